@@ -0,0 +1,279 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ros/ros.h"
+#include "spdlog/spdlog.h"
+#include "config/calib_context.h"
+#include "config/configor.h"
+#include "util/status.hpp"
+#include "util/utils_tpl.hpp"
+#include "solver/calib_solver.h"
+#include "spdlog/fmt/bundled/color.h"
+#include "solver/calib_solver_io.h"
+#include "calib/calib_param_manager.h"
+#include "calib/calib_data_manager.h"
+#include "calib/flat_param_io.h"
+#include "calib/calib_data_cache.h"
+#include "util/stage_profiler.h"
+#include "util/trace_recorder.h"
+#include "filesystem"
+#include "fstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+// each non-empty line (except comments starting with '#') is the 'BagPath' of a job
+std::vector<std::string> LoadJobs(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL, "open bag list '{}' failed!",
+                                 filename);
+    }
+    std::vector<std::string> jobs;
+    std::string line;
+    while (std::getline(file, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && line.front() != '#') {
+            jobs.push_back(line);
+        }
+    }
+    return jobs;
+}
+
+/**
+ * derive the context of a job from the base one, only the bag path and the output path (a sub
+ * directory of the base one, named by the index and the first bag of the job) are replaced
+ */
+ns_ikalibr::CalibContext::Ptr CreateJobContext(const ns_ikalibr::CalibContext::Ptr &baseContext,
+                                               int index,
+                                               const std::string &bagPath) {
+    using namespace ns_ikalibr;
+    auto scope = baseContext->Activate();
+    Configor::DataStream::BagPath = bagPath;
+    const auto bagPaths = Configor::DataStream::GetBagPaths();
+    if (bagPaths.empty()) {
+        throw Status(Status::ERROR, "can not find the ros bag of job '{}': '{}'!", index, bagPath);
+    }
+    for (const auto &path : bagPaths) {
+        if (!std::filesystem::exists(path)) {
+            throw Status(Status::ERROR, "can not find the ros bag '{}' of job '{}'!", path, index);
+        }
+    }
+    Configor::DataStream::OutputPath =
+        fmt::format("{}/{:03d}_{}", Configor::DataStream::OutputPath, index,
+                    std::filesystem::path(bagPaths.front()).stem().string());
+    if (!std::filesystem::exists(Configor::DataStream::OutputPath) &&
+        !std::filesystem::create_directories(Configor::DataStream::OutputPath)) {
+        throw Status(Status::ERROR, "create output directory of job '{}' failed: '{}'", index,
+                     Configor::DataStream::OutputPath);
+    }
+    // the base context would be reinstalled once it is activated again
+    return CalibContext::CreateFromConfigor();
+}
+
+// perform the calibration of a job, see 'main.cpp' for details of each step
+void RunJob(const ns_ikalibr::CalibContext::Ptr &context) {
+    using namespace ns_ikalibr;
+    auto scope = context->Activate();
+    StageProfiler::Reset();
+    if (IsOptionWith(OutputOption::TraceEvents, Configor::Preference::Outputs)) {
+        TraceRecorder::Start();
+    } else {
+        TraceRecorder::Stop();
+    }
+    spdlog::info("calibrating bag(s) '{}', output to '{}'...", Configor::DataStream::BagPath,
+                 Configor::DataStream::OutputPath);
+
+    auto paramMagr = CalibParamManager::InitParamsFromConfigor();
+
+    auto dataMagr = CalibDataManager::Create(context);
+    dataMagr->LoadCalibData();
+
+    auto solver = CalibSolver::Create(dataMagr, paramMagr);
+    solver->Process();
+
+    const auto filename =
+        Configor::DataStream::OutputPath + "/ikalibr_param" + Configor::GetFormatExtension();
+    paramMagr->Save(filename, Configor::Preference::OutputDataFormat);
+    FlatParamIO::SaveParams(paramMagr,
+                            Configor::DataStream::OutputPath + "/ikalibr_param" +
+                                FlatParamIO::EXTENSION);
+    CalibSolverIO::Create(solver)->SaveByProductsToDisk();
+    StageProfiler::SaveReport(Configor::DataStream::OutputPath + "/ikalibr_stages.json");
+    if (TraceRecorder::IsEnabled()) {
+        TraceRecorder::Stop();
+        TraceRecorder::Save(Configor::DataStream::OutputPath + "/ikalibr_trace.json");
+    }
+
+    // the next job is started without waiting for users to close the viewer
+    solver->CloseViewer();
+}
+
+/**
+ * decode the bag(s) of a job into the calibration data cache (see 'CalibDataCache') only, which
+ * is loaded by the calibration of this job later, e.g., by another process sharing the output path
+ */
+void PreprocessJob(const ns_ikalibr::CalibContext::Ptr &context) {
+    using namespace ns_ikalibr;
+    auto scope = context->Activate();
+    const auto cache = CalibDataCache::CreateFromConfigor();
+    if (cache->IsValid()) {
+        spdlog::info("bag(s) '{}' have been cached in '{}', skip", Configor::DataStream::BagPath,
+                     cache->GetFilename());
+        return;
+    }
+    spdlog::info("preprocessing bag(s) '{}', cache to '{}'...", Configor::DataStream::BagPath,
+                 cache->GetFilename());
+    CalibDataManager::Create(context)->LoadCalibData();
+}
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "ikalibr_batch_prog");
+    try {
+        ns_ikalibr::ConfigSpdlog();
+
+        ns_ikalibr::PrintIKalibrLibInfo();
+
+        /**
+         * the configuration is loaded once as the base context of all jobs, the warm states of
+         * this process (ros, thread pools, and process-wide caches such as undistortion maps) are
+         * reused by jobs, which are performed one by one
+         */
+        auto configPath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_batch_prog/config_path");
+        spdlog::info("loading configure from yaml file '{}'...", configPath);
+        if (!std::filesystem::exists(configPath)) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "configure file dose not exist: '{}'", configPath);
+        }
+        auto baseContext = ns_ikalibr::CalibContext::Load(configPath);
+        if (baseContext == nullptr) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "load configure file from '{}' failed!", configPath);
+        }
+        // the logger is shared by all jobs, thus it is configured by the base configuration
+        if (auto scope = baseContext->Activate(); ns_ikalibr::Configor::Preference::AsyncLogging) {
+            ns_ikalibr::ConfigAsyncSpdlog(ns_ikalibr::Configor::Preference::AsyncLogQueueSize);
+        }
+
+        auto bagListPath = ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_batch_prog/bag_list");
+        const auto jobs = LoadJobs(bagListPath);
+        spdlog::info("'{}' job(s) are loaded from bag list '{}'", jobs.size(), bagListPath);
+
+        /**
+         * jobs of a fleet can be shared by several worker processes (nodes), the i-th job is
+         * performed by the '(i % worker_count)-th' worker. If 'preprocess_only' is set, workers
+         * only decode bags into caches in the (shared) output paths of jobs, from which the
+         * calibrations are performed by the coordinator (a worker with 'worker_count' as 1)
+         */
+        const int workerIndex = ros::param::param("/ikalibr_batch_prog/worker_index", 0);
+        const int workerCount = ros::param::param("/ikalibr_batch_prog/worker_count", 1);
+        const bool preprocessOnly = ros::param::param("/ikalibr_batch_prog/preprocess_only", false);
+        if (workerCount < 1 || workerIndex < 0 || workerIndex >= workerCount) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "invalid worker index '{}' of '{}' worker(s)!", workerIndex,
+                                     workerCount);
+        }
+        if (auto scope = baseContext->Activate();
+            preprocessOnly && !ns_ikalibr::Configor::Preference::CacheCalibData) {
+            throw ns_ikalibr::Status(
+                ns_ikalibr::Status::CRITICAL,
+                "'CacheCalibData' should be enabled to preprocess jobs, or nothing is kept!");
+        }
+
+        // a failed job is reported and skipped, the following ones are still performed
+        std::vector<std::string> failedJobs;
+        int workerJobCount = 0;
+        for (int i = 0; i < static_cast<int>(jobs.size()) && ros::ok(); ++i) {
+            if (i % workerCount != workerIndex) {
+                continue;
+            }
+            ++workerJobCount;
+            spdlog::info("perform '{}-th' job of '{}' job(s)...", i, jobs.size());
+            try {
+                // the job index is kept in the output path, which is the same for all workers
+                const auto context = CreateJobContext(baseContext, i, jobs.at(i));
+                if (preprocessOnly) {
+                    PreprocessJob(context);
+                } else {
+                    RunJob(context);
+                }
+            } catch (const ns_ikalibr::IKalibrStatus &status) {
+                spdlog::error("job '{}' failed: '{}'", jobs.at(i), status.what);
+                failedJobs.push_back(jobs.at(i));
+            } catch (const std::exception &e) {
+                spdlog::error("job '{}' failed: '{}'", jobs.at(i), e.what());
+                failedJobs.push_back(jobs.at(i));
+            }
+        }
+
+        static constexpr auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        spdlog::info(fmt::format(FStyle, "batch {} finished!!! '{}' of '{}' job(s) done",
+                                 preprocessOnly ? "preprocessing" : "calibration",
+                                 workerJobCount - static_cast<int>(failedJobs.size()),
+                                 workerJobCount));
+        for (const auto &job : failedJobs) {
+            spdlog::warn("failed job: '{}'", job);
+        }
+
+    } catch (const ns_ikalibr::IKalibrStatus &status) {
+        // if error happened, print it
+        static constexpr auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        static constexpr auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        switch (status.flag) {
+            case ns_ikalibr::Status::FINE:
+                // this case usually won't happen
+                spdlog::info(fmt::format(FStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::WARNING:
+                spdlog::warn(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::ERROR:
+                spdlog::error(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::CRITICAL:
+                spdlog::critical(fmt::format(WECStyle, "{}", status.what));
+                break;
+        }
+    } catch (const std::exception &e) {
+        // an unknown exception not thrown by this program
+        static constexpr auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        spdlog::critical(fmt::format(WECStyle, "unknown error happened: '{}'", e.what()));
+    }
+
+    ros::shutdown();
+    return 0;
+}
@@ -42,6 +42,9 @@
 #include "solver/calib_solver_io.h"
 #include "calib/calib_param_manager.h"
 #include "calib/calib_data_manager.h"
+#include "calib/flat_param_io.h"
+#include "util/stage_profiler.h"
+#include "util/trace_recorder.h"
 #include "filesystem"
 
 namespace {
@@ -72,7 +75,9 @@ int main(int argc, char **argv) {
              * make code cleaner.
              *
              * Suggestion from authors: such a design is not recommanded in other programs,
-             * especially those multi-thread programs!!!
+             * especially those multi-thread programs!!! To run multiple calibrations in one
+             * program, load their configurations as 'CalibContext's (see 'CalibContext::Load'),
+             * and pass them to the data managers and solvers.
              */
             throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
                                      "load configure file from '{}' failed!", configPath);
@@ -81,6 +86,15 @@ int main(int argc, char **argv) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
 
+        if (ns_ikalibr::Configor::Preference::AsyncLogging) {
+            ns_ikalibr::ConfigAsyncSpdlog(ns_ikalibr::Configor::Preference::AsyncLogQueueSize);
+        }
+
+        if (ns_ikalibr::IsOptionWith(ns_ikalibr::OutputOption::TraceEvents,
+                                     ns_ikalibr::Configor::Preference::Outputs)) {
+            ns_ikalibr::TraceRecorder::Start();
+        }
+
         // create parameter manager based on loaded configure information
         auto paramMagr = ns_ikalibr::CalibParamManager::InitParamsFromConfigor();
         paramMagr->ShowParamStatus();
@@ -98,10 +112,23 @@ int main(int argc, char **argv) {
         const auto filename = ns_ikalibr::Configor::DataStream::OutputPath + "/ikalibr_param" +
                               ns_ikalibr::Configor::GetFormatExtension();
         paramMagr->Save(filename, ns_ikalibr::Configor::Preference::OutputDataFormat);
+        ns_ikalibr::FlatParamIO::SaveParams(paramMagr,
+                                            ns_ikalibr::Configor::DataStream::OutputPath +
+                                                "/ikalibr_param" +
+                                                ns_ikalibr::FlatParamIO::EXTENSION);
 
         // save the by-products from the spatiotemporal calibration to the disk
         ns_ikalibr::CalibSolverIO::Create(solver)->SaveByProductsToDisk();
 
+        // the timing and resource telemetry of stages, e.g., for regression tracking
+        ns_ikalibr::StageProfiler::SaveReport(ns_ikalibr::Configor::DataStream::OutputPath +
+                                              "/ikalibr_stages.json");
+        if (ns_ikalibr::TraceRecorder::IsEnabled()) {
+            ns_ikalibr::TraceRecorder::Stop();
+            ns_ikalibr::TraceRecorder::Save(ns_ikalibr::Configor::DataStream::OutputPath +
+                                            "/ikalibr_trace.json");
+        }
+
         static constexpr auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
         spdlog::info(
             fmt::format(FStyle, "solving and outputting finished!!! Everything is fine!!!"));
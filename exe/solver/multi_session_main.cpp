@@ -0,0 +1,257 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ros/ros.h"
+#include "spdlog/spdlog.h"
+#include "config/calib_context.h"
+#include "config/configor.h"
+#include "util/status.hpp"
+#include "util/utils_tpl.hpp"
+#include "solver/calib_solver.h"
+#include "spdlog/fmt/bundled/color.h"
+#include "solver/calib_solver_io.h"
+#include "calib/calib_param_manager.h"
+#include "calib/calib_data_manager.h"
+#include "calib/flat_param_io.h"
+#include "util/stage_profiler.h"
+#include "filesystem"
+#include "fstream"
+#include "sstream"
+#include "optional"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+struct Session {
+    std::string bagPath;
+    // the 'BeginTime' and 'Duration' of this session, the ones of the base configuration are used
+    // if not given
+    std::optional<double> beginTime;
+    std::optional<double> duration;
+};
+
+// each non-empty line (except comments starting with '#') is '<BagPath> [BeginTime] [Duration]'
+std::vector<Session> LoadSessions(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL, "open session list '{}' failed!",
+                                 filename);
+    }
+    std::vector<Session> sessions;
+    std::string line;
+    while (std::getline(file, line)) {
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+        std::istringstream stream(line);
+        Session session;
+        stream >> session.bagPath;
+        if (double value; stream >> value) {
+            session.beginTime = value;
+            if (stream >> value) {
+                session.duration = value;
+            }
+        }
+        sessions.push_back(session);
+    }
+    return sessions;
+}
+
+/**
+ * derive the context of a session from the base one, only the bag path, the time range, and the
+ * output path (a sub directory of the base one, named by the index and the first bag of the
+ * session) are replaced
+ */
+ns_ikalibr::CalibContext::Ptr CreateSessionContext(
+    const ns_ikalibr::CalibContext::Ptr &baseContext, int index, const Session &session) {
+    using namespace ns_ikalibr;
+    auto scope = baseContext->Activate();
+    Configor::DataStream::BagPath = session.bagPath;
+    if (session.beginTime) {
+        Configor::DataStream::BeginTime = *session.beginTime;
+    }
+    if (session.duration) {
+        Configor::DataStream::Duration = *session.duration;
+    }
+    const auto bagPaths = Configor::DataStream::GetBagPaths();
+    if (bagPaths.empty()) {
+        throw Status(Status::ERROR, "can not find the ros bag of session '{}': '{}'!", index,
+                     session.bagPath);
+    }
+    for (const auto &path : bagPaths) {
+        if (!std::filesystem::exists(path)) {
+            throw Status(Status::ERROR, "can not find the ros bag '{}' of session '{}'!", path,
+                         index);
+        }
+    }
+    Configor::DataStream::OutputPath =
+        fmt::format("{}/{:03d}_{}", Configor::DataStream::OutputPath, index,
+                    std::filesystem::path(bagPaths.front()).stem().string());
+    if (!std::filesystem::exists(Configor::DataStream::OutputPath) &&
+        !std::filesystem::create_directories(Configor::DataStream::OutputPath)) {
+        throw Status(Status::ERROR, "create output directory of session '{}' failed: '{}'", index,
+                     Configor::DataStream::OutputPath);
+    }
+    // the base context would be reinstalled once it is activated again
+    return CalibContext::CreateFromConfigor();
+}
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "ikalibr_multi_session_prog");
+    try {
+        ns_ikalibr::ConfigSpdlog();
+
+        ns_ikalibr::PrintIKalibrLibInfo();
+
+        /**
+         * sessions are recordings of the same sensor suite, each of them has its own data and
+         * splines, the calibration parameters are shared and estimated jointly
+         */
+        auto configPath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_multi_session_prog/config_path");
+        spdlog::info("loading configure from yaml file '{}'...", configPath);
+        if (!std::filesystem::exists(configPath)) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "configure file dose not exist: '{}'", configPath);
+        }
+        auto baseContext = ns_ikalibr::CalibContext::Load(configPath);
+        if (baseContext == nullptr) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "load configure file from '{}' failed!", configPath);
+        }
+        if (auto scope = baseContext->Activate(); ns_ikalibr::Configor::Preference::AsyncLogging) {
+            ns_ikalibr::ConfigAsyncSpdlog(ns_ikalibr::Configor::Preference::AsyncLogQueueSize);
+        }
+
+        auto sessionListPath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_multi_session_prog/session_list");
+        const auto sessions = LoadSessions(sessionListPath);
+        spdlog::info("'{}' session(s) are loaded from session list '{}'", sessions.size(),
+                     sessionListPath);
+
+        // the parameter manager is shared by all sessions
+        ns_ikalibr::CalibParamManager::Ptr paramMagr;
+        {
+            auto scope = baseContext->Activate();
+            paramMagr = ns_ikalibr::CalibParamManager::InitParamsFromConfigor();
+        }
+
+        std::vector<ns_ikalibr::CalibSolver::Ptr> solvers;
+        for (int i = 0; i < static_cast<int>(sessions.size()); ++i) {
+            auto context = CreateSessionContext(baseContext, i, sessions.at(i));
+            auto scope = context->Activate();
+            spdlog::info("loading '{}-th' session from bag(s) '{}'...", i,
+                         ns_ikalibr::Configor::DataStream::BagPath);
+            auto dataMagr = ns_ikalibr::CalibDataManager::Create(context);
+            dataMagr->LoadCalibData();
+            solvers.push_back(ns_ikalibr::CalibSolver::Create(dataMagr, paramMagr));
+        }
+
+        ns_ikalibr::CalibSolver::ProcessSessions(solvers, baseContext);
+
+        {
+            // the jointly estimated parameters are saved to the base output path
+            auto scope = baseContext->Activate();
+            const auto &outputPath = ns_ikalibr::Configor::DataStream::OutputPath;
+            paramMagr->Save(outputPath + "/ikalibr_param" +
+                                ns_ikalibr::Configor::GetFormatExtension(),
+                            ns_ikalibr::Configor::Preference::OutputDataFormat);
+            ns_ikalibr::FlatParamIO::SaveParams(
+                paramMagr, outputPath + "/ikalibr_param" + ns_ikalibr::FlatParamIO::EXTENSION);
+        }
+
+        // by-products of each session are saved to its own output path
+        for (const auto &solver : solvers) {
+            ns_ikalibr::CalibSolverIO::Create(solver)->SaveByProductsToDisk();
+        }
+
+        {
+            auto scope = baseContext->Activate();
+            ns_ikalibr::StageProfiler::SaveReport(ns_ikalibr::Configor::DataStream::OutputPath +
+                                                  "/ikalibr_stages.json");
+        }
+
+        static constexpr auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        spdlog::info(fmt::format(FStyle,
+                                 "multi-session calibration finished!!! '{}' session(s) are "
+                                 "calibrated jointly",
+                                 sessions.size()));
+
+    } catch (const ns_ikalibr::IKalibrStatus &status) {
+                spdlog::error("job '{}' failed: '{}'", jobs.at(i), status.what);
+                failedJobs.push_back(jobs.at(i));
+            } catch (const std::exception &e) {
+                spdlog::error("job '{}' failed: '{}'", jobs.at(i), e.what());
+                failedJobs.push_back(jobs.at(i));
+            }
+        }
+
+        static constexpr auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        spdlog::info(fmt::format(FStyle, "batch calibration finished!!! '{}' of '{}' job(s) done",
+                                 jobs.size() - failedJobs.size(), jobs.size()));
+        for (const auto &job : failedJobs) {
+            spdlog::warn("failed job: '{}'", job);
+        }
+
+    } catch (const ns_ikalibr::IKalibrStatus &status) {
+        // if error happened, print it
+        static constexpr auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        static constexpr auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        switch (status.flag) {
+            case ns_ikalibr::Status::FINE:
+                // this case usually won't happen
+                spdlog::info(fmt::format(FStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::WARNING:
+                spdlog::warn(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::ERROR:
+                spdlog::error(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::CRITICAL:
+                spdlog::critical(fmt::format(WECStyle, "{}", status.what));
+                break;
+        }
+    } catch (const std::exception &e) {
+        // an unknown exception not thrown by this program
+        static constexpr auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        spdlog::critical(fmt::format(WECStyle, "unknown error happened: '{}'", e.what()));
+    }
+
+    ros::shutdown();
+    return 0;
+}
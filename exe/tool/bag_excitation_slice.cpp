@@ -0,0 +1,222 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/imu_excitation.h"
+#include "sensor/imu_data_loader.h"
+#include "spdlog/fmt/bundled/color.h"
+#include "spdlog/spdlog.h"
+#include "util/status.hpp"
+#include "util/utils_tpl.hpp"
+#include "filesystem"
+#include "fstream"
+#include "rosbag/bag.h"
+#include "rosbag/view.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "ikalibr_bag_excitation_slice");
+
+    try {
+        ns_ikalibr::ConfigSpdlog();
+
+        ns_ikalibr::PrintIKalibrLibInfo();
+
+        // load parameters
+        auto iBagPath = ns_ikalibr::GetParamFromROS<std::string>(
+            "/ikalibr_bag_excitation_slice/input_bag_path");
+        if (!std::filesystem::exists(iBagPath)) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR, "the bag path not exists!!! '{}'",
+                                     iBagPath);
+        } else {
+            spdlog::info("the path of rosbag: '{}'", iBagPath);
+        }
+
+        auto imuTopic =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_bag_excitation_slice/imu_topic");
+        auto imuModel =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_bag_excitation_slice/imu_model");
+        spdlog::info("the imu to evaluate excitation: '{}' ('{}')", imuTopic, imuModel);
+        auto loader = ns_ikalibr::IMUDataLoader::GetLoader(imuModel);
+
+        auto windowLength =
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_excitation_slice/window_length");
+        auto angularThd =
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_excitation_slice/angular_threshold");
+        auto linearThd =
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_excitation_slice/linear_threshold");
+        auto padding = ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_excitation_slice/padding");
+        auto mergeGap =
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_excitation_slice/merge_gap");
+        if (windowLength <= 0.0) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                     "invalid length of excitation windows: '{:.3f}'",
+                                     windowLength);
+        }
+        spdlog::info(
+            "window length: '{:.3f}', angular threshold: '{:.3f}', linear threshold: '{:.3f}', "
+            "padding: '{:.3f}', merge gap: '{:.3f}'",
+            windowLength, angularThd, linearThd, padding, mergeGap);
+
+        // the output rosbag containing only excited segments, it is not written if it is empty
+        auto oBagPath = ns_ikalibr::GetParamFromROS<std::string>(
+            "/ikalibr_bag_excitation_slice/output_bag_path");
+        if (!oBagPath.empty() && std::filesystem::exists(oBagPath)) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::WARNING,
+                                     "the output bag exists: '{}', please delete it first!",
+                                     oBagPath);
+        }
+        // the yaml file listing segments, in the form of 'BeginTime' and 'Duration' in config files
+        auto oSegmentsPath = ns_ikalibr::GetParamFromROS<std::string>(
+            "/ikalibr_bag_excitation_slice/output_segments_path");
+
+        // open rosbag, only the imu is loaded to evaluate excitation
+        auto srcBag = std::make_unique<rosbag::Bag>();
+        srcBag->open(iBagPath, rosbag::BagMode::Read);
+        rosbag::View bagView(*srcBag);
+        const ros::Time bagBegTime = bagView.getBeginTime();
+        const ros::Time bagEndTime = bagView.getEndTime();
+
+        rosbag::View imuView(*srcBag, rosbag::TopicQuery(imuTopic));
+        std::vector<ns_ikalibr::IMUFrame::Ptr> imuMes;
+        imuMes.reserve(imuView.size());
+        // the offset from timestamps of imu frames to the bag (recording) time
+        double stampToBagTime = 0.0;
+        for (const auto &item : imuView) {
+            auto frame = loader->UnpackFrame(item);
+            if (frame == nullptr) {
+                continue;
+            }
+            if (imuMes.empty()) {
+                stampToBagTime = item.getTime().toSec() - frame->GetTimestamp();
+            }
+            imuMes.push_back(frame);
+        }
+        if (imuMes.empty()) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                     "no imu frame of topic '{}' is loaded from the bag!",
+                                     imuTopic);
+        }
+        spdlog::info("'{}' imu frames are loaded", imuMes.size());
+
+        const auto windows = ns_ikalibr::IMUExcitation::Evaluate(imuMes, windowLength);
+        const auto segments = ns_ikalibr::IMUExcitation::ExcitedSegments(
+            windows, angularThd, linearThd, padding, mergeGap);
+        int excitedWindows = 0;
+        for (const auto &window : windows) {
+            excitedWindows += window.IsExcited(angularThd, linearThd);
+        }
+        double keptTime = 0.0;
+        for (const auto &[st, et] : segments) {
+            keptTime += et - st;
+        }
+        spdlog::info(
+            "'{}' of '{}' windows are excited, '{}' segment(s) are kept, '{:.3f}' of '{:.3f}' "
+            "seconds",
+            excitedWindows, windows.size(), segments.size(), keptTime,
+            (bagEndTime - bagBegTime).toSec());
+
+        // segments measured from the start time of bag, like 'BeginTime' in config files
+        std::vector<std::pair<double, double>> bagSegments;
+        for (const auto &[st, et] : segments) {
+            const double bagSt = st + stampToBagTime - bagBegTime.toSec();
+            const double bagEt = et + stampToBagTime - bagBegTime.toSec();
+            bagSegments.emplace_back(std::max(0.0, bagSt), bagEt);
+            spdlog::info("excited segment: 'BeginTime: {:.3f}', 'Duration: {:.3f}'",
+                         bagSegments.back().first,
+                         bagSegments.back().second - bagSegments.back().first);
+        }
+
+        if (!oSegmentsPath.empty()) {
+            std::ofstream file(oSegmentsPath);
+            file << "# excited segments of '" << iBagPath << "' evaluated by imu '" << imuTopic
+                 << "'\n# times are measured from the start time of the bag, unit: second(s)\n";
+            file << "Segments:\n";
+            for (const auto &[st, et] : bagSegments) {
+                file << fmt::format("  - BeginTime: {:.3f}\n    Duration: {:.3f}\n", st, et - st);
+            }
+            spdlog::info("segments are written to '{}'", oSegmentsPath);
+        }
+
+        if (!oBagPath.empty()) {
+            auto dstBag = std::make_unique<rosbag::Bag>();
+            dstBag->open(oBagPath, rosbag::BagMode::Write);
+            dstBag->setCompression(rosbag::compression::LZ4);
+            // segments are disjoint and ordered, messages are copied as serialized buffers
+            std::size_t count = 0;
+            for (const auto &[st, et] : bagSegments) {
+                const ros::Time segBeg = bagBegTime + ros::Duration(st);
+                const ros::Time segEnd = std::min(bagBegTime + ros::Duration(et), bagEndTime);
+                rosbag::View view(*srcBag, segBeg, segEnd);
+                for (const auto &item : view) {
+                    dstBag->write(item.getTopic(), item.getTime(), item,
+                                  item.getConnectionHeader());
+                    ++count;
+                }
+            }
+            dstBag->close();
+            spdlog::info("'{}' messages are written to '{}'", count, oBagPath);
+        }
+        srcBag->close();
+
+    } catch (const ns_ikalibr::IKalibrStatus &status) {
+        // if error happened, print it
+        static const auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        static const auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        switch (status.flag) {
+            case ns_ikalibr::Status::FINE:
+                // this case usually won't happen
+                spdlog::info(fmt::format(FStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::WARNING:
+                spdlog::warn(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::ERROR:
+                spdlog::error(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::CRITICAL:
+                spdlog::critical(fmt::format(WECStyle, "{}", status.what));
+                break;
+        }
+    } catch (const std::exception &e) {
+        // an unknown exception not thrown by this program
+        static const auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        spdlog::critical(fmt::format(WECStyle, "unknown error happened: '{}'", e.what()));
+    }
+
+    ros::shutdown();
+    return 0;
+}
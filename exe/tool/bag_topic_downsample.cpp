@@ -41,6 +41,7 @@
 #include "filesystem"
 #include "rosbag/bag.h"
 #include "rosbag/view.h"
+#include "map"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -64,9 +65,54 @@ int main(int argc, char **argv) {
             spdlog::info("the path of rosbag: '{}'", iBagPath);
         }
 
-        auto topic = ns_ikalibr::GetParamFromROS<std::string>(
+        /**
+         * topics to downsample and their desired frequencies, e.g., '/cam/image:10;/lidar:5'.
+         * A topic without a frequency is downsampled to the 'desired_frequency'
+         */
+        auto topicsStr = ns_ikalibr::GetParamFromROS<std::string>(
             "/ikalibr_bag_topic_downsample/topic_to_downsample");
-        spdlog::info("ros topic to down sampled: '{}'", topic);
+        auto defaultFrequency =
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_topic_downsample/desired_frequency");
+        std::map<std::string, double> topicToDeltaTime;
+        for (const auto &item : ns_ikalibr::SplitString(topicsStr, ';')) {
+            const auto pos = item.rfind(':');
+            const std::string topic = item.substr(0, pos);
+            const double frequency =
+                pos == std::string::npos ? defaultFrequency : std::stod(item.substr(pos + 1));
+            if (topic.empty()) {
+                continue;
+            }
+            if (frequency < 1E-3) {
+                throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                         "invalid desired frequency of topic '{}': '{:.3f}'", topic,
+                                         frequency);
+            }
+            spdlog::info("the desired frequency of topic '{}': '{:.3f}'", topic, frequency);
+            topicToDeltaTime[topic] = 1.0 / frequency;
+        }
+        if (topicToDeltaTime.empty()) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR, "no topic to downsample is set!");
+        }
+
+        // whether the other topics are copied to the output bag as they are
+        auto keepOtherTopics =
+            ns_ikalibr::GetParamFromROS<bool>("/ikalibr_bag_topic_downsample/keep_other_topics");
+        // the chunk compression of the output bag: 'none', 'lz4', or 'bz2'
+        auto compressionStr =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_bag_topic_downsample/compression");
+        rosbag::compression::CompressionType compression;
+        if (compressionStr == "none") {
+            compression = rosbag::compression::Uncompressed;
+        } else if (compressionStr == "lz4") {
+            compression = rosbag::compression::LZ4;
+        } else if (compressionStr == "bz2") {
+            compression = rosbag::compression::BZ2;
+        } else {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                     "unknown compression type: '{}', options: 'none', 'lz4', "
+                                     "'bz2'",
+                                     compressionStr);
+        }
 
         auto oBagPath = ns_ikalibr::GetParamFromROS<std::string>(
             "/ikalibr_bag_topic_downsample/output_bag_path");
@@ -78,45 +124,51 @@ int main(int argc, char **argv) {
             spdlog::info("the path of output rosbag: '{}'", oBagPath);
         }
 
-        auto frequency =
-            ns_ikalibr::GetParamFromROS<double>("/ikalibr_bag_topic_downsample/desired_frequency");
-        if (frequency < 1E-3) {
-            spdlog::error("invalid desired frequency: '{:.3f}'", frequency);
-        } else {
-            spdlog::info("the desired frequency of topic '{}': '{:.3f}'", topic, frequency);
-        }
-
         // open rosbag
         auto srcBag = std::make_unique<rosbag::Bag>();
         srcBag->open(iBagPath, rosbag::BagMode::Read);
         auto view = rosbag::View();
-        view.addQuery(*srcBag, rosbag::TopicQuery(topic));
-        spdlog::info("load message of topic '{}' and sort them by timestamps...", topic);
-        std::list<rosbag::View::iterator> msgs;
-        for (auto iter = view.begin(); iter != view.end(); ++iter) {
-            msgs.push_back(iter);
-        }
-        struct {
-            bool operator()(const rosbag::View::iterator &i1,
-                            const rosbag::View::iterator &i2) const {
-                return i1->getTime().toSec() < i2->getTime().toSec();
+        if (keepOtherTopics) {
+            view.addQuery(*srcBag);
+        } else {
+            std::vector<std::string> topics;
+            for (const auto &[topic, deltaTime] : topicToDeltaTime) {
+                topics.push_back(topic);
             }
-        } customLess;
-        // sort messages according to the time stamps
-        msgs.sort(customLess);
+            view.addQuery(*srcBag, rosbag::TopicQuery(topics));
+        }
 
         auto dstBag = std::make_unique<rosbag::Bag>();
         dstBag->open(oBagPath, rosbag::BagMode::Write);
-        double lastTimeSed = msgs.front()->getTime().toSec();
-        const double DeltaTime = 1.0 / frequency;
-        spdlog::info("write message of topic '{}'...", topic);
-        for (const auto &iter : msgs) {
-            if (iter->getTime().toSec() - lastTimeSed > DeltaTime) {
-                dstBag->write(topic, iter->getTime(), *iter, iter->getConnectionHeader());
-                lastTimeSed = iter->getTime().toSec();
+        dstBag->setCompression(compression);
+
+        /**
+         * the view is time-ordered, all topics are processed in one streaming pass. Messages are
+         * copied as serialized buffers, they are not instantiated
+         */
+        std::map<std::string, double> lastTimeWritten;
+        std::map<std::string, std::pair<int, int>> topicCounts;
+        spdlog::info("write messages of topics to '{}'...", oBagPath);
+        for (const auto &item : view) {
+            const auto &topic = item.getTopic();
+            auto &[readCount, writtenCount] = topicCounts[topic];
+            ++readCount;
+            if (auto iter = topicToDeltaTime.find(topic); iter != topicToDeltaTime.cend()) {
+                const double time = item.getTime().toSec();
+                auto last = lastTimeWritten.find(topic);
+                if (last != lastTimeWritten.cend() && time - last->second <= iter->second) {
+                    continue;
+                }
+                lastTimeWritten[topic] = time;
             }
+            dstBag->write(topic, item.getTime(), item, item.getConnectionHeader());
+            ++writtenCount;
+        }
+        for (const auto &[topic, count] : topicCounts) {
+            spdlog::info("topic '{}': '{}' message(s) read, '{}' written", topic, count.first,
+                         count.second);
         }
-        spdlog::info("write message of topic '{}' finished!", topic);
+        spdlog::info("write messages finished!");
         dstBag->close();
         srcBag->close();
 
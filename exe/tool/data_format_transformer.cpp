@@ -37,17 +37,313 @@
 #include "config/configor.h"
 #include "util/status.hpp"
 #include "util/utils_tpl.hpp"
+#include "util/columnar_writer.h"
 #include "calib/calib_param_manager.h"
 #include "ctraj/core/pose.hpp"
 #include "ctraj/core/spline_bundle.h"
 #include "cereal/types/utility.hpp"
 #include "cereal/types/list.hpp"
 #include "spdlog/fmt/bundled/color.h"
+#include "functional"
+#include "exception"
+#include "thread"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
+namespace ns_ikalibr {
+namespace {
+// a transformation of a single file, the ones of all workspaces are performed concurrently
+struct TransformTask {
+    std::string rName;
+    std::string wName;
+    std::function<void()> perform;
+};
+
+// the data is loaded by the given nvps and saved by the same ones
+template <typename... NVPs>
+void TransformArchive(const std::string &rName,
+                      CerealArchiveType::Enum srcFormat,
+                      const std::string &wName,
+                      CerealArchiveType::Enum dstFormat,
+                      NVPs &&...nvps) {
+    {
+        std::ifstream file(rName);
+        auto ar = GetInputArchiveVariant(file, srcFormat);
+        SerializeByInputArchiveVariant(ar, srcFormat, nvps...);
+    }
+    {
+        std::ofstream file(wName);
+        auto ar = GetOutputArchiveVariant(file, dstFormat);
+        SerializeByOutputArchiveVariant(ar, dstFormat, nvps...);
+    }
+}
+
+// the data is only loaded, for time series to be written as columns
+template <typename... NVPs>
+void LoadArchive(const std::string &rName, CerealArchiveType::Enum srcFormat, NVPs &&...nvps) {
+    std::ifstream file(rName);
+    auto ar = GetInputArchiveVariant(file, srcFormat);
+    SerializeByInputArchiveVariant(ar, srcFormat, nvps...);
+}
+
+ColumnarWriter::Ptr CreateColumnarWriter(const std::string &filename,
+                                         const std::vector<std::string> &columns) {
+    auto writer = ColumnarWriter::Create(filename, columns);
+    if (!writer->IsOpen()) {
+        throw Status(Status::CRITICAL, "open columnar file failed: '{}'", filename);
+    }
+    return writer;
+}
+
+// columns are the same as the ones output by the solver, see 'CalibSolverIO'
+void SavePoseSequenceColumnar(const std::vector<ns_ctraj::Posed> &poseSeq,
+                              const std::string &filename) {
+    auto writer =
+        CreateColumnarWriter(filename, {"timestamp", "qx", "qy", "qz", "qw", "px", "py", "pz"});
+    for (const auto &pose : poseSeq) {
+        const Eigen::Quaterniond &q = pose.so3.unit_quaternion();
+        writer->AppendRow(
+            {pose.timeStamp, q.x(), q.y(), q.z(), q.w(), pose.t(0), pose.t(1), pose.t(2)});
+    }
+}
+
+void SaveInertialMesColumnar(
+    const std::vector<std::pair<std::string, const std::list<IMUFrame> *>> &mesLists,
+    const std::string &filename) {
+    std::vector<std::string> columns{"timestamp"};
+    for (const auto &[prefix, _] : mesLists) {
+        for (const std::string name : {"gyro", "acce"}) {
+            for (const std::string axis : {"x", "y", "z"}) {
+                columns.push_back(prefix + '_' + name + '_' + axis);
+            }
+        }
+    }
+    auto writer = CreateColumnarWriter(filename, columns);
+    std::vector<std::list<IMUFrame>::const_iterator> iters;
+    for (const auto &[_, mes] : mesLists) {
+        iters.push_back(mes->cbegin());
+    }
+    std::vector<double> row(columns.size());
+    while (iters.front() != mesLists.front().second->cend()) {
+        row.at(0) = iters.front()->GetTimestamp();
+        for (int i = 0; i < static_cast<int>(iters.size()); ++i) {
+            // lists output by the solver have the same size
+            if (iters.at(i) == mesLists.at(i).second->cend()) {
+                throw Status(Status::CRITICAL, "inertial lists in '{}' are not row-aligned!!!",
+                             filename);
+            }
+            const IMUFrame &frame = *iters.at(i)++;
+            const Eigen::Vector3d &gyro = frame.GetGyro(), &acce = frame.GetAcce();
+            for (int j = 0; j < 3; ++j) {
+                row.at(1 + i * 6 + j) = gyro(j);
+                row.at(4 + i * 6 + j) = acce(j);
+            }
+        }
+        writer->AppendRow(row);
+    }
+}
+
+void SaveResidualsColumnar(const std::list<double> &residuals, const std::string &filename) {
+    auto writer = CreateColumnarWriter(filename, {"residual"});
+    for (const double &r : residuals) {
+        writer->AppendRow({r});
+    }
+}
+
+void SaveResidualsColumnar(const std::list<Eigen::Vector2d> &residuals,
+                           const std::string &filename) {
+    auto writer = CreateColumnarWriter(filename, {"residual_x", "residual_y"});
+    for (const Eigen::Vector2d &r : residuals) {
+        writer->AppendRow({r(0), r(1)});
+    }
+}
+
+std::vector<std::string> FilesWithExtension(const std::string &dir,
+                                            const std::string &ext,
+                                            bool recursive) {
+    if (!std::filesystem::exists(dir)) {
+        return {};
+    }
+    auto files = recursive ? FilesInDirRecursive(dir) : FilesInDir(dir);
+    files.erase(std::remove_if(files.begin(), files.end(),
+                               [&ext](const std::string &str) {
+                                   return std::filesystem::path(str).extension() != ext;
+                               }),
+                files.end());
+    return files;
+}
+
+/**
+ * collect the transformations of a workspace. Parameters are always saved by cereal ('dstFormat'),
+ * while time series (splines samples, inertial measurements, and residuals) are written as columns
+ * if 'columnar' is true
+ */
+std::vector<TransformTask> CollectTransformTasks(const std::string &ws,
+                                                 CerealArchiveType::Enum srcFormat,
+                                                 CerealArchiveType::Enum dstFormat,
+                                                 bool columnar) {
+    const auto &srcExt = Configor::Preference::FileExtension.at(srcFormat);
+    const auto &dstExt = Configor::Preference::FileExtension.at(dstFormat);
+    const auto &seriesExt = columnar ? Configor::GetColumnarExtension() : dstExt;
+    std::vector<TransformTask> tasks;
+
+    auto withExt = [](const std::string &filename, const std::string &ext) {
+        return std::filesystem::path(filename).replace_extension(ext).string();
+    };
+
+    // -------------------------
+    // spatiotemporal parameters
+    // -------------------------
+    auto paramFiles = FilesWithExtension(ws + "/iteration/epoch", srcExt, false);
+    for (const auto &filename : FilesWithExtension(ws + "/iteration/stage", srcExt, false)) {
+        paramFiles.push_back(filename);
+    }
+    if (std::filesystem::exists(ws + "/ikalibr_param" + srcExt)) {
+        paramFiles.push_back(ws + "/ikalibr_param" + srcExt);
+    }
+    for (const auto &rName : paramFiles) {
+        auto wName = withExt(rName, dstExt);
+        tasks.push_back({rName, wName, [=]() {
+                             CalibParamManager::Load(rName, srcFormat)->Save(wName, dstFormat);
+                         }});
+    }
+
+    // -------
+    // splines
+    // -------
+    auto rName = ws + "/splines/knots" + srcExt;
+    if (std::filesystem::exists(rName)) {
+        auto wName = withExt(rName, dstExt);
+        tasks.push_back({rName, wName, [=]() {
+                             auto bundle =
+                                 ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>::Create({});
+                             TransformArchive(rName, srcFormat, wName, dstFormat,
+                                              cereal::make_nvp("splines", *bundle));
+                         }});
+    }
+
+    rName = ws + "/splines/samples" + srcExt;
+    if (std::filesystem::exists(rName)) {
+        auto wName = withExt(rName, seriesExt);
+        tasks.push_back({rName, wName, [=]() {
+                             std::vector<ns_ctraj::Posed> poseSeq;
+                             if (columnar) {
+                                 LoadArchive(rName, srcFormat,
+                                             cereal::make_nvp("pose_seq", poseSeq));
+                                 SavePoseSequenceColumnar(poseSeq, wName);
+                             } else {
+                                 TransformArchive(rName, srcFormat, wName, dstFormat,
+                                                  cereal::make_nvp("pose_seq", poseSeq));
+                             }
+                         }});
+    }
+
+    // -------
+    // hessian
+    // -------
+    rName = ws + "/hessian/hessian" + srcExt;
+    if (std::filesystem::exists(rName)) {
+        auto wName = withExt(rName, dstExt);
+        tasks.push_back({rName, wName, [=]() {
+                             int row, col;
+                             std::vector<std::pair<std::string, int>> parOrderSize;
+                             Eigen::MatrixXd hessian;
+                             {
+                                 // load
+                                 std::ifstream file(rName);
+                                 auto ar = GetInputArchiveVariant(file, srcFormat);
+                                 SerializeByInputArchiveVariant(
+                                     ar, srcFormat, cereal::make_nvp("row", row),
+                                     cereal::make_nvp("col", col),
+                                     cereal::make_nvp("par_order_size", parOrderSize));
+                                 hessian.resize(row, col);
+                                 SerializeByInputArchiveVariant(
+                                     ar, srcFormat, cereal::make_nvp("hessian", hessian));
+                             }
+                             {
+                                 // output
+                                 std::ofstream file(wName);
+                                 auto ar = GetOutputArchiveVariant(file, dstFormat);
+                                 SerializeByOutputArchiveVariant(
+                                     ar, dstFormat, cereal::make_nvp("row", row),
+                                     cereal::make_nvp("col", col),
+                                     cereal::make_nvp("hessian", hessian),
+                                     cereal::make_nvp("par_order_size", parOrderSize));
+                             }
+                         }});
+    }
+
+    // ---------
+    // residuals
+    // ---------
+
+    // inertial errors
+    for (const auto &filename :
+         FilesWithExtension(ws + "/residuals/inertial_error", srcExt, true)) {
+        auto wName = withExt(filename, seriesExt);
+        const auto name = std::filesystem::path(filename).filename();
+        if (name == "inertial_mes" + srcExt) {
+            tasks.push_back({filename, wName, [=]() {
+                                 std::list<IMUFrame> rawMes, estMes, diff;
+                                 auto raw = cereal::make_nvp("raw_inertial", rawMes);
+                                 auto est = cereal::make_nvp("est_inertial", estMes);
+                                 auto dif = cereal::make_nvp("inertial_diff", diff);
+                                 if (columnar) {
+                                     LoadArchive(filename, srcFormat, raw, est, dif);
+                                     SaveInertialMesColumnar(
+                                         {{"raw", &rawMes}, {"est", &estMes}, {"diff", &diff}},
+                                         wName);
+                                 } else {
+                                     TransformArchive(filename, srcFormat, wName, dstFormat, raw,
+                                                      est, dif);
+                                 }
+                             }});
+        } else if (name == "aligned_mes_to_ref" + srcExt) {
+            tasks.push_back({filename, wName, [=]() {
+                                 std::list<IMUFrame> estMes;
+                                 auto est = cereal::make_nvp("aligned_inertial", estMes);
+                                 if (columnar) {
+                                     LoadArchive(filename, srcFormat, est);
+                                     SaveInertialMesColumnar({{"aligned", &estMes}}, wName);
+                                 } else {
+                                     TransformArchive(filename, srcFormat, wName, dstFormat, est);
+                                 }
+                             }});
+        }
+    }
+
+    // other residuals, i.e., reprojection, optical flow, radar doppler, and lidar point-to-surfel
+    auto addResiduals = [&](const std::string &subWS, const std::string &nvpName, auto tag) {
+        using Residual = decltype(tag);
+        for (const auto &filename : FilesWithExtension(ws + subWS, srcExt, true)) {
+            if (std::filesystem::path(filename).filename() != "residuals" + srcExt) {
+                continue;
+            }
+            auto wName = withExt(filename, seriesExt);
+            tasks.push_back({filename, wName, [=]() {
+                                 std::list<Residual> errors;
+                                 auto nvp = cereal::make_nvp(nvpName.c_str(), errors);
+                                 if (columnar) {
+                                     LoadArchive(filename, srcFormat, nvp);
+                                     SaveResidualsColumnar(errors, wName);
+                                 } else {
+                                     TransformArchive(filename, srcFormat, wName, dstFormat, nvp);
+                                 }
+                             }});
+        }
+    };
+    addResiduals("/residuals/reproj_error", "reproj_errors", Eigen::Vector2d{});
+    addResiduals("/residuals/optical_flow_error", "of_errors", Eigen::Vector2d{});
+    addResiduals("/residuals/doppler_error", "doppler_errors", double{});
+    addResiduals("/residuals/lidar_pts_error", "pts_errors", double{});
+
+    return tasks;
+}
+}  // namespace
+}  // namespace ns_ikalibr
+
 int main(int argc, char **argv) {
     ros::init(argc, argv, "ikalibr_data_format_transformer");
     try {
@@ -76,319 +372,67 @@ int main(int argc, char **argv) {
         auto dstFormatStr =
             ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_data_format_transformer/dst_format");
         spdlog::info("destination data format: '{}'", dstFormatStr);
-        ns_ikalibr::CerealArchiveType::Enum dstFormat;
-        try {
-            dstFormat = ns_ikalibr::EnumCast::stringToEnum<ns_ikalibr::CerealArchiveType::Enum>(
-                dstFormatStr);
-        } catch (...) {
-            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
-                                     "data format '{}' is unsupported!!!", dstFormatStr);
+        // for the columnar format, parameters (not time series) are saved as binary files
+        const bool columnar = dstFormatStr == "COLUMNAR";
+        ns_ikalibr::CerealArchiveType::Enum dstFormat = ns_ikalibr::CerealArchiveType::Enum::BINARY;
+        if (!columnar) {
+            try {
+                dstFormat = ns_ikalibr::EnumCast::stringToEnum<ns_ikalibr::CerealArchiveType::Enum>(
+                    dstFormatStr);
+            } catch (...) {
+                throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                         "data format '{}' is unsupported!!!", dstFormatStr);
+            }
+        }
+        const auto &dstExt =
+            columnar ? ns_ikalibr::Configor::GetColumnarExtension()
+                     : ns_ikalibr::Configor::Preference::FileExtension.at(dstFormat);
+
+        // non-positive: all hardware threads
+        auto threads =
+            ns_ikalibr::GetParamFromROS<int>("/ikalibr_data_format_transformer/threads");
+        if (threads <= 0) {
+            threads = static_cast<int>(std::thread::hardware_concurrency());
         }
-        const auto &dstExt = ns_ikalibr::Configor::Preference::FileExtension.at(dstFormat);
 
         auto wsDirVecSrc = ns_ikalibr::GetParamFromROS<std::vector<std::string>>(
             "/ikalibr_data_format_transformer/ws_dir_vec");
 
+        std::vector<ns_ikalibr::TransformTask> tasks;
         for (const auto &dir : wsDirVecSrc) {
             auto ws = preDir + '/' + dir;
             spdlog::info("perform data format transform for '{}', from '{}' to '{}'", ws, srcExt,
                          dstExt);
+            auto wsTasks = ns_ikalibr::CollectTransformTasks(ws, srcFormat, dstFormat, columnar);
+            tasks.insert(tasks.end(), wsTasks.begin(), wsTasks.end());
+        }
 
-            // -------------------------
-            // spatiotemporal parameters
-            // -------------------------
-            auto rName = ws + "/ikalibr_param" + srcExt;
-            auto wName = ws + "/ikalibr_param" + dstExt;
-            if (std::filesystem::exists(rName)) {
-                spdlog::info("perform transformation:\n   '{}'\n-> '{}'", rName, wName);
-                ns_ikalibr::CalibParamManager::Load(rName, srcFormat)->Save(wName, dstFormat);
-            }
-
-            // -------
-            // splines
-            // -------
-            rName = ws + "/splines/knots" + srcExt;
-            wName = ws + "/splines/knots" + dstExt;
-            if (std::filesystem::exists(rName)) {
-                spdlog::info("perform transformation:\n   '{}'\n-> '{}'", rName, wName);
-                auto bundle =
-                    ns_ctraj::SplineBundle<ns_ikalibr::Configor::Prior::SplineOrder>::Create({});
-                {
-                    // load
-                    std::ifstream file(rName);
-                    auto ar = ns_ikalibr::GetInputArchiveVariant(file, srcFormat);
-                    SerializeByInputArchiveVariant(ar, srcFormat,
-                                                   cereal::make_nvp("splines", *bundle));
-                }
-                {
-                    // output
-                    std::ofstream file(wName);
-                    auto ar = ns_ikalibr::GetOutputArchiveVariant(file, dstFormat);
-                    SerializeByOutputArchiveVariant(ar, dstFormat,
-                                                    cereal::make_nvp("splines", *bundle));
-                }
-            }
-
-            rName = ws + "/splines/samples" + srcExt;
-            wName = ws + "/splines/samples" + dstExt;
-            if (std::filesystem::exists(rName)) {
-                spdlog::info("perform transformation:\n   '{}'\n-> '{}'", rName, wName);
-                std::vector<ns_ctraj::Posed> poseSeq;
-                {
-                    // load
-                    std::ifstream file(rName);
-                    auto ar = ns_ikalibr::GetInputArchiveVariant(file, srcFormat);
-                    SerializeByInputArchiveVariant(ar, srcFormat,
-                                                   cereal::make_nvp("pose_seq", poseSeq));
-                }
-                {
-                    // output
-                    std::ofstream file(wName);
-                    auto ar = ns_ikalibr::GetOutputArchiveVariant(file, dstFormat);
-                    SerializeByOutputArchiveVariant(ar, dstFormat,
-                                                    cereal::make_nvp("pose_seq", poseSeq));
-                }
-            }
-
-            // -------
-            // hessian
-            // -------
-            rName = ws + "/hessian/hessian" + srcExt;
-            wName = ws + "/hessian/hessian" + dstExt;
-            if (std::filesystem::exists(rName)) {
-                spdlog::info("perform transformation:\n   '{}'\n-> '{}'", rName, wName);
-                int row, col;
-                std::vector<std::pair<std::string, int>> parOrderSize;
-                Eigen::MatrixXd hessian;
-                // load
-                {
-                    std::ifstream file(rName);
-                    auto ar = ns_ikalibr::GetInputArchiveVariant(file, srcFormat);
-                    SerializeByInputArchiveVariant(
-                        ar, srcFormat, cereal::make_nvp("row", row), cereal::make_nvp("col", col),
-                        cereal::make_nvp("par_order_size", parOrderSize));
-                    hessian.resize(row, col);
-                    SerializeByInputArchiveVariant(ar, srcFormat,
-                                                   cereal::make_nvp("hessian", hessian));
-                }
-                {
-                    // output
-                    std::ofstream file(wName);
-                    auto ar = ns_ikalibr::GetOutputArchiveVariant(file, dstFormat);
-                    SerializeByOutputArchiveVariant(
-                        ar, dstFormat, cereal::make_nvp("row", row), cereal::make_nvp("col", col),
-                        cereal::make_nvp("hessian", hessian),
-                        cereal::make_nvp("par_order_size", parOrderSize));
-                }
-            }
-
-            // ----------------------------
-            // parameters in each iteration
-            // ----------------------------
-            {
-                auto paramsEpochDir = ws + "/iteration/epoch";
-                if (std::filesystem::exists(paramsEpochDir)) {
-                    auto files = ns_ikalibr::FilesInDir(paramsEpochDir);
-                    files.erase(std::remove_if(files.begin(), files.end(),
-                                               [&srcExt](const std::string &str) {
-                                                   return std::filesystem::path(str).extension() !=
-                                                          srcExt;
-                                               }),
-                                files.end());
-                    for (const auto &filename : files) {
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        ns_ikalibr::CalibParamManager::Load(filename, srcFormat)
-                            ->Save(wName, dstFormat);
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
-            }
-
-            {
-                auto paramsStageDir = ws + "/iteration/stage";
-                if (std::filesystem::exists(paramsStageDir)) {
-                    auto files = ns_ikalibr::FilesInDir(paramsStageDir);
-                    files.erase(std::remove_if(files.begin(), files.end(),
-                                               [&srcExt](const std::string &str) {
-                                                   return std::filesystem::path(str).extension() !=
-                                                          srcExt;
-                                               }),
-                                files.end());
-                    for (const auto &filename : files) {
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        ns_ikalibr::CalibParamManager::Load(filename, srcFormat)
-                            ->Save(wName, dstFormat);
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
-            }
-
-            // ---------
-            // residuals
-            // ---------
-
-            // inertial errors
-            auto subWS = ws + "/residuals/inertial_error";
-            if (std::filesystem::exists(subWS)) {
-                auto files = ns_ikalibr::FilesInDirRecursive(subWS);
-                files.erase(std::remove_if(files.begin(), files.end(),
-                                           [&srcExt](const std::string &str) {
-                                               return std::filesystem::path(str).extension() !=
-                                                      srcExt;
-                                           }),
-                            files.end());
-                for (const auto &filename : files) {
-                    if (std::filesystem::path(filename).filename() == "inertial_mes" + srcExt) {
-                        std::list<ns_ikalibr::IMUFrame> rawMes, estMes, diff;
-                        // load
-                        std::ifstream ifile(filename);
-                        auto iar = GetInputArchiveVariant(ifile, srcFormat);
-                        SerializeByInputArchiveVariant(iar, srcFormat,
-                                                       cereal::make_nvp("raw_inertial", rawMes),
-                                                       cereal::make_nvp("est_inertial", estMes),
-                                                       cereal::make_nvp("inertial_diff", diff));
-                        // save
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        std::ofstream ofile(wName);
-                        auto oar = GetOutputArchiveVariant(ofile, dstFormat);
-                        SerializeByOutputArchiveVariant(oar, dstFormat,
-                                                        cereal::make_nvp("raw_inertial", rawMes),
-                                                        cereal::make_nvp("est_inertial", estMes),
-                                                        cereal::make_nvp("inertial_diff", diff));
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    } else if (std::filesystem::path(filename).filename() ==
-                               "aligned_mes_to_ref" + srcExt) {
-                        std::list<ns_ikalibr::IMUFrame> estMes;
-                        // load
-                        std::ifstream ifile(filename);
-                        auto iar = GetInputArchiveVariant(ifile, srcFormat);
-                        SerializeByInputArchiveVariant(
-                            iar, srcFormat, cereal::make_nvp("aligned_inertial", estMes));
-                        // save
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        std::ofstream ofile(wName);
-                        auto oar = GetOutputArchiveVariant(ofile, dstFormat);
-                        SerializeByOutputArchiveVariant(
-                            oar, dstFormat, cereal::make_nvp("aligned_inertial", estMes));
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
-            }
-
-            // reprojection error
-            subWS = ws + "/residuals/reproj_error";
-            if (std::filesystem::exists(subWS)) {
-                auto files = ns_ikalibr::FilesInDirRecursive(subWS);
-                files.erase(std::remove_if(files.begin(), files.end(),
-                                           [&srcExt](const std::string &str) {
-                                               return std::filesystem::path(str).extension() !=
-                                                      srcExt;
-                                           }),
-                            files.end());
-                for (const auto &filename : files) {
-                    if (std::filesystem::path(filename).filename() == "residuals" + srcExt) {
-                        std::list<Eigen::Vector2d> reprojErrors;
-                        // load
-                        std::ifstream ifile(filename);
-                        auto iar = GetInputArchiveVariant(ifile, srcFormat);
-                        SerializeByInputArchiveVariant(
-                            iar, srcFormat, cereal::make_nvp("reproj_errors", reprojErrors));
-                        // save
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        std::ofstream ofile(wName);
-                        auto oar = GetOutputArchiveVariant(ofile, dstFormat);
-                        SerializeByOutputArchiveVariant(
-                            oar, dstFormat, cereal::make_nvp("reproj_errors", reprojErrors));
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
-            }
-
-            // optical flow error
-            subWS = ws + "/residuals/optical_flow_error";
-            if (std::filesystem::exists(subWS)) {
-                auto files = ns_ikalibr::FilesInDirRecursive(subWS);
-                files.erase(std::remove_if(files.begin(), files.end(),
-                                           [&srcExt](const std::string &str) {
-                                               return std::filesystem::path(str).extension() !=
-                                                      srcExt;
-                                           }),
-                            files.end());
-                for (const auto &filename : files) {
-                    if (std::filesystem::path(filename).filename() == "residuals" + srcExt) {
-                        std::list<Eigen::Vector2d> velErrors;
-                        // load
-                        std::ifstream ifile(filename);
-                        auto iar = GetInputArchiveVariant(ifile, srcFormat);
-                        SerializeByInputArchiveVariant(iar, srcFormat,
-                                                       cereal::make_nvp("of_errors", velErrors));
-                        // save
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        std::ofstream ofile(wName);
-                        auto oar = GetOutputArchiveVariant(ofile, dstFormat);
-                        SerializeByOutputArchiveVariant(oar, dstFormat,
-                                                        cereal::make_nvp("of_errors", velErrors));
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
+        /**
+         * each task loads a single file and releases it once saved, thus at most 'threads' files
+         * are in memory. Tasks are scheduled dynamically as file sizes vary a lot (parameters vs.
+         * residuals), exceptions are rethrown after all tasks are finished
+         */
+        threads = std::max(1, std::min(threads, static_cast<int>(tasks.size())));
+        spdlog::info("'{}' files to transform using '{}' threads", tasks.size(), threads);
+        std::vector<std::exception_ptr> errors(tasks.size());
+#pragma omp parallel for num_threads(threads) schedule(dynamic)
+        for (int i = 0; i < static_cast<int>(tasks.size()); ++i) {
+            const auto &task = tasks.at(i);
+            try {
+                task.perform();
+                spdlog::info("perform transformation:\n   '{}'\n-> '{}'", task.rName, task.wName);
+            } catch (...) {
+                errors.at(i) = std::current_exception();
             }
-
-            // radar doppler error
-            subWS = ws + "/residuals/doppler_error";
-            if (std::filesystem::exists(subWS)) {
-                auto files = ns_ikalibr::FilesInDirRecursive(subWS);
-                files.erase(std::remove_if(files.begin(), files.end(),
-                                           [&srcExt](const std::string &str) {
-                                               return std::filesystem::path(str).extension() !=
-                                                      srcExt;
-                                           }),
-                            files.end());
-                for (const auto &filename : files) {
-                    if (std::filesystem::path(filename).filename() == "residuals" + srcExt) {
-                        std::list<double> dopplerErrors;
-                        // load
-                        std::ifstream ifile(filename);
-                        auto iar = GetInputArchiveVariant(ifile, srcFormat);
-                        SerializeByInputArchiveVariant(
-                            iar, srcFormat, cereal::make_nvp("doppler_errors", dopplerErrors));
-                        // save
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        std::ofstream ofile(wName);
-                        auto oar = GetOutputArchiveVariant(ofile, dstFormat);
-                        SerializeByOutputArchiveVariant(
-                            oar, dstFormat, cereal::make_nvp("doppler_errors", dopplerErrors));
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
+        }
+        for (int i = 0; i < static_cast<int>(tasks.size()); ++i) {
+            if (errors.at(i) != nullptr) {
+                spdlog::warn("transformation of '{}' failed!!!", tasks.at(i).rName);
             }
-
-            // lidar point-to-surfel error
-            subWS = ws + "/residuals/lidar_pts_error";
-            if (std::filesystem::exists(subWS)) {
-                auto files = ns_ikalibr::FilesInDirRecursive(subWS);
-                files.erase(std::remove_if(files.begin(), files.end(),
-                                           [&srcExt](const std::string &str) {
-                                               return std::filesystem::path(str).extension() !=
-                                                      srcExt;
-                                           }),
-                            files.end());
-                for (const auto &filename : files) {
-                    if (std::filesystem::path(filename).filename() == "residuals" + srcExt) {
-                        std::list<double> ptsErrors;
-                        // load
-                        std::ifstream ifile(filename);
-                        auto iar = GetInputArchiveVariant(ifile, srcFormat);
-                        SerializeByInputArchiveVariant(iar, srcFormat,
-                                                       cereal::make_nvp("pts_errors", ptsErrors));
-                        // save
-                        wName = std::filesystem::path(filename).replace_extension(dstExt).string();
-                        std::ofstream ofile(wName);
-                        auto oar = GetOutputArchiveVariant(ofile, dstFormat);
-                        SerializeByOutputArchiveVariant(oar, dstFormat,
-                                                        cereal::make_nvp("pts_errors", ptsErrors));
-                        spdlog::info("perform transformation:\n   '{}'\n-> '{}'", filename, wName);
-                    }
-                }
+        }
+        for (const auto &error : errors) {
+            if (error != nullptr) {
+                std::rethrow_exception(error);
             }
         }
 
@@ -39,11 +39,13 @@
 #include "cereal/types/utility.hpp"
 #include "opencv2/imgcodecs.hpp"
 #include "sensor_msgs/Image.h"
+#include "sensor_msgs/CompressedImage.h"
 #include "cv_bridge/cv_bridge.h"
 #include "rosbag/bag.h"
 #include "filesystem"
 #include "spdlog/fmt/bundled/color.h"
 #include "regex"
+#include "omp.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -156,37 +158,89 @@ int main(int argc, char **argv) {
         auto imgFrequency = ns_ikalibr::GetParamFromROS<int>("/ikalibr_imgs_to_bag/img_frequency");
         spdlog::info("if not use name as time stamp, the frequency is: '{}'", imgFrequency);
 
+        // 'raw' for 'sensor_msgs/Image', 'jpeg' or 'png' for 'sensor_msgs/CompressedImage'
+        auto format = ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_imgs_to_bag/format");
+        if (format != "raw" && format != "jpeg" && format != "png") {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                     "unknown image format '{}', options: 'raw', 'jpeg', 'png'",
+                                     format);
+        }
+        spdlog::info("the format of images in rosbag: '{}'", format);
+
+        // threads to read and encode images, non-positive value means all hardware threads
+        auto threads = ns_ikalibr::GetParamFromROS<int>("/ikalibr_imgs_to_bag/threads");
+        if (threads <= 0) {
+            threads = omp_get_max_threads();
+        }
+        spdlog::info("read and encode images using '{}' thread(s)", threads);
+
+        // images are written in the order of their time stamps
+        std::vector<int> indices;
+        for (int i = 0; i < static_cast<int>(filenames.size()); i += downsampleNum) {
+            indices.push_back(i);
+        }
+        std::stable_sort(indices.begin(), indices.end(), [&timestamps](int i1, int i2) {
+            return timestamps.at(i1) < timestamps.at(i2);
+        });
+        const int imgCount = static_cast<int>(indices.size());
+
         auto dstBag = std::make_unique<rosbag::Bag>();
         dstBag->open(bagPath, rosbag::BagMode::Write);
 
-        for (int i = 0; i < static_cast<int>(filenames.size()); ++i) {
-            // downsample
-            if (i % downsampleNum != 0) {
-                continue;
-            }
-
-            auto filename = filenames.at(i);
+        /**
+         * images are read and encoded by the threads in parallel, while their messages are written
+         * by one thread at a time in the order of 'indices' (the ordered region). Images finished
+         * ahead of their turn wait there, which bounds the reorder buffer to the thread count
+         */
+        std::exception_ptr exception = nullptr;
+#pragma omp parallel for num_threads(threads) ordered schedule(dynamic) default(none) \
+    shared(imgCount, indices, filenames, timestamps, encoding, format, imgsTopic, dstBag, exception)
+        for (int j = 0; j < imgCount; ++j) {
+            const int i = indices.at(j);
+            const auto &filename = filenames.at(i);
+            const auto stamp = ros::Time(timestamps.at(i));
+
+            sensor_msgs::Image rawImage;
+            sensor_msgs::CompressedImage compImage;
             auto img = cv::imread(filename, cv::IMREAD_UNCHANGED);
-            if (img.empty()) {
-                spdlog::warn("invalid image: '{}'!!!", filename);
-                continue;
+            if (!img.empty()) {
+                cv_bridge::CvImage cvImage;
+                cvImage.image = img;
+                cvImage.header.stamp = stamp;
+                cvImage.encoding = encoding;
+                if (format == "raw") {
+                    cvImage.toImageMsg(rawImage);
+                } else {
+                    cvImage.toCompressedImageMsg(
+                        compImage, format == "jpeg" ? cv_bridge::JPG : cv_bridge::PNG);
+                }
             }
 
-            auto time = timestamps.at(i);
-            spdlog::info("filename: '{}', time: '{:.3f}'",
-                         std::filesystem::path(filename).filename().string(), time);
-
-            cv_bridge::CvImage cvImage;
-            cvImage.image = img;
-            cvImage.header.stamp = ros::Time(time);
-            cvImage.encoding = encoding;
-
-            sensor_msgs::Image sensorImage;
-            cvImage.toImageMsg(sensorImage);
-            dstBag->write(imgsTopic, cvImage.header.stamp, sensorImage);
+#pragma omp ordered
+            {
+                if (img.empty()) {
+                    spdlog::warn("invalid image: '{}'!!!", filename);
+                } else if (exception == nullptr) {
+                    spdlog::info("filename: '{}', time: '{:.3f}'",
+                                 std::filesystem::path(filename).filename().string(),
+                                 stamp.toSec());
+                    try {
+                        if (format == "raw") {
+                            dstBag->write(imgsTopic, stamp, rawImage);
+                        } else {
+                            dstBag->write(imgsTopic, stamp, compImage);
+                        }
+                    } catch (...) {
+                        // exceptions can not be thrown out of the parallel region
+                        exception = std::current_exception();
+                    }
+                }
+            }
         }
-
         dstBag->close();
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
         spdlog::info("images in '{}' have been writen to rosbag as '{}'!", imgPath, bagPath);
 
     } catch (const ns_ikalibr::IKalibrStatus &status) {
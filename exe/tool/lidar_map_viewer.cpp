@@ -44,6 +44,9 @@
 #include "util/utils_tpl.hpp"
 #include "tiny-viewer/object/aligned_cloud.hpp"
 #include "tiny-viewer/core/pose.hpp"
+#include "util/tiled_cloud_map.hpp"
+#include "util/frame_encoder.h"
+#include "viewer/offscreen_renderer.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -97,6 +100,228 @@ ns_viewer::Posef GetCameraPose(const float radius, const float height, const flo
     return ns_viewer::Posef(rotMat, pos);
 }
 
+/**
+ * a tiled map streamed to a sub-window, entities of a tile are replaced once its level changes, and
+ * removed once it is out of the view range
+ */
+struct TiledLayer {
+    using TileKey = std::pair<int, int>;
+
+    std::string view;
+    std::function<std::map<TileKey, int>(const Eigen::Vector3f &)> visible;
+    std::function<std::vector<ns_viewer::Entity::Ptr>(const TileKey &, int)> load;
+    // levels and entity ids of loaded tiles
+    std::map<TileKey, std::pair<int, std::vector<std::size_t>>> loaded;
+
+    template <class ViewerType>
+    void Update(ViewerType &viewer, const Eigen::Vector3f &eye) {
+        const auto wanted = visible(eye);
+        std::vector<std::size_t> expired;
+        for (auto iter = loaded.begin(); iter != loaded.end();) {
+            auto target = wanted.find(iter->first);
+            if (target == wanted.cend() || target->second != iter->second.first) {
+                expired.insert(expired.end(), iter->second.second.cbegin(),
+                               iter->second.second.cend());
+                iter = loaded.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        if (!expired.empty()) {
+            viewer.RemoveEntity(expired, view);
+        }
+        for (const auto &[key, level] : wanted) {
+            if (loaded.find(key) != loaded.cend()) {
+                continue;
+            }
+            auto entities = load(key, level);
+            // tiles without points (e.g., filtered by z values) are recorded as well
+            std::vector<std::size_t> ids;
+            if (!entities.empty()) {
+                ids = viewer.AddEntity(entities, view);
+            }
+            loaded.insert({key, {level, ids}});
+        }
+    }
+};
+
+template <class PointType>
+typename ns_ikalibr::TiledCloudMap<PointType>::Ptr LoadTiledMap(const std::string &pcdFile,
+                                                                float tileSize,
+                                                                float leafSize,
+                                                                int levels) {
+    using TiledMap = ns_ikalibr::TiledCloudMap<PointType>;
+    const auto dir = std::filesystem::path(pcdFile).replace_extension(".tiles").string();
+    typename TiledMap::Ptr tiledMap = nullptr;
+    if (!TiledMap::IsOutdated(pcdFile, dir)) {
+        tiledMap = TiledMap::Load(dir);
+    }
+    // built by other settings
+    if (tiledMap != nullptr &&
+        (tiledMap->GetTileSize() != tileSize || tiledMap->GetLevels() != levels)) {
+        tiledMap = nullptr;
+    }
+    if (tiledMap == nullptr && std::filesystem::exists(pcdFile)) {
+        spdlog::info("build tiled map of '{}' in '{}' (only once)...", pcdFile, dir);
+        tiledMap = TiledMap::Build(pcdFile, dir, tileSize, leafSize, levels);
+    }
+    if (tiledMap == nullptr) {
+        spdlog::warn("load tiled map of '{}' failed!", pcdFile);
+    }
+    return tiledMap;
+}
+
+/**
+ * tiled maps of the workspaces, they are built (only once) if not exist or outdated
+ */
+std::vector<TiledLayer> CreateTiledLayers(const std::vector<std::pair<std::string, int>> &wsDirVec,
+                                          float tileSize,
+                                          float leafSize,
+                                          int tileLevels,
+                                          float viewRange,
+                                          float minZ,
+                                          float maxZ) {
+    std::vector<TiledLayer> layers;
+    for (const auto &[filename, type] : wsDirVec) {
+        TiledLayer layer;
+        layer.view = filename;
+        if (type == 0) {
+            auto alignedMap = LoadTiledMap<PosPoint>(filename, tileSize, leafSize, tileLevels);
+            if (alignedMap == nullptr) {
+                continue;
+            }
+            layer.visible = [alignedMap, viewRange](const Eigen::Vector3f &eye) {
+                return alignedMap->VisibleTiles(eye, viewRange);
+            };
+            layer.load = [alignedMap, minZ, maxZ](const TiledLayer::TileKey &key, int level) {
+                std::vector<ns_viewer::Entity::Ptr> entities;
+                auto cloud = alignedMap->LoadTile(key, level, minZ, maxZ);
+                if (!cloud->empty()) {
+                    entities.push_back(
+                        ns_viewer::AlignedCloud<PosPoint>::Create(cloud, {0, 0, -1}));
+                }
+                return entities;
+            };
+        } else {
+            // type == 1
+            std::string alignedFilename = filename, search = "lidar_surfel_map",
+                        replace = "lidar_aligned_map";
+            size_t pos = alignedFilename.find(search);
+            if (pos != std::string::npos) {
+                alignedFilename.replace(pos, search.length(), replace);
+            }
+            auto surfelMap =
+                LoadTiledMap<ColorPoint>(filename, tileSize, leafSize * 0.5f, tileLevels);
+            auto alignedMap =
+                LoadTiledMap<PosPoint>(alignedFilename, tileSize, leafSize, tileLevels);
+            if (surfelMap == nullptr || alignedMap == nullptr) {
+                continue;
+            }
+            layer.visible = [surfelMap, viewRange](const Eigen::Vector3f &eye) {
+                return surfelMap->VisibleTiles(eye, viewRange);
+            };
+            layer.load = [surfelMap, alignedMap, minZ, maxZ](
+                             const TiledLayer::TileKey &key, int level) {
+                std::vector<ns_viewer::Entity::Ptr> entities;
+                auto surfelCloud = surfelMap->LoadTile(key, level, minZ, maxZ);
+                if (!surfelCloud->empty()) {
+                    entities.push_back(ns_viewer::Cloud<ColorPoint>::Create(surfelCloud));
+                }
+                auto alignedCloud = alignedMap->LoadTile(key, level, minZ, maxZ);
+                if (!alignedCloud->empty()) {
+                    pcl::PointCloud<pcl::PointXYZ>::Ptr alignedCloudRaw(
+                        new pcl::PointCloud<pcl::PointXYZ>);
+                    pcl::copyPointCloud(*alignedCloud, *alignedCloudRaw);
+                    auto color = ns_viewer::Colour::Black().WithAlpha(0.2f);
+                    entities.push_back(ns_viewer::Cloud<pcl::PointXYZ>::Create(
+                        alignedCloudRaw, DefaultPointSize, color));
+                }
+                return entities;
+            };
+        }
+        layers.push_back(layer);
+    }
+    return layers;
+}
+
+/**
+ * load the whole maps (rather than tiles) into the viewer, which is either a 'MultiViewer' or an
+ * 'OffscreenRenderer'
+ */
+template <class ViewerType>
+void AddWholeMaps(ViewerType &viewer,
+                  const std::vector<std::pair<std::string, int>> &wsDirVec,
+                  int mode,
+                  float minZ,
+                  float maxZ,
+                  float leafSize) {
+    PosPointCloud::Ptr alignedCloudCopy = nullptr;
+    for (const auto &[filename, type] : wsDirVec) {
+        spdlog::info("load pcd from '{}'...", filename);
+
+        if (type == 0) {
+            PosPointCloud::Ptr alignedCloud(new PosPointCloud);
+            if (pcl::io::loadPCDFile(filename, *alignedCloud) == -1) {
+                spdlog::warn("load lidar aligned map from '{}' failed!", filename);
+                continue;
+            }
+            alignedCloud = CloudFilter<PosPoint>(alignedCloud, minZ, maxZ, leafSize);
+            viewer.AddEntity(ns_viewer::AlignedCloud<PosPoint>::Create(alignedCloud, {0, 0, -1}),
+                             filename);
+            // aligned cloud is stored for surfel map visualization
+            if (mode == 2) {
+                alignedCloudCopy = alignedCloud;
+            }
+        } else {
+            // type == 1
+
+            // load surfel map
+            ColorPointCloud::Ptr surfelCloud(new ColorPointCloud);
+            if (pcl::io::loadPCDFile(filename, *surfelCloud) == -1) {
+                spdlog::warn("load lidar surfel map from '{}' failed!", filename);
+                continue;
+            }
+
+            surfelCloud = CloudFilter<ColorPoint>(surfelCloud, minZ, maxZ, leafSize * 0.5f);
+            viewer.AddEntity(ns_viewer::Cloud<ColorPoint>::Create(surfelCloud), filename);
+            surfelCloud.reset();
+
+            // load aligned map
+            PosPointCloud::Ptr alignedCloud(new PosPointCloud);
+
+            // if aligned is loaded, use it
+            if (alignedCloudCopy != nullptr) {
+                alignedCloud = alignedCloudCopy;
+                alignedCloudCopy = nullptr;
+            } else {
+                std::string alignedFilename = filename, search = "lidar_surfel_map",
+                            replace = "lidar_aligned_map";
+                size_t pos = alignedFilename.find(search);
+                if (pos != std::string::npos) {
+                    alignedFilename.replace(pos, search.length(), replace);
+                }
+
+                if (pcl::io::loadPCDFile(alignedFilename, *alignedCloud) == -1) {
+                    spdlog::warn("load aligned lidar map from '{}' failed!", alignedFilename);
+                    continue;
+                }
+                alignedCloud = CloudFilter<PosPoint>(alignedCloud, minZ, maxZ, leafSize);
+            }
+
+            pcl::PointCloud<pcl::PointXYZ>::Ptr alignedCloudRaw(new pcl::PointCloud<pcl::PointXYZ>);
+            pcl::copyPointCloud(*alignedCloud, *alignedCloudRaw);
+            alignedCloud.reset();
+
+            auto color = ns_viewer::Colour::Black().WithAlpha(0.2f);
+            viewer.AddEntity(
+                ns_viewer::Cloud<pcl::PointXYZ>::Create(alignedCloudRaw, DefaultPointSize, color),
+                filename);
+            alignedCloudRaw.reset();
+        }
+    }
+    alignedCloudCopy.reset();
+}
+
 int main(int argc, char **argv) {
     ros::init(argc, argv, "ikalibr_lidar_map_viewer");
     try {
@@ -149,6 +374,32 @@ int main(int argc, char **argv) {
         }
         spdlog::info("size of window grid: '{}'", winGridSize);
 
+        // maps are cut into tiles with multiple levels of detail, and streamed around the camera
+        auto tiled = ns_ikalibr::GetParamFromROS<bool>("/ikalibr_lidar_map_viewer/tiled");
+        auto tileSize =
+            (float)ns_ikalibr::GetParamFromROS<double>("/ikalibr_lidar_map_viewer/tile_size");
+        auto tileLevels = ns_ikalibr::GetParamFromROS<int>("/ikalibr_lidar_map_viewer/tile_levels");
+        auto viewRange =
+            (float)ns_ikalibr::GetParamFromROS<double>("/ikalibr_lidar_map_viewer/view_range");
+        if (tiled) {
+            if (tileSize <= 0.0f || tileLevels < 1) {
+                throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                         "wrong tile size or tile levels is set!");
+            }
+            spdlog::info("tile size: '{:.3f}', tile levels: '{}', view range: '{:.3f}'", tileSize,
+                         tileLevels, viewRange);
+        }
+
+        // render frames without any window as fast as possible, and encode them in parallel
+        auto offscreen = ns_ikalibr::GetParamFromROS<bool>("/ikalibr_lidar_map_viewer/offscreen");
+        auto frameCount = ns_ikalibr::GetParamFromROS<int>("/ikalibr_lidar_map_viewer/frame_count");
+        auto video = ns_ikalibr::GetParamFromROS<bool>("/ikalibr_lidar_map_viewer/video");
+        auto encodeThreads =
+            ns_ikalibr::GetParamFromROS<int>("/ikalibr_lidar_map_viewer/encode_threads");
+        if (encodeThreads <= 0) {
+            encodeThreads = static_cast<int>(std::thread::hardware_concurrency());
+        }
+
         auto wsDirVecSrc = ns_ikalibr::GetParamFromROS<std::vector<std::string>>(
             "/ikalibr_lidar_map_viewer/ws_dir_vec");
         std::vector<std::pair<std::string, int>> wsDirVec;
@@ -181,103 +432,97 @@ int main(int argc, char **argv) {
             }
         }
 
-        ns_viewer::MultiViewerConfigor configor(viewerNames, "lidar-map-viewer");
-        configor.window.width = col * winGridSize;
-        configor.window.height = row * winGridSize;
-        configor.output.dataOutputPath = outputDir;
-
-        for (const auto &name : viewerNames) {
-            auto &cam = configor.camera.at(name);
-            cam.height = winGridSize;
-            cam.width = winGridSize;
-            cam.cx = winGridSize * 0.5;
-            cam.cy = winGridSize * 0.5;
-
-            configor.grid.at(name).showGrid = false;
+        std::vector<TiledLayer> layers;
+        if (tiled) {
+            layers = CreateTiledLayers(wsDirVec, tileSize, leafSize, tileLevels, viewRange, minZ,
+                                       maxZ);
         }
 
-        ns_viewer::MultiViewer viewer(configor);
-        viewer.RunInMultiThread();
-        // set init camera poses
-        for (const auto &name : viewerNames) {
-            viewer.SetCamView(GetCameraPose(camRadius, camHeight, rotRate), name);
-        }
-
-        PosPointCloud::Ptr alignedCloudCopy = nullptr;
-        for (const auto &[filename, type] : wsDirVec) {
-            spdlog::info("load pcd from '{}'...", filename);
-
-            if (type == 0) {
-                PosPointCloud::Ptr alignedCloud(new PosPointCloud);
-                if (pcl::io::loadPCDFile(filename, *alignedCloud) == -1) {
-                    spdlog::warn("load lidar aligned map from '{}' failed!", filename);
-                    continue;
-                }
-                alignedCloud = CloudFilter<PosPoint>(alignedCloud, minZ, maxZ, leafSize);
-                viewer.AddEntity(
-                    ns_viewer::AlignedCloud<PosPoint>::Create(alignedCloud, {0, 0, -1}), filename);
-                // aligned cloud is stored for surfel map visualization
-                if (mode == 2) {
-                    alignedCloudCopy = alignedCloud;
-                }
-            } else {
-                // type == 1
-
-                // load surfel map
-                ColorPointCloud::Ptr surfelCloud(new ColorPointCloud);
-                if (pcl::io::loadPCDFile(filename, *surfelCloud) == -1) {
-                    spdlog::warn("load lidar surfel map from '{}' failed!", filename);
-                    continue;
+        if (offscreen) {
+            auto renderer = ns_ikalibr::OffscreenRenderer::Create(viewerNames, col, winGridSize);
+            if (!renderer->IsValid()) {
+                throw ns_ikalibr::Status(
+                    ns_ikalibr::Status::ERROR,
+                    "offscreen rendering is unavailable, is iKalibr built with egl?");
+            }
+            if (!tiled) {
+                AddWholeMaps(*renderer, wsDirVec, mode, minZ, maxZ, leafSize);
+            }
+            // one revolution by default, the angle increases by 'rotRate' for each view per frame
+            if (frameCount <= 0) {
+                frameCount = rotRate > 0.0f ? static_cast<int>(std::ceil(
+                                                  2.0 * M_PI / (rotRate * wsDirVec.size())))
+                                            : 1;
+            }
+            auto encoder = ns_ikalibr::FrameEncoder::Create(
+                outputDir,
+                video ? ns_ikalibr::FrameEncoder::Format::VIDEO
+                      : ns_ikalibr::FrameEncoder::Format::PNG,
+                encodeThreads, 2 * encodeThreads);
+            spdlog::info("render '{}' frames offscreen to '{}'...", frameCount, outputDir);
+            for (int i = 0; i < frameCount && ros::ok(); ++i) {
+                std::map<std::string, ns_viewer::Posef> camPoses;
+                for (const auto &[filename, type] : wsDirVec) {
+                    camPoses.insert({filename, GetCameraPose(camRadius, camHeight, rotRate)});
                 }
-
-                surfelCloud = CloudFilter<ColorPoint>(surfelCloud, minZ, maxZ, leafSize * 0.5f);
-                viewer.AddEntity(ns_viewer::Cloud<ColorPoint>::Create(surfelCloud), filename);
-                surfelCloud.reset();
-
-                // load aligned map
-                PosPointCloud::Ptr alignedCloud(new PosPointCloud);
-
-                // if aligned is loaded, use it
-                if (alignedCloudCopy != nullptr) {
-                    alignedCloud = alignedCloudCopy;
-                    alignedCloudCopy = nullptr;
-                } else {
-                    std::string alignedFilename = filename, search = "lidar_surfel_map",
-                                replace = "lidar_aligned_map";
-                    size_t pos = alignedFilename.find(search);
-                    if (pos != std::string::npos) {
-                        alignedFilename.replace(pos, search.length(), replace);
-                    }
-
-                    if (pcl::io::loadPCDFile(alignedFilename, *alignedCloud) == -1) {
-                        spdlog::warn("load aligned lidar map from '{}' failed!", alignedFilename);
-                        continue;
-                    }
-                    alignedCloud = CloudFilter<PosPoint>(alignedCloud, minZ, maxZ, leafSize);
+                for (auto &layer : layers) {
+                    layer.Update(*renderer, camPoses.at(layer.view).translation);
                 }
+                encoder->Push(renderer->Render(camPoses));
+            }
+            if (int failed = encoder->Finish(); failed > 0) {
+                spdlog::warn("'{}' frames failed to be encoded!", failed);
+            }
+        } else {
+            ns_viewer::MultiViewerConfigor configor(viewerNames, "lidar-map-viewer");
+            configor.window.width = col * winGridSize;
+            configor.window.height = row * winGridSize;
+            configor.output.dataOutputPath = outputDir;
+
+            for (const auto &name : viewerNames) {
+                auto &cam = configor.camera.at(name);
+                cam.height = winGridSize;
+                cam.width = winGridSize;
+                cam.cx = winGridSize * 0.5;
+                cam.cy = winGridSize * 0.5;
+
+                configor.grid.at(name).showGrid = false;
+            }
 
-                pcl::PointCloud<pcl::PointXYZ>::Ptr alignedCloudRaw(
-                    new pcl::PointCloud<pcl::PointXYZ>);
-                pcl::copyPointCloud(*alignedCloud, *alignedCloudRaw);
-                alignedCloud.reset();
-
-                auto color = ns_viewer::Colour::Black().WithAlpha(0.2f);
-                viewer.AddEntity(ns_viewer::Cloud<pcl::PointXYZ>::Create(alignedCloudRaw,
-                                                                         DefaultPointSize, color),
-                                 filename);
-                alignedCloudRaw.reset();
+            ns_viewer::MultiViewer viewer(configor);
+            viewer.RunInMultiThread();
+            // set init camera poses
+            for (const auto &name : viewerNames) {
+                viewer.SetCamView(GetCameraPose(camRadius, camHeight, rotRate), name);
             }
-        }
-        alignedCloudCopy.reset();
 
-        if (rotRate > 0.0) {
-            ros::start();
-            ros::Rate r(25);
-            while (ros::ok() && viewer.IsActive()) {
-                for (const auto &[filename, type] : wsDirVec) {
-                    viewer.SetCamView(GetCameraPose(camRadius, camHeight, rotRate), filename);
+            if (!tiled) {
+                AddWholeMaps(viewer, wsDirVec, mode, minZ, maxZ, leafSize);
+            }
+            // tiles around the (orbiting) camera are loaded, and the others are released
+            auto updateLayers = [&]() {
+                for (auto &layer : layers) {
+                    const auto camPose = GetCameraPose(camRadius, camHeight, rotRate);
+                    viewer.SetCamView(camPose, layer.view);
+                    layer.Update(viewer, camPose.translation);
+                }
+            };
+            updateLayers();
+
+            if (rotRate > 0.0) {
+                ros::start();
+                ros::Rate r(25);
+                while (ros::ok() && viewer.IsActive()) {
+                    if (tiled) {
+                        updateLayers();
+                    } else {
+                        for (const auto &[filename, type] : wsDirVec) {
+                            viewer.SetCamView(GetCameraPose(camRadius, camHeight, rotRate),
+                                              filename);
+                        }
+                    }
+                    r.sleep();
                 }
-                r.sleep();
             }
         }
 
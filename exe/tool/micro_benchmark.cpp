@@ -0,0 +1,473 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "benchmark/benchmark.h"
+#include "spdlog/spdlog.h"
+#include "config/configor.h"
+#include "calib/estimator.h"
+#include "core/pts_association.h"
+#include "core/visual_distortion.h"
+#include "core/event_preprocessing.h"
+#include "factor/data_correspondence.h"
+#include "sensor/lidar_data_loader.h"
+#include "sensor/radar.h"
+#include "pcl_conversions/pcl_conversions.h"
+#include "veta/camera/pinhole_brown.h"
+#include "random"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+/**
+ * microbenchmarks of hot kernels in iKalibr, all inputs are synthesized (fixed seeds), so no bag
+ * or configure file is required. Factors are benchmarked on single residual blocks built by the
+ * estimator, thus the exact cost functions (sized or dynamic) used in calibration are measured.
+ * run with '--benchmark_filter=<regex>' to select benchmarks, see Google Benchmark for more
+ */
+namespace ns_ikalibr {
+static const std::string IMU_TOPIC = "/bench/imu";
+static const std::string RADAR_TOPIC = "/bench/radar";
+static const std::string LIDAR_TOPIC = "/bench/lidar";
+static const std::string CAMERA_TOPIC = "/bench/camera";
+static constexpr double SPLINE_ST = 0.0, SPLINE_ET = 10.0, SPLINE_DT = 0.05;
+static constexpr int IMG_WIDTH = 640, IMG_HEIGHT = 480;
+
+template <int Order>
+typename ns_ctraj::SplineBundle<Order>::Ptr CreateRandomSplines(double dt) {
+    auto splines = ns_ctraj::SplineBundle<Order>::Create(
+        {ns_ctraj::SplineInfo(Configor::Preference::SO3_SPLINE, ns_ctraj::SplineType::So3Spline,
+                              SPLINE_ST, SPLINE_ET, dt),
+         ns_ctraj::SplineInfo(Configor::Preference::SCALE_SPLINE, ns_ctraj::SplineType::RdSpline,
+                              SPLINE_ST, SPLINE_ET, dt)});
+    // random knots, so that evaluations are not on degenerate (identity) states
+    std::default_random_engine engine(0);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+        so3Spline.GetKnot(i) =
+            Sophus::SO3d::exp(Eigen::Vector3d(noise(engine), noise(engine), noise(engine)));
+    }
+    auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    for (int i = 0; i < static_cast<int>(scaleSpline.GetKnots().size()); ++i) {
+        scaleSpline.GetKnot(i) = Eigen::Vector3d(noise(engine), noise(engine), noise(engine));
+    }
+    return splines;
+}
+
+ns_veta::PinholeIntrinsic::Ptr CreateBrownIntrinsics() {
+    return ns_veta::PinholeIntrinsicBrownT2::Create(IMG_WIDTH, IMG_HEIGHT, 460.0, 460.0, 320.0,
+                                                    240.0, -0.28, 0.07, 0.0, 1E-4, 2E-5);
+}
+
+CalibParamManager::Ptr CreateParamManager() {
+    auto parMagr = CalibParamManager::Create({IMU_TOPIC}, {RADAR_TOPIC}, {LIDAR_TOPIC},
+                                             {CAMERA_TOPIC}, {}, {});
+    parMagr->INTRI.Camera.at(CAMERA_TOPIC) = CreateBrownIntrinsics();
+    parMagr->GRAVITY = Eigen::Vector3d(0.0, 0.0, -9.8);
+    parMagr->EXTRI.POS_RjInBr.at(RADAR_TOPIC) = Eigen::Vector3d(0.1, 0.0, 0.05);
+    parMagr->EXTRI.POS_LkInBr.at(LIDAR_TOPIC) = Eigen::Vector3d(0.0, 0.1, 0.05);
+    parMagr->EXTRI.POS_CmInBr.at(CAMERA_TOPIC) = Eigen::Vector3d(0.05, 0.0, 0.1);
+    return parMagr;
+}
+
+Estimator::Opt FactorOption(bool estimateTimeOffsets) {
+    auto option = Estimator::Opt::OPT_SO3_SPLINE | Estimator::Opt::OPT_SCALE_SPLINE |
+                  Estimator::Opt::OPT_SO3_BiToBr | Estimator::Opt::OPT_POS_BiInBr |
+                  Estimator::Opt::OPT_SO3_RjToBr | Estimator::Opt::OPT_POS_RjInBr |
+                  Estimator::Opt::OPT_SO3_LkToBr | Estimator::Opt::OPT_POS_LkInBr |
+                  Estimator::Opt::OPT_SO3_CmToBr | Estimator::Opt::OPT_POS_CmInBr |
+                  Estimator::Opt::OPT_VISUAL_DEPTH;
+    if (estimateTimeOffsets) {
+        // time offsets are padded, the dynamic-size cost functions would be used
+        option |= Estimator::Opt::OPT_TO_RjToBr | Estimator::Opt::OPT_TO_LkToBr |
+                  Estimator::Opt::OPT_TO_CmToBr | Estimator::Opt::OPT_RS_CAM_READOUT_TIME;
+    }
+    return option;
+}
+
+/**
+ * evaluate the cost function of the only residual block in the estimator, arg 0: whether the time
+ * offsets are estimated, arg 1: whether jacobians are evaluated
+ */
+void EvaluateResidualBlock(benchmark::State &state, const Estimator::Ptr &estimator) {
+    std::vector<ceres::ResidualBlockId> resBlocks;
+    estimator->GetResidualBlocks(&resBlocks);
+    if (resBlocks.size() != 1) {
+        state.SkipWithError("the residual block is not added");
+        return;
+    }
+    const auto *costFunc = estimator->GetCostFunctionForResidualBlock(resBlocks.front());
+    std::vector<double *> parBlocks;
+    estimator->GetParameterBlocksForResidualBlock(resBlocks.front(), &parBlocks);
+
+    const bool withJacobians = state.range(1) != 0;
+    const auto &parBlockSizes = costFunc->parameter_block_sizes();
+    std::vector<double> residuals(costFunc->num_residuals());
+    std::vector<std::vector<double>> jacobians(parBlockSizes.size());
+    std::vector<double *> jacobianPtrs(parBlockSizes.size());
+    for (int i = 0; i < static_cast<int>(parBlockSizes.size()); ++i) {
+        jacobians.at(i).resize(costFunc->num_residuals() * parBlockSizes.at(i));
+        jacobianPtrs.at(i) = jacobians.at(i).data();
+    }
+
+    for (auto _ : state) {
+        bool success = costFunc->Evaluate(parBlocks.data(), residuals.data(),
+                                          withJacobians ? jacobianPtrs.data() : nullptr);
+        benchmark::DoNotOptimize(success);
+        benchmark::ClobberMemory();
+    }
+    state.counters["ParBlocks"] = static_cast<double>(parBlocks.size());
+    state.counters["Residuals"] = costFunc->num_residuals();
+}
+
+void FactorArguments(benchmark::internal::Benchmark *bench) {
+    bench->ArgNames({"time_offset", "jacobian"});
+    for (int timeOffset : {0, 1}) {
+        for (int jacobian : {0, 1}) {
+            bench->Args({timeOffset, jacobian});
+        }
+    }
+}
+
+void BM_IMUGyroFactor(benchmark::State &state) {
+    auto estimator = Estimator::Create(CreateRandomSplines<Configor::Prior::SplineOrder>(SPLINE_DT),
+                                       CreateParamManager());
+    auto frame = IMUFrame::Create(5.012, Eigen::Vector3d(0.1, -0.2, 0.3),
+                                  Eigen::Vector3d(0.2, 0.1, 9.7));
+    auto option = FactorOption(state.range(0) != 0) | Estimator::Opt::OPT_GYRO_BIAS |
+                  Estimator::Opt::OPT_GYRO_MAP_COEFF | Estimator::Opt::OPT_SO3_AtoG;
+    if (state.range(0) != 0) {
+        option |= Estimator::Opt::OPT_TO_BiToBr;
+    }
+    estimator->AddIMUGyroMeasurement(frame, IMU_TOPIC, option, 1.0);
+    EvaluateResidualBlock(state, estimator);
+}
+
+void BM_IMUAcceFactor(benchmark::State &state) {
+    auto estimator = Estimator::Create(CreateRandomSplines<Configor::Prior::SplineOrder>(SPLINE_DT),
+                                       CreateParamManager());
+    auto frame = IMUFrame::Create(5.012, Eigen::Vector3d(0.1, -0.2, 0.3),
+                                  Eigen::Vector3d(0.2, 0.1, 9.7));
+    auto option = FactorOption(state.range(0) != 0) | Estimator::Opt::OPT_ACCE_BIAS |
+                  Estimator::Opt::OPT_ACCE_MAP_COEFF | Estimator::Opt::OPT_GRAVITY;
+    if (state.range(0) != 0) {
+        option |= Estimator::Opt::OPT_TO_BiToBr;
+    }
+    estimator->AddIMUAcceMeasurement<TimeDeriv::LIN_POS_SPLINE>(frame, IMU_TOPIC, option, 1.0);
+    EvaluateResidualBlock(state, estimator);
+}
+
+void BM_PointToSurfelFactor(benchmark::State &state) {
+    auto estimator = Estimator::Create(CreateRandomSplines<Configor::Prior::SplineOrder>(SPLINE_DT),
+                                       CreateParamManager());
+    auto corrs = PointToSurfelCorrBuffer::Create();
+    auto surfelIdx = corrs->surfels->Insert(ufo::map::Node(), Eigen::Vector4d(0.0, 0.0, 1.0, 1.8));
+    corrs->Append(5.012, Eigen::Vector3f(3.2f, -1.5f, 0.4f), 1.0f, surfelIdx);
+    estimator->AddLiDARPointToSurfelConstraint<TimeDeriv::LIN_POS_SPLINE>(
+        *corrs, 0, LIDAR_TOPIC, FactorOption(state.range(0) != 0), 1.0);
+    EvaluateResidualBlock(state, estimator);
+}
+
+void BM_VisualReProjFactor(benchmark::State &state) {
+    auto estimator = Estimator::Create(CreateRandomSplines<Configor::Prior::SplineOrder>(SPLINE_DT),
+                                       CreateParamManager());
+    auto corr = VisualReProjCorr::Create(5.012, 5.112, Eigen::Vector2d(210.5, 132.7),
+                                         Eigen::Vector2d(218.1, 140.2), 132.7 / IMG_HEIGHT,
+                                         140.2 / IMG_HEIGHT, 1.0);
+    double globalScale = 1.0, invDepth = 0.2;
+    estimator->AddVisualReprojection<TimeDeriv::LIN_POS_SPLINE>(
+        corr, CAMERA_TOPIC, &globalScale, &invDepth, FactorOption(state.range(0) != 0), 1.0);
+    EvaluateResidualBlock(state, estimator);
+}
+
+void BM_RadarFactor(benchmark::State &state) {
+    auto estimator = Estimator::Create(CreateRandomSplines<Configor::Prior::SplineOrder>(SPLINE_DT),
+                                       CreateParamManager());
+    auto target = RadarTarget::Create(5.012, Eigen::Vector3d(8.2, 1.3, -0.4), -1.7);
+    estimator->AddRadarMeasurement<TimeDeriv::LIN_POS_SPLINE>(
+        target, RADAR_TOPIC, FactorOption(state.range(0) != 0), 1.0);
+    EvaluateResidualBlock(state, estimator);
+}
+
+BENCHMARK(BM_IMUGyroFactor)->Apply(FactorArguments);
+BENCHMARK(BM_IMUAcceFactor)->Apply(FactorArguments);
+BENCHMARK(BM_PointToSurfelFactor)->Apply(FactorArguments);
+BENCHMARK(BM_VisualReProjFactor)->Apply(FactorArguments);
+BENCHMARK(BM_RadarFactor)->Apply(FactorArguments);
+
+// spline evaluations of the given order at random times, arg 0: the knot distance (in ms)
+template <int Order>
+void BM_SplineEvaluate(benchmark::State &state) {
+    auto splines = CreateRandomSplines<Order>(static_cast<double>(state.range(0)) * 1E-3);
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+
+    std::default_random_engine engine(0);
+    std::uniform_real_distribution<double> timeDist(so3Spline.MinTime(),
+                                                    so3Spline.MaxTime() - 1E-3);
+    std::vector<double> times(1024);
+    for (auto &t : times) {
+        t = timeDist(engine);
+    }
+
+    std::size_t idx = 0;
+    for (auto _ : state) {
+        const double t = times[idx++ % times.size()];
+        auto so3 = so3Spline.Evaluate(t);
+        Eigen::Vector3d angVel = so3Spline.VelocityBody(t);
+        Eigen::Vector3d pos = scaleSpline.Evaluate<0>(t);
+        Eigen::Vector3d linAcce = scaleSpline.Evaluate<2>(t);
+        benchmark::DoNotOptimize(so3);
+        benchmark::DoNotOptimize(angVel);
+        benchmark::DoNotOptimize(pos);
+        benchmark::DoNotOptimize(linAcce);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+
+BENCHMARK_TEMPLATE(BM_SplineEvaluate, 3)->ArgName("dt_ms")->Arg(20)->Arg(100);
+BENCHMARK_TEMPLATE(BM_SplineEvaluate, 4)->ArgName("dt_ms")->Arg(20)->Arg(100);
+BENCHMARK_TEMPLATE(BM_SplineEvaluate, 5)->ArgName("dt_ms")->Arg(20)->Arg(100);
+BENCHMARK_TEMPLATE(BM_SplineEvaluate, 6)->ArgName("dt_ms")->Arg(20)->Arg(100);
+
+/**
+ * a procedural scene of a box room (floor, ceiling, and four walls), points are sampled with a
+ * small noise, the scan is the room observed from a pose near the origin
+ */
+IKalibrPointCloud::Ptr CreateRoomCloud(int count, double noise, unsigned int seed) {
+    std::default_random_engine engine(seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::normal_distribution<double> gaussian(0.0, noise);
+    std::uniform_int_distribution<int> faceDist(0, 5);
+    constexpr double HALF_X = 10.0, HALF_Y = 6.0, HALF_Z = 2.0;
+
+    IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud);
+    cloud->reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Eigen::Vector3d p(uniform(engine) * HALF_X, uniform(engine) * HALF_Y,
+                          uniform(engine) * HALF_Z);
+        switch (faceDist(engine)) {
+            case 0:
+                p(0) = -HALF_X;
+                break;
+            case 1:
+                p(0) = HALF_X;
+                break;
+            case 2:
+                p(1) = -HALF_Y;
+                break;
+            case 3:
+                p(1) = HALF_Y;
+                break;
+            case 4:
+                p(2) = -HALF_Z;
+                break;
+            default:
+                p(2) = HALF_Z;
+                break;
+        }
+        p += Eigen::Vector3d(gaussian(engine), gaussian(engine), gaussian(engine));
+        IKalibrPoint point;
+        point.x = static_cast<float>(p(0));
+        point.y = static_cast<float>(p(1));
+        point.z = static_cast<float>(p(2));
+        point.timestamp = 0.1 * i / count;
+        cloud->push_back(point);
+    }
+    return cloud;
+}
+
+// associate a scan to the surfel map, arg 0: the number of points in the scan
+void BM_PointToSurfelAssociation(benchmark::State &state) {
+    static const auto MapCloud = CreateRoomCloud(500000, 0.01, 0);
+    static const auto Associator = PointToSurfelAssociator::Create(
+        MapCloud, Configor::Prior::LiDARDataAssociate::MapResolution,
+        Configor::Prior::LiDARDataAssociate::MapDepthLevels);
+
+    // the scan is in the map frame here, the same cloud is taken as the raw one
+    auto scan = CreateRoomCloud(static_cast<int>(state.range(0)), 0.01, 1);
+    // the default thresholds in the configure file
+    auto condition = PointToSurfelCondition();
+    condition.WithPointToSurfelMax(0.1).WithPlanarityMin(0.6);
+    std::size_t corrCount = 0;
+    for (auto _ : state) {
+        auto corrs = Associator->Association(scan, scan, condition, false);
+        corrCount = corrs->Size();
+        benchmark::DoNotOptimize(corrs);
+    }
+    state.counters["Correspondences"] = static_cast<double>(corrCount);
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_PointToSurfelAssociation)
+    ->ArgName("points")
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+// remove the distortion of an entire image, arg 0: the interpolation of 'cv::remap'
+void BM_RemoveDistortion(benchmark::State &state) {
+    auto undistoMap = VisualUndistortionMap::Create(CreateBrownIntrinsics());
+    cv::Mat img(IMG_HEIGHT, IMG_WIDTH, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+    const auto interpolation = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        auto undistImg = undistoMap->RemoveDistortion(img, interpolation);
+        benchmark::DoNotOptimize(undistImg.data);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * IMG_WIDTH *
+                            IMG_HEIGHT);
+}
+
+BENCHMARK(BM_RemoveDistortion)
+    ->ArgName("interpolation")
+    ->Arg(cv::INTER_NEAREST)
+    ->Arg(cv::INTER_LINEAR)
+    ->Unit(benchmark::kMicrosecond);
+
+// grab a batch of events and create the time surface, arg 0: events per batch
+void BM_TimeSurface(benchmark::State &state) {
+    auto surface = ActiveEventSurface::Create(CreateBrownIntrinsics(), 0.01);
+    std::default_random_engine engine(0);
+    std::uniform_int_distribution<int> xDist(0, IMG_WIDTH - 1), yDist(0, IMG_HEIGHT - 1);
+    std::bernoulli_distribution pDist(0.5);
+
+    const auto eventCount = static_cast<int>(state.range(0));
+    double time = 0.0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<std::tuple<double, std::uint16_t, std::uint16_t, bool>> events(eventCount);
+        for (auto &[et, ex, ey, ep] : events) {
+            et = (time += 1E-6);
+            ex = static_cast<std::uint16_t>(xDist(engine));
+            ey = static_cast<std::uint16_t>(yDist(engine));
+            ep = pDist(engine);
+        }
+        state.ResumeTiming();
+
+        for (const auto &[et, ex, ey, ep] : events) {
+            surface->GrabEvent(et, ex, ey, ep);
+        }
+        auto ts = surface->TimeSurface(false, false, 0, 0.02);
+        benchmark::DoNotOptimize(ts.data);
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * eventCount);
+}
+
+BENCHMARK(BM_TimeSurface)
+    ->ArgName("events")
+    ->Arg(1000)
+    ->Arg(50000)
+    ->Unit(benchmark::kMicrosecond);
+
+// the loader exposing the (protected) conversion of 'sensor_msgs::PointCloud2'
+class BenchLiDARLoader : public OusterLiDAR {
+public:
+    explicit BenchLiDARLoader()
+        : OusterLiDAR(LidarModelType::OUSTER_POINTS) {}
+
+    using LiDARDataLoader::UnpackPointCloud2;
+};
+
+// an ouster-like scan message, rows are rings and columns are azimuths
+sensor_msgs::PointCloud2 CreateOusterMsg(int rings, int columns) {
+    OusterPointCloud cloud;
+    cloud.width = columns;
+    cloud.height = rings;
+    cloud.is_dense = false;
+    cloud.resize(static_cast<std::size_t>(rings) * columns);
+    for (int r = 0; r < rings; ++r) {
+        const double elevation = (r - rings * 0.5) * 0.6 * M_PI / 180.0;
+        for (int c = 0; c < columns; ++c) {
+            const double azimuth = c * 2.0 * M_PI / columns;
+            const double range = 5.0 + 3.0 * std::abs(std::sin(azimuth * 3.0));
+            auto &p = cloud.at(c, r);
+            p.x = static_cast<float>(range * std::cos(elevation) * std::cos(azimuth));
+            p.y = static_cast<float>(range * std::cos(elevation) * std::sin(azimuth));
+            p.z = static_cast<float>(range * std::sin(elevation));
+            p.intensity = 100.0f;
+            p.ring = static_cast<std::uint8_t>(r);
+            // relative time in nanoseconds
+            p.t = static_cast<std::uint32_t>(c * 1E8 / columns);
+            p.range = static_cast<float>(range);
+        }
+    }
+    sensor_msgs::PointCloud2 msg;
+    pcl::toROSMsg(cloud, msg);
+    msg.header.stamp = ros::Time(1000.0);
+    return msg;
+}
+
+// arg 0: the unpacking path, 0 for the layout-based one, and 1 for the pcl-based one
+void BM_UnpackOusterScan(benchmark::State &state) {
+    static const auto Msg = CreateOusterMsg(64, 1024);
+    BenchLiDARLoader loader;
+    const double timebase = Msg.header.stamp.toSec();
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            auto cloud = loader.UnpackPointCloud2(Msg, "t", timebase, 1E-9, 1.0, 60.0);
+            benchmark::DoNotOptimize(cloud);
+        } else {
+            // the pcl-based fallback, i.e., the conversion the layout-based path avoids
+            OusterPointCloud cloud;
+            pcl::fromROSMsg(Msg, cloud);
+            benchmark::DoNotOptimize(cloud.points.data());
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) * Msg.width *
+                            Msg.height);
+}
+
+BENCHMARK(BM_UnpackOusterScan)->ArgName("pcl")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+}  // namespace ns_ikalibr
+
+int main(int argc, char **argv) {
+    ns_ikalibr::ConfigSpdlog();
+    // keep the output of benchmarks clean
+    spdlog::set_level(spdlog::level::warn);
+
+    // paddings used by factors with estimated time offsets (and readout times)
+    ns_ikalibr::Configor::Prior::TimeOffsetPadding = 0.01;
+    ns_ikalibr::Configor::Prior::ReadoutTimePadding = 0.01;
+    // the benchmarked imu is not the reference one, so that its time offset could be padded
+    ns_ikalibr::Configor::DataStream::ReferIMU = "/bench/refer_imu";
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
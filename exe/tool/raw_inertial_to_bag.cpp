@@ -42,11 +42,117 @@
 #include "sensor_msgs/Imu.h"
 #include "filesystem"
 #include "spdlog/fmt/bundled/color.h"
+#include "charconv"
+#include "array"
+#include "cstdlib"
+#include "omp.h"
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
+namespace {
+// the time stamp, three-axis acceleration and angular velocity
+constexpr int FieldCount = 7;
+
+// a read-only memory mapping of a file
+class MappedFile {
+private:
+    const char *_data = nullptr;
+    std::size_t _size = 0;
+
+public:
+    explicit MappedFile(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR, "open file '{}' failed!!!",
+                                     filename);
+        }
+        struct stat st {};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            _size = static_cast<std::size_t>(st.st_size);
+            void *addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                close(fd);
+                throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR, "map file '{}' failed!!!",
+                                         filename);
+            }
+            _data = static_cast<const char *>(addr);
+            // the file is parsed sequentially in each chunk
+            madvise(addr, _size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (_data != nullptr) {
+            munmap(const_cast<char *>(_data), _size);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] const char *Data() const { return _data; }
+
+    [[nodiscard]] std::size_t Size() const { return _size; }
+};
+
+// parse a number (surrounding blanks are ignored) in [first, last), false if it is not a number
+bool ParseNumber(const char *first, const char *last, double &value) {
+    while (first < last && (*first == ' ' || *first == '\t')) {
+        ++first;
+    }
+    while (last > first && (*(last - 1) == ' ' || *(last - 1) == '\t')) {
+        --last;
+    }
+    if (first < last && *first == '+') {
+        ++first;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const auto [ptr, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() && ptr == last;
+#else
+    // floating-point 'from_chars' is not supported by this standard library
+    char buffer[64];
+    const auto len = static_cast<std::size_t>(last - first);
+    if (len == 0 || len >= sizeof(buffer)) {
+        return false;
+    }
+    std::copy(first, last, buffer);
+    buffer[len] = '\0';
+    char *end = nullptr;
+    value = std::strtod(buffer, &end);
+    return end == buffer + len;
+#endif
+}
+
+/**
+ * split a line into numbers by the splitor (empty fields are skipped), false if the field count is
+ * not the expected one or a field is not a number
+ */
+bool ParseLine(const char *first, const char *last, char splitor, std::vector<double> &values) {
+    values.clear();
+    while (first < last) {
+        const char *end = std::find(first, last, splitor);
+        if (end != first) {
+            double value;
+            if (!ParseNumber(first, end, value)) {
+                return false;
+            }
+            values.push_back(value);
+        }
+        first = end == last ? last : end + 1;
+    }
+    return true;
+}
+}  // namespace
+
 int main(int argc, char **argv) {
     ros::init(argc, argv, "ikalibr_raw_inertial_to_bag");
     try {
@@ -146,33 +252,80 @@ int main(int argc, char **argv) {
         auto dstBag = std::make_unique<rosbag::Bag>();
         dstBag->open(bagPath, rosbag::BagMode::Write);
 
-        std::ifstream file(rawInertialPath, std::ios::in);
-        std::string line;
-        for (int i = 0; i < headLineCount; ++i) {
-            std::getline(file, line);
+        MappedFile file(rawInertialPath);
+        const char *begin = file.Data(), *end = file.Data() + file.Size();
+        for (int i = 0; i < headLineCount && begin < end; ++i) {
+            begin = std::find(begin, end, '\n');
+            begin = begin == end ? end : begin + 1;
         }
-        while (std::getline(file, line)) {
-            auto elems = ns_ikalibr::SplitString(line, splitor, true);
-            if (elems.size() != 7) {
+
+        /**
+         * the body is parsed in chunks in parallel, chunk boundaries are moved to the line
+         * boundaries, and parsed samples are written in the order of chunks, i.e., the file order
+         */
+        const int chunkCount = std::max(
+            1, std::min(omp_get_max_threads() * 4, static_cast<int>((end - begin) >> 16)));
+        std::vector<const char *> bounds(chunkCount + 1, end);
+        bounds.front() = begin;
+        for (int i = 1; i < chunkCount; ++i) {
+            const char *pos = begin + (end - begin) * i / chunkCount;
+            pos = std::max(pos, bounds.at(i - 1));
+            pos = std::find(pos, end, '\n');
+            bounds.at(i) = pos == end ? end : pos + 1;
+        }
+
+        std::vector<std::vector<std::array<double, FieldCount>>> samples(chunkCount);
+        std::vector<std::vector<std::string>> wrongLines(chunkCount);
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic) default(none) \
+    shared(chunkCount, bounds, samples, wrongLines, splitor)
+        for (int i = 0; i < chunkCount; ++i) {
+            std::vector<double> values;
+            for (const char *first = bounds.at(i), *last; first < bounds.at(i + 1);
+                 first = last + 1) {
+                last = std::find(first, bounds.at(i + 1), '\n');
+                const char *lineEnd = last;
+                if (lineEnd > first && *(lineEnd - 1) == '\r') {
+                    --lineEnd;
+                }
+                if (lineEnd == first) {
+                    // empty line
+                    continue;
+                }
+                if (ParseLine(first, lineEnd, splitor, values) && values.size() == FieldCount) {
+                    auto &sample = samples.at(i).emplace_back();
+                    std::copy(values.cbegin(), values.cend(), sample.begin());
+                } else {
+                    wrongLines.at(i).emplace_back(first, lineEnd);
+                }
+                if (last == bounds.at(i + 1)) {
+                    break;
+                }
+            }
+        }
+
+        std::size_t sampleCount = 0;
+        for (int i = 0; i < chunkCount; ++i) {
+            for (const auto &line : wrongLines.at(i)) {
                 spdlog::warn("wrong decoded line: {}", line);
-                continue;
             }
-            sensor_msgs::Imu imu;
-            imu.header.stamp = ros::Time(std::stod(elems.at(index.at(TIME))) * stampToSedScale);
-            imu.linear_acceleration.x = std::stod(elems.at(index.at(AX))) * acceScale;
-            imu.linear_acceleration.y = std::stod(elems.at(index.at(AY))) * acceScale;
-            imu.linear_acceleration.z = std::stod(elems.at(index.at(AZ))) * acceScale;
-            imu.angular_velocity.x = std::stod(elems.at(index.at(GX))) * gyroScale;
-            imu.angular_velocity.y = std::stod(elems.at(index.at(GY))) * gyroScale;
-            imu.angular_velocity.z = std::stod(elems.at(index.at(GZ))) * gyroScale;
-            // std::cout << imu.header.stamp << std::endl;
-            // std::cout << imu.linear_acceleration << std::endl;
-            // std::cout << imu.angular_velocity << std::endl;
-            dstBag->write(imuTopic, imu.header.stamp, imu);
-            // std::cin.get();
-        }
-        file.close();
+            for (const auto &sample : samples.at(i)) {
+                sensor_msgs::Imu imu;
+                imu.header.stamp = ros::Time(sample.at(index.at(TIME)) * stampToSedScale);
+                imu.linear_acceleration.x = sample.at(index.at(AX)) * acceScale;
+                imu.linear_acceleration.y = sample.at(index.at(AY)) * acceScale;
+                imu.linear_acceleration.z = sample.at(index.at(AZ)) * acceScale;
+                imu.angular_velocity.x = sample.at(index.at(GX)) * gyroScale;
+                imu.angular_velocity.y = sample.at(index.at(GY)) * gyroScale;
+                imu.angular_velocity.z = sample.at(index.at(GZ)) * gyroScale;
+                dstBag->write(imuTopic, imu.header.stamp, imu);
+            }
+            sampleCount += samples.at(i).size();
+            // release parsed samples once they are written
+            samples.at(i) = {};
+        }
         dstBag->close();
+        spdlog::info("'{}' inertial measurement(s) are parsed in '{}' chunk(s)", sampleCount,
+                     chunkCount);
         spdlog::info("raw inertial in '{}' have been writen to rosbag as '{}'!", rawInertialPath,
                      bagPath);
 
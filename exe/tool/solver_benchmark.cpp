@@ -0,0 +1,219 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ros/ros.h"
+#include "spdlog/spdlog.h"
+#include "config/configor.h"
+#include "util/status.hpp"
+#include "util/utils_tpl.hpp"
+#include "spdlog/fmt/bundled/color.h"
+#include "calib/batch_opt_problem.h"
+#include "filesystem"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+// the average time (in seconds) of evaluating residual blocks of the given group
+std::pair<double, double> GroupEvaluationTime(const ns_ikalibr::Estimator::Ptr &estimator,
+                                              const std::vector<ceres::ResidualBlockId> &group,
+                                              int threads,
+                                              int repeats) {
+    ceres::Problem::EvaluateOptions options;
+    options.residual_blocks = group;
+    options.num_threads = threads;
+    double cost;
+    std::vector<double> residuals;
+    ceres::CRSMatrix jacobian;
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        estimator->Evaluate(options, &cost, &residuals, nullptr, nullptr);
+    }
+    std::chrono::duration<double> residualTime = Clock::now() - start;
+
+    start = Clock::now();
+    for (int i = 0; i < repeats; ++i) {
+        estimator->Evaluate(options, &cost, &residuals, nullptr, &jacobian);
+    }
+    std::chrono::duration<double> jacobianTime = Clock::now() - start;
+
+    return {residualTime.count() / repeats, jacobianTime.count() / repeats};
+}
+
+void BenchmarkProblem(const std::string &filename,
+                      int threads,
+                      ceres::LinearSolverType solverType,
+                      int repeats) {
+    // the problem is reloaded for each run, as the solving changes the states
+    auto problem = ns_ikalibr::BatchOptProblem::Load(
+        filename, ns_ikalibr::Configor::Preference::OutputDataFormat);
+    auto estimator = problem->BuildEstimator();
+
+    spdlog::info(
+        "problem: '{}', threads: '{}', linear solver: '{}', residual blocks: '{}', parameter "
+        "blocks: '{}'",
+        filename, threads, ceres::LinearSolverTypeToString(solverType),
+        estimator->NumResidualBlocks(), estimator->NumParameterBlocks());
+
+    // evaluation time of each factor type
+    for (const auto &group : ns_ikalibr::BatchOptProblem::FACTOR_GROUPS) {
+        const auto resBlocks = estimator->GetResidualGroup(group);
+        if (resBlocks.empty()) {
+            continue;
+        }
+        auto [residualTime, jacobianTime] =
+            GroupEvaluationTime(estimator, resBlocks, threads, repeats);
+        spdlog::info(
+            "factor type: '{}', residual blocks: '{}', residual evaluation: '{:.6f}' (s), "
+            "residual and jacobian evaluation: '{:.6f}' (s)",
+            group, resBlocks.size(), residualTime, jacobianTime);
+    }
+
+    auto options = ns_ikalibr::Estimator::DefaultSolverOptions(threads, false, false);
+    options.linear_solver_type = solverType;
+    if (solverType == ceres::ITERATIVE_SCHUR) {
+        options.preconditioner_type = ceres::SCHUR_JACOBI;
+    }
+    auto sum = estimator->Solve(options);
+
+    const auto iterations = std::max<std::size_t>(sum.iterations.size(), 1);
+    spdlog::info(
+        "linear solver used: '{}', iterations: '{}', total time: '{:.6f}' (s), time per iteration: "
+        "'{:.6f}' (s), residual evaluation time: '{:.6f}' (s), jacobian evaluation time: '{:.6f}' "
+        "(s), linear solver time: '{:.6f}' (s), initial cost: '{:.6f}', final cost: '{:.6f}'",
+        ceres::LinearSolverTypeToString(sum.linear_solver_type_used), sum.iterations.size(),
+        sum.total_time_in_seconds, sum.minimizer_time_in_seconds / iterations,
+        sum.residual_evaluation_time_in_seconds, sum.jacobian_evaluation_time_in_seconds,
+        sum.linear_solver_time_in_seconds, sum.initial_cost, sum.final_cost);
+}
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "ikalibr_solver_benchmark");
+    try {
+        ns_ikalibr::ConfigSpdlog();
+
+        ns_ikalibr::PrintIKalibrLibInfo();
+
+        // load settings
+        auto configPath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_solver_benchmark/config_path");
+        spdlog::info("loading configure from yaml file '{}'...", configPath);
+        if (!std::filesystem::exists(configPath)) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "configure file dose not exist: '{}'", configPath);
+        }
+        if (!ns_ikalibr::Configor::LoadConfigure(configPath)) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "load configure file from '{}' failed!", configPath);
+        }
+
+        // a problem file, or a directory of problem files
+        auto problemPath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_solver_benchmark/problem_path");
+        std::vector<std::string> problemFiles;
+        if (std::filesystem::is_directory(problemPath)) {
+            for (const auto &entry : std::filesystem::directory_iterator(problemPath)) {
+                if (entry.is_regular_file()) {
+                    problemFiles.push_back(entry.path().string());
+                }
+            }
+            std::sort(problemFiles.begin(), problemFiles.end());
+        } else if (std::filesystem::exists(problemPath)) {
+            problemFiles.push_back(problemPath);
+        } else {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "problem path dose not exist: '{}'", problemPath);
+        }
+
+        // such as '1,4,8'
+        std::vector<int> threadsVec;
+        for (const auto &str : ns_ikalibr::SplitString(
+                 ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_solver_benchmark/threads"),
+                 ',')) {
+            threadsVec.push_back(std::stoi(str));
+        }
+        // such as 'DENSE_SCHUR,SPARSE_SCHUR,ITERATIVE_SCHUR'
+        std::vector<ceres::LinearSolverType> solverTypes;
+        for (const auto &str : ns_ikalibr::SplitString(
+                 ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_solver_benchmark/solvers"),
+                 ',')) {
+            ceres::LinearSolverType type;
+            if (!ceres::StringToLinearSolverType(str, &type)) {
+                throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                         "unknown linear solver type: '{}'", str);
+            }
+            solverTypes.push_back(type);
+        }
+        // repeats for factor evaluation timing
+        int repeats = std::max(
+            1, ns_ikalibr::GetParamFromROS<int>("/ikalibr_solver_benchmark/evaluation_repeats"));
+
+        for (const auto &filename : problemFiles) {
+            for (int threads : threadsVec) {
+                for (const auto &type : solverTypes) {
+                    BenchmarkProblem(filename, threads, type, repeats);
+                }
+            }
+        }
+
+    } catch (const ns_ikalibr::IKalibrStatus &status) {
+        // if error happened, print it
+        static const auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        static const auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        switch (status.flag) {
+            case ns_ikalibr::Status::FINE:
+                // this case usually won't happen
+                spdlog::info(fmt::format(FStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::WARNING:
+                spdlog::warn(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::ERROR:
+                spdlog::error(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::CRITICAL:
+                spdlog::critical(fmt::format(WECStyle, "{}", status.what));
+                break;
+        }
+    } catch (const std::exception &e) {
+        // an unknown exception not thrown by this program
+        static const auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        spdlog::critical(fmt::format(WECStyle, "unknown error happened: '{}'", e.what()));
+    }
+
+    ros::shutdown();
+    return 0;
+}
@@ -0,0 +1,217 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/stage_profiler.h"
+#include "spdlog/fmt/bundled/color.h"
+#include "spdlog/spdlog.h"
+#include "util/status.hpp"
+#include "util/utils_tpl.hpp"
+#include "map"
+#include "cmath"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+struct TelemetryThresholds {
+    // relative increase of the wall time, and the minimum absolute increase (seconds) to flag
+    double timeRatio, timeMin;
+    // relative increase of the peak resident memory
+    double rssRatio;
+    // relative change (either direction) of the factor counts
+    double factorRatio;
+};
+
+// returns the number of regressions, all comparisons are logged
+int CompareTelemetryReports(const StageProfiler::Report &baseline,
+                            const StageProfiler::Report &candidate,
+                            const TelemetryThresholds &thd) {
+    static const auto RStyle = fmt::emphasis::bold | fmt::fg(fmt::color::red);
+    int regressions = 0;
+
+    if (baseline.hardwareThreads != candidate.hardwareThreads) {
+        spdlog::warn("reports are generated on different hardware ({} vs. {} threads)!",
+                     baseline.hardwareThreads, candidate.hardwareThreads);
+    }
+
+    // stages
+    std::map<std::string, const StageProfiler::Record *> candStages;
+    for (const auto &record : candidate.stages) {
+        candStages.insert({record.stage, &record});
+    }
+    spdlog::info("{:<60} {:>10} {:>10} {:>8} {:>10} {:>10} {:>8}", "stage", "base(s)", "cand(s)",
+                 "diff", "base(MB)", "cand(MB)", "diff");
+    for (const auto &base : baseline.stages) {
+        auto iter = candStages.find(base.stage);
+        if (iter == candStages.cend()) {
+            spdlog::warn("stage '{}' is absent in the candidate report!", base.stage);
+            continue;
+        }
+        const auto &cand = *iter->second;
+        candStages.erase(iter);
+
+        const bool timeReg = cand.wallTime > base.wallTime * (1.0 + thd.timeRatio) &&
+                             cand.wallTime - base.wallTime > thd.timeMin;
+        const bool rssReg = cand.peakRSS > base.peakRSS * (1.0 + thd.rssRatio);
+        const std::string name = std::string(base.depth * 2, ' ') + base.stage;
+        const auto line = fmt::format(
+            "{:<60} {:>10.3f} {:>10.3f} {:>+7.1f}% {:>10.1f} {:>10.1f} {:>+7.1f}%", name,
+            base.wallTime, cand.wallTime, 100.0 * (cand.wallTime / base.wallTime - 1.0),
+            base.peakRSS, cand.peakRSS, 100.0 * (cand.peakRSS / base.peakRSS - 1.0));
+        if (timeReg || rssReg) {
+            spdlog::info(fmt::format(RStyle, "{}", line));
+            regressions += timeReg + rssReg;
+        } else {
+            spdlog::info(line);
+        }
+    }
+    for (const auto &[stage, record] : candStages) {
+        spdlog::warn("stage '{}' is absent in the baseline report!", stage);
+    }
+
+    // factor counts
+    std::map<std::string, double> baseCounters, candCounters;
+    for (const auto &counter : baseline.counters) {
+        baseCounters.insert({counter.name, counter.value});
+    }
+    for (const auto &counter : candidate.counters) {
+        candCounters.insert({counter.name, counter.value});
+    }
+    if (baseCounters.empty() || candCounters.empty()) {
+        spdlog::warn("counters are absent in the reports, they would not be compared!");
+        return regressions;
+    }
+    spdlog::info("{:<60} {:>12} {:>12} {:>8}", "counter", "base", "cand", "diff");
+    for (const auto &[name, base] : baseCounters) {
+        auto iter = candCounters.find(name);
+        // zero for factors that are absent in the candidate
+        const double cand = iter == candCounters.cend() ? 0.0 : iter->second;
+        const double change = base == 0.0 ? 0.0 : cand / base - 1.0;
+        const auto line =
+            fmt::format("{:<60} {:>12.3f} {:>12.3f} {:>+7.1f}%", name, base, cand, 100.0 * change);
+        // solver times (e.g., '.../Solver/LinearSolverTime') are gated like stage wall times
+        const bool isTime = name.size() >= 4 && name.compare(name.size() - 4, 4, "Time") == 0;
+        const bool timeReg =
+            isTime && cand > base * (1.0 + thd.timeRatio) && cand - base > thd.timeMin;
+        const bool factorReg = name.rfind("Factors/", 0) == 0 && std::abs(change) > thd.factorRatio;
+        if (timeReg || factorReg) {
+            spdlog::info(fmt::format(RStyle, "{}", line));
+            ++regressions;
+        } else {
+            spdlog::info(line);
+        }
+    }
+    for (const auto &[name, cand] : candCounters) {
+        if (baseCounters.count(name) == 0 && name.rfind("Factors/", 0) == 0) {
+            spdlog::info(fmt::format(RStyle, "{:<60} {:>12} {:>12.0f}", name, "-", cand));
+            ++regressions;
+        }
+    }
+    return regressions;
+}
+}  // namespace ns_ikalibr
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "ikalibr_telemetry_compare");
+    // non-zero if regressions are detected, so that this tool could be used as a gate
+    int exitCode = 0;
+
+    try {
+        ns_ikalibr::ConfigSpdlog();
+
+        ns_ikalibr::PrintIKalibrLibInfo();
+
+        // load settings
+        auto baselinePath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_telemetry_compare/baseline_path");
+        auto candidatePath =
+            ns_ikalibr::GetParamFromROS<std::string>("/ikalibr_telemetry_compare/candidate_path");
+        ns_ikalibr::TelemetryThresholds thd{
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_telemetry_compare/time_ratio"),
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_telemetry_compare/time_min"),
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_telemetry_compare/rss_ratio"),
+            ns_ikalibr::GetParamFromROS<double>("/ikalibr_telemetry_compare/factor_ratio")};
+        spdlog::info(
+            "thresholds: wall time '+{:.1f}%' (at least '{:.3f}' s), peak rss '+{:.1f}%', factor "
+            "count '±{:.1f}%'",
+            thd.timeRatio * 100.0, thd.timeMin, thd.rssRatio * 100.0, thd.factorRatio * 100.0);
+
+        auto baseline = ns_ikalibr::StageProfiler::LoadReport(baselinePath);
+        auto candidate = ns_ikalibr::StageProfiler::LoadReport(candidatePath);
+        if (!baseline || !candidate) {
+            throw ns_ikalibr::Status(ns_ikalibr::Status::CRITICAL,
+                                     "load telemetry reports '{}' and '{}' failed!", baselinePath,
+                                     candidatePath);
+        }
+
+        int regressions = ns_ikalibr::CompareTelemetryReports(*baseline, *candidate, thd);
+        if (regressions != 0) {
+            exitCode = 1;
+            throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR,
+                                     "'{}' performance regression(s) are detected!", regressions);
+        } else {
+            spdlog::info("no performance regression is detected.");
+        }
+
+    } catch (const ns_ikalibr::IKalibrStatus &status) {
+        // if error happened, print it
+        static const auto FStyle = fmt::emphasis::italic | fmt::fg(fmt::color::green);
+        static const auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        switch (status.flag) {
+            case ns_ikalibr::Status::FINE:
+                // this case usually won't happen
+                spdlog::info(fmt::format(FStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::WARNING:
+                spdlog::warn(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::ERROR:
+                spdlog::error(fmt::format(WECStyle, "{}", status.what));
+                break;
+            case ns_ikalibr::Status::CRITICAL:
+                spdlog::critical(fmt::format(WECStyle, "{}", status.what));
+                exitCode = 1;
+                break;
+        }
+    } catch (const std::exception &e) {
+        // an unknown exception not thrown by this program
+        static const auto WECStyle = fmt::emphasis::italic | fmt::fg(fmt::color::red);
+        spdlog::critical(fmt::format(WECStyle, "unknown error happened: '{}'", e.what()));
+        exitCode = 1;
+    }
+
+    ros::shutdown();
+    return exitCode;
+}
@@ -0,0 +1,234 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_BATCH_OPT_PROBLEM_H
+#define IKALIBR_BATCH_OPT_PROBLEM_H
+
+#include "calib/estimator.h"
+#include "factor/data_correspondence.h"
+#include "sensor/imu.h"
+#include "sensor/radar.h"
+#include "util/cereal_archive_helper.hpp"
+#include "cereal/types/map.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief a snapshot of the problem of a batch optimization stage, i.e., the splines, calibration
+ * parameters, raw measurements (imus and radars), and data correspondences (lidars, cameras, and
+ * rgbds) at the beginning of the stage. It could be serialized, and replayed (rebuilding the
+ * estimator) without the ros bag, which is used for solver benchmarks. Note that event-based
+ * correspondences and spatiotemporal priori are not involved in the snapshot.
+ */
+class BatchOptProblem {
+public:
+    using Ptr = std::shared_ptr<BatchOptProblem>;
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+    template <class CorrType>
+    using CorrMap = std::map<std::string, std::vector<typename CorrType::Ptr>>;
+
+    // residual groups of factor types in the rebuilt estimator
+    static const std::string IMU_GYRO_GROUP, IMU_ACCE_GROUP, RADAR_GROUP;
+    static const std::string LIDAR_PTS_TO_SURFEL_GROUP, RGBD_PTS_TO_SURFEL_GROUP;
+    static const std::string VISUAL_REPROJ_GROUP;
+    static const std::string RGBD_OPTICAL_FLOW_GROUP, RGBD_OPTICAL_FLOW_REPROJ_GROUP;
+    static const std::string VISUAL_OPTICAL_FLOW_GROUP, VISUAL_OPTICAL_FLOW_REPROJ_GROUP;
+
+    static const std::vector<std::string> FACTOR_GROUPS;
+
+public:
+    OptOption optOption{};
+    TimeDeriv::ScaleSplineType scaleType{};
+    // the optimization options refined for each camera (rgbd), e.g., readout time of gs cameras
+    std::map<std::string, OptOption> cameraOptOptions;
+
+    SplineBundleType::Ptr splines;
+    CalibParamManager::Ptr parMagr;
+
+    std::map<std::string, std::vector<IMUFrame::Ptr>> imuMes;
+    std::map<std::string, std::vector<RadarTargetArray::Ptr>> radarMes;
+
+    std::map<std::string, PointToSurfelCorrBuffer::Ptr> lidarPtsCorrs;
+    std::map<std::string, PointToSurfelCorrBuffer::Ptr> rgbdPtsCorrs;
+    CorrMap<VisualReProjCorrSeq> visualReprojCorrs;
+    CorrMap<OpticalFlowCorr> rgbdCorrs;
+    CorrMap<OpticalFlowCorr> visualVelCorrs;
+
+protected:
+    // the global scale of visual reprojection factors, which is reset when rebuilding estimators
+    std::shared_ptr<double> _visualGlobalScale;
+
+public:
+    BatchOptProblem(OptOption optOption,
+                    TimeDeriv::ScaleSplineType scaleType,
+                    SplineBundleType::Ptr splines,
+                    CalibParamManager::Ptr parMagr);
+
+    BatchOptProblem();
+
+    static Ptr Create(OptOption optOption,
+                      TimeDeriv::ScaleSplineType scaleType,
+                      const SplineBundleType::Ptr &splines,
+                      const CalibParamManager::Ptr &parMagr);
+
+    void Save(const std::string &filename, CerealArchiveType::Enum archiveType) const;
+
+    static Ptr Load(const std::string &filename, CerealArchiveType::Enum archiveType);
+
+    /**
+     * rebuild the estimator of this problem just like the batch optimization does, residual blocks
+     * of each factor type are organized as a residual group (see 'FACTOR_GROUPS'). Weights of
+     * factors are obtained from the 'Configor', thus the configure should be loaded first
+     */
+    Estimator::Ptr BuildEstimator(
+        const ceres::Problem::Options &options = Estimator::DefaultProblemOptions());
+
+protected:
+    template <TimeDeriv::ScaleSplineType type>
+    void AddFactors(Estimator::Ptr &estimator) const;
+
+    [[nodiscard]] OptOption CameraOptOption(const std::string &topic) const;
+
+public:
+    template <class Archive>
+    void save(Archive &ar) const {
+        const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+        const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+        Eigen::aligned_vector<Eigen::Vector4d> so3Knots(so3Spline.GetKnots().size());
+        for (int i = 0; i < static_cast<int>(so3Knots.size()); ++i) {
+            so3Knots.at(i) = Eigen::Map<const Eigen::Vector4d>(so3Spline.GetKnot(i).data());
+        }
+        Eigen::aligned_vector<Eigen::Vector3d> scaleKnots(scaleSpline.GetKnots().size());
+        for (int i = 0; i < static_cast<int>(scaleKnots.size()); ++i) {
+            scaleKnots.at(i) = scaleSpline.GetKnot(i);
+        }
+        // imu frames are stored as [ timestamp | gyro | acce ]
+        std::map<std::string, std::vector<double>> imuFrames;
+        for (const auto &[topic, frames] : imuMes) {
+            auto &data = imuFrames[topic];
+            data.reserve(frames.size() * 7);
+            for (const auto &frame : frames) {
+                data.push_back(frame->GetTimestamp());
+                data.insert(data.end(), frame->GetGyro().data(), frame->GetGyro().data() + 3);
+                data.insert(data.end(), frame->GetAcce().data(), frame->GetAcce().data() + 3);
+            }
+        }
+        ar(cereal::make_nvp("OptOption", static_cast<std::uint64_t>(optOption)),
+           cereal::make_nvp("ScaleSplineType", static_cast<int>(scaleType)));
+        std::map<std::string, std::uint64_t> camOpts;
+        for (const auto &[topic, opt] : cameraOptOptions) {
+            camOpts.insert({topic, static_cast<std::uint64_t>(opt)});
+        }
+        ar(cereal::make_nvp("CameraOptOptions", camOpts));
+        const double st = std::max(so3Spline.MinTime(), scaleSpline.MinTime());
+        const double et = std::min(so3Spline.MaxTime(), scaleSpline.MaxTime());
+        ar(cereal::make_nvp("SplineStartTime", st), cereal::make_nvp("SplineEndTime", et),
+           cereal::make_nvp("SO3KnotTimeDist", Configor::Prior::KnotTimeDist::SO3Spline),
+           cereal::make_nvp("ScaleKnotTimeDist", Configor::Prior::KnotTimeDist::ScaleSpline),
+           cereal::make_nvp("SO3Knots", so3Knots), cereal::make_nvp("ScaleKnots", scaleKnots));
+        ar(cereal::make_nvp("CalibParam", *parMagr));
+        ar(cereal::make_nvp("IMUFrames", imuFrames), cereal::make_nvp("RadarMes", radarMes));
+        ar(CEREAL_NVP(lidarPtsCorrs), CEREAL_NVP(rgbdPtsCorrs), CEREAL_NVP(visualReprojCorrs),
+           CEREAL_NVP(rgbdCorrs), CEREAL_NVP(visualVelCorrs));
+    }
+
+    template <class Archive>
+    void load(Archive &ar) {
+        std::uint64_t opt;
+        int type;
+        ar(cereal::make_nvp("OptOption", opt), cereal::make_nvp("ScaleSplineType", type));
+        optOption = static_cast<OptOption>(opt);
+        scaleType = static_cast<TimeDeriv::ScaleSplineType>(type);
+        std::map<std::string, std::uint64_t> camOpts;
+        ar(cereal::make_nvp("CameraOptOptions", camOpts));
+        cameraOptOptions.clear();
+        for (const auto &[topic, camOpt] : camOpts) {
+            cameraOptOptions.insert({topic, static_cast<OptOption>(camOpt)});
+        }
+
+        double st, et, so3Dt, scaleDt;
+        Eigen::aligned_vector<Eigen::Vector4d> so3Knots;
+        Eigen::aligned_vector<Eigen::Vector3d> scaleKnots;
+        ar(cereal::make_nvp("SplineStartTime", st), cereal::make_nvp("SplineEndTime", et),
+           cereal::make_nvp("SO3KnotTimeDist", so3Dt),
+           cereal::make_nvp("ScaleKnotTimeDist", scaleDt), cereal::make_nvp("SO3Knots", so3Knots),
+           cereal::make_nvp("ScaleKnots", scaleKnots));
+        splines = SplineBundleType::Create(
+            {ns_ctraj::SplineInfo(Configor::Preference::SO3_SPLINE,
+                                  ns_ctraj::SplineType::So3Spline, st, et, so3Dt),
+             ns_ctraj::SplineInfo(Configor::Preference::SCALE_SPLINE,
+                                  ns_ctraj::SplineType::RdSpline, st, et, scaleDt)});
+        auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+        auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+        if (so3Spline.GetKnots().size() != so3Knots.size() ||
+            scaleSpline.GetKnots().size() != scaleKnots.size()) {
+            throw Status(Status::ERROR,
+                         "the knot layout of the serialized splines can not be recovered!!!");
+        }
+        for (int i = 0; i < static_cast<int>(so3Knots.size()); ++i) {
+            Eigen::Map<Eigen::Vector4d>(so3Spline.GetKnot(i).data()) = so3Knots.at(i);
+        }
+        for (int i = 0; i < static_cast<int>(scaleKnots.size()); ++i) {
+            scaleSpline.GetKnot(i) = scaleKnots.at(i);
+        }
+
+        parMagr = CalibParamManager::Create();
+        ar(cereal::make_nvp("CalibParam", *parMagr));
+
+        std::map<std::string, std::vector<double>> imuFrames;
+        ar(cereal::make_nvp("IMUFrames", imuFrames), cereal::make_nvp("RadarMes", radarMes));
+        imuMes.clear();
+        for (const auto &[topic, data] : imuFrames) {
+            auto &frames = imuMes[topic];
+            frames.reserve(data.size() / 7);
+            for (std::size_t i = 0; i + 7 <= data.size(); i += 7) {
+                Eigen::Vector3d gyro = Eigen::Map<const Eigen::Vector3d>(&data.at(i + 1));
+                Eigen::Vector3d acce = Eigen::Map<const Eigen::Vector3d>(&data.at(i + 4));
+                frames.push_back(IMUFrame::Create(data.at(i), gyro, acce));
+            }
+        }
+        ar(CEREAL_NVP(lidarPtsCorrs), CEREAL_NVP(rgbdPtsCorrs), CEREAL_NVP(visualReprojCorrs),
+           CEREAL_NVP(rgbdCorrs), CEREAL_NVP(visualVelCorrs));
+    }
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_BATCH_OPT_PROBLEM_H
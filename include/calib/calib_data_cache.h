@@ -0,0 +1,113 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_CALIB_DATA_CACHE_H
+#define IKALIBR_CALIB_DATA_CACHE_H
+
+#include "sensor/camera.h"
+#include "sensor/imu.h"
+#include "sensor/lidar.h"
+#include "sensor/radar.h"
+#include "sensor/rgbd.h"
+#include "sensor/event.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief a binary cache of the unpacked (pre-decoded) calibration data. Decoding the ros bag is
+ * time-consuming, especially for large bags, the unpacked measurements are stored to the disk in
+ * a plain binary layout (loaded back by memory mapping), so that repeated runs on the same bag can
+ * skip the rosbag parsing. The cache is keyed by the bag files (canonical path, size, modification
+ * time), the involved topics and their types, and the queried time piece ('BeginTime' and
+ * 'Duration'). Once any of them changes, the cache would be invalid and rebuilt.
+ */
+class CalibDataCache {
+public:
+    using Ptr = std::shared_ptr<CalibDataCache>;
+
+    template <class MesType>
+    using MesMap = std::map<std::string, std::vector<typename MesType::Ptr>>;
+
+    // increase this version once the layout of the cache file changes
+    constexpr static std::uint32_t VERSION = 4;
+    // whether store images in compressed (lossless 'png') format, raw images are quite large
+    constexpr static bool COMPRESS_IMAGES = true;
+
+private:
+    // the cache file
+    std::string _filename;
+    // the key string of the configuration this cache is bound to
+    std::string _key;
+
+public:
+    CalibDataCache(std::string filename, std::string key);
+
+    static Ptr Create(const std::string &filename, const std::string &key);
+
+    // create the cache bound to the current configuration in 'Configor'
+    static Ptr CreateFromConfigor();
+
+    [[nodiscard]] const std::string &GetFilename() const;
+
+    [[nodiscard]] const std::string &GetKey() const;
+
+    // whether the cache file exists and is bound to the same key
+    [[nodiscard]] bool IsValid() const;
+
+    bool Save(const MesMap<IMUFrame> &imuMes,
+              const MesMap<RadarTargetArray> &radarMes,
+              const MesMap<LiDARFrame> &lidarMes,
+              const MesMap<CameraFrame> &camMes,
+              const MesMap<EventArray> &eventMes,
+              const MesMap<RGBDFrame> &rgbdMes) const;
+
+    // if the cache is invalid or broken, false would be returned and containers would be untouched
+    bool Load(MesMap<IMUFrame> &imuMes,
+              MesMap<RadarTargetArray> &radarMes,
+              MesMap<LiDARFrame> &lidarMes,
+              MesMap<CameraFrame> &camMes,
+              MesMap<EventArray> &eventMes,
+              MesMap<RGBDFrame> &rgbdMes) const;
+
+protected:
+    static std::string GenerateKeyFromConfigor();
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_CALIB_DATA_CACHE_H
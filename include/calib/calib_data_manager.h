@@ -35,6 +35,7 @@
 #ifndef IKALIBR_CALIB_DATA_MANAGER_H
 #define IKALIBR_CALIB_DATA_MANAGER_H
 
+#include "config/calib_context.h"
 #include "config/configor.h"
 #include "sensor/camera.h"
 #include "sensor/imu.h"
@@ -45,6 +46,8 @@
 #include "util/status.hpp"
 #include "veta/veta.h"
 #include "rosbag/bag.h"
+#include "deque"
+#include "mutex"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -56,11 +59,84 @@ struct OpticalFlowTripleTrace;
 using OpticalFlowTripleTracePtr = std::shared_ptr<OpticalFlowTripleTrace>;
 struct FeatureTrackingCurve;
 using FeatureTrackingCurvePtr = std::shared_ptr<FeatureTrackingCurve>;
+class IMUDataLoader;
+class RadarDataLoader;
+class LiDARDataLoader;
+class CameraDataLoader;
+class DepthDataLoader;
+class EventDataLoader;
 
 class CalibDataManager {
 public:
     using Ptr = std::shared_ptr<CalibDataManager>;
 
+protected:
+    // data loaders of sensors, organized by ros topics
+    struct DataLoaderPack {
+        std::map<std::string, std::shared_ptr<IMUDataLoader>> imuDataLoaders;
+        std::map<std::string, std::shared_ptr<RadarDataLoader>> radarDataLoaders;
+        std::map<std::string, std::shared_ptr<LiDARDataLoader>> lidarDataLoaders;
+        std::map<std::string, std::shared_ptr<CameraDataLoader>> cameraDataLoaders;
+        std::map<std::string, std::shared_ptr<EventDataLoader>> eventDataLoaders;
+        // for rgbd cameras
+        std::map<std::string, std::shared_ptr<CameraDataLoader>> rgbdColorDataLoaders;
+        std::map<std::string, std::shared_ptr<DepthDataLoader>> rgbdDepthDataLoaders;
+        // depth topic --> color topic
+        std::map<std::string, std::string> rgbdDepthToColorTopic;
+    };
+
+    // pairs color and depth images of a rgbd camera as they arrive, matched pairs are emitted as
+    // rgbd frames directly, pending frames are kept in bounded buffers
+    struct RGBDFramePairing {
+        // the maximum number of pending color (depth) frames waiting for their counterparts
+        static constexpr std::size_t PendingCapacity = 32;
+        // the matched depth and color images should be close enough to each other in time
+        static constexpr double MatchTimeDistance = 1E-3;
+
+        std::deque<CameraFrame::Ptr> colorPending;
+        std::deque<DepthFrame::Ptr> depthPending;
+        // frames squeezed out of the pending buffers (or left when the stream ends)
+        std::vector<CameraFrame::Ptr> colorStray;
+        std::vector<DepthFrame::Ptr> depthStray;
+        // the emitted rgbd frames
+        std::vector<RGBDFrame::Ptr> rgbdMes;
+
+        void PushColor(const CameraFrame::Ptr &colorFrame);
+
+        void PushDepth(const DepthFrame::Ptr &depthFrame);
+
+        // move all pending frames to the stray containers
+        void Finish();
+
+        // the color image passed to rgbd frames, which is empty for grey-only color frames
+        static cv::Mat ColorImageOf(const CameraFrame::Ptr &colorFrame);
+    };
+
+    // measurements unpacked from a continuous piece of the ros bag
+    struct UnpackedMesPiece {
+        // inertial samples are appended to stores directly, see 'IMUSampleStore'
+        std::map<std::string, IMUSampleStore> imuMes;
+        std::map<std::string, std::vector<RadarTargetArray::Ptr>> radarMes;
+        std::map<std::string, std::vector<LiDARFrame::Ptr>> lidarMes;
+        std::map<std::string, std::vector<CameraFrame::Ptr>> camMes;
+        std::map<std::string, std::vector<EventArray::Ptr>> eventMes;
+        // for rgbd cameras, organized by color topics
+        std::map<std::string, RGBDFramePairing> rgbdPairing;
+        // the total byte sizes of unpacked messages of each topic
+        std::map<std::string, std::size_t> byteSizes;
+    };
+
+    // the index of a topic in the queried bag view
+    struct TopicIndex {
+        std::uint32_t mesCount = 0;
+        ros::Time begTime, endTime;
+        // this is accumulated when unpacking messages, as reading it requires loading records
+        std::size_t byteSize = 0;
+    };
+
+    // a piece would not be unpacked on a single thread if its messages are too few
+    constexpr static int MinMesCountInPiece = 100;
+
 private:
     std::map<std::string, std::vector<IMUFrame::Ptr>> _imuMes;
     std::map<std::string, std::vector<RadarTargetArray::Ptr>> _radarMes;
@@ -73,6 +149,8 @@ private:
 
     std::map<std::string, std::vector<OpticalFlowTripleTracePtr>> _visualOpticalFlowTrace;
     std::map<std::string, std::vector<FeatureTrackingCurvePtr>> _visualFeatTrackingCurve;
+    // guards the lookup and insertion of data derived in (concurrent) initialization preparations
+    mutable std::mutex _derivedDataMutex;
 
     double _rawStartTimestamp{};
     double _rawEndTimestamp{};
@@ -80,12 +158,17 @@ private:
     double _alignedStartTimestamp{};
     double _alignedEndTimestamp{};
 
+    // the context (configuration) of this calibration, which is active when loading data
+    CalibContextPtr _context;
+
 public:
-    // using config information to load and adjust data in this constructor
-    CalibDataManager();
+    // the context currently in 'Configor' is captured if it is not given
+    explicit CalibDataManager(CalibContextPtr context = nullptr);
 
     // the creator
-    static CalibDataManager::Ptr Create();
+    static CalibDataManager::Ptr Create(const CalibContextPtr &context = nullptr);
+
+    [[nodiscard]] const CalibContextPtr &GetContext() const;
 
     // get raw imu measurements
     [[nodiscard]] const std::map<std::string, std::vector<IMUFrame::Ptr>> &GetIMUMeasurements()
@@ -129,6 +212,9 @@ public:
     [[nodiscard]] const std::vector<EventArray::Ptr> &GetEventMeasurements(
         const std::string &eventTopic) const;
 
+    // release raw event measurements once they are not needed anymore, to bound the memory usage
+    void ReleaseEventMeasurements();
+
     // get raw SfM data
     [[nodiscard]] const std::map<std::string, ns_veta::Veta::Ptr> &GetSfMData() const;
 
@@ -136,8 +222,8 @@ public:
 
     void SetSfMData(const std::string &camTopic, const ns_veta::Veta::Ptr &veta);
 
-    // [[nodiscard]] const std::map<std::string, std::vector<OpticalFlowTripleTracePtr>> &
-    // GetVisualOpticalFlowTrace() const;
+    [[nodiscard]] const std::map<std::string, std::vector<OpticalFlowTripleTracePtr>> &
+    GetVisualOpticalFlowTrace() const;
 
     [[nodiscard]] const std::vector<OpticalFlowTripleTracePtr> &GetVisualOpticalFlowTrace(
         const std::string &visualTopic) const;
@@ -145,6 +231,9 @@ public:
     void SetVisualOpticalFlowTrace(const std::string &visualTopic,
                                    const std::vector<OpticalFlowTripleTracePtr> &dynamics);
 
+    [[nodiscard]] const std::map<std::string, std::vector<FeatureTrackingCurvePtr>> &
+    GetVisualFeatureTrackingCurve() const;
+
     [[nodiscard]] const std::vector<FeatureTrackingCurvePtr> &GetVisualFeatureTrackingCurve(
         const std::string &visualTopic) const;
 
@@ -201,15 +290,16 @@ public:
         return ExtractIMUDataPiece(_imuMes.at(topic), st, et);
     }
 
+    // event arrays are time-ordered, thus they are located by binary searches
     static auto ExtractEventDataPiece(const std::vector<EventArray::Ptr> &data,
                                       double st,
                                       double et) {
-        auto sIter = std::find_if(data.begin(), data.end(), [st](const EventArray::Ptr &frame) {
-            return frame->GetTimestamp() > st;
+        auto sIter = std::partition_point(data.begin(), data.end(), [st](const auto &frame) {
+            return frame->GetTimestamp() <= st;
+        });
+        auto eIter = std::partition_point(sIter, data.end(), [et](const auto &frame) {
+            return frame->GetTimestamp() < et;
         });
-        auto eIter = std::find_if(data.rbegin(), data.rend(), [et](const EventArray::Ptr &frame) {
-                         return frame->GetTimestamp() < et;
-                     }).base();
         return std::pair(sIter, eIter);
     }
 
@@ -217,10 +307,20 @@ public:
         return ExtractEventDataPiece(_eventMes.at(topic), st, et);
     }
 
+    // a zero-copy view of events in the time range [st, et) at the event granularity
+    [[nodiscard]] EventArraySpan ExtractEventDataSpan(const std::string &topic,
+                                                      double st,
+                                                      double et) const {
+        return EventArraySpan::Extract(_eventMes.at(topic), st, et);
+    }
+
     // load camera, lidar, imu data from the ros bag [according to the config file]
     void LoadCalibData();
 
 protected:
+    // load and unpack the calibration data from the ros bag
+    void LoadCalibDataFromBag();
+
     // make sure the first imu frame is before camera and lidar data
     // assign the '_alignedStartTimestamp' and '_alignedEndTimestamp'
     void AdjustCalibDataSequence();
@@ -228,32 +328,50 @@ protected:
     // align the timestamp to zero
     void AlignTimestamp();
 
-    // remove the head data according to the pred
-    template <typename ElemType, typename Pred>
-    void EraseSeqHeadData(std::vector<ElemType> &seq, Pred pred, const std::string &errorMsg) {
-        auto iter = std::find_if(seq.begin(), seq.end(), pred);
-        if (iter == seq.end()) {
-            // find failed
-            OutputDataStatus();
-            throw Status(Status::ERROR, errorMsg);
-        } else {
-            // adjust
-            seq.erase(seq.begin(), iter);
-        }
+    /**
+     * thin the data of windows whose excitation (of the reference imu) is lower than the
+     * 'Preference::TargetInfoPerSecond', the aligned time range of the data is kept
+     */
+    void WindowByExcitation();
+
+    // pack imu frames of each topic contiguously in their final order, see 'IMUSampleStore'
+    void PackIMUMeasurements();
+
+    // whether the time falls in one of the 'segments' (ordered and disjoint)
+    static bool InSegments(const std::vector<std::pair<double, double>> &segments, double time);
+
+    // remove elements whose timestamps fall out of all 'segments'
+    template <typename ElemType>
+    static void KeepSegmentData(std::vector<ElemType> &seq,
+                                const std::vector<std::pair<double, double>> &segments) {
+        seq.erase(std::remove_if(seq.begin(), seq.end(),
+                                 [&segments](const ElemType &elem) {
+                                     return !InSegments(segments, elem->GetTimestamp());
+                                 }),
+                  seq.end());
     }
 
-    // remove the tail data according to the pred
-    template <typename ElemType, typename Pred>
-    void EraseSeqTailData(std::vector<ElemType> &seq, Pred pred, const std::string &errorMsg) {
-        auto iter = std::find_if(seq.rbegin(), seq.rend(), pred);
-        if (iter == seq.rend()) {
+    /**
+     * remove the head data (before the first one satisfying 'headPred') and the tail data (after
+     * the last one satisfying 'tailPred') in place. The tail is erased first, thus each kept
+     * element is moved at most once
+     */
+    template <typename ElemType, typename HeadPred, typename TailPred>
+    void TrimSeqData(std::vector<ElemType> &seq,
+                     HeadPred headPred,
+                     TailPred tailPred,
+                     const std::string &errorMsg) {
+        auto head = std::find_if(seq.begin(), seq.end(), headPred);
+        auto tail = std::find_if(seq.rbegin(), seq.rend(), tailPred).base();
+        if (head == seq.end() || tail == seq.begin() || tail <= head) {
             // find failed
             OutputDataStatus();
             throw Status(Status::ERROR, errorMsg);
-        } else {
-            // adjust
-            seq.erase(iter.base(), seq.end());
         }
+        // adjust
+        const auto headCount = std::distance(seq.begin(), head);
+        seq.erase(tail, seq.end());
+        seq.erase(seq.begin(), seq.begin() + headCount);
     }
 
     // output the data status
@@ -294,10 +412,37 @@ protected:
         }
     }
 
-    static std::uint32_t MessageNumInTopic(const rosbag::Bag *bag,
-                                           const std::string &topic,
-                                           const ros::Time &begTime,
-                                           const ros::Time &endTime);
+    static std::map<std::string, TopicIndex> BuildTopicIndex(rosbag::View &view);
+
+    /**
+     * decide which messages of the view are kept by the load-time decimation (see
+     * 'DataStream::TopicDecimation'), only the index (and the reference imu if rotations are
+     * required) is read. Flags are ordered as the view, an empty vector means all are kept
+     */
+    static std::vector<bool> DecimateMessages(rosbag::View &view, const DataLoaderPack &loaders);
+
+    static std::vector<std::unique_ptr<rosbag::Bag>> OpenBags(
+        const std::vector<std::string> &bagPaths);
+
+    // unpack a message using the data loader corresponding to its topic, thread-safe
+    static void UnpackMessage(const rosbag::MessageInstance &item,
+                              const DataLoaderPack &loaders,
+                              UnpackedMesPiece &piece);
+
+    // sort the measurements of each topic by their timestamps (stable)
+    template <typename MesType>
+    static void SortByTimestamp(std::map<std::string, std::vector<MesType>> &mesMap) {
+        for (auto &[topic, mes] : mesMap) {
+            auto cmp = [](const MesType &m1, const MesType &m2) {
+                return m1->GetTimestamp() < m2->GetTimestamp();
+            };
+            if (!std::is_sorted(mes.begin(), mes.end(), cmp)) {
+                spdlog::warn("measurements of topic '{}' are not ordered by timestamps, sort them!",
+                             topic);
+                std::stable_sort(mes.begin(), mes.end(), cmp);
+            }
+        }
+    }
 };
 
 }  // namespace ns_ikalibr
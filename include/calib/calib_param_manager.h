@@ -311,6 +311,11 @@ public:
 
     template <class Archive>
     void load(Archive &archive) {
+        if constexpr (std::is_same_v<Archive, cereal::BinaryInputArchive>) {
+            // fields of the binary archive are not named, the saved header has to be skipped
+            std::string software, version, address;
+            archive(software, version, address);
+        }
         archive(CEREAL_NVP(EXTRI), CEREAL_NVP(TEMPORAL), CEREAL_NVP(INTRI), CEREAL_NVP(GRAVITY));
     }
 
@@ -37,6 +37,10 @@
 
 #include "ceres/iteration_callback.h"
 #include "util/utils.h"
+#include "thread"
+#include "mutex"
+#include "condition_variable"
+#include "fstream"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -46,15 +50,38 @@ namespace ns_ikalibr {
 
 struct CalibParamManager;
 using CalibParamManagerPtr = std::shared_ptr<CalibParamManager>;
-struct Viewer;
-using ViewerPtr = std::shared_ptr<Viewer>;
+class ViewerBridge;
+using ViewerBridgePtr = std::shared_ptr<ViewerBridge>;
 
+/**
+ * parameters are snapshotted (copied to memory in the flat layout, see 'FlatParamIO') into a ring
+ * buffer in the ceres iteration, and are dumped to files by a background writer, so that slow file
+ * systems would not delay iterations
+ */
 struct CeresDebugCallBack : public ceres::IterationCallback {
 private:
+    struct IterSnapshot {
+        int idx;
+        double cost, gradient, trRadius;
+        // the parameters in the flat layout
+        std::string param;
+    };
+
     CalibParamManagerPtr _parMagr;
+    // a deep copy of the parameter manager, where snapshots are restored to be dumped
+    CalibParamManagerPtr _dumpParMagr;
     const std::string _outputDir;
     std::ofstream _iterInfoFile;
     int _idx;
+    int _iterCount;
+
+    // the ring buffer, the writer waits for snapshots, and the solver waits only if it is full
+    std::vector<IterSnapshot> _ring;
+    std::size_t _head, _size;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    bool _stop;
+    std::thread _writer;
 
 public:
     explicit CeresDebugCallBack(CalibParamManagerPtr calibParamManager);
@@ -64,12 +91,19 @@ public:
     ceres::CallbackReturnType operator()(const ceres::IterationSummary &summary) override;
 };
 
+// records each ceres iteration (and its cost) as trace events, see 'TraceRecorder'
+struct CeresTraceCallBack : public ceres::IterationCallback {
+public:
+    ceres::CallbackReturnType operator()(const ceres::IterationSummary &summary) override;
+};
+
+// publishes snapshots to the viewer bridge, which never blocks the solver on rendering
 struct CeresViewerCallBack : public ceres::IterationCallback {
 private:
-    ViewerPtr _viewer;
+    ViewerBridgePtr _bridge;
 
 public:
-    explicit CeresViewerCallBack(ViewerPtr viewer);
+    explicit CeresViewerCallBack(ViewerBridgePtr bridge);
 
     ceres::CallbackReturnType operator()(const ceres::IterationSummary &summary) override;
 };
@@ -0,0 +1,108 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_DATA_LIFETIME_PLANNER_H
+#define IKALIBR_DATA_LIFETIME_PLANNER_H
+
+#include "calib/calib_data_manager.h"
+#include "calib/time_deriv.hpp"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the lifetime planner of heavy measurement payloads (images and depth maps). From the
+ * integrated sensors, the spline type, and the batch optimizations to perform, the last stage
+ * using each payload is determined in advance. Once a stage is finished, payloads whose last use
+ * is this stage are released (or spilled to disk), and the memory usage of the process is reported.
+ * LiDAR scans are not managed, as they are used until the final map is output.
+ */
+class DataLifetimePlanner {
+public:
+    using Ptr = std::shared_ptr<DataLifetimePlanner>;
+
+    enum class Stage : int { INITIALIZATION = 0, BATCH_OPTIMIZATION, FINALIZATION, OUTPUT };
+
+    enum class Payload : int {
+        // the images of optical cameras (both the pose and velocity ones)
+        CAMERA_IMAGE = 0,
+        // the color and depth images of rgbd cameras, back-projection requires both of them
+        RGBD_IMAGE
+    };
+
+    struct Lifetime {
+        Payload payload;
+        std::string topic;
+        // the last stage using this payload
+        Stage lastUse;
+        bool released;
+    };
+
+private:
+    CalibDataManager::Ptr _dataMagr;
+    std::vector<Lifetime> _lifetimes;
+
+public:
+    DataLifetimePlanner(CalibDataManager::Ptr dataMagr,
+                        TimeDeriv::ScaleSplineType scaleType,
+                        int batchOptCount);
+
+    static Ptr Create(const CalibDataManager::Ptr &dataMagr,
+                      TimeDeriv::ScaleSplineType scaleType,
+                      int batchOptCount);
+
+    // release payloads whose last use is the finished stage, and report the memory usage
+    void OnStageFinished(Stage stage);
+
+    void PrintPlan() const;
+
+    [[nodiscard]] const std::vector<Lifetime> &GetLifetimes() const;
+
+    // the current and peak resident set sizes (in MB) of this process, negative if unknown
+    static std::pair<double, double> ResidentSetSize();
+
+    static std::string StageName(Stage stage);
+
+protected:
+    // release frames of the payload, returns the number of frames spilled to disk
+    int Release(const Lifetime &lifetime) const;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_DATA_LIFETIME_PLANNER_H
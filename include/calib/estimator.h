@@ -37,8 +37,14 @@
 
 #include "calib/calib_data_manager.h"
 #include "calib/calib_param_manager.h"
+#include "calib/factor_arena.h"
+#include "calib/factor_profiler.h"
+#include "calib/inertial_preintegration.h"
+#include "calib/spline_meta_cache.h"
+#include "calib/temporal_padding.h"
 #include "calib/time_deriv.hpp"
 #include "ceres/ceres.h"
+#include "Eigen/Sparse"
 #include "config/configor.h"
 #include "ctraj/core/pose.hpp"
 #include "ctraj/core/spline_bundle.h"
@@ -49,8 +55,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 using namespace magic_enum::bitwise_operators;
-struct PointToSurfelCorr;
-using PointToSurfelCorrPtr = std::shared_ptr<PointToSurfelCorr>;
+struct PointToSurfelCorrBuffer;
 struct VisualReProjCorr;
 using VisualReProjCorrPtr = std::shared_ptr<VisualReProjCorr>;
 struct OpticalFlowCorr;
@@ -59,6 +64,7 @@ struct OpticalFlowCurveCorr;
 using OpticalFlowCurveCorrPtr = std::shared_ptr<OpticalFlowCurveCorr>;
 struct NormFlow;
 using NormFlowPtr = std::shared_ptr<NormFlow>;
+struct SpatTempPrioriFactor;
 
 // myenumGenor Option OPT_SO3_SPLINE OPT_SCALE_SPLINE OPT_SO3_BiToBr OPT_POS_BiInBr
 // OPT_SO3_RjToBr OPT_POS_RjInBr OPT_SO3_LkToBr OPT_POS_LkInBr OPT_SO3_CmToBr OPT_POS_CmInBr
@@ -140,22 +146,61 @@ public:
     using SplineMetaType = ns_ctraj::SplineMeta<Configor::Prior::SplineOrder>;
     using Opt = OptOption;
 
+    // point-to-surfel correspondences of the same surfel involving the same spline segments
+    struct PointToSurfelGroup {
+        SplineMetaType so3Meta, scaleMeta;
+        std::vector<std::size_t> indices;
+    };
+
 private:
+    // the spline bundle that newly added residual blocks are on
     SplineBundleType::Ptr splines;
     CalibParamManager::Ptr parMagr;
+    // spline metas shared by estimators on the same spline bundle
+    SplineMetaCache::Ptr metaCache;
+    // all spline bundles residual blocks are on, e.g., ones of sessions in a joint optimization
+    std::vector<SplineBundleType::Ptr> involvedSplines;
+
+    // residual blocks organized by groups, which could be removed (and re-added) separately
+    std::map<std::string, std::vector<ceres::ResidualBlockId>> residualGroups;
+    // the group that newly added residual blocks are assigned to, empty for no group
+    std::string curResidualGroup;
+
+    // whether the problem takes the ownership of cost functions and loss functions
+    bool ownCostFunctions;
+    bool ownLossFunctions;
+    // the factor profiler, nullptr if the profiling is not enabled
+    FactorProfiler::Ptr factorProfiler;
+    // cost functions (and profiled wrappers) and shared loss functions not owned by the problem
+    FactorArena arena;
+
+    // paddings of estimated time offsets and readout times, the priori ones by default
+    TemporalPadding temporalPadding;
+
+    // preintegration tables of imus for inertial alignments, built when first used
+    std::map<std::string, InertialPreintegration::Ptr> preintegrations;
 
     // manifolds
     static std::shared_ptr<ceres::EigenQuaternionManifold> QUATER_MANIFOLD;
     static std::shared_ptr<ceres::SphereManifold<3>> GRAVITY_MANIFOLD;
 
 public:
-    Estimator(SplineBundleType::Ptr splines, CalibParamManager::Ptr calibParamManager);
+    // the group of spatiotemporal priori constraints, which are re-added in each 'Solve'
+    static const std::string PRIORI_RESIDUAL_GROUP;
+
+    Estimator(SplineBundleType::Ptr splines,
+              CalibParamManager::Ptr calibParamManager,
+              const ceres::Problem::Options &options = DefaultProblemOptions());
 
     static Ptr Create(const SplineBundleType::Ptr &splines,
-                      const CalibParamManager::Ptr &calibParamManager);
+                      const CalibParamManager::Ptr &calibParamManager,
+                      const ceres::Problem::Options &options = DefaultProblemOptions());
 
     static ceres::Problem::Options DefaultProblemOptions();
 
+    // for estimators kept (and partially rebuilt) across batch optimizations, fast removal enabled
+    static ceres::Problem::Options PersistentProblemOptions();
+
     static ceres::Solver::Options DefaultSolverOptions(int threadNum = -1,
                                                        bool toStdout = true,
                                                        bool useCUDA = false);
@@ -164,9 +209,74 @@ public:
         const ceres::Solver::Options &options = Estimator::DefaultSolverOptions(),
         const SpatialTemporalPrioriPtr &priori = nullptr);
 
+    /**
+     * solve the problem by levenberg-marquardt iterations, where the 'eliminated' parameter blocks
+     * (e.g., per-window velocities, which are numerous but only locally coupled) are eliminated
+     * via the Schur complement in each iteration. Only a small dense system of other parameters
+     * (e.g., gravity and extrinsics) is solved, and eliminated ones are back-substituted. The
+     * iteration count, tolerance, threads, and callbacks are taken from 'options'
+     */
+    ceres::Solver::Summary SolveBySchurElimination(
+        const std::set<double *> &eliminated,
+        const ceres::Solver::Options &options = Estimator::DefaultSolverOptions(),
+        const SpatialTemporalPrioriPtr &priori = nullptr);
+
+    /**
+     * profile evaluations of residual blocks added afterwards for each factor type, the summary
+     * would be printed after each solving
+     */
+    void EnableFactorProfiler();
+
+    // nullptr if the profiling is not enabled
+    [[nodiscard]] const FactorProfiler::Ptr &GetFactorProfiler() const;
+
+    // the number of residual blocks of each factor type (see 'FactorProfiler::FactorName')
+    [[nodiscard]] std::map<std::string, int> FactorCounts() const;
+
+    /**
+     * preintegration tables of imus used by inertial alignments, which could be passed to another
+     * estimator on the same splines to avoid rebuilding. Tables are dropped once the so3 spline is
+     * optimized in 'Solve'
+     */
+    [[nodiscard]] const std::map<std::string, InertialPreintegration::Ptr> &
+    GetInertialPreintegrations() const;
+
+    void SetInertialPreintegrations(
+        const std::map<std::string, InertialPreintegration::Ptr> &tables);
+
+    /**
+     * the paddings of temporal parameters used by residual blocks added afterwards, which
+     * determine the considered time ranges (thus knots involved) and the bounds of temporal
+     * parameters. Should be set before adding any residual block
+     */
+    void SetTemporalPadding(const TemporalPadding &padding);
+
+    [[nodiscard]] const TemporalPadding &GetTemporalPadding() const;
+
+    /**
+     * switch the spline bundle that residual blocks added afterwards are on, thus residual blocks
+     * of several sessions (each with its own splines) share calibration parameters in one problem.
+     * Preintegration tables are bound to the so3 spline, thus are dropped
+     */
+    void SwitchSplines(const SplineBundleType::Ptr &newSplines);
+
     Eigen::MatrixXd GetHessianMatrix(const std::vector<double *> &consideredParBlocks,
                                      int numThread = 1);
 
+    // the hessian matrix (J^T * J) computed sparsely, columns are ordered as 'consideredParBlocks'
+    Eigen::SparseMatrix<double> GetSparseHessianMatrix(
+        const std::vector<double *> &consideredParBlocks, int numThread = 1);
+
+    /**
+     * the hessian matrix of 'keptParBlocks', where 'marginalizedParBlocks' (such as spline knots)
+     * are marginalized via the Schur complement, i.e., H_kk - H_km * H_mm^(-1) * H_mk. The inverse
+     * of this matrix is the covariance of kept parameters. The marginalized block is factorized
+     * sparsely and is never densified
+     */
+    Eigen::MatrixXd GetMarginalHessianMatrix(const std::vector<double *> &keptParBlocks,
+                                             const std::vector<double *> &marginalizedParBlocks,
+                                             int numThread = 1);
+
     void PrintParameterInfo() const;
 
 public:
@@ -186,6 +296,18 @@ public:
                                Opt option,
                                double acceWeight);
 
+    // imu samples falling into the same spline segment are organized as one residual block
+    void AddIMUGyroMeasurements(const std::vector<IMUFrame::Ptr> &imuFrames,
+                                const std::string &topic,
+                                Opt option,
+                                double gyroWeight);
+
+    template <TimeDeriv::ScaleSplineType type>
+    void AddIMUAcceMeasurements(const std::vector<IMUFrame::Ptr> &imuFrames,
+                                const std::string &topic,
+                                Opt option,
+                                double acceWeight);
+
     void AddInertialAlignment(const std::vector<IMUFrame::Ptr> &data,
                               const std::string &imuTopic,
                               double sTimeByBr,
@@ -223,6 +345,8 @@ public:
                                    const std::string &radarTopic,
                                    const RadarTargetArray::Ptr &sRadarAry,
                                    const RadarTargetArray::Ptr &eRadarAry,
+                                   const Eigen::Vector3d &sRadarVel,
+                                   const Eigen::Vector3d &eRadarVel,
                                    Estimator::Opt option,
                                    double weight);
 
@@ -259,6 +383,8 @@ public:
                                            const std::string &radarTopic,
                                            const RadarTargetArray::Ptr &sRadarAry,
                                            const RadarTargetArray::Ptr &eRadarAry,
+                                           const Eigen::Vector3d &sRadarVel,
+                                           const Eigen::Vector3d &eRadarVel,
                                            Estimator::Opt option,
                                            double weight);
 
@@ -303,6 +429,18 @@ public:
                              Estimator::Opt option,
                              double weight);
 
+    /**
+     * targets of a scan are organized as one residual block, the spline kinematics are evaluated
+     * only once for them
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_RjToBr | POS_RjInBr | TO_RjToBr ]
+     */
+    template <TimeDeriv::ScaleSplineType type>
+    void AddRadarMeasurements(const RadarTargetArray::Ptr &radarArray,
+                              const std::string &topic,
+                              Estimator::Opt option,
+                              double weight);
+
     /**
      * param blocks:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_RjToBr | POS_RjInBr | TO_RjToBr ]
@@ -323,7 +461,8 @@ public:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_LkToBr | POS_LkInBr | TO_LkToBr ]
      */
     template <TimeDeriv::ScaleSplineType type>
-    void AddLiDARPointToSurfelConstraint(const PointToSurfelCorrPtr &ptsCorr,
+    void AddLiDARPointToSurfelConstraint(const PointToSurfelCorrBuffer &ptsCorrs,
+                                         std::size_t idx,
                                          const std::string &topic,
                                          Opt option,
                                          double weight);
@@ -333,11 +472,36 @@ public:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr ]
      */
     template <TimeDeriv::ScaleSplineType type>
-    void AddRGBDPointTiSurfelConstraint(const PointToSurfelCorrPtr &ptsCorr,
+    void AddRGBDPointTiSurfelConstraint(const PointToSurfelCorrBuffer &ptsCorrs,
+                                        std::size_t idx,
                                         const std::string &topic,
                                         Opt option,
                                         double weight);
 
+    /**
+     * points of the same surfel involving the same knots are organized as one residual block (see
+     * 'GroupPointToSurfelCorrs'), the surfel and extrinsics are loaded only once for them. The
+     * 'weight' is multiplied by the one of each correspondence
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_LkToBr | POS_LkInBr | TO_LkToBr ]
+     */
+    template <TimeDeriv::ScaleSplineType type>
+    void AddLiDARPointToSurfelConstraints(const PointToSurfelCorrBuffer &ptsCorrs,
+                                          const std::string &topic,
+                                          Opt option,
+                                          double weight);
+
+    /**
+     * see 'AddLiDARPointToSurfelConstraints'
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr ]
+     */
+    template <TimeDeriv::ScaleSplineType type>
+    void AddRGBDPointToSurfelConstraints(const PointToSurfelCorrBuffer &ptsCorrs,
+                                         const std::string &topic,
+                                         Opt option,
+                                         double weight);
+
     /**
      * param blocks:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
@@ -351,6 +515,21 @@ public:
                                Opt option,
                                double weight);
 
+    /**
+     * reprojections of a landmark (sharing the first observation and the inverse depth), organized
+     * as one residual block, 'weight' is multiplied by the weights of correspondences
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
+     * READOUT_TIME | FX | FY | CX | CY | GLOBAL_SCALE | INV_DEPTH ]
+     */
+    template <TimeDeriv::ScaleSplineType type>
+    void AddVisualReprojections(const std::vector<VisualReProjCorrPtr> &visualCorrs,
+                                const std::string &topic,
+                                double *globalScale,
+                                double *invDepth,
+                                Opt option,
+                                double weight);
+
     /**
      * param blocks:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr |
@@ -427,6 +606,37 @@ public:
                                             Opt option,
                                             double weight);
 
+    /**
+     * the fused counterpart of 'AddVisualOpticalFlowConstraint' and
+     * 'AddVisualOpticalFlowReprojConstraint', both residuals are computed from one evaluation of
+     * splines in a single cost function (see 'VisualOpticalFlowFusedFactor'). The trifocal tensor
+     * constraint (see 'AddVisualPPPTrifocalTensorFactorForVelCam') is involved as well if
+     * 'trifocalWeight' is positive. Param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
+     *   READOUT_TIME | FX | FY | CX | CY | DEPTH_INFO ]
+     */
+    template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+    void AddVisualOpticalFlowFusedConstraint(const OpticalFlowCorrPtr &ofCorr,
+                                             const std::string &topic,
+                                             Opt option,
+                                             double flowWeight,
+                                             double reprojWeight,
+                                             double trifocalWeight = 0.0);
+
+    /**
+     * the fused counterpart of 'AddRGBDOpticalFlowConstraint' and
+     * 'AddRGBDOpticalFlowReprojConstraint'. Param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr |
+     *   READOUT_TIME | FX | FY | CX | CY | DEPTH_INFO ]
+     */
+    template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+    void AddRGBDOpticalFlowFusedConstraint(const OpticalFlowCorrPtr &ofCorr,
+                                           const std::string &topic,
+                                           Opt option,
+                                           double flowWeight,
+                                           double reprojWeight,
+                                           double trifocalWeight = 0.0);
+
     /**
      * param blocks:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
@@ -447,8 +657,61 @@ public:
                                        Opt option,
                                        double weight);
 
+    /**
+     * the batched 'AddEventNormFlowRotConstraint' for normal flows in a short time bin, where the
+     * angular velocity is evaluated once at their mean time
+     * param blocks:
+     * [ SO3 | ... | SO3 | SO3_EsToBr | TO_EsToBr | FX | FY | CX | CY ]
+     */
+    void AddEventNormFlowRotBinConstraint(const std::vector<NormFlowPtr> &nfs,
+                                          const std::string &topic,
+                                          Opt option,
+                                          double weight);
+
     void SetRefIMUParamsConstant();
 
+    // residual blocks added after this call would be assigned to the given group
+    void SetResidualGroup(const std::string &group);
+
+    [[nodiscard]] bool HasResidualGroup(const std::string &group) const;
+
+    // the residual blocks of the given group, an empty vector is returned if it does not exist
+    [[nodiscard]] std::vector<ceres::ResidualBlockId> GetResidualGroup(
+        const std::string &group) const;
+
+    /**
+     * remove the residual blocks of the given group, as well as parameter blocks only involved in
+     * these residual blocks. Note that this is quite slow if fast removal is not enabled in the
+     * problem options, see 'PersistentProblemOptions'
+     */
+    void RemoveResidualGroup(const std::string &group);
+
+    /**
+     * set calibration parameters and spline knots in the problem to be constant or variable based
+     * on the given option, so that an existing estimator could be reused for another option. Note
+     * that time offset related options should not change, as they affect the structure (knots
+     * involved) of residual blocks
+     */
+    void ResetParameterBlockConstancy(Opt option);
+
+    using ceres::Problem::AddResidualBlock;
+
+    // add a residual block to the problem, which would be assigned to the current residual group
+    ceres::ResidualBlockId AddResidualBlock(ceres::CostFunction *costFunc,
+                                            ceres::LossFunction *lossFunc,
+                                            const std::vector<double *> &paramBlocks);
+
+    // loss functions for residual blocks, which are shared ones if the problem does not own them
+    ceres::LossFunction *HuberLoss(double param);
+
+    ceres::LossFunction *CauchyLoss(double param);
+
+    /**
+     * evaluate the residual block and the reference (double-precision) cost function at current
+     * parameters, and report differences of residuals and jacobians, the reference is deleted
+     */
+    void ValidateMixedPrecision(ceres::ResidualBlockId id, ceres::CostFunction *reference);
+
     void FixFirSO3ControlPoint();
 
     void AddVisualProjectionFactor(ns_veta::Posed *T_CurCToW,
@@ -485,6 +748,40 @@ public:
                                       double *TO_Sen2ToRef,
                                       double weight);
 
+    /**
+     * param blocks:
+     * [ PAR ]
+     * the rotation block ('isSO3') has four sub params, its target is a quaternion
+     */
+    void AddConsensusConstraint(double *parBlock,
+                                int size,
+                                bool isSO3,
+                                const Eigen::VectorXd &target,
+                                double weight);
+
+    /**
+     * param blocks:
+     * [ PAR | PAR | ... | PAR ]
+     * the dense prior from a marginal hessian matrix 'info' (in tangent spaces) at 'linPoint', the
+     * stacked parameter blocks, where rotation blocks ('isSO3') are quaternions
+     */
+    void AddMarginalPriorConstraint(const std::vector<double *> &parBlocks,
+                                    const std::vector<int> &sizes,
+                                    const std::vector<bool> &isSO3,
+                                    const Eigen::VectorXd &linPoint,
+                                    const Eigen::MatrixXd &info);
+
+    /**
+     * param blocks:
+     * [ PAR | PAR | ... | PAR ]
+     * the stacked spatiotemporal priors of sensor pairs on the (deduplicated) parameter blocks,
+     * where rotation blocks ('isSO3') are quaternions
+     */
+    void AddSpatTempPrioriConstraint(const SpatTempPrioriFactor &factor,
+                                     const std::vector<double *> &parBlocks,
+                                     const std::vector<int> &sizes,
+                                     const std::vector<bool> &isSO3);
+
     void PrintUninvolvedKnots() const;
 
     void AddVisualVelocityDepthFactor(Eigen::Vector3d *LIN_VEL_CmToWInCm,
@@ -547,6 +844,137 @@ public:
                                               bool estVelDirOnly);
 
 protected:
+    // the cached versions of 'SplineBundleType::CalculateSo3SplineMeta' and 'CalculateRdSplineMeta'
+    void CalculateSo3SplineMeta(const std::string &name,
+                                SplineMetaCache::TimeInitList times,
+                                SplineMetaType &splineMeta);
+
+    void CalculateRdSplineMeta(const std::string &name,
+                               SplineMetaCache::TimeInitList times,
+                               SplineMetaType &splineMeta);
+
+    /**
+     * set up the elimination ordering for schur-type linear solvers if it's not given: landmark
+     * (inverse) depths are eliminated first, then spline knots, and calibration parameters (
+     * extrinsics, time offsets, and intrinsics) are kept to the last. For long sequences where the
+     * dense reduced camera matrix is too large, 'DENSE_SCHUR' is switched to 'SPARSE_SCHUR' (or
+     * 'ITERATIVE_SCHUR' with a block-jacobi preconditioner if no sparse library is available)
+     */
+    void OrganizeSchurOrdering(ceres::Solver::Options &options);
+
+    // (re)add the spatiotemporal priori constraints before solving
+    void AddPrioriConstraints(const SpatialTemporalPrioriPtr &priori);
+
+    // the rotations stored in preintegration tables are out of date if the so3 spline varied
+    void ReleaseOutdatedPreintegrations();
+
+    // J^T * J of the (row-major) jacobian matrix, computed by row pieces in parallel
+    static Eigen::SparseMatrix<double> JacobianToHessian(
+        const Eigen::Map<const Eigen::SparseMatrix<double, Eigen::RowMajor, int>> &JMat,
+        int numThread);
+
+    // record the time breakdown and the problem size of a solving in the stage telemetry
+    static void CountSolverSummary(const ceres::Solver::Summary &summary);
+
+    // parameter blocks of the calibration parameters, i.e., extrinsics, time offsets, intrinsics
+    [[nodiscard]] std::set<double *> CalibParameterBlocks() const;
+
+    /**
+     * if imu intrinsics are not optimized, they are removed from measurements in advance (see
+     * 'PreCorrectFrozenIMUIntri'), and their param blocks are not involved in inertial factors
+     */
+    [[nodiscard]] static bool IsGyroIntriFrozen(Opt option);
+
+    [[nodiscard]] static bool IsAcceIntriFrozen(Opt option);
+
+    void AddIMUGyroResidualBlock(ceres::CostFunction *costFunc,
+                                 const SplineMetaType &so3Meta,
+                                 const std::string &topic,
+                                 Opt option,
+                                 bool intriFrozen);
+
+    void AddIMUAcceResidualBlock(ceres::CostFunction *costFunc,
+                                 const SplineMetaType &so3Meta,
+                                 const SplineMetaType &scaleMeta,
+                                 const std::string &topic,
+                                 Opt option,
+                                 bool intriFrozen);
+
+    // the involved spline segments of the radar measurement, false is returned if out of range
+    bool CalculateRadarSplineMeta(double timestamp,
+                                  const std::string &topic,
+                                  Opt option,
+                                  SplineMetaType &so3Meta,
+                                  SplineMetaType &scaleMeta);
+
+    ceres::ResidualBlockId AddRadarResidualBlock(ceres::CostFunction *costFunc,
+                                                 ceres::LossFunction *lossFunc,
+                                                 const SplineMetaType &so3Meta,
+                                                 const SplineMetaType &scaleMeta,
+                                                 const std::string &topic,
+                                                 Opt option);
+
+    // the involved spline segments of the point (lidar or rgbd), false is returned if out of range
+    bool CalculatePointToSurfelSplineMeta(double timestamp,
+                                          double timeOffset,
+                                          bool padTimeOffset,
+                                          double timeOffsetPadding,
+                                          SplineMetaType &so3Meta,
+                                          SplineMetaType &scaleMeta);
+
+    /**
+     * group correspondences by surfels and then by the involved spline segments, a group holds at
+     * most 'PointToSurfelGroupSizeMax' ones, correspondences out of the spline range are dropped
+     */
+    std::vector<PointToSurfelGroup> GroupPointToSurfelCorrs(const PointToSurfelCorrBuffer &ptsCorrs,
+                                                            double timeOffset,
+                                                            bool padTimeOffset,
+                                                            double timeOffsetPadding);
+
+    ceres::ResidualBlockId AddLiDARPointToSurfelResidualBlock(ceres::CostFunction *costFunc,
+                                                              ceres::LossFunction *lossFunc,
+                                                              const SplineMetaType &so3Meta,
+                                                              const SplineMetaType &scaleMeta,
+                                                              const std::string &topic,
+                                                              Opt option);
+
+    ceres::ResidualBlockId AddRGBDPointToSurfelResidualBlock(ceres::CostFunction *costFunc,
+                                                             ceres::LossFunction *lossFunc,
+                                                             const SplineMetaType &so3Meta,
+                                                             const SplineMetaType &scaleMeta,
+                                                             const std::string &topic,
+                                                             Opt option);
+
+    void AddVisualReprojResidualBlock(ceres::CostFunction *costFunc,
+                                      ceres::LossFunction *lossFunc,
+                                      const SplineMetaType &so3Meta,
+                                      const SplineMetaType &scaleMeta,
+                                      const std::string &topic,
+                                      double *globalScale,
+                                      double *invDepth,
+                                      Opt option);
+
+    /**
+     * add the fused optical flow factor of a camera (or rgbd camera) given its parameters, with
+     * 'optSO3', 'optPOS', and 'optTO' the options of its extrinsics and time offset. False is
+     * returned if the first or last feature is out of the range of splines
+     */
+    template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+    bool AddOpticalFlowFusedResidualBlock(const OpticalFlowCorrPtr &ofCorr,
+                                          const std::string &topic,
+                                          const ns_veta::PinholeIntrinsic::Ptr &intri,
+                                          double *SO3_SenToBr,
+                                          double *POS_SenInBr,
+                                          double *TO_SenToBr,
+                                          double *RS_READOUT,
+                                          Opt option,
+                                          Opt optSO3,
+                                          Opt optPOS,
+                                          Opt optTO,
+                                          double flowWeight,
+                                          double reprojWeight,
+                                          double trifocalWeight);
+
     void AddSo3KnotsData(std::vector<double *> &paramBlockVec,
                          const SplineBundleType::So3SplineType &spline,
                          const SplineMetaType &splineMeta,
@@ -572,12 +1000,12 @@ protected:
                            double sTimeByBi,
                            double eTimeByBi);
 
-    std::pair<std::vector<std::pair<double, Eigen::Vector3d>>,
-              std::vector<std::pair<double, Eigen::Matrix3d>>>
-    InertialIntegrationBase(const std::vector<IMUFrame::Ptr> &data,
-                            const std::string &imuTopic,
-                            double sTimeByBi,
-                            double eTimeByBi);
+    /**
+     * the preintegration table of the imu, which is (re)built if it does not exist or the imu
+     * frames, extrinsic rotation, or time offset of the imu changed
+     */
+    const InertialPreintegration::Ptr &GetInertialPreintegration(
+        const std::vector<IMUFrame::Ptr> &data, const std::string &imuTopic);
 
     /**
      * compute the time range of knots to be considered in optimization based on given information
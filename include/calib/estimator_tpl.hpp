@@ -55,6 +55,8 @@ namespace ns_ikalibr {
  * param blocks:
  * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | ACCE_BIAS | ACCE_MAP_COEFF | GRAVITY |
  *   SO3_BiToBr | POS_BiInBr | TO_BiToBr ]
+ * or [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | GRAVITY | SO3_BiToBr | POS_BiInBr |
+ *   TO_BiToBr ] if intrinsics are frozen
  */
 template <TimeDeriv::ScaleSplineType type>
 void Estimator::AddIMUAcceMeasurement(const IMUFrame::Ptr &imuFrame,
@@ -68,8 +70,8 @@ void Estimator::AddIMUAcceMeasurement(const IMUFrame::Ptr &imuFrame,
     // for the inertial measurements from the reference IMU, there is no need to consider a time
     // padding, as its time offsets would be fixed as identity
     if (IsOptionWith(Opt::OPT_TO_BiToBr, option) && Configor::DataStream::ReferIMU != topic) {
-        double minTime = imuFrame->GetTimestamp() - Configor::Prior::TimeOffsetPadding;
-        double maxTime = imuFrame->GetTimestamp() + Configor::Prior::TimeOffsetPadding;
+        double minTime = imuFrame->GetTimestamp() - temporalPadding.TimeOffset(topic);
+        double maxTime = imuFrame->GetTimestamp() + temporalPadding.TimeOffset(topic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(minTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(maxTime, Configor::Preference::SO3_SPLINE) ||
@@ -77,10 +79,8 @@ void Estimator::AddIMUAcceMeasurement(const IMUFrame::Ptr &imuFrame,
             !splines->TimeInRangeForRd(maxTime, Configor::Preference::SCALE_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{minTime, maxTime}},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{minTime, maxTime}},
-                                       scaleMeta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{minTime, maxTime}}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{minTime, maxTime}}, scaleMeta);
     } else {
         double curTime = imuFrame->GetTimestamp() + parMagr->TEMPORAL.TO_BiToBr.at(topic);
 
@@ -89,102 +89,174 @@ void Estimator::AddIMUAcceMeasurement(const IMUFrame::Ptr &imuFrame,
             !splines->TimeInRangeForRd(curTime, Configor::Preference::SCALE_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{curTime, curTime}},
-                                       scaleMeta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{curTime, curTime}}, scaleMeta);
     }
     // create a cost function
     constexpr int derivIMU = TimeDeriv::Deriv<type, TimeDeriv::LIN_ACCE>();
-    auto costFunc = IMUAcceFactor<Configor::Prior::SplineOrder, derivIMU>::Create(
-        so3Meta, scaleMeta, imuFrame, acceWeight);
-
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
-    }
-
-    // ACCE_BIAS
-    costFunc->AddParameterBlock(3);
-    // ACCE_MAP_COEFF
-    costFunc->AddParameterBlock(6);
-    // GRAVITY
-    costFunc->AddParameterBlock(3);
-    // SO3_BiToBr
-    costFunc->AddParameterBlock(4);
-    // POS_BiInBr
-    costFunc->AddParameterBlock(3);
-    // TO_BiToBr
-    costFunc->AddParameterBlock(1);
-
-    costFunc->SetNumResiduals(3);
-
-    // organize the param block vector
-    std::vector<double *> paramBlockVec;
-
-    // so3 knots param block
-    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
-                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+    using FactorType = IMUAcceFactor<Configor::Prior::SplineOrder, derivIMU>;
+    using FrozenFactorType = IMUAcceFactor<Configor::Prior::SplineOrder, derivIMU, true>;
+    const bool intriFrozen = IsAcceIntriFrozen(option);
+    ceres::CostFunction *costFunc;
+    if (intriFrozen) {
+        const auto &intri = parMagr->INTRI.IMU.at(topic);
+        const double timestamp = imuFrame->GetTimestamp();
+        const Eigen::Vector3d acce = intri->RemoveForceIntri(imuFrame->GetAcce());
+        const Eigen::Matrix3d intriMat = intri->ForceIntriMatrix();
+        if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+            scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+            costFunc = FrozenFactorType::CreateSized(so3Meta, scaleMeta, timestamp, acce, intriMat,
+                                                     acceWeight);
+        } else {
+            auto dynCostFunc = FrozenFactorType::Create(so3Meta, scaleMeta, timestamp, acce,
+                                                        intriMat, acceWeight);
+
+            // so3 knots param block [each has four sub params]
+            for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+                dynCostFunc->AddParameterBlock(4);
+            }
+            // pos knots param block [each has three sub params]
+            for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+                dynCostFunc->AddParameterBlock(3);
+            }
+
+            // GRAVITY
+            dynCostFunc->AddParameterBlock(3);
+            // SO3_BiToBr
+            dynCostFunc->AddParameterBlock(4);
+            // POS_BiInBr
+            dynCostFunc->AddParameterBlock(3);
+            // TO_BiToBr
+            dynCostFunc->AddParameterBlock(1);
+
+            dynCostFunc->SetNumResiduals(3);
+            costFunc = dynCostFunc;
+        }
+    } else if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the time offset is not padded, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, imuFrame, acceWeight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, imuFrame, acceWeight);
 
-    // lin acce knots
-    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
-                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
 
-    // ACCE_BIAS
-    auto acceBias = parMagr->INTRI.IMU.at(topic)->ACCE.BIAS.data();
-    paramBlockVec.push_back(acceBias);
-    // ACCE_MAP_COEFF
-    auto aceMapCoeff = parMagr->INTRI.IMU.at(topic)->ACCE.MAP_COEFF.data();
-    paramBlockVec.push_back(aceMapCoeff);
-    // GRAVITY
-    auto gravity = parMagr->GRAVITY.data();
-    paramBlockVec.push_back(gravity);
-    // SO3_BiToBc
-    auto SO3_BiToBc = parMagr->EXTRI.SO3_BiToBr.at(topic).data();
-    paramBlockVec.push_back(SO3_BiToBc);
-    // POS_BiInBc
-    auto POS_BiInBc = parMagr->EXTRI.POS_BiInBr.at(topic).data();
-    paramBlockVec.push_back(POS_BiInBc);
-    // TIME_OFFSET_BiToBc
-    auto TIME_OFFSET_BiToBc = &parMagr->TEMPORAL.TO_BiToBr.at(topic);
-    paramBlockVec.push_back(TIME_OFFSET_BiToBc);
+        // ACCE_BIAS
+        dynCostFunc->AddParameterBlock(3);
+        // ACCE_MAP_COEFF
+        dynCostFunc->AddParameterBlock(6);
+        // GRAVITY
+        dynCostFunc->AddParameterBlock(3);
+        // SO3_BiToBr
+        dynCostFunc->AddParameterBlock(4);
+        // POS_BiInBr
+        dynCostFunc->AddParameterBlock(3);
+        // TO_BiToBr
+        dynCostFunc->AddParameterBlock(1);
 
-    // pass to problem
-    this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
-    this->SetManifold(gravity, GRAVITY_MANIFOLD.get());
-    this->SetManifold(SO3_BiToBc, QUATER_MANIFOLD.get());
-
-    if (!IsOptionWith(Opt::OPT_ACCE_BIAS, option)) {
-        this->SetParameterBlockConstant(acceBias);
+        dynCostFunc->SetNumResiduals(3);
+        costFunc = dynCostFunc;
     }
 
-    if (!IsOptionWith(Opt::OPT_ACCE_MAP_COEFF, option)) {
-        this->SetParameterBlockConstant(aceMapCoeff);
-    }
+    AddIMUAcceResidualBlock(costFunc, so3Meta, scaleMeta, topic, option, intriFrozen);
+}
 
-    if (!IsOptionWith(Opt::OPT_GRAVITY, option)) {
-        this->SetParameterBlockConstant(gravity);
+template <TimeDeriv::ScaleSplineType type>
+void Estimator::AddIMUAcceMeasurements(const std::vector<IMUFrame::Ptr> &imuFrames,
+                                       const std::string &topic,
+                                       Opt option,
+                                       double acceWeight) {
+    // if the time offset is padded, the involved knots vary from sample to sample
+    if (IsOptionWith(Opt::OPT_TO_BiToBr, option) && Configor::DataStream::ReferIMU != topic) {
+        for (const auto &imuFrame : imuFrames) {
+            AddIMUAcceMeasurement<type>(imuFrame, topic, option, acceWeight);
+        }
+        return;
     }
 
-    if (!IsOptionWith(Opt::OPT_SO3_BiToBr, option)) {
-        this->SetParameterBlockConstant(SO3_BiToBc);
+    /**
+     * frozen intrinsics are removed from all measurements at once, the corrected measurement of
+     * the i-th frame is the i-th column
+     */
+    const bool intriFrozen = IsAcceIntriFrozen(option);
+    Eigen::Matrix3Xd acces;
+    Eigen::Matrix3d intriMat;
+    if (intriFrozen) {
+        const auto &intri = parMagr->INTRI.IMU.at(topic);
+        acces.resize(3, static_cast<Eigen::Index>(imuFrames.size()));
+        for (int i = 0; i < static_cast<int>(imuFrames.size()); ++i) {
+            acces.col(i) = imuFrames[i]->GetAcce();
+        }
+        acces = intri->RemoveForceIntriBatch(acces);
+        intriMat = intri->ForceIntriMatrix();
     }
 
-    if (!IsOptionWith(Opt::OPT_POS_BiInBr, option)) {
-        this->SetParameterBlockConstant(POS_BiInBc);
-    }
+    // samples falling into the same spline segments are organized as one residual block
+    constexpr int derivIMU = TimeDeriv::Deriv<type, TimeDeriv::LIN_ACCE>();
+    SplineMetaType so3Meta, scaleMeta;
+    std::vector<IMUFrame::Ptr> segFrames;
+    std::vector<int> segIndices;
+    auto addSegment = [this, &so3Meta, &scaleMeta, &segFrames, &segIndices, &acces, &intriMat,
+                       &topic, option, acceWeight, intriFrozen]() {
+        if (segFrames.empty()) {
+            return;
+        }
+        ceres::CostFunction *costFunc;
+        if (intriFrozen) {
+            Eigen::Matrix3Xd segAcces(3, static_cast<Eigen::Index>(segIndices.size()));
+            for (int i = 0; i < static_cast<int>(segIndices.size()); ++i) {
+                segAcces.col(i) = acces.col(segIndices[i]);
+            }
+            costFunc = IMUAcceBatchFactor<Configor::Prior::SplineOrder, derivIMU, true>::Create(
+                so3Meta, scaleMeta, segFrames, segAcces, intriMat, acceWeight);
+        } else {
+            costFunc = IMUAcceBatchFactor<Configor::Prior::SplineOrder, derivIMU>::Create(
+                so3Meta, scaleMeta, segFrames, acceWeight);
+        }
+        AddIMUAcceResidualBlock(costFunc, so3Meta, scaleMeta, topic, option, intriFrozen);
+        segFrames.clear();
+        segIndices.clear();
+    };
 
-    if (!IsOptionWith(Opt::OPT_TO_BiToBr, option)) {
-        this->SetParameterBlockConstant(TIME_OFFSET_BiToBc);
-    } else {
-        // set bound
-        this->SetParameterLowerBound(TIME_OFFSET_BiToBc, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TIME_OFFSET_BiToBc, 0, Configor::Prior::TimeOffsetPadding);
+    const double TO_BiToBr = parMagr->TEMPORAL.TO_BiToBr.at(topic);
+    for (int i = 0; i < static_cast<int>(imuFrames.size()); ++i) {
+        const auto &imuFrame = imuFrames[i];
+        double curTime = imuFrame->GetTimestamp() + TO_BiToBr;
+
+        // check point time stamp
+        if (!splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE) ||
+            !splines->TimeInRangeForRd(curTime, Configor::Preference::SCALE_SPLINE)) {
+            continue;
+        }
+        SplineMetaType curSo3Meta, curScaleMeta;
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}}, curSo3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{curTime, curTime}},
+                              curScaleMeta);
+        if (curSo3Meta.NumParameters() != Configor::Prior::SplineOrder ||
+            curScaleMeta.NumParameters() != Configor::Prior::SplineOrder) {
+            // unexpected knot window, add it separately
+            AddIMUAcceMeasurement<type>(imuFrame, topic, option, acceWeight);
+            continue;
+        }
+        if (!segFrames.empty() &&
+            (curSo3Meta.segments.front().t0 != so3Meta.segments.front().t0 ||
+             curScaleMeta.segments.front().t0 != scaleMeta.segments.front().t0)) {
+            addSegment();
+        }
+        if (segFrames.empty()) {
+            so3Meta = curSo3Meta, scaleMeta = curScaleMeta;
+        }
+        segFrames.push_back(imuFrame);
+        segIndices.push_back(i);
     }
+    addSegment();
 }
 
 /**
@@ -196,99 +268,89 @@ void Estimator::AddRadarMeasurement(const RadarTarget::Ptr &radarFrame,
                                     const std::string &topic,
                                     Opt option,
                                     double weight) {
-    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-
     SplineMetaType so3Meta, scaleMeta;
-
-    // different relative control points finding [single vs. range]
-    if (IsOptionWith(Opt::OPT_TO_RjToBr, option)) {
-        double tMin = radarFrame->GetTimestamp() - Configor::Prior::TimeOffsetPadding;
-        double tMax = radarFrame->GetTimestamp() + Configor::Prior::TimeOffsetPadding;
-        // invalid time stamp
-        if (!splines->TimeInRange(tMin, so3Spline) || !splines->TimeInRange(tMax, so3Spline) ||
-            !splines->TimeInRange(tMin, scaleSpline) || !splines->TimeInRange(tMax, scaleSpline)) {
-            return;
-        }
-
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{tMin, tMax}}, so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{tMin, tMax}},
-                                       scaleMeta);
-    } else {
-        double t = radarFrame->GetTimestamp() + parMagr->TEMPORAL.TO_RjToBr.at(topic);
-
-        // check point time stamp
-        if (!splines->TimeInRange(t, so3Spline) || !splines->TimeInRange(t, scaleSpline)) {
-            return;
-        }
-
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{t, t}}, so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{t, t}}, scaleMeta);
+    if (!CalculateRadarSplineMeta(radarFrame->GetTimestamp(), topic, option, so3Meta, scaleMeta)) {
+        return;
     }
 
     static constexpr int derivRadar = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
 
     // create a cost function
-    auto costFunc = RadarFactor<Configor::Prior::SplineOrder, derivRadar>::Create(
-        so3Meta, scaleMeta, radarFrame, weight);
-
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
+    using FactorType = RadarFactor<Configor::Prior::SplineOrder, derivRadar>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the time offset is not padded, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, radarFrame, weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, radarFrame, weight);
+        // the Residual
+        dynCostFunc->SetNumResiduals(1);
+        costFunc = dynCostFunc;
     }
-    costFunc->AddParameterBlock(4);  // SO3_RtoB
-    costFunc->AddParameterBlock(3);  // POS_RinB
-    costFunc->AddParameterBlock(1);  // TIME_OFFSET_RtoB
 
-    // the Residual
-    costFunc->SetNumResiduals(1);
-
-    // organize the param block vector
-    std::vector<double *> paramBlockVec;
-
-    // so3 knots param block
-    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
-                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+    // pass to problem
+    // remove dynamic targets (outliers)
+    // this->AddResidualBlockToProblem(costFunc, new ceres::HuberLoss(weight * weight * 0.125),
+    // paramBlockVec);
+    AddRadarResidualBlock(costFunc,
+                          this->HuberLoss(Configor::Prior::LossForRadarDopplerFactor * weight),
+                          so3Meta, scaleMeta, topic, option);
+}
 
-    // lin acce knots
-    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
-                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_RjToBr | POS_RjInBr | TO_RjToBr ]
+ */
+template <TimeDeriv::ScaleSplineType type>
+void Estimator::AddRadarMeasurements(const RadarTargetArray::Ptr &radarArray,
+                                     const std::string &topic,
+                                     Opt option,
+                                     double weight) {
+    static constexpr int derivRadar = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
 
-    auto SO3_RjToBr = parMagr->EXTRI.SO3_RjToBr.at(topic).data();
-    paramBlockVec.push_back(SO3_RjToBr);
+    // targets sharing the same timestamp are organized as one residual block, which refers to
+    // them by indices in the structure-of-arrays layout
+    const auto &timestamps = radarArray->GetTargetSoA().timestamps;
+    // the first mixed-precision block is compared against the double one if required
+    bool validate = Configor::Preference::MixedPrecisionResiduals &&
+                    Configor::Preference::ValidateMixedPrecision;
+    for (Eigen::Index begin = 0, end = 0; begin < timestamps.size(); begin = end) {
+        const double t = timestamps(begin);
+        end = begin + 1;
+        while (end < timestamps.size() && timestamps(end) == t) {
+            ++end;
+        }
+        const Eigen::Index count = end - begin;
 
-    auto POS_RjInBr = parMagr->EXTRI.POS_RjInBr.at(topic).data();
-    paramBlockVec.push_back(POS_RjInBr);
+        SplineMetaType so3Meta, scaleMeta;
+        if (!CalculateRadarSplineMeta(t, topic, option, so3Meta, scaleMeta)) {
+            continue;
+        }
 
-    auto TO_RjToBr = &parMagr->TEMPORAL.TO_RjToBr.at(topic);
-    paramBlockVec.push_back(TO_RjToBr);
+        // create a cost function, the huber loss is applied to each target inside
+        using FactorType = RadarScanFactor<Configor::Prior::SplineOrder, derivRadar>;
+        const double lossParam = Configor::Prior::LossForRadarDopplerFactor * weight;
+        ceres::CostFunction *costFunc;
+        if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+            scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+            // the time offset is not padded, the fixed-size cost function is much faster
+            costFunc = FactorType::CreateSized(so3Meta, scaleMeta, radarArray, begin, count, weight,
+                                               lossParam);
+        } else {
+            auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, radarArray, begin, count,
+                                                  weight, lossParam);
+            // the Residual
+            dynCostFunc->SetNumResiduals(static_cast<int>(count));
+            costFunc = dynCostFunc;
+        }
 
-    // pass to problem
-    // remove dynamic targets (outliers)
-    // this->AddResidualBlockToProblem(costFunc, new ceres::HuberLoss(weight * weight * 0.125),
-    // paramBlockVec);
-    this->AddResidualBlock(
-        costFunc, new ceres::HuberLoss(Configor::Prior::LossForRadarDopplerFactor * weight),
-        paramBlockVec);
-    this->SetManifold(SO3_RjToBr, QUATER_MANIFOLD.get());
-
-    // lock param or not
-    if (!IsOptionWith(Opt::OPT_TO_RjToBr, option)) {
-        this->SetParameterBlockConstant(TO_RjToBr);
-    } else {
-        // set bound
-        this->SetParameterLowerBound(TO_RjToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_RjToBr, 0, Configor::Prior::TimeOffsetPadding);
-    }
-    if (!IsOptionWith(Opt::OPT_SO3_RjToBr, option)) {
-        this->SetParameterBlockConstant(SO3_RjToBr);
-    }
-    if (!IsOptionWith(Opt::OPT_POS_RjInBr, option)) {
-        this->SetParameterBlockConstant(POS_RjInBr);
+        auto id = AddRadarResidualBlock(costFunc, nullptr, so3Meta, scaleMeta, topic, option);
+        if (validate) {
+            ValidateMixedPrecision(id, FactorType::Create(so3Meta, scaleMeta, radarArray, begin,
+                                                          count, weight, lossParam, false));
+            validate = false;
+        }
     }
 }
 
@@ -308,8 +370,7 @@ void Estimator::AddLinearScaleConstraint(double timeByBr,
     }
 
     SplineMetaType scaleMeta;
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{timeByBr, timeByBr}},
-                                   scaleMeta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{timeByBr, timeByBr}}, scaleMeta);
 
     // create a cost function
     auto costFunc = LinearScaleDerivFactor<Configor::Prior::SplineOrder, TimeDeriv>::Create(
@@ -339,107 +400,88 @@ void Estimator::AddLinearScaleConstraint(double timeByBr,
  * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_LkToBr | POS_LkInBr | TO_LkToBr ]
  */
 template <TimeDeriv::ScaleSplineType type>
-void Estimator::AddLiDARPointToSurfelConstraint(const PointToSurfelCorrPtr &ptsCorr,
+void Estimator::AddLiDARPointToSurfelConstraint(const PointToSurfelCorrBuffer &ptsCorrs,
+                                                std::size_t idx,
                                                 const std::string &topic,
                                                 Opt option,
                                                 double weight) {
+    const double timestamp = ptsCorrs.timestamps.at(idx);
+
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
-
-    // different relative control points finding [single vs. range]
-    if (IsOptionWith(Opt::OPT_TO_LkToBr, option)) {
-        double maxTime = ptsCorr->timestamp + Configor::Prior::TimeOffsetPadding;
-        double minTime = ptsCorr->timestamp - Configor::Prior::TimeOffsetPadding;
-
-        // invalid time stamp
-        if (!splines->TimeInRangeForSo3(minTime, Configor::Preference::SO3_SPLINE) ||
-            !splines->TimeInRangeForSo3(maxTime, Configor::Preference::SO3_SPLINE) ||
-            !splines->TimeInRangeForRd(minTime, Configor::Preference::SCALE_SPLINE) ||
-            !splines->TimeInRangeForRd(maxTime, Configor::Preference::SCALE_SPLINE)) {
-            return;
-        }
-
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{minTime, maxTime}},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{minTime, maxTime}},
-                                       scaleMeta);
-    } else {
-        double curTime = ptsCorr->timestamp + parMagr->TEMPORAL.TO_LkToBr.at(topic);
-
-        // check point time stamp
-        if (!splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE) ||
-            !splines->TimeInRangeForRd(curTime, Configor::Preference::SCALE_SPLINE)) {
-            return;
-        }
-
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{curTime, curTime}},
-                                       scaleMeta);
+    if (!CalculatePointToSurfelSplineMeta(timestamp, parMagr->TEMPORAL.TO_LkToBr.at(topic),
+                                          IsOptionWith(Opt::OPT_TO_LkToBr, option),
+                                          temporalPadding.TimeOffset(topic), so3Meta, scaleMeta)) {
+        return;
     }
+
     static constexpr int derivLiDAR = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
     // create a cost function
-    auto costFunc = PointToSurfelFactor<Configor::Prior::SplineOrder, derivLiDAR>::Create(
-        so3Meta, scaleMeta, ptsCorr, weight);
-
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
+    using FactorType = PointToSurfelFactor<Configor::Prior::SplineOrder, derivLiDAR>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the time offset is not padded, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, timestamp,
+                                           ptsCorrs.pInScan.at(idx).cast<double>(),
+                                           ptsCorrs.SurfelOf(idx), weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, timestamp,
+                                              ptsCorrs.pInScan.at(idx).cast<double>(),
+                                              ptsCorrs.SurfelOf(idx), weight);
+        dynCostFunc->SetNumResiduals(1);
+        costFunc = dynCostFunc;
     }
 
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-
-    costFunc->SetNumResiduals(1);
-
-    // organize the param block vector
-    std::vector<double *> paramBlockVec;
-
-    // so3 knots param block
-    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
-                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
-
-    // lin acce knots
-    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
-                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
-
-    // SO3_LkToBr
-    auto SO3_LkToBr = parMagr->EXTRI.SO3_LkToBr.at(topic).data();
-    paramBlockVec.push_back(SO3_LkToBr);
-
-    // POS_LkInBr
-    auto POS_LkInBr = parMagr->EXTRI.POS_LkInBr.at(topic).data();
-    paramBlockVec.push_back(POS_LkInBr);
-
-    // TO_LkToBr
-    auto TO_LkToBr = &parMagr->TEMPORAL.TO_LkToBr.at(topic);
-    paramBlockVec.push_back(TO_LkToBr);
-
     // pass to problem
-    this->AddResidualBlock(
-        costFunc, new ceres::HuberLoss(Configor::Prior::LossForPointToSurfelFactor * weight),
-        paramBlockVec);
-    this->SetManifold(SO3_LkToBr, QUATER_MANIFOLD.get());
-
-    if (!IsOptionWith(Opt::OPT_SO3_LkToBr, option)) {
-        this->SetParameterBlockConstant(SO3_LkToBr);
-    }
-
-    if (!IsOptionWith(Opt::OPT_POS_LkInBr, option)) {
-        this->SetParameterBlockConstant(POS_LkInBr);
-    }
+    AddLiDARPointToSurfelResidualBlock(
+        costFunc, this->HuberLoss(Configor::Prior::LossForPointToSurfelFactor * weight),
+        so3Meta, scaleMeta, topic, option);
+}
 
-    if (!IsOptionWith(Opt::OPT_TO_LkToBr, option)) {
-        this->SetParameterBlockConstant(TO_LkToBr);
-    } else {
-        // set bound
-        this->SetParameterLowerBound(TO_LkToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_LkToBr, 0, Configor::Prior::TimeOffsetPadding);
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_LkToBr | POS_LkInBr | TO_LkToBr ]
+ */
+template <TimeDeriv::ScaleSplineType type>
+void Estimator::AddLiDARPointToSurfelConstraints(const PointToSurfelCorrBuffer &ptsCorrs,
+                                                 const std::string &topic,
+                                                 Opt option,
+                                                 double weight) {
+    static constexpr int derivLiDAR = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
+    const double lossParam = Configor::Prior::LossForPointToSurfelFactor;
+    const double TO_LkToBr = parMagr->TEMPORAL.TO_LkToBr.at(topic);
+    const bool optTO = IsOptionWith(Opt::OPT_TO_LkToBr, option);
+
+    const auto groups =
+        GroupPointToSurfelCorrs(ptsCorrs, TO_LkToBr, optTO, temporalPadding.TimeOffset(topic));
+    // the first mixed-precision block is compared against the double one if required
+    bool validate = Configor::Preference::MixedPrecisionResiduals &&
+                    Configor::Preference::ValidateMixedPrecision;
+    for (const auto &[so3Meta, scaleMeta, indices] : groups) {
+        // create a cost function, the huber loss is applied to each point inside, the factor is
+        // specialized at compile time by whether the time offset is estimated
+        ceres::CostFunction *costFunc =
+            optTO ? PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivLiDAR, true>::
+                        CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                           lossParam, TO_LkToBr)
+                  : PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivLiDAR, false>::
+                        CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                           lossParam, TO_LkToBr);
+        auto id = AddLiDARPointToSurfelResidualBlock(costFunc, nullptr, so3Meta, scaleMeta, topic,
+                                                     option);
+        if (validate) {
+            // the double-precision reference shaped the same as the evaluated one
+            ceres::CostFunction *reference =
+                optTO ? PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivLiDAR, true>::
+                            CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                               lossParam, TO_LkToBr, false)
+                      : PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivLiDAR, false>::
+                            CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                               lossParam, TO_LkToBr, false);
+            ValidateMixedPrecision(id, reference);
+            validate = false;
+        }
     }
 }
 
@@ -448,108 +490,89 @@ void Estimator::AddLiDARPointToSurfelConstraint(const PointToSurfelCorrPtr &ptsC
  * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr ]
  */
 template <TimeDeriv::ScaleSplineType type>
-void Estimator::AddRGBDPointTiSurfelConstraint(const PointToSurfelCorrPtr &ptsCorr,
+void Estimator::AddRGBDPointTiSurfelConstraint(const PointToSurfelCorrBuffer &ptsCorrs,
+                                               std::size_t idx,
                                                const std::string &topic,
                                                Opt option,
                                                double weight) {
+    const double timestamp = ptsCorrs.timestamps.at(idx);
+
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
-
-    // different relative control points finding [single vs. range]
-    if (IsOptionWith(Opt::OPT_TO_DnToBr, option)) {
-        double maxTime = ptsCorr->timestamp + Configor::Prior::TimeOffsetPadding;
-        double minTime = ptsCorr->timestamp - Configor::Prior::TimeOffsetPadding;
-
-        // invalid time stamp
-        if (!splines->TimeInRangeForSo3(minTime, Configor::Preference::SO3_SPLINE) ||
-            !splines->TimeInRangeForSo3(maxTime, Configor::Preference::SO3_SPLINE) ||
-            !splines->TimeInRangeForRd(minTime, Configor::Preference::SCALE_SPLINE) ||
-            !splines->TimeInRangeForRd(maxTime, Configor::Preference::SCALE_SPLINE)) {
-            return;
-        }
-
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{minTime, maxTime}},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{minTime, maxTime}},
-                                       scaleMeta);
-    } else {
-        double curTime = ptsCorr->timestamp + parMagr->TEMPORAL.TO_DnToBr.at(topic);
-
-        // check point time stamp
-        if (!splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE) ||
-            !splines->TimeInRangeForRd(curTime, Configor::Preference::SCALE_SPLINE)) {
-            return;
-        }
-
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{curTime, curTime}},
-                                       scaleMeta);
+    if (!CalculatePointToSurfelSplineMeta(timestamp, parMagr->TEMPORAL.TO_DnToBr.at(topic),
+                                          IsOptionWith(Opt::OPT_TO_DnToBr, option),
+                                          temporalPadding.TimeOffset(topic), so3Meta, scaleMeta)) {
+        return;
     }
-    static constexpr int derivLiDAR = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
-    // create a cost function
-    auto costFunc = PointToSurfelFactor<Configor::Prior::SplineOrder, derivLiDAR>::Create(
-        so3Meta, scaleMeta, ptsCorr, weight);
 
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
+    static constexpr int derivRGBD = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
+    // create a cost function
+    using FactorType = PointToSurfelFactor<Configor::Prior::SplineOrder, derivRGBD>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the time offset is not padded, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, timestamp,
+                                           ptsCorrs.pInScan.at(idx).cast<double>(),
+                                           ptsCorrs.SurfelOf(idx), weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, timestamp,
+                                              ptsCorrs.pInScan.at(idx).cast<double>(),
+                                              ptsCorrs.SurfelOf(idx), weight);
+        dynCostFunc->SetNumResiduals(1);
+        costFunc = dynCostFunc;
     }
 
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-
-    costFunc->SetNumResiduals(1);
-
-    // organize the param block vector
-    std::vector<double *> paramBlockVec;
-
-    // so3 knots param block
-    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
-                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
-
-    // lin acce knots
-    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
-                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
-
-    // SO3_DnToBr
-    auto SO3_DnToBr = parMagr->EXTRI.SO3_DnToBr.at(topic).data();
-    paramBlockVec.push_back(SO3_DnToBr);
-
-    // POS_DnInBr
-    auto POS_DnInBr = parMagr->EXTRI.POS_DnInBr.at(topic).data();
-    paramBlockVec.push_back(POS_DnInBr);
-
-    // TO_DnToBr
-    auto TO_DnToBr = &parMagr->TEMPORAL.TO_DnToBr.at(topic);
-    paramBlockVec.push_back(TO_DnToBr);
-
     // pass to problem
-    this->AddResidualBlock(
-        costFunc,
-        // we use 'Configor::Prior::LossForLiDARFactor' for rgbds here
-        new ceres::HuberLoss(Configor::Prior::LossForPointToSurfelFactor * weight), paramBlockVec);
-    this->SetManifold(SO3_DnToBr, QUATER_MANIFOLD.get());
-
-    if (!IsOptionWith(Opt::OPT_SO3_DnToBr, option)) {
-        this->SetParameterBlockConstant(SO3_DnToBr);
-    }
-
-    if (!IsOptionWith(Opt::OPT_POS_DnInBr, option)) {
-        this->SetParameterBlockConstant(POS_DnInBr);
-    }
+    // we use 'Configor::Prior::LossForPointToSurfelFactor' for rgbds here
+    AddRGBDPointToSurfelResidualBlock(
+        costFunc, this->HuberLoss(Configor::Prior::LossForPointToSurfelFactor * weight),
+        so3Meta, scaleMeta, topic, option);
+}
 
-    if (!IsOptionWith(Opt::OPT_TO_DnToBr, option)) {
-        this->SetParameterBlockConstant(TO_DnToBr);
-    } else {
-        // set bound
-        this->SetParameterLowerBound(TO_DnToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_DnToBr, 0, Configor::Prior::TimeOffsetPadding);
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr ]
+ */
+template <TimeDeriv::ScaleSplineType type>
+void Estimator::AddRGBDPointToSurfelConstraints(const PointToSurfelCorrBuffer &ptsCorrs,
+                                                const std::string &topic,
+                                                Opt option,
+                                                double weight) {
+    static constexpr int derivRGBD = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
+    // we use 'Configor::Prior::LossForPointToSurfelFactor' for rgbds here
+    const double lossParam = Configor::Prior::LossForPointToSurfelFactor;
+    const double TO_DnToBr = parMagr->TEMPORAL.TO_DnToBr.at(topic);
+    const bool optTO = IsOptionWith(Opt::OPT_TO_DnToBr, option);
+
+    const auto groups =
+        GroupPointToSurfelCorrs(ptsCorrs, TO_DnToBr, optTO, temporalPadding.TimeOffset(topic));
+    // the first mixed-precision block is compared against the double one if required
+    bool validate = Configor::Preference::MixedPrecisionResiduals &&
+                    Configor::Preference::ValidateMixedPrecision;
+    for (const auto &[so3Meta, scaleMeta, indices] : groups) {
+        // create a cost function, the huber loss is applied to each point inside
+        ceres::CostFunction *costFunc =
+            optTO ? PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivRGBD, true>::
+                        CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                           lossParam, TO_DnToBr)
+                  : PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivRGBD, false>::
+                        CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                           lossParam, TO_DnToBr);
+        auto id = AddRGBDPointToSurfelResidualBlock(costFunc, nullptr, so3Meta, scaleMeta, topic,
+                                                    option);
+        if (validate) {
+            // the double-precision reference shaped the same as the evaluated one
+            ceres::CostFunction *reference =
+                optTO ? PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivRGBD, true>::
+                            CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                               lossParam, TO_DnToBr, false)
+                      : PointToSurfelGroupFactor<Configor::Prior::SplineOrder, derivRGBD, false>::
+                            CreateCostFunction(so3Meta, scaleMeta, ptsCorrs, indices, weight,
+                                               lossParam, TO_DnToBr, false);
+            ValidateMixedPrecision(id, reference);
+            validate = false;
+        }
     }
 }
 
@@ -568,8 +591,8 @@ void Estimator::AddVisualReprojection(const VisualReProjCorr::Ptr &visualCorr,
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_CmToBr = &parMagr->TEMPORAL.TO_CmToBr.at(topic);
 
@@ -586,134 +609,137 @@ void Estimator::AddVisualReprojection(const VisualReProjCorr::Ptr &visualCorr,
         *TO_CmToBr, TO_PADDING, IsOptionWith(Opt::OPT_TO_CmToBr, option)  // if opt time offset
     );
 
-    if (!TimeInRangeForSplines(timePairI) || !TimeInRangeForSplines(timePairJ)) {
-        return;
-    }
-
-    if (timePairI.first < timePairJ.first) {
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePairI, timePairJ},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePairI, timePairJ},
-                                       scaleMeta);
-    } else {
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePairJ, timePairI},
-                                        so3Meta);
-        splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePairJ, timePairI},
-                                       scaleMeta);
-    }
-
-    static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
-    // create a cost function
-    auto costFunc = VisualReProjFactor<Configor::Prior::SplineOrder, deriv>::Create(
-        so3Meta, scaleMeta, visualCorr, weight);
-
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
-    }
-
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-
-    // fx, fy, cx, cy
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-
-    // global scale, inv depth
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-
-    costFunc->SetNumResiduals(2);
-
-    // organize the param block vector
-    std::vector<double *> paramBlockVec;
-
-    // so3 knots param block
-    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
-                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
-
-    // lin acce knots
-    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
-                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
-
-    auto SO3_CmToBr = parMagr->EXTRI.SO3_CmToBr.at(topic).data();
-    paramBlockVec.push_back(SO3_CmToBr);
-
-    auto POS_CmInBr = parMagr->EXTRI.POS_CmInBr.at(topic).data();
-    paramBlockVec.push_back(POS_CmInBr);
-
-    paramBlockVec.push_back(TO_CmToBr);
-    paramBlockVec.push_back(RS_READOUT);
-
-    auto &intri = parMagr->INTRI.Camera.at(topic);
-    paramBlockVec.push_back(intri->FXAddress());
-    paramBlockVec.push_back(intri->FYAddress());
-    paramBlockVec.push_back(intri->CXAddress());
-    paramBlockVec.push_back(intri->CYAddress());
-
-    paramBlockVec.push_back(globalScale);
-    paramBlockVec.push_back(invDepth);
-
-    // pass to problem
-    this->AddResidualBlock(costFunc, new ceres::CauchyLoss(Configor::Prior::LossForReprojFactor),
-                           paramBlockVec);
-    this->SetManifold(SO3_CmToBr, QUATER_MANIFOLD.get());
-
-    if (!IsOptionWith(Opt::OPT_SO3_CmToBr, option)) {
-        this->SetParameterBlockConstant(SO3_CmToBr);
-    }
-
-    if (!IsOptionWith(Opt::OPT_POS_CmInBr, option)) {
-        this->SetParameterBlockConstant(POS_CmInBr);
-    }
-
-    if (!IsOptionWith(Opt::OPT_TO_CmToBr, option)) {
-        this->SetParameterBlockConstant(TO_CmToBr);
-    } else {
-        // set bound
-        this->SetParameterLowerBound(TO_CmToBr, 0, -TO_PADDING);
-        this->SetParameterUpperBound(TO_CmToBr, 0, TO_PADDING);
+    if (!TimeInRangeForSplines(timePairI) || !TimeInRangeForSplines(timePairJ)) {
+        return;
     }
 
-    if (!IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option)) {
-        this->SetParameterBlockConstant(RS_READOUT);
+    if (timePairI.first < timePairJ.first) {
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePairI, timePairJ}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePairI, timePairJ},
+                              scaleMeta);
     } else {
-        // set bound
-        this->SetParameterLowerBound(RS_READOUT, 0, 0.0);
-        this->SetParameterUpperBound(RS_READOUT, 0, RT_PADDING);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePairJ, timePairI}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePairJ, timePairI},
+                              scaleMeta);
     }
 
-    if (!IsOptionWith(Opt::OPT_CAM_FOCAL_LEN, option)) {
-        this->SetParameterBlockConstant(intri->FXAddress());
-        this->SetParameterBlockConstant(intri->FYAddress());
+    static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
+    // create a cost function
+    using FactorType = VisualReProjFactor<Configor::Prior::SplineOrder, deriv>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the two features are in a single segment, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, visualCorr, weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, visualCorr, weight);
+        dynCostFunc->SetNumResiduals(2);
+        costFunc = dynCostFunc;
     }
 
-    if (!IsOptionWith(Opt::OPT_CAM_PRINCIPAL_POINT, option)) {
-        this->SetParameterBlockConstant(intri->CXAddress());
-        this->SetParameterBlockConstant(intri->CYAddress());
+    // pass to problem
+    AddVisualReprojResidualBlock(costFunc,
+                                 this->CauchyLoss(Configor::Prior::LossForReprojFactor),
+                                 so3Meta, scaleMeta, topic, globalScale, invDepth, option);
+}
+
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
+ * READOUT_TIME | FX | FY | CX | CY | GLOBAL_SCALE | INV_DEPTH ]
+ */
+template <TimeDeriv::ScaleSplineType type>
+void Estimator::AddVisualReprojections(const std::vector<VisualReProjCorrPtr> &visualCorrs,
+                                       const std::string &topic,
+                                       double *globalScale,
+                                       double *invDepth,
+                                       Opt option,
+                                       double weight) {
+    if (visualCorrs.empty()) {
+        return;
+    }
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
+    double RS_READOUT = parMagr->TEMPORAL.RS_READOUT.at(topic);
+    double TO_CmToBr = parMagr->TEMPORAL.TO_CmToBr.at(topic);
+    auto timeRange = [&](double timeByCam, double rdFactor) {
+        return ConsideredTimeRangeForCameraStamp(
+            timeByCam,                                           // time stamped by the camera
+            RS_READOUT, RT_PADDING, rdFactor,                    // the readout factor
+            IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option),  // if optimize rs readout time
+            TO_CmToBr, TO_PADDING, IsOptionWith(Opt::OPT_TO_CmToBr, option)  // if opt time offset
+        );
+    };
+
+    // all reprojections of a landmark start from its first observation
+    const auto &firCorr = visualCorrs.front();
+    std::pair<double, double> timePairI = timeRange(firCorr->ti, firCorr->li);
+    if (!TimeInRangeForSplines(timePairI)) {
+        return;
     }
 
-    if (!IsOptionWith(Opt::OPT_VISUAL_GLOBAL_SCALE, option)) {
-        this->SetParameterBlockConstant(globalScale);
-    } else {
-        // set bound
-        this->SetParameterLowerBound(globalScale, 0, 1E-3);
+    /**
+     * the residual block involves all knots between the first observation and the batched ones,
+     * observations far from the first one are added separately, as the dimension of the block
+     * (and the cost of the automatic differentiation) grows with the time span
+     */
+    const double span = (Configor::Prior::SplineOrder - 1) *
+                        std::min(Configor::Prior::KnotTimeDist::SO3Spline,
+                                 Configor::Prior::KnotTimeDist::ScaleSpline);
+    std::vector<VisualReProjCorrPtr> batchCorrs;
+    std::vector<double> batchWeights;
+    std::pair<double, double> batchRange = timePairI;
+    for (const auto &corr : visualCorrs) {
+        std::pair<double, double> timePairJ = timeRange(corr->tj, corr->lj);
+        if (timePairJ.first < timePairI.first - span ||
+            timePairJ.second > timePairI.second + span) {
+            AddVisualReprojection<type>(corr, topic, globalScale, invDepth, option,
+                                        weight * corr->weight);
+            continue;
+        }
+        if (!TimeInRangeForSplines(timePairJ)) {
+            continue;
+        }
+        batchCorrs.push_back(corr);
+        batchWeights.push_back(weight * corr->weight);
+        batchRange.first = std::min(batchRange.first, timePairJ.first);
+        batchRange.second = std::max(batchRange.second, timePairJ.second);
+    }
+    if (batchCorrs.empty()) {
+        return;
     }
 
-    if (!IsOptionWith(Opt::OPT_VISUAL_DEPTH, option)) {
-        this->SetParameterBlockConstant(invDepth);
+    SplineMetaType so3Meta, scaleMeta;
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {batchRange}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {batchRange}, scaleMeta);
+
+    static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
+    /**
+     * create a cost function, the cauchy loss is applied to each reprojection inside. The factor is
+     * specialized at compile time by whether any temporal parameter (the time offset or the
+     * readout time) is estimated
+     */
+    const int numResiduals = 2 * static_cast<int>(batchCorrs.size());
+    const double lossParam = Configor::Prior::LossForReprojFactor;
+    ceres::CostFunction *costFunc;
+    if (IsOptionWith(Opt::OPT_TO_CmToBr, option) ||
+        IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option)) {
+        using FactorType = VisualReProjSeqFactor<Configor::Prior::SplineOrder, deriv, true>;
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, batchCorrs, batchWeights,
+                                              lossParam, TO_CmToBr, RS_READOUT);
+        dynCostFunc->SetNumResiduals(numResiduals);
+        costFunc = dynCostFunc;
     } else {
-        // set bound
-        this->SetParameterLowerBound(invDepth, 0, 1E-3);
+        using FactorType = VisualReProjSeqFactor<Configor::Prior::SplineOrder, deriv, false>;
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, batchCorrs, batchWeights,
+                                              lossParam, TO_CmToBr, RS_READOUT);
+        dynCostFunc->SetNumResiduals(numResiduals);
+        costFunc = dynCostFunc;
     }
+
+    // pass to problem
+    AddVisualReprojResidualBlock(costFunc, nullptr, so3Meta, scaleMeta, topic, globalScale,
+                                 invDepth, option);
 }
 
 /**
@@ -732,8 +758,8 @@ void Estimator::AddRGBDOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCorr,
         return;
     }
 
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_DnToBr = &parMagr->TEMPORAL.TO_DnToBr.at(topic);
 
@@ -756,39 +782,46 @@ void Estimator::AddRGBDOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCorr,
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
 
     static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
     // create a cost function
-    auto costFunc =
-        VisualOpticalFlowFactor<Configor::Prior::SplineOrder, deriv, IsInvDepth>::Create(
-            so3Meta, scaleMeta, ofCorr, weight);
+    using FactorType = VisualOpticalFlowFactor<Configor::Prior::SplineOrder, deriv, IsInvDepth>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the mid feature is in a single segment, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, ofCorr, weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, ofCorr, weight);
 
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
-    }
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
 
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(4);
+        dynCostFunc->AddParameterBlock(3);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // fx, fy, cx, cy
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        // fx, fy, cx, cy
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // depth
-    costFunc->AddParameterBlock(1);
+        // depth
+        dynCostFunc->AddParameterBlock(1);
 
-    costFunc->SetNumResiduals(2);
+        dynCostFunc->SetNumResiduals(2);
+        costFunc = dynCostFunc;
+    }
 
     // organize the param block vector
     std::vector<double *> paramBlockVec;
@@ -823,7 +856,7 @@ void Estimator::AddRGBDOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCorr,
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_DnToBr, QUATER_MANIFOLD.get());
 
@@ -889,8 +922,8 @@ void Estimator::AddVisualOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCor
     }
 
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_CmToBr = &parMagr->TEMPORAL.TO_CmToBr.at(topic);
 
@@ -913,39 +946,46 @@ void Estimator::AddVisualOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCor
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
 
     static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
     // create a cost function
-    auto costFunc =
-        VisualOpticalFlowFactor<Configor::Prior::SplineOrder, deriv, IsInvDepth>::Create(
-            so3Meta, scaleMeta, ofCorr, weight);
+    using FactorType = VisualOpticalFlowFactor<Configor::Prior::SplineOrder, deriv, IsInvDepth>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the mid feature is in a single segment, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, ofCorr, weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, ofCorr, weight);
 
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
-    }
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
 
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(4);
+        dynCostFunc->AddParameterBlock(3);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // fx, fy, cx, cy
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        // fx, fy, cx, cy
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // alpha, beta, depth
-    costFunc->AddParameterBlock(1);
+        // alpha, beta, depth
+        dynCostFunc->AddParameterBlock(1);
 
-    costFunc->SetNumResiduals(2);
+        dynCostFunc->SetNumResiduals(2);
+        costFunc = dynCostFunc;
+    }
 
     // organize the param block vector
     std::vector<double *> paramBlockVec;
@@ -980,7 +1020,7 @@ void Estimator::AddVisualOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCor
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_CmToBr, QUATER_MANIFOLD.get());
 
@@ -1043,8 +1083,8 @@ void Estimator::AddEventOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCorr
     }
 
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_EsToBr = &parMagr->TEMPORAL.TO_EsToBr.at(topic);
 
@@ -1067,39 +1107,46 @@ void Estimator::AddEventOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCorr
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
 
     static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
     // create a cost function
-    auto costFunc =
-        VisualOpticalFlowFactor<Configor::Prior::SplineOrder, deriv, IsInvDepth>::Create(
-            so3Meta, scaleMeta, ofCorr, weight);
+    using FactorType = VisualOpticalFlowFactor<Configor::Prior::SplineOrder, deriv, IsInvDepth>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the mid feature is in a single segment, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, ofCorr, weight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, ofCorr, weight);
 
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
-    }
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
 
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(4);
+        dynCostFunc->AddParameterBlock(3);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // fx, fy, cx, cy
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        // fx, fy, cx, cy
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // alpha, beta, depth
-    costFunc->AddParameterBlock(1);
+        // alpha, beta, depth
+        dynCostFunc->AddParameterBlock(1);
 
-    costFunc->SetNumResiduals(2);
+        dynCostFunc->SetNumResiduals(2);
+        costFunc = dynCostFunc;
+    }
 
     // organize the param block vector
     std::vector<double *> paramBlockVec;
@@ -1134,7 +1181,7 @@ void Estimator::AddEventOpticalFlowConstraint(const OpticalFlowCorr::Ptr &ofCorr
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_EsToBr, QUATER_MANIFOLD.get());
 
@@ -1192,8 +1239,8 @@ void Estimator::AddEventOpticalFlowConstraint(const OpticalFlowCurveCorr::Ptr &f
     }
 
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *TO_EsToBr = &parMagr->TEMPORAL.TO_EsToBr.at(topic);
 
     if (auto vel = ftm->trace->VelocityAt(ftm->midTime);
@@ -1216,8 +1263,8 @@ void Estimator::AddEventOpticalFlowConstraint(const OpticalFlowCurveCorr::Ptr &f
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {timePair}, scaleMeta);
 
     static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
 
@@ -1288,7 +1335,7 @@ void Estimator::AddEventOpticalFlowConstraint(const OpticalFlowCurveCorr::Ptr &f
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_EsToBr, QUATER_MANIFOLD.get());
 
@@ -1349,8 +1396,8 @@ void Estimator::AddVisualOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &o
     }
 
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_CmToBr = &parMagr->TEMPORAL.TO_CmToBr.at(topic);
 
@@ -1385,10 +1432,10 @@ void Estimator::AddVisualOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &o
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                    {timePairFir, timePairMid, timePairLast}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
-                                   {timePairFir, timePairMid, timePairLast}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                           {timePairFir, timePairMid, timePairLast}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
+                          {timePairFir, timePairMid, timePairLast}, scaleMeta);
 
     // create a cost function
     ceres::DynamicCostFunction *costFunc;
@@ -1465,7 +1512,7 @@ void Estimator::AddVisualOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &o
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForReprojFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForReprojFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_CmToBr, QUATER_MANIFOLD.get());
 
@@ -1523,8 +1570,8 @@ void Estimator::AddVisualPPPTrifocalTensorFactorForVelCam(const OpticalFlowCorrP
     }
 
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_CmToBr = &parMagr->TEMPORAL.TO_CmToBr.at(topic);
 
@@ -1559,49 +1606,51 @@ void Estimator::AddVisualPPPTrifocalTensorFactorForVelCam(const OpticalFlowCorrP
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                    {timePairFir, timePairMid, timePairLast}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
-                                   {timePairFir, timePairMid, timePairLast}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                           {timePairFir, timePairMid, timePairLast}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
+                          {timePairFir, timePairMid, timePairLast}, scaleMeta);
 
     // create a cost function
-    ceres::DynamicCostFunction *costFunc;
-
-    if (type == TimeDeriv::ScaleSplineType::LIN_POS_SPLINE) {
-        static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>();
-        costFunc = PPPTrifocalTensorFactor<Configor::Prior::SplineOrder, deriv, true>::Create(
-            so3Meta, scaleMeta, ofCorr, weight);
-    } else if (type == TimeDeriv::ScaleSplineType::LIN_VEL_SPLINE) {
-        static constexpr int deriv = TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
-        costFunc = PPPTrifocalTensorFactor<Configor::Prior::SplineOrder, deriv, false>::Create(
-            so3Meta, scaleMeta, ofCorr, weight);
+    static_assert(type == TimeDeriv::LIN_POS_SPLINE || type == TimeDeriv::LIN_VEL_SPLINE,
+                  "only 'LIN_POS_SPLINE' and 'LIN_VEL_SPLINE' is supported in "
+                  "'AddVisualPPPTrifocalTensorFactorForVelCam'");
+    static constexpr bool TruePosFalseVel = type == TimeDeriv::LIN_POS_SPLINE;
+    static constexpr int deriv = TruePosFalseVel ? TimeDeriv::Deriv<type, TimeDeriv::LIN_POS>()
+                                                 : TimeDeriv::Deriv<type, TimeDeriv::LIN_VEL>();
+    using FactorType =
+        PPPTrifocalTensorFactor<Configor::Prior::SplineOrder, deriv, TruePosFalseVel>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the three features are in a single segment, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, ofCorr, weight);
     } else {
-        throw Status(Status::CRITICAL,
-                     "only 'LIN_POS_SPLINE' and 'LIN_VEL_SPLINE' is supported in "
-                     "'AddVisualOpticalFlowReprojConstraint'");
-    }
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, ofCorr, weight);
 
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
-    }
-    // pos knots param block [each has three sub params]
-    for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(3);
-    }
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
 
-    costFunc->AddParameterBlock(4);
-    costFunc->AddParameterBlock(3);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(4);
+        dynCostFunc->AddParameterBlock(3);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // fx, fy, cx, cy
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
-    costFunc->AddParameterBlock(1);
+        // fx, fy, cx, cy
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    costFunc->SetNumResiduals(4);
+        dynCostFunc->SetNumResiduals(4);
+        costFunc = dynCostFunc;
+    }
 
     // organize the param block vector
     std::vector<double *> paramBlockVec;
@@ -1683,8 +1732,8 @@ void Estimator::AddRGBDOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &ofC
     }
 
     auto &intri = parMagr->INTRI.RGBD.at(topic)->intri;
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
     double *TO_DnToBr = &parMagr->TEMPORAL.TO_DnToBr.at(topic);
 
@@ -1720,10 +1769,10 @@ void Estimator::AddRGBDOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &ofC
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                    {timePairFir, timePairMid, timePairLast}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
-                                   {timePairFir, timePairMid, timePairLast}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                           {timePairFir, timePairMid, timePairLast}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
+                          {timePairFir, timePairMid, timePairLast}, scaleMeta);
 
     // create a cost function
     ceres::DynamicCostFunction *costFunc;
@@ -1799,7 +1848,7 @@ void Estimator::AddRGBDOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &ofC
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForReprojFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForReprojFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_DnToBr, QUATER_MANIFOLD.get());
 
@@ -1846,6 +1895,225 @@ void Estimator::AddRGBDOpticalFlowReprojConstraint(const OpticalFlowCorrPtr &ofC
     }
 }
 
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
+ *   READOUT_TIME | FX | FY | CX | CY | DEPTH ]
+ */
+template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+void Estimator::AddVisualOpticalFlowFusedConstraint(const OpticalFlowCorrPtr &ofCorr,
+                                                    const std::string &topic,
+                                                    Opt option,
+                                                    double flowWeight,
+                                                    double reprojWeight,
+                                                    double trifocalWeight) {
+    // invalid depth
+    if (ofCorr->depth < 1E-3) {
+        return;
+    }
+    auto &intri = parMagr->INTRI.Camera.at(topic);
+    bool added = AddOpticalFlowFusedResidualBlock<type, IsInvDepth>(
+        ofCorr, topic, intri, parMagr->EXTRI.SO3_CmToBr.at(topic).data(),
+        parMagr->EXTRI.POS_CmInBr.at(topic).data(), &parMagr->TEMPORAL.TO_CmToBr.at(topic),
+        &parMagr->TEMPORAL.RS_READOUT.at(topic), option, Opt::OPT_SO3_CmToBr, Opt::OPT_POS_CmInBr,
+        Opt::OPT_TO_CmToBr, flowWeight, reprojWeight, trifocalWeight);
+    if (!added) {
+        // the first or last feature is out of the range of splines, only the optical flow remains
+        AddVisualOpticalFlowConstraint<type, IsInvDepth>(ofCorr, topic, option, flowWeight);
+    }
+}
+
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_DnToBr | POS_DnInBr | TO_DnToBr |
+ *   READOUT_TIME | FX | FY | CX | CY | DEPTH ]
+ */
+template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+void Estimator::AddRGBDOpticalFlowFusedConstraint(const OpticalFlowCorrPtr &ofCorr,
+                                                  const std::string &topic,
+                                                  Opt option,
+                                                  double flowWeight,
+                                                  double reprojWeight,
+                                                  double trifocalWeight) {
+    // invalid depth
+    if (parMagr->INTRI.RGBD.at(topic)->ActualDepth(ofCorr->depth) < 1E-3) {
+        return;
+    }
+    auto &intri = parMagr->INTRI.RGBD.at(topic)->intri;
+    bool added = AddOpticalFlowFusedResidualBlock<type, IsInvDepth>(
+        ofCorr, topic, intri, parMagr->EXTRI.SO3_DnToBr.at(topic).data(),
+        parMagr->EXTRI.POS_DnInBr.at(topic).data(), &parMagr->TEMPORAL.TO_DnToBr.at(topic),
+        &parMagr->TEMPORAL.RS_READOUT.at(topic), option, Opt::OPT_SO3_DnToBr, Opt::OPT_POS_DnInBr,
+        Opt::OPT_TO_DnToBr, flowWeight, reprojWeight, trifocalWeight);
+    if (!added) {
+        // the first or last feature is out of the range of splines, only the optical flow remains
+        AddRGBDOpticalFlowConstraint<type, IsInvDepth>(ofCorr, topic, option, flowWeight);
+    }
+}
+
+template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+bool Estimator::AddOpticalFlowFusedResidualBlock(const OpticalFlowCorrPtr &ofCorr,
+                                                 const std::string &topic,
+                                                 const ns_veta::PinholeIntrinsic::Ptr &intri,
+                                                 double *SO3_SenToBr,
+                                                 double *POS_SenInBr,
+                                                 double *TO_SenToBr,
+                                                 double *RS_READOUT,
+                                                 Opt option,
+                                                 Opt optSO3,
+                                                 Opt optPOS,
+                                                 Opt optTO,
+                                                 double flowWeight,
+                                                 double reprojWeight,
+                                                 double trifocalWeight) {
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
+
+    if (ofCorr->MidPointVel(*RS_READOUT).norm() < Configor::Prior::LossForOpticalFlowFactor) {
+        // small pixel velocity, neither of the two factors is added
+        return true;
+    }
+
+    std::array<std::pair<double, double>, 3> timePairs;
+    for (int i = 0; i < 3; ++i) {
+        timePairs.at(i) = ConsideredTimeRangeForCameraStamp(
+            ofCorr->timeAry.at(i),                               // time stamped by the camera
+            *RS_READOUT, RT_PADDING, ofCorr->rdFactorAry.at(i),  // the readout factor
+            IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option),  // if optimize rs readout time
+            *TO_SenToBr, TO_PADDING, IsOptionWith(optTO, option)  // if opt time offset
+        );
+        if (!TimeInRangeForSplines(timePairs.at(i))) {
+            return false;
+        }
+    }
+
+    // prepare metas for splines
+    SplineMetaType so3Meta, scaleMeta;
+
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                           {timePairs.at(0), timePairs.at(1), timePairs.at(2)}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
+                          {timePairs.at(0), timePairs.at(1), timePairs.at(2)}, scaleMeta);
+
+    // create a cost function
+    static_assert(type == TimeDeriv::LIN_POS_SPLINE || type == TimeDeriv::LIN_VEL_SPLINE,
+                  "only 'LIN_POS_SPLINE' and 'LIN_VEL_SPLINE' is supported in "
+                  "'AddOpticalFlowFusedResidualBlock'");
+    using FactorType = VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, IsInvDepth,
+                                                    type == TimeDeriv::LIN_POS_SPLINE>;
+    ceres::CostFunction *costFunc;
+    if (so3Meta.NumParameters() == Configor::Prior::SplineOrder &&
+        scaleMeta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the three features are in a single segment, the fixed-size cost function is much faster
+        costFunc = FactorType::CreateSized(so3Meta, scaleMeta, ofCorr, flowWeight, reprojWeight,
+                                           trifocalWeight);
+    } else {
+        auto dynCostFunc = FactorType::Create(so3Meta, scaleMeta, ofCorr, flowWeight, reprojWeight,
+                                              trifocalWeight);
+
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
+
+        dynCostFunc->AddParameterBlock(4);
+        dynCostFunc->AddParameterBlock(3);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+
+        // fx, fy, cx, cy
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+
+        // depth
+        dynCostFunc->AddParameterBlock(1);
+
+        // optical flow (2), reprojection (4) and trifocal tensor (4, optional)
+        dynCostFunc->SetNumResiduals(FactorType::NumResiduals(trifocalWeight));
+        costFunc = dynCostFunc;
+    }
+
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    // lin acce knots
+    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
+                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+
+    paramBlockVec.push_back(SO3_SenToBr);
+    paramBlockVec.push_back(POS_SenInBr);
+    paramBlockVec.push_back(TO_SenToBr);
+    paramBlockVec.push_back(RS_READOUT);
+
+    paramBlockVec.push_back(intri->FXAddress());
+    paramBlockVec.push_back(intri->FYAddress());
+    paramBlockVec.push_back(intri->CXAddress());
+    paramBlockVec.push_back(intri->CYAddress());
+
+    if constexpr (IsInvDepth) {
+        paramBlockVec.push_back(&ofCorr->invDepth);
+    } else {
+        paramBlockVec.push_back(&ofCorr->depth);
+    }
+
+    // pass to problem, losses of the two residual groups are applied in the factor
+    this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
+    this->SetManifold(SO3_SenToBr, QUATER_MANIFOLD.get());
+
+    if (!IsOptionWith(optSO3, option)) {
+        this->SetParameterBlockConstant(SO3_SenToBr);
+    }
+
+    if (!IsOptionWith(optPOS, option)) {
+        this->SetParameterBlockConstant(POS_SenInBr);
+    }
+
+    if (!IsOptionWith(optTO, option)) {
+        this->SetParameterBlockConstant(TO_SenToBr);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TO_SenToBr, 0, -TO_PADDING);
+        this->SetParameterUpperBound(TO_SenToBr, 0, TO_PADDING);
+    }
+
+    if (!IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option)) {
+        this->SetParameterBlockConstant(RS_READOUT);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(RS_READOUT, 0, 0.0);
+        this->SetParameterUpperBound(RS_READOUT, 0, RT_PADDING);
+    }
+
+    if (!IsOptionWith(Opt::OPT_CAM_FOCAL_LEN, option)) {
+        this->SetParameterBlockConstant(intri->FXAddress());
+        this->SetParameterBlockConstant(intri->FYAddress());
+    }
+
+    if (!IsOptionWith(Opt::OPT_CAM_PRINCIPAL_POINT, option)) {
+        this->SetParameterBlockConstant(intri->CXAddress());
+        this->SetParameterBlockConstant(intri->CYAddress());
+    }
+
+    if (!IsOptionWith(Opt::OPT_VISUAL_DEPTH, option)) {
+        if constexpr (IsInvDepth) {
+            this->SetParameterBlockConstant(&ofCorr->invDepth);
+        } else {
+            this->SetParameterBlockConstant(&ofCorr->depth);
+        }
+    }
+    return true;
+}
+
 /**
  * param blocks:
  * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
@@ -1862,8 +2130,8 @@ void Estimator::AddEventOpticalFlowReprojConstraint(const OpticalFlowCurveCorrPt
     }
 
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *TO_EsToBr = &parMagr->TEMPORAL.TO_EsToBr.at(topic);
 
     if (auto vel = ftm->trace->VelocityAt(ftm->midTime);
@@ -1898,10 +2166,10 @@ void Estimator::AddEventOpticalFlowReprojConstraint(const OpticalFlowCurveCorrPt
     // prepare metas for splines
     SplineMetaType so3Meta, scaleMeta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                    {timePairFir, timePairMid, timePairLast}, so3Meta);
-    splines->CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
-                                   {timePairFir, timePairMid, timePairLast}, scaleMeta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                           {timePairFir, timePairMid, timePairLast}, so3Meta);
+    CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE,
+                          {timePairFir, timePairMid, timePairLast}, scaleMeta);
 
     // create a cost function
     ceres::DynamicCostFunction *costFunc;
@@ -1981,7 +2249,7 @@ void Estimator::AddEventOpticalFlowReprojConstraint(const OpticalFlowCurveCorrPt
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForReprojFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForReprojFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_EsToBr, QUATER_MANIFOLD.get());
 
@@ -0,0 +1,90 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_FACTOR_ARENA_H
+#define IKALIBR_FACTOR_ARENA_H
+
+#include "ceres/cost_function.h"
+#include "ceres/loss_function.h"
+#include "util/utils.h"
+#include "map"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the storage of cost functions and loss functions of a problem which does not take their
+ * ownership (see 'Estimator::DefaultProblemOptions'). Cost functions are adopted and released in
+ * bulk with the arena, and the problem skips its per-residual ownership bookkeeping. Loss functions
+ * of the same kind and parameter are shared by residual blocks, rather than allocated for each one
+ */
+class FactorArena {
+public:
+    using Ptr = std::shared_ptr<FactorArena>;
+
+    enum class LossKind : int { HUBER, CAUCHY };
+
+private:
+    std::vector<std::unique_ptr<ceres::CostFunction>> _costFunctions;
+    std::map<std::pair<LossKind, double>, std::unique_ptr<ceres::LossFunction>> _lossFunctions;
+
+public:
+    FactorArena() = default;
+
+    FactorArena(const FactorArena &) = delete;
+
+    FactorArena &operator=(const FactorArena &) = delete;
+
+    static Ptr Create();
+
+    // the arena takes the ownership of the cost function, which is returned
+    ceres::CostFunction *Adopt(ceres::CostFunction *costFunc);
+
+    // the shared loss function of the given kind and parameter, owned by the arena
+    ceres::LossFunction *Loss(LossKind kind, double param);
+
+    [[nodiscard]] std::size_t CostFunctionCount() const;
+
+    [[nodiscard]] std::size_t LossFunctionCount() const;
+
+    // create a loss function of the given kind and parameter, whose ownership is not kept
+    static ceres::LossFunction *CreateLoss(LossKind kind, double param);
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_FACTOR_ARENA_H
@@ -0,0 +1,138 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_FACTOR_PROFILER_H
+#define IKALIBR_FACTOR_PROFILER_H
+
+#include "ceres/ceres.h"
+#include "util/utils.h"
+#include "atomic"
+#include "typeinfo"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief an opt-in instrumentation of residual evaluations in the estimator. Cost functions are
+ * wrapped when added to the problem, and evaluation counts and time are accumulated for each factor
+ * type (the type of the cost function, i.e., the factor functor it wraps). Residual-only
+ * evaluations (line searches, cost checks) and jacobian evaluations are counted separately.
+ */
+class FactorProfiler {
+public:
+    using Ptr = std::shared_ptr<FactorProfiler>;
+
+    struct Record {
+    public:
+        using Ptr = std::shared_ptr<Record>;
+
+    public:
+        std::string name;
+        // the number of residual blocks of this type in the problem
+        std::atomic<std::int64_t> residualBlocks{};
+        // the memory (in bytes) of jacobians of all residual blocks of this type
+        std::atomic<std::int64_t> jacobianBytes{};
+
+        std::atomic<std::uint64_t> residualEvals{}, residualNanos{};
+        std::atomic<std::uint64_t> jacobianEvals{}, jacobianNanos{};
+
+    public:
+        explicit Record(std::string name);
+
+        [[nodiscard]] double ResidualTime() const;
+
+        [[nodiscard]] double JacobianTime() const;
+    };
+
+private:
+    // type hash code, record
+    std::map<std::size_t, Record::Ptr> _records;
+
+public:
+    FactorProfiler() = default;
+
+    static Ptr Create();
+
+    /**
+     * wrap the cost function to profile its evaluations. If 'ownCostFunc' is true, the wrapped
+     * cost function would be deleted with the wrapper, just like the problem does
+     */
+    ceres::CostFunction *Wrap(ceres::CostFunction *costFunc, bool ownCostFunc);
+
+    // clear the accumulated evaluation counts and time, e.g., before a new solving
+    void ResetEvaluations();
+
+    // the summary table, factor types are sorted by the total evaluation time
+    [[nodiscard]] std::string Summary() const;
+
+    bool SaveToCSV(const std::string &filename) const;
+
+    // the readable name of the factor type, e.g., 'IMUGyroFactor<4>' for its autodiff functions
+    static std::string FactorName(const std::type_info &info);
+
+protected:
+    [[nodiscard]] std::vector<Record::Ptr> SortedRecords() const;
+};
+
+/**
+ * @brief the cost function wrapper that profiles the evaluations of the wrapped one
+ */
+class ProfiledCostFunction : public ceres::CostFunction {
+private:
+    ceres::CostFunction *_costFunc;
+    bool _ownCostFunc;
+    FactorProfiler::Record::Ptr _record;
+
+public:
+    ProfiledCostFunction(ceres::CostFunction *costFunc,
+                         bool ownCostFunc,
+                         FactorProfiler::Record::Ptr record);
+
+    ~ProfiledCostFunction() override;
+
+    bool Evaluate(double const *const *parameters,
+                  double *residuals,
+                  double **jacobians) const override;
+
+    [[nodiscard]] std::int64_t JacobianBytes() const;
+
+    [[nodiscard]] const ceres::CostFunction *GetWrapped() const { return _costFunc; }
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_FACTOR_PROFILER_H
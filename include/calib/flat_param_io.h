@@ -0,0 +1,99 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_FLAT_PARAM_IO_H
+#define IKALIBR_FLAT_PARAM_IO_H
+
+#include "config/configor.h"
+#include "ctraj/core/spline_bundle.h"
+#include "util/utils.h"
+#include "cstdint"
+#include "string"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+struct CalibParamManager;
+using CalibParamManagerPtr = std::shared_ptr<CalibParamManager>;
+
+/**
+ * a versioned flat binary layout of the estimated parameters and spline knots, which is written
+ * by copying parameter blocks, and loaded by memory-mapping the file and copying the blocks back,
+ * i.e., without parsing as cereal archives do. The layout (little-endian, 8-byte aligned):
+ *   header: magic 'IKFLATPM', uint32 version, uint32 kind, uint64 entry count
+ *   entry:  uint32 name length, uint32 value count, name (zero padded to 8 bytes), float64 values
+ * parameters are stored as named blocks (e.g., 'SO3_BiToBr:/imu0/frame'), thus they are only
+ * loaded to parameter managers of the same sensor suite, where the camera models (and distortions),
+ * which are not estimated, are kept. Splines are stored as their time ranges and knots
+ */
+class FlatParamIO {
+public:
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+
+    enum class Kind : std::uint32_t { PARAMS = 1, SPLINES = 2 };
+
+    constexpr static std::uint32_t VERSION = 1;
+    // the extension of flat files, which are recognized when warm-starting
+    static const std::string EXTENSION;
+
+public:
+    // the flat layout of parameters in the memory, e.g., for snapshots
+    static std::string SerializeParams(const CalibParamManagerPtr &parMagr);
+
+    // the parameter blocks are copied in place, an exception is thrown if layouts are different
+    static void DeserializeParams(const std::string &bytes, const CalibParamManagerPtr &parMagr);
+
+    static bool SaveParams(const CalibParamManagerPtr &parMagr, const std::string &filename);
+
+    // the file is memory-mapped, see 'DeserializeParams'
+    static void LoadParams(const std::string &filename, const CalibParamManagerPtr &parMagr);
+
+    static bool SaveSplines(const SplineBundleType::Ptr &splines, const std::string &filename);
+
+    // splines are recreated from their time ranges, and knots are copied from the mapped file
+    static SplineBundleType::Ptr LoadSplines(const std::string &filename);
+
+    // whether the file is a flat one, i.e., starts with the magic header
+    static bool IsFlatFile(const std::string &filename);
+
+protected:
+    static std::string MagicHeader();
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_FLAT_PARAM_IO_H
@@ -0,0 +1,96 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_IMU_EXCITATION_H
+#define IKALIBR_IMU_EXCITATION_H
+
+#include "sensor/imu.h"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the motion excitation of imu measurements in consecutive time windows. A window is scored
+ * by its angular energy (the rms of angular velocities), and its linear energy (the standard
+ * deviation of specific forces, where the constant gravity is removed). Windows of stationary
+ * periods (e.g., a parked vehicle) are scored nearly zero on both, and provide little information
+ * for spatiotemporal calibration
+ */
+class IMUExcitation {
+public:
+    struct Window {
+        double begTime;
+        double endTime;
+        // unit: rad/s
+        double angularScore;
+        // unit: m/s^2
+        double linearScore;
+        int mesCount;
+
+        [[nodiscard]] bool IsExcited(double angularThd, double linearThd) const {
+            return angularScore > angularThd || linearScore > linearThd;
+        }
+    };
+
+    // a time range [first, second]
+    using Segment = std::pair<double, double>;
+
+public:
+    /**
+     * score windows of length 'windowLength' (seconds) in parallel, measurements should be
+     * ordered by time. Windows with less than 'MinMesCount' measurements are scored zero
+     */
+    static std::vector<Window> Evaluate(const std::vector<IMUFrame::Ptr> &mes,
+                                        double windowLength);
+
+    /**
+     * time ranges of excited windows, each is extended by 'padding' on both sides (to keep the
+     * observability of time offsets), and gaps shorter than 'mergeGap' are bridged
+     */
+    static std::vector<Segment> ExcitedSegments(const std::vector<Window> &windows,
+                                                double angularThd,
+                                                double linearThd,
+                                                double padding,
+                                                double mergeGap);
+
+    constexpr static int MinMesCount = 5;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_IMU_EXCITATION_H
@@ -0,0 +1,116 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_INERTIAL_PREINTEGRATION_H
+#define IKALIBR_INERTIAL_PREINTEGRATION_H
+
+#include "config/configor.h"
+#include "ctraj/core/spline_bundle.h"
+#include "sensor/imu.h"
+#include "util/utils.h"
+#include "optional"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the preintegration table of an imu for inertial alignments. Inertial alignments integrate
+ * the accelerations (rotated by the so3 spline) and the rotation terms over the imu frames between
+ * two sensor frames, where windows of neighboring alignments overlap with each other. Here the
+ * trapezoidal integrations are organized as prefix sums over all frames of the imu, thus any
+ * interval could be answered in O(1) (plus a binary search). The table holds for the so3 spline,
+ * the extrinsic rotation, and the time offset when it is built, see 'Matches'.
+ */
+class InertialPreintegration {
+public:
+    using Ptr = std::shared_ptr<InertialPreintegration>;
+    using So3SplineType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>::So3SplineType;
+    using VecMatPair = std::pair<Eigen::Vector3d, Eigen::Matrix3d>;
+
+private:
+    // identity of the imu frames the table is built from
+    const IMUFrame::Ptr *_frames;
+    std::size_t _frameCount;
+    Sophus::SO3d _SO3_BiToBr;
+    double _TO_BiToBr;
+
+    // time stamps (by the imu) of frames that are in the range of the so3 spline
+    std::vector<double> _timeByBi;
+    // prefix sums of the once integration, the k-th one integrates from frame 0 to frame k
+    std::vector<Eigen::Vector3d> _vecOnce;
+    std::vector<Eigen::Matrix3d> _matOnce;
+    // mid time of each two neighboring frames, where the once integration is sampled for the twice
+    std::vector<double> _midTimeByBr;
+    // prefix sums of the twice integration over the mid times
+    std::vector<Eigen::Vector3d> _vecTwice;
+    std::vector<Eigen::Matrix3d> _matTwice;
+
+public:
+    InertialPreintegration(const std::vector<IMUFrame::Ptr> &frames,
+                           const So3SplineType &so3Spline,
+                           const Sophus::SO3d &SO3_BiToBr,
+                           double TO_BiToBr);
+
+    static Ptr Create(const std::vector<IMUFrame::Ptr> &frames,
+                      const So3SplineType &so3Spline,
+                      const Sophus::SO3d &SO3_BiToBr,
+                      double TO_BiToBr);
+
+    // whether this table is built from the given frames, extrinsic rotation, and time offset
+    [[nodiscard]] bool Matches(const std::vector<IMUFrame::Ptr> &frames,
+                               const Sophus::SO3d &SO3_BiToBr,
+                               double TO_BiToBr) const;
+
+    // the once integration of frames in (sTimeByBi, eTimeByBi), empty if less than two frames
+    [[nodiscard]] std::optional<VecMatPair> VelIntegration(double sTimeByBi,
+                                                           double eTimeByBi) const;
+
+    // the once and twice integrations of frames in (sTimeByBi, eTimeByBi)
+    [[nodiscard]] std::optional<std::pair<VecMatPair, VecMatPair>> PosIntegration(
+        double sTimeByBi, double eTimeByBi) const;
+
+    [[nodiscard]] std::size_t Size() const;
+
+protected:
+    // the index range [sIdx, eIdx) of frames in (sTimeByBi, eTimeByBi)
+    [[nodiscard]] std::pair<std::size_t, std::size_t> FrameIndexRange(double sTimeByBi,
+                                                                      double eTimeByBi) const;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_INERTIAL_PREINTEGRATION_H
@@ -0,0 +1,94 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_LINEAR_SCALE_FITTER_H
+#define IKALIBR_LINEAR_SCALE_FITTER_H
+
+#include "config/configor.h"
+#include "optional"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief closed-form fitting of a uniform (linear) scale spline, whose knots enter constraints
+ * on its values and time derivatives linearly. Constraints are isotropic, thus the three axes
+ * share one scalar normal matrix, which is banded (the bandwidth is the spline order) as each
+ * constraint involves 'Order' consecutive knots only. It is solved by a banded cholesky
+ * decomposition in 'O(knots * Order^2)'
+ */
+class LinearScaleFitter {
+public:
+    using Ptr = std::shared_ptr<LinearScaleFitter>;
+    constexpr static int Order = Configor::Prior::SplineOrder;
+
+private:
+    double _minTime, _maxTime, _dtInv;
+    int _knotCount;
+    // the lower band of the normal matrix: '_band(i, k) = H(i, i - k)', k in [0, Order)
+    Eigen::MatrixXd _band;
+    Eigen::MatrixX3d _rhs;
+    std::size_t _count;
+
+public:
+    // the time range and the knot count of the spline to fit
+    LinearScaleFitter(double minTime, double maxTime, int knotCount);
+
+    static Ptr Create(double minTime, double maxTime, int knotCount);
+
+    /**
+     * the 'deriv'-th time derivative of the spline at 'time' should be 'value', returns false if
+     * the time is out of the time range of the spline
+     */
+    bool AddConstraint(double time, int deriv, const Eigen::Vector3d &value, double weight);
+
+    /**
+     * solve knots, a slight damping is added for knots without constraints (they are solved as
+     * zero). Nothing returned if the normal matrix is not positive definite
+     */
+    [[nodiscard]] std::optional<std::vector<Eigen::Vector3d>> Solve(double damping = 1E-6) const;
+
+    [[nodiscard]] std::size_t ConstraintCount() const;
+
+protected:
+    // time derivatives of basis functions of the uniform b-spline at normalized time 'u'
+    [[nodiscard]] Eigen::Vector4d BasisCoeff(double u, int deriv) const;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_LINEAR_SCALE_FITTER_H
@@ -0,0 +1,119 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_LIVE_TOPIC_RECORDER_H
+#define IKALIBR_LIVE_TOPIC_RECORDER_H
+
+#include "util/spsc_ring_buffer.hpp"
+#include "sensor/imu.h"
+#include "ros/ros.h"
+#include "rosbag/bag.h"
+#include "topic_tools/shape_shifter.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+class IMUDataLoader;
+
+/**
+ * @brief the live mode of data ingestion. Configured topics are subscribed; messages land in
+ * lock-free per-topic ring buffers and are drained into a ros bag. The data quality of each topic
+ * (rates, gaps, and drops) and the excitation of the reference imu are reported continuously.
+ * Recording stops once enough excited motion is collected (or 'Duration' is reached, or the node
+ * is interrupted). The recorded bag is then loaded as an offline one, i.e., messages are unpacked
+ * by the same data loaders
+ */
+class LiveTopicRecorder {
+public:
+    using Ptr = std::shared_ptr<LiveTopicRecorder>;
+    using MessageEvent = ros::MessageEvent<const topic_tools::ShapeShifter>;
+
+    // buffers are drained at this rate (Hz)
+    constexpr static double DrainRate = 20.0;
+
+protected:
+    struct Channel {
+        std::string topic;
+        ros::Subscriber subscriber;
+        SPSCRingBuffer<MessageEvent> buffer;
+        // messages rejected by the full buffer, counted by the producer
+        std::atomic<std::size_t> dropped;
+
+        // the following are maintained by the consumer
+        std::size_t recorded = 0;
+        ros::Time firstTime, lastTime;
+        // the maximum interval between consecutive received messages
+        double maxGap = 0.0;
+
+        Channel(std::string topic, std::size_t capacity)
+            : topic(std::move(topic)),
+              buffer(capacity),
+              dropped(0) {}
+    };
+
+protected:
+    std::string _bagPath;
+    std::map<std::string, std::unique_ptr<Channel>> _channels;
+
+    // measurements of the reference imu, unpacked on arrival to evaluate the excitation
+    std::shared_ptr<IMUDataLoader> _referIMULoader;
+    std::vector<IMUFrame::Ptr> _referIMUMes;
+
+public:
+    explicit LiveTopicRecorder(std::string bagPath);
+
+    static Ptr Create(const std::string &bagPath);
+
+    // block until the recording stops, all configured topics in 'Configor' are recorded
+    void Record();
+
+protected:
+    // called on the spinner threads
+    static void OnMessage(Channel *channel, const MessageEvent &event);
+
+    // move buffered messages to the bag, returns the number of messages drained
+    std::size_t Drain(rosbag::Bag &bag);
+
+    // the total length (s) of the excited windows of the reference imu
+    [[nodiscard]] double ExcitedDuration() const;
+
+    void ReportStatus(double excitedDuration) const;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_LIVE_TOPIC_RECORDER_H
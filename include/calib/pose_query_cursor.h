@@ -0,0 +1,99 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_POSE_QUERY_CURSOR_H
+#define IKALIBR_POSE_QUERY_CURSOR_H
+
+#include "config/configor.h"
+#include "ctraj/core/spline_bundle.h"
+#include "util/utils.h"
+#include "array"
+#include "optional"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief a cursor querying poses of a sensor in the world frame, i.e., 'SE3_BrToW * SE3_SenToBr'
+ * at 'timeBySen + timeOffset', from the rotation and translation splines. Splines, the time offset
+ * and the extrinsic are resolved once when the cursor is created, and control points of the last
+ * queried segments are remembered, thus sequential (monotonic) queries falling into the same
+ * segments evaluate the splines directly. A cursor is not thread-safe, see 'QueryBatch'
+ */
+class PoseQueryCursor {
+public:
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+
+    // the number of times queried by a cursor in 'QueryBatch'
+    constexpr static int CHUNK_SIZE = 1024;
+
+private:
+    constexpr static int Order = Configor::Prior::SplineOrder;
+
+    // held so that splines referenced below stay valid
+    SplineBundleType::Ptr _splines;
+    const SplineBundleType::So3SplineType &_so3Spline;
+    const SplineBundleType::RdSplineType &_posSpline;
+    double _so3DtInv, _posDtInv;
+
+    // 'timeByBr = timeBySen + _timeOffset'
+    double _timeOffset;
+    Sophus::SE3d _SE3_SenToBr;
+
+    // control points of the last queried segments
+    std::array<const double *, Order> _so3Knots{}, _posKnots{};
+    std::int64_t _so3Seg = -1, _posSeg = -1;
+
+public:
+    PoseQueryCursor(SplineBundleType::Ptr splines,
+                    double timeOffset,
+                    const Sophus::SE3d &SE3_SenToBr = Sophus::SE3d());
+
+    // the pose at 'timeBySen', if the time is out of range, return 'std::nullopt'
+    std::optional<Sophus::SE3d> Query(double timeBySen);
+
+    /**
+     * query poses at (sorted) times, which are split into chunks queried in parallel, each by a
+     * copy of this cursor. Poses are organized as the times
+     */
+    [[nodiscard]] std::vector<std::optional<Sophus::SE3d>> QueryBatch(
+        const std::vector<double> &timesBySen) const;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_POSE_QUERY_CURSOR_H
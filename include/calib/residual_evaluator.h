@@ -0,0 +1,215 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_RESIDUAL_EVALUATOR_H
+#define IKALIBR_RESIDUAL_EVALUATOR_H
+
+#include "config/configor.h"
+#include "calib/time_deriv.hpp"
+#include "ctraj/core/spline_bundle.h"
+#include "veta/camera/pinhole.h"
+#include "util/utils.h"
+#include "cereal/cereal.hpp"
+#include "cereal/types/vector.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+class RadarTargetArray;
+using RadarTargetArrayPtr = std::shared_ptr<RadarTargetArray>;
+struct VisualReProjCorrSeq;
+using VisualReProjCorrSeqPtr = std::shared_ptr<VisualReProjCorrSeq>;
+struct OpticalFlowCorr;
+using OpticalFlowCorrPtr = std::shared_ptr<OpticalFlowCorr>;
+struct PointToSurfelCorrBuffer;
+using PointToSurfelCorrBufferPtr = std::shared_ptr<PointToSurfelCorrBuffer>;
+
+/**
+ * @brief single-pass summary statistics of residuals (of dimension 'dim'), accumulated while they
+ * are evaluated. Norms of residuals are also counted into a log-scale histogram (bins over
+ * decades), whose range needs not to be known in advance. Statistics of threads are mergeable
+ */
+struct ResidualStatistics {
+public:
+    constexpr static int BINS_PER_DECADE = 4;
+    // norms in [10^MIN_DECADE, 10^MAX_DECADE) are binned, others are in the under/overflow bins
+    constexpr static int MIN_DECADE = -6;
+    constexpr static int MAX_DECADE = 4;
+
+public:
+    int dim;
+    std::size_t count;
+    // the component-wise sum, and the sum of squared norms
+    std::vector<double> sum;
+    double sqSum;
+    double minNorm, maxNorm;
+    // the underflow bin, bins, the overflow bin
+    std::vector<std::size_t> histogram;
+
+public:
+    explicit ResidualStatistics(int dim = 1);
+
+    void Add(const double *residual);
+
+    void Merge(const ResidualStatistics &other);
+
+    [[nodiscard]] std::vector<double> Mean() const;
+
+    [[nodiscard]] double RMSE() const;
+
+    // the edges of bins, i.e., 'histogram[i]' counts norms in [edges[i-1], edges[i])
+    static std::vector<double> BinEdges();
+
+    [[nodiscard]] std::string Summary() const;
+
+public:
+    // statistics are only saved (exported)
+    template <class Archive>
+    void save(Archive &ar) const {
+        ar(CEREAL_NVP(count), cereal::make_nvp("mean", Mean()), cereal::make_nvp("rmse", RMSE()),
+           CEREAL_NVP(minNorm), CEREAL_NVP(maxNorm), cereal::make_nvp("bin_edges", BinEdges()),
+           CEREAL_NVP(histogram));
+    }
+};
+
+/**
+ * @brief residual-only evaluation of factor families for exports and cost monitoring. Measurements
+ * are packed into flat arrays, splines are sampled at their times in batch (see 'SplineSampler'),
+ * and residuals are computed in double (no jets, no cost functions) in parallel across
+ * measurements. Measurements out of the time range of splines are dropped, and residuals of the
+ * remaining ones are organized as the measurements
+ */
+class ResidualEvaluator {
+public:
+    using Ptr = std::shared_ptr<ResidualEvaluator>;
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+
+    struct RadarPack {
+    public:
+        std::vector<double> times;
+        Eigen::aligned_vector<Eigen::Vector3d> targetsInRj;
+        std::vector<double> invRanges;
+        std::vector<double> radialVels;
+
+    public:
+        static RadarPack Pack(const std::vector<RadarTargetArrayPtr> &arrays);
+    };
+
+    struct ReprojPack {
+    public:
+        // the raw times and exposure factors (row / image height - 'ExposureFactor')
+        std::vector<double> ti, tj, li, lj;
+        Eigen::aligned_vector<Eigen::Vector2d> fi, fj;
+        // the depth of the first observation of the landmark
+        std::vector<double> depths;
+
+    public:
+        static ReprojPack Pack(const std::vector<VisualReProjCorrSeqPtr> &corrSeqs);
+    };
+
+    struct OpticalFlowPack {
+    public:
+        // mid times (raw, i.e., without time offsets), points and velocities (given the readout)
+        std::vector<double> times;
+        Eigen::aligned_vector<Eigen::Vector2d> points, vels;
+        std::vector<double> depths;
+
+    public:
+        static OpticalFlowPack Pack(const std::vector<OpticalFlowCorrPtr> &corrs, double readout);
+    };
+
+    struct PointToSurfelPack {
+    public:
+        std::vector<double> times;
+        Eigen::aligned_vector<Eigen::Vector3d> pointsInScan;
+        // [norm dir, dist]
+        Eigen::aligned_vector<Eigen::Vector4d> surfelsInW;
+
+    public:
+        static PointToSurfelPack Pack(const PointToSurfelCorrBuffer &corrs);
+    };
+
+private:
+    SplineBundleType::Ptr _splines;
+    TimeDeriv::ScaleSplineType _scaleType;
+
+public:
+    ResidualEvaluator(SplineBundleType::Ptr splines, TimeDeriv::ScaleSplineType scaleType);
+
+    static Ptr Create(const SplineBundleType::Ptr &splines, TimeDeriv::ScaleSplineType scaleType);
+
+    /**
+     * residuals of measurements in packs. If 'stats' is given, the statistics of residuals are
+     * accumulated into it (reset first) in the same pass
+     */
+    [[nodiscard]] std::vector<double> RadarDoppler(const RadarPack &pack,
+                                                   double TO_RjToBr,
+                                                   const Sophus::SE3d &SE3_RjToBr,
+                                                   ResidualStatistics *stats = nullptr) const;
+
+    // the linear scale spline should be the translation spline
+    [[nodiscard]] Eigen::aligned_vector<Eigen::Vector2d> VisualReprojection(
+        const ReprojPack &pack,
+        double TO_CmToBr,
+        double readout,
+        const Sophus::SE3d &SE3_CmToBr,
+        const ns_veta::PinholeIntrinsic::Ptr &intri,
+        ResidualStatistics *stats = nullptr) const;
+
+    [[nodiscard]] Eigen::aligned_vector<Eigen::Vector2d> VisualOpticalFlow(
+        const OpticalFlowPack &pack,
+        double TO_CamToBr,
+        const Sophus::SE3d &SE3_CamToBr,
+        const ns_veta::PinholeIntrinsic::Ptr &intri,
+        ResidualStatistics *stats = nullptr) const;
+
+    // the linear scale spline should be the translation spline
+    [[nodiscard]] std::vector<double> PointToSurfel(const PointToSurfelPack &pack,
+                                                    double TO_LkToBr,
+                                                    const Sophus::SO3d &SO3_LkToBr,
+                                                    const Eigen::Vector3d &POS_LkInBr,
+                                                    ResidualStatistics *stats = nullptr) const;
+
+protected:
+    // the derivative order of the linear scale spline to obtain the linear velocity
+    [[nodiscard]] int LinVelDeriv() const;
+
+    void CheckPosSpline(const std::string &desc) const;
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_RESIDUAL_EVALUATOR_H
@@ -0,0 +1,102 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_SPLINE_META_CACHE_H
+#define IKALIBR_SPLINE_META_CACHE_H
+
+#include "config/configor.h"
+#include "ctraj/core/spline_bundle.h"
+#include "util/utils.h"
+#include "mutex"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief spline metas are only determined by the query times and the knot layout of the spline,
+ * which does not change during batch optimizations. As estimators are rebuilt for each stage (and
+ * each iteration) on the same spline bundle, metas of measurements are cached here and reused. The
+ * query times (time offsets involved) are a part of the key, thus once time offsets change, the
+ * old metas would be missed naturally rather than misused. Once a bundle is replaced in place
+ * (e.g., refitted with other knot distances), its cache has to be cleared by the owner.
+ */
+class SplineMetaCache {
+public:
+    using Ptr = std::shared_ptr<SplineMetaCache>;
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+    using SplineMetaType = ns_ctraj::SplineMeta<Configor::Prior::SplineOrder>;
+    using TimeInitList = std::initializer_list<std::pair<const double, const double>>;
+
+    // the cache is cleared once the number of cached metas exceeds this capacity
+    constexpr static std::size_t CAPACITY = 1 << 21;
+
+private:
+    using KeyType = std::pair<std::string, std::vector<std::pair<double, double>>>;
+
+    std::map<KeyType, SplineMetaType> _metas;
+    mutable std::mutex _mutex;
+
+    // caches organized by spline bundles, expired bundles are erased
+    static std::map<const SplineBundleType *,
+                    std::pair<std::weak_ptr<SplineBundleType>, SplineMetaCache::Ptr>>
+        CACHES;
+    static std::mutex CACHES_MUTEX;
+
+public:
+    SplineMetaCache() = default;
+
+    static Ptr Create();
+
+    // get the cache bound to the given spline bundle, a new one would be created if not exists
+    static Ptr GetCache(const SplineBundleType::Ptr &splines);
+
+    // find the meta of the given spline and query times, return false if not cached
+    bool Find(const std::string &name, TimeInitList times, SplineMetaType &meta) const;
+
+    void Insert(const std::string &name, TimeInitList times, const SplineMetaType &meta);
+
+    void Clear();
+
+    [[nodiscard]] std::size_t Size() const;
+
+protected:
+    static KeyType GenerateKey(const std::string &name, TimeInitList times);
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_SPLINE_META_CACHE_H
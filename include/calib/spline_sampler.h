@@ -0,0 +1,103 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_SPLINE_SAMPLER_H
+#define IKALIBR_SPLINE_SAMPLER_H
+
+#include "config/configor.h"
+#include "ctraj/core/spline_bundle.h"
+#include "ctraj/utils/macros.hpp"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief batched evaluation of the rotation and linear scale splines of a bundle at many times,
+ * e.g., for dense sampling in outputs. Times are split into chunks evaluated in parallel, and in
+ * each chunk, control points are fetched once per segment and reused by (sorted) times in it
+ */
+class SplineSampler {
+public:
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+
+    struct Sample {
+    public:
+        // false if the time is out of the range of splines
+        bool valid = false;
+        double time = INVALID_TIME_STAMP;
+        Sophus::SO3d so3;
+        // the angular velocity and acceleration expressed in the body frame (if evaluated)
+        Eigen::Vector3d angVelInBody = Eigen::Vector3d::Zero();
+        Eigen::Vector3d angAcceInBody = Eigen::Vector3d::Zero();
+        // the 'scaleDeriv'-th derivative of the linear scale spline
+        Eigen::Vector3d scale = Eigen::Vector3d::Zero();
+
+    public:
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    using SampleVec = Eigen::aligned_vector<Sample>;
+
+    // the number of times evaluated in a chunk
+    constexpr static int CHUNK_SIZE = 2048;
+
+public:
+    /**
+     * evaluate splines at the given times, samples are organized as the times
+     * @param scaleDeriv the derivative order of the linear scale spline to evaluate, i.e., 0, 1, 2
+     * @param withAngDerivs whether the angular velocity and acceleration are evaluated
+     */
+    static SampleVec Evaluate(const SplineBundleType::Ptr &splines,
+                              const std::vector<double> &times,
+                              int scaleDeriv,
+                              bool withAngDerivs);
+
+    // times in [st, et) with the step 'dt', i.e., st + i * dt, which avoids accumulated errors
+    static std::vector<double> UniformTimes(double st, double et, double dt);
+
+    // the knot distance of a spline, from its time range and the count of its control points
+    template <typename SplineType>
+    static double KnotTimeDist(const SplineType &spline) {
+        return (spline.MaxTime() - spline.MinTime()) /
+               static_cast<double>(spline.GetKnots().size() - Configor::Prior::SplineOrder + 1);
+    }
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_SPLINE_SAMPLER_H
@@ -0,0 +1,98 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_TEMPORAL_PADDING_H
+#define IKALIBR_TEMPORAL_PADDING_H
+
+#include "util/utils.h"
+#include "map"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief once a time offset (or readout time) is estimated, residuals of the sensor consider the
+ * time range padded by 'Prior::TimeOffsetPadding' (or 'Prior::ReadoutTimePadding'), and involve
+ * extra knots. As temporal parameters converge across batch optimizations, paddings of sensors are
+ * narrowed to the sigma multiple of their marginal standard deviations around the estimates. The
+ * padding is also the bound of the parameter, thus it always covers the current estimate, and it
+ * never grows.
+ */
+class TemporalPadding {
+public:
+    using Ptr = std::shared_ptr<TemporalPadding>;
+
+private:
+    // narrowed paddings of sensors, the priori ones are used if not given
+    std::map<std::string, double> _timeOffset;
+    std::map<std::string, double> _readoutTime;
+
+public:
+    TemporalPadding() = default;
+
+    static Ptr Create();
+
+    // the padding of the time offset of the sensor, i.e., the bound of its absolute value
+    [[nodiscard]] double TimeOffset(const std::string &topic) const;
+
+    // the padding of the readout time of the (rolling shutter) camera, i.e., its upper bound
+    [[nodiscard]] double ReadoutTime(const std::string &topic) const;
+
+    // narrow the padding given the estimate and its marginal standard deviation
+    void NarrowTimeOffset(const std::string &topic, double timeOffset, double stdDev);
+
+    void NarrowReadoutTime(const std::string &topic, double readoutTime, double stdDev);
+
+    // narrow the padding of the time offset to the given one (never below the minimum)
+    void NarrowTimeOffsetTo(const std::string &topic, double padding);
+
+    // whether any padding is narrowed
+    [[nodiscard]] bool IsNarrowed() const;
+
+    bool operator==(const TemporalPadding &other) const;
+
+    bool operator!=(const TemporalPadding &other) const;
+
+    void ShowPaddings() const;
+
+protected:
+    static double Narrowed(double padding, double magnitude, double stdDev, double minPadding);
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_TEMPORAL_PADDING_H
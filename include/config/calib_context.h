@@ -0,0 +1,122 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_CALIB_CONTEXT_H
+#define IKALIBR_CALIB_CONTEXT_H
+
+#include "config/configor.h"
+#include "mutex"
+#include "optional"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the calibration context, i.e., a configuration ('DataStream', 'Prior', and 'Preference')
+ * owned by an instance rather than the static 'Configor'. The 'Configor' is kept as the view of the
+ * active context, so that the static api works as before: a context is activated by a scope, which
+ * installs its configuration to the 'Configor'. Scopes are exclusive within the process, thus
+ * calibrations owning different contexts (e.g., different rigs or bags) can live in one process,
+ * and their entries (data loading, solving, and output) are serialized rather than interfered.
+ */
+class CalibContext {
+public:
+    using Ptr = std::shared_ptr<CalibContext>;
+
+    /**
+     * @brief the scope where a context is active, the configuration before it (if another context
+     * is active in the same thread) is restored once the scope is destroyed
+     */
+    class Scope {
+    private:
+        std::unique_lock<std::recursive_mutex> _lock;
+        // the configuration (and its context id) replaced by this scope
+        std::optional<std::pair<std::string, std::uint64_t>> _replaced;
+
+    public:
+        explicit Scope(const CalibContext &context);
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope();
+    };
+
+private:
+    // the configuration archived (cereal binary), including internally transformed fields
+    std::string _archive;
+    // the unique id of this context
+    std::uint64_t _id;
+
+    // activation of contexts is exclusive as 'Configor' is shared in the process
+    static std::recursive_mutex ACTIVE_MUTEX;
+    // the id of the context installed to 'Configor' (zero for none) and the depth of scopes
+    static std::uint64_t ACTIVE_ID;
+    static int ACTIVE_DEPTH;
+
+public:
+    explicit CalibContext(std::string archive);
+
+    static Ptr Create(const std::string &archive);
+
+    // capture the configuration currently in 'Configor'
+    static Ptr CreateFromConfigor();
+
+    /**
+     * load the configuration from file into a new context, the one in 'Configor' is untouched
+     * @return the loaded context, nullptr if the file can not be opened
+     */
+    static Ptr Load(const std::string &filename,
+                    CerealArchiveType::Enum archiveType = CerealArchiveType::Enum::YAML);
+
+    // activate this context until the returned scope is destroyed
+    [[nodiscard]] std::unique_ptr<Scope> Activate() const;
+
+    [[nodiscard]] std::uint64_t GetId() const;
+
+protected:
+    static std::string ArchiveConfigor();
+
+    static void InstallToConfigor(const std::string &archive);
+};
+
+using CalibContextPtr = CalibContext::Ptr;
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_CALIB_CONTEXT_H
@@ -38,6 +38,7 @@
 #include "util/utils.h"
 #include "util/enum_cast.hpp"
 #include "util/cereal_archive_helper.hpp"
+#include "util/numa.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -46,7 +47,8 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 // myenumGenor OutputOption ParamInEachIter BSplines LiDARMaps VisualMaps RadarMaps HessianMat
 // VisualLiDARCovisibility VisualKinematics ColorizedLiDARMap AlignedInertialMes VisualReprojErrors
-// RadarDopplerErrors
+// RadarDopplerErrors VisualOpticalFlowErrors LiDARPointToSurfelErrors BatchOptProblems
+// FactorProfiles TraceEvents
 enum class OutputOption : std::uint32_t {
     /**
      * @brief options
@@ -66,12 +68,28 @@ enum class OutputOption : std::uint32_t {
     RadarDopplerErrors = 1 << 12,
     VisualOpticalFlowErrors = 1 << 13,
     LiDARPointToSurfelErrors = 1 << 14,
+    BatchOptProblems = 1 << 15,
+    FactorProfiles = 1 << 16,
+    TraceEvents = 1 << 17,
     ALL = ParamInEachIter | BSplines | LiDARMaps | VisualMaps | RadarMaps | HessianMat |
           VisualLiDARCovisibility | VisualKinematics | ColorizedLiDARMap | AlignedInertialMes |
           VisualReprojErrors | RadarDopplerErrors | VisualOpticalFlowErrors |
-          LiDARPointToSurfelErrors
+          LiDARPointToSurfelErrors | BatchOptProblems | FactorProfiles | TraceEvents
 };
 
+enum class ScanRegistrationType { NDT, VGICP };
+
+enum class ViewerModeType { GUI, HEADLESS, RECORD };
+
+/**
+ * NONE: memory and threads are placed by the system
+ * INTERLEAVE: pages of the process (e.g., sensor data allocated by the loading thread) are
+ * interleaved over numa nodes
+ * NODE_LOCAL: concurrent workers (see 'Preference::ThreadSplit') are bound to numa nodes, data
+ * they (first) touch, e.g., maps and associations of a topic, are allocated on their nodes
+ */
+enum class NUMAModeType { NONE, INTERLEAVE, NODE_LOCAL };
+
 struct Configor {
 public:
     using Ptr = std::shared_ptr<Configor>;
@@ -197,6 +215,25 @@ public:
             }
         };
 
+        struct DecimationConfig {
+        public:
+            // keep at most one message in each time bin of '1 / Rate' (s), non-positive to disable
+            double Rate;
+            // keep a message only if the rotation (deg) integrated from gyroscopes of the
+            // reference imu since the last kept one reaches it, non-positive to disable
+            double MinRotation;
+
+            DecimationConfig()
+                : Rate(),
+                  MinRotation() {};
+
+        public:
+            template <class Archive>
+            void serialize(Archive &ar) {
+                ar(CEREAL_NVP(Rate), CEREAL_NVP(MinRotation));
+            }
+        };
+
         static std::optional<std::string> CreateImageStoreFolder(const std::string &camTopic);
 
         static std::optional<std::string> CreateSfMWorkspace(const std::string &camTopic);
@@ -223,6 +260,16 @@ public:
 
         static bool IsEventCamera(const std::string &topic);
 
+        /**
+         * 'BagPath' could be a single bag, a glob pattern (e.g., '/data/seq_*.bag' for split
+         * bags), or multiple paths (patterns) separated by ';'. The resolved bags are sorted and
+         * read as one merged, time-ordered data stream
+         */
+        static std::vector<std::string> GetBagPaths();
+
+        // shared-library plugins of data loaders, given in the same way as 'BagPath'
+        static std::vector<std::string> GetLoaderPluginPaths();
+
         static std::map<std::string, IMUConfig> IMUTopics;
         static std::map<std::string, RadarConfig> RadarTopics;
         static std::map<std::string, LiDARConfig> LiDARTopics;
@@ -233,8 +280,17 @@ public:
         static std::string ReferIMU;
 
         static std::string BagPath;
+        // plugins registering loaders of other lidar and radar models (see 'DataLoaderRegistry')
+        static std::string LoaderPlugins;
         static double BeginTime;
         static double Duration;
+        // load-time decimation of radar, lidar, camera and event topics, where dropped messages
+        // are skipped before decoding. Imus and rgbd cameras (paired images) are never decimated
+        static std::map<std::string, DecimationConfig> TopicDecimation;
+        // subscribe the topics and record them into 'BagPath' (rather than reading it), the
+        // calibration starts once 'LiveExcitedDuration' (s) of excited motion is collected
+        static bool LiveMode;
+        static double LiveExcitedDuration;
 
         static std::string OutputPath;
         const static std::string PkgPath;
@@ -247,9 +303,16 @@ public:
                CEREAL_NVP(CameraTopics), CEREAL_NVP(RGBDTopics),
                // the calibration of event cameras have not been supported yet in iKalibr!!!
                // CEREAL_NVP(EventTopics),
-               CEREAL_NVP(ReferIMU), CEREAL_NVP(BagPath), CEREAL_NVP(BeginTime),
-               CEREAL_NVP(Duration), CEREAL_NVP(OutputPath));
+               CEREAL_NVP(ReferIMU), CEREAL_NVP(BagPath), CEREAL_NVP(LoaderPlugins),
+               CEREAL_NVP(BeginTime), CEREAL_NVP(Duration), CEREAL_NVP(TopicDecimation),
+               CEREAL_NVP(LiveMode),
+               CEREAL_NVP(LiveExcitedDuration), CEREAL_NVP(OutputPath));
         }
+
+    protected:
+        // split paths (patterns) separated by ';', glob patterns are resolved and sorted, throws
+        // if a pattern matches nothing
+        static std::vector<std::string> ResolvePaths(const std::string &pathsStr);
     } dataStream;
 
     static struct Prior {
@@ -264,6 +327,8 @@ public:
         static struct KnotTimeDist {
             static double SO3Spline;
             static double ScaleSpline;
+            // the count of coarse levels (each doubles the knot distances) in early optimizations
+            const static int CoarseToFineLevels;
 
         public:
             template <class Archive>
@@ -275,11 +340,20 @@ public:
         static struct NDTLiDAROdometer {
             static double Resolution;
             static double KeyFrameDownSample;
+            // the scan registration backend of the lidar odometer, 'NDT' or 'VGICP'
+            static std::string Registration;
+            static ScanRegistrationType RegistrationType;
+            // the number of latest key frames kept in the local map, zero for the whole global map
+            const static std::size_t LocalMapKeyFrames;
+            // warm-start the odometer rerun on undistorted scans using relative translations from
+            // the first run (that recovers extrinsic rotations) as priors
+            const static bool WarmStartRerun;
 
         public:
             template <class Archive>
             void serialize(Archive &ar) {
-                ar(CEREAL_NVP(Resolution), CEREAL_NVP(KeyFrameDownSample));
+                ar(CEREAL_NVP(Resolution), CEREAL_NVP(KeyFrameDownSample),
+                   CEREAL_NVP(Registration));
             }
         } ndtLiDAROdometer;
 
@@ -296,6 +370,15 @@ public:
             const static std::uint8_t MapDepthLevels;
 
             const static int PointToSurfelCountInScan;
+            // candidates associated in each scan are 'PointToSurfelCountInScan' times this value,
+            // a non-positive one associates all points
+            const static double CandidateOversampling;
+            // scans moved beyond this distance (m) are re-inserted into the kept surfel map
+            const static double SurfelMapUpdateThreshold;
+            // if the ratio of moved scans exceeds this value, the surfel map is fully rebuilt
+            const static double SurfelMapRebuildRatio;
+            // the max number of points of a surfel organized as one point-to-surfel residual block
+            const static std::size_t PointToSurfelGroupSizeMax;
 
         public:
             template <class Archive>
@@ -312,6 +395,9 @@ public:
         const static double LossForReprojFactor;
         // the loss function used for rgbd velocity factor (pixel) (on the image pixel plane)
         const static double LossForOpticalFlowFactor;
+        // the max count of visual reprojection factors of a camera, if exceeded, observations are
+        // subsampled based on covisibility keyframes, a zero one adds all observations
+        const static std::size_t VisualReprojFactorBudget;
 
     public:
         template <class Archive>
@@ -334,6 +420,200 @@ public:
         static CerealArchiveType::Enum OutputDataFormat;
         const static std::map<CerealArchiveType::Enum, std::string> FileExtension;
         static int ThreadsToUse;
+        // cache the unpacked calibration data to skip rosbag parsing in repeated runs
+        static bool CacheCalibData;
+        // windows (of the reference imu) carrying less excitation information per second than it
+        // are thinned before the heavy stages, see 'ikalibr-config.yaml'. Zero keeps all data
+        static double TargetInfoPerSecond;
+        // the length (s) of windows to score excitation, and the decimation of imu measurements in
+        // thinned windows (other sensors are dropped there, while imus keep the spline constrained)
+        const static double ExcitationWindowLength;
+        const static int LowExcitationIMUDecimation;
+        // in the live mode, the information per second of excited windows if the target above is
+        // zero, the capacity of the ring buffer of each topic, and the interval (s) of reports
+        const static double LiveMinInfoPerSecond;
+        const static std::size_t LiveRingBufferCapacity;
+        const static double LiveReportInterval;
+        // perform SfM for pose cameras in process, instead of the external colmap / glomap
+        static bool InProcessSfM;
+        // save checkpoints after stages, and the stage to resume the calibration from (if set)
+        static bool SaveCheckpoints;
+        static std::string ResumeFromStage;
+        /**
+         * warm-start the calibration from the parameters (and the 'knots' splines) output by a
+         * previous calibration: the initialization is skipped if they validate against the data
+         */
+        static std::string WarmStartParamPath;
+        static std::string WarmStartSplinePath;
+        // only every 'DiagnosticFrameStride'-th frame is rendered in visual diagnostics by-products
+        static int DiagnosticFrameStride;
+        // log through a background thread, so that logging would never block the calibration
+        static bool AsyncLogging;
+        // the capacity of the log queue, the oldest messages are overwritten once it is full
+        const static std::size_t AsyncLogQueueSize;
+        const static int WarmStartSampleStride;
+        const static double WarmStartMaxGyroRMSE;
+        const static double WarmStartMaxAcceRMSE;
+        // str for file configuration, and enum for internal use
+        static std::string ViewerModeStr;
+        static ViewerModeType ViewerMode;
+        // release raw measurements once the last stage using them is finished
+        const static bool ReleaseConsumedData;
+        // the key of counter-based random sampling (e.g., of correspondences), for reproducibility
+        const static std::uint64_t SamplingSeed;
+        // spill released camera images to disk (decoded on demand), rather than dropping them
+        const static bool SpillReleasedImages;
+        // run the independent preparations of sensor-inertial alignments concurrently
+        const static bool ConcurrentInitPreparation;
+        // perform data associations of different sensor types concurrently in batch optimizations
+        const static bool ConcurrentDataAssociation;
+        // the placement of memory and threads on multi-socket machines
+        const static NUMAModeType NUMAMode;
+        // the maximum number of by-products output concurrently, i.e., the io concurrency limit
+        const static int ByProductOutputConcurrency;
+        // voxel size to downsample exported maps on the fly, non-positive value keeps them dense
+        const static float MapExportVoxelSize;
+        // the maximum rate (frames per second) at which solver snapshots are rendered by the viewer
+        const static double ViewerMaxFPS;
+        // clouds with more points are drawn by levels of detail in the viewer, and the per-frame
+        // point budget, the screen space error (px) to refine levels in drawing
+        const static std::size_t LODCloudMinPoints;
+        const static std::size_t LODPointBudget;
+        const static float LODScreenSpaceError;
+        // the count of entity groups reused by the viewer when the same content is added again
+        const static std::size_t ViewerEntityCacheCapacity;
+        // parameters of every n-th ceres iteration are dumped (if 'ParamInEachIter' is output)
+        const static int ParamDumpInterval;
+        // the capacity of the ring buffer of parameter snapshots waiting to be dumped
+        const static std::size_t ParamDumpBufferCapacity;
+        // keep only the payload of camera images, and decode them on demand (off by default)
+        const static bool LazyImageDecoding;
+        // the maximum number of lazily decoded camera frames kept in memory
+        const static std::size_t LazyImageCacheCapacity;
+        // keep only grey images of cameras if colors are not required by outputs, the color
+        // image is derived on demand (from the compressed payload if kept, otherwise the grey)
+        const static bool GreyOnlyImageStorage;
+        // keep only moments of points in leaf nodes of lidar surfel maps (a flat hash grid), and
+        // aggregate surfels of coarser nodes on demand, rather than maintaining the whole octree.
+        // Surfel maps are not rendered in the viewer in this mode
+        const static bool CompactSurfelMap;
+        // landmarks of each pose camera kept for the visual reprojection association (zero keeps
+        // all), which are ranked by track lengths, triangulation angles and errors, and spread
+        // over a 'LandmarkPruneGridSize' x 'LandmarkPruneGridSize' image grid
+        const static std::size_t LandmarkPruneBudget;
+        const static int LandmarkPruneGridSize;
+        // landmarks with larger mean reprojection errors (pixel) or smaller triangulation angles
+        // (deg) are rejected in pruning
+        const static double LandmarkPruneMaxReprojError;
+        const static double LandmarkPruneMinTriangAngle;
+        // the memory budget (MB) of derived data of frames, e.g., image pyramids and descriptors
+        const static std::size_t DerivedFrameDataBudget;
+        // clear speckles and fill small holes of depth images when they are loaded
+        const static bool FilterDepthImages;
+        // organize inertial samples falling into the same spline segment as one residual block
+        const static bool BatchInertialFactors;
+        // remove frozen imu intrinsics from measurements in advance, dropping their param blocks
+        const static bool PreCorrectFrozenIMUIntri;
+        // organize doppler targets of the same radar scan as one residual block
+        const static bool BatchRadarFactors;
+        // evaluate the optical flow and its reprojection of a correspondence in one residual block
+        const static bool FuseOpticalFlowFactors;
+        // append the trifocal tensor constraint to fused optical flow factors (cameras and rgbds)
+        const static bool OpticalFlowTrifocalTensor;
+        // organize reprojections of the same landmark as one residual block
+        const static bool BatchVisualReprojFactors;
+        // keep the estimator across batch optimizations, only re-associated residuals are rebuilt
+        const static bool ReuseBatchEstimator;
+        // the length (s) of overlapping time windows solved in parallel and reconciled by consensus
+        // on calibration parameters before each batch optimization, zero disables decomposition
+        const static double DecomposedWindowLength;
+        // the overlap (s) between two neighboring time windows
+        const static double DecomposedWindowOverlap;
+        // the count of consensus admm iterations, and the weight of the augmented terms
+        const static int ConsensusIterations;
+        const static double ConsensusWeight;
+        // the length (s) of sliding windows to refine the calibration incrementally after the
+        // batch optimizations, where old knots are marginalized into a dense prior on the
+        // spatiotemporal parameters, zero disables it. The prior is scaled by the forgetting factor
+        // in each update, and drifts larger than the sigma multiple are reported
+        const static double IncrementalWindowLength;
+        const static double IncrementalPriorForgetting;
+        const static double IncrementalDriftSigma;
+        // the thresholds of spatiotemporal parameter changes (rotation: deg, translation: m, time:
+        // s) in a batch optimization, below which the data association of the next one is skipped
+        const static double StageConvergenceRotThd;
+        const static double StageConvergencePosThd;
+        const static double StageConvergenceTimeThd;
+        // terminate remaining batch optimizations once converged, if they optimize no other params
+        // and the splines are already at the configured (finest) knot distances
+        const static bool EarlyStopBatchOptimization;
+        // initialize the so3 spline by a linear least-squares fit of reference gyroscope, which is
+        // then polished by at most the given count of nonlinear iterations
+        const static bool LinearSO3SplineInit;
+        const static int SO3SplinePolishIterations;
+        // fit knots of linear velocity / position scale splines in closed form (banded normal
+        // equations) in the initialization, ceres is only used for nonlinear radar refinement
+        const static bool LinearScaleSplineInit;
+        // eliminate per-window velocities (and velocity scales) via the Schur complement in the
+        // sensor-inertial alignment, only gravity, extrinsic translations and scales are solved
+        const static bool SchurSensorInertialAlign;
+        // the count of gyroscope measurements of each imu (the most excited ones) used to recover
+        // the extrinsic rotations and time offsets of multiple imus in the initialization, zero
+        // means all. Batch optimizations are always performed using all measurements
+        const static std::size_t MultiIMUInitGyroBudget;
+        // the max dimension of the dense reduced camera matrix, sparse schur is used if exceeded
+        const static std::size_t DenseSchurDimensionMax;
+        // the interval (s) to sample poses in scan undistortion, zero means exact evaluation
+        const static double UndistortionSampleInterval;
+        // run the lk optical flow and corner detection on OpenCL devices (if available)
+        const static bool UseOpenCLInTracking;
+        // once the rotation prior is available, track each feature with the lk window size and
+        // pyramid level chosen from its predicted displacement, rather than the full ones
+        const static bool AdaptiveLKTracking;
+        // track long image sequences in overlapping chunks (frame count, and frames shared by two
+        // neighboring chunks) in parallel by independent rotation-only odometers in the
+        // initialization of vel-cameras and rgbd cameras, zero disables chunking
+        const static int VOChunkFrameCount;
+        const static int VOChunkOverlapFrames;
+        // the extrinsic rotation of a camera is accepted (and its rotation-only odometry stops
+        // estimating rotations) once the last 'count' estimates differ below 'thd' (degree)
+        const static std::size_t RotationStabilityCount;
+        const static double RotationStabilityThd;
+        // whether closed-form hand-eye rotations (of lidars and sfm-based cameras) are refined by
+        // the continuous-time (ceres) alignment, which is always performed if time offsets are
+        // estimated, otherwise the closed-form solutions using whole sequences are used
+        const static bool RefineHandEyeRotation;
+        // bin events into count, polarity and time images on OpenCL devices (if available)
+        const static bool UseOpenCLInEventRendering;
+        // event denoising after loading (a non-positive one disables the corresponding filter):
+        // the time (s) to learn hot pixels, the refractory period (s), and the time window (s) of
+        // the background-activity filter
+        const static double EventHotPixelLearnTime;
+        const static double EventRefractoryPeriod;
+        const static double EventBAFTimeWindow;
+        // normal flows within the bin width (s) share one pure-rotation factor, where the angular
+        // velocity is evaluated once, zero width adds one factor for each normal flow
+        const static double EventNormFlowBinWidth;
+        // evaluate measurement-dependent parts of point-to-surfel and radar residuals in float
+        // (jets) to halve the jet width, the spline evaluation and the solver stay in double
+        const static bool MixedPrecisionResiduals;
+        // compare the first mixed-precision residual block of each batch against the double one,
+        // and warn if residuals or jacobians differ by more than the (relative) tolerance
+        const static bool ValidateMixedPrecision;
+        const static double MixedPrecisionTolerance;
+        // narrow paddings of estimated time offsets and readout times after each batch
+        // optimization to the sigma multiple (of their marginal standard deviations) around the
+        // estimates, but never below the given minimums (s), zero factor disables it
+        const static double TemporalPaddingSigma;
+        const static double TimeOffsetPaddingMin;
+        const static double ReadoutTimePaddingMin;
+        // before batch optimizations, coarse time offsets of sensors with rotation sequences are
+        // found by correlating angular rate magnitudes (resampled at the given rate, Hz) with the
+        // so3 spline. If the correlation coefficient is large enough, the padding is narrowed to
+        // the coarse estimate plus the margin (s), zero margin disables it
+        const static double CoarseTimeOffsetSampleRate;
+        const static double CoarseTimeOffsetMinCorr;
+        const static double CoarseTimeOffsetMargin;
 
         const static std::string SO3_SPLINE, SCALE_SPLINE;
 
@@ -343,12 +623,56 @@ public:
 
         static int AvailableThreads();
 
+        /**
+         * bound OpenMP regions of the process (including ones in thirdparty libraries, e.g., the
+         * ndt registration) to 'ThreadsToUse', and run nested regions serially unless they are
+         * opened by workers of a 'ThreadSplit'. Called once the configure is loaded
+         */
+        static void ApplyThreadBudget();
+
+        /**
+         * split the available threads among concurrent workers of independent tasks. While it
+         * lives, one more level of nested parallel regions is enabled, and a worker that calls
+         * 'EnterWorker' bounds its nested regions, ceres solvings, and 'AvailableThreads' to its
+         * share of the budget, so that overlapped stages do not oversubscribe cores
+         */
+        class ThreadSplit {
+        private:
+            int _maxActiveLevels;
+            int _workers;
+            int _threadsPerWorker;
+
+        public:
+            // 'tasks' caps the number of workers
+            explicit ThreadSplit(int tasks);
+
+            ~ThreadSplit();
+
+            ThreadSplit(const ThreadSplit &) = delete;
+
+            ThreadSplit &operator=(const ThreadSplit &) = delete;
+
+            [[nodiscard]] int Workers() const;
+
+            [[nodiscard]] int ThreadsPerWorker() const;
+
+            // called at the beginning of each task in the parallel region of workers, the returned
+            // binding (if 'NUMAMode' is 'NODE_LOCAL') should live till the task is finished
+            [[nodiscard]] NUMABinding EnterWorker() const;
+        };
+
     public:
         template <class Archive>
         void serialize(Archive &ar) {
             ar(CEREAL_NVP(UseCudaInSolving), cereal::make_nvp("Outputs", OutputsStr),
                cereal::make_nvp("OutputDataFormat", OutputDataFormatStr), CEREAL_NVP(ThreadsToUse),
-               CEREAL_NVP(SplineScaleInViewer), CEREAL_NVP(CoordSScaleInViewer));
+               CEREAL_NVP(CacheCalibData), CEREAL_NVP(TargetInfoPerSecond),
+               CEREAL_NVP(InProcessSfM), CEREAL_NVP(SaveCheckpoints),
+               CEREAL_NVP(ResumeFromStage), CEREAL_NVP(WarmStartParamPath),
+               CEREAL_NVP(WarmStartSplinePath), CEREAL_NVP(DiagnosticFrameStride),
+               CEREAL_NVP(AsyncLogging), cereal::make_nvp("ViewerMode", ViewerModeStr),
+               CEREAL_NVP(SplineScaleInViewer),
+               CEREAL_NVP(CoordSScaleInViewer));
         }
     } preference;
 
@@ -370,6 +694,15 @@ public:
 
     static std::string GetFormatExtension();
 
+    // 'COLUMNAR': time-series by-products are written as columnar files (see 'ColumnarWriter'),
+    // and the other ones are serialized in the 'BINARY' format
+    [[nodiscard]] static bool IsColumnarOutput();
+
+    static std::string GetColumnarExtension();
+
+    // whether color images of cameras are required by enabled outputs (see 'CalibSolverIO')
+    [[nodiscard]] static bool IsColorImageRequired();
+
     [[nodiscard]] static bool IsLiDARIntegrated();
 
     [[nodiscard]] static bool IsPosCameraIntegrated();
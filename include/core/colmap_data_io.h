@@ -36,6 +36,7 @@
 #define IKALIBR_COLMAP_DATA_IO_H
 
 #include "util/utils.h"
+#include "functional"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -185,6 +186,30 @@ public:
     static std::map<image_t, Image> ReadImagesText(const std::string &path);
 
     static std::map<point3D_t, Point3D> ReadPoints3DText(const std::string &path);
+
+    // readers for the binary model, i.e., 'cameras.bin', 'images.bin', and 'points3D.bin'
+    static std::map<camera_t, Camera> ReadCamerasBinary(const std::string &path);
+
+    static std::map<image_t, Image> ReadImagesBinary(const std::string &path);
+
+    static std::map<point3D_t, Point3D> ReadPoints3DBinary(const std::string &path);
+
+    /**
+     * stream images in 'images.bin' one by one, only the current image is kept in memory, which is
+     * passed to the handler
+     */
+    static void ForEachImageBinary(const std::string &path,
+                                   const std::function<void(const Image &)> &handler);
+
+    /**
+     * stream points in 'points3D.bin' one by one, only the current point is kept in memory, which
+     * is passed to the handler
+     */
+    static void ForEachPoint3DBinary(
+        const std::string &path, const std::function<void(point3D_t, const Point3D &)> &handler);
+
+    // the number of parameters of the camera model in colmap
+    static std::size_t CameraModelParamsCount(int modelId);
 };
 }  // namespace ns_ikalibr
 
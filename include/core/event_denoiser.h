@@ -0,0 +1,98 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_EVENT_DENOISER_H
+#define IKALIBR_EVENT_DENOISER_H
+
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+class EventArray;
+using EventArrayPtr = std::shared_ptr<EventArray>;
+
+/**
+ * removes noise events of a time-ordered event sequence before any processing, three filters are
+ * performed in a single pass over the packed (structure-of-arrays) events:
+ * (1) hot pixels, whose event counts in the first seconds are outliers, are removed entirely;
+ * (2) the refractory-period filter, which removes bursts of events at the same pixel;
+ * (3) the background-activity filter (BAF), which removes events that are not supported by any
+ *     recent event in the 8-neighborhood
+ */
+class EventDenoiser {
+public:
+    using Ptr = std::shared_ptr<EventDenoiser>;
+
+    struct Report {
+        std::size_t rawCount = 0;
+        std::size_t hotPixelCount = 0;
+        std::size_t byHotPixel = 0;
+        std::size_t byRefractory = 0;
+        std::size_t byBackgroundActivity = 0;
+
+        [[nodiscard]] std::size_t RemovedCount() const;
+
+        [[nodiscard]] double ReductionRatio() const;
+    };
+
+private:
+    // the time (s) to learn the hot pixel map, and the refractory period (s)
+    const double _hotPixelLearnTime;
+    const double _refractoryPeriod;
+    // the time window (s) in which a neighboring event supports an event in BAF
+    const double _bafTimeWindow;
+
+public:
+    EventDenoiser(double hotPixelLearnTime, double refractoryPeriod, double bafTimeWindow);
+
+    static Ptr Create(double hotPixelLearnTime, double refractoryPeriod, double bafTimeWindow);
+
+    // create a denoiser using the options in 'Configor::Preference'
+    static Ptr CreateFromConfigor();
+
+    // filters are disabled by non-positive parameters, empty arrays after filtering are removed
+    Report Denoise(std::vector<EventArrayPtr> &data) const;
+
+protected:
+    [[nodiscard]] std::vector<std::uint8_t> LearnHotPixels(const std::vector<EventArrayPtr> &data,
+                                                           int width,
+                                                           int height,
+                                                           std::size_t &hotPixelCount) const;
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_EVENT_DENOISER_H
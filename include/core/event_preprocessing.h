@@ -65,6 +65,21 @@ private:
 
     cv::Mat _eventImgMat;
 
+    // the side length of tiles (in pixels) to track regions of the sae updated by events
+    constexpr static int TILE_SIZE = 32;
+    int _tileCols, _tileRows;
+    // whether a tile of the sae is updated since the last refresh of the surfaces
+    std::vector<std::uint8_t> _dirtyTiles;
+    bool _anyDirty;
+
+    /**
+     * surfaces of both polarities merged in one pass, which are refreshed only on dirty tiles:
+     * the most recent timestamps (CV_64FC1), and the polarities of them (CV_8UC1, 1 for positive
+     * ones and 0 for negative ones)
+     */
+    cv::Mat _stampMat;
+    cv::Mat _polarityMat;
+
 public:
     explicit ActiveEventSurface(const ns_veta::PinholeIntrinsicPtr &intri, double filterThd = 0.01);
 
@@ -72,8 +87,16 @@ public:
 
     void GrabEvent(const Event::Ptr &event, bool drawEventMat = false);
 
+    void GrabEvent(double et,
+                   std::uint16_t ex,
+                   std::uint16_t ey,
+                   bool ep,
+                   bool drawEventMat = false);
+
     void GrabEvent(const EventArray::Ptr &events, bool drawEventMat = false);
 
+    void GrabEvent(const EventArraySpan &events, bool drawEventMat = false);
+
     [[nodiscard]] cv::Mat GetEventImgMat(bool resetMat, bool undistoMat = false);
 
     cv::Mat TimeSurface(bool ignorePolarity = false,
@@ -85,6 +108,9 @@ public:
                                                bool undistoMat = false);
 
     [[nodiscard]] double GetTimeLatest() const;
+
+protected:
+    void RefreshSurfaces();
 };
 
 struct NormFlow;
@@ -130,6 +156,17 @@ public:
 protected:
     static std::vector<std::tuple<double, double, double>> Centralization(
         const std::vector<std::tuple<int, int, double>> &inRangeData);
+
+    static void Centralization(const std::vector<std::tuple<int, int, double>> &inRangeData,
+                               std::vector<std::tuple<double, double, double>> &centeredData);
+
+    /**
+     * a cheap prefilter before the ransac-based plane fitting, which rejects neighborhoods that
+     * are far from planar using the closed-form least-squares plane
+     */
+    static bool IsRoughlyPlanar(const std::vector<std::tuple<double, double, double>> &centeredData,
+                                double timeDistEventToPlaneThd,
+                                double goodRatioThd);
 };
 
 class EventLocalPlaneSacProblem : public opengv::sac::SampleConsensusProblem<Eigen::Vector3d> {
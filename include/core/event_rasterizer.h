@@ -0,0 +1,113 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_EVENT_RASTERIZER_H
+#define IKALIBR_EVENT_RASTERIZER_H
+
+#include "util/utils.h"
+#include "opencv2/core.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_veta {
+struct PinholeIntrinsic;
+using PinholeIntrinsicPtr = std::shared_ptr<PinholeIntrinsic>;
+}  // namespace ns_veta
+
+namespace ns_ikalibr {
+class EventArraySpan;
+
+// images of events binned in a single pass
+struct EventRaster {
+public:
+    // the reference time, all times stored in 'latestMat' are relative to it
+    double refTime{};
+    // the number of events at pixels (CV_32SC1)
+    cv::Mat countMat;
+    // the number of positive events minus the number of negative events at pixels (CV_32SC1)
+    cv::Mat polarityMat;
+    // the time of the latest event at pixels (CV_32FC1), and its polarity (CV_8UC1, 0 or 1)
+    cv::Mat latestMat;
+    cv::Mat latestPolarityMat;
+
+public:
+    // exponential-decayed time surface (CV_8UC1) at the time of the latest event in this raster
+    [[nodiscard]] cv::Mat TimeSurface(double decaySec = 0.02) const;
+
+    // the event frame (CV_8UC3) in the style of 'EventArray::DrawRawEventFrame'
+    [[nodiscard]] cv::Mat EventFrame() const;
+};
+
+/**
+ * bins the structure-of-arrays events of a span into count, polarity and latest-time images in one
+ * pass, which is performed by an OpenCL kernel (with atomics) if enabled and available, otherwise
+ * on the cpu
+ */
+class EventRasterizer {
+public:
+    using Ptr = std::shared_ptr<EventRasterizer>;
+
+private:
+    const int _width, _height;
+    const bool _useOpenCL;
+
+public:
+    EventRasterizer(int width, int height);
+
+    static Ptr Create(int width, int height);
+
+    static Ptr Create(const ns_veta::PinholeIntrinsicPtr &intri);
+
+    [[nodiscard]] EventRaster Rasterize(const EventArraySpan &span) const;
+
+protected:
+    void RasterizeOnCPU(const EventArraySpan &span, EventRaster &raster) const;
+
+    [[nodiscard]] bool RasterizeOnOpenCL(const EventArraySpan &span, EventRaster &raster) const;
+
+    /**
+     * the time (relative, non-negative float) and the polarity of an event are packed into an int,
+     * where the polarity takes the lowest mantissa bit. For non-negative floats, the order of
+     * their bits (as ints) is the same as the order of them, thus the latest event of a pixel is
+     * found by an (atomic) int max
+     */
+    static int PackTimePolarity(float time, bool polarity);
+
+    static void UnpackTimePolarity(const cv::Mat &packed, EventRaster &raster);
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_EVENT_RASTERIZER_H
@@ -38,6 +38,7 @@
 #include "utility"
 #include "util/utils.h"
 #include "veta/camera/pinhole.h"
+#include "core/visual_distortion.h"
 #include "opencv2/features2d.hpp"
 
 namespace {
@@ -77,6 +78,12 @@ using FeatureVecMap = std::map<int, FeatureVec>;
 using FeatureIdVec = std::vector<int>;
 using FeatureMatch = std::map<int, int>;
 
+// key points and their descriptors detected in a frame, cached as derived data of the frame
+struct FrameKeyPoints {
+    std::vector<cv::KeyPoint> kps;
+    cv::Mat descriptor;
+};
+
 class FeatureTracking {
 public:
     using Ptr = std::shared_ptr<FeatureTracking>;
@@ -109,6 +116,8 @@ protected:
 
     // visual intrinsics
     ns_veta::PinholeIntrinsic::Ptr _intri;
+    // the undistortion table of the intrinsics, refreshed for each grabbed image
+    VisualUndistortionLUT::Ptr _undistoLUT;
     // the last image
     CameraFramePtr _imgLast;
     // feature id, raw feature, undistorted feature in the last image
@@ -180,6 +189,32 @@ class LKFeatureTracking : public FeatureTracking {
 public:
     using Ptr = std::shared_ptr<LKFeatureTracking>;
 
+protected:
+    // the window size and the max pyramid level of the lk optical flow
+    constexpr static int LK_WIN_SIZE = 21;
+    constexpr static int LK_MAX_LEVEL = 5;
+    // the max distance (pixel) between the raw and the forward-backward tracked features
+    constexpr static float FB_CHECK_THD = 0.5f;
+    // the search radius (pixel) of a feature predicted by the rotation prior, i.e., the base one
+    // (for the unknown translation) plus the ratio of the predicted displacement
+    constexpr static float PRIOR_RADIUS_BASE = 3.0f;
+    constexpr static float PRIOR_RADIUS_RATIO = 0.25f;
+
+    /**
+     * derived data of a frame for optical flow, i.e., the image pyramid for the cpu backend, and
+     * the image uploaded to the device for the OpenCL backend, they are built once for a frame,
+     * and reused in forward and backward tracking, and when the frame is the last one then
+     */
+    struct FlowFrame {
+        CameraFramePtr frame;
+        // cached as derived data of the frame
+        std::shared_ptr<const std::vector<cv::Mat>> pyramid;
+        cv::UMat image;
+    };
+
+    bool _useOpenCL;
+    FlowFrame _flowFrameLast;
+
 public:
     explicit LKFeatureTracking(int featNumPerImg,
                                int minDist,
@@ -206,6 +241,32 @@ protected:
                             FeatureIdVec& ptsCurIdVec,
                             std::vector<uchar>& status,
                             int& ptsIdCounter) override;
+
+    FlowFrame BuildFlowFrame(const CameraFramePtr& frame) const;
+
+    void CalcOpticalFlow(const FlowFrame& from,
+                         const FlowFrame& to,
+                         const std::vector<cv::Point2f>& ptsFromVec,
+                         std::vector<cv::Point2f>& ptsToVec,
+                         std::vector<uchar>& status,
+                         int winSize = LK_WIN_SIZE,
+                         int maxLevel = LK_MAX_LEVEL) const;
+
+    /**
+     * group features predicted by the rotation prior by their lk parameters [window size, pyramid
+     * level], which are chosen from search radii of predictions, confident predictions are tracked
+     * using small windows and few levels
+     */
+    static std::map<std::pair<int, int>, std::vector<int>> GroupByPredictions(
+        const std::vector<cv::Point2f>& ptsLastVec, const std::vector<cv::Point2f>& ptsPredVec);
+
+    // track features group by group, see 'GroupByPredictions'
+    void CalcOpticalFlowInGroups(const FlowFrame& from,
+                                 const FlowFrame& to,
+                                 const std::map<std::pair<int, int>, std::vector<int>>& groups,
+                                 const std::vector<cv::Point2f>& ptsFromVec,
+                                 std::vector<cv::Point2f>& ptsToVec,
+                                 std::vector<uchar>& status) const;
 };
 
 class DescriptorBasedFeatureTracking : public FeatureTracking {
@@ -249,6 +310,13 @@ protected:
                                            int featCountDesired,
                                            std::vector<cv::KeyPoint>& kps,
                                            cv::Mat& descriptor) = 0;
+
+    // the key of detected key points in the derived data of frames
+    [[nodiscard]] virtual std::string KeyPointsKey(int featCountDesired) const = 0;
+
+    // detect key points of the frame (without mask), which are detected only once for a frame
+    std::shared_ptr<const FrameKeyPoints> ObtainKeyPoints(const CameraFramePtr& frame,
+                                                          int featCountDesired);
 };
 
 class ORBFeatureTracking : public DescriptorBasedFeatureTracking {
@@ -274,6 +342,8 @@ protected:
                                    int featCountDesired,
                                    std::vector<cv::KeyPoint>& kps,
                                    cv::Mat& descriptor) override;
+
+    [[nodiscard]] std::string KeyPointsKey(int featCountDesired) const override;
 };
 
 class AKAZEFeatureTracking : public DescriptorBasedFeatureTracking {
@@ -293,12 +363,17 @@ public:
         const ns_veta::PinholeIntrinsic::Ptr& intri,
         const cv::Ptr<cv::DescriptorMatcher>& matcher = cv::BFMatcher::create(cv::NORM_HAMMING));
 
+    // detect AKAZE key points of the frame, which are shared with the structure from motion
+    static std::shared_ptr<const FrameKeyPoints> DetectKeyPoints(const CameraFramePtr& frame);
+
 protected:
     void DetectAndComputeKeyPoints(const cv::Mat& img,
                                    const cv::Mat& mask,
                                    int featCountDesired,
                                    std::vector<cv::KeyPoint>& kps,
                                    cv::Mat& descriptor) override;
+
+    [[nodiscard]] std::string KeyPointsKey(int featCountDesired) const override;
 };
 }  // namespace ns_ikalibr
 
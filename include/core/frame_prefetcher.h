@@ -0,0 +1,89 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_FRAME_PREFETCHER_H
+#define IKALIBR_FRAME_PREFETCHER_H
+
+#include "config/configor.h"
+#include "vector"
+#include "mutex"
+#include "thread"
+#include "condition_variable"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+class CameraFrame;
+using CameraFramePtr = std::shared_ptr<CameraFrame>;
+
+/**
+ * the decode stage of the feature tracking pipeline: a worker thread decodes (lazy) camera frames
+ * ahead of the consumer. At most 'depth' frames are decoded ahead, which works as a bounded queue
+ * between the decode stage and the tracking stage, and keeps the decoded frames in the lazy cache
+ */
+class FramePrefetcher {
+public:
+    using Ptr = std::shared_ptr<FramePrefetcher>;
+
+private:
+    const std::vector<CameraFramePtr> _frames;
+    const int _depth;
+
+    // the count of decoded frames, and the index of the frame being consumed
+    int _decoded;
+    int _consumed;
+    bool _stop;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::thread _worker;
+
+public:
+    FramePrefetcher(std::vector<CameraFramePtr> frames, int depth);
+
+    static Ptr Create(const std::vector<CameraFramePtr> &frames, int depth);
+
+    // block until the 'idx'-th frame is decoded, frames before it would not be requested anymore
+    CameraFramePtr Acquire(int idx);
+
+    virtual ~FramePrefetcher();
+
+protected:
+    void Decode();
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_FRAME_PREFETCHER_H
@@ -105,6 +105,12 @@ public:
     // trans degree angle to radian angle
     constexpr static double DEG_TO_RAD = M_PI / 180.0;
 
+    // packed record sizes of the binary haste files, there is no padding between fields
+    // event: time (float), x (uint16_t), y (uint16_t), polarity (boolean)
+    constexpr static std::size_t EVENT_RECORD_SIZE = 9;
+    // seed and tracking result: t (float), x (float), y (float), theta (float), id (uint64_t)
+    constexpr static std::size_t SEED_RECORD_SIZE = 24;
+
     // batch index, tracking results in a batch
     using TrackingResultsType = std::map<int, FeatureVecMap>;
 
@@ -162,6 +168,17 @@ struct EventTrackingFilter {
     static void FilterByTrackingAge(FeatureVecMap &tracking, double acceptedTrackedThdCompBest);
 
     static void FilterByTrackingFreq(FeatureVecMap &tracking, double acceptedTrackedThdCompBest);
+
+    /**
+     * performs 'FilterByTrackingLength', 'FilterByTraceFittingSAC', 'FilterByTrackingAge', and
+     * 'FilterByTrackingFreq' in order, with the same results, but the statistics of each filter
+     * are accumulated while the previous one traverses, and tracks are erased only once
+     */
+    static void FilterTracking(FeatureVecMap &tracking,
+                               double lenThdCompBest,
+                               double sacThd,
+                               double ageThdCompBest,
+                               double freqThdCompBest);
 };
 }  // namespace ns_ikalibr
 
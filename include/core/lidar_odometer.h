@@ -38,7 +38,8 @@
 #include "util/utils.h"
 #include "util/cloud_define.hpp"
 #include "ctraj/core/pose.hpp"
-#include "pclomp/ndt_omp.hpp"
+#include "core/scan_registration.h"
+#include "deque"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -55,17 +56,27 @@ public:
 private:
     float _ndtResolution;
     int _threads;
+    // the number of latest key frames in the local map (the ndt target), zero for the global map
+    std::size_t _localMapKeyFrames;
 
     // the key frame index in the '_frames'
     std::vector<std::size_t> _keyFrameIdx;
     std::vector<LiDARFramePtr> _frames;
 
+    // the state of the last key frame
+    Eigen::Vector3d _lastKeyFramePos;
+    Eigen::Vector3d _lastKeyFrameYPR;
+
     // the global map
     IKalibrPointCloud::Ptr _map;
     double _mapTime;
 
-    // ndt
-    pclomp::NormalDistributionsTransform<IKalibrPoint, IKalibrPoint>::Ptr _ndt;
+    // key frame clouds (in the map frame) in the local map, and the local map
+    std::deque<IKalibrPointCloud::Ptr> _localMapFrames;
+    IKalibrPointCloud::Ptr _localMap;
+
+    // the registration backend, ndt by default
+    ScanRegistration::Ptr _registration;
 
     bool _initialized;
 
@@ -73,9 +84,19 @@ private:
     std::vector<ns_ctraj::Posed> _poseSeq;
 
 public:
-    LiDAROdometer(float ndtResolution, int threads);
-
-    static LiDAROdometer::Ptr Create(float ndtResolution, int threads);
+    /**
+     * @param registration the registration backend, if it is nullptr, the one specified in the
+     * configor would be created
+     */
+    LiDAROdometer(float ndtResolution,
+                  int threads,
+                  std::size_t localMapKeyFrames = 0,
+                  ScanRegistration::Ptr registration = nullptr);
+
+    static LiDAROdometer::Ptr Create(float ndtResolution,
+                                     int threads,
+                                     std::size_t localMapKeyFrames = 0,
+                                     const ScanRegistration::Ptr &registration = nullptr);
 
     ns_ctraj::Posed FeedFrame(const LiDARFramePtr &frame,
                               const Eigen::Matrix4d &predCurToLast = Eigen::Matrix4d::Identity(),
@@ -92,10 +113,12 @@ public:
 
     [[nodiscard]] const IKalibrPointCloud::Ptr &GetMap() const;
 
+    // the ndt target, which is the same as the global map if the local map is not bounded
+    [[nodiscard]] const IKalibrPointCloud::Ptr &GetLocalMap() const;
+
     [[nodiscard]] const std::vector<LiDARFramePtr> &GetFramesVec() const;
 
-    [[nodiscard]] const pclomp::NormalDistributionsTransform<IKalibrPoint, IKalibrPoint>::Ptr &
-    GetNdt() const;
+    [[nodiscard]] const ScanRegistration::Ptr &GetRegistration() const;
 
     [[nodiscard]] double GetMapTime() const;
 
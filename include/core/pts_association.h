@@ -37,8 +37,12 @@
 
 #include "config/configor.h"
 #include "util/cloud_define.hpp"
+#include "factor/data_correspondence.h"
 #include "ufo/map/point_cloud.h"
 #include "ufo/map/surfel_map.h"
+#include "random"
+#include "mutex"
+#include "optional"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -46,9 +50,6 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
-struct PointToSurfelCorr;
-using PointToSurfelCorrPtr = std::shared_ptr<PointToSurfelCorr>;
-
 struct PointToSurfelCondition {
     double pointToSurfelMax;
     std::uint8_t queryDepthMin;
@@ -81,43 +82,172 @@ public:
 protected:
     ufo::map::SurfelMap _smp;
 
+    /**
+     * the moments of points in a node, which are expressed relative to the min corner of the node
+     */
+    struct SurfelMoments {
+        std::uint32_t count = 0;
+        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+        // the upper triangle of the sum of outer products: [xx, xy, xz, yy, yz, zz]
+        Eigen::Matrix<double, 6, 1> sumSquares = Eigen::Matrix<double, 6, 1>::Zero();
+
+        void Add(const Eigen::Vector3d &p);
+
+        void Remove(const Eigen::Vector3d &p);
+
+        // accumulate moments of a child node, whose min corner is 'offset' from the one of this
+        void Merge(const SurfelMoments &child, const Eigen::Vector3d &offset);
+
+        // the planarity (the same definition as ufo surfels) and the plane coefficients
+        [[nodiscard]] std::optional<std::pair<double, Eigen::Vector4d>> Surfel(
+            const Eigen::Vector3d &origin) const;
+    };
+
+    /**
+     * in the compact mode (see 'Configor::Preference::CompactSurfelMap'), only moments of points
+     * in leaf nodes are kept in a flat hash grid (keyed by node indices), surfels of coarser nodes
+     * are aggregated from them when the lookup is built, and '_smp' is kept empty, which only
+     * serves the node geometry
+     */
+    bool _compact;
+    std::unordered_map<std::uint64_t, SurfelMoments> _leaves;
+
+    /**
+     * candidate surfels of each cell (node at 'queryDepthMin') in the map, i.e., the qualified
+     * surfels containing this cell across query depths, which are sorted by their scores. It is
+     * built once for a condition, and invalidated once the surfel map is updated
+     */
+    struct SurfelLookup {
+        PointToSurfelCondition condition;
+        double cellSize;
+        // the qualified surfels
+        std::vector<ufo::map::Node> nodes;
+        std::vector<double> scores;
+        Eigen::aligned_vector<Eigen::Vector4d> coeffs;
+        // indices of candidate surfels of each cell
+        std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> cells;
+
+        [[nodiscard]] std::uint64_t CellKey(float x, float y, float z) const;
+
+        // register a surfel to all cells covered by its node
+        void AddSurfel(const ufo::map::Node &node,
+                       double score,
+                       const Eigen::Vector4d &coeff,
+                       const ufo::map::Point3 &min,
+                       const ufo::map::Point3 &max);
+    };
+    std::shared_ptr<SurfelLookup> _lookup;
+    std::mutex _lookupMutex;
+
 public:
     explicit PointToSurfelAssociator(const IKalibrPointCloud::Ptr &mapInW,
                                      double resolution,
-                                     std::uint8_t depth);
-
-    static Ptr Create(const IKalibrPointCloud::Ptr &mapInW, double resolution, std::uint8_t depth);
-
-    std::vector<PointToSurfelCorrPtr> Association(const IKalibrPointCloud::Ptr &mapCloud,
-                                                  const IKalibrPointCloud::Ptr &rawCloud,
-                                                  const PointToSurfelCondition &condition);
+                                     std::uint8_t depth,
+                                     bool compact = Configor::Preference::CompactSurfelMap);
+
+    static Ptr Create(const IKalibrPointCloud::Ptr &mapInW,
+                      double resolution,
+                      std::uint8_t depth,
+                      bool compact = Configor::Preference::CompactSurfelMap);
+
+    /**
+     * create an associator with an empty surfel map, clouds are inserted by 'UpdateSurfelMap'
+     */
+    explicit PointToSurfelAssociator(double resolution,
+                                     std::uint8_t depth,
+                                     bool compact = Configor::Preference::CompactSurfelMap);
+
+    static Ptr Create(double resolution,
+                      std::uint8_t depth,
+                      bool compact = Configor::Preference::CompactSurfelMap);
+
+    /**
+     * associate a scan, correspondences refer to surfels in a table owned by the returned buffer.
+     * Points in the map are kept in the buffer only if 'withVisualization' is true. Candidate
+     * surfels of points are found in the lookup of the condition (see 'SurfelLookup')
+     */
+    PointToSurfelCorrBuffer::Ptr Association(const IKalibrPointCloud::Ptr &mapCloud,
+                                             const IKalibrPointCloud::Ptr &rawCloud,
+                                             const PointToSurfelCondition &condition,
+                                             bool withVisualization);
+
+    /**
+     * associate scans in parallel, the surfel map is only queried here, each scan owns its
+     * correspondence buffer, which is returned in the order of scans. Scans with null clouds have
+     * no correspondence. If 'candidateCount' is positive, at most this many candidate points are
+     * sampled from each scan before association (see 'SampleCandidates')
+     */
+    std::vector<PointToSurfelCorrBuffer::Ptr> Association(
+        const std::vector<IKalibrPointCloud::Ptr> &mapClouds,
+        const std::vector<IKalibrPointCloud::Ptr> &rawClouds,
+        const PointToSurfelCondition &condition,
+        bool withVisualization,
+        int candidateCount = -1);
+
+    /**
+     * sample at most 'count' candidate points from a scan for association, points are stratified
+     * by the ring, the range, and the map node (with size 'nodeSize') they fall in, and strata are
+     * visited in a round-robin manner, thus the candidates are spread over the scan and the map
+     */
+    static std::pair<IKalibrPointCloud::Ptr, IKalibrPointCloud::Ptr> SampleCandidates(
+        const IKalibrPointCloud::Ptr &mapCloud,
+        const IKalibrPointCloud::Ptr &rawCloud,
+        int count,
+        double nodeSize,
+        std::default_random_engine &engine);
+
+    /**
+     * update the surfel map incrementally, points of 'oldCloud' are erased from the map and ones of
+     * 'newCloud' are inserted, both can be null. Nan points are ignored
+     */
+    void UpdateSurfelMap(const IKalibrPointCloud::Ptr &oldCloud,
+                         const IKalibrPointCloud::Ptr &newCloud);
 
     static double SurfelScore(const ufo::map::SurfelMap &m, const ufo::map::Node &n);
 
+    // the surfel map, which is empty in the compact mode (only the node geometry is valid)
     [[nodiscard]] const ufo::map::SurfelMap &GetSurfelMap() const;
 
+    [[nodiscard]] bool IsCompact() const;
+
 protected:
-    static double PointToSurfel(const ufo::map::SurfelMap::Surfel &s, const ufo::map::Point3 &p);
+    // the surfel lookup of the condition, which is (re)built if it does not exist or mismatches
+    std::shared_ptr<const SurfelLookup> GetSurfelLookup(const PointToSurfelCondition &condition);
 
     static Eigen::Vector4d SurfelCoeffs(const ufo::map::SurfelMap::Surfel &s);
 
-    template <typename PointType>
-    void InsertCloudToSurfelMap(ufo::map::SurfelMap &map, pcl::PointCloud<PointType> &pclCloud) {
-        int cloudSize = pclCloud.size();
+    // insert points to (or erase them from) the leaf moments, for the compact mode
+    void UpdateLeafMoments(const ufo::map::PointCloud &cloud, bool erase);
 
+    // aggregate leaf moments to surfels in query depths and register them, for the compact mode
+    void BuildCompactSurfelLookup(SurfelLookup &lookup) const;
+
+    /**
+     * the valid (non-nan) points, which are sorted in the z-order of nodes with size 'resolution'
+     * (see 'SortInZOrder') if it is positive
+     */
+    template <typename PointType>
+    static ufo::map::PointCloud ValidUFOCloud(const pcl::PointCloud<PointType> &pclCloud,
+                                              double resolution = -1.0) {
         ufo::map::PointCloud ufoCloud;
-        ufoCloud.resize(cloudSize);
-
-#pragma omp parallel for num_threads(omp_get_max_threads()) default(none) \
-    shared(ufoCloud, cloudSize, pclCloud)
-        for (int i = 0; i < cloudSize; i++) {
-            ufoCloud[i].x = pclCloud.points[i].x;
-            ufoCloud[i].y = pclCloud.points[i].y;
-            ufoCloud[i].z = pclCloud.points[i].z;
+        ufoCloud.reserve(pclCloud.size());
+        for (const auto &p : pclCloud.points) {
+            if (!IS_POS_NAN(p)) {
+                ufoCloud.push_back(ufo::map::Point3(p.x, p.y, p.z));
+            }
         }
-
-        map.insertSurfelPoint(std::begin(ufoCloud), std::end(ufoCloud));
+        if (resolution > 0.0) {
+            SortInZOrder(ufoCloud, resolution);
+        }
+        return ufoCloud;
     }
+
+    /**
+     * sort points in the z-order (morton code) of the finest nodes in parallel, thus successive
+     * points inserted into (or erased from) the surfel map share the octree path and the cached
+     * nodes, rather than jumping over the map in the order of acquisition
+     */
+    static void SortInZOrder(ufo::map::PointCloud &cloud, double resolution);
 };
 }  // namespace ns_ikalibr
 #endif  // IKALIBR_PTS_ASSOCIATION_H
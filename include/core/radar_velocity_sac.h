@@ -37,6 +37,9 @@
 
 #include "sensor/radar.h"
 #include "opengv/sac/SampleConsensusProblem.hpp"
+#include "random"
+#include "optional"
+#include "array"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -96,6 +99,56 @@ protected:
     /** The adapter holding all input data */
     const RadarTargetArray::Ptr &_data;
 };
+
+/**
+ * a radar ego-velocity ransac specialized from 'RadarVelocitySacProblem'. Targets are accessed in
+ * the structure-of-arrays layout (see 'RadarTargetSoA'), thus hypotheses are scored by vectorized
+ * doppler residuals, rather than virtual calls and allocations per iteration
+ */
+class RadarVelocitySac {
+public:
+    using Ptr = std::shared_ptr<RadarVelocitySac>;
+
+    // targets are scored in blocks, after which hopeless hypotheses are rejected preemptively
+    constexpr static int SCORE_BLOCK_SIZE = 64;
+
+private:
+    // the array is held so that its targets (in the structure-of-arrays layout) stay valid
+    RadarTargetArray::Ptr _data;
+    const RadarTargetSoA &_soa;
+
+    std::mt19937 _rng;
+
+public:
+    explicit RadarVelocitySac(const RadarTargetArray::Ptr &data,
+                              unsigned int seed = std::mt19937::default_seed);
+
+    static Ptr Create(const RadarTargetArray::Ptr &data,
+                      unsigned int seed = std::mt19937::default_seed);
+
+    /**
+     * estimate the radar velocity from static targets, the sampling terminates early once the
+     * desired probability is reached
+     * @return the velocity refined using inliers, std::nullopt if no valid model is found
+     */
+    std::optional<Eigen::Vector3d> Estimate(double threshold,
+                                            int maxIterations = 20,
+                                            double probability = 0.99);
+
+    [[nodiscard]] int GetTargetCount() const;
+
+protected:
+    // solve the velocity from three targets, false is returned for degenerate samples
+    bool ComputeMinimalModel(const std::array<int, 3> &indices, Eigen::Vector3d &model) const;
+
+    // return the inlier count of the model, or -1 if it can not outperform 'bestCount'
+    [[nodiscard]] int CountInliers(const Eigen::Vector3d &model,
+                                   double threshold,
+                                   int bestCount) const;
+
+    [[nodiscard]] std::optional<Eigen::Vector3d> RefineModel(const Eigen::Vector3d &model,
+                                                             double threshold) const;
+};
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_RADAR_VELOCITY_SAC_H
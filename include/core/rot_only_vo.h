@@ -36,6 +36,7 @@
 #define IKALIBR_ROT_ONLY_VO_H
 
 #include "utility"
+#include "functional"
 #include "util/utils.h"
 #include "opencv2/core.hpp"
 #include "opengv/types.hpp"
@@ -58,6 +59,12 @@ public:
     using FeatTrackingInfo =
         std::map<ns_veta::IndexT, std::list<std::pair<CameraFramePtr, Feature::Ptr>>>;
 
+    // the rotations and tracking information of a continuously tracked piece of frames
+    struct TrackedPiece {
+        std::vector<std::pair<double, Sophus::SO3d>> rotations;
+        FeatTrackingInfo lmTrackInfo;
+    };
+
 private:
     FeatureTracking::Ptr _featTracking;
     ns_veta::PinholeIntrinsic::Ptr _intri;
@@ -69,13 +76,20 @@ private:
     std::map<int, ns_veta::IndexT> _featId2lmIdInLast;
 
     std::vector<std::pair<double, Sophus::SO3d>> _rotations;
+    // whether keep the whole rotation sequence, otherwise only the latest rotation is kept
+    bool _keepRotations;
+
+    // whether show the tracked features, the highgui can only be used in one thread
+    bool _visualize;
 
 public:
     explicit RotOnlyVisualOdometer(FeatureTracking::Ptr featTracking,
-                                   ns_veta::PinholeIntrinsic::Ptr intri);
+                                   ns_veta::PinholeIntrinsic::Ptr intri,
+                                   bool visualize = true);
 
     static Ptr Create(const FeatureTracking::Ptr &featTracking,
-                      const ns_veta::PinholeIntrinsic::Ptr &intri);
+                      const ns_veta::PinholeIntrinsic::Ptr &intri,
+                      bool visualize = true);
 
     bool GrabFrame(const CameraFramePtr &curFrame,
                    const std::optional<Sophus::SO3d> &SO3_LastToCur = std::nullopt);
@@ -90,6 +104,23 @@ public:
 
     void ResetWorkspace();
 
+    // once the rotation sequence is not required anymore, e.g., the extrinsic rotation is
+    // recovered, only the latest rotation is maintained, the feature tracking is not affected
+    void KeepRotationSequence(bool keep);
+
+    /**
+     * track frames in overlapping chunks ('chunkSize' frames, and 'overlap' frames shared with the
+     * next chunk) in parallel using independent odometers created by 'trackerCreator', rotations
+     * of neighboring chunks are stitched via their overlapped frames. Pieces are split where the
+     * tracking fails or two neighboring chunks can not be stitched
+     */
+    static std::vector<TrackedPiece> TrackInChunks(
+        const std::vector<CameraFramePtr> &frames,
+        const std::function<FeatureTracking::Ptr()> &trackerCreator,
+        const ns_veta::PinholeIntrinsic::Ptr &intri,
+        int chunkSize,
+        int overlap);
+
     static std::pair<opengv::rotation_t, std::vector<int>> RelRotationRecovery(
         const std::vector<Eigen::Vector2d> &featUndisto1,
         const std::vector<Eigen::Vector2d> &featUndisto2,
@@ -110,6 +141,12 @@ protected:
 
     static ns_veta::IndexT GenNewLmId();
 
+    // stitch 'next' to 'last' if they share enough frames, 'last' is trimmed at the head of 'next'
+    static bool StitchPieces(TrackedPiece &last, TrackedPiece &next, int sharedMin);
+
+    // erase rotations and tracked features of frames stamped at or after 'time' from the piece
+    static void TrimPiece(TrackedPiece &piece, double time);
+
     template <class Type>
     static void ReduceVector(std::vector<Type> &v, std::vector<uchar> status) {
         int j = 0;
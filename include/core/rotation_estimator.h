@@ -38,6 +38,7 @@
 #include "config/configor.h"
 #include "ctraj/core/spline_bundle.h"
 #include "ctraj/core/pose.hpp"
+#include "deque"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,10 +55,22 @@ public:
     // t1, t2, rotation from the t2 frame to the t1 frame
     using RelRotationSequence = std::vector<std::tuple<double, double, Sophus::SO3d>>;
 
+    constexpr static double DEG_TO_RAD = M_PI / 180.0;
+
 private:
     bool _solveFlag;
     Sophus::SO3d _sensorToSpline;
 
+    // states of the incremental estimation: the accumulated normal matrix (sum of 'A^T * A'), the
+    // number of coefficient matrices in it, and the count and head time of the involved sequence
+    Eigen::Matrix4d _normalMat;
+    std::size_t _coeffMatCount;
+    std::size_t _involvedCount;
+    double _headTime;
+
+    // the recent successful solutions, to check the stability of the incremental estimation
+    std::deque<Sophus::SO3d> _recentSolutions;
+
 public:
     RotationEstimator();
 
@@ -69,14 +82,50 @@ public:
 
     void Estimate(const So3SplineType &spline, const std::vector<ns_ctraj::Posed> &poseSeq);
 
+    /**
+     * incremental estimation for a growing sequence, only items appended since the last call are
+     * organized and accumulated into the normal matrix, which is then solved. If the sequence is
+     * reset (shrunk or with a different head), the accumulation restarts. The same kind of sequence
+     * should be passed in successive calls
+     */
+    void EstimateIncrementally(const So3SplineType &spline, const RotationSequence &rotSeq);
+
+    void EstimateIncrementally(const So3SplineType &spline, const RelRotationSequence &relRotSeq);
+
+    void EstimateIncrementally(const So3SplineType &spline,
+                               const std::vector<ns_ctraj::Posed> &poseSeq);
+
+    /**
+     * relative rotations of consecutive poses, which are stamped by the spline (i.e., shifted by
+     * the time offset), and the ones out of the time range [st, et] are dropped
+     */
+    static RelRotationSequence RelRotations(const std::vector<ns_ctraj::Posed> &poseSeq,
+                                            double timeOffset,
+                                            double st,
+                                            double et);
+
     [[nodiscard]] bool SolveStatus() const;
 
     [[nodiscard]] const Sophus::SO3d &GetSO3SensorToSpline() const;
 
+    /**
+     * whether the last 'count' successful solutions agree with each other, i.e., rotations between
+     * them are all below 'thd' (degree). Solutions of successive incremental estimations are
+     * recorded, even if the accumulation restarts
+     */
+    [[nodiscard]] bool Stable(std::size_t count, double thd) const;
+
 protected:
     static std::vector<Eigen::Matrix4d> OrganizeCoeffMatSeq(const So3SplineType &spline,
                                                             const RotationSequence &rotSeq);
 
+    // restart the accumulation if the sequence is not the one accumulated before
+    void CheckIncrementalState(std::size_t seqSize, double headTime);
+
+    void AccumulateAndSolve(const So3SplineType &spline, const RelRotationSequence &newRelRotSeq);
+
+    void RecordSolution();
+
     static std::vector<Eigen::Matrix4d> OrganizeCoeffMatSeq(const So3SplineType &spline,
                                                             const RelRotationSequence &relRotSeq);
 };
@@ -0,0 +1,190 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_SCAN_REGISTRATION_H
+#define IKALIBR_SCAN_REGISTRATION_H
+
+#include "config/configor.h"
+#include "util/cloud_define.hpp"
+#include "pclomp/ndt_omp.hpp"
+#include "pclomp/voxel_grid_covariance_omp.hpp"
+#include "unordered_map"
+#include "mutex"
+#include "map"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * the registration backend of the lidar odometer, which aligns (down sampled) scans to a target
+ * map that is updated incrementally
+ */
+class ScanRegistration {
+public:
+    using Ptr = std::shared_ptr<ScanRegistration>;
+
+public:
+    virtual ~ScanRegistration() = default;
+
+    /**
+     * create a registration backend
+     * @param type the backend type
+     * @param resolution the voxel resolution of the target
+     * @param threads the thread count for registration
+     */
+    static Ptr Create(ScanRegistrationType type, float resolution, int threads);
+
+    /**
+     * update the target, compared to the last target, only 'inserted' and 'removed' changed
+     */
+    virtual void UpdateTarget(const IKalibrPointCloud::Ptr &target,
+                              const IKalibrPointCloud &inserted,
+                              const IKalibrPointCloud &removed) = 0;
+
+    /**
+     * align the source scan to the target
+     * @param source the (down sampled) source scan
+     * @param timestamp the timestamp of the scan, which is the key of states cached for the scan
+     * @param guess the initial guess from the source to the target
+     * @return the estimated transformation from the source to the target
+     */
+    virtual Eigen::Matrix4d Align(const IKalibrPointCloud::Ptr &source,
+                                  double timestamp,
+                                  const Eigen::Matrix4d &guess) = 0;
+
+    /**
+     * create a backend with the same settings and an empty target, states cached for scans (if
+     * any) are shared, which is used when odometry is performed on the same scans again
+     */
+    [[nodiscard]] virtual Ptr Renew() const = 0;
+};
+
+/**
+ * the normal distributions transform (pclomp) backend
+ */
+class NDTScanRegistration : public ScanRegistration {
+public:
+    using Ptr = std::shared_ptr<NDTScanRegistration>;
+    using NDTType = pclomp::NormalDistributionsTransform<IKalibrPoint, IKalibrPoint>;
+
+protected:
+    NDTType::Ptr _ndt;
+    int _threads;
+
+public:
+    NDTScanRegistration(float resolution, int threads);
+
+    static Ptr Create(float resolution, int threads);
+
+    void UpdateTarget(const IKalibrPointCloud::Ptr &target,
+                      const IKalibrPointCloud &inserted,
+                      const IKalibrPointCloud &removed) override;
+
+    Eigen::Matrix4d Align(const IKalibrPointCloud::Ptr &source,
+                          double timestamp,
+                          const Eigen::Matrix4d &guess) override;
+
+    [[nodiscard]] ScanRegistration::Ptr Renew() const override;
+
+    [[nodiscard]] const NDTType::Ptr &GetNdt() const;
+};
+
+/**
+ * the voxelized generalized icp backend, where each source point (with its local covariance) is
+ * associated to the target voxel it falls in, and the distribution-to-distribution distances are
+ * minimized using gauss-newton. Source covariances are cached for each scan, keyed by the
+ * timestamp and the voxel of points, thus they are reused when the scan (slightly changed, e.g.,
+ * undistorted) is registered again
+ */
+class VGICPScanRegistration : public ScanRegistration {
+public:
+    using Ptr = std::shared_ptr<VGICPScanRegistration>;
+
+protected:
+    using VoxelKey = std::array<int, 3>;
+
+    struct VoxelKeyHash {
+        std::size_t operator()(const VoxelKey &key) const {
+            return static_cast<std::size_t>((key[0] * 73856093L) ^ (key[1] * 19349663L) ^
+                                            (key[2] * 83492791L));
+        }
+    };
+
+    struct CovarianceCache {
+        std::mutex mutex;
+        // timestamp, [voxel key, covariance]
+        std::map<double, std::unordered_map<VoxelKey, Eigen::Matrix3d, VoxelKeyHash>> covs;
+    };
+
+    // the number of neighbors to compute source covariances
+    static constexpr int CovNeighborCount = 10;
+    static constexpr int MaxIterations = 30;
+    static constexpr double ConvergenceEpsilon = 1E-4;
+
+    float _resolution;
+    int _threads;
+    pclomp::VoxelGridCovariance<IKalibrPoint> _targetCells;
+    bool _targetInitialized;
+    std::shared_ptr<CovarianceCache> _covCache;
+
+public:
+    VGICPScanRegistration(float resolution, int threads);
+
+    static Ptr Create(float resolution, int threads);
+
+    void UpdateTarget(const IKalibrPointCloud::Ptr &target,
+                      const IKalibrPointCloud &inserted,
+                      const IKalibrPointCloud &removed) override;
+
+    Eigen::Matrix4d Align(const IKalibrPointCloud::Ptr &source,
+                          double timestamp,
+                          const Eigen::Matrix4d &guess) override;
+
+    [[nodiscard]] ScanRegistration::Ptr Renew() const override;
+
+protected:
+    /**
+     * the covariances of source points, cached ones are reused, and the new ones are cached
+     */
+    std::vector<Eigen::Matrix3d> SourceCovariances(const IKalibrPointCloud::Ptr &source,
+                                                   double timestamp);
+
+    [[nodiscard]] VoxelKey KeyOf(const IKalibrPoint &p) const;
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_SCAN_REGISTRATION_H
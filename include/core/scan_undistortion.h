@@ -86,13 +86,30 @@ public:
                                               Option option);
 
 protected:
-    std::optional<LiDARFramePtr> UndistortToScan(const LiDARFramePtr &lidarFrame,
-                                                 const std::string &topic,
-                                                 bool correctPos);
-
-    std::optional<LiDARFramePtr> UndistortToRef(const LiDARFramePtr &lidarFrame,
-                                                const std::string &topic,
-                                                bool correctPos);
+    std::vector<LiDARFramePtr> UndistortFrames(const std::vector<LiDARFramePtr> &data,
+                                               const std::string &topic,
+                                               bool correctPos,
+                                               bool toRef) const;
+
+    /**
+     * undistort a single frame, points are transformed to the world frame if 'toRef' is set,
+     * otherwise to the lidar frame at the scan time
+     */
+    std::optional<LiDARFramePtr> UndistortFrame(const LiDARFramePtr &lidarFrame,
+                                                double TO_LkToBr,
+                                                const Sophus::SE3d &SE3_LkToBr,
+                                                bool correctPos,
+                                                bool toRef) const;
+
+    /**
+     * poses from the lidar to the world at the given sorted times (in the time line of the
+     * reference imu), if 'UndistortionSampleInterval' is positive, the spline is sampled at this
+     * interval and the poses in between are interpolated on SE3
+     */
+    std::vector<Sophus::SE3d> LiDARPosesAtTimes(const std::vector<double> &timesByBr,
+                                                const Sophus::SE3d &SE3_LkToBr) const;
+
+    [[nodiscard]] bool TimeStampInRange(double timeByBr) const;
 };
 }  // namespace ns_ikalibr
 
@@ -0,0 +1,107 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_VETA_LANDMARK_PRUNER_H
+#define IKALIBR_VETA_LANDMARK_PRUNER_H
+
+#include "util/utils.h"
+#include "config/configor.h"
+#include "veta/camera/pinhole.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_veta {
+struct Veta;
+using VetaPtr = std::shared_ptr<Veta>;
+}  // namespace ns_veta
+
+namespace ns_ikalibr {
+
+/**
+ * prune landmarks of (large) sfm reconstructions before the visual reprojection association.
+ * Tracks with large reprojection errors or small triangulation angles are rejected, and the
+ * remaining ones are ranked by their length, triangulation angle and error. A quality-ranked
+ * subset within the budget is kept, which is spread evenly over an image grid (of the first
+ * observations of landmarks)
+ */
+class VetaLandmarkPruner {
+public:
+    using Ptr = std::shared_ptr<VetaLandmarkPruner>;
+
+    struct LandmarkQuality {
+        // the track length, the max triangulation angle (rad), and the mean reprojection error
+        std::size_t trackLength;
+        double triangAngle;
+        double reprojError;
+        // the grid cell of the first observation, negative if the landmark is rejected
+        int cell;
+        double score;
+    };
+
+protected:
+    // the max count of kept landmarks, a zero one keeps all
+    std::size_t _budget;
+    // the cell count along each image dimension
+    int _gridSize;
+    double _maxReprojError;
+    double _minTriangAngle;
+
+public:
+    VetaLandmarkPruner(std::size_t budget,
+                       int gridSize,
+                       double maxReprojError,
+                       double minTriangAngleDeg);
+
+    static Ptr Create(std::size_t budget = Configor::Preference::LandmarkPruneBudget,
+                      int gridSize = Configor::Preference::LandmarkPruneGridSize,
+                      double maxReprojError = Configor::Preference::LandmarkPruneMaxReprojError,
+                      double minTriangAngleDeg = Configor::Preference::LandmarkPruneMinTriangAngle);
+
+    /**
+     * the pruned reconstruction, which shares views, poses and intrinsics with the given one, and
+     * holds the kept landmarks only. The given one is returned if no landmark is pruned
+     */
+    [[nodiscard]] ns_veta::VetaPtr Prune(const ns_veta::VetaPtr &veta,
+                                         const ns_veta::PinholeIntrinsic::Ptr &intri) const;
+
+protected:
+    // the quality of each landmark, which is evaluated in parallel
+    [[nodiscard]] std::vector<LandmarkQuality> EvaluateQualities(
+        const ns_veta::Veta &veta, const ns_veta::PinholeIntrinsic::Ptr &intri) const;
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_VETA_LANDMARK_PRUNER_H
@@ -205,13 +205,28 @@ public:
 
     [[nodiscard]] const std::map<IndexPair, SfMFeaturePairInfo> &GetMatchRes() const;
 
+    /**
+     * extract the reconstruction after 'StructureFromMotion', only reconstructed views and
+     * landmarks that are well observed are kept, which is organized as the one loaded from colmap
+     * @param errorThd the mean reprojection error threshold (pixel) of landmarks
+     * @param trackLenThd the track length threshold of landmarks
+     */
+    [[nodiscard]] ns_veta::Veta::Ptr ExtractReconstruction(double errorThd,
+                                                           std::size_t trackLenThd) const;
+
     std::set<IndexPair> FindCovisibility(double covThd = 0.2);
 
 protected:
     std::optional<ns_veta::Posed> ComputeCamRotations(const CameraFramePtr &frame);
 
-    std::map<CameraFramePtr, std::pair<polygon_2d, polygon_2d>> FindCovisibility(
-        const CameraFramePtr &refFrame, const std::set<IndexPair> &ignore, double covThd = 0.2);
+    /**
+     * find covisible frames of all frames (with rough rotations), each pair is found once, i.e.,
+     * in the one of the reference frame before the other in '_frames'. Candidates are queried from
+     * a kd-tree of viewing directions, where only ones in the cone of fov overlap are tested
+     * @return the reference frame id, [covisible frame, intersection polygons]
+     */
+    std::map<ns_veta::IndexT, std::map<CameraFramePtr, PolyPair>> FindCovisibleFrames(
+        double covThd);
 
     std::optional<std::pair<polygon_2d, polygon_2d>> IntersectionArea(const cv::Mat &i1,
                                                                       const cv::Mat &i2,
@@ -32,6 +32,9 @@
 
 #include "util/utils.h"
 #include "opencv2/imgproc.hpp"
+#include "mutex"
+#include "map"
+#include "tuple"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -57,11 +60,25 @@ private:
     // operate on entire image (remove disto)
     cv::Mat _map1, _map2;
 
+    // maps cached by the model, image size, and parameters of intrinsics
+    using CacheKey = std::tuple<std::string, std::size_t, std::size_t, std::vector<double>>;
+    // maps are large (two float maps and a vector map of the image size), only a few are kept
+    constexpr static std::size_t CacheCapacity = 8;
+    static std::mutex CacheMutex;
+    static std::map<CacheKey, Ptr> Cache;
+
 public:
     VisualUndistortionMap(const ns_veta::PinholeIntrinsicPtr& intri);
 
     static Ptr Create(const ns_veta::PinholeIntrinsicPtr& intri);
 
+    /**
+     * obtain the map from the process-wide cache, which is keyed by values of intrinsics rather
+     * than their addresses, thus maps are shared by calibrations of identical cameras (e.g., when
+     * bags of the same sensor layout are calibrated one by one in a process)
+     */
+    static Ptr Obtain(const ns_veta::PinholeIntrinsicPtr& intri);
+
     // only for events
     template <typename T, typename U>
     std::enable_if_t<std::is_integral_v<T> && std::is_integral_v<U>, std::pair<double, double>>
@@ -85,6 +102,47 @@ protected:
     static std::pair<cv::Mat, cv::Mat> InitUndistortRectifyMap(
         const ns_veta::PinholeIntrinsicPtr& intri);
 };
+
+/**
+ * the subpixel undistortion look-up table of a camera, which stores undistorted pixels on a grid,
+ * and undistorts a pixel using the bilinear interpolation rather than the iterative solving of
+ * 'GetUndistoPixel'. Tables are shared for the same intrinsics, and rebuilt once the intrinsics
+ * are changed (e.g., optimized using 'OPT_CAM_FOCAL_LEN' and 'OPT_CAM_PRINCIPAL_POINT')
+ */
+struct VisualUndistortionLUT {
+public:
+    using Ptr = std::shared_ptr<const VisualUndistortionLUT>;
+
+private:
+    // the pixel interval of the grid
+    constexpr static int GRID_STEP = 2;
+
+    // the intrinsics are held by the table, thus the address used as the key stays valid
+    ns_veta::PinholeIntrinsicPtr _intri;
+    // the intrinsic parameters used to build this table
+    std::vector<double> _params;
+    int _cols, _rows;
+    // undistorted pixels on the grid, stored row by row
+    std::vector<Eigen::Vector2d> _grid;
+
+    static std::mutex TablesMutex;
+    static std::map<const ns_veta::PinholeIntrinsic *, Ptr> Tables;
+
+public:
+    explicit VisualUndistortionLUT(const ns_veta::PinholeIntrinsicPtr& intri);
+
+    /**
+     * obtain the table of the intrinsics, the table would be rebuilt if the intrinsics changed,
+     * thus obtain the table once for a batch of pixels rather than each one
+     */
+    static Ptr Obtain(const ns_veta::PinholeIntrinsicPtr& intri);
+
+    // pixels out of the image are undistorted using 'GetUndistoPixel'
+    [[nodiscard]] Eigen::Vector2d RemoveDistortion(const Eigen::Vector2d& p) const;
+
+    // whether this table is built using the current intrinsic parameters
+    [[nodiscard]] bool IsUpToDate() const;
+};
 }  // namespace ns_ikalibr
 
 #endif  // VISUAL_DISTORTION_H
@@ -37,6 +37,9 @@
 
 #include "core/visual_velocity_estimator.h"
 #include "opengv/sac/SampleConsensusProblem.hpp"
+#include "random"
+#include "optional"
+#include "array"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -101,13 +104,19 @@ public:
      */
     [[nodiscard]] int getSampleSize() const override;
 
+    /**
+     * estimate the linear velocity of the camera using 'VisualVelocitySac'. If 'warmStart' is
+     * given (e.g., the velocity of the last frame), it's scored as the first hypothesis, thus the
+     * sampling terminates early if it's still a good one
+     */
     static std::optional<Eigen::Vector3d> VisualVelocityEstimationRANSAC(
         // dynamics in this frame (pixel, velocity, depth)
         const std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> &dynamics,
         const ns_veta::PinholeIntrinsic::Ptr &intri,
         double timeByBr,
         const VisualVelocityEstimator::So3SplineType &spline,
-        const Sophus::SO3d &SO3_DnToBr);
+        const Sophus::SO3d &SO3_DnToBr,
+        const std::optional<Eigen::Vector3d> &warmStart = std::nullopt);
 
     static std::optional<Eigen::Vector3d> VisualVelocityEstimationRANSAC(
         const std::vector<RGBDVelocityCorrPtr> &corrVec,
@@ -115,7 +124,8 @@ public:
         const ns_veta::PinholeIntrinsic::Ptr &intri,
         double timeByBr,
         const VisualVelocityEstimator::So3SplineType &spline,
-        const Sophus::SO3d &SO3_DnToBr);
+        const Sophus::SO3d &SO3_DnToBr,
+        const std::optional<Eigen::Vector3d> &warmStart = std::nullopt);
 
 protected:
     /** The adapter holding all input data */
@@ -125,6 +135,69 @@ protected:
     VisualVelocityEstimator::So3SplineType spline;
     Sophus::SO3d SO3_DnToBr;
 };
+
+/**
+ * a visual velocity ransac specialized from 'VisualVelocitySacProblem'. The optical flow model of
+ * each correspondence is linear in the camera velocity, as the angular velocity is given by the
+ * spline, thus models are stored as stacked rows and hypotheses are scored in a vectorized manner
+ */
+class VisualVelocitySac {
+public:
+    using Ptr = std::shared_ptr<VisualVelocitySac>;
+
+    // correspondences are scored in blocks, after which hopeless hypotheses are rejected
+    constexpr static int SCORE_BLOCK_SIZE = 64;
+
+private:
+    // columns '2i' and '2i+1' are the two rows of 'subAMat / depth' of the i-th correspondence
+    Eigen::Matrix3Xd _rows;
+    // 'vel - subBMat * ANG_VEL_DnToWInDn' of correspondences, stacked in the same order
+    Eigen::VectorXd _rhs;
+
+    std::mt19937 _rng;
+
+public:
+    VisualVelocitySac(
+        const std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> &dynamics,
+        const ns_veta::PinholeIntrinsic::Ptr &intri,
+        double timeByBr,
+        const VisualVelocityEstimator::So3SplineType &spline,
+        const Sophus::SO3d &SO3_DnToBr,
+        unsigned int seed = std::mt19937::default_seed);
+
+    static Ptr Create(
+        const std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> &dynamics,
+        const ns_veta::PinholeIntrinsic::Ptr &intri,
+        double timeByBr,
+        const VisualVelocityEstimator::So3SplineType &spline,
+        const Sophus::SO3d &SO3_DnToBr,
+        unsigned int seed = std::mt19937::default_seed);
+
+    /**
+     * estimate the camera velocity, the sampling terminates early once the desired probability is
+     * reached. The 'warmStart' velocity is scored before sampling if it's given
+     * @return the velocity refined using inliers, std::nullopt if no valid model is found
+     */
+    std::optional<Eigen::Vector3d> Estimate(
+        double threshold,
+        const std::optional<Eigen::Vector3d> &warmStart = std::nullopt,
+        int maxIterations = 20,
+        double probability = 0.99);
+
+    [[nodiscard]] int GetCorrCount() const;
+
+protected:
+    // solve the velocity from two correspondences, false is returned for degenerate samples
+    bool ComputeMinimalModel(const std::array<int, 2> &indices, Eigen::Vector3d &model) const;
+
+    // return the inlier count of the model, or -1 if it can not outperform 'bestCount'
+    [[nodiscard]] int CountInliers(const Eigen::Vector3d &model,
+                                   double threshold,
+                                   int bestCount) const;
+
+    [[nodiscard]] std::optional<Eigen::Vector3d> RefineModel(const Eigen::Vector3d &model,
+                                                             double threshold) const;
+};
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_VISUAL_VELOCITY_SAC_H
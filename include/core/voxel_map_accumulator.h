@@ -0,0 +1,102 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_VOXEL_MAP_ACCUMULATOR_H
+#define IKALIBR_VOXEL_MAP_ACCUMULATOR_H
+
+#include "config/configor.h"
+#include "util/cloud_define.hpp"
+#include "unordered_map"
+#include "mutex"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * accumulate point clouds into voxels, each voxel keeps the centroid (both position and timestamp)
+ * of points falling in it, like 'pcl::VoxelGrid'. Clouds can be inserted concurrently, thus
+ * scans are streamed into the voxel map without concatenating them in one cloud
+ */
+class VoxelMapAccumulator {
+public:
+    using Ptr = std::shared_ptr<VoxelMapAccumulator>;
+
+protected:
+    struct Voxel {
+        Eigen::Vector3d ptSum = Eigen::Vector3d::Zero();
+        double timeSum = 0.0;
+        std::size_t count = 0;
+    };
+
+    using VoxelKey = std::array<long, 3>;
+
+    struct VoxelKeyHash {
+        std::size_t operator()(const VoxelKey &key) const {
+            return static_cast<std::size_t>((key[0] * 73856093L) ^ (key[1] * 19349663L) ^
+                                            (key[2] * 83492791L));
+        }
+    };
+
+    // voxels are organized in shards, each is locked independently for concurrent insertion
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<VoxelKey, Voxel, VoxelKeyHash> voxels;
+    };
+
+    double _voxelSize;
+    std::vector<Shard> _shards;
+
+public:
+    explicit VoxelMapAccumulator(double voxelSize, std::size_t shardCount = 64);
+
+    static Ptr Create(double voxelSize, std::size_t shardCount = 64);
+
+    /**
+     * insert a cloud into the voxel map, nan points are ignored. This is thread-safe
+     */
+    void Insert(const IKalibrPointCloud::Ptr &cloud);
+
+    [[nodiscard]] std::size_t VoxelCount();
+
+    /**
+     * the downsampled cloud, each point is the centroid of a voxel
+     */
+    [[nodiscard]] IKalibrPointCloud::Ptr GetCloud();
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_VOXEL_MAP_ACCUMULATOR_H
@@ -0,0 +1,98 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_CONSENSUS_FACTOR_HPP
+#define IKALIBR_CONSENSUS_FACTOR_HPP
+
+#include "ctraj/utils/sophus_utils.hpp"
+#include "ceres/dynamic_autodiff_cost_function.h"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * the (scaled) augmented term of the consensus admm, which pulls a parameter block to its target,
+ * i.e., the consensus value minus the scaled dual variable
+ */
+struct ConsensusFactor {
+private:
+    // for rotation blocks, the target is stored as a quaternion of 'Sophus::SO3d'
+    const Eigen::VectorXd _target;
+    const bool _isSO3;
+    double _weight;
+
+public:
+    explicit ConsensusFactor(Eigen::VectorXd target, bool isSO3, double weight)
+        : _target(std::move(target)),
+          _isSO3(isSO3),
+          _weight(weight) {}
+
+    static auto Create(const Eigen::VectorXd &target, bool isSO3, double weight) {
+        return new ceres::DynamicAutoDiffCostFunction<ConsensusFactor>(
+            new ConsensusFactor(target, isSO3, weight));
+    }
+
+    static std::size_t TypeHashCode() { return typeid(ConsensusFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ PAR ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        if (_isSO3) {
+            Eigen::Map<Sophus::SO3<T> const> const SO3_Cur(sKnots[0]);
+            Sophus::SO3<T> SO3_Target =
+                Eigen::Map<Sophus::SO3d const>(_target.data()).template cast<T>();
+
+            Eigen::Map<Eigen::Vector3<T>> residuals(sResiduals);
+            residuals = T(_weight) * (SO3_Target.inverse() * SO3_Cur).log();
+        } else {
+            for (int i = 0; i < static_cast<int>(_target.size()); ++i) {
+                sResiduals[i] = T(_weight) * (sKnots[0][i] - T(_target(i)));
+            }
+        }
+        return true;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_CONSENSUS_FACTOR_HPP
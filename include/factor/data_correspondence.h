@@ -38,6 +38,10 @@
 #include "util/utils_tpl.hpp"
 #include "ufo/map/octree/node.h"
 #include "veta/landmark.h"
+#include "cereal/types/array.hpp"
+#include "cereal/types/memory.hpp"
+#include "cereal/types/vector.hpp"
+#include "unordered_map"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -47,31 +51,111 @@ namespace ns_ikalibr {
 class CameraFrame;
 using CameraFramePtr = std::shared_ptr<CameraFrame>;
 
-struct PointToSurfelCorr {
-    using Ptr = std::shared_ptr<PointToSurfelCorr>;
+// hash functor of ufo nodes, to organize nodes in unordered containers
+struct UFONodeHash {
+    std::size_t operator()(const ufo::map::Node &node) const {
+        return ufo::map::Code::Hash()(node.code());
+    }
+};
 
+/**
+ * @brief the deduplicated plane coefficients of surfels referred by point-to-surfel correspondences
+ * (by indices), surfels are keyed by their ufo nodes. Nodes are not serialized, thus surfels loaded
+ * would not be deduplicated against newly inserted ones
+ */
+struct SurfelTable {
 public:
-    double timestamp;
+    using Ptr = std::shared_ptr<SurfelTable>;
 
-    Eigen::Vector3d pInScan;
-    double weight;
+public:
     // [norm dir, dist]
-    Eigen::Vector4d surfelInW;
-
-    // just for visualization
-    Eigen::Vector3d pInMap;
-    // for ufomap associator
-    ufo::map::Node node;
-
-    PointToSurfelCorr(double timestamp,
-                      Eigen::Vector3d pInScan,
-                      double weight,
-                      Eigen::Vector4d surfelInW);
-
-    static Ptr Create(double timestamp,
-                      const Eigen::Vector3d &pInScan,
-                      double weight,
-                      const Eigen::Vector4d &surfelInW);
+    Eigen::aligned_vector<Eigen::Vector4d> coeffs;
+    std::vector<ufo::map::Node> nodes;
+
+protected:
+    std::unordered_map<ufo::map::Node, std::uint32_t, UFONodeHash> _indices;
+
+public:
+    static Ptr Create();
+
+    // the index of the surfel of the node, it is inserted if not exists
+    std::uint32_t Insert(const ufo::map::Node &node, const Eigen::Vector4d &coeff);
+
+    [[nodiscard]] std::size_t Size() const;
+
+public:
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(coeffs));
+    }
+};
+
+/**
+ * @brief packed (structure-of-arrays) point-to-surfel correspondences of a sensor. Points and
+ * weights are stored in float, and each correspondence refers to a surfel in the shared table by
+ * index, rather than holding its coefficients. Points in the map are only for visualization
+ * (the viewer and exported surfel maps), which are kept only if required in the association
+ */
+struct PointToSurfelCorrBuffer {
+public:
+    using Ptr = std::shared_ptr<PointToSurfelCorrBuffer>;
+
+public:
+    std::vector<double> timestamps;
+    Eigen::aligned_vector<Eigen::Vector3f> pInScan;
+    std::vector<float> weights;
+    std::vector<std::uint32_t> surfelIndices;
+    SurfelTable::Ptr surfels;
+
+    // visualization-only, empty if not kept
+    Eigen::aligned_vector<Eigen::Vector3f> pInMap;
+
+public:
+    explicit PointToSurfelCorrBuffer(SurfelTable::Ptr surfels = SurfelTable::Create());
+
+    static Ptr Create(const SurfelTable::Ptr &surfels = SurfelTable::Create());
+
+    [[nodiscard]] std::size_t Size() const;
+
+    [[nodiscard]] bool Empty() const;
+
+    [[nodiscard]] bool WithVisualization() const;
+
+    void Reserve(std::size_t count, bool withVisualization);
+
+    void Append(double timestamp,
+                const Eigen::Vector3f &point,
+                float weight,
+                std::uint32_t surfelIdx,
+                const Eigen::Vector3f *pointInMap = nullptr);
+
+    /**
+     * append correspondences of another buffer, whose surfels are inserted into the table of this
+     * one (deduplicated by nodes) if tables are different
+     */
+    void Append(const PointToSurfelCorrBuffer &other);
+
+    // a buffer of the selected correspondences, which shares the surfel table with this one
+    [[nodiscard]] Ptr Select(const std::vector<std::size_t> &indices) const;
+
+    /**
+     * indices of correspondences referring to each surfel (which has correspondences), ordered by
+     * surfel indices. Dense surfel indices are bucketed directly, rather than by an ordered map
+     */
+    [[nodiscard]] std::vector<std::pair<std::uint32_t, std::vector<std::size_t>>> GroupBySurfel()
+        const;
+
+    [[nodiscard]] const Eigen::Vector4d &SurfelOf(std::size_t idx) const;
+
+    // approximated memory (in bytes) of correspondences, the shared surfel table is not involved
+    [[nodiscard]] std::size_t GetMemoryBytes() const;
+
+public:
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(timestamps), CEREAL_NVP(pInScan), CEREAL_NVP(weights),
+           CEREAL_NVP(surfelIndices), CEREAL_NVP(surfels));
+    }
 };
 
 struct VisualReProjCorr {
@@ -129,6 +213,13 @@ public:
         feat->operator()(0) = *FX * P(0) + *CX;
         feat->operator()(1) = *FY * P(1) + *CY;
     }
+
+public:
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(ti), CEREAL_NVP(tj), CEREAL_NVP(fi), CEREAL_NVP(fj), CEREAL_NVP(li),
+           CEREAL_NVP(lj), CEREAL_NVP(weight));
+    }
 };
 
 struct VisualReProjCorrSeq {
@@ -136,9 +227,10 @@ public:
     using Ptr = std::shared_ptr<VisualReProjCorrSeq>;
 
 public:
+    // correspondences and the inverse depth may point into arenas shared by sequences
     std::vector<VisualReProjCorr::Ptr> corrs;
 
-    std::unique_ptr<double> invDepthFir;
+    std::shared_ptr<double> invDepthFir;
 
     ns_veta::IndexT lmId{};
 
@@ -147,6 +239,13 @@ public:
 
 public:
     VisualReProjCorrSeq();
+
+public:
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(corrs), CEREAL_NVP(invDepthFir), CEREAL_NVP(lmId), CEREAL_NVP(firObvViewId),
+           cereal::make_nvp("firObvX", firObv.x), cereal::make_nvp("firObvFeatId", firObv.id_feat));
+    }
 };
 
 struct OpticalFlowCorr {
@@ -196,6 +295,15 @@ public:
                       const std::array<double, 3> &yDynamicAry,
                       double depth);
 
+    /**
+     * copy correspondences into one contiguous arena ordered by the middle timestamps (stable),
+     * thus their depth and inverse depth parameter blocks are adjacent in memory and are visited
+     * frame by frame in the schur elimination. The returned pointers alias the arena
+     */
+    static std::vector<Ptr> CreateArena(const std::vector<Ptr> &corrs);
+
+    OpticalFlowCorr();
+
     [[nodiscard]] Eigen::Vector2d FirPoint() const;
 
     [[nodiscard]] Eigen::Vector2d MidPoint() const;
@@ -283,6 +391,56 @@ public:
         SubAMat(fx, fy, up, vp, aMat);
         SubBMat(fx, fy, up, vp, bMat);
     }
+
+    /**
+     * the point-point-point trifocal tensor residuals of the three features, i.e., the four
+     * independent entries of '[bFir]x * (sum_i bMid(i) * T_i) * [bLast]x', given the relative
+     * poses from the middle camera to the first and the last ones. The contraction over the tensor
+     * is performed in a closed form:
+     * 'sum_i bMid(i) * T_i = (R1 * bMid) * t2^T - t1 * (R2 * bMid)^T'
+     */
+    template <class T>
+    [[nodiscard]] Eigen::Vector4<T> TrifocalTensorResiduals(
+        const T *FX_INV,
+        const T *FY_INV,
+        const T *CX,
+        const T *CY,
+        const Eigen::Matrix33<T> &SO3_CmMidToCmFir,
+        const Eigen::Vector3<T> &POS_CmMidInCmFir,
+        const Eigen::Matrix33<T> &SO3_CmMidToCmLast,
+        const Eigen::Vector3<T> &POS_CmMidInCmLast) const {
+        // bearing vectors of the three features
+        std::array<Eigen::Vector3<T>, 3> bvs;
+        for (int i = 0; i < 3; ++i) {
+            Eigen::Vector2<T> f(T(xTraceAry[i]), T(yTraceAry[i]));
+            Eigen::Vector3<T> p;
+            VisualReProjCorr::TransformImgToCam<T>(FX_INV, FY_INV, CX, CY, f, &p);
+            bvs[i] = p.normalized();
+        }
+
+        // [bFir]x * (u * t2^T - t1 * v^T) * [bLast]x = -(bFir x u)(bLast x t2)^T +
+        // (bFir x t1)(bLast x v)^T
+        const Eigen::Vector3<T> u = SO3_CmMidToCmFir * bvs[MID];
+        const Eigen::Vector3<T> v = SO3_CmMidToCmLast * bvs[MID];
+        const Eigen::Vector3<T> a1 = bvs[FIR].cross(u), b1 = bvs[LAST].cross(POS_CmMidInCmLast);
+        const Eigen::Vector3<T> a2 = bvs[FIR].cross(POS_CmMidInCmFir), b2 = bvs[LAST].cross(v);
+
+        Eigen::Vector4<T> res;
+        res(0) = a2(0) * b2(0) - a1(0) * b1(0);
+        res(1) = a2(0) * b2(2) - a1(0) * b1(2);
+        res(2) = a2(2) * b2(0) - a1(2) * b1(0);
+        res(3) = a2(2) * b2(2) - a1(2) * b1(2);
+        return res;
+    }
+
+public:
+    // the associated camera frame is not serialized, which is not involved in factors
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(timeAry), CEREAL_NVP(xTraceAry), CEREAL_NVP(yTraceAry),
+           CEREAL_NVP(rdFactorAry), CEREAL_NVP(depth), CEREAL_NVP(invDepth),
+           CEREAL_NVP(withDepthObservability), CEREAL_NVP(weight));
+    }
 };
 
 struct Feature;
@@ -317,6 +475,18 @@ public:
 
     [[nodiscard]] std::vector<Eigen::Vector3d> DiscretePositions(double dt = 0.005) const;
 
+    /**
+     * evaluate positions and velocities at sorted times in a batch, the range of in-range times is
+     * located by binary search, and the curve is evaluated only for them
+     * @param times the query times in ascending order
+     * @param positions positions at in-range times, nullptr if not required
+     * @param velocities velocities at in-range times, nullptr if not required
+     * @return the index range [begin, end) of in-range times in 'times'
+     */
+    std::pair<std::size_t, std::size_t> EvaluateAt(const std::vector<double> &times,
+                                                   std::vector<Eigen::Vector2d> *positions,
+                                                   std::vector<Eigen::Vector2d> *velocities) const;
+
     bool IsTimeInRange(double time) const;
 
     template <typename ScaleType>
@@ -335,6 +505,12 @@ public:
         return 2.0 * a * x + b;
     }
 
+public:
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(sTime), CEREAL_NVP(eTime), CEREAL_NVP(xParm), CEREAL_NVP(yParm));
+    }
+
 protected:
     static Eigen::Vector3d FitQuadraticCurve(const std::vector<double> &x,
                                              const std::vector<double> &y);
@@ -41,6 +41,7 @@
 #include "ctraj/spline/ceres_spline_helper.h"
 #include "ctraj/spline/ceres_spline_helper_jet.h"
 #include "ceres/dynamic_autodiff_cost_function.h"
+#include "factor/sized_autodiff_cost_function.hpp"
 #include "sensor/imu.h"
 #include "util/utils.h"
 #include "config/configor.h"
@@ -50,11 +51,20 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
 namespace ns_ikalibr {
-template <int Order, int TimeDeriv>
+/**
+ * if 'IntriFrozen' is true, the accelerometer intrinsics (bias and map coefficients) are not
+ * estimated and have been removed from the measurement in advance, thus their parameter blocks are
+ * not involved. The residual is mapped back to the raw measurement space by 'intriMat', i.e., the
+ * map matrix, so that the cost equals to the one of the factor with intrinsics
+ */
+template <int Order, int TimeDeriv, bool IntriFrozen = false>
 struct IMUAcceFactor {
 private:
     ns_ctraj::SplineMeta<Order> _so3Meta, _scaleMeta;
-    IMUFrame::Ptr _imuFrame{};
+    // the sample is kept by value, rather than the shared frame (no reference counting)
+    double _timestamp;
+    Eigen::Vector3d _acce;
+    Eigen::Matrix3d _intriMat;
 
     double _so3DtInv, _scaleDtInv;
     double _weight;
@@ -62,15 +72,43 @@ private:
 public:
     explicit IMUAcceFactor(ns_ctraj::SplineMeta<Order> rotMeta,
                            ns_ctraj::SplineMeta<Order> linScaleMeta,
-                           IMUFrame::Ptr imuFrame,
+                           double timestamp,
+                           Eigen::Vector3d acce,
+                           Eigen::Matrix3d intriMat,
                            double weight)
         : _so3Meta(rotMeta),
           _scaleMeta(std::move(linScaleMeta)),
-          _imuFrame(std::move(imuFrame)),
+          _timestamp(timestamp),
+          _acce(std::move(acce)),
+          _intriMat(std::move(intriMat)),
           _so3DtInv(1.0 / rotMeta.segments.front().dt),
           _scaleDtInv(1.0 / _scaleMeta.segments.front().dt),
           _weight(weight) {}
 
+    explicit IMUAcceFactor(ns_ctraj::SplineMeta<Order> rotMeta,
+                           ns_ctraj::SplineMeta<Order> linScaleMeta,
+                           const IMUFrame::Ptr &imuFrame,
+                           double weight)
+        : IMUAcceFactor(std::move(rotMeta),
+                        std::move(linScaleMeta),
+                        imuFrame->GetTimestamp(),
+                        imuFrame->GetAcce(),
+                        Eigen::Matrix3d::Identity(),
+                        weight) {}
+
+protected:
+    static auto CreateSizedFrom(IMUAcceFactor *factor) {
+        static_assert(Order == 4, "the fixed-size imu acce factor only supports 'Order == 4'");
+        if constexpr (IntriFrozen) {
+            return new SizedAutoDiffCostFunction<IMUAcceFactor, 3, 4, 4, 4, 4, 3, 3, 3, 3, 3, 4,
+                                                 3, 1>(factor);
+        } else {
+            return new SizedAutoDiffCostFunction<IMUAcceFactor, 3, 4, 4, 4, 4, 3, 3, 3, 3, 3, 6,
+                                                 3, 4, 3, 1>(factor);
+        }
+    }
+
+public:
     static auto Create(const ns_ctraj::SplineMeta<Order> &rotMeta,
                        const ns_ctraj::SplineMeta<Order> &linScaleMeta,
                        const IMUFrame::Ptr &imuFrame,
@@ -79,6 +117,42 @@ public:
             new IMUAcceFactor(rotMeta, linScaleMeta, imuFrame, weight));
     }
 
+    // the measurement 'acce' has been corrected by the frozen intrinsics
+    static auto Create(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                       const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                       double timestamp,
+                       const Eigen::Vector3d &acce,
+                       const Eigen::Matrix3d &intriMat,
+                       double weight) {
+        return new ceres::DynamicAutoDiffCostFunction<IMUAcceFactor>(
+            new IMUAcceFactor(rotMeta, linScaleMeta, timestamp, acce, intriMat, weight));
+    }
+
+    /**
+     * the fixed-size cost function, which is used when only 'Order' so3 and linear scale knots are
+     * involved, i.e., the time offset is not padded:
+     * [ SO3 x 4 | LIN_SCALE x 4 | ACCE_BIAS | ACCE_MAP_COEFF | GRAVITY | SO3_BiToBr | POS_BiInBr |
+     *   TO_BiToBr ]
+     * or [ SO3 x 4 | LIN_SCALE x 4 | GRAVITY | SO3_BiToBr | POS_BiInBr | TO_BiToBr ] if
+     * 'IntriFrozen'
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                            const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                            const IMUFrame::Ptr &imuFrame,
+                            double weight) {
+        return CreateSizedFrom(new IMUAcceFactor(rotMeta, linScaleMeta, imuFrame, weight));
+    }
+
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                            const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                            double timestamp,
+                            const Eigen::Vector3d &acce,
+                            const Eigen::Matrix3d &intriMat,
+                            double weight) {
+        return CreateSizedFrom(
+            new IMUAcceFactor(rotMeta, linScaleMeta, timestamp, acce, intriMat, weight));
+    }
+
     static std::size_t TypeHashCode() { return typeid(IMUAcceFactor).hash_code(); }
 
 public:
@@ -86,6 +160,8 @@ public:
      * param blocks:
      * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | ACCE_BIAS | ACCE_MAP_COEFF | GRAVITY |
      *   SO3_BiToBr | POS_BiInBr | TO_BiToBr ]
+     * or [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | GRAVITY | SO3_BiToBr | POS_BiInBr |
+     *   TO_BiToBr ] if 'IntriFrozen'
      */
     template <class T>
     bool operator()(T const *const *sKnots, T *sResiduals) const {
@@ -94,7 +170,7 @@ public:
 
         std::size_t ACCE_BIAS_OFFSET = _so3Meta.NumParameters() + _scaleMeta.NumParameters();
         std::size_t ACCE_MAP_COEFF_OFFSET = ACCE_BIAS_OFFSET + 1;
-        std::size_t GRAVITY_OFFSET = ACCE_MAP_COEFF_OFFSET + 1;
+        std::size_t GRAVITY_OFFSET = IntriFrozen ? ACCE_BIAS_OFFSET : ACCE_MAP_COEFF_OFFSET + 1;
         std::size_t SO3_BiToBr_OFFSET = GRAVITY_OFFSET + 1;
         std::size_t POS_BiInBr_OFFSET = SO3_BiToBr_OFFSET + 1;
         std::size_t TO_BiToBr_OFFSET = POS_BiInBr_OFFSET + 1;
@@ -104,7 +180,7 @@ public:
         Eigen::Map<const Eigen::Vector3<T>> POS_BiInBr(sKnots[POS_BiInBr_OFFSET]);
         T TO_BiToBr = sKnots[TO_BiToBr_OFFSET][0];
 
-        auto timeByBr = _imuFrame->GetTimestamp() + TO_BiToBr;
+        auto timeByBr = _timestamp + TO_BiToBr;
 
         // calculate the so3 and lin scale offset
         std::pair<std::size_t, T> iuSo3, iuScale;
@@ -126,18 +202,8 @@ public:
         ns_ctraj::CeresSplineHelperJet<T, Order>::template Evaluate<3, TimeDeriv>(
             sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, &ACCE_BrToBr0InBr0);
 
-        Eigen::Map<const Eigen::Vector3<T>> acceBias(sKnots[ACCE_BIAS_OFFSET]);
         Eigen::Map<const Eigen::Vector3<T>> gravity(sKnots[GRAVITY_OFFSET]);
 
-        auto acceCoeff = sKnots[ACCE_MAP_COEFF_OFFSET];
-
-        Eigen::Matrix33<T> acceMapMat = Eigen::Matrix33<T>::Zero();
-
-        acceMapMat.diagonal() = Eigen::Map<const Eigen::Vector3<T>>(acceCoeff, 3);
-        acceMapMat(0, 1) = *(acceCoeff + 3);
-        acceMapMat(0, 2) = *(acceCoeff + 4);
-        acceMapMat(1, 2) = *(acceCoeff + 5);
-
         Sophus::SO3<T> SO3_BiToBr0 = SO3_BrToBr0 * SO3_BiToBr;
 
         Eigen::Matrix33<T> SO3_VEL_MAT = Sophus::SO3<T>::hat(SO3_VEL_BrToBr0InBr0);
@@ -152,12 +218,26 @@ public:
         //                             Sophus::SO3<T>::hat(SO3_BrToBr0 * POS_BiInBr) *
         //                             SO3_VEL_BrToBr0InBr0;
 
-        Eigen::Vector3<T> accePred =
-            (acceMapMat * (SO3_BiToBr0.inverse() * (POS_ACCE_BiToBr0InBr0 - gravity))).eval() +
-            acceBias;
+        Eigen::Vector3<T> force = SO3_BiToBr0.inverse() * (POS_ACCE_BiToBr0InBr0 - gravity);
 
         Eigen::Map<Eigen::Vector3<T>> residuals(sResiduals);
-        residuals = accePred - _imuFrame->GetAcce().template cast<T>();
+        if constexpr (IntriFrozen) {
+            residuals = _intriMat.template cast<T>() * (force - _acce.template cast<T>());
+        } else {
+            Eigen::Map<const Eigen::Vector3<T>> acceBias(sKnots[ACCE_BIAS_OFFSET]);
+
+            auto acceCoeff = sKnots[ACCE_MAP_COEFF_OFFSET];
+
+            Eigen::Matrix33<T> acceMapMat = Eigen::Matrix33<T>::Zero();
+
+            acceMapMat.diagonal() = Eigen::Map<const Eigen::Vector3<T>>(acceCoeff, 3);
+            acceMapMat(0, 1) = *(acceCoeff + 3);
+            acceMapMat(0, 2) = *(acceCoeff + 4);
+            acceMapMat(1, 2) = *(acceCoeff + 5);
+
+            Eigen::Vector3<T> accePred = (acceMapMat * force).eval() + acceBias;
+            residuals = accePred - _acce.template cast<T>();
+        }
         residuals = T(_weight) * residuals;
 
         return true;
@@ -167,8 +247,106 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
-extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 2>;
-extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 1>;
-extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 0>;
+/**
+ * accelerometer measurements falling into the same so3 and linear scale spline segments, which
+ * share the same knots and are organized as one residual block, the time offset should not be
+ * padded
+ */
+template <int Order, int TimeDeriv, bool IntriFrozen = false>
+struct IMUAcceBatchFactor {
+private:
+    std::vector<IMUAcceFactor<Order, TimeDeriv, IntriFrozen>> _factors;
+
+public:
+    explicit IMUAcceBatchFactor(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                                const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                                const std::vector<IMUFrame::Ptr> &imuFrames,
+                                double weight) {
+        _factors.reserve(imuFrames.size());
+        for (const auto &imuFrame : imuFrames) {
+            _factors.emplace_back(rotMeta, linScaleMeta, imuFrame, weight);
+        }
+    }
+
+    // the i-th column of 'acces' is the corrected measurement of the i-th frame
+    explicit IMUAcceBatchFactor(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                                const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                                const std::vector<IMUFrame::Ptr> &imuFrames,
+                                const Eigen::Matrix3Xd &acces,
+                                const Eigen::Matrix3d &intriMat,
+                                double weight) {
+        _factors.reserve(imuFrames.size());
+        for (int i = 0; i < static_cast<int>(imuFrames.size()); ++i) {
+            _factors.emplace_back(rotMeta, linScaleMeta, imuFrames[i]->GetTimestamp(),
+                                  acces.col(i), intriMat, weight);
+        }
+    }
+
+protected:
+    static auto CreateFrom(IMUAcceBatchFactor *factor, std::size_t count) {
+        static_assert(Order == 4, "the batched imu acce factor only supports 'Order == 4'");
+        const int numResiduals = static_cast<int>(count * 3);
+        if constexpr (IntriFrozen) {
+            return new SizedAutoDiffCostFunction<IMUAcceBatchFactor, ceres::DYNAMIC, 4, 4, 4, 4, 3,
+                                                 3, 3, 3, 3, 4, 3, 1>(factor, numResiduals);
+        } else {
+            return new SizedAutoDiffCostFunction<IMUAcceBatchFactor, ceres::DYNAMIC, 4, 4, 4, 4, 3,
+                                                 3, 3, 3, 3, 6, 3, 4, 3, 1>(factor, numResiduals);
+        }
+    }
+
+public:
+    static auto Create(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                       const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                       const std::vector<IMUFrame::Ptr> &imuFrames,
+                       double weight) {
+        return CreateFrom(new IMUAcceBatchFactor(rotMeta, linScaleMeta, imuFrames, weight),
+                          imuFrames.size());
+    }
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                       const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                       const std::vector<IMUFrame::Ptr> &imuFrames,
+                       const Eigen::Matrix3Xd &acces,
+                       const Eigen::Matrix3d &intriMat,
+                       double weight) {
+        return CreateFrom(new IMUAcceBatchFactor(rotMeta, linScaleMeta, imuFrames, acces,
+                                                 intriMat, weight),
+                          imuFrames.size());
+    }
+
+    static std::size_t TypeHashCode() { return typeid(IMUAcceBatchFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 x 4 | LIN_SCALE x 4 | ACCE_BIAS | ACCE_MAP_COEFF | GRAVITY | SO3_BiToBr | POS_BiInBr |
+     *   TO_BiToBr ]
+     * or [ SO3 x 4 | LIN_SCALE x 4 | GRAVITY | SO3_BiToBr | POS_BiInBr | TO_BiToBr ] if
+     * 'IntriFrozen'
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        for (std::size_t i = 0; i < _factors.size(); ++i) {
+            if (!_factors[i](sKnots, sResiduals + i * 3)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 2, false>;
+extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 1, false>;
+extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 0, false>;
+extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 2, true>;
+extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 1, true>;
+extern template struct IMUAcceFactor<Configor::Prior::SplineOrder, 0, true>;
+extern template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 2, false>;
+extern template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 1, false>;
+extern template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 0, false>;
+extern template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 2, true>;
+extern template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 1, true>;
+extern template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 0, true>;
 }  // namespace ns_ikalibr
 #endif  // IKALIBR_IMU_ACCE_FACTOR_HPP
@@ -40,6 +40,7 @@
 #include "ctraj/spline/spline_segment.h"
 #include "ctraj/spline/ceres_spline_helper_jet.h"
 #include "ceres/dynamic_autodiff_cost_function.h"
+#include "factor/sized_autodiff_cost_function.hpp"
 #include "sensor/imu.h"
 #include "util/utils.h"
 #include "config/configor.h"
@@ -49,22 +50,58 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
 namespace ns_ikalibr {
-template <int Order>
+/**
+ * if 'IntriFrozen' is true, the gyroscope intrinsics (bias, map coefficients and 'SO3_AtoG') are
+ * not estimated and have been removed from the measurement in advance, thus their parameter blocks
+ * are not involved. The residual is mapped back to the raw measurement space by 'intriMat', i.e.,
+ * 'mapMat * SO3_AtoG', so that the cost equals to the one of the factor with intrinsics
+ */
+template <int Order, bool IntriFrozen = false>
 struct IMUGyroFactor {
 private:
     ns_ctraj::SplineMeta<Order> _so3Meta;
-    IMUFrame::Ptr _frame{};
+    // the sample is kept by value, rather than the shared frame (no reference counting)
+    double _timestamp;
+    Eigen::Vector3d _gyro;
+    Eigen::Matrix3d _intriMat;
 
     double _so3DtInv;
     double _weight;
 
 public:
-    explicit IMUGyroFactor(ns_ctraj::SplineMeta<Order> so3Meta, IMUFrame::Ptr frame, double weight)
+    explicit IMUGyroFactor(ns_ctraj::SplineMeta<Order> so3Meta,
+                           double timestamp,
+                           Eigen::Vector3d gyro,
+                           Eigen::Matrix3d intriMat,
+                           double weight)
         : _so3Meta(std::move(so3Meta)),
-          _frame(std::move(frame)),
+          _timestamp(timestamp),
+          _gyro(std::move(gyro)),
+          _intriMat(std::move(intriMat)),
           _so3DtInv(1.0 / _so3Meta.segments.front().dt),
           _weight(weight) {}
 
+    explicit IMUGyroFactor(ns_ctraj::SplineMeta<Order> so3Meta,
+                           const IMUFrame::Ptr &frame,
+                           double weight)
+        : IMUGyroFactor(std::move(so3Meta),
+                        frame->GetTimestamp(),
+                        frame->GetGyro(),
+                        Eigen::Matrix3d::Identity(),
+                        weight) {}
+
+protected:
+    static auto CreateSizedFrom(IMUGyroFactor *factor) {
+        static_assert(Order == 4, "the fixed-size imu gyro factor only supports 'Order == 4'");
+        if constexpr (IntriFrozen) {
+            return new SizedAutoDiffCostFunction<IMUGyroFactor, 3, 4, 4, 4, 4, 4, 1>(factor);
+        } else {
+            return new SizedAutoDiffCostFunction<IMUGyroFactor, 3, 4, 4, 4, 4, 3, 6, 4, 4, 1>(
+                factor);
+        }
+    }
+
+public:
     static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
                        const IMUFrame::Ptr &frame,
                        double weight) {
@@ -72,12 +109,43 @@ public:
             new IMUGyroFactor(so3Meta, frame, weight));
     }
 
+    // the measurement 'gyro' has been corrected by the frozen intrinsics
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       double timestamp,
+                       const Eigen::Vector3d &gyro,
+                       const Eigen::Matrix3d &intriMat,
+                       double weight) {
+        return new ceres::DynamicAutoDiffCostFunction<IMUGyroFactor>(
+            new IMUGyroFactor(so3Meta, timestamp, gyro, intriMat, weight));
+    }
+
+    /**
+     * the fixed-size cost function, which is used when only 'Order' so3 knots are involved, i.e.,
+     * the time offset is not padded:
+     * [ SO3 x 4 | GYRO_BIAS | GYRO_MAP_COEFF | SO3_AtoG | SO3_BiToBr | TO_BiToBr ]
+     * or [ SO3 x 4 | SO3_BiToBr | TO_BiToBr ] if 'IntriFrozen'
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            const IMUFrame::Ptr &frame,
+                            double weight) {
+        return CreateSizedFrom(new IMUGyroFactor(so3Meta, frame, weight));
+    }
+
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            double timestamp,
+                            const Eigen::Vector3d &gyro,
+                            const Eigen::Matrix3d &intriMat,
+                            double weight) {
+        return CreateSizedFrom(new IMUGyroFactor(so3Meta, timestamp, gyro, intriMat, weight));
+    }
+
     static std::size_t TypeHashCode() { return typeid(IMUGyroFactor).hash_code(); }
 
 public:
     /**
      * param blocks:
      * [ SO3 | ... | SO3 | GYRO_BIAS | GYRO_MAP_COEFF | SO3_AtoG | SO3_BiToBr | TO_BiToBr ]
+     * or [ SO3 | ... | SO3 | SO3_BiToBr | TO_BiToBr ] if 'IntriFrozen'
      */
     template <class T>
     bool operator()(T const *const *sKnots, T *sResiduals) const {
@@ -86,12 +154,12 @@ public:
         std::size_t GYRO_BIAS_OFFSET = _so3Meta.NumParameters();
         std::size_t GYRO_MAP_COEFF_OFFSET = GYRO_BIAS_OFFSET + 1;
         std::size_t SO3_AtoG_OFFSET = GYRO_MAP_COEFF_OFFSET + 1;
-        std::size_t SO3_BiToBr_OFFSET = SO3_AtoG_OFFSET + 1;
+        std::size_t SO3_BiToBr_OFFSET = IntriFrozen ? GYRO_BIAS_OFFSET : SO3_AtoG_OFFSET + 1;
         std::size_t TO_BiToBr_OFFSET = SO3_BiToBr_OFFSET + 1;
 
         T TO_BiToBr = sKnots[TO_BiToBr_OFFSET][0];
 
-        auto timeByBr = _frame->GetTimestamp() + TO_BiToBr;
+        auto timeByBr = _timestamp + TO_BiToBr;
 
         // calculate the so3 offset
         std::pair<std::size_t, T> iuCur;
@@ -103,25 +171,31 @@ public:
         ns_ctraj::CeresSplineHelperJet<T, Order>::EvaluateLie(
             sKnots + SO3_OFFSET, iuCur.second, _so3DtInv, &SO3_BrToBr0, &SO3_VEL_BrToBr0InBr);
 
-        Eigen::Map<const Eigen::Vector3<T>> gyroBias(sKnots[GYRO_BIAS_OFFSET]);
-        auto gyroCoeff = sKnots[GYRO_MAP_COEFF_OFFSET];
-        Eigen::Matrix33<T> gyroMapMat = Eigen::Matrix33<T>::Zero();
-        gyroMapMat.diagonal() = Eigen::Map<const Eigen::Vector3<T>>(gyroCoeff, 3);
-        gyroMapMat(0, 1) = *(gyroCoeff + 3);
-        gyroMapMat(0, 2) = *(gyroCoeff + 4);
-        gyroMapMat(1, 2) = *(gyroCoeff + 5);
-
-        Eigen::Map<Sophus::SO3<T> const> const SO3_AtoG(sKnots[SO3_AtoG_OFFSET]);
         Eigen::Map<Sophus::SO3<T> const> const SO3_BiToBr(sKnots[SO3_BiToBr_OFFSET]);
-        Sophus::SO3<T> SO3_BiToBr0 = SO3_BrToBr0 * SO3_BiToBr;
-        Sophus::SO3Tangent<T> SO3_VEL_BrToBr0InBr0 = SO3_BrToBr0 * SO3_VEL_BrToBr0InBr;
+        Eigen::Map<Eigen::Vector3<T>> residuals(sResiduals);
 
-        Eigen::Vector3<T> pred =
-            (gyroMapMat * (SO3_AtoG * SO3_BiToBr0.inverse() * SO3_VEL_BrToBr0InBr0)).eval() +
-            gyroBias;
+        if constexpr (IntriFrozen) {
+            // the angular velocity in the imu frame, i.e., 'SO3_BrToBi * w'
+            Eigen::Vector3<T> pred = SO3_BiToBr.inverse() * SO3_VEL_BrToBr0InBr;
+            residuals = _intriMat.template cast<T>() * (pred - _gyro.template cast<T>());
+        } else {
+            Eigen::Map<const Eigen::Vector3<T>> gyroBias(sKnots[GYRO_BIAS_OFFSET]);
+            auto gyroCoeff = sKnots[GYRO_MAP_COEFF_OFFSET];
+            Eigen::Matrix33<T> gyroMapMat = Eigen::Matrix33<T>::Zero();
+            gyroMapMat.diagonal() = Eigen::Map<const Eigen::Vector3<T>>(gyroCoeff, 3);
+            gyroMapMat(0, 1) = *(gyroCoeff + 3);
+            gyroMapMat(0, 2) = *(gyroCoeff + 4);
+            gyroMapMat(1, 2) = *(gyroCoeff + 5);
 
-        Eigen::Map<Eigen::Vector3<T>> residuals(sResiduals);
-        residuals = pred - _frame->GetGyro().template cast<T>();
+            Eigen::Map<Sophus::SO3<T> const> const SO3_AtoG(sKnots[SO3_AtoG_OFFSET]);
+            Sophus::SO3<T> SO3_BiToBr0 = SO3_BrToBr0 * SO3_BiToBr;
+            Sophus::SO3Tangent<T> SO3_VEL_BrToBr0InBr0 = SO3_BrToBr0 * SO3_VEL_BrToBr0InBr;
+
+            Eigen::Vector3<T> pred =
+                (gyroMapMat * (SO3_AtoG * SO3_BiToBr0.inverse() * SO3_VEL_BrToBr0InBr0)).eval() +
+                gyroBias;
+            residuals = pred - _gyro.template cast<T>();
+        }
         residuals = T(_weight) * residuals;
 
         return true;
@@ -131,7 +205,90 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
-extern template struct IMUGyroFactor<Configor ::Prior::SplineOrder>;
+/**
+ * gyroscope measurements falling into the same so3 spline segment, which share the same knots and
+ * are organized as one residual block, the time offset should not be padded
+ */
+template <int Order, bool IntriFrozen = false>
+struct IMUGyroBatchFactor {
+private:
+    std::vector<IMUGyroFactor<Order, IntriFrozen>> _factors;
+
+public:
+    explicit IMUGyroBatchFactor(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                                const std::vector<IMUFrame::Ptr> &frames,
+                                double weight) {
+        _factors.reserve(frames.size());
+        for (const auto &frame : frames) {
+            _factors.emplace_back(so3Meta, frame, weight);
+        }
+    }
+
+    // the i-th column of 'gyros' is the corrected measurement of the i-th frame
+    explicit IMUGyroBatchFactor(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                                const std::vector<IMUFrame::Ptr> &frames,
+                                const Eigen::Matrix3Xd &gyros,
+                                const Eigen::Matrix3d &intriMat,
+                                double weight) {
+        _factors.reserve(frames.size());
+        for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
+            _factors.emplace_back(so3Meta, frames[i]->GetTimestamp(), gyros.col(i), intriMat,
+                                  weight);
+        }
+    }
+
+protected:
+    static auto CreateFrom(IMUGyroBatchFactor *factor, std::size_t count) {
+        static_assert(Order == 4, "the batched imu gyro factor only supports 'Order == 4'");
+        const int numResiduals = static_cast<int>(count * 3);
+        if constexpr (IntriFrozen) {
+            return new SizedAutoDiffCostFunction<IMUGyroBatchFactor, ceres::DYNAMIC, 4, 4, 4, 4, 4,
+                                                 1>(factor, numResiduals);
+        } else {
+            return new SizedAutoDiffCostFunction<IMUGyroBatchFactor, ceres::DYNAMIC, 4, 4, 4, 4, 3,
+                                                 6, 4, 4, 1>(factor, numResiduals);
+        }
+    }
+
+public:
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       const std::vector<IMUFrame::Ptr> &frames,
+                       double weight) {
+        return CreateFrom(new IMUGyroBatchFactor(so3Meta, frames, weight), frames.size());
+    }
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       const std::vector<IMUFrame::Ptr> &frames,
+                       const Eigen::Matrix3Xd &gyros,
+                       const Eigen::Matrix3d &intriMat,
+                       double weight) {
+        return CreateFrom(new IMUGyroBatchFactor(so3Meta, frames, gyros, intriMat, weight),
+                          frames.size());
+    }
+
+    static std::size_t TypeHashCode() { return typeid(IMUGyroBatchFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 x 4 | GYRO_BIAS | GYRO_MAP_COEFF | SO3_AtoG | SO3_BiToBr | TO_BiToBr ]
+     * or [ SO3 x 4 | SO3_BiToBr | TO_BiToBr ] if 'IntriFrozen'
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        for (std::size_t i = 0; i < _factors.size(); ++i) {
+            if (!_factors[i](sKnots, sResiduals + i * 3)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+extern template struct IMUGyroFactor<Configor ::Prior::SplineOrder, false>;
+extern template struct IMUGyroFactor<Configor ::Prior::SplineOrder, true>;
+extern template struct IMUGyroBatchFactor<Configor ::Prior::SplineOrder, false>;
+extern template struct IMUGyroBatchFactor<Configor ::Prior::SplineOrder, true>;
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_IMU_GYRO_FACTOR_HPP
@@ -0,0 +1,115 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_MARGINAL_PRIOR_FACTOR_HPP
+#define IKALIBR_MARGINAL_PRIOR_FACTOR_HPP
+
+#include "ctraj/utils/sophus_utils.hpp"
+#include "ceres/dynamic_autodiff_cost_function.h"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * the dense prior of parameter blocks, obtained by marginalizing the other parameters (e.g., knots
+ * of old time windows) via the Schur complement, i.e., r = S * (x [-] x0), where x0 is the
+ * linearization point, and S^T * S is the marginal hessian matrix. For rotation blocks, the
+ * difference is 'log(SO3 * SO3_0^(-1))', which is consistent with the quaternion manifold
+ */
+struct MarginalPriorFactor {
+private:
+    const std::vector<int> _sizes;
+    const std::vector<bool> _isSO3;
+    // stacked parameter blocks, rotations are stored as quaternions of 'Sophus::SO3d'
+    const Eigen::VectorXd _linPoint;
+    const Eigen::MatrixXd _sqrtInfo;
+
+public:
+    explicit MarginalPriorFactor(std::vector<int> sizes,
+                                 std::vector<bool> isSO3,
+                                 Eigen::VectorXd linPoint,
+                                 Eigen::MatrixXd sqrtInfo)
+        : _sizes(std::move(sizes)),
+          _isSO3(std::move(isSO3)),
+          _linPoint(std::move(linPoint)),
+          _sqrtInfo(std::move(sqrtInfo)) {}
+
+    static auto Create(const std::vector<int> &sizes,
+                       const std::vector<bool> &isSO3,
+                       const Eigen::VectorXd &linPoint,
+                       const Eigen::MatrixXd &sqrtInfo) {
+        return new ceres::DynamicAutoDiffCostFunction<MarginalPriorFactor>(
+            new MarginalPriorFactor(sizes, isSO3, linPoint, sqrtInfo));
+    }
+
+    static std::size_t TypeHashCode() { return typeid(MarginalPriorFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ PAR | PAR | ... | PAR ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        Eigen::Matrix<T, Eigen::Dynamic, 1> delta(_sqrtInfo.cols());
+        for (int i = 0, g = 0, l = 0; i < static_cast<int>(_sizes.size()); ++i) {
+            if (_isSO3.at(i)) {
+                Eigen::Map<Sophus::SO3<T> const> const SO3_Cur(sKnots[i]);
+                Sophus::SO3<T> SO3_Lin =
+                    Eigen::Map<Sophus::SO3d const>(_linPoint.data() + g).template cast<T>();
+                delta.template segment<3>(l) = (SO3_Cur * SO3_Lin.inverse()).log();
+                l += 3;
+            } else {
+                for (int j = 0; j < _sizes.at(i); ++j) {
+                    delta(l + j) = sKnots[i][j] - T(_linPoint(g + j));
+                }
+                l += _sizes.at(i);
+            }
+            g += _sizes.at(i);
+        }
+
+        Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, 1>> residuals(sResiduals, _sqrtInfo.rows());
+        residuals = _sqrtInfo.template cast<T>() * delta;
+        return true;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_MARGINAL_PRIOR_FACTOR_HPP
@@ -0,0 +1,92 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_MIXED_PRECISION_HPP
+#define IKALIBR_MIXED_PRECISION_HPP
+
+#include "ceres/jet.h"
+#include "Eigen/Core"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * the low-precision counterpart of a (jet) scalar, i.e., 'float' for 'double' and
+ * 'ceres::Jet<float, N>' for 'ceres::Jet<double, N>'. High-volume residuals evaluate their
+ * measurement-dependent parts in the low precision, whose jets are half-sized and twice as wide in
+ * SIMD lanes, while the spline evaluation (knot accumulation) and the solver stay in double
+ */
+template <class T>
+struct MixedPrecision {
+    using Low = float;
+
+    static Low ToLow(const T &v) { return static_cast<Low>(v); }
+
+    static T ToHigh(const Low &v) { return static_cast<T>(v); }
+};
+
+template <int N>
+struct MixedPrecision<ceres::Jet<double, N>> {
+    using High = ceres::Jet<double, N>;
+    using Low = ceres::Jet<float, N>;
+
+    static Low ToLow(const High &v) {
+        return Low(static_cast<float>(v.a), v.v.template cast<float>());
+    }
+
+    static High ToHigh(const Low &v) {
+        return High(static_cast<double>(v.a), v.v.template cast<double>());
+    }
+};
+
+// cast an eigen matrix of (jet) scalars to the low-precision one
+template <class T, int Rows, int Cols>
+Eigen::Matrix<typename MixedPrecision<T>::Low, Rows, Cols> ToLowPrecision(
+    const Eigen::Matrix<T, Rows, Cols> &mat) {
+    return mat.unaryExpr([](const T &v) { return MixedPrecision<T>::ToLow(v); });
+}
+
+// cast an eigen matrix of constants (measurements) to the low-precision (jet) one
+template <class T, class Derived>
+auto ConstToLowPrecision(const Eigen::MatrixBase<Derived> &mat) {
+    using Low = typename MixedPrecision<T>::Low;
+    return mat.template cast<float>().template cast<Low>().eval();
+}
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_MIXED_PRECISION_HPP
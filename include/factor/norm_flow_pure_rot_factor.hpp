@@ -124,7 +124,119 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
+/**
+ * the batched 'NormFlowPureRotFactor' for normal flows in a short time bin, which share one angular
+ * velocity evaluated at the bin time, and emit one residual for each normal flow
+ */
+template <int Order>
+struct NormFlowPureRotBinFactor {
+private:
+    ns_ctraj::SplineMeta<Order> _so3Meta;
+    double _timestamp;
+    std::vector<NormFlow::Ptr> _nfs;
+
+    double _so3DtInv;
+    double _weight;
+    // the parameter of the huber loss applied to each normal flow
+    double _lossParam;
+
+public:
+    explicit NormFlowPureRotBinFactor(ns_ctraj::SplineMeta<Order> so3Meta,
+                                      double timestamp,
+                                      std::vector<NormFlow::Ptr> nfs,
+                                      double weight,
+                                      double lossParam)
+        : _so3Meta(std::move(so3Meta)),
+          _timestamp(timestamp),
+          _nfs(std::move(nfs)),
+          _so3DtInv(1.0 / _so3Meta.segments.front().dt),
+          _weight(weight),
+          _lossParam(lossParam) {}
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       double timestamp,
+                       const std::vector<NormFlow::Ptr> &nfs,
+                       double weight,
+                       double lossParam) {
+        return new ceres::DynamicAutoDiffCostFunction<NormFlowPureRotBinFactor>(
+            new NormFlowPureRotBinFactor(so3Meta, timestamp, nfs, weight, lossParam));
+    }
+
+    static std::size_t TypeHashCode() { return typeid(NormFlowPureRotBinFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 | ... | SO3 | SO3_EsToBr | TO_EsToBr | FX | FY | CX | CY ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        // array offset
+        std::size_t SO3_EsToBr_OFFSET = _so3Meta.NumParameters();
+        std::size_t TO_EsToBr_OFFSET = SO3_EsToBr_OFFSET + 1;
+        std::size_t FX_OFFSET = TO_EsToBr_OFFSET + 1;
+        std::size_t FY_OFFSET = FX_OFFSET + 1;
+        std::size_t CX_OFFSET = FY_OFFSET + 1;
+        std::size_t CY_OFFSET = CX_OFFSET + 1;
+
+        Eigen::Map<Sophus::SO3<T> const> const SO3_EsToBr(sKnots[SO3_EsToBr_OFFSET]);
+        Sophus::SO3<T> SO3_BrToEs = SO3_EsToBr.inverse();
+
+        T TO_EsToBr = sKnots[TO_EsToBr_OFFSET][0];
+        T FX = sKnots[FX_OFFSET][0];
+        T FY = sKnots[FY_OFFSET][0];
+        T CX = sKnots[CX_OFFSET][0];
+        T CY = sKnots[CY_OFFSET][0];
+
+        T timeByBr = _timestamp + TO_EsToBr;
+
+        // calculate the so3 offset
+        std::pair<std::size_t, T> iuCur;
+        _so3Meta.ComputeSplineIndex(timeByBr, iuCur.first, iuCur.second);
+        std::size_t SO3_OFFSET = iuCur.first;
+
+        Sophus::SO3<T> SO3_BrToBr0;
+        Sophus::SO3Tangent<T> ANG_VEL_BrToBr0InBr;
+        ns_ctraj::CeresSplineHelperJet<T, Order>::EvaluateLie(
+            sKnots + SO3_OFFSET, iuCur.second, _so3DtInv, &SO3_BrToBr0, &ANG_VEL_BrToBr0InBr);
+
+        // the angular velocity of the event camera, which is shared by all normal flows
+        Eigen::Vector3<T> ANG_VEL_EsToBr0InEs = SO3_BrToEs * ANG_VEL_BrToBr0InBr;
+
+        for (std::size_t i = 0; i < _nfs.size(); ++i) {
+            const auto &nf = _nfs[i];
+            Eigen::Matrix<T, 2, 3> subBMat;
+            OpticalFlowCorr::SubBMat<T>(&FX, &FY, &CX, &CY, nf->p.cast<T>(), &subBMat);
+
+            T pred = nf->nfDir.cast<T>().dot(subBMat * ANG_VEL_EsToBr0InEs);
+            sResiduals[i] = RobustResidual(T(_weight) * (nf->nfNorm - pred));
+        }
+
+        return true;
+    }
+
+protected:
+    /**
+     * the residual 'r' is mapped to 'r'' so that 'r'^2' equals to the huber-robustified 'r^2',
+     * thus the cost equals to the one using 'ceres::HuberLoss' for each normal flow
+     */
+    template <class T>
+    T RobustResidual(const T &r) const {
+        using std::abs;
+        using std::sqrt;
+        if (abs(r) <= T(_lossParam)) {
+            return r;
+        }
+        T s = sqrt(T(2.0 * _lossParam) * abs(r) - T(_lossParam * _lossParam));
+        return r < T(0.0) ? T(-s) : s;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 extern template struct NormFlowPureRotFactor<Configor ::Prior::SplineOrder>;
+extern template struct NormFlowPureRotBinFactor<Configor ::Prior::SplineOrder>;
 }  // namespace ns_ikalibr
 
 #endif  // NORM_FLOW_ROTATION_FACTOR_HPP
@@ -38,11 +38,14 @@
 #include "ctraj/utils/eigen_utils.hpp"
 #include "ctraj/utils/sophus_utils.hpp"
 #include "ctraj/spline/spline_segment.h"
+#include "ctraj/spline/ceres_spline_helper.h"
 #include "ctraj/spline/ceres_spline_helper_jet.h"
 #include "ceres/dynamic_autodiff_cost_function.h"
+#include "factor/sized_autodiff_cost_function.hpp"
 #include "util/utils.h"
 #include "config/configor.h"
 #include "factor/data_correspondence.h"
+#include "factor/mixed_precision.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,7 +57,11 @@ template <int Order, int TimeDeriv>
 struct PointToSurfelFactor {
 private:
     ns_ctraj::SplineMeta<Order> _so3Meta, _scaleMeta;
-    PointToSurfelCorr::Ptr _ptsCorr;
+    // the correspondence is copied from the packed buffer, which is not kept alive by factors
+    double _timestamp;
+    Eigen::Vector3d _pInScan;
+    // [norm dir, dist]
+    Eigen::Vector4d _surfelInW;
 
     double _so3DtInv, _scaleDtInv;
     double _weight;
@@ -62,21 +69,45 @@ private:
 public:
     explicit PointToSurfelFactor(const ns_ctraj::SplineMeta<Order> &so3Meta,
                                  const ns_ctraj::SplineMeta<Order> &scaleMeta,
-                                 PointToSurfelCorr::Ptr ptsCorr,
+                                 double timestamp,
+                                 Eigen::Vector3d pInScan,
+                                 Eigen::Vector4d surfelInW,
                                  double weight)
         : _so3Meta(so3Meta),
           _scaleMeta(scaleMeta),
-          _ptsCorr(std::move(ptsCorr)),
+          _timestamp(timestamp),
+          _pInScan(std::move(pInScan)),
+          _surfelInW(std::move(surfelInW)),
           _so3DtInv(1.0 / _so3Meta.segments.front().dt),
           _scaleDtInv(1.0 / _scaleMeta.segments.front().dt),
           _weight(weight) {}
 
     static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
                        const ns_ctraj::SplineMeta<Order> &scaleMeta,
-                       const PointToSurfelCorr::Ptr &ptsCorr,
+                       double timestamp,
+                       const Eigen::Vector3d &pInScan,
+                       const Eigen::Vector4d &surfelInW,
                        double weight) {
         return new ceres::DynamicAutoDiffCostFunction<PointToSurfelFactor>(
-            new PointToSurfelFactor(so3Meta, scaleMeta, ptsCorr, weight));
+            new PointToSurfelFactor(so3Meta, scaleMeta, timestamp, pInScan, surfelInW, weight));
+    }
+
+    /**
+     * the fixed-size cost function, which is used when only 'Order' so3 and linear scale knots are
+     * involved, i.e., the time offset is not padded:
+     * [ SO3 x 4 | LIN_SCALE x 4 | SO3_LkToBr | POS_LkInBr | TO_LkToBr ]
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                            double timestamp,
+                            const Eigen::Vector3d &pInScan,
+                            const Eigen::Vector4d &surfelInW,
+                            double weight) {
+        static_assert(Order == 4,
+                      "the fixed-size point-to-surfel factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<PointToSurfelFactor, 1, 4, 4, 4, 4, 3, 3, 3, 3, 4, 3,
+                                             1>(
+            new PointToSurfelFactor(so3Meta, scaleMeta, timestamp, pInScan, surfelInW, weight));
     }
 
     static std::size_t TypeHashCode() { return typeid(PointToSurfelFactor).hash_code(); }
@@ -100,7 +131,7 @@ public:
         Eigen::Map<const Eigen::Vector3<T>> POS_LkInBr(sKnots[POS_LkInBr_OFFSET]);
         T TO_LkToBr = sKnots[TO_LkToBr_OFFSET][0];
 
-        auto timeByBr = _ptsCorr->timestamp + TO_LkToBr;
+        auto timeByBr = _timestamp + TO_LkToBr;
 
         // calculate the so3 and lin scale offset
         std::pair<std::size_t, T> iuSo3, iuScale;
@@ -119,12 +150,11 @@ public:
             sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, &POS_BrInBr0);
 
         // construct the residuals
-        Eigen::Vector3<T> pointInBr =
-            SO3_LkToBr * _ptsCorr->pInScan.template cast<T>() + POS_LkInBr;
+        Eigen::Vector3<T> pointInBr = SO3_LkToBr * _pInScan.template cast<T>() + POS_LkInBr;
         Eigen::Vector3<T> pointInBr0 = SO3_BrToBr0 * pointInBr + POS_BrInBr0;
 
-        Eigen::Vector3<T> planeNorm = _ptsCorr->surfelInW.head(3).template cast<T>();
-        T distance = pointInBr0.dot(planeNorm) + T(_ptsCorr->surfelInW(3));
+        Eigen::Vector3<T> planeNorm = _surfelInW.head(3).template cast<T>();
+        T distance = pointInBr0.dot(planeNorm) + T(_surfelInW(3));
 
         Eigen::Map<Eigen::Matrix11<T>> residuals(sResiduals);
         residuals.template block<1, 1>(0, 0) = T(_weight) * Eigen::Matrix11<T>(distance);
@@ -136,8 +166,236 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
+/**
+ * points associated to the same surfel whose times fall into the same knot window, the plane
+ * coefficients and the extrinsics are loaded only once for all points. As residuals of points are
+ * organized as one block, the robust (huber) loss is applied to each point inside, rather than by
+ * ceres. If 'OptTimeOffset' is false, the (constant) time offset is only involved in the
+ * construction, where the spline indices of points are computed once, thus splines are evaluated
+ * at plain times rather than jets in iterations
+ */
+template <int Order, int TimeDeriv, bool OptTimeOffset = true>
+struct PointToSurfelGroupFactor {
+private:
+    ns_ctraj::SplineMeta<Order> _so3Meta, _scaleMeta;
+
+    std::vector<double> _timestamps;
+    Eigen::aligned_vector<Eigen::Vector3d> _pInScan;
+    // the weights of points, i.e., the weight of the sensor times the one of the correspondence
+    std::vector<double> _weights;
+    // [norm dir, dist], shared by all points
+    Eigen::Vector4d _surfelInW;
+    // the spline indices of points, which are only computed if the time offset is fixed
+    std::vector<std::pair<std::size_t, double>> _iuSo3, _iuScale;
+
+    double _so3DtInv, _scaleDtInv;
+    // the parameter of the huber loss applied to the (unweighted) distance of each point
+    double _lossParam;
+    // whether transformations of points are evaluated in the low precision (see 'MixedPrecision')
+    bool _mixedPrecision;
+
+public:
+    explicit PointToSurfelGroupFactor(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                                      const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                                      const PointToSurfelCorrBuffer &corrs,
+                                      const std::vector<std::size_t> &indices,
+                                      double weight,
+                                      double lossParam,
+                                      double timeOffset,
+                                      bool mixedPrecision)
+        : _so3Meta(so3Meta),
+          _scaleMeta(scaleMeta),
+          _surfelInW(corrs.SurfelOf(indices.front())),
+          _so3DtInv(1.0 / _so3Meta.segments.front().dt),
+          _scaleDtInv(1.0 / _scaleMeta.segments.front().dt),
+          _lossParam(lossParam),
+          _mixedPrecision(mixedPrecision) {
+        _timestamps.reserve(indices.size());
+        _pInScan.reserve(indices.size());
+        _weights.reserve(indices.size());
+        for (const auto &idx : indices) {
+            _timestamps.push_back(corrs.timestamps.at(idx));
+            _pInScan.emplace_back(corrs.pInScan.at(idx).cast<double>());
+            _weights.push_back(weight * corrs.weights.at(idx));
+        }
+        if constexpr (!OptTimeOffset) {
+            _iuSo3.resize(_timestamps.size());
+            _iuScale.resize(_timestamps.size());
+            for (std::size_t i = 0; i < _timestamps.size(); ++i) {
+                const double timeByBr = _timestamps[i] + timeOffset;
+                _so3Meta.ComputeSplineIndex(timeByBr, _iuSo3[i].first, _iuSo3[i].second);
+                _scaleMeta.ComputeSplineIndex(timeByBr, _iuScale[i].first, _iuScale[i].second);
+            }
+        }
+    }
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                       const PointToSurfelCorrBuffer &corrs,
+                       const std::vector<std::size_t> &indices,
+                       double weight,
+                       double lossParam,
+                       double timeOffset,
+                       bool mixedPrecision = Configor::Preference::MixedPrecisionResiduals) {
+        return new ceres::DynamicAutoDiffCostFunction<PointToSurfelGroupFactor>(
+            new PointToSurfelGroupFactor(so3Meta, scaleMeta, corrs, indices, weight, lossParam,
+                                         timeOffset, mixedPrecision));
+    }
+
+    /**
+     * the fixed-size cost function (with one residual per point), see
+     * 'PointToSurfelFactor::CreateSized'
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                            const PointToSurfelCorrBuffer &corrs,
+                            const std::vector<std::size_t> &indices,
+                            double weight,
+                            double lossParam,
+                            double timeOffset,
+                            bool mixedPrecision = Configor::Preference::MixedPrecisionResiduals) {
+        static_assert(Order == 4,
+                      "the fixed-size point-to-surfel group factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<PointToSurfelGroupFactor, ceres::DYNAMIC, 4, 4, 4, 4,
+                                             3, 3, 3, 3, 4, 3, 1>(
+            new PointToSurfelGroupFactor(so3Meta, scaleMeta, corrs, indices, weight, lossParam,
+                                         timeOffset, mixedPrecision),
+            static_cast<int>(indices.size()));
+    }
+
+    // the fixed-size cost function if only 'Order' knots of each spline are involved
+    static ceres::CostFunction *CreateCostFunction(
+        const ns_ctraj::SplineMeta<Order> &so3Meta,
+        const ns_ctraj::SplineMeta<Order> &scaleMeta,
+        const PointToSurfelCorrBuffer &corrs,
+        const std::vector<std::size_t> &indices,
+        double weight,
+        double lossParam,
+        double timeOffset,
+        bool mixedPrecision = Configor::Preference::MixedPrecisionResiduals) {
+        if (so3Meta.NumParameters() == Order && scaleMeta.NumParameters() == Order) {
+            return CreateSized(so3Meta, scaleMeta, corrs, indices, weight, lossParam, timeOffset,
+                               mixedPrecision);
+        }
+        auto dynCostFunc = Create(so3Meta, scaleMeta, corrs, indices, weight, lossParam,
+                                  timeOffset, mixedPrecision);
+        dynCostFunc->SetNumResiduals(static_cast<int>(indices.size()));
+        return dynCostFunc;
+    }
+
+    static std::size_t TypeHashCode() { return typeid(PointToSurfelGroupFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_LkToBr | POS_LkInBr | TO_LkToBr ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        std::size_t SO3_LkToBr_OFFSET = _so3Meta.NumParameters() + _scaleMeta.NumParameters();
+        std::size_t POS_LkInBr_OFFSET = SO3_LkToBr_OFFSET + 1;
+        std::size_t TO_LkToBr_OFFSET = POS_LkInBr_OFFSET + 1;
+
+        // get value
+        Eigen::Map<const Sophus::SO3<T>> SO3_LkToBr(sKnots[SO3_LkToBr_OFFSET]);
+        Eigen::Map<const Eigen::Vector3<T>> POS_LkInBr(sKnots[POS_LkInBr_OFFSET]);
+        T TO_LkToBr = sKnots[TO_LkToBr_OFFSET][0];
+
+        // the surfel is shared by all points
+        Eigen::Vector3<T> planeNorm = _surfelInW.head(3).template cast<T>();
+        T planeDist = T(_surfelInW(3));
+
+        // low-precision counterparts of the shared quantities for the mixed-precision mode
+        using Low = typename MixedPrecision<T>::Low;
+        Eigen::Matrix3<Low> ROT_LkToBrLow;
+        Eigen::Vector3<Low> POS_LkInBrLow, planeNormLow;
+        if (_mixedPrecision) {
+            ROT_LkToBrLow = ToLowPrecision<T>(SO3_LkToBr.matrix());
+            POS_LkInBrLow = ToLowPrecision<T>(Eigen::Vector3<T>(POS_LkInBr));
+            planeNormLow = ConstToLowPrecision<T>(_surfelInW.head<3>());
+        }
+
+        for (std::size_t i = 0; i < _timestamps.size(); ++i) {
+            Sophus::SO3<T> SO3_BrToBr0;
+            Eigen::Vector3<T> POS_BrInBr0;
+            if constexpr (OptTimeOffset) {
+                auto timeByBr = _timestamps[i] + TO_LkToBr;
+
+                // calculate the so3 and lin scale offset
+                std::pair<std::size_t, T> iuSo3, iuScale;
+                _so3Meta.ComputeSplineIndex(timeByBr, iuSo3.first, iuSo3.second);
+                _scaleMeta.ComputeSplineIndex(timeByBr, iuScale.first, iuScale.second);
+
+                std::size_t SO3_OFFSET = iuSo3.first;
+                std::size_t LIN_SCALE_OFFSET = iuScale.first + _so3Meta.NumParameters();
+
+                ns_ctraj::CeresSplineHelperJet<T, Order>::EvaluateLie(
+                    sKnots + SO3_OFFSET, iuSo3.second, _so3DtInv, &SO3_BrToBr0);
+
+                ns_ctraj::CeresSplineHelperJet<T, Order>::template Evaluate<3, TimeDeriv>(
+                    sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, &POS_BrInBr0);
+            } else {
+                std::size_t SO3_OFFSET = _iuSo3[i].first;
+                std::size_t LIN_SCALE_OFFSET = _iuScale[i].first + _so3Meta.NumParameters();
+
+                ns_ctraj::CeresSplineHelper<Order>::EvaluateLie(
+                    sKnots + SO3_OFFSET, _iuSo3[i].second, _so3DtInv, &SO3_BrToBr0);
+
+                ns_ctraj::CeresSplineHelper<Order>::template Evaluate<T, 3, TimeDeriv>(
+                    sKnots + LIN_SCALE_OFFSET, _iuScale[i].second, _scaleDtInv, &POS_BrInBr0);
+            }
+
+            T distance;
+            if (_mixedPrecision) {
+                // the point is transformed in the low precision, the pose of the spline is cast
+                Eigen::Vector3<Low> pointInBr =
+                    ROT_LkToBrLow * ConstToLowPrecision<T>(_pInScan[i]) + POS_LkInBrLow;
+                const Eigen::Matrix3<Low> ROT_BrToBr0Low = ToLowPrecision<T>(SO3_BrToBr0.matrix());
+                Eigen::Vector3<Low> pointInBr0 =
+                    ROT_BrToBr0Low * pointInBr + ToLowPrecision<T>(POS_BrInBr0);
+                // the plane distance is added in the high precision, which may be large
+                distance = MixedPrecision<T>::ToHigh(pointInBr0.dot(planeNormLow)) + planeDist;
+            } else {
+                Eigen::Vector3<T> pointInBr =
+                    SO3_LkToBr * _pInScan[i].template cast<T>() + POS_LkInBr;
+                Eigen::Vector3<T> pointInBr0 = SO3_BrToBr0 * pointInBr + POS_BrInBr0;
+
+                distance = pointInBr0.dot(planeNorm) + planeDist;
+            }
+            sResiduals[i] = T(_weights[i]) * RobustResidual(distance);
+        }
+
+        return true;
+    }
+
+protected:
+    /**
+     * the residual 'r' is mapped to 'r'' so that 'r'^2' equals to the huber-robustified 'r^2',
+     * weighting it afterwards equals to 'ceres::HuberLoss' with the weighted loss parameter
+     */
+    template <class T>
+    T RobustResidual(const T &r) const {
+        using std::abs;
+        using std::sqrt;
+        if (abs(r) <= T(_lossParam)) {
+            return r;
+        }
+        T s = sqrt(T(2.0 * _lossParam) * abs(r) - T(_lossParam * _lossParam));
+        return r < T(0.0) ? T(-s) : s;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 extern template struct PointToSurfelFactor<Configor::Prior::SplineOrder, 2>;
 extern template struct PointToSurfelFactor<Configor::Prior::SplineOrder, 1>;
 extern template struct PointToSurfelFactor<Configor::Prior::SplineOrder, 0>;
+extern template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 2>;
+extern template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 1>;
+extern template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 0>;
+extern template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 2, false>;
+extern template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 1, false>;
+extern template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 0, false>;
 }  // namespace ns_ikalibr
 #endif  // IKALIBR_POINT_TO_SURFEL_FACTOR_HPP
@@ -37,6 +37,7 @@
 #include "factor/data_correspondence.h"
 #include "veta/camera/pinhole.h"
 #include "factor/visual_optical_flow_factor.hpp"
+#include "factor/sized_autodiff_cost_function.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -195,6 +196,23 @@ public:
             new PPPTrifocalTensorFactor(rotMeta, linScaleMeta, ofCorr, weight));
     }
 
+    /**
+     * the fixed-size cost function, which is used when only 'Order' knots of each spline are
+     * involved, i.e., the three features are in a single spline segment:
+     * [ SO3 x 4 | LIN_SCALE x 4 | SO3_CmToBr | POS_CmInBr | TO_CmToBr | READOUT_TIME | FX | FY |
+     *   CX | CY ]
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                            const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                            const OpticalFlowCorr::Ptr &ofCorr,
+                            double weight) {
+        static_assert(Order == 4,
+                      "the fixed-size trifocal tensor factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<PPPTrifocalTensorFactor, 4, 4, 4, 4, 4, 3, 3, 3, 3, 4,
+                                             3, 1, 1, 1, 1, 1, 1>(
+            new PPPTrifocalTensorFactor(rotMeta, linScaleMeta, ofCorr, weight));
+    }
+
     static std::size_t TypeHashCode() { return typeid(PPPTrifocalTensorFactor).hash_code(); }
 
     template <class T>
@@ -289,39 +307,10 @@ public:
         Sophus::SE3<T> SE3_CmMidToCmFir = SE3_CmToBr.inverse() * SE3_BrMidToBrFir * SE3_CmToBr;
         Sophus::SE3<T> SE3_CmMidToCmLast = SE3_CmToBr.inverse() * SE3_BrMidToBrLast * SE3_CmToBr;
 
-        Eigen::Matrix33<T> SO3_CmMidToCmFir = SE3_CmMidToCmFir.so3().matrix();
-        Eigen::Matrix33<T> SO3_CmMidToCmLast = SE3_CmMidToCmLast.so3().matrix();
-
-        Eigen::Vector3<T> POS_CmMidInCmFir = SE3_CmMidToCmFir.translation();
-        Eigen::Vector3<T> POS_CmMidInCmLast = SE3_CmMidToCmLast.translation();
-
-        std::array<Eigen::Vector3<T>, 3> bvs;
-
-        for (int i = 0; i < 3; ++i) {
-            const double x = _corr->xTraceAry[i], y = _corr->yTraceAry[i];
-            Eigen::Vector2<T> f = Eigen::Vector2d(x, y).cast<T>();
-            Eigen::Vector3<T> p;
-            VisualReProjCorr::TransformImgToCam<T>(&FX_INV, &FY_INV, &CX, &CY, f, &p);
-            bvs[i] = p.normalized();
-        }
-
-        Eigen::Matrix33<T> m1 = Eigen::Matrix33<T>::Zero();
-
-        for (int i = 0; i < 3; ++i) {
-            Eigen::Matrix33<T> v1 = SO3_CmMidToCmFir.col(i) * POS_CmMidInCmLast.transpose();
-            Eigen::Matrix33<T> v2 = POS_CmMidInCmFir * SO3_CmMidToCmLast.col(i).transpose();
-            Eigen::Matrix33<T> Ti = v1 - v2;
-            m1 += bvs.at(1)(i) * Ti;
-        }
-
-        Eigen::Matrix33<T> m2 =
-            Sophus::SO3<T>::hat(bvs.at(0)) * m1 * Sophus::SO3<T>::hat(bvs.at(2));
-
-        Eigen::Vector4<T> resVec;
-        resVec(0) = m2(0, 0);
-        resVec(1) = m2(0, 2);
-        resVec(2) = m2(2, 0);
-        resVec(3) = m2(2, 2);
+        Eigen::Vector4<T> resVec = _corr->template TrifocalTensorResiduals<T>(
+            &FX_INV, &FY_INV, &CX, &CY, SE3_CmMidToCmFir.so3().matrix(),
+            SE3_CmMidToCmFir.translation(), SE3_CmMidToCmLast.so3().matrix(),
+            SE3_CmMidToCmLast.translation());
 
         Eigen::Map<Eigen::Vector4<T>> residuals(sResiduals);
         residuals = T(_weight) * resVec;
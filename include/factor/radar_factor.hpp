@@ -40,6 +40,8 @@
 #include "ctraj/spline/spline_segment.h"
 #include "ctraj/spline/ceres_spline_helper_jet.h"
 #include "ceres/dynamic_autodiff_cost_function.h"
+#include "factor/sized_autodiff_cost_function.hpp"
+#include "factor/mixed_precision.hpp"
 #include "sensor/radar.h"
 #include "util/utils.h"
 #include "config/configor.h"
@@ -79,6 +81,20 @@ public:
             new RadarFactor(so3Meta, scaleMeta, frame, weight));
     }
 
+    /**
+     * the fixed-size cost function, which is used when only 'Order' knots of each spline are
+     * involved, i.e., the time offset is not padded:
+     * [ SO3 x 4 | LIN_SCALE x 4 | SO3_RjToBr | POS_RjInBr | TO_RjToBr ]
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                            const RadarTarget::Ptr &frame,
+                            double weight) {
+        static_assert(Order == 4, "the fixed-size radar factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<RadarFactor, 1, 4, 4, 4, 4, 3, 3, 3, 3, 4, 3, 1>(
+            new RadarFactor(so3Meta, scaleMeta, frame, weight));
+    }
+
     static std::size_t TypeHashCode() { return typeid(RadarFactor).hash_code(); }
 
 public:
@@ -136,9 +152,173 @@ public:
     }
 };
 
+/**
+ * doppler measurements of all targets in one radar scan, which share the same timestamp, thus the
+ * spline kinematics are evaluated only once for all targets. As residuals of targets are organized
+ * as one block, the robust (huber) loss is applied to each target inside, rather than by ceres
+ */
+template <int Order, int TimeDeriv>
+struct RadarScanFactor {
+private:
+    ns_ctraj::SplineMeta<Order> _so3Meta, _scaleMeta;
+
+    double _timestamp;
+    // targets of this scan are referred by indices [begin, begin + count) in the array, whose
+    // structure-of-arrays layout provides unit directions in {Rj} and radial velocities
+    RadarTargetArray::Ptr _array;
+    Eigen::Index _begin, _count;
+
+    double _so3DtInv, _scaleDtInv;
+    double _weight;
+    // the parameter of the huber loss applied to each target
+    double _lossParam;
+    // whether doppler residuals of targets are evaluated in the low precision
+    bool _mixedPrecision;
+
+public:
+    explicit RadarScanFactor(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                             const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                             RadarTargetArray::Ptr array,
+                             Eigen::Index begin,
+                             Eigen::Index count,
+                             double weight,
+                             double lossParam,
+                             bool mixedPrecision)
+        : _so3Meta(so3Meta),
+          _scaleMeta(scaleMeta),
+          _timestamp(array->GetTargetSoA().timestamps(begin)),
+          _array(std::move(array)),
+          _begin(begin),
+          _count(count),
+          _so3DtInv(1.0 / _so3Meta.segments.front().dt),
+          _scaleDtInv(1.0 / _scaleMeta.segments.front().dt),
+          _weight(weight),
+          _lossParam(lossParam),
+          _mixedPrecision(mixedPrecision) {}
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                       const RadarTargetArray::Ptr &array,
+                       Eigen::Index begin,
+                       Eigen::Index count,
+                       double weight,
+                       double lossParam,
+                       bool mixedPrecision = Configor::Preference::MixedPrecisionResiduals) {
+        return new ceres::DynamicAutoDiffCostFunction<RadarScanFactor>(new RadarScanFactor(
+            so3Meta, scaleMeta, array, begin, count, weight, lossParam, mixedPrecision));
+    }
+
+    /**
+     * the fixed-size cost function (with one residual per target), see 'RadarFactor::CreateSized'
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                            const RadarTargetArray::Ptr &array,
+                            Eigen::Index begin,
+                            Eigen::Index count,
+                            double weight,
+                            double lossParam,
+                            bool mixedPrecision = Configor::Preference::MixedPrecisionResiduals) {
+        static_assert(Order == 4, "the fixed-size radar scan factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<RadarScanFactor, ceres::DYNAMIC, 4, 4, 4, 4, 3, 3, 3,
+                                             3, 4, 3, 1>(
+            new RadarScanFactor(so3Meta, scaleMeta, array, begin, count, weight, lossParam,
+                                mixedPrecision),
+            static_cast<int>(count));
+    }
+
+    static std::size_t TypeHashCode() { return typeid(RadarScanFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_RjToBr | POS_RjInBr | TO_RjToBr ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        std::size_t SO3_OFFSET, LIN_SCALE_OFFSET;
+        std::size_t SO3_RjToBr_OFFSET = _so3Meta.NumParameters() + _scaleMeta.NumParameters();
+        std::size_t POS_RjInBr_OFFSET = SO3_RjToBr_OFFSET + 1;
+        std::size_t TO_RjToBr_OFFSET = POS_RjInBr_OFFSET + 1;
+
+        // get value
+        Eigen::Map<const Sophus::SO3<T>> SO3_RjToBr(sKnots[SO3_RjToBr_OFFSET]);
+        Eigen::Map<const Eigen::Vector3<T>> POS_RjInBr(sKnots[POS_RjInBr_OFFSET]);
+        T TO_RjToBr = sKnots[TO_RjToBr_OFFSET][0];
+
+        auto timeByBr = _timestamp + TO_RjToBr;
+
+        // calculate the so3 and pos offset
+        std::pair<std::size_t, T> iuSo3, iuScale;
+        _so3Meta.ComputeSplineIndex(timeByBr, iuSo3.first, iuSo3.second);
+        _scaleMeta.ComputeSplineIndex(timeByBr, iuScale.first, iuScale.second);
+
+        SO3_OFFSET = iuSo3.first;
+        LIN_SCALE_OFFSET = iuScale.first + _so3Meta.NumParameters();
+
+        // query
+        Sophus::SO3<T> SO3_BrToBr0;
+        Eigen::Vector3<T> ANG_VEL_BrToBr0InBr;
+        ns_ctraj::CeresSplineHelperJet<T, Order>::EvaluateLie(
+            sKnots + SO3_OFFSET, iuSo3.second, _so3DtInv, &SO3_BrToBr0, &ANG_VEL_BrToBr0InBr);
+        Eigen::Vector3<T> ANG_VEL_BrToBr0InBr0 = SO3_BrToBr0 * ANG_VEL_BrToBr0InBr;
+
+        Eigen::Vector3<T> LIN_VEL_BrInBr0;
+        ns_ctraj::CeresSplineHelperJet<T, Order>::template Evaluate<3, TimeDeriv>(
+            sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, &LIN_VEL_BrInBr0);
+
+        // the velocity of the radar expressed in {Rj}, which is shared by all targets
+        Eigen::Vector3<T> LIN_VEL_RjInRj =
+            SO3_RjToBr.inverse() *
+            (SO3_BrToBr0.inverse() *
+             (-Sophus::SO3<T>::hat(SO3_BrToBr0 * POS_RjInBr) * ANG_VEL_BrToBr0InBr0 +
+              LIN_VEL_BrInBr0));
+
+        const RadarTargetSoAView targets = _array->GetTargetSoA().View(_begin, _count);
+        if (_mixedPrecision) {
+            // the shared velocity is cast once, and targets are evaluated in the low precision
+            using Low = typename MixedPrecision<T>::Low;
+            const Eigen::Vector3<Low> LIN_VEL_RjInRjLow = ToLowPrecision<T>(LIN_VEL_RjInRj);
+            const Low weight(static_cast<float>(_weight));
+            for (Eigen::Index i = 0; i < _count; ++i) {
+                Low v1 = -ConstToLowPrecision<T>(targets.dirs.col(i)).dot(LIN_VEL_RjInRjLow);
+                Low v2(static_cast<float>(targets.radialVels(i)));
+                sResiduals[i] = RobustResidual(MixedPrecision<T>::ToHigh(weight * (v1 - v2)));
+            }
+            return true;
+        }
+        for (Eigen::Index i = 0; i < _count; ++i) {
+            T v1 = -targets.dirs.col(i).template cast<T>().dot(LIN_VEL_RjInRj);
+            T v2 = static_cast<T>(targets.radialVels(i));
+            sResiduals[i] = RobustResidual(T(_weight) * (v1 - v2));
+        }
+
+        return true;
+    }
+
+protected:
+    /**
+     * the residual 'r' is mapped to 'r'' so that 'r'^2' equals to the huber-robustified 'r^2',
+     * thus the cost equals to the one using 'ceres::HuberLoss' for each target
+     */
+    template <class T>
+    T RobustResidual(const T &r) const {
+        using std::abs;
+        using std::sqrt;
+        if (abs(r) <= T(_lossParam)) {
+            return r;
+        }
+        T s = sqrt(T(2.0 * _lossParam) * abs(r) - T(_lossParam * _lossParam));
+        return r < T(0.0) ? T(-s) : s;
+    }
+};
+
 extern template struct RadarFactor<Configor::Prior::SplineOrder, 2>;
 extern template struct RadarFactor<Configor::Prior::SplineOrder, 1>;
 extern template struct RadarFactor<Configor::Prior::SplineOrder, 0>;
+extern template struct RadarScanFactor<Configor::Prior::SplineOrder, 2>;
+extern template struct RadarScanFactor<Configor::Prior::SplineOrder, 1>;
+extern template struct RadarScanFactor<Configor::Prior::SplineOrder, 0>;
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_RADAR_FACTOR_HPP
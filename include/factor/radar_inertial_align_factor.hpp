@@ -78,15 +78,17 @@ public:
                              const RadarTargetArray::Ptr &eRadarAry,
                              double TO_RjToBr,
                              const std::pair<Eigen::Vector3d, Eigen::Matrix3d> &velVecMat,
-                             double ransacThd) {
+                             const Eigen::Vector3d &sRadarVel,
+                             const Eigen::Vector3d &eRadarVel) {
         double st = sRadarAry->GetTimestamp(), et = eRadarAry->GetTimestamp();
         dt = et - st;
 
         velVec = velVecMat.first;
         velMat = velVecMat.second;
 
-        sDVec = RadarVelocityFromStaticTargetArray(sRadarAry, ransacThd);
-        eDVec = RadarVelocityFromStaticTargetArray(eRadarAry, ransacThd);
+        // radar velocities are estimated in advance, see 'RadarVelocitySac'
+        sDVec = sRadarVel;
+        eDVec = eRadarVel;
 
         sANG_VEL_BcToBc0 = AngularVelBrToBr0(so3Spline, st + TO_RjToBr);
         eANG_VEL_BcToBc0 = AngularVelBrToBr0(so3Spline, et + TO_RjToBr);
@@ -99,31 +101,6 @@ protected:
     static Eigen::Vector3d AngularVelBrToBr0(const So3SplineType &so3Spline, double t) {
         return so3Spline.Evaluate(t) * so3Spline.VelocityBody(t);
     }
-
-    static Eigen::Vector3d RadarVelocityFromStaticTargetArray(const RadarTargetArray::Ptr &ary,
-                                                              double ransacThd) {
-        opengv::sac::Ransac<RadarVelocitySacProblem> ransac;
-        std::shared_ptr<RadarVelocitySacProblem> probPtr(new RadarVelocitySacProblem(ary));
-        ransac.sac_model_ = probPtr;
-        ransac.threshold_ = ransacThd;
-        ransac.max_iterations_ = 20;
-        bool res = ransac.computeModel();
-        if (res) {
-            // spdlog::info("inlier rate: {}/{}", ransac.inliers_.size(), ary->GetTargets().size());
-            Eigen::Vector3d radarVel;
-            probPtr->optimizeModelCoefficients(ransac.inliers_, ransac.model_coefficients_,
-                                               radarVel);
-
-            // std::cout << " RANSAC: " << radarVel.transpose() << std::endl;
-            // std::cout << "LS PROB: " << ary->RadarVelocityFromStaticTargetArray().transpose() <<
-            // std::endl;
-
-            return radarVel;
-        } else {
-            spdlog::warn("compute velocity using RANSAC failed, try to use all targets to fit...");
-            return ary->RadarVelocityFromStaticTargetArray();
-        }
-    }
 };
 
 extern template struct RadarInertialAlignHelper<Configor::Prior::SplineOrder>;
@@ -0,0 +1,125 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_SIZED_AUTODIFF_COST_FUNCTION_HPP
+#define IKALIBR_SIZED_AUTODIFF_COST_FUNCTION_HPP
+
+#include "ceres/sized_cost_function.h"
+#include "ceres/jet.h"
+#include "util/utils.h"
+#include "array"
+#include "memory"
+#include "vector"
+#include "algorithm"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * a fixed-size counterpart of 'ceres::DynamicAutoDiffCostFunction' for functors whose operator is
+ * 'bool operator()(T const *const *params, T *residuals)'. Jacobians of all parameter blocks are
+ * obtained in a single evaluation using a stack-allocated jet, rather than the multiple strided
+ * passes (with heap-allocated jets) performed by the dynamic one. 'kNumResiduals' could be
+ * 'ceres::DYNAMIC', in which case the number of residuals is passed to the constructor
+ */
+template <typename Functor, int kNumResiduals, int... Ns>
+class SizedAutoDiffCostFunction : public ceres::SizedCostFunction<kNumResiduals, Ns...> {
+public:
+    static constexpr int NumParameterBlocks = sizeof...(Ns);
+    static constexpr int NumParameters = (Ns + ...);
+    using JetType = ceres::Jet<double, NumParameters>;
+
+private:
+    std::unique_ptr<Functor> _functor;
+
+public:
+    explicit SizedAutoDiffCostFunction(Functor *functor, int numResiduals = kNumResiduals)
+        : _functor(functor) {
+        if constexpr (kNumResiduals == ceres::DYNAMIC) {
+            this->set_num_residuals(numResiduals);
+        }
+    }
+
+    bool Evaluate(double const *const *parameters,
+                  double *residuals,
+                  double **jacobians) const override {
+        if (jacobians == nullptr) {
+            return (*_functor)(parameters, residuals);
+        }
+
+        constexpr std::array<int, NumParameterBlocks> blockSizes = {Ns...};
+
+        // seed the jets, the derivative part of each parameter is a unit vector
+        std::array<JetType, NumParameters> paramJets;
+        std::array<const JetType *, NumParameterBlocks> paramJetPtrs;
+        for (int i = 0, jetIdx = 0; i < NumParameterBlocks; ++i) {
+            paramJetPtrs[i] = paramJets.data() + jetIdx;
+            for (int j = 0; j < blockSizes[i]; ++j, ++jetIdx) {
+                paramJets[jetIdx] = JetType(parameters[i][j], jetIdx);
+            }
+        }
+
+        const int numResiduals = this->num_residuals();
+        std::conditional_t<kNumResiduals == ceres::DYNAMIC, std::vector<JetType>,
+                           std::array<JetType, std::max(kNumResiduals, 1)>>
+            residualJets;
+        if constexpr (kNumResiduals == ceres::DYNAMIC) {
+            residualJets.resize(numResiduals);
+        }
+        if (!(*_functor)(paramJetPtrs.data(), residualJets.data())) {
+            return false;
+        }
+
+        // jacobians are stored in row-major order: [ numResiduals x blockSize ]
+        for (int r = 0; r < numResiduals; ++r) {
+            residuals[r] = residualJets[r].a;
+        }
+        for (int i = 0, jetIdx = 0; i < NumParameterBlocks; jetIdx += blockSizes[i], ++i) {
+            if (jacobians[i] == nullptr) {
+                continue;
+            }
+            for (int r = 0; r < numResiduals; ++r) {
+                for (int j = 0; j < blockSizes[i]; ++j) {
+                    jacobians[i][r * blockSizes[i] + j] = residualJets[r].v[jetIdx + j];
+                }
+            }
+        }
+        return true;
+    }
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_SIZED_AUTODIFF_COST_FUNCTION_HPP
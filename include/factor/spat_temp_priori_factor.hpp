@@ -0,0 +1,126 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifndef IKALIBR_SPAT_TEMP_PRIORI_FACTOR_HPP
+#define IKALIBR_SPAT_TEMP_PRIORI_FACTOR_HPP
+
+#include "factor/prior_extri_pos_factor.hpp"
+#include "factor/prior_extri_so3_factor.hpp"
+#include "factor/prior_time_offset_factor.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * all spatiotemporal priors of sensor pairs stacked in a single factor, where each term is
+ * evaluated by its pairwise prior factor on the shared (deduplicated) parameter blocks, so that
+ * large rigs with many priors do not add many tiny residual blocks to the problem
+ */
+struct SpatTempPrioriFactor {
+private:
+    // the pairwise factors and the indices of their parameter blocks in the stacked ones
+    Eigen::aligned_vector<std::pair<PriorExtriSO3Factor, std::array<int, 2>>> _so3Terms;
+    Eigen::aligned_vector<std::pair<PriorExtriPOSFactor, std::array<int, 3>>> _posTerms;
+    std::vector<std::pair<PriorTimeOffsetFactor, std::array<int, 2>>> _toTerms;
+
+public:
+    SpatTempPrioriFactor() = default;
+
+    static auto Create(const SpatTempPrioriFactor &factor) {
+        return new ceres::DynamicAutoDiffCostFunction<SpatTempPrioriFactor>(
+            new SpatTempPrioriFactor(factor));
+    }
+
+    static std::size_t TypeHashCode() { return typeid(SpatTempPrioriFactor).hash_code(); }
+
+    // param blocks: [ SO3_Sen1ToRef | SO3_Sen2ToRef ]
+    void AddExtriSO3(const Sophus::SO3d &Sen1ToSen2, double weight, int sen1Idx, int sen2Idx) {
+        _so3Terms.emplace_back(PriorExtriSO3Factor(Sen1ToSen2, weight),
+                               std::array<int, 2>{sen1Idx, sen2Idx});
+    }
+
+    // param blocks: [ POS_Sen1InRef | SO3_Sen2ToRef | POS_Sen2InRef ]
+    void AddExtriPOS(const Eigen::Vector3d &Sen1InSen2,
+                     double weight,
+                     int pos1Idx,
+                     int rot2Idx,
+                     int pos2Idx) {
+        _posTerms.emplace_back(PriorExtriPOSFactor(Sen1InSen2, weight),
+                               std::array<int, 3>{pos1Idx, rot2Idx, pos2Idx});
+    }
+
+    // param blocks: [ TO_Sen1ToRef | TO_Sen2ToRef ]
+    void AddTimeOffset(double Sen1ToSen2, double weight, int sen1Idx, int sen2Idx) {
+        _toTerms.emplace_back(PriorTimeOffsetFactor(Sen1ToSen2, weight),
+                              std::array<int, 2>{sen1Idx, sen2Idx});
+    }
+
+    [[nodiscard]] int NumResiduals() const {
+        return static_cast<int>(3 * _so3Terms.size() + 3 * _posTerms.size() + _toTerms.size());
+    }
+
+public:
+    /**
+     * param blocks:
+     * [ PAR | PAR | ... | PAR ]
+     * residuals are stacked as [ so3 terms | pos terms | time offset terms ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        int offset = 0;
+        for (const auto &[factor, idx] : _so3Terms) {
+            T const *const knots[2] = {sKnots[idx[0]], sKnots[idx[1]]};
+            factor(knots, sResiduals + offset);
+            offset += 3;
+        }
+        for (const auto &[factor, idx] : _posTerms) {
+            T const *const knots[3] = {sKnots[idx[0]], sKnots[idx[1]], sKnots[idx[2]]};
+            factor(knots, sResiduals + offset);
+            offset += 3;
+        }
+        for (const auto &[factor, idx] : _toTerms) {
+            T const *const knots[2] = {sKnots[idx[0]], sKnots[idx[1]]};
+            factor(knots, sResiduals + offset);
+            offset += 1;
+        }
+        return true;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_SPAT_TEMP_PRIORI_FACTOR_HPP
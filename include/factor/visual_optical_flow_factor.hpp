@@ -39,6 +39,7 @@
 #include "ctraj/spline/spline_segment.h"
 #include "ctraj/spline/ceres_spline_helper_jet.h"
 #include "ceres/dynamic_autodiff_cost_function.h"
+#include "factor/sized_autodiff_cost_function.hpp"
 #include "util/utils.h"
 #include "config/configor.h"
 #include "factor/data_correspondence.h"
@@ -79,6 +80,22 @@ public:
             new VisualOpticalFlowFactor(so3Meta, scaleMeta, corr, weight));
     }
 
+    /**
+     * the fixed-size cost function, which is used when only 'Order' knots of each spline are
+     * involved, i.e., the mid feature is in a single spline segment:
+     * [ SO3 x 4 | LIN_SCALE x 4 | SO3_CmToBr | POS_CmInBr | TO_CmToBr | READOUT_TIME | FX | FY |
+     *   CX | CY | DEPTH_INFO ]
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                            const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                            const OpticalFlowCorr::Ptr &corr,
+                            double weight) {
+        static_assert(Order == 4, "the fixed-size optical flow factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<VisualOpticalFlowFactor, 2, 4, 4, 4, 4, 3, 3, 3, 3, 4,
+                                             3, 1, 1, 1, 1, 1, 1, 1>(
+            new VisualOpticalFlowFactor(so3Meta, scaleMeta, corr, weight));
+    }
+
     static std::size_t TypeHashCode() { return typeid(VisualOpticalFlowFactor).hash_code(); }
 
 public:
@@ -392,6 +409,291 @@ extern template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrde
 extern template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 2, false, false>;
 extern template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 1, false, false>;
 extern template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 0, false, false>;
+
+/**
+ * the fused 'VisualOpticalFlowFactor' and 'VisualOpticalFlowReProjFactor' of an optical flow
+ * correspondence. Both residuals are computed from one evaluation, where the spline at the middle
+ * time is shared by them. As robust losses are applied to residual blocks in ceres, the two
+ * residual groups are robustified here, thus the cost equals to the one of the two factors.
+ * If 'trifocalWeight' is positive, the residuals of 'PPPTrifocalTensorFactor' are appended, which
+ * reuse the relative poses of the reprojection (no additional spline evaluation is performed)
+ */
+template <int Order, bool IsInvDepth, bool TruePosFalseVel>
+struct VisualOpticalFlowFusedFactor {
+private:
+    using ReProjFactor = VisualOpticalFlowReProjFactor<Order, 0, IsInvDepth, TruePosFalseVel>;
+    // the derivative of the linear scale spline to obtain the linear velocity
+    static constexpr int LIN_VEL_DERIV = TruePosFalseVel ? 1 : 0;
+
+    ns_ctraj::SplineMeta<Order> _so3Meta, _scaleMeta;
+    OpticalFlowCorr::Ptr _corr;
+
+    double _so3DtInv, _scaleDtInv;
+    double _flowWeight, _reprojWeight, _trifocalWeight;
+    double _flowLoss, _reprojLoss;
+
+public:
+    explicit VisualOpticalFlowFusedFactor(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                                          const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                                          OpticalFlowCorr::Ptr corr,
+                                          double flowWeight,
+                                          double reprojWeight,
+                                          double trifocalWeight = 0.0)
+        : _so3Meta(so3Meta),
+          _scaleMeta(scaleMeta),
+          _corr(std::move(corr)),
+          _so3DtInv(1.0 / _so3Meta.segments.front().dt),
+          _scaleDtInv(1.0 / _scaleMeta.segments.front().dt),
+          _flowWeight(flowWeight),
+          _reprojWeight(reprojWeight),
+          _trifocalWeight(trifocalWeight),
+          _flowLoss(Configor::Prior::LossForOpticalFlowFactor * flowWeight),
+          _reprojLoss(Configor::Prior::LossForReprojFactor * reprojWeight) {}
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                       const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                       const OpticalFlowCorr::Ptr &corr,
+                       double flowWeight,
+                       double reprojWeight,
+                       double trifocalWeight = 0.0) {
+        return new ceres::DynamicAutoDiffCostFunction<VisualOpticalFlowFusedFactor>(
+            new VisualOpticalFlowFusedFactor(so3Meta, scaleMeta, corr, flowWeight, reprojWeight,
+                                             trifocalWeight));
+    }
+
+    /**
+     * the fixed-size cost function, which is used when only 'Order' knots of each spline are
+     * involved, i.e., the three features are in a single spline segment:
+     * [ SO3 x 4 | LIN_SCALE x 4 | SO3_CmToBr | POS_CmInBr | TO_CmToBr | READOUT_TIME | FX | FY |
+     *   CX | CY | DEPTH_INFO ]
+     */
+    static ceres::CostFunction *CreateSized(const ns_ctraj::SplineMeta<Order> &so3Meta,
+                                            const ns_ctraj::SplineMeta<Order> &scaleMeta,
+                                            const OpticalFlowCorr::Ptr &corr,
+                                            double flowWeight,
+                                            double reprojWeight,
+                                            double trifocalWeight = 0.0) {
+        static_assert(Order == 4, "the fixed-size optical flow factor only supports 'Order == 4'");
+        auto factor = new VisualOpticalFlowFusedFactor(so3Meta, scaleMeta, corr, flowWeight,
+                                                       reprojWeight, trifocalWeight);
+        if (trifocalWeight > 0.0) {
+            return new SizedAutoDiffCostFunction<VisualOpticalFlowFusedFactor, 10, 4, 4, 4, 4, 3,
+                                                 3, 3, 3, 4, 3, 1, 1, 1, 1, 1, 1, 1>(factor);
+        } else {
+            return new SizedAutoDiffCostFunction<VisualOpticalFlowFusedFactor, 6, 4, 4, 4, 4, 3, 3,
+                                                 3, 3, 4, 3, 1, 1, 1, 1, 1, 1, 1>(factor);
+        }
+    }
+
+    static int NumResiduals(double trifocalWeight) { return trifocalWeight > 0.0 ? 10 : 6; }
+
+    static std::size_t TypeHashCode() { return typeid(VisualOpticalFlowFusedFactor).hash_code(); }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
+     * READOUT_TIME | FX | FY | CX | CY | DEPTH_INFO ]
+     * residuals:
+     * [ OPTICAL_FLOW (2) | REPROJ_FIR (2) | REPROJ_LAST (2) | TRIFOCAL (4, optional) ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        std::size_t SO3_CmToBr_OFFSET = _so3Meta.NumParameters() + _scaleMeta.NumParameters();
+        std::size_t POS_CmInBr_OFFSET = SO3_CmToBr_OFFSET + 1;
+        std::size_t TO_CmToBr_OFFSET = POS_CmInBr_OFFSET + 1;
+        std::size_t READOUT_TIME_OFFSET = TO_CmToBr_OFFSET + 1;
+        std::size_t FX_OFFSET = READOUT_TIME_OFFSET + 1;
+        std::size_t FY_OFFSET = FX_OFFSET + 1;
+        std::size_t CX_OFFSET = FY_OFFSET + 1;
+        std::size_t CY_OFFSET = CX_OFFSET + 1;
+        std::size_t DEPTH_INFO_OFFSET = CY_OFFSET + 1;
+
+        // get value
+        Eigen::Map<const Sophus::SO3<T>> SO3_CmToBr(sKnots[SO3_CmToBr_OFFSET]);
+        Eigen::Map<const Eigen::Vector3<T>> POS_CmInBr(sKnots[POS_CmInBr_OFFSET]);
+        Sophus::SE3<T> SE3_CmToBr(SO3_CmToBr, POS_CmInBr);
+        Sophus::SO3<T> SO3_BrToCm = SE3_CmToBr.so3().inverse();
+
+        T TO_CmToBr = sKnots[TO_CmToBr_OFFSET][0];
+        T READOUT_TIME = sKnots[READOUT_TIME_OFFSET][0];
+
+        T FX = sKnots[FX_OFFSET][0];
+        T FX_INV = (T)1.0 / FX;
+        T FY = sKnots[FY_OFFSET][0];
+        T FY_INV = (T)1.0 / FY;
+        T CX = sKnots[CX_OFFSET][0];
+        T CY = sKnots[CY_OFFSET][0];
+
+        T DEPTH_INFO = sKnots[DEPTH_INFO_OFFSET][0];
+
+        T timeByBrFir = _corr->timeAry.at(0) + TO_CmToBr + _corr->rdFactorAry.at(0) * READOUT_TIME;
+        T timeByBrMid = _corr->timeAry.at(1) + TO_CmToBr + _corr->rdFactorAry.at(1) * READOUT_TIME;
+        T timeByBrLast = _corr->timeAry.at(2) + TO_CmToBr + _corr->rdFactorAry.at(2) * READOUT_TIME;
+
+        // ------------------------------------------------------------------------
+        // the middle time, the spline is evaluated once for both optical flow and reprojection
+        // ------------------------------------------------------------------------
+        std::pair<std::size_t, T> iuSo3, iuScale;
+        _so3Meta.ComputeSplineIndex(timeByBrMid, iuSo3.first, iuSo3.second);
+        _scaleMeta.ComputeSplineIndex(timeByBrMid, iuScale.first, iuScale.second);
+        std::size_t SO3_OFFSET = iuSo3.first;
+        std::size_t LIN_SCALE_OFFSET = iuScale.first + _so3Meta.NumParameters();
+
+        Sophus::SO3<T> SO3_BrMidToBr0;
+        Eigen::Vector3<T> ANG_VEL_BrToBr0InBr;
+        ns_ctraj::CeresSplineHelperJet<T, Order>::EvaluateLie(
+            sKnots + SO3_OFFSET, iuSo3.second, _so3DtInv, &SO3_BrMidToBr0, &ANG_VEL_BrToBr0InBr);
+
+        // the position (pos spline) or the velocity (vel spline) of the middle time
+        Eigen::Vector3<T> SCALE_BrMidInBr0, LIN_VEL_BrToBr0InBr0;
+        ns_ctraj::CeresSplineHelperJet<T, Order>::template Evaluate<3, 0>(
+            sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, &SCALE_BrMidInBr0);
+        if constexpr (LIN_VEL_DERIV == 0) {
+            LIN_VEL_BrToBr0InBr0 = SCALE_BrMidInBr0;
+        } else {
+            ns_ctraj::CeresSplineHelperJet<T, Order>::template Evaluate<3, LIN_VEL_DERIV>(
+                sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, &LIN_VEL_BrToBr0InBr0);
+        }
+
+        // ------------
+        // optical flow
+        // ------------
+        Eigen::Vector3<T> ANG_VEL_BrToBr0InBr0 = SO3_BrMidToBr0 * ANG_VEL_BrToBr0InBr;
+        Eigen::Vector3<T> ANG_VEL_CmToBr0InCm = SO3_BrToCm * ANG_VEL_BrToBr0InBr;
+
+        Eigen::Vector3<T> LIN_VEL_CmToBr0InBr0 =
+            -Sophus::SO3<T>::hat(SO3_BrMidToBr0 * POS_CmInBr) * ANG_VEL_BrToBr0InBr0 +
+            LIN_VEL_BrToBr0InBr0;
+
+        Eigen::Vector3<T> LIN_VEL_CmToBr0InCm =
+            SO3_BrToCm * SO3_BrMidToBr0.inverse() * LIN_VEL_CmToBr0InBr0;
+
+        Eigen::Matrix<T, 2, 3> subAMat, subBMat;
+        OpticalFlowCorr::SubMats<T>(&FX, &FY, &CX, &CY, _corr->MidPoint().cast<T>(), &subAMat,
+                                    &subBMat);
+
+        Eigen::Vector2<T> pred;
+        if constexpr (IsInvDepth) {
+            // inverse depth
+            pred = DEPTH_INFO * subAMat * LIN_VEL_CmToBr0InCm + subBMat * ANG_VEL_CmToBr0InCm;
+        } else {
+            // depth
+            pred =
+                (1.0 / DEPTH_INFO) * subAMat * LIN_VEL_CmToBr0InCm + subBMat * ANG_VEL_CmToBr0InCm;
+        }
+
+        Eigen::Map<Eigen::Vector2<T>> flowResiduals(sResiduals);
+        flowResiduals = T(_flowWeight) * (pred - _corr->template MidPointVel(READOUT_TIME));
+        RobustResidual(flowResiduals, _flowLoss);
+
+        // ------------
+        // reprojection
+        // ------------
+        Sophus::SE3<T> SE3_BrMidToBrFir, SE3_BrMidToBrLast;
+        Sophus::SO3<T> SO3_BrFirToBr0, SO3_BrLastToBr0;
+        Eigen::Vector3<T> SCALE_BrFirInBr0, SCALE_BrLastInBr0;
+        ReProjFactor::template ComputeSE3BrToBr0ByPosSpline<T>(
+            sKnots, &timeByBrFir, &SO3_BrFirToBr0, &SCALE_BrFirInBr0, _so3Meta, _so3DtInv,
+            _scaleMeta, _scaleDtInv);
+        ReProjFactor::template ComputeSE3BrToBr0ByPosSpline<T>(
+            sKnots, &timeByBrLast, &SO3_BrLastToBr0, &SCALE_BrLastInBr0, _so3Meta, _so3DtInv,
+            _scaleMeta, _scaleDtInv);
+
+        if constexpr (TruePosFalseVel) {
+            Sophus::SE3<T> SE3_BrMidToBr0(SO3_BrMidToBr0, SCALE_BrMidInBr0);
+            SE3_BrMidToBrFir = Sophus::SE3<T>(SO3_BrFirToBr0, SCALE_BrFirInBr0).inverse() *
+                               SE3_BrMidToBr0;
+            SE3_BrMidToBrLast = Sophus::SE3<T>(SO3_BrLastToBr0, SCALE_BrLastInBr0).inverse() *
+                                SE3_BrMidToBr0;
+        } else {
+            // under the assumption of uniform velocity variation
+            Sophus::SO3<T> SO3_Br0ToBrFir = SO3_BrFirToBr0.inverse();
+            SE3_BrMidToBrFir.so3() = SO3_Br0ToBrFir * SO3_BrMidToBr0;
+            SE3_BrMidToBrFir.translation() = SO3_Br0ToBrFir *
+                                             (SCALE_BrMidInBr0 + SCALE_BrFirInBr0) *
+                                             (0.5 * (timeByBrMid - timeByBrFir));
+
+            Sophus::SO3<T> SO3_Br0ToBrLast = SO3_BrLastToBr0.inverse();
+            SE3_BrMidToBrLast.so3() = SO3_Br0ToBrLast * SO3_BrMidToBr0;
+            SE3_BrMidToBrLast.translation() = SO3_Br0ToBrLast *
+                                              (SCALE_BrMidInBr0 + SCALE_BrLastInBr0) *
+                                              (0.5 * (timeByBrMid - timeByBrLast));
+        }
+
+        Sophus::SE3<T> SE3_BrToCm = SE3_CmToBr.inverse();
+        Sophus::SE3<T> SE3_CmMidToCmFir = SE3_BrToCm * SE3_BrMidToBrFir * SE3_CmToBr;
+        Sophus::SE3<T> SE3_CmMidToCmLast = SE3_BrToCm * SE3_BrMidToBrLast * SE3_CmToBr;
+
+        Eigen::Vector3<T> PMid;
+        VisualReProjCorr::TransformImgToCam<T>(&FX_INV, &FY_INV, &CX, &CY,
+                                               _corr->MidPoint().cast<T>(), &PMid);
+        if constexpr (IsInvDepth) {
+            // inverse depth
+            PMid /= DEPTH_INFO;
+        } else {
+            // depth
+            PMid *= DEPTH_INFO;
+        }
+
+        Eigen::Vector3<T> PFir = SE3_CmMidToCmFir * PMid;
+        Eigen::Vector3<T> PLast = SE3_CmMidToCmLast * PMid;
+
+        PFir /= PFir(2);
+        PLast /= PLast(2);
+
+        Eigen::Vector2<T> fFirPred, fLastPred;
+        VisualReProjCorr::TransformCamToImg<T>(&FX, &FY, &CX, &CY, PFir, &fFirPred);
+        VisualReProjCorr::TransformCamToImg<T>(&FX, &FY, &CX, &CY, PLast, &fLastPred);
+
+        Eigen::Map<Eigen::Vector4<T>> reprojResiduals(sResiduals + 2);
+        reprojResiduals.template head<2>() = fFirPred - _corr->FirPoint().cast<T>();
+        reprojResiduals.template tail<2>() = fLastPred - _corr->LastPoint().cast<T>();
+
+        reprojResiduals = T(_reprojWeight) * reprojResiduals;
+        RobustResidual(reprojResiduals, _reprojLoss);
+
+        // --------------
+        // trifocal tensor
+        // --------------
+        if (_trifocalWeight > 0.0) {
+            Eigen::Map<Eigen::Vector4<T>> trifocalResiduals(sResiduals + 6);
+            trifocalResiduals = T(_trifocalWeight) *
+                                _corr->template TrifocalTensorResiduals<T>(
+                                    &FX_INV, &FY_INV, &CX, &CY, SE3_CmMidToCmFir.so3().matrix(),
+                                    SE3_CmMidToCmFir.translation(),
+                                    SE3_CmMidToCmLast.so3().matrix(),
+                                    SE3_CmMidToCmLast.translation());
+        }
+
+        return true;
+    }
+
+protected:
+    /**
+     * the residual vector 'r' is scaled so that its squared norm equals to the huber-robustified
+     * one, i.e., 'rho(|r|^2)' of 'ceres::HuberLoss(lossParam)'
+     */
+    template <class Vector>
+    static void RobustResidual(Vector &r, double lossParam) {
+        using std::sqrt;
+        using Scalar = typename Vector::Scalar;
+        const Scalar sqrNorm = r.squaredNorm();
+        if (sqrNorm <= Scalar(lossParam * lossParam)) {
+            return;
+        }
+        const Scalar norm = sqrt(sqrNorm);
+        r *= sqrt(Scalar(2.0 * lossParam) * norm - Scalar(lossParam * lossParam)) / norm;
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+extern template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, true, true>;
+extern template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, true, false>;
+extern template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, false, true>;
+extern template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, false, false>;
 }  // namespace ns_ikalibr
 
 #endif  // VISUAL_OPTICAL_FLOW_FACTOR_HPP
@@ -37,11 +37,14 @@
 
 #include "ctraj/utils/sophus_utils.hpp"
 #include "ctraj/spline/spline_segment.h"
+#include "ctraj/spline/ceres_spline_helper.h"
 #include "ctraj/spline/ceres_spline_helper_jet.h"
 #include "ceres/dynamic_autodiff_cost_function.h"
+#include "factor/sized_autodiff_cost_function.hpp"
 #include "util/utils.h"
 #include "config/configor.h"
 #include "factor/data_correspondence.h"
+#include "array"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -78,6 +81,22 @@ public:
             new VisualReProjFactor(rotMeta, linScaleMeta, visualCorr, weight));
     }
 
+    /**
+     * the fixed-size cost function, which is used when only 'Order' knots of each spline are
+     * involved, i.e., the two features are in a single spline segment:
+     * [ SO3 x 4 | LIN_SCALE x 4 | SO3_CmToBr | POS_CmInBr | TO_CmToBr | READOUT_TIME | FX | FY |
+     *   CX | CY | GLOBAL_SCALE | INV_DEPTH ]
+     */
+    static auto CreateSized(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                            const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                            const VisualReProjCorr::Ptr &visualCorr,
+                            double weight) {
+        static_assert(Order == 4, "the fixed-size reprojection factor only supports 'Order == 4'");
+        return new SizedAutoDiffCostFunction<VisualReProjFactor, 2, 4, 4, 4, 4, 3, 3, 3, 3, 4, 3, 1,
+                                             1, 1, 1, 1, 1, 1, 1>(
+            new VisualReProjFactor(rotMeta, linScaleMeta, visualCorr, weight));
+    }
+
     static std::size_t TypeHashCode() { return typeid(VisualReProjFactor).hash_code(); }
 
     template <class T>
@@ -173,10 +192,238 @@ public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 };
 
+/**
+ * reprojections of a landmark from its first observation to the following ones, organized as one
+ * residual block. The pose at the first observation, the back-projected landmark, and the unpacked
+ * extrinsics and intrinsics are evaluated once and shared by all reprojections
+ */
+template <int Order, int TimeDeriv, bool OptTemporal = true>
+struct VisualReProjSeqFactor {
+private:
+    ns_ctraj::SplineMeta<Order> _so3Meta, _scaleMeta;
+
+    // the first observation, shared by all reprojections
+    double _ti;
+    Eigen::Vector2d _fi;
+    double _li;
+    // the following observations
+    std::vector<double> _tjs;
+    std::vector<Eigen::Vector2d> _fjs;
+    std::vector<double> _ljs;
+    std::vector<double> _weights;
+    // spline indices of the first and the following observations (so3 and scale splines), which
+    // are only computed if the time offset and the readout time are both fixed
+    std::array<std::pair<std::size_t, double>, 2> _iuI;
+    std::vector<std::array<std::pair<std::size_t, double>, 2>> _iuJs;
+
+    double _so3DtInv, _scaleDtInv;
+    // the parameter of the cauchy loss applied to each reprojection
+    double _lossParam;
+
+public:
+    /**
+     * if 'OptTemporal' is false, the (constant) time offset and readout time are only involved in
+     * the construction, where spline indices are computed once, thus splines are evaluated at
+     * plain times rather than jets in iterations
+     */
+    explicit VisualReProjSeqFactor(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                                   const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                                   const std::vector<VisualReProjCorr::Ptr> &visualCorrs,
+                                   const std::vector<double> &weights,
+                                   double lossParam,
+                                   double timeOffset,
+                                   double readout)
+        : _so3Meta(rotMeta),
+          _scaleMeta(linScaleMeta),
+          _ti(visualCorrs.front()->ti),
+          _fi(visualCorrs.front()->fi),
+          _li(visualCorrs.front()->li),
+          _weights(weights),
+          _so3DtInv(1.0 / rotMeta.segments.front().dt),
+          _scaleDtInv(1.0 / linScaleMeta.segments.front().dt),
+          _lossParam(lossParam) {
+        _tjs.reserve(visualCorrs.size());
+        _fjs.reserve(visualCorrs.size());
+        _ljs.reserve(visualCorrs.size());
+        for (const auto &corr : visualCorrs) {
+            _tjs.push_back(corr->tj);
+            _fjs.push_back(corr->fj);
+            _ljs.push_back(corr->lj);
+        }
+        if constexpr (!OptTemporal) {
+            auto SplineIndex = [this](double timeByBr) {
+                std::array<std::pair<std::size_t, double>, 2> iu;
+                _so3Meta.ComputeSplineIndex(timeByBr, iu[0].first, iu[0].second);
+                _scaleMeta.ComputeSplineIndex(timeByBr, iu[1].first, iu[1].second);
+                return iu;
+            };
+            _iuI = SplineIndex(_ti + timeOffset + _li * readout);
+            _iuJs.reserve(_tjs.size());
+            for (std::size_t i = 0; i < _tjs.size(); ++i) {
+                _iuJs.push_back(SplineIndex(_tjs[i] + timeOffset + _ljs[i] * readout));
+            }
+        }
+    }
+
+    static auto Create(const ns_ctraj::SplineMeta<Order> &rotMeta,
+                       const ns_ctraj::SplineMeta<Order> &linScaleMeta,
+                       const std::vector<VisualReProjCorr::Ptr> &visualCorrs,
+                       const std::vector<double> &weights,
+                       double lossParam,
+                       double timeOffset,
+                       double readout) {
+        return new ceres::DynamicAutoDiffCostFunction<VisualReProjSeqFactor>(
+            new VisualReProjSeqFactor(rotMeta, linScaleMeta, visualCorrs, weights, lossParam,
+                                      timeOffset, readout));
+    }
+
+    static std::size_t TypeHashCode() { return typeid(VisualReProjSeqFactor).hash_code(); }
+
+    template <class T>
+    void ComputeSE3BrToBr0(T const *const *sKnots,
+                           T *timeByBr,
+                           Sophus::SO3<T> *SO3_BrToBr0,
+                           Eigen::Vector3<T> *POS_BrInBr0) const {
+        std::pair<std::size_t, T> iuSo3, iuScale;
+        _so3Meta.ComputeSplineIndex(*timeByBr, iuSo3.first, iuSo3.second);
+        _scaleMeta.ComputeSplineIndex(*timeByBr, iuScale.first, iuScale.second);
+
+        std::size_t SO3_OFFSET = iuSo3.first;
+        std::size_t LIN_SCALE_OFFSET = iuScale.first + _so3Meta.NumParameters();
+
+        ns_ctraj::CeresSplineHelperJet<T, Order>::EvaluateLie(sKnots + SO3_OFFSET, iuSo3.second,
+                                                              _so3DtInv, SO3_BrToBr0);
+
+        ns_ctraj::CeresSplineHelperJet<T, Order>::template Evaluate<3, TimeDeriv>(
+            sKnots + LIN_SCALE_OFFSET, iuScale.second, _scaleDtInv, POS_BrInBr0);
+    }
+
+    // the pose at the time whose spline indices are computed in the construction
+    template <class T>
+    void ComputeSE3BrToBr0(T const *const *sKnots,
+                           const std::array<std::pair<std::size_t, double>, 2> &iu,
+                           Sophus::SO3<T> *SO3_BrToBr0,
+                           Eigen::Vector3<T> *POS_BrInBr0) const {
+        std::size_t SO3_OFFSET = iu[0].first;
+        std::size_t LIN_SCALE_OFFSET = iu[1].first + _so3Meta.NumParameters();
+
+        ns_ctraj::CeresSplineHelper<Order>::EvaluateLie(sKnots + SO3_OFFSET, iu[0].second,
+                                                        _so3DtInv, SO3_BrToBr0);
+
+        ns_ctraj::CeresSplineHelper<Order>::template Evaluate<T, 3, TimeDeriv>(
+            sKnots + LIN_SCALE_OFFSET, iu[1].second, _scaleDtInv, POS_BrInBr0);
+    }
+
+public:
+    /**
+     * param blocks:
+     * [ SO3 | ... | SO3 | LIN_SCALE | ... | LIN_SCALE | SO3_CmToBr | POS_CmInBr | TO_CmToBr |
+     * READOUT_TIME | FX | FY | CX | CY | GLOBAL_SCALE | INV_DEPTH ]
+     */
+    template <class T>
+    bool operator()(T const *const *sKnots, T *sResiduals) const {
+        std::size_t SO3_CmToBr_OFFSET = _so3Meta.NumParameters() + _scaleMeta.NumParameters();
+        std::size_t POS_CmInBr_OFFSET = SO3_CmToBr_OFFSET + 1;
+        std::size_t TO_CmToBr_OFFSET = POS_CmInBr_OFFSET + 1;
+        std::size_t READOUT_TIME_OFFSET = TO_CmToBr_OFFSET + 1;
+        std::size_t FX_OFFSET = READOUT_TIME_OFFSET + 1;
+        std::size_t FY_OFFSET = FX_OFFSET + 1;
+        std::size_t CX_OFFSET = FY_OFFSET + 1;
+        std::size_t CY_OFFSET = CX_OFFSET + 1;
+        std::size_t GLOBAL_SCALE_OFFSET = CY_OFFSET + 1;
+        std::size_t INV_DEPTH_OFFSET = GLOBAL_SCALE_OFFSET + 1;
+
+        // get value
+        Eigen::Map<const Sophus::SO3<T>> SO3_CmToBr(sKnots[SO3_CmToBr_OFFSET]);
+        Eigen::Map<const Eigen::Vector3<T>> POS_CmInBr(sKnots[POS_CmInBr_OFFSET]);
+        Sophus::SE3<T> SE3_CmToBr(SO3_CmToBr, POS_CmInBr);
+
+        T TO_CmToBr = sKnots[TO_CmToBr_OFFSET][0];
+        T READOUT_TIME = sKnots[READOUT_TIME_OFFSET][0];
+
+        T FX = sKnots[FX_OFFSET][0];
+        T FX_INV = (T)1.0 / FX;
+        T FY = sKnots[FY_OFFSET][0];
+        T FY_INV = (T)1.0 / FY;
+        T CX = sKnots[CX_OFFSET][0];
+        T CY = sKnots[CY_OFFSET][0];
+
+        T GLOBAL_SCALE = sKnots[GLOBAL_SCALE_OFFSET][0];
+        T INV_DEPTH = sKnots[INV_DEPTH_OFFSET][0];
+        T DEPTH = (T)1.0 / INV_DEPTH;
+
+        // the pose of the first observation, evaluated once
+        Sophus::SE3<T> SE3_BrToBr0_I;
+        if constexpr (OptTemporal) {
+            T timeIByBr = _ti + TO_CmToBr + _li * READOUT_TIME;
+            ComputeSE3BrToBr0<T>(sKnots, &timeIByBr, &SE3_BrToBr0_I.so3(),
+                                 &SE3_BrToBr0_I.translation());
+        } else {
+            ComputeSE3BrToBr0<T>(sKnots, _iuI, &SE3_BrToBr0_I.so3(),
+                                 &SE3_BrToBr0_I.translation());
+        }
+        // the landmark in the first camera frame, and then in the reference frame
+        Eigen::Vector3<T> PI;
+        VisualReProjCorr::TransformImgToCam<T>(&FX_INV, &FY_INV, &CX, &CY, _fi.cast<T>(), &PI);
+        PI *= DEPTH * GLOBAL_SCALE;
+        Eigen::Vector3<T> PInBr0 = SE3_BrToBr0_I * (SE3_CmToBr * PI);
+
+        Sophus::SE3<T> SE3_BrToCm = SE3_CmToBr.inverse();
+        for (int i = 0; i < static_cast<int>(_tjs.size()); ++i) {
+            Sophus::SE3<T> SE3_BrToBr0_J;
+            if constexpr (OptTemporal) {
+                auto timeJByBr = _tjs[i] + TO_CmToBr + _ljs[i] * READOUT_TIME;
+                ComputeSE3BrToBr0<T>(sKnots, &timeJByBr, &SE3_BrToBr0_J.so3(),
+                                     &SE3_BrToBr0_J.translation());
+            } else {
+                ComputeSE3BrToBr0<T>(sKnots, _iuJs[i], &SE3_BrToBr0_J.so3(),
+                                     &SE3_BrToBr0_J.translation());
+            }
+
+            Eigen::Vector3<T> PJ = SE3_BrToCm * (SE3_BrToBr0_J.inverse() * PInBr0);
+            PJ /= PJ(2);
+            Eigen::Vector2<T> fjPred;
+            VisualReProjCorr::TransformCamToImg<T>(&FX, &FY, &CX, &CY, PJ, &fjPred);
+
+            Eigen::Map<Eigen::Vector2<T>> residuals(sResiduals + 2 * i);
+            residuals = RobustResidual<T>(T(_weights[i]) * (fjPred - _fjs[i].cast<T>()));
+        }
+
+        return true;
+    }
+
+protected:
+    /**
+     * the residual 'r' is mapped to 'r'' so that '|r'|^2' equals to the cauchy-robustified
+     * '|r|^2', thus the cost equals to the one using 'ceres::CauchyLoss' for each reprojection
+     */
+    template <class T>
+    Eigen::Vector2<T> RobustResidual(const Eigen::Vector2<T> &r) const {
+        using std::log;
+        using std::sqrt;
+        const double b = _lossParam * _lossParam;
+        T s = r.squaredNorm();
+        if (s < T(1E-12 * b)) {
+            // rho(s) / s tends to one
+            return r;
+        }
+        return r * sqrt(T(b) * log(T(1.0) + s / T(b)) / s);
+    }
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 
 extern template struct VisualReProjFactor<Configor::Prior::SplineOrder, 2>;
 extern template struct VisualReProjFactor<Configor::Prior::SplineOrder, 1>;
 extern template struct VisualReProjFactor<Configor::Prior::SplineOrder, 0>;
+extern template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 2>;
+extern template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 1>;
+extern template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 0>;
+extern template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 2, false>;
+extern template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 1, false>;
+extern template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 0, false>;
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_VISUAL_REPROJ_FACTOR_HPP
@@ -44,6 +44,10 @@ namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
+namespace ceres {
+class Problem;
+}
+
 namespace ns_ikalibr {
 class IMUIntriCalibSolver {
 public:
@@ -72,6 +76,10 @@ public:
         std::string IMUTopic;
         double gravityNorm{};
         std::string outputPath;
+        // solve on the sufficient statistics (mean and covariance) of static pieces, and whether
+        // refine the solution using all frames afterwards
+        bool sufficientStatistics{};
+        bool refineWithFrames{};
 
     public:
         Configor() = default;
@@ -113,13 +121,29 @@ public:
         void serialize(Archive &ar) {
             ar(cereal::make_nvp("IMUTopic", IMUTopic), CEREAL_NVP(IMUType),
                cereal::make_nvp("GravityNorm", gravityNorm),
-               cereal::make_nvp("OutputPath", outputPath), cereal::make_nvp("ROSBags", items));
+               cereal::make_nvp("OutputPath", outputPath),
+               cereal::make_nvp("SufficientStatistics", sufficientStatistics),
+               cereal::make_nvp("RefineWithFrames", refineWithFrames),
+               cereal::make_nvp("ROSBags", items));
         }
     };
 
+    /**
+     * the residuals of frames in a static piece are affine in measurements, thus the sum of their
+     * squares equals that of the mean (weighted by the count) plus a constant (the trace of the
+     * covariance), i.e., the mean and the count are sufficient for the intrinsic solving
+     */
+    struct PieceStatistics {
+        std::size_t count{};
+        Eigen::Vector3d acceMean, gyroMean;
+        Eigen::Matrix3d acceCov, gyroCov;
+    };
+
 protected:
     Configor configor;
+    // frames are kept only if they are solved on, i.e., not in the (non-refined) statistic mode
     std::vector<std::list<IMUFrame::Ptr>> data;
+    std::vector<std::vector<PieceStatistics>> statistics;
     std::vector<Eigen::Vector3d> gravity;
     IMUIntrinsics intrinsics;
 
@@ -136,6 +160,14 @@ protected:
     void LoadIMUData();
 
     static Eigen::Vector3d AverageAcce(const std::list<IMUFrame::Ptr> &frames);
+
+    static PieceStatistics ComputeStatistics(const std::list<IMUFrame::Ptr> &frames);
+
+    // add the accelerator and gyroscope factors of a frame
+    void AddFrameFactors(ceres::Problem &prob,
+                         const IMUFrame::Ptr &frame,
+                         double weight,
+                         Eigen::Vector3d &grav);
 };
 }  // namespace ns_ikalibr
 
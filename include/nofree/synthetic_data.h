@@ -0,0 +1,319 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_SYNTHETIC_DATA_H
+#define IKALIBR_SYNTHETIC_DATA_H
+
+#include "calib/calib_param_manager.h"
+#include "ctraj/core/spline_bundle.h"
+#include "util/cereal_archive_helper.hpp"
+#include "opencv2/core.hpp"
+#include "rosbag/bag.h"
+#include "random"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+struct SimConfigor {
+public:
+    using Ptr = std::shared_ptr<SimConfigor>;
+
+    // fields shared by all simulated sensors
+    struct SensorInfo {
+        std::string topic;
+        double frequency{};
+        // roll, pitch, and yaw (degrees, z-y-x order) of the rotation from the sensor to the
+        // reference imu
+        Eigen::Vector3d EULER_SenToBr = Eigen::Vector3d::Zero();
+        Eigen::Vector3d POS_SenInBr = Eigen::Vector3d::Zero();
+        // the time offset, i.e., t_Br = t_Sen + TO_SenToBr
+        double TO_SenToBr{};
+
+        [[nodiscard]] Sophus::SO3d SO3_SenToBr() const;
+
+        [[nodiscard]] Sophus::SE3d SE3_SenToBr() const;
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            ar(cereal::make_nvp("Topic", topic), cereal::make_nvp("Frequency", frequency),
+               cereal::make_nvp("EULER_SenToBr", EULER_SenToBr),
+               cereal::make_nvp("POS_SenInBr", POS_SenInBr),
+               cereal::make_nvp("TO_SenToBr", TO_SenToBr));
+        }
+    };
+
+    struct IMUInfo : public SensorInfo {
+        // standard deviations of the white noises
+        double gyroNoise{}, acceNoise{};
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            SensorInfo::serialize(ar);
+            ar(cereal::make_nvp("GyroNoise", gyroNoise), cereal::make_nvp("AcceNoise", acceNoise));
+        }
+    };
+
+    // a spinning lidar whose scans are stored as ouster-like point clouds ('OUSTER_POINTS')
+    struct LiDARInfo : public SensorInfo {
+        int rings{}, columns{};
+        // the vertical field of view (degrees), rings are distributed evenly in it
+        double verticalFov{};
+        double rangeMax{}, rangeNoise{};
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            SensorInfo::serialize(ar);
+            ar(cereal::make_nvp("Rings", rings), cereal::make_nvp("Columns", columns),
+               cereal::make_nvp("VerticalFov", verticalFov), cereal::make_nvp("RangeMax", rangeMax),
+               cereal::make_nvp("RangeNoise", rangeNoise));
+        }
+    };
+
+    // a doppler radar whose scans are stored as point clouds with velocities ('POINTCLOUD2_POSV')
+    struct RadarInfo : public SensorInfo {
+        int targetsPerScan{};
+        // fields of view (degrees) in azimuth and elevation directions
+        double azimuthFov{}, elevationFov{};
+        double rangeMax{}, rangeNoise{}, velocityNoise{};
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            SensorInfo::serialize(ar);
+            ar(cereal::make_nvp("TargetsPerScan", targetsPerScan),
+               cereal::make_nvp("AzimuthFov", azimuthFov),
+               cereal::make_nvp("ElevationFov", elevationFov),
+               cereal::make_nvp("RangeMax", rangeMax), cereal::make_nvp("RangeNoise", rangeNoise),
+               cereal::make_nvp("VelocityNoise", velocityNoise));
+        }
+    };
+
+    // distortion-free pinhole intrinsics
+    struct PinholeInfo {
+        int width{}, height{};
+        double fx{}, fy{}, cx{}, cy{};
+
+        [[nodiscard]] ns_veta::PinholeIntrinsic::Ptr Intrinsics() const;
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            ar(cereal::make_nvp("Width", width), cereal::make_nvp("Height", height),
+               cereal::make_nvp("FX", fx), cereal::make_nvp("FY", fy), cereal::make_nvp("CX", cx),
+               cereal::make_nvp("CY", cy));
+        }
+    };
+
+    // images are stamped at the first exposure, i.e., 'SENSOR_IMAGE_GS' or 'SENSOR_IMAGE_RS_FIRST'
+    struct CameraInfo : public SensorInfo {
+        PinholeInfo intri;
+        // zero for global shutter cameras
+        double readoutTime{};
+        // standard deviation of the intensity noise (in gray levels)
+        double pixelNoise{};
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            SensorInfo::serialize(ar);
+            ar(cereal::make_nvp("Intrinsics", intri), cereal::make_nvp("ReadoutTime", readoutTime),
+               cereal::make_nvp("PixelNoise", pixelNoise));
+        }
+    };
+
+    /**
+     * events are generated from log-intensity changes of images rendered at 'renderFrequency',
+     * and stored as event arrays ('DVS_EVENT') at 'frequency'
+     */
+    struct EventInfo : public SensorInfo {
+        PinholeInfo intri;
+        double renderFrequency{};
+        double contrastThreshold{};
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            SensorInfo::serialize(ar);
+            ar(cereal::make_nvp("Intrinsics", intri),
+               cereal::make_nvp("RenderFrequency", renderFrequency),
+               cereal::make_nvp("ContrastThreshold", contrastThreshold));
+        }
+    };
+
+public:
+    std::string _outputBagPath;
+    // the time (in seconds) in the bag of the start of the simulation
+    double _startTime{};
+    double _duration{};
+    unsigned int _seed{};
+
+    // 'DEMO' (the motion of the data collection demo) or 'RANDOM'
+    std::string _motionType;
+    double _knotDistance{};
+
+    // the size of the room, and the number of boxes placed in it
+    Eigen::Vector3d _roomSize = Eigen::Vector3d::Zero();
+    int _boxCount{};
+    // the side length of texture cells on surfels
+    double _textureCellSize{};
+
+    // the first imu is the reference one, its extrinsics and time offset are ignored
+    std::vector<IMUInfo> _imus;
+    std::vector<LiDARInfo> _lidars;
+    std::vector<RadarInfo> _radars;
+    std::vector<CameraInfo> _cameras;
+    std::vector<EventInfo> _events;
+
+    SimConfigor() = default;
+
+    static Ptr Create();
+
+    // load configure information from file
+    static Ptr LoadConfigure(const std::string &filename, CerealArchiveType::Enum archiveType);
+
+    void PrintMainFields() const;
+
+public:
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(cereal::make_nvp("OutputBagPath", _outputBagPath),
+           cereal::make_nvp("StartTime", _startTime), cereal::make_nvp("Duration", _duration),
+           cereal::make_nvp("Seed", _seed), cereal::make_nvp("MotionType", _motionType),
+           cereal::make_nvp("KnotDistance", _knotDistance),
+           cereal::make_nvp("RoomSize", _roomSize), cereal::make_nvp("BoxCount", _boxCount),
+           cereal::make_nvp("TextureCellSize", _textureCellSize),
+           cereal::make_nvp("IMUs", _imus), cereal::make_nvp("LiDARs", _lidars),
+           cereal::make_nvp("Radars", _radars), cereal::make_nvp("Cameras", _cameras),
+           cereal::make_nvp("EventCameras", _events));
+    }
+};
+
+/**
+ * synthesize sensor streams on a known trajectory (splines of the reference imu) in a procedural
+ * world of textured planar surfels (a room with boxes), with known extrinsics and time offsets,
+ * which are written to a rosbag, as well as the ground truth of calibration parameters
+ */
+class SyntheticDataGenerator {
+public:
+    using Ptr = std::shared_ptr<SyntheticDataGenerator>;
+    using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+
+    // a bounded planar patch, points are 'center + a * uDir + b * vDir', |a| <= halfU, |b| <= halfV
+    struct Surfel {
+        Eigen::Vector3d center, normal, uDir, vDir;
+        double halfU, halfV;
+        std::uint32_t seed;
+    };
+
+private:
+    SimConfigor::Ptr _configor;
+    SplineBundleType::Ptr _splines;
+    std::vector<Surfel> _world;
+    Eigen::Vector3d _gravity;
+
+public:
+    explicit SyntheticDataGenerator(SimConfigor::Ptr configor);
+
+    static Ptr Create(const SimConfigor::Ptr &configor);
+
+    // write all streams to the bag, the ground truth is saved next to it
+    void Process();
+
+    // the ground truth of calibration parameters
+    [[nodiscard]] CalibParamManager::Ptr GroundTruth() const;
+
+protected:
+    void CreateTrajectory();
+
+    void CreateWorld();
+
+    // stamps (by the sensor clock, from zero) whose spans are covered by the splines
+    [[nodiscard]] std::vector<double> SensorStamps(const SimConfigor::SensorInfo &sensor,
+                                                   double frequency,
+                                                   double span) const;
+
+    // the pose from the sensor to the world at the given time (by the reference imu)
+    [[nodiscard]] Sophus::SE3d SensorPose(const SimConfigor::SensorInfo &sensor,
+                                          double timeByBr) const;
+
+    // the linear velocity of the sensor in the world at the given time (by the reference imu)
+    [[nodiscard]] Eigen::Vector3d SensorVelocity(const SimConfigor::SensorInfo &sensor,
+                                                 double timeByBr) const;
+
+    /**
+     * the first intersection of the ray with the world, returns false if nothing is hit within
+     * 'rangeMax', the intensity (in [0, 1]) is obtained from the texture of the hit surfel
+     */
+    bool RayCast(const Eigen::Vector3d &origin,
+                 const Eigen::Vector3d &dir,
+                 double rangeMax,
+                 double *range,
+                 double *intensity) const;
+
+    /**
+     * render the image (CV_64FC1, intensities in [0, 1]), the exposure of row 'r' happens at
+     * 'timeByBr + r / height * readoutTime'
+     */
+    [[nodiscard]] cv::Mat RenderImage(const SimConfigor::SensorInfo &sensor,
+                                      const SimConfigor::PinholeInfo &intri,
+                                      double timeByBr,
+                                      double readoutTime) const;
+
+    void WriteIMU(rosbag::Bag &bag,
+                  const SimConfigor::IMUInfo &imu,
+                  std::default_random_engine &engine) const;
+
+    void WriteLiDAR(rosbag::Bag &bag,
+                    const SimConfigor::LiDARInfo &lidar,
+                    std::default_random_engine &engine) const;
+
+    void WriteRadar(rosbag::Bag &bag,
+                    const SimConfigor::RadarInfo &radar,
+                    std::default_random_engine &engine) const;
+
+    void WriteCamera(rosbag::Bag &bag,
+                     const SimConfigor::CameraInfo &camera,
+                     std::default_random_engine &engine) const;
+
+    void WriteEvent(rosbag::Bag &bag, const SimConfigor::EventInfo &event) const;
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_SYNTHETIC_DATA_H
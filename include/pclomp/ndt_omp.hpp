@@ -56,7 +56,10 @@ public:
     /** \brief Empty destructor */
     virtual ~NormalDistributionsTransform() = default;
 
-    void setNumThreads(int n) { num_threads_ = n; }
+    void setNumThreads(int n) {
+        num_threads_ = n;
+        target_cells_.setNumThreads(n);
+    }
 
     /** \brief Provide a pointer to the input target (e.g., the point cloud that we want to align
      * the input source to).
@@ -64,9 +67,32 @@ public:
      */
     inline void setInputTarget(const PointCloudTargetConstPtr &cloud) {
         pcl::Registration<PointSource, PointTarget>::setInputTarget(cloud);
+        incremental_target_ = false;
         init();
     }
 
+    /** \brief Provide the updated input target, where only voxels touched by the inserted and
+     * removed points are recomputed, rather than the whole voxel structure in \ref setInputTarget.
+     * Only the DIRECT neighborhood search methods are available for such targets.
+     * \param[in] cloud the updated target point cloud, i.e., old target + inserted - removed
+     * \param[in] inserted points inserted into the old target
+     * \param[in] removed points removed from the old target
+     */
+    inline void updateInputTarget(const PointCloudTargetConstPtr &cloud,
+                                  const PointCloudTarget &inserted,
+                                  const PointCloudTarget &removed) {
+        pcl::Registration<PointSource, PointTarget>::setInputTarget(cloud);
+        // the kdtree of target points is not used by the ndt, skip its rebuilding in 'align'
+        target_cloud_updated_ = false;
+        if (!incremental_target_) {
+            // the voxel structure is built from the whole target for the first time
+            incremental_target_ = true;
+            init();
+        } else {
+            target_cells_.updateLeaves(inserted, removed);
+        }
+    }
+
     /** \brief Set/change the voxel grid resolution.
      * \param[in] resolution side length of voxels
      */
@@ -148,6 +174,7 @@ protected:
     using pcl::Registration<PointSource, PointTarget>::input_;
     using pcl::Registration<PointSource, PointTarget>::indices_;
     using pcl::Registration<PointSource, PointTarget>::target_;
+    using pcl::Registration<PointSource, PointTarget>::target_cloud_updated_;
     using pcl::Registration<PointSource, PointTarget>::nr_iterations_;
     using pcl::Registration<PointSource, PointTarget>::max_iterations_;
     using pcl::Registration<PointSource, PointTarget>::previous_transformation_;
@@ -176,6 +203,12 @@ protected:
     /** \brief Initiate covariance voxel structure. */
     void inline init() {
         target_cells_.setLeafSize(resolution_, resolution_, resolution_);
+        if (incremental_target_) {
+            // Initiate voxel structure incrementally from an empty one.
+            target_cells_.clearLeaves();
+            target_cells_.updateLeaves(*target_, PointCloudTarget());
+            return;
+        }
         target_cells_.setInputCloud(target_);
         // Initiate voxel structure.
         target_cells_.filter(true);
@@ -439,6 +472,10 @@ protected:
 
     int num_threads_;
 
+    /** \brief Whether the voxel structure of the target is updated incrementally, see \ref
+     * updateInputTarget. */
+    bool incremental_target_;
+
 public:
     NeighborSearchMethod search_method;
 
@@ -478,7 +515,8 @@ pclomp::NormalDistributionsTransform<PointSource, PointTarget>::NormalDistributi
       h_ang_e3_(),
       h_ang_f1_(),
       h_ang_f2_(),
-      h_ang_f3_() {
+      h_ang_f3_(),
+      incremental_target_(false) {
     reg_name_ = "NormalDistributionsTransform";
 
     double gauss_c1, gauss_c2;
@@ -495,6 +533,7 @@ pclomp::NormalDistributionsTransform<PointSource, PointTarget>::NormalDistributi
 
     search_method = DIRECT7;
     num_threads_ = omp_get_max_threads();
+    target_cells_.setNumThreads(num_threads_);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
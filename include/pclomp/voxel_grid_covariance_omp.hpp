@@ -3,6 +3,7 @@
 
 #include "Eigen/Cholesky"
 #include "Eigen/Dense"
+#include "array"
 #include "map"
 #include "pcl/common/common.h"
 #include "pcl/filters/boost.h"
@@ -10,6 +11,7 @@
 #include "pcl/kdtree/kdtree_flann.h"
 #include "pcl/point_types.h"
 #include "pclomp/voxel_grid_covariance_omp.hpp"
+#include "set"
 #include "unordered_map"
 
 namespace pclomp {
@@ -134,6 +136,16 @@ public:
 
     typedef std::map<size_t, Leaf> Map;
 
+    /** \brief Point sums of a voxel (indexed by its absolute grid coordinates), from which the leaf
+     * is recomputed in incremental updates. */
+    struct LeafAccumulator {
+        int nr_points = 0;
+        Eigen::Vector3d pt_sum = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d pt_sq_sum = Eigen::Matrix3d::Zero();
+    };
+
+    typedef std::map<std::array<int, 3>, LeafAccumulator> AccumulatorMap;
+
 public:
     /** \brief Constructor.
      * Sets \ref leaf_size_ to 0 and \ref searchable_ to false.
@@ -142,6 +154,7 @@ public:
         : searchable_(true),
           min_points_per_voxel_(6),
           min_covar_eigvalue_mult_(0.01),
+          num_threads_(1),
           leaves_(),
           voxel_centroids_(),
           voxel_centroids_leaf_indices_(),
@@ -190,6 +203,12 @@ public:
      */
     inline double getCovEigValueInflationRatio() { return min_covar_eigvalue_mult_; }
 
+    /** \brief Set the number of threads used to accumulate points into voxels and to compute the
+     * voxel distributions (1 by default, i.e., single-threaded).
+     * \param[in] n the number of threads
+     */
+    inline void setNumThreads(int n) { num_threads_ = std::max(n, 1); }
+
     /** \brief Filter cloud and initializes voxel structure.
      * \param[out] output cloud containing centroids of voxels containing a sufficient number of
      * points
@@ -221,6 +240,25 @@ public:
         }
     }
 
+    /** \brief Incrementally update the voxel structure by inserting and removing points, where
+     * only voxels touched by these points are recomputed (the other leaves are kept, and re-indexed
+     * if the bounding box of voxels changes). Leaves built by \ref filter are discarded in the
+     * first update. The kdtree of centroids is not maintained, thus only the DIRECT neighborhood
+     * search methods are available for the updated structure.
+     * \param[in] inserted points to be inserted into the voxel structure
+     * \param[in] removed points (inserted before) to be removed from the voxel structure
+     */
+    void updateLeaves(const PointCloud &inserted, const PointCloud &removed);
+
+    /** \brief Clear the voxel structure and the point sums maintained by \ref updateLeaves. */
+    inline void clearLeaves() {
+        leaves_.clear();
+        leaf_accumulators_.clear();
+        voxel_centroids_leaf_indices_.clear();
+        voxel_centroids_ = PointCloudPtr(new PointCloud);
+        searchable_ = false;
+    }
+
     /** \brief Get the voxel containing point p.
      * \param[in] index the index of the leaf structure node
      * \return const pointer to leaf structure
@@ -464,6 +502,13 @@ protected:
      */
     void applyFilter(PointCloud &output);
 
+    /** \brief Compute the covariance (and its inverse, eigen vectors and values) of a leaf, whose
+     * \ref Leaf::mean_ is normalized and \ref Leaf::cov_ holds the sum of x*xT.
+     * \param[in,out] leaf the leaf whose \ref Leaf::nr_points is set to -1 if it is degenerated
+     * \param[in] pt_sum the sum of points in the leaf
+     */
+    void computeLeafDistribution(Leaf &leaf, const Eigen::Vector3d &pt_sum) const;
+
     /** \brief Flag to determine if voxel structure is searchable. */
     bool searchable_;
 
@@ -474,6 +519,9 @@ protected:
      */
     double min_covar_eigvalue_mult_;
 
+    /** \brief Number of threads used in \ref applyFilter and \ref updateLeaves. */
+    int num_threads_;
+
     /** \brief Voxel structure containing all leaf nodes (includes voxels with less than a
      * sufficient number of points). */
     Map leaves_;
@@ -488,12 +536,16 @@ protected:
 
     /** \brief KdTree generated using \ref voxel_centroids_ (used for searching). */
     pcl::KdTreeFLANN<PointT> kdtree_;
+
+    /** \brief Point sums of voxels updated by \ref updateLeaves. */
+    AccumulatorMap leaf_accumulators_;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////
 template <typename PointT>
 void pclomp::VoxelGridCovariance<PointT>::applyFilter(PointCloud &output) {
     voxel_centroids_leaf_indices_.clear();
+    leaf_accumulators_.clear();
 
     // Has the input dataset been set already?
     if (!input_) {
@@ -646,6 +698,54 @@ void pclomp::VoxelGridCovariance<PointT>::applyFilter(PointCloud &output) {
             leaf.pointList_.push_back(input_->points[cp]);
         }
     }
+    // No distance filtering, process all data in parallel if only xyz fields are required
+    else if (!downsample_all_data_ && num_threads_ > 1) {
+        const int size = static_cast<int>(input_->points.size());
+        // the leaf index of each point, -1 for invalid points
+        std::vector<int> indices(size, -1);
+#pragma omp parallel for num_threads(num_threads_) schedule(static)
+        for (int cp = 0; cp < size; ++cp) {
+            const PointT &p = input_->points[cp];
+            if (!input_->is_dense)
+                if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+
+            int ijk0 = static_cast<int>(floor(p.x * inverse_leaf_size_[0]) -
+                                        static_cast<float>(min_b_[0]));
+            int ijk1 = static_cast<int>(floor(p.y * inverse_leaf_size_[1]) -
+                                        static_cast<float>(min_b_[1]));
+            int ijk2 = static_cast<int>(floor(p.z * inverse_leaf_size_[2]) -
+                                        static_cast<float>(min_b_[2]));
+            indices[cp] = ijk0 * divb_mul_[0] + ijk1 * divb_mul_[1] + ijk2 * divb_mul_[2];
+        }
+
+        // First pass: leaves are partitioned by their indices, each thread accumulates points of
+        // its own partition in the input order, thus leaves are the same as the serial ones
+        std::vector<Map> partitions(num_threads_);
+#pragma omp parallel for num_threads(num_threads_) schedule(static, 1)
+        for (int t = 0; t < num_threads_; ++t) {
+            Map &partition = partitions[t];
+            for (int cp = 0; cp < size; ++cp) {
+                const int idx = indices[cp];
+                if (idx < 0 || idx % num_threads_ != t) continue;
+
+                const PointT &p = input_->points[cp];
+                Leaf &leaf = partition[idx];
+                if (leaf.nr_points == 0) {
+                    leaf.centroid.resize(centroid_size);
+                    leaf.centroid.setZero();
+                }
+                Eigen::Vector3d pt3d(p.x, p.y, p.z);
+                leaf.mean_ += pt3d;
+                leaf.cov_ += pt3d * pt3d.transpose();
+                leaf.centroid.template head<4>() += Eigen::Vector4f(p.x, p.y, p.z, 0);
+                ++leaf.nr_points;
+
+                leaf.pointList_.push_back(p);
+            }
+        }
+        // partitions are disjoint, nodes are spliced without copying
+        for (auto &partition : partitions) leaves_.merge(partition);
+    }
     // No distance filtering, process all data
     else {
         // First pass: go over all points and insert them into the right leaf
@@ -714,14 +814,10 @@ void pclomp::VoxelGridCovariance<PointT>::applyFilter(PointCloud &output) {
     int cp = 0;
     if (save_leaf_layout_) leaf_layout_.resize(div_b_[0] * div_b_[1] * div_b_[2], -1);
 
-    // Eigen values and vectors calculated to prevent near singluar matrices
-    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
-    Eigen::Matrix3d eigen_val;
     Eigen::Vector3d pt_sum;
-
-    // Eigen values less than a threshold of max eigen value are inflated to a set fraction of the
-    // max eigen value.
-    double min_covar_eigvalue;
+    // leaves with sufficient points and their point sums, whose distributions are computed later
+    std::vector<std::pair<Leaf *, Eigen::Vector3d>> distributions;
+    distributions.reserve(leaves_.size());
 
     for (auto it = leaves_.begin(); it != leaves_.end(); ++it) {
         // Normalize the centroid
@@ -766,44 +862,198 @@ void pclomp::VoxelGridCovariance<PointT>::applyFilter(PointCloud &output) {
             // Stores the voxel indice for fast access searching
             if (searchable_) voxel_centroids_leaf_indices_.push_back(static_cast<int>(it->first));
 
-            // Single pass covariance calculation
-            leaf.cov_ = (leaf.cov_ - 2 * (pt_sum * leaf.mean_.transpose())) / leaf.nr_points +
-                        leaf.mean_ * leaf.mean_.transpose();
-            leaf.cov_ *= (leaf.nr_points - 1.0) / leaf.nr_points;
+            distributions.emplace_back(&leaf, pt_sum);
+        }
+    }
 
-            // Normalize Eigen Val such that max no more than 100x min.
-            eigensolver.compute(leaf.cov_);
-            eigen_val = eigensolver.eigenvalues().asDiagonal();
-            leaf.evecs_ = eigensolver.eigenvectors();
+    // Single pass covariance calculation, leaves are independent of each other
+#pragma omp parallel for num_threads(num_threads_) schedule(guided, 64)
+    for (int i = 0; i < static_cast<int>(distributions.size()); ++i) {
+        computeLeafDistribution(*distributions[i].first, distributions[i].second);
+    }
 
-            if (eigen_val(0, 0) < 0 || eigen_val(1, 1) < 0 || eigen_val(2, 2) <= 0) {
-                leaf.nr_points = -1;
-                continue;
-            }
+    output.width = static_cast<uint32_t>(output.points.size());
+}
 
-            // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+void pclomp::VoxelGridCovariance<PointT>::computeLeafDistribution(
+    Leaf &leaf, const Eigen::Vector3d &pt_sum) const {
+    // Single pass covariance calculation
+    leaf.cov_ = (leaf.cov_ - 2 * (pt_sum * leaf.mean_.transpose())) / leaf.nr_points +
+                leaf.mean_ * leaf.mean_.transpose();
+    leaf.cov_ *= (leaf.nr_points - 1.0) / leaf.nr_points;
+
+    // Normalize Eigen Val such that max no more than 100x min.
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigensolver;
+    eigensolver.compute(leaf.cov_);
+    Eigen::Matrix3d eigen_val = eigensolver.eigenvalues().asDiagonal();
+    leaf.evecs_ = eigensolver.eigenvectors();
 
-            min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val(2, 2);
-            if (eigen_val(0, 0) < min_covar_eigvalue) {
-                eigen_val(0, 0) = min_covar_eigvalue;
+    if (eigen_val(0, 0) < 0 || eigen_val(1, 1) < 0 || eigen_val(2, 2) <= 0) {
+        leaf.nr_points = -1;
+        return;
+    }
 
-                if (eigen_val(1, 1) < min_covar_eigvalue) {
-                    eigen_val(1, 1) = min_covar_eigvalue;
-                }
+    // Avoids matrices near singularities (eq 6.11)[Magnusson 2009]
+
+    // Eigen values less than a threshold of max eigen value are inflated to a set fraction of the
+    // max eigen value.
+    double min_covar_eigvalue = min_covar_eigvalue_mult_ * eigen_val(2, 2);
+    if (eigen_val(0, 0) < min_covar_eigvalue) {
+        eigen_val(0, 0) = min_covar_eigvalue;
+
+        if (eigen_val(1, 1) < min_covar_eigvalue) {
+            eigen_val(1, 1) = min_covar_eigvalue;
+        }
+
+        leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse();
+    }
+    leaf.evals_ = eigen_val.diagonal();
+
+    leaf.icov_ = leaf.cov_.inverse();
+    if (leaf.icov_.maxCoeff() == std::numeric_limits<float>::infinity() ||
+        leaf.icov_.minCoeff() == -std::numeric_limits<float>::infinity()) {
+        leaf.nr_points = -1;
+    }
+}
 
-                leaf.cov_ = leaf.evecs_ * eigen_val * leaf.evecs_.inverse();
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename PointT>
+void pclomp::VoxelGridCovariance<PointT>::updateLeaves(const PointCloud &inserted,
+                                                       const PointCloud &removed) {
+    if (leaf_accumulators_.empty()) {
+        // leaves built by 'filter' have no point sums, start from an empty structure
+        leaves_.clear();
+    }
+    searchable_ = false;
+    voxel_centroids_leaf_indices_.clear();
+    voxel_centroids_ = PointCloudPtr(new PointCloud);
+
+    // accumulate point sums of voxels touched, voxels are partitioned by their hashes, and each
+    // thread accumulates points of its own partition
+    const int threads = num_threads_;
+    std::vector<AccumulatorMap> partitions(threads);
+#pragma omp parallel for num_threads(threads) schedule(static, 1)
+    for (int t = 0; t < threads; ++t) {
+        auto accumulate = [this, t, threads, &partitions](const PointCloud &cloud, int sign) {
+            for (const auto &p : cloud.points) {
+                if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) continue;
+
+                std::array<int, 3> ijk = {static_cast<int>(floor(p.x * inverse_leaf_size_[0])),
+                                          static_cast<int>(floor(p.y * inverse_leaf_size_[1])),
+                                          static_cast<int>(floor(p.z * inverse_leaf_size_[2]))};
+                auto hash = static_cast<uint32_t>(ijk[0]) * 73856093u ^
+                            static_cast<uint32_t>(ijk[1]) * 19349663u ^
+                            static_cast<uint32_t>(ijk[2]) * 83492791u;
+                if (static_cast<int>(hash % static_cast<uint32_t>(threads)) != t) continue;
+
+                Eigen::Vector3d pt3d(p.x, p.y, p.z);
+                LeafAccumulator &acc = partitions[t][ijk];
+                acc.nr_points += sign;
+                acc.pt_sum += sign * pt3d;
+                acc.pt_sq_sum += sign * pt3d * pt3d.transpose();
             }
-            leaf.evals_ = eigen_val.diagonal();
+        };
+        accumulate(removed, -1);
+        accumulate(inserted, 1);
+    }
+    std::set<std::array<int, 3>> touched;
+    for (const auto &partition : partitions) {
+        for (const auto &[ijk, sum] : partition) {
+            LeafAccumulator &acc = leaf_accumulators_[ijk];
+            acc.nr_points += sum.nr_points;
+            acc.pt_sum += sum.pt_sum;
+            acc.pt_sq_sum += sum.pt_sq_sum;
+            touched.insert(ijk);
+        }
+    }
 
-            leaf.icov_ = leaf.cov_.inverse();
-            if (leaf.icov_.maxCoeff() == std::numeric_limits<float>::infinity() ||
-                leaf.icov_.minCoeff() == -std::numeric_limits<float>::infinity()) {
-                leaf.nr_points = -1;
+    // the index of a leaf, which relies on the bounding box of voxels, see 'applyFilter'
+    auto leafIndex = [](const std::array<int, 3> &ijk, const Eigen::Vector4i &min_b,
+                        const Eigen::Vector4i &divb_mul) {
+        return static_cast<size_t>((ijk[0] - min_b[0]) * divb_mul[0] +
+                                   (ijk[1] - min_b[1]) * divb_mul[1] +
+                                   (ijk[2] - min_b[2]) * divb_mul[2]);
+    };
+
+    // erase voxels whose points are all removed
+    for (const auto &ijk : touched) {
+        auto acc_iter = leaf_accumulators_.find(ijk);
+        if (acc_iter->second.nr_points <= 0) {
+            leaves_.erase(leafIndex(ijk, min_b_, divb_mul_));
+            leaf_accumulators_.erase(acc_iter);
+        }
+    }
+
+    if (leaf_accumulators_.empty()) {
+        leaves_.clear();
+        return;
+    }
+
+    // the bounding box of voxels
+    Eigen::Vector4i min_b(std::numeric_limits<int>::max(), std::numeric_limits<int>::max(),
+                          std::numeric_limits<int>::max(), 0);
+    Eigen::Vector4i max_b(std::numeric_limits<int>::min(), std::numeric_limits<int>::min(),
+                          std::numeric_limits<int>::min(), 0);
+    for (const auto &[ijk, acc] : leaf_accumulators_) {
+        for (int i = 0; i < 3; ++i) {
+            min_b[i] = std::min(min_b[i], ijk[i]);
+            max_b[i] = std::max(max_b[i], ijk[i]);
+        }
+    }
+    Eigen::Vector4i div_b = max_b - min_b + Eigen::Vector4i::Ones();
+    div_b[3] = 0;
+
+    if (static_cast<int64_t>(div_b[0]) * div_b[1] * div_b[2] >
+        std::numeric_limits<int32_t>::max()) {
+        PCL_WARN(
+            "[pcl::%s::updateLeaves] Leaf size is too small for the input dataset. Integer indices "
+            "would overflow.",
+            getClassName().c_str());
+        leaves_.clear();
+        return;
+    }
+
+    // re-index the untouched leaves if the bounding box changes
+    Eigen::Vector4i divb_mul(1, div_b[0], div_b[0] * div_b[1], 0);
+    if (min_b != min_b_ || divb_mul != divb_mul_) {
+        Map leaves;
+        for (const auto &[ijk, acc] : leaf_accumulators_) {
+            if (touched.count(ijk) != 0) continue;
+            auto leaf_iter = leaves_.find(leafIndex(ijk, min_b_, divb_mul_));
+            if (leaf_iter != leaves_.end()) {
+                leaves.emplace(leafIndex(ijk, min_b, divb_mul), std::move(leaf_iter->second));
             }
         }
+        leaves_.swap(leaves);
+        min_b_ = min_b;
+        max_b_ = max_b;
+        div_b_ = div_b;
+        divb_mul_ = divb_mul;
     }
 
-    output.width = static_cast<uint32_t>(output.points.size());
+    // recompute the touched leaves, distributions are computed in parallel afterwards
+    std::vector<std::pair<Leaf *, const LeafAccumulator *>> distributions;
+    for (const auto &ijk : touched) {
+        auto acc_iter = leaf_accumulators_.find(ijk);
+        if (acc_iter == leaf_accumulators_.end()) continue;
+        const LeafAccumulator &acc = acc_iter->second;
+
+        Leaf &leaf = leaves_[leafIndex(ijk, min_b_, divb_mul_)];
+        leaf = Leaf();
+        leaf.nr_points = acc.nr_points;
+        leaf.mean_ = acc.pt_sum / acc.nr_points;
+        leaf.centroid = Eigen::VectorXf::Zero(4);
+        leaf.centroid.template head<3>() = leaf.mean_.template cast<float>();
+        leaf.cov_ = acc.pt_sq_sum;
+
+        if (leaf.nr_points >= min_points_per_voxel_) distributions.emplace_back(&leaf, &acc);
+    }
+#pragma omp parallel for num_threads(num_threads_) schedule(guided, 64)
+    for (int i = 0; i < static_cast<int>(distributions.size()); ++i) {
+        computeLeafDistribution(*distributions[i].first, distributions[i].second->pt_sum);
+    }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -38,6 +38,10 @@
 #include "util/utils.h"
 #include "ctraj/utils/macros.hpp"
 #include "opencv4/opencv2/core.hpp"
+#include "functional"
+#include "mutex"
+#include "list"
+#include "map"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -45,15 +49,48 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
-class CameraFrame {
+class CameraFrame : public std::enable_shared_from_this<CameraFrame> {
 public:
     using Ptr = std::shared_ptr<CameraFrame>;
+    // decode the color (BGR8) image from the payload kept in this decoder
+    using Decoder = std::function<cv::Mat()>;
+
+    // a derived product of a frame, and its position in the LRU cache
+    struct DerivedData {
+        CameraFrame *owner;
+        std::string key;
+        std::shared_ptr<const void> data;
+        std::size_t bytes;
+        bool inCache;
+        std::list<DerivedData *>::iterator cacheIter;
+    };
 
 protected:
     double _timestamp;
     cv::Mat _greyImg, _colorImg;
     ns_veta::IndexT _id;
 
+    /**
+     * for lazy frames, only the (compressed) payload is kept in memory, images are decoded on the
+     * first access, and maintained in a bounded LRU cache shared by all lazy frames
+     */
+    Decoder _decoder;
+    mutable std::mutex _decodeMutex;
+    bool _inDecodedCache;
+    std::size_t _payloadBytes;
+    std::list<CameraFrame *>::iterator _decodedCacheIter;
+    // only the grey image is kept, the color one is derived when it is accessed, using the
+    // decoder of the (compressed) payload if it is kept for non-lazy frames
+    bool _greyOnly;
+    Decoder _colorDecoder;
+
+    /**
+     * derived data of this frame (e.g., image pyramids, key points and descriptors), each product
+     * is computed once, and maintained in a memory-bounded LRU cache shared by all frames
+     */
+    std::map<std::string, DerivedData> _derivedData;
+    mutable std::mutex _derivedMutex;
+
 public:
     // constructor
     explicit CameraFrame(double timestamp = INVALID_TIME_STAMP,
@@ -67,13 +104,78 @@ public:
                                    const cv::Mat &colorImg = cv::Mat(),
                                    ns_veta::IndexT id = ns_veta::UndefinedIndexT);
 
-    cv::Mat &GetImage();
-
-    cv::Mat &GetColorImage();
+    /**
+     * creator of the lazy frame
+     * @param payloadBytes the heap bytes of the payload kept in the decoder, which is only used
+     * for memory accounting
+     * @param greyOnly only the grey image is kept once decoded
+     */
+    static CameraFrame::Ptr CreateLazy(double timestamp,
+                                       Decoder decoder,
+                                       ns_veta::IndexT id = ns_veta::UndefinedIndexT,
+                                       std::size_t payloadBytes = 0,
+                                       bool greyOnly = false);
+
+    /**
+     * creator of the grey-only frame, whose color image is derived from the decoder when it is
+     * accessed, or from the grey image if no decoder is given
+     */
+    static CameraFrame::Ptr CreateGreyOnly(double timestamp,
+                                           const cv::Mat &greyImg,
+                                           Decoder decoder = nullptr,
+                                           ns_veta::IndexT id = ns_veta::UndefinedIndexT,
+                                           std::size_t payloadBytes = 0);
+
+    /**
+     * the returned header shares the image data of this frame, and holds a reference to it, thus
+     * it stays valid even if the frame is evicted or released by other threads. Write into a
+     * clone, as the data is shared
+     */
+    cv::Mat GetImage();
+
+    // see 'GetImage()'
+    cv::Mat GetColorImage();
 
     // release the image mat data to save memory when needed
     virtual void ReleaseMat();
 
+    /**
+     * write images to disk and release them, the frame becomes a lazy one decoding the written
+     * image on demand. Lazy frames are only released. Returns false if the writing fails
+     */
+    bool SpillToDisk(const std::string &filename);
+
+    // whether the images are decoded on demand
+    [[nodiscard]] bool IsLazy() const;
+
+    // whether only the grey image is kept
+    [[nodiscard]] bool IsGreyOnly() const;
+
+    /**
+     * heap bytes held by this frame (see 'MemoryUsage'), including the shared-ptr overhead, the
+     * images in memory, the payload of lazy frames, and the cached derived data of this frame
+     */
+    [[nodiscard]] virtual std::size_t GetMemoryBytes() const;
+
+    /**
+     * obtain the derived data of this frame, which is computed only if it is not cached
+     * @param key the key of this product, which should encode the parameters to compute it
+     * @param compute the function computing the product, returns the product and its bytes
+     */
+    template <typename Type, typename Compute>
+    std::shared_ptr<const Type> GetDerivedData(const std::string &key, const Compute &compute) {
+        if (auto data = FindDerivedData(key); data != nullptr) {
+            return std::static_pointer_cast<const Type>(data);
+        }
+        auto [product, bytes] = compute();
+        auto data = std::make_shared<const Type>(std::move(product));
+        // the product may be computed by other threads in the meantime, the cached one is used
+        return std::static_pointer_cast<const Type>(StoreDerivedData(key, data, bytes));
+    }
+
+    // release all derived data of this frame
+    void ReleaseDerivedData();
+
     [[nodiscard]] double GetTimestamp() const;
 
     void SetTimestamp(double timestamp);
@@ -84,7 +186,25 @@ public:
 
     friend std::ostream &operator<<(std::ostream &os, const CameraFrame &frame);
 
-    virtual ~CameraFrame() = default;
+    virtual ~CameraFrame();
+
+protected:
+    /**
+     * decode the images of the lazy frame if they are not in memory, and touch the LRU cache.
+     * Returns the header of the grey image taken under the lock
+     */
+    cv::Mat DecodeIfLazy();
+
+    // derive the color image if only the grey one (given by 'DecodeIfLazy()') is in memory
+    cv::Mat DeriveColorIfGreyOnly(const cv::Mat &greyImg);
+
+    // find the cached derived data and touch the LRU cache, return nullptr if not cached
+    std::shared_ptr<const void> FindDerivedData(const std::string &key);
+
+    // cache the derived data, products of other frames would be evicted if over the budget
+    std::shared_ptr<const void> StoreDerivedData(const std::string &key,
+                                                 const std::shared_ptr<const void> &data,
+                                                 std::size_t bytes);
 };
 }  // namespace ns_ikalibr
 
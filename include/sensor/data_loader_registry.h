@@ -0,0 +1,165 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_DATA_LOADER_REGISTRY_H
+#define IKALIBR_DATA_LOADER_REGISTRY_H
+
+#include "util/utils.h"
+#include "functional"
+#include "map"
+#include "mutex"
+#include "optional"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the decoding capabilities a data loader publishes, a larger underlying value means a
+ * faster decode path, i.e., zero-copy decoding is preferred, then batch decoding, then simd
+ */
+enum class DecodeCapability : std::uint32_t {
+    NONE = 0,
+    // the decoding of a message is vectorized
+    SIMD_DECODE = 1 << 0,
+    // messages of a scan (e.g., packets) are decoded together, rather than one by one
+    BATCH_DECODE = 1 << 1,
+    // points (targets) are decoded from the message buffer via offsets, without per-item copies
+    ZERO_COPY = 1 << 2,
+};
+
+std::string DecodeCapabilityStr(DecodeCapability capability);
+
+/**
+ * @brief the registry of data loaders of a sensor type (e.g., 'LiDARDataLoader'), keyed by the
+ * sensor model string in the configure file. Built-in loaders are registered statically (see
+ * 'IKALIBR_REGISTER_DATA_LOADER'), and loaders of other models could be registered in the same way
+ * from shared-library plugins (see 'LoadDataLoaderPlugins'). Several decoders could be registered
+ * for a model, the fastest one is picked when a loader is created
+ */
+template <class LoaderType>
+class DataLoaderRegistry {
+public:
+    using LoaderPtr = std::shared_ptr<LoaderType>;
+    using Factory = std::function<LoaderPtr()>;
+
+    struct Entry {
+        // the name of the decoder, for logging
+        std::string decoder;
+        DecodeCapability capability;
+        Factory factory;
+    };
+
+public:
+    // register a decoder of the model, false is returned if the decoder has been registered
+    static bool Register(const std::string &model,
+                         const std::string &decoder,
+                         DecodeCapability capability,
+                         const Factory &factory) {
+        std::lock_guard<std::mutex> lock(Mutex());
+        auto &entries = Entries()[model];
+        for (const auto &entry : entries) {
+            if (entry.decoder == decoder) {
+                return false;
+            }
+        }
+        entries.push_back({decoder, capability, factory});
+        return true;
+    }
+
+    // the fastest decoder of the model, std::nullopt if the model is not registered
+    static std::optional<Entry> Find(const std::string &model) {
+        std::lock_guard<std::mutex> lock(Mutex());
+        auto iter = Entries().find(model);
+        if (iter == Entries().cend() || iter->second.empty()) {
+            return std::nullopt;
+        }
+        const auto &entries = iter->second;
+        auto IsSlower = [](const Entry &a, const Entry &b) {
+            return magic_enum::enum_integer(a.capability) < magic_enum::enum_integer(b.capability);
+        };
+        return *std::max_element(entries.cbegin(), entries.cend(), IsSlower);
+    }
+
+    // create a loader by the fastest decoder of the model, nullptr if the model is not registered
+    static LoaderPtr Create(const std::string &model) {
+        auto entry = Find(model);
+        return entry != std::nullopt ? entry->factory() : nullptr;
+    }
+
+    // registered models, sorted
+    static std::vector<std::string> Models() {
+        std::lock_guard<std::mutex> lock(Mutex());
+        std::vector<std::string> models;
+        for (const auto &[model, entries] : Entries()) {
+            models.push_back(model);
+        }
+        return models;
+    }
+
+protected:
+    static std::map<std::string, std::vector<Entry>> &Entries() {
+        static std::map<std::string, std::vector<Entry>> entries;
+        return entries;
+    }
+
+    static std::mutex &Mutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+};
+
+/**
+ * load shared-library plugins of data loaders, whose static registrations are performed once
+ * loaded. Plugins that have been loaded would be skipped, and an exception would be thrown if a
+ * plugin fails to load
+ */
+void LoadDataLoaderPlugins(const std::vector<std::string> &paths);
+
+}  // namespace ns_ikalibr
+
+/**
+ * statically register a decoder of the model for the loader type, the factory (the last argument,
+ * a callable returning the loader pointer) is invoked each time a loader is created
+ */
+#define IKALIBR_REGISTER_DATA_LOADER(LoaderType, model, decoder, capability, ...)                \
+    namespace {                                                                                  \
+    const bool IKALIBR_UNIQUE_NAME(_LOADER_REGISTERED_) =                                        \
+        ns_ikalibr::DataLoaderRegistry<LoaderType>::Register(model, decoder, capability,         \
+                                                             __VA_ARGS__);                       \
+    }
+
+#endif  // IKALIBR_DATA_LOADER_REGISTRY_H
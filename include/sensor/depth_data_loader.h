@@ -74,6 +74,22 @@ protected:
     }
 
     static void InverseMat(cv::Mat &floatMat);
+
+    /**
+     * organize the unpacked depth image: raw 16-bit depths are kept as they are (half the memory
+     * of float ones), others are converted to float ones (and inversed if needed). The depth
+     * image is then filtered if 'Configor::Preference::FilterDepthImages' is enabled
+     */
+    void OrganizeMat(cv::Mat &depthMat) const;
+
+    /**
+     * filter the raw depth image in place: invalid depths are cleared, speckles (depths with few
+     * consistent neighbors) are removed, and small holes (surrounded by consistent depths) are
+     * filled by the medians of their neighbors. Consistency is relative, thus the unit of raw
+     * depths does not matter
+     */
+    template <class Type>
+    static void FilterMat(cv::Mat &depthMat);
 };
 
 class DepthSensorImageLoader : public DepthDataLoader {
@@ -90,37 +90,178 @@ public:
 class EventArray {
 public:
     using Ptr = std::shared_ptr<EventArray>;
+    using PosScalar = Event::PosType::Scalar;
+
+    // the resolution (s) of event times in the packed layout
+    constexpr static double TIME_RESOLUTION = 1E-6;
+    // the max offset that can be stored in 31 bits
+    constexpr static long long MAX_OFFSET = 0x7FFFFFFF;
+
+    /**
+     * an event packed in 8 bytes: the time is stored as a microsecond offset (31 bits, about 35
+     * minutes) to the base time of its array, and the polarity takes the lowest bit
+     */
+    struct PackedEvent {
+        std::uint32_t offsetAndPolarity;
+        PosScalar x;
+        PosScalar y;
+
+        [[nodiscard]] std::uint32_t Offset() const { return offsetAndPolarity >> 1; }
+
+        [[nodiscard]] bool Polarity() const { return offsetAndPolarity & 1u; }
+
+        template <class Archive>
+        void serialize(Archive& ar) {
+            ar(CEREAL_NVP(offsetAndPolarity), CEREAL_NVP(x), CEREAL_NVP(y));
+        }
+    };
 
 private:
     double _timestamp;
-    std::vector<Event::Ptr> _events;
+    // the base time of offsets of packed events, which is not later than any event
+    double _timeBase;
+    /**
+     * events are stored in a packed layout, rather than 'std::vector<Event::Ptr>', so that a
+     * single event would not cost a heap allocation and a pointer chase, and large event sequences
+     * fit in caches and memory. Fields of events are decoded on access
+     */
+    std::vector<PackedEvent> _events;
 
 public:
     explicit EventArray(double timestamp = INVALID_TIME_STAMP,
                         const std::vector<Event::Ptr>& events = {});
 
+    EventArray(double timestamp,
+               const std::vector<double>& eventTimes,
+               const std::vector<PosScalar>& eventXs,
+               const std::vector<PosScalar>& eventYs,
+               const std::vector<std::uint8_t>& eventPolarities);
+
+    EventArray(double timestamp, double timeBase, std::vector<PackedEvent> events);
+
     static Ptr Create(double timestamp = INVALID_TIME_STAMP,
                       const std::vector<Event::Ptr>& events = {});
 
-    [[nodiscard]] double GetTimestamp() const;
+    static Ptr Create(double timestamp,
+                      const std::vector<double>& eventTimes,
+                      const std::vector<PosScalar>& eventXs,
+                      const std::vector<PosScalar>& eventYs,
+                      const std::vector<std::uint8_t>& eventPolarities);
 
-    [[nodiscard]] std::vector<Event::Ptr> GetEvents() const;
+    static Ptr Create(double timestamp, double timeBase, std::vector<PackedEvent> events);
+
+    [[nodiscard]] double GetTimestamp() const;
 
     void SetTimestamp(double timestamp);
 
+    // shift the timestamp of this array and the times of all events
+    void ShiftTimestamps(double dt);
+
+    void Reserve(std::size_t size);
+
+    void PushBack(double timestamp, PosScalar x, PosScalar y, bool polarity);
+
+    [[nodiscard]] std::size_t GetEventCount() const;
+
+    [[nodiscard]] bool IsEmpty() const;
+
+    // the packed events, times of which are decoded by 'GetTimeBase' and 'DecodeTime'
+    [[nodiscard]] const std::vector<PackedEvent>& GetPackedEvents() const;
+
+    // heap bytes held by this array (see 'MemoryUsage'), including the shared-ptr overhead
+    [[nodiscard]] std::size_t GetMemoryBytes() const;
+
+    [[nodiscard]] double GetTimeBase() const;
+
+    [[nodiscard]] double DecodeTime(const PackedEvent& event) const {
+        return _timeBase + event.Offset() * TIME_RESOLUTION;
+    }
+
+    // access a single event
+    [[nodiscard]] double GetEventTime(std::size_t idx) const;
+
+    [[nodiscard]] PosScalar GetEventX(std::size_t idx) const;
+
+    [[nodiscard]] PosScalar GetEventY(std::size_t idx) const;
+
+    [[nodiscard]] Event::PosType GetEventPos(std::size_t idx) const;
+
+    [[nodiscard]] bool GetEventPolarity(std::size_t idx) const;
+
+    // the index of the first event whose time is not before 't'
+    [[nodiscard]] std::size_t LowerBound(double t) const;
+
+    // events are created one by one here, which is costly, use views instead in heavy loops
+    [[nodiscard]] std::vector<Event::Ptr> GetEvents() const;
+
     [[nodiscard]] cv::Mat DrawRawEventFrame(const ns_veta::PinholeIntrinsicPtr& intri) const;
 
     static cv::Mat DrawRawEventFrame(const std::vector<Ptr>::const_iterator& sIter,
                                      const std::vector<Ptr>::const_iterator& eIter,
                                      const ns_veta::PinholeIntrinsicPtr& intri);
 
+protected:
+    void DrawEventsOnFrame(cv::Mat& eventFrame) const;
+
+    // move the base time to an earlier one, the offsets of events are updated accordingly
+    void Rebase(double timeBase);
+
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
 public:
     template <class Archive>
     void serialize(Archive& ar) {
-        ar(cereal::make_nvp("timestamp", _timestamp), cereal::make_nvp("events", _events));
+        ar(cereal::make_nvp("timestamp", _timestamp), cereal::make_nvp("time_base", _timeBase),
+           cereal::make_nvp("events", _events));
+    }
+};
+
+static_assert(sizeof(EventArray::PackedEvent) == 8, "events should be packed in 8 bytes");
+
+/**
+ * a zero-copy view of events in the time range [st, et) of a time-ordered sequence of event
+ * arrays. Each array is treated as a block with its min/max event timestamps, thus the view is
+ * located by binary searches on blocks first, and then on events in the boundary blocks
+ */
+class EventArraySpan {
+public:
+    using ArrayIter = std::vector<EventArray::Ptr>::const_iterator;
+
+private:
+    // arrays overlapping the time range
+    ArrayIter _sIter, _eIter;
+    // the index of the first event in '*_sIter', and the end index of events in '*(_eIter - 1)'
+    std::size_t _sIdx, _eIdx;
+
+public:
+    EventArraySpan(ArrayIter sIter, ArrayIter eIter, std::size_t sIdx, std::size_t eIdx);
+
+    // a view of all events in arrays [sIter, eIter)
+    EventArraySpan(const ArrayIter& sIter, const ArrayIter& eIter);
+
+    static EventArraySpan Extract(const std::vector<EventArray::Ptr>& data, double st, double et);
+
+    [[nodiscard]] const ArrayIter& ArraysBegin() const;
+
+    [[nodiscard]] const ArrayIter& ArraysEnd() const;
+
+    // the index range [begin, end) of viewed events in an array of this span
+    [[nodiscard]] std::pair<std::size_t, std::size_t> GetEventRange(const ArrayIter& iter) const;
+
+    [[nodiscard]] std::size_t GetEventCount() const;
+
+    [[nodiscard]] bool IsEmpty() const;
+
+    // 'func' is called as 'func(const EventArray::Ptr &ary, std::size_t idx)' for viewed events
+    template <class Func>
+    void ForEachEvent(Func&& func) const {
+        for (auto iter = _sIter; iter != _eIter; ++iter) {
+            const auto [sIdx, eIdx] = GetEventRange(iter);
+            for (std::size_t idx = sIdx; idx < eIdx; ++idx) {
+                func(*iter, idx);
+            }
+        }
     }
 };
 }  // namespace ns_ikalibr
@@ -37,6 +37,7 @@
 
 #include "util/utils.h"
 #include "ctraj/core/imu.h"
+#include "vector"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -44,6 +45,56 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 using IMUFrame = ns_ctraj::IMUFrame;
+
+/**
+ * inertial samples of a topic stored in the structure-of-arrays layout (timestamps, gyroscope and
+ * accelerometer measurements), which are appended by data loaders directly, without a heap object
+ * per sample. Frames are index-based views of samples packed in a single allocation
+ */
+class IMUSampleStore {
+public:
+    using Ptr = std::shared_ptr<IMUSampleStore>;
+
+private:
+    std::vector<double> _timestamps;
+    std::vector<Eigen::Vector3d> _gyro;
+    std::vector<Eigen::Vector3d> _acce;
+
+public:
+    IMUSampleStore() = default;
+
+    static Ptr Create();
+
+    static Ptr Create(const std::vector<IMUFrame::Ptr> &frames);
+
+    void Reserve(std::size_t size);
+
+    void Append(double timestamp, const Eigen::Vector3d &gyro, const Eigen::Vector3d &acce);
+
+    [[nodiscard]] std::size_t Size() const;
+
+    [[nodiscard]] bool Empty() const;
+
+    [[nodiscard]] const std::vector<double> &GetTimestamps() const;
+
+    [[nodiscard]] double GetTimestamp(std::size_t i) const;
+
+    [[nodiscard]] const Eigen::Vector3d &GetGyro(std::size_t i) const;
+
+    [[nodiscard]] const Eigen::Vector3d &GetAcce(std::size_t i) const;
+
+    /**
+     * frames packed contiguously in a single allocation, the i-th frame views the i-th sample.
+     * Pointers share the ownership of the packed storage, rather than each owns a heap object
+     */
+    [[nodiscard]] std::vector<IMUFrame::Ptr> PackFrames() const;
+
+    // heap bytes held by this store (see 'MemoryUsage')
+    [[nodiscard]] std::size_t GetMemoryBytes() const;
+
+    // heap bytes held by frames from 'PackFrames', including the vector holding them
+    static std::size_t PackedFramesBytes(const std::vector<IMUFrame::Ptr> &frames);
+};
 }
 
 #endif  // IKALIBR_IMU_H
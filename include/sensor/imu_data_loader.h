@@ -38,6 +38,7 @@
 #include "util/utils.h"
 #include "sensor_msgs/Imu.h"
 #include "rosbag/message_instance.h"
+#include "topic_tools/shape_shifter.h"
 #include "sensor/imu.h"
 #include "util/enum_cast.hpp"
 #include "sensor/sensor_model.h"
@@ -62,6 +63,13 @@ public:
 
     virtual IMUFrame::Ptr UnpackFrame(const rosbag::MessageInstance &msgInstance) = 0;
 
+    // unpack a message received from a live subscription, see 'LiveTopicRecorder'
+    virtual IMUFrame::Ptr UnpackFrame(const topic_tools::ShapeShifter &msg) = 0;
+
+    // unpack the message and append the sample to the store directly, without a frame object
+    virtual void UnpackFrame(const rosbag::MessageInstance &msgInstance,
+                             IMUSampleStore &store) = 0;
+
     static IMUDataLoader::Ptr GetLoader(const std::string &imuModelStr);
 
     [[nodiscard]] IMUModelType GetIMUModel() const;
@@ -91,6 +99,18 @@ public:
     static SensorIMULoader::Ptr Create(IMUModelType imuModel, double g2StdUnit, double a2StdUnit);
 
     IMUFrame::Ptr UnpackFrame(const rosbag::MessageInstance &msgInstance) override;
+
+    IMUFrame::Ptr UnpackFrame(const topic_tools::ShapeShifter &msg) override;
+
+    void UnpackFrame(const rosbag::MessageInstance &msgInstance, IMUSampleStore &store) override;
+
+protected:
+    // 'MsgSource' is either a bag message instance or a live message
+    template <class MsgSource>
+    void UnpackSampleFrom(const MsgSource &source,
+                          double &timestamp,
+                          Eigen::Vector3d &gyro,
+                          Eigen::Vector3d &acce);
 };
 
 class SbgIMULoader : public IMUDataLoader {
@@ -103,6 +123,17 @@ public:
     static SbgIMULoader::Ptr Create(IMUModelType imuModel);
 
     IMUFrame::Ptr UnpackFrame(const rosbag::MessageInstance &msgInstance) override;
+
+    IMUFrame::Ptr UnpackFrame(const topic_tools::ShapeShifter &msg) override;
+
+    void UnpackFrame(const rosbag::MessageInstance &msgInstance, IMUSampleStore &store) override;
+
+protected:
+    template <class MsgSource>
+    void UnpackSampleFrom(const MsgSource &source,
+                          double &timestamp,
+                          Eigen::Vector3d &gyro,
+                          Eigen::Vector3d &acce);
 };
 }  // namespace ns_ikalibr
 
@@ -154,6 +154,23 @@ struct IMUIntrinsics {
                                 RemoveForceIntri(frame->GetAcce()));
     }
 
+    // the matrix mapping the real force to the measurement (without bias), i.e., 'mapMat'
+    [[nodiscard]] Eigen::Matrix3d ForceIntriMatrix() const { return ACCE.MapMatrix(); }
+
+    // the matrix mapping the real angular velocity to the measurement, i.e., 'mapMat * SO3_AtoG'
+    [[nodiscard]] Eigen::Matrix3d GyroIntriMatrix() const {
+        return GYRO.MapMatrix() * SO3_AtoG.matrix();
+    }
+
+    // remove intrinsics of measurements stored column by column at once
+    [[nodiscard]] Eigen::Matrix3Xd RemoveForceIntriBatch(const Eigen::Matrix3Xd &forces) const {
+        return ForceIntriMatrix().inverse() * (forces.colwise() - ACCE.BIAS);
+    }
+
+    [[nodiscard]] Eigen::Matrix3Xd RemoveGyroIntriBatch(const Eigen::Matrix3Xd &gyros) const {
+        return GyroIntriMatrix().inverse() * (gyros.colwise() - GYRO.BIAS);
+    }
+
     // quaternion
     [[nodiscard]] Eigen::Quaterniond Q_AtoG() const { return SO3_AtoG.unit_quaternion(); }
 
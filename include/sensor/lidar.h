@@ -45,6 +45,15 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+/**
+ * the compact point stored in lidar frames, where the time is a 32-bit offset relative to the
+ * timestamp of the frame, i.e., 16 bytes per point rather than 32 ones of 'IKalibrPoint'
+ */
+struct CompactLiDARPoint {
+    float x, y, z;
+    float timeOffset;
+};
+
 struct LiDARFrame {
 public:
     using Ptr = std::shared_ptr<LiDARFrame>;
@@ -52,8 +61,11 @@ public:
 private:
     // the timestamp of this lidar scan
     double _timestamp;
-    // the lidar scan [x, y, z, timestamp]
-    IKalibrPointCloud::Ptr _scan;
+    // the lidar scan [x, y, z, time offset], organized as the 'IKalibrPointCloud' it is from
+    std::vector<CompactLiDARPoint> _points;
+    std::uint32_t _width, _height;
+    bool _isDense;
+    pcl::PCLHeader _header;
 
 public:
     // constructor
@@ -65,11 +77,29 @@ public:
         double timestamp = INVALID_TIME_STAMP,
         const IKalibrPointCloud::Ptr &scan = boost::make_shared<IKalibrPointCloud>());
 
-    // access
+    /**
+     * the scan with absolute point timestamps for pcl-facing apis, which is converted from the
+     * compact storage for each call, thus modifications on it would not be written back
+     */
     [[nodiscard]] IKalibrPointCloud::Ptr GetScan() const;
 
+    [[nodiscard]] const std::vector<CompactLiDARPoint> &GetCompactPoints() const;
+
+    [[nodiscard]] std::uint32_t GetWidth() const;
+
+    [[nodiscard]] std::uint32_t GetHeight() const;
+
+    [[nodiscard]] std::size_t GetPointCount() const;
+
+    // the absolute timestamp of the 'i'-th point
+    [[nodiscard]] double GetPointTimestamp(std::size_t i) const;
+
+    // heap bytes held by this frame (see 'MemoryUsage'), including the shared-ptr overhead
+    [[nodiscard]] std::size_t GetMemoryBytes() const;
+
     [[nodiscard]] double GetTimestamp() const;
 
+    // point times are relative to the frame, thus they are shifted along with the frame
     void SetTimestamp(double timestamp);
 
     friend std::ostream &operator<<(std::ostream &os, const LiDARFrame &frame);
@@ -35,11 +35,14 @@
 #ifndef IKALIBR_LIDAR_DATA_LOADER_H
 #define IKALIBR_LIDAR_DATA_LOADER_H
 
+#include "sensor/data_loader_registry.h"
 #include "sensor/lidar.h"
 #include "rosbag/message_instance.h"
 #include "util/enum_cast.hpp"
 #include "velodyne_msgs/VelodyneScan.h"
 #include "sensor/sensor_model.h"
+#include "sensor_msgs/PointCloud2.h"
+#include "mutex"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,12 +57,31 @@ public:
 protected:
     LidarModelType _lidarModel;
 
+    /**
+     * the field layout of 'sensor_msgs::PointCloud2', which is recognized once per topic (and
+     * recognized again only if the fields change), so that points can be converted via offsets
+     * directly, without per-field lookups for each point
+     */
+    struct PointCloud2Layout {
+        // the fields (name, offset, datatype) this layout is recognized from
+        std::vector<std::tuple<std::string, std::uint32_t, std::uint8_t>> fields;
+        std::uint32_t xOffset = 0, yOffset = 0, zOffset = 0, timeOffset = 0;
+        std::uint8_t timeDatatype = 0;
+        bool supported = false;
+    };
+    PointCloud2Layout _layout;
+    std::mutex _layoutMutex;
+
 public:
     explicit LiDARDataLoader(LidarModelType lidarModel)
         : _lidarModel(lidarModel) {}
 
     virtual LiDARFrame::Ptr UnpackScan(const rosbag::MessageInstance &msgInstance) = 0;
 
+    /**
+     * create the loader by the fastest decoder registered for the model (see 'DataLoaderRegistry'),
+     * plugin loaders should be loaded first (see 'LoadDataLoaderPlugins')
+     */
     static LiDARDataLoader::Ptr GetLoader(const std::string &lidarModelStr);
 
     [[nodiscard]] LidarModelType GetLiDARModel() const;
@@ -74,6 +96,21 @@ protected:
                 "' for LiDARs! It's incompatible with the type of ros message to load in!");
         }
     }
+
+    PointCloud2Layout GetPointCloud2Layout(const sensor_msgs::PointCloud2 &msg,
+                                           const std::string &timeField);
+
+    /**
+     * convert the point cloud message using the recognized field layout, points out of the depth
+     * range would be removed, and the timestamp of a point is 'timebase + time * timeScale'. If the
+     * layout is not supported, nullptr would be returned, and the pcl-based conversion is expected
+     */
+    IKalibrPointCloud::Ptr UnpackPointCloud2(const sensor_msgs::PointCloud2 &msg,
+                                             const std::string &timeField,
+                                             double timebase,
+                                             double timeScale,
+                                             double depthMin,
+                                             double depthMax);
 };
 
 class Velodyne16 : public LiDARDataLoader {
@@ -88,11 +125,20 @@ public:
     // for Velodyne16 ['VLP_16_SIMU' and 'VLP_16_PACKET']
     LiDARFrame::Ptr UnpackScan(const rosbag::MessageInstance &msgInstance) override;
 
+    /**
+     * decode all packets of a scan in batch: raw ranges and corrected azimuth bins of all firings
+     * are gathered first, then xyz coordinates are computed in a vectorized pass using the
+     * precomputed sin/cos tables, finally points are organized into the scan. It's thread-safe
+     */
+    [[nodiscard]] LiDARFrame::Ptr UnpackPackets(
+        const std::vector<velodyne_msgs::VelodynePacket> &packets, double scanTimestamp) const;
+
 protected:
     [[nodiscard]] LiDARFrame::Ptr UnpackScan(
         const velodyne_msgs::VelodyneScan::ConstPtr &lidarMsg) const;
 
-    [[nodiscard]] double GetExactTime(int dsr, int firing) const;
+    // the time of the laser in the firing (counted from the first one in the scan)
+    [[nodiscard]] static double GetExactTime(int dsr, int firing);
 
     void SetParameters();
 
@@ -124,6 +170,8 @@ private:
     float COS_VERT_ANGLE[16]{};
     float SIN_VERT_ANGLE[16]{};
     int SCAN_MAPPING_16[16]{};
+    // the azimuth correction factors of each laser in each firing of a block
+    float AZIMUTH_TOFFSET_FACTOR[2][16]{};
 
     typedef struct RawBlock {
         uint16_t header;    ///< UPPER_BANK or LOWER_BANK
@@ -155,8 +203,6 @@ private:
         int maxAngle;  // maximum angle to publish
     } Config;
     Config CONFIG{};
-
-    double VLP16_TIME_BLOCK[1824][16]{};
 };
 
 class VelodynePoints : public LiDARDataLoader {
@@ -205,6 +251,8 @@ public:
 
     LiDARFrame::Ptr UnpackScan(const rosbag::MessageInstance &msgInstance) override;
 };
+
+extern template class DataLoaderRegistry<LiDARDataLoader>;
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_LIDAR_DATA_LOADER_H
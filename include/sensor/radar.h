@@ -110,6 +110,52 @@ public:
     }
 };
 
+/**
+ * a contiguous (structure-of-arrays) view of radar targets, which are referred by indices
+ */
+struct RadarTargetSoAView {
+public:
+    Eigen::VectorBlock<const Eigen::VectorXd> timestamps, ranges, radialVels;
+    Eigen::Block<const Eigen::Matrix3Xd, 3, Eigen::Dynamic, true> dirs;
+
+    [[nodiscard]] Eigen::Index Size() const { return timestamps.size(); }
+};
+
+/**
+ * radar targets stored in the structure-of-arrays layout, so that they can be traversed without
+ * chasing pointers, and doppler residuals of targets can be evaluated in a vectorized manner
+ */
+struct RadarTargetSoA {
+public:
+    Eigen::VectorXd timestamps;
+    // [ range | azimuth (theta) | elevation (phi) ], see 'RadarTarget::GetTargetRTP'
+    Eigen::VectorXd ranges, azimuths, elevations;
+    // doppler velocities, i.e., target radial velocities with respect to radar in frame {R}
+    Eigen::VectorXd radialVels;
+    // unit directions of targets in frame {R} (3 x N)
+    Eigen::Matrix3Xd dirs;
+
+public:
+    explicit RadarTargetSoA(Eigen::Index size = 0);
+
+    static RadarTargetSoA FromTargets(const std::vector<RadarTarget::Ptr> &targets);
+
+    [[nodiscard]] Eigen::Index Size() const;
+
+    // the size is changed, values of targets in the kept range are preserved
+    void Resize(Eigen::Index size);
+
+    void Set(Eigen::Index i, double timestamp, const Eigen::Vector3d &xyz, double radialVel);
+
+    [[nodiscard]] Eigen::Vector3d GetTargetXYZ(Eigen::Index i) const;
+
+    [[nodiscard]] RadarTargetSoAView View(Eigen::Index begin, Eigen::Index size) const;
+
+    [[nodiscard]] RadarTargetSoAView View() const;
+
+    [[nodiscard]] std::size_t GetMemoryBytes() const;
+};
+
 struct RadarTargetArray {
 public:
     using Ptr = std::shared_ptr<RadarTargetArray>;
@@ -118,6 +164,10 @@ private:
     // the timestamp of this array
     double _timestamp;
     std::vector<RadarTarget::Ptr> _targets;
+    // the contiguous storage of targets (see 'CreatePacked'), nullptr if allocated one by one
+    std::shared_ptr<std::vector<RadarTarget>> _packed;
+    // targets in the structure-of-arrays layout, always in sync with '_targets'
+    RadarTargetSoA _soa;
 
 public:
     explicit RadarTargetArray(double timestamp = INVALID_TIME_STAMP,
@@ -126,12 +176,32 @@ public:
     static RadarTargetArray::Ptr Create(double timestamp = INVALID_TIME_STAMP,
                                         const std::vector<RadarTarget::Ptr> &targets = {});
 
+    /**
+     * create the array whose targets are stored contiguously in a single allocation, rather than
+     * allocated one by one. Pointers of targets share the ownership of the storage
+     */
+    static RadarTargetArray::Ptr CreatePacked(double timestamp, std::vector<RadarTarget> targets);
+
+    /**
+     * create the array from targets already organized in the structure-of-arrays layout (e.g.,
+     * filled by data loaders directly), the packed targets are generated from it
+     */
+    static RadarTargetArray::Ptr CreatePacked(double timestamp, RadarTargetSoA soa);
+
     [[nodiscard]] double GetTimestamp() const;
 
     void SetTimestamp(double timestamp);
 
     [[nodiscard]] const std::vector<RadarTarget::Ptr> &GetTargets() const;
 
+    [[nodiscard]] const RadarTargetSoA &GetTargetSoA() const;
+
+    // shift timestamps of this array and its targets (both layouts) by 'dt'
+    void ShiftTimestamps(double dt);
+
+    // heap bytes held by this array (see 'MemoryUsage'), including the shared-ptr overhead
+    [[nodiscard]] std::size_t GetMemoryBytes() const;
+
     // save radar frames sequence to disk
     static bool SaveTargetArraysToDisk(const std::string &filename,
                                        const std::vector<RadarTargetArray::Ptr> &arrays,
@@ -144,8 +214,15 @@ public:
 
 public:
     template <class Archive>
-    void serialize(Archive &ar) {
+    void save(Archive &ar) const {
+        ar(cereal::make_nvp("timestamp", _timestamp), cereal::make_nvp("targets", _targets));
+    }
+
+    template <class Archive>
+    void load(Archive &ar) {
         ar(cereal::make_nvp("timestamp", _timestamp), cereal::make_nvp("targets", _targets));
+        _packed = nullptr;
+        _soa = RadarTargetSoA::FromTargets(_targets);
     }
 };
 
@@ -36,10 +36,13 @@
 #define IKALIBR_RADAR_DATA_LOADER_H
 
 #include "rosbag/message_instance.h"
+#include "sensor/data_loader_registry.h"
 #include "sensor/radar.h"
 #include "util/cloud_define.hpp"
 #include "util/enum_cast.hpp"
 #include "sensor/sensor_model.h"
+#include "sensor_msgs/PointCloud2.h"
+#include "mutex"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,11 +57,29 @@ public:
 protected:
     RadarModelType _radarModel;
 
+    /**
+     * the field layout of 'sensor_msgs::PointCloud2', which is recognized once per topic (and
+     * recognized again only if the fields change), so that targets can be converted via offsets
+     * directly, without per-field lookups for each target
+     */
+    struct PointCloud2Layout {
+        // the fields (name, offset, datatype) this layout is recognized from
+        std::vector<std::tuple<std::string, std::uint32_t, std::uint8_t>> fields;
+        std::uint32_t xOffset = 0, yOffset = 0, zOffset = 0, velOffset = 0;
+        bool supported = false;
+    };
+    PointCloud2Layout _layout;
+    std::mutex _layoutMutex;
+
 public:
     explicit RadarDataLoader(RadarModelType radarModel);
 
     virtual RadarTargetArray::Ptr UnpackScan(const rosbag::MessageInstance &msgInstance) = 0;
 
+    /**
+     * create the loader by the fastest decoder registered for the model (see 'DataLoaderRegistry'),
+     * plugin loaders should be loaded first (see 'LoadDataLoaderPlugins')
+     */
     static RadarDataLoader::Ptr GetLoader(const std::string &radarModelStr);
 
     [[nodiscard]] RadarModelType GetRadarModel() const;
@@ -74,6 +95,19 @@ protected:
                 std::string(EnumCast::enumToString(GetRadarModel())));
         }
     }
+
+    PointCloud2Layout GetPointCloud2Layout(const sensor_msgs::PointCloud2 &msg,
+                                           const std::string &velField);
+
+    /**
+     * convert the point cloud message using the recognized field layout into a packed target array
+     * (see 'RadarTargetArray::CreatePacked'), invalid and too-close targets would be removed. If
+     * the layout is not supported, nullptr would be returned, and the pcl-based conversion is
+     * expected
+     */
+    RadarTargetArray::Ptr UnpackPointCloud2(const sensor_msgs::PointCloud2 &msg,
+                                            const std::string &velField,
+                                            double timestamp);
 };
 
 class AinsteinRadarLoader : public RadarDataLoader {
@@ -138,7 +172,7 @@ public:
 
 class PointCloud2XRIOLoader : public RadarDataLoader {
 public:
-    using Ptr = std::shared_ptr<PointCloud2POSIVLoader>;
+    using Ptr = std::shared_ptr<PointCloud2XRIOLoader>;
 
 public:
     explicit PointCloud2XRIOLoader(RadarModelType radarModel);
@@ -147,6 +181,8 @@ public:
 
     RadarTargetArray::Ptr UnpackScan(const rosbag::MessageInstance &msgInstance) override;
 };
+
+extern template class DataLoaderRegistry<RadarDataLoader>;
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_RADAR_DATA_LOADER_H
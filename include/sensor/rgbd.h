@@ -46,6 +46,25 @@ namespace ns_ikalibr {
 struct RGBDIntrinsics;
 using RGBDIntrinsicsPtr = std::shared_ptr<RGBDIntrinsics>;
 
+/**
+ * the rays (on the plane 'z = 1') of pixels of depth images, which are computed once for the
+ * intrinsics and shared by all frames, a point is then back-projected by 'depth * ray'
+ */
+struct RGBDRayLUT {
+public:
+    using Ptr = std::shared_ptr<RGBDRayLUT>;
+
+public:
+    int width, height;
+    // the x and y components of rays, stored row by row
+    std::vector<float> xs, ys;
+
+public:
+    RGBDRayLUT(const RGBDIntrinsicsPtr &intri, int width, int height);
+
+    static Ptr Create(const RGBDIntrinsicsPtr &intri, int width, int height);
+};
+
 class RGBDFrame : public CameraFrame {
 public:
     using Ptr = std::shared_ptr<RGBDFrame>;
@@ -70,23 +89,72 @@ public:
 
     cv::Mat &GetDepthImage();
 
+    // the raw depth at the given pixel, raw depths are stored as 16-bit (CV_16U) or float ones
+    [[nodiscard]] float GetRawDepth(int row, int col) const;
+
     // release the image mat data to save memory when needed
     void ReleaseMat() override;
 
+    [[nodiscard]] std::size_t GetMemoryBytes() const override;
+
     [[nodiscard]] cv::Mat CreateColorDepthMap(const RGBDIntrinsicsPtr &intri,
                                               bool withColorMat = true,
                                               float zMin = 0.1f,
                                               float zMax = 80.0f) const;
 
+    /**
+     * back-project valid depths to a cloud. If 'sampleCount' is positive, only this count of valid
+     * pixels are randomly sampled and back-projected, thus the dense cloud is never created. The
+     * ray lut is created here if it is not given (or not matched)
+     */
     ColorPointCloud::Ptr CreatePointCloud(const RGBDIntrinsicsPtr &intri,
                                           float zMin = 0.1f,
-                                          float zMax = 80.0f);
+                                          float zMax = 80.0f,
+                                          int sampleCount = -1,
+                                          const RGBDRayLUT::Ptr &lut = nullptr);
 
     IKalibrPointCloud::Ptr CreatePointCloud(double rsExpFactor,
                                             double readout,
                                             const RGBDIntrinsicsPtr &intri,
                                             float zMin = 0.1f,
-                                            float zMax = 80.0f);
+                                            float zMax = 80.0f,
+                                            int sampleCount = -1,
+                                            const RGBDRayLUT::Ptr &lut = nullptr);
+
+    /**
+     * back-project at most 'count' pixels selected for data association. The image is bucketed
+     * into cells, pixels on depth discontinuities (and next to holes) are rejected, and the most
+     * planar one in each cell is kept, thus points are spread over the image and mostly on surfels
+     */
+    IKalibrPointCloud::Ptr CreateSparsePointCloud(double rsExpFactor,
+                                                  double readout,
+                                                  const RGBDIntrinsicsPtr &intri,
+                                                  int count,
+                                                  float zMin = 0.1f,
+                                                  float zMax = 80.0f,
+                                                  const RGBDRayLUT::Ptr &lut = nullptr);
+
+protected:
+    // (row-major) indices of pixels whose depths are in range, and the depths of all pixels
+    [[nodiscard]] std::vector<int> ValidDepthPixels(const RGBDIntrinsicsPtr &intri,
+                                                    float zMin,
+                                                    float zMax,
+                                                    int sampleCount,
+                                                    std::vector<float> &depths) const;
+
+    // (row-major) indices of edge-free and planar pixels, see 'CreateSparsePointCloud'
+    [[nodiscard]] std::vector<int> SparseDepthPixels(const RGBDIntrinsicsPtr &intri,
+                                                     float zMin,
+                                                     float zMax,
+                                                     int count,
+                                                     std::vector<float> &depths) const;
+
+    [[nodiscard]] IKalibrPointCloud::Ptr BackProject(double rsExpFactor,
+                                                     double readout,
+                                                     const RGBDIntrinsicsPtr &intri,
+                                                     const std::vector<int> &indices,
+                                                     const std::vector<float> &depths,
+                                                     const RGBDRayLUT::Ptr &lut) const;
 };
 
 class DepthFrame {
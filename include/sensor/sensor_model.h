@@ -116,6 +116,9 @@ struct LidarModel {
         PANDAR_XT_POINTS,
 
         LIVOX_CUSTOM,
+
+        // models registered by data loader plugins, which are not enumerated here
+        PLUGIN,
     };
 
     static std::string UnsupportedLiDARModelMsg(const std::string &modelStr);
@@ -131,6 +134,9 @@ struct RadarModel {
         POINTCLOUD2_POSV,
         POINTCLOUD2_POSIV,
         POINTCLOUD2_XRIO,
+
+        // models registered by data loader plugins, which are not enumerated here
+        PLUGIN,
     };
 
     static std::string UnsupportedRadarModelMsg(const std::string &modelStr);
@@ -39,10 +39,13 @@
 
 #include "calib/time_deriv.hpp"
 #include "ceres/solver.h"
+#include "config/calib_context.h"
 #include "config/configor.h"
 #include "core/rot_only_vo.h"
+#include "sensor/imu.h"
 #include "ctraj/core/pose.hpp"
 #include "ctraj/core/spline_bundle.h"
+#include "functional"
 #include "optional"
 #include "pcl/point_cloud.h"
 
@@ -80,14 +83,20 @@ struct VisualReProjCorrSeq;
 using VisualReProjCorrSeqPtr = std::shared_ptr<VisualReProjCorrSeq>;
 struct OpticalFlowCorr;
 using OpticalFlowCorrPtr = std::shared_ptr<OpticalFlowCorr>;
-struct PointToSurfelCorr;
-using PointToSurfelCorrPtr = std::shared_ptr<PointToSurfelCorr>;
+struct PointToSurfelCorrBuffer;
+using PointToSurfelCorrBufferPtr = std::shared_ptr<PointToSurfelCorrBuffer>;
 struct LiDARFrame;
 using LiDARFramePtr = std::shared_ptr<LiDARFrame>;
+class PointToSurfelAssociator;
+using PointToSurfelAssociatorPtr = std::shared_ptr<PointToSurfelAssociator>;
+class LinearScaleFitter;
+using LinearScaleFitterPtr = std::shared_ptr<LinearScaleFitter>;
 class CameraFrame;
 using CameraFramePtr = std::shared_ptr<CameraFrame>;
 class Viewer;
 using ViewerPtr = std::shared_ptr<Viewer>;
+class ViewerBridge;
+using ViewerBridgePtr = std::shared_ptr<ViewerBridge>;
 class Estimator;
 using EstimatorPtr = std::shared_ptr<Estimator>;
 enum class OptOption : std::uint64_t;
@@ -95,6 +104,12 @@ struct EventArray;
 using EventArrayPtr = std::shared_ptr<EventArray>;
 struct OpticalFlowCurveCorr;
 using OpticalFlowCurveCorrPtr = std::shared_ptr<OpticalFlowCurveCorr>;
+class DataLifetimePlanner;
+using DataLifetimePlannerPtr = std::shared_ptr<DataLifetimePlanner>;
+class TemporalPadding;
+
+class PoseQueryCursor;
+using TemporalPaddingPtr = std::shared_ptr<TemporalPadding>;
 
 struct ImagesInfo {
 public:
@@ -139,6 +154,8 @@ public:
     public:
         // estimator
         EstimatorPtr estimator;
+        // the optimization option of this estimator
+        OptOption optOption;
         // visual global scale
         std::shared_ptr<double> visualGlobalScale;
         // visual reprojection correspondences contains inverse depth parameters
@@ -146,11 +163,13 @@ public:
         // lidar global map
         IKalibrPointCloudPtr lidarMap;
         // lidar point-to-surfel correspondences
-        std::map<std::string, std::vector<PointToSurfelCorrPtr>> lidarCorrs;
+        std::map<std::string, PointToSurfelCorrBufferPtr> lidarCorrs;
         // radar global map
         IKalibrPointCloudPtr radarMap;
         // visual optical flow correspondences, orienting to RGBDs and VelCameras
         std::map<std::string, std::vector<OpticalFlowCorrPtr>> ofCorrs;
+        // event optical flow correspondences, whose depths are parameters in the estimator
+        std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> eventCorrs;
     };
 
     struct InitAsset {
@@ -162,6 +181,10 @@ public:
         std::map<std::string, LiDAROdometerPtr> lidarOdometers;
         // undistorted scans for each lidar
         std::map<std::string, std::vector<LiDARFramePtr>> undistFramesInScan;
+        // radar-derived radar-frame velocities for each radar (indexed as target arrays), which are
+        // estimated using the rough and the refined ransac thresholds respectively
+        std::map<std::string, std::vector<Eigen::Vector3d>> radarRoughBodyFrameVels;
+        std::map<std::string, std::vector<Eigen::Vector3d>> radarBodyFrameVels;
         // rgbd-derived rgbd-frame velocities for each rgbd camera
         std::map<std::string, std::vector<std::pair<CameraFramePtr, Eigen::Vector3d>>>
             rgbdBodyFrameVels;
@@ -178,13 +201,40 @@ public:
         std::map<std::string, std::vector<std::pair<double, Eigen::Vector3d>>> velEventBodyFrameVel;
         // SfM pose sequence for each camera
         std::map<std::string, std::vector<ns_ctraj::Posed>> sfmPoseSeq;
-        // the global lidar map expressed in world frame
+        // the global lidar map expressed in world frame (voxelized using 'MapDownSample')
         IKalibrPointCloudPtr globalMap;
         // undistorted scans for each lidar expressed in the world frame
         std::map<std::string, std::vector<LiDARFramePtr>> undistFramesInMap;
     };
 
+    struct SurfelMapAsset {
+    public:
+        using Ptr = std::shared_ptr<SurfelMapAsset>;
+
+    public:
+        // the lidar surfel map (in associator) kept across batch optimizations
+        PointToSurfelAssociatorPtr associator;
+        // undistorted scans expressed in the world frame, which are inserted to the surfel map
+        std::map<std::string, std::vector<LiDARFramePtr>> framesInMap;
+    };
+
+    struct BatchOptCorrs {
+    public:
+        // point-to-surfel correspondences for lidars
+        std::map<std::string, PointToSurfelCorrBufferPtr> lidarPtsCorrs;
+        // visual reprojection correspondences for pos-cameras
+        std::map<std::string, std::vector<VisualReProjCorrSeqPtr>> visualReprojCorrs;
+        // optical flow correspondences for rgbd cameras
+        std::map<std::string, std::vector<OpticalFlowCorrPtr>> rgbdCorrs;
+        // optical flow correspondences for vel-cameras
+        std::map<std::string, std::vector<OpticalFlowCorrPtr>> visualVelCorrs;
+        // optical flow curve correspondences for event cameras
+        std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> eventCorrs;
+    };
+
 private:
+    // the context (configuration) of this calibration, which is active when solving
+    CalibContextPtr _context;
     // the data manager for calibration
     CalibDataManagerPtr _dataMagr;
     // the parameter manager for calibration
@@ -197,42 +247,104 @@ private:
     ceres::Solver::Options _ceresOption;
     // viewer used to visualize entities in calibration
     ViewerPtr _viewer;
+    // publishes solver snapshots to the viewer asynchronously, e.g., in ceres iterations
+    ViewerBridgePtr _viewerBridge;
     // storge results from optimization for by-products-related output
     BackUp::Ptr _backup;
     // storge temporal results from initialization, which would be destroyed after initialization
     InitAsset::Ptr _initAsset;
+    // the lidar surfel map used for data association, which is updated incrementally
+    SurfelMapAsset::Ptr _surfelAsset;
+    // releases heavy payloads (images, depth maps) once the last stage using them is finished
+    DataLifetimePlannerPtr _lifetimePlanner;
+    // paddings of temporal parameters, narrowed as they converge in batch optimizations
+    TemporalPaddingPtr _temporalPadding;
     // indicates whether the solving is finished
     bool _solveFinished;
+    // the index of the next dumped batch optimization problem of this run
+    mutable int _batchOptProblemIdx;
+    // the index of the next dumped factor evaluation profile of this run
+    mutable int _factorProfileIdx;
 
 public:
     /**
      * create a solver for spatiotemporal calibration
      * @param calibDataManager the data manager
      * @param calibParamManager the parameter manager
+     * @param context the calibration context, the one of the data manager is used if not given
      */
     explicit CalibSolver(CalibDataManagerPtr calibDataManager,
-                         CalibParamManagerPtr calibParamManager);
+                         CalibParamManagerPtr calibParamManager,
+                         CalibContextPtr context = nullptr);
 
     /**
      * create a solver shared pointer for spatiotemporal calibration
      * @param calibDataManager the data manager
      * @param calibParamManager the parameter manager
+     * @param context the calibration context, the one of the data manager is used if not given
      * @return the shared pointer of this solver
      */
     static Ptr Create(const CalibDataManagerPtr &calibDataManager,
-                      const CalibParamManagerPtr &calibParamManager);
+                      const CalibParamManagerPtr &calibParamManager,
+                      const CalibContextPtr &context = nullptr);
+
+    [[nodiscard]] const CalibContextPtr &GetContext() const;
+
+    /**
+     * close the viewer rather than waiting for users to close it when this solver is destroyed,
+     * which is used when calibrations are performed one by one in a long-running process
+     */
+    void CloseViewer() const;
 
     /**
      * perform the spatiotemporal calibration
      */
     void Process();
 
+    /**
+     * perform the joint spatiotemporal calibration of multiple sessions (recordings of the same
+     * sensor suite), where each session has its own splines and data, and the calibration
+     * parameters are shared (estimated jointly in batch optimizations)
+     * @param sessions the solvers of sessions, which should share the same parameter manager
+     * @param context the base context, under which the joint batch optimizations are performed
+     */
+    static void ProcessSessions(const std::vector<Ptr> &sessions, const CalibContextPtr &context);
+
     /**
      * de-constructor
      */
     virtual ~CalibSolver();
 
 protected:
+    /**
+     * the initialization procedure to recover spatiotemporal parameters and interested states in
+     * the estimator, such as the splines and the gravity vector
+     */
+    void Initialization();
+
+    /**
+     * save the states after a stage as a checkpoint (in 'OutputPath/checkpoint'), including the
+     * splines, the spatiotemporal parameters, the SfM data, and tracked optical flow traces and
+     * feature curves, from which the calibration can be resumed without initialization
+     * @param desc the description of this stage, i.e., 'stage_3_scale_fit' or 'stage_4_bo_i'
+     */
+    void SaveStageCheckpoint(const std::string &desc) const;
+
+    /**
+     * load the checkpoint saved after a stage, which should be bound to the same data and splines
+     * @param desc the description of this stage, i.e., 'stage_3_scale_fit' or 'stage_4_bo_i'
+     * @return the index of the batch optimization to resume from
+     */
+    int LoadStageCheckpoint(const std::string &desc);
+
+    /**
+     * warm-start the calibration from the parameters and splines of a previous calibration (see
+     * 'Preference::WarmStartParamPath'), which are accepted only if they cover the data and
+     * reproduce subsampled inertial measurements of all IMUs
+     * @return true if accepted, then the initialization procedure could be skipped
+     */
+    bool TryWarmStart();
+
     /**
      * transform an input veta using given transformation information, if scale is provide,
      * this veta would also ve scaled
@@ -251,6 +363,12 @@ protected:
      */
     void AlignStatesToGravity() const;
 
+    /**
+     * align states to the given gravity vector (expressed in the current reference frame), rather
+     * than the one in the parameter manager, which is overwritten by the aligned one
+     */
+    void AlignStatesToGravity(const Eigen::Vector3d &gravity) const;
+
     /**
      * initialize (recover) the rotation spline using raw angular velocity measurements from
      * the gyroscope. If multiple gyroscopes (IMUs) are involved, the extrinsic rotations and
@@ -258,11 +376,24 @@ protected:
      */
     void InitSO3Spline() const;
 
+    /**
+     * fit knots of the so3 spline linearly using the reference gyroscope, the adjoint terms of the
+     * cumulative parameterization are neglected, i.e., increments between neighboring knots (in
+     * the Lie algebra) are solved from a banded linear system, and knots are accumulated then
+     */
+    void FitSO3SplineLinearly() const;
+
     /**
      * perform sensor-inertial alignment to recover the gravity vector and extrinsic translations
      */
     void InitSensorInertialAlign() const;
 
+    /**
+     * perform the preparations of all sensor-inertial alignments below. These preparations are
+     * independent of each other, thus they are run concurrently and share the available threads
+     */
+    void InitPrepSensorInertialAlign();
+
     /**
      * detailed sensor-inertial alignment for camera and IMU, this is the preparation for final
      * one-shot sensor-inertial alignment
@@ -275,18 +406,44 @@ protected:
      */
     void InitPrepVelCameraInertialAlign() const;
 
+    /**
+     * the tracking pipeline of a single camera in 'InitPrepVelCameraInertialAlign': rotation-only
+     * visual odometry and extrinsic rotation initialization. Frames are decoded 'prefetchDepth'
+     * frames ahead of the tracking, the viewer and progress bars are only touched when
+     * 'visualize' is set
+     * @return the feature tracking information of this camera
+     */
+    std::list<RotOnlyVisualOdometer::FeatTrackingInfo> InitPrepVelCameraPipeline(
+        const std::string &topic, int prefetchDepth, bool visualize) const;
+
     /**
      * detailed sensor-inertial alignment for LiDAR and IMU, this is the preparation for final
      * one-shot sensor-inertial alignment
      */
     void InitPrepLiDARInertialAlign() const;
 
+    /**
+     * the pipeline of a single LiDAR in 'InitPrepLiDARInertialAlign': extrinsic rotation
+     * initialization, rotation-only undistortion, and the odometer rerun. Pipelines of different
+     * LiDARs run concurrently, the viewer and progress bars are only touched when 'visualize'
+     * is set
+     */
+    void InitPrepLiDARPipeline(const std::string &topic, int ndtThreads, bool visualize) const;
+
     /**
      * detailed sensor-inertial alignment for RGBD camera and IMU, this is the preparation for final
      * one-shot sensor-inertial alignment
      */
     void InitPrepRGBDInertialAlign() const;
 
+    /**
+     * the tracking pipeline of a single RGBD camera in 'InitPrepRGBDInertialAlign', see
+     * 'InitPrepVelCameraPipeline'
+     * @return the feature tracking information of this RGBD camera
+     */
+    std::list<RotOnlyVisualOdometer::FeatTrackingInfo> InitPrepRGBDPipeline(
+        const std::string &topic, int prefetchDepth, bool visualize) const;
+
     /**
      * detailed sensor-inertial alignment for radars and IMU, this is the preparation for final
      * one-shot sensor-inertial alignment
@@ -312,6 +469,24 @@ protected:
      */
     void InitPrepEventInertialAlignLineBased() const;
 
+    /**
+     * estimate coarse time offsets of sensors with rotation sequences (non-reference IMUs, LiDARs,
+     * and pos-based cameras) by correlating their angular rate magnitudes, which are invariant to
+     * extrinsic rotations, with the ones of the so3 spline. Paddings of time offsets used in batch
+     * optimizations are narrowed around them (see 'Configor::Preference::CoarseTimeOffsetMargin')
+     */
+    void InitCoarseTimeOffsets() const;
+
+    /**
+     * find the time offset 'TO' (bounded by 'maxLag') maximizing the normalized cross-correlation
+     * between angular rate magnitudes of the sensor and the so3 spline, i.e., 'w_sen(t) ~
+     * w_spline(t + TO)'
+     * @param rates the time-ordered angular rate magnitudes stamped by the sensor
+     * @return the time offset and the correlation coefficient, or nullopt if data are insufficient
+     */
+    [[nodiscard]] std::optional<std::pair<double, double>> CorrelateAngularRates(
+        const std::vector<std::pair<double, double>> &rates, double maxLag) const;
+
     /**
      * initialize the linear scale spline using by-products from sensor-inertial alignment
      * one of three kinds of linear scale spline, i.e., linear acceleration, linear velocity, and
@@ -319,6 +494,16 @@ protected:
      */
     void InitScaleSpline() const;
 
+    /**
+     * add accelerometer measurements of the reference imu (in the world frame, using the so3
+     * spline and the gravity) to the closed-form scale spline fitting
+     * @param acceDeriv the time derivative of the scale spline that is the linear acceleration
+     */
+    void AddAcceConstraints(const LinearScaleFitterPtr &fitter, int acceDeriv) const;
+
+    // solve the closed-form scale spline fitting, and assign knots of the scale spline
+    void ApplyLinearScaleFit(const LinearScaleFitterPtr &fitter) const;
+
     /**
      * preparation for the final batch optimization
      */
@@ -326,11 +511,13 @@ protected:
 
     /**
      * build the global map for LiDARs
+     * @param keepDense whether keep all points in the map, otherwise the map is voxelized using
+     * 'MapDownSample' by streaming scans into a voxel map (memory bounded)
      * @return the final map and frames used for map construction.
      * these frames are also expressed in the map (global) frame, rather than local frames
      */
     std::tuple<IKalibrPointCloudPtr, std::map<std::string, std::vector<LiDARFramePtr>>>
-    BuildGlobalMapOfLiDAR() const;
+    BuildGlobalMapOfLiDAR(bool keepDense = false) const;
 
     /**
      * build the global map for radars, this is only for visualization if translation spline
@@ -348,14 +535,17 @@ protected:
 
     /**
      * build the global map for RGBDs
-     * @return the global map, scans in global frame, and scans in local frame
+     * @param keepDense whether keep all (sampled) points in the map, otherwise the map is voxelized
+     * using 'MapDownSample' by streaming scans into a voxel map (memory bounded)
+     * @return the global map, scans in global frame, and scans in local frame. Scans are sparse
+     * ones (edge-free and planar pixels) for data association, rather than those building the map
      */
     std::tuple<IKalibrPointCloudPtr,
                // scans in global frame
                std::map<std::string, std::vector<IKalibrPointCloudPtr>>,
                // scans in local frame
                std::map<std::string, std::vector<IKalibrPointCloudPtr>>>
-    BuildGlobalMapOfRGBD() const;
+    BuildGlobalMapOfRGBD(bool keepDense = false) const;
 
     /**
      * @param topic the ros topic of this vision sensor
@@ -374,15 +564,29 @@ protected:
 
     /**
      * perform data association for LiDARs
-     * @param map the global point cloud map
+     * @param map the global point cloud map, which is only visualized, the surfel map is built
+     * from the scans
      * @param undistFrames the undistorted scans expressed in the global coordinate frame
      * @param ptsCountInEachScan construct how many correspondences in each scan
+     * @param withMapPoints whether keep the points in the map frame even though the viewer is
+     * headless (they are required for exporting the surfel map)
      * @return the point-to-surfel correspondences for each LiDAR
      */
-    std::map<std::string, std::vector<PointToSurfelCorrPtr>> DataAssociationForLiDARs(
+    std::map<std::string, PointToSurfelCorrBufferPtr> DataAssociationForLiDARs(
         const IKalibrPointCloudPtr &map,
         const std::map<std::string, std::vector<LiDARFramePtr>> &undistFrames,
-        int ptsCountInEachScan) const;
+        int ptsCountInEachScan,
+        bool withMapPoints = false) const;
+
+    /**
+     * obtain the lidar surfel map for data association. The kept surfel map is updated
+     * incrementally: only scans moved beyond 'SurfelMapUpdateThreshold' are erased and re-inserted,
+     * it is rebuilt from the scans if too many scans moved, or no surfel map is kept
+     * @param undistFrames the undistorted scans expressed in the global coordinate frame
+     * @return the associator holding the surfel map
+     */
+    PointToSurfelAssociatorPtr UpdateSurfelMapOfLiDARs(
+        const std::map<std::string, std::vector<LiDARFramePtr>> &undistFrames) const;
 
     /**
      * perform data association for pos-derived cameras
@@ -421,7 +625,7 @@ protected:
      * @param ptsCountInEachScan construct how many correspondences in each scan
      * @return the point-to-surfel correspondences for each RGBD camera
      */
-    std::map<std::string, std::vector<PointToSurfelCorrPtr>> DataAssociationForRGBDs(
+    std::map<std::string, PointToSurfelCorrBufferPtr> DataAssociationForRGBDs(
         const IKalibrPointCloudPtr &map,
         const std::map<std::string, std::vector<IKalibrPointCloudPtr>> &scanInGFrame,
         const std::map<std::string, std::vector<IKalibrPointCloudPtr>> &scanInLFrame,
@@ -440,14 +644,133 @@ protected:
      */
     BackUp::Ptr BatchOptimization(
         OptOption optOption,
-        const std::map<std::string, std::vector<PointToSurfelCorrPtr>> &lidarPtsCorrs,
+        const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs,
         const std::map<std::string, std::vector<VisualReProjCorrSeqPtr>> &visualReprojCorrs,
         const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &rgbdCorrs,
         const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &visualVelCorrs,
         const std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> &eventCorrs,
-        const std::optional<std::map<std::string, std::vector<PointToSurfelCorrPtr>>>
+        const std::optional<std::map<std::string, PointToSurfelCorrBufferPtr>>
             &rgbdPtsCorrs = std::nullopt) const;
 
+    /**
+     * the joint batch optimization of multiple sessions, where factors of each session are added
+     * on its own splines (see 'Estimator::SwitchSplines') and calibration parameters are shared.
+     * The solver options, priori, and temporal paddings of the first session are used
+     * @param sessions the solvers of sessions
+     * @param optOption the optimization option
+     * @param corrs the correspondences of each session
+     * @return the solved joint estimator
+     */
+    static EstimatorPtr JointBatchOptimization(const std::vector<Ptr> &sessions,
+                                               OptOption optOption,
+                                               const std::vector<BatchOptCorrs> &corrs);
+
+    /**
+     * add factors of the batch optimization to the estimator, on the current splines of it
+     * @param visualGlobalScale the visual global scale of pos-cameras (if estimated)
+     * @param withRawMes whether raw measurements (imus and radars) are fused
+     */
+    void AddBatchOptFactors(
+        EstimatorPtr &estimator,
+        OptOption optOption,
+        const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs,
+        const std::map<std::string, std::vector<VisualReProjCorrSeqPtr>> &visualReprojCorrs,
+        const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &rgbdCorrs,
+        const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &visualVelCorrs,
+        const std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> &eventCorrs,
+        const std::optional<std::map<std::string, PointToSurfelCorrBufferPtr>> &rgbdPtsCorrs,
+        double *visualGlobalScale,
+        bool withRawMes) const;
+
+    /**
+     * update states out of the estimator (sfm poses and landmarks, depths) after a solved batch
+     * optimization
+     * @return the backup data from batch optimization
+     */
+    BackUp::Ptr UpdateByBatchOptimization(
+        const EstimatorPtr &estimator,
+        OptOption optOption,
+        const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs,
+        const std::map<std::string, std::vector<VisualReProjCorrSeqPtr>> &visualReprojCorrs,
+        const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &rgbdCorrs,
+        const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &visualVelCorrs,
+        const std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> &eventCorrs,
+        const std::shared_ptr<double> &visualGlobalScale) const;
+
+    /**
+     * the optimization option for a camera, where the readout time is not estimated if this
+     * camera is not a rolling shutter one
+     */
+    static OptOption RefineReadoutTimeOptForCameras(const std::string &topic, OptOption opt);
+
+    /**
+     * refit the splines if their knot distances differ from the scheduled ones
+     * @return true if the splines are refitted
+     */
+    bool RefitScheduledSplines(double so3Dt, double scaleDt);
+
+    /**
+     * perform data associations of all sensors before a batch optimization, independent ones are
+     * performed concurrently (see 'Configor::Preference::ConcurrentDataAssociation')
+     * @param optOption the option of the following batch optimization
+     * @param corrs the correspondences to be assigned
+     */
+    void BatchOptDataAssociation(OptOption optOption, BatchOptCorrs &corrs);
+
+    /**
+     * tasks after all batch optimizations, i.e., final lidar and radar maps, the sliding-window
+     * monitoring, and sfm structures in the viewer
+     * @param lastOption the option of the last batch optimization
+     */
+    void FinalizeBatchOptimizations(OptOption lastOption);
+
+    /**
+     * narrow paddings of time offsets and readout times estimated in the solved estimator, using
+     * their marginal standard deviations, where all other free parameter blocks are marginalized
+     * (see 'Configor::Preference::TemporalPaddingSigma')
+     */
+    void NarrowTemporalPaddings(const EstimatorPtr &estimator) const;
+
+    /**
+     * decompose the batch optimization into overlapping time windows, each with its own splines
+     * and copy of calibration parameters, which are solved in parallel and reconciled by the
+     * consensus admm on calibration parameters (see 'Configor::Preference::DecomposedWindowLength')
+     * only raw measurements (imus and radars) and lidar point-to-surfel correspondences are fused
+     * in windows, the reconciled parameters are refined in the following global batch optimization
+     * @param optOption the optimization option
+     * @param lidarPtsCorrs the point-to-surfel correspondences of lidars
+     * @param so3Dt the time distance between two rotation control points
+     * @param scaleDt the time distance between two linear scale control points
+     * @return true if the decomposition is performed
+     */
+    bool WindowedConsensusOptimization(
+        OptOption optOption,
+        const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs,
+        double so3Dt,
+        double scaleDt);
+
+    /**
+     * refine the calibration incrementally in consecutive sliding windows (see
+     * 'Configor::Preference::IncrementalWindowLength'), each with its own splines, where the
+     * knots (and other non-spatiotemporal parameters) of old windows are marginalized into a dense
+     * prior on extrinsics and time offsets. Drifts of spatiotemporal parameters w.r.t. the batch
+     * estimate are reported for each update, the batch estimate itself is not changed
+     * @param optOption the optimization option
+     * @param lidarPtsCorrs the point-to-surfel correspondences of lidars
+     */
+    void SlidingWindowRefinement(
+        OptOption optOption,
+        const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs) const;
+
+    /**
+     * add raw measurements (imus and radars) and lidar point-to-surfel correspondences to the
+     * estimator of a time window, whose splines cover the window only
+     */
+    void AddWindowFactors(
+        EstimatorPtr &estimator,
+        OptOption optOption,
+        const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs) const;
+
     /**
      * compute the pose of IMU in the global (world) coordinate frame
      * @param timeByBr the time stamped by the reference IMU
@@ -495,6 +818,23 @@ protected:
      */
     std::optional<Sophus::SE3d> CurRjToW(double timeByRj, const std::string &topic) const;
 
+    /**
+     * cursors for pose queries at sequential (monotonic) times, see 'PoseQueryCursor', which
+     * resolve the time offset and extrinsic of the sensor once, rather than for each query as the
+     * 'Cur**ToW' ones do. The batch variant 'PoseQueryCursor::QueryBatch' queries in parallel
+     */
+    [[nodiscard]] PoseQueryCursor BrToWCursor() const;
+
+    [[nodiscard]] PoseQueryCursor LkToWCursor(const std::string &topic) const;
+
+    [[nodiscard]] PoseQueryCursor CmToWCursor(const std::string &topic) const;
+
+    [[nodiscard]] PoseQueryCursor EsToWCursor(const std::string &topic) const;
+
+    [[nodiscard]] PoseQueryCursor DnToWCursor(const std::string &topic) const;
+
+    [[nodiscard]] PoseQueryCursor RjToWCursor(const std::string &topic) const;
+
     /**
      * create a spline bundle, including the rotation and linear scale splines
      * @param st the starr timestamp
@@ -508,6 +848,39 @@ protected:
                                                     double so3Dt,
                                                     double scaleDt);
 
+    /**
+     * create splines in the given time range with given knot distances, which are fitted to the
+     * current splines
+     * @param st the start timestamp
+     * @param et the end timestamp
+     * @param so3Dt the time distance between two rotation control points
+     * @param scaleDt the time distance between two linear scale control points
+     * @param threads the thread count used in fitting
+     * @return the fitted spline bundle
+     */
+    SplineBundleType::Ptr FitSplineBundle(double st,
+                                          double et,
+                                          double so3Dt,
+                                          double scaleDt,
+                                          int threads) const;
+
+    /**
+     * replace the splines by ones with given knot distances (knots are inserted or removed), which
+     * are fitted to the current splines
+     * @param so3Dt the time distance between two rotation control points
+     * @param scaleDt the time distance between two linear scale control points
+     */
+    void RefitSplineBundle(double so3Dt, double scaleDt);
+
+    /**
+     * the knot distances of the splines in the given batch optimization, coarse knots are used in
+     * early batch optimizations, see 'Configor::Prior::KnotTimeDist::CoarseToFineLevels'
+     * @param boIdx the index of the batch optimization
+     * @param boCount the count of batch optimizations
+     * @return the knot distances of the rotation and linear scale splines
+     */
+    static std::pair<double, double> ScheduledKnotTimeDist(int boIdx, int boCount);
+
     /**
      * get the type of the linear scale spline, it can be linear acceleration, linear velocity,
      * and translation spline, decided by the sensor suite to be calibrated
@@ -549,6 +922,23 @@ protected:
                        const std::string &imuTopic,
                        OptOption option) const;
 
+    /**
+     * add gyroscope factors of the given measurements (a subset of ones of this IMU) to the
+     * estimator
+     */
+    static void AddGyroFactor(EstimatorPtr &estimator,
+                              const std::string &imuTopic,
+                              const std::vector<IMUFrame::Ptr> &mes,
+                              OptOption option);
+
+    /**
+     * select at most 'budget' gyroscope measurements with the largest angular accelerations
+     * (central differences), which are most informative to time offsets and extrinsic rotations.
+     * The selected ones are kept in time order, and all are returned if the budget is zero
+     */
+    static std::vector<IMUFrame::Ptr> SelectInformativeGyroMes(
+        const std::vector<IMUFrame::Ptr> &mes, std::size_t budget);
+
     /**
      * add point-to-surfel factors for the LiDAR to the estimator
      * @tparam type the linear scale spline type
@@ -560,7 +950,7 @@ protected:
     template <TimeDeriv::ScaleSplineType type>
     static void AddLiDARPointToSurfelFactor(EstimatorPtr &estimator,
                                             const std::string &lidarTopic,
-                                            const std::vector<PointToSurfelCorrPtr> &corrs,
+                                            const PointToSurfelCorrBufferPtr &corrs,
                                             OptOption option);
 
     /**
@@ -574,7 +964,7 @@ protected:
     template <TimeDeriv::ScaleSplineType type>
     static void AddRGBDPointToSurfelFactor(EstimatorPtr &estimator,
                                            const std::string &rgbdTopic,
-                                           const std::vector<PointToSurfelCorrPtr> &corrs,
+                                           const PointToSurfelCorrBufferPtr &corrs,
                                            OptOption option);
 
     /**
@@ -593,6 +983,18 @@ protected:
                                             double *globalScale,
                                             OptOption option);
 
+    /**
+     * subsample the observations of visual reprojection sequences within a factor budget.
+     * observations in covisibility keyframes are kept first, the remaining budget is spent on
+     * observations evenly distributed along each track (temporal diversity for the time offset
+     * and the readout time), each track keeps at least its last observation
+     * @param corrs the visual reprojection sequences of a camera
+     * @param budget the max count of observations (factors), a zero one keeps all
+     * @return the subsampled sequences, which share the inverse depths with the input ones
+     */
+    static std::vector<VisualReProjCorrSeqPtr> SelectVisualReProjCorrs(
+        const std::vector<VisualReProjCorrSeqPtr> &corrs, std::size_t budget);
+
     /**
      * add optical flow factors for the RGBD camera to the estimator
      * @tparam type the linear scale spline type
@@ -686,6 +1088,42 @@ protected:
                                                 const std::vector<OpticalFlowCurveCorrPtr> &corrs,
                                                 OptOption option);
 
+    /**
+     * add optical flow factors and their reprojection factors for the optical camera to the
+     * estimator. If 'FuseOpticalFlowFactors' is enabled, the two factors of a correspondence are
+     * fused as one, otherwise, 'AddVisualOpticalFlowFactor' and 'AddVisualOpticalFlowReprojFactor'
+     * are called. The trifocal tensor constraint is involved if 'OpticalFlowTrifocalTensor' is
+     * enabled
+     * @tparam type the linear scale spline type
+     * @tparam IsInvDepth estimate the depth or the inverse depth
+     * @param estimator the estimator
+     * @param camTopic the ros topic of this camera
+     * @param corrs the optical flow correspondences
+     * @param option the option for the optimization
+     */
+    template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+    static void AddVisualOpticalFlowFusedFactor(EstimatorPtr &estimator,
+                                                const std::string &camTopic,
+                                                const std::vector<OpticalFlowCorrPtr> &corrs,
+                                                OptOption option);
+
+    // the rgbd counterpart of 'AddVisualOpticalFlowFusedFactor'
+    template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+    static void AddRGBDOpticalFlowFusedFactor(EstimatorPtr &estimator,
+                                              const std::string &rgbdTopic,
+                                              const std::vector<OpticalFlowCorrPtr> &corrs,
+                                              OptOption option);
+
+    /**
+     * run the feature tracking pipelines of cameras concurrently
+     * @param topics the ros topics of cameras
+     * @param pipeline the pipeline of a camera, which is called with the ros topic, the prefetch
+     * depth of frames, and whether to visualize the tracking
+     */
+    static void RunTrackingPipelines(
+        const std::vector<std::string> &topics,
+        const std::function<void(const std::string &, int, bool)> &pipeline);
+
     /**
      * store images to the disk for structure from motion (SfM)
      * @param camTopic the ros topic of this camera
@@ -731,7 +1169,8 @@ protected:
     static void SaveStageCalibParam(const CalibParamManagerPtr &par, const std::string &desc);
 
     /**
-     * create optical flow triple trace for RGBD cameras
+     * create optical flow triple trace for RGBD cameras, tracked features are processed in
+     * parallel, and traces are organized in order of features
      * @param trackInfoList the optical tracking information
      * @param trackThd the threshold of track length
      * @return the optical flow trace of this RGBD camera
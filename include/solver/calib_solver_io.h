@@ -37,6 +37,8 @@
 
 #include "util/cereal_archive_helper.hpp"
 #include "ctraj/core/pose.hpp"
+#include "sensor/imu.h"
+#include "list"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -46,6 +48,9 @@ namespace ns_ikalibr {
 class CalibSolver;
 
 using CalibSolverPtr = std::shared_ptr<CalibSolver>;
+class ColorizedCloudMap;
+using ColorizedCloudMapPtr = std::shared_ptr<ColorizedCloudMap>;
+struct ResidualStatistics;
 
 class CalibSolverIO {
 public:
@@ -93,6 +98,30 @@ protected:
                                  const std::string &filename,
                                  CerealArchiveType::Enum archiveType);
 
+    // columnar counterparts of the time-series outputs, used when 'IsColumnarOutput()'
+    static bool SavePoseSequenceColumnar(const Eigen::aligned_vector<ns_ctraj::Posed> &poseSeq,
+                                         const std::string &filename);
+
+    /**
+     * inertial measurement lists with the same size (thus row-aligned), are written in one file,
+     * columns are named by the given prefixes, e.g., 'raw_gyro_x' and 'est_acce_z'
+     */
+    static bool SaveInertialMesColumnar(
+        const std::vector<std::pair<std::string, const std::list<IMUFrame> *>> &mesLists,
+        const std::string &filename);
+
+    static bool SaveResidualsColumnar(const std::vector<double> &residuals,
+                                      const std::string &filename);
+
+    static bool SaveResidualsColumnar(const Eigen::aligned_vector<Eigen::Vector2d> &residuals,
+                                      const std::string &filename);
+
+    // the summary statistics and histogram of residuals, see 'ResidualStatistics'
+    static bool SaveResidualStatistics(const ResidualStatistics &stats,
+                                       const std::string &filename);
+
+    bool SaveColorizedMap(const ColorizedCloudMapPtr &shader, const std::string &filename) const;
+
     static bool TryCreatePath(const std::string &path);
 };
 }  // namespace ns_ikalibr
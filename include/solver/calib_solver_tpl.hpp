@@ -51,6 +51,10 @@ void CalibSolver::AddRadarFactor(Estimator::Ptr &estimator,
     double weight = Configor::DataStream::RadarTopics.at(radarTopic).Weight;
 
     for (const auto &targetAry : _dataMagr->GetRadarMeasurements(radarTopic)) {
+        if (Configor::Preference::BatchRadarFactors) {
+            estimator->AddRadarMeasurements<type>(targetAry, radarTopic, option, weight);
+            continue;
+        }
         for (const auto &tar : targetAry->GetTargets()) {
             estimator->AddRadarMeasurement<type>(tar, radarTopic, option, weight);
         }
@@ -63,6 +67,11 @@ void CalibSolver::AddAcceFactor(Estimator::Ptr &estimator,
                                 Estimator::Opt option) const {
     double weight = Configor::DataStream::IMUTopics.at(imuTopic).AcceWeight;
 
+    if (Configor::Preference::BatchInertialFactors) {
+        estimator->AddIMUAcceMeasurements<type>(_dataMagr->GetIMUMeasurements(imuTopic), imuTopic,
+                                                option, weight);
+        return;
+    }
     for (const auto &item : _dataMagr->GetIMUMeasurements(imuTopic)) {
         estimator->AddIMUAcceMeasurement<type>(item, imuTopic, option, weight);
     }
@@ -71,27 +80,21 @@ void CalibSolver::AddAcceFactor(Estimator::Ptr &estimator,
 template <TimeDeriv::ScaleSplineType type>
 void CalibSolver::AddLiDARPointToSurfelFactor(Estimator::Ptr &estimator,
                                               const std::string &lidarTopic,
-                                              const std::vector<PointToSurfelCorrPtr> &corrs,
+                                              const PointToSurfelCorrBufferPtr &corrs,
                                               Estimator::Opt option) {
     double weight = Configor::DataStream::LiDARTopics.at(lidarTopic).Weight;
-
-    for (const auto &corr : corrs) {
-        estimator->AddLiDARPointToSurfelConstraint<type>(corr, lidarTopic, option,
-                                                         weight * corr->weight);
-    }
+    // points are organized by surfels, weights of correspondences are multiplied inside
+    estimator->AddLiDARPointToSurfelConstraints<type>(*corrs, lidarTopic, option, weight);
 }
 
 template <TimeDeriv::ScaleSplineType type>
 void CalibSolver::AddRGBDPointToSurfelFactor(Estimator::Ptr &estimator,
                                              const std::string &rgbdTopic,
-                                             const std::vector<PointToSurfelCorrPtr> &corrs,
+                                             const PointToSurfelCorrBufferPtr &corrs,
                                              Estimator::Opt option) {
     double weight = Configor::DataStream::RGBDTopics.at(rgbdTopic).Weight;
-
-    for (const auto &corr : corrs) {
-        estimator->AddRGBDPointTiSurfelConstraint<type>(corr, rgbdTopic, option,
-                                                        weight * corr->weight);
-    }
+    // points are organized by surfels, weights of correspondences are multiplied inside
+    estimator->AddRGBDPointToSurfelConstraints<type>(*corrs, rgbdTopic, option, weight);
 }
 
 template <TimeDeriv::ScaleSplineType type>
@@ -102,7 +105,15 @@ void CalibSolver::AddVisualReprojectionFactor(Estimator::Ptr &estimator,
                                               Estimator::Opt option) {
     double weight = Configor::DataStream::CameraTopics.at(camTopic).Weight;
 
-    for (const auto &corr : corrs) {
+    // neighboring observations are nearly redundant, they are subsampled for long sequences
+    const auto selectedCorrs =
+        SelectVisualReProjCorrs(corrs, Configor::Prior::VisualReprojFactorBudget);
+    for (const auto &corr : selectedCorrs) {
+        if (Configor::Preference::BatchVisualReprojFactors) {
+            estimator->AddVisualReprojections<type>(corr->corrs, camTopic, globalScale,
+                                                    corr->invDepthFir.get(), option, weight);
+            continue;
+        }
         for (const auto &c : corr->corrs) {
             estimator->AddVisualReprojection<type>(
                 c, camTopic, globalScale, corr->invDepthFir.get(), option, weight * c->weight);
@@ -232,6 +243,53 @@ void CalibSolver::AddEventOpticalFlowReprojFactor(EstimatorPtr &estimator,
                                                                          weight * corr->weight);
     }
 }
+
+template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+void CalibSolver::AddVisualOpticalFlowFusedFactor(Estimator::Ptr &estimator,
+                                                  const std::string &camTopic,
+                                                  const std::vector<OpticalFlowCorr::Ptr> &corrs,
+                                                  Estimator::Opt option) {
+    if (!Configor::Preference::FuseOpticalFlowFactors) {
+        AddVisualOpticalFlowFactor<type, IsInvDepth>(estimator, camTopic, corrs, option);
+        AddVisualOpticalFlowReprojFactor<type, IsInvDepth>(estimator, camTopic, corrs, option);
+        if (Configor::Preference::OpticalFlowTrifocalTensor) {
+            AddVisualPPPTrifocalTensorFactor<type>(estimator, camTopic, corrs, option);
+        }
+        return;
+    }
+    /**
+     * weights are the same as the ones in 'AddVisualOpticalFlowFactor', its reprojection one and
+     * 'AddVisualPPPTrifocalTensorFactor'. The trifocal tensor reuses the relative poses of the
+     * reprojection, thus it is cheap to be involved
+     */
+    double weight = Configor::DataStream::CameraTopics.at(camTopic).Weight;
+    double trifocalWeight = Configor::Preference::OpticalFlowTrifocalTensor ? 1E5 * weight : 0.0;
+    for (const auto &corr : corrs) {
+        estimator->AddVisualOpticalFlowFusedConstraint<type, IsInvDepth>(
+            corr, camTopic, option, weight * corr->weight, 10.0 * weight * corr->weight,
+            trifocalWeight * corr->weight);
+    }
+}
+
+template <TimeDeriv::ScaleSplineType type, bool IsInvDepth>
+void CalibSolver::AddRGBDOpticalFlowFusedFactor(Estimator::Ptr &estimator,
+                                                const std::string &rgbdTopic,
+                                                const std::vector<OpticalFlowCorr::Ptr> &corrs,
+                                                Estimator::Opt option) {
+    if (!Configor::Preference::FuseOpticalFlowFactors) {
+        AddRGBDOpticalFlowFactor<type, IsInvDepth>(estimator, rgbdTopic, corrs, option);
+        AddRGBDOpticalFlowReprojFactor<type, IsInvDepth>(estimator, rgbdTopic, corrs, option);
+        return;
+    }
+    // weights are the same as the ones in 'AddVisualOpticalFlowFusedFactor'
+    double weight = Configor::DataStream::RGBDTopics.at(rgbdTopic).Weight;
+    double trifocalWeight = Configor::Preference::OpticalFlowTrifocalTensor ? 1E5 * weight : 0.0;
+    for (const auto &corr : corrs) {
+        estimator->AddRGBDOpticalFlowFusedConstraint<type, IsInvDepth>(
+            corr, rgbdTopic, option, weight * corr->weight, 10.0 * weight * corr->weight,
+            trifocalWeight * corr->weight);
+    }
+}
 }  // namespace ns_ikalibr
 
 #endif  // IKALIBR_CALIB_SOLVER_TPL_HPP
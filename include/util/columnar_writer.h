@@ -0,0 +1,113 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_COLUMNAR_WRITER_H
+#define IKALIBR_COLUMNAR_WRITER_H
+
+#include "fstream"
+#include "memory"
+#include "string"
+#include "vector"
+#include "cstdint"
+#include "util/utils.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * a dependency-free chunked typed-array writer for large time-series by-products. All columns
+ * are float64, rows are buffered and written block by block, each column of a block is stored
+ * contiguously and compressed losslessly (xor with the previous value, byte-plane transposition,
+ * and run-length encoding of zero bytes), which suits smooth series such as timestamps and
+ * poses. The layout (little-endian):
+ *   header: magic 'IKCOLUMN', uint32 version, uint32 column count, [uint32 length, name] ...
+ *   block:  uint64 row count, [uint8 codec, uint64 byte count, payload] for each column
+ * see 'script/columnar.py' for the reader
+ */
+class ColumnarWriter {
+public:
+    using Ptr = std::shared_ptr<ColumnarWriter>;
+
+    enum class Codec : std::uint8_t { RAW = 0, XOR_PLANE_RLE = 1 };
+
+    constexpr static std::uint32_t VERSION = 1;
+    // rows buffered in memory before a block is encoded and written
+    constexpr static std::size_t BLOCK_ROWS = 1 << 16;
+
+protected:
+    std::ofstream _file;
+    std::vector<std::string> _columns;
+    // column-major buffer of the current block
+    std::vector<std::vector<double>> _block;
+    std::size_t _rowCount;
+
+public:
+    ColumnarWriter(const std::string &filename, const std::vector<std::string> &columns);
+
+    static Ptr Create(const std::string &filename, const std::vector<std::string> &columns);
+
+    // buffered rows are flushed here
+    virtual ~ColumnarWriter();
+
+    [[nodiscard]] bool IsOpen() const;
+
+    [[nodiscard]] std::size_t RowCount() const;
+
+    /**
+     * append a row whose values are ordered as the columns, a block is written once it is full
+     */
+    void AppendRow(const std::vector<double> &row);
+
+    /**
+     * encode and write the buffered rows as a block
+     */
+    void Flush();
+
+    static std::string MagicHeader();
+
+protected:
+    // the payload of a column and the codec used for it, raw values are kept if not compressible
+    static std::pair<Codec, std::string> EncodeColumn(const std::vector<double> &values);
+
+    template <typename Type>
+    void Write(const Type &value) {
+        _file.write(reinterpret_cast<const char *>(&value), sizeof(Type));
+    }
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_COLUMNAR_WRITER_H
@@ -0,0 +1,106 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_FRAME_ENCODER_H
+#define IKALIBR_FRAME_ENCODER_H
+
+#include "util/utils.h"
+#include "opencv2/core.hpp"
+#include "deque"
+#include "mutex"
+#include "thread"
+#include "condition_variable"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * encode rendered frames in background threads, so that rendering is not blocked by encoding.
+ * Frames are either written as numbered png files by multiple workers in parallel, or piped (in
+ * order, by a single worker) to an 'ffmpeg' process as a video, which encodes it multithreaded.
+ * At most 'depth' frames wait in the queue, and 'Push' blocks once it is full, which bounds the
+ * memory when rendering is faster than encoding
+ */
+class FrameEncoder {
+public:
+    using Ptr = std::shared_ptr<FrameEncoder>;
+
+    enum class Format { PNG, VIDEO };
+
+private:
+    const std::string _outputDir;
+    const Format _format;
+    const int _depth;
+    const double _fps;
+
+    // frames waiting to be encoded, and their indices
+    std::deque<std::pair<int, cv::Mat>> _queue;
+    int _pushed;
+    int _failed;
+    bool _stop;
+    FILE *_pipe;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::vector<std::thread> _workers;
+
+public:
+    FrameEncoder(std::string outputDir, Format format, int workers, int depth, double fps);
+
+    static Ptr Create(
+        const std::string &outputDir, Format format, int workers, int depth, double fps = 25.0);
+
+    // block while the queue is full
+    void Push(cv::Mat frame);
+
+    /**
+     * wait for all pushed frames to be encoded, return the count of frames failed to be encoded
+     */
+    int Finish();
+
+    virtual ~FrameEncoder();
+
+    static std::string VideoFilename(const std::string &outputDir);
+
+protected:
+    void Encode();
+
+    // write a frame to the video pipe, which is opened by the first frame (for its size)
+    bool WriteVideoFrame(const cv::Mat &frame);
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_FRAME_ENCODER_H
@@ -0,0 +1,107 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_MEMORY_USAGE_HPP
+#define IKALIBR_MEMORY_USAGE_HPP
+
+#include "util/utils.h"
+#include "opencv2/core.hpp"
+#include "cstddef"
+#include "string"
+#include "vector"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief heap bytes held by data containers, which are used to size machines and find streams
+ * to be decimated. Allocator bookkeeping is not counted, buffers shared by several owners (e.g.,
+ * mats sharing data) are counted for each owner
+ */
+struct MemoryUsage {
+    // the control block of 'std::make_shared' (libstdc++): the vtable pointer, use and weak counts
+    static constexpr std::size_t SharedControlBlockBytes = sizeof(void *) + 2 * sizeof(int);
+
+    // bytes of the single allocation of 'std::make_shared<Type>', i.e., control block and object
+    template <typename Type>
+    static constexpr std::size_t MakeSharedBytes() {
+        constexpr std::size_t align = alignof(Type);
+        return (SharedControlBlockBytes + align - 1) / align * align + sizeof(Type);
+    }
+
+    // heap bytes of the buffer of the vector, the capacity slack included
+    template <typename Type, typename Alloc>
+    static std::size_t VectorBytes(const std::vector<Type, Alloc> &vec) {
+        return vec.capacity() * sizeof(Type);
+    }
+
+    // heap bytes of the mat data, zero if the data is not allocated by the mat (e.g., wrapped)
+    static std::size_t MatBytes(const cv::Mat &mat) {
+        return mat.u != nullptr ? sizeof(cv::UMatData) + mat.u->size : 0;
+    }
+
+    // heap bytes of a sequence of shared objects, whose own bytes are obtained by 'ElemBytes'
+    template <typename Type, typename ElemBytes>
+    static std::size_t SharedSeqBytes(const std::vector<std::shared_ptr<Type>> &seq,
+                                      const ElemBytes &elemBytes) {
+        std::size_t bytes = VectorBytes(seq);
+        for (const auto &elem : seq) {
+            if (elem != nullptr) {
+                bytes += elemBytes(elem);
+            }
+        }
+        return bytes;
+    }
+
+    static std::string Format(std::size_t bytes) {
+        constexpr double KB = 1024.0, MB = KB * 1024.0, GB = MB * 1024.0;
+        const auto b = static_cast<double>(bytes);
+        if (b >= GB) {
+            return fmt::format("{:.2f} GB", b / GB);
+        } else if (b >= MB) {
+            return fmt::format("{:.2f} MB", b / MB);
+        } else if (b >= KB) {
+            return fmt::format("{:.2f} KB", b / KB);
+        } else {
+            return fmt::format("{} B", bytes);
+        }
+    }
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_MEMORY_USAGE_HPP
@@ -0,0 +1,91 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_NUMA_H
+#define IKALIBR_NUMA_H
+
+#include "util/utils.h"
+#include "sched.h"
+#include "vector"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief the numa topology of the machine (parsed from '/sys/devices/system/node'), and helpers to
+ * place memory and threads on nodes without depending on libnuma. On machines with only one node
+ * (or if the topology is unavailable), all helpers do nothing
+ */
+class NUMATopology {
+public:
+    // cpus of each numa node
+    static const std::vector<std::vector<int>> &Nodes();
+
+    [[nodiscard]] static int NodeCount();
+
+    /**
+     * interleave pages allocated by the calling thread over all nodes. The policy is inherited by
+     * threads created afterwards (e.g., omp workers), so that data loaded by one thread does not
+     * land on a single node. Returns false if the policy is not applied
+     */
+    static bool InterleaveMemory();
+};
+
+/**
+ * @brief binds the calling thread to the cpus of a numa node till destructed, pages first touched
+ * by the thread in this duration are allocated on that node (the default local policy). A negative
+ * node (or a non-numa machine) binds nothing
+ */
+class NUMABinding {
+private:
+    cpu_set_t _origin;
+    bool _bound;
+
+public:
+    explicit NUMABinding(int node);
+
+    ~NUMABinding();
+
+    NUMABinding(const NUMABinding &) = delete;
+
+    NUMABinding &operator=(const NUMABinding &) = delete;
+
+    [[nodiscard]] bool IsBound() const;
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_NUMA_H
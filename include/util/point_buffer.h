@@ -0,0 +1,105 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_POINT_BUFFER_H
+#define IKALIBR_POINT_BUFFER_H
+
+#include "util/cloud_define.hpp"
+#include "sophus/se3.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * a structure-of-arrays buffer of 'IKalibrPoint' for the internal lidar pipeline. Coordinates are
+ * stored row by row (x, y, and z rows are contiguous and aligned), thus the kernels below are
+ * coefficient-wise Eigen expressions, which are vectorized (SSE/AVX/NEON) by the compiler flags.
+ * The layout (width and height) of the pcl cloud is kept for the conversion back
+ */
+class PointBuffer {
+public:
+    using Coords = Eigen::Matrix<float, 3, Eigen::Dynamic, Eigen::RowMajor>;
+    using Times = Eigen::Array<double, 1, Eigen::Dynamic>;
+    using Mask = Eigen::Array<bool, 1, Eigen::Dynamic>;
+    using VoxelKeys = Eigen::Array<int, 3, Eigen::Dynamic, Eigen::RowMajor>;
+
+protected:
+    Coords _xyz;
+    Times _timestamps;
+    std::uint32_t _width;
+    std::uint32_t _height;
+
+public:
+    PointBuffer();
+
+    explicit PointBuffer(const IKalibrPointCloud &cloud);
+
+    /**
+     * convert back to the pcl type, the layout is kept if the buffer is not compacted by 'Select'
+     */
+    [[nodiscard]] IKalibrPointCloud::Ptr ToCloud() const;
+
+    [[nodiscard]] Eigen::Index Size() const;
+
+    [[nodiscard]] const Coords &GetCoords() const;
+
+    [[nodiscard]] const Times &GetTimestamps() const;
+
+    /**
+     * transform points in place, nan points stay nan
+     */
+    PointBuffer &Transform(const Sophus::SE3f &trans);
+
+    /**
+     * points which are not nan, and whose ranges are in [minRange, maxRange]
+     */
+    [[nodiscard]] Mask ValidMask(float minRange = 0.0f,
+                                 float maxRange = std::numeric_limits<float>::max()) const;
+
+    /**
+     * keep the points selected by the mask, the buffer becomes unorganized
+     */
+    [[nodiscard]] PointBuffer Select(const Mask &mask) const;
+
+    /**
+     * the voxel indices of points, i.e., floor(p / voxelSize), which is undefined for nan points
+     */
+    [[nodiscard]] VoxelKeys ComputeVoxelKeys(float voxelSize) const;
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_POINT_BUFFER_H
@@ -0,0 +1,125 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_PROGRESS_H
+#define IKALIBR_PROGRESS_H
+
+#include "util/utils.h"
+#include "atomic"
+#include "memory"
+#include "string"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief a stage of work whose progress is reported by the 'ProgressMonitor'. Counters are atomic,
+ * thus a stage could be stepped by any thread (e.g., in omp parallel regions), and stepping only
+ * costs a relaxed atomic operation, no formatting or printing happens on the calling thread
+ */
+class ProgressStage {
+public:
+    using Ptr = std::shared_ptr<ProgressStage>;
+
+    // the state shared with the monitor, which outlives the stage until it is reported
+    struct State {
+        std::string label;
+        std::atomic_long current, total;
+        std::atomic_bool finished;
+        // seconds (steady clock)
+        double startTime;
+    };
+
+private:
+    std::shared_ptr<State> _state;
+
+public:
+    explicit ProgressStage(const std::string &label, long total = 0);
+
+    // register a stage to the monitor, 'total' could be zero if it is unknown yet
+    static Ptr Create(const std::string &label, long total = 0);
+
+    ~ProgressStage();
+
+    ProgressStage(const ProgressStage &) = delete;
+
+    ProgressStage &operator=(const ProgressStage &) = delete;
+
+    // thread-safe
+    void Step(long count = 1) { _state->current.fetch_add(count, std::memory_order_relaxed); }
+
+    // thread-safe, the counterpart of 'tqdm::progress(curr, tot)'
+    void Progress(long current, long total) {
+        _state->total.store(total, std::memory_order_relaxed);
+        _state->current.store(current, std::memory_order_relaxed);
+    }
+
+    void SetTotal(long total) { _state->total.store(total, std::memory_order_relaxed); }
+
+    // report the final state of this stage immediately, stepping after finishing is ignored
+    void Finish();
+};
+
+/**
+ * @brief the reporter of all active progress stages, which runs in a background thread and
+ * redraws on a timer: stages running concurrently are aggregated into a single line, which is
+ * redrawn in place on terminals ('BAR'), or printed as a structured log line periodically when the
+ * output is redirected, e.g., to a file ('LOG')
+ */
+class ProgressMonitor {
+public:
+    enum class Mode { AUTO, BAR, LOG, NONE };
+
+public:
+    // 'AUTO' by default, i.e., 'BAR' if the stdout is a terminal, otherwise 'LOG'
+    static void SetMode(Mode mode);
+
+    // periods (seconds) of redrawing in the 'BAR' mode and of logging in the 'LOG' mode
+    static void SetPeriods(double redrawPeriod, double logPeriod);
+
+protected:
+    friend class ProgressStage;
+
+    static void Register(const std::shared_ptr<ProgressStage::State> &state);
+
+    // report immediately, called when a stage finishes
+    static void Report();
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_PROGRESS_H
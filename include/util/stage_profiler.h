@@ -0,0 +1,156 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_STAGE_PROFILER_H
+#define IKALIBR_STAGE_PROFILER_H
+
+#include "util/utils.h"
+#include "util/trace_recorder.h"
+#include "cereal/cereal.hpp"
+#include "chrono"
+#include "mutex"
+#include "optional"
+#include "string"
+#include "vector"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief hierarchical stage timing of the calibration. A stage is profiled by a 'Scope' (raii),
+ * nested scopes form stage paths, e.g., 'Process/Initialization/InitSO3Spline'. Scopes opened in
+ * worker threads (concurrent stages) are nested into the innermost stage of the main thread. The
+ * wall time, the cpu time of the process, the thread utilization (cpu time over wall time of all
+ * hardware threads), and the peak resident memory are accumulated for each stage path, which are
+ * reported in a json file, e.g., 'ikalibr_stages.json' next to 'ikalibr_param'
+ */
+class StageProfiler {
+public:
+    struct Record {
+    public:
+        std::string stage;
+        int depth;
+        int count;
+        // seconds
+        double wallTime, cpuTime;
+        // cpu time over wall time of all hardware threads
+        double threadUtilization;
+        // the peak (till the end of the stage) and the current resident memory, in MB
+        double peakRSS, curRSS;
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            ar(CEREAL_NVP(stage), CEREAL_NVP(depth), CEREAL_NVP(count), CEREAL_NVP(wallTime),
+               CEREAL_NVP(cpuTime), CEREAL_NVP(threadUtilization), CEREAL_NVP(peakRSS),
+               CEREAL_NVP(curRSS));
+        }
+    };
+
+    // an accumulated quantity of the calibration, e.g., the number of residual blocks of a factor
+    struct Counter {
+    public:
+        std::string name;
+        double value;
+
+    public:
+        template <class Archive>
+        void serialize(Archive &ar) {
+            ar(CEREAL_NVP(name), CEREAL_NVP(value));
+        }
+    };
+
+    // a saved report, see 'SaveReport'
+    struct Report {
+    public:
+        int hardwareThreads;
+        std::vector<Record> stages;
+        std::vector<Counter> counters;
+    };
+
+    class Scope {
+    private:
+        std::string _path;
+        std::chrono::steady_clock::time_point _wallStart;
+        double _cpuStart;
+        // stages are traced as well if the trace recorder is enabled
+        TraceRecorder::Span _span;
+
+    public:
+        explicit Scope(const std::string &stage);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+    };
+
+public:
+    // clear all records, e.g., before a new calibration
+    static void Reset();
+
+    // records in the order of first profiled
+    static std::vector<Record> Records();
+
+    // the path of the innermost stage of this thread (or the hosting one for worker threads)
+    static std::string CurrentStage();
+
+    // accumulate the value of the counter, which is created if it does not exist
+    static void Count(const std::string &name, double value);
+
+    // counters in the order of first counted
+    static std::vector<Counter> Counters();
+
+    static bool SaveReport(const std::string &filename);
+
+    // load a saved report, reports saved without counters are supported as well
+    static std::optional<Report> LoadReport(const std::string &filename);
+
+protected:
+    static void Accumulate(const std::string &path, double wallTime, double cpuTime);
+
+    // the cpu time (s) consumed by all threads of this process
+    static double ProcessCPUTime();
+
+    // the peak and current resident memory (MB) of this process
+    static std::pair<double, double> ResidentMemory();
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_STAGE_PROFILER_H
@@ -0,0 +1,193 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_STREAMING_PCD_WRITER_HPP
+#define IKALIBR_STREAMING_PCD_WRITER_HPP
+
+#include "util/utils.h"
+#include "pcl/common/io.h"
+#include "pcl/point_cloud.h"
+#include "fstream"
+#include "sstream"
+#include "iomanip"
+#include "cstring"
+#include "unordered_set"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * write a (possibly huge) point cloud to a binary pcd file chunk by chunk, so that the whole cloud
+ * never needs to be kept in memory. Nan points are dropped, and if the voxel size is positive, only
+ * the first point of each voxel is written (on-the-fly downsampling, whose memory only depends on
+ * the count of occupied voxels). Counts in the header are reserved in fixed width and patched
+ * when the writer is closed. Note that 'binary_compressed' pcd stores a single compressed block,
+ * which can not be streamed, thus the plain 'binary' layout is used here
+ */
+template <typename PointType>
+class StreamingPCDWriter {
+public:
+    using Ptr = std::shared_ptr<StreamingPCDWriter>;
+
+protected:
+    std::ofstream _file;
+    std::string _filename;
+    std::vector<pcl::PCLPointField> _fields;
+    std::size_t _pointSize;
+    std::size_t _count;
+
+    float _voxelSize;
+    std::unordered_set<std::uint64_t> _occupied;
+
+    std::streampos _widthPos, _pointsPos;
+    std::vector<char> _buffer;
+
+public:
+    explicit StreamingPCDWriter(const std::string &filename, float voxelSize = 0.0f)
+        : _file(filename, std::ios::out | std::ios::binary),
+          _filename(filename),
+          _fields(pcl::getFields<PointType>()),
+          _pointSize(0),
+          _count(0),
+          _voxelSize(voxelSize),
+          _widthPos(),
+          _pointsPos() {
+        // padding fields ('_') are not written
+        _fields.erase(std::remove_if(_fields.begin(), _fields.end(),
+                                     [](const auto &field) { return field.name == "_"; }),
+                      _fields.end());
+        for (const auto &field : _fields) {
+            _pointSize += field.count * pcl::getFieldSize(field.datatype);
+        }
+        if (_file.is_open()) {
+            WriteHeader();
+        }
+    }
+
+    static Ptr Create(const std::string &filename, float voxelSize = 0.0f) {
+        return std::make_shared<StreamingPCDWriter>(filename, voxelSize);
+    }
+
+    virtual ~StreamingPCDWriter() { Close(); }
+
+    [[nodiscard]] bool IsOpen() const { return _file.is_open(); }
+
+    [[nodiscard]] std::size_t Count() const { return _count; }
+
+    [[nodiscard]] const std::string &GetFilename() const { return _filename; }
+
+    /**
+     * append a chunk (e.g., a scan) to the file, this is not thread-safe
+     */
+    void Append(const pcl::PointCloud<PointType> &chunk) {
+        if (!IsOpen()) {
+            return;
+        }
+        _buffer.resize(chunk.size() * _pointSize);
+        std::size_t written = 0;
+        for (const auto &p : chunk.points) {
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+                continue;
+            }
+            if (_voxelSize > 0.0f && !_occupied.insert(VoxelKey(p)).second) {
+                continue;
+            }
+            char *dst = _buffer.data() + written * _pointSize;
+            for (const auto &field : _fields) {
+                const std::size_t size = field.count * pcl::getFieldSize(field.datatype);
+                std::memcpy(dst, reinterpret_cast<const char *>(&p) + field.offset, size);
+                dst += size;
+            }
+            ++written;
+        }
+        _file.write(_buffer.data(), static_cast<std::streamsize>(written * _pointSize));
+        _count += written;
+    }
+
+    /**
+     * patch the point counts in the header and close the file, return false if failed
+     */
+    bool Close() {
+        if (!IsOpen()) {
+            return false;
+        }
+        _file.seekp(_widthPos);
+        _file << FixedWidthCount(_count);
+        _file.seekp(_pointsPos);
+        _file << FixedWidthCount(_count);
+        const bool good = _file.good();
+        _file.close();
+        _occupied.clear();
+        return good;
+    }
+
+protected:
+    void WriteHeader() {
+        std::stringstream names, sizes, types, counts;
+        for (const auto &field : _fields) {
+            names << ' ' << field.name;
+            sizes << ' ' << pcl::getFieldSize(field.datatype);
+            types << ' ' << pcl::getFieldType(field.datatype);
+            counts << ' ' << field.count;
+        }
+        _file << "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\n";
+        _file << "FIELDS" << names.str() << "\nSIZE" << sizes.str() << "\nTYPE" << types.str()
+              << "\nCOUNT" << counts.str() << '\n';
+        _file << "WIDTH ";
+        _widthPos = _file.tellp();
+        _file << FixedWidthCount(0) << "\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS ";
+        _pointsPos = _file.tellp();
+        _file << FixedWidthCount(0) << "\nDATA binary\n";
+    }
+
+    static std::string FixedWidthCount(std::size_t count) {
+        std::stringstream stream;
+        stream << std::setw(20) << std::setfill('0') << count;
+        return stream.str();
+    }
+
+    [[nodiscard]] std::uint64_t VoxelKey(const PointType &p) const {
+        // 21 bits for each axis
+        auto key = [this](float v) {
+            auto idx = static_cast<std::int64_t>(std::floor(v / _voxelSize));
+            return static_cast<std::uint64_t>(idx) & 0x1FFFFF;
+        };
+        return key(p.x) | (key(p.y) << 21) | (key(p.z) << 42);
+    }
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_STREAMING_PCD_WRITER_HPP
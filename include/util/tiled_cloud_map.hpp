@@ -0,0 +1,404 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_TILED_CLOUD_MAP_HPP
+#define IKALIBR_TILED_CLOUD_MAP_HPP
+
+#include "util/utils.h"
+#include "pcl/point_cloud.h"
+#include "pcl/conversions.h"
+#include "pcl/io/pcd_io.h"
+#include "pcl/filters/voxel_grid.h"
+#include "spdlog/spdlog.h"
+#include "filesystem"
+#include "fstream"
+#include "sstream"
+#include "functional"
+#include "map"
+#include "algorithm"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * an out-of-core tiled pyramid of a (possibly huge) point cloud map. The map is cut into square
+ * tiles on the x-y plane, each of which is stored as binary pcd files in several levels of detail
+ * (lod), where the leaf size of level 'l' is that of level 0 times '2^l'. The pyramid is built once
+ * by streaming the source pcd file (only a chunk of it and a tile are kept in memory at a time),
+ * then tiles are loaded on demand, e.g., the ones near the camera of a viewer at fine levels, and
+ * the far ones at coarse levels. Note that this is a quadtree on the x-y plane rather than an
+ * octree, as maps are commonly flat, and tiles are filtered by their z ranges instead
+ */
+template <typename PointType>
+class TiledCloudMap {
+public:
+    using Ptr = std::shared_ptr<TiledCloudMap>;
+    using PointCloud = pcl::PointCloud<PointType>;
+    using TileKey = std::pair<int, int>;
+
+    struct Tile {
+        // points in level 0
+        std::size_t count;
+        float minZ;
+        float maxZ;
+    };
+
+    // points read from the source pcd file at a time when building
+    constexpr static std::size_t CHUNK_POINTS = 1 << 20;
+
+protected:
+    std::string _dir;
+    float _tileSize;
+    int _levels;
+    std::map<TileKey, Tile> _tiles;
+
+public:
+    TiledCloudMap(std::string dir, float tileSize, int levels, std::map<TileKey, Tile> tiles)
+        : _dir(std::move(dir)),
+          _tileSize(tileSize),
+          _levels(levels),
+          _tiles(std::move(tiles)) {}
+
+    static std::string IndexFilename(const std::string &dir) { return dir + "/index.txt"; }
+
+    /**
+     * whether the tiled map in 'dir' is missing or older than the source pcd file
+     */
+    static bool IsOutdated(const std::string &pcdFile, const std::string &dir) {
+        const auto index = IndexFilename(dir);
+        if (!std::filesystem::exists(index)) {
+            return true;
+        }
+        // the source pcd file could be removed once the tiled map is built
+        return std::filesystem::exists(pcdFile) && std::filesystem::last_write_time(index) <
+                                                       std::filesystem::last_write_time(pcdFile);
+    }
+
+    /**
+     * load the index of a built tiled map, tiles themselves are loaded by 'LoadTile'
+     */
+    static Ptr Load(const std::string &dir) {
+        std::ifstream file(IndexFilename(dir));
+        std::string magic;
+        float tileSize;
+        int levels;
+        if (!std::getline(file, magic) || magic != MagicHeader() || !(file >> tileSize >> levels)) {
+            spdlog::warn("load tiled map index from '{}' failed!", IndexFilename(dir));
+            return nullptr;
+        }
+        std::map<TileKey, Tile> tiles;
+        int ix, iy;
+        Tile tile{};
+        while (file >> ix >> iy >> tile.count >> tile.minZ >> tile.maxZ) {
+            tiles.insert({{ix, iy}, tile});
+        }
+        return std::make_shared<TiledCloudMap>(dir, tileSize, levels, tiles);
+    }
+
+    /**
+     * build the tiled map of 'pcdFile' in 'dir'. Level 0 is downsampled by 'leafSize' (if it is
+     * non-positive, all points are kept and coarser levels start from 'tileSize / 256')
+     */
+    static Ptr Build(const std::string &pcdFile,
+                     const std::string &dir,
+                     float tileSize,
+                     float leafSize,
+                     int levels) {
+        if (tileSize <= 0.0f || levels < 1) {
+            spdlog::warn("wrong tile size '{:.3f}' or level count '{}' is set!", tileSize, levels);
+            return nullptr;
+        }
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+
+        // the first pass: split points into spill files of tiles
+        std::map<TileKey, Tile> tiles;
+        std::map<TileKey, PointCloud> buckets;
+        bool streamed = ForEachChunk(pcdFile, [&](const PointCloud &chunk) {
+            for (const auto &p : chunk.points) {
+                if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+                    continue;
+                }
+                TileKey key{static_cast<int>(std::floor(p.x / tileSize)),
+                            static_cast<int>(std::floor(p.y / tileSize))};
+                buckets[key].push_back(p);
+                auto iter = tiles.insert({key, Tile{0, p.z, p.z}}).first;
+                iter->second.minZ = std::min(iter->second.minZ, p.z);
+                iter->second.maxZ = std::max(iter->second.maxZ, p.z);
+            }
+            for (auto &[key, bucket] : buckets) {
+                std::ofstream file(SpillFilename(dir, key),
+                                   std::ios::out | std::ios::binary | std::ios::app);
+                file.write(reinterpret_cast<const char *>(bucket.points.data()),
+                           static_cast<std::streamsize>(bucket.size() * sizeof(PointType)));
+            }
+            buckets.clear();
+        });
+        if (!streamed) {
+            return nullptr;
+        }
+
+        // the second pass: build the levels of each tile, tiles are independent
+        std::vector<std::pair<TileKey, Tile *>> tileVec;
+        for (auto &[key, tile] : tiles) {
+            tileVec.emplace_back(key, &tile);
+        }
+        const float lodLeafSize = leafSize > 0.0f ? leafSize : tileSize / 256.0f;
+#pragma omp parallel for schedule(dynamic)
+        for (int i = 0; i < static_cast<int>(tileVec.size()); ++i) {
+            const auto &[key, tile] = tileVec.at(i);
+            const auto spill = SpillFilename(dir, key);
+            typename PointCloud::Ptr cloud(new PointCloud);
+            cloud->resize(std::filesystem::file_size(spill) / sizeof(PointType));
+            {
+                std::ifstream file(spill, std::ios::in | std::ios::binary);
+                file.read(reinterpret_cast<char *>(cloud->points.data()),
+                          static_cast<std::streamsize>(cloud->size() * sizeof(PointType)));
+            }
+            std::filesystem::remove(spill);
+
+            for (int level = 0; level < levels; ++level) {
+                if (level > 0 || leafSize > 0.0f) {
+                    const float leaf = lodLeafSize * static_cast<float>(1 << level);
+                    typename PointCloud::Ptr downSampled(new PointCloud);
+                    pcl::VoxelGrid<PointType> filter;
+                    filter.setInputCloud(cloud);
+                    filter.setLeafSize(leaf, leaf, leaf);
+                    filter.filter(*downSampled);
+                    // each level is downsampled from the previous one, which is smaller
+                    cloud = downSampled;
+                }
+                if (level == 0) {
+                    tile->count = cloud->size();
+                }
+                pcl::io::savePCDFileBinary(TileFilename(dir, key, level), *cloud);
+            }
+        }
+
+        std::ofstream file(IndexFilename(dir));
+        file << MagicHeader() << '\n' << tileSize << ' ' << levels << '\n';
+        for (const auto &[key, tile] : tiles) {
+            file << key.first << ' ' << key.second << ' ' << tile.count << ' ' << tile.minZ << ' '
+                 << tile.maxZ << '\n';
+        }
+        if (!file.good()) {
+            spdlog::warn("write tiled map index to '{}' failed!", IndexFilename(dir));
+            return nullptr;
+        }
+        return std::make_shared<TiledCloudMap>(dir, tileSize, levels, tiles);
+    }
+
+    [[nodiscard]] const std::map<TileKey, Tile> &GetTiles() const { return _tiles; }
+
+    [[nodiscard]] float GetTileSize() const { return _tileSize; }
+
+    [[nodiscard]] int GetLevels() const { return _levels; }
+
+    /**
+     * tiles whose centers are within 'range' (all tiles if it is non-positive) of 'eye' on the x-y
+     * plane, and their levels, the level increases by one each time the distance doubles (starting
+     * from one tile size)
+     */
+    [[nodiscard]] std::map<TileKey, int> VisibleTiles(const Eigen::Vector3f &eye,
+                                                      float range) const {
+        std::map<TileKey, int> visible;
+        for (const auto &[key, tile] : _tiles) {
+            const float dx = (static_cast<float>(key.first) + 0.5f) * _tileSize - eye(0);
+            const float dy = (static_cast<float>(key.second) + 0.5f) * _tileSize - eye(1);
+            const float dist = std::sqrt(dx * dx + dy * dy);
+            if (range > 0.0f && dist > range) {
+                continue;
+            }
+            int level = 0;
+            if (dist > _tileSize) {
+                level = static_cast<int>(std::floor(std::log2(dist / _tileSize))) + 1;
+            }
+            visible.insert({key, std::min(level, _levels - 1)});
+        }
+        return visible;
+    }
+
+    /**
+     * load a tile at the given level, points out of the z range are filtered. The file is not read
+     * at all if the whole tile is out of the range
+     */
+    [[nodiscard]] typename PointCloud::Ptr LoadTile(const TileKey &key,
+                                                    int level,
+                                                    float minZ,
+                                                    float maxZ) const {
+        typename PointCloud::Ptr cloud(new PointCloud);
+        auto iter = _tiles.find(key);
+        if (iter == _tiles.cend() || iter->second.maxZ < minZ || iter->second.minZ > maxZ) {
+            return cloud;
+        }
+        const auto filename = TileFilename(_dir, key, std::clamp(level, 0, _levels - 1));
+        if (pcl::io::loadPCDFile(filename, *cloud) == -1) {
+            spdlog::warn("load tile from '{}' failed!", filename);
+            cloud->clear();
+            return cloud;
+        }
+        if (iter->second.minZ < minZ || iter->second.maxZ > maxZ) {
+            cloud->erase(std::remove_if(cloud->begin(), cloud->end(),
+                                        [minZ, maxZ](const PointType &p) {
+                                            return p.z < minZ || p.z > maxZ;
+                                        }),
+                         cloud->end());
+        }
+        return cloud;
+    }
+
+    static std::string MagicHeader() { return "# iKalibr tiled cloud map v1"; }
+
+protected:
+    static std::string TileFilename(const std::string &dir, const TileKey &key, int level) {
+        std::stringstream stream;
+        stream << dir << "/tile_" << key.first << '_' << key.second << "_l" << level << ".pcd";
+        return stream.str();
+    }
+
+    static std::string SpillFilename(const std::string &dir, const TileKey &key) {
+        std::stringstream stream;
+        stream << dir << "/tile_" << key.first << '_' << key.second << ".spill";
+        return stream.str();
+    }
+
+    /**
+     * read a pcd file chunk by chunk, 'binary' pcd files (e.g., the ones written by
+     * 'StreamingPCDWriter') are streamed, while others ('ascii' and 'binary_compressed') can only
+     * be loaded as a whole
+     */
+    static bool ForEachChunk(const std::string &pcdFile,
+                             const std::function<void(const PointCloud &)> &handler) {
+        std::ifstream file(pcdFile, std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            spdlog::warn("open pcd file '{}' failed!", pcdFile);
+            return false;
+        }
+        std::vector<std::string> names, types;
+        std::vector<int> sizes, counts;
+        std::size_t points = 0;
+        std::string line, data;
+        while (data.empty() && std::getline(file, line)) {
+            std::stringstream stream(line);
+            std::string entry;
+            stream >> entry;
+            if (entry == "FIELDS") {
+                for (std::string v; stream >> v;) {
+                    names.push_back(v);
+                }
+            } else if (entry == "SIZE") {
+                for (int v; stream >> v;) {
+                    sizes.push_back(v);
+                }
+            } else if (entry == "TYPE") {
+                for (std::string v; stream >> v;) {
+                    types.push_back(v);
+                }
+            } else if (entry == "COUNT") {
+                for (int v; stream >> v;) {
+                    counts.push_back(v);
+                }
+            } else if (entry == "POINTS") {
+                stream >> points;
+            } else if (entry == "DATA") {
+                stream >> data;
+            }
+        }
+        if (counts.empty()) {
+            counts.resize(names.size(), 1);
+        }
+        if (data != "binary" || sizes.size() != names.size() || types.size() != names.size() ||
+            counts.size() != names.size()) {
+            spdlog::info("pcd file '{}' can not be streamed, load it as a whole...", pcdFile);
+            PointCloud cloud;
+            if (pcl::io::loadPCDFile(pcdFile, cloud) == -1) {
+                spdlog::warn("load pcd file from '{}' failed!", pcdFile);
+                return false;
+            }
+            handler(cloud);
+            return true;
+        }
+
+        pcl::PCLPointCloud2 blob;
+        std::uint32_t offset = 0;
+        for (int i = 0; i < static_cast<int>(names.size()); ++i) {
+            pcl::PCLPointField field;
+            field.name = names.at(i);
+            field.offset = offset;
+            field.datatype = FieldDatatype(types.at(i).front(), sizes.at(i));
+            field.count = counts.at(i);
+            blob.fields.push_back(field);
+            offset += sizes.at(i) * counts.at(i);
+        }
+        blob.point_step = offset;
+        blob.height = 1;
+        blob.is_dense = false;
+
+        PointCloud chunk;
+        for (std::size_t read = 0; read < points;) {
+            const std::size_t num = std::min(CHUNK_POINTS, points - read);
+            blob.width = static_cast<std::uint32_t>(num);
+            blob.row_step = blob.point_step * blob.width;
+            blob.data.resize(blob.row_step);
+            if (!file.read(reinterpret_cast<char *>(blob.data.data()), blob.row_step)) {
+                spdlog::warn("pcd file '{}' is truncated!", pcdFile);
+                return false;
+            }
+            pcl::fromPCLPointCloud2(blob, chunk);
+            handler(chunk);
+            read += num;
+        }
+        return true;
+    }
+
+    static std::uint8_t FieldDatatype(char type, int size) {
+        switch (type) {
+            case 'I':
+                return size == 1   ? pcl::PCLPointField::INT8
+                       : size == 2 ? pcl::PCLPointField::INT16
+                                   : pcl::PCLPointField::INT32;
+            case 'U':
+                return size == 1   ? pcl::PCLPointField::UINT8
+                       : size == 2 ? pcl::PCLPointField::UINT16
+                                   : pcl::PCLPointField::UINT32;
+            default:
+                return size == 8 ? pcl::PCLPointField::FLOAT64 : pcl::PCLPointField::FLOAT32;
+        }
+    }
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_TILED_CLOUD_MAP_HPP
@@ -0,0 +1,107 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_TRACE_RECORDER_H
+#define IKALIBR_TRACE_RECORDER_H
+
+#include "util/utils.h"
+#include "atomic"
+#include "cstdint"
+#include "string"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * @brief an optional recorder of trace events, which are saved in the chrome trace-event json
+ * format (could be opened by 'chrome://tracing' or 'ui.perfetto.dev') to inspect the concurrency
+ * and stalls of the pipeline. Events are buffered per thread, thus recording is lock-free across
+ * threads. When the recorder is disabled, a span costs one relaxed atomic load
+ */
+class TraceRecorder {
+public:
+    // a complete event ('X') spanning the lifetime of this object
+    class Span {
+    private:
+        bool _active;
+        const char *_category;
+        std::string _name;
+        std::int64_t _start;
+
+    public:
+        Span(const char *category, const char *name);
+
+        Span(const char *category, const std::string &name);
+
+        ~Span();
+
+        Span(const Span &) = delete;
+
+        Span &operator=(const Span &) = delete;
+    };
+
+private:
+    static std::atomic_bool _enabled;
+
+public:
+    // clear recorded events and enable recording
+    static void Start();
+
+    // disable recording, recorded events are kept until the next start
+    static void Stop();
+
+    static bool IsEnabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    // save recorded events to the json file
+    static bool Save(const std::string &filename);
+
+    // record a complete event whose time span is already known, times are in microseconds
+    static void Complete(const char *category,
+                         const std::string &name,
+                         std::int64_t start,
+                         std::int64_t duration);
+
+    // record a counter event ('C'), e.g., the cost of the solving
+    static void Counter(const char *category, const std::string &name, double value);
+
+    // the monotonic time in microseconds, which is the time base of events
+    static std::int64_t NowMicros();
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_TRACE_RECORDER_H
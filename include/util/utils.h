@@ -62,6 +62,10 @@ namespace ns_ikalibr {
 // config the 'spdlog' log pattern
 void ConfigSpdlog();
 
+// replace the default logger by an asynchronous one with the same sinks, whose messages are queued
+// (the oldest ones are overwritten if the queue is full) and written by a background thread
+void ConfigAsyncSpdlog(std::size_t queueSize);
+
 void PrintIKalibrLibInfo();
 
 // given n points and a x value, compute the y value using lagrange polynomial
@@ -184,6 +188,43 @@ std::vector<ElemType> SamplingWoutReplace2(std::default_random_engine &engine,
                                            const std::vector<ElemType> &dataVec,
                                            std::size_t num);
 
+/**
+ * @brief the counter-based (Philox-2x64-10) random number, i.e., the 'counter'-th number of the
+ * stream 'stream' under the key 'seed'. It is stateless, thus numbers do not depend on the order
+ * they are drawn in, and streams could be sampled in parallel reproducibly
+ */
+std::uint64_t CounterBasedRandom(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter);
+
+/**
+ * @brief sampling indices of [0, size) without replacement using the counter-based stream
+ *
+ * @param seed the key of the counter-based random numbers
+ * @param stream the stream, e.g., the index of the group to be sampled
+ * @param size the size of the pool
+ * @param num the num of the samples to sampling
+ * @return std::vector<std::size_t>
+ */
+std::vector<std::size_t> SamplingWoutReplace(std::uint64_t seed,
+                                             std::uint64_t stream,
+                                             std::size_t size,
+                                             std::size_t num);
+
+/**
+ * @brief sampling the samples without replacement using the counter-based stream
+ *
+ * @tparam ElemType the element type
+ * @param seed the key of the counter-based random numbers
+ * @param stream the stream, e.g., the index of the group to be sampled
+ * @param dataVec the data vector
+ * @param num the num of the samples to sampling
+ * @return std::vector<ElemType>
+ */
+template <typename ElemType>
+std::vector<ElemType> SamplingWoutReplace2(std::uint64_t seed,
+                                           std::uint64_t stream,
+                                           const std::vector<ElemType> &dataVec,
+                                           std::size_t num);
+
 /**
  * @brief sampling the samples with replacement
  *
@@ -140,6 +140,29 @@ std::vector<ElemType> SamplingWoutReplace2(std::default_random_engine &engine,
     return samples;
 }
 
+/**
+ * @brief sampling the samples without replacement using the counter-based stream
+ *
+ * @tparam ElemType the element type
+ * @param seed the key of the counter-based random numbers
+ * @param stream the stream, e.g., the index of the group to be sampled
+ * @param dataVec the data vector
+ * @param num the num of the samples to sampling
+ * @return std::vector<ElemType>
+ */
+template <typename ElemType>
+std::vector<ElemType> SamplingWoutReplace2(std::uint64_t seed,
+                                           std::uint64_t stream,
+                                           const std::vector<ElemType> &dataVec,
+                                           std::size_t num) {
+    std::vector<std::size_t> res = SamplingWoutReplace(seed, stream, dataVec.size(), num);
+    std::vector<ElemType> samples(num);
+    for (int i = 0; i != static_cast<int>(num); ++i) {
+        samples.at(i) = dataVec.at(res.at(i));
+    }
+    return samples;
+}
+
 /**
  * @brief sampling the samples with replacement
  *
@@ -0,0 +1,109 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_OFFSCREEN_RENDERER_H
+#define IKALIBR_OFFSCREEN_RENDERER_H
+
+#include "tiny-viewer/entity/entity.h"
+#include "tiny-viewer/core/pose.hpp"
+#include "util/utils.h"
+#include "opencv2/core.hpp"
+#include "map"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * render entities without any window (e.g., on a headless machine) into an egl pbuffer, as fast
+ * as the gpu allows. Like 'ns_viewer::MultiViewer', entities are added to named views, which are
+ * laid out as square cells in rows (row-major, from the top left), and each view is rendered from
+ * its own camera pose, which is in the right-down-forward convention. This requires the library to
+ * be built with egl ('IKALIBR_WITH_EGL'), otherwise the renderer is always invalid
+ */
+class OffscreenRenderer {
+public:
+    using Ptr = std::shared_ptr<OffscreenRenderer>;
+
+    // the focal length of cameras, as a multiple of the cell size
+    constexpr static float FOCAL_SCALE = 0.65f;
+
+protected:
+    std::vector<std::string> _views;
+    int _cols, _rows, _cellSize;
+    float _near, _far;
+
+    // egl handles, kept opaque here
+    void *_display, *_surface, *_context;
+
+    // entities of each view, with their ids
+    std::map<std::string, std::map<std::size_t, ns_viewer::Entity::Ptr>> _entities;
+    std::size_t _nextId;
+
+public:
+    OffscreenRenderer(std::vector<std::string> views,
+                      int cols,
+                      int cellSize,
+                      float near = 0.1f,
+                      float far = 1000.0f);
+
+    static Ptr Create(const std::vector<std::string> &views,
+                      int cols,
+                      int cellSize,
+                      float near = 0.1f,
+                      float far = 1000.0f);
+
+    virtual ~OffscreenRenderer();
+
+    [[nodiscard]] bool IsValid() const;
+
+    std::size_t AddEntity(const ns_viewer::Entity::Ptr &entity, const std::string &view);
+
+    std::vector<std::size_t> AddEntity(const std::vector<ns_viewer::Entity::Ptr> &entities,
+                                       const std::string &view);
+
+    void RemoveEntity(const std::vector<std::size_t> &ids, const std::string &view);
+
+    /**
+     * render all views into a bgr image, views without camera poses are left blank
+     */
+    cv::Mat Render(const std::map<std::string, ns_viewer::Posef> &camPoses);
+
+protected:
+    bool InitContext();
+};
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_OFFSCREEN_RENDERER_H
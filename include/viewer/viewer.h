@@ -43,6 +43,10 @@
 #include "util/cloud_define.hpp"
 #include "veta/veta.h"
 #include "ufo/map/surfel_map.h"
+#include "mutex"
+#include "fstream"
+#include "list"
+#include "functional"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -57,8 +61,8 @@ namespace ns_ikalibr {
 struct CalibParamManager;
 using CalibParamManagerPtr = std::shared_ptr<CalibParamManager>;
 struct PointToSurfelCondition;
-struct PointToSurfelCorr;
-using PointToSurfelCorrPtr = std::shared_ptr<PointToSurfelCorr>;
+struct PointToSurfelCorrBuffer;
+using PointToSurfelCorrBufferPtr = std::shared_ptr<PointToSurfelCorrBuffer>;
 struct RGBDFrame;
 using RGBDFramePtr = std::shared_ptr<RGBDFrame>;
 struct RGBDIntrinsics;
@@ -68,6 +72,7 @@ using FeaturePtr = std::shared_ptr<Feature>;
 using FeatureVec = std::vector<FeaturePtr>;
 struct EventArray;
 using EventArrayPtr = std::shared_ptr<EventArray>;
+class EventArraySpan;
 
 class Viewer : public ns_viewer::MultiViewer {
 public:
@@ -83,11 +88,54 @@ private:
     SplineBundleType::Ptr _splines;
 
     std::map<std::string, std::vector<std::size_t>> _entities;
+    // entities may be added concurrently, e.g., by data associations of different sensors
+    std::mutex _entitiesMutex;
+    // serializes the clear-and-add of the sensor and spline views, and guards the revision, which
+    // is increased by every direct update so that older snapshots would not overwrite newer views
+    std::mutex _updateMutex;
+    std::uint64_t _revision;
+
+    /**
+     * in the headless mode, the window is not run and all viewer calls return immediately (no
+     * entity is created), in the record mode, the window is not run either, while the viewer
+     * commands are recorded to 'OutputPath/viewer_commands.bin', which could be replayed later
+     */
+    ViewerModeType _mode;
+    std::shared_ptr<std::ofstream> _recorder;
+
+    // entities created from the same (hashed) content are reused rather than recreated, so that
+    // unchanged geometry keeps its gpu buffers across clear-and-add cycles, in the lru order
+    std::list<std::pair<std::size_t, std::vector<ns_viewer::Entity::Ptr>>> _entityCache;
+    std::mutex _entityCacheMutex;
+
+    enum class Command : std::uint8_t { ADD, CLEAR, POP_BACK };
 
 public:
-    explicit Viewer(CalibParamManagerPtr parMagr, SplineBundleType::Ptr splines);
+    // an immutable copy of the bound splines and parameters, taken at a revision of the viewer
+    struct Snapshot {
+        using Ptr = std::shared_ptr<Snapshot>;
 
-    static Ptr Create(const CalibParamManagerPtr &parMagr, const SplineBundleType::Ptr &splines);
+        SplineBundleType::Ptr splines;
+        CalibParamManagerPtr parMagr;
+        std::uint64_t revision;
+    };
+
+public:
+    explicit Viewer(CalibParamManagerPtr parMagr,
+                    SplineBundleType::Ptr splines,
+                    ViewerModeType mode = Configor::Preference::ViewerMode);
+
+    static Ptr Create(const CalibParamManagerPtr &parMagr,
+                      const SplineBundleType::Ptr &splines,
+                      ViewerModeType mode = Configor::Preference::ViewerMode);
+
+    // replay the recorded viewer commands in a window, 'interval' (s) is waited between commands
+    static void Replay(const std::string &filename, double interval = 0.05);
+
+    [[nodiscard]] bool IsHeadless() const;
+
+    // hides the one of 'MultiViewer', the window is inactive if it is not run
+    bool IsActive();
 
     Viewer &FillEmptyViews(const std::string &objPath);
 
@@ -95,6 +143,13 @@ public:
 
     Viewer &UpdateSplineViewer(double dt = 0.005);
 
+    // copy the bound splines and parameters, which could then be rendered by another thread
+    Snapshot::Ptr TakeSnapshot();
+
+    // update the sensor and spline views using the snapshot, returns false (nothing is rendered) if
+    // views have been directly updated after the snapshot was taken
+    bool UpdateFromSnapshot(const Snapshot::Ptr &snapshot, double dt = 0.005);
+
     Viewer &AddAlignedCloud(const IKalibrPointCloud::Ptr &cloud,
                             const std::string &view,
                             const Eigen::Vector3f &dir = {0, 0, 1},
@@ -122,7 +177,7 @@ public:
                          const std::string &view);
 
     Viewer &AddPointToSurfel(const ufo::map::SurfelMap &smp,
-                             const std::map<std::string, std::vector<PointToSurfelCorrPtr>> &corrs,
+                             const std::map<std::string, PointToSurfelCorrBufferPtr> &corrs,
                              const std::string &view);
 
     ns_viewer::Entity::Ptr Gravity() const;
@@ -171,6 +226,11 @@ public:
                          const std::string &view,
                          const std::pair<float, float> &ptScales = {0.01f, 2.0f});
 
+    Viewer &AddEventData(const EventArraySpan &span,
+                         float sTime,
+                         const std::string &view,
+                         const std::pair<float, float> &ptScales = {0.01f, 2.0f});
+
     Viewer &AddEventData(const EventArrayPtr &ary,
                          float sTime,
                          const std::string &view,
@@ -180,6 +240,21 @@ public:
 protected:
     ns_viewer::MultiViewerConfigor GenViewerConfigor();
 
+    static std::vector<ns_viewer::Entity::Ptr> SplineEntities(const SplineBundleType::Ptr &splines,
+                                                              const CalibParamManagerPtr &parMagr,
+                                                              double dt);
+
+    static ns_viewer::Entity::Ptr Gravity(const CalibParamManagerPtr &parMagr);
+
+    // return the cached entities of the content hash, or create (and cache) them
+    std::vector<ns_viewer::Entity::Ptr> CachedEntities(
+        std::size_t hash, const std::function<std::vector<ns_viewer::Entity::Ptr>()> &creator);
+
+    // the entities mutex should be locked by the caller
+    void Record(Command command,
+                const std::string &view,
+                const std::vector<ns_viewer::Entity::Ptr> &entities = {});
+
     void ZoomInSplineCallBack();
 
     void ZoomOutSplineCallBack();
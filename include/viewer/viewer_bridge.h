@@ -0,0 +1,108 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_VIEWER_BRIDGE_H
+#define IKALIBR_VIEWER_BRIDGE_H
+
+#include "viewer/viewer.h"
+#include "thread"
+#include "condition_variable"
+#include "atomic"
+#include "chrono"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+/**
+ * an asynchronous bridge between solvers and the viewer: solvers publish immutable snapshots
+ * (splines, parameters, and scans) into a double buffer, i.e., the pending one and the one being
+ * rendered, which is consumed by the bridge thread at a capped rate (see
+ * 'Configor::Preference::ViewerMaxFPS'). The latest snapshot wins, older pending ones are dropped,
+ * so that solver threads never block on rendering
+ */
+class ViewerBridge {
+public:
+    using Ptr = std::shared_ptr<ViewerBridge>;
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Viewer::Ptr _viewer;
+
+    // the pending buffer, guarded by '_mutex'
+    Viewer::Snapshot::Ptr _snapshot;
+    std::map<std::string, IKalibrPointCloud::Ptr> _scans;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+
+    // held by the bridge thread while a snapshot is rendered
+    std::mutex _renderMutex;
+
+    // the time at which the last snapshot was taken, to skip copies that would never be rendered
+    Clock::time_point _lastPublish;
+    const Clock::duration _period;
+
+    std::atomic_bool _stop;
+    std::thread _thread;
+
+public:
+    explicit ViewerBridge(Viewer::Ptr viewer, double maxFPS = Configor::Preference::ViewerMaxFPS);
+
+    static Ptr Create(const Viewer::Ptr &viewer,
+                      double maxFPS = Configor::Preference::ViewerMaxFPS);
+
+    virtual ~ViewerBridge();
+
+    // snapshot the splines and parameters bound to the viewer, which is skipped if the last one
+    // was taken within a frame period
+    void Publish();
+
+    // the latest scan of each view is kept, which is rendered as an aligned cloud
+    void PublishScan(const std::string &view, const IKalibrPointCloud::Ptr &scan);
+
+    // drop the pending scan of the view, and clear the view once the current rendering is done
+    void DropScans(const std::string &view);
+
+    // stop the bridge thread, pending snapshots are dropped, and nothing would be published later
+    void Stop();
+
+protected:
+    void Run();
+};
+
+}  // namespace ns_ikalibr
+
+#endif  // IKALIBR_VIEWER_BRIDGE_H
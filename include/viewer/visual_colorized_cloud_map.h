@@ -41,6 +41,7 @@
 #include "veta/camera/pinhole.h"
 #include "opencv2/core.hpp"
 #include "util/cloud_define.hpp"
+#include "functional"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -60,6 +61,8 @@ class ColorizedCloudMap {
 public:
     using Ptr = std::shared_ptr<ColorizedCloudMap>;
     using SplineBundleType = ns_ctraj::SplineBundle<Configor::Prior::SplineOrder>;
+    // map points are colorized chunk by chunk, which bounds the thread-local accumulators
+    constexpr static int COLORIZE_CHUNK_SIZE = 1 << 16;
 
 private:
     std::string _topic;
@@ -98,6 +101,14 @@ public:
 
     ColorPointCloud::Ptr Colorize(const IKalibrPointCloud::Ptr &cloudMap, int K = 5);
 
+    /**
+     * the streaming version, each colorized chunk (ordered as the map) is passed to the handler,
+     * thus the whole colorized map is not required to be kept in memory
+     */
+    void Colorize(const IKalibrPointCloud::Ptr &cloudMap,
+                  const std::function<void(const ColorPointCloud &)> &handler,
+                  int K = 5);
+
 protected:
     std::optional<Sophus::SE3d> CurCmToW(double timeByCm);
 
@@ -38,18 +38,36 @@
 #include "veta/camera/pinhole.h"
 #include "opencv2/core.hpp"
 #include "util/cloud_define.hpp"
+#include "array"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
 namespace ns_ikalibr {
+/**
+ * project the lidar map into cameras to obtain (inverse) depth images. The map is reordered into
+ * an octree with bounding boxes of nodes, where nodes out of the camera frustum are culled before
+ * projection, thus only the visible part of a large map is transformed for a frame
+ */
 class VisualLiDARCovisibility {
 public:
     using Ptr = std::shared_ptr<VisualLiDARCovisibility>;
 
+    struct Node {
+        // the point range of this node (including its children) in the reordered points
+        std::size_t offset, count;
+        Eigen::AlignedBox3f box;
+        std::array<int, 8> children;
+    };
+
+    // the maximum point count of leaf nodes, and the maximum depth of the octree
+    constexpr static std::size_t LEAF_CAPACITY = 4096;
+    constexpr static int MAX_DEPTH = 16;
+
 private:
-    IKalibrPointCloud::Ptr _cloudMap;
+    Eigen::aligned_vector<Eigen::Vector3f> _points;
+    std::vector<Node> _nodes;
 
 public:
     explicit VisualLiDARCovisibility(IKalibrPointCloud::Ptr cloudMap);
@@ -60,6 +78,9 @@ public:
                                                    const ns_veta::PinholeIntrinsic::Ptr &intri,
                                                    float zMin = 0.1f,
                                                    float zMax = 80.0f);
+
+protected:
+    int BuildNode(std::size_t begin, std::size_t end, int depth);
 };
 }  // namespace ns_ikalibr
 
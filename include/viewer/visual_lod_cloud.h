@@ -0,0 +1,146 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef IKALIBR_VISUAL_LOD_CLOUD_H
+#define IKALIBR_VISUAL_LOD_CLOUD_H
+
+#include "tiny-viewer/entity/entity.h"
+#include "util/cloud_define.hpp"
+#include "util/utils.h"
+#include "cereal/types/vector.hpp"
+#include "mutex"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_viewer {
+
+/**
+ * a level-of-detail point cloud for large maps. Points are reordered into an octree, where each
+ * node keeps a grid-sampled subset of its points (the others are passed to its children), thus a
+ * node together with its ancestors gives a uniform density of the node spacing. In drawing, nodes
+ * out of the view frustum are culled, and nodes are refined only if their spacing projected on the
+ * screen is larger than 'Configor::Preference::LODScreenSpaceError' (px), until the per-frame
+ * point budget is reached. Points of drawn nodes are kept in gpu buffers, which are evicted by the
+ * least recently used order when the gpu point budget is exceeded
+ */
+struct LODCloud : public Entity {
+public:
+    using Ptr = std::shared_ptr<LODCloud>;
+
+    struct Point {
+        float x, y, z;
+        std::uint8_t r, g, b, a;
+
+        template <class Archive>
+        void serialize(Archive &archive) {
+            archive(x, y, z, r, g, b, a);
+        }
+    };
+
+    struct Node {
+        // the point range of this node in the reordered points
+        std::size_t offset, count;
+        Eigen::Vector3f center;
+        float halfSize, spacing;
+        std::array<int, 8> children;
+    };
+
+    // the grid resolution of node sampling, and the maximum point count of leaf nodes
+    constexpr static int NODE_GRID_RES = 64;
+    constexpr static std::size_t LEAF_CAPACITY = 1 << 15;
+    // the maximum count of nodes uploaded in one frame, to keep the frame rate consistent
+    constexpr static int MAX_UPLOADS_PER_FRAME = 32;
+    // the gpu point budget, as a multiple of the per-frame point budget
+    constexpr static std::size_t GPU_BUDGET_SCALE = 4;
+
+protected:
+    std::vector<Point> points;
+    std::vector<Node> nodes;
+    float size{};
+
+    // gpu buffers of nodes (node index, {buffer, last drawn frame}), only touched in drawing
+    mutable std::map<int, std::pair<unsigned int, std::size_t>> buffers;
+    mutable std::size_t bufferedPoints = 0, frame = 0;
+
+public:
+    LODCloud(const IKalibrPointCloud::Ptr &inputCloud, const Colour &color, float size);
+
+    static Ptr Create(const IKalibrPointCloud::Ptr &cloud,
+                      const Colour &color,
+                      float size = DefaultPointSize);
+
+    ~LODCloud() override;
+
+    void Draw() const override;
+
+    LODCloud() = default;
+
+    [[nodiscard]] std::size_t GetPointCount() const { return points.size(); }
+
+protected:
+    // reorder points and build the octree
+    void Build();
+
+    int BuildNode(std::size_t begin,
+                  std::size_t end,
+                  const Eigen::Vector3f &center,
+                  float halfSize,
+                  int depth);
+
+    // buffers could only be deleted in the rendering thread (the one owning the gl context), thus
+    // buffers of destroyed clouds are deferred to the next drawing of any cloud
+    static std::vector<unsigned int> &ReleasedBuffers();
+
+    static std::mutex &ReleasedBuffersMutex();
+
+    void ReleaseBuffer(int nodeIdx) const;
+
+public:
+    template <class Archive>
+    void serialize(Archive &archive) {
+        Entity::serialize(archive);
+        archive(cereal::make_nvp("points", points), CEREAL_NVP(size));
+        if constexpr (Archive::is_loading::value) {
+            Build();
+        }
+    }
+};
+}  // namespace ns_viewer
+
+CEREAL_REGISTER_TYPE_WITH_NAME(ns_viewer::LODCloud, "LODCloud")
+CEREAL_REGISTER_POLYMORPHIC_RELATION(ns_viewer::Entity, ns_viewer::LODCloud)
+
+#endif  // IKALIBR_VISUAL_LOD_CLOUD_H
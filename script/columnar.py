@@ -0,0 +1,101 @@
+#  iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+#  Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+#  https://github.com/Unsigned-Long/iKalibr.git
+#
+#  Author: Shuolong Chen (shlchen@whu.edu.cn)
+#  GitHub: https://github.com/Unsigned-Long
+#   ORCID: 0000-0002-5283-9057
+#
+#  Purpose: See .h/.hpp file.
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions are met:
+#
+#  * Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#  * The names of its contributors can not be
+#    used to endorse or promote products derived from this software without
+#    specific prior written permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+#  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+#  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+#  ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+#  LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+#  CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+#  SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+#  INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+#  CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+#  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+#  POSSIBILITY OF SUCH DAMAGE.
+
+import struct
+import sys
+
+import numpy as np
+
+
+# reader of the columnar time-series files ('.ikc') written by 'ns_ikalibr::ColumnarWriter'
+def decode_column(codec, payload, rows):
+    if codec == 0:
+        return np.frombuffer(payload, dtype='<f8', count=rows)
+    # run-length decoding of zero bytes
+    planes = bytearray()
+    i = 0
+    while i < len(payload):
+        byte = payload[i]
+        i += 1
+        if byte != 0:
+            planes.append(byte)
+            continue
+        run, shift = 0, 0
+        while True:
+            v = payload[i]
+            i += 1
+            run |= (v & 0x7F) << shift
+            shift += 7
+            if v & 0x80 == 0:
+                break
+        planes.extend(b'\x00' * run)
+    # byte planes from the most significant one, then the inverse of the xor with previous value
+    planes = np.frombuffer(bytes(planes), dtype=np.uint8).reshape(8, rows).astype(np.uint64)
+    bits = np.zeros(rows, dtype=np.uint64)
+    for p in range(8):
+        bits |= planes[p] << np.uint64(8 * (7 - p))
+    bits = np.bitwise_xor.accumulate(bits)
+    return bits.view('<f8')
+
+
+def read_columnar(filename):
+    with open(filename, 'rb') as file:
+        content = file.read()
+    if content[:8] != b'IKCOLUMN':
+        raise ValueError("'{}' is not a columnar file of iKalibr".format(filename))
+    version, col_count = struct.unpack_from('<II', content, 8)
+    offset = 16
+    names = []
+    for _ in range(col_count):
+        (length,) = struct.unpack_from('<I', content, offset)
+        offset += 4
+        names.append(content[offset:offset + length].decode())
+        offset += length
+    columns = [[] for _ in range(col_count)]
+    while offset < len(content):
+        (rows,) = struct.unpack_from('<Q', content, offset)
+        offset += 8
+        for c in range(col_count):
+            codec, size = struct.unpack_from('<BQ', content, offset)
+            offset += 9
+            columns[c].append(decode_column(codec, content[offset:offset + size], rows))
+            offset += size
+    return {name: (np.concatenate(col) if col else np.empty(0)) for name, col in
+            zip(names, columns)}
+
+
+if __name__ == '__main__':
+    data = read_columnar(sys.argv[1])
+    for key, value in data.items():
+        print('{}: {} values, [{}, {}]'.format(key, len(value), value.min(), value.max()))
@@ -0,0 +1,247 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/batch_opt_problem.h"
+#include "calib/estimator_tpl.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+const std::string BatchOptProblem::IMU_GYRO_GROUP = "IMU_GYRO";
+const std::string BatchOptProblem::IMU_ACCE_GROUP = "IMU_ACCE";
+const std::string BatchOptProblem::RADAR_GROUP = "RADAR";
+const std::string BatchOptProblem::LIDAR_PTS_TO_SURFEL_GROUP = "LIDAR_PTS_TO_SURFEL";
+const std::string BatchOptProblem::RGBD_PTS_TO_SURFEL_GROUP = "RGBD_PTS_TO_SURFEL";
+const std::string BatchOptProblem::VISUAL_REPROJ_GROUP = "VISUAL_REPROJ";
+const std::string BatchOptProblem::RGBD_OPTICAL_FLOW_GROUP = "RGBD_OPTICAL_FLOW";
+const std::string BatchOptProblem::RGBD_OPTICAL_FLOW_REPROJ_GROUP = "RGBD_OPTICAL_FLOW_REPROJ";
+const std::string BatchOptProblem::VISUAL_OPTICAL_FLOW_GROUP = "VISUAL_OPTICAL_FLOW";
+const std::string BatchOptProblem::VISUAL_OPTICAL_FLOW_REPROJ_GROUP = "VISUAL_OPTICAL_FLOW_REPROJ";
+
+const std::vector<std::string> BatchOptProblem::FACTOR_GROUPS = {
+    IMU_GYRO_GROUP,
+    IMU_ACCE_GROUP,
+    RADAR_GROUP,
+    LIDAR_PTS_TO_SURFEL_GROUP,
+    RGBD_PTS_TO_SURFEL_GROUP,
+    VISUAL_REPROJ_GROUP,
+    RGBD_OPTICAL_FLOW_GROUP,
+    RGBD_OPTICAL_FLOW_REPROJ_GROUP,
+    VISUAL_OPTICAL_FLOW_GROUP,
+    VISUAL_OPTICAL_FLOW_REPROJ_GROUP,
+};
+
+BatchOptProblem::BatchOptProblem(OptOption optOption,
+                                 TimeDeriv::ScaleSplineType scaleType,
+                                 SplineBundleType::Ptr splines,
+                                 CalibParamManager::Ptr parMagr)
+    : optOption(optOption),
+      scaleType(scaleType),
+      splines(std::move(splines)),
+      parMagr(std::move(parMagr)),
+      _visualGlobalScale(std::make_shared<double>(1.0)) {}
+
+BatchOptProblem::BatchOptProblem()
+    : _visualGlobalScale(std::make_shared<double>(1.0)) {}
+
+BatchOptProblem::Ptr BatchOptProblem::Create(OptOption optOption,
+                                             TimeDeriv::ScaleSplineType scaleType,
+                                             const SplineBundleType::Ptr &splines,
+                                             const CalibParamManager::Ptr &parMagr) {
+    return std::make_shared<BatchOptProblem>(optOption, scaleType, splines, parMagr);
+}
+
+void BatchOptProblem::Save(const std::string &filename, CerealArchiveType::Enum archiveType) const {
+    std::ofstream file(filename, std::ios::out | std::ios::binary);
+    auto ar = GetOutputArchiveVariant(file, archiveType);
+    SerializeByOutputArchiveVariant(ar, archiveType, cereal::make_nvp("BatchOptProblem", *this));
+}
+
+BatchOptProblem::Ptr BatchOptProblem::Load(const std::string &filename,
+                                           CerealArchiveType::Enum archiveType) {
+    auto problem = std::make_shared<BatchOptProblem>();
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        throw Status(Status::ERROR, "can not open the batch optimization problem file '{}'!!!",
+                     filename);
+    }
+    auto ar = GetInputArchiveVariant(file, archiveType);
+    SerializeByInputArchiveVariant(ar, archiveType, cereal::make_nvp("BatchOptProblem", *problem));
+    return problem;
+}
+
+Estimator::Ptr BatchOptProblem::BuildEstimator(const ceres::Problem::Options &options) {
+    auto estimator = Estimator::Create(splines, parMagr, options);
+    if (IsOptionWith(OutputOption::FactorProfiles, Configor::Preference::Outputs)) {
+        estimator->EnableFactorProfiler();
+    }
+    *_visualGlobalScale = 1.0;
+
+    // keep consistent with the batch optimization in 'CalibSolver::BatchOptimization'
+    switch (scaleType) {
+        case TimeDeriv::LIN_ACCE_SPLINE:
+            AddFactors<TimeDeriv::LIN_ACCE_SPLINE>(estimator);
+            break;
+        case TimeDeriv::LIN_VEL_SPLINE:
+            AddFactors<TimeDeriv::LIN_VEL_SPLINE>(estimator);
+            break;
+        case TimeDeriv::LIN_POS_SPLINE:
+            AddFactors<TimeDeriv::LIN_POS_SPLINE>(estimator);
+            break;
+    }
+    estimator->SetResidualGroup("");
+
+    // make this problem full rank
+    estimator->SetRefIMUParamsConstant();
+    return estimator;
+}
+
+template <TimeDeriv::ScaleSplineType type>
+void BatchOptProblem::AddFactors(Estimator::Ptr &estimator) const {
+    constexpr bool OPTICAL_FLOW_EST_INV_DEPTH = true;
+
+    // raw measurements
+    estimator->SetResidualGroup(IMU_ACCE_GROUP);
+    for (const auto &[topic, frames] : imuMes) {
+        double weight = Configor::DataStream::IMUTopics.at(topic).AcceWeight;
+        if (Configor::Preference::BatchInertialFactors) {
+            estimator->AddIMUAcceMeasurements<type>(frames, topic, optOption, weight);
+        } else {
+            for (const auto &frame : frames) {
+                estimator->AddIMUAcceMeasurement<type>(frame, topic, optOption, weight);
+            }
+        }
+    }
+    estimator->SetResidualGroup(IMU_GYRO_GROUP);
+    for (const auto &[topic, frames] : imuMes) {
+        double weight = Configor::DataStream::IMUTopics.at(topic).GyroWeight;
+        if (Configor::Preference::BatchInertialFactors) {
+            estimator->AddIMUGyroMeasurements(frames, topic, optOption, weight);
+        } else {
+            for (const auto &frame : frames) {
+                estimator->AddIMUGyroMeasurement(frame, topic, optOption, weight);
+            }
+        }
+    }
+    if constexpr (type == TimeDeriv::LIN_ACCE_SPLINE) {
+        // only imus are involved for the linear acceleration spline
+        return;
+    }
+    estimator->SetResidualGroup(RADAR_GROUP);
+    for (const auto &[topic, arrays] : radarMes) {
+        double weight = Configor::DataStream::RadarTopics.at(topic).Weight;
+        for (const auto &targetAry : arrays) {
+            if (Configor::Preference::BatchRadarFactors) {
+                estimator->AddRadarMeasurements<type>(targetAry, topic, optOption, weight);
+                continue;
+            }
+            for (const auto &tar : targetAry->GetTargets()) {
+                estimator->AddRadarMeasurement<type>(tar, topic, optOption, weight);
+            }
+        }
+    }
+
+    // correspondences of rgbds and velocity cameras (optical flow)
+    for (const auto &[topic, corrs] : rgbdCorrs) {
+        double weight = Configor::DataStream::RGBDTopics.at(topic).Weight;
+        const auto opt = CameraOptOption(topic);
+        estimator->SetResidualGroup(RGBD_OPTICAL_FLOW_GROUP);
+        for (const auto &corr : corrs) {
+            estimator->AddRGBDOpticalFlowConstraint<type, OPTICAL_FLOW_EST_INV_DEPTH>(
+                corr, topic, opt, weight * corr->weight);
+        }
+        estimator->SetResidualGroup(RGBD_OPTICAL_FLOW_REPROJ_GROUP);
+        for (const auto &corr : corrs) {
+            estimator->AddRGBDOpticalFlowReprojConstraint<type, OPTICAL_FLOW_EST_INV_DEPTH>(
+                corr, topic, opt, 10.0 * weight * corr->weight);
+        }
+    }
+    for (const auto &[topic, corrs] : visualVelCorrs) {
+        double weight = Configor::DataStream::CameraTopics.at(topic).Weight;
+        const auto opt = CameraOptOption(topic);
+        estimator->SetResidualGroup(VISUAL_OPTICAL_FLOW_GROUP);
+        for (const auto &corr : corrs) {
+            estimator->AddVisualOpticalFlowConstraint<type, OPTICAL_FLOW_EST_INV_DEPTH>(
+                corr, topic, opt, weight * corr->weight);
+        }
+        estimator->SetResidualGroup(VISUAL_OPTICAL_FLOW_REPROJ_GROUP);
+        for (const auto &corr : corrs) {
+            estimator->AddVisualOpticalFlowReprojConstraint<type, OPTICAL_FLOW_EST_INV_DEPTH>(
+                corr, topic, opt, 10.0 * weight * corr->weight);
+        }
+    }
+    if constexpr (type != TimeDeriv::LIN_POS_SPLINE) {
+        return;
+    }
+
+    // correspondences of lidars, rgbds (point-to-surfel), and optical cameras (reprojection)
+    estimator->SetResidualGroup(LIDAR_PTS_TO_SURFEL_GROUP);
+    for (const auto &[topic, corrs] : lidarPtsCorrs) {
+        double weight = Configor::DataStream::LiDARTopics.at(topic).Weight;
+        estimator->AddLiDARPointToSurfelConstraints<type>(*corrs, topic, optOption, weight);
+    }
+    estimator->SetResidualGroup(RGBD_PTS_TO_SURFEL_GROUP);
+    for (const auto &[topic, corrs] : rgbdPtsCorrs) {
+        double weight = Configor::DataStream::RGBDTopics.at(topic).Weight;
+        estimator->AddRGBDPointToSurfelConstraints<type>(*corrs, topic, optOption, weight);
+    }
+    estimator->SetResidualGroup(VISUAL_REPROJ_GROUP);
+    for (const auto &[topic, corrs] : visualReprojCorrs) {
+        double weight = Configor::DataStream::CameraTopics.at(topic).Weight;
+        const auto opt = CameraOptOption(topic);
+        for (const auto &corr : corrs) {
+            if (Configor::Preference::BatchVisualReprojFactors) {
+                estimator->AddVisualReprojections<type>(corr->corrs, topic,
+                                                        _visualGlobalScale.get(),
+                                                        corr->invDepthFir.get(), opt, weight);
+                continue;
+            }
+            for (const auto &c : corr->corrs) {
+                estimator->AddVisualReprojection<type>(c, topic, _visualGlobalScale.get(),
+                                                       corr->invDepthFir.get(), opt,
+                                                       weight * c->weight);
+            }
+        }
+    }
+}
+
+OptOption BatchOptProblem::CameraOptOption(const std::string &topic) const {
+    auto iter = cameraOptOptions.find(topic);
+    return iter == cameraOptOptions.cend() ? optOption : iter->second;
+}
+
+}  // namespace ns_ikalibr
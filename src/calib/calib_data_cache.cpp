@@ -0,0 +1,641 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/calib_data_cache.h"
+#include "config/configor.h"
+#include "util/status.hpp"
+#include "spdlog/spdlog.h"
+#include "opencv2/imgcodecs.hpp"
+#include "opencv2/imgproc.hpp"
+#include "util/memory_usage.hpp"
+#include "filesystem"
+#include "fstream"
+#include "deque"
+#include "cstring"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "fcntl.h"
+#include "unistd.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+// the magic header of the cache file
+static const std::string CACHE_MAGIC = "IKALIBR_CALIB_DATA_CACHE";
+
+// --------------------------
+// binary writer and reader
+// --------------------------
+
+struct CacheWriter {
+    std::ofstream &file;
+
+    template <class Type>
+    void Write(const Type &val) {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        file.write(reinterpret_cast<const char *>(&val), sizeof(Type));
+    }
+
+    void WriteBytes(const void *data, std::size_t size) {
+        file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+    }
+
+    void WriteString(const std::string &str) {
+        Write<std::uint64_t>(str.size());
+        WriteBytes(str.data(), str.size());
+    }
+
+    void WriteVector3d(const Eigen::Vector3d &vec) {
+        Write(vec(0)), Write(vec(1)), Write(vec(2));
+    }
+
+    template <class Type>
+    void WriteVector(const std::vector<Type> &vec) {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        Write<std::uint64_t>(vec.size());
+        WriteBytes(vec.data(), vec.size() * sizeof(Type));
+    }
+
+    void WriteMat(const cv::Mat &mat, bool compress) {
+        Write<std::int32_t>(mat.rows);
+        Write<std::int32_t>(mat.cols);
+        Write<std::int32_t>(mat.type());
+        if (mat.empty()) {
+            return;
+        }
+        // only 8-bit images can be compressed losslessly using 'png' here
+        compress = compress && mat.depth() == CV_8U;
+        Write<std::uint8_t>(compress);
+        if (compress) {
+            std::vector<uchar> buffer;
+            cv::imencode(".png", mat, buffer);
+            Write<std::uint64_t>(buffer.size());
+            WriteBytes(buffer.data(), buffer.size());
+        } else {
+            cv::Mat continuous = mat.isContinuous() ? mat : mat.clone();
+            Write<std::uint64_t>(continuous.total() * continuous.elemSize());
+            WriteBytes(continuous.data, continuous.total() * continuous.elemSize());
+        }
+    }
+};
+
+struct CacheReader {
+    const char *data;
+    std::size_t size;
+    std::size_t cursor;
+
+    void Require(std::size_t bytes) const {
+        if (cursor + bytes > size) {
+            throw Status(Status::WARNING, "the calibration data cache is broken!");
+        }
+    }
+
+    template <class Type>
+    Type Read() {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        Require(sizeof(Type));
+        Type val;
+        std::memcpy(&val, data + cursor, sizeof(Type));
+        cursor += sizeof(Type);
+        return val;
+    }
+
+    const char *ReadBytes(std::size_t bytes) {
+        Require(bytes);
+        const char *ptr = data + cursor;
+        cursor += bytes;
+        return ptr;
+    }
+
+    std::string ReadString() {
+        auto len = Read<std::uint64_t>();
+        return {ReadBytes(len), len};
+    }
+
+    Eigen::Vector3d ReadVector3d() {
+        auto x = Read<double>(), y = Read<double>(), z = Read<double>();
+        return {x, y, z};
+    }
+
+    template <class Type>
+    std::vector<Type> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        std::vector<Type> vec(Read<std::uint64_t>());
+        std::memcpy(vec.data(), ReadBytes(vec.size() * sizeof(Type)), vec.size() * sizeof(Type));
+        return vec;
+    }
+
+    // the mat is not decoded here, a header referring to the mapped memory is returned
+    std::pair<cv::Mat, bool> ReadMatHeader() {
+        auto rows = Read<std::int32_t>();
+        auto cols = Read<std::int32_t>();
+        auto type = Read<std::int32_t>();
+        if (rows == 0 || cols == 0) {
+            return {cv::Mat(), false};
+        }
+        bool compressed = Read<std::uint8_t>();
+        auto bytes = Read<std::uint64_t>();
+        auto ptr = const_cast<char *>(ReadBytes(bytes));
+        if (compressed) {
+            return {cv::Mat(1, static_cast<int>(bytes), CV_8UC1, ptr), true};
+        } else {
+            return {cv::Mat(rows, cols, type, ptr), false};
+        }
+    }
+};
+
+// a mat (maybe encoded) referring to the mapped memory, which would be decoded or copied
+struct MatToRecover {
+    cv::Mat *dst;
+    cv::Mat src;
+    bool compressed;
+
+    void Recover() const {
+        if (src.empty()) {
+            *dst = cv::Mat();
+        } else if (compressed) {
+            *dst = cv::imdecode(src, cv::IMREAD_UNCHANGED);
+        } else {
+            *dst = src.clone();
+        }
+    }
+};
+
+// images of a camera (or rgbd) frame recovered from the cache, from which the frame is created
+struct ImagesToRecover {
+    double timestamp;
+    ns_veta::IndexT id;
+    cv::Mat color, grey, depth;
+};
+
+// the decoder of lazy frames over the payload copied from the cache, returns the color image
+static CameraFrame::Decoder CachedImageDecoder(cv::Mat payload, bool compressed) {
+    return [payload = std::move(payload), compressed]() -> cv::Mat {
+        cv::Mat img = compressed ? cv::imdecode(payload, cv::IMREAD_COLOR) : payload.clone();
+        if (img.channels() == 1) {
+            cv::cvtColor(img, img, cv::COLOR_GRAY2BGR);
+        }
+        return img;
+    };
+}
+
+// --------------
+// CalibDataCache
+// --------------
+
+CalibDataCache::CalibDataCache(std::string filename, std::string key)
+    : _filename(std::move(filename)),
+      _key(std::move(key)) {}
+
+CalibDataCache::Ptr CalibDataCache::Create(const std::string &filename, const std::string &key) {
+    return std::make_shared<CalibDataCache>(filename, key);
+}
+
+CalibDataCache::Ptr CalibDataCache::CreateFromConfigor() {
+    auto key = GenerateKeyFromConfigor();
+    auto filename = fmt::format("{}/cache/calib_data_{:016x}.bin",
+                                Configor::DataStream::OutputPath, std::hash<std::string>{}(key));
+    return Create(filename, key);
+}
+
+const std::string &CalibDataCache::GetFilename() const { return _filename; }
+
+const std::string &CalibDataCache::GetKey() const { return _key; }
+
+std::string CalibDataCache::GenerateKeyFromConfigor() {
+    std::stringstream stream;
+    stream << "version: " << VERSION << '\n';
+    for (const auto &bagPath : Configor::DataStream::GetBagPaths()) {
+        if (std::filesystem::exists(bagPath)) {
+            auto path = std::filesystem::canonical(bagPath);
+            stream << "bag: " << path.string() << '\n';
+            stream << "size: " << std::filesystem::file_size(path) << '\n';
+            stream << "mtime: "
+                   << std::filesystem::last_write_time(path).time_since_epoch().count() << '\n';
+        } else {
+            stream << "bag: " << bagPath << '\n';
+        }
+    }
+    stream << fmt::format("piece: {:.9f}, {:.9f}\n", Configor::DataStream::BeginTime,
+                          Configor::DataStream::Duration);
+    // only grey images of cameras are stored if colors are not required
+    stream << "color images: " << Configor::IsColorImageRequired() << '\n';
+    for (const auto &[topic, config] : Configor::DataStream::IMUTopics) {
+        stream << "imu: " << topic << ", " << config.Type << '\n';
+    }
+    for (const auto &[topic, config] : Configor::DataStream::RadarTopics) {
+        stream << "radar: " << topic << ", " << config.Type << '\n';
+    }
+    for (const auto &[topic, config] : Configor::DataStream::LiDARTopics) {
+        stream << "lidar: " << topic << ", " << config.Type << '\n';
+    }
+    for (const auto &[topic, config] : Configor::DataStream::CameraTopics) {
+        stream << "camera: " << topic << ", " << config.Type << '\n';
+    }
+    for (const auto &[topic, config] : Configor::DataStream::RGBDTopics) {
+        // inverse depth images are inverted when loading
+        stream << "rgbd: " << topic << ", " << config.Type << ", " << config.DepthTopic << ", "
+               << (config.DepthFactor < 0.0) << '\n';
+    }
+    for (const auto &[topic, config] : Configor::DataStream::EventTopics) {
+        stream << "event: " << topic << ", " << config.Type << '\n';
+    }
+    // messages are decimated before caching, the rotation one is integrated from the reference imu
+    for (const auto &[topic, config] : Configor::DataStream::TopicDecimation) {
+        stream << fmt::format("decimation: {}, {:.9f}, {:.9f}", topic, config.Rate,
+                              config.MinRotation);
+        if (config.MinRotation > 0.0) {
+            stream << ", " << Configor::DataStream::ReferIMU;
+        }
+        stream << '\n';
+    }
+    return stream.str();
+}
+
+bool CalibDataCache::IsValid() const {
+    if (!std::filesystem::exists(_filename)) {
+        return false;
+    }
+    std::ifstream file(_filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string magic(CACHE_MAGIC.size(), '\0');
+    std::uint64_t keyLen = 0;
+    file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    file.read(reinterpret_cast<char *>(&keyLen), sizeof(std::uint64_t));
+    if (!file || magic != CACHE_MAGIC || keyLen != _key.size()) {
+        return false;
+    }
+    std::string key(keyLen, '\0');
+    file.read(key.data(), static_cast<std::streamsize>(keyLen));
+    return file && key == _key;
+}
+
+bool CalibDataCache::Save(const MesMap<IMUFrame> &imuMes,
+                          const MesMap<RadarTargetArray> &radarMes,
+                          const MesMap<LiDARFrame> &lidarMes,
+                          const MesMap<CameraFrame> &camMes,
+                          const MesMap<EventArray> &eventMes,
+                          const MesMap<RGBDFrame> &rgbdMes) const {
+    auto dir = std::filesystem::path(_filename).parent_path();
+    if (!std::filesystem::exists(dir) && !std::filesystem::create_directories(dir)) {
+        spdlog::warn("create directory for calibration data cache failed: '{}'", dir.string());
+        return false;
+    }
+    // write to a temporary file first, so that a broken cache would never be left
+    const std::string tmpFilename = _filename + ".tmp";
+    std::ofstream file(tmpFilename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        spdlog::warn("open calibration data cache file '{}' failed!", tmpFilename);
+        return false;
+    }
+    spdlog::info("saving calibration data cache to '{}'...", _filename);
+
+    CacheWriter writer{file};
+    writer.WriteBytes(CACHE_MAGIC.data(), CACHE_MAGIC.size());
+    writer.WriteString(_key);
+
+    // imu
+    writer.Write<std::uint64_t>(imuMes.size());
+    for (const auto &[topic, mes] : imuMes) {
+        writer.WriteString(topic);
+        writer.Write<std::uint64_t>(mes.size());
+        for (const auto &frame : mes) {
+            writer.Write(frame->GetTimestamp());
+            writer.WriteVector3d(frame->GetGyro());
+            writer.WriteVector3d(frame->GetAcce());
+        }
+    }
+
+    // radar
+    writer.Write<std::uint64_t>(radarMes.size());
+    for (const auto &[topic, mes] : radarMes) {
+        writer.WriteString(topic);
+        writer.Write<std::uint64_t>(mes.size());
+        for (const auto &ary : mes) {
+            writer.Write(ary->GetTimestamp());
+            writer.Write<std::uint64_t>(ary->GetTargets().size());
+            for (const auto &tar : ary->GetTargets()) {
+                writer.Write(tar->GetTimestamp());
+                writer.WriteVector3d(tar->GetTargetXYZ());
+                writer.Write(tar->GetRadialVelocity());
+            }
+        }
+    }
+
+    // lidar, points are stored in their raw memory layout
+    writer.Write<std::uint64_t>(sizeof(IKalibrPoint));
+    writer.Write<std::uint64_t>(lidarMes.size());
+    for (const auto &[topic, mes] : lidarMes) {
+        writer.WriteString(topic);
+        writer.Write<std::uint64_t>(mes.size());
+        for (const auto &frame : mes) {
+            const auto &scan = frame->GetScan();
+            writer.Write(frame->GetTimestamp());
+            writer.Write<std::uint32_t>(scan->width);
+            writer.Write<std::uint32_t>(scan->height);
+            writer.Write<std::uint8_t>(scan->is_dense);
+            writer.Write<std::uint64_t>(scan->size());
+            writer.WriteBytes(scan->points.data(), scan->size() * sizeof(IKalibrPoint));
+        }
+    }
+
+    /**
+     * camera, only grey images are stored if colors are not required (derived ones carry nothing
+     * more). Otherwise color ones are stored, from which grey ones are recovered
+     */
+    const bool greyOnly = !Configor::IsColorImageRequired();
+    writer.Write<std::uint64_t>(camMes.size());
+    for (const auto &[topic, mes] : camMes) {
+        writer.WriteString(topic);
+        writer.Write<std::uint64_t>(mes.size());
+        for (const auto &frame : mes) {
+            writer.Write(frame->GetTimestamp());
+            writer.Write<std::uint64_t>(frame->GetId());
+            writer.WriteMat(greyOnly ? frame->GetImage() : frame->GetColorImage(), COMPRESS_IMAGES);
+        }
+    }
+
+    // event
+    writer.Write<std::uint64_t>(eventMes.size());
+    for (const auto &[topic, mes] : eventMes) {
+        writer.WriteString(topic);
+        writer.Write<std::uint64_t>(mes.size());
+        for (const auto &ary : mes) {
+            // events are packed in arrays, store them directly
+            writer.Write(ary->GetTimestamp());
+            writer.Write(ary->GetTimeBase());
+            writer.WriteVector(ary->GetPackedEvents());
+        }
+    }
+
+    // rgbd, depth images are 16-bit or float ones, they are stored in raw
+    writer.Write<std::uint64_t>(rgbdMes.size());
+    for (const auto &[topic, mes] : rgbdMes) {
+        writer.WriteString(topic);
+        writer.Write<std::uint64_t>(mes.size());
+        for (const auto &frame : mes) {
+            writer.Write(frame->GetTimestamp());
+            writer.Write<std::uint64_t>(frame->GetId());
+            writer.WriteMat(frame->GetColorImage(), COMPRESS_IMAGES);
+            writer.WriteMat(frame->GetDepthImage(), false);
+        }
+    }
+
+    file.close();
+    if (!file) {
+        spdlog::warn("write calibration data cache file '{}' failed!", tmpFilename);
+        std::filesystem::remove(tmpFilename);
+        return false;
+    }
+    std::filesystem::rename(tmpFilename, _filename);
+    spdlog::info("calibration data cache saved, size: '{:.3f}' (MB)",
+                 static_cast<double>(std::filesystem::file_size(_filename)) / 1024.0 / 1024.0);
+    return true;
+}
+
+bool CalibDataCache::Load(MesMap<IMUFrame> &imuMes,
+                          MesMap<RadarTargetArray> &radarMes,
+                          MesMap<LiDARFrame> &lidarMes,
+                          MesMap<CameraFrame> &camMes,
+                          MesMap<EventArray> &eventMes,
+                          MesMap<RGBDFrame> &rgbdMes) const {
+    if (!IsValid()) {
+        return false;
+    }
+    spdlog::info("loading calibration data from cache '{}'...", _filename);
+
+    // map the cache file into the memory
+    int fd = open(_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    auto size = static_cast<std::size_t>(fileStat.st_size);
+    void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    MesMap<IMUFrame> imuMesTemp;
+    MesMap<RadarTargetArray> radarMesTemp;
+    MesMap<LiDARFrame> lidarMesTemp;
+    MesMap<CameraFrame> camMesTemp;
+    MesMap<EventArray> eventMesTemp;
+    MesMap<RGBDFrame> rgbdMesTemp;
+    // images are decoded in parallel after parsing, then frames are created from them
+    std::vector<MatToRecover> matsToRecover;
+    std::deque<std::pair<CameraFrame::Ptr *, ImagesToRecover>> camImages;
+    std::deque<std::pair<RGBDFrame::Ptr *, ImagesToRecover>> rgbdImages;
+    // the same as the one when saving, which is encoded in the key
+    const bool greyOnly = !Configor::IsColorImageRequired();
+    // grey images are recovered from color ones after decoding
+    std::vector<ImagesToRecover *> greyToRecover;
+
+    bool success = true;
+    try {
+        CacheReader reader{static_cast<const char *>(addr), size, 0};
+        reader.ReadBytes(CACHE_MAGIC.size());
+        reader.ReadString();
+
+        // imu
+        auto topicCount = reader.Read<std::uint64_t>();
+        for (std::uint64_t i = 0; i < topicCount; ++i) {
+            auto &mes = imuMesTemp[reader.ReadString()];
+            // samples are appended to the store directly, and then packed as frames
+            IMUSampleStore store;
+            const auto count = reader.Read<std::uint64_t>();
+            store.Reserve(count);
+            for (std::uint64_t j = 0; j < count; ++j) {
+                auto t = reader.Read<double>();
+                auto gyro = reader.ReadVector3d();
+                auto acce = reader.ReadVector3d();
+                store.Append(t, gyro, acce);
+            }
+            mes = store.PackFrames();
+        }
+
+        // radar
+        topicCount = reader.Read<std::uint64_t>();
+        for (std::uint64_t i = 0; i < topicCount; ++i) {
+            auto &mes = radarMesTemp[reader.ReadString()];
+            mes.resize(reader.Read<std::uint64_t>());
+            for (auto &ary : mes) {
+                auto t = reader.Read<double>();
+                // targets are filled into the structure-of-arrays layout directly
+                RadarTargetSoA soa(static_cast<Eigen::Index>(reader.Read<std::uint64_t>()));
+                for (Eigen::Index j = 0; j < soa.Size(); ++j) {
+                    auto tarTime = reader.Read<double>();
+                    auto xyz = reader.ReadVector3d();
+                    auto vel = reader.Read<double>();
+                    soa.Set(j, tarTime, xyz, vel);
+                }
+                ary = RadarTargetArray::CreatePacked(t, std::move(soa));
+            }
+        }
+
+        // lidar
+        if (reader.Read<std::uint64_t>() != sizeof(IKalibrPoint)) {
+            throw Status(Status::WARNING, "the point type in calibration data cache is changed!");
+        }
+        topicCount = reader.Read<std::uint64_t>();
+        for (std::uint64_t i = 0; i < topicCount; ++i) {
+            auto &mes = lidarMesTemp[reader.ReadString()];
+            mes.resize(reader.Read<std::uint64_t>());
+            for (auto &frame : mes) {
+                auto t = reader.Read<double>();
+                IKalibrPointCloud::Ptr scan(new IKalibrPointCloud);
+                auto width = reader.Read<std::uint32_t>();
+                auto height = reader.Read<std::uint32_t>();
+                auto isDense = reader.Read<std::uint8_t>();
+                auto count = reader.Read<std::uint64_t>();
+                scan->resize(count);
+                std::memcpy(scan->points.data(), reader.ReadBytes(count * sizeof(IKalibrPoint)),
+                            count * sizeof(IKalibrPoint));
+                scan->width = width, scan->height = height, scan->is_dense = isDense;
+                frame = LiDARFrame::Create(t, scan);
+            }
+        }
+
+        // camera, frames are created in the same (lazy, grey-only) way as the ones from bags
+        topicCount = reader.Read<std::uint64_t>();
+        for (std::uint64_t i = 0; i < topicCount; ++i) {
+            auto &mes = camMesTemp[reader.ReadString()];
+            mes.resize(reader.Read<std::uint64_t>());
+            for (auto &frame : mes) {
+                auto t = reader.Read<double>();
+                auto id = static_cast<ns_veta::IndexT>(reader.Read<std::uint64_t>());
+                auto [mat, compressed] = reader.ReadMatHeader();
+                if (Configor::Preference::LazyImageDecoding && !mat.empty()) {
+                    // the payload is copied out of the mapped memory, and decoded on demand
+                    cv::Mat payload = mat.clone();
+                    const std::size_t payloadBytes = MemoryUsage::MatBytes(payload);
+                    frame = CameraFrame::CreateLazy(t, CachedImageDecoder(payload, compressed), id,
+                                                    payloadBytes, greyOnly);
+                    continue;
+                }
+                auto &images = camImages.emplace_back(&frame, ImagesToRecover{t, id}).second;
+                matsToRecover.push_back({greyOnly ? &images.grey : &images.color, mat, compressed});
+                if (!greyOnly) {
+                    greyToRecover.push_back(&images);
+                }
+            }
+        }
+
+        // event
+        topicCount = reader.Read<std::uint64_t>();
+        for (std::uint64_t i = 0; i < topicCount; ++i) {
+            auto &mes = eventMesTemp[reader.ReadString()];
+            mes.resize(reader.Read<std::uint64_t>());
+            for (auto &ary : mes) {
+                auto t = reader.Read<double>();
+                auto timeBase = reader.Read<double>();
+                ary = EventArray::Create(t, timeBase,
+                                         reader.ReadVector<EventArray::PackedEvent>());
+            }
+        }
+
+        // rgbd
+        topicCount = reader.Read<std::uint64_t>();
+        for (std::uint64_t i = 0; i < topicCount; ++i) {
+            auto &mes = rgbdMesTemp[reader.ReadString()];
+            mes.resize(reader.Read<std::uint64_t>());
+            for (auto &frame : mes) {
+                auto t = reader.Read<double>();
+                auto id = static_cast<ns_veta::IndexT>(reader.Read<std::uint64_t>());
+                auto [colorMat, colorCompressed] = reader.ReadMatHeader();
+                auto [depthMat, depthCompressed] = reader.ReadMatHeader();
+                auto &images = rgbdImages.emplace_back(&frame, ImagesToRecover{t, id}).second;
+                matsToRecover.push_back({&images.color, colorMat, colorCompressed});
+                matsToRecover.push_back({&images.depth, depthMat, depthCompressed});
+                greyToRecover.push_back(&images);
+            }
+        }
+
+        // decode images in parallel, the mapped memory is still alive here
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(matsToRecover)
+        for (int i = 0; i < static_cast<int>(matsToRecover.size()); ++i) {
+            matsToRecover.at(i).Recover();
+        }
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(greyToRecover)
+        for (int i = 0; i < static_cast<int>(greyToRecover.size()); ++i) {
+            auto images = greyToRecover.at(i);
+            if (!images->color.empty()) {
+                cv::cvtColor(images->color, images->grey, cv::COLOR_BGR2GRAY);
+            }
+        }
+        for (const auto &[frame, images] : camImages) {
+            *frame = greyOnly ? CameraFrame::CreateGreyOnly(images.timestamp, images.grey, nullptr,
+                                                            images.id)
+                              : CameraFrame::Create(images.timestamp, images.grey, images.color,
+                                                    images.id);
+        }
+        for (const auto &[frame, images] : rgbdImages) {
+            *frame = RGBDFrame::Create(images.timestamp, images.grey, images.color, images.depth,
+                                       images.id);
+        }
+    } catch (const IKalibrStatus &status) {
+        spdlog::warn("{}", status.what);
+        success = false;
+    } catch (const cv::Exception &exception) {
+        spdlog::warn("decode images in calibration data cache failed: '{}'", exception.what());
+        success = false;
+    }
+    munmap(addr, size);
+
+    if (!success) {
+        return false;
+    }
+    imuMes = std::move(imuMesTemp);
+    radarMes = std::move(radarMesTemp);
+    lidarMes = std::move(lidarMesTemp);
+    camMes = std::move(camMesTemp);
+    eventMes = std::move(eventMesTemp);
+    rgbdMes = std::move(rgbdMesTemp);
+    return true;
+}
+
+}  // namespace ns_ikalibr
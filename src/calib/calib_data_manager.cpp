@@ -33,7 +33,11 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "calib/calib_data_manager.h"
+#include "calib/calib_data_cache.h"
+#include "calib/imu_excitation.h"
+#include "calib/live_topic_recorder.h"
 #include "core/optical_flow_trace.h"
+#include "core/event_denoiser.h"
 #include "rosbag/view.h"
 #include "sensor/camera_data_loader.h"
 #include "sensor/depth_data_loader.h"
@@ -42,7 +46,12 @@
 #include "sensor/lidar_data_loader.h"
 #include "sensor/radar_data_loader.h"
 #include "spdlog/spdlog.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
+#include "util/memory_usage.hpp"
+#include "omp.h"
+#include "atomic"
+#include "util/stage_profiler.h"
+#include "util/trace_recorder.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,21 +63,94 @@ namespace ns_ikalibr {
 // CalibDataManager
 // ----------------
 
-CalibDataManager::CalibDataManager() = default;
+CalibDataManager::CalibDataManager(CalibContextPtr context)
+    : _context(context != nullptr ? std::move(context) : CalibContext::CreateFromConfigor()) {}
 
-CalibDataManager::Ptr CalibDataManager::Create() { return std::make_shared<CalibDataManager>(); }
+CalibDataManager::Ptr CalibDataManager::Create(const CalibContextPtr &context) {
+    return std::make_shared<CalibDataManager>(context);
+}
 
-void CalibDataManager::LoadCalibData() {
-    spdlog::info("loading calibration data...");
+const CalibContextPtr &CalibDataManager::GetContext() const { return _context; }
 
-    // open the ros bag
-    auto bag = std::make_unique<rosbag::Bag>();
-    if (!std::filesystem::exists(Configor::DataStream::BagPath)) {
-        spdlog::error("the ros bag path '{}' is invalid!", Configor::DataStream::BagPath);
+void CalibDataManager::LoadCalibData() {
+    StageProfiler::Scope stageScope("LoadCalibData");
+    auto scope = _context->Activate();
+    if (Configor::DataStream::LiveMode) {
+        // messages are recorded into the bag first, which is then loaded as an offline one
+        LiveTopicRecorder::Create(Configor::DataStream::BagPath)->Record();
+    }
+    if (Configor::Preference::CacheCalibData) {
+        auto cache = CalibDataCache::CreateFromConfigor();
+        if (cache->Load(_imuMes, _radarMes, _lidarMes, _camMes, _eventMes, _rgbdMes)) {
+            spdlog::info("calibration data loaded from cache '{}'", cache->GetFilename());
+        } else {
+            LoadCalibDataFromBag();
+            cache->Save(_imuMes, _radarMes, _lidarMes, _camMes, _eventMes, _rgbdMes);
+        }
     } else {
-        bag->open(Configor::DataStream::BagPath, rosbag::BagMode::Read);
+        LoadCalibDataFromBag();
     }
 
+    OutputDataStatus();
+
+    AdjustCalibDataSequence();
+    AlignTimestamp();
+
+    /**
+     * to calibrate velocity-spline-derived cameras, high sampling frequency is required (larger
+     * than 30 Hz), to perform high-precision optical flow velocity recovery
+     */
+    for (const auto &[topic, _] : Configor::DataStream::VelCameraTopics()) {
+        auto freq = GetCameraAvgFrequency(topic);
+        spdlog::info("sampling frequency for camera '{}': {:.3f}", topic, freq);
+        if (freq < 29.0) {
+            throw Status(
+                Status::WARNING,
+                "Sampling frequency of vel camera '{}' (freq: {:.3f}) is too small!!! "
+                "Frequency larger than 30 Hz is required!!! Please change 'ScaleSplineType' of "
+                "this camera to 'LIN_POS_SPLINE' which would perform a SfM-based calibration!!! Do "
+                "not forget to change its weight!",
+                topic, freq);
+        }
+    }
+
+    for (const auto &[topic, _] : Configor::DataStream::RGBDTopics) {
+        auto freq = GetRGBDAvgFrequency(topic);
+        spdlog::info("sampling frequency for rgbd camera '{}': {:.3f}", topic, freq);
+        if (freq < 29.0) {
+            throw Status(Status::WARNING,
+                         "Sampling frequency of rgbd camera '{}' (freq: {:.3f}) is too small!!! "
+                         "Frequency larger than 30 Hz is required!!! Please throw the depth "
+                         "information and treat it an optical camera, and perform "
+                         "'LIN_POS_SPLINE'-based calibration.",
+                         topic, freq);
+        }
+    }
+
+    // performed after the frequency checks, as thinned windows would lower average frequencies
+    WindowByExcitation();
+
+    PackIMUMeasurements();
+}
+
+void CalibDataManager::PackIMUMeasurements() {
+    /**
+     * frames are packed per bag piece when loaded, here they are packed again in the final order,
+     * so that frames of a topic are stored contiguously (which is friendly to the cache in the
+     * inertial factors and the preintegration), and storages of trimmed frames are released
+     */
+    for (auto &[topic, mes] : _imuMes) {
+        mes = IMUSampleStore::Create(mes)->PackFrames();
+    }
+}
+
+void CalibDataManager::LoadCalibDataFromBag() {
+    spdlog::info("loading calibration data...");
+
+    // open the ros bags, split (multiple) bags are queried as a merged view ordered by time
+    const auto bagPaths = Configor::DataStream::GetBagPaths();
+    auto bags = OpenBags(bagPaths);
+
     auto view = rosbag::View();
 
     // using a temp view to check the time range of the source ros bag
@@ -96,7 +178,9 @@ void CalibDataManager::LoadCalibData() {
         topicsToQuery.push_back(topic);
     }
 
-    viewTemp.addQuery(*bag, rosbag::TopicQuery(topicsToQuery));
+    for (const auto &bag : bags) {
+        viewTemp.addQuery(*bag, rosbag::TopicQuery(topicsToQuery));
+    }
     auto begTime = viewTemp.getBeginTime();
     auto endTime = viewTemp.getEndTime();
     spdlog::info("source data duration: from '{:.5f}' to '{:.5f}'.", begTime.toSec(),
@@ -124,130 +208,260 @@ void CalibDataManager::LoadCalibData() {
     spdlog::info("expect data duration: from '{:.5f}' to '{:.5f}'.", begTime.toSec(),
                  endTime.toSec());
 
-    view.addQuery(*bag, rosbag::TopicQuery(topicsToQuery), begTime, endTime);
-
-    // create IMU data loader
-    std::map<std::string, IMUDataLoader::Ptr> imuDataLoaders;
-    std::map<std::string, RadarDataLoader::Ptr> radarDataLoaders;
-    std::map<std::string, LiDARDataLoader::Ptr> lidarDataLoaders;
-    std::map<std::string, CameraDataLoader::Ptr> cameraDataLoaders;
-    std::map<std::string, EventDataLoader::Ptr> eventDataLoaders;
-    // for rgbd cameras
-    std::map<std::string, CameraDataLoader::Ptr> rgbdColorDataLoaders;
-    std::map<std::string, DepthDataLoader::Ptr> rgbdDepthDataLoaders;
-    // temporal data containers ('list' containers)
-    std::map<std::string, std::list<CameraFrame::Ptr>> rgbdColorMesTemp;
-    std::map<std::string, std::list<DepthFrame::Ptr>> rgbdDepthMesTemp;
+    // the chunk indices of each bag are used to seek to the queried time range directly
+    for (const auto &bag : bags) {
+        view.addQuery(*bag, rosbag::TopicQuery(topicsToQuery), begTime, endTime);
+    }
+
+    // index the queried view in a single pass, which is reused for reservation and progress
+    auto topicIndex = BuildTopicIndex(view);
 
+    // create data loaders, loaders of other lidar and radar models are registered by plugins
+    LoadDataLoaderPlugins(Configor::DataStream::GetLoaderPluginPaths());
+    DataLoaderPack loaders;
     // get type enum from the string
     for (const auto &[topic, config] : Configor::DataStream::IMUTopics) {
-        imuDataLoaders.insert({topic, IMUDataLoader::GetLoader(config.Type)});
+        loaders.imuDataLoaders.insert({topic, IMUDataLoader::GetLoader(config.Type)});
         // reserve tp speed up the data loading
-        auto size = MessageNumInTopic(bag.get(), topic, begTime, endTime);
-        if (size > 0) {
-            _imuMes[topic].reserve(size);
+        if (auto iter = topicIndex.find(topic); iter != topicIndex.cend()) {
+            _imuMes[topic].reserve(iter->second.mesCount);
         }
     }
     for (const auto &[topic, config] : Configor::DataStream::RadarTopics) {
-        radarDataLoaders.insert({topic, RadarDataLoader::GetLoader(config.Type)});
+        loaders.radarDataLoaders.insert({topic, RadarDataLoader::GetLoader(config.Type)});
+        if (auto entry = DataLoaderRegistry<RadarDataLoader>::Find(config.Type)) {
+            spdlog::info("radar '{}' is decoded by '{}' with capabilities: {}", topic,
+                         entry->decoder, DecodeCapabilityStr(entry->capability));
+        }
         // reserve tp speed up the data loading
-        auto size = MessageNumInTopic(bag.get(), topic, begTime, endTime);
-        if (size > 0) {
-            _radarMes[topic].reserve(size);
+        if (auto iter = topicIndex.find(topic); iter != topicIndex.cend()) {
+            _radarMes[topic].reserve(iter->second.mesCount);
         }
     }
     for (const auto &[topic, config] : Configor::DataStream::LiDARTopics) {
-        lidarDataLoaders.insert({topic, LiDARDataLoader::GetLoader(config.Type)});
+        loaders.lidarDataLoaders.insert({topic, LiDARDataLoader::GetLoader(config.Type)});
+        if (auto entry = DataLoaderRegistry<LiDARDataLoader>::Find(config.Type)) {
+            spdlog::info("lidar '{}' is decoded by '{}' with capabilities: {}", topic,
+                         entry->decoder, DecodeCapabilityStr(entry->capability));
+        }
         // reserve tp speed up the data loading
-        auto size = MessageNumInTopic(bag.get(), topic, begTime, endTime);
-        if (size > 0) {
-            _lidarMes[topic].reserve(size);
+        if (auto iter = topicIndex.find(topic); iter != topicIndex.cend()) {
+            _lidarMes[topic].reserve(iter->second.mesCount);
         }
     }
     for (const auto &[topic, config] : Configor::DataStream::CameraTopics) {
-        cameraDataLoaders.insert({topic, CameraDataLoader::GetLoader(config.Type)});
+        loaders.cameraDataLoaders.insert({topic, CameraDataLoader::GetLoader(config.Type)});
         // reserve tp speed up the data loading
-        auto size = MessageNumInTopic(bag.get(), topic, begTime, endTime);
-        if (size > 0) {
-            _camMes[topic].reserve(size);
+        if (auto iter = topicIndex.find(topic); iter != topicIndex.cend()) {
+            _camMes[topic].reserve(iter->second.mesCount);
         }
     }
     for (const auto &[topic, config] : Configor::DataStream::RGBDTopics) {
-        rgbdColorDataLoaders.insert({topic, CameraDataLoader::GetLoader(config.Type)});
+        loaders.rgbdColorDataLoaders.insert({topic, CameraDataLoader::GetLoader(config.Type)});
         bool isInverse = config.DepthFactor < 0.0f;
-        rgbdDepthDataLoaders.insert(
+        loaders.rgbdDepthDataLoaders.insert(
             {config.DepthTopic, DepthDataLoader::GetLoader(config.Type, isInverse)});
+        loaders.rgbdDepthToColorTopic.insert({config.DepthTopic, topic});
         // reserve tp speed up the data loading
-        // 'rgbdColorMesTemp' and 'rgbdDepthMesTemp' are std::list, three is no need to 'reserve'
+        if (auto iter = topicIndex.find(topic); iter != topicIndex.cend()) {
+            _rgbdMes[topic].reserve(iter->second.mesCount);
+        }
     }
     for (const auto &[topic, config] : Configor::DataStream::EventTopics) {
-        eventDataLoaders.insert({topic, EventDataLoader::GetLoader(config.Type)});
+        loaders.eventDataLoaders.insert({topic, EventDataLoader::GetLoader(config.Type)});
         // reserve tp speed up the data loading
-        auto size = MessageNumInTopic(bag.get(), topic, begTime, endTime);
-        if (size > 0) {
-            _eventMes[topic].reserve(size);
+        if (auto iter = topicIndex.find(topic); iter != topicIndex.cend()) {
+            _eventMes[topic].reserve(iter->second.mesCount);
         }
     }
 
+    // messages dropped here are never instantiated in unpacking
+    const auto keep = DecimateMessages(view, loaders);
+
     // read raw data
-    auto bar = std::make_shared<tqdm>();
-    int idx = 0;
-    for (auto iter = view.begin(); iter != view.end(); ++iter, ++idx) {
-        bar->progress(idx, static_cast<int>(view.size()));
-        const auto &item = *iter;
-        const std::string &topic = item.getTopic();
-        if (imuDataLoaders.cend() != imuDataLoaders.find(topic)) {
-            // is an inertial frame
-            auto mes = imuDataLoaders.at(topic)->UnpackFrame(item);
-            if (mes != nullptr) {
-                _imuMes[topic].push_back(mes);
-            }
-        } else if (radarDataLoaders.cend() != radarDataLoaders.find(topic)) {
-            // is a radar frame
-            auto mes = radarDataLoaders.at(topic)->UnpackScan(item);
-            if (mes != nullptr) {
-                _radarMes[topic].push_back(mes);
+    /**
+     * the queried message sequence is split into several continuous pieces, which are unpacked in
+     * parallel. As 'rosbag::Bag' is not thread-safe, each thread opens its own bag handle and
+     * reads messages of its own piece, the unpacked pieces are then merged in order, thus the
+     * data sequence is the same as the one obtained by iterating the view on a single thread
+     */
+    int mesCount = 0;
+    for (const auto &[topic, index] : topicIndex) {
+        mesCount += static_cast<int>(index.mesCount);
+    }
+    int pieceCount = std::max(
+        1, std::min(Configor::Preference::AvailableThreads(), mesCount / MinMesCountInPiece));
+    spdlog::info("unpack '{}' messages using '{}' thread(s)...", mesCount, pieceCount);
+
+    std::vector<UnpackedMesPiece> pieces(pieceCount);
+    std::vector<std::exception_ptr> exceptions(pieceCount, nullptr);
+    auto bar = ProgressStage::Create("unpack messages", mesCount);
+#pragma omp parallel for num_threads(pieceCount) default(none)                             \
+    shared(pieceCount, mesCount, pieces, exceptions, bar, loaders, topicsToQuery, begTime, \
+               endTime, bagPaths, keep)
+    for (int i = 0; i < pieceCount; ++i) {
+        TraceRecorder::Span span("loader", "UnpackPiece");
+        try {
+            auto pieceBags = OpenBags(bagPaths);
+            auto pieceView = rosbag::View();
+            for (const auto &pieceBag : pieceBags) {
+                pieceView.addQuery(*pieceBag, rosbag::TopicQuery(topicsToQuery), begTime, endTime);
             }
-        } else if (lidarDataLoaders.cend() != lidarDataLoaders.find(topic)) {
-            // is a lidar frame
-            auto mes = lidarDataLoaders.at(topic)->UnpackScan(item);
-            if (mes != nullptr) {
-                _lidarMes[topic].push_back(mes);
+
+            // the index range of this piece: [sIdx, eIdx)
+            auto sIdx = static_cast<int>(static_cast<long>(mesCount) * i / pieceCount);
+            auto eIdx = static_cast<int>(static_cast<long>(mesCount) * (i + 1) / pieceCount);
+
+            int idx = 0;
+            auto iter = pieceView.begin();
+            // skip messages before this piece, this only iterates the index, no data is read
+            while (iter != pieceView.end() && idx < sIdx) {
+                ++iter, ++idx;
             }
-        } else if (rgbdColorDataLoaders.cend() != rgbdColorDataLoaders.find(topic)) {
-            // is a rgbd color frame
-            auto mes = rgbdColorDataLoaders.at(topic)->UnpackFrame(item);
-            if (mes != nullptr) {
-                // id: uint64_t from timestamp (raw, millisecond)
-                mes->SetId(static_cast<ns_veta::IndexT>(mes->GetTimestamp() * 1E3));
-                rgbdColorMesTemp[topic].push_back(mes);
+            for (; iter != pieceView.end() && idx < eIdx; ++iter, ++idx) {
+                if (!keep.empty() && !keep.at(idx)) {
+                    bar->Step();
+                    continue;
+                }
+                UnpackMessage(*iter, loaders, pieces.at(i));
+                pieces.at(i).byteSizes[iter->getTopic()] += iter->size();
+                bar->Step();
             }
-        } else if (rgbdDepthDataLoaders.cend() != rgbdDepthDataLoaders.find(topic)) {
-            // is a rgbd depth frame
-            auto mes = rgbdDepthDataLoaders.at(topic)->UnpackFrame(item);
-            if (mes != nullptr) {
-                // id: uint64_t from timestamp (raw, millisecond)
-                mes->SetId(static_cast<ns_veta::IndexT>(mes->GetTimestamp() * 1E3));
-                rgbdDepthMesTemp[topic].push_back(mes);
+            for (auto &[topic, pairing] : pieces.at(i).rgbdPairing) {
+                pairing.Finish();
             }
-        } else if (cameraDataLoaders.cend() != cameraDataLoaders.find(topic)) {
-            // is a camera frame
-            auto mes = cameraDataLoaders.at(topic)->UnpackFrame(item);
-            if (mes != nullptr) {
-                // id: uint64_t from timestamp (raw, millisecond)
-                mes->SetId(static_cast<ns_veta::IndexT>(mes->GetTimestamp() * 1E3));
-                _camMes[topic].push_back(mes);
+            for (const auto &pieceBag : pieceBags) {
+                pieceBag->close();
             }
-        } else if (eventDataLoaders.cend() != eventDataLoaders.find(topic)) {
-            // is a camera frame
-            auto mes = eventDataLoaders.at(topic)->UnpackData(item);
-            if (mes != nullptr) {
-                _eventMes[topic].push_back(mes);
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
+        }
+    }
+    bar->Finish();
+    for (const auto &bag : bags) {
+        bag->close();
+    }
+
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // merge pieces in order
+    std::map<std::string, RGBDFramePairing> strayPairing;
+    for (auto &piece : pieces) {
+        for (const auto &[topic, byteSize] : piece.byteSizes) {
+            topicIndex[topic].byteSize += byteSize;
+        }
+        for (auto &[topic, store] : piece.imuMes) {
+            auto &seq = _imuMes[topic];
+            const auto frames = store.PackFrames();
+            seq.insert(seq.end(), frames.begin(), frames.end());
+        }
+        for (auto &[topic, mes] : piece.radarMes) {
+            auto &seq = _radarMes[topic];
+            seq.insert(seq.end(), mes.begin(), mes.end());
+        }
+        for (auto &[topic, mes] : piece.lidarMes) {
+            auto &seq = _lidarMes[topic];
+            seq.insert(seq.end(), mes.begin(), mes.end());
+        }
+        for (auto &[topic, mes] : piece.camMes) {
+            auto &seq = _camMes[topic];
+            seq.insert(seq.end(), mes.begin(), mes.end());
+        }
+        for (auto &[topic, mes] : piece.eventMes) {
+            auto &seq = _eventMes[topic];
+            seq.insert(seq.end(), mes.begin(), mes.end());
+        }
+        for (auto &[topic, pairing] : piece.rgbdPairing) {
+            auto &seq = _rgbdMes[topic];
+            seq.insert(seq.end(), pairing.rgbdMes.begin(), pairing.rgbdMes.end());
+            // frames that are not paired in their own piece, mainly the ones near piece borders
+            auto &stray = strayPairing[topic];
+            stray.colorStray.insert(stray.colorStray.end(), pairing.colorStray.begin(),
+                                    pairing.colorStray.end());
+            stray.depthStray.insert(stray.depthStray.end(), pairing.depthStray.begin(),
+                                    pairing.depthStray.end());
+        }
+    }
+    pieces.clear();
+
+    // pair the stray color and depth images of rgbd cameras across pieces in time order
+    for (auto &[colorTopic, stray] : strayPairing) {
+        RGBDFramePairing pairing;
+        std::size_t ci = 0, di = 0;
+        auto &colorFrames = stray.colorStray;
+        auto &depthFrames = stray.depthStray;
+        auto cmp = [](const auto &m1, const auto &m2) {
+            return m1->GetTimestamp() < m2->GetTimestamp();
+        };
+        std::sort(colorFrames.begin(), colorFrames.end(), cmp);
+        std::sort(depthFrames.begin(), depthFrames.end(), cmp);
+        while (ci < colorFrames.size() || di < depthFrames.size()) {
+            if (di == depthFrames.size() ||
+                (ci < colorFrames.size() &&
+                 colorFrames.at(ci)->GetTimestamp() < depthFrames.at(di)->GetTimestamp())) {
+                pairing.PushColor(colorFrames.at(ci++));
+            } else {
+                pairing.PushDepth(depthFrames.at(di++));
             }
         }
+        pairing.Finish();
+
+        // frames paired here are merged into the ones paired in pieces
+        auto &seq = _rgbdMes[colorTopic];
+        auto size = static_cast<long>(seq.size());
+        seq.insert(seq.end(), pairing.rgbdMes.begin(), pairing.rgbdMes.end());
+        std::inplace_merge(seq.begin(), seq.begin() + size, seq.end(), cmp);
+        const auto &depthTopic = Configor::DataStream::RGBDTopics.at(colorTopic).DepthTopic;
+        for (const auto &colorFrame : pairing.colorStray) {
+            spdlog::warn(
+                "can not find a matched depth image from '{}' for color image from '{}' at "
+                "time '{:.5f}'",
+                depthTopic, colorTopic, colorFrame->GetTimestamp());
+        }
+    }
+    strayPairing.clear();
+
+    // messages in the ros bag are organized by the recording time, rather than the sampling time,
+    // make sure the measurements are ordered by the sampling timestamps
+    SortByTimestamp(_imuMes);
+    SortByTimestamp(_radarMes);
+    SortByTimestamp(_lidarMes);
+    SortByTimestamp(_camMes);
+    SortByTimestamp(_eventMes);
+    SortByTimestamp(_rgbdMes);
+
+    // remove noise events (hot pixels, bursts, and background activities) before any processing
+    std::vector<std::string> eventTopics;
+    for (const auto &[topic, _] : _eventMes) {
+        eventTopics.push_back(topic);
+    }
+    std::vector<EventDenoiser::Report> denoiseReports(eventTopics.size());
+    auto denoiser = EventDenoiser::CreateFromConfigor();
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(eventTopics, denoiseReports, denoiser)
+    for (int i = 0; i < static_cast<int>(eventTopics.size()); ++i) {
+        denoiseReports.at(i) = denoiser->Denoise(_eventMes.at(eventTopics.at(i)));
+    }
+    for (int i = 0; i < static_cast<int>(eventTopics.size()); ++i) {
+        const auto &r = denoiseReports.at(i);
+        spdlog::info(
+            "denoise events of '{}': '{}' of '{}' events removed ('{:.2f}%'), hot pixel: '{}' "
+            "('{}' pixels), refractory: '{}', background activity: '{}'",
+            eventTopics.at(i), r.RemovedCount(), r.rawCount, r.ReductionRatio() * 100.0,
+            r.byHotPixel, r.hotPixelCount, r.byRefractory, r.byBackgroundActivity);
+    }
+
+    for (const auto &[topic, index] : topicIndex) {
+        spdlog::info(
+            "topic '{}' in bag: '{}' messages, '{:.3f}' (MB), time span: from '{:.5f}' to '{:.5f}'",
+            topic, index.mesCount, static_cast<double>(index.byteSize) / 1024.0 / 1024.0,
+            index.begTime.toSec(), index.endTime.toSec());
     }
-    bar->finish();
-    bag->close();
 
     for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
         CheckTopicExists(topic, _imuMes);
@@ -261,10 +475,8 @@ void CalibDataManager::LoadCalibData() {
     for (const auto &[topic, _] : Configor::DataStream::CameraTopics) {
         CheckTopicExists(topic, _camMes);
     }
-    for (const auto &[topic, info] : Configor::DataStream::RGBDTopics) {
-        // measurements are stored in 'rgbdColorMesTemp' and 'rgbdDepthMesTemp' temporally
-        CheckTopicExists(topic, rgbdColorMesTemp);
-        CheckTopicExists(info.DepthTopic, rgbdDepthMesTemp);
+    for (const auto &[topic, _] : Configor::DataStream::RGBDTopics) {
+        CheckTopicExists(topic, _rgbdMes);
     }
     for (const auto &[topic, _] : Configor::DataStream::EventTopics) {
         CheckTopicExists(topic, _eventMes);
@@ -276,7 +488,7 @@ void CalibDataManager::LoadCalibData() {
     // convenience), they are still fused separately in batch optimizations (a tightly-coupled
     // optimization framework)
     std::map<std::string, std::vector<RadarTargetArray::Ptr>> oldRadarMes = _radarMes;
-    for (const auto &[topic, loader] : radarDataLoaders) {
+    for (const auto &[topic, loader] : loaders.radarDataLoaders) {
         if (loader->GetRadarModel() == RadarModelType::AWR1843BOOST_RAW ||
             loader->GetRadarModel() == RadarModelType::AWR1843BOOST_CUSTOM) {
             const auto &mes = oldRadarMes.at(topic);
@@ -301,80 +513,6 @@ void CalibDataManager::LoadCalibData() {
             _radarMes.at(topic) = arrays;
         }
     }
-
-    // match color and depth images for rgbd cameras
-    // 'rgbdColorMesTemp' + 'rgbdDepthMesTemp' -->  '_rgbdMes'
-    for (const auto &[colorTopic, colorFrames] : rgbdColorMesTemp) {
-        auto depthTopic = Configor::DataStream::RGBDTopics.at(colorTopic).DepthTopic;
-        auto &curRGBDMes = _rgbdMes[colorTopic];
-        auto &depthImgs = rgbdDepthMesTemp.at(depthTopic);
-        for (const auto &colorFrame : colorFrames) {
-            const double timestamp = colorFrame->GetTimestamp();
-            // find a matched depth image for current color image
-            // the matched depth and color images should be close enough to each other in time
-            // domain
-            auto iter = std::find_if(
-                depthImgs.begin(), depthImgs.end(), [timestamp](const DepthFrame::Ptr &depthFrame) {
-                    // time distance: 0.001 s, i.e., 1 ms
-                    return std::abs(depthFrame->GetTimestamp() - timestamp) < 1E-3;
-                });
-            if (iter != depthImgs.cend()) {
-                curRGBDMes.push_back(RGBDFrame::Create(timestamp,                    // timestamp
-                                                       colorFrame->GetImage(),       // grey image
-                                                       colorFrame->GetColorImage(),  // color image
-                                                       (*iter)->GetDepthImage(),     // depth image
-                                                       colorFrame->GetId()           // image index
-                                                       ));
-                // remove this depth image
-                depthImgs.erase(iter);
-            } else {
-                spdlog::warn(
-                    "can not find a matched depth image from '{}' for color image from '{}' at "
-                    "time '{:.5f}'",
-                    depthTopic, colorTopic, timestamp);
-            }
-        }
-    }
-    rgbdColorMesTemp.clear(), rgbdDepthMesTemp.clear();
-    for (const auto &[topic, info] : Configor::DataStream::RGBDTopics) {
-        CheckTopicExists(topic, _rgbdMes);
-    }
-
-    OutputDataStatus();
-
-    AdjustCalibDataSequence();
-    AlignTimestamp();
-
-    /**
-     * to calibrate velocity-spline-derived cameras, high sampling frequency is required (larger
-     * than 30 Hz), to perform high-precision optical flow velocity recovery
-     */
-    for (const auto &[topic, _] : Configor::DataStream::VelCameraTopics()) {
-        auto freq = GetCameraAvgFrequency(topic);
-        spdlog::info("sampling frequency for camera '{}': {:.3f}", topic, freq);
-        if (freq < 29.0) {
-            throw Status(
-                Status::WARNING,
-                "Sampling frequency of vel camera '{}' (freq: {:.3f}) is too small!!! "
-                "Frequency larger than 30 Hz is required!!! Please change 'ScaleSplineType' of "
-                "this camera to 'LIN_POS_SPLINE' which would perform a SfM-based calibration!!! Do "
-                "not forget to change its weight!",
-                topic, freq);
-        }
-    }
-
-    for (const auto &[topic, _] : Configor::DataStream::RGBDTopics) {
-        auto freq = GetRGBDAvgFrequency(topic);
-        spdlog::info("sampling frequency for rgbd camera '{}': {:.3f}", topic, freq);
-        if (freq < 29.0) {
-            throw Status(Status::WARNING,
-                         "Sampling frequency of rgbd camera '{}' (freq: {:.3f}) is too small!!! "
-                         "Frequency larger than 30 Hz is required!!! Please throw the depth "
-                         "information and treat it an optical camera, and perform "
-                         "'LIN_POS_SPLINE'-based calibration.",
-                         topic, freq);
-        }
-    }
 }
 
 void CalibDataManager::AdjustCalibDataSequence() {
@@ -525,34 +663,24 @@ void CalibDataManager::AdjustCalibDataSequence() {
     }
 
     for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
-        // remove imu frames that are before the start time stamp
-        EraseSeqHeadData(
+        // remove imu frames that are before the start time stamp or after the end one
+        TrimSeqData(
             _imuMes.at(topic),
             [this](const IMUFrame::Ptr &frame) {
                 return frame->GetTimestamp() > _rawStartTimestamp;
             },
-            "the imu data is invalid, there is no intersection.");
-
-        // remove imu frames that are after the end time stamp
-        EraseSeqTailData(
-            _imuMes.at(topic),
             [this](const IMUFrame::Ptr &frame) { return frame->GetTimestamp() < _rawEndTimestamp; },
             "the imu data is invalid, there is no intersection.");
     }
 
     for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
-        // remove radar frames that are before the start time stamp
-        EraseSeqHeadData(
+        // remove radar frames that are before the start time stamp or after the end one
+        TrimSeqData(
             _radarMes.at(topic),
             [this](const RadarTargetArray::Ptr &frame) {
                 return frame->GetTimestamp() >
                        _rawStartTimestamp + 2 * Configor::Prior::TimeOffsetPadding;
             },
-            "the radar data is invalid, there is no intersection between imu data and radar data.");
-
-        // remove radar frames that are after the end time stamp
-        EraseSeqTailData(
-            _radarMes.at(topic),
             [this](const RadarTargetArray::Ptr &frame) {
                 return frame->GetTimestamp() <
                        _rawEndTimestamp - 2 * Configor::Prior::TimeOffsetPadding;
@@ -561,8 +689,8 @@ void CalibDataManager::AdjustCalibDataSequence() {
     }
 
     for (const auto &[topic, _] : Configor::DataStream::LiDARTopics) {
-        // remove lidar frames that are before the start time stamp
-        EraseSeqHeadData(
+        // remove lidar frames that are before the start time stamp or after the end one
+        TrimSeqData(
             _lidarMes.at(topic),
             [this](const LiDARFrame::Ptr &frame) {
                 // different from other sensor, a time offset padding is used here
@@ -570,11 +698,6 @@ void CalibDataManager::AdjustCalibDataSequence() {
                 return frame->GetTimestamp() >
                        _rawStartTimestamp + 2 * Configor::Prior::TimeOffsetPadding;
             },
-            "the lidar data is invalid, there is no intersection between imu data and lidar data.");
-
-        // remove lidar frames that are after the end time stamp
-        EraseSeqTailData(
-            _lidarMes.at(topic),
             [this](const LiDARFrame::Ptr &frame) {
                 return frame->GetTimestamp() <
                        _rawEndTimestamp - 2 * Configor::Prior::TimeOffsetPadding;
@@ -583,8 +706,8 @@ void CalibDataManager::AdjustCalibDataSequence() {
     }
 
     for (const auto &[topic, _] : Configor::DataStream::CameraTopics) {
-        // remove camera frames that are before the start time stamp
-        EraseSeqHeadData(
+        // remove camera frames that are before the start time stamp or after the end one
+        TrimSeqData(
             _camMes.at(topic),
             [this](const CameraFrame::Ptr &frame) {
                 // different from other sensor, a time offset padding is used here
@@ -592,12 +715,6 @@ void CalibDataManager::AdjustCalibDataSequence() {
                 return frame->GetTimestamp() >
                        _rawStartTimestamp + 2 * Configor::Prior::TimeOffsetPadding;
             },
-            "the camera data is invalid, there is no intersection between imu data and lidar "
-            "data.");
-
-        // remove camera frames that are after the end time stamp
-        EraseSeqTailData(
-            _camMes.at(topic),
             [this](const CameraFrame::Ptr &frame) {
                 return frame->GetTimestamp() <
                        _rawEndTimestamp - 2 * Configor::Prior::TimeOffsetPadding;
@@ -607,18 +724,13 @@ void CalibDataManager::AdjustCalibDataSequence() {
     }
 
     for (const auto &[topic, _] : Configor::DataStream::RGBDTopics) {
-        // remove rgbd frames that are before the start time stamp
-        EraseSeqHeadData(
+        // remove rgbd frames that are before the start time stamp or after the end one
+        TrimSeqData(
             _rgbdMes.at(topic),
             [this](const RGBDFrame::Ptr &frame) {
                 return frame->GetTimestamp() >
                        _rawStartTimestamp + 2 * Configor::Prior::TimeOffsetPadding;
             },
-            "the rgbd data is invalid, there is no intersection between imu data and rgbd data.");
-
-        // remove rgbd frames that are after the end time stamp
-        EraseSeqTailData(
-            _rgbdMes.at(topic),
             [this](const RGBDFrame::Ptr &frame) {
                 return frame->GetTimestamp() <
                        _rawEndTimestamp - 2 * Configor::Prior::TimeOffsetPadding;
@@ -627,18 +739,13 @@ void CalibDataManager::AdjustCalibDataSequence() {
     }
 
     for (const auto &[topic, _] : Configor::DataStream::EventTopics) {
-        // remove event data arrays that are before the start time stamp
-        EraseSeqHeadData(
+        // remove event data arrays that are before the start time stamp or after the end one
+        TrimSeqData(
             _eventMes.at(topic),
             [this](const EventArray::Ptr &ary) {
                 return ary->GetTimestamp() >
                        _rawStartTimestamp + 2 * Configor::Prior::TimeOffsetPadding;
             },
-            "the event data is invalid, there is no intersection between imu data and event data.");
-
-        // remove event data arrays that are after the end time stamp
-        EraseSeqTailData(
-            _eventMes.at(topic),
             [this](const EventArray::Ptr &ary) {
                 return ary->GetTimestamp() <
                        _rawEndTimestamp - 2 * Configor::Prior::TimeOffsetPadding;
@@ -660,22 +767,32 @@ void CalibDataManager::AlignTimestamp() {
             frame->SetTimestamp(frame->GetTimestamp() - _rawStartTimestamp);
         }
     }
-    for (const auto &[radarTopic, mes] : _radarMes) {
-        for (const auto &array : mes) {
-            // array
-            array->SetTimestamp(array->GetTimestamp() - _rawStartTimestamp);
-            // targets
-            for (auto &tar : array->GetTargets()) {
-                tar->SetTimestamp(tar->GetTimestamp() - _rawStartTimestamp);
-            }
+    /**
+     * this function is performed after 'AdjustCalibDataSequence', thus only the kept data are
+     * shifted. Radar targets and lidar points (the bulk of the data) are shifted frame-wise in
+     * parallel, while events are shifted lazily by the time bases of their arrays
+     */
+    const double rawStartTimestamp = _rawStartTimestamp;
+    for (const auto &radarMes : _radarMes) {
+        // structured bindings can not be shared in the parallel region
+        const auto &mes = radarMes.second;
+        const int count = static_cast<int>(mes.size());
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(count, mes, rawStartTimestamp)
+        for (int i = 0; i < count; ++i) {
+            // the array and its targets
+            mes.at(i)->ShiftTimestamps(-rawStartTimestamp);
         }
     }
-    for (const auto &[topic, data] : _lidarMes) {
-        for (const auto &item : data) {
-            item->SetTimestamp(item->GetTimestamp() - _rawStartTimestamp);
-            for (auto &p : *item->GetScan()) {
-                p.timestamp -= _rawStartTimestamp;
-            }
+    for (const auto &lidarMes : _lidarMes) {
+        const auto &data = lidarMes.second;
+        const int count = static_cast<int>(data.size());
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(count, data, rawStartTimestamp)
+        for (int i = 0; i < count; ++i) {
+            // point times are relative to the frame, and would be shifted along with it
+            const auto &item = data.at(i);
+            item->SetTimestamp(item->GetTimestamp() - rawStartTimestamp);
         }
     }
     for (auto &[camTopic, mes] : _camMes) {
@@ -690,54 +807,140 @@ void CalibDataManager::AlignTimestamp() {
     }
     for (const auto &[eventTopic, mes] : _eventMes) {
         for (const auto &array : mes) {
-            // array
-            array->SetTimestamp(array->GetTimestamp() - _rawStartTimestamp);
-            // targets
-            for (auto &tar : array->GetEvents()) {
-                tar->SetTimestamp(tar->GetTimestamp() - _rawStartTimestamp);
+            // both the array and its events, event times are relative to a base one
+            array->ShiftTimestamps(-_rawStartTimestamp);
+        }
+    }
+    OutputDataStatus();
+}
+
+void CalibDataManager::WindowByExcitation() {
+    const double target = Configor::Preference::TargetInfoPerSecond;
+    if (target <= 0.0) {
+        return;
+    }
+    StageProfiler::Scope stageScope("WindowByExcitation");
+    spdlog::info("thin low-excitation windows of calibration data, target info per second: {:.3f}",
+                 target);
+
+    // the information rate of a window: max(angular score, linear score / gravity norm)
+    const auto windows = IMUExcitation::Evaluate(_imuMes.at(Configor::DataStream::ReferIMU),
+                                                 Configor::Preference::ExcitationWindowLength);
+    /**
+     * kept segments are padded by the margin used in 'AdjustCalibDataSequence', i.e., data of
+     * other sensors in a kept segment are still covered by the imu data of the segment under
+     * time offsets. Gaps shorter than a window are bridged
+     */
+    auto segments = IMUExcitation::ExcitedSegments(
+        windows, target, target * Configor::Prior::GravityNorm,
+        2 * Configor::Prior::TimeOffsetPadding, Configor::Preference::ExcitationWindowLength);
+    if (segments.empty()) {
+        spdlog::warn(
+            "no window of the reference imu reaches the target info per second ({:.3f}), "
+            "all data are kept! Please lower 'Preference::TargetInfoPerSecond'",
+            target);
+        return;
+    }
+    double keptTime = 0.0;
+    for (const auto &[st, et] : segments) {
+        keptTime += et - st;
+    }
+    const double totalTime = _alignedEndTimestamp - _alignedStartTimestamp;
+    spdlog::info("{} excited segments kept, duration {:.3f}(s) of {:.3f}(s) ({:.1f}%)",
+                 segments.size(), keptTime, totalTime, 100.0 * keptTime / totalTime);
+    if (keptTime >= totalTime) {
+        return;
+    }
+
+    // imus are decimated (rather than dropped) in thinned windows to keep the spline constrained
+    for (auto &[topic, mes] : _imuMes) {
+        std::vector<IMUFrame::Ptr> kept;
+        kept.reserve(mes.size());
+        int thinnedCount = 0;
+        for (auto &frame : mes) {
+            if (InSegments(segments, frame->GetTimestamp()) ||
+                thinnedCount++ % Configor::Preference::LowExcitationIMUDecimation == 0) {
+                kept.push_back(std::move(frame));
             }
         }
+        mes = std::move(kept);
     }
+
+    auto keepSegmentData = [&segments](auto &mesMap) {
+        for (auto &[topic, mes] : mesMap) {
+            KeepSegmentData(mes, segments);
+            if (mes.empty()) {
+                throw Status(Status::ERROR,
+                             "the data of '{}' are all in low-excitation windows! Please lower "
+                             "'Preference::TargetInfoPerSecond'",
+                             topic);
+            }
+        }
+    };
+    keepSegmentData(_radarMes);
+    keepSegmentData(_lidarMes);
+    keepSegmentData(_camMes);
+    keepSegmentData(_rgbdMes);
+    keepSegmentData(_eventMes);
+
     OutputDataStatus();
 }
 
+bool CalibDataManager::InSegments(const std::vector<std::pair<double, double>> &segments,
+                                  double time) {
+    auto iter = std::upper_bound(segments.cbegin(), segments.cend(), time,
+                                 [](double t, const auto &seg) { return t < seg.first; });
+    return iter != segments.cbegin() && time <= std::prev(iter)->second;
+}
+
 void CalibDataManager::OutputDataStatus() const {
+    // heap bytes of each sequence (see 'MemoryUsage'), i.e., frames and the vector holding them
+    auto seqBytes = [](const auto &seq) {
+        return MemoryUsage::SharedSeqBytes(
+            seq, [](const auto &frame) { return frame->GetMemoryBytes(); });
+    };
+    // imu frames are plain data, packed in storages (see 'IMUSampleStore::PackFrames')
+    auto imuSeqBytes = [](const std::vector<IMUFrame::Ptr> &seq) {
+        return IMUSampleStore::PackedFramesBytes(seq);
+    };
+    std::map<std::string, std::size_t> typeBytes;
+    auto logTopic = [&typeBytes](const std::string &type, const std::string &topic,
+                                 const auto &mes, std::size_t bytes) {
+        typeBytes[type] += bytes;
+        spdlog::info(
+            "{} topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' (s), "
+            "memory: '{}'",
+            type, topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp(),
+            MemoryUsage::Format(bytes));
+    };
+
     spdlog::info("calibration data info:");
     for (const auto &[topic, mes] : _imuMes) {
-        spdlog::info(
-            "IMU topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' (s)",
-            topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp());
+        logTopic("IMU", topic, mes, imuSeqBytes(mes));
     }
     for (const auto &[topic, mes] : _radarMes) {
-        spdlog::info(
-            "Radar topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' "
-            "(s)",
-            topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp());
+        logTopic("Radar", topic, mes, seqBytes(mes));
     }
     for (const auto &[topic, mes] : _lidarMes) {
-        spdlog::info(
-            "LiDAR topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' "
-            "(s)",
-            topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp());
+        logTopic("LiDAR", topic, mes, seqBytes(mes));
     }
     for (const auto &[topic, mes] : _camMes) {
-        spdlog::info(
-            "Camera topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' "
-            "(s)",
-            topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp());
+        logTopic("Camera", topic, mes, seqBytes(mes));
     }
     for (const auto &[topic, mes] : _rgbdMes) {
-        spdlog::info(
-            "RGBD topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' "
-            "(s)",
-            topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp());
+        logTopic("RGBD", topic, mes, seqBytes(mes));
     }
     for (const auto &[topic, mes] : _eventMes) {
-        spdlog::info(
-            "Event topic: '{}', data size: '{:06}', time span: from '{:+010.5f}' to '{:+010.5f}' "
-            "(s)",
-            topic, mes.size(), mes.front()->GetTimestamp(), mes.back()->GetTimestamp());
+        logTopic("Event", topic, mes, seqBytes(mes));
+    }
+    std::size_t totalBytes = 0;
+    std::string typeInfo;
+    for (const auto &[type, bytes] : typeBytes) {
+        totalBytes += bytes;
+        typeInfo += fmt::format(", {}: '{}'", type, MemoryUsage::Format(bytes));
     }
+    spdlog::info("memory of calibration data, total: '{}'{}", MemoryUsage::Format(totalBytes),
+                 typeInfo);
     spdlog::info("raw start time: '{:+010.5f}' (s), raw end time: '{:+010.5f}' (s)",
                  GetRawStartTimestamp(), GetRawEndTimestamp());
     spdlog::info("aligned start time: '{:+010.5f}' (s), aligned end time: '{:+010.5f}' (s)",
@@ -745,13 +948,227 @@ void CalibDataManager::OutputDataStatus() const {
     spdlog::info("calib start time: '{:+010.5f}' (s), calib end time: '{:+010.5f}' (s)\n",
                  GetCalibStartTimestamp(), GetCalibEndTimestamp());
 }
-std::uint32_t CalibDataManager::MessageNumInTopic(const rosbag::Bag *bag,
-                                                  const std::string &topic,
-                                                  const ros::Time &begTime,
-                                                  const ros::Time &endTime) {
-    auto view = rosbag::View();
-    view.addQuery(*bag, rosbag::TopicQuery({topic}), begTime, endTime);
-    return view.size();
+std::map<std::string, CalibDataManager::TopicIndex> CalibDataManager::BuildTopicIndex(
+    rosbag::View &view) {
+    std::map<std::string, TopicIndex> topicIndex;
+    // only the index entries are iterated here, no message data is read
+    for (const auto &item : view) {
+        auto &index = topicIndex[item.getTopic()];
+        if (index.mesCount == 0) {
+            index.begTime = item.getTime();
+        }
+        index.endTime = item.getTime();
+        ++index.mesCount;
+    }
+    return topicIndex;
+}
+
+std::vector<bool> CalibDataManager::DecimateMessages(rosbag::View &view,
+                                                     const DataLoaderPack &loaders) {
+    const auto &decimation = Configor::DataStream::TopicDecimation;
+    if (decimation.empty()) {
+        return {};
+    }
+    // the rotation prior is integrated from the reference imu only if it is required
+    const bool useRotation = std::any_of(decimation.cbegin(), decimation.cend(), [](const auto &p) {
+        return p.second.MinRotation > 0.0;
+    });
+    const auto &imuTopic = Configor::DataStream::ReferIMU;
+    const auto &imuLoader = loaders.imuDataLoaders.at(imuTopic);
+
+    struct DecimationState {
+        long lastBin = -1;
+        double lastAngle = 0.0;
+        std::uint32_t kept = 0, dropped = 0;
+    };
+    std::map<std::string, DecimationState> states;
+
+    std::vector<bool> keep;
+    // the accumulated rotation angle (rad) of the reference imu, messages are ordered by time
+    double angle = 0.0, lastImuTime = -1.0;
+    const double begTime = view.getBeginTime().toSec();
+    for (const auto &item : view) {
+        const auto &topic = item.getTopic();
+        const double t = item.getTime().toSec();
+        if (useRotation && topic == imuTopic) {
+            const auto frame = imuLoader->UnpackFrame(item);
+            if (frame != nullptr) {
+                if (lastImuTime >= 0.0) {
+                    angle += frame->GetGyro().norm() * (t - lastImuTime);
+                }
+                lastImuTime = t;
+            }
+            keep.push_back(true);
+            continue;
+        }
+        auto iter = decimation.find(topic);
+        if (iter == decimation.cend()) {
+            keep.push_back(true);
+            continue;
+        }
+        const auto &config = iter->second;
+        auto &state = states[topic];
+
+        bool isKept = true;
+        long bin = state.lastBin;
+        if (config.Rate > 0.0) {
+            bin = static_cast<long>(std::floor((t - begTime) * config.Rate));
+            isKept = bin > state.lastBin;
+        }
+        if (isKept && state.kept > 0 && config.MinRotation > 0.0) {
+            isKept = angle - state.lastAngle >= config.MinRotation * IMUDataLoader::DEG_TO_RAD;
+        }
+        if (isKept) {
+            state.lastBin = bin;
+            state.lastAngle = angle;
+            ++state.kept;
+        } else {
+            ++state.dropped;
+        }
+        keep.push_back(isKept);
+    }
+    for (const auto &[topic, state] : states) {
+        spdlog::info("topic '{}' is decimated at load time, '{}' kept and '{}' dropped", topic,
+                     state.kept, state.dropped);
+    }
+    return keep;
+}
+
+std::vector<std::unique_ptr<rosbag::Bag>> CalibDataManager::OpenBags(
+    const std::vector<std::string> &bagPaths) {
+    std::vector<std::unique_ptr<rosbag::Bag>> bags;
+    for (const auto &bagPath : bagPaths) {
+        if (!std::filesystem::exists(bagPath)) {
+            spdlog::error("the ros bag path '{}' is invalid!", bagPath);
+            continue;
+        }
+        auto bag = std::make_unique<rosbag::Bag>();
+        bag->open(bagPath, rosbag::BagMode::Read);
+        bags.push_back(std::move(bag));
+    }
+    return bags;
+}
+
+cv::Mat CalibDataManager::RGBDFramePairing::ColorImageOf(const CameraFrame::Ptr &colorFrame) {
+    // rgbd frames of grey-only color frames derive their color images on demand as well
+    return colorFrame->IsGreyOnly() ? cv::Mat() : colorFrame->GetColorImage();
+}
+
+void CalibDataManager::RGBDFramePairing::PushColor(const CameraFrame::Ptr &colorFrame) {
+    const double timestamp = colorFrame->GetTimestamp();
+    // find a matched depth image for current color image
+    auto iter = std::find_if(depthPending.begin(), depthPending.end(),
+                             [timestamp](const DepthFrame::Ptr &depthFrame) {
+                                 return std::abs(depthFrame->GetTimestamp() - timestamp) <
+                                        MatchTimeDistance;
+                             });
+    if (iter != depthPending.end()) {
+        rgbdMes.push_back(RGBDFrame::Create(timestamp,                    // timestamp
+                                            colorFrame->GetImage(),       // grey image
+                                            ColorImageOf(colorFrame),     // color image
+                                            (*iter)->GetDepthImage(),     // depth image
+                                            colorFrame->GetId()           // image index
+                                            ));
+        // remove this depth image
+        depthPending.erase(iter);
+    } else {
+        colorPending.push_back(colorFrame);
+        if (colorPending.size() > PendingCapacity) {
+            colorStray.push_back(colorPending.front());
+            colorPending.pop_front();
+        }
+    }
+}
+
+void CalibDataManager::RGBDFramePairing::PushDepth(const DepthFrame::Ptr &depthFrame) {
+    const double timestamp = depthFrame->GetTimestamp();
+    // find a matched color image for current depth image
+    auto iter = std::find_if(colorPending.begin(), colorPending.end(),
+                             [timestamp](const CameraFrame::Ptr &colorFrame) {
+                                 return std::abs(colorFrame->GetTimestamp() - timestamp) <
+                                        MatchTimeDistance;
+                             });
+    if (iter != colorPending.end()) {
+        const auto &colorFrame = *iter;
+        rgbdMes.push_back(RGBDFrame::Create(colorFrame->GetTimestamp(),   // timestamp
+                                            colorFrame->GetImage(),       // grey image
+                                            ColorImageOf(colorFrame),     // color image
+                                            depthFrame->GetDepthImage(),  // depth image
+                                            colorFrame->GetId()           // image index
+                                            ));
+        // remove this color image
+        colorPending.erase(iter);
+    } else {
+        depthPending.push_back(depthFrame);
+        if (depthPending.size() > PendingCapacity) {
+            depthStray.push_back(depthPending.front());
+            depthPending.pop_front();
+        }
+    }
+}
+
+void CalibDataManager::RGBDFramePairing::Finish() {
+    colorStray.insert(colorStray.end(), colorPending.begin(), colorPending.end());
+    depthStray.insert(depthStray.end(), depthPending.begin(), depthPending.end());
+    colorPending.clear(), depthPending.clear();
+}
+
+void CalibDataManager::UnpackMessage(const rosbag::MessageInstance &item,
+                                     const DataLoaderPack &loaders,
+                                     UnpackedMesPiece &piece) {
+    const std::string &topic = item.getTopic();
+    if (auto iter = loaders.imuDataLoaders.find(topic); iter != loaders.imuDataLoaders.cend()) {
+        // is an inertial frame
+        iter->second->UnpackFrame(item, piece.imuMes[topic]);
+    } else if (auto iter = loaders.radarDataLoaders.find(topic);
+               iter != loaders.radarDataLoaders.cend()) {
+        // is a radar frame
+        auto mes = iter->second->UnpackScan(item);
+        if (mes != nullptr) {
+            piece.radarMes[topic].push_back(mes);
+        }
+    } else if (auto iter = loaders.lidarDataLoaders.find(topic);
+               iter != loaders.lidarDataLoaders.cend()) {
+        // is a lidar frame
+        auto mes = iter->second->UnpackScan(item);
+        if (mes != nullptr) {
+            piece.lidarMes[topic].push_back(mes);
+        }
+    } else if (auto iter = loaders.rgbdColorDataLoaders.find(topic);
+               iter != loaders.rgbdColorDataLoaders.cend()) {
+        // is a rgbd color frame
+        auto mes = iter->second->UnpackFrame(item);
+        if (mes != nullptr) {
+            // id: uint64_t from timestamp (raw, millisecond)
+            mes->SetId(static_cast<ns_veta::IndexT>(mes->GetTimestamp() * 1E3));
+            piece.rgbdPairing[topic].PushColor(mes);
+        }
+    } else if (auto iter = loaders.rgbdDepthDataLoaders.find(topic);
+               iter != loaders.rgbdDepthDataLoaders.cend()) {
+        // is a rgbd depth frame
+        auto mes = iter->second->UnpackFrame(item);
+        if (mes != nullptr) {
+            // id: uint64_t from timestamp (raw, millisecond)
+            mes->SetId(static_cast<ns_veta::IndexT>(mes->GetTimestamp() * 1E3));
+            piece.rgbdPairing[loaders.rgbdDepthToColorTopic.at(topic)].PushDepth(mes);
+        }
+    } else if (auto iter = loaders.cameraDataLoaders.find(topic);
+               iter != loaders.cameraDataLoaders.cend()) {
+        // is a camera frame
+        auto mes = iter->second->UnpackFrame(item);
+        if (mes != nullptr) {
+            // id: uint64_t from timestamp (raw, millisecond)
+            mes->SetId(static_cast<ns_veta::IndexT>(mes->GetTimestamp() * 1E3));
+            piece.camMes[topic].push_back(mes);
+        }
+    } else if (auto iter = loaders.eventDataLoaders.find(topic);
+               iter != loaders.eventDataLoaders.cend()) {
+        // is an event array
+        auto mes = iter->second->UnpackData(item);
+        if (mes != nullptr) {
+            piece.eventMes[topic].push_back(mes);
+        }
+    }
 }
 
 // -----------
@@ -760,6 +1177,7 @@ std::uint32_t CalibDataManager::MessageNumInTopic(const rosbag::Bag *bag,
 
 void CalibDataManager::SetVisualFeatureTrackingCurve(
     const std::string &visualTopic, const std::vector<FeatureTrackingCurvePtr> &dynamics) {
+    std::lock_guard<std::mutex> lock(_derivedDataMutex);
     _visualFeatTrackingCurve[visualTopic] = dynamics;
 }
 
@@ -890,34 +1308,57 @@ const std::vector<EventArray::Ptr> &CalibDataManager::GetEventMeasurements(
     return _eventMes.at(eventTopic);
 }
 
+void CalibDataManager::ReleaseEventMeasurements() {
+    for (auto &[topic, mes] : _eventMes) {
+        std::size_t eventCount = 0;
+        for (const auto &ary : mes) {
+            eventCount += ary->GetEventCount();
+        }
+        // swap with an empty one to free the memory actually
+        std::vector<EventArray::Ptr>().swap(mes);
+        spdlog::info("raw event measurements of '{}' are released, event count: '{}'", topic,
+                     eventCount);
+    }
+}
+
 const std::map<std::string, ns_veta::Veta::Ptr> &CalibDataManager::GetSfMData() const {
     return _sfmData;
 }
 
 const ns_veta::Veta::Ptr &CalibDataManager::GetSfMData(const std::string &camTopic) const {
+    std::lock_guard<std::mutex> lock(_derivedDataMutex);
     return _sfmData.at(camTopic);
 }
 
 void CalibDataManager::SetSfMData(const std::string &camTopic, const ns_veta::Veta::Ptr &veta) {
+    std::lock_guard<std::mutex> lock(_derivedDataMutex);
     _sfmData[camTopic] = veta;
 }
 void CalibDataManager::SetVisualOpticalFlowTrace(
     const std::string &visualTopic, const std::vector<OpticalFlowTripleTrace::Ptr> &dynamics) {
+    std::lock_guard<std::mutex> lock(_derivedDataMutex);
     _visualOpticalFlowTrace[visualTopic] = dynamics;
 }
 
+const std::map<std::string, std::vector<FeatureTrackingCurvePtr>> &
+CalibDataManager::GetVisualFeatureTrackingCurve() const {
+    return _visualFeatTrackingCurve;
+}
+
 const std::vector<FeatureTrackingCurvePtr> &CalibDataManager::GetVisualFeatureTrackingCurve(
     const std::string &visualTopic) const {
+    std::lock_guard<std::mutex> lock(_derivedDataMutex);
     return _visualFeatTrackingCurve.at(visualTopic);
 }
 
-// const std::map<std::string, std::vector<OpticalFlowTripleTrace::Ptr>> &
-// CalibDataManager::GetVisualOpticalFlowTrace() const {
-//     return _visualOpticalFlowTrace;
-// }
+const std::map<std::string, std::vector<OpticalFlowTripleTrace::Ptr>> &
+CalibDataManager::GetVisualOpticalFlowTrace() const {
+    return _visualOpticalFlowTrace;
+}
 
 const std::vector<OpticalFlowTripleTrace::Ptr> &CalibDataManager::GetVisualOpticalFlowTrace(
     const std::string &visualTopic) const {
+    std::lock_guard<std::mutex> lock(_derivedDataMutex);
     return _visualOpticalFlowTrace.at(visualTopic);
 }
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -502,8 +502,9 @@ std::vector<ns_viewer::Entity::Ptr> CalibParamManager::EntitiesForVisualization(
                                     ns_viewer::Colour::Black());
         entities.push_back(line);
         ns_viewer::Entity::Ptr lidar;
-        if (EnumCast::stringToEnum<LidarModelType>(
-                Configor::DataStream::LiDARTopics.at(topic).Type) == LidarModelType::LIVOX_CUSTOM) {
+        // models of plugin loaders are not enumerated, thus strings are compared here
+        if (Configor::DataStream::LiDARTopics.at(topic).Type ==
+            EnumCast::enumToString(LidarModelType::LIVOX_CUSTOM)) {
             lidar = ns_viewer::LivoxLiDAR::Create(
                 ns_viewer::Posef(SE3_LkToBr.so3().matrix(), SE3_LkToBr.translation()), LiDAR_SIZE,
                 ns_viewer::Colour(0.33f, 0.33f, 0.5f, 1.0f));
@@ -33,9 +33,13 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "calib/ceres_callback.h"
-#include "viewer/viewer.h"
+#include "viewer/viewer_bridge.h"
 #include "calib/calib_param_manager.h"
+#include "calib/flat_param_io.h"
 #include "spdlog/spdlog.h"
+#include "util/trace_recorder.h"
+#include "cereal/archives/binary.hpp"
+#include "sstream"
 
 namespace ns_ikalibr{
 
@@ -46,7 +50,12 @@ namespace ns_ikalibr{
 CeresDebugCallBack::CeresDebugCallBack(CalibParamManager::Ptr calibParamManager)
     : _parMagr(std::move(calibParamManager)),
       _outputDir(Configor::DataStream::OutputPath + "/iteration/epoch"),
-      _idx(0) {
+      _idx(0),
+      _iterCount(0),
+      _ring(std::max<std::size_t>(Configor::Preference::ParamDumpBufferCapacity, 1)),
+      _head(0),
+      _size(0),
+      _stop(false) {
     if (std::filesystem::exists(_outputDir)) {
         std::filesystem::remove_all(_outputDir);
     }
@@ -57,34 +66,108 @@ CeresDebugCallBack::CeresDebugCallBack(CalibParamManager::Ptr calibParamManager)
         _iterInfoFile = std::ofstream(_outputDir + "/epoch_info.csv", std::ios::out);
         _iterInfoFile << "cost,gradient,tr_radius(1/lambda)" << std::endl;
     }
+    {
+        // the camera models are only copied here, as the flat layout only involves estimates
+        std::stringstream stream;
+        {
+            cereal::BinaryOutputArchive ar(stream);
+            ar(*_parMagr);
+        }
+        _dumpParMagr = CalibParamManager::Create();
+        cereal::BinaryInputArchive ar(stream);
+        ar(*_dumpParMagr);
+    }
+    _writer = std::thread(&CeresDebugCallBack::RunWriter, this);
 }
 
 ceres::CallbackReturnType CeresDebugCallBack::operator()(const ceres::IterationSummary &summary) {
+    if (_iterCount++ % std::max(Configor::Preference::ParamDumpInterval, 1) != 0) {
+        return ceres::SOLVER_CONTINUE;
+    }
     if (std::filesystem::exists(_outputDir)) {
-        // save param
-        const std::string paramFilename = _outputDir + "/ikalibr_param_" + std::to_string(_idx) +
-                                          ns_ikalibr::Configor::GetFormatExtension();
-        _parMagr->Save(paramFilename, ns_ikalibr::Configor::Preference::OutputDataFormat);
-
-        // save iter info
-        _iterInfoFile << _idx << ',' << summary.cost << ',' << summary.gradient_norm << ','
-                      << summary.trust_region_radius << std::endl;
+        // snapshot param, which is dumped by the writer
+        IterSnapshot snapshot{_idx, summary.cost, summary.gradient_norm,
+                              summary.trust_region_radius,
+                              FlatParamIO::SerializeParams(_parMagr)};
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return _size < _ring.size(); });
+            _ring.at((_head + _size) % _ring.size()) = std::move(snapshot);
+            ++_size;
+        }
+        _cv.notify_all();
 
         ++_idx;
     }
     return ceres::SOLVER_CONTINUE;
 }
 
-CeresDebugCallBack::~CeresDebugCallBack() { _iterInfoFile.close(); }
+void CeresDebugCallBack::RunWriter() {
+    while (true) {
+        IterSnapshot snapshot;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return _stop || _size != 0; });
+            if (_size == 0) {
+                // stopped, and all snapshots are dumped
+                break;
+            }
+            snapshot = std::move(_ring.at(_head));
+            _head = (_head + 1) % _ring.size();
+            --_size;
+        }
+        _cv.notify_all();
+
+        try {
+            FlatParamIO::DeserializeParams(snapshot.param, _dumpParMagr);
+            // save param
+            const std::string paramFilename = _outputDir + "/ikalibr_param_" +
+                                              std::to_string(snapshot.idx) +
+                                              ns_ikalibr::Configor::GetFormatExtension();
+            _dumpParMagr->Save(paramFilename, ns_ikalibr::Configor::Preference::OutputDataFormat);
+
+            // save iter info
+            _iterInfoFile << snapshot.idx << ',' << snapshot.cost << ',' << snapshot.gradient
+                          << ',' << snapshot.trRadius << '\n';
+        } catch (const std::exception &e) {
+            spdlog::warn("dump parameters of iteration '{}' failed: '{}'", snapshot.idx, e.what());
+        }
+    }
+    _iterInfoFile.flush();
+}
+
+CeresDebugCallBack::~CeresDebugCallBack() {
+    // pending snapshots are dumped before the writer quits
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_writer.joinable()) {
+        _writer.join();
+    }
+    _iterInfoFile.close();
+}
+
+// ------------------
+// CeresTraceCallBack
+// ------------------
+ceres::CallbackReturnType CeresTraceCallBack::operator()(const ceres::IterationSummary &summary) {
+    const auto duration = static_cast<std::int64_t>(summary.iteration_time_in_seconds * 1E6);
+    TraceRecorder::Complete("ceres", fmt::format("Iteration{}", summary.iteration),
+                            TraceRecorder::NowMicros() - duration, duration);
+    TraceRecorder::Counter("ceres", "Cost", summary.cost);
+    return ceres::SOLVER_CONTINUE;
+}
 
 // -------------------
 // CeresViewerCallBack
 // -------------------
-CeresViewerCallBack::CeresViewerCallBack(Viewer::Ptr viewer)
-    : _viewer(std::move(viewer)) {}
+CeresViewerCallBack::CeresViewerCallBack(ViewerBridge::Ptr bridge)
+    : _bridge(std::move(bridge)) {}
 
 ceres::CallbackReturnType CeresViewerCallBack::operator()(const ceres::IterationSummary &summary) {
-    _viewer->UpdateSensorViewer().UpdateSplineViewer();
+    _bridge->Publish();
     return ceres::CallbackReturnType::SOLVER_CONTINUE;
 }
 
@@ -0,0 +1,193 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/data_lifetime_planner.h"
+#include "config/configor.h"
+#include "spdlog/spdlog.h"
+#include "filesystem"
+#include "fstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+DataLifetimePlanner::DataLifetimePlanner(CalibDataManager::Ptr dataMagr,
+                                         TimeDeriv::ScaleSplineType scaleType,
+                                         int batchOptCount)
+    : _dataMagr(std::move(dataMagr)) {
+    const auto &outputs = Configor::Preference::Outputs;
+    // outputs rendering camera images, see 'CalibSolverIO'
+    const bool imageOutput = IsOptionWith(OutputOption::VisualKinematics, outputs) ||
+                             IsOptionWith(OutputOption::VisualLiDARCovisibility, outputs) ||
+                             IsOptionWith(OutputOption::ColorizedLiDARMap, outputs);
+    // vetas are created from the pixel dynamics in the finalization, which renders colors
+    const bool posSpline = scaleType == TimeDeriv::LIN_POS_SPLINE;
+
+    for (const auto &[topic, _] : Configor::DataStream::PosCameraTopics()) {
+        _lifetimes.push_back({Payload::CAMERA_IMAGE, topic,
+                              imageOutput ? Stage::OUTPUT : Stage::INITIALIZATION, false});
+    }
+    for (const auto &[topic, _] : Configor::DataStream::VelCameraTopics()) {
+        Stage lastUse = Stage::INITIALIZATION;
+        if (imageOutput) {
+            lastUse = Stage::OUTPUT;
+        } else if (posSpline) {
+            lastUse = Stage::FINALIZATION;
+        }
+        _lifetimes.push_back({Payload::CAMERA_IMAGE, topic, lastUse, false});
+    }
+    for (const auto &[topic, _] : Configor::DataStream::RGBDTopics) {
+        // depth maps are used in data association of each batch optimization
+        Stage lastUse = batchOptCount > 0 ? Stage::BATCH_OPTIMIZATION : Stage::INITIALIZATION;
+        if (imageOutput || IsOptionWith(OutputOption::VisualMaps, outputs)) {
+            lastUse = Stage::OUTPUT;
+        } else if (posSpline) {
+            lastUse = Stage::FINALIZATION;
+        }
+        _lifetimes.push_back({Payload::RGBD_IMAGE, topic, lastUse, false});
+    }
+}
+
+DataLifetimePlanner::Ptr DataLifetimePlanner::Create(const CalibDataManager::Ptr &dataMagr,
+                                                     TimeDeriv::ScaleSplineType scaleType,
+                                                     int batchOptCount) {
+    return std::make_shared<DataLifetimePlanner>(dataMagr, scaleType, batchOptCount);
+}
+
+void DataLifetimePlanner::OnStageFinished(Stage stage) {
+    const auto [rssBefore, _] = ResidentSetSize();
+    std::size_t releasedCount = 0;
+    if (Configor::Preference::ReleaseConsumedData) {
+        for (auto &lifetime : _lifetimes) {
+            // the stage may be skipped (e.g., resumed from a checkpoint), where 'lastUse' is passed
+            if (lifetime.released || lifetime.lastUse > stage) {
+                continue;
+            }
+            int spilled = Release(lifetime);
+            lifetime.released = true;
+            ++releasedCount;
+            spdlog::info("payload '{}' of '{}' is released after stage '{}', spilled frames: {}",
+                         lifetime.payload == Payload::CAMERA_IMAGE ? "image" : "rgbd",
+                         lifetime.topic, StageName(stage), spilled);
+        }
+    }
+    const auto [rss, peak] = ResidentSetSize();
+    if (rss < 0.0) {
+        return;
+    }
+    if (releasedCount != 0) {
+        spdlog::info(
+            "memory after stage '{}': current RSS {:.1f} MB ({:.1f} MB before releasing {} "
+            "payload(s)), peak RSS {:.1f} MB",
+            StageName(stage), rss, rssBefore, releasedCount, peak);
+    } else {
+        spdlog::info("memory after stage '{}': current RSS {:.1f} MB, peak RSS {:.1f} MB",
+                     StageName(stage), rss, peak);
+    }
+}
+
+int DataLifetimePlanner::Release(const Lifetime &lifetime) const {
+    if (lifetime.payload == Payload::RGBD_IMAGE) {
+        for (const auto &frame : _dataMagr->GetRGBDMeasurements(lifetime.topic)) {
+            frame->ReleaseMat();
+        }
+        return 0;
+    }
+    const auto &frames = _dataMagr->GetCameraMeasurements(lifetime.topic);
+    std::string spillDir;
+    if (Configor::Preference::SpillReleasedImages) {
+        spillDir = Configor::DataStream::OutputPath + "/spill" + lifetime.topic;
+        if (std::error_code ec; !std::filesystem::create_directories(spillDir, ec) && ec) {
+            spdlog::warn("create spill dir '{}' failed, images would be dropped", spillDir);
+            spillDir.clear();
+        }
+    }
+    int spilled = 0;
+    for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
+        const auto &frame = frames.at(i);
+        // lazy frames keep their payload, and are decoded again on demand
+        if (!spillDir.empty() && !frame->IsLazy() &&
+            frame->SpillToDisk(spillDir + "/" + std::to_string(i) + ".png")) {
+            ++spilled;
+        } else {
+            frame->ReleaseMat();
+        }
+    }
+    return spilled;
+}
+
+void DataLifetimePlanner::PrintPlan() const {
+    for (const auto &lifetime : _lifetimes) {
+        spdlog::info("payload '{}' of '{}' would be kept until stage '{}'",
+                     lifetime.payload == Payload::CAMERA_IMAGE ? "image" : "rgbd", lifetime.topic,
+                     StageName(lifetime.lastUse));
+    }
+}
+
+const std::vector<DataLifetimePlanner::Lifetime> &DataLifetimePlanner::GetLifetimes() const {
+    return _lifetimes;
+}
+
+std::pair<double, double> DataLifetimePlanner::ResidentSetSize() {
+    // in kB, see 'man proc'
+    std::ifstream file("/proc/self/status");
+    double rss = -1.0, peak = -1.0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            rss = std::stod(line.substr(6)) / 1024.0;
+        } else if (line.rfind("VmHWM:", 0) == 0) {
+            peak = std::stod(line.substr(6)) / 1024.0;
+        }
+    }
+    return {rss, peak};
+}
+
+std::string DataLifetimePlanner::StageName(Stage stage) {
+    switch (stage) {
+        case Stage::INITIALIZATION:
+            return "initialization";
+        case Stage::BATCH_OPTIMIZATION:
+            return "batch optimization";
+        case Stage::FINALIZATION:
+            return "finalization";
+        case Stage::OUTPUT:
+            return "output";
+    }
+    return "unknown";
+}
+
+}  // namespace ns_ikalibr
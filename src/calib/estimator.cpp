@@ -54,6 +54,13 @@
 #include "factor/vel_visual_inertial_align_factor.hpp"
 #include "factor/norm_flow_pure_rot_factor.hpp"
 #include "factor/ppp_trifocal_tensor_factor.hpp"
+#include "factor/consensus_factor.hpp"
+#include "factor/marginal_prior_factor.hpp"
+#include "factor/spat_temp_priori_factor.hpp"
+#include "factor/data_correspondence.h"
+#include "util/stage_profiler.h"
+#include "chrono"
+#include "algorithm"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -67,7 +74,12 @@ std::shared_ptr<ceres::SphereManifold<3>> Estimator::GRAVITY_MANIFOLD(
     new ceres::SphereManifold<3>());
 
 ceres::Problem::Options Estimator::DefaultProblemOptions() {
-    return ns_ctraj::TrajectoryEstimator<Configor::Prior::SplineOrder>::DefaultProblemOptions();
+    auto options =
+        ns_ctraj::TrajectoryEstimator<Configor::Prior::SplineOrder>::DefaultProblemOptions();
+    // cost functions and loss functions are kept in the arena of the estimator (released in bulk)
+    options.cost_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    options.loss_function_ownership = ceres::DO_NOT_TAKE_OWNERSHIP;
+    return options;
 }
 
 ceres::Solver::Options Estimator::DefaultSolverOptions(int threadNum, bool toStdout, bool useCUDA) {
@@ -81,26 +93,446 @@ ceres::Solver::Options Estimator::DefaultSolverOptions(int threadNum, bool toStd
     return defaultSolverOptions;
 }
 
-Estimator::Estimator(SplineBundleType::Ptr splines, CalibParamManager::Ptr calibParamManager)
-    : ceres::Problem(DefaultProblemOptions()),
+const std::string Estimator::PRIORI_RESIDUAL_GROUP = "SPAT_TEMP_PRIORI";
+
+Estimator::Estimator(SplineBundleType::Ptr splines,
+                     CalibParamManager::Ptr calibParamManager,
+                     const ceres::Problem::Options &options)
+    : ceres::Problem(options),
       splines(std::move(splines)),
-      parMagr(std::move(calibParamManager)) {}
+      parMagr(std::move(calibParamManager)),
+      metaCache(SplineMetaCache::GetCache(this->splines)),
+      involvedSplines({this->splines}),
+      ownCostFunctions(options.cost_function_ownership == ceres::TAKE_OWNERSHIP),
+      ownLossFunctions(options.loss_function_ownership == ceres::TAKE_OWNERSHIP),
+      factorProfiler(nullptr) {}
 
 Estimator::Ptr Estimator::Create(const SplineBundleType::Ptr &splines,
-                                 const CalibParamManager::Ptr &calibParamManager) {
-    return std::make_shared<Estimator>(splines, calibParamManager);
+                                 const CalibParamManager::Ptr &calibParamManager,
+                                 const ceres::Problem::Options &options) {
+    return std::make_shared<Estimator>(splines, calibParamManager, options);
+}
+
+ceres::Problem::Options Estimator::PersistentProblemOptions() {
+    auto options = DefaultProblemOptions();
+    options.enable_fast_removal = true;
+    // residual groups are removed and re-added, their cost functions should be released with them
+    options.cost_function_ownership = ceres::TAKE_OWNERSHIP;
+    return options;
 }
 
 ceres::Solver::Summary Estimator::Solve(const ceres::Solver::Options &options,
                                         const SpatialTemporalPriori::Ptr &priori) {
-    if (priori != nullptr) {
-        priori->AddSpatTempPrioriConstraint(*this, *parMagr);
+    StageProfiler::Scope stageScope("EstimatorSolve");
+    AddPrioriConstraints(priori);
+    ceres::Solver::Summary summary;
+    auto solverOptions = options;
+    OrganizeSchurOrdering(solverOptions);
+    if (factorProfiler != nullptr) {
+        factorProfiler->ResetEvaluations();
+    }
+    ceres::Solve(solverOptions, this, &summary);
+    if (factorProfiler != nullptr) {
+        spdlog::info("factor evaluation profile of this solving:\n{}", factorProfiler->Summary());
+    }
+    CountSolverSummary(summary);
+    ReleaseOutdatedPreintegrations();
+    return summary;
+}
+
+ceres::Solver::Summary Estimator::SolveBySchurElimination(
+    const std::set<double *> &eliminated,
+    const ceres::Solver::Options &options,
+    const SpatialTemporalPriori::Ptr &priori) {
+    StageProfiler::Scope stageScope("EstimatorSchurSolve");
+    const auto wallStart = std::chrono::steady_clock::now();
+    AddPrioriConstraints(priori);
+
+    // variable parameter blocks: [ kept | eliminated ]
+    std::vector<double *> allParBlocks, keptParBlocks, elimParBlocks;
+    this->GetParameterBlocks(&allParBlocks);
+    for (double *parBlock : allParBlocks) {
+        if (this->IsParameterBlockConstant(parBlock)) {
+            continue;
+        }
+        (eliminated.count(parBlock) != 0 ? elimParBlocks : keptParBlocks).push_back(parBlock);
+    }
+    std::vector<double *> parBlocks = keptParBlocks;
+    parBlocks.insert(parBlocks.end(), elimParBlocks.cbegin(), elimParBlocks.cend());
+    int keptSize = 0, paramSize = 0;
+    for (double *parBlock : keptParBlocks) {
+        keptSize += this->ParameterBlockTangentSize(parBlock);
     }
+    for (double *parBlock : parBlocks) {
+        paramSize += this->ParameterBlockSize(parBlock);
+    }
+
+    ceres::Problem::EvaluateOptions evalOpt;
+    evalOpt.parameter_blocks = parBlocks;
+    evalOpt.num_threads = options.num_threads;
+
     ceres::Solver::Summary summary;
-    ceres::Solve(options, this, &summary);
+    summary.num_residual_blocks = this->NumResidualBlocks();
+    summary.num_residuals = this->NumResiduals();
+    summary.num_parameter_blocks = static_cast<int>(allParBlocks.size());
+    summary.num_parameter_blocks_reduced = static_cast<int>(parBlocks.size());
+    summary.num_parameters_reduced = paramSize;
+    summary.num_threads_used = options.num_threads;
+    summary.termination_type = ceres::NO_CONVERGENCE;
+
+    double cost = 0.0;
+    this->Evaluate(evalOpt, &cost, nullptr, nullptr, nullptr);
+    summary.initial_cost = summary.final_cost = cost;
+
+    // the damping of levenberg-marquardt, relative to the diagonal of the hessian matrix
+    double lambda = 1.0 / options.initial_trust_region_radius;
+    std::vector<double> backup(paramSize);
+    for (int iter = 0; iter < options.max_num_iterations; ++iter) {
+        std::vector<double> residuals;
+        ceres::CRSMatrix jacobianCRSMatrix;
+        this->Evaluate(evalOpt, &cost, &residuals, nullptr, &jacobianCRSMatrix);
+        Eigen::Map<const Eigen::SparseMatrix<double, Eigen::RowMajor, int>> JMat(
+            jacobianCRSMatrix.num_rows, jacobianCRSMatrix.num_cols,
+            static_cast<int>(jacobianCRSMatrix.values.size()), jacobianCRSMatrix.rows.data(),
+            jacobianCRSMatrix.cols.data(), jacobianCRSMatrix.values.data());
+        const Eigen::Map<const Eigen::VectorXd> rVec(residuals.data(),
+                                                     static_cast<long>(residuals.size()));
+        const Eigen::VectorXd gVec = JMat.transpose() * rVec;
+
+        const auto linearStart = std::chrono::steady_clock::now();
+        Eigen::SparseMatrix<double> HMat = JacobianToHessian(JMat, options.num_threads);
+        for (int i = 0; i < HMat.cols(); ++i) {
+            HMat.coeffRef(i, i) += lambda * std::max(HMat.coeff(i, i), 1E-12);
+        }
+        const int elimSize = static_cast<int>(HMat.cols()) - keptSize;
+        const Eigen::VectorXd gVecK = gVec.head(keptSize), gVecE = gVec.tail(elimSize);
+
+        Eigen::VectorXd delta(HMat.cols());
+        Eigen::MatrixXd HMatKK = HMat.topLeftCorner(keptSize, keptSize);
+        if (elimSize == 0) {
+            delta = HMatKK.ldlt().solve(-gVecK);
+        } else {
+            const Eigen::SparseMatrix<double> HMatEE = HMat.bottomRightCorner(elimSize, elimSize);
+            const Eigen::MatrixXd HMatEK = HMat.bottomLeftCorner(elimSize, keptSize);
+            Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(HMatEE);
+            if (solver.info() != Eigen::Success) {
+                summary.termination_type = ceres::FAILURE;
+                summary.message = "the eliminated parameter blocks are not fully constrained";
+                break;
+            }
+            // H_ee^(-1) * H_ek, and H_ee^(-1) * g_e
+            const Eigen::MatrixXd HMatEEInvEK = solver.solve(HMatEK);
+            const Eigen::VectorXd gVecEEInv = solver.solve(gVecE);
+            // the Schur complement: (H_kk - H_ke * H_ee^(-1) * H_ek) * dx_k = -g_k + H_ke * ...
+            HMatKK -= HMatEK.transpose() * HMatEEInvEK;
+            delta.head(keptSize) = HMatKK.ldlt().solve(-gVecK + HMatEK.transpose() * gVecEEInv);
+            // back substitution: dx_e = -H_ee^(-1) * (g_e + H_ek * dx_k)
+            delta.tail(elimSize) = -gVecEEInv - HMatEEInvEK * delta.head(keptSize);
+        }
+        summary.linear_solver_time_in_seconds +=
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - linearStart).count();
+
+        // apply the step on manifolds, parameters are backed up in case the step is rejected
+        for (int i = 0, stateIdx = 0, deltaIdx = 0; i < static_cast<int>(parBlocks.size()); ++i) {
+            double *parBlock = parBlocks.at(i);
+            const int size = this->ParameterBlockSize(parBlock);
+            std::copy_n(parBlock, size, backup.data() + stateIdx);
+            if (const auto *manifold = this->GetManifold(parBlock); manifold != nullptr) {
+                manifold->Plus(backup.data() + stateIdx, delta.data() + deltaIdx, parBlock);
+            } else {
+                for (int j = 0; j < size; ++j) {
+                    parBlock[j] += delta(deltaIdx + j);
+                }
+            }
+            stateIdx += size, deltaIdx += this->ParameterBlockTangentSize(parBlock);
+        }
+        double newCost = 0.0;
+        this->Evaluate(evalOpt, &newCost, nullptr, nullptr, nullptr);
+
+        ceres::IterationSummary iterSummary;
+        iterSummary.iteration = iter + 1;
+        iterSummary.step_is_successful = newCost < cost;
+        iterSummary.cost = std::min(newCost, cost);
+        iterSummary.cost_change = cost - newCost;
+        iterSummary.gradient_max_norm = gVec.lpNorm<Eigen::Infinity>();
+        iterSummary.step_norm = delta.norm();
+        iterSummary.trust_region_radius = 1.0 / lambda;
+        summary.iterations.push_back(iterSummary);
+
+        if (iterSummary.step_is_successful) {
+            lambda = std::max(lambda / 10.0, 1E-12);
+            summary.final_cost = newCost;
+        } else {
+            // reject this step
+            for (int i = 0, stateIdx = 0; i < static_cast<int>(parBlocks.size()); ++i) {
+                const int size = this->ParameterBlockSize(parBlocks.at(i));
+                std::copy_n(backup.data() + stateIdx, size, parBlocks.at(i));
+                stateIdx += size;
+            }
+            lambda *= 10.0;
+        }
+        for (auto *callback : options.callbacks) {
+            (*callback)(iterSummary);
+        }
+        if (iterSummary.step_is_successful &&
+            iterSummary.cost_change < options.function_tolerance * cost) {
+            summary.termination_type = ceres::CONVERGENCE;
+            break;
+        }
+        if (lambda > 1.0 / options.min_trust_region_radius) {
+            summary.termination_type = ceres::CONVERGENCE;
+            summary.message = "the damping exceeds the one of 'min_trust_region_radius'";
+            break;
+        }
+    }
+    summary.total_time_in_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    CountSolverSummary(summary);
+    ReleaseOutdatedPreintegrations();
     return summary;
 }
 
+void Estimator::AddPrioriConstraints(const SpatialTemporalPriori::Ptr &priori) {
+    if (priori == nullptr) {
+        return;
+    }
+    // priori constraints added in the last solving (if reused) are replaced
+    RemoveResidualGroup(PRIORI_RESIDUAL_GROUP);
+    const std::string lastGroup = curResidualGroup;
+    SetResidualGroup(PRIORI_RESIDUAL_GROUP);
+    priori->AddSpatTempPrioriConstraint(*this, *parMagr);
+    SetResidualGroup(lastGroup);
+}
+
+void Estimator::ReleaseOutdatedPreintegrations() {
+    if (preintegrations.empty()) {
+        return;
+    }
+    // the rotations stored in preintegration tables are out of date if the so3 spline varied
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+        auto knot = const_cast<double *>(so3Spline.GetKnot(i).data());
+        if (this->HasParameterBlock(knot) && !this->IsParameterBlockConstant(knot)) {
+            preintegrations.clear();
+            break;
+        }
+    }
+}
+
+void Estimator::CountSolverSummary(const ceres::Solver::Summary &summary) {
+    // counters are named by the stage of this solving, e.g., 'Process/BatchOptimization0/...'
+    const std::string prefix = StageProfiler::CurrentStage() + "/Solver/";
+    const std::pair<std::string, double> counters[] = {
+        // seconds
+        {"ResidualEvaluationTime", summary.residual_evaluation_time_in_seconds},
+        {"JacobianEvaluationTime", summary.jacobian_evaluation_time_in_seconds},
+        {"LinearSolverTime", summary.linear_solver_time_in_seconds},
+        {"TotalTime", summary.total_time_in_seconds},
+        // the problem size, the reduced ones are optimized (see 'PrintParameterInfo')
+        {"ResidualBlocks", summary.num_residual_blocks},
+        {"Residuals", summary.num_residuals},
+        {"ParameterBlocks", summary.num_parameter_blocks},
+        {"OptimizedParameterBlocks", summary.num_parameter_blocks_reduced},
+        {"OptimizedParameters", summary.num_parameters_reduced},
+        {"Iterations", static_cast<double>(summary.iterations.size())},
+    };
+    for (const auto &[name, value] : counters) {
+        StageProfiler::Count(prefix + name, value);
+    }
+}
+
+void Estimator::EnableFactorProfiler() {
+    if (factorProfiler == nullptr) {
+        factorProfiler = FactorProfiler::Create();
+    }
+}
+
+const FactorProfiler::Ptr &Estimator::GetFactorProfiler() const { return factorProfiler; }
+
+std::map<std::string, int> Estimator::FactorCounts() const {
+    std::vector<ceres::ResidualBlockId> resBlocks;
+    this->GetResidualBlocks(&resBlocks);
+    std::map<std::string, int> counts;
+    for (const auto &resBlock : resBlocks) {
+        const ceres::CostFunction *costFunc = this->GetCostFunctionForResidualBlock(resBlock);
+        // the profiled factor is counted as the wrapped one
+        if (auto profiled = dynamic_cast<const ProfiledCostFunction *>(costFunc);
+            profiled != nullptr) {
+            costFunc = profiled->GetWrapped();
+        }
+        ++counts[FactorProfiler::FactorName(typeid(*costFunc))];
+    }
+    return counts;
+}
+
+const std::map<std::string, InertialPreintegration::Ptr> &Estimator::GetInertialPreintegrations()
+    const {
+    return preintegrations;
+}
+
+void Estimator::SetInertialPreintegrations(
+    const std::map<std::string, InertialPreintegration::Ptr> &tables) {
+    preintegrations = tables;
+}
+
+void Estimator::SetTemporalPadding(const TemporalPadding &padding) { temporalPadding = padding; }
+
+const TemporalPadding &Estimator::GetTemporalPadding() const { return temporalPadding; }
+
+void Estimator::SwitchSplines(const SplineBundleType::Ptr &newSplines) {
+    if (newSplines == splines) {
+        return;
+    }
+    splines = newSplines;
+    metaCache = SplineMetaCache::GetCache(splines);
+    if (std::find(involvedSplines.cbegin(), involvedSplines.cend(), splines) ==
+        involvedSplines.cend()) {
+        involvedSplines.push_back(splines);
+    }
+    preintegrations.clear();
+}
+
+void Estimator::OrganizeSchurOrdering(ceres::Solver::Options &options) {
+    if (!ceres::IsSchurType(options.linear_solver_type) ||
+        options.linear_solver_ordering != nullptr) {
+        return;
+    }
+    // elimination groups, the landmark group is eliminated first
+    constexpr int LANDMARK_GROUP = 0, KNOTS_GROUP = 1, CALIB_GROUP = 2;
+
+    std::set<double *> knots;
+    for (const auto &bundle : involvedSplines) {
+        const auto &so3Spline = bundle->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+        for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+            knots.insert(const_cast<double *>(so3Spline.GetKnot(i).data()));
+        }
+        const auto &scaleSpline = bundle->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+        for (int i = 0; i < static_cast<int>(scaleSpline.GetKnots().size()); ++i) {
+            knots.insert(const_cast<double *>(scaleSpline.GetKnot(i).data()));
+        }
+    }
+    const auto calibParBlocks = CalibParameterBlocks();
+
+    std::vector<double *> parBlocks;
+    this->GetParameterBlocks(&parBlocks);
+
+    auto ordering = std::make_shared<ceres::ParameterBlockOrdering>();
+    std::set<double *> landmarks;
+    // the dimension of the reduced camera matrix
+    std::size_t reducedDim = 0;
+    for (double *parBlock : parBlocks) {
+        if (knots.count(parBlock) != 0) {
+            ordering->AddElementToGroup(parBlock, KNOTS_GROUP);
+        } else if (calibParBlocks.count(parBlock) != 0) {
+            ordering->AddElementToGroup(parBlock, CALIB_GROUP);
+        } else {
+            // inverse depths, depths, and other per-landmark parameters
+            ordering->AddElementToGroup(parBlock, LANDMARK_GROUP);
+            landmarks.insert(parBlock);
+            continue;
+        }
+        if (!this->IsParameterBlockConstant(parBlock)) {
+            reducedDim += this->ParameterBlockTangentSize(parBlock);
+        }
+    }
+
+    if (options.linear_solver_type == ceres::DENSE_SCHUR &&
+        reducedDim > Configor::Preference::DenseSchurDimensionMax) {
+        // the dense reduced camera matrix would be too large for long sequences
+        if (options.sparse_linear_algebra_library_type != ceres::NO_SPARSE) {
+            options.linear_solver_type = ceres::SPARSE_SCHUR;
+        } else {
+            options.linear_solver_type = ceres::ITERATIVE_SCHUR;
+            options.preconditioner_type = ceres::SCHUR_JACOBI;
+        }
+        spdlog::info("reduced camera matrix dimension '{}' exceeds '{}', use '{}' for solving",
+                     reducedDim, Configor::Preference::DenseSchurDimensionMax,
+                     ceres::LinearSolverTypeToString(options.linear_solver_type));
+    }
+
+    // if there are no landmarks, ceres would find an independent set of knots to eliminate
+    if (landmarks.empty()) {
+        return;
+    }
+    // the first elimination group must be an independent set
+    std::vector<ceres::ResidualBlockId> resBlocks;
+    this->GetResidualBlocks(&resBlocks);
+    std::vector<double *> resParBlocks;
+    for (const auto &resBlock : resBlocks) {
+        this->GetParameterBlocksForResidualBlock(resBlock, &resParBlocks);
+        auto count = std::count_if(resParBlocks.cbegin(), resParBlocks.cend(),
+                                   [&landmarks](double *p) { return landmarks.count(p) != 0; });
+        if (count > 1) {
+            return;
+        }
+    }
+    options.linear_solver_ordering = ordering;
+}
+
+std::set<double *> Estimator::CalibParameterBlocks() const {
+    std::set<double *> parBlocks;
+    auto InsertMap = [&parBlocks](auto &parMap) {
+        for (auto &[topic, par] : parMap) {
+            parBlocks.insert(par.data());
+        }
+    };
+    auto InsertTOMap = [&parBlocks](auto &parMap) {
+        for (auto &[topic, par] : parMap) {
+            parBlocks.insert(&par);
+        }
+    };
+
+    // extrinsics
+    InsertMap(parMagr->EXTRI.SO3_BiToBr);
+    InsertMap(parMagr->EXTRI.POS_BiInBr);
+    InsertMap(parMagr->EXTRI.SO3_RjToBr);
+    InsertMap(parMagr->EXTRI.POS_RjInBr);
+    InsertMap(parMagr->EXTRI.SO3_LkToBr);
+    InsertMap(parMagr->EXTRI.POS_LkInBr);
+    InsertMap(parMagr->EXTRI.SO3_CmToBr);
+    InsertMap(parMagr->EXTRI.POS_CmInBr);
+    InsertMap(parMagr->EXTRI.SO3_DnToBr);
+    InsertMap(parMagr->EXTRI.POS_DnInBr);
+    InsertMap(parMagr->EXTRI.SO3_EsToBr);
+    InsertMap(parMagr->EXTRI.POS_EsInBr);
+
+    // time offsets and readout times
+    InsertTOMap(parMagr->TEMPORAL.TO_BiToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_RjToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_LkToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_CmToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_DnToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_EsToBr);
+    InsertTOMap(parMagr->TEMPORAL.RS_READOUT);
+
+    // intrinsics
+    for (auto &[topic, intri] : parMagr->INTRI.IMU) {
+        parBlocks.insert(intri->GYRO.BIAS.data());
+        parBlocks.insert(intri->GYRO.MAP_COEFF.data());
+        parBlocks.insert(intri->ACCE.BIAS.data());
+        parBlocks.insert(intri->ACCE.MAP_COEFF.data());
+        parBlocks.insert(intri->SO3_AtoG.data());
+    }
+    auto InsertPinhole = [&parBlocks](const ns_veta::PinholeIntrinsic::Ptr &intri) {
+        parBlocks.insert(intri->FXAddress());
+        parBlocks.insert(intri->FYAddress());
+        parBlocks.insert(intri->CXAddress());
+        parBlocks.insert(intri->CYAddress());
+    };
+    for (auto &[topic, intri] : parMagr->INTRI.Camera) {
+        InsertPinhole(intri);
+    }
+    for (auto &[topic, intri] : parMagr->INTRI.RGBD) {
+        InsertPinhole(intri->intri);
+        parBlocks.insert(&intri->alpha);
+        parBlocks.insert(&intri->beta);
+    }
+
+    // gravity
+    parBlocks.insert(parMagr->GRAVITY.data());
+    return parBlocks;
+}
+
 void Estimator::AddRdKnotsData(std::vector<double *> &paramBlockVec,
                                const Estimator::SplineBundleType::RdSplineType &spline,
                                const Estimator::SplineMetaType &splineMeta,
@@ -176,6 +608,7 @@ Eigen::MatrixXd Estimator::CRSMatrix2EigenMatrix(ceres::CRSMatrix *jacobian_crs_
 /**
  * param blocks:
  * [ SO3 | ... | SO3 | GYRO_BIAS | GYRO_MAP_COEFF | SO3_AtoG | SO3_BiToBr | TO_BiToBr ]
+ * or [ SO3 | ... | SO3 | SO3_BiToBr | TO_BiToBr ] if intrinsics are frozen
  */
 void Estimator::AddIMUGyroMeasurement(const IMUFrame::Ptr &imuFrame,
                                       const std::string &topic,
@@ -188,15 +621,14 @@ void Estimator::AddIMUGyroMeasurement(const IMUFrame::Ptr &imuFrame,
     // for the inertial measurements from the reference IMU, there is no need to consider a time
     // padding, as its time offsets would be fixed as identity
     if (IsOptionWith(Opt::OPT_TO_BiToBr, option) && Configor::DataStream::ReferIMU != topic) {
-        double minTime = imuFrame->GetTimestamp() - Configor::Prior::TimeOffsetPadding;
-        double maxTime = imuFrame->GetTimestamp() + Configor::Prior::TimeOffsetPadding;
+        double minTime = imuFrame->GetTimestamp() - temporalPadding.TimeOffset(topic);
+        double maxTime = imuFrame->GetTimestamp() + temporalPadding.TimeOffset(topic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(minTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(maxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{minTime, maxTime}},
-                                        so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{minTime, maxTime}}, so3Meta);
     } else {
         double curTime = imuFrame->GetTimestamp() + parMagr->TEMPORAL.TO_BiToBr.at(topic);
 
@@ -204,32 +636,649 @@ void Estimator::AddIMUGyroMeasurement(const IMUFrame::Ptr &imuFrame,
         if (!splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}},
-                                        so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}}, so3Meta);
     }
 
     // create a cost function
-    auto costFunc =
-        IMUGyroFactor<Configor::Prior::SplineOrder>::Create(so3Meta, imuFrame, gyroWeight);
+    const bool intriFrozen = IsGyroIntriFrozen(option);
+    ceres::CostFunction *costFunc;
+    if (intriFrozen) {
+        using FactorType = IMUGyroFactor<Configor::Prior::SplineOrder, true>;
+        const auto &intri = parMagr->INTRI.IMU.at(topic);
+        const double timestamp = imuFrame->GetTimestamp();
+        const Eigen::Vector3d gyro = intri->RemoveGyroIntri(imuFrame->GetGyro());
+        const Eigen::Matrix3d intriMat = intri->GyroIntriMatrix();
+        if (so3Meta.NumParameters() == Configor::Prior::SplineOrder) {
+            costFunc = FactorType::CreateSized(so3Meta, timestamp, gyro, intriMat, gyroWeight);
+        } else {
+            auto dynCostFunc =
+                FactorType::Create(so3Meta, timestamp, gyro, intriMat, gyroWeight);
+
+            // so3 knots param block [each has four sub params]
+            for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+                dynCostFunc->AddParameterBlock(4);
+            }
+            // SO3_BiToBr
+            dynCostFunc->AddParameterBlock(4);
+            // TIME_OFFSET_BiToBc
+            dynCostFunc->AddParameterBlock(1);
+
+            // set Residuals
+            dynCostFunc->SetNumResiduals(3);
+            costFunc = dynCostFunc;
+        }
+    } else if (so3Meta.NumParameters() == Configor::Prior::SplineOrder) {
+        // the time offset is not padded, the fixed-size cost function is much faster
+        costFunc = IMUGyroFactor<Configor::Prior::SplineOrder>::CreateSized(so3Meta, imuFrame,
+                                                                            gyroWeight);
+    } else {
+        auto dynCostFunc =
+            IMUGyroFactor<Configor::Prior::SplineOrder>::Create(so3Meta, imuFrame, gyroWeight);
 
-    // so3 knots param block [each has four sub params]
-    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
-        costFunc->AddParameterBlock(4);
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+
+        // GYRO gyroBias
+        dynCostFunc->AddParameterBlock(3);
+        // GYRO map coeff
+        dynCostFunc->AddParameterBlock(6);
+        // SO3_AtoG
+        dynCostFunc->AddParameterBlock(4);
+        // SO3_BiToBr
+        dynCostFunc->AddParameterBlock(4);
+        // TIME_OFFSET_BiToBc
+        dynCostFunc->AddParameterBlock(1);
+
+        // set Residuals
+        dynCostFunc->SetNumResiduals(3);
+        costFunc = dynCostFunc;
     }
 
-    // GYRO gyroBias
-    costFunc->AddParameterBlock(3);
-    // GYRO map coeff
-    costFunc->AddParameterBlock(6);
-    // SO3_AtoG
-    costFunc->AddParameterBlock(4);
+    AddIMUGyroResidualBlock(costFunc, so3Meta, topic, option, intriFrozen);
+}
+
+void Estimator::AddIMUGyroMeasurements(const std::vector<IMUFrame::Ptr> &imuFrames,
+                                       const std::string &topic,
+                                       Opt option,
+                                       double gyroWeight) {
+    // if the time offset is padded, the involved knots vary from sample to sample
+    if (IsOptionWith(Opt::OPT_TO_BiToBr, option) && Configor::DataStream::ReferIMU != topic) {
+        for (const auto &imuFrame : imuFrames) {
+            AddIMUGyroMeasurement(imuFrame, topic, option, gyroWeight);
+        }
+        return;
+    }
+
+    /**
+     * frozen intrinsics are removed from all measurements at once, the corrected measurement of
+     * the i-th frame is the i-th column
+     */
+    const bool intriFrozen = IsGyroIntriFrozen(option);
+    Eigen::Matrix3Xd gyros;
+    Eigen::Matrix3d intriMat;
+    if (intriFrozen) {
+        const auto &intri = parMagr->INTRI.IMU.at(topic);
+        gyros.resize(3, static_cast<Eigen::Index>(imuFrames.size()));
+        for (int i = 0; i < static_cast<int>(imuFrames.size()); ++i) {
+            gyros.col(i) = imuFrames[i]->GetGyro();
+        }
+        gyros = intri->RemoveGyroIntriBatch(gyros);
+        intriMat = intri->GyroIntriMatrix();
+    }
+
+    // samples falling into the same spline segment are organized as one residual block
+    SplineMetaType so3Meta;
+    std::vector<IMUFrame::Ptr> segFrames;
+    std::vector<int> segIndices;
+    auto addSegment = [this, &so3Meta, &segFrames, &segIndices, &gyros, &intriMat, &topic, option,
+                       gyroWeight, intriFrozen]() {
+        if (segFrames.empty()) {
+            return;
+        }
+        ceres::CostFunction *costFunc;
+        if (intriFrozen) {
+            Eigen::Matrix3Xd segGyros(3, static_cast<Eigen::Index>(segIndices.size()));
+            for (int i = 0; i < static_cast<int>(segIndices.size()); ++i) {
+                segGyros.col(i) = gyros.col(segIndices[i]);
+            }
+            costFunc = IMUGyroBatchFactor<Configor::Prior::SplineOrder, true>::Create(
+                so3Meta, segFrames, segGyros, intriMat, gyroWeight);
+        } else {
+            costFunc = IMUGyroBatchFactor<Configor::Prior::SplineOrder>::Create(
+                so3Meta, segFrames, gyroWeight);
+        }
+        AddIMUGyroResidualBlock(costFunc, so3Meta, topic, option, intriFrozen);
+        segFrames.clear();
+        segIndices.clear();
+    };
+
+    const double TO_BiToBr = parMagr->TEMPORAL.TO_BiToBr.at(topic);
+    for (int i = 0; i < static_cast<int>(imuFrames.size()); ++i) {
+        const auto &imuFrame = imuFrames[i];
+        double curTime = imuFrame->GetTimestamp() + TO_BiToBr;
+
+        // check point time stamp
+        if (!splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE)) {
+            continue;
+        }
+        SplineMetaType curSo3Meta;
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{curTime, curTime}}, curSo3Meta);
+        if (curSo3Meta.NumParameters() != Configor::Prior::SplineOrder) {
+            // unexpected knot window, add it separately
+            AddIMUGyroMeasurement(imuFrame, topic, option, gyroWeight);
+            continue;
+        }
+        if (!segFrames.empty() && curSo3Meta.segments.front().t0 != so3Meta.segments.front().t0) {
+            addSegment();
+        }
+        if (segFrames.empty()) {
+            so3Meta = curSo3Meta;
+        }
+        segFrames.push_back(imuFrame);
+        segIndices.push_back(i);
+    }
+    addSegment();
+}
+
+void Estimator::CalculateSo3SplineMeta(const std::string &name,
+                                       SplineMetaCache::TimeInitList times,
+                                       SplineMetaType &splineMeta) {
+    if (!metaCache->Find(name, times, splineMeta)) {
+        splines->CalculateSo3SplineMeta(name, times, splineMeta);
+        metaCache->Insert(name, times, splineMeta);
+    }
+}
+
+void Estimator::CalculateRdSplineMeta(const std::string &name,
+                                      SplineMetaCache::TimeInitList times,
+                                      SplineMetaType &splineMeta) {
+    if (!metaCache->Find(name, times, splineMeta)) {
+        splines->CalculateRdSplineMeta(name, times, splineMeta);
+        metaCache->Insert(name, times, splineMeta);
+    }
+}
+
+bool Estimator::IsGyroIntriFrozen(Opt option) {
+    return Configor::Preference::PreCorrectFrozenIMUIntri &&
+           !IsOptionWith(Opt::OPT_GYRO_BIAS, option) &&
+           !IsOptionWith(Opt::OPT_GYRO_MAP_COEFF, option) &&
+           !IsOptionWith(Opt::OPT_SO3_AtoG, option);
+}
+
+bool Estimator::IsAcceIntriFrozen(Opt option) {
+    return Configor::Preference::PreCorrectFrozenIMUIntri &&
+           !IsOptionWith(Opt::OPT_ACCE_BIAS, option) &&
+           !IsOptionWith(Opt::OPT_ACCE_MAP_COEFF, option);
+}
+
+void Estimator::AddIMUGyroResidualBlock(ceres::CostFunction *costFunc,
+                                        const SplineMetaType &so3Meta,
+                                        const std::string &topic,
+                                        Opt option,
+                                        bool intriFrozen) {
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    // frozen intrinsics have been removed from measurements in advance
+    auto gyroBias = parMagr->INTRI.IMU.at(topic)->GYRO.BIAS.data();
+    auto gyroMapCoeff = parMagr->INTRI.IMU.at(topic)->GYRO.MAP_COEFF.data();
+    auto SO3_AtoG = parMagr->INTRI.IMU.at(topic)->SO3_AtoG.data();
+    if (!intriFrozen) {
+        // GYRO gyroBias
+        paramBlockVec.push_back(gyroBias);
+        // GYRO map coeff
+        paramBlockVec.push_back(gyroMapCoeff);
+        // SO3_AtoG
+        paramBlockVec.push_back(SO3_AtoG);
+    }
     // SO3_BiToBr
-    costFunc->AddParameterBlock(4);
+    auto SO3_BiToBr = parMagr->EXTRI.SO3_BiToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_BiToBr);
     // TIME_OFFSET_BiToBc
-    costFunc->AddParameterBlock(1);
+    auto TIME_OFFSET_BiToBc = &parMagr->TEMPORAL.TO_BiToBr.at(topic);
+    paramBlockVec.push_back(TIME_OFFSET_BiToBc);
+
+    // pass to problem
+    this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
+
+    this->SetManifold(SO3_BiToBr, QUATER_MANIFOLD.get());
+
+    if (!intriFrozen) {
+        this->SetManifold(SO3_AtoG, QUATER_MANIFOLD.get());
+
+        if (!IsOptionWith(Opt::OPT_GYRO_BIAS, option)) {
+            this->SetParameterBlockConstant(gyroBias);
+        }
+
+        if (!IsOptionWith(Opt::OPT_GYRO_MAP_COEFF, option)) {
+            this->SetParameterBlockConstant(gyroMapCoeff);
+        }
+
+        if (!IsOptionWith(Opt::OPT_SO3_AtoG, option)) {
+            this->SetParameterBlockConstant(SO3_AtoG);
+        }
+    }
+
+    if (!IsOptionWith(Opt::OPT_SO3_BiToBr, option)) {
+        this->SetParameterBlockConstant(SO3_BiToBr);
+    }
+
+    if (!IsOptionWith(Opt::OPT_TO_BiToBr, option)) {
+        this->SetParameterBlockConstant(TIME_OFFSET_BiToBc);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TIME_OFFSET_BiToBc, 0, -temporalPadding.TimeOffset(topic));
+        this->SetParameterUpperBound(TIME_OFFSET_BiToBc, 0, temporalPadding.TimeOffset(topic));
+    }
+}
+
+void Estimator::AddIMUAcceResidualBlock(ceres::CostFunction *costFunc,
+                                        const SplineMetaType &so3Meta,
+                                        const SplineMetaType &scaleMeta,
+                                        const std::string &topic,
+                                        Opt option,
+                                        bool intriFrozen) {
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    // lin acce knots
+    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
+                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+
+    // frozen intrinsics have been removed from measurements in advance
+    auto acceBias = parMagr->INTRI.IMU.at(topic)->ACCE.BIAS.data();
+    auto aceMapCoeff = parMagr->INTRI.IMU.at(topic)->ACCE.MAP_COEFF.data();
+    if (!intriFrozen) {
+        // ACCE_BIAS
+        paramBlockVec.push_back(acceBias);
+        // ACCE_MAP_COEFF
+        paramBlockVec.push_back(aceMapCoeff);
+    }
+    // GRAVITY
+    auto gravity = parMagr->GRAVITY.data();
+    paramBlockVec.push_back(gravity);
+    // SO3_BiToBc
+    auto SO3_BiToBc = parMagr->EXTRI.SO3_BiToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_BiToBc);
+    // POS_BiInBc
+    auto POS_BiInBc = parMagr->EXTRI.POS_BiInBr.at(topic).data();
+    paramBlockVec.push_back(POS_BiInBc);
+    // TIME_OFFSET_BiToBc
+    auto TIME_OFFSET_BiToBc = &parMagr->TEMPORAL.TO_BiToBr.at(topic);
+    paramBlockVec.push_back(TIME_OFFSET_BiToBc);
+
+    // pass to problem
+    this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
+    this->SetManifold(gravity, GRAVITY_MANIFOLD.get());
+    this->SetManifold(SO3_BiToBc, QUATER_MANIFOLD.get());
+
+    if (!intriFrozen && !IsOptionWith(Opt::OPT_ACCE_BIAS, option)) {
+        this->SetParameterBlockConstant(acceBias);
+    }
+
+    if (!intriFrozen && !IsOptionWith(Opt::OPT_ACCE_MAP_COEFF, option)) {
+        this->SetParameterBlockConstant(aceMapCoeff);
+    }
+
+    if (!IsOptionWith(Opt::OPT_GRAVITY, option)) {
+        this->SetParameterBlockConstant(gravity);
+    }
+
+    if (!IsOptionWith(Opt::OPT_SO3_BiToBr, option)) {
+        this->SetParameterBlockConstant(SO3_BiToBc);
+    }
+
+    if (!IsOptionWith(Opt::OPT_POS_BiInBr, option)) {
+        this->SetParameterBlockConstant(POS_BiInBc);
+    }
+
+    if (!IsOptionWith(Opt::OPT_TO_BiToBr, option)) {
+        this->SetParameterBlockConstant(TIME_OFFSET_BiToBc);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TIME_OFFSET_BiToBc, 0, -temporalPadding.TimeOffset(topic));
+        this->SetParameterUpperBound(TIME_OFFSET_BiToBc, 0, temporalPadding.TimeOffset(topic));
+    }
+}
+
+bool Estimator::CalculateRadarSplineMeta(double timestamp,
+                                         const std::string &topic,
+                                         Opt option,
+                                         SplineMetaType &so3Meta,
+                                         SplineMetaType &scaleMeta) {
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+
+    // different relative control points finding [single vs. range]
+    if (IsOptionWith(Opt::OPT_TO_RjToBr, option)) {
+        double tMin = timestamp - temporalPadding.TimeOffset(topic);
+        double tMax = timestamp + temporalPadding.TimeOffset(topic);
+        // invalid time stamp
+        if (!splines->TimeInRange(tMin, so3Spline) || !splines->TimeInRange(tMax, so3Spline) ||
+            !splines->TimeInRange(tMin, scaleSpline) || !splines->TimeInRange(tMax, scaleSpline)) {
+            return false;
+        }
+
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{tMin, tMax}}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{tMin, tMax}}, scaleMeta);
+    } else {
+        double t = timestamp + parMagr->TEMPORAL.TO_RjToBr.at(topic);
+
+        // check point time stamp
+        if (!splines->TimeInRange(t, so3Spline) || !splines->TimeInRange(t, scaleSpline)) {
+            return false;
+        }
+
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{t, t}}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{t, t}}, scaleMeta);
+    }
+    return true;
+}
+
+ceres::ResidualBlockId Estimator::AddRadarResidualBlock(ceres::CostFunction *costFunc,
+                                                        ceres::LossFunction *lossFunc,
+                                                        const SplineMetaType &so3Meta,
+                                                        const SplineMetaType &scaleMeta,
+                                                        const std::string &topic,
+                                                        Opt option) {
+    // parameter blocks of fixed-size cost functions are given by their types
+    if (auto dynCostFunc = dynamic_cast<ceres::DynamicCostFunction *>(costFunc);
+        dynCostFunc != nullptr) {
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
+        dynCostFunc->AddParameterBlock(4);  // SO3_RtoB
+        dynCostFunc->AddParameterBlock(3);  // POS_RinB
+        dynCostFunc->AddParameterBlock(1);  // TIME_OFFSET_RtoB
+    }
+
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    // lin acce knots
+    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
+                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+
+    auto SO3_RjToBr = parMagr->EXTRI.SO3_RjToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_RjToBr);
+
+    auto POS_RjInBr = parMagr->EXTRI.POS_RjInBr.at(topic).data();
+    paramBlockVec.push_back(POS_RjInBr);
+
+    auto TO_RjToBr = &parMagr->TEMPORAL.TO_RjToBr.at(topic);
+    paramBlockVec.push_back(TO_RjToBr);
+
+    // pass to problem
+    auto id = this->AddResidualBlock(costFunc, lossFunc, paramBlockVec);
+    this->SetManifold(SO3_RjToBr, QUATER_MANIFOLD.get());
+
+    // lock param or not
+    if (!IsOptionWith(Opt::OPT_TO_RjToBr, option)) {
+        this->SetParameterBlockConstant(TO_RjToBr);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TO_RjToBr, 0, -temporalPadding.TimeOffset(topic));
+        this->SetParameterUpperBound(TO_RjToBr, 0, temporalPadding.TimeOffset(topic));
+    }
+    if (!IsOptionWith(Opt::OPT_SO3_RjToBr, option)) {
+        this->SetParameterBlockConstant(SO3_RjToBr);
+    }
+    if (!IsOptionWith(Opt::OPT_POS_RjInBr, option)) {
+        this->SetParameterBlockConstant(POS_RjInBr);
+    }
+    return id;
+}
+
+bool Estimator::CalculatePointToSurfelSplineMeta(double timestamp,
+                                                 double timeOffset,
+                                                 bool padTimeOffset,
+                                                 double timeOffsetPadding,
+                                                 SplineMetaType &so3Meta,
+                                                 SplineMetaType &scaleMeta) {
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+
+    // different relative control points finding [single vs. range]
+    if (padTimeOffset) {
+        double tMin = timestamp - timeOffsetPadding;
+        double tMax = timestamp + timeOffsetPadding;
+        // invalid time stamp
+        if (!splines->TimeInRange(tMin, so3Spline) || !splines->TimeInRange(tMax, so3Spline) ||
+            !splines->TimeInRange(tMin, scaleSpline) || !splines->TimeInRange(tMax, scaleSpline)) {
+            return false;
+        }
+
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{tMin, tMax}}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{tMin, tMax}}, scaleMeta);
+    } else {
+        double t = timestamp + timeOffset;
+
+        // check point time stamp
+        if (!splines->TimeInRange(t, so3Spline) || !splines->TimeInRange(t, scaleSpline)) {
+            return false;
+        }
+
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{t, t}}, so3Meta);
+        CalculateRdSplineMeta(Configor::Preference::SCALE_SPLINE, {{t, t}}, scaleMeta);
+    }
+    return true;
+}
+
+std::vector<Estimator::PointToSurfelGroup> Estimator::GroupPointToSurfelCorrs(
+    const PointToSurfelCorrBuffer &ptsCorrs,
+    double timeOffset,
+    bool padTimeOffset,
+    double timeOffsetPadding) {
+    const std::size_t sizeMax =
+        std::max<std::size_t>(Configor::Prior::LiDARDataAssociate::PointToSurfelGroupSizeMax, 1);
+
+    std::vector<PointToSurfelGroup> groups;
+    for (const auto &[surfelIdx, indices] : ptsCorrs.GroupBySurfel()) {
+        // the open group of each knot window of this surfel, keyed by the window
+        std::map<std::tuple<double, std::size_t, double, std::size_t>, std::size_t> windows;
+        for (const auto &idx : indices) {
+            SplineMetaType so3Meta, scaleMeta;
+            if (!CalculatePointToSurfelSplineMeta(ptsCorrs.timestamps.at(idx), timeOffset,
+                                                  padTimeOffset, timeOffsetPadding, so3Meta,
+                                                  scaleMeta)) {
+                continue;
+            }
+            auto key = std::make_tuple(so3Meta.segments.front().t0, so3Meta.NumParameters(),
+                                       scaleMeta.segments.front().t0, scaleMeta.NumParameters());
+            auto iter = windows.find(key);
+            if (iter == windows.cend() || groups.at(iter->second).indices.size() >= sizeMax) {
+                windows[key] = groups.size();
+                groups.push_back({so3Meta, scaleMeta, {idx}});
+            } else {
+                groups.at(iter->second).indices.push_back(idx);
+            }
+        }
+    }
+    return groups;
+}
+
+ceres::ResidualBlockId Estimator::AddLiDARPointToSurfelResidualBlock(
+    ceres::CostFunction *costFunc,
+    ceres::LossFunction *lossFunc,
+    const SplineMetaType &so3Meta,
+    const SplineMetaType &scaleMeta,
+    const std::string &topic,
+    Opt option) {
+    // parameter blocks of fixed-size cost functions are given by their types
+    if (auto dynCostFunc = dynamic_cast<ceres::DynamicCostFunction *>(costFunc);
+        dynCostFunc != nullptr) {
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
+        dynCostFunc->AddParameterBlock(4);  // SO3_LkToBr
+        dynCostFunc->AddParameterBlock(3);  // POS_LkInBr
+        dynCostFunc->AddParameterBlock(1);  // TO_LkToBr
+    }
+
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    // lin acce knots
+    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
+                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+
+    auto SO3_LkToBr = parMagr->EXTRI.SO3_LkToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_LkToBr);
+
+    auto POS_LkInBr = parMagr->EXTRI.POS_LkInBr.at(topic).data();
+    paramBlockVec.push_back(POS_LkInBr);
+
+    auto TO_LkToBr = &parMagr->TEMPORAL.TO_LkToBr.at(topic);
+    paramBlockVec.push_back(TO_LkToBr);
+
+    // pass to problem
+    auto id = this->AddResidualBlock(costFunc, lossFunc, paramBlockVec);
+    this->SetManifold(SO3_LkToBr, QUATER_MANIFOLD.get());
+
+    if (!IsOptionWith(Opt::OPT_SO3_LkToBr, option)) {
+        this->SetParameterBlockConstant(SO3_LkToBr);
+    }
+    if (!IsOptionWith(Opt::OPT_POS_LkInBr, option)) {
+        this->SetParameterBlockConstant(POS_LkInBr);
+    }
+    if (!IsOptionWith(Opt::OPT_TO_LkToBr, option)) {
+        this->SetParameterBlockConstant(TO_LkToBr);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TO_LkToBr, 0, -temporalPadding.TimeOffset(topic));
+        this->SetParameterUpperBound(TO_LkToBr, 0, temporalPadding.TimeOffset(topic));
+    }
+    return id;
+}
+
+ceres::ResidualBlockId Estimator::AddRGBDPointToSurfelResidualBlock(ceres::CostFunction *costFunc,
+                                                                    ceres::LossFunction *lossFunc,
+                                                                    const SplineMetaType &so3Meta,
+                                                                    const SplineMetaType &scaleMeta,
+                                                                    const std::string &topic,
+                                                                    Opt option) {
+    // parameter blocks of fixed-size cost functions are given by their types
+    if (auto dynCostFunc = dynamic_cast<ceres::DynamicCostFunction *>(costFunc);
+        dynCostFunc != nullptr) {
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
+        dynCostFunc->AddParameterBlock(4);  // SO3_DnToBr
+        dynCostFunc->AddParameterBlock(3);  // POS_DnInBr
+        dynCostFunc->AddParameterBlock(1);  // TO_DnToBr
+    }
+
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    // lin acce knots
+    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
+                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+
+    auto SO3_DnToBr = parMagr->EXTRI.SO3_DnToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_DnToBr);
+
+    auto POS_DnInBr = parMagr->EXTRI.POS_DnInBr.at(topic).data();
+    paramBlockVec.push_back(POS_DnInBr);
+
+    auto TO_DnToBr = &parMagr->TEMPORAL.TO_DnToBr.at(topic);
+    paramBlockVec.push_back(TO_DnToBr);
+
+    // pass to problem
+    auto id = this->AddResidualBlock(costFunc, lossFunc, paramBlockVec);
+    this->SetManifold(SO3_DnToBr, QUATER_MANIFOLD.get());
+
+    if (!IsOptionWith(Opt::OPT_SO3_DnToBr, option)) {
+        this->SetParameterBlockConstant(SO3_DnToBr);
+    }
+    if (!IsOptionWith(Opt::OPT_POS_DnInBr, option)) {
+        this->SetParameterBlockConstant(POS_DnInBr);
+    }
+    if (!IsOptionWith(Opt::OPT_TO_DnToBr, option)) {
+        this->SetParameterBlockConstant(TO_DnToBr);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TO_DnToBr, 0, -temporalPadding.TimeOffset(topic));
+        this->SetParameterUpperBound(TO_DnToBr, 0, temporalPadding.TimeOffset(topic));
+    }
+    return id;
+}
+
+void Estimator::AddVisualReprojResidualBlock(ceres::CostFunction *costFunc,
+                                             ceres::LossFunction *lossFunc,
+                                             const SplineMetaType &so3Meta,
+                                             const SplineMetaType &scaleMeta,
+                                             const std::string &topic,
+                                             double *globalScale,
+                                             double *invDepth,
+                                             Opt option) {
+    double *RS_READOUT = &parMagr->TEMPORAL.RS_READOUT.at(topic);
+    double *TO_CmToBr = &parMagr->TEMPORAL.TO_CmToBr.at(topic);
+
+    // parameter blocks of fixed-size cost functions are given by their types
+    if (auto dynCostFunc = dynamic_cast<ceres::DynamicCostFunction *>(costFunc);
+        dynCostFunc != nullptr) {
+        // so3 knots param block [each has four sub params]
+        for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(4);
+        }
+        // pos knots param block [each has three sub params]
+        for (int i = 0; i < static_cast<int>(scaleMeta.NumParameters()); ++i) {
+            dynCostFunc->AddParameterBlock(3);
+        }
+
+        dynCostFunc->AddParameterBlock(4);
+        dynCostFunc->AddParameterBlock(3);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
 
-    // set Residuals
-    costFunc->SetNumResiduals(3);
+        // fx, fy, cx, cy
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+
+        // global scale, inv depth
+        dynCostFunc->AddParameterBlock(1);
+        dynCostFunc->AddParameterBlock(1);
+    }
 
     // organize the param block vector
     std::vector<double *> paramBlockVec;
@@ -238,50 +1287,78 @@ void Estimator::AddIMUGyroMeasurement(const IMUFrame::Ptr &imuFrame,
     AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
                     !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
 
-    // GYRO gyroBias
-    auto gyroBias = parMagr->INTRI.IMU.at(topic)->GYRO.BIAS.data();
-    paramBlockVec.push_back(gyroBias);
-    // GYRO map coeff
-    auto gyroMapCoeff = parMagr->INTRI.IMU.at(topic)->GYRO.MAP_COEFF.data();
-    paramBlockVec.push_back(gyroMapCoeff);
-    // SO3_AtoG
-    auto SO3_AtoG = parMagr->INTRI.IMU.at(topic)->SO3_AtoG.data();
-    paramBlockVec.push_back(SO3_AtoG);
-    // SO3_BiToBr
-    auto SO3_BiToBr = parMagr->EXTRI.SO3_BiToBr.at(topic).data();
-    paramBlockVec.push_back(SO3_BiToBr);
-    // TIME_OFFSET_BiToBc
-    auto TIME_OFFSET_BiToBc = &parMagr->TEMPORAL.TO_BiToBr.at(topic);
-    paramBlockVec.push_back(TIME_OFFSET_BiToBc);
+    // lin acce knots
+    AddRdKnotsData(paramBlockVec, splines->GetRdSpline(Configor::Preference::SCALE_SPLINE),
+                   scaleMeta, !IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+
+    auto SO3_CmToBr = parMagr->EXTRI.SO3_CmToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_CmToBr);
+
+    auto POS_CmInBr = parMagr->EXTRI.POS_CmInBr.at(topic).data();
+    paramBlockVec.push_back(POS_CmInBr);
+
+    paramBlockVec.push_back(TO_CmToBr);
+    paramBlockVec.push_back(RS_READOUT);
+
+    auto &intri = parMagr->INTRI.Camera.at(topic);
+    paramBlockVec.push_back(intri->FXAddress());
+    paramBlockVec.push_back(intri->FYAddress());
+    paramBlockVec.push_back(intri->CXAddress());
+    paramBlockVec.push_back(intri->CYAddress());
+
+    paramBlockVec.push_back(globalScale);
+    paramBlockVec.push_back(invDepth);
 
     // pass to problem
-    this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
+    this->AddResidualBlock(costFunc, lossFunc, paramBlockVec);
+    this->SetManifold(SO3_CmToBr, QUATER_MANIFOLD.get());
 
-    this->SetManifold(SO3_AtoG, QUATER_MANIFOLD.get());
-    this->SetManifold(SO3_BiToBr, QUATER_MANIFOLD.get());
+    if (!IsOptionWith(Opt::OPT_SO3_CmToBr, option)) {
+        this->SetParameterBlockConstant(SO3_CmToBr);
+    }
 
-    if (!IsOptionWith(Opt::OPT_GYRO_BIAS, option)) {
-        this->SetParameterBlockConstant(gyroBias);
+    if (!IsOptionWith(Opt::OPT_POS_CmInBr, option)) {
+        this->SetParameterBlockConstant(POS_CmInBr);
     }
 
-    if (!IsOptionWith(Opt::OPT_GYRO_MAP_COEFF, option)) {
-        this->SetParameterBlockConstant(gyroMapCoeff);
+    if (!IsOptionWith(Opt::OPT_TO_CmToBr, option)) {
+        this->SetParameterBlockConstant(TO_CmToBr);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TO_CmToBr, 0, -temporalPadding.TimeOffset(topic));
+        this->SetParameterUpperBound(TO_CmToBr, 0, temporalPadding.TimeOffset(topic));
     }
 
-    if (!IsOptionWith(Opt::OPT_SO3_AtoG, option)) {
-        this->SetParameterBlockConstant(SO3_AtoG);
+    if (!IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option)) {
+        this->SetParameterBlockConstant(RS_READOUT);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(RS_READOUT, 0, 0.0);
+        this->SetParameterUpperBound(RS_READOUT, 0, temporalPadding.ReadoutTime(topic));
     }
 
-    if (!IsOptionWith(Opt::OPT_SO3_BiToBr, option)) {
-        this->SetParameterBlockConstant(SO3_BiToBr);
+    if (!IsOptionWith(Opt::OPT_CAM_FOCAL_LEN, option)) {
+        this->SetParameterBlockConstant(intri->FXAddress());
+        this->SetParameterBlockConstant(intri->FYAddress());
     }
 
-    if (!IsOptionWith(Opt::OPT_TO_BiToBr, option)) {
-        this->SetParameterBlockConstant(TIME_OFFSET_BiToBc);
+    if (!IsOptionWith(Opt::OPT_CAM_PRINCIPAL_POINT, option)) {
+        this->SetParameterBlockConstant(intri->CXAddress());
+        this->SetParameterBlockConstant(intri->CYAddress());
+    }
+
+    if (!IsOptionWith(Opt::OPT_VISUAL_GLOBAL_SCALE, option)) {
+        this->SetParameterBlockConstant(globalScale);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(globalScale, 0, 1E-3);
+    }
+
+    if (!IsOptionWith(Opt::OPT_VISUAL_DEPTH, option)) {
+        this->SetParameterBlockConstant(invDepth);
     } else {
         // set bound
-        this->SetParameterLowerBound(TIME_OFFSET_BiToBc, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TIME_OFFSET_BiToBc, 0, Configor::Prior::TimeOffsetPadding);
+        this->SetParameterLowerBound(invDepth, 0, 1E-3);
     }
 }
 
@@ -540,6 +1617,8 @@ void Estimator::AddRadarInertialAlignment(const std::vector<IMUFrame::Ptr> &data
                                           const std::string &radarTopic,
                                           const RadarTargetArray::Ptr &sRadarAry,
                                           const RadarTargetArray::Ptr &eRadarAry,
+                                          const Eigen::Vector3d &sRadarVel,
+                                          const Eigen::Vector3d &eRadarVel,
                                           Estimator::Opt option,
                                           double weight) {
     const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
@@ -558,8 +1637,7 @@ void Estimator::AddRadarInertialAlignment(const std::vector<IMUFrame::Ptr> &data
     }
     // create a cost function
     auto helper = RadarInertialAlignHelper<Configor::Prior::SplineOrder>(
-        so3Spline, sRadarAry, eRadarAry, TO_RjToBr, *velVecMat,
-        Configor::Prior::LossForRadarDopplerFactor);
+        so3Spline, sRadarAry, eRadarAry, TO_RjToBr, *velVecMat, sRadarVel, eRadarVel);
     auto costFunc = RadarInertialAlignFactor<Configor::Prior::SplineOrder>::Create(helper, weight);
 
     costFunc->AddParameterBlock(3);
@@ -614,6 +1692,8 @@ void Estimator::AddRadarInertialRotRoughAlignment(const std::vector<IMUFrame::Pt
                                                   const std::string &radarTopic,
                                                   const RadarTargetArray::Ptr &sRadarAry,
                                                   const RadarTargetArray::Ptr &eRadarAry,
+                                                  const Eigen::Vector3d &sRadarVel,
+                                                  const Eigen::Vector3d &eRadarVel,
                                                   Estimator::Opt option,
                                                   double weight) {
     const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
@@ -632,7 +1712,7 @@ void Estimator::AddRadarInertialRotRoughAlignment(const std::vector<IMUFrame::Pt
     }
     // create a cost function
     auto helper = RadarInertialRotRoughAlignHelper<Configor::Prior::SplineOrder>(
-        so3Spline, sRadarAry, eRadarAry, TO_RjToBr, *velVecMat);
+        so3Spline, sRadarAry, eRadarAry, TO_RjToBr, *velVecMat, sRadarVel, eRadarVel);
     auto costFunc =
         RadarInertialRotRoughAlignFactor<Configor::Prior::SplineOrder>::Create(helper, weight);
 
@@ -928,25 +2008,24 @@ void Estimator::AddHandEyeRotationAlignmentForLiDAR(const std::string &lidarTopi
 
     // different relative control points finding [single vs. range]
     if (IsOptionWith(Opt::OPT_TO_LkToBr, option)) {
-        double lastMinTime = tLastByLk - Configor::Prior::TimeOffsetPadding;
-        double lastMaxTime = tLastByLk + Configor::Prior::TimeOffsetPadding;
+        double lastMinTime = tLastByLk - temporalPadding.TimeOffset(lidarTopic);
+        double lastMaxTime = tLastByLk + temporalPadding.TimeOffset(lidarTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(lastMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(lastMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        double curMinTime = tCurByLk - Configor::Prior::TimeOffsetPadding;
-        double curMaxTime = tCurByLk + Configor::Prior::TimeOffsetPadding;
+        double curMinTime = tCurByLk - temporalPadding.TimeOffset(lidarTopic);
+        double curMaxTime = tCurByLk + temporalPadding.TimeOffset(lidarTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(curMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(curMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}},
-                                        so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}}, so3Meta);
     } else {
         double lastTime = tLastByLk + parMagr->TEMPORAL.TO_LkToBr.at(lidarTopic);
         double curTime = tCurByLk + parMagr->TEMPORAL.TO_LkToBr.at(lidarTopic);
@@ -956,8 +2035,8 @@ void Estimator::AddHandEyeRotationAlignmentForLiDAR(const std::string &lidarTopi
             !splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
     }
 
     // create a cost function
@@ -1003,8 +2082,8 @@ void Estimator::AddHandEyeRotationAlignmentForLiDAR(const std::string &lidarTopi
         this->SetParameterBlockConstant(TO_LkToBr);
     } else {
         // set bound
-        this->SetParameterLowerBound(TO_LkToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_LkToBr, 0, Configor::Prior::TimeOffsetPadding);
+        this->SetParameterLowerBound(TO_LkToBr, 0, -temporalPadding.TimeOffset(lidarTopic));
+        this->SetParameterUpperBound(TO_LkToBr, 0, temporalPadding.TimeOffset(lidarTopic));
     }
 }
 
@@ -1024,25 +2103,24 @@ void Estimator::AddHandEyeRotationAlignmentForCamera(const std::string &camTopic
 
     // different relative control points finding [single vs. range]
     if (IsOptionWith(Opt::OPT_TO_CmToBr, option)) {
-        double lastMinTime = tLastByCm - Configor::Prior::TimeOffsetPadding;
-        double lastMaxTime = tLastByCm + Configor::Prior::TimeOffsetPadding;
+        double lastMinTime = tLastByCm - temporalPadding.TimeOffset(camTopic);
+        double lastMaxTime = tLastByCm + temporalPadding.TimeOffset(camTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(lastMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(lastMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        double curMinTime = tCurByCm - Configor::Prior::TimeOffsetPadding;
-        double curMaxTime = tCurByCm + Configor::Prior::TimeOffsetPadding;
+        double curMinTime = tCurByCm - temporalPadding.TimeOffset(camTopic);
+        double curMaxTime = tCurByCm + temporalPadding.TimeOffset(camTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(curMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(curMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}},
-                                        so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}}, so3Meta);
     } else {
         double lastTime = tLastByCm + parMagr->TEMPORAL.TO_CmToBr.at(camTopic);
         double curTime = tCurByCm + parMagr->TEMPORAL.TO_CmToBr.at(camTopic);
@@ -1052,8 +2130,8 @@ void Estimator::AddHandEyeRotationAlignmentForCamera(const std::string &camTopic
             !splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
     }
 
     // create a cost function
@@ -1099,8 +2177,8 @@ void Estimator::AddHandEyeRotationAlignmentForCamera(const std::string &camTopic
         this->SetParameterBlockConstant(TO_CmToBr);
     } else {
         // set bound
-        this->SetParameterLowerBound(TO_CmToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_CmToBr, 0, Configor::Prior::TimeOffsetPadding);
+        this->SetParameterLowerBound(TO_CmToBr, 0, -temporalPadding.TimeOffset(camTopic));
+        this->SetParameterUpperBound(TO_CmToBr, 0, temporalPadding.TimeOffset(camTopic));
     }
 }
 
@@ -1120,25 +2198,24 @@ void Estimator::AddHandEyeRotationAlignmentForRGBD(const std::string &rgbdTopic,
 
     // different relative control points finding [single vs. range]
     if (IsOptionWith(Opt::OPT_TO_DnToBr, option)) {
-        double lastMinTime = tLastByDn - Configor::Prior::TimeOffsetPadding;
-        double lastMaxTime = tLastByDn + Configor::Prior::TimeOffsetPadding;
+        double lastMinTime = tLastByDn - temporalPadding.TimeOffset(rgbdTopic);
+        double lastMaxTime = tLastByDn + temporalPadding.TimeOffset(rgbdTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(lastMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(lastMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        double curMinTime = tCurByDn - Configor::Prior::TimeOffsetPadding;
-        double curMaxTime = tCurByDn + Configor::Prior::TimeOffsetPadding;
+        double curMinTime = tCurByDn - temporalPadding.TimeOffset(rgbdTopic);
+        double curMaxTime = tCurByDn + temporalPadding.TimeOffset(rgbdTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(curMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(curMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}},
-                                        so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}}, so3Meta);
     } else {
         double lastTime = tLastByDn + parMagr->TEMPORAL.TO_DnToBr.at(rgbdTopic);
         double curTime = tCurByDn + parMagr->TEMPORAL.TO_DnToBr.at(rgbdTopic);
@@ -1148,8 +2225,8 @@ void Estimator::AddHandEyeRotationAlignmentForRGBD(const std::string &rgbdTopic,
             !splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
     }
 
     // create a cost function
@@ -1195,8 +2272,8 @@ void Estimator::AddHandEyeRotationAlignmentForRGBD(const std::string &rgbdTopic,
         this->SetParameterBlockConstant(TO_DnToBr);
     } else {
         // set bound
-        this->SetParameterLowerBound(TO_DnToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_DnToBr, 0, Configor::Prior::TimeOffsetPadding);
+        this->SetParameterLowerBound(TO_DnToBr, 0, -temporalPadding.TimeOffset(rgbdTopic));
+        this->SetParameterUpperBound(TO_DnToBr, 0, temporalPadding.TimeOffset(rgbdTopic));
     }
 }
 
@@ -1210,25 +2287,24 @@ void Estimator::AddHandEyeRotationAlignmentForEvent(const std::string &eventTopi
 
     // different relative control points finding [single vs. range]
     if (IsOptionWith(Opt::OPT_TO_EsToBr, option)) {
-        double lastMinTime = tLastByEs - Configor::Prior::TimeOffsetPadding;
-        double lastMaxTime = tLastByEs + Configor::Prior::TimeOffsetPadding;
+        double lastMinTime = tLastByEs - temporalPadding.TimeOffset(eventTopic);
+        double lastMaxTime = tLastByEs + temporalPadding.TimeOffset(eventTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(lastMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(lastMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        double curMinTime = tCurByEs - Configor::Prior::TimeOffsetPadding;
-        double curMaxTime = tCurByEs + Configor::Prior::TimeOffsetPadding;
+        double curMinTime = tCurByEs - temporalPadding.TimeOffset(eventTopic);
+        double curMaxTime = tCurByEs + temporalPadding.TimeOffset(eventTopic);
         // invalid time stamp
         if (!splines->TimeInRangeForSo3(curMinTime, Configor::Preference::SO3_SPLINE) ||
             !splines->TimeInRangeForSo3(curMaxTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
 
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}},
-                                        so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastMinTime, lastMaxTime}, {curMinTime, curMaxTime}}, so3Meta);
     } else {
         double lastTime = tLastByEs + parMagr->TEMPORAL.TO_EsToBr.at(eventTopic);
         double curTime = tCurByEs + parMagr->TEMPORAL.TO_EsToBr.at(eventTopic);
@@ -1238,8 +2314,8 @@ void Estimator::AddHandEyeRotationAlignmentForEvent(const std::string &eventTopi
             !splines->TimeInRangeForSo3(curTime, Configor::Preference::SO3_SPLINE)) {
             return;
         }
-        splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
-                                        {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
+        CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE,
+                               {{lastTime, lastTime}, {curTime, curTime}}, so3Meta);
     }
 
     // create a cost function
@@ -1285,8 +2361,8 @@ void Estimator::AddHandEyeRotationAlignmentForEvent(const std::string &eventTopi
         this->SetParameterBlockConstant(TO_EsToBr);
     } else {
         // set bound
-        this->SetParameterLowerBound(TO_EsToBr, 0, -Configor::Prior::TimeOffsetPadding);
-        this->SetParameterUpperBound(TO_EsToBr, 0, Configor::Prior::TimeOffsetPadding);
+        this->SetParameterLowerBound(TO_EsToBr, 0, -temporalPadding.TimeOffset(eventTopic));
+        this->SetParameterUpperBound(TO_EsToBr, 0, temporalPadding.TimeOffset(eventTopic));
     }
 }
 
@@ -1305,8 +2381,7 @@ void Estimator::AddSO3Constraint(double timeByBr,
     }
 
     SplineMetaType so3Meta;
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{timeByBr, timeByBr}},
-                                    so3Meta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {{timeByBr, timeByBr}}, so3Meta);
 
     // create a cost function
     auto costFunc = SO3Factor<Configor::Prior::SplineOrder>::Create(so3Meta, timeByBr, so3, weight);
@@ -1367,13 +2442,7 @@ std::optional<std::pair<Eigen::Vector3d, Eigen::Matrix3d>> Estimator::InertialVe
     const std::string &imuTopic,
     double sTimeByBi,
     double eTimeByBi) {
-    auto vecMatSeq = InertialIntegrationBase(data, imuTopic, sTimeByBi, eTimeByBi);
-    if (vecMatSeq.first.size() < 2 || vecMatSeq.second.size() < 2) {
-        // invalid integration data
-        return {};
-    }
-    return std::pair<Eigen::Vector3d, Eigen::Matrix3d>{TrapIntegrationOnce(vecMatSeq.first),
-                                                       TrapIntegrationOnce(vecMatSeq.second)};
+    return GetInertialPreintegration(data, imuTopic)->VelIntegration(sTimeByBi, eTimeByBi);
 }
 
 std::optional<std::pair<std::pair<Eigen::Vector3d, Eigen::Matrix3d>,
@@ -1382,64 +2451,30 @@ Estimator::InertialPosIntegration(const std::vector<IMUFrame::Ptr> &data,
                                   const std::string &imuTopic,
                                   double sTimeByBi,
                                   double eTimeByBi) {
-    auto vecMatSeq = InertialIntegrationBase(data, imuTopic, sTimeByBi, eTimeByBi);
-    if (vecMatSeq.first.size() < 2 || vecMatSeq.second.size() < 2) {
-        // invalid integration data
-        return {};
-    }
-    return std::pair<std::pair<Eigen::Vector3d, Eigen::Matrix3d>,
-                     std::pair<Eigen::Vector3d, Eigen::Matrix3d>>{
-        {TrapIntegrationOnce(vecMatSeq.first), TrapIntegrationOnce(vecMatSeq.second)},
-        {TrapIntegrationTwice(vecMatSeq.first), TrapIntegrationTwice(vecMatSeq.second)}};
+    return GetInertialPreintegration(data, imuTopic)->PosIntegration(sTimeByBi, eTimeByBi);
 }
 
-std::pair<std::vector<std::pair<double, Eigen::Vector3d>>,
-          std::vector<std::pair<double, Eigen::Matrix3d>>>
-Estimator::InertialIntegrationBase(const std::vector<IMUFrame::Ptr> &data,
-                                   const std::string &imuTopic,
-                                   double sTimeByBi,
-                                   double eTimeByBi) {
-    // vector and matrix sequence for integration
-    std::vector<std::pair<double, Eigen::Vector3d>> vecSeq;
-    std::vector<std::pair<double, Eigen::Matrix3d>> matSeq;
-
-    double timeOffset = parMagr->TEMPORAL.TO_BiToBr.at(imuTopic);
-    auto SO3_BiToBr = parMagr->EXTRI.SO3_BiToBr.at(imuTopic);
+const InertialPreintegration::Ptr &Estimator::GetInertialPreintegration(
+    const std::vector<IMUFrame::Ptr> &data, const std::string &imuTopic) {
+    const double TO_BiToBr = parMagr->TEMPORAL.TO_BiToBr.at(imuTopic);
+    const auto &SO3_BiToBr = parMagr->EXTRI.SO3_BiToBr.at(imuTopic);
 
-    // extract data by considering the initialized time offsets
-    auto [sIter, eIter] = CalibDataManager::ExtractIMUDataPiece(data, sTimeByBi, eTimeByBi);
-
-    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-
-    for (auto iter = sIter; iter != eIter; ++iter) {
-        const auto &frame = *iter;
-        double curTimeByBr = frame->GetTimestamp() + timeOffset;
-
-        if (!splines->TimeInRangeForSo3(curTimeByBr, Configor::Preference::SO3_SPLINE)) {
-            continue;
-        }
-
-        auto SO3_BrToBr0 = so3Spline.Evaluate(curTimeByBr);
-
-        // angular velocity in world
-        auto SO3_VEL_BrToBr0InBr0 = SO3_BrToBr0 * so3Spline.VelocityBody(curTimeByBr);
-        Eigen::Matrix3d SO3_VEL_MAT = Sophus::SO3d::hat(SO3_VEL_BrToBr0InBr0);
-
-        // angular acceleration in world
-        auto SO3_ACCE_BrToBr0InBr0 = SO3_BrToBr0 * so3Spline.AccelerationBody(curTimeByBr);
-        Eigen::Matrix3d SO3_ACCE_MAT = Sophus::SO3d::hat(SO3_ACCE_BrToBr0InBr0);
-
-        // store
-        vecSeq.emplace_back(curTimeByBr, SO3_BrToBr0 * SO3_BiToBr * frame->GetAcce());
-        matSeq.emplace_back(curTimeByBr,
-                            (SO3_ACCE_MAT + SO3_VEL_MAT * SO3_VEL_MAT) * SO3_BrToBr0.matrix());
+    auto &table = preintegrations[imuTopic];
+    if (table == nullptr || !table->Matches(data, SO3_BiToBr, TO_BiToBr)) {
+        table = InertialPreintegration::Create(
+            data, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), SO3_BiToBr, TO_BiToBr);
     }
-
-    return {vecSeq, matSeq};
+    return table;
 }
 
 Eigen::MatrixXd Estimator::GetHessianMatrix(const std::vector<double *> &consideredParBlocks,
                                             int numThread) {
+    // the hessian matrix of considered parameters is small, densify it
+    return Eigen::MatrixXd(GetSparseHessianMatrix(consideredParBlocks, numThread));
+}
+
+Eigen::SparseMatrix<double> Estimator::GetSparseHessianMatrix(
+    const std::vector<double *> &consideredParBlocks, int numThread) {
     // remove params that are not involved
     ceres::Problem::EvaluateOptions evalOpt;
     evalOpt.parameter_blocks = consideredParBlocks;
@@ -1449,14 +2484,69 @@ Eigen::MatrixXd Estimator::GetHessianMatrix(const std::vector<double *> &conside
     ceres::CRSMatrix jacobianCRSMatrix;
     this->Evaluate(evalOpt, nullptr, nullptr, nullptr, &jacobianCRSMatrix);
 
-    // obtain hessian matrix and residual vector
-    Eigen::MatrixXd JMat = CRSMatrix2EigenMatrix(&jacobianCRSMatrix);
+    // map the row-major compressed jacobian matrix directly, without copying
+    Eigen::Map<const Eigen::SparseMatrix<double, Eigen::RowMajor, int>> JMat(
+        jacobianCRSMatrix.num_rows, jacobianCRSMatrix.num_cols,
+        static_cast<int>(jacobianCRSMatrix.values.size()), jacobianCRSMatrix.rows.data(),
+        jacobianCRSMatrix.cols.data(), jacobianCRSMatrix.values.data());
+
+    return JacobianToHessian(JMat, numThread);
+}
 
-    Eigen::MatrixXd HMat = JMat.transpose() * JMat;
+Eigen::SparseMatrix<double> Estimator::JacobianToHessian(
+    const Eigen::Map<const Eigen::SparseMatrix<double, Eigen::RowMajor, int>> &JMat,
+    int numThread) {
+    // J^T * J = sum(J_i^T * J_i), where J_i is a row piece of the jacobian matrix
+    int pieceCount = std::max(1, std::min(numThread, static_cast<int>(JMat.rows())));
+    std::vector<Eigen::SparseMatrix<double>> HMatPieces(pieceCount);
+#pragma omp parallel for num_threads(pieceCount) default(none) shared(pieceCount, JMat, HMatPieces)
+    for (int i = 0; i < pieceCount; ++i) {
+        const auto sRow = JMat.rows() * i / pieceCount;
+        const auto eRow = JMat.rows() * (i + 1) / pieceCount;
+        const Eigen::SparseMatrix<double> JMatPiece = JMat.middleRows(sRow, eRow - sRow);
+        HMatPieces.at(i) = JMatPiece.transpose() * JMatPiece;
+    }
 
+    Eigen::SparseMatrix<double> HMat(JMat.cols(), JMat.cols());
+    for (const auto &piece : HMatPieces) {
+        HMat += piece;
+    }
     return HMat;
 }
 
+Eigen::MatrixXd Estimator::GetMarginalHessianMatrix(
+    const std::vector<double *> &keptParBlocks,
+    const std::vector<double *> &marginalizedParBlocks,
+    int numThread) {
+    // columns of the hessian matrix: [ kept | marginalized ]
+    std::vector<double *> parBlocks = keptParBlocks;
+    parBlocks.insert(parBlocks.end(), marginalizedParBlocks.cbegin(),
+                     marginalizedParBlocks.cend());
+    int keptSize = 0;
+    for (const auto &parBlock : keptParBlocks) {
+        keptSize += this->ParameterBlockTangentSize(parBlock);
+    }
+    const Eigen::SparseMatrix<double> HMat = GetSparseHessianMatrix(parBlocks, numThread);
+    const int margSize = static_cast<int>(HMat.cols()) - keptSize;
+
+    Eigen::MatrixXd HMatKK = HMat.topLeftCorner(keptSize, keptSize);
+    if (margSize == 0) {
+        return HMatKK;
+    }
+    const Eigen::SparseMatrix<double> HMatMM = HMat.bottomRightCorner(margSize, margSize);
+    const Eigen::MatrixXd HMatMK = HMat.bottomLeftCorner(margSize, keptSize);
+
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(HMatMM);
+    if (solver.info() != Eigen::Success) {
+        throw Status(Status::ERROR,
+                     "the hessian matrix of marginalized parameters can not be factorized, they "
+                     "may not be fully constrained!");
+    }
+    // H_kk - H_km * H_mm^(-1) * H_mk
+    HMatKK -= HMatMK.transpose() * solver.solve(HMatMK);
+    return HMatKK;
+}
+
 void Estimator::PrintParameterInfo() const {
     std::vector<double *> parameterBlocks;
     this->GetParameterBlocks(&parameterBlocks);
@@ -1484,8 +2574,8 @@ void Estimator::AddEventNormFlowRotConstraint(const NormFlowPtr &nf,
                                               Opt option,
                                               double weight) {
     auto &intri = parMagr->INTRI.Camera.at(topic);
-    const double TO_PADDING = Configor::Prior::TimeOffsetPadding;
-    const double RT_PADDING = Configor::Prior::ReadoutTimePadding;
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
     double *TO_EsToBr = &parMagr->TEMPORAL.TO_EsToBr.at(topic);
 
     std::pair<double, double> timePair = ConsideredTimeRangeForCameraStamp(
@@ -1502,7 +2592,7 @@ void Estimator::AddEventNormFlowRotConstraint(const NormFlowPtr &nf,
     // prepare metas for splines
     SplineMetaType so3Meta;
 
-    splines->CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
 
     // create a cost function
     auto costFunc =
@@ -1543,7 +2633,7 @@ void Estimator::AddEventNormFlowRotConstraint(const NormFlowPtr &nf,
 
     // pass to problem
     this->AddResidualBlock(costFunc,
-                           new ceres::HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
+                           this->HuberLoss(Configor::Prior::LossForOpticalFlowFactor * weight),
                            paramBlockVec);
     this->SetManifold(SO3_EsToBr, QUATER_MANIFOLD.get());
 
@@ -1570,6 +2660,110 @@ void Estimator::AddEventNormFlowRotConstraint(const NormFlowPtr &nf,
     }
 }
 
+/**
+ * param blocks:
+ * [ SO3 | ... | SO3 | SO3_EsToBr | TO_EsToBr | FX | FY | CX | CY ]
+ */
+void Estimator::AddEventNormFlowRotBinConstraint(const std::vector<NormFlowPtr> &nfs,
+                                                 const std::string &topic,
+                                                 Opt option,
+                                                 double weight) {
+    if (nfs.empty()) {
+        return;
+    }
+    // normal flows in this bin share the angular velocity at their mean time
+    double timestamp = 0.0;
+    for (const auto &nf : nfs) {
+        timestamp += nf->timestamp;
+    }
+    timestamp /= static_cast<double>(nfs.size());
+
+    auto &intri = parMagr->INTRI.Camera.at(topic);
+    const double TO_PADDING = temporalPadding.TimeOffset(topic);
+    const double RT_PADDING = temporalPadding.ReadoutTime(topic);
+    double *TO_EsToBr = &parMagr->TEMPORAL.TO_EsToBr.at(topic);
+
+    std::pair<double, double> timePair = ConsideredTimeRangeForCameraStamp(
+        timestamp,                                           // time stamped by the camera
+        0.0, RT_PADDING, 0.0,                                // the readout factor
+        IsOptionWith(Opt::OPT_RS_CAM_READOUT_TIME, option),  // if optimize rs readout time
+        *TO_EsToBr, TO_PADDING, IsOptionWith(Opt::OPT_TO_EsToBr, option)  // if opt time offset
+    );
+
+    if (!TimeInRangeForSplines(timePair)) {
+        return;
+    }
+
+    // prepare metas for splines
+    SplineMetaType so3Meta;
+
+    CalculateSo3SplineMeta(Configor::Preference::SO3_SPLINE, {timePair}, so3Meta);
+
+    // create a cost function
+    auto costFunc = NormFlowPureRotBinFactor<Configor::Prior::SplineOrder>::Create(
+        so3Meta, timestamp, nfs, weight, Configor::Prior::LossForOpticalFlowFactor * weight);
+
+    // so3 knots param block [each has four sub params]
+    for (int i = 0; i < static_cast<int>(so3Meta.NumParameters()); ++i) {
+        costFunc->AddParameterBlock(4);
+    }
+
+    costFunc->AddParameterBlock(4);
+    costFunc->AddParameterBlock(1);
+
+    // fx, fy, cx, cy
+    costFunc->AddParameterBlock(1);
+    costFunc->AddParameterBlock(1);
+    costFunc->AddParameterBlock(1);
+    costFunc->AddParameterBlock(1);
+
+    costFunc->SetNumResiduals(static_cast<int>(nfs.size()));
+
+    // organize the param block vector
+    std::vector<double *> paramBlockVec;
+
+    // so3 knots param block
+    AddSo3KnotsData(paramBlockVec, splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Meta,
+                    !IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+
+    auto SO3_EsToBr = parMagr->EXTRI.SO3_EsToBr.at(topic).data();
+    paramBlockVec.push_back(SO3_EsToBr);
+
+    paramBlockVec.push_back(TO_EsToBr);
+
+    paramBlockVec.push_back(intri->FXAddress());
+    paramBlockVec.push_back(intri->FYAddress());
+    paramBlockVec.push_back(intri->CXAddress());
+    paramBlockVec.push_back(intri->CYAddress());
+
+    // pass to problem
+    // the huber loss is applied to each normal flow in the factor
+    this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
+    this->SetManifold(SO3_EsToBr, QUATER_MANIFOLD.get());
+
+    if (!IsOptionWith(Opt::OPT_SO3_EsToBr, option)) {
+        this->SetParameterBlockConstant(SO3_EsToBr);
+    }
+
+    if (!IsOptionWith(Opt::OPT_TO_EsToBr, option)) {
+        this->SetParameterBlockConstant(TO_EsToBr);
+    } else {
+        // set bound
+        this->SetParameterLowerBound(TO_EsToBr, 0, -TO_PADDING);
+        this->SetParameterUpperBound(TO_EsToBr, 0, TO_PADDING);
+    }
+
+    if (!IsOptionWith(Opt::OPT_CAM_FOCAL_LEN, option)) {
+        this->SetParameterBlockConstant(intri->FXAddress());
+        this->SetParameterBlockConstant(intri->FYAddress());
+    }
+
+    if (!IsOptionWith(Opt::OPT_CAM_PRINCIPAL_POINT, option)) {
+        this->SetParameterBlockConstant(intri->CXAddress());
+        this->SetParameterBlockConstant(intri->CYAddress());
+    }
+}
+
 void Estimator::SetRefIMUParamsConstant() {
     auto SO3_BiToBr = parMagr->EXTRI.SO3_BiToBr.at(Configor::DataStream::ReferIMU).data();
     if (this->HasParameterBlock(SO3_BiToBr)) {
@@ -1587,6 +2781,213 @@ void Estimator::SetRefIMUParamsConstant() {
     }
 }
 
+void Estimator::SetResidualGroup(const std::string &group) { curResidualGroup = group; }
+
+bool Estimator::HasResidualGroup(const std::string &group) const {
+    return residualGroups.find(group) != residualGroups.cend();
+}
+
+std::vector<ceres::ResidualBlockId> Estimator::GetResidualGroup(const std::string &group) const {
+    auto iter = residualGroups.find(group);
+    if (iter == residualGroups.cend()) {
+        return {};
+    }
+    return iter->second;
+}
+
+void Estimator::RemoveResidualGroup(const std::string &group) {
+    auto iter = residualGroups.find(group);
+    if (iter == residualGroups.cend()) {
+        return;
+    }
+    std::set<double *> involvedParBlocks;
+    for (const auto &id : iter->second) {
+        std::vector<double *> parBlocks;
+        this->GetParameterBlocksForResidualBlock(id, &parBlocks);
+        involvedParBlocks.insert(parBlocks.cbegin(), parBlocks.cend());
+        this->RemoveResidualBlock(id);
+    }
+    residualGroups.erase(iter);
+
+    // parameter blocks that are not involved in any residual block, such as the inverse depths of
+    // visual correspondences, would be removed, their memories may be released by their owners
+    for (const auto &parBlock : involvedParBlocks) {
+        if (!this->HasParameterBlock(parBlock)) {
+            continue;
+        }
+        std::vector<ceres::ResidualBlockId> ids;
+        this->GetResidualBlocksForParameterBlock(parBlock, &ids);
+        if (ids.empty()) {
+            this->RemoveParameterBlock(parBlock);
+        }
+    }
+}
+
+void Estimator::ResetParameterBlockConstancy(Opt option) {
+    auto SetConstancy = [this](double *parBlock, bool variable) {
+        if (!this->HasParameterBlock(parBlock)) {
+            return;
+        }
+        if (variable) {
+            this->SetParameterBlockVariable(parBlock);
+        } else {
+            this->SetParameterBlockConstant(parBlock);
+        }
+    };
+    auto SetMapConstancy = [&SetConstancy, option](auto &parMap, Opt opt) {
+        for (auto &[topic, par] : parMap) {
+            SetConstancy(par.data(), IsOptionWith(opt, option));
+        }
+    };
+    auto SetTOMapConstancy = [&SetConstancy, option](auto &parMap, Opt opt) {
+        for (auto &[topic, par] : parMap) {
+            SetConstancy(&par, IsOptionWith(opt, option));
+        }
+    };
+
+    // spline knots
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+        auto *data = const_cast<double *>(so3Spline.GetKnot(i).data());
+        SetConstancy(data, IsOptionWith(Opt::OPT_SO3_SPLINE, option));
+    }
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    for (int i = 0; i < static_cast<int>(scaleSpline.GetKnots().size()); ++i) {
+        auto *data = const_cast<double *>(scaleSpline.GetKnot(i).data());
+        SetConstancy(data, IsOptionWith(Opt::OPT_SCALE_SPLINE, option));
+    }
+
+    // imu intrinsics
+    for (auto &[topic, intri] : parMagr->INTRI.IMU) {
+        SetConstancy(intri->GYRO.BIAS.data(), IsOptionWith(Opt::OPT_GYRO_BIAS, option));
+        SetConstancy(intri->GYRO.MAP_COEFF.data(), IsOptionWith(Opt::OPT_GYRO_MAP_COEFF, option));
+        SetConstancy(intri->ACCE.BIAS.data(), IsOptionWith(Opt::OPT_ACCE_BIAS, option));
+        SetConstancy(intri->ACCE.MAP_COEFF.data(), IsOptionWith(Opt::OPT_ACCE_MAP_COEFF, option));
+        SetConstancy(intri->SO3_AtoG.data(), IsOptionWith(Opt::OPT_SO3_AtoG, option));
+    }
+
+    // extrinsics
+    SetMapConstancy(parMagr->EXTRI.SO3_BiToBr, Opt::OPT_SO3_BiToBr);
+    SetMapConstancy(parMagr->EXTRI.POS_BiInBr, Opt::OPT_POS_BiInBr);
+    SetMapConstancy(parMagr->EXTRI.SO3_RjToBr, Opt::OPT_SO3_RjToBr);
+    SetMapConstancy(parMagr->EXTRI.POS_RjInBr, Opt::OPT_POS_RjInBr);
+    SetMapConstancy(parMagr->EXTRI.SO3_LkToBr, Opt::OPT_SO3_LkToBr);
+    SetMapConstancy(parMagr->EXTRI.POS_LkInBr, Opt::OPT_POS_LkInBr);
+    SetMapConstancy(parMagr->EXTRI.SO3_CmToBr, Opt::OPT_SO3_CmToBr);
+    SetMapConstancy(parMagr->EXTRI.POS_CmInBr, Opt::OPT_POS_CmInBr);
+    SetMapConstancy(parMagr->EXTRI.SO3_DnToBr, Opt::OPT_SO3_DnToBr);
+    SetMapConstancy(parMagr->EXTRI.POS_DnInBr, Opt::OPT_POS_DnInBr);
+    SetMapConstancy(parMagr->EXTRI.SO3_EsToBr, Opt::OPT_SO3_EsToBr);
+    SetMapConstancy(parMagr->EXTRI.POS_EsInBr, Opt::OPT_POS_EsInBr);
+
+    // time offsets (their bounds are kept, as time offset related options do not change)
+    SetTOMapConstancy(parMagr->TEMPORAL.TO_BiToBr, Opt::OPT_TO_BiToBr);
+    SetTOMapConstancy(parMagr->TEMPORAL.TO_RjToBr, Opt::OPT_TO_RjToBr);
+    SetTOMapConstancy(parMagr->TEMPORAL.TO_LkToBr, Opt::OPT_TO_LkToBr);
+    SetTOMapConstancy(parMagr->TEMPORAL.TO_CmToBr, Opt::OPT_TO_CmToBr);
+    SetTOMapConstancy(parMagr->TEMPORAL.TO_DnToBr, Opt::OPT_TO_DnToBr);
+    SetTOMapConstancy(parMagr->TEMPORAL.TO_EsToBr, Opt::OPT_TO_EsToBr);
+
+    // gravity
+    SetConstancy(parMagr->GRAVITY.data(), IsOptionWith(Opt::OPT_GRAVITY, option));
+
+    // camera and rgbd intrinsics are only involved in visual residual blocks, which are rebuilt
+    // with re-associated correspondences, thus their constancy is determined when they are added
+}
+
+ceres::ResidualBlockId Estimator::AddResidualBlock(ceres::CostFunction *costFunc,
+                                                   ceres::LossFunction *lossFunc,
+                                                   const std::vector<double *> &paramBlocks) {
+    if (!ownCostFunctions) {
+        arena.Adopt(costFunc);
+    }
+    if (factorProfiler != nullptr) {
+        costFunc = factorProfiler->Wrap(costFunc, ownCostFunctions);
+        if (!ownCostFunctions) {
+            arena.Adopt(costFunc);
+        }
+    }
+    auto id = ceres::Problem::AddResidualBlock(costFunc, lossFunc, paramBlocks);
+    if (!curResidualGroup.empty()) {
+        residualGroups[curResidualGroup].push_back(id);
+    }
+    return id;
+}
+
+ceres::LossFunction *Estimator::HuberLoss(double param) {
+    if (ownLossFunctions) {
+        return FactorArena::CreateLoss(FactorArena::LossKind::HUBER, param);
+    }
+    return arena.Loss(FactorArena::LossKind::HUBER, param);
+}
+
+ceres::LossFunction *Estimator::CauchyLoss(double param) {
+    if (ownLossFunctions) {
+        return FactorArena::CreateLoss(FactorArena::LossKind::CAUCHY, param);
+    }
+    return arena.Loss(FactorArena::LossKind::CAUCHY, param);
+}
+
+void Estimator::ValidateMixedPrecision(ceres::ResidualBlockId id, ceres::CostFunction *reference) {
+    const ceres::CostFunction *costFunc = this->GetCostFunctionForResidualBlock(id);
+    // dynamic references are organized the same as the evaluated one
+    if (auto dynRef = dynamic_cast<ceres::DynamicCostFunction *>(reference); dynRef != nullptr) {
+        for (const auto &size : costFunc->parameter_block_sizes()) {
+            dynRef->AddParameterBlock(size);
+        }
+        dynRef->SetNumResiduals(costFunc->num_residuals());
+    }
+
+    std::vector<double *> paramBlocks;
+    this->GetParameterBlocksForResidualBlock(id, &paramBlocks);
+    const auto &sizes = costFunc->parameter_block_sizes();
+    const int numResiduals = costFunc->num_residuals();
+
+    // evaluate residuals and jacobians of both
+    auto Evaluate = [&paramBlocks, &sizes, numResiduals](const ceres::CostFunction *func,
+                                                         Eigen::VectorXd &residuals,
+                                                         std::vector<Eigen::VectorXd> &jacobians) {
+        residuals.resize(numResiduals);
+        jacobians.resize(sizes.size());
+        std::vector<double *> jacobianPtrs(sizes.size());
+        for (int i = 0; i < static_cast<int>(sizes.size()); ++i) {
+            jacobians.at(i).resize(numResiduals * sizes.at(i));
+            jacobianPtrs.at(i) = jacobians.at(i).data();
+        }
+        return func->Evaluate(paramBlocks.data(), residuals.data(), jacobianPtrs.data());
+    };
+    Eigen::VectorXd resLow, resHigh;
+    std::vector<Eigen::VectorXd> jacLow, jacHigh;
+    const bool valid = Evaluate(costFunc, resLow, jacLow) && Evaluate(reference, resHigh, jacHigh);
+    delete reference;
+    if (!valid) {
+        spdlog::warn("failed to evaluate the residual block for mixed-precision validation!");
+        return;
+    }
+
+    // relative differences
+    auto RelDiff = [](const Eigen::VectorXd &low, const Eigen::VectorXd &high) {
+        return (low - high).cwiseAbs().maxCoeff() / std::max(1.0, high.cwiseAbs().maxCoeff());
+    };
+    const double resDiff = numResiduals > 0 ? RelDiff(resLow, resHigh) : 0.0;
+    double jacDiff = 0.0;
+    for (int i = 0; i < static_cast<int>(sizes.size()); ++i) {
+        if (jacLow.at(i).size() > 0) {
+            jacDiff = std::max(jacDiff, RelDiff(jacLow.at(i), jacHigh.at(i)));
+        }
+    }
+    if (resDiff > Configor::Preference::MixedPrecisionTolerance ||
+        jacDiff > Configor::Preference::MixedPrecisionTolerance) {
+        spdlog::warn(
+            "mixed-precision residual block differs from the double one, residual: {:.3e}, "
+            "jacobian: {:.3e}",
+            resDiff, jacDiff);
+    } else {
+        spdlog::info("mixed-precision residual block validated, residual: {:.3e}, jacobian: {:.3e}",
+                     resDiff, jacDiff);
+    }
+}
+
 void Estimator::FixFirSO3ControlPoint() {
     const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
@@ -1821,6 +3222,88 @@ void Estimator::AddPriorTimeOffsetConstraint(const double &TO_Sen1ToSen2,
     // pass to problem
     this->AddResidualBlock(costFunc, nullptr, paramBlockVec);
 }
+/**
+ * param blocks:
+ * [ PAR ]
+ */
+void Estimator::AddConsensusConstraint(double *parBlock,
+                                       int size,
+                                       bool isSO3,
+                                       const Eigen::VectorXd &target,
+                                       double weight) {
+    // create a cost function
+    auto costFunc = ConsensusFactor::Create(target, isSO3, weight);
+
+    // PAR
+    costFunc->AddParameterBlock(size);
+
+    // set Residuals
+    costFunc->SetNumResiduals(isSO3 ? 3 : size);
+
+    // pass to problem
+    this->AddResidualBlock(costFunc, nullptr, std::vector<double *>{parBlock});
+
+    if (isSO3) {
+        this->SetManifold(parBlock, QUATER_MANIFOLD.get());
+    }
+}
+
+void Estimator::AddMarginalPriorConstraint(const std::vector<double *> &parBlocks,
+                                           const std::vector<int> &sizes,
+                                           const std::vector<bool> &isSO3,
+                                           const Eigen::VectorXd &linPoint,
+                                           const Eigen::MatrixXd &info) {
+    // the square root of the (semi-definite) information matrix: S = D^(1/2) * V^T
+    Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(info);
+    const Eigen::VectorXd sqrtEigenValues = solver.eigenvalues().cwiseMax(0.0).cwiseSqrt();
+    const Eigen::MatrixXd sqrtInfo =
+        sqrtEigenValues.asDiagonal() * solver.eigenvectors().transpose();
+
+    // create a cost function
+    auto costFunc = MarginalPriorFactor::Create(sizes, isSO3, linPoint, sqrtInfo);
+
+    // PAR | PAR | ... | PAR
+    for (int size : sizes) {
+        costFunc->AddParameterBlock(size);
+    }
+
+    // set Residuals
+    costFunc->SetNumResiduals(static_cast<int>(info.rows()));
+
+    // pass to problem
+    this->AddResidualBlock(costFunc, nullptr, parBlocks);
+
+    for (int i = 0; i < static_cast<int>(parBlocks.size()); ++i) {
+        if (isSO3.at(i)) {
+            this->SetManifold(parBlocks.at(i), QUATER_MANIFOLD.get());
+        }
+    }
+}
+
+void Estimator::AddSpatTempPrioriConstraint(const SpatTempPrioriFactor &factor,
+                                            const std::vector<double *> &parBlocks,
+                                            const std::vector<int> &sizes,
+                                            const std::vector<bool> &isSO3) {
+    // create a cost function
+    auto costFunc = SpatTempPrioriFactor::Create(factor);
+
+    // PAR | PAR | ... | PAR
+    for (int size : sizes) {
+        costFunc->AddParameterBlock(size);
+    }
+
+    // set Residuals
+    costFunc->SetNumResiduals(factor.NumResiduals());
+
+    // pass to problem
+    this->AddResidualBlock(costFunc, nullptr, parBlocks);
+
+    for (int i = 0; i < static_cast<int>(parBlocks.size()); ++i) {
+        if (isSO3.at(i)) {
+            this->SetManifold(parBlocks.at(i), QUATER_MANIFOLD.get());
+        }
+    }
+}
 
 void Estimator::PrintUninvolvedKnots() const {
     {
@@ -1887,7 +3370,7 @@ void Estimator::AddVisualVelocityDepthFactor(Eigen::Vector3d *LIN_VEL_CmToWInCm,
     // pass to problem, the loss function factor is the same as
     // 'Configor::Prior::LossForRGBDFactor', as this model is the same as rgbd velocity model
     this->AddResidualBlock(
-        costFunc, new ceres::HuberLoss(Configor::Prior::LossForOpticalFlowFactor), paramBlockVec);
+        costFunc, this->HuberLoss(Configor::Prior::LossForOpticalFlowFactor), paramBlockVec);
 
     // the 'GRAVITY_MANIFOLD' manifold is used to make the vel vector keep const norm, as we only
     // estimate its directory
@@ -0,0 +1,72 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/factor_arena.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+FactorArena::Ptr FactorArena::Create() { return std::make_shared<FactorArena>(); }
+
+ceres::CostFunction *FactorArena::Adopt(ceres::CostFunction *costFunc) {
+    _costFunctions.emplace_back(costFunc);
+    return costFunc;
+}
+
+ceres::LossFunction *FactorArena::Loss(LossKind kind, double param) {
+    auto &loss = _lossFunctions[{kind, param}];
+    if (loss == nullptr) {
+        loss.reset(CreateLoss(kind, param));
+    }
+    return loss.get();
+}
+
+std::size_t FactorArena::CostFunctionCount() const { return _costFunctions.size(); }
+
+std::size_t FactorArena::LossFunctionCount() const { return _lossFunctions.size(); }
+
+ceres::LossFunction *FactorArena::CreateLoss(LossKind kind, double param) {
+    switch (kind) {
+        case LossKind::CAUCHY:
+            return new ceres::CauchyLoss(param);
+        case LossKind::HUBER:
+        default:
+            return new ceres::HuberLoss(param);
+    }
+}
+
+}  // namespace ns_ikalibr
@@ -0,0 +1,203 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/factor_profiler.h"
+#include "spdlog/spdlog.h"
+#include "cxxabi.h"
+#include "chrono"
+#include "fstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+// --------------
+// FactorProfiler
+// --------------
+
+FactorProfiler::Record::Record(std::string name)
+    : name(std::move(name)) {}
+
+double FactorProfiler::Record::ResidualTime() const { return residualNanos * 1E-9; }
+
+double FactorProfiler::Record::JacobianTime() const { return jacobianNanos * 1E-9; }
+
+FactorProfiler::Ptr FactorProfiler::Create() { return std::make_shared<FactorProfiler>(); }
+
+ceres::CostFunction *FactorProfiler::Wrap(ceres::CostFunction *costFunc, bool ownCostFunc) {
+    const std::type_info &info = typeid(*costFunc);
+    auto iter = _records.find(info.hash_code());
+    if (iter == _records.cend()) {
+        auto record = std::make_shared<Record>(FactorName(info));
+        iter = _records.insert({info.hash_code(), record}).first;
+    }
+    return new ProfiledCostFunction(costFunc, ownCostFunc, iter->second);
+}
+
+void FactorProfiler::ResetEvaluations() {
+    for (auto &[hashCode, record] : _records) {
+        record->residualEvals = 0;
+        record->residualNanos = 0;
+        record->jacobianEvals = 0;
+        record->jacobianNanos = 0;
+    }
+}
+
+std::vector<FactorProfiler::Record::Ptr> FactorProfiler::SortedRecords() const {
+    std::vector<Record::Ptr> records;
+    records.reserve(_records.size());
+    for (const auto &[hashCode, record] : _records) {
+        records.push_back(record);
+    }
+    std::sort(records.begin(), records.end(), [](const Record::Ptr &r1, const Record::Ptr &r2) {
+        return r1->residualNanos + r1->jacobianNanos > r2->residualNanos + r2->jacobianNanos;
+    });
+    return records;
+}
+
+std::string FactorProfiler::Summary() const {
+    std::stringstream stream;
+    stream << fmt::format("{:<48}{:>10}{:>12}{:>12}{:>12}{:>12}{:>14}\n", "factor type",
+                          "blocks", "res evals", "res time", "jac evals", "jac time",
+                          "jac mem (MB)");
+    for (const auto &record : SortedRecords()) {
+        stream << fmt::format("{:<48}{:>10}{:>12}{:>12.6f}{:>12}{:>12.6f}{:>14.3f}\n",
+                              record->name, record->residualBlocks.load(),
+                              record->residualEvals.load(), record->ResidualTime(),
+                              record->jacobianEvals.load(), record->JacobianTime(),
+                              static_cast<double>(record->jacobianBytes) / (1024.0 * 1024.0));
+    }
+    return stream.str();
+}
+
+bool FactorProfiler::SaveToCSV(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::out);
+    if (!file.is_open()) {
+        spdlog::warn("can not open file '{}' to save the factor profile!", filename);
+        return false;
+    }
+    file << "factor_type,residual_blocks,residual_evals,residual_time,jacobian_evals,"
+            "jacobian_time,jacobian_bytes\n";
+    for (const auto &record : SortedRecords()) {
+        file << fmt::format("\"{}\",{},{},{:.9f},{},{:.9f},{}\n", record->name,
+                            record->residualBlocks.load(), record->residualEvals.load(),
+                            record->ResidualTime(), record->jacobianEvals.load(),
+                            record->JacobianTime(), record->jacobianBytes.load());
+    }
+    return true;
+}
+
+std::string FactorProfiler::FactorName(const std::type_info &info) {
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(info.name(), nullptr, nullptr, &status);
+    std::string name = (status == 0 && demangled != nullptr) ? demangled : info.name();
+    std::free(demangled);
+
+    // for 'ceres::AutoDiffCostFunction<Factor, ...>' like wrappers, the factor functor is kept
+    auto beg = name.find('<');
+    if (beg != std::string::npos) {
+        int depth = 0;
+        std::size_t end = beg + 1;
+        for (; end < name.size(); ++end) {
+            const char c = name.at(end);
+            if (c == '<') {
+                ++depth;
+            } else if ((c == '>' || c == ',') && depth == 0) {
+                break;
+            } else if (c == '>') {
+                --depth;
+            }
+        }
+        name = name.substr(beg + 1, end - beg - 1);
+    }
+    const std::string ns = "ns_ikalibr::";
+    if (name.compare(0, ns.size(), ns) == 0) {
+        name = name.substr(ns.size());
+    }
+    return name;
+}
+
+// --------------------
+// ProfiledCostFunction
+// --------------------
+
+ProfiledCostFunction::ProfiledCostFunction(ceres::CostFunction *costFunc,
+                                           bool ownCostFunc,
+                                           FactorProfiler::Record::Ptr record)
+    : _costFunc(costFunc),
+      _ownCostFunc(ownCostFunc),
+      _record(std::move(record)) {
+    set_num_residuals(_costFunc->num_residuals());
+    *mutable_parameter_block_sizes() = _costFunc->parameter_block_sizes();
+    ++_record->residualBlocks;
+    _record->jacobianBytes += JacobianBytes();
+}
+
+ProfiledCostFunction::~ProfiledCostFunction() {
+    --_record->residualBlocks;
+    _record->jacobianBytes -= JacobianBytes();
+    if (_ownCostFunc) {
+        delete _costFunc;
+    }
+}
+
+bool ProfiledCostFunction::Evaluate(double const *const *parameters,
+                                    double *residuals,
+                                    double **jacobians) const {
+    auto start = std::chrono::steady_clock::now();
+    bool res = _costFunc->Evaluate(parameters, residuals, jacobians);
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    if (jacobians == nullptr) {
+        ++_record->residualEvals;
+        _record->residualNanos += nanos;
+    } else {
+        ++_record->jacobianEvals;
+        _record->jacobianNanos += nanos;
+    }
+    return res;
+}
+
+std::int64_t ProfiledCostFunction::JacobianBytes() const {
+    std::int64_t paramSize = 0;
+    for (const auto &size : parameter_block_sizes()) {
+        paramSize += size;
+    }
+    return static_cast<std::int64_t>(num_residuals()) * paramSize * sizeof(double);
+}
+
+}  // namespace ns_ikalibr
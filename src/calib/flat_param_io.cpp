@@ -0,0 +1,391 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/flat_param_io.h"
+#include "calib/calib_param_manager.h"
+#include "util/status.hpp"
+#include "spdlog/spdlog.h"
+#include "array"
+#include "filesystem"
+#include "fstream"
+#include "cstring"
+#include "map"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "fcntl.h"
+#include "unistd.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+const std::string FlatParamIO::EXTENSION = ".flat";
+
+std::string FlatParamIO::MagicHeader() { return "IKFLATPM"; }
+
+// ----------------
+// internal helpers
+// ----------------
+
+struct FlatBlock {
+    std::string name;
+    double *data;
+    std::uint32_t size;
+};
+
+/**
+ * the named parameter blocks of the parameter manager, whose names are composed of fields and
+ * topics, e.g., 'TO_LkToBr:/lidar/points'. Only estimated parameters are involved
+ */
+static std::vector<FlatBlock> FlatBlocksOf(const CalibParamManager::Ptr &parMagr) {
+    std::vector<FlatBlock> blocks;
+    auto InsertMap = [&blocks](const std::string &field, auto &parMap, std::uint32_t size) {
+        for (auto &[topic, par] : parMap) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(par)>, double>) {
+                blocks.push_back({field + ':' + topic, &par, size});
+            } else {
+                blocks.push_back({field + ':' + topic, par.data(), size});
+            }
+        }
+    };
+
+    // extrinsics
+    InsertMap("SO3_BiToBr", parMagr->EXTRI.SO3_BiToBr, 4);
+    InsertMap("POS_BiInBr", parMagr->EXTRI.POS_BiInBr, 3);
+    InsertMap("SO3_RjToBr", parMagr->EXTRI.SO3_RjToBr, 4);
+    InsertMap("POS_RjInBr", parMagr->EXTRI.POS_RjInBr, 3);
+    InsertMap("SO3_LkToBr", parMagr->EXTRI.SO3_LkToBr, 4);
+    InsertMap("POS_LkInBr", parMagr->EXTRI.POS_LkInBr, 3);
+    InsertMap("SO3_CmToBr", parMagr->EXTRI.SO3_CmToBr, 4);
+    InsertMap("POS_CmInBr", parMagr->EXTRI.POS_CmInBr, 3);
+    InsertMap("SO3_DnToBr", parMagr->EXTRI.SO3_DnToBr, 4);
+    InsertMap("POS_DnInBr", parMagr->EXTRI.POS_DnInBr, 3);
+    InsertMap("SO3_EsToBr", parMagr->EXTRI.SO3_EsToBr, 4);
+    InsertMap("POS_EsInBr", parMagr->EXTRI.POS_EsInBr, 3);
+
+    // time offsets and readout times
+    InsertMap("TO_BiToBr", parMagr->TEMPORAL.TO_BiToBr, 1);
+    InsertMap("TO_RjToBr", parMagr->TEMPORAL.TO_RjToBr, 1);
+    InsertMap("TO_LkToBr", parMagr->TEMPORAL.TO_LkToBr, 1);
+    InsertMap("TO_CmToBr", parMagr->TEMPORAL.TO_CmToBr, 1);
+    InsertMap("TO_DnToBr", parMagr->TEMPORAL.TO_DnToBr, 1);
+    InsertMap("TO_EsToBr", parMagr->TEMPORAL.TO_EsToBr, 1);
+    InsertMap("RS_READOUT", parMagr->TEMPORAL.RS_READOUT, 1);
+
+    // intrinsics
+    for (auto &[topic, intri] : parMagr->INTRI.IMU) {
+        blocks.push_back({"GYRO.BIAS:" + topic, intri->GYRO.BIAS.data(), 3});
+        blocks.push_back({"GYRO.MAP_COEFF:" + topic, intri->GYRO.MAP_COEFF.data(), 6});
+        blocks.push_back({"ACCE.BIAS:" + topic, intri->ACCE.BIAS.data(), 3});
+        blocks.push_back({"ACCE.MAP_COEFF:" + topic, intri->ACCE.MAP_COEFF.data(), 6});
+        blocks.push_back({"SO3_AtoG:" + topic, intri->SO3_AtoG.data(), 4});
+    }
+    auto InsertPinhole = [&blocks](const std::string &topic,
+                                   const ns_veta::PinholeIntrinsic::Ptr &intri) {
+        blocks.push_back({"FX:" + topic, intri->FXAddress(), 1});
+        blocks.push_back({"FY:" + topic, intri->FYAddress(), 1});
+        blocks.push_back({"CX:" + topic, intri->CXAddress(), 1});
+        blocks.push_back({"CY:" + topic, intri->CYAddress(), 1});
+    };
+    for (auto &[topic, intri] : parMagr->INTRI.Camera) {
+        InsertPinhole(topic, intri);
+    }
+    for (auto &[topic, intri] : parMagr->INTRI.RGBD) {
+        InsertPinhole(topic, intri->intri);
+        blocks.push_back({"RGBD.ALPHA:" + topic, &intri->alpha, 1});
+        blocks.push_back({"RGBD.BETA:" + topic, &intri->beta, 1});
+    }
+
+    // the gravity
+    blocks.push_back({"GRAVITY", parMagr->GRAVITY.data(), 3});
+    return blocks;
+}
+
+// entries are appended to the byte buffer, padded to 8 bytes, so that values are aligned
+struct FlatWriter {
+    std::string bytes;
+
+    FlatWriter(const std::string &magic, FlatParamIO::Kind kind, std::uint64_t entryCount) {
+        bytes.append(magic);
+        Write<std::uint32_t>(FlatParamIO::VERSION);
+        Write<std::uint32_t>(static_cast<std::uint32_t>(kind));
+        Write<std::uint64_t>(entryCount);
+    }
+
+    template <class Type>
+    void Write(const Type &val) {
+        static_assert(std::is_trivially_copyable_v<Type>);
+        bytes.append(reinterpret_cast<const char *>(&val), sizeof(Type));
+    }
+
+    void Append(const std::string &name, const double *values, std::uint32_t count) {
+        Write<std::uint32_t>(static_cast<std::uint32_t>(name.size()));
+        Write<std::uint32_t>(count);
+        bytes.append(name);
+        bytes.append((8 - name.size() % 8) % 8, '\0');
+        bytes.append(reinterpret_cast<const char *>(values), count * sizeof(double));
+    }
+};
+
+// the value count and the values (referring to the parsed bytes) of entries, organized by names
+using FlatEntries = std::map<std::string, std::pair<std::uint32_t, const char *>>;
+
+static FlatEntries ParseFlat(const char *data,
+                             std::size_t size,
+                             const std::string &magic,
+                             FlatParamIO::Kind kind) {
+    std::size_t cursor = 0;
+    auto Require = [size, &cursor](std::size_t bytes) {
+        if (cursor + bytes > size) {
+            throw Status(Status::ERROR, "the flat file is broken!");
+        }
+    };
+    auto Read = [data, &cursor, &Require](auto &val) {
+        Require(sizeof(val));
+        std::memcpy(&val, data + cursor, sizeof(val));
+        cursor += sizeof(val);
+    };
+
+    Require(magic.size());
+    if (std::memcmp(data, magic.data(), magic.size()) != 0) {
+        throw Status(Status::ERROR, "the file is not a flat one!");
+    }
+    cursor += magic.size();
+    std::uint32_t version = 0, kindVal = 0;
+    std::uint64_t entryCount = 0;
+    Read(version);
+    Read(kindVal);
+    Read(entryCount);
+    if (version != FlatParamIO::VERSION || kindVal != static_cast<std::uint32_t>(kind)) {
+        throw Status(Status::ERROR, "the flat file of version '{}' and kind '{}' is unexpected!",
+                     version, kindVal);
+    }
+
+    FlatEntries entries;
+    for (std::uint64_t i = 0; i < entryCount; ++i) {
+        std::uint32_t nameLen = 0, count = 0;
+        Read(nameLen);
+        Read(count);
+        Require(nameLen);
+        std::string name(data + cursor, nameLen);
+        cursor += nameLen + (8 - nameLen % 8) % 8;
+        Require(count * sizeof(double));
+        entries[name] = {count, data + cursor};
+        cursor += count * sizeof(double);
+    }
+    return entries;
+}
+
+// the read-only memory mapping of a file, which is unmapped once it is destroyed
+struct MappedFile {
+    const char *data = nullptr;
+    std::size_t size = 0;
+
+    explicit MappedFile(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw Status(Status::ERROR, "open flat file '{}' failed!", filename);
+        }
+        struct stat fileStat {};
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0) {
+            close(fd);
+            throw Status(Status::ERROR, "the flat file '{}' is empty!", filename);
+        }
+        size = static_cast<std::size_t>(fileStat.st_size);
+        void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            throw Status(Status::ERROR, "map flat file '{}' failed!", filename);
+        }
+        data = static_cast<const char *>(addr);
+    }
+
+    ~MappedFile() { munmap(const_cast<char *>(data), size); }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+};
+
+// write a temporary file first, so that an interrupted saving would not leave a broken one
+static bool WriteFlatFile(const std::string &bytes, const std::string &filename) {
+    const std::string tmpFilename = filename + ".tmp";
+    {
+        std::ofstream file(tmpFilename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            spdlog::warn("open flat file failed: '{}'", tmpFilename);
+            return false;
+        }
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        if (!file.good()) {
+            spdlog::warn("write flat file failed: '{}'", tmpFilename);
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpFilename, filename, ec);
+    if (ec) {
+        spdlog::warn("save flat file failed: '{}', {}", filename, ec.message());
+        return false;
+    }
+    return true;
+}
+
+static void CopyParamBlocks(const FlatEntries &entries, const CalibParamManager::Ptr &parMagr) {
+    const auto blocks = FlatBlocksOf(parMagr);
+    // all blocks are checked before copying, so that the manager is untouched if failed
+    bool matched = entries.size() == blocks.size();
+    for (int i = 0; matched && i < static_cast<int>(blocks.size()); ++i) {
+        auto iter = entries.find(blocks.at(i).name);
+        matched = iter != entries.cend() && iter->second.first == blocks.at(i).size;
+    }
+    if (!matched) {
+        throw Status(Status::ERROR,
+                     "the flat parameters are of another sensor suite, which can not be loaded!");
+    }
+    for (const auto &block : blocks) {
+        std::memcpy(block.data, entries.at(block.name).second, block.size * sizeof(double));
+    }
+}
+
+// -----------
+// FlatParamIO
+// -----------
+
+std::string FlatParamIO::SerializeParams(const CalibParamManagerPtr &parMagr) {
+    const auto blocks = FlatBlocksOf(parMagr);
+    FlatWriter writer(MagicHeader(), Kind::PARAMS, blocks.size());
+    for (const auto &block : blocks) {
+        writer.Append(block.name, block.data, block.size);
+    }
+    return writer.bytes;
+}
+
+void FlatParamIO::DeserializeParams(const std::string &bytes, const CalibParamManagerPtr &parMagr) {
+    CopyParamBlocks(ParseFlat(bytes.data(), bytes.size(), MagicHeader(), Kind::PARAMS), parMagr);
+}
+
+bool FlatParamIO::SaveParams(const CalibParamManagerPtr &parMagr, const std::string &filename) {
+    return WriteFlatFile(SerializeParams(parMagr), filename);
+}
+
+void FlatParamIO::LoadParams(const std::string &filename, const CalibParamManagerPtr &parMagr) {
+    MappedFile file(filename);
+    CopyParamBlocks(ParseFlat(file.data, file.size, MagicHeader(), Kind::PARAMS), parMagr);
+}
+
+bool FlatParamIO::SaveSplines(const SplineBundleType::Ptr &splines, const std::string &filename) {
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+
+    // knots are not stored contiguously in splines, thus gathered here
+    std::vector<double> so3Knots(so3Spline.GetKnots().size() * 4);
+    for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+        std::memcpy(so3Knots.data() + i * 4, so3Spline.GetKnot(i).data(), 4 * sizeof(double));
+    }
+    std::vector<double> scaleKnots(scaleSpline.GetKnots().size() * 3);
+    for (int i = 0; i < static_cast<int>(scaleSpline.GetKnots().size()); ++i) {
+        std::memcpy(scaleKnots.data() + i * 3, scaleSpline.GetKnot(i).data(), 3 * sizeof(double));
+    }
+    const std::array<double, 2> so3Range{so3Spline.MinTime(), so3Spline.MaxTime()};
+    const std::array<double, 2> scaleRange{scaleSpline.MinTime(), scaleSpline.MaxTime()};
+
+    FlatWriter writer(MagicHeader(), Kind::SPLINES, 4);
+    writer.Append(Configor::Preference::SO3_SPLINE + ":range", so3Range.data(), 2);
+    writer.Append(Configor::Preference::SO3_SPLINE + ":knots", so3Knots.data(),
+                  static_cast<std::uint32_t>(so3Knots.size()));
+    writer.Append(Configor::Preference::SCALE_SPLINE + ":range", scaleRange.data(), 2);
+    writer.Append(Configor::Preference::SCALE_SPLINE + ":knots", scaleKnots.data(),
+                  static_cast<std::uint32_t>(scaleKnots.size()));
+    return WriteFlatFile(writer.bytes, filename);
+}
+
+FlatParamIO::SplineBundleType::Ptr FlatParamIO::LoadSplines(const std::string &filename) {
+    MappedFile file(filename);
+    const auto entries = ParseFlat(file.data, file.size, MagicHeader(), Kind::SPLINES);
+
+    // the time range and the knot count, where the knot distance is recovered from
+    auto RangeOf = [&entries, &filename](const std::string &name, int knotDim) {
+        auto rangeIter = entries.find(name + ":range");
+        auto knotsIter = entries.find(name + ":knots");
+        if (rangeIter == entries.cend() || rangeIter->second.first != 2 ||
+            knotsIter == entries.cend() || knotsIter->second.first % knotDim != 0 ||
+            knotsIter->second.first / knotDim < Configor::Prior::SplineOrder) {
+            throw Status(Status::ERROR, "spline '{}' in flat file '{}' is broken!", name, filename);
+        }
+        std::array<double, 2> range{};
+        std::memcpy(range.data(), rangeIter->second.second, 2 * sizeof(double));
+        const auto knotCount = knotsIter->second.first / knotDim;
+        const double dt = (range.at(1) - range.at(0)) /
+                          static_cast<double>(knotCount - Configor::Prior::SplineOrder + 1);
+        return std::make_tuple(range.at(0), range.at(1), dt, knotCount, knotsIter->second.second);
+    };
+    const auto [so3St, so3Et, so3Dt, so3Count, so3Knots] =
+        RangeOf(Configor::Preference::SO3_SPLINE, 4);
+    const auto [scaleSt, scaleEt, scaleDt, scaleCount, scaleKnots] =
+        RangeOf(Configor::Preference::SCALE_SPLINE, 3);
+
+    auto splines = SplineBundleType::Create(
+        {ns_ctraj::SplineInfo(Configor::Preference::SO3_SPLINE, ns_ctraj::SplineType::So3Spline,
+                              so3St, so3Et, so3Dt),
+         ns_ctraj::SplineInfo(Configor::Preference::SCALE_SPLINE, ns_ctraj::SplineType::RdSpline,
+                              scaleSt, scaleEt, scaleDt)});
+    auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    if (so3Spline.GetKnots().size() != so3Count || scaleSpline.GetKnots().size() != scaleCount) {
+        throw Status(Status::ERROR,
+                     "the knot layout of splines in flat file '{}' can not be recovered!!!",
+                     filename);
+    }
+    for (int i = 0; i < static_cast<int>(so3Count); ++i) {
+        std::memcpy(so3Spline.GetKnot(i).data(), so3Knots + i * 4 * sizeof(double),
+                    4 * sizeof(double));
+    }
+    for (int i = 0; i < static_cast<int>(scaleCount); ++i) {
+        std::memcpy(scaleSpline.GetKnot(i).data(), scaleKnots + i * 3 * sizeof(double),
+                    3 * sizeof(double));
+    }
+    return splines;
+}
+
+bool FlatParamIO::IsFlatFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::string magic(MagicHeader().size(), '\0');
+    return file.read(magic.data(), static_cast<std::streamsize>(magic.size())) &&
+           magic == MagicHeader();
+}
+
+}  // namespace ns_ikalibr
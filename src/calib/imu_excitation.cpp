@@ -0,0 +1,112 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/imu_excitation.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+std::vector<IMUExcitation::Window> IMUExcitation::Evaluate(const std::vector<IMUFrame::Ptr> &mes,
+                                                           double windowLength) {
+    if (mes.empty() || windowLength <= 0.0) {
+        return {};
+    }
+    const double st = mes.front()->GetTimestamp(), et = mes.back()->GetTimestamp();
+    const int count = std::max(1, static_cast<int>(std::ceil((et - st) / windowLength)));
+    std::vector<Window> windows(count);
+
+    auto timeLess = [](const IMUFrame::Ptr &frame, double time) {
+        return frame->GetTimestamp() < time;
+    };
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < count; ++i) {
+        auto &window = windows.at(i);
+        window.begTime = st + i * windowLength;
+        window.endTime = std::min(window.begTime + windowLength, et);
+        auto beg = std::lower_bound(mes.cbegin(), mes.cend(), window.begTime, timeLess);
+        // the last window is closed
+        auto end = i == count - 1
+                       ? mes.cend()
+                       : std::lower_bound(beg, mes.cend(), window.begTime + windowLength, timeLess);
+        window.mesCount = static_cast<int>(std::distance(beg, end));
+        window.angularScore = window.linearScore = 0.0;
+        if (window.mesCount < MinMesCount) {
+            continue;
+        }
+        double gyroSqNorm = 0.0;
+        Eigen::Vector3d acceSum = Eigen::Vector3d::Zero();
+        double acceSqNorm = 0.0;
+        for (auto iter = beg; iter != end; ++iter) {
+            gyroSqNorm += (*iter)->GetGyro().squaredNorm();
+            acceSum += (*iter)->GetAcce();
+            acceSqNorm += (*iter)->GetAcce().squaredNorm();
+        }
+        const double n = window.mesCount;
+        window.angularScore = std::sqrt(gyroSqNorm / n);
+        // the square root of the trace of the covariance of specific forces
+        window.linearScore = std::sqrt(std::max(0.0, acceSqNorm / n - (acceSum / n).squaredNorm()));
+    }
+    return windows;
+}
+
+std::vector<IMUExcitation::Segment> IMUExcitation::ExcitedSegments(
+    const std::vector<Window> &windows,
+    double angularThd,
+    double linearThd,
+    double padding,
+    double mergeGap) {
+    std::vector<Segment> segments;
+    if (windows.empty()) {
+        return segments;
+    }
+    const double st = windows.front().begTime, et = windows.back().endTime;
+    for (const auto &window : windows) {
+        if (!window.IsExcited(angularThd, linearThd)) {
+            continue;
+        }
+        Segment segment{std::max(st, window.begTime - padding),
+                        std::min(et, window.endTime + padding)};
+        if (!segments.empty() && segment.first - segments.back().second <= mergeGap) {
+            segments.back().second = std::max(segments.back().second, segment.second);
+        } else {
+            segments.push_back(segment);
+        }
+    }
+    return segments;
+}
+
+}  // namespace ns_ikalibr
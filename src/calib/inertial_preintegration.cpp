@@ -0,0 +1,167 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/inertial_preintegration.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+InertialPreintegration::InertialPreintegration(const std::vector<IMUFrame::Ptr> &frames,
+                                               const So3SplineType &so3Spline,
+                                               const Sophus::SO3d &SO3_BiToBr,
+                                               double TO_BiToBr)
+    : _frames(frames.data()),
+      _frameCount(frames.size()),
+      _SO3_BiToBr(SO3_BiToBr),
+      _TO_BiToBr(TO_BiToBr) {
+    _timeByBi.reserve(frames.size());
+    _vecOnce.reserve(frames.size());
+    _matOnce.reserve(frames.size());
+
+    double lastTimeByBr = 0.0;
+    Eigen::Vector3d lastVec;
+    Eigen::Matrix3d lastMat;
+    for (const auto &frame : frames) {
+        double curTimeByBr = frame->GetTimestamp() + TO_BiToBr;
+
+        if (!so3Spline.TimeStampInRange(curTimeByBr)) {
+            continue;
+        }
+
+        auto SO3_BrToBr0 = so3Spline.Evaluate(curTimeByBr);
+
+        // angular velocity in world
+        auto SO3_VEL_BrToBr0InBr0 = SO3_BrToBr0 * so3Spline.VelocityBody(curTimeByBr);
+        Eigen::Matrix3d SO3_VEL_MAT = Sophus::SO3d::hat(SO3_VEL_BrToBr0InBr0);
+
+        // angular acceleration in world
+        auto SO3_ACCE_BrToBr0InBr0 = SO3_BrToBr0 * so3Spline.AccelerationBody(curTimeByBr);
+        Eigen::Matrix3d SO3_ACCE_MAT = Sophus::SO3d::hat(SO3_ACCE_BrToBr0InBr0);
+
+        Eigen::Vector3d curVec = SO3_BrToBr0 * SO3_BiToBr * frame->GetAcce();
+        Eigen::Matrix3d curMat = (SO3_ACCE_MAT + SO3_VEL_MAT * SO3_VEL_MAT) * SO3_BrToBr0.matrix();
+
+        if (_timeByBi.empty()) {
+            _vecOnce.emplace_back(Eigen::Vector3d::Zero());
+            _matOnce.emplace_back(Eigen::Matrix3d::Zero());
+        } else {
+            // the trapezoidal rule, see 'TrapIntegrationOnce'
+            const double dt = curTimeByBr - lastTimeByBr;
+            _vecOnce.emplace_back(_vecOnce.back() + (lastVec + curVec) * dt * 0.5);
+            _matOnce.emplace_back(_matOnce.back() + (lastMat + curMat) * dt * 0.5);
+            _midTimeByBr.push_back((lastTimeByBr + curTimeByBr) * 0.5);
+        }
+        _timeByBi.push_back(frame->GetTimestamp());
+        lastTimeByBr = curTimeByBr;
+        lastVec = curVec;
+        lastMat = curMat;
+    }
+
+    /**
+     * 'TrapIntegrationTwice' integrates the once integration sampled at mid times, i.e., the m-th
+     * sample of the once integration starting from frame 'a' is (_xxxOnce[m + 1] - _xxxOnce[a]).
+     * The constant '_xxxOnce[a]' is taken out of the sum, see 'PosIntegration', the remaining part
+     * is accumulated here
+     */
+    const std::size_t midCount = _midTimeByBr.size();
+    _vecTwice.reserve(midCount);
+    _matTwice.reserve(midCount);
+    for (std::size_t m = 0; m < midCount; ++m) {
+        if (m == 0) {
+            _vecTwice.emplace_back(Eigen::Vector3d::Zero());
+            _matTwice.emplace_back(Eigen::Matrix3d::Zero());
+            continue;
+        }
+        const double dt = _midTimeByBr.at(m) - _midTimeByBr.at(m - 1);
+        _vecTwice.emplace_back(_vecTwice.back() + (_vecOnce.at(m) + _vecOnce.at(m + 1)) * dt * 0.5);
+        _matTwice.emplace_back(_matTwice.back() + (_matOnce.at(m) + _matOnce.at(m + 1)) * dt * 0.5);
+    }
+}
+
+InertialPreintegration::Ptr InertialPreintegration::Create(const std::vector<IMUFrame::Ptr> &frames,
+                                                           const So3SplineType &so3Spline,
+                                                           const Sophus::SO3d &SO3_BiToBr,
+                                                           double TO_BiToBr) {
+    return std::make_shared<InertialPreintegration>(frames, so3Spline, SO3_BiToBr, TO_BiToBr);
+}
+
+bool InertialPreintegration::Matches(const std::vector<IMUFrame::Ptr> &frames,
+                                     const Sophus::SO3d &SO3_BiToBr,
+                                     double TO_BiToBr) const {
+    return _frames == frames.data() && _frameCount == frames.size() && _TO_BiToBr == TO_BiToBr &&
+           _SO3_BiToBr.unit_quaternion().coeffs() == SO3_BiToBr.unit_quaternion().coeffs();
+}
+
+std::optional<InertialPreintegration::VecMatPair> InertialPreintegration::VelIntegration(
+    double sTimeByBi, double eTimeByBi) const {
+    auto [sIdx, eIdx] = FrameIndexRange(sTimeByBi, eTimeByBi);
+    if (eIdx < sIdx + 2) {
+        // invalid integration data
+        return {};
+    }
+    return VecMatPair{_vecOnce.at(eIdx - 1) - _vecOnce.at(sIdx),
+                      _matOnce.at(eIdx - 1) - _matOnce.at(sIdx)};
+}
+
+std::optional<std::pair<InertialPreintegration::VecMatPair, InertialPreintegration::VecMatPair>>
+InertialPreintegration::PosIntegration(double sTimeByBi, double eTimeByBi) const {
+    auto velIntegration = VelIntegration(sTimeByBi, eTimeByBi);
+    if (velIntegration == std::nullopt) {
+        return {};
+    }
+    auto [sIdx, eIdx] = FrameIndexRange(sTimeByBi, eTimeByBi);
+    // mid times involved are [sIdx, eIdx - 2]
+    const double midTimeSpan = _midTimeByBr.at(eIdx - 2) - _midTimeByBr.at(sIdx);
+    VecMatPair posIntegration{
+        _vecTwice.at(eIdx - 2) - _vecTwice.at(sIdx) - _vecOnce.at(sIdx) * midTimeSpan,
+        _matTwice.at(eIdx - 2) - _matTwice.at(sIdx) - _matOnce.at(sIdx) * midTimeSpan};
+    return std::pair<VecMatPair, VecMatPair>{*velIntegration, posIntegration};
+}
+
+std::size_t InertialPreintegration::Size() const { return _timeByBi.size(); }
+
+std::pair<std::size_t, std::size_t> InertialPreintegration::FrameIndexRange(
+    double sTimeByBi, double eTimeByBi) const {
+    // frames in (sTimeByBi, eTimeByBi), the same as 'CalibDataManager::ExtractIMUDataPiece'
+    auto sIter = std::upper_bound(_timeByBi.cbegin(), _timeByBi.cend(), sTimeByBi);
+    auto eIter = std::lower_bound(_timeByBi.cbegin(), _timeByBi.cend(), eTimeByBi);
+    auto sIdx = static_cast<std::size_t>(std::distance(_timeByBi.cbegin(), sIter));
+    auto eIdx = static_cast<std::size_t>(std::distance(_timeByBi.cbegin(), eIter));
+    return {sIdx, std::max(sIdx, eIdx)};
+}
+
+}  // namespace ns_ikalibr
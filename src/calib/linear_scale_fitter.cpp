@@ -0,0 +1,146 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/linear_scale_fitter.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+LinearScaleFitter::LinearScaleFitter(double minTime, double maxTime, int knotCount)
+    : _minTime(minTime),
+      _maxTime(maxTime),
+      _dtInv(static_cast<double>(knotCount - Order + 1) / (maxTime - minTime)),
+      _knotCount(knotCount),
+      _band(Eigen::MatrixXd::Zero(knotCount, Order)),
+      _rhs(Eigen::MatrixX3d::Zero(knotCount, 3)),
+      _count(0) {
+    static_assert(Order == 4, "the linear scale fitter only supports 'Order == 4'");
+}
+
+LinearScaleFitter::Ptr LinearScaleFitter::Create(double minTime, double maxTime, int knotCount) {
+    return std::make_shared<LinearScaleFitter>(minTime, maxTime, knotCount);
+}
+
+bool LinearScaleFitter::AddConstraint(double time,
+                                      int deriv,
+                                      const Eigen::Vector3d &value,
+                                      double weight) {
+    if (time < _minTime || time >= _maxTime) {
+        return false;
+    }
+    const double s = (time - _minTime) * _dtInv;
+    const int idx = std::min(static_cast<int>(s), _knotCount - Order);
+    const Eigen::Vector4d coeff = BasisCoeff(s - idx, deriv);
+
+    const double w2 = weight * weight;
+    for (int r = 0; r < Order; ++r) {
+        for (int c = 0; c <= r; ++c) {
+            _band(idx + r, r - c) += w2 * coeff(r) * coeff(c);
+        }
+        _rhs.row(idx + r) += w2 * coeff(r) * value.transpose();
+    }
+    ++_count;
+    return true;
+}
+
+std::optional<std::vector<Eigen::Vector3d>> LinearScaleFitter::Solve(double damping) const {
+    const int n = _knotCount;
+    // the banded cholesky factor, stored as the normal matrix: 'L(i, k) = L(i, i - k)'
+    Eigen::MatrixXd L = Eigen::MatrixXd::Zero(n, Order);
+    for (int j = 0; j < n; ++j) {
+        double d = _band(j, 0) + damping;
+        for (int k = std::max(0, j - Order + 1); k < j; ++k) {
+            d -= L(j, j - k) * L(j, j - k);
+        }
+        if (d <= 0.0) {
+            return {};
+        }
+        L(j, 0) = std::sqrt(d);
+        for (int i = j + 1; i < std::min(n, j + Order); ++i) {
+            double v = _band(i, i - j);
+            for (int k = std::max(0, i - Order + 1); k < j; ++k) {
+                v -= L(i, i - k) * L(j, j - k);
+            }
+            L(i, i - j) = v / L(j, 0);
+        }
+    }
+    // forward substitution 'L * y = b'
+    Eigen::MatrixX3d x = _rhs;
+    for (int i = 0; i < n; ++i) {
+        for (int k = std::max(0, i - Order + 1); k < i; ++k) {
+            x.row(i) -= L(i, i - k) * x.row(k);
+        }
+        x.row(i) /= L(i, 0);
+    }
+    // backward substitution 'L^T * x = y'
+    for (int i = n - 1; i >= 0; --i) {
+        for (int k = i + 1; k < std::min(n, i + Order); ++k) {
+            x.row(i) -= L(k, k - i) * x.row(k);
+        }
+        x.row(i) /= L(i, 0);
+    }
+
+    std::vector<Eigen::Vector3d> knots(n);
+    for (int i = 0; i < n; ++i) {
+        knots.at(i) = x.row(i).transpose();
+    }
+    return knots;
+}
+
+std::size_t LinearScaleFitter::ConstraintCount() const { return _count; }
+
+Eigen::Vector4d LinearScaleFitter::BasisCoeff(double u, int deriv) const {
+    // polynomial coefficients (powers 0 to 3) of basis functions of the uniform cubic b-spline
+    static const Eigen::Matrix4d POLY_COEFF = (Eigen::Matrix4d() << 1.0, -3.0, 3.0, -1.0,  // B_0
+                                               4.0, 0.0, -6.0, 3.0,                        // B_1
+                                               1.0, 3.0, 3.0, -3.0,                        // B_2
+                                               0.0, 0.0, 0.0, 1.0)                         // B_3
+                                                  .finished() /
+                                              6.0;
+    // the 'deriv'-th derivatives of powers of 'u'
+    Eigen::Vector4d powers = Eigen::Vector4d::Zero();
+    for (int p = deriv; p < Order; ++p) {
+        double factor = 1.0;
+        for (int k = 0; k < deriv; ++k) {
+            factor *= p - k;
+        }
+        powers(p) = factor * std::pow(u, p - deriv);
+    }
+    return std::pow(_dtInv, deriv) * POLY_COEFF * powers;
+}
+
+}  // namespace ns_ikalibr
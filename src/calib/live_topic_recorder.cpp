@@ -0,0 +1,225 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/live_topic_recorder.h"
+#include "calib/imu_excitation.h"
+#include "config/configor.h"
+#include "sensor/imu_data_loader.h"
+#include "spdlog/spdlog.h"
+#include "util/status.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+LiveTopicRecorder::LiveTopicRecorder(std::string bagPath)
+    : _bagPath(std::move(bagPath)) {
+    std::vector<std::string> topics;
+    for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+        topics.push_back(topic);
+    }
+    for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
+        topics.push_back(topic);
+    }
+    for (const auto &[topic, _] : Configor::DataStream::LiDARTopics) {
+        topics.push_back(topic);
+    }
+    for (const auto &[topic, _] : Configor::DataStream::CameraTopics) {
+        topics.push_back(topic);
+    }
+    for (const auto &[topic, config] : Configor::DataStream::RGBDTopics) {
+        topics.push_back(topic);
+        topics.push_back(config.DepthTopic);
+    }
+    for (const auto &[topic, _] : Configor::DataStream::EventTopics) {
+        topics.push_back(topic);
+    }
+    const std::size_t capacity = Configor::Preference::LiveRingBufferCapacity;
+    for (const auto &topic : topics) {
+        _channels.insert({topic, std::make_unique<Channel>(topic, capacity)});
+    }
+    _referIMULoader = IMUDataLoader::GetLoader(
+        Configor::DataStream::IMUTopics.at(Configor::DataStream::ReferIMU).Type);
+}
+
+LiveTopicRecorder::Ptr LiveTopicRecorder::Create(const std::string &bagPath) {
+    return std::make_shared<LiveTopicRecorder>(bagPath);
+}
+
+void LiveTopicRecorder::Record() {
+    spdlog::info("live mode: recording '{}' topics into '{}'...", _channels.size(), _bagPath);
+
+    rosbag::Bag bag;
+    bag.open(_bagPath, rosbag::BagMode::Write);
+
+    ros::NodeHandle handle;
+    for (auto &[topic, channel] : _channels) {
+        Channel *ptr = channel.get();
+        boost::function<void(const MessageEvent &)> callback =
+            [ptr](const MessageEvent &event) { OnMessage(ptr, event); };
+        channel->subscriber = handle.subscribe<topic_tools::ShapeShifter>(
+            topic, static_cast<uint32_t>(channel->buffer.Capacity()), callback);
+    }
+    // callbacks of a subscription are invoked sequentially, i.e., each buffer has a single producer
+    ros::AsyncSpinner spinner(static_cast<uint32_t>(
+        std::max(1, std::min(Configor::Preference::AvailableThreads(),
+                             static_cast<int>(_channels.size())))));
+    spinner.start();
+
+    // the time span to record (measured from the first message), non-positive means unlimited
+    double spanToRecord = -1.0;
+    if (Configor::DataStream::Duration > 0.0) {
+        spanToRecord = std::max(0.0, Configor::DataStream::BeginTime) +
+                       Configor::DataStream::Duration;
+    }
+
+    ros::WallRate rate(DrainRate);
+    auto lastReport = ros::WallTime::now();
+    while (ros::ok()) {
+        Drain(bag);
+
+        const auto now = ros::WallTime::now();
+        if ((now - lastReport).toSec() >= Configor::Preference::LiveReportInterval) {
+            lastReport = now;
+            const double excited = ExcitedDuration();
+            ReportStatus(excited);
+
+            if (Configor::DataStream::LiveExcitedDuration > 0.0 &&
+                excited >= Configor::DataStream::LiveExcitedDuration) {
+                spdlog::info("live mode: enough excitation collected, stop recording.");
+                break;
+            }
+            const auto &refer = *_channels.at(Configor::DataStream::ReferIMU);
+            if (spanToRecord > 0.0 && refer.recorded > 0 &&
+                (refer.lastTime - refer.firstTime).toSec() >= spanToRecord) {
+                spdlog::info("live mode: the expected duration is recorded, stop recording.");
+                break;
+            }
+        }
+        rate.sleep();
+    }
+    if (!ros::ok()) {
+        spdlog::warn("live mode: interrupted, calibrate using data recorded so far.");
+    }
+
+    spinner.stop();
+    for (auto &[topic, channel] : _channels) {
+        channel->subscriber.shutdown();
+    }
+    Drain(bag);
+    bag.close();
+    ReportStatus(ExcitedDuration());
+
+    if (_referIMUMes.empty()) {
+        throw Status(Status::ERROR,
+                     "live mode: no message of the reference imu '{}' is received!",
+                     Configor::DataStream::ReferIMU);
+    }
+}
+
+void LiveTopicRecorder::OnMessage(Channel *channel, const MessageEvent &event) {
+    if (!channel->buffer.TryPush(event)) {
+        channel->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::size_t LiveTopicRecorder::Drain(rosbag::Bag &bag) {
+    std::size_t count = 0;
+    MessageEvent event;
+    for (auto &[topic, channel] : _channels) {
+        const bool isReferIMU = topic == Configor::DataStream::ReferIMU;
+        while (channel->buffer.TryPop(event)) {
+            const ros::Time &time = event.getReceiptTime();
+            if (channel->recorded == 0) {
+                channel->firstTime = time;
+            } else {
+                channel->maxGap = std::max(channel->maxGap, (time - channel->lastTime).toSec());
+            }
+            channel->lastTime = time;
+            ++channel->recorded;
+
+            const auto &msg = event.getConstMessage();
+            bag.write(topic, time, *msg, event.getConnectionHeaderPtr());
+            if (isReferIMU) {
+                // unpacked by the loader used in the offline mode, thus units are the same
+                _referIMUMes.push_back(_referIMULoader->UnpackFrame(*msg));
+            }
+            ++count;
+        }
+    }
+    return count;
+}
+
+double LiveTopicRecorder::ExcitedDuration() const {
+    const double target = Configor::Preference::TargetInfoPerSecond > 0.0
+                              ? Configor::Preference::TargetInfoPerSecond
+                              : Configor::Preference::LiveMinInfoPerSecond;
+    const auto windows =
+        IMUExcitation::Evaluate(_referIMUMes, Configor::Preference::ExcitationWindowLength);
+    double duration = 0.0;
+    for (const auto &window : windows) {
+        if (window.IsExcited(target, target * Configor::Prior::GravityNorm)) {
+            duration += window.endTime - window.begTime;
+        }
+    }
+    return duration;
+}
+
+void LiveTopicRecorder::ReportStatus(double excitedDuration) const {
+    for (const auto &[topic, channel] : _channels) {
+        const std::size_t dropped = channel->dropped.load(std::memory_order_relaxed);
+        if (channel->recorded == 0) {
+            spdlog::warn("live topic '{}': no message received yet, '{}' dropped", topic, dropped);
+            continue;
+        }
+        const double span = (channel->lastTime - channel->firstTime).toSec();
+        const double freq = span > 0.0 ? static_cast<double>(channel->recorded - 1) / span : 0.0;
+        spdlog::info(
+            "live topic '{}': '{}' messages, span '{:.3f}' (s), freq '{:.3f}' (Hz), max gap "
+            "'{:.3f}' (s), '{}' dropped",
+            topic, channel->recorded, span, freq, channel->maxGap, dropped);
+        if (dropped > 0) {
+            spdlog::warn(
+                "messages of '{}' are dropped as its ring buffer (capacity: '{}') is full!", topic,
+                channel->buffer.Capacity());
+        }
+    }
+    spdlog::info("excited duration of reference imu '{}': '{:.3f}' (s) of '{:.3f}' (s) required",
+                 Configor::DataStream::ReferIMU, excitedDuration,
+                 Configor::DataStream::LiveExcitedDuration);
+}
+
+}  // namespace ns_ikalibr
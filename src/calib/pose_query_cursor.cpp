@@ -0,0 +1,102 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/pose_query_cursor.h"
+#include "calib/spline_sampler.h"
+#include "ctraj/spline/ceres_spline_helper.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+PoseQueryCursor::PoseQueryCursor(SplineBundleType::Ptr splines,
+                                 double timeOffset,
+                                 const Sophus::SE3d &SE3_SenToBr)
+    : _splines(std::move(splines)),
+      _so3Spline(_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE)),
+      _posSpline(_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE)),
+      _so3DtInv(1.0 / SplineSampler::KnotTimeDist(_so3Spline)),
+      _posDtInv(1.0 / SplineSampler::KnotTimeDist(_posSpline)),
+      _timeOffset(timeOffset),
+      _SE3_SenToBr(SE3_SenToBr) {}
+
+std::optional<Sophus::SE3d> PoseQueryCursor::Query(double timeBySen) {
+    using Helper = ns_ctraj::CeresSplineHelper<Order>;
+    const double timeByBr = timeBySen + _timeOffset;
+    if (!_so3Spline.TimeStampInRange(timeByBr) || !_posSpline.TimeStampInRange(timeByBr)) {
+        return {};
+    }
+
+    const auto [so3U, so3Idx] = _so3Spline.ComputeTIndex(timeByBr);
+    if (static_cast<std::int64_t>(so3Idx) != _so3Seg) {
+        _so3Seg = static_cast<std::int64_t>(so3Idx);
+        for (int j = 0; j < Order; ++j) {
+            _so3Knots[j] = _so3Spline.GetKnot(static_cast<int>(_so3Seg) + j).data();
+        }
+    }
+    Sophus::SO3d SO3_BrToW;
+    Helper::EvaluateLie(_so3Knots.data(), so3U, _so3DtInv, &SO3_BrToW);
+
+    const auto [posU, posIdx] = _posSpline.ComputeTIndex(timeByBr);
+    if (static_cast<std::int64_t>(posIdx) != _posSeg) {
+        _posSeg = static_cast<std::int64_t>(posIdx);
+        for (int j = 0; j < Order; ++j) {
+            _posKnots[j] = _posSpline.GetKnot(static_cast<int>(_posSeg) + j).data();
+        }
+    }
+    Eigen::Vector3d POS_BrInW;
+    Helper::Evaluate<double, 3, 0>(_posKnots.data(), posU, _posDtInv, &POS_BrInW);
+
+    return Sophus::SE3d(SO3_BrToW, POS_BrInW) * _SE3_SenToBr;
+}
+
+std::vector<std::optional<Sophus::SE3d>> PoseQueryCursor::QueryBatch(
+    const std::vector<double> &timesBySen) const {
+    const int count = static_cast<int>(timesBySen.size());
+    const int chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<std::optional<Sophus::SE3d>> poses(count);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(chunkCount, count, timesBySen, poses)
+    for (int c = 0; c < chunkCount; ++c) {
+        PoseQueryCursor cursor = *this;
+        for (int i = c * CHUNK_SIZE; i < std::min(count, (c + 1) * CHUNK_SIZE); ++i) {
+            poses[i] = cursor.Query(timesBySen[i]);
+        }
+    }
+    return poses;
+}
+
+}  // namespace ns_ikalibr
@@ -0,0 +1,453 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/residual_evaluator.h"
+#include "calib/spline_sampler.h"
+#include "factor/data_correspondence.h"
+#include "sensor/radar.h"
+#include "util/status.hpp"
+#include "spdlog/fmt/fmt.h"
+#include "omp.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+template <class Type>
+struct ResidualDim {
+    static constexpr int value = Type::RowsAtCompileTime;
+};
+
+template <>
+struct ResidualDim<double> {
+    static constexpr int value = 1;
+};
+
+static const double *DataOf(const double &residual) { return &residual; }
+
+static const double *DataOf(const Eigen::Vector2d &residual) { return residual.data(); }
+
+/**
+ * evaluate residuals of 'count' measurements in parallel, 'func(i, &residual)' returns false if the
+ * i-th measurement is not evaluable (out of the time range), whose residual would be dropped.
+ * Statistics are accumulated by each thread in the pass, and merged at last
+ */
+template <class Container, class Func>
+static Container EvaluateInParallel(int count, const Func &func, ResidualStatistics *stats) {
+    constexpr int DIM = ResidualDim<typename Container::value_type>::value;
+    if (stats != nullptr) {
+        *stats = ResidualStatistics(DIM);
+    }
+    Container residuals(count);
+    std::vector<char> valid(count, 0);
+#pragma omp parallel num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(count, func, residuals, valid, stats)
+    {
+        ResidualStatistics localStats(DIM);
+#pragma omp for
+        for (int i = 0; i < count; ++i) {
+            valid[i] = func(i, &residuals[i]);
+            if (stats != nullptr && valid[i]) {
+                localStats.Add(DataOf(residuals[i]));
+            }
+        }
+        if (stats != nullptr) {
+#pragma omp critical
+            { stats->Merge(localStats); }
+        }
+    }
+    std::size_t validCount = 0;
+    for (int i = 0; i < count; ++i) {
+        if (valid[i]) {
+            residuals[validCount++] = residuals[i];
+        }
+    }
+    residuals.resize(validCount);
+    return residuals;
+}
+
+// ------------------
+// ResidualStatistics
+// ------------------
+
+ResidualStatistics::ResidualStatistics(int dim)
+    : dim(dim),
+      count(0),
+      sum(dim, 0.0),
+      sqSum(0.0),
+      minNorm(std::numeric_limits<double>::max()),
+      maxNorm(0.0),
+      histogram((MAX_DECADE - MIN_DECADE) * BINS_PER_DECADE + 2, 0) {}
+
+void ResidualStatistics::Add(const double *residual) {
+    double sqNorm = 0.0;
+    for (int i = 0; i < dim; ++i) {
+        sum[i] += residual[i];
+        sqNorm += residual[i] * residual[i];
+    }
+    const double norm = std::sqrt(sqNorm);
+    ++count;
+    sqSum += sqNorm;
+    minNorm = std::min(minNorm, norm);
+    maxNorm = std::max(maxNorm, norm);
+
+    // the bin index is computed from the log of the norm directly, zero norms are underflows
+    std::size_t bin = 0;
+    if (norm > 0.0) {
+        const double pos = (std::log10(norm) - MIN_DECADE) * BINS_PER_DECADE;
+        if (pos >= 0.0) {
+            bin = std::min(static_cast<std::size_t>(pos) + 1, histogram.size() - 1);
+        }
+    }
+    ++histogram[bin];
+}
+
+void ResidualStatistics::Merge(const ResidualStatistics &other) {
+    if (other.dim != dim) {
+        throw Status(Status::CRITICAL, "can not merge residual statistics with dims {} and {}",
+                     dim, other.dim);
+    }
+    count += other.count;
+    for (int i = 0; i < dim; ++i) {
+        sum[i] += other.sum[i];
+    }
+    sqSum += other.sqSum;
+    minNorm = std::min(minNorm, other.minNorm);
+    maxNorm = std::max(maxNorm, other.maxNorm);
+    for (std::size_t i = 0; i < histogram.size(); ++i) {
+        histogram[i] += other.histogram[i];
+    }
+}
+
+std::vector<double> ResidualStatistics::Mean() const {
+    std::vector<double> mean(dim, 0.0);
+    if (count != 0) {
+        for (int i = 0; i < dim; ++i) {
+            mean[i] = sum[i] / static_cast<double>(count);
+        }
+    }
+    return mean;
+}
+
+double ResidualStatistics::RMSE() const {
+    return count == 0 ? 0.0 : std::sqrt(sqSum / static_cast<double>(count));
+}
+
+std::vector<double> ResidualStatistics::BinEdges() {
+    std::vector<double> edges;
+    edges.reserve((MAX_DECADE - MIN_DECADE) * BINS_PER_DECADE + 1);
+    for (int i = 0; i <= (MAX_DECADE - MIN_DECADE) * BINS_PER_DECADE; ++i) {
+        edges.push_back(std::pow(10.0, MIN_DECADE + static_cast<double>(i) / BINS_PER_DECADE));
+    }
+    return edges;
+}
+
+std::string ResidualStatistics::Summary() const {
+    if (count == 0) {
+        return "count: 0";
+    }
+    std::string meanStr;
+    for (const double &m : Mean()) {
+        meanStr += (meanStr.empty() ? "" : ", ") + fmt::format("{:.6f}", m);
+    }
+    return fmt::format("count: {}, mean: [{}], rmse: {:.6f}, norm range: [{:.6f}, {:.6f}]", count,
+                       meanStr, RMSE(), minNorm, maxNorm);
+}
+
+// ---------------------------
+// ResidualEvaluator::*Pack
+// ---------------------------
+
+ResidualEvaluator::RadarPack ResidualEvaluator::RadarPack::Pack(
+    const std::vector<RadarTargetArrayPtr> &arrays) {
+    std::size_t count = 0;
+    for (const auto &ary : arrays) {
+        count += ary->GetTargets().size();
+    }
+    RadarPack pack;
+    pack.times.reserve(count), pack.targetsInRj.reserve(count);
+    pack.invRanges.reserve(count), pack.radialVels.reserve(count);
+    for (const auto &ary : arrays) {
+        for (const auto &tar : ary->GetTargets()) {
+            pack.times.push_back(tar->GetTimestamp());
+            pack.targetsInRj.push_back(tar->GetTargetXYZ());
+            pack.invRanges.push_back(tar->GetInvRange());
+            pack.radialVels.push_back(tar->GetRadialVelocity());
+        }
+    }
+    return pack;
+}
+
+ResidualEvaluator::ReprojPack ResidualEvaluator::ReprojPack::Pack(
+    const std::vector<VisualReProjCorrSeqPtr> &corrSeqs) {
+    std::size_t count = 0;
+    for (const auto &corrs : corrSeqs) {
+        count += corrs->corrs.size();
+    }
+    ReprojPack pack;
+    pack.ti.reserve(count), pack.tj.reserve(count), pack.li.reserve(count);
+    pack.lj.reserve(count), pack.fi.reserve(count), pack.fj.reserve(count);
+    pack.depths.reserve(count);
+    for (const auto &corrs : corrSeqs) {
+        const double DEPTH = 1.0 / *corrs->invDepthFir;
+        for (const auto &corr : corrs->corrs) {
+            pack.ti.push_back(corr->ti), pack.tj.push_back(corr->tj);
+            pack.li.push_back(corr->li), pack.lj.push_back(corr->lj);
+            pack.fi.push_back(corr->fi), pack.fj.push_back(corr->fj);
+            pack.depths.push_back(DEPTH);
+        }
+    }
+    return pack;
+}
+
+ResidualEvaluator::OpticalFlowPack ResidualEvaluator::OpticalFlowPack::Pack(
+    const std::vector<OpticalFlowCorrPtr> &corrs, double readout) {
+    OpticalFlowPack pack;
+    pack.times.reserve(corrs.size()), pack.points.reserve(corrs.size());
+    pack.vels.reserve(corrs.size()), pack.depths.reserve(corrs.size());
+    for (const auto &corr : corrs) {
+        pack.times.push_back(corr->MidPointTime(readout));
+        pack.points.push_back(corr->MidPoint());
+        pack.vels.push_back(corr->MidPointVel(readout));
+        pack.depths.push_back(corr->depth);
+    }
+    return pack;
+}
+
+ResidualEvaluator::PointToSurfelPack ResidualEvaluator::PointToSurfelPack::Pack(
+    const PointToSurfelCorrBuffer &corrs) {
+    PointToSurfelPack pack;
+    pack.times = corrs.timestamps;
+    pack.pointsInScan.reserve(corrs.Size()), pack.surfelsInW.reserve(corrs.Size());
+    for (std::size_t i = 0; i < corrs.Size(); ++i) {
+        pack.pointsInScan.push_back(corrs.pInScan.at(i).cast<double>());
+        pack.surfelsInW.push_back(corrs.SurfelOf(i));
+    }
+    return pack;
+}
+
+// -----------------
+// ResidualEvaluator
+// -----------------
+
+ResidualEvaluator::ResidualEvaluator(SplineBundleType::Ptr splines,
+                                     TimeDeriv::ScaleSplineType scaleType)
+    : _splines(std::move(splines)),
+      _scaleType(scaleType) {}
+
+ResidualEvaluator::Ptr ResidualEvaluator::Create(const SplineBundleType::Ptr &splines,
+                                                 TimeDeriv::ScaleSplineType scaleType) {
+    return std::make_shared<ResidualEvaluator>(splines, scaleType);
+}
+
+std::vector<double> ResidualEvaluator::RadarDoppler(const RadarPack &pack,
+                                                    double TO_RjToBr,
+                                                    const Sophus::SE3d &SE3_RjToBr,
+                                                    ResidualStatistics *stats) const {
+    std::vector<double> times(pack.times.size());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        times[i] = pack.times[i] + TO_RjToBr;
+    }
+    const auto samples = SplineSampler::Evaluate(_splines, times, LinVelDeriv(), true);
+
+    const Eigen::Matrix3d ROT_BrToRj = SE3_RjToBr.so3().matrix().transpose();
+    return EvaluateInParallel<std::vector<double>>(
+        static_cast<int>(samples.size()), [&](int i, double *error) {
+            const auto &sample = samples[i];
+            if (!sample.valid) {
+                return false;
+            }
+            const Sophus::SO3d &SO3_BrToBr0 = sample.so3;
+            const Eigen::Vector3d ANG_VEL_BrToBr0InBr0 = SO3_BrToBr0 * sample.angVelInBody;
+            const Eigen::Vector3d &LIN_VEL_BrInBr0 = sample.scale;
+
+            const Eigen::Vector3d LIN_VEL_RjInBr0 =
+                -Sophus::SO3d::hat(SO3_BrToBr0 * SE3_RjToBr.translation()) *
+                    ANG_VEL_BrToBr0InBr0 +
+                LIN_VEL_BrInBr0;
+            const double v1 = -pack.targetsInRj[i].dot(
+                ROT_BrToRj * (SO3_BrToBr0.matrix().transpose() * LIN_VEL_RjInBr0));
+
+            *error = pack.invRanges[i] * v1 - pack.radialVels[i];
+            return true;
+        },
+        stats);
+}
+
+Eigen::aligned_vector<Eigen::Vector2d> ResidualEvaluator::VisualReprojection(
+    const ReprojPack &pack,
+    double TO_CmToBr,
+    double readout,
+    const Sophus::SE3d &SE3_CmToBr,
+    const ns_veta::PinholeIntrinsic::Ptr &intri,
+    ResidualStatistics *stats) const {
+    CheckPosSpline("VisualReprojection");
+
+    // times of i-feats are followed by the ones of j-feats
+    const std::size_t count = pack.ti.size();
+    std::vector<double> times(2 * count);
+    for (std::size_t i = 0; i < count; ++i) {
+        times[i] = pack.ti[i] + TO_CmToBr + pack.li[i] * readout;
+        times[count + i] = pack.tj[i] + TO_CmToBr + pack.lj[i] * readout;
+    }
+    const auto samples = SplineSampler::Evaluate(_splines, times, 0, false);
+
+    const double FX = intri->FocalX(), FX_INV = 1.0 / FX;
+    const double FY = intri->FocalY(), FY_INV = 1.0 / FY;
+    const double CX = intri->PrincipalPoint()(0);
+    const double CY = intri->PrincipalPoint()(1);
+    const Sophus::SE3d SE3_BrToCm = SE3_CmToBr.inverse();
+
+    return EvaluateInParallel<Eigen::aligned_vector<Eigen::Vector2d>>(
+        static_cast<int>(count), [&](int i, Eigen::Vector2d *residuals) {
+            const auto &sampleI = samples[i], &sampleJ = samples[count + i];
+            if (!sampleI.valid || !sampleJ.valid) {
+                return false;
+            }
+            const Sophus::SE3d SE3_BrToBr0_I(sampleI.so3, sampleI.scale);
+            const Sophus::SE3d SE3_BrToBr0_J(sampleJ.so3, sampleJ.scale);
+            const Sophus::SE3d SE3_CmIToCmJ =
+                SE3_BrToCm * SE3_BrToBr0_J.inverse() * SE3_BrToBr0_I * SE3_CmToBr;
+
+            Eigen::Vector3d PI;
+            VisualReProjCorr::TransformImgToCam<double>(&FX_INV, &FY_INV, &CX, &CY, pack.fi[i],
+                                                        &PI);
+            PI *= pack.depths[i];
+
+            Eigen::Vector3d PJ = SE3_CmIToCmJ * PI;
+            PJ /= PJ(2);
+            Eigen::Vector2d fjPred;
+            VisualReProjCorr::TransformCamToImg<double>(&FX, &FY, &CX, &CY, PJ, &fjPred);
+
+            *residuals = fjPred - pack.fj[i];
+            return true;
+        },
+        stats);
+}
+
+Eigen::aligned_vector<Eigen::Vector2d> ResidualEvaluator::VisualOpticalFlow(
+    const OpticalFlowPack &pack,
+    double TO_CamToBr,
+    const Sophus::SE3d &SE3_CamToBr,
+    const ns_veta::PinholeIntrinsic::Ptr &intri,
+    ResidualStatistics *stats) const {
+    std::vector<double> times(pack.times.size());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        times[i] = pack.times[i] + TO_CamToBr;
+    }
+    const auto samples = SplineSampler::Evaluate(_splines, times, LinVelDeriv(), true);
+
+    const double FX = intri->FocalX(), FY = intri->FocalY();
+    const double CX = intri->PrincipalPoint()(0), CY = intri->PrincipalPoint()(1);
+    const Sophus::SO3d SO3_BrToCam = SE3_CamToBr.so3().inverse();
+
+    return EvaluateInParallel<Eigen::aligned_vector<Eigen::Vector2d>>(
+        static_cast<int>(samples.size()), [&](int i, Eigen::Vector2d *residuals) {
+            const auto &sample = samples[i];
+            if (!sample.valid) {
+                return false;
+            }
+            const Sophus::SO3d &SO3_BrToBr0 = sample.so3;
+            const Eigen::Vector3d ANG_VEL_BrToBr0InBr0 = SO3_BrToBr0 * sample.angVelInBody;
+            const Eigen::Vector3d ANG_VEL_CamToBr0InCam = SO3_BrToCam * sample.angVelInBody;
+
+            const Eigen::Vector3d LIN_VEL_CamToBr0InBr0 =
+                sample.scale -
+                Sophus::SO3d::hat(SO3_BrToBr0 * SE3_CamToBr.translation()) * ANG_VEL_BrToBr0InBr0;
+            const Eigen::Vector3d LIN_VEL_CamToBr0InCam =
+                SO3_BrToCam * (SO3_BrToBr0.inverse() * LIN_VEL_CamToBr0InBr0);
+
+            Eigen::Matrix<double, 2, 3> subAMat, subBMat;
+            OpticalFlowCorr::SubMats<double>(&FX, &FY, &CX, &CY, pack.points[i], &subAMat,
+                                             &subBMat);
+            const Eigen::Vector2d pred = 1.0 / pack.depths[i] * subAMat * LIN_VEL_CamToBr0InCam +
+                                         subBMat * ANG_VEL_CamToBr0InCam;
+
+            *residuals = pred - pack.vels[i];
+            return true;
+        },
+        stats);
+}
+
+std::vector<double> ResidualEvaluator::PointToSurfel(const PointToSurfelPack &pack,
+                                                     double TO_LkToBr,
+                                                     const Sophus::SO3d &SO3_LkToBr,
+                                                     const Eigen::Vector3d &POS_LkInBr,
+                                                     ResidualStatistics *stats) const {
+    CheckPosSpline("PointToSurfel");
+
+    std::vector<double> times(pack.times.size());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        times[i] = pack.times[i] + TO_LkToBr;
+    }
+    const auto samples = SplineSampler::Evaluate(_splines, times, 0, false);
+
+    return EvaluateInParallel<std::vector<double>>(
+        static_cast<int>(samples.size()), [&](int i, double *distance) {
+            const auto &sample = samples[i];
+            if (!sample.valid) {
+                return false;
+            }
+            const Eigen::Vector3d pointInBr = SO3_LkToBr * pack.pointsInScan[i] + POS_LkInBr;
+            const Eigen::Vector3d pointInBr0 = sample.so3 * pointInBr + sample.scale;
+
+            const Eigen::Vector4d &surfel = pack.surfelsInW[i];
+            *distance = pointInBr0.dot(surfel.head<3>()) + surfel(3);
+            return true;
+        },
+        stats);
+}
+
+int ResidualEvaluator::LinVelDeriv() const {
+    switch (_scaleType) {
+        case TimeDeriv::LIN_VEL_SPLINE:
+            return 0;
+        case TimeDeriv::LIN_POS_SPLINE:
+            return 1;
+        default:
+            throw Status(Status::ERROR,
+                         "unknown scale spline type when compute velocity-based residuals");
+    }
+}
+
+void ResidualEvaluator::CheckPosSpline(const std::string &desc) const {
+    if (_scaleType != TimeDeriv::LIN_POS_SPLINE) {
+        throw Status(Status::CRITICAL, "'{}' error, scale spline is not translation spline!!!",
+                     desc);
+    }
+}
+
+}  // namespace ns_ikalibr
@@ -39,6 +39,7 @@
 #include "sensor/camera_data_loader.h"
 #include "calib/estimator.h"
 #include "calib/calib_param_manager.h"
+#include "factor/spat_temp_priori_factor.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -241,6 +242,26 @@ void SpatialTemporalPriori::AddSpatTempPrioriConstraint(Estimator& estimator,
     }
     auto RefIMU = Configor::DataStream::ReferIMU;
 
+    /**
+     * priors of all sensor pairs are stacked into a single factor, whose parameter blocks are
+     * deduplicated, as a sensor is often involved in many pairs in large rigs
+     */
+    SpatTempPrioriFactor stackedFactor;
+    std::vector<double*> parBlocks;
+    std::vector<int> sizes;
+    std::vector<bool> isSO3;
+    std::map<double*, int> parBlockIdx;
+    auto IndexOf = [&parBlocks, &sizes, &isSO3, &parBlockIdx](double* parBlock, int size,
+                                                              bool rotation) {
+        auto [iter, inserted] = parBlockIdx.insert({parBlock, static_cast<int>(parBlocks.size())});
+        if (inserted) {
+            parBlocks.push_back(parBlock);
+            sizes.push_back(size);
+            isSO3.push_back(rotation);
+        }
+        return iter->second;
+    };
+
     for (const auto& [sensorPair, Sen1ToSen2] : this->SO3_Sen1ToSen2) {
         const auto& [sen1, sen2] = sensorPair;
         Sophus::SO3d *rot1 = SO3Address.at(sen1), *rot2 = SO3Address.at(sen2);
@@ -254,7 +275,8 @@ void SpatialTemporalPriori::AddSpatTempPrioriConstraint(Estimator& estimator,
                    estimator.HasParameterBlock(rot2->data())) {
             // only one of the param block has been added to problem, we then add the constraint,
             // to make sure a unique least-squares solution
-            estimator.AddPriorExtriSO3Constraint(Sen1ToSen2, rot1, rot2, PrioriWeight);
+            stackedFactor.AddExtriSO3(Sen1ToSen2, PrioriWeight, IndexOf(rot1->data(), 4, true),
+                                      IndexOf(rot2->data(), 4, true));
         }
     }
     for (const auto& [sensorPair, Sen1InSen2] : this->POS_Sen1InSen2) {
@@ -269,7 +291,9 @@ void SpatialTemporalPriori::AddSpatTempPrioriConstraint(Estimator& estimator,
             }
         } else if (estimator.HasParameterBlock(pos1->data()) ||
                    estimator.HasParameterBlock(pos2->data())) {
-            estimator.AddPriorExtriPOSConstraint(Sen1InSen2, pos1, rot2, pos2, PrioriWeight);
+            stackedFactor.AddExtriPOS(Sen1InSen2, PrioriWeight, IndexOf(pos1->data(), 3, false),
+                                      IndexOf(rot2->data(), 4, true),
+                                      IndexOf(pos2->data(), 3, false));
         }
     }
     for (const auto& [sensorPair, Sen1ToSen2] : this->TO_Sen1ToSen2) {
@@ -282,9 +306,13 @@ void SpatialTemporalPriori::AddSpatTempPrioriConstraint(Estimator& estimator,
                 estimator.SetParameterBlockConstant(to1);
             }
         } else if (estimator.HasParameterBlock(to1) || estimator.HasParameterBlock(to2)) {
-            estimator.AddPriorTimeOffsetConstraint(Sen1ToSen2, to1, to2, PrioriWeight);
+            stackedFactor.AddTimeOffset(Sen1ToSen2, PrioriWeight, IndexOf(to1, 1, false),
+                                        IndexOf(to2, 1, false));
         }
     }
+    if (stackedFactor.NumResiduals() != 0) {
+        estimator.AddSpatTempPrioriConstraint(stackedFactor, parBlocks, sizes, isSO3);
+    }
     // readout times (we set them as constraints in optimization)
     for (const auto& [sensor, readout] : this->RS_READOUT) {
         double* data = &parMagr.TEMPORAL.RS_READOUT.at(sensor);
@@ -0,0 +1,106 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/spline_meta_cache.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+std::map<const SplineMetaCache::SplineBundleType *,
+         std::pair<std::weak_ptr<SplineMetaCache::SplineBundleType>, SplineMetaCache::Ptr>>
+    SplineMetaCache::CACHES = {};
+std::mutex SplineMetaCache::CACHES_MUTEX = {};
+
+SplineMetaCache::Ptr SplineMetaCache::Create() { return std::make_shared<SplineMetaCache>(); }
+
+SplineMetaCache::Ptr SplineMetaCache::GetCache(const SplineBundleType::Ptr &splines) {
+    std::lock_guard<std::mutex> lock(CACHES_MUTEX);
+    // erase caches of expired spline bundles, whose addresses may be reused by new ones
+    for (auto iter = CACHES.begin(); iter != CACHES.end();) {
+        if (iter->second.first.expired()) {
+            iter = CACHES.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    auto &item = CACHES[splines.get()];
+    if (item.second == nullptr) {
+        item = {splines, SplineMetaCache::Create()};
+    }
+    return item.second;
+}
+
+bool SplineMetaCache::Find(const std::string &name,
+                           TimeInitList times,
+                           SplineMetaType &meta) const {
+    auto key = GenerateKey(name, times);
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _metas.find(key);
+    if (iter == _metas.cend()) {
+        return false;
+    }
+    meta = iter->second;
+    return true;
+}
+
+void SplineMetaCache::Insert(const std::string &name,
+                             TimeInitList times,
+                             const SplineMetaType &meta) {
+    auto key = GenerateKey(name, times);
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_metas.size() >= CAPACITY) {
+        _metas.clear();
+    }
+    _metas.insert({std::move(key), meta});
+}
+
+void SplineMetaCache::Clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _metas.clear();
+}
+
+std::size_t SplineMetaCache::Size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _metas.size();
+}
+
+SplineMetaCache::KeyType SplineMetaCache::GenerateKey(const std::string &name,
+                                                      TimeInitList times) {
+    return {name, std::vector<std::pair<double, double>>(times.begin(), times.end())};
+}
+
+}  // namespace ns_ikalibr
@@ -0,0 +1,132 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/spline_sampler.h"
+#include "ctraj/spline/ceres_spline_helper.h"
+#include "omp.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+SplineSampler::SampleVec SplineSampler::Evaluate(const SplineBundleType::Ptr &splines,
+                                                 const std::vector<double> &times,
+                                                 int scaleDeriv,
+                                                 bool withAngDerivs) {
+    constexpr int Order = Configor::Prior::SplineOrder;
+    using Helper = ns_ctraj::CeresSplineHelper<Order>;
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    const double so3DtInv = 1.0 / KnotTimeDist(so3Spline);
+    const double scaleDtInv = 1.0 / KnotTimeDist(scaleSpline);
+
+    const int count = static_cast<int>(times.size());
+    const int chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    SampleVec samples(count);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(chunkCount, count, times, samples, splines, so3Spline, scaleSpline,  \
+                             so3DtInv, scaleDtInv, scaleDeriv, withAngDerivs)
+    for (int c = 0; c < chunkCount; ++c) {
+        // control points of the current segments, which are reused by times in them
+        std::array<const double *, Order> so3Knots{}, scaleKnots{};
+        std::int64_t so3Seg = -1, scaleSeg = -1;
+
+        for (int i = c * CHUNK_SIZE; i < std::min(count, (c + 1) * CHUNK_SIZE); ++i) {
+            const double t = times[i];
+            auto &sample = samples[i];
+            sample.time = t;
+            if (!splines->TimeInRange(t, so3Spline) || !splines->TimeInRange(t, scaleSpline)) {
+                continue;
+            }
+            sample.valid = true;
+
+            const auto [so3U, so3Idx] = so3Spline.ComputeTIndex(t);
+            if (static_cast<std::int64_t>(so3Idx) != so3Seg) {
+                so3Seg = static_cast<std::int64_t>(so3Idx);
+                for (int j = 0; j < Order; ++j) {
+                    so3Knots[j] = so3Spline.GetKnot(static_cast<int>(so3Seg) + j).data();
+                }
+            }
+            if (withAngDerivs) {
+                Helper::EvaluateLie(so3Knots.data(), so3U, so3DtInv, &sample.so3,
+                                    &sample.angVelInBody, &sample.angAcceInBody);
+            } else {
+                Helper::EvaluateLie(so3Knots.data(), so3U, so3DtInv, &sample.so3);
+            }
+
+            const auto [scaleU, scaleIdx] = scaleSpline.ComputeTIndex(t);
+            if (static_cast<std::int64_t>(scaleIdx) != scaleSeg) {
+                scaleSeg = static_cast<std::int64_t>(scaleIdx);
+                for (int j = 0; j < Order; ++j) {
+                    scaleKnots[j] = scaleSpline.GetKnot(static_cast<int>(scaleSeg) + j).data();
+                }
+            }
+            switch (scaleDeriv) {
+                case 0:
+                    Helper::Evaluate<double, 3, 0>(scaleKnots.data(), scaleU, scaleDtInv,
+                                                   &sample.scale);
+                    break;
+                case 1:
+                    Helper::Evaluate<double, 3, 1>(scaleKnots.data(), scaleU, scaleDtInv,
+                                                   &sample.scale);
+                    break;
+                default:
+                    Helper::Evaluate<double, 3, 2>(scaleKnots.data(), scaleU, scaleDtInv,
+                                                   &sample.scale);
+                    break;
+            }
+        }
+    }
+    return samples;
+}
+
+std::vector<double> SplineSampler::UniformTimes(double st, double et, double dt) {
+    std::vector<double> times;
+    if (et <= st || dt <= 0.0) {
+        return times;
+    }
+    times.reserve(static_cast<std::size_t>((et - st) / dt) + 1);
+    for (std::size_t i = 0;; ++i) {
+        const double t = st + static_cast<double>(i) * dt;
+        if (t >= et) {
+            break;
+        }
+        times.push_back(t);
+    }
+    return times;
+}
+
+}  // namespace ns_ikalibr
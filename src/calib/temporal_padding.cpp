@@ -0,0 +1,124 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/temporal_padding.h"
+#include "config/configor.h"
+#include "spdlog/spdlog.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+TemporalPadding::Ptr TemporalPadding::Create() { return std::make_shared<TemporalPadding>(); }
+
+double TemporalPadding::TimeOffset(const std::string &topic) const {
+    if (auto iter = _timeOffset.find(topic); iter != _timeOffset.cend()) {
+        return iter->second;
+    }
+    return Configor::Prior::TimeOffsetPadding;
+}
+
+double TemporalPadding::ReadoutTime(const std::string &topic) const {
+    if (auto iter = _readoutTime.find(topic); iter != _readoutTime.cend()) {
+        return iter->second;
+    }
+    return Configor::Prior::ReadoutTimePadding;
+}
+
+void TemporalPadding::NarrowTimeOffset(const std::string &topic,
+                                       double timeOffset,
+                                       double stdDev) {
+    _timeOffset[topic] = Narrowed(TimeOffset(topic), std::abs(timeOffset), stdDev,
+                                  Configor::Preference::TimeOffsetPaddingMin);
+}
+
+void TemporalPadding::NarrowReadoutTime(const std::string &topic,
+                                        double readoutTime,
+                                        double stdDev) {
+    _readoutTime[topic] = Narrowed(ReadoutTime(topic), readoutTime, stdDev,
+                                   Configor::Preference::ReadoutTimePaddingMin);
+}
+
+void TemporalPadding::NarrowTimeOffsetTo(const std::string &topic, double padding) {
+    _timeOffset[topic] =
+        std::min(TimeOffset(topic), std::max(padding, Configor::Preference::TimeOffsetPaddingMin));
+}
+
+bool TemporalPadding::IsNarrowed() const {
+    for (const auto &[topic, padding] : _timeOffset) {
+        if (padding < Configor::Prior::TimeOffsetPadding) {
+            return true;
+        }
+    }
+    for (const auto &[topic, padding] : _readoutTime) {
+        if (padding < Configor::Prior::ReadoutTimePadding) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TemporalPadding::operator==(const TemporalPadding &other) const {
+    return _timeOffset == other._timeOffset && _readoutTime == other._readoutTime;
+}
+
+bool TemporalPadding::operator!=(const TemporalPadding &other) const { return !(*this == other); }
+
+void TemporalPadding::ShowPaddings() const {
+    for (const auto &[topic, padding] : _timeOffset) {
+        spdlog::info("time offset padding of '{}': {:.6f} (s), priori: {:.6f} (s)", topic,
+                     padding, Configor::Prior::TimeOffsetPadding);
+    }
+    for (const auto &[topic, padding] : _readoutTime) {
+        spdlog::info("readout time padding of '{}': {:.6f} (s), priori: {:.6f} (s)", topic,
+                     padding, Configor::Prior::ReadoutTimePadding);
+    }
+}
+
+double TemporalPadding::Narrowed(double padding,
+                                 double magnitude,
+                                 double stdDev,
+                                 double minPadding) {
+    if (!std::isfinite(stdDev) || stdDev < 0.0) {
+        // the uncertainty is not available, keep the current one
+        return padding;
+    }
+    // the estimate should be an inner point of the bound, otherwise the parameter is clamped
+    const double desired = magnitude + Configor::Preference::TemporalPaddingSigma * stdDev;
+    return std::min(padding, std::max(desired, minPadding));
+}
+
+}  // namespace ns_ikalibr
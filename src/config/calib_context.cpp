@@ -0,0 +1,140 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "config/calib_context.h"
+#include "util/status.hpp"
+#include "cereal/types/map.hpp"
+#include "cereal/types/set.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+#include "atomic"
+#include "sstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+std::recursive_mutex CalibContext::ACTIVE_MUTEX = {};
+std::uint64_t CalibContext::ACTIVE_ID = 0;
+int CalibContext::ACTIVE_DEPTH = 0;
+
+// ---------------------
+// CalibContext::Scope
+// ---------------------
+
+CalibContext::Scope::Scope(const CalibContext &context)
+    : _lock(CalibContext::ACTIVE_MUTEX) {
+    // the outermost scope always installs the context, as 'Configor' may be changed directly
+    if (ACTIVE_DEPTH == 0 || ACTIVE_ID != context.GetId()) {
+        if (ACTIVE_DEPTH != 0) {
+            _replaced = {ArchiveConfigor(), ACTIVE_ID};
+        }
+        InstallToConfigor(context._archive);
+        ACTIVE_ID = context.GetId();
+    }
+    ++ACTIVE_DEPTH;
+}
+
+CalibContext::Scope::~Scope() {
+    if (_replaced != std::nullopt) {
+        InstallToConfigor(_replaced->first);
+        ACTIVE_ID = _replaced->second;
+    }
+    --ACTIVE_DEPTH;
+}
+
+// ------------
+// CalibContext
+// ------------
+
+CalibContext::CalibContext(std::string archive)
+    : _archive(std::move(archive)) {
+    static std::atomic<std::uint64_t> ID_COUNTER = 1;
+    _id = ID_COUNTER++;
+}
+
+CalibContext::Ptr CalibContext::Create(const std::string &archive) {
+    return std::make_shared<CalibContext>(archive);
+}
+
+CalibContext::Ptr CalibContext::CreateFromConfigor() {
+    std::lock_guard<std::recursive_mutex> lock(ACTIVE_MUTEX);
+    return Create(ArchiveConfigor());
+}
+
+CalibContext::Ptr CalibContext::Load(const std::string &filename,
+                                     CerealArchiveType::Enum archiveType) {
+    std::lock_guard<std::recursive_mutex> lock(ACTIVE_MUTEX);
+    const std::string previous = ArchiveConfigor();
+    CalibContext::Ptr context = nullptr;
+    try {
+        if (Configor::LoadConfigure(filename, archiveType)) {
+            context = Create(ArchiveConfigor());
+        }
+    } catch (...) {
+        InstallToConfigor(previous);
+        throw;
+    }
+    InstallToConfigor(previous);
+    return context;
+}
+
+std::unique_ptr<CalibContext::Scope> CalibContext::Activate() const {
+    return std::make_unique<Scope>(*this);
+}
+
+std::uint64_t CalibContext::GetId() const { return _id; }
+
+std::string CalibContext::ArchiveConfigor() {
+    std::stringstream stream;
+    {
+        cereal::BinaryOutputArchive ar(stream);
+        // the configurator and fields transformed from it when it is loaded
+        ar(*Configor::Create(), Configor::Preference::Outputs,
+           Configor::Preference::OutputDataFormat, Configor::Preference::ViewerMode,
+           Configor::Prior::NDTLiDAROdometer::RegistrationType);
+    }
+    return stream.str();
+}
+
+void CalibContext::InstallToConfigor(const std::string &archive) {
+    std::stringstream stream(archive);
+    cereal::BinaryInputArchive ar(stream);
+    auto configor = Configor::Create();
+    ar(*configor, Configor::Preference::Outputs, Configor::Preference::OutputDataFormat,
+       Configor::Preference::ViewerMode, Configor::Prior::NDTLiDAROdometer::RegistrationType);
+}
+}  // namespace ns_ikalibr
@@ -35,11 +35,15 @@
 #include "config/configor.h"
 #include "spdlog/spdlog.h"
 #include "util/status.hpp"
+#include "util/utils_tpl.hpp"
 #include "magic_enum_flags.hpp"
 #include "ros/package.h"
 #include "filesystem"
+#include "fstream"
 #include "cereal/types/vector.hpp"
 #include "cereal/types/set.hpp"
+#include "glob.h"
+#include "omp.h"
 
 #include <calib/time_deriv.hpp>
 
@@ -48,6 +52,9 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
 namespace ns_ikalibr {
+// the magic bytes at the beginning of an MCAP file
+const static std::string MCAP_MAGIC = "\x89MCAP0\r\n";
+
 const static std::map<std::string, OutputOption> OutputOptionMap = {
     {"NONE", OutputOption::NONE},
     {"ParamInEachIter", OutputOption::ParamInEachIter},
@@ -64,6 +71,9 @@ const static std::map<std::string, OutputOption> OutputOptionMap = {
     {"RadarDopplerErrors", OutputOption::RadarDopplerErrors},
     {"VisualOpticalFlowErrors", OutputOption::VisualOpticalFlowErrors},
     {"LiDARPointToSurfelErrors", OutputOption::LiDARPointToSurfelErrors},
+    {"BatchOptProblems", OutputOption::BatchOptProblems},
+    {"FactorProfiles", OutputOption::FactorProfiles},
+    {"TraceEvents", OutputOption::TraceEvents},
     {"ALL", OutputOption::ALL},
 };
 
@@ -82,8 +92,13 @@ std::map<std::string, Configor::DataStream::RGBDConfig> Configor::DataStream::RG
 std::map<std::string, Configor::DataStream::EventConfig> Configor::DataStream::EventTopics = {};
 std::string Configor::DataStream::ReferIMU = {};
 std::string Configor::DataStream::BagPath = {};
+std::string Configor::DataStream::LoaderPlugins = {};
 double Configor::DataStream::BeginTime = {};
 double Configor::DataStream::Duration = {};
+std::map<std::string, Configor::DataStream::DecimationConfig>
+    Configor::DataStream::TopicDecimation = {};
+bool Configor::DataStream::LiveMode = {};
+double Configor::DataStream::LiveExcitedDuration = 60.0;
 std::string Configor::DataStream::OutputPath = {};
 const std::string Configor::DataStream::PkgPath = ros::package::getPath("ikalibr");
 const std::string Configor::DataStream::DebugPath = PkgPath + "/debug/";
@@ -96,9 +111,15 @@ double Configor::Prior::MapDownSample = {};
 
 double Configor::Prior::KnotTimeDist::SO3Spline = {};
 double Configor::Prior::KnotTimeDist::ScaleSpline = {};
+const int Configor::Prior::KnotTimeDist::CoarseToFineLevels = 1;
 
 double Configor::Prior::NDTLiDAROdometer::Resolution = {};
 double Configor::Prior::NDTLiDAROdometer::KeyFrameDownSample = {};
+std::string Configor::Prior::NDTLiDAROdometer::Registration = "NDT";
+ScanRegistrationType Configor::Prior::NDTLiDAROdometer::RegistrationType =
+    ScanRegistrationType::NDT;
+const std::size_t Configor::Prior::NDTLiDAROdometer::LocalMapKeyFrames = 0;
+const bool Configor::Prior::NDTLiDAROdometer::WarmStartRerun = true;
 
 double Configor::Prior::LiDARDataAssociate::PointToSurfelMax = {};
 double Configor::Prior::LiDARDataAssociate::PlanarityMin = {};
@@ -110,6 +131,10 @@ const std::size_t Configor::Prior::LiDARDataAssociate::SurfelPointMin = 100;
 const double Configor::Prior::LiDARDataAssociate::MapResolution = 0.1;
 const std::uint8_t Configor::Prior::LiDARDataAssociate::MapDepthLevels = 16;
 const int Configor::Prior::LiDARDataAssociate::PointToSurfelCountInScan = 200;
+const double Configor::Prior::LiDARDataAssociate::CandidateOversampling = 4.0;
+const double Configor::Prior::LiDARDataAssociate::SurfelMapUpdateThreshold = 0.01;
+const double Configor::Prior::LiDARDataAssociate::SurfelMapRebuildRatio = 0.5;
+const std::size_t Configor::Prior::LiDARDataAssociate::PointToSurfelGroupSizeMax = 32;
 
 // the loss function used for radar factor (m/s) (on the direction of target)
 const double Configor::Prior::LossForRadarDopplerFactor = 0.1;
@@ -119,6 +144,7 @@ const double Configor::Prior::LossForPointToSurfelFactor = 0.02;
 const double Configor::Prior::LossForReprojFactor = 1.0;
 // the loss function used for visual optical flow factor (pixel) (on the image pixel plane)
 const double Configor::Prior::LossForOpticalFlowFactor = 30.0;
+const std::size_t Configor::Prior::VisualReprojFactorBudget = 100000;
 
 bool Configor::Prior::OptTemporalParams = {};
 
@@ -133,6 +159,97 @@ const std::map<CerealArchiveType::Enum, std::string> Configor::Preference::FileE
     {CerealArchiveType::Enum::XML, ".xml"},
     {CerealArchiveType::Enum::BINARY, ".bin"}};
 int Configor::Preference::ThreadsToUse = {};
+bool Configor::Preference::CacheCalibData = {};
+double Configor::Preference::TargetInfoPerSecond = {};
+const double Configor::Preference::ExcitationWindowLength = 1.0;
+const int Configor::Preference::LowExcitationIMUDecimation = 4;
+const double Configor::Preference::LiveMinInfoPerSecond = 0.2;
+const std::size_t Configor::Preference::LiveRingBufferCapacity = 4096;
+const double Configor::Preference::LiveReportInterval = 5.0;
+bool Configor::Preference::InProcessSfM = {};
+bool Configor::Preference::SaveCheckpoints = {};
+std::string Configor::Preference::ResumeFromStage = {};
+std::string Configor::Preference::WarmStartParamPath = {};
+std::string Configor::Preference::WarmStartSplinePath = {};
+int Configor::Preference::DiagnosticFrameStride = 1;
+bool Configor::Preference::AsyncLogging = {};
+const std::size_t Configor::Preference::AsyncLogQueueSize = 8192;
+const int Configor::Preference::WarmStartSampleStride = 10;
+const double Configor::Preference::WarmStartMaxGyroRMSE = 0.1;
+const double Configor::Preference::WarmStartMaxAcceRMSE = 0.5;
+std::string Configor::Preference::ViewerModeStr = "GUI";
+ViewerModeType Configor::Preference::ViewerMode = ViewerModeType::GUI;
+const bool Configor::Preference::ReleaseConsumedData = true;
+const std::uint64_t Configor::Preference::SamplingSeed = 0;
+const bool Configor::Preference::SpillReleasedImages = false;
+const bool Configor::Preference::ConcurrentInitPreparation = true;
+const bool Configor::Preference::ConcurrentDataAssociation = true;
+const NUMAModeType Configor::Preference::NUMAMode = NUMAModeType::NONE;
+const int Configor::Preference::ByProductOutputConcurrency = 4;
+const float Configor::Preference::MapExportVoxelSize = 0.0f;
+const double Configor::Preference::ViewerMaxFPS = 10.0;
+const std::size_t Configor::Preference::LODCloudMinPoints = 1000000;
+const std::size_t Configor::Preference::LODPointBudget = 5000000;
+const float Configor::Preference::LODScreenSpaceError = 2.0f;
+const std::size_t Configor::Preference::ViewerEntityCacheCapacity = 16;
+const int Configor::Preference::ParamDumpInterval = 1;
+const std::size_t Configor::Preference::ParamDumpBufferCapacity = 64;
+const bool Configor::Preference::LazyImageDecoding = false;
+const std::size_t Configor::Preference::LazyImageCacheCapacity = 256;
+const bool Configor::Preference::GreyOnlyImageStorage = true;
+const bool Configor::Preference::CompactSurfelMap = false;
+const std::size_t Configor::Preference::LandmarkPruneBudget = 10000;
+const int Configor::Preference::LandmarkPruneGridSize = 8;
+const double Configor::Preference::LandmarkPruneMaxReprojError = 2.0;
+const double Configor::Preference::LandmarkPruneMinTriangAngle = 1.0;
+const std::size_t Configor::Preference::DerivedFrameDataBudget = 1024;
+const bool Configor::Preference::FilterDepthImages = false;
+const bool Configor::Preference::BatchInertialFactors = true;
+const bool Configor::Preference::PreCorrectFrozenIMUIntri = true;
+const bool Configor::Preference::BatchRadarFactors = true;
+const bool Configor::Preference::FuseOpticalFlowFactors = true;
+const bool Configor::Preference::OpticalFlowTrifocalTensor = true;
+const bool Configor::Preference::BatchVisualReprojFactors = true;
+const bool Configor::Preference::ReuseBatchEstimator = true;
+const double Configor::Preference::DecomposedWindowLength = 0.0;
+const double Configor::Preference::DecomposedWindowOverlap = 2.0;
+const int Configor::Preference::ConsensusIterations = 5;
+const double Configor::Preference::ConsensusWeight = 10.0;
+const double Configor::Preference::IncrementalWindowLength = 0.0;
+const double Configor::Preference::IncrementalPriorForgetting = 0.9;
+const double Configor::Preference::IncrementalDriftSigma = 3.0;
+const double Configor::Preference::StageConvergenceRotThd = 0.01;
+const double Configor::Preference::StageConvergencePosThd = 0.001;
+const double Configor::Preference::StageConvergenceTimeThd = 1E-5;
+const bool Configor::Preference::EarlyStopBatchOptimization = true;
+const bool Configor::Preference::LinearSO3SplineInit = true;
+const int Configor::Preference::SO3SplinePolishIterations = 5;
+const bool Configor::Preference::LinearScaleSplineInit = true;
+const bool Configor::Preference::SchurSensorInertialAlign = true;
+const std::size_t Configor::Preference::MultiIMUInitGyroBudget = 5000;
+const std::size_t Configor::Preference::DenseSchurDimensionMax = 4096;
+const double Configor::Preference::UndistortionSampleInterval = 0.0;
+const bool Configor::Preference::UseOpenCLInTracking = false;
+const bool Configor::Preference::AdaptiveLKTracking = true;
+const int Configor::Preference::VOChunkFrameCount = 300;
+const int Configor::Preference::VOChunkOverlapFrames = 20;
+const std::size_t Configor::Preference::RotationStabilityCount = 3;
+const double Configor::Preference::RotationStabilityThd = 0.5;
+const bool Configor::Preference::RefineHandEyeRotation = false;
+const bool Configor::Preference::UseOpenCLInEventRendering = false;
+const double Configor::Preference::EventHotPixelLearnTime = 1.0;
+const double Configor::Preference::EventRefractoryPeriod = 1E-4;
+const double Configor::Preference::EventBAFTimeWindow = 0.01;
+const double Configor::Preference::EventNormFlowBinWidth = 1E-3;
+const bool Configor::Preference::MixedPrecisionResiduals = false;
+const bool Configor::Preference::ValidateMixedPrecision = false;
+const double Configor::Preference::MixedPrecisionTolerance = 1E-4;
+const double Configor::Preference::TemporalPaddingSigma = 6.0;
+const double Configor::Preference::TimeOffsetPaddingMin = 1E-3;
+const double Configor::Preference::ReadoutTimePaddingMin = 1E-4;
+const double Configor::Preference::CoarseTimeOffsetSampleRate = 200.0;
+const double Configor::Preference::CoarseTimeOffsetMinCorr = 0.7;
+const double Configor::Preference::CoarseTimeOffsetMargin = 0.02;
 const std::string Configor::Preference::SO3_SPLINE = "SO3_SPLINE";
 const std::string Configor::Preference::SCALE_SPLINE = "SCALE_SPLINE";
 double Configor::Preference::SplineScaleInViewer = {};
@@ -233,15 +350,97 @@ bool Configor::DataStream::IsEventCamera(const std::string &topic) {
     return EventTopics.count(topic) > 0;
 }
 
+std::vector<std::string> Configor::DataStream::GetBagPaths() { return ResolvePaths(BagPath); }
+
+std::vector<std::string> Configor::DataStream::GetLoaderPluginPaths() {
+    return ResolvePaths(LoaderPlugins);
+}
+
+std::vector<std::string> Configor::DataStream::ResolvePaths(const std::string &pathsStr) {
+    std::vector<std::string> paths;
+    std::stringstream stream(pathsStr);
+    std::string item;
+    while (std::getline(stream, item, ';')) {
+        // trim
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (item.empty()) {
+            continue;
+        }
+        if (item.find_first_of("*?[") == std::string::npos) {
+            paths.push_back(item);
+            continue;
+        }
+        // a glob pattern, matched paths are sorted
+        glob_t globResult{};
+        const int result = glob(item.c_str(), 0, nullptr, &globResult);
+        if (result == 0) {
+            for (std::size_t i = 0; i < globResult.gl_pathc; ++i) {
+                paths.emplace_back(globResult.gl_pathv[i]);
+            }
+        }
+        globfree(&globResult);
+        // a mistyped pattern should not drop its files silently
+        if (result != 0) {
+            throw Status(Status::ERROR, "the path pattern '{}' matches no file!", item);
+        }
+    }
+    return paths;
+}
+
 int Configor::Preference::AvailableThreads() {
     int hardwareConcurrency = static_cast<int>(std::thread::hardware_concurrency());
-    if (ThreadsToUse <= 0 || ThreadsToUse > hardwareConcurrency) {
-        return hardwareConcurrency;
-    } else {
-        return ThreadsToUse;
+    int threads = hardwareConcurrency;
+    if (ThreadsToUse > 0 && ThreadsToUse <= hardwareConcurrency) {
+        threads = ThreadsToUse;
+    }
+    /**
+     * in a parallel region, e.g., a stage of concurrent initialization preparations, its nested
+     * parallel regions share the thread budget assigned to it (by 'omp_set_num_threads')
+     */
+    if (omp_in_parallel()) {
+        threads = std::max(1, std::min(threads, omp_get_max_threads()));
+    }
+    return threads;
+}
+
+void Configor::Preference::ApplyThreadBudget() {
+    omp_set_dynamic(0);
+    omp_set_num_threads(AvailableThreads());
+    omp_set_max_active_levels(1);
+    // threads created afterwards inherit the memory policy of the main (loading) thread
+    if (NUMAMode == NUMAModeType::INTERLEAVE && NUMATopology::InterleaveMemory()) {
+        spdlog::info("memory is interleaved over '{}' numa nodes", NUMATopology::NodeCount());
     }
 }
 
+Configor::Preference::ThreadSplit::ThreadSplit(int tasks)
+    : _maxActiveLevels(omp_get_max_active_levels()) {
+    const int threads = AvailableThreads();
+    _workers = std::max(1, std::min(tasks, threads));
+    _threadsPerWorker = std::max(1, threads / _workers);
+    // the region of workers, and regions nested in workers are active
+    omp_set_max_active_levels(std::max(_maxActiveLevels, omp_get_active_level() + 2));
+}
+
+Configor::Preference::ThreadSplit::~ThreadSplit() {
+    // the level setting is shared by threads, splits in workers leave it to the outermost one
+    if (!omp_in_parallel()) {
+        omp_set_max_active_levels(_maxActiveLevels);
+    }
+}
+
+int Configor::Preference::ThreadSplit::Workers() const { return _workers; }
+
+int Configor::Preference::ThreadSplit::ThreadsPerWorker() const { return _threadsPerWorker; }
+
+NUMABinding Configor::Preference::ThreadSplit::EnterWorker() const {
+    omp_set_num_threads(_threadsPerWorker);
+    // workers of nested splits stay on the node of their outer worker
+    const bool bind = NUMAMode == NUMAModeType::NODE_LOCAL && omp_get_active_level() == 1;
+    return NUMABinding(bind ? omp_get_thread_num() : -1);
+}
+
 Configor::Configor() = default;
 
 void Configor::PrintMainFields() {
@@ -287,24 +486,36 @@ void Configor::PrintMainFields() {
             DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT
                 DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT
                     DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT
-                        DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT,
+                        DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT
+                            DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT
+                                DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT
+                                    DESC_FORMAT DESC_FORMAT DESC_FORMAT DESC_FORMAT,
         DESC_FIELD(IMUTopics), DESC_FIELD(RadarTopics), DESC_FIELD(LiDARTopics),
         DESC_FIELD(CameraTopics), DESC_FIELD(RGBDTopics), DESC_FIELD(EventTopics),
         DESC_FIELD(DataStream::ReferIMU), DESC_FIELD(DataStream::BagPath),
-        DESC_FIELD(DataStream::BeginTime), DESC_FIELD(DataStream::Duration),
-        DESC_FIELD(DataStream::OutputPath), DESC_FIELD(Prior::GravityNorm),
+        DESC_FIELD(DataStream::LoaderPlugins), DESC_FIELD(DataStream::BeginTime),
+        DESC_FIELD(DataStream::Duration), DESC_FIELD(DataStream::LiveMode),
+        DESC_FIELD(DataStream::LiveExcitedDuration), DESC_FIELD(DataStream::OutputPath),
+        DESC_FIELD(Prior::GravityNorm),
         DESC_FIELD(Prior::OptTemporalParams), DESC_FIELD(Prior::TimeOffsetPadding),
         DESC_FIELD(Prior::ReadoutTimePadding), DESC_FIELD(Prior::MapDownSample),
         DESC_FIELD(Prior::KnotTimeDist::SO3Spline), DESC_FIELD(Prior::KnotTimeDist::ScaleSpline),
         DESC_FIELD(Prior::NDTLiDAROdometer::Resolution),
         DESC_FIELD(Prior::NDTLiDAROdometer::KeyFrameDownSample),
+        DESC_FIELD(Prior::NDTLiDAROdometer::Registration),
         DESC_FIELD(Prior::LiDARDataAssociate::PointToSurfelMax),
         DESC_FIELD(Prior::LiDARDataAssociate::PlanarityMin),
         DESC_FIELD(Prior::LossForRadarDopplerFactor), DESC_FIELD(Prior::LossForPointToSurfelFactor),
         DESC_FIELD(Prior::LossForReprojFactor), DESC_FIELD(Prior::LossForOpticalFlowFactor),
         DESC_FIELD(Preference::UseCudaInSolving), "Preference::OutputDataFormat",
         Preference::OutputDataFormatStr, "Preference::Outputs", GetOptString(Preference::Outputs),
-        DESC_FIELD(Preference::ThreadsToUse));
+        DESC_FIELD(Preference::ThreadsToUse), DESC_FIELD(Preference::CacheCalibData),
+        DESC_FIELD(Preference::TargetInfoPerSecond), DESC_FIELD(Preference::InProcessSfM),
+        DESC_FIELD(Preference::SaveCheckpoints),
+        DESC_FIELD(Preference::ResumeFromStage), DESC_FIELD(Preference::WarmStartParamPath),
+        DESC_FIELD(Preference::WarmStartSplinePath), DESC_FIELD(Preference::DiagnosticFrameStride),
+        DESC_FIELD(Preference::AsyncLogging), "Preference::ViewerMode",
+        Preference::ViewerModeStr);
 
 #undef DESC_FIELD
 #undef DESC_FORMAT
@@ -436,8 +647,57 @@ void Configor::CheckConfigure() {
         throw Status(Status::ERROR, "the reference IMU is not set, it should be one of the IMUs!");
     }
 
-    if (!std::filesystem::exists(DataStream::BagPath)) {
-        throw Status(Status::ERROR, "can not find the ros bag (i.e., DataStream::BagPath)!");
+    // only radar, lidar, camera and event topics could be decimated at load time
+    for (const auto &[topic, config] : DataStream::TopicDecimation) {
+        if (!DataStream::IsRadar(topic) && !DataStream::IsLiDAR(topic) &&
+            !DataStream::IsCamera(topic) && !DataStream::IsEventCamera(topic)) {
+            throw Status(Status::ERROR,
+                         "the decimated topic '{}' is not a radar, lidar, camera or event topic!",
+                         topic);
+        }
+        if (config.Rate <= 0.0 && config.MinRotation <= 0.0) {
+            spdlog::warn("neither 'Rate' nor 'MinRotation' of decimated topic '{}' is positive!",
+                         topic);
+        }
+    }
+
+    if (DataStream::LiveMode) {
+        // the bag to record live messages into, which is created (overwritten) by the recorder
+        const auto &bagPath = DataStream::BagPath;
+        if (bagPath.empty() || bagPath.find_first_of("*?[;") != std::string::npos) {
+            throw Status(Status::ERROR,
+                         "a single bag path (i.e., DataStream::BagPath) without patterns is "
+                         "required to record live messages into in the live mode!");
+        }
+        const auto dir = std::filesystem::absolute(bagPath).parent_path();
+        if (!std::filesystem::exists(dir) && !std::filesystem::create_directories(dir)) {
+            throw Status(Status::ERROR, "the directory of the bag '{}' can not be created!",
+                         bagPath);
+        }
+    } else {
+        const auto bagPaths = DataStream::GetBagPaths();
+        if (bagPaths.empty()) {
+            throw Status(Status::ERROR, "can not find the ros bag (i.e., DataStream::BagPath)!");
+        }
+        for (const auto &bagPath : bagPaths) {
+            if (!std::filesystem::exists(bagPath)) {
+                throw Status(Status::ERROR,
+                             "can not find the ros bag '{}' (i.e., DataStream::BagPath)!", bagPath);
+            }
+            /**
+             * only ROS 1 bags are supported by the data loaders, MCAP (ROS 2) recordings should be
+             * converted first, otherwise 'rosbag' would fail with an obscure message
+             */
+            std::ifstream file(bagPath, std::ios::binary);
+            std::string magic(MCAP_MAGIC.size(), '\0');
+            file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+            if (file && magic == MCAP_MAGIC) {
+                throw Status(Status::ERROR,
+                             "the bag '{}' is an MCAP (ROS 2) recording, which is not supported "
+                             "currently, please convert it to a ROS 1 bag first!",
+                             bagPath);
+            }
+        }
     }
     if (DataStream::OutputPath.empty()) {
         throw Status(Status::ERROR, "the output path (i.e., DataStream::OutputPath) is empty!");
@@ -480,6 +740,24 @@ void Configor::CheckConfigure() {
                      "Prior::NDTLiDAROdometer::KeyFrameDownSample) should be positive!");
     }
 
+    if (!Preference::WarmStartSplinePath.empty() && Preference::WarmStartParamPath.empty()) {
+        throw Status(Status::ERROR,
+                     "the splines to warm-start from (i.e., Preference::WarmStartSplinePath) "
+                     "should be given with their parameters (i.e., "
+                     "Preference::WarmStartParamPath)!");
+    }
+    for (const auto &path : {Preference::WarmStartParamPath, Preference::WarmStartSplinePath}) {
+        if (!path.empty() && !std::filesystem::exists(path)) {
+            throw Status(Status::ERROR, "the file to warm-start from dose not exist: '{}'", path);
+        }
+    }
+
+    if (Preference::DiagnosticFrameStride < 1) {
+        throw Status(Status::ERROR,
+                     "the frame stride of visual diagnostics (i.e., "
+                     "Preference::DiagnosticFrameStride) should be larger equal than 1!");
+    }
+
     if (Preference::SplineScaleInViewer <= 0.0) {
         throw Status(Status::ERROR, "the scale of splines in visualization should be positive!");
     }
@@ -495,6 +773,22 @@ std::string Configor::GetFormatExtension() {
     return Preference::FileExtension.at(Preference::OutputDataFormat);
 }
 
+bool Configor::IsColumnarOutput() { return Preference::OutputDataFormatStr == "COLUMNAR"; }
+
+std::string Configor::GetColumnarExtension() { return ".ikc"; }
+
+bool Configor::IsColorImageRequired() {
+    if (!Preference::GreyOnlyImageStorage) {
+        return true;
+    }
+    // outputs rendering colorized images, maps, and landmarks
+    const auto &outputs = Preference::Outputs;
+    return IsOptionWith(OutputOption::VisualMaps, outputs) ||
+           IsOptionWith(OutputOption::VisualKinematics, outputs) ||
+           IsOptionWith(OutputOption::VisualLiDARCovisibility, outputs) ||
+           IsOptionWith(OutputOption::ColorizedLiDARMap, outputs);
+}
+
 bool Configor::LoadConfigure(const std::string &filename, CerealArchiveType::Enum archiveType) {
     // load configure info
     std::ifstream file(filename);
@@ -520,12 +814,32 @@ bool Configor::LoadConfigure(const std::string &filename, CerealArchiveType::Enu
 
     // perform internal data transformation
     try {
-        Configor::Preference::OutputDataFormat = EnumCast::stringToEnum<CerealArchiveType::Enum>(
-            Configor::Preference::OutputDataFormatStr);
+        Configor::Preference::OutputDataFormat =
+            IsColumnarOutput() ? CerealArchiveType::Enum::BINARY
+                               : EnumCast::stringToEnum<CerealArchiveType::Enum>(
+                                     Configor::Preference::OutputDataFormatStr);
     } catch (...) {
         throw Status(Status::CRITICAL, "unsupported data format '{}' for io!!!",
                      Configor::Preference::OutputDataFormatStr);
     }
+    try {
+        Configor::Preference::ViewerMode =
+            EnumCast::stringToEnum<ViewerModeType>(Configor::Preference::ViewerModeStr);
+    } catch (...) {
+        throw Status(Status::CRITICAL, "unsupported viewer mode '{}'!!!",
+                     Configor::Preference::ViewerModeStr);
+    }
+    try {
+        Configor::Prior::NDTLiDAROdometer::RegistrationType =
+            EnumCast::stringToEnum<ScanRegistrationType>(
+                Configor::Prior::NDTLiDAROdometer::Registration);
+    } catch (...) {
+        throw Status(Status::CRITICAL,
+                     "unsupported registration backend '{}' for lidar odometer!!!",
+                     Configor::Prior::NDTLiDAROdometer::Registration);
+    }
+    // the outputs are accumulated from the strings, reset them as the configure may be reloaded
+    Configor::Preference::Outputs = OutputOption::NONE;
     for (const auto &output : Preference::OutputsStr) {
         // when the enum is out of range of [MAGIC_ENUM_RANGE_MIN, MAGIC_ENUM_RANGE_MAX],
         // magic_enum would not work
@@ -543,6 +857,7 @@ bool Configor::LoadConfigure(const std::string &filename, CerealArchiveType::Enu
 
     // perform checking
     ns_ikalibr::Configor::CheckConfigure();
+    Configor::Preference::ApplyThreadBudget();
     return true;
 }
 
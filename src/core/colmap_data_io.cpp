@@ -33,6 +33,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "core/colmap_data_io.h"
+#include "util/status.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -301,6 +302,175 @@ std::map<ColMapDataIO::point3D_t, ColMapDataIO::Point3D> ColMapDataIO::ReadPoint
     return points3D_;
 }
 
+namespace {
+// the binary model of colmap is stored in little endian, which is the native one here
+template <typename T>
+T ReadBinary(std::istream &stream) {
+    T data;
+    stream.read(reinterpret_cast<char *>(&data), sizeof(T));
+    return data;
+}
+
+std::ifstream OpenBinary(const std::string &path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR, "can not open binary file '{}'!!!",
+                                 path);
+    }
+    return file;
+}
+
+void CheckBinary(const std::ifstream &file, const std::string &path) {
+    if (!file) {
+        throw ns_ikalibr::Status(ns_ikalibr::Status::ERROR, "binary file '{}' is broken!!!", path);
+    }
+}
+}  // namespace
+
+std::map<ColMapDataIO::camera_t, ColMapDataIO::Camera> ColMapDataIO::ReadCamerasBinary(
+    const std::string &path) {
+    std::map<camera_t, Camera> cameras_;
+
+    auto file = OpenBinary(path);
+
+    const auto num_cameras = ReadBinary<uint64_t>(file);
+    for (uint64_t i = 0; i < num_cameras; ++i) {
+        Camera camera;
+        camera.camera_id_ = ReadBinary<camera_t>(file);
+        camera.model_id_ = ReadBinary<int>(file);
+        camera.width_ = ReadBinary<uint64_t>(file);
+        camera.height_ = ReadBinary<uint64_t>(file);
+        camera.params_.resize(CameraModelParamsCount(camera.model_id_));
+        for (auto &param : camera.params_) {
+            param = ReadBinary<double>(file);
+        }
+        CheckBinary(file, path);
+
+        cameras_.emplace(camera.camera_id_, camera);
+    }
+    return cameras_;
+}
+
+std::map<ColMapDataIO::image_t, ColMapDataIO::Image> ColMapDataIO::ReadImagesBinary(
+    const std::string &path) {
+    std::map<image_t, Image> images_;
+    ForEachImageBinary(path, [&images_](const Image &image) {
+        images_.emplace(image.image_id_, image);
+    });
+    return images_;
+}
+
+std::map<ColMapDataIO::point3D_t, ColMapDataIO::Point3D> ColMapDataIO::ReadPoints3DBinary(
+    const std::string &path) {
+    std::map<point3D_t, Point3D> points3D_;
+    ForEachPoint3DBinary(path, [&points3D_](point3D_t point3D_id, const Point3D &point3D) {
+        points3D_.emplace(point3D_id, point3D);
+    });
+    return points3D_;
+}
+
+void ColMapDataIO::ForEachImageBinary(const std::string &path,
+                                      const std::function<void(const Image &)> &handler) {
+    auto file = OpenBinary(path);
+
+    // the image is reused to avoid reallocation of 2D points
+    Image image;
+    const auto num_reg_images = ReadBinary<uint64_t>(file);
+    for (uint64_t i = 0; i < num_reg_images; ++i) {
+        image.image_id_ = ReadBinary<image_t>(file);
+
+        // QVEC (qw, qx, qy, qz)
+        for (int j = 0; j < 4; ++j) {
+            image.qvec_(j) = ReadBinary<double>(file);
+        }
+        image.qvec_.normalize();
+
+        // TVEC
+        for (int j = 0; j < 3; ++j) {
+            image.tvec_(j) = ReadBinary<double>(file);
+        }
+
+        image.camera_id_ = ReadBinary<camera_t>(file);
+
+        // NAME, null-terminated
+        image.name_.clear();
+        char name_char;
+        while (file.get(name_char) && name_char != '\0') {
+            image.name_ += name_char;
+        }
+
+        // POINTS2D
+        const auto num_points2D = ReadBinary<uint64_t>(file);
+        image.points2D_.resize(num_points2D);
+        for (auto &point2D : image.points2D_) {
+            point2D.xy_(0) = ReadBinary<double>(file);
+            point2D.xy_(1) = ReadBinary<double>(file);
+            // '-1' (the invalid one) is stored as the max value of the unsigned type
+            point2D.point3D_id_ = ReadBinary<point3D_t>(file);
+        }
+        CheckBinary(file, path);
+
+        handler(image);
+    }
+}
+
+void ColMapDataIO::ForEachPoint3DBinary(
+    const std::string &path, const std::function<void(point3D_t, const Point3D &)> &handler) {
+    auto file = OpenBinary(path);
+
+    Point3D point3D;
+    const auto num_points3D = ReadBinary<uint64_t>(file);
+    for (uint64_t i = 0; i < num_points3D; ++i) {
+        const auto point3D_id = ReadBinary<point3D_t>(file);
+
+        // XYZ
+        for (int j = 0; j < 3; ++j) {
+            point3D.xyz_(j) = ReadBinary<double>(file);
+        }
+
+        // Color
+        for (int j = 0; j < 3; ++j) {
+            point3D.color_(j) = ReadBinary<uint8_t>(file);
+        }
+
+        // ERROR
+        point3D.error_ = ReadBinary<double>(file);
+
+        // TRACK
+        const auto track_length = ReadBinary<uint64_t>(file);
+        point3D.track_.resize(track_length);
+        for (auto &track_el : point3D.track_) {
+            track_el.image_id = ReadBinary<image_t>(file);
+            track_el.point2D_idx = ReadBinary<point2D_t>(file);
+        }
+        CheckBinary(file, path);
+
+        handler(point3D_id, point3D);
+    }
+}
+
+std::size_t ColMapDataIO::CameraModelParamsCount(int modelId) {
+    // the same as the 'CAMERA_MODEL_CASES' in colmap
+    static const std::map<int, std::size_t> PARAMS_COUNT = {
+        {0, 3},   // SIMPLE_PINHOLE
+        {1, 4},   // PINHOLE
+        {2, 4},   // SIMPLE_RADIAL
+        {3, 5},   // RADIAL
+        {4, 8},   // OPENCV
+        {5, 8},   // OPENCV_FISHEYE
+        {6, 12},  // FULL_OPENCV
+        {7, 5},   // FOV
+        {8, 4},   // SIMPLE_RADIAL_FISHEYE
+        {9, 5},   // RADIAL_FISHEYE
+        {10, 12}  // THIN_PRISM_FISHEYE
+    };
+    auto iter = PARAMS_COUNT.find(modelId);
+    if (iter == PARAMS_COUNT.cend()) {
+        throw Status(Status::ERROR, "unknown camera model id '{}' of colmap!!!", modelId);
+    }
+    return iter->second;
+}
+
 // -------------------------------
 // camera, image, point3d, point3d
 // -------------------------------
@@ -0,0 +1,208 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "core/event_denoiser.h"
+#include "sensor/event.h"
+#include "config/configor.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+std::size_t EventDenoiser::Report::RemovedCount() const {
+    return byHotPixel + byRefractory + byBackgroundActivity;
+}
+
+double EventDenoiser::Report::ReductionRatio() const {
+    return rawCount == 0 ? 0.0
+                         : static_cast<double>(RemovedCount()) / static_cast<double>(rawCount);
+}
+
+EventDenoiser::EventDenoiser(double hotPixelLearnTime,
+                             double refractoryPeriod,
+                             double bafTimeWindow)
+    : _hotPixelLearnTime(hotPixelLearnTime),
+      _refractoryPeriod(refractoryPeriod),
+      _bafTimeWindow(bafTimeWindow) {}
+
+EventDenoiser::Ptr EventDenoiser::Create(double hotPixelLearnTime,
+                                         double refractoryPeriod,
+                                         double bafTimeWindow) {
+    return std::make_shared<EventDenoiser>(hotPixelLearnTime, refractoryPeriod, bafTimeWindow);
+}
+
+EventDenoiser::Ptr EventDenoiser::CreateFromConfigor() {
+    return Create(Configor::Preference::EventHotPixelLearnTime,
+                  Configor::Preference::EventRefractoryPeriod,
+                  Configor::Preference::EventBAFTimeWindow);
+}
+
+EventDenoiser::Report EventDenoiser::Denoise(std::vector<EventArray::Ptr> &data) const {
+    Report report;
+    // the sensor size is obtained from events, as intrinsics are not available when loading data
+    int width = 0, height = 0;
+    for (const auto &ary : data) {
+        report.rawCount += ary->GetEventCount();
+        for (const auto &event : ary->GetPackedEvents()) {
+            width = std::max(width, static_cast<int>(event.x) + 1);
+            height = std::max(height, static_cast<int>(event.y) + 1);
+        }
+    }
+    if (report.rawCount == 0 ||
+        (_hotPixelLearnTime <= 0.0 && _refractoryPeriod <= 0.0 && _bafTimeWindow <= 0.0)) {
+        return report;
+    }
+    const std::vector<std::uint8_t> hotPixels =
+        LearnHotPixels(data, width, height, report.hotPixelCount);
+
+    // the timestamp of the last kept event at pixels, for the refractory-period filter
+    std::vector<double> lastKept(width * height, std::numeric_limits<double>::lowest());
+    // the timestamp of the last event in the 8-neighborhood of pixels, for the BAF (the BAF map
+    // is padded by one pixel, thus no boundary check is required when writing neighbors)
+    const int bafWidth = width + 2;
+    std::vector<double> lastNeighbor(bafWidth * (height + 2),
+                                     std::numeric_limits<double>::lowest());
+
+    std::vector<EventArray::Ptr> denoised;
+    denoised.reserve(data.size());
+    std::vector<std::uint8_t> keep;
+    for (const auto &ary : data) {
+        const auto &events = ary->GetPackedEvents();
+        const std::size_t count = events.size();
+        keep.assign(count, 1);
+        std::size_t keptCount = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const double t = ary->DecodeTime(events[i]);
+            const int x = events[i].x, y = events[i].y;
+            const int idx = y * width + x;
+            if (hotPixels[idx]) {
+                keep[i] = 0;
+                ++report.byHotPixel;
+                continue;
+            }
+            // every (non-hot) event supports its neighbors in BAF, whether it is kept or not
+            const int bafIdx = (y + 1) * bafWidth + (x + 1);
+            const double tNeighbor = lastNeighbor[bafIdx];
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if (dx != 0 || dy != 0) {
+                        lastNeighbor[bafIdx + dy * bafWidth + dx] = t;
+                    }
+                }
+            }
+            if (_refractoryPeriod > 0.0 && t - lastKept[idx] < _refractoryPeriod) {
+                keep[i] = 0;
+                ++report.byRefractory;
+                continue;
+            }
+            if (_bafTimeWindow > 0.0 && t - tNeighbor > _bafTimeWindow) {
+                keep[i] = 0;
+                ++report.byBackgroundActivity;
+                continue;
+            }
+            lastKept[idx] = t;
+            ++keptCount;
+        }
+        if (keptCount == count) {
+            denoised.push_back(ary);
+            continue;
+        } else if (keptCount == 0) {
+            continue;
+        }
+        // compact the packed events using the keep mask, the base time is kept as well
+        std::vector<EventArray::PackedEvent> newEvents(keptCount + 1);
+        for (std::size_t i = 0, j = 0; i < count; ++i) {
+            newEvents[j] = events[i];
+            // branchless compaction, the slot is overwritten if this event is not kept
+            j += keep[i];
+        }
+        // the extra slot absorbs the write of dropped trailing events
+        newEvents.pop_back();
+        denoised.push_back(
+            EventArray::Create(ary->GetTimestamp(), ary->GetTimeBase(), std::move(newEvents)));
+    }
+    data = std::move(denoised);
+    return report;
+}
+
+std::vector<std::uint8_t> EventDenoiser::LearnHotPixels(const std::vector<EventArray::Ptr> &data,
+                                                        int width,
+                                                        int height,
+                                                        std::size_t &hotPixelCount) const {
+    std::vector<std::uint8_t> hotPixels(width * height, 0);
+    hotPixelCount = 0;
+    if (_hotPixelLearnTime <= 0.0 || data.empty()) {
+        return hotPixels;
+    }
+    // event counts of pixels in the learning time
+    std::vector<int> counts(width * height, 0);
+    const double learnEndTime = data.front()->GetTimestamp() + _hotPixelLearnTime;
+    for (const auto &ary : data) {
+        if (ary->GetTimestamp() > learnEndTime) {
+            break;
+        }
+        for (const auto &event : ary->GetPackedEvents()) {
+            ++counts[event.y * width + event.x];
+        }
+    }
+    // statistics of active pixels, hot pixels are the outliers beyond 'mean + 5 * std'
+    constexpr double HOT_PIXEL_SIGMA = 5.0;
+    constexpr int HOT_PIXEL_MIN_COUNT = 10;
+    double sum = 0.0, sumSq = 0.0;
+    std::size_t active = 0;
+    for (int c : counts) {
+        if (c > 0) {
+            sum += c;
+            sumSq += static_cast<double>(c) * c;
+            ++active;
+        }
+    }
+    if (active == 0) {
+        return hotPixels;
+    }
+    const double mean = sum / static_cast<double>(active);
+    const double variance = sumSq / static_cast<double>(active) - mean * mean;
+    const double stdDev = std::sqrt(std::max(0.0, variance));
+    const double countThd = std::max<double>(HOT_PIXEL_MIN_COUNT, mean + HOT_PIXEL_SIGMA * stdDev);
+    for (int i = 0; i < width * height; ++i) {
+        if (counts[i] > countThd) {
+            hotPixels[i] = 1;
+            ++hotPixelCount;
+        }
+    }
+    return hotPixels;
+}
+}  // namespace ns_ikalibr
@@ -53,7 +53,13 @@ ActiveEventSurface::ActiveEventSurface(const ns_veta::PinholeIntrinsic::Ptr &int
     : FILTER_THD(filterThd),
       _intri(intri),
       _undistoMap(VisualUndistortionMap::Create(_intri)),
-      _eventImgMat(cv::Size(_intri->imgWidth, _intri->imgHeight), CV_8UC3, cv::Scalar(0, 0, 0)) {
+      _eventImgMat(cv::Size(_intri->imgWidth, _intri->imgHeight), CV_8UC3, cv::Scalar(0, 0, 0)),
+      _tileCols(static_cast<int>(_intri->imgWidth + TILE_SIZE - 1) / TILE_SIZE),
+      _tileRows(static_cast<int>(_intri->imgHeight + TILE_SIZE - 1) / TILE_SIZE),
+      _dirtyTiles(_tileCols * _tileRows, 0),
+      _anyDirty(false),
+      _stampMat(cv::Mat::zeros(cv::Size(_intri->imgWidth, _intri->imgHeight), CV_64FC1)),
+      _polarityMat(cv::Mat::zeros(cv::Size(_intri->imgWidth, _intri->imgHeight), CV_8UC1)) {
     _sae[0] = Eigen::MatrixXd::Zero(_intri->imgWidth, _intri->imgHeight);
     _sae[1] = Eigen::MatrixXd::Zero(_intri->imgWidth, _intri->imgHeight);
     _saeLatest[0] = Eigen::MatrixXd::Zero(_intri->imgWidth, _intri->imgHeight);
@@ -67,10 +73,15 @@ ActiveEventSurface::Ptr ActiveEventSurface::Create(const ns_veta::PinholeIntrins
 }
 
 void ActiveEventSurface::GrabEvent(const Event::Ptr &event, bool drawEventMat) {
-    const bool ep = event->GetPolarity();
-    const std::uint16_t ex = event->GetPos()(0), ey = event->GetPos()(1);
-    const double et = event->GetTimestamp();
+    GrabEvent(event->GetTimestamp(), event->GetPos()(0), event->GetPos()(1), event->GetPolarity(),
+              drawEventMat);
+}
 
+void ActiveEventSurface::GrabEvent(double et,
+                                   std::uint16_t ex,
+                                   std::uint16_t ey,
+                                   bool ep,
+                                   bool drawEventMat) {
     // update Surface of Active Events
     const int pol = ep ? 1 : 0;
     const int polInv = !ep ? 1 : 0;
@@ -80,6 +91,8 @@ void ActiveEventSurface::GrabEvent(const Event::Ptr &event, bool drawEventMat) {
     if ((et > tLast + FILTER_THD) || (tLastInv > tLast)) {
         tLast = et;
         _sae[pol](ex, ey) = et;
+        _dirtyTiles[(ey / TILE_SIZE) * _tileCols + ex / TILE_SIZE] = 1;
+        _anyDirty = true;
     } else {
         tLast = et;
     }
@@ -87,14 +100,25 @@ void ActiveEventSurface::GrabEvent(const Event::Ptr &event, bool drawEventMat) {
 
     if (drawEventMat) {
         // draw image
-        _eventImgMat.at<cv::Vec3b>(cv::Point2d(ex, ey)) =
-            ep ? cv::Vec3b(255, 0, 0) : cv::Vec3b(0, 0, 255);
+        _eventImgMat.ptr<cv::Vec3b>(ey)[ex] = ep ? cv::Vec3b(255, 0, 0) : cv::Vec3b(0, 0, 255);
     }
 }
 
 void ActiveEventSurface::GrabEvent(const EventArray::Ptr &events, bool drawEventMat) {
-    for (const auto &event : events->GetEvents()) {
-        GrabEvent(event, drawEventMat);
+    for (const auto &event : events->GetPackedEvents()) {
+        GrabEvent(events->DecodeTime(event), event.x, event.y, event.Polarity(), drawEventMat);
+    }
+}
+
+void ActiveEventSurface::GrabEvent(const EventArraySpan &events, bool drawEventMat) {
+    for (auto iter = events.ArraysBegin(); iter != events.ArraysEnd(); ++iter) {
+        const auto &ary = *iter;
+        const auto &packed = ary->GetPackedEvents();
+        const auto [sIdx, eIdx] = events.GetEventRange(iter);
+        for (std::size_t i = sIdx; i < eIdx; ++i) {
+            const auto &event = packed[i];
+            GrabEvent(ary->DecodeTime(event), event.x, event.y, event.Polarity(), drawEventMat);
+        }
     }
 }
 
@@ -111,35 +135,60 @@ cv::Mat ActiveEventSurface::GetEventImgMat(bool resetMat, bool undistoMat) {
     }
 }
 
+void ActiveEventSurface::RefreshSurfaces() {
+    if (!_anyDirty) {
+        return;
+    }
+    const int width = static_cast<int>(_intri->imgWidth);
+    const int height = static_cast<int>(_intri->imgHeight);
+    for (int ty = 0; ty < _tileRows; ++ty) {
+        for (int tx = 0; tx < _tileCols; ++tx) {
+            auto &dirty = _dirtyTiles[ty * _tileCols + tx];
+            if (!dirty) {
+                continue;
+            }
+            dirty = 0;
+            const int x0 = tx * TILE_SIZE;
+            const int n = std::min(TILE_SIZE, width - x0);
+            for (int y = ty * TILE_SIZE; y < std::min((ty + 1) * TILE_SIZE, height); ++y) {
+                // the sae is stored as a column-major (width x height) matrix, so that a column of
+                // it is a row of the image, which is contiguous
+                const auto sae0 = _sae[0].col(y).segment(x0, n).array();
+                const auto sae1 = _sae[1].col(y).segment(x0, n).array();
+                Eigen::Map<Eigen::ArrayXd>(_stampMat.ptr<double>(y) + x0, n) = sae0.max(sae1);
+                Eigen::Map<Eigen::Array<uchar, Eigen::Dynamic, 1>>(_polarityMat.ptr<uchar>(y) + x0,
+                                                                    n) =
+                    (sae1 > sae0).cast<uchar>();
+            }
+        }
+    }
+    _anyDirty = false;
+}
+
 cv::Mat ActiveEventSurface::TimeSurface(bool ignorePolarity,
                                         bool undistoMat,
                                         int medianBlurKernelSize,
                                         double decaySec) {
+    RefreshSurfaces();
     // create exponential-decayed Time Surface map
     const auto imgSize = cv::Size(_intri->imgWidth, _intri->imgHeight);
-    cv::Mat timeSurfaceMap = cv::Mat::zeros(imgSize, CV_64F);
+    cv::Mat timeSurfaceMap(imgSize, CV_64F);
 
-    for (int y = 0; y < imgSize.height; ++y) {
-        for (int x = 0; x < imgSize.width; ++x) {
-            const double mostRecentStampAtCoord = std::max(_sae[1](x, y), _sae[0](x, y));
-
-            const double dt = _timeLatest - mostRecentStampAtCoord;
-            double expVal = std::exp(-dt / decaySec);
-
-            if (!ignorePolarity) {
-                double polarity = _sae[1](x, y) > _sae[0](x, y) ? 1.0 : -1.0;
-                expVal *= polarity;
-            }
-            timeSurfaceMap.at<double>(y, x) = expVal;
-        }
-    }
+    // the exponentials are vectorized by eigen over the whole (continuous) map
+    const Eigen::Index size = imgSize.area();
+    Eigen::Map<const Eigen::ArrayXd> stamps(_stampMat.ptr<double>(), size);
+    Eigen::Map<Eigen::ArrayXd> expVal(timeSurfaceMap.ptr<double>(), size);
+    expVal = ((stamps - _timeLatest) / decaySec).exp();
 
     if (!ignorePolarity) {
-        timeSurfaceMap = 255.0 * (timeSurfaceMap + 1.0) / 2.0;
+        Eigen::Map<const Eigen::Array<uchar, Eigen::Dynamic, 1>> polarity(
+            _polarityMat.ptr<uchar>(), size);
+        expVal *= 2.0 * polarity.cast<double>() - 1.0;
+        // 255.0 * (timeSurfaceMap + 1.0) / 2.0
+        timeSurfaceMap.convertTo(timeSurfaceMap, CV_8U, 127.5, 127.5);
     } else {
-        timeSurfaceMap = 255.0 * timeSurfaceMap;
+        timeSurfaceMap.convertTo(timeSurfaceMap, CV_8U, 255.0);
     }
-    timeSurfaceMap.convertTo(timeSurfaceMap, CV_8U);
 
     if (medianBlurKernelSize > 0) {
         cv::medianBlur(timeSurfaceMap, timeSurfaceMap, 2 * medianBlurKernelSize + 1);
@@ -154,21 +203,16 @@ cv::Mat ActiveEventSurface::TimeSurface(bool ignorePolarity,
 
 std::pair<cv::Mat, cv::Mat> ActiveEventSurface::RawTimeSurface(bool ignorePolarity,
                                                                bool undistoMat) {
-    // create exponential-decayed Time Surface map
-    const auto imgSize = cv::Size(_intri->imgWidth, _intri->imgHeight);
-    cv::Mat timeSurfaceMap = cv::Mat::zeros(imgSize, CV_64FC1);
-    cv::Mat polarityMap = cv::Mat::zeros(imgSize, CV_8UC1);
-
-    for (int y = 0; y < imgSize.height; ++y) {
-        for (int x = 0; x < imgSize.width; ++x) {
-            double mostRecentStampAtCoord = std::max(_sae[1](x, y), _sae[0](x, y));
-            double polarity = _sae[1](x, y) > _sae[0](x, y) ? 1.0 : -1.0;
-            polarityMap.at<uchar>(y, x) = polarity;
-            if (!ignorePolarity) {
-                mostRecentStampAtCoord *= polarity;
-            }
-            timeSurfaceMap.at<double>(y, x) = mostRecentStampAtCoord;
-        }
+    RefreshSurfaces();
+    cv::Mat timeSurfaceMap = _stampMat.clone();
+    cv::Mat polarityMap = _polarityMat.clone();
+
+    if (!ignorePolarity) {
+        const Eigen::Index size = timeSurfaceMap.size().area();
+        Eigen::Map<Eigen::ArrayXd> stamps(timeSurfaceMap.ptr<double>(), size);
+        Eigen::Map<const Eigen::Array<uchar, Eigen::Dynamic, 1>> polarity(polarityMap.ptr<uchar>(),
+                                                                          size);
+        stamps *= 2.0 * polarity.cast<double>() - 1.0;
     }
     if (undistoMat) {
         return {_undistoMap->RemoveDistortion(timeSurfaceMap),
@@ -181,7 +225,7 @@ std::pair<cv::Mat, cv::Mat> ActiveEventSurface::RawTimeSurface(bool ignorePolari
 double ActiveEventSurface::GetTimeLatest() const { return _timeLatest; }
 
 EventArray::Ptr EventNormFlow::NormFlowPack::ActiveEvents(double dt) const {
-    std::list<Event::Ptr> events;
+    auto events = EventArray::Create();
     const int rows = rawTimeSurfaceMap.rows;
     const int cols = rawTimeSurfaceMap.cols;
     for (int ey = 0; ey < rows; ey++) {
@@ -192,19 +236,19 @@ EventArray::Ptr EventNormFlow::NormFlowPack::ActiveEvents(double dt) const {
                 continue;
             }
             const auto &ep = polarityMap.at<uchar>(ey, ex);
-            events.push_back(Event::Create(et, {ex, ey}, ep));
+            events->PushBack(et, ex, ey, ep);
         }
     }
-    if (events.size() > 0) {
-        std::vector<Event::Ptr> eventsVec(events.cbegin(), events.cend());
-        return EventArray::Create(eventsVec.back()->GetTimestamp(), eventsVec);
+    if (!events->IsEmpty()) {
+        events->SetTimestamp(events->GetEventTime(events->GetEventCount() - 1));
+        return events;
     } else {
         return nullptr;
     }
 }
 
 EventArray::Ptr EventNormFlow::NormFlowPack::NormFlowEvents() const {
-    std::list<Event::Ptr> events;
+    auto events = EventArray::Create();
     const int rows = rawTimeSurfaceMap.rows;
     const int cols = rawTimeSurfaceMap.cols;
     for (int ey = 0; ey < rows; ey++) {
@@ -218,12 +262,12 @@ EventArray::Ptr EventNormFlow::NormFlowPack::NormFlowEvents() const {
                 continue;
             }
             const auto &ep = polarityMap.at<uchar>(ey, ex);
-            events.push_back(Event::Create(et, {ex, ey}, ep));
+            events->PushBack(et, ex, ey, ep);
         }
     }
-    if (events.size() > 0) {
-        std::vector<Event::Ptr> eventsVec(events.cbegin(), events.cend());
-        return EventArray::Create(eventsVec.back()->GetTimestamp(), eventsVec);
+    if (!events->IsEmpty()) {
+        events->SetTimestamp(events->GetEventTime(events->GetEventCount() - 1));
+        return events;
     } else {
         return nullptr;
     }
@@ -234,17 +278,19 @@ cv::Mat EventNormFlow::NormFlowPack::Visualization(double dt) const {
     cv::hconcat(nfSeedsImg, nfsImg, m1);
 
     cv::Mat actEventMat(nfSeedsImg.size(), CV_8UC3, cv::Scalar(0, 0, 0));
-    for (const auto &event : this->ActiveEvents(dt)->GetEvents()) {
-        auto ex = event->GetPos()(0), ey = event->GetPos()(1);
-        auto ep = event->GetPolarity();
+    const auto actEvents = this->ActiveEvents(dt);
+    for (std::size_t i = 0; i < actEvents->GetEventCount(); ++i) {
+        auto ex = actEvents->GetEventX(i), ey = actEvents->GetEventY(i);
+        auto ep = actEvents->GetEventPolarity(i);
         actEventMat.at<cv::Vec3b>(cv::Point2d(ex, ey)) =
             ep ? cv::Vec3b(255, 0, 0) : cv::Vec3b(0, 0, 255);
     }
 
     cv::Mat nfEventMat(nfSeedsImg.size(), CV_8UC3, cv::Scalar(0, 0, 0));
-    for (const auto &event : this->NormFlowEvents()->GetEvents()) {
-        auto ex = event->GetPos()(0), ey = event->GetPos()(1);
-        auto ep = event->GetPolarity();
+    const auto nfEvents = this->NormFlowEvents();
+    for (std::size_t i = 0; i < nfEvents->GetEventCount(); ++i) {
+        auto ex = nfEvents->GetEventX(i), ey = nfEvents->GetEventY(i);
+        auto ep = nfEvents->GetEventPolarity(i);
         nfEventMat.at<cv::Vec3b>(cv::Point2d(ex, ey)) =
             ep ? cv::Vec3b(255, 0, 0) : cv::Vec3b(0, 0, 255);
     }
@@ -288,15 +334,19 @@ EventNormFlow::NormFlowPack EventNormFlow::ExtractNormFlows(double decaySec,
 #if OUTPUT_PLANE_FIT
     std::list<std::pair<Eigen::Vector3d, std::list<std::tuple<double, double, double>>>> drawData;
 #endif
+    /**
+     * pixels are selected greedily in the raster order, a pixel is skipped if any of its neighbors
+     * has been selected. The selection only depends on the mask (not on the plane fitting), thus
+     * it is performed sequentially first, and then planes of selected pixels are fitted in parallel
+     */
+    std::vector<Eigen::Vector2i> selected;
     for (int y = subTravSize; y < mask.rows - subTravSize; y++) {
         for (int x = subTravSize; x < mask.cols - subTravSize; x++) {
             if (mask.at<uchar>(y /*row*/, x /*col*/) != 255) {
                 continue;
             }
-            // for this window, obtain the values [x, y, timestamp]
-            std::vector<std::tuple<int, int, double>> inRangeData;
-            double timeCen = 0.0;
-            inRangeData.reserve(winSampleCount);
+            // for this window, count the valid values [x, y, timestamp]
+            int inRangeCount = 0;
             bool jumpCurPixel = false;
             for (int dy = -subTravSize; dy <= subTravSize; ++dy) {
                 for (int dx = -subTravSize; dx <= subTravSize; ++dx) {
@@ -319,14 +369,8 @@ EventNormFlow::NormFlowPack EventNormFlow::ExtractNormFlows(double decaySec,
                     }
 
                     // in window but not involved in norm flow estimation
-                    if (mask.at<uchar>(ny /*row*/, nx /*col*/) != 255) {
-                        continue;
-                    }
-
-                    double timestamp = rtsMat.at<double>(ny /*row*/, nx /*col*/);
-                    inRangeData.emplace_back(nx, ny, timestamp);
-                    if (nx == x && ny == y) {
-                        timeCen = timestamp;
+                    if (mask.at<uchar>(ny /*row*/, nx /*col*/) == 255) {
+                        ++inRangeCount;
                     }
                 }
                 if (jumpCurPixel) {
@@ -334,17 +378,62 @@ EventNormFlow::NormFlowPack EventNormFlow::ExtractNormFlows(double decaySec,
                 }
             }
             // data in this window is sufficient
-            if (jumpCurPixel || static_cast<int>(inRangeData.size()) < winSampleCountThd) {
+            if (jumpCurPixel || inRangeCount < winSampleCountThd) {
                 continue;
             }
-            /**
-             * drawing
-             */
-            tsImg.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 0, 255);  // selected but not verified
             occupy.at<uchar>(y /*row*/, x /*col*/) = 255;
+            selected.emplace_back(x, y);
+        }
+    }
+
+    struct PlaneFitResult {
+        bool success = false;
+        double timeCen = 0.0;
+        Eigen::Vector2d nf;
+        // pixels of inliers
+        std::vector<Eigen::Vector2i> inliers;
+#if OUTPUT_PLANE_FIT
+        Eigen::Vector3d abc;
+        std::list<std::tuple<double, double, double>> centeredInliers;
+#endif
+    };
+    const int selectedCount = static_cast<int>(selected.size());
+    std::vector<PlaneFitResult> results(selectedCount);
+
+#pragma omp parallel num_threads(Configor::Preference::AvailableThreads()) default(none)     \
+    shared(selectedCount, selected, results, mask, rtsMat, ws, winSampleCount, goodRatioThd, \
+               timeDistEventToPlaneThd, ransacMaxIter)
+    {
+        // scratch buffers owned by the thread, reused for all windows it fits
+        std::vector<std::tuple<int, int, double>> inRangeData;
+        std::vector<std::tuple<double, double, double>> centeredInRangeData;
+        inRangeData.reserve(winSampleCount);
+        centeredInRangeData.reserve(winSampleCount);
+
+#pragma omp for schedule(dynamic, 64)
+        for (int i = 0; i < selectedCount; ++i) {
+            const int x = selected.at(i)(0), y = selected.at(i)(1);
+            auto &result = results.at(i);
+            // for this window, obtain the values [x, y, timestamp]
+            inRangeData.clear();
+            for (int ny = y - ws; ny <= y + ws; ++ny) {
+                for (int nx = x - ws; nx <= x + ws; ++nx) {
+                    // in window but not involved in norm flow estimation
+                    if (mask.at<uchar>(ny /*row*/, nx /*col*/) != 255) {
+                        continue;
+                    }
+                    inRangeData.emplace_back(nx, ny, rtsMat.at<double>(ny /*row*/, nx /*col*/));
+                }
+            }
+            result.timeCen = rtsMat.at<double>(y /*row*/, x /*col*/);
+
+            Centralization(inRangeData, centeredInRangeData);
+            // neighborhoods that are far from planar are rejected before ransac
+            if (!IsRoughlyPlanar(centeredInRangeData, timeDistEventToPlaneThd, goodRatioThd)) {
+                continue;
+            }
 
             // try fit planes using ransac
-            auto centeredInRangeData = Centralization(inRangeData);
             opengv::sac::Ransac<EventLocalPlaneSacProblem> ransac;
             std::shared_ptr<EventLocalPlaneSacProblem> probPtr(
                 new EventLocalPlaneSacProblem(centeredInRangeData));
@@ -369,29 +458,49 @@ EventNormFlow::NormFlowPack EventNormFlow::ExtractNormFlows(double decaySec,
                 // the fitted plane is orthogonal to the t-axis, todo: a better way?
                 continue;
             }
-
-            nfs.push_back(NormFlow::Create(timeCen, Eigen::Vector2i{x, y}, nf));
-
+            result.success = true;
+            result.nf = nf;
+            result.inliers.reserve(ransac.inliers_.size());
             for (int idx : ransac.inliers_) {
                 const auto &[ex, ey, et] = inRangeData.at(idx);
-                inliersOccupy.at<uchar>(ey /*row*/, ex /*col*/) = 255;
+                result.inliers.emplace_back(ex, ey);
             }
-
-            /**
-             * drawing
-             */
-            tsImg.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 255, 0);  // selected and verified
-            DrawLineOnCVMat(tsImgNfs, Eigen::Vector2d{x, y} + 0.01 * nf, {x, y});
-
 #if OUTPUT_PLANE_FIT
-            std::list<std::tuple<double, double, double>> centeredInliers;
+            result.abc = abc;
             for (int idx : ransac.inliers_) {
-                centeredInliers.push_back(centeredInRangeData.at(idx));
+                result.centeredInliers.push_back(centeredInRangeData.at(idx));
             }
-            drawData.push_back({abc, centeredInliers});
 #endif
         }
     }
+
+    // results are merged in the raster order
+    for (int i = 0; i < selectedCount; ++i) {
+        const int x = selected.at(i)(0), y = selected.at(i)(1);
+        const auto &result = results.at(i);
+        /**
+         * drawing
+         */
+        if (!result.success) {
+            tsImg.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 0, 255);  // selected but not verified
+            continue;
+        }
+        nfs.push_back(NormFlow::Create(result.timeCen, Eigen::Vector2i{x, y}, result.nf));
+
+        for (const auto &pixel : result.inliers) {
+            inliersOccupy.at<uchar>(pixel(1) /*row*/, pixel(0) /*col*/) = 255;
+        }
+
+        /**
+         * drawing
+         */
+        tsImg.at<cv::Vec3b>(y, x) = cv::Vec3b(0, 255, 0);  // selected and verified
+        DrawLineOnCVMat(tsImgNfs, Eigen::Vector2d{x, y} + 0.01 * result.nf, {x, y});
+
+#if OUTPUT_PLANE_FIT
+        drawData.push_back({result.abc, result.centeredInliers});
+#endif
+    }
 #if OUTPUT_PLANE_FIT
     auto path = Configor::DataStream::DebugPath;
     static int count = 0;
@@ -417,6 +526,14 @@ EventNormFlow::NormFlowPack EventNormFlow::ExtractNormFlows(double decaySec,
 
 std::vector<std::tuple<double, double, double>> EventNormFlow::Centralization(
     const std::vector<std::tuple<int, int, double>> &inRangeData) {
+    std::vector<std::tuple<double, double, double>> centeredInRangeData;
+    Centralization(inRangeData, centeredInRangeData);
+    return centeredInRangeData;
+}
+
+void EventNormFlow::Centralization(
+    const std::vector<std::tuple<int, int, double>> &inRangeData,
+    std::vector<std::tuple<double, double, double>> &centeredInRangeData) {
     double mean1 = 0.0, mean2 = 0.0, mean3 = 0.0;
 
     for (const auto &t : inRangeData) {
@@ -430,7 +547,7 @@ std::vector<std::tuple<double, double, double>> EventNormFlow::Centralization(
     mean2 /= n;
     mean3 /= n;
 
-    std::vector<std::tuple<double, double, double>> centeredInRangeData;
+    // the output buffer is reused, no allocation happens if its capacity is sufficient
     centeredInRangeData.resize(inRangeData.size());
 
     for (size_t i = 0; i < inRangeData.size(); ++i) {
@@ -438,8 +555,43 @@ std::vector<std::tuple<double, double, double>> EventNormFlow::Centralization(
                                                  std::get<1>(inRangeData[i]) - mean2,
                                                  std::get<2>(inRangeData[i]) - mean3);
     }
+}
 
-    return centeredInRangeData;
+bool EventNormFlow::IsRoughlyPlanar(
+    const std::vector<std::tuple<double, double, double>> &centeredData,
+    double timeDistEventToPlaneThd,
+    double goodRatioThd) {
+    /**
+     * the closed-form least-squares plane 't = -(A * x + B * y)' of the centered data, the criteria
+     * are relaxed compared to the ransac ones, as the least-squares plane is not robust to outliers
+     */
+    constexpr double DIST_THD_RELAX = 3.0;
+    constexpr double RATIO_THD_RELAX = 0.5;
+    double sxx = 0.0, sxy = 0.0, syy = 0.0, sxt = 0.0, syt = 0.0;
+    for (const auto &[x, y, t] : centeredData) {
+        sxx += x * x;
+        sxy += x * y;
+        syy += y * y;
+        sxt += x * t;
+        syt += y * t;
+    }
+    const double det = sxx * syy - sxy * sxy;
+    if (std::abs(det) < 1E-9) {
+        // degenerated spatial distribution, leave it to the ransac
+        return true;
+    }
+    const double A = -(syy * sxt - sxy * syt) / det;
+    const double B = -(sxx * syt - sxy * sxt) / det;
+
+    const double distThd = DIST_THD_RELAX * timeDistEventToPlaneThd;
+    std::size_t goodCount = 0;
+    for (const auto &[x, y, t] : centeredData) {
+        if (EventLocalPlaneSacProblem::PointToPlaneDistance(x, y, t, A, B, 0.0) < distThd) {
+            ++goodCount;
+        }
+    }
+    return static_cast<double>(goodCount) >=
+           RATIO_THD_RELAX * goodRatioThd * static_cast<double>(centeredData.size());
 }
 
 /**
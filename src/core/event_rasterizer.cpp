@@ -0,0 +1,204 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "core/event_rasterizer.h"
+#include "sensor/event.h"
+#include "config/configor.h"
+#include "veta/camera/pinhole.h"
+#include "opencv2/core/ocl.hpp"
+#include "spdlog/spdlog.h"
+#include "cstring"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+/**
+ * EventRaster
+ */
+cv::Mat EventRaster::TimeSurface(double decaySec) const {
+    cv::Mat timeSurfaceMap = cv::Mat::zeros(latestMat.size(), CV_32FC1);
+    double minTime, maxTime;
+    cv::minMaxLoc(latestMat, &minTime, &maxTime, nullptr, nullptr, countMat > 0);
+    // exp(-(t_latest - t) / decay) for pixels with events, zeros for others
+    cv::exp((latestMat - maxTime) / decaySec, timeSurfaceMap);
+    timeSurfaceMap.setTo(0.0f, countMat == 0);
+    timeSurfaceMap.convertTo(timeSurfaceMap, CV_8U, 255.0);
+    return timeSurfaceMap;
+}
+
+cv::Mat EventRaster::EventFrame() const {
+    cv::Mat eventFrame(countMat.size(), CV_8UC3, cv::Scalar(255, 255, 255));
+    // red for positive events, and blue for negative ones
+    eventFrame.setTo(cv::Scalar(255, 0, 0), countMat > 0);
+    eventFrame.setTo(cv::Scalar(0, 0, 255), latestPolarityMat > 0);
+    return eventFrame;
+}
+
+/**
+ * EventRasterizer
+ */
+EventRasterizer::EventRasterizer(int width, int height)
+    : _width(width),
+      _height(height),
+      _useOpenCL(Configor::Preference::UseOpenCLInEventRendering && cv::ocl::haveOpenCL()) {
+    if (Configor::Preference::UseOpenCLInEventRendering && !_useOpenCL) {
+        spdlog::warn("no OpenCL device is available, rasterize events on the cpu instead!");
+    }
+}
+
+EventRasterizer::Ptr EventRasterizer::Create(int width, int height) {
+    return std::make_shared<EventRasterizer>(width, height);
+}
+
+EventRasterizer::Ptr EventRasterizer::Create(const ns_veta::PinholeIntrinsicPtr &intri) {
+    return Create(static_cast<int>(intri->imgWidth), static_cast<int>(intri->imgHeight));
+}
+
+EventRaster EventRasterizer::Rasterize(const EventArraySpan &span) const {
+    EventRaster raster;
+    raster.refTime = 0.0;
+    for (auto iter = span.ArraysBegin(); iter != span.ArraysEnd(); ++iter) {
+        const auto [sIdx, eIdx] = span.GetEventRange(iter);
+        if (sIdx < eIdx) {
+            raster.refTime = (*iter)->GetEventTime(sIdx);
+            break;
+        }
+    }
+    if (!_useOpenCL || !RasterizeOnOpenCL(span, raster)) {
+        RasterizeOnCPU(span, raster);
+    }
+    return raster;
+}
+
+void EventRasterizer::RasterizeOnCPU(const EventArraySpan &span, EventRaster &raster) const {
+    raster.countMat = cv::Mat::zeros(_height, _width, CV_32SC1);
+    raster.polarityMat = cv::Mat::zeros(_height, _width, CV_32SC1);
+    cv::Mat packed = cv::Mat::zeros(_height, _width, CV_32SC1);
+    auto *count = raster.countMat.ptr<int>();
+    auto *polarity = raster.polarityMat.ptr<int>();
+    auto *latest = packed.ptr<int>();
+    span.ForEachEvent([&](const EventArray::Ptr &ary, std::size_t i) {
+        const auto &event = ary->GetPackedEvents()[i];
+        const int idx = event.y * _width + event.x;
+        const bool p = event.Polarity();
+        ++count[idx];
+        polarity[idx] += p ? 1 : -1;
+        const int bits =
+            PackTimePolarity(static_cast<float>(ary->DecodeTime(event) - raster.refTime), p);
+        latest[idx] = std::max(latest[idx], bits);
+    });
+    UnpackTimePolarity(packed, raster);
+}
+
+bool EventRasterizer::RasterizeOnOpenCL(const EventArraySpan &span, EventRaster &raster) const {
+    static const char *KERNEL_SOURCE = R"(
+__kernel void bin_events(__global const int *packed, __global const ushort *xs,
+                         __global const ushort *ys, int n, int width, __global int *count,
+                         __global int *polarity, __global int *latest) {
+    int i = get_global_id(0);
+    if (i >= n) {
+        return;
+    }
+    int idx = ys[i] * width + xs[i];
+    atomic_inc(count + idx);
+    atomic_add(polarity + idx, (packed[i] & 1) ? 1 : -1);
+    atomic_max(latest + idx, packed[i]);
+}
+)";
+    const int n = static_cast<int>(span.GetEventCount());
+    if (n == 0) {
+        return false;
+    }
+    // the events of the span are packed into contiguous host buffers, and uploaded once
+    cv::Mat packedEvents(1, n, CV_32SC1), xs(1, n, CV_16UC1), ys(1, n, CV_16UC1);
+    int k = 0;
+    span.ForEachEvent([&](const EventArray::Ptr &ary, std::size_t i) {
+        const auto &event = ary->GetPackedEvents()[i];
+        packedEvents.at<int>(k) = PackTimePolarity(
+            static_cast<float>(ary->DecodeTime(event) - raster.refTime), event.Polarity());
+        xs.at<std::uint16_t>(k) = event.x;
+        ys.at<std::uint16_t>(k) = event.y;
+        ++k;
+    });
+
+    cv::ocl::ProgramSource source(KERNEL_SOURCE);
+    cv::ocl::Kernel kernel("bin_events", source);
+    if (kernel.empty()) {
+        spdlog::warn("build OpenCL kernel for event rasterization failed, use the cpu instead!");
+        return false;
+    }
+    cv::UMat packedEventsDev = packedEvents.getUMat(cv::ACCESS_READ);
+    cv::UMat xsDev = xs.getUMat(cv::ACCESS_READ), ysDev = ys.getUMat(cv::ACCESS_READ);
+    cv::UMat countDev = cv::UMat::zeros(_height, _width, CV_32SC1);
+    cv::UMat polarityDev = cv::UMat::zeros(_height, _width, CV_32SC1);
+    cv::UMat latestDev = cv::UMat::zeros(_height, _width, CV_32SC1);
+    kernel.args(cv::ocl::KernelArg::PtrReadOnly(packedEventsDev),
+                cv::ocl::KernelArg::PtrReadOnly(xsDev), cv::ocl::KernelArg::PtrReadOnly(ysDev), n,
+                _width, cv::ocl::KernelArg::PtrReadWrite(countDev),
+                cv::ocl::KernelArg::PtrReadWrite(polarityDev),
+                cv::ocl::KernelArg::PtrReadWrite(latestDev));
+    std::size_t globalSize = n;
+    if (!kernel.run(1, &globalSize, nullptr, true)) {
+        spdlog::warn("run OpenCL kernel for event rasterization failed, use the cpu instead!");
+        return false;
+    }
+    countDev.copyTo(raster.countMat);
+    polarityDev.copyTo(raster.polarityMat);
+    UnpackTimePolarity(latestDev.getMat(cv::ACCESS_READ), raster);
+    return true;
+}
+
+int EventRasterizer::PackTimePolarity(float time, bool polarity) {
+    int bits;
+    std::memcpy(&bits, &time, sizeof(bits));
+    return (bits & ~1) | (polarity ? 1 : 0);
+}
+
+void EventRasterizer::UnpackTimePolarity(const cv::Mat &packed, EventRaster &raster) {
+    raster.latestMat = cv::Mat(packed.size(), CV_32FC1);
+    raster.latestPolarityMat = cv::Mat(packed.size(), CV_8UC1);
+    for (int r = 0; r < packed.rows; ++r) {
+        const auto *bits = packed.ptr<int>(r);
+        auto *time = raster.latestMat.ptr<float>(r);
+        auto *polarity = raster.latestPolarityMat.ptr<uchar>(r);
+        for (int c = 0; c < packed.cols; ++c) {
+            const int timeBits = bits[c] & ~1;
+            std::memcpy(time + c, &timeBits, sizeof(timeBits));
+            polarity[c] = static_cast<uchar>(bits[c] & 1);
+        }
+    }
+}
+}  // namespace ns_ikalibr
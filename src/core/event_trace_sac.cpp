@@ -47,6 +47,25 @@ EventTrackingTraceSacProblem::EventTrackingTraceSacProblem(const FeatureVec& tra
 
 std::pair<FeatureTrackingCurve::Ptr, FeatureVec>
 EventTrackingTraceSacProblem::EventTrackingTraceSac(const FeatureVec& trackingAry, double thd) {
+    /**
+     * the closed-form quadratic fit of the whole track is tried first, if all positions are within
+     * the threshold, the track is accepted directly, which is the case for most good tracks, and
+     * ransac is only performed for tracks with outliers
+     */
+    if (auto trace = FeatureTrackingCurve::CreateFrom(trackingAry, true); trace != nullptr) {
+        bool allInliers = true;
+        for (const auto& track : trackingAry) {
+            std::optional<Eigen::Vector2d> pos = trace->PositionAt(track->timestamp);
+            if (pos == std::nullopt || (*pos - track->Undistorted().cast<double>()).norm() > thd) {
+                allInliers = false;
+                break;
+            }
+        }
+        if (allInliers) {
+            return {trace, trackingAry};
+        }
+    }
+
     opengv::sac::Ransac<EventTrackingTraceSacProblem> ransac;
     std::shared_ptr<EventTrackingTraceSacProblem> probPtr(
         new EventTrackingTraceSacProblem(trackingAry));
@@ -36,6 +36,9 @@
 #include "sensor/camera.h"
 #include "opencv2/imgproc.hpp"
 #include "opencv2/video/tracking.hpp"
+#include "opencv2/core/ocl.hpp"
+#include "config/configor.h"
+#include "spdlog/spdlog.h"
 
 namespace ns_ikalibr {
 
@@ -107,11 +110,16 @@ FeatureTracking::FeatureTracking(int featNumPerImg,
     : FEAT_NUM_PER_IMG(featNumPerImg),
       MIN_DIST(minDist),
       _intri(std::move(intri)),
+      _undistoLUT(nullptr),
       _imgLast(nullptr),
       _featLast() {}
 
 FeatureTracking::TrackedFeaturePack::Ptr FeatureTracking::GrabImageFrame(
     const CameraFrame::Ptr& imgCur, const std::optional<Sophus::SO3d>& SO3_Last2Cur) {
+    if (_intri != nullptr) {
+        // the intrinsics may be changed (optimized) between two grabbed images
+        _undistoLUT = VisualUndistortionLUT::Obtain(_intri);
+    }
     if (_imgLast == nullptr) {
         // for the first image, we just extract features and store them to '_featLast'
         std::vector<cv::Point2f> ptsCurVec;
@@ -270,7 +278,7 @@ void FeatureTracking::ComputeIndexVecOfPoints(const std::vector<cv::Point2f>& pt
 }
 
 cv::Point2f FeatureTracking::UndistortPoint(const cv::Point2f& p) const {
-    ns_veta::Vec2d up = _intri->GetUndistoPixel(ns_veta::Vec2d(p.x, p.y));
+    ns_veta::Vec2d up = _undistoLUT->RemoveDistortion(ns_veta::Vec2d(p.x, p.y));
     return {static_cast<float>(up(0)), static_cast<float>(up(1))};
 }
 
@@ -284,7 +292,7 @@ void FeatureTracking::ComputePriorPoints(const std::vector<cv::Point2f>& ptsLast
     ptsCur.clear();
     ptsCur.reserve(ptsLast.size());
     for (const auto& raw : ptsLast) {
-        Eigen::Vector2d pCam = _intri->RemoveDisto(_intri->ImgToCam({raw.x, raw.y}));
+        Eigen::Vector2d pCam = _intri->ImgToCam(_undistoLUT->RemoveDistortion({raw.x, raw.y}));
         Eigen::Vector3d pCamNew = SO3_Last2Cur * Eigen::Vector3d(pCam(0), pCam(1), 1.0);
         Eigen::Vector2d rawNew = _intri->CamToImg(_intri->AddDisto({pCamNew(0), pCamNew(1)}));
         ptsCur.emplace_back(rawNew(0), rawNew(1));
@@ -324,7 +332,15 @@ std::pair<cv::Mat, FeatureMap> FeatureTracking::MakeTrackedFeatUniform(
 LKFeatureTracking::LKFeatureTracking(int featNumPerImg,
                                      int minDist,
                                      const ns_veta::PinholeIntrinsic::Ptr& intri)
-    : FeatureTracking(featNumPerImg, minDist, intri) {}
+    : FeatureTracking(featNumPerImg, minDist, intri),
+      _useOpenCL(Configor::Preference::UseOpenCLInTracking && cv::ocl::haveOpenCL()) {
+    if (Configor::Preference::UseOpenCLInTracking && !_useOpenCL) {
+        spdlog::warn("no OpenCL device is available, track features on the cpu instead!");
+    }
+    if (_useOpenCL) {
+        cv::ocl::setUseOpenCL(true);
+    }
+}
 
 LKFeatureTracking::Ptr LKFeatureTracking::Create(int featNumPerImg,
                                                  int minDist,
@@ -339,7 +355,17 @@ void LKFeatureTracking::ExtractFeatures(const CameraFrame::Ptr& imgCur,
                                         FeatureIdVec& ptsCurIdVec,
                                         int& ptsIdCounter) {
     // the mask is empty for the first frame, do not use mask
-    cv::goodFeaturesToTrack(imgCur->GetImage(), ptsCurVec, featCountDesired, 0.01, MIN_DIST, mask);
+    if (_useOpenCL) {
+        // the current frame has been uploaded in tracking (if it is not the first frame)
+        if (_flowFrameLast.frame != imgCur) {
+            _flowFrameLast = BuildFlowFrame(imgCur);
+        }
+        cv::goodFeaturesToTrack(_flowFrameLast.image, ptsCurVec, featCountDesired, 0.01, MIN_DIST,
+                                mask);
+    } else {
+        cv::goodFeaturesToTrack(imgCur->GetImage(), ptsCurVec, featCountDesired, 0.01, MIN_DIST,
+                                mask);
+    }
     ComputeIndexVecOfPoints(ptsCurVec, ptsCurIdVec, ptsIdCounter);
 }
 
@@ -352,17 +378,143 @@ void LKFeatureTracking::GrabNextImageFrame(const CameraFrame::Ptr& imgLast,
                                            FeatureIdVec& ptsCurIdVec,
                                            std::vector<uchar>& status,
                                            int& ptsIdCounter) {
+    // features are tracked with their own lk parameters if they are predicted by the prior
+    std::map<std::pair<int, int>, std::vector<int>> groups;
     if (SO3_Last2Cur != std::nullopt) {
         ComputePriorPoints(ptsLastVec, *SO3_Last2Cur, ptsCurVec);
+        // without intrinsics, features are not predicted actually
+        if (Configor::Preference::AdaptiveLKTracking && _intri != nullptr) {
+            groups = GroupByPredictions(ptsLastVec, ptsCurVec);
+        }
     } else {
         ptsCurVec = ptsLastVec;
     }
+    // the last frame is built when it was the current one
+    if (_flowFrameLast.frame != imgLast) {
+        _flowFrameLast = BuildFlowFrame(imgLast);
+    }
+    FlowFrame flowFrameCur = BuildFlowFrame(imgCur);
+
+    // forward tracking
+    if (groups.empty()) {
+        CalcOpticalFlow(_flowFrameLast, flowFrameCur, ptsLastVec, ptsCurVec, status);
+    } else {
+        CalcOpticalFlowInGroups(_flowFrameLast, flowFrameCur, groups, ptsLastVec, ptsCurVec,
+                                status);
+    }
+
+    // backward tracking, features that can not be tracked back are rejected
+    std::vector<cv::Point2f> ptsBackVec = ptsLastVec;
+    std::vector<uchar> backStatus;
+    if (groups.empty()) {
+        CalcOpticalFlow(flowFrameCur, _flowFrameLast, ptsCurVec, ptsBackVec, backStatus);
+    } else {
+        // the forward error is also the one of the initial guesses in the backward tracking
+        CalcOpticalFlowInGroups(flowFrameCur, _flowFrameLast, groups, ptsCurVec, ptsBackVec,
+                                backStatus);
+    }
+    for (int i = 0; i < static_cast<int>(status.size()); ++i) {
+        if (status.at(i) &&
+            (!backStatus.at(i) || cv::norm(ptsBackVec.at(i) - ptsLastVec.at(i)) > FB_CHECK_THD)) {
+            status.at(i) = 0;
+        }
+    }
+    ComputeIndexVecOfPoints(ptsCurVec, ptsCurIdVec, ptsIdCounter);
+
+    _flowFrameLast = std::move(flowFrameCur);
+}
+
+LKFeatureTracking::FlowFrame LKFeatureTracking::BuildFlowFrame(
+    const CameraFrame::Ptr& frame) const {
+    FlowFrame flowFrame;
+    flowFrame.frame = frame;
+    if (_useOpenCL) {
+        frame->GetImage().copyTo(flowFrame.image);
+    } else {
+        const static std::string key = fmt::format("lk-pyramid-{}-{}", LK_WIN_SIZE, LK_MAX_LEVEL);
+        flowFrame.pyramid = frame->GetDerivedData<std::vector<cv::Mat>>(key, [&frame]() {
+            std::vector<cv::Mat> pyramid;
+            cv::buildOpticalFlowPyramid(frame->GetImage(), pyramid,
+                                        cv::Size(LK_WIN_SIZE, LK_WIN_SIZE), LK_MAX_LEVEL);
+            std::size_t bytes = 0;
+            for (const auto& mat : pyramid) {
+                bytes += mat.step[0] * mat.rows;
+            }
+            return std::make_pair(pyramid, bytes);
+        });
+    }
+    return flowFrame;
+}
+
+void LKFeatureTracking::CalcOpticalFlow(const FlowFrame& from,
+                                        const FlowFrame& to,
+                                        const std::vector<cv::Point2f>& ptsFromVec,
+                                        std::vector<cv::Point2f>& ptsToVec,
+                                        std::vector<uchar>& status,
+                                        int winSize,
+                                        int maxLevel) const {
     std::vector<float> errors;
     cv::TermCriteria termCrit =
         cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.01);
-    cv::calcOpticalFlowPyrLK(imgLast->GetImage(), imgCur->GetImage(), ptsLastVec, ptsCurVec, status,
-                             errors, cv::Size(21, 21), 5, termCrit, cv::OPTFLOW_USE_INITIAL_FLOW);
-    ComputeIndexVecOfPoints(ptsCurVec, ptsCurIdVec, ptsIdCounter);
+    if (_useOpenCL) {
+        cv::calcOpticalFlowPyrLK(from.image, to.image, ptsFromVec, ptsToVec, status, errors,
+                                 cv::Size(winSize, winSize), maxLevel, termCrit,
+                                 cv::OPTFLOW_USE_INITIAL_FLOW);
+    } else {
+        // the pre-built pyramids are used directly, whose borders also suit smaller windows
+        cv::calcOpticalFlowPyrLK(*from.pyramid, *to.pyramid, ptsFromVec, ptsToVec, status, errors,
+                                 cv::Size(winSize, winSize), maxLevel, termCrit,
+                                 cv::OPTFLOW_USE_INITIAL_FLOW);
+    }
+}
+
+std::map<std::pair<int, int>, std::vector<int>> LKFeatureTracking::GroupByPredictions(
+    const std::vector<cv::Point2f>& ptsLastVec, const std::vector<cv::Point2f>& ptsPredVec) {
+    std::map<std::pair<int, int>, std::vector<int>> groups;
+    for (int i = 0; i < static_cast<int>(ptsLastVec.size()); ++i) {
+        const auto disp = static_cast<float>(cv::norm(ptsPredVec.at(i) - ptsLastVec.at(i)));
+        const float radius = PRIOR_RADIUS_BASE + PRIOR_RADIUS_RATIO * disp;
+        // the window grows with the search radius
+        int winSize = LK_WIN_SIZE;
+        if (radius <= 8.0f) {
+            winSize = 11;
+        } else if (radius <= 16.0f) {
+            winSize = 15;
+        }
+        // the lowest level (at least one) whose search range (half window on it) covers the radius
+        int level = 1;
+        while (level < LK_MAX_LEVEL && static_cast<float>((winSize / 2) << level) < radius) {
+            ++level;
+        }
+        groups[{winSize, level}].push_back(i);
+    }
+    return groups;
+}
+
+void LKFeatureTracking::CalcOpticalFlowInGroups(
+    const FlowFrame& from,
+    const FlowFrame& to,
+    const std::map<std::pair<int, int>, std::vector<int>>& groups,
+    const std::vector<cv::Point2f>& ptsFromVec,
+    std::vector<cv::Point2f>& ptsToVec,
+    std::vector<uchar>& status) const {
+    status.assign(ptsFromVec.size(), 0);
+    std::vector<cv::Point2f> ptsFromGroup, ptsToGroup;
+    std::vector<uchar> statusGroup;
+    for (const auto& [param, indices] : groups) {
+        ptsFromGroup.resize(indices.size());
+        ptsToGroup.resize(indices.size());
+        for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
+            ptsFromGroup.at(i) = ptsFromVec.at(indices.at(i));
+            ptsToGroup.at(i) = ptsToVec.at(indices.at(i));
+        }
+        CalcOpticalFlow(from, to, ptsFromGroup, ptsToGroup, statusGroup, param.first,
+                        param.second);
+        for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
+            ptsToVec.at(indices.at(i)) = ptsToGroup.at(i);
+            status.at(indices.at(i)) = statusGroup.at(i);
+        }
+    }
 }
 
 /**
@@ -383,9 +535,10 @@ void DescriptorBasedFeatureTracking::ExtractFeatures(const CameraFrame::Ptr& img
                                                      std::vector<cv::Point2f>& ptsCurVec,
                                                      FeatureIdVec& ptsCurIdVec,
                                                      int& ptsIdCounter) {
-    std::vector<cv::KeyPoint> kpsCur;
-    cv::Mat descCur;
-    DetectAndComputeKeyPoints(imgCur->GetImage(), cv::Mat(), FEAT_NUM_PER_IMG, kpsCur, descCur);
+    // the key points have been detected in tracking (if it is not the first frame)
+    const auto keyPoints = ObtainKeyPoints(imgCur, FEAT_NUM_PER_IMG);
+    const auto& kpsCur = keyPoints->kps;
+    const auto& descCur = keyPoints->descriptor;
 
     ptsCurVec.clear();
     ptsCurVec.reserve(kpsCur.size());
@@ -422,9 +575,9 @@ void DescriptorBasedFeatureTracking::GrabNextImageFrame(
     }
 
     // obtain the key points of the last image
-    std::vector<cv::KeyPoint> kptCur;
-    cv::Mat descCur;
-    DetectAndComputeKeyPoints(imgCur->GetImage(), cv::Mat(), FEAT_NUM_PER_IMG, kptCur, descCur);
+    const auto keyPoints = ObtainKeyPoints(imgCur, FEAT_NUM_PER_IMG);
+    const auto& kptCur = keyPoints->kps;
+    const auto& descCur = keyPoints->descriptor;
 
     /**
      * todo: when prior relative rotation is valid, we use it to accelerate the feature matching
@@ -483,6 +636,18 @@ void DescriptorBasedFeatureTracking::GrabNextImageFrame(
     }
 }
 
+std::shared_ptr<const FrameKeyPoints> DescriptorBasedFeatureTracking::ObtainKeyPoints(
+    const CameraFrame::Ptr& frame, int featCountDesired) {
+    return frame->GetDerivedData<FrameKeyPoints>(KeyPointsKey(featCountDesired), [&]() {
+        FrameKeyPoints keyPoints;
+        DetectAndComputeKeyPoints(frame->GetImage(), cv::Mat(), featCountDesired, keyPoints.kps,
+                                  keyPoints.descriptor);
+        std::size_t bytes = keyPoints.kps.size() * sizeof(cv::KeyPoint) +
+                            keyPoints.descriptor.total() * keyPoints.descriptor.elemSize();
+        return std::make_pair(keyPoints, bytes);
+    });
+}
+
 /**
  * orb feature based feature tracking
  */
@@ -506,6 +671,10 @@ void ORBFeatureTracking::DetectAndComputeKeyPoints(const cv::Mat& img,
     cv::ORB::create(featCountDesired)->detectAndCompute(img, mask, kps, descriptor);
 }
 
+std::string ORBFeatureTracking::KeyPointsKey(int featCountDesired) const {
+    return fmt::format("orb-key-points-{}", featCountDesired);
+}
+
 /**
  * AKAZE feature based feature tracking
  */
@@ -531,4 +700,21 @@ void AKAZEFeatureTracking::DetectAndComputeKeyPoints(const cv::Mat& img,
     cv::AKAZE::create()->detectAndCompute(img, mask, kps, descriptor);
 }
 
+std::string AKAZEFeatureTracking::KeyPointsKey(int) const {
+    // the count of AKAZE key points is not limited
+    return "akaze-key-points";
+}
+
+std::shared_ptr<const FrameKeyPoints> AKAZEFeatureTracking::DetectKeyPoints(
+    const CameraFrame::Ptr& frame) {
+    return frame->GetDerivedData<FrameKeyPoints>("akaze-key-points", [&frame]() {
+        FrameKeyPoints keyPoints;
+        cv::AKAZE::create()->detectAndCompute(frame->GetImage(), cv::noArray(), keyPoints.kps,
+                                              keyPoints.descriptor);
+        std::size_t bytes = keyPoints.kps.size() * sizeof(cv::KeyPoint) +
+                            keyPoints.descriptor.total() * keyPoints.descriptor.elemSize();
+        return std::make_pair(keyPoints, bytes);
+    });
+}
+
 }  // namespace ns_ikalibr
\ No newline at end of file
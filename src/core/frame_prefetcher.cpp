@@ -0,0 +1,98 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "core/frame_prefetcher.h"
+#include "sensor/camera.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+FramePrefetcher::FramePrefetcher(std::vector<CameraFramePtr> frames, int depth)
+    : _frames(std::move(frames)),
+      _depth(std::max(depth, 1)),
+      _decoded(0),
+      _consumed(0),
+      _stop(false) {
+    _worker = std::thread(&FramePrefetcher::Decode, this);
+}
+
+FramePrefetcher::Ptr FramePrefetcher::Create(const std::vector<CameraFramePtr> &frames,
+                                             int depth) {
+    return std::make_shared<FramePrefetcher>(frames, depth);
+}
+
+CameraFramePtr FramePrefetcher::Acquire(int idx) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _consumed = std::max(_consumed, idx);
+    _cond.notify_all();
+    _cond.wait(lock, [this, idx] { return _decoded > idx; });
+    return _frames.at(idx);
+}
+
+FramePrefetcher::~FramePrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    _worker.join();
+}
+
+void FramePrefetcher::Decode() {
+    for (int i = 0; i < static_cast<int>(_frames.size()); ++i) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this, i] { return _stop || i < _consumed + _depth; });
+            if (_stop) {
+                break;
+            }
+        }
+        if (_frames.at(i)->IsLazy()) {
+            try {
+                _frames.at(i)->GetImage();
+            } catch (...) {
+                // the consumer decodes this frame again, where the error would be reported
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _decoded = i + 1;
+        }
+        _cond.notify_all();
+    }
+}
+}  // namespace ns_ikalibr
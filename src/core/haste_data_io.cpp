@@ -38,9 +38,10 @@
 #include "util/status.hpp"
 #include "config/configor.h"
 #include "filesystem"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "core/event_trace_sac.h"
 #include "core/feature_tracking.h"
+#include "cstring"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -93,22 +94,24 @@ std::pair<std::string, EventsInfo::SubBatch> HASTEDataIO::SaveRawEventDataAsText
     // event.txt
     const std::string &eventsPath = subWS + "/events.txt";
     std::ofstream ofEvents(eventsPath, std::ios::out);
-    std::stringstream buffer;
+    // events are formatted into a growing memory buffer, which is flushed in blocks
+    constexpr std::size_t FLUSH_SIZE = 1 << 24;
+    fmt::memory_buffer buffer;
     std::size_t eventCount = 0;
     for (auto iter = fromIter; iter != toIter; ++iter) {
-        const auto &events = (*iter)->GetEvents();
-        for (const auto &event : events) {
-            // todo: this is too too slow!!! modify haste to support binary data loading
-            buffer << fmt::format("{:.9f} {} {} {}\n",                    // time, x, y, polarity
-                                  event->GetTimestamp(),                  // time
-                                  event->GetPos()(0),                     // x
-                                  event->GetPos()(1),                     // y
-                                  static_cast<int>(event->GetPolarity())  // polarity
-            );
-            ++eventCount;
+        const auto &ary = *iter;
+        for (const auto &event : ary->GetPackedEvents()) {
+            // time, x, y, polarity
+            fmt::format_to(std::back_inserter(buffer), "{:.9f} {} {} {}\n", ary->DecodeTime(event),
+                           event.x, event.y, static_cast<int>(event.Polarity()));
+        }
+        eventCount += ary->GetEventCount();
+        if (buffer.size() > FLUSH_SIZE) {
+            ofEvents.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
         }
     }
-    ofEvents << buffer.str();
+    ofEvents.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
     ofEvents.close();
 
     // calib.txt
@@ -137,17 +140,17 @@ std::pair<std::string, EventsInfo::SubBatch> HASTEDataIO::SaveRawEventDataAsText
     // seeds.txt
     const std::string &seedsPath = subWS + "/seeds.txt";
     std::ofstream ofSeeds(seedsPath, std::ios::out);
-    buffer = std::stringstream();
+    buffer.clear();
     for (int id = 0; id != static_cast<int>(seeds.size()); ++id) {
         const Eigen::Vector2d &seed = intri->GetUndistoPixel(seeds.at(id));
-        // todo: this is too too slow!!! modify haste to support binary data loading
-        buffer << fmt::format("{:.9f},{:.3f},{:.3f},0.0,{}\n",  // t, x, y, theta, id
-                              seedsTime,                        // t
-                              seed(0), seed(1),                 // x, y
-                              id                                // id
+        fmt::format_to(std::back_inserter(buffer),
+                       "{:.9f},{:.3f},{:.3f},0.0,{}\n",  // t, x, y, theta, id
+                       seedsTime,                        // t
+                       seed(0), seed(1),                 // x, y
+                       id                                // id
         );
     }
-    ofSeeds << buffer.str();
+    ofSeeds.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
     ofSeeds.close();
 
     // command
@@ -182,23 +185,28 @@ std::pair<std::string, EventsInfo::SubBatch> HASTEDataIO::SaveRawEventDataAsBina
     // event.bin
     const std::string &eventsPath = subWS + "/events.bin";
     std::ofstream ofEvents(eventsPath, std::ios::binary);
+    // each event array is packed into a contiguous block and written by a single call
+    std::vector<char> buffer;
     std::size_t eventCount = 0;
     for (auto iter = fromIter; iter != toIter; ++iter) {
-        const auto &events = (*iter)->GetEvents();
-        for (const auto &event : events) {
+        const auto &ary = *iter;
+        buffer.resize(ary->GetEventCount() * EVENT_RECORD_SIZE);
+        char *record = buffer.data();
+        for (const auto &event : ary->GetPackedEvents()) {
             // time (float), x (uint16_t), y (uint16_t), polarity (boolean)
-            auto time = static_cast<float>(event->GetTimestamp());
-            std::uint16_t x = event->GetPos()(0);
-            std::uint16_t y = event->GetPos()(1);
-            bool polarity = event->GetPolarity();
-
-            ofEvents.write(reinterpret_cast<const char *>(&time), sizeof(time));
-            ofEvents.write(reinterpret_cast<const char *>(&x), sizeof(x));
-            ofEvents.write(reinterpret_cast<const char *>(&y), sizeof(y));
-            ofEvents.write(reinterpret_cast<const char *>(&polarity), sizeof(polarity));
-
-            ++eventCount;
+            auto time = static_cast<float>(ary->DecodeTime(event));
+            auto x = static_cast<std::uint16_t>(event.x);
+            auto y = static_cast<std::uint16_t>(event.y);
+            bool polarity = event.Polarity();
+
+            std::memcpy(record, &time, sizeof(time));
+            std::memcpy(record + 4, &x, sizeof(x));
+            std::memcpy(record + 6, &y, sizeof(y));
+            std::memcpy(record + 8, &polarity, sizeof(polarity));
+            record += EVENT_RECORD_SIZE;
         }
+        ofEvents.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        eventCount += ary->GetEventCount();
     }
     ofEvents.close();
 
@@ -238,6 +246,7 @@ std::pair<std::string, EventsInfo::SubBatch> HASTEDataIO::SaveRawEventDataAsBina
     // seeds.bin
     const std::string &seedsPath = subWS + "/seeds.bin";
     std::ofstream ofSeeds(seedsPath, std::ios::binary);
+    buffer.resize(seeds.size() * SEED_RECORD_SIZE);
     for (int i = 0; i != static_cast<int>(seeds.size()); ++i) {
         const Eigen::Vector2d &seed = intri->GetUndistoPixel(seeds.at(i));
         auto time = static_cast<float>(seedsTime);
@@ -247,12 +256,14 @@ std::pair<std::string, EventsInfo::SubBatch> HASTEDataIO::SaveRawEventDataAsBina
         std::uint64_t id = i;
 
         // t (float), x (float), y (float), theta (float), id (uint64_t)
-        ofSeeds.write(reinterpret_cast<const char *>(&time), sizeof(time));
-        ofSeeds.write(reinterpret_cast<const char *>(&x), sizeof(x));
-        ofSeeds.write(reinterpret_cast<const char *>(&y), sizeof(y));
-        ofSeeds.write(reinterpret_cast<const char *>(&theta), sizeof(theta));
-        ofSeeds.write(reinterpret_cast<const char *>(&id), sizeof(id));
+        char *record = buffer.data() + i * SEED_RECORD_SIZE;
+        std::memcpy(record, &time, sizeof(time));
+        std::memcpy(record + 4, &x, sizeof(x));
+        std::memcpy(record + 8, &y, sizeof(y));
+        std::memcpy(record + 12, &theta, sizeof(theta));
+        std::memcpy(record + 16, &id, sizeof(id));
     }
+    ofSeeds.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
     ofSeeds.close();
 
     // command
@@ -282,14 +293,15 @@ std::optional<HASTEDataIO::TrackingResultsType> HASTEDataIO::TryLoadHASTEResults
         spdlog::warn("there is no any batch in '{}'!!!", info.root_path);
         return {};
     }
-    std::shared_ptr<tqdm> bar = std::make_shared<tqdm>();
+    auto bar =
+        ProgressStage::Create("load tracking results", static_cast<long>(info.batches.size()));
     // batch index, feature id, tracking list
     TrackingResultsType trackResults;
     std::size_t trackedFeatCount = 0;
     double minTime = std::numeric_limits<double>::max();
     double maxTime = std::numeric_limits<double>::min();
     for (const auto &batch : info.batches) {
-        bar->progress(batch.index, static_cast<int>(info.batches.size()));
+        bar->Step();
 
         const std::string resultsPath =
             fmt::format("{}/{}/haste_results.txt", info.root_path, batch.index);
@@ -328,7 +340,7 @@ std::optional<HASTEDataIO::TrackingResultsType> HASTEDataIO::TryLoadHASTEResults
         }
         ifResults.close();
     }
-    bar->finish();
+    bar->Finish();
     spdlog::info(
         "load tracking results finished, batch count: {}, total tracked feature count: {}, time "
         "span from '{:.5f}' to '{:.5f}', time range: '{:.5f}'",
@@ -342,14 +354,15 @@ std::optional<HASTEDataIO::TrackingResultsType> HASTEDataIO::TryLoadHASTEResults
         spdlog::warn("there is no any batch in '{}'!!!", info.root_path);
         return {};
     }
-    std::shared_ptr<tqdm> bar = std::make_shared<tqdm>();
+    auto bar =
+        ProgressStage::Create("load tracking results", static_cast<long>(info.batches.size()));
     // batch index, feature id, tracking list
     TrackingResultsType trackResults;
     std::size_t trackedFeatCount = 0;
     double minTime = std::numeric_limits<double>::max();
     double maxTime = std::numeric_limits<double>::min();
     for (const auto &batch : info.batches) {
-        bar->progress(batch.index, static_cast<int>(info.batches.size()));
+        bar->Step();
 
         const std::string resultsPath =
             fmt::format("{}/{}/haste_results.bin", info.root_path, batch.index);
@@ -358,21 +371,30 @@ std::optional<HASTEDataIO::TrackingResultsType> HASTEDataIO::TryLoadHASTEResults
             continue;
         }
 
-        std::ifstream ifResults(resultsPath, std::ios::binary);
+        // the result file is loaded by a single read, and then decoded record by record
+        std::ifstream ifResults(resultsPath, std::ios::binary | std::ios::ate);
+        std::vector<char> buffer(static_cast<std::size_t>(ifResults.tellg()));
+        ifResults.seekg(0, std::ios::beg);
+        ifResults.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (buffer.size() % SEED_RECORD_SIZE != 0) {
+            spdlog::warn("the haste result file '{}' may broken!!!", resultsPath);
+        }
 
         float time;
         float x;
         float y;
-        float theta;
         std::uint64_t id;
 
         auto &tracking = trackResults[batch.index];
 
-        while (ifResults.read(reinterpret_cast<char *>(&time), sizeof(time))) {
-            ifResults.read(reinterpret_cast<char *>(&x), sizeof(x));
-            ifResults.read(reinterpret_cast<char *>(&y), sizeof(y));
-            ifResults.read(reinterpret_cast<char *>(&theta), sizeof(theta));
-            ifResults.read(reinterpret_cast<char *>(&id), sizeof(id));
+        const std::size_t recordCount = buffer.size() / SEED_RECORD_SIZE;
+        for (std::size_t i = 0; i < recordCount; ++i) {
+            // t (float), x (float), y (float), theta (float), id (uint64_t)
+            const char *record = buffer.data() + i * SEED_RECORD_SIZE;
+            std::memcpy(&time, record, sizeof(time));
+            std::memcpy(&x, record + 4, sizeof(x));
+            std::memcpy(&y, record + 8, sizeof(y));
+            std::memcpy(&id, record + 16, sizeof(id));
 
             Feature feature;
             feature.timestamp = time + info.raw_start_time - newRawStartTime;
@@ -393,7 +415,7 @@ std::optional<HASTEDataIO::TrackingResultsType> HASTEDataIO::TryLoadHASTEResults
         }
         ifResults.close();
     }
-    bar->finish();
+    bar->Finish();
     spdlog::info(
         "load tracking results finished, batch count: {}, total tracked feature count: {}, time "
         "span from '{:.5f}' to '{:.5f}', time range: '{:.5f}'",
@@ -434,10 +456,20 @@ void EventTrackingFilter::FilterByTrackingLength(FeatureVecMap &tracking,
 }
 
 void EventTrackingFilter::FilterByTraceFittingSAC(FeatureVecMap &tracking, double thd) {
-    for (auto it = tracking.begin(); it != tracking.end();) {
-        auto &trackingList = it->second;
+    std::vector<FeatureVecMap::iterator> tracks;
+    tracks.reserve(tracking.size());
+    for (auto it = tracking.begin(); it != tracking.end(); ++it) {
+        tracks.push_back(it);
+    }
+    const int trackCount = static_cast<int>(tracks.size());
+    // whether the track is accepted by the trace fitting
+    std::vector<std::uint8_t> accepted(trackCount, 0);
+    // tracks are fitted in parallel, each thread only modifies its own tracks
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(trackCount, tracks, accepted, thd)
+    for (int i = 0; i < trackCount; ++i) {
+        auto &trackingList = tracks.at(i)->second;
         if (trackingList.size() < 3) {
-            it = tracking.erase(it);
             continue;
         }
         auto res = EventTrackingTraceSacProblem::EventTrackingTraceSac(trackingList, thd);
@@ -447,9 +479,12 @@ void EventTrackingFilter::FilterByTraceFittingSAC(FeatureVecMap &tracking, doubl
                       [](const std::shared_ptr<Feature> &f1, const std::shared_ptr<Feature> &f2) {
                           return f1->timestamp < f2->timestamp;
                       });
-            ++it;
-        } else {
-            it = tracking.erase(it);
+            accepted.at(i) = 1;
+        }
+    }
+    for (int i = 0; i < trackCount; ++i) {
+        if (!accepted.at(i)) {
+            tracking.erase(tracks.at(i));
         }
     }
 }
@@ -499,4 +534,70 @@ void EventTrackingFilter::FilterByTrackingFreq(FeatureVecMap &tracking,
     }
 }
 
+void EventTrackingFilter::FilterTracking(FeatureVecMap &tracking,
+                                         double lenThdCompBest,
+                                         double sacThd,
+                                         double ageThdCompBest,
+                                         double freqThdCompBest) {
+    auto Age = [](const FeatureVec &trackingList) {
+        return trackingList.back()->timestamp - trackingList.front()->timestamp;
+    };
+    // length
+    std::size_t maxLength = 0;
+    for (const auto &[featId, trackingList] : tracking) {
+        maxLength = std::max(maxLength, trackingList.size());
+    }
+    const auto acceptedMinLength = static_cast<std::size_t>(static_cast<double>(maxLength) *
+                                                            lenThdCompBest);
+    // length and trace fitting, the max age of survivors is accumulated meanwhile
+    std::vector<FeatureVecMap::iterator> survivors;
+    survivors.reserve(tracking.size());
+    double maxAge = 0.0;
+    for (auto it = tracking.begin(); it != tracking.end(); ++it) {
+        auto &trackingList = it->second;
+        if (trackingList.size() < acceptedMinLength || trackingList.size() < 3) {
+            continue;
+        }
+        auto res = EventTrackingTraceSacProblem::EventTrackingTraceSac(trackingList, sacThd);
+        if (res.first == nullptr) {
+            continue;
+        }
+        trackingList = res.second;
+        std::sort(trackingList.begin(), trackingList.end(),
+                  [](const std::shared_ptr<Feature> &f1, const std::shared_ptr<Feature> &f2) {
+                      return f1->timestamp < f2->timestamp;
+                  });
+        maxAge = std::max(maxAge, Age(trackingList));
+        survivors.push_back(it);
+    }
+    // age, the max frequency of survivors is accumulated meanwhile
+    const double acceptedMinAge = maxAge * ageThdCompBest;
+    double maxFreq = 0.0;
+    std::size_t ageSurvivorCount = 0;
+    for (const auto &it : survivors) {
+        const double age = Age(it->second);
+        if (age < acceptedMinAge) {
+            continue;
+        }
+        maxFreq = std::max(maxFreq, static_cast<double>(it->second.size()) / age);
+        survivors.at(ageSurvivorCount++) = it;
+    }
+    survivors.resize(ageSurvivorCount);
+    // frequency
+    const double acceptedMinFreq = maxFreq * freqThdCompBest;
+    std::set<int> accepted;
+    for (const auto &it : survivors) {
+        if (static_cast<double>(it->second.size()) / Age(it->second) >= acceptedMinFreq) {
+            accepted.insert(it->first);
+        }
+    }
+    for (auto it = tracking.begin(); it != tracking.end();) {
+        if (accepted.count(it->first) == 0) {
+            it = tracking.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -34,6 +34,7 @@
 
 #include "core/lidar_odometer.h"
 #include "sensor/lidar.h"
+#include "util/point_buffer.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -41,24 +42,32 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
-LiDAROdometer::LiDAROdometer(float ndtResolution, int threads)
+LiDAROdometer::LiDAROdometer(float ndtResolution,
+                             int threads,
+                             std::size_t localMapKeyFrames,
+                             ScanRegistration::Ptr registration)
     : _ndtResolution(ndtResolution),
       _threads(threads),
+      _localMapKeyFrames(localMapKeyFrames),
+      _lastKeyFramePos(Eigen::Vector3d::Zero()),
+      _lastKeyFrameYPR(Eigen::Vector3d::Zero()),
       _map(nullptr),
       _mapTime(0.0),
-      _ndt(new pclomp::NormalDistributionsTransform<IKalibrPoint, IKalibrPoint>),
+      _localMap(nullptr),
+      _registration(std::move(registration)),
       _initialized(false) {
-    // init the ndt omp object
-    _ndt->setResolution(ndtResolution);
-    _ndt->setNumThreads(threads);
-    _ndt->setNeighborhoodSearchMethod(pclomp::DIRECT7);
-    _ndt->setTransformationEpsilon(1E-3);
-    _ndt->setStepSize(0.01);
-    _ndt->setMaximumIterations(50);
+    if (_registration == nullptr) {
+        _registration = ScanRegistration::Create(
+            Configor::Prior::NDTLiDAROdometer::RegistrationType, ndtResolution, threads);
+    }
 }
 
-LiDAROdometer::Ptr LiDAROdometer::Create(float ndtResolution, int threads) {
-    return std::make_shared<LiDAROdometer>(ndtResolution, threads);
+LiDAROdometer::Ptr LiDAROdometer::Create(float ndtResolution,
+                                         int threads,
+                                         std::size_t localMapKeyFrames,
+                                         const ScanRegistration::Ptr &registration) {
+    return std::make_shared<LiDAROdometer>(ndtResolution, threads, localMapKeyFrames,
+                                           registration);
 }
 
 ns_ctraj::Posed LiDAROdometer::FeedFrame(const LiDARFrame::Ptr &frame,
@@ -72,6 +81,8 @@ ns_ctraj::Posed LiDAROdometer::FeedFrame(const LiDARFrame::Ptr &frame,
         // create map
         _map = boost::make_shared<IKalibrPointCloud>();
         _mapTime = frame->GetTimestamp();
+        // the global map is the ndt target if the local map is not bounded
+        _localMap = _localMapKeyFrames == 0 ? _map : boost::make_shared<IKalibrPointCloud>();
 
         // here the pose id identity
         _initialized = true;
@@ -80,16 +91,14 @@ ns_ctraj::Posed LiDAROdometer::FeedFrame(const LiDARFrame::Ptr &frame,
         // down sample
         IKalibrPointCloud::Ptr filterCloud(new IKalibrPointCloud());
         DownSampleCloud(frame->GetScan(), filterCloud, 0.5);
-        _ndt->setInputSource(filterCloud);
 
         // organize the pred pose from cur frame to map
 
         Eigen::Matrix4d predCurLtoM = this->_poseSeq.back().se3().matrix() * predCurToLast;
-        IKalibrPointCloud::Ptr outputCloud(new IKalibrPointCloud());
-        _ndt->align(*outputCloud, predCurLtoM.cast<float>());
 
         // get pose
-        Eigen::Matrix4d pose = _ndt->getFinalTransformation().cast<double>();
+        Eigen::Matrix4d pose =
+            _registration->Align(filterCloud, frame->GetTimestamp(), predCurLtoM);
         curLtoM = ns_ctraj::Posed::FromT(pose, frame->GetTimestamp());
     }
 
@@ -105,15 +114,12 @@ ns_ctraj::Posed LiDAROdometer::FeedFrame(const LiDARFrame::Ptr &frame,
 }
 
 bool LiDAROdometer::CheckKeyFrame(const ns_ctraj::Posed &LtoM) {
-    static Eigen::Vector3d lastPos(0.0, 0.0, 0.0);
-    static Eigen::Vector3d lastYPR(0.0, 0.0, 0.0);
-
     Eigen::Vector3d curPos = LtoM.t;
-    double posDist = (curPos - lastPos).norm();
+    double posDist = (curPos - _lastKeyFramePos).norm();
 
     // get current rotMat, ypr
     Eigen::Vector3d curYPR = RotMatToYPR(LtoM.so3.matrix());
-    Eigen::Vector3d deltaAngle = curYPR - lastYPR;
+    Eigen::Vector3d deltaAngle = curYPR - _lastKeyFrameYPR;
     for (int i = 0; i < 3; i++) {
         deltaAngle(i) = NormalizeAngle(deltaAngle(i));
     }
@@ -122,33 +128,53 @@ bool LiDAROdometer::CheckKeyFrame(const ns_ctraj::Posed &LtoM) {
     if (_frames.empty() || posDist > 0.2 || deltaAngle(0) > 5.0 || deltaAngle(1) > 5.0 ||
         deltaAngle(2) > 5.0) {
         // update state
-        lastPos = curPos;
-        lastYPR = curYPR;
+        _lastKeyFramePos = curPos;
+        _lastKeyFrameYPR = curYPR;
         return true;
     }
     return false;
 }
 
 void LiDAROdometer::UpdateMap(const LiDARFrame::Ptr &frame, const ns_ctraj::Posed &LtoM) {
+    IKalibrPointCloud::Ptr keyFrameCloud(new IKalibrPointCloud);
     // update the first map frame using all points after this program is fine
     if (_frames.empty()) {
         // copy the frame point cloud to the map
-        *_map += *frame->GetScan();
+        *keyFrameCloud = *frame->GetScan();
     } else {
         // down sample
         IKalibrPointCloud::Ptr filteredCloud(new IKalibrPointCloud);
         DownSampleCloud(frame->GetScan(), filteredCloud, _ndtResolution);
 
         // transform
-        IKalibrPointCloud::Ptr transformCloud(new IKalibrPointCloud);
-        pcl::transformPointCloud(*filteredCloud, *transformCloud,
-                                 LtoM.se3().matrix().cast<float>());
+        keyFrameCloud = PointBuffer(*filteredCloud).Transform(LtoM.se3().cast<float>()).ToCloud();
+    }
+    *_map += *keyFrameCloud;
 
-        *_map += *transformCloud;
+    if (_localMapKeyFrames == 0) {
+        // the global map is the target, only voxels touched by the new key frame are updated
+        _registration->UpdateTarget(_map, *keyFrameCloud, IKalibrPointCloud());
+        return;
     }
 
-    // set the target point cloud
-    _ndt->setInputTarget(_map);
+    // slide the local map, the oldest key frames are removed from the target
+    _localMapFrames.push_back(keyFrameCloud);
+    IKalibrPointCloud removedCloud;
+    while (_localMapFrames.size() > _localMapKeyFrames) {
+        removedCloud += *_localMapFrames.front();
+        _localMapFrames.pop_front();
+    }
+    if (removedCloud.empty()) {
+        *_localMap += *keyFrameCloud;
+    } else {
+        _localMap = boost::make_shared<IKalibrPointCloud>();
+        for (const auto &cloud : _localMapFrames) {
+            *_localMap += *cloud;
+        }
+    }
+
+    // set the target point cloud, only voxels touched by inserted and removed points are updated
+    _registration->UpdateTarget(_localMap, *keyFrameCloud, removedCloud);
 }
 
 void LiDAROdometer::DownSampleCloud(const IKalibrPointCloud::Ptr &inCloud,
@@ -170,12 +196,11 @@ const std::vector<ns_ctraj::Posed> &LiDAROdometer::GetOdomPoseVec() const { retu
 
 const IKalibrPointCloud::Ptr &LiDAROdometer::GetMap() const { return _map; }
 
+const IKalibrPointCloud::Ptr &LiDAROdometer::GetLocalMap() const { return _localMap; }
+
 const std::vector<LiDARFrame::Ptr> &LiDAROdometer::GetFramesVec() const { return _frames; }
 
-const pclomp::NormalDistributionsTransform<IKalibrPoint, IKalibrPoint>::Ptr &LiDAROdometer::GetNdt()
-    const {
-    return _ndt;
-}
+const ScanRegistration::Ptr &LiDAROdometer::GetRegistration() const { return _registration; }
 
 double LiDAROdometer::GetMapTime() const { return _mapTime; }
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -84,9 +84,9 @@ OpticalFlowCorr::Ptr OpticalFlowTripleTrace::CreateOpticalFlowCorr(
     double rsExposureFactor, const RGBDIntrinsicsPtr& intri) const {
     auto corr = CreateOpticalFlowCorr(rsExposureFactor);
     if (auto rgbdFrame = std::dynamic_pointer_cast<RGBDFrame>(_trace.at(MID).first); rgbdFrame) {
-        if (auto depthMat = rgbdFrame->GetDepthImage(); !depthMat.empty()) {
+        if (!rgbdFrame->GetDepthImage().empty()) {
             const Eigen::Vector2d& midPoint = _trace.at(MID).second;
-            const auto rawDepth = depthMat.at<float>((int)midPoint(1), (int)midPoint(0));
+            const auto rawDepth = rgbdFrame->GetRawDepth((int)midPoint(1), (int)midPoint(0));
             if (intri != nullptr) {
                 corr->depth = intri->ActualDepth(rawDepth);
             }
@@ -154,6 +154,11 @@ cv::Mat OpticalFlowTripleTrace::GetInRangeSubMat(const cv::Mat& image,
     int x2 = std::min(image.cols, x + padding);
     int y2 = std::min(image.rows, y + padding);
 
+    // the patch is totally in the image, the roi view is returned, no pixel is copied
+    if (x2 - x1 == 2 * padding && y2 - y1 == 2 * padding) {
+        return image(cv::Rect(x1, y1, x2 - x1, y2 - y1));
+    }
+
     cv::Mat sub_image = image(cv::Rect(x1, y1, x2 - x1, y2 - y1));
 
     int dx = (2 * padding - (x2 - x1)) / 2;
@@ -34,6 +34,15 @@
 
 #include "core/pts_association.h"
 #include "factor/data_correspondence.h"
+#include "util/status.hpp"
+#include "util/progress.h"
+#include "omp.h"
+#include "atomic"
+#include "unordered_map"
+#include "chrono"
+#include "algorithm"
+#include "array"
+#include "Eigen/Eigenvalues"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -87,15 +96,281 @@ PointToSurfelCondition &PointToSurfelCondition::WithPlanarityMin(double val) {
 
 PointToSurfelAssociator::PointToSurfelAssociator(const IKalibrPointCloud::Ptr &mapInW,
                                                  double resolution,
-                                                 std::uint8_t depth) {
-    _smp = ufo::map::SurfelMap(resolution, depth);
-    InsertCloudToSurfelMap<IKalibrPoint>(_smp, *mapInW);
+                                                 std::uint8_t depth,
+                                                 bool compact)
+    : PointToSurfelAssociator(resolution, depth, compact) {
+    UpdateSurfelMap(nullptr, mapInW);
 }
 
 PointToSurfelAssociator::Ptr PointToSurfelAssociator::Create(const IKalibrPointCloud::Ptr &mapInW,
                                                              double resolution,
-                                                             std::uint8_t depth) {
-    return std::make_shared<PointToSurfelAssociator>(mapInW, resolution, depth);
+                                                             std::uint8_t depth,
+                                                             bool compact) {
+    return std::make_shared<PointToSurfelAssociator>(mapInW, resolution, depth, compact);
+}
+
+PointToSurfelAssociator::PointToSurfelAssociator(double resolution,
+                                                 std::uint8_t depth,
+                                                 bool compact)
+    : _compact(compact) {
+    _smp = ufo::map::SurfelMap(resolution, depth);
+}
+
+PointToSurfelAssociator::Ptr PointToSurfelAssociator::Create(double resolution,
+                                                             std::uint8_t depth,
+                                                             bool compact) {
+    return std::make_shared<PointToSurfelAssociator>(resolution, depth, compact);
+}
+
+void PointToSurfelAssociator::UpdateSurfelMap(const IKalibrPointCloud::Ptr &oldCloud,
+                                              const IKalibrPointCloud::Ptr &newCloud) {
+    // the map is changed, candidate surfels would be looked up again
+    _lookup.reset();
+    if (_compact) {
+        // leaf moments are keyed by nodes, thus points are not sorted
+        if (oldCloud != nullptr) {
+            UpdateLeafMoments(ValidUFOCloud(*oldCloud), true);
+        }
+        if (newCloud != nullptr) {
+            UpdateLeafMoments(ValidUFOCloud(*newCloud), false);
+        }
+        return;
+    }
+    if (oldCloud != nullptr) {
+        auto ufoCloud = ValidUFOCloud(*oldCloud, _smp.getNodeSize(0));
+        _smp.eraseSurfelPoint(std::begin(ufoCloud), std::end(ufoCloud));
+    }
+    if (newCloud != nullptr) {
+        auto ufoCloud = ValidUFOCloud(*newCloud, _smp.getNodeSize(0));
+        _smp.insertSurfelPoint(std::begin(ufoCloud), std::end(ufoCloud));
+    }
+}
+
+namespace {
+// spread the lower 21 bits of 'v' to every third bit, for 63-bit morton codes
+std::uint64_t SpreadBitsBy3(std::uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+// node indices are offset to be non-negative, 21 bits for each axis
+std::uint64_t PackNodeIndices(const std::array<std::int64_t, 3> &idx) {
+    auto Pack = [](std::int64_t v) { return static_cast<std::uint64_t>(v + (1 << 20)) & 0x1fffff; };
+    return Pack(idx[0]) | Pack(idx[1]) << 21 | Pack(idx[2]) << 42;
+}
+
+std::array<std::int64_t, 3> UnpackNodeIndices(std::uint64_t key) {
+    auto Unpack = [key](int shift) {
+        return static_cast<std::int64_t>((key >> shift) & 0x1fffff) - (1 << 20);
+    };
+    return {Unpack(0), Unpack(21), Unpack(42)};
+}
+
+// the upper triangle of the symmetrized outer product of 'a' and 'b': [xx, xy, xz, yy, yz, zz]
+Eigen::Matrix<double, 6, 1> OuterUpper(const Eigen::Vector3d &a, const Eigen::Vector3d &b) {
+    Eigen::Matrix<double, 6, 1> upper;
+    upper << a.x() * b.x(), 0.5 * (a.x() * b.y() + a.y() * b.x()),
+        0.5 * (a.x() * b.z() + a.z() * b.x()), a.y() * b.y(),
+        0.5 * (a.y() * b.z() + a.z() * b.y()), a.z() * b.z();
+    return upper;
+}
+}  // namespace
+
+// -------------
+// SurfelMoments
+// -------------
+
+void PointToSurfelAssociator::SurfelMoments::Add(const Eigen::Vector3d &p) {
+    ++count;
+    sum += p;
+    sumSquares += OuterUpper(p, p);
+}
+
+void PointToSurfelAssociator::SurfelMoments::Remove(const Eigen::Vector3d &p) {
+    if (count == 0) {
+        return;
+    }
+    --count;
+    sum -= p;
+    sumSquares -= OuterUpper(p, p);
+}
+
+void PointToSurfelAssociator::SurfelMoments::Merge(const SurfelMoments &child,
+                                                   const Eigen::Vector3d &offset) {
+    // sum((q + o) * (q + o)^T) = sum(q * q^T) + sum(q) * o^T + o * sum(q)^T + n * o * o^T
+    const auto n = static_cast<double>(child.count);
+    count += child.count;
+    sum += child.sum + n * offset;
+    sumSquares += child.sumSquares + 2.0 * OuterUpper(child.sum, offset) +
+                  n * OuterUpper(offset, offset);
+}
+
+std::optional<std::pair<double, Eigen::Vector4d>>
+PointToSurfelAssociator::SurfelMoments::Surfel(const Eigen::Vector3d &origin) const {
+    // at least three points are required to determine a plane
+    if (count < 3) {
+        return std::nullopt;
+    }
+    const auto n = static_cast<double>(count);
+    const Eigen::Vector3d mean = sum / n;
+    Eigen::Matrix3d scatter;
+    scatter << sumSquares(0), sumSquares(1), sumSquares(2), sumSquares(1), sumSquares(3),
+        sumSquares(4), sumSquares(2), sumSquares(4), sumSquares(5);
+    scatter -= n * mean * mean.transpose();
+
+    // eigen values are sorted in increasing order
+    const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(scatter);
+    const Eigen::Vector3d &e = solver.eigenvalues();
+    if (e.sum() <= 0.0) {
+        return std::nullopt;
+    }
+    const double planarity = 2.0 * (e(1) - e(0)) / e.sum();
+    const Eigen::Vector3d norm = solver.eigenvectors().col(0);
+    return std::make_pair(planarity, Eigen::Vector4d(norm.x(), norm.y(), norm.z(),
+                                                     -norm.dot(origin + mean)));
+}
+
+void PointToSurfelAssociator::UpdateLeafMoments(const ufo::map::PointCloud &cloud, bool erase) {
+    const double res = _smp.getNodeSize(0);
+    for (const auto &p : cloud) {
+        const std::array<std::int64_t, 3> idx{static_cast<std::int64_t>(std::floor(p.x / res)),
+                                              static_cast<std::int64_t>(std::floor(p.y / res)),
+                                              static_cast<std::int64_t>(std::floor(p.z / res))};
+        // the point relative to the min corner of its leaf
+        const Eigen::Vector3d q(p.x - idx[0] * res, p.y - idx[1] * res, p.z - idx[2] * res);
+        const auto key = PackNodeIndices(idx);
+        if (!erase) {
+            _leaves[key].Add(q);
+            continue;
+        }
+        auto iter = _leaves.find(key);
+        if (iter == _leaves.end()) {
+            continue;
+        }
+        iter->second.Remove(q);
+        if (iter->second.count == 0) {
+            _leaves.erase(iter);
+        }
+    }
+}
+
+void PointToSurfelAssociator::BuildCompactSurfelLookup(SurfelLookup &lookup) const {
+    const auto &condition = lookup.condition;
+    // moments of nodes in the current depth, which are aggregated level by level from leaves
+    std::unordered_map<std::uint64_t, SurfelMoments> level;
+    const std::unordered_map<std::uint64_t, SurfelMoments> *nodes = &_leaves;
+    for (int depth = 0; depth <= condition.queryDepthMax; ++depth) {
+        if (depth > 0) {
+            const double childSize = _smp.getNodeSize(depth - 1);
+            std::unordered_map<std::uint64_t, SurfelMoments> parents;
+            parents.reserve(nodes->size() / 4 + 1);
+            for (const auto &[key, moments] : *nodes) {
+                const auto idx = UnpackNodeIndices(key);
+                // arithmetic shifts, i.e., floor divisions for negative indices
+                const std::array<std::int64_t, 3> parentIdx{idx[0] >> 1, idx[1] >> 1,
+                                                            idx[2] >> 1};
+                const Eigen::Vector3d offset((idx[0] - 2 * parentIdx[0]) * childSize,
+                                             (idx[1] - 2 * parentIdx[1]) * childSize,
+                                             (idx[2] - 2 * parentIdx[2]) * childSize);
+                parents[PackNodeIndices(parentIdx)].Merge(moments, offset);
+            }
+            level = std::move(parents);
+            nodes = &level;
+        }
+        if (depth < condition.queryDepthMin) {
+            continue;
+        }
+
+        const double nodeSize = _smp.getNodeSize(depth);
+        for (const auto &[key, moments] : *nodes) {
+            if (moments.count < condition.surfelPointMin) {
+                continue;
+            }
+            const auto idx = UnpackNodeIndices(key);
+            const Eigen::Vector3d min(idx[0] * nodeSize, idx[1] * nodeSize, idx[2] * nodeSize);
+            const auto surfel = moments.Surfel(min);
+            if (surfel == std::nullopt || surfel->first < condition.planarityMin) {
+                continue;
+            }
+            const Eigen::Vector3d max = min + Eigen::Vector3d::Constant(nodeSize);
+            const Eigen::Vector3d center = min + Eigen::Vector3d::Constant(0.5 * nodeSize);
+            // the node is only used as the key (and the geometry) of the surfel
+            const ufo::map::Node node(
+                nullptr,
+                _smp.toCode(ufo::map::Point3(static_cast<float>(center.x()),
+                                             static_cast<float>(center.y()),
+                                             static_cast<float>(center.z())),
+                            static_cast<ufo::map::depth_t>(depth)));
+            lookup.AddSurfel(node, surfel->first, surfel->second,
+                             ufo::map::Point3(static_cast<float>(min.x()),
+                                              static_cast<float>(min.y()),
+                                              static_cast<float>(min.z())),
+                             ufo::map::Point3(static_cast<float>(max.x()),
+                                              static_cast<float>(max.y()),
+                                              static_cast<float>(max.z())));
+        }
+    }
+}
+
+void PointToSurfelAssociator::SortInZOrder(ufo::map::PointCloud &cloud, double resolution) {
+    const int size = static_cast<int>(cloud.size());
+    if (size < 2) {
+        return;
+    }
+    const int threads = Configor::Preference::AvailableThreads();
+
+    // quantize points relative to the min corner of the cloud
+    float minX = cloud[0].x, minY = cloud[0].y, minZ = cloud[0].z;
+#pragma omp parallel for num_threads(threads) default(none) shared(cloud, size) \
+    reduction(min : minX, minY, minZ)
+    for (int i = 0; i < size; ++i) {
+        minX = std::min(minX, cloud[i].x);
+        minY = std::min(minY, cloud[i].y);
+        minZ = std::min(minZ, cloud[i].z);
+    }
+    const double invRes = 1.0 / resolution;
+    constexpr double QUANT_MAX = static_cast<double>((1 << 21) - 1);
+    auto Quantize = [invRes, QUANT_MAX](float val, float min) {
+        return static_cast<std::uint64_t>(std::min(std::floor((val - min) * invRes), QUANT_MAX));
+    };
+
+    std::vector<std::pair<std::uint64_t, int>> keys(size);
+#pragma omp parallel for num_threads(threads) default(none) \
+    shared(cloud, size, keys, minX, minY, minZ, Quantize)
+    for (int i = 0; i < size; ++i) {
+        const auto &p = cloud[i];
+        keys[i].first = SpreadBitsBy3(Quantize(p.x, minX)) |
+                        SpreadBitsBy3(Quantize(p.y, minY)) << 1 |
+                        SpreadBitsBy3(Quantize(p.z, minZ)) << 2;
+        keys[i].second = i;
+    }
+
+    // sort chunks in parallel, and then merge them pairwise
+    const int chunk = (size + threads - 1) / threads;
+#pragma omp parallel for num_threads(threads) default(none) shared(keys, size, chunk)
+    for (int s = 0; s < size; s += chunk) {
+        std::sort(keys.begin() + s, keys.begin() + std::min(s + chunk, size));
+    }
+    for (int width = chunk; width < size; width *= 2) {
+#pragma omp parallel for num_threads(threads) default(none) shared(keys, size, width)
+        for (int s = 0; s < size - width; s += 2 * width) {
+            std::inplace_merge(keys.begin() + s, keys.begin() + s + width,
+                               keys.begin() + std::min(s + 2 * width, size));
+        }
+    }
+
+    ufo::map::PointCloud sorted;
+    sorted.resize(size);
+#pragma omp parallel for num_threads(threads) default(none) shared(cloud, sorted, keys, size)
+    for (int i = 0; i < size; ++i) {
+        sorted[i] = cloud[keys[i].second];
+    }
+    cloud = std::move(sorted);
 }
 
 double PointToSurfelAssociator::SurfelScore(const ufo::map::SurfelMap &m, const ufo::map::Node &n) {
@@ -104,11 +379,6 @@ double PointToSurfelAssociator::SurfelScore(const ufo::map::SurfelMap &m, const
     return score;
 }
 
-double PointToSurfelAssociator::PointToSurfel(const ufo::map::SurfelMap::Surfel &s,
-                                              const ufo::map::Point3 &p) {
-    return std::abs(SurfelCoeffs(s).dot(Eigen::Vector4d(p.x, p.y, p.z, 1.0)));
-}
-
 Eigen::Vector4d PointToSurfelAssociator::SurfelCoeffs(const ufo::map::SurfelMap::Surfel &s) {
     auto norm = s.getNormal();
     auto d = -norm.dot(s.getMean());
@@ -117,24 +387,108 @@ Eigen::Vector4d PointToSurfelAssociator::SurfelCoeffs(const ufo::map::SurfelMap:
 
 const ufo::map::SurfelMap &PointToSurfelAssociator::GetSurfelMap() const { return _smp; }
 
-std::vector<PointToSurfelCorr::Ptr> PointToSurfelAssociator::Association(
+bool PointToSurfelAssociator::IsCompact() const { return _compact; }
+
+std::uint64_t PointToSurfelAssociator::SurfelLookup::CellKey(float x, float y, float z) const {
+    // cell indices are offset to be non-negative, 21 bits for each axis
+    auto Index = [this](float v) {
+        return static_cast<std::uint64_t>(
+                   static_cast<std::int64_t>(std::floor(v / cellSize)) + (1 << 20)) &
+               0x1fffff;
+    };
+    return Index(x) | Index(y) << 21 | Index(z) << 42;
+}
+
+void PointToSurfelAssociator::SurfelLookup::AddSurfel(const ufo::map::Node &node,
+                                                      double score,
+                                                      const Eigen::Vector4d &coeff,
+                                                      const ufo::map::Point3 &min,
+                                                      const ufo::map::Point3 &max) {
+    const auto surfelIdx = static_cast<std::uint32_t>(nodes.size());
+    nodes.push_back(node);
+    scores.push_back(score);
+    coeffs.push_back(coeff);
+    // node bounds are multiples of the cell size, cells are indexed by their min corners
+    const int nx = std::max(1, static_cast<int>(std::round((max.x - min.x) / cellSize)));
+    const int ny = std::max(1, static_cast<int>(std::round((max.y - min.y) / cellSize)));
+    const int nz = std::max(1, static_cast<int>(std::round((max.z - min.z) / cellSize)));
+    for (int ix = 0; ix < nx; ++ix) {
+        for (int iy = 0; iy < ny; ++iy) {
+            for (int iz = 0; iz < nz; ++iz) {
+                auto key = CellKey(static_cast<float>(min.x + (ix + 0.5) * cellSize),
+                                   static_cast<float>(min.y + (iy + 0.5) * cellSize),
+                                   static_cast<float>(min.z + (iz + 0.5) * cellSize));
+                cells[key].push_back(surfelIdx);
+            }
+        }
+    }
+}
+
+std::shared_ptr<const PointToSurfelAssociator::SurfelLookup>
+PointToSurfelAssociator::GetSurfelLookup(const PointToSurfelCondition &condition) {
+    std::lock_guard<std::mutex> lock(_lookupMutex);
+    // the point-to-surfel distance is checked for each point, thus is not involved here
+    if (_lookup != nullptr && _lookup->condition.queryDepthMin == condition.queryDepthMin &&
+        _lookup->condition.queryDepthMax == condition.queryDepthMax &&
+        _lookup->condition.surfelPointMin == condition.surfelPointMin &&
+        _lookup->condition.planarityMin == condition.planarityMin) {
+        return _lookup;
+    }
+
+    auto lookup = std::make_shared<SurfelLookup>();
+    lookup->condition = condition;
+    lookup->cellSize = _smp.getNodeSize(condition.queryDepthMin);
+
+    // each qualified surfel is registered to all cells it covers
+    if (_compact) {
+        BuildCompactSurfelLookup(*lookup);
+    } else {
+        namespace ufopred = ufo::map::predicate;
+        auto pred = ufopred::HasSurfel()
+                // depth constraint
+                && ufopred::DepthMin(condition.queryDepthMin) &&
+                ufopred::DepthMax(condition.queryDepthMax)
+                // point num constraint
+                && ufopred::NumSurfelPointsMin(condition.surfelPointMin)
+                // planarity constraint
+                && ufopred::SurfelPlanarityMin(condition.planarityMin);
+        for (const auto &node : _smp.query(pred)) {
+            lookup->AddSurfel(node, SurfelScore(_smp, node), SurfelCoeffs(_smp.getSurfel(node)),
+                              _smp.getNodeMin(node), _smp.getNodeMax(node));
+        }
+    }
+    // the best one is checked first
+    const auto &scores = lookup->scores;
+    for (auto &[key, candidates] : lookup->cells) {
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [&scores](auto a, auto b) { return scores[a] > scores[b]; });
+    }
+
+    _lookup = lookup;
+    return _lookup;
+}
+
+PointToSurfelCorrBuffer::Ptr PointToSurfelAssociator::Association(
     const IKalibrPointCloud::Ptr &mapCloud,
     const IKalibrPointCloud::Ptr &rawCloud,
-    const PointToSurfelCondition &condition) {
+    const PointToSurfelCondition &condition,
+    bool withVisualization) {
+    auto corrs = PointToSurfelCorrBuffer::Create();
     if (mapCloud == nullptr || rawCloud == nullptr) {
-        return {};
+        return corrs;
     }
 
-    namespace ufopred = ufo::map::predicate;
+    // candidate surfels of cells are looked up, rather than querying the tree for each point
+    const auto lookup = GetSurfelLookup(condition);
 
     // get the width and height of this scan
     const int pts = static_cast<int>(rawCloud->size());
 
     std::vector<double> winScores(pts, -1.0);
-    std::vector<ufo::map::Node> winNodes(pts, ufo::map::Node());
+    std::vector<std::uint32_t> winSurfels(pts, 0);
 
-#pragma omp parallel for num_threads(omp_get_max_threads()) default(none) \
-    shared(pts, mapCloud, condition, winNodes, winScores)
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(pts, mapCloud, condition, winSurfels, winScores, lookup)
     for (int i = 0; i < pts; ++i) {
         const auto &mp = mapCloud->at(i);
 
@@ -143,55 +497,176 @@ std::vector<PointToSurfelCorr::Ptr> PointToSurfelAssociator::Association(
             continue;
         }
 
-        // predicate
-        auto pred = ufopred::HasSurfel()
-                    // depth constraint
-                    && ufopred::DepthMin(condition.queryDepthMin) &&
-                    ufopred::DepthMax(condition.queryDepthMax)
-                    // point num constraint
-                    && ufopred::NumSurfelPointsMin(condition.surfelPointMin)
-                    // planarity constraint
-                    && ufopred::SurfelPlanarityMin(condition.planarityMin)
-                    // geometry constraint
-                    && ufopred::Contains(ufo::geometry::Point(mp.x, mp.y, mp.z));
-
-        double winScore = -1.0;
-        ufo::map::Node winNode;
+        auto iter = lookup->cells.find(lookup->CellKey(mp.x, mp.y, mp.z));
+        if (iter == lookup->cells.cend()) {
+            continue;
+        }
 
-        for (const auto &node : _smp.query(pred)) {
-            double s = SurfelScore(_smp, node);
-            if (winScore < 0.0 || s > winScore) {
-                // this surfel is a good surfel, check point to surfel distance
-                if (PointToSurfel(_smp.getSurfel(node), ufo::map::Point3(mp.x, mp.y, mp.z)) <
-                    condition.pointToSurfelMax) {
-                    winScore = s, winNode = node;
-                }
+        // candidates are sorted by scores, the first one close enough to the point wins
+        for (const auto &surfelIdx : iter->second) {
+            const auto &coeff = lookup->coeffs[surfelIdx];
+            if (std::abs(coeff.dot(Eigen::Vector4d(mp.x, mp.y, mp.z, 1.0))) <
+                condition.pointToSurfelMax) {
+                winScores.at(i) = lookup->scores[surfelIdx], winSurfels.at(i) = surfelIdx;
+                break;
             }
         }
-
-        winScores.at(i) = winScore, winNodes.at(i) = winNode;
     }
 
-    std::vector<PointToSurfelCorr::Ptr> corrs;
-    corrs.reserve(pts);
+    std::size_t count = 0;
+    for (int i = 0; i < pts; ++i) {
+        count += winScores.at(i) > 0.0;
+    }
+    corrs->Reserve(count, withVisualization);
     for (int i = 0; i < pts; ++i) {
         double winScore = winScores.at(i);
         // valid
         if (winScore > 0.0) {
             const auto &rp = rawCloud->at(i);
             const auto &mp = mapCloud->at(i);
+            const auto &winSurfel = winSurfels.at(i);
+
+            // surfels hit by several points are inserted into the table only once
+            const auto surfelIdx =
+                corrs->surfels->Insert(lookup->nodes[winSurfel], lookup->coeffs[winSurfel]);
+            const Eigen::Vector3f pInMap(mp.x, mp.y, mp.z);
+            corrs->Append(rp.timestamp, Eigen::Vector3f(rp.x, rp.y, rp.z),
+                          static_cast<float>(winScore), surfelIdx,
+                          withVisualization ? &pInMap : nullptr);
+        }
+    }
 
-            auto corr =
-                PointToSurfelCorr::Create(rp.timestamp, Eigen::Vector3d(rp.x, rp.y, rp.z), winScore,
-                                          SurfelCoeffs(_smp.getSurfel(winNodes.at(i))));
-
-            corr->pInMap = Eigen::Vector3d(mp.x, mp.y, mp.z);
-            corr->node = winNodes.at(i);
+    return corrs;
+}
 
-            corrs.push_back(corr);
+std::vector<PointToSurfelCorrBuffer::Ptr> PointToSurfelAssociator::Association(
+    const std::vector<IKalibrPointCloud::Ptr> &mapClouds,
+    const std::vector<IKalibrPointCloud::Ptr> &rawClouds,
+    const PointToSurfelCondition &condition,
+    bool withVisualization,
+    int candidateCount) {
+    if (mapClouds.size() != rawClouds.size()) {
+        throw Status(Status::ERROR,
+                     "the count of map clouds '{}' and raw clouds '{}' for association mismatch!",
+                     mapClouds.size(), rawClouds.size());
+    }
+    const int scanCount = static_cast<int>(mapClouds.size());
+
+    // the surfel lookup is built once here, before scans query it in parallel
+    GetSurfelLookup(condition);
+
+    /**
+     * scans are associated in parallel, the point-level parallel region in the association of a
+     * single scan is nested here, and thus runs serially (unless nesting is enabled)
+     */
+    std::vector<PointToSurfelCorrBuffer::Ptr> corrs(scanCount);
+    std::vector<std::exception_ptr> exceptions(scanCount, nullptr);
+    // candidates are sampled in nodes of the coarsest queried depth
+    const double nodeSize = _smp.getNodeSize(condition.queryDepthMax);
+    const auto seed = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto bar = ProgressStage::Create("associate scans", scanCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(scanCount, mapClouds, rawClouds, condition, corrs, exceptions, bar,   \
+                             candidateCount, nodeSize, seed, withVisualization)
+    for (int i = 0; i < scanCount; ++i) {
+        try {
+            if (candidateCount > 0 && mapClouds.at(i) != nullptr && rawClouds.at(i) != nullptr) {
+                // each scan owns its engine, thus the sampling is independent of scheduling
+                std::default_random_engine engine(seed + i);
+                auto [mapCands, rawCands] = SampleCandidates(mapClouds.at(i), rawClouds.at(i),
+                                                             candidateCount, nodeSize, engine);
+                corrs.at(i) = Association(mapCands, rawCands, condition, withVisualization);
+            } else {
+                corrs.at(i) =
+                    Association(mapClouds.at(i), rawClouds.at(i), condition, withVisualization);
+            }
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
         }
+        bar->Step();
     }
+    bar->Finish();
 
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
     return corrs;
 }
+
+std::pair<IKalibrPointCloud::Ptr, IKalibrPointCloud::Ptr> PointToSurfelAssociator::SampleCandidates(
+    const IKalibrPointCloud::Ptr &mapCloud,
+    const IKalibrPointCloud::Ptr &rawCloud,
+    int count,
+    double nodeSize,
+    std::default_random_engine &engine) {
+    const int pts = static_cast<int>(rawCloud->size());
+    if (count >= pts) {
+        return {mapCloud, rawCloud};
+    }
+    // points of an organized scan are stored ring by ring
+    const int width = rawCloud->height > 1 ? static_cast<int>(rawCloud->width) : pts;
+
+    // organize valid points into strata by the ring, the range bin (log2), and the map node
+    std::unordered_map<std::size_t, std::vector<int>> strataMap;
+    for (int i = 0; i < pts; ++i) {
+        const auto &mp = mapCloud->at(i);
+        const auto &rp = rawCloud->at(i);
+        if (IS_POS_NAN(mp) || IS_POS_NAN(rp)) {
+            continue;
+        }
+        const double range = Eigen::Vector3d(rp.x, rp.y, rp.z).norm();
+        const auto ring = static_cast<std::size_t>(i / width);
+        const auto rangeBin = static_cast<std::size_t>(std::max(0.0, std::log2(range + 1.0)));
+        const auto nx = static_cast<long>(std::floor(mp.x / nodeSize));
+        const auto ny = static_cast<long>(std::floor(mp.y / nodeSize));
+        const auto nz = static_cast<long>(std::floor(mp.z / nodeSize));
+        // the spatial hash of the node, collisions only merge strata
+        auto key = static_cast<std::size_t>((nx * 73856093L) ^ (ny * 19349663L) ^ (nz * 83492791L));
+        key = key * 31 + ring;
+        key = key * 31 + rangeBin;
+        strataMap[key].push_back(i);
+    }
+
+    std::vector<std::vector<int>> strata;
+    strata.reserve(strataMap.size());
+    for (auto &[key, indices] : strataMap) {
+        std::shuffle(indices.begin(), indices.end(), engine);
+        strata.push_back(std::move(indices));
+    }
+    std::shuffle(strata.begin(), strata.end(), engine);
+
+    // round-robin over strata, one point from each stratum in each round
+    std::vector<int> picked;
+    picked.reserve(count);
+    for (std::size_t round = 0; static_cast<int>(picked.size()) < count; ++round) {
+        bool anyLeft = false;
+        for (const auto &stratum : strata) {
+            if (round >= stratum.size()) {
+                continue;
+            }
+            anyLeft = true;
+            picked.push_back(stratum.at(round));
+            if (static_cast<int>(picked.size()) == count) {
+                break;
+            }
+        }
+        if (!anyLeft) {
+            break;
+        }
+    }
+    std::sort(picked.begin(), picked.end());
+
+    IKalibrPointCloud::Ptr mapCands(new IKalibrPointCloud);
+    IKalibrPointCloud::Ptr rawCands(new IKalibrPointCloud);
+    mapCands->reserve(picked.size());
+    rawCands->reserve(picked.size());
+    for (int idx : picked) {
+        mapCands->push_back(mapCloud->at(idx));
+        rawCands->push_back(rawCloud->at(idx));
+    }
+    return {mapCands, rawCands};
+}
 }  // namespace ns_ikalibr
@@ -59,11 +59,10 @@ void RadarVelocitySacProblem::getSelectedDistancesToModel(
     const std::vector<int> &indices,
     std::vector<double> &scores) const {
     scores.resize(indices.size());
-    const auto &allTargets = _data->GetTargets();
+    const auto &soa = _data->GetTargetSoA();
     for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
-        const auto &curTar = allTargets.at(indices.at(i));
-        const Eigen::Vector3d &tPos = curTar->GetTargetXYZ();
-        scores.at(i) = curTar->GetRadialVelocity() + tPos.dot(model) / tPos.norm();
+        const int idx = indices[i];
+        scores[i] = soa.radialVels(idx) + soa.dirs.col(idx).dot(model);
     }
 }
 
@@ -73,4 +72,118 @@ void RadarVelocitySacProblem::optimizeModelCoefficients(
     RadarVelocitySacProblem::model_t &optimized_model) {
     computeModelCoefficients(inliers, optimized_model);
 }
+
+// ----------------
+// RadarVelocitySac
+// ----------------
+
+RadarVelocitySac::RadarVelocitySac(const RadarTargetArray::Ptr &data, unsigned int seed)
+    : _data(data),
+      _soa(_data->GetTargetSoA()),
+      _rng(seed) {}
+
+RadarVelocitySac::Ptr RadarVelocitySac::Create(const RadarTargetArray::Ptr &data,
+                                               unsigned int seed) {
+    return std::make_shared<RadarVelocitySac>(data, seed);
+}
+
+int RadarVelocitySac::GetTargetCount() const { return static_cast<int>(_soa.Size()); }
+
+std::optional<Eigen::Vector3d> RadarVelocitySac::Estimate(double threshold,
+                                                          int maxIterations,
+                                                          double probability) {
+    const int n = GetTargetCount();
+    if (n < 3) {
+        return {};
+    }
+    std::uniform_int_distribution<int> dist(0, n - 1);
+
+    Eigen::Vector3d bestModel;
+    int bestCount = -1;
+    // the required iteration count, which is updated by the inlier ratio of the best model
+    double requiredIterations = maxIterations;
+    for (int iter = 0; iter < maxIterations && iter < requiredIterations; ++iter) {
+        std::array<int, 3> indices{dist(_rng), dist(_rng), dist(_rng)};
+        while (indices[1] == indices[0]) {
+            indices[1] = dist(_rng);
+        }
+        while (indices[2] == indices[0] || indices[2] == indices[1]) {
+            indices[2] = dist(_rng);
+        }
+        Eigen::Vector3d model;
+        if (!ComputeMinimalModel(indices, model)) {
+            continue;
+        }
+        const int count = CountInliers(model, threshold, bestCount);
+        if (count <= bestCount) {
+            continue;
+        }
+        bestCount = count;
+        bestModel = model;
+
+        const double inlierRatio = static_cast<double>(count) / n;
+        const double noOutlierProb = 1.0 - inlierRatio * inlierRatio * inlierRatio;
+        if (noOutlierProb < std::numeric_limits<double>::epsilon()) {
+            // all targets are inliers
+            break;
+        }
+        requiredIterations = std::log(1.0 - probability) / std::log(noOutlierProb);
+    }
+    if (bestCount < 3) {
+        return {};
+    }
+    return RefineModel(bestModel, threshold);
+}
+
+bool RadarVelocitySac::ComputeMinimalModel(const std::array<int, 3> &indices,
+                                           Eigen::Vector3d &model) const {
+    // doppler model for static targets: 'dir.dot(vel) + radialVel = 0'
+    Eigen::Matrix3d A;
+    Eigen::Vector3d b;
+    for (int i = 0; i < 3; ++i) {
+        A.row(i) = _soa.dirs.col(indices[i]).transpose();
+        b(i) = -_soa.radialVels(indices[i]);
+    }
+    if (std::abs(A.determinant()) < 1E-6) {
+        return false;
+    }
+    model = A.inverse() * b;
+    return true;
+}
+
+int RadarVelocitySac::CountInliers(const Eigen::Vector3d &model,
+                                   double threshold,
+                                   int bestCount) const {
+    const Eigen::Index n = _soa.Size();
+    int count = 0;
+    for (Eigen::Index s = 0; s < n; s += SCORE_BLOCK_SIZE) {
+        const Eigen::Index len = std::min<Eigen::Index>(SCORE_BLOCK_SIZE, n - s);
+        count += static_cast<int>(
+            ((_soa.dirs.middleCols(s, len).transpose() * model + _soa.radialVels.segment(s, len))
+                 .array()
+                 .abs() < threshold)
+                .count());
+        // even if all remaining targets are inliers, this model is not better than the best one
+        if (count + (n - s - len) <= bestCount) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+std::optional<Eigen::Vector3d> RadarVelocitySac::RefineModel(const Eigen::Vector3d &model,
+                                                             double threshold) const {
+    // weights of targets (squared ranges, as the raw least-squares one does), zeros for outliers
+    const Eigen::ArrayXd weights =
+        ((_soa.dirs.transpose() * model + _soa.radialVels).array().abs() < threshold)
+            .cast<double>() *
+        _soa.ranges.array().square();
+    if ((weights > 0.0).count() < 3) {
+        return {};
+    }
+    const Eigen::Matrix3Xd weightedDirs = _soa.dirs.array().rowwise() * weights.transpose();
+    const Eigen::Matrix3d A = weightedDirs * _soa.dirs.transpose();
+    const Eigen::Vector3d b = -weightedDirs * _soa.radialVels;
+    return Eigen::Vector3d(A.ldlt().solve(b));
+}
 }  // namespace ns_ikalibr
\ No newline at end of file
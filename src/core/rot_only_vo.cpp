@@ -37,8 +37,10 @@
 #include "calib/calib_param_manager.h"
 #include "util/status.hpp"
 #include "util/utils_tpl.hpp"
+#include "config/configor.h"
 
 #include "opencv2/highgui.hpp"
+#include "atomic"
 #include "opencv2/video/tracking.hpp"
 #include "opencv2/calib3d.hpp"
 
@@ -53,14 +55,19 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 RotOnlyVisualOdometer::RotOnlyVisualOdometer(FeatureTracking::Ptr featTracking,
-                                             ns_veta::PinholeIntrinsic::Ptr intri)
+                                             ns_veta::PinholeIntrinsic::Ptr intri,
+                                             bool visualize)
     : _featTracking(std::move(featTracking)),
       _intri(std::move(intri)),
-      _trackFeatLast(nullptr) {}
+      _trackFeatLast(nullptr),
+      _keepRotations(true),
+      _visualize(visualize) {}
 
 RotOnlyVisualOdometer::Ptr RotOnlyVisualOdometer::Create(
-    const FeatureTracking::Ptr &featTracking, const ns_veta::PinholeIntrinsic::Ptr &intri) {
-    return std::make_shared<RotOnlyVisualOdometer>(featTracking, intri);
+    const FeatureTracking::Ptr &featTracking,
+    const ns_veta::PinholeIntrinsic::Ptr &intri,
+    bool visualize) {
+    return std::make_shared<RotOnlyVisualOdometer>(featTracking, intri, visualize);
 }
 
 bool RotOnlyVisualOdometer::GrabFrame(const CameraFrame::Ptr &curFrame,
@@ -145,6 +152,9 @@ bool RotOnlyVisualOdometer::GrabFrame(const CameraFrame::Ptr &curFrame,
     Eigen::Matrix3d ROT_CurToLast = res.first;
     Sophus::SO3d SO3_CurToLast(Sophus::makeRotationMatrix(ROT_CurToLast));
     Sophus::SO3d SO3_CurToW = _rotations.back().second * SO3_CurToLast;
+    if (!_keepRotations) {
+        _rotations.clear();
+    }
     _rotations.emplace_back(curFrame->GetTimestamp(), SO3_CurToW);
 
     // remove outlier
@@ -190,9 +200,11 @@ bool RotOnlyVisualOdometer::GrabFrame(const CameraFrame::Ptr &curFrame,
     _featId2lmIdInLast = featId2lmIdInLastTmp;
     _trackFeatLast = trackedFeats;
 
-    // spdlog::info("show tracked features on the image...");
-    ShowCurrentFrame();
-    cv::waitKey(1);
+    if (_visualize) {
+        // spdlog::info("show tracked features on the image...");
+        ShowCurrentFrame();
+        cv::waitKey(1);
+    }
 #undef VISUALIZATION
     return true;
 }
@@ -201,6 +213,143 @@ void RotOnlyVisualOdometer::ResetWorkspace() {
     _lmTrackInfo.clear();
     _featId2lmIdInLast.clear();
     _rotations.clear();
+    // the next grabbed frame is treated as the first one of a new piece
+    _trackFeatLast = nullptr;
+}
+
+void RotOnlyVisualOdometer::KeepRotationSequence(bool keep) {
+    _keepRotations = keep;
+    if (!_keepRotations && _rotations.size() > 1) {
+        _rotations.erase(_rotations.begin(), std::prev(_rotations.end()));
+        _rotations.shrink_to_fit();
+    }
+}
+
+std::vector<RotOnlyVisualOdometer::TrackedPiece> RotOnlyVisualOdometer::TrackInChunks(
+    const std::vector<CameraFramePtr> &frames,
+    const std::function<FeatureTracking::Ptr()> &trackerCreator,
+    const ns_veta::PinholeIntrinsic::Ptr &intri,
+    int chunkSize,
+    int overlap) {
+    const int frameCount = static_cast<int>(frames.size());
+    chunkSize = std::max(chunkSize, 1);
+    overlap = std::clamp(overlap, 0, chunkSize);
+    // the last chunk covers the remaining frames
+    const int chunkCount = std::max(1, (frameCount - overlap) / chunkSize);
+
+    std::vector<std::vector<TrackedPiece>> chunkPieces(chunkCount);
+    std::vector<std::exception_ptr> exceptions(chunkCount, nullptr);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(chunkCount, chunkSize, overlap, frameCount, frames, trackerCreator,   \
+                             intri, chunkPieces, exceptions)
+    for (int c = 0; c < chunkCount; ++c) {
+        const int sIdx = c * chunkSize;
+        const int eIdx = c == chunkCount - 1 ? frameCount : (c + 1) * chunkSize + overlap;
+        try {
+            // the highgui can only be used in one thread, chunks are tracked without visualization
+            auto odometer = Create(trackerCreator(), intri, false);
+            auto &pieces = chunkPieces.at(c);
+            for (int i = sIdx; i < eIdx; ++i) {
+                if (!odometer->GrabFrame(frames.at(i))) {
+                    pieces.push_back({odometer->GetRotations(), odometer->GetLmTrackInfo()});
+                    odometer->ResetWorkspace();
+                }
+            }
+            pieces.push_back({odometer->GetRotations(), odometer->GetLmTrackInfo()});
+        } catch (...) {
+            exceptions.at(c) = std::current_exception();
+        }
+    }
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    std::vector<TrackedPiece> pieces;
+    for (int c = 0; c < chunkCount; ++c) {
+        auto &curPieces = chunkPieces.at(c);
+        // pieces failed to be tracked are empty
+        curPieces.erase(std::remove_if(curPieces.begin(), curPieces.end(),
+                                       [](const auto &p) { return p.rotations.empty(); }),
+                        curPieces.end());
+        if (curPieces.empty()) {
+            continue;
+        }
+        auto iter = curPieces.begin();
+        if (c != 0 && !pieces.empty()) {
+            // frames from the head of this chunk on are represented by this chunk
+            const double headTime = frames.at(c * chunkSize)->GetTimestamp();
+            for (auto &piece : pieces) {
+                if (&piece != &pieces.back()) {
+                    TrimPiece(piece, headTime);
+                }
+            }
+            if (StitchPieces(pieces.back(), *iter, std::max(2, overlap / 2))) {
+                ++iter;
+            } else {
+                TrimPiece(pieces.back(), headTime);
+            }
+            pieces.erase(std::remove_if(pieces.begin(), pieces.end(),
+                                        [](const auto &p) { return p.rotations.empty(); }),
+                         pieces.end());
+        }
+        std::move(iter, curPieces.end(), std::back_inserter(pieces));
+    }
+    return pieces;
+}
+
+bool RotOnlyVisualOdometer::StitchPieces(TrackedPiece &last, TrackedPiece &next, int sharedMin) {
+    // the rotations from the world frame of 'next' to the one of 'last' at shared frames
+    std::vector<Sophus::SO3d> SO3_NextWToLastWSeq;
+    auto lastIter = last.rotations.cbegin();
+    for (const auto &[time, SO3_CurToNextW] : next.rotations) {
+        while (lastIter != last.rotations.cend() && lastIter->first < time) {
+            ++lastIter;
+        }
+        if (lastIter == last.rotations.cend()) {
+            break;
+        }
+        if (lastIter->first == time) {
+            SO3_NextWToLastWSeq.push_back(lastIter->second * SO3_CurToNextW.inverse());
+        }
+    }
+    if (static_cast<int>(SO3_NextWToLastWSeq.size()) < sharedMin) {
+        return false;
+    }
+    // average the rotation in the tangent space of the first one
+    const Sophus::SO3d &SO3_Ref = SO3_NextWToLastWSeq.front();
+    Eigen::Vector3d delta = Eigen::Vector3d::Zero();
+    for (const auto &SO3_NextWToLastW : SO3_NextWToLastWSeq) {
+        delta += (SO3_Ref.inverse() * SO3_NextWToLastW).log();
+    }
+    delta /= static_cast<double>(SO3_NextWToLastWSeq.size());
+    const Sophus::SO3d SO3_NextWToLastW = SO3_Ref * Sophus::SO3d::exp(delta);
+
+    TrimPiece(last, next.rotations.front().first);
+    last.rotations.reserve(last.rotations.size() + next.rotations.size());
+    for (const auto &[time, SO3_CurToNextW] : next.rotations) {
+        last.rotations.emplace_back(time, SO3_NextWToLastW * SO3_CurToNextW);
+    }
+    // landmark ids are unique over odometers
+    last.lmTrackInfo.merge(next.lmTrackInfo);
+    return true;
+}
+
+void RotOnlyVisualOdometer::TrimPiece(TrackedPiece &piece, double time) {
+    auto &rotations = piece.rotations;
+    rotations.erase(std::lower_bound(rotations.begin(), rotations.end(), time,
+                                     [](const auto &p, double t) { return p.first < t; }),
+                    rotations.end());
+    for (auto iter = piece.lmTrackInfo.begin(); iter != piece.lmTrackInfo.end();) {
+        iter->second.remove_if([time](const auto &p) { return p.first->GetTimestamp() >= time; });
+        if (iter->second.empty()) {
+            iter = piece.lmTrackInfo.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
 }
 
 std::pair<opengv::rotation_t, std::vector<int>> RotOnlyVisualOdometer::RelRotationRecovery(
@@ -353,7 +502,8 @@ const std::vector<std::pair<double, Sophus::SO3d>> &RotOnlyVisualOdometer::GetRo
 RotOnlyVisualOdometer::~RotOnlyVisualOdometer() { cv::destroyAllWindows(); }
 
 ns_veta::IndexT RotOnlyVisualOdometer::GenNewLmId() {
-    static ns_veta::IndexT id = 0;
+    // odometers of different cameras may run in parallel
+    static std::atomic<ns_veta::IndexT> id(0);
     return ++id;
 }
 
@@ -417,7 +567,7 @@ const RotOnlyVisualOdometer::FeatTrackingInfo &RotOnlyVisualOdometer::GetLmTrack
 
 void RotOnlyVisualOdometer::ShowLmTrackInfo() const {
     for (const auto &[lmId, trackList] : _lmTrackInfo) {
-        spdlog::info("landmark id: {}, track count: {}", lmId, trackList.size());
+        spdlog::trace("landmark id: {}, track count: {}", lmId, trackList.size());
         if (trackList.size() == 1) {
             continue;
         }
@@ -43,7 +43,11 @@ namespace ns_ikalibr {
 
 RotationEstimator::RotationEstimator()
     : _solveFlag(false),
-      _sensorToSpline() {}
+      _sensorToSpline(),
+      _normalMat(Eigen::Matrix4d::Zero()),
+      _coeffMatCount(0),
+      _involvedCount(0),
+      _headTime(0.0) {}
 
 RotationEstimator::Ptr RotationEstimator::Create() { return std::make_shared<RotationEstimator>(); }
 
@@ -100,14 +104,151 @@ void RotationEstimator::Estimate(const RotationEstimator::So3SplineType &spline,
     return Estimate(spline, rotSeq);
 }
 
+void RotationEstimator::EstimateIncrementally(const So3SplineType &spline,
+                                              const RotationSequence &rotSeq) {
+    if (rotSeq.empty()) {
+        _solveFlag = false;
+        return;
+    }
+    CheckIncrementalState(rotSeq.size(), rotSeq.front().first);
+
+    RelRotationSequence newRelRotSeq;
+    for (std::size_t i = std::max<std::size_t>(_involvedCount, 1); i < rotSeq.size(); ++i) {
+        const auto &[curTime, curRot] = rotSeq.at(i);
+        const auto &[lastTime, lastRot] = rotSeq.at(i - 1);
+        newRelRotSeq.emplace_back(lastTime, curTime, lastRot.inverse() * curRot);
+    }
+    _involvedCount = rotSeq.size();
+    AccumulateAndSolve(spline, newRelRotSeq);
+}
+
+void RotationEstimator::EstimateIncrementally(const So3SplineType &spline,
+                                              const RelRotationSequence &relRotSeq) {
+    if (relRotSeq.empty()) {
+        _solveFlag = false;
+        return;
+    }
+    CheckIncrementalState(relRotSeq.size(), std::get<0>(relRotSeq.front()));
+
+    RelRotationSequence newRelRotSeq(relRotSeq.cbegin() + static_cast<long>(_involvedCount),
+                                     relRotSeq.cend());
+    _involvedCount = relRotSeq.size();
+    AccumulateAndSolve(spline, newRelRotSeq);
+}
+
+void RotationEstimator::EstimateIncrementally(const So3SplineType &spline,
+                                              const std::vector<ns_ctraj::Posed> &poseSeq) {
+    if (poseSeq.empty()) {
+        _solveFlag = false;
+        return;
+    }
+    CheckIncrementalState(poseSeq.size(), poseSeq.front().timeStamp);
+
+    RelRotationSequence newRelRotSeq;
+    for (std::size_t i = std::max<std::size_t>(_involvedCount, 1); i < poseSeq.size(); ++i) {
+        const auto &curPose = poseSeq.at(i), &lastPose = poseSeq.at(i - 1);
+        newRelRotSeq.emplace_back(lastPose.timeStamp, curPose.timeStamp,
+                                  lastPose.so3.inverse() * curPose.so3);
+    }
+    _involvedCount = poseSeq.size();
+    AccumulateAndSolve(spline, newRelRotSeq);
+}
+
+void RotationEstimator::CheckIncrementalState(std::size_t seqSize, double headTime) {
+    if (seqSize >= _involvedCount && headTime == _headTime) {
+        return;
+    }
+    _normalMat = Eigen::Matrix4d::Zero();
+    _coeffMatCount = 0;
+    _involvedCount = 0;
+    _headTime = headTime;
+}
+
+void RotationEstimator::AccumulateAndSolve(const So3SplineType &spline,
+                                           const RelRotationSequence &newRelRotSeq) {
+    _solveFlag = false;
+
+    for (const auto &AMat : OrganizeCoeffMatSeq(spline, newRelRotSeq)) {
+        _normalMat += AMat.transpose() * AMat;
+        ++_coeffMatCount;
+    }
+
+    if (_coeffMatCount < 15) {
+        return;
+    }
+
+    // the squared singular values of the stacked 'A' are the eigen values of 'A^T * A', in
+    // ascending order here, and the right singular vectors are the eigen vectors
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix4d> solver(_normalMat);
+    Eigen::Vector4d eigenValues = solver.eigenvalues();
+
+    if (std::sqrt(std::max(eigenValues(1), 0.0)) > 0.25) {
+        // get result
+        Eigen::Matrix<double, 4, 1> x = solver.eigenvectors().col(0);
+        Eigen::Quaterniond quat(x);
+        Sophus::SO3d splineToSensor(quat);
+
+        _solveFlag = true;
+        _sensorToSpline = splineToSensor.inverse();
+        RecordSolution();
+    }
+}
+
+void RotationEstimator::RecordSolution() {
+    // only a few recent solutions are involved in the stability check
+    constexpr std::size_t recordMax = 16;
+    _recentSolutions.push_back(_sensorToSpline);
+    if (_recentSolutions.size() > recordMax) {
+        _recentSolutions.pop_front();
+    }
+}
+
+bool RotationEstimator::Stable(std::size_t count, double thd) const {
+    if (!_solveFlag || count == 0 || _recentSolutions.size() < count) {
+        return false;
+    }
+    const double thdRad = thd * DEG_TO_RAD;
+    const auto head = _recentSolutions.cend() - static_cast<long>(count);
+    for (auto i = head; i != _recentSolutions.cend(); ++i) {
+        for (auto j = std::next(i); j != _recentSolutions.cend(); ++j) {
+            if ((i->inverse() * *j).log().norm() > thdRad) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+RotationEstimator::RelRotationSequence RotationEstimator::RelRotations(
+    const std::vector<ns_ctraj::Posed> &poseSeq, double timeOffset, double st, double et) {
+    RelRotationSequence relRotSeq;
+    relRotSeq.reserve(poseSeq.size());
+    for (int i = 0; i < static_cast<int>(poseSeq.size()) - 1; ++i) {
+        const auto &sPose = poseSeq.at(i), &ePose = poseSeq.at(i + 1);
+        const double sTime = sPose.timeStamp + timeOffset, eTime = ePose.timeStamp + timeOffset;
+        if (sTime < st || eTime > et) {
+            continue;
+        }
+        relRotSeq.emplace_back(sTime, eTime, sPose.so3.inverse() * ePose.so3);
+    }
+    return relRotSeq;
+}
+
 bool RotationEstimator::SolveStatus() const { return _solveFlag; }
 
 const Sophus::SO3d &RotationEstimator::GetSO3SensorToSpline() const { return _sensorToSpline; }
 
 std::vector<Eigen::Matrix4d> RotationEstimator::OrganizeCoeffMatSeq(
     const So3SplineType &spline, const RelRotationSequence &relRotSeq) {
-    std::vector<Eigen::Matrix4d> AMatSeq;
-    for (const auto &[lastTime, curTime, SO3_CurToLast] : relRotSeq) {
+    // spline evaluations dominate, long sequences are organized in parallel (in order)
+    constexpr int PARALLEL_MIN_COUNT = 256;
+    const int count = static_cast<int>(relRotSeq.size());
+    std::vector<Eigen::Matrix4d> coeffMats(count);
+    std::vector<char> valid(count, 0);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(static) \
+    default(none) shared(count, relRotSeq, spline, coeffMats, valid) if (count > PARALLEL_MIN_COUNT)
+    for (int i = 0; i < count; ++i) {
+        const auto &[lastTime, curTime, SO3_CurToLast] = relRotSeq[i];
         // check time stamp
         if (!spline.TimeStampInRange(curTime) || !spline.TimeStampInRange(lastTime)) {
             continue;
@@ -133,7 +274,16 @@ std::vector<Eigen::Matrix4d> RotationEstimator::OrganizeCoeffMatSeq(
 
         Eigen::Matrix4d lqMat = LeftQuatMatrix(curToLast);
         Eigen::Matrix4d rqMat = RightQuatMatrix(trajCurToLast);
-        AMatSeq.emplace_back(factor * (lqMat - rqMat));
+        coeffMats[i] = factor * (lqMat - rqMat);
+        valid[i] = 1;
+    }
+
+    std::vector<Eigen::Matrix4d> AMatSeq;
+    AMatSeq.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        if (valid[i]) {
+            AMatSeq.push_back(coeffMats[i]);
+        }
     }
     return AMatSeq;
 }
@@ -0,0 +1,295 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "core/scan_registration.h"
+#include "util/status.hpp"
+#include "pcl/kdtree/kdtree_flann.h"
+#include "sophus/se3.hpp"
+#include "util/trace_recorder.h"
+#include "omp.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+// ----------------
+// ScanRegistration
+// ----------------
+
+ScanRegistration::Ptr ScanRegistration::Create(ScanRegistrationType type,
+                                               float resolution,
+                                               int threads) {
+    switch (type) {
+        case ScanRegistrationType::NDT:
+            return NDTScanRegistration::Create(resolution, threads);
+        case ScanRegistrationType::VGICP:
+            return VGICPScanRegistration::Create(resolution, threads);
+        default:
+            throw Status(Status::ERROR, "unsupported scan registration type '{}'!",
+                         EnumCast::enumToString(type));
+    }
+}
+
+// -------------------
+// NDTScanRegistration
+// -------------------
+
+NDTScanRegistration::NDTScanRegistration(float resolution, int threads)
+    : _ndt(new NDTType),
+      _threads(threads) {
+    // init the ndt omp object
+    _ndt->setResolution(resolution);
+    _ndt->setNumThreads(threads);
+    _ndt->setNeighborhoodSearchMethod(pclomp::DIRECT7);
+    _ndt->setTransformationEpsilon(1E-3);
+    _ndt->setStepSize(0.01);
+    _ndt->setMaximumIterations(50);
+}
+
+NDTScanRegistration::Ptr NDTScanRegistration::Create(float resolution, int threads) {
+    return std::make_shared<NDTScanRegistration>(resolution, threads);
+}
+
+void NDTScanRegistration::UpdateTarget(const IKalibrPointCloud::Ptr &target,
+                                       const IKalibrPointCloud &inserted,
+                                       const IKalibrPointCloud &removed) {
+    // only voxels touched by inserted and removed points are updated
+    _ndt->updateInputTarget(target, inserted, removed);
+}
+
+Eigen::Matrix4d NDTScanRegistration::Align(const IKalibrPointCloud::Ptr &source,
+                                           double timestamp,
+                                           const Eigen::Matrix4d &guess) {
+    TraceRecorder::Span span("registration", "NDTAlign");
+    _ndt->setInputSource(source);
+    IKalibrPointCloud::Ptr outputCloud(new IKalibrPointCloud());
+    _ndt->align(*outputCloud, guess.cast<float>());
+    return _ndt->getFinalTransformation().cast<double>();
+}
+
+ScanRegistration::Ptr NDTScanRegistration::Renew() const {
+    return NDTScanRegistration::Create(_ndt->getResolution(), _threads);
+}
+
+const NDTScanRegistration::NDTType::Ptr &NDTScanRegistration::GetNdt() const { return _ndt; }
+
+// ---------------------
+// VGICPScanRegistration
+// ---------------------
+
+VGICPScanRegistration::VGICPScanRegistration(float resolution, int threads)
+    : _resolution(resolution),
+      _threads(threads),
+      _targetInitialized(false),
+      _covCache(std::make_shared<CovarianceCache>()) {
+    _targetCells.setLeafSize(resolution, resolution, resolution);
+}
+
+VGICPScanRegistration::Ptr VGICPScanRegistration::Create(float resolution, int threads) {
+    return std::make_shared<VGICPScanRegistration>(resolution, threads);
+}
+
+void VGICPScanRegistration::UpdateTarget(const IKalibrPointCloud::Ptr &target,
+                                         const IKalibrPointCloud &inserted,
+                                         const IKalibrPointCloud &removed) {
+    if (!_targetInitialized) {
+        // the first target is inserted as a whole
+        _targetCells.clearLeaves();
+        _targetCells.updateLeaves(*target, IKalibrPointCloud());
+        _targetInitialized = true;
+    } else {
+        _targetCells.updateLeaves(inserted, removed);
+    }
+}
+
+Eigen::Matrix4d VGICPScanRegistration::Align(const IKalibrPointCloud::Ptr &source,
+                                             double timestamp,
+                                             const Eigen::Matrix4d &guess) {
+    TraceRecorder::Span span("registration", "VGICPAlign");
+    if (!_targetInitialized || source == nullptr || source->empty()) {
+        return guess;
+    }
+    using Matrix6d = Eigen::Matrix<double, 6, 6>;
+    using Vector6d = Eigen::Matrix<double, 6, 1>;
+
+    const auto covs = SourceCovariances(source, timestamp);
+    const int pts = static_cast<int>(source->size());
+
+    Eigen::Matrix3d curRot = guess.block<3, 3>(0, 0);
+    Eigen::Vector3d curPos = guess.block<3, 1>(0, 3);
+    for (int iter = 0; iter < MaxIterations; ++iter) {
+        // each thread accumulates its own normal equation, which are summed up afterwards
+        std::vector<Matrix6d> hessians(_threads, Matrix6d::Zero());
+        std::vector<Vector6d> gradients(_threads, Vector6d::Zero());
+
+#pragma omp parallel for num_threads(_threads) default(none) \
+    shared(pts, source, covs, curRot, curPos, hessians, gradients)
+        for (int i = 0; i < pts; ++i) {
+            const auto &sp = source->at(i);
+            if (IS_POS_NAN(sp)) {
+                continue;
+            }
+            Eigen::Vector3d q = curRot * Eigen::Vector3d(sp.x, sp.y, sp.z) + curPos;
+
+            IKalibrPoint qp;
+            qp.x = static_cast<float>(q(0));
+            qp.y = static_cast<float>(q(1));
+            qp.z = static_cast<float>(q(2));
+            std::vector<pclomp::VoxelGridCovariance<IKalibrPoint>::LeafConstPtr> neighbors;
+            // the voxel it falls in, which contains enough points
+            if (_targetCells.getNeighborhoodAtPoint1(qp, neighbors) == 0) {
+                continue;
+            }
+            const auto &leaf = neighbors.front();
+
+            // distribution-to-distribution residual, with the fused covariance as the weight
+            Eigen::Vector3d r = leaf->getMean() - q;
+            Eigen::Matrix3d weight =
+                (leaf->getCov() + curRot * covs.at(i) * curRot.transpose()).inverse();
+            // left perturbation: q' = exp(dTheta) * q + dPos
+            Eigen::Matrix<double, 3, 6> jacobian;
+            jacobian.leftCols<3>() = Sophus::SO3d::hat(q);
+            jacobian.rightCols<3>() = -Eigen::Matrix3d::Identity();
+
+            const int tid = omp_get_thread_num();
+            hessians.at(tid) += jacobian.transpose() * weight * jacobian;
+            gradients.at(tid) += jacobian.transpose() * weight * r;
+        }
+
+        Matrix6d hessian = Matrix6d::Zero();
+        Vector6d gradient = Vector6d::Zero();
+        for (int i = 0; i < _threads; ++i) {
+            hessian += hessians.at(i);
+            gradient += gradients.at(i);
+        }
+        Vector6d delta = hessian.ldlt().solve(-gradient);
+        if (!delta.allFinite()) {
+            break;
+        }
+        Eigen::Matrix3d deltaRot = Sophus::SO3d::exp(delta.head<3>()).matrix();
+        curRot = deltaRot * curRot;
+        curPos = deltaRot * curPos + delta.tail<3>();
+
+        if (delta.norm() < ConvergenceEpsilon) {
+            break;
+        }
+    }
+    // keep the rotation orthogonal
+    Eigen::Matrix4d result = Eigen::Matrix4d::Identity();
+    result.block<3, 3>(0, 0) = Eigen::Quaterniond(curRot).normalized().toRotationMatrix();
+    result.block<3, 1>(0, 3) = curPos;
+    return result;
+}
+
+ScanRegistration::Ptr VGICPScanRegistration::Renew() const {
+    auto registration = VGICPScanRegistration::Create(_resolution, _threads);
+    // source covariances are shared
+    registration->_covCache = _covCache;
+    return registration;
+}
+
+std::vector<Eigen::Matrix3d> VGICPScanRegistration::SourceCovariances(
+    const IKalibrPointCloud::Ptr &source, double timestamp) {
+    const int pts = static_cast<int>(source->size());
+    std::vector<Eigen::Matrix3d> covs(pts, Eigen::Matrix3d::Identity());
+
+    std::lock_guard<std::mutex> lock(_covCache->mutex);
+    auto &cachedCovs = _covCache->covs[timestamp];
+
+    // find points whose covariances are not cached
+    std::vector<int> uncached;
+    for (int i = 0; i < pts; ++i) {
+        const auto &p = source->at(i);
+        if (IS_POS_NAN(p)) {
+            continue;
+        }
+        auto iter = cachedCovs.find(KeyOf(p));
+        if (iter != cachedCovs.cend()) {
+            covs.at(i) = iter->second;
+        } else {
+            uncached.push_back(i);
+        }
+    }
+    if (uncached.empty()) {
+        return covs;
+    }
+
+    // the neighbor count should be less than the point count
+    const int k = std::min(CovNeighborCount, pts);
+    pcl::KdTreeFLANN<IKalibrPoint> kdtree;
+    kdtree.setInputCloud(source);
+    const int uncachedCount = static_cast<int>(uncached.size());
+
+#pragma omp parallel for num_threads(_threads) default(none) \
+    shared(uncachedCount, uncached, source, kdtree, k, covs)
+    for (int j = 0; j < uncachedCount; ++j) {
+        const int i = uncached.at(j);
+        std::vector<int> indices;
+        std::vector<float> sqDists;
+        if (kdtree.nearestKSearch(source->at(i), k, indices, sqDists) < 3) {
+            continue;
+        }
+        Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d sqSum = Eigen::Matrix3d::Zero();
+        for (int idx : indices) {
+            const auto &np = source->at(idx);
+            Eigen::Vector3d v(np.x, np.y, np.z);
+            mean += v;
+            sqSum += v * v.transpose();
+        }
+        const auto n = static_cast<double>(indices.size());
+        mean /= n;
+        Eigen::Matrix3d cov = (sqSum - n * mean * mean.transpose()) / (n - 1.0);
+
+        // inflate small eigen values, the same as the ones of the target voxels
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(cov);
+        Eigen::Vector3d evals = solver.eigenvalues();
+        const double minEval = std::max(0.01 * evals(2), 1E-6);
+        evals = evals.cwiseMax(minEval);
+        covs.at(i) = solver.eigenvectors() * evals.asDiagonal() * solver.eigenvectors().transpose();
+    }
+    for (int i : uncached) {
+        cachedCovs[KeyOf(source->at(i))] = covs.at(i);
+    }
+    return covs;
+}
+
+VGICPScanRegistration::VoxelKey VGICPScanRegistration::KeyOf(const IKalibrPoint &p) const {
+    return {static_cast<int>(std::floor(p.x / _resolution)),
+            static_cast<int>(std::floor(p.y / _resolution)),
+            static_cast<int>(std::floor(p.z / _resolution))};
+}
+}  // namespace ns_ikalibr
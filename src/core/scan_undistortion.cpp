@@ -35,8 +35,10 @@
 #include "core/scan_undistortion.h"
 #include "calib/calib_param_manager.h"
 #include "sensor/lidar.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "util/utils_tpl.hpp"
+#include "omp.h"
+#include "atomic"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -61,37 +63,79 @@ ScanUndistortion::Ptr ScanUndistortion::Create(const SplineBundleType::Ptr &spli
 
 std::vector<LiDARFrame::Ptr> ScanUndistortion::UndistortToScan(
     const std::vector<LiDARFrame::Ptr> &data, const std::string &topic, Option option) {
-    std::vector<LiDARFrame::Ptr> lidarUndistFrames;
+    return UndistortFrames(data, topic, IsOptionWith(Option::UNDIST_POS, option), false);
+}
+
+// --------------
+// UndistortToRef
+// --------------
+
+std::vector<LiDARFrame::Ptr> ScanUndistortion::UndistortToRef(
+    const std::vector<LiDARFrame::Ptr> &data, const std::string &topic, Option option) {
+    return UndistortFrames(data, topic, IsOptionWith(Option::UNDIST_POS, option), true);
+}
 
-    auto bar = std::make_shared<tqdm>();
-    bool correctPos = IsOptionWith(Option::UNDIST_POS, option);
-    for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-        bar->progress(i, static_cast<int>(data.size()));
+// ---------------
+// UndistortFrames
+// ---------------
+
+std::vector<LiDARFrame::Ptr> ScanUndistortion::UndistortFrames(
+    const std::vector<LiDARFrame::Ptr> &data,
+    const std::string &topic,
+    bool correctPos,
+    bool toRef) const {
+    // query parameters once, rather than for each point
+    const double TO_LkToBr = _parMagr->TEMPORAL.TO_LkToBr.at(topic);
+    const Sophus::SE3d SE3_LkToBr = _parMagr->EXTRI.SE3_LkToBr(topic);
 
-        if (auto undistLidarFrame = UndistortToScan(data.at(i), topic, correctPos)) {
-            lidarUndistFrames.push_back(*undistLidarFrame);
-        } else {
-            lidarUndistFrames.push_back(nullptr);
+    // frames are undistorted independently, each one is written to its own slot
+    const int frameCount = static_cast<int>(data.size());
+    std::vector<LiDARFrame::Ptr> undistFrames(frameCount, nullptr);
+    std::vector<std::exception_ptr> exceptions(frameCount, nullptr);
+    auto bar = ProgressStage::Create("undistort scans", frameCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(frameCount, data, undistFrames, exceptions, bar, TO_LkToBr, SE3_LkToBr, \
+                             correctPos, toRef)
+    for (int i = 0; i < frameCount; ++i) {
+        try {
+            if (auto undistFrame = UndistortFrame(data.at(i), TO_LkToBr, SE3_LkToBr, correctPos,
+                                                  toRef)) {
+                undistFrames.at(i) = *undistFrame;
+            }
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
         }
+        bar->Step();
     }
-    bar->finish();
-    return lidarUndistFrames;
+    bar->Finish();
+
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+    return undistFrames;
 }
 
-std::optional<LiDARFrame::Ptr> ScanUndistortion::UndistortToScan(const LiDARFrame::Ptr &lidarFrame,
-                                                                 const std::string &topic,
-                                                                 bool correctPos) {
-    double scanTimeByBr = lidarFrame->GetTimestamp() + _parMagr->TEMPORAL.TO_LkToBr.at(topic);
+std::optional<LiDARFrame::Ptr> ScanUndistortion::UndistortFrame(const LiDARFrame::Ptr &lidarFrame,
+                                                                double TO_LkToBr,
+                                                                const Sophus::SE3d &SE3_LkToBr,
+                                                                bool correctPos,
+                                                                bool toRef) const {
+    double scanTimeByBr = lidarFrame->GetTimestamp() + TO_LkToBr;
     // id this time stamp is invalid, return
-    if (!_so3Spline.TimeStampInRange(scanTimeByBr) || !_posSpline.TimeStampInRange(scanTimeByBr)) {
+    if (!TimeStampInRange(scanTimeByBr)) {
         return {};
     }
 
-    Sophus::SE3d scanRefIMUToW(_so3Spline.Evaluate(scanTimeByBr),
-                               _posSpline.Evaluate(scanTimeByBr));
-    auto scanToRef = scanRefIMUToW * _parMagr->EXTRI.SE3_LkToBr(topic);
-
-    Sophus::SE3d refToScan = scanToRef.inverse();
+    // points are transformed to the world frame (to ref), or to the lidar frame at scan time
+    Sophus::SE3d targetFromW;
+    if (!toRef) {
+        Sophus::SE3d scanRefIMUToW(_so3Spline.Evaluate(scanTimeByBr),
+                                   _posSpline.Evaluate(scanTimeByBr));
+        targetFromW = (scanRefIMUToW * SE3_LkToBr).inverse();
+    }
 
     // prepare
     IKalibrPointCloud::Ptr undistScan(new IKalibrPointCloud);
@@ -103,6 +147,27 @@ std::optional<LiDARFrame::Ptr> ScanUndistortion::UndistortToScan(const LiDARFram
     undistScan->resize(rawScan->height * rawScan->width);
     undistScan->is_dense = rawScan->is_dense;
 
+    /**
+     * points of a ring are sorted in time, and points of different rings are fired together, thus
+     * the number of distinct point times is much smaller than the number of points. The spline
+     * is evaluated only once for each distinct time (or sampled and interpolated, see
+     * 'LiDARPosesAtTimes'), and poses of points are obtained by looking up
+     */
+    std::vector<double> timesByBr;
+    timesByBr.reserve(rawScan->size());
+    for (const auto &rawPoint : rawScan->points) {
+        if (IS_POS_NAN(rawPoint)) {
+            continue;
+        }
+        double pTimeByBr = rawPoint.timestamp + TO_LkToBr;
+        if (TimeStampInRange(pTimeByBr)) {
+            timesByBr.push_back(pTimeByBr);
+        }
+    }
+    std::sort(timesByBr.begin(), timesByBr.end());
+    timesByBr.erase(std::unique(timesByBr.begin(), timesByBr.end()), timesByBr.end());
+    const auto posesToW = LiDARPosesAtTimes(timesByBr, SE3_LkToBr);
+
     for (int h = 0; h < static_cast<int>(rawScan->height); h++) {
         for (int w = 0; w < static_cast<int>(rawScan->width); w++) {
             const auto &rawPoint = rawScan->points[h * rawScan->width + w];
@@ -111,21 +176,18 @@ std::optional<LiDARFrame::Ptr> ScanUndistortion::UndistortToScan(const LiDARFram
             if (IS_POS_NAN(rawPoint)) {
                 SET_POS_NAN(undistPoint)
             } else {
-                double pTimeByBr = rawPoint.timestamp + _parMagr->TEMPORAL.TO_LkToBr.at(topic);
-
-                if (_so3Spline.TimeStampInRange(pTimeByBr) &&
-                    _posSpline.TimeStampInRange(pTimeByBr)) {
-                    Sophus::SE3d pRefIMUToW(_so3Spline.Evaluate(pTimeByBr),
-                                            _posSpline.Evaluate(pTimeByBr));
-                    auto pointToRef = pRefIMUToW * _parMagr->EXTRI.SE3_LkToBr(topic);
+                double pTimeByBr = rawPoint.timestamp + TO_LkToBr;
 
-                    Sophus::SE3d pointToScan = refToScan * pointToRef;
+                if (TimeStampInRange(pTimeByBr)) {
+                    auto iter = std::lower_bound(timesByBr.cbegin(), timesByBr.cend(), pTimeByBr);
+                    const auto &pointToW = posesToW.at(std::distance(timesByBr.cbegin(), iter));
 
                     Eigen::Vector3d rp(rawPoint.x, rawPoint.y, rawPoint.z), up;
-                    if (correctPos) {
-                        up = pointToScan * rp;
+                    if (toRef) {
+                        up = correctPos ? pointToW * rp : pointToW.so3() * rp;
                     } else {
-                        up = pointToScan.so3() * rp;
+                        Sophus::SE3d pointToScan = targetFromW * pointToW;
+                        up = correctPos ? pointToScan * rp : pointToScan.so3() * rp;
                     }
 
                     undistPoint.x = static_cast<float>(up(0));
@@ -147,85 +209,50 @@ std::optional<LiDARFrame::Ptr> ScanUndistortion::UndistortToScan(const LiDARFram
     return LiDARFrame::Create(lidarFrame->GetTimestamp(), undistScan);
 }
 
-// --------------
-// UndistortToRef
-// --------------
-
-std::vector<LiDARFrame::Ptr> ScanUndistortion::UndistortToRef(
-    const std::vector<LiDARFrame::Ptr> &data, const std::string &topic, Option option) {
-    std::vector<LiDARFrame::Ptr> lidarUndistFramesInRef;
+std::vector<Sophus::SE3d> ScanUndistortion::LiDARPosesAtTimes(
+    const std::vector<double> &timesByBr, const Sophus::SE3d &SE3_LkToBr) const {
+    std::vector<Sophus::SE3d> posesToW(timesByBr.size());
+    if (timesByBr.empty()) {
+        return posesToW;
+    }
+    auto PoseAt = [this, &SE3_LkToBr](double timeByBr) {
+        return Sophus::SE3d(_so3Spline.Evaluate(timeByBr), _posSpline.Evaluate(timeByBr)) *
+               SE3_LkToBr;
+    };
 
-    auto bar = std::make_shared<tqdm>();
-    bool correctPos = IsOptionWith(Option::UNDIST_POS, option);
-    for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-        bar->progress(i, static_cast<int>(data.size()));
+    const double interval = Configor::Preference::UndistortionSampleInterval;
+    const double st = timesByBr.front(), et = timesByBr.back();
+    const int sampleCount = interval > 0.0 ? static_cast<int>(std::ceil((et - st) / interval)) : 0;
 
-        if (auto undistLidarFrame = UndistortToRef(data.at(i), topic, correctPos)) {
-            lidarUndistFramesInRef.push_back(*undistLidarFrame);
-        } else {
-            lidarUndistFramesInRef.push_back(nullptr);
+    if (sampleCount < 2 || sampleCount >= static_cast<int>(timesByBr.size())) {
+        // evaluate the spline for each time exactly, as sampling saves nothing
+        for (int i = 0; i < static_cast<int>(timesByBr.size()); ++i) {
+            posesToW.at(i) = PoseAt(timesByBr.at(i));
         }
+        return posesToW;
     }
-    bar->finish();
-    return lidarUndistFramesInRef;
-}
 
-std::optional<LiDARFrame::Ptr> ScanUndistortion::UndistortToRef(const LiDARFrame::Ptr &lidarFrame,
-                                                                const std::string &topic,
-                                                                bool correctPos) {
-    double scanTimeByBr = lidarFrame->GetTimestamp() + _parMagr->TEMPORAL.TO_LkToBr.at(topic);
-    if (!_so3Spline.TimeStampInRange(scanTimeByBr) || !_posSpline.TimeStampInRange(scanTimeByBr)) {
-        return {};
+    // sample poses at [st, st + interval, ..., et], the last one is clamped to the end time
+    std::vector<Sophus::SE3d> samples(sampleCount + 1);
+    std::vector<Sophus::SE3d::Tangent> deltas(sampleCount);
+    for (int k = 0; k <= sampleCount; ++k) {
+        samples.at(k) = PoseAt(std::min(st + k * interval, et));
     }
-    // prepare
-    IKalibrPointCloud::Ptr undistScan(new IKalibrPointCloud);
-    auto rawScan = lidarFrame->GetScan();
-    // assign
-    undistScan->header = rawScan->header;
-    undistScan->height = rawScan->height;
-    undistScan->width = rawScan->width;
-    undistScan->resize(rawScan->height * rawScan->width);
-    undistScan->is_dense = rawScan->is_dense;
-
-    for (int h = 0; h < static_cast<int>(rawScan->height); h++) {
-        for (int w = 0; w < static_cast<int>(rawScan->width); w++) {
-            const auto &rawPoint = rawScan->points[h * rawScan->width + w];
-            IKalibrPoint undistPoint;
-
-            if (IS_POS_NAN(rawPoint)) {
-                SET_POS_NAN(undistPoint)
-            } else {
-                double pTimeByBr = rawPoint.timestamp + _parMagr->TEMPORAL.TO_LkToBr.at(topic);
-
-                if (_so3Spline.TimeStampInRange(pTimeByBr) &&
-                    _posSpline.TimeStampInRange(pTimeByBr)) {
-                    Sophus::SE3d pBrToW(_so3Spline.Evaluate(pTimeByBr),
-                                        _posSpline.Evaluate(pTimeByBr));
-                    auto pointToW = pBrToW * _parMagr->EXTRI.SE3_LkToBr(topic);
-
-                    Eigen::Vector3d rp(rawPoint.x, rawPoint.y, rawPoint.z), up;
-                    if (correctPos) {
-                        up = pointToW * rp;
-                    } else {
-                        up = pointToW.so3() * rp;
-                    }
-
-                    undistPoint.x = static_cast<float>(up(0));
-                    undistPoint.y = static_cast<float>(up(1));
-                    undistPoint.z = static_cast<float>(up(2));
-                    undistPoint.timestamp = rawPoint.timestamp;
-                    // attention: use 'PointXYZT' as 'IKalibrPoint' rather than 'PointXYZIT' here
-                    // undistPoint.intensity = rawPoint.intensity;
-                } else {
-                    // we can't undistort it (no condition)
-                    SET_POS_NAN(undistPoint)
-                }
-            }
-            // undistScan->at(w, h) = undistPoint;
-            undistScan->points[h * rawScan->width + w] = undistPoint;
-        }
+    for (int k = 0; k < sampleCount; ++k) {
+        deltas.at(k) = (samples.at(k).inverse() * samples.at(k + 1)).log();
+    }
+    // interpolate on SE3 between the two neighbor samples
+    for (int i = 0; i < static_cast<int>(timesByBr.size()); ++i) {
+        const double t = timesByBr.at(i);
+        int k = std::min(static_cast<int>((t - st) / interval), sampleCount - 1);
+        double sk = st + k * interval, ek = std::min(sk + interval, et);
+        double alpha = std::clamp((t - sk) / (ek - sk), 0.0, 1.0);
+        posesToW.at(i) = samples.at(k) * Sophus::SE3d::exp(alpha * deltas.at(k));
     }
+    return posesToW;
+}
 
-    return LiDARFrame::Create(lidarFrame->GetTimestamp(), undistScan);
+bool ScanUndistortion::TimeStampInRange(double timeByBr) const {
+    return _so3Spline.TimeStampInRange(timeByBr) && _posSpline.TimeStampInRange(timeByBr);
 }
-}  // namespace ns_ikalibr
\ No newline at end of file
+}  // namespace ns_ikalibr
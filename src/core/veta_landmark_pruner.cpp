@@ -0,0 +1,181 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "core/veta_landmark_pruner.h"
+#include "veta/veta.h"
+#include "spdlog/spdlog.h"
+#include "numeric"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+VetaLandmarkPruner::VetaLandmarkPruner(std::size_t budget,
+                                       int gridSize,
+                                       double maxReprojError,
+                                       double minTriangAngleDeg)
+    : _budget(budget),
+      _gridSize(std::max(gridSize, 1)),
+      _maxReprojError(maxReprojError),
+      _minTriangAngle(minTriangAngleDeg * M_PI / 180.0) {}
+
+VetaLandmarkPruner::Ptr VetaLandmarkPruner::Create(std::size_t budget,
+                                                   int gridSize,
+                                                   double maxReprojError,
+                                                   double minTriangAngleDeg) {
+    return std::make_shared<VetaLandmarkPruner>(budget, gridSize, maxReprojError,
+                                                minTriangAngleDeg);
+}
+
+std::vector<VetaLandmarkPruner::LandmarkQuality> VetaLandmarkPruner::EvaluateQualities(
+    const ns_veta::Veta &veta, const ns_veta::PinholeIntrinsic::Ptr &intri) const {
+    std::vector<decltype(veta.structure.cbegin())> lmIters;
+    lmIters.reserve(veta.structure.size());
+    for (auto iter = veta.structure.cbegin(); iter != veta.structure.cend(); ++iter) {
+        lmIters.push_back(iter);
+    }
+    const int lmCount = static_cast<int>(lmIters.size());
+    const double cellWidth = static_cast<double>(intri->imgWidth) / _gridSize;
+    const double cellHeight = static_cast<double>(intri->imgHeight) / _gridSize;
+
+    std::vector<LandmarkQuality> qualities(lmCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(lmCount, lmIters, qualities, veta, intri, cellWidth, cellHeight)
+    for (int i = 0; i < lmCount; ++i) {
+        const auto &lm = lmIters.at(i)->second;
+        auto &quality = qualities.at(i);
+        quality.trackLength = lm.obs.size();
+        quality.triangAngle = 0.0;
+        quality.reprojError = 0.0;
+        quality.cell = -1;
+        quality.score = 0.0;
+
+        // the ray from the first camera to the landmark, to which others are compared
+        std::optional<Eigen::Vector3d> firRay;
+        bool behind = false;
+        for (const auto &[viewId, obv] : lm.obs) {
+            const auto &pose = veta.poses.at(veta.views.at(viewId)->poseId);
+            const Eigen::Vector3d lmInC = pose.Inverse()(lm.X);
+            if (lmInC(2) <= 0.0) {
+                behind = true;
+                break;
+            }
+            const Eigen::Vector2d pred =
+                intri->CamToImg({lmInC(0) / lmInC(2), lmInC(1) / lmInC(2)});
+            quality.reprojError += (pred - obv.x).norm();
+
+            const Eigen::Vector3d ray = (lm.X - pose.Translation()).normalized();
+            if (firRay == std::nullopt) {
+                firRay = ray;
+                quality.cell = std::min(static_cast<int>(obv.x(1) / cellHeight), _gridSize - 1) *
+                                   _gridSize +
+                               std::min(static_cast<int>(obv.x(0) / cellWidth), _gridSize - 1);
+            } else {
+                const double cosAngle = std::clamp(firRay->dot(ray), -1.0, 1.0);
+                quality.triangAngle = std::max(quality.triangAngle, std::acos(cosAngle));
+            }
+        }
+        quality.reprojError /= static_cast<double>(std::max<std::size_t>(lm.obs.size(), 1));
+
+        // rejected landmarks
+        if (behind || quality.cell < 0 || quality.reprojError > _maxReprojError ||
+            quality.triangAngle < _minTriangAngle) {
+            quality.cell = -1;
+            continue;
+        }
+        /**
+         * long tracks constrain the time-varying poses more, the triangulation angle saturates
+         * at ten times the min one (well-conditioned depth), and large errors are penalized
+         */
+        const double angleTerm = std::min(quality.triangAngle / (10.0 * _minTriangAngle), 1.0);
+        quality.score = static_cast<double>(quality.trackLength) * angleTerm /
+                        (1.0 + quality.reprojError);
+    }
+    return qualities;
+}
+
+ns_veta::Veta::Ptr VetaLandmarkPruner::Prune(const ns_veta::Veta::Ptr &veta,
+                                            const ns_veta::PinholeIntrinsic::Ptr &intri) const {
+    const auto qualities = EvaluateQualities(*veta, intri);
+
+    // landmarks (indices in the structure) in each cell, ranked by their scores
+    std::vector<std::vector<int>> cells(_gridSize * _gridSize);
+    std::size_t validCount = 0;
+    for (int i = 0; i < static_cast<int>(qualities.size()); ++i) {
+        if (qualities.at(i).cell >= 0) {
+            cells.at(qualities.at(i).cell).push_back(i);
+            ++validCount;
+        }
+    }
+    if (validCount == qualities.size() && (_budget == 0 || validCount <= _budget)) {
+        return veta;
+    }
+    for (auto &cell : cells) {
+        std::sort(cell.begin(), cell.end(), [&qualities](int l, int r) {
+            return qualities.at(l).score > qualities.at(r).score;
+        });
+    }
+
+    // the best remaining landmark of each cell is taken in turns, which spreads the kept ones
+    const std::size_t budget = _budget == 0 ? validCount : std::min(_budget, validCount);
+    std::vector<bool> kept(qualities.size(), false);
+    std::size_t keptCount = 0;
+    for (std::size_t round = 0; keptCount < budget; ++round) {
+        for (const auto &cell : cells) {
+            if (round < cell.size() && keptCount < budget) {
+                kept.at(cell.at(round)) = true;
+                ++keptCount;
+            }
+        }
+    }
+
+    auto pruned = ns_veta::Veta::Create();
+    pruned->intrinsics = veta->intrinsics;
+    pruned->views = veta->views;
+    pruned->poses = veta->poses;
+    auto iter = veta->structure.cbegin();
+    for (std::size_t i = 0; i < kept.size(); ++i, ++iter) {
+        if (kept.at(i)) {
+            pruned->structure.insert(pruned->structure.cend(), *iter);
+        }
+    }
+    spdlog::info(
+        "landmarks pruned from '{}' to '{}', where '{}' ones are rejected by errors, triangulation "
+        "angles, or cheirality",
+        qualities.size(), pruned->structure.size(), qualities.size() - validCount);
+    return pruned;
+}
+}  // namespace ns_ikalibr
@@ -35,10 +35,12 @@
 #include "core/vision_only_sfm.h"
 #include "util/status.hpp"
 #include "util/utils_tpl.hpp"
+#include "util/progress.h"
 
 #include "calib/calib_param_manager.h"
 #include "calib/estimator.h"
 #include "sensor/camera.h"
+#include "core/feature_tracking.h"
 #include "viewer/viewer.h"
 
 #include "tiny-viewer/entity/cube.h"
@@ -46,6 +48,10 @@
 
 #include "boost/geometry.hpp"
 
+#include "pcl/kdtree/kdtree_flann.h"
+#include "omp.h"
+#include "atomic"
+
 #include "opencv2/highgui.hpp"
 #include "opencv2/imgproc.hpp"
 #include "opencv2/features2d.hpp"
@@ -122,18 +128,19 @@ bool VisionOnlySfM::PreProcess() {
     // ------------------
     spdlog::info("start extracting features for each image, this would cost some time...");
     std::map<ns_veta::IndexT, FeaturePack> featMap;
-#pragma omp parallel for num_threads(omp_get_max_threads()) default(none) shared(featMap, _intri)
+    const auto undistoLUT = VisualUndistortionLUT::Obtain(_intri);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(featMap, undistoLUT)
     for (int i = 0; i < static_cast<int>(_frames.size()); ++i) {
-        // use detector to detect features
-        std::vector<cv::KeyPoint> kps;
-        cv::Mat descriptor;
-        cv::AKAZE::create()->detectAndCompute(_frames.at(i)->GetImage(), cv::noArray(), kps,
-                                              descriptor);
+        // use detector to detect features, which are shared with the AKAZE feature tracking
+        const auto keyPoints = AKAZEFeatureTracking::DetectKeyPoints(_frames.at(i));
+        const auto &kps = keyPoints->kps;
+        const auto &descriptor = keyPoints->descriptor;
         std::vector<ns_veta::IndexT> index(kps.size());
         std::vector<ns_veta::Vec2d> kpsUndisto(kps.size());
         for (int j = 0; j < static_cast<int>(kpsUndisto.size()); ++j) {
             const auto &kp = kps.at(j).pt;
-            kpsUndisto.at(j) = _intri->GetUndistoPixel(ns_veta::Vec2d(kp.x, kp.y));
+            kpsUndisto.at(j) = undistoLUT->RemoveDistortion(ns_veta::Vec2d(kp.x, kp.y));
             index.at(j) = j;
         }
 #pragma omp critical
@@ -145,28 +152,46 @@ bool VisionOnlySfM::PreProcess() {
     // feature matching
     // ----------------
     spdlog::info("start matching exhaustive features, this would cost some time...");
-    std::set<IndexPair> hasDone;
-    for (int j = 0; j < static_cast<int>(_frames.size()); ++j) {
-        const auto &refFrame = _frames.at(j);
-        auto covFrames = FindCovisibility(refFrame, hasDone);
-        // spdlog::info("covisibility view count of refFrame '{}': '{}'", refFrame->GetId(),
-        // covFrames.size());
-
-        const ns_veta::IndexT &refId = refFrame->GetId();
-        const auto &refFeat = featMap.at(refId);
-
-        for (const auto &[schFrame, intersection] : covFrames) {
+    /**
+     * covisible pairs are independent of each other in matching and outlier rejection, they are
+     * performed in parallel, and then merged in the order of pairs (the reference frame, and then
+     * the id of the other one), thus results do not depend on the thread count
+     */
+    std::vector<std::tuple<CameraFrame::Ptr, CameraFrame::Ptr, PolyPair>> covPairs;
+    {
+        const auto covFramesMap = FindCovisibleFrames(0.2);
+        for (const auto &refFrame : _frames) {
+            auto covIter = covFramesMap.find(refFrame->GetId());
+            if (covIter == covFramesMap.cend()) {
+                continue;
+            }
+            const std::size_t curCount = covPairs.size();
+            for (const auto &[schFrame, intersection] : covIter->second) {
+                covPairs.emplace_back(refFrame, schFrame, intersection);
+            }
+            // the map is keyed by pointers, sort for a deterministic order
+            std::sort(covPairs.begin() + static_cast<long>(curCount), covPairs.end(),
+                      [](const auto &p1, const auto &p2) {
+                          return std::get<1>(p1)->GetId() < std::get<1>(p2)->GetId();
+                      });
+        }
+    }
+    const int pairCount = static_cast<int>(covPairs.size());
+    std::vector<std::optional<SfMFeaturePairInfo>> pairInfos(pairCount);
+    std::vector<std::exception_ptr> exceptions(pairCount, nullptr);
+    auto bar = ProgressStage::Create("match features", pairCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(pairCount, covPairs, featMap, pairInfos, exceptions, bar)
+    for (int p = 0; p < pairCount; ++p) {
+        try {
+            const auto &[refFrame, schFrame, intersection] = covPairs.at(p);
+            const ns_veta::IndexT &refId = refFrame->GetId();
             const ns_veta::IndexT &schId = schFrame->GetId();
-
-            spdlog::info("performing feature matching between frames '{}'-'{}'...", refId, schId);
-
-            // record match info
-            hasDone.insert({schId, refId});
-            hasDone.insert({refId, schId});
+            const auto &refFeat = featMap.at(refId);
+            const auto &schFeat = featMap.at(schId);
 
             // extract in-broder key points
             const auto &[polySchInRef, polyRefInSch] = intersection;
-            const auto &schFeat = featMap.at(schId);
             auto refFeatInBorder = FindInBorderOnes(refFeat, polySchInRef);
             auto schFeatInBorder = FindInBorderOnes(schFeat, polyRefInSch);
 
@@ -176,79 +201,42 @@ bool VisionOnlySfM::PreProcess() {
             // outlier rejection
             const auto &inlierIdx = RejectOutliers(refMatched, schMatched, _intri);
 
-            // ransac failed
-            if (inlierIdx.empty()) {
-                std::cout << "\033[1A";
-                // spdlog::warn("feature matching failed for co-visible frame '{}' and '{}'", refId,
-                // schId);
-                continue;
-            }
-
-            SfMFeaturePairVec featPairVec(inlierIdx.size());
-            for (int i = 0; i < static_cast<int>(inlierIdx.size()); ++i) {
-                const int idx = inlierIdx.at(i);
-                auto &featPair = featPairVec.at(i);
-                featPair.first = refMatched.at(idx);
-                featPair.second = schMatched.at(idx);
-            }
-
-            _matchRes.insert(
-                {IndexPair(refId, schId), {refId, schId, featPairVec, polySchInRef, polyRefInSch}});
-            _viewFeatLM.insert({refId, {}});
-            _viewFeatLM.insert({schId, {}});
-
-            std::cout << "\033[1A";
-#define VISUALIZATION 0
-#if VISUALIZATION
-            const cv::Scalar red = cv::Scalar(0, 0, 255);
-            const cv::Scalar green = cv::Scalar(0, 255, 0);
-            auto covImg1 =
-                DrawInBorderFeatMatch(refFrame->GetImage(), polySchInRef, refFeat, refFeatInBorder);
-            auto covImg2 =
-                DrawInBorderFeatMatch(schFrame->GetImage(), polyRefInSch, schFeat, schFeatInBorder);
-
-            cv::Mat covImg;
-            cv::hconcat(covImg1, covImg2, covImg);
-
-            assert(refMatched.size() == schMatched.size());
-            spdlog::info(" match rate: {}/{}", refMatched.size(),
-                         std::get<0>(refFeatInBorder).size());
-            spdlog::info("inlier rate: {}/{}", inlierIdx.size(), refMatched.size());
-
-            auto bias = cv::Point2f((float)refFrame->GetImage().cols, 0.0f);
-            for (int i = 0; i < static_cast<int>(refMatched.size()); ++i) {
-                const auto &pt1 = refMatched.at(i).kp, pt2 = schMatched.at(i).kp + bias;
-                cv::line(covImg, pt1, pt2, red, 1);
-            }
-            for (const auto &i : inlierIdx) {
-                const auto &pt1 = refMatched.at(i).kp, pt2 = schMatched.at(i).kp + bias;
-                cv::drawMarker(covImg, pt1, green, cv::MarkerTypes::MARKER_SQUARE, 10, 1);
-                cv::drawMarker(covImg, pt1, green, cv::MarkerTypes::MARKER_SQUARE, 2, 2);
-                cv::drawMarker(covImg, pt2, green, cv::MarkerTypes::MARKER_SQUARE, 10, 1);
-                cv::drawMarker(covImg, pt2, green, cv::MarkerTypes::MARKER_SQUARE, 2, 2);
-                cv::line(covImg, pt1, pt2, green, 1);
+            // ransac succeeded
+            if (!inlierIdx.empty()) {
+                SfMFeaturePairVec featPairVec(inlierIdx.size());
+                for (int i = 0; i < static_cast<int>(inlierIdx.size()); ++i) {
+                    const int idx = inlierIdx.at(i);
+                    auto &featPair = featPairVec.at(i);
+                    featPair.first = refMatched.at(idx);
+                    featPair.second = schMatched.at(idx);
+                }
+                pairInfos.at(p).emplace(refId, schId, featPairVec, polySchInRef, polyRefInSch);
             }
+        } catch (...) {
+            exceptions.at(p) = std::current_exception();
+        }
+        bar->Step();
+    }
+    bar->Finish();
 
-            cv::imshow("Covisibility", covImg);
-            // static int count = 0;
-            // cv::imwrite(
-            //         Configor::DataStream::DebugPath + "/covisibility" + std::to_string(++count) +
-            //         ".png", covImg
-            // );
-            cv::waitKey(0);
-#endif
-#undef VISUALIZATION
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
         }
+    }
 
-        if (j % 10 == 0) {
-            _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION)
-                .AddEntityLocal(_viewCubes, Viewer::VIEW_ASSOCIATION);
-            DrawMatchesInViewer(ns_viewer::Colour::Red());
+    // merge matches
+    for (auto &pairInfo : pairInfos) {
+        if (pairInfo == std::nullopt) {
+            continue;
         }
+        const auto [refId, schId] = pairInfo->viewId;
+        _matchRes.insert({IndexPair(refId, schId), std::move(*pairInfo)});
+        _viewFeatLM.insert({refId, {}});
+        _viewFeatLM.insert({schId, {}});
     }
-    std::cout << std::endl;
     spdlog::info("feature matching finished.");
-    hasDone.clear();
     featMap.clear();
     _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION)
         .AddEntityLocal(_viewCubes, Viewer::VIEW_ASSOCIATION);
@@ -271,14 +259,22 @@ bool VisionOnlySfM::StructureFromMotion() {
     // ---------------------
     spdlog::info(
         "initialize structure using the frame pair with enough covisibility and parallax...");
+    if (_matchRes.empty()) {
+        spdlog::warn("no matched frame pair exists, structure from motion can not be performed!");
+        return false;
+    }
     auto initViewIdxPair = InitStructure();
+    if (initViewIdxPair.first == ns_veta::UndefinedIndexT) {
+        return false;
+    }
     _viewer->AddVeta(_veta, Viewer::VIEW_MAP);
-    cv::Mat img = DrawMatchResult(initViewIdxPair);
-    cv::imshow("img", img);
-    cv::waitKey(0);
 
     spdlog::info("performing incremental structure from motion...");
     IncrementalSfM(initViewIdxPair);
+
+    spdlog::info("performing final batch optimization for structure from motion...");
+    BatchOptimization();
+    _viewer->ClearViewer(Viewer::VIEW_MAP).AddVeta(_veta, Viewer::VIEW_MAP);
     return true;
 }
 
@@ -299,47 +295,103 @@ std::optional<ns_veta::Posed> VisionOnlySfM::ComputeCamRotations(const CameraFra
 // VisionOnlySfM: feature matching
 // -------------------------------
 
-std::map<CameraFrame::Ptr, std::pair<polygon_2d, polygon_2d>> VisionOnlySfM::FindCovisibility(
-    const CameraFrame::Ptr &refFrame, const std::set<IndexPair> &ignore, double covThd) {
-    const auto &view = _veta->views.at(refFrame->GetId());
-    const double area = (double)view->imgHeight * (double)view->imgWidth;
-    const auto &refSo3 = _veta->poses.at(view->poseId).Rotation();
-    const auto &refSo3Inv = refSo3.inverse();
-
-    std::map<CameraFrame::Ptr, std::pair<polygon_2d, polygon_2d>> covFrames;
-    for (const auto &schFrame : _frames) {
-        // same frame
-        if (schFrame == refFrame) {
-            continue;
+std::map<ns_veta::IndexT, std::map<CameraFrame::Ptr, PolyPair>>
+VisionOnlySfM::FindCovisibleFrames(double covThd) {
+    // frames with rough rotations
+    std::vector<CameraFrame::Ptr> frames;
+    for (const auto &frame : _frames) {
+        if (_veta->views.find(frame->GetId()) != _veta->views.cend()) {
+            frames.push_back(frame);
         }
+    }
+    const int size = static_cast<int>(frames.size());
+    if (size == 0) {
+        return {};
+    }
+    const double area = (double)_intri->imgHeight * (double)_intri->imgWidth;
 
-        // has been performed
-        if (ignore.find({refFrame->GetId(), schFrame->GetId()}) != ignore.cend()) {
-            continue;
-        }
-        if (ignore.find({schFrame->GetId(), refFrame->GetId()}) != ignore.cend()) {
-            continue;
-        }
+    // rotations and viewing directions (the z axis) of frames in the world frame
+    std::vector<Sophus::SO3d> rotations(size);
+    pcl::PointCloud<pcl::PointXYZ>::Ptr directions(new pcl::PointCloud<pcl::PointXYZ>);
+    directions->resize(size);
+    for (int i = 0; i < size; ++i) {
+        const auto &view = _veta->views.at(frames.at(i)->GetId());
+        rotations.at(i) = _veta->poses.at(view->poseId).Rotation();
+        Eigen::Vector3d dir = rotations.at(i) * Eigen::Vector3d::UnitZ();
+        directions->at(i) = pcl::PointXYZ(static_cast<float>(dir(0)), static_cast<float>(dir(1)),
+                                          static_cast<float>(dir(2)));
+    }
 
-        const auto &schSo3 = _veta->poses.at(_veta->views.at(schFrame->GetId())->poseId).Rotation();
-        auto intersection =
-            IntersectionArea(refFrame->GetImage(), schFrame->GetImage(), refSo3Inv * schSo3);
-        if (!intersection) {
-            continue;
-        }
+    /**
+     * each image covers a cone around its viewing direction, whose half angle is the one of the
+     * farthest image corner. Two frames are possibly covisible only if the angle between their
+     * viewing directions is less than twice the half angle, i.e., the chord distance of their
+     * directions is less than '2 * sin(halfAngle)'
+     */
+    double halfAngle = 0.0;
+    for (const auto &corner : {ns_veta::Vec2d(0.0, 0.0), ns_veta::Vec2d(_intri->imgWidth, 0.0),
+                               ns_veta::Vec2d(0.0, _intri->imgHeight),
+                               ns_veta::Vec2d(_intri->imgWidth, _intri->imgHeight)}) {
+        halfAngle = std::max(halfAngle, std::atan(_intri->ImgToCam(corner).norm()));
+    }
+    // all frames are candidates if the cone covers the hemisphere
+    const float radius = halfAngle < M_PI_2 ? static_cast<float>(2.0 * std::sin(halfAngle)) : 2.1f;
+    pcl::KdTreeFLANN<pcl::PointXYZ> kdtree;
+    kdtree.setInputCloud(directions);
+
+    std::vector<std::map<CameraFrame::Ptr, PolyPair>> covFramesVec(size);
+    std::vector<std::exception_ptr> exceptions(size, nullptr);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(size, frames, rotations, directions, radius, kdtree, covFramesVec, area, \
+                             covThd, exceptions)
+    for (int i = 0; i < size; ++i) {
+        try {
+            std::vector<int> indices;
+            std::vector<float> sqDists;
+            kdtree.radiusSearch(directions->at(i), radius, indices, sqDists);
+
+            const auto &refFrame = frames.at(i);
+            const auto refSo3Inv = rotations.at(i).inverse();
+            for (int k : indices) {
+                // the pair is tested in the reference frame before the other one
+                if (k <= i) {
+                    continue;
+                }
+                const auto &schFrame = frames.at(k);
+                auto intersection = IntersectionArea(refFrame->GetImage(), schFrame->GetImage(),
+                                                     refSo3Inv * rotations.at(k));
+                if (!intersection) {
+                    continue;
+                }
 
-        const auto &[sectSchInRef, sectRefInSch] = *intersection;
+                const auto &[sectSchInRef, sectRefInSch] = *intersection;
 
-        double covRate1 = bg::area(sectSchInRef) / area;
-        double covRate2 = bg::area(sectRefInSch) / area;
-        // spdlog::info("covisibility area between '{}' and '{}': '{:.3f}' | '{:.3f}'",
-        //              refFrame->GetId(), schFrame->GetId(), covRate1, covRate2);
+                double covRate1 = bg::area(sectSchInRef) / area;
+                double covRate2 = bg::area(sectRefInSch) / area;
 
-        if (covRate1 < covThd || covRate2 < covThd) {
-            continue;
+                if (covRate1 < covThd || covRate2 < covThd) {
+                    continue;
+                }
+
+                covFramesVec.at(i).insert({schFrame, *intersection});
+            }
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
         }
+    }
 
-        covFrames.insert({schFrame, *intersection});
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    std::map<ns_veta::IndexT, std::map<CameraFrame::Ptr, PolyPair>> covFrames;
+    for (int i = 0; i < size; ++i) {
+        if (!covFramesVec.at(i).empty()) {
+            covFrames.insert({frames.at(i)->GetId(), std::move(covFramesVec.at(i))});
+        }
     }
     return covFrames;
 }
@@ -512,7 +564,8 @@ std::vector<int> VisionOnlySfM::RejectOutliers(const SfMFeatureVec &feat1,
         // Create a RotationOnlySacProblem and Ransac
         opengv::sac::Ransac<opengv::sac_problems::relative_pose::RotationOnlySacProblem> ransac;
         std::shared_ptr<opengv::sac_problems::relative_pose::RotationOnlySacProblem> probPtr(
-            new opengv::sac_problems::relative_pose::RotationOnlySacProblem(adapter));
+            // the fixed seed makes results reproducible, no matter which thread solves it
+            new opengv::sac_problems::relative_pose::RotationOnlySacProblem(adapter, false));
         ransac.sac_model_ = probPtr;
         ransac.threshold_ = intri->ImagePlaneToCameraPlaneError(1.0);
         ransac.max_iterations_ = 50;
@@ -551,7 +604,7 @@ std::vector<int> VisionOnlySfM::RejectOutliers(const SfMFeatureVec &feat1,
 
         opengv::sac::Ransac<opengv::sac_problems::relative_pose::TranslationOnlySacProblem> ransac;
         std::shared_ptr<opengv::sac_problems::relative_pose::TranslationOnlySacProblem> probPtr(
-            new opengv::sac_problems::relative_pose::TranslationOnlySacProblem(adapter));
+            new opengv::sac_problems::relative_pose::TranslationOnlySacProblem(adapter, false));
         ransac.sac_model_ = probPtr;
         ransac.threshold_ = intri->ImagePlaneToCameraPlaneError(1.0);
         ransac.max_iterations_ = 20;
@@ -771,6 +824,10 @@ IndexPair VisionOnlySfM::InitStructure() {
         }
     }
 
+    if (lmBest.empty()) {
+        spdlog::warn("no frame pair with enough parallax exists to initialize the structure!");
+        return {ns_veta::UndefinedIndexT, ns_veta::UndefinedIndexT};
+    }
     spdlog::info("best image pair: {}-{}, match count: {}", viewPairBest.first, viewPairBest.second,
                  lmBest.size());
 
@@ -1104,6 +1161,54 @@ const std::map<IndexPair, SfMFeaturePairInfo> &VisionOnlySfM::GetMatchRes() cons
     return _matchRes;
 }
 
+ns_veta::Veta::Ptr VisionOnlySfM::ExtractReconstruction(double errorThd,
+                                                        std::size_t trackLenThd) const {
+    if (_veta == nullptr) {
+        return nullptr;
+    }
+    auto veta = ns_veta::Veta::Create();
+    veta->intrinsics = _veta->intrinsics;
+
+    // only views whose poses are recovered are kept
+    for (const auto &[viewId, view] : _veta->views) {
+        auto poseIter = _veta->poses.find(view->poseId);
+        if (poseIter == _veta->poses.cend()) {
+            continue;
+        }
+        veta->views.insert({viewId, view});
+        veta->poses.insert(*poseIter);
+    }
+
+    for (const auto &[lmId, lm] : _veta->structure) {
+        ns_veta::Landmark newLM(lm.X, {});
+        newLM.color = lm.color;
+        double errorSum = 0.0;
+        for (const auto &[viewId, obv] : lm.obs) {
+            auto viewIter = veta->views.find(viewId);
+            if (viewIter == veta->views.cend()) {
+                continue;
+            }
+            const auto &T_CamToW = veta->poses.at(viewIter->second->poseId);
+            Eigen::Vector3d pInCam = T_CamToW.Inverse()(lm.X);
+            if (pInCam(2) < 1E-3) {
+                continue;
+            }
+            ns_veta::Vec2d proj = _intri->CamToImg({pInCam(0) / pInCam(2), pInCam(1) / pInCam(2)});
+            errorSum += (proj - obv.x).norm();
+            newLM.obs.insert({viewId, obv});
+        }
+        // filter bad landmarks
+        if (newLM.obs.size() < std::max<std::size_t>(trackLenThd, 2) ||
+            errorSum / static_cast<double>(newLM.obs.size()) > errorThd) {
+            continue;
+        }
+        veta->structure.insert({lmId, newLM});
+    }
+    spdlog::info("reconstruction of camera '{}': view count: {}, landmark count: {}", _topic,
+                 veta->views.size(), veta->structure.size());
+    return veta;
+}
+
 std::set<IndexPair> VisionOnlySfM::FindCovisibility(double covThd) {
     _veta = ns_veta::Veta::Create();
 
@@ -1138,19 +1243,10 @@ std::set<IndexPair> VisionOnlySfM::FindCovisibility(double covThd) {
     CreateViewCubes();
     _viewer->AddEntity(_viewCubes, Viewer::VIEW_ASSOCIATION);
 
-    std::set<IndexPair> hasDone, covPairs;
-    for (int j = 0; j < static_cast<int>(_frames.size()); ++j) {
-        const auto &refFrame = _frames.at(j);
-        auto covFrames = FindCovisibility(refFrame, hasDone, covThd);
-        // spdlog::info("covisibility view count of refFrame '{}': '{}'", refFrame->GetId(),
-        // covFrames.size());
-        if (j % 10 == 0) {
-            _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION)
-                .AddEntityLocal(_viewCubes, Viewer::VIEW_ASSOCIATION);
-            DrawMatchesInViewer(ns_viewer::Colour::Red());
-        }
+    std::set<IndexPair> covPairs;
+    for (const auto &[refId, covFrames] : FindCovisibleFrames(covThd)) {
         for (const auto &[covFrame, _] : covFrames) {
-            covPairs.insert({refFrame->GetId(), covFrame->GetId()});
+            covPairs.insert({refId, covFrame->GetId()});
         }
     }
     return covPairs;
@@ -29,6 +29,8 @@
 
 #include "core/visual_distortion.h"
 #include "veta/camera/pinhole.h"
+#include "config/configor.h"
+#include "typeinfo"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,6 +56,28 @@ VisualUndistortionMap::Ptr VisualUndistortionMap::Create(
     return std::make_shared<VisualUndistortionMap>(intri);
 }
 
+std::mutex VisualUndistortionMap::CacheMutex;
+std::map<VisualUndistortionMap::CacheKey, VisualUndistortionMap::Ptr> VisualUndistortionMap::Cache;
+
+VisualUndistortionMap::Ptr VisualUndistortionMap::Obtain(
+    const ns_veta::PinholeIntrinsicPtr &intri) {
+    CacheKey key(typeid(*intri).name(), intri->imgWidth, intri->imgHeight, intri->GetParams());
+    {
+        std::lock_guard<std::mutex> lock(CacheMutex);
+        if (auto iter = Cache.find(key); iter != Cache.end()) {
+            return iter->second;
+        }
+    }
+    // the map is built out of the lock, as it would cost some time
+    auto map = Create(intri);
+    std::lock_guard<std::mutex> lock(CacheMutex);
+    if (Cache.size() >= CacheCapacity) {
+        Cache.clear();
+    }
+    Cache[key] = map;
+    return map;
+}
+
 cv::Mat VisualUndistortionMap::RemoveDistortion(const cv::Mat &distoImg, int interpolation) const {
     cv::Mat undistImg;
     cv::remap(distoImg, undistImg, _map1, _map2, interpolation, CV_HAL_BORDER_CONSTANT);
@@ -119,4 +143,67 @@ std::pair<cv::Mat, cv::Mat> VisualUndistortionMap::ObtainKDMatForUndisto(
     return {ObtainKMat(intri), ObtainDMat(intri)};
 }
 
+/**
+ * VisualUndistortionLUT
+ */
+std::mutex VisualUndistortionLUT::TablesMutex;
+std::map<const ns_veta::PinholeIntrinsic *, VisualUndistortionLUT::Ptr>
+    VisualUndistortionLUT::Tables;
+
+VisualUndistortionLUT::VisualUndistortionLUT(const ns_veta::PinholeIntrinsic::Ptr &intri)
+    : _intri(intri),
+      _params(intri->GetParams()),
+      // the last row and column of pixels are covered by the grid
+      _cols(static_cast<int>(intri->imgWidth + GRID_STEP - 1) / GRID_STEP + 1),
+      _rows(static_cast<int>(intri->imgHeight + GRID_STEP - 1) / GRID_STEP + 1),
+      _grid(_cols * _rows) {
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(intri)
+    for (int r = 0; r < _rows; ++r) {
+        for (int c = 0; c < _cols; ++c) {
+            _grid.at(r * _cols + c) = intri->GetUndistoPixel(
+                {static_cast<double>(c * GRID_STEP), static_cast<double>(r * GRID_STEP)});
+        }
+    }
+}
+
+VisualUndistortionLUT::Ptr VisualUndistortionLUT::Obtain(
+    const ns_veta::PinholeIntrinsic::Ptr &intri) {
+    {
+        std::lock_guard<std::mutex> lock(TablesMutex);
+        if (auto iter = Tables.find(intri.get());
+            iter != Tables.end() && iter->second->IsUpToDate()) {
+            return iter->second;
+        }
+    }
+    // the table is built out of the lock, as it would cost some time
+    auto table = std::make_shared<const VisualUndistortionLUT>(intri);
+    std::lock_guard<std::mutex> lock(TablesMutex);
+    // tables whose intrinsics are only held by themselves are expired (e.g., from a finished
+    // calibration in a long-running process), they are erased to bound the memory
+    for (auto iter = Tables.begin(); iter != Tables.end();) {
+        if (iter->second->_intri.use_count() == 1) {
+            iter = Tables.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    Tables[intri.get()] = table;
+    return table;
+}
+
+Eigen::Vector2d VisualUndistortionLUT::RemoveDistortion(const Eigen::Vector2d &p) const {
+    const double x = p(0) / GRID_STEP, y = p(1) / GRID_STEP;
+    const int c = static_cast<int>(std::floor(x)), r = static_cast<int>(std::floor(y));
+    if (c < 0 || r < 0 || c + 1 >= _cols || r + 1 >= _rows) {
+        return _intri->GetUndistoPixel(p);
+    }
+    const double u = x - c, v = y - r;
+    const auto &p00 = _grid[r * _cols + c], &p01 = _grid[r * _cols + c + 1];
+    const auto &p10 = _grid[(r + 1) * _cols + c], &p11 = _grid[(r + 1) * _cols + c + 1];
+    return (1.0 - v) * ((1.0 - u) * p00 + u * p01) + v * ((1.0 - u) * p10 + u * p11);
+}
+
+bool VisualUndistortionLUT::IsUpToDate() const { return _intri->GetParams() == _params; }
+
 }  // namespace ns_ikalibr
@@ -35,6 +35,7 @@
 #include "core/visual_reproj_association.h"
 #include "factor/data_correspondence.h"
 #include "veta/veta.h"
+#include "config/configor.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,10 +55,31 @@ std::vector<VisualReProjCorrSeq::Ptr> VisualReProjAssociator::Association(
     // scale weight from image pixel to real scale
     const double weight = intri->ImagePlaneToCameraPlaneError(1.0);
 
-    std::vector<VisualReProjCorrSeq::Ptr> corrVec;
-    corrVec.reserve(veta.structure.size());
+    /**
+     * correspondences and inverse depths of all landmarks are stored in two contiguous arenas,
+     * rather than allocated one by one, sequences and the estimator point into them directly
+     * (aliasing pointers keep the arenas alive). The offset of each landmark in the arena is
+     * computed first, thus landmarks can be associated in parallel
+     */
+    std::vector<decltype(veta.structure.cbegin())> lmIters;
+    lmIters.reserve(veta.structure.size());
+    std::vector<std::size_t> offsets;
+    offsets.reserve(veta.structure.size());
+    std::size_t corrCount = 0;
+    for (auto iter = veta.structure.cbegin(); iter != veta.structure.cend(); ++iter) {
+        lmIters.push_back(iter);
+        offsets.push_back(corrCount);
+        corrCount += iter->second.obs.size() - 1;
+    }
+    const int lmCount = static_cast<int>(lmIters.size());
+    auto corrArena = std::make_shared<std::vector<VisualReProjCorr>>(corrCount);
+    auto invDepthArena = std::make_shared<std::vector<double>>(lmCount);
 
-    for (const auto &[lmId, lm] : veta.structure) {
+    std::vector<VisualReProjCorrSeq::Ptr> corrVec(lmCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(lmCount, lmIters, offsets, corrArena, invDepthArena, corrVec, veta, intri, weight)
+    for (int i = 0; i < lmCount; ++i) {
+        const auto &[lmId, lm] = *lmIters.at(i);
         auto begIter = lm.obs.cbegin();
         const auto &[viewIdFir, featFir] = *begIter;
         const auto &viewFir = veta.views.find(viewIdFir)->second;
@@ -73,13 +95,15 @@ std::vector<VisualReProjCorrSeq::Ptr> VisualReProjAssociator::Association(
         // landmark
         Eigen::Vector3d lmInFir = veta.poses.at(viewFir->poseId).Inverse().operator()(lm.X);
         // inverse depth
-        corrSeq->invDepthFir = std::make_unique<double>(1.0 / lmInFir(2));
+        invDepthArena->at(i) = 1.0 / lmInFir(2);
+        corrSeq->invDepthFir = std::shared_ptr<double>(invDepthArena, &invDepthArena->at(i));
         corrSeq->lmId = lmId;
         corrSeq->corrs.reserve(lm.obs.size() - 1);
         corrSeq->firObvViewId = viewIdFir;
         corrSeq->firObv = featFir;
 
-        for (auto curIter = std::next(begIter); curIter != lm.obs.cend(); ++curIter) {
+        std::size_t idx = offsets.at(i);
+        for (auto curIter = std::next(begIter); curIter != lm.obs.cend(); ++curIter, ++idx) {
             const auto &[viewIdCur, featCur] = *curIter;
             const auto &viewCur = veta.views.find(viewIdCur)->second;
             // row / image height - ExposureFactor
@@ -88,7 +112,7 @@ std::vector<VisualReProjCorrSeq::Ptr> VisualReProjAssociator::Association(
                 intri->GetDistoPixel(featCur.x)(1) / static_cast<double>(viewCur->imgHeight) -
                 ExposureFactor;
 
-            corrSeq->corrs.push_back(VisualReProjCorr::Create(
+            corrArena->at(idx) = VisualReProjCorr(
                 // timestamps
                 viewFir->timestamp, viewCur->timestamp,
                 // feature location in image plane (has been undistorted)
@@ -96,9 +120,10 @@ std::vector<VisualReProjCorrSeq::Ptr> VisualReProjAssociator::Association(
                 // row / image height - ExposureFactor: v/h - ExposureFactor
                 lFir, lCur,
                 // rough weight
-                weight));
+                weight);
+            corrSeq->corrs.emplace_back(corrArena, &corrArena->at(idx));
         }
-        corrVec.push_back(corrSeq);
+        corrVec.at(i) = corrSeq;
     }
 
     return corrVec;
@@ -95,26 +95,12 @@ std::optional<Eigen::Vector3d> VisualVelocitySacProblem::VisualVelocityEstimatio
     const ns_veta::PinholeIntrinsic::Ptr &intri,
     double timeByBr,
     const VisualVelocityEstimator::So3SplineType &spline,
-    const Sophus::SO3d &SO3_DnToBr) {
-    opengv::sac::Ransac<VisualVelocitySacProblem> ransac;
-    std::shared_ptr<VisualVelocitySacProblem> probPtr(
-        new VisualVelocitySacProblem(dynamics, intri, timeByBr, spline, SO3_DnToBr));
-    ransac.sac_model_ = probPtr;
-    ransac.threshold_ = Configor::Prior::LossForOpticalFlowFactor;
-    ransac.max_iterations_ = 20;
-    bool res = ransac.computeModel();
+    const Sophus::SO3d &SO3_DnToBr,
+    const std::optional<Eigen::Vector3d> &warmStart) {
+    auto res = VisualVelocitySac(dynamics, intri, timeByBr, spline, SO3_DnToBr)
+                   .Estimate(Configor::Prior::LossForOpticalFlowFactor, warmStart);
     if (res) {
-        // spdlog::info("inlier rate: {}/{}", ransac.inliers_.size(), dynamics.size());
-        Eigen::Vector3d vel;
-        probPtr->optimizeModelCoefficients(ransac.inliers_, ransac.model_coefficients_, vel);
-
-        // std::cout << " RANSAC: " << vel.transpose() << std::endl;
-        // std::cout << "LS PROB: "
-        //           << VisualVelocityEstimator::Create(dynamics, intri)
-        //                  ->Estimate(timeByBr, spline, SO3_DnToBr)
-        //                  ->transpose()
-        //           << std::endl;
-        return vel;
+        return res;
     } else {
         spdlog::warn("compute velocity using RANSAC failed, try to use all measurements to fit...");
         auto vvEstimator = VisualVelocityEstimator::Create(dynamics, intri);
@@ -128,7 +114,8 @@ std::optional<Eigen::Vector3d> VisualVelocitySacProblem::VisualVelocityEstimatio
     const ns_veta::PinholeIntrinsic::Ptr &intri,
     double timeByBr,
     const VisualVelocityEstimator::So3SplineType &spline,
-    const Sophus::SO3d &SO3_DnToBr) {
+    const Sophus::SO3d &SO3_DnToBr,
+    const std::optional<Eigen::Vector3d> &warmStart) {
     // dynamics in this frame (pixel, velocity, depth)
     std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> rawDynamicsInFrame(
         corrVec.size());
@@ -136,6 +123,163 @@ std::optional<Eigen::Vector3d> VisualVelocitySacProblem::VisualVelocityEstimatio
         const auto &corr = corrVec.at(i);
         rawDynamicsInFrame.at(i) = {corr->MidPoint(), corr->MidPointVel(readout), corr->depth};
     }
-    return VisualVelocityEstimationRANSAC(rawDynamicsInFrame, intri, timeByBr, spline, SO3_DnToBr);
+    return VisualVelocityEstimationRANSAC(rawDynamicsInFrame, intri, timeByBr, spline, SO3_DnToBr,
+                                          warmStart);
 }
-}  // namespace ns_ikalibr
\ No newline at end of file
+
+// -----------------
+// VisualVelocitySac
+// -----------------
+
+VisualVelocitySac::VisualVelocitySac(
+    const std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> &dynamics,
+    const ns_veta::PinholeIntrinsic::Ptr &intri,
+    double timeByBr,
+    const VisualVelocityEstimator::So3SplineType &spline,
+    const Sophus::SO3d &SO3_DnToBr,
+    unsigned int seed)
+    : _rng(seed) {
+    const double fx = intri->FocalX(), fy = intri->FocalY();
+    const double cx = intri->PrincipalPoint()(0), cy = intri->PrincipalPoint()(1);
+
+    // the angular velocity is shared by all correspondences of this frame
+    Eigen::Vector3d ANG_VEL_BrToWInBr = spline.VelocityBody(timeByBr);
+    Eigen::Vector3d ANG_VEL_DnToWInDn = SO3_DnToBr.inverse() * ANG_VEL_BrToWInBr;
+
+    const auto n = static_cast<Eigen::Index>(dynamics.size());
+    _rows.resize(3, 2 * n);
+    _rhs.resize(2 * n);
+    for (Eigen::Index i = 0; i < n; ++i) {
+        const auto &[pixel, vel, depth] = dynamics.at(i);
+
+        Eigen::Matrix<double, 2, 3> subAMat, subBMat;
+        // the template parameters, i.e., 'Order' and 'TimeDeriv', do not matter here
+        OpticalFlowCorr::SubMats<double>(&fx, &fy, &cx, &cy, pixel, &subAMat, &subBMat);
+
+        _rows.middleCols<2>(2 * i) = (1 / depth * subAMat).transpose();
+        _rhs.segment<2>(2 * i) = vel - subBMat * ANG_VEL_DnToWInDn;
+    }
+}
+
+VisualVelocitySac::Ptr VisualVelocitySac::Create(
+    const std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> &dynamics,
+    const ns_veta::PinholeIntrinsic::Ptr &intri,
+    double timeByBr,
+    const VisualVelocityEstimator::So3SplineType &spline,
+    const Sophus::SO3d &SO3_DnToBr,
+    unsigned int seed) {
+    return std::make_shared<VisualVelocitySac>(dynamics, intri, timeByBr, spline, SO3_DnToBr,
+                                               seed);
+}
+
+int VisualVelocitySac::GetCorrCount() const { return static_cast<int>(_rhs.size() / 2); }
+
+std::optional<Eigen::Vector3d> VisualVelocitySac::Estimate(
+    double threshold,
+    const std::optional<Eigen::Vector3d> &warmStart,
+    int maxIterations,
+    double probability) {
+    const int n = GetCorrCount();
+    if (n < 2) {
+        return {};
+    }
+    std::uniform_int_distribution<int> dist(0, n - 1);
+
+    Eigen::Vector3d bestModel;
+    int bestCount = -1;
+    // the required iteration count, which is updated by the inlier ratio of the best model
+    double requiredIterations = maxIterations;
+    auto updateBest = [&](const Eigen::Vector3d &model) {
+        const int count = CountInliers(model, threshold, bestCount);
+        if (count <= bestCount) {
+            return false;
+        }
+        bestCount = count;
+        bestModel = model;
+
+        const double inlierRatio = static_cast<double>(count) / n;
+        const double noOutlierProb = 1.0 - inlierRatio * inlierRatio;
+        if (noOutlierProb < std::numeric_limits<double>::epsilon()) {
+            // all correspondences are inliers
+            return true;
+        }
+        requiredIterations = std::log(1.0 - probability) / std::log(noOutlierProb);
+        return false;
+    };
+
+    // the warm start is regarded as a hypothesis without sampling
+    bool allInliers = warmStart != std::nullopt && updateBest(*warmStart);
+    for (int iter = 0; !allInliers && iter < maxIterations && iter < requiredIterations; ++iter) {
+        std::array<int, 2> indices{dist(_rng), dist(_rng)};
+        while (indices[1] == indices[0]) {
+            indices[1] = dist(_rng);
+        }
+        Eigen::Vector3d model;
+        if (!ComputeMinimalModel(indices, model)) {
+            continue;
+        }
+        allInliers = updateBest(model);
+    }
+    if (bestCount < 2) {
+        return {};
+    }
+    return RefineModel(bestModel, threshold);
+}
+
+bool VisualVelocitySac::ComputeMinimalModel(const std::array<int, 2> &indices,
+                                            Eigen::Vector3d &model) const {
+    // four equations of two correspondences, the velocity is solved in the least-squares sense
+    Eigen::Matrix<double, 4, 3> A;
+    Eigen::Vector4d b;
+    for (int i = 0; i < 2; ++i) {
+        A.middleRows<2>(2 * i) = _rows.middleCols<2>(2 * indices[i]).transpose();
+        b.segment<2>(2 * i) = _rhs.segment<2>(2 * indices[i]);
+    }
+    Eigen::ColPivHouseholderQR<Eigen::Matrix<double, 4, 3>> qr(A);
+    if (qr.rank() < 3) {
+        return false;
+    }
+    model = qr.solve(b);
+    return true;
+}
+
+int VisualVelocitySac::CountInliers(const Eigen::Vector3d &model,
+                                    double threshold,
+                                    int bestCount) const {
+    const Eigen::Index n = GetCorrCount();
+    const double sqrThd = threshold * threshold;
+    int count = 0;
+    for (Eigen::Index s = 0; s < n; s += SCORE_BLOCK_SIZE) {
+        const Eigen::Index len = std::min<Eigen::Index>(SCORE_BLOCK_SIZE, n - s);
+        // residuals of this block, which are mapped to (2 x len) to compute the norms
+        const Eigen::VectorXd res =
+            _rows.middleCols(2 * s, 2 * len).transpose() * model - _rhs.segment(2 * s, 2 * len);
+        const Eigen::Map<const Eigen::Matrix2Xd> resMat(res.data(), 2, len);
+        count += static_cast<int>((resMat.colwise().squaredNorm().array() < sqrThd).count());
+        // even if all remaining correspondences are inliers, this model is not a better one
+        if (count + (n - s - len) <= bestCount) {
+            return -1;
+        }
+    }
+    return count;
+}
+
+std::optional<Eigen::Vector3d> VisualVelocitySac::RefineModel(const Eigen::Vector3d &model,
+                                                              double threshold) const {
+    const Eigen::Index n = GetCorrCount();
+    const Eigen::VectorXd res = _rows.transpose() * model - _rhs;
+    const Eigen::Map<const Eigen::Matrix2Xd> resMat(res.data(), 2, n);
+    const double sqrThd = threshold * threshold;
+    // weights of rows, zeros for outliers, each one is shared by the two rows of a correspondence
+    const Eigen::Matrix2Xd weights =
+        (resMat.colwise().squaredNorm().array() < sqrThd).cast<double>().replicate(2, 1);
+    if (weights.row(0).sum() < 2.0) {
+        return {};
+    }
+    const Eigen::Map<const Eigen::RowVectorXd> rowWeights(weights.data(), 2 * n);
+    const Eigen::Matrix3Xd weightedRows = _rows.array().rowwise() * rowWeights.array();
+    const Eigen::Matrix3d A = weightedRows * _rows.transpose();
+    const Eigen::Vector3d b = weightedRows * _rhs;
+    return Eigen::Vector3d(A.ldlt().solve(b));
+}
+}  // namespace ns_ikalibr
@@ -0,0 +1,123 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "core/voxel_map_accumulator.h"
+#include "util/point_buffer.h"
+#include "util/status.hpp"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+VoxelMapAccumulator::VoxelMapAccumulator(double voxelSize, std::size_t shardCount)
+    : _voxelSize(voxelSize),
+      _shards(std::max<std::size_t>(shardCount, 1)) {
+    if (_voxelSize <= 0.0) {
+        throw Status(Status::ERROR, "the voxel size of the voxel map '{}' should be positive!",
+                     _voxelSize);
+    }
+}
+
+VoxelMapAccumulator::Ptr VoxelMapAccumulator::Create(double voxelSize, std::size_t shardCount) {
+    return std::make_shared<VoxelMapAccumulator>(voxelSize, shardCount);
+}
+
+void VoxelMapAccumulator::Insert(const IKalibrPointCloud::Ptr &cloud) {
+    if (cloud == nullptr) {
+        return;
+    }
+    // points are first accumulated locally and grouped by shards, so each shard is locked once
+    std::vector<std::unordered_map<VoxelKey, Voxel, VoxelKeyHash>> local(_shards.size());
+    // the validity and voxel keys of points are computed in vectorized kernels
+    const PointBuffer buffer(*cloud);
+    const auto mask = buffer.ValidMask();
+    const auto keys = buffer.ComputeVoxelKeys(static_cast<float>(_voxelSize));
+    const auto &coords = buffer.GetCoords();
+    const auto &timestamps = buffer.GetTimestamps();
+    for (Eigen::Index i = 0; i < buffer.Size(); ++i) {
+        if (!mask(i)) {
+            continue;
+        }
+        VoxelKey key = {keys(0, i), keys(1, i), keys(2, i)};
+        auto &voxel = local.at(VoxelKeyHash()(key) % _shards.size())[key];
+        voxel.ptSum += coords.col(i).cast<double>();
+        voxel.timeSum += timestamps(i);
+        ++voxel.count;
+    }
+    for (int i = 0; i < static_cast<int>(_shards.size()); ++i) {
+        if (local.at(i).empty()) {
+            continue;
+        }
+        auto &shard = _shards.at(i);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto &[key, voxel] : local.at(i)) {
+            auto &target = shard.voxels[key];
+            target.ptSum += voxel.ptSum;
+            target.timeSum += voxel.timeSum;
+            target.count += voxel.count;
+        }
+    }
+}
+
+std::size_t VoxelMapAccumulator::VoxelCount() {
+    std::size_t count = 0;
+    for (auto &shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.voxels.size();
+    }
+    return count;
+}
+
+IKalibrPointCloud::Ptr VoxelMapAccumulator::GetCloud() {
+    IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud);
+    cloud->reserve(VoxelCount());
+    for (auto &shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (const auto &[key, voxel] : shard.voxels) {
+            const double invCount = 1.0 / static_cast<double>(voxel.count);
+            Eigen::Vector3d centroid = voxel.ptSum * invCount;
+            IKalibrPoint p;
+            p.x = static_cast<float>(centroid(0));
+            p.y = static_cast<float>(centroid(1));
+            p.z = static_cast<float>(centroid(2));
+            p.timestamp = voxel.timeSum * invCount;
+            cloud->push_back(p);
+        }
+    }
+    return cloud;
+}
+
+}  // namespace ns_ikalibr
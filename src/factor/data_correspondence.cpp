@@ -35,26 +35,152 @@
 #include "factor/data_correspondence.h"
 #include "sensor/camera.h"
 #include "core/feature_tracking.h"
+#include "util/status.hpp"
+#include "algorithm"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
 namespace ns_ikalibr {
-PointToSurfelCorr::PointToSurfelCorr(double timestamp,
-                                     Eigen::Vector3d pInScan,
-                                     double weight,
-                                     Eigen::Vector4d surfelInW)
-    : timestamp(timestamp),
-      pInScan(std::move(pInScan)),
-      weight(weight),
-      surfelInW(std::move(surfelInW)) {}
-
-PointToSurfelCorr::Ptr PointToSurfelCorr::Create(double timestamp,
-                                                 const Eigen::Vector3d& pInScan,
-                                                 double weight,
-                                                 const Eigen::Vector4d& surfelInW) {
-    return std::make_shared<PointToSurfelCorr>(timestamp, pInScan, weight, surfelInW);
+// -----------
+// SurfelTable
+// -----------
+
+SurfelTable::Ptr SurfelTable::Create() { return std::make_shared<SurfelTable>(); }
+
+std::uint32_t SurfelTable::Insert(const ufo::map::Node& node, const Eigen::Vector4d& coeff) {
+    auto [iter, inserted] = _indices.insert({node, static_cast<std::uint32_t>(coeffs.size())});
+    if (inserted) {
+        coeffs.push_back(coeff);
+        nodes.push_back(node);
+    }
+    return iter->second;
+}
+
+std::size_t SurfelTable::Size() const { return coeffs.size(); }
+
+// -----------------------
+// PointToSurfelCorrBuffer
+// -----------------------
+
+PointToSurfelCorrBuffer::PointToSurfelCorrBuffer(SurfelTable::Ptr surfels)
+    : surfels(std::move(surfels)) {}
+
+PointToSurfelCorrBuffer::Ptr PointToSurfelCorrBuffer::Create(const SurfelTable::Ptr& surfels) {
+    return std::make_shared<PointToSurfelCorrBuffer>(surfels);
+}
+
+std::size_t PointToSurfelCorrBuffer::Size() const { return timestamps.size(); }
+
+bool PointToSurfelCorrBuffer::Empty() const { return timestamps.empty(); }
+
+bool PointToSurfelCorrBuffer::WithVisualization() const {
+    return !pInMap.empty() && pInMap.size() == timestamps.size();
+}
+
+void PointToSurfelCorrBuffer::Reserve(std::size_t count, bool withVisualization) {
+    timestamps.reserve(count), pInScan.reserve(count);
+    weights.reserve(count), surfelIndices.reserve(count);
+    if (withVisualization) {
+        pInMap.reserve(count);
+    }
+}
+
+void PointToSurfelCorrBuffer::Append(double timestamp,
+                                     const Eigen::Vector3f& point,
+                                     float weight,
+                                     std::uint32_t surfelIdx,
+                                     const Eigen::Vector3f* pointInMap) {
+    timestamps.push_back(timestamp);
+    pInScan.push_back(point);
+    weights.push_back(weight);
+    surfelIndices.push_back(surfelIdx);
+    if (pointInMap != nullptr) {
+        pInMap.push_back(*pointInMap);
+    }
+}
+
+void PointToSurfelCorrBuffer::Append(const PointToSurfelCorrBuffer& other) {
+    if (other.Empty()) {
+        return;
+    }
+    const bool withVisualization = (Empty() || WithVisualization()) && other.WithVisualization();
+    if (!withVisualization) {
+        pInMap.clear();
+    }
+    Reserve(Size() + other.Size(), withVisualization);
+
+    // indices of surfels in the other table to the ones in this table
+    std::vector<std::uint32_t> indexMap;
+    if (other.surfels != surfels) {
+        if (other.surfels->nodes.size() != other.surfels->Size()) {
+            throw Status(Status::CRITICAL,
+                         "surfels without nodes can not be merged into another surfel table!");
+        }
+        indexMap.resize(other.surfels->Size());
+        for (std::size_t i = 0; i < indexMap.size(); ++i) {
+            indexMap.at(i) =
+                surfels->Insert(other.surfels->nodes.at(i), other.surfels->coeffs.at(i));
+        }
+    }
+    for (std::size_t i = 0; i < other.Size(); ++i) {
+        const std::uint32_t surfelIdx =
+            indexMap.empty() ? other.surfelIndices[i] : indexMap.at(other.surfelIndices[i]);
+        Append(other.timestamps[i], other.pInScan[i], other.weights[i], surfelIdx,
+               withVisualization ? &other.pInMap[i] : nullptr);
+    }
+}
+
+PointToSurfelCorrBuffer::Ptr PointToSurfelCorrBuffer::Select(
+    const std::vector<std::size_t>& indices) const {
+    auto buffer = Create(surfels);
+    const bool withVisualization = WithVisualization();
+    buffer->Reserve(indices.size(), withVisualization);
+    for (const auto& i : indices) {
+        buffer->Append(timestamps.at(i), pInScan.at(i), weights.at(i), surfelIndices.at(i),
+                       withVisualization ? &pInMap.at(i) : nullptr);
+    }
+    return buffer;
+}
+
+std::vector<std::pair<std::uint32_t, std::vector<std::size_t>>>
+PointToSurfelCorrBuffer::GroupBySurfel() const {
+    if (surfelIndices.empty()) {
+        return {};
+    }
+    // count correspondences of each surfel first, so that buckets are allocated once
+    const auto bucketCount =
+        static_cast<std::size_t>(*std::max_element(surfelIndices.cbegin(), surfelIndices.cend())) +
+        1;
+    std::vector<std::size_t> counts(bucketCount, 0);
+    for (const auto &surfelIdx : surfelIndices) {
+        ++counts[surfelIdx];
+    }
+    // the position of each (non-empty) surfel in groups
+    std::vector<std::size_t> groupIdx(bucketCount, 0);
+    std::vector<std::pair<std::uint32_t, std::vector<std::size_t>>> groups;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        if (counts[i] != 0) {
+            groupIdx[i] = groups.size();
+            groups.emplace_back(static_cast<std::uint32_t>(i), std::vector<std::size_t>());
+            groups.back().second.reserve(counts[i]);
+        }
+    }
+    for (std::size_t i = 0; i < surfelIndices.size(); ++i) {
+        groups[groupIdx[surfelIndices[i]]].second.push_back(i);
+    }
+    return groups;
+}
+
+const Eigen::Vector4d& PointToSurfelCorrBuffer::SurfelOf(std::size_t idx) const {
+    return surfels->coeffs.at(surfelIndices.at(idx));
+}
+
+std::size_t PointToSurfelCorrBuffer::GetMemoryBytes() const {
+    return timestamps.capacity() * sizeof(double) + pInScan.capacity() * sizeof(Eigen::Vector3f) +
+           weights.capacity() * sizeof(float) + surfelIndices.capacity() * sizeof(std::uint32_t) +
+           pInMap.capacity() * sizeof(Eigen::Vector3f);
 }
 
 VisualReProjCorr::VisualReProjCorr(double ti,
@@ -140,6 +266,34 @@ OpticalFlowCorr::Ptr OpticalFlowCorr::Create(const std::array<double, 3>& timeAr
     return std::make_shared<OpticalFlowCorr>(timeAry, xDynamicAry, yDynamicAry, depth);
 }
 
+std::vector<OpticalFlowCorr::Ptr> OpticalFlowCorr::CreateArena(const std::vector<Ptr>& corrs) {
+    std::vector<Ptr> sortedCorrs = corrs;
+    std::stable_sort(sortedCorrs.begin(), sortedCorrs.end(), [](const Ptr& c1, const Ptr& c2) {
+        return c1->timeAry[MID] < c2->timeAry[MID];
+    });
+    auto arena = std::make_shared<std::vector<OpticalFlowCorr>>();
+    arena->reserve(sortedCorrs.size());
+    for (const auto& corr : sortedCorrs) {
+        arena->push_back(*corr);
+    }
+    std::vector<Ptr> arenaCorrs;
+    arenaCorrs.reserve(arena->size());
+    for (auto& corr : *arena) {
+        arenaCorrs.emplace_back(arena, &corr);
+    }
+    return arenaCorrs;
+}
+
+OpticalFlowCorr::OpticalFlowCorr()
+    : timeAry(),
+      xTraceAry(),
+      yTraceAry(),
+      rdFactorAry(),
+      depth(-1.0),
+      invDepth(-1.0),
+      frame(nullptr),
+      withDepthObservability(false) {}
+
 Eigen::Vector2d OpticalFlowCorr::FirPoint() const { return {xTraceAry.at(FIR), yTraceAry.at(FIR)}; }
 
 Eigen::Vector2d OpticalFlowCorr::MidPoint() const { return {xTraceAry.at(MID), yTraceAry.at(MID)}; }
@@ -217,18 +371,51 @@ std::optional<Eigen::Vector2d> FeatureTrackingCurve::VelocityAt(double t) const
 }
 
 std::vector<Eigen::Vector3d> FeatureTrackingCurve::DiscretePositions(double dt) const {
-    std::vector<Eigen::Vector3d> positions;
-    for (double t = this->sTime; t < this->eTime;) {
-        std::optional<Eigen::Vector2d> pos = this->PositionAt(t);
-        if (pos == std::nullopt) {
-            continue;
-        }
-        positions.emplace_back(t, (*pos)(0), (*pos)(1));
-        t += dt;
+    std::vector<double> times;
+    times.reserve(static_cast<std::size_t>(std::max(0.0, (eTime - sTime) / dt)) + 1);
+    for (double t = this->sTime; t < this->eTime; t += dt) {
+        times.push_back(t);
+    }
+    std::vector<Eigen::Vector2d> posVec;
+    const auto [begin, end] = EvaluateAt(times, &posVec, nullptr);
+    std::vector<Eigen::Vector3d> positions(end - begin);
+    for (std::size_t i = begin; i < end; ++i) {
+        positions.at(i - begin) = {times.at(i), posVec.at(i - begin)(0), posVec.at(i - begin)(1)};
     }
     return positions;
 }
 
+std::pair<std::size_t, std::size_t> FeatureTrackingCurve::EvaluateAt(
+    const std::vector<double>& times,
+    std::vector<Eigen::Vector2d>* positions,
+    std::vector<Eigen::Vector2d>* velocities) const {
+    const auto begIter = std::lower_bound(times.cbegin(), times.cend(), sTime);
+    const auto endIter = std::upper_bound(begIter, times.cend(), eTime);
+    const auto begin = static_cast<std::size_t>(std::distance(times.cbegin(), begIter));
+    const auto end = static_cast<std::size_t>(std::distance(times.cbegin(), endIter));
+
+    // coefficients of both curves are organized as matrices, evaluated in the horner form
+    Eigen::Matrix<double, 2, 3> posCoeffs;
+    posCoeffs << xParm.transpose(), yParm.transpose();
+    Eigen::Matrix2d velCoeffs;
+    velCoeffs << posCoeffs.col(0) * 2.0, posCoeffs.col(1);
+    if (positions != nullptr) {
+        positions->resize(end - begin);
+        for (std::size_t i = begin; i < end; ++i) {
+            const double t = times.at(i);
+            positions->at(i - begin) =
+                (posCoeffs.col(0) * t + posCoeffs.col(1)) * t + posCoeffs.col(2);
+        }
+    }
+    if (velocities != nullptr) {
+        velocities->resize(end - begin);
+        for (std::size_t i = begin; i < end; ++i) {
+            velocities->at(i - begin) = velCoeffs.col(0) * times.at(i) + velCoeffs.col(1);
+        }
+    }
+    return {begin, end};
+}
+
 bool FeatureTrackingCurve::IsTimeInRange(double time) const {
     return time >= sTime && time <= eTime;
 }
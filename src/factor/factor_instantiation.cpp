@@ -58,11 +58,23 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 template struct HandEyeRotationAlignFactor<Configor::Prior::SplineOrder>;
 
-template struct IMUAcceFactor<Configor::Prior::SplineOrder, 2>;
-template struct IMUAcceFactor<Configor::Prior::SplineOrder, 1>;
-template struct IMUAcceFactor<Configor::Prior::SplineOrder, 0>;
-
-template struct IMUGyroFactor<Configor ::Prior::SplineOrder>;
+template struct IMUAcceFactor<Configor::Prior::SplineOrder, 2, false>;
+template struct IMUAcceFactor<Configor::Prior::SplineOrder, 1, false>;
+template struct IMUAcceFactor<Configor::Prior::SplineOrder, 0, false>;
+template struct IMUAcceFactor<Configor::Prior::SplineOrder, 2, true>;
+template struct IMUAcceFactor<Configor::Prior::SplineOrder, 1, true>;
+template struct IMUAcceFactor<Configor::Prior::SplineOrder, 0, true>;
+template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 2, false>;
+template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 1, false>;
+template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 0, false>;
+template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 2, true>;
+template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 1, true>;
+template struct IMUAcceBatchFactor<Configor::Prior::SplineOrder, 0, true>;
+
+template struct IMUGyroFactor<Configor ::Prior::SplineOrder, false>;
+template struct IMUGyroFactor<Configor ::Prior::SplineOrder, true>;
+template struct IMUGyroBatchFactor<Configor ::Prior::SplineOrder, false>;
+template struct IMUGyroBatchFactor<Configor ::Prior::SplineOrder, true>;
 
 template struct LiDARInertialAlignHelper<Configor::Prior::SplineOrder>;
 template struct LiDARInertialAlignFactor<Configor::Prior::SplineOrder>;
@@ -74,10 +86,19 @@ template struct LinearScaleDerivFactor<Configor::Prior::SplineOrder, 0>;
 template struct PointToSurfelFactor<Configor::Prior::SplineOrder, 2>;
 template struct PointToSurfelFactor<Configor::Prior::SplineOrder, 1>;
 template struct PointToSurfelFactor<Configor::Prior::SplineOrder, 0>;
+template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 2>;
+template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 1>;
+template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 0>;
+template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 2, false>;
+template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 1, false>;
+template struct PointToSurfelGroupFactor<Configor::Prior::SplineOrder, 0, false>;
 
 template struct RadarFactor<Configor::Prior::SplineOrder, 2>;
 template struct RadarFactor<Configor::Prior::SplineOrder, 1>;
 template struct RadarFactor<Configor::Prior::SplineOrder, 0>;
+template struct RadarScanFactor<Configor::Prior::SplineOrder, 2>;
+template struct RadarScanFactor<Configor::Prior::SplineOrder, 1>;
+template struct RadarScanFactor<Configor::Prior::SplineOrder, 0>;
 
 template struct RadarInertialAlignHelper<Configor::Prior::SplineOrder>;
 template struct RadarInertialAlignFactor<Configor::Prior::SplineOrder>;
@@ -104,6 +125,12 @@ template struct VelVisualInertialAlignFactor<Configor::Prior::SplineOrder>;
 template struct VisualReProjFactor<Configor::Prior::SplineOrder, 2>;
 template struct VisualReProjFactor<Configor::Prior::SplineOrder, 1>;
 template struct VisualReProjFactor<Configor::Prior::SplineOrder, 0>;
+template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 2>;
+template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 1>;
+template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 0>;
+template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 2, false>;
+template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 1, false>;
+template struct VisualReProjSeqFactor<Configor::Prior::SplineOrder, 0, false>;
 
 template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 2, true, true>;
 template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 1, true, true>;
@@ -118,6 +145,11 @@ template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 2, f
 template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 1, false, false>;
 template struct VisualOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 0, false, false>;
 
+template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, true, true>;
+template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, true, false>;
+template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, false, true>;
+template struct VisualOpticalFlowFusedFactor<Configor::Prior::SplineOrder, false, false>;
+
 template struct EventOpticalFlowFactor<Configor::Prior::SplineOrder, 2, true>;
 template struct EventOpticalFlowFactor<Configor::Prior::SplineOrder, 2, false>;
 template struct EventOpticalFlowFactor<Configor::Prior::SplineOrder, 1, true>;
@@ -139,4 +171,5 @@ template struct EventOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 1, fa
 template struct EventOpticalFlowReProjFactor<Configor::Prior::SplineOrder, 0, false, false>;
 
 template struct NormFlowPureRotFactor<Configor::Prior::SplineOrder>;
+template struct NormFlowPureRotBinFactor<Configor::Prior::SplineOrder>;
 }  // namespace ns_ikalibr
@@ -40,6 +40,7 @@
 #include "filesystem"
 #include "cereal/types/map.hpp"
 #include "cereal/types/string.hpp"
+#include "queue"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -133,30 +134,59 @@ std::pair<ros::Time, ros::Time> BagMerger::Process() {
                          dstParentPath.string());
         }
     }
-    auto dstBag = std::make_unique<rosbag::Bag>();
-    dstBag->open(_configor->_outputBagPath, rosbag::BagMode::Write | rosbag::BagMode::Read);
-    for (const auto &bagInfo : _configor->_bags) {
-        spdlog::info("process bag at '{}'...", bagInfo.bagPath);
-        // open current rosbag
-        auto srcBag = std::make_unique<rosbag::Bag>();
-        srcBag->open(bagInfo.bagPath, rosbag::BagMode::Read);
+    const int bagCount = static_cast<int>(_configor->_bags.size());
+    std::vector<std::unique_ptr<rosbag::Bag>> srcBags(bagCount);
+    std::vector<std::unique_ptr<rosbag::View>> views(bagCount);
+    std::vector<rosbag::View::iterator> cursors(bagCount);
+    for (int i = 0; i < bagCount; ++i) {
+        const auto &bagInfo = _configor->_bags.at(i);
+        spdlog::info("open bag at '{}'...", bagInfo.bagPath);
+        srcBags.at(i) = std::make_unique<rosbag::Bag>();
+        srcBags.at(i)->open(bagInfo.bagPath, rosbag::BagMode::Read);
         // query
-        auto view = rosbag::View();
+        views.at(i) = std::make_unique<rosbag::View>();
         if (auto topicVec = bagInfo.GetSrcTopicVec(); topicVec.empty()) {
-            view.addQuery(*srcBag);
+            views.at(i)->addQuery(*srcBags.at(i));
         } else {
-            view.addQuery(*srcBag, rosbag::TopicQuery(bagInfo.GetSrcTopicVec()));
+            views.at(i)->addQuery(*srcBags.at(i), rosbag::TopicQuery(topicVec));
         }
-        for (const auto &item : view) {
-            dstBag->write(bagInfo.GetDstTopic(item.getTopic()), item.getTime(), item,
-                          item.getConnectionHeader());
+        cursors.at(i) = views.at(i)->begin();
+    }
+
+    /**
+     * k-way merge of the time-ordered views, messages are written in the global time order, so
+     * that chunks of the output bag are not interleaved in time. Messages are copied as serialized
+     * buffers (no instantiation), and the time range is tracked while writing
+     */
+    using HeapItem = std::pair<ros::Time, int>;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<>> heap;
+    for (int i = 0; i < bagCount; ++i) {
+        if (cursors.at(i) != views.at(i)->end()) {
+            heap.emplace(cursors.at(i)->getTime(), i);
+        }
+    }
+    auto dstBag = std::make_unique<rosbag::Bag>();
+    dstBag->open(_configor->_outputBagPath, rosbag::BagMode::Write);
+    ros::Time st = ros::TIME_MAX, et = ros::TIME_MIN;
+    while (!heap.empty()) {
+        const auto [time, i] = heap.top();
+        heap.pop();
+        const auto &item = *cursors.at(i);
+        dstBag->write(_configor->_bags.at(i).GetDstTopic(item.getTopic()), time, item,
+                      item.getConnectionHeader());
+        st = std::min(st, time), et = std::max(et, time);
+        if (++cursors.at(i) != views.at(i)->end()) {
+            heap.emplace(cursors.at(i)->getTime(), i);
         }
-        srcBag->close();
     }
-    auto view = rosbag::View();
-    view.addQuery(*dstBag);
-    auto st = view.getBeginTime(), et = view.getEndTime();
     dstBag->close();
+    for (auto &srcBag : srcBags) {
+        srcBag->close();
+    }
+    if (st > et) {
+        // no message is merged
+        st = et = ros::Time();
+    }
     spdlog::info("process finished...");
     return std::pair{st, et};
 }
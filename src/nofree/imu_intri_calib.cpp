@@ -38,6 +38,8 @@
 #include "rosbag/view.h"
 #include "nofree/imu_intri_calib_factors.hpp"
 #include "calib/estimator.h"
+#include "omp.h"
+#include "algorithm"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -56,56 +58,54 @@ IMUIntriCalibSolver::Ptr IMUIntriCalibSolver::Create(
 
 void IMUIntriCalibSolver::Process() {
     // initialize gravity roughly
-    gravity.resize(data.size());
-    for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-        if (data.at(i).empty()) {
+    gravity.resize(configor.items.size());
+    for (int i = 0; i < static_cast<int>(configor.items.size()); ++i) {
+        Eigen::Vector3d acceSum = Eigen::Vector3d::Zero();
+        if (configor.sufficientStatistics) {
+            for (const auto &piece : statistics.at(i)) {
+                acceSum += static_cast<double>(piece.count) * piece.acceMean;
+            }
+        } else if (!data.at(i).empty()) {
+            acceSum = AverageAcce(data.at(i));
+        }
+        if (acceSum.isZero()) {
             continue;
         }
-        gravity.at(i) = -configor.gravityNorm * AverageAcce(data.at(i)).normalized();
+        gravity.at(i) = -configor.gravityNorm * acceSum.normalized();
     }
 
-    auto *GRAVITY_MANIFOLD = new ceres::SphereManifold<3>();
-    auto *QUATER_MANIFOLD = new ceres::EigenQuaternionManifold();
+    if (configor.sufficientStatistics) {
+        ceres::Problem prob;
+        for (int i = 0; i < static_cast<int>(statistics.size()); ++i) {
+            for (const auto &piece : statistics.at(i)) {
+                spdlog::info(
+                    "static piece of '{}' frames in bag '{}', acce std: [{:.6f}, {:.6f}, {:.6f}], "
+                    "gyro std: [{:.6f}, {:.6f}, {:.6f}]",
+                    piece.count, configor.items.at(i).bagPath,
+                    std::sqrt(piece.acceCov(0, 0)), std::sqrt(piece.acceCov(1, 1)),
+                    std::sqrt(piece.acceCov(2, 2)), std::sqrt(piece.gyroCov(0, 0)),
+                    std::sqrt(piece.gyroCov(1, 1)), std::sqrt(piece.gyroCov(2, 2)));
+                // a mean frame weighted by the square root of the count
+                auto meanFrame = IMUFrame::Create(0.0, piece.gyroMean, piece.acceMean);
+                AddFrameFactors(prob, meanFrame, std::sqrt(static_cast<double>(piece.count)),
+                                gravity.at(i));
+            }
+        }
+        ceres::Solver::Summary summary;
+        ceres::Solve(Estimator::DefaultSolverOptions(), &prob, &summary);
+        spdlog::info("here is the summary of the statistic problem:\n{}\n",
+                     summary.BriefReport());
+        if (!configor.refineWithFrames) {
+            return;
+        }
+        spdlog::info("refine the intrinsics using all frames...");
+    }
 
     ceres::Problem prob;
     // add factors
     for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-        const auto &pieces = data.at(i);
-        Eigen::Vector3d &grav = gravity.at(i);
-        for (const auto &frame : pieces) {
-            // accelerator
-            auto acceCostFunc = IMUIntriAcceFactor::Create(frame, 1.0);
-            acceCostFunc->AddParameterBlock(3);
-            acceCostFunc->AddParameterBlock(6);
-            acceCostFunc->AddParameterBlock(3);
-            acceCostFunc->SetNumResiduals(3);
-
-            std::vector<double *> acceParBlockVec;
-            acceParBlockVec.push_back(intrinsics.ACCE.BIAS.data());
-            acceParBlockVec.push_back(intrinsics.ACCE.MAP_COEFF.data());
-            acceParBlockVec.push_back(grav.data());
-
-            prob.AddResidualBlock(acceCostFunc, nullptr, acceParBlockVec);
-            prob.SetManifold(grav.data(), GRAVITY_MANIFOLD);
-
-            // gyroscope
-            auto gyroCostFunc = IMUIntriGyroFactor::Create(frame, 1.0);
-            gyroCostFunc->AddParameterBlock(3);
-            gyroCostFunc->AddParameterBlock(6);
-            gyroCostFunc->AddParameterBlock(4);
-            gyroCostFunc->SetNumResiduals(3);
-
-            std::vector<double *> gyroParBlockVec;
-            gyroParBlockVec.push_back(intrinsics.GYRO.BIAS.data());
-            gyroParBlockVec.push_back(intrinsics.GYRO.MAP_COEFF.data());
-            gyroParBlockVec.push_back(intrinsics.SO3_AtoG.data());
-
-            prob.AddResidualBlock(gyroCostFunc, nullptr, gyroParBlockVec);
-            prob.SetManifold(intrinsics.SO3_AtoG.data(), QUATER_MANIFOLD);
-
-            // we do not optimize these two block
-            prob.SetParameterBlockConstant(intrinsics.GYRO.MAP_COEFF.data());
-            prob.SetParameterBlockConstant(intrinsics.SO3_AtoG.data());
+        for (const auto &frame : data.at(i)) {
+            AddFrameFactors(prob, frame, 1.0, gravity.at(i));
         }
     }
     ceres::Solver::Summary summary;
@@ -113,11 +113,56 @@ void IMUIntriCalibSolver::Process() {
     spdlog::info("here is the summary:\n{}\n", summary.BriefReport());
 }
 
+void IMUIntriCalibSolver::AddFrameFactors(ceres::Problem &prob,
+                                          const IMUFrame::Ptr &frame,
+                                          double weight,
+                                          Eigen::Vector3d &grav) {
+    // accelerator
+    auto acceCostFunc = IMUIntriAcceFactor::Create(frame, weight);
+    acceCostFunc->AddParameterBlock(3);
+    acceCostFunc->AddParameterBlock(6);
+    acceCostFunc->AddParameterBlock(3);
+    acceCostFunc->SetNumResiduals(3);
+
+    std::vector<double *> acceParBlockVec;
+    acceParBlockVec.push_back(intrinsics.ACCE.BIAS.data());
+    acceParBlockVec.push_back(intrinsics.ACCE.MAP_COEFF.data());
+    acceParBlockVec.push_back(grav.data());
+
+    prob.AddResidualBlock(acceCostFunc, nullptr, acceParBlockVec);
+    // manifolds are owned by the problem, they are created once for each parameter block
+    if (prob.GetManifold(grav.data()) == nullptr) {
+        prob.SetManifold(grav.data(), new ceres::SphereManifold<3>());
+    }
+
+    // gyroscope
+    auto gyroCostFunc = IMUIntriGyroFactor::Create(frame, weight);
+    gyroCostFunc->AddParameterBlock(3);
+    gyroCostFunc->AddParameterBlock(6);
+    gyroCostFunc->AddParameterBlock(4);
+    gyroCostFunc->SetNumResiduals(3);
+
+    std::vector<double *> gyroParBlockVec;
+    gyroParBlockVec.push_back(intrinsics.GYRO.BIAS.data());
+    gyroParBlockVec.push_back(intrinsics.GYRO.MAP_COEFF.data());
+    gyroParBlockVec.push_back(intrinsics.SO3_AtoG.data());
+
+    prob.AddResidualBlock(gyroCostFunc, nullptr, gyroParBlockVec);
+    if (prob.GetManifold(intrinsics.SO3_AtoG.data()) == nullptr) {
+        prob.SetManifold(intrinsics.SO3_AtoG.data(), new ceres::EigenQuaternionManifold());
+    }
+
+    // we do not optimize these two block
+    prob.SetParameterBlockConstant(intrinsics.GYRO.MAP_COEFF.data());
+    prob.SetParameterBlockConstant(intrinsics.SO3_AtoG.data());
+}
+
 const IMUIntrinsics &IMUIntriCalibSolver::GetIntrinsics() const { return intrinsics; }
 
 void IMUIntriCalibSolver::LoadIMUData() {
     auto dataLoader = IMUDataLoader::GetLoader(configor.IMUType);
     data.resize(configor.items.size());
+    statistics.resize(configor.items.size());
     for (int i = 0; i < static_cast<int>(configor.items.size()); ++i) {
         const auto &item = configor.items.at(i);
         if (!std::filesystem::exists(item.bagPath)) {
@@ -134,6 +179,7 @@ void IMUIntriCalibSolver::LoadIMUData() {
         auto begTime = viewTemp.getBeginTime();
         auto endTime = viewTemp.getEndTime();
 
+        std::vector<std::list<IMUFrame::Ptr>> pieces;
         for (const auto &[st, et] : item.staticPieces) {
             spdlog::info("load imu data in time piece [{}, {}]...", st, et);
             ros::Time curBegTime, curEndTime;
@@ -150,15 +196,65 @@ void IMUIntriCalibSolver::LoadIMUData() {
             }
             auto view = rosbag::View();
             view.addQuery(*bag, rosbag::TopicQuery(configor.IMUTopic), curBegTime, curEndTime);
+            auto &piece = pieces.emplace_back();
             for (const auto &frame : view) {
                 // is an inertial frame
                 auto mes = dataLoader->UnpackFrame(frame);
-                curData.push_back(mes);
+                piece.push_back(mes);
+            }
+        }
+
+        if (configor.sufficientStatistics) {
+            // pieces are reduced in parallel, and only one bag of frames is held at a time
+            const int pieceCount = static_cast<int>(pieces.size());
+            auto &curStatistics = statistics.at(i);
+            curStatistics.resize(pieceCount);
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic) default(none) \
+    shared(pieceCount, pieces, curStatistics)
+            for (int j = 0; j < pieceCount; ++j) {
+                curStatistics.at(j) = ComputeStatistics(pieces.at(j));
             }
+            // empty pieces are not involved in solving
+            curStatistics.erase(std::remove_if(curStatistics.begin(), curStatistics.end(),
+                                               [](const auto &s) { return s.count == 0; }),
+                                curStatistics.end());
+            if (!configor.refineWithFrames) {
+                continue;
+            }
+        }
+        for (auto &piece : pieces) {
+            curData.splice(curData.end(), piece);
         }
     }
 }
 
+IMUIntriCalibSolver::PieceStatistics IMUIntriCalibSolver::ComputeStatistics(
+    const std::list<IMUFrame::Ptr> &frames) {
+    PieceStatistics statistic;
+    statistic.count = frames.size();
+    statistic.acceMean = statistic.gyroMean = Eigen::Vector3d::Zero();
+    statistic.acceCov = statistic.gyroCov = Eigen::Matrix3d::Zero();
+    if (frames.empty()) {
+        return statistic;
+    }
+    // two passes, which is numerically stable for long pieces
+    for (const auto &frame : frames) {
+        statistic.acceMean += frame->GetAcce();
+        statistic.gyroMean += frame->GetGyro();
+    }
+    statistic.acceMean /= static_cast<double>(statistic.count);
+    statistic.gyroMean /= static_cast<double>(statistic.count);
+    for (const auto &frame : frames) {
+        const Eigen::Vector3d acce = frame->GetAcce() - statistic.acceMean;
+        const Eigen::Vector3d gyro = frame->GetGyro() - statistic.gyroMean;
+        statistic.acceCov += acce * acce.transpose();
+        statistic.gyroCov += gyro * gyro.transpose();
+    }
+    statistic.acceCov /= static_cast<double>(statistic.count);
+    statistic.gyroCov /= static_cast<double>(statistic.count);
+    return statistic;
+}
+
 Eigen::Vector3d IMUIntriCalibSolver::AverageAcce(const std::list<IMUFrame::Ptr> &frames) {
     Eigen::Vector3d sum = Eigen::Vector3d::Zero();
     for (const auto &item : frames) {
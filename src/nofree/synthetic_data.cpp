@@ -0,0 +1,763 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "nofree/synthetic_data.h"
+#include "nofree/data_collect_demo.h"
+#include "util/cloud_define.hpp"
+#include "util/status.hpp"
+#include "spdlog/spdlog.h"
+#include "sensor_msgs/Imu.h"
+#include "pcl_conversions/pcl_conversions.h"
+#include "cv_bridge/cv_bridge.h"
+#include "ikalibr/DVSEventArray.h"
+#include "opencv2/imgproc.hpp"
+#include "omp.h"
+#include "cereal/types/vector.hpp"
+#include "cereal/types/string.hpp"
+#include "filesystem"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+// zero-mean gaussian noise, no noise if the standard deviation is not positive
+static double Gaussian(std::default_random_engine &engine, double stddev) {
+    return stddev > 0.0 ? std::normal_distribution<double>(0.0, stddev)(engine) : 0.0;
+}
+
+// --------------------
+// SimConfigor::Sensors
+// --------------------
+Sophus::SO3d SimConfigor::SensorInfo::SO3_SenToBr() const {
+    const Eigen::Vector3d euler = EULER_SenToBr * M_PI / 180.0;
+    Eigen::Matrix3d rot = (Eigen::AngleAxisd(euler(2), Eigen::Vector3d::UnitZ()) *
+                           Eigen::AngleAxisd(euler(1), Eigen::Vector3d::UnitY()) *
+                           Eigen::AngleAxisd(euler(0), Eigen::Vector3d::UnitX()))
+                              .toRotationMatrix();
+    return Sophus::SO3d(Eigen::Quaterniond(rot).normalized());
+}
+
+Sophus::SE3d SimConfigor::SensorInfo::SE3_SenToBr() const { return {SO3_SenToBr(), POS_SenInBr}; }
+
+ns_veta::PinholeIntrinsic::Ptr SimConfigor::PinholeInfo::Intrinsics() const {
+    // images are rendered without distortion
+    return ns_veta::PinholeIntrinsicBrownT2::Create(width, height, fx, fy, cx, cy, 0.0, 0.0, 0.0,
+                                                    0.0, 0.0);
+}
+
+// -----------
+// SimConfigor
+// -----------
+SimConfigor::Ptr SimConfigor::Create() { return std::make_shared<SimConfigor>(); }
+
+SimConfigor::Ptr SimConfigor::LoadConfigure(const std::string &filename,
+                                            CerealArchiveType::Enum archiveType) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    auto archive = GetInputArchiveVariant(file, archiveType);
+    auto configor = SimConfigor::Create();
+    try {
+        SerializeByInputArchiveVariant(archive, archiveType,
+                                       cereal::make_nvp("SimConfigor", *configor));
+    } catch (const cereal::Exception &exception) {
+        throw Status(Status::CRITICAL,
+                     "The configuration file '{}' for 'SimConfigor' is "
+                     "outdated or broken, and can not be loaded in iKalibr using cereal!!! "
+                     "To make it right, please refer to our latest configuration file "
+                     "template released at "
+                     "https://github.com/Unsigned-Long/iKalibr/blob/master/config/tool/"
+                     "config-synthetic-data.yaml, and then fix your custom configuration "
+                     "file. Detailed cereal "
+                     "exception information: \n'{}'",
+                     filename, exception.what());
+    }
+    return configor;
+}
+
+void SimConfigor::PrintMainFields() const {
+    spdlog::info(
+        "output rosbag path: '{}', start time: '{:.3f}', duration: '{:.3f}', seed: '{}', motion "
+        "type: '{}', knot distance: '{:.3f}', room size: '[{:.2f}, {:.2f}, {:.2f}]', boxes: '{}'",
+        _outputBagPath, _startTime, _duration, _seed, _motionType, _knotDistance, _roomSize(0),
+        _roomSize(1), _roomSize(2), _boxCount);
+    auto print = [](const std::string &type, const SensorInfo &sensor) {
+        spdlog::info(
+            "{} '{}', frequency: '{:.2f}', EULER_SenToBr: '[{:.2f}, {:.2f}, {:.2f}]', POS_SenInBr: "
+            "'[{:.3f}, {:.3f}, {:.3f}]', TO_SenToBr: '{:.5f}'",
+            type, sensor.topic, sensor.frequency, sensor.EULER_SenToBr(0), sensor.EULER_SenToBr(1),
+            sensor.EULER_SenToBr(2), sensor.POS_SenInBr(0), sensor.POS_SenInBr(1),
+            sensor.POS_SenInBr(2), sensor.TO_SenToBr);
+    };
+    for (const auto &sensor : _imus) {
+        print("imu (SENSOR_IMU)", sensor);
+    }
+    for (const auto &sensor : _lidars) {
+        print("lidar (OUSTER_POINTS)", sensor);
+    }
+    for (const auto &sensor : _radars) {
+        print("radar (POINTCLOUD2_POSV)", sensor);
+    }
+    for (const auto &sensor : _cameras) {
+        print(sensor.readoutTime > 0.0 ? "camera (SENSOR_IMAGE_RS_FIRST)"
+                                       : "camera (SENSOR_IMAGE_GS)",
+              sensor);
+    }
+    for (const auto &sensor : _events) {
+        print("event camera (DVS_EVENT)", sensor);
+    }
+}
+
+// ----------------------
+// SyntheticDataGenerator
+// ----------------------
+SyntheticDataGenerator::SyntheticDataGenerator(SimConfigor::Ptr configor)
+    : _configor(std::move(configor)),
+      _gravity(0.0, 0.0, -9.8) {
+    if (_configor->_imus.empty()) {
+        throw Status(Status::CRITICAL, "at least one imu should be simulated as the reference!");
+    }
+    if (_configor->_knotDistance <= 0.0 ||
+        _configor->_duration < _configor->_knotDistance * Configor::Prior::SplineOrder) {
+        throw Status(Status::CRITICAL,
+                     "the duration '{:.3f}' is too short for the knot distance '{:.3f}'!",
+                     _configor->_duration, _configor->_knotDistance);
+    }
+    auto checkFrequency = [](const SimConfigor::SensorInfo &sensor) {
+        if (sensor.frequency <= 0.0) {
+            throw Status(Status::CRITICAL, "the frequency of '{}' should be positive!",
+                         sensor.topic);
+        }
+    };
+    std::for_each(_configor->_imus.cbegin(), _configor->_imus.cend(), checkFrequency);
+    std::for_each(_configor->_lidars.cbegin(), _configor->_lidars.cend(), checkFrequency);
+    std::for_each(_configor->_radars.cbegin(), _configor->_radars.cend(), checkFrequency);
+    std::for_each(_configor->_cameras.cbegin(), _configor->_cameras.cend(), checkFrequency);
+    std::for_each(_configor->_events.cbegin(), _configor->_events.cend(), checkFrequency);
+    for (const auto &event : _configor->_events) {
+        if (event.renderFrequency <= 0.0 || event.contrastThreshold <= 0.0) {
+            throw Status(Status::CRITICAL,
+                         "the render frequency and the contrast threshold of '{}' should be "
+                         "positive!",
+                         event.topic);
+        }
+    }
+
+    // the reference imu defines the trajectory
+    auto &referIMU = _configor->_imus.front();
+    if (!referIMU.EULER_SenToBr.isZero() || !referIMU.POS_SenInBr.isZero() ||
+        referIMU.TO_SenToBr != 0.0) {
+        spdlog::warn("extrinsics and time offset of the reference imu '{}' are ignored!",
+                     referIMU.topic);
+    }
+    referIMU.EULER_SenToBr.setZero();
+    referIMU.POS_SenInBr.setZero();
+    referIMU.TO_SenToBr = 0.0;
+
+    CreateTrajectory();
+    CreateWorld();
+}
+
+SyntheticDataGenerator::Ptr SyntheticDataGenerator::Create(const SimConfigor::Ptr &configor) {
+    return std::make_shared<SyntheticDataGenerator>(configor);
+}
+
+void SyntheticDataGenerator::CreateTrajectory() {
+    const double dt = _configor->_knotDistance;
+    _splines = SplineBundleType::Create(
+        {ns_ctraj::SplineInfo(Configor::Preference::SO3_SPLINE, ns_ctraj::SplineType::So3Spline,
+                              0.0, _configor->_duration, dt),
+         ns_ctraj::SplineInfo(Configor::Preference::SCALE_SPLINE, ns_ctraj::SplineType::RdSpline,
+                              0.0, _configor->_duration, dt)});
+    auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    const int knotCount = static_cast<int>(so3Spline.GetKnots().size());
+    // the trajectory is around the center of the room, at the half height
+    const Eigen::Vector3d center(0.0, 0.0, 0.5 * _configor->_roomSize(2));
+
+    if (_configor->_motionType == "DEMO") {
+        // the periodic motion shown in the data collection demo, knots are assigned by its poses
+        const auto poses = DataCollectionMotionDemo::GeneratePoseSeq().front();
+        const double period =
+            poses.back().timeStamp + (poses.at(1).timeStamp - poses.at(0).timeStamp);
+        for (int i = 0; i < knotCount; ++i) {
+            // the time around which the knot is weighted most
+            double t = std::max((i - 0.5 * (Configor::Prior::SplineOrder - 2)) * dt, 0.0);
+            t = std::fmod(t, period);
+            auto idx = static_cast<std::size_t>(std::round(t / period * poses.size()));
+            const auto &pose = poses.at(idx % poses.size());
+            so3Spline.GetKnot(i) = Sophus::SO3d(
+                Eigen::Quaterniond(pose.rotation.cast<double>()).normalized());
+            posSpline.GetKnot(i) = pose.translation.cast<double>() + center;
+        }
+    } else if (_configor->_motionType == "RANDOM") {
+        // a random walk, positions are kept away from boxes (see 'CreateWorld')
+        std::default_random_engine engine(_configor->_seed);
+        constexpr double ROT_STEP = 0.25, POS_STEP = 0.15, POS_BOUND = 2.5;
+        Sophus::SO3d so3;
+        Eigen::Vector3d pos = center;
+        for (int i = 0; i < knotCount; ++i) {
+            so3 = so3 * Sophus::SO3d::exp(Eigen::Vector3d(
+                            Gaussian(engine, ROT_STEP), Gaussian(engine, ROT_STEP),
+                            Gaussian(engine, ROT_STEP)));
+            pos += Eigen::Vector3d(Gaussian(engine, POS_STEP), Gaussian(engine, POS_STEP),
+                                   Gaussian(engine, POS_STEP));
+            for (int j = 0; j < 3; ++j) {
+                const double bound =
+                    j == 2 ? std::min(POS_BOUND, 0.5 * _configor->_roomSize(2) - 0.5) : POS_BOUND;
+                pos(j) = std::clamp(pos(j), center(j) - bound, center(j) + bound);
+            }
+            so3Spline.GetKnot(i) = so3;
+            posSpline.GetKnot(i) = pos;
+        }
+    } else {
+        throw Status(Status::CRITICAL,
+                     "unknown motion type: '{}', supported ones are 'DEMO' and 'RANDOM'!",
+                     _configor->_motionType);
+    }
+}
+
+void SyntheticDataGenerator::CreateWorld() {
+    std::default_random_engine engine(_configor->_seed + 1);
+    std::uint32_t seed = 0;
+    // a box (without the bottom face), each face is a surfel whose normal points outward
+    auto addBox = [this, &seed](const Eigen::Vector3d &center, const Eigen::Vector3d &size,
+                                bool inward) {
+        const Eigen::Vector3d half = 0.5 * size;
+        for (int axis = 0; axis < 3; ++axis) {
+            const int uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+            for (int sign : {-1, 1}) {
+                if (axis == 2 && sign == -1 && !inward) {
+                    continue;
+                }
+                Surfel surfel;
+                surfel.center = center;
+                surfel.center(axis) += sign * half(axis);
+                surfel.normal = Eigen::Vector3d::Unit(axis) * (inward ? -sign : sign);
+                surfel.uDir = Eigen::Vector3d::Unit(uAxis);
+                surfel.vDir = Eigen::Vector3d::Unit(vAxis);
+                surfel.halfU = half(uAxis);
+                surfel.halfV = half(vAxis);
+                surfel.seed = seed++;
+                _world.push_back(surfel);
+            }
+        }
+    };
+    const Eigen::Vector3d &roomSize = _configor->_roomSize;
+    addBox(Eigen::Vector3d(0.0, 0.0, 0.5 * roomSize(2)), roomSize, true);
+
+    // boxes stand on the floor, away from the trajectory
+    constexpr double KEEP_OUT = 4.0;
+    std::uniform_real_distribution<double> xDist(-0.5 * roomSize(0), 0.5 * roomSize(0));
+    std::uniform_real_distribution<double> yDist(-0.5 * roomSize(1), 0.5 * roomSize(1));
+    std::uniform_real_distribution<double> sizeDist(0.5, 1.5);
+    std::uniform_real_distribution<double> heightDist(0.5, std::max(0.6, roomSize(2) - 0.5));
+    for (int i = 0, trials = 0; i < _configor->_boxCount && trials < 100 * _configor->_boxCount;
+         ++trials) {
+        Eigen::Vector3d size(sizeDist(engine), sizeDist(engine), heightDist(engine));
+        Eigen::Vector3d center(xDist(engine), yDist(engine), 0.5 * size(2));
+        if (center.head<2>().norm() < KEEP_OUT ||
+            std::abs(center(0)) + 0.5 * size(0) > 0.5 * roomSize(0) ||
+            std::abs(center(1)) + 0.5 * size(1) > 0.5 * roomSize(1)) {
+            continue;
+        }
+        addBox(center, size, false);
+        ++i;
+    }
+    spdlog::info("procedural world created, surfels: '{}'", _world.size());
+}
+
+std::vector<double> SyntheticDataGenerator::SensorStamps(const SimConfigor::SensorInfo &sensor,
+                                                         double frequency,
+                                                         double span) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const double st = so3Spline.MinTime(), et = so3Spline.MaxTime() - 1E-6;
+    std::vector<double> stamps;
+    for (std::size_t k = 0;; ++k) {
+        const double t = static_cast<double>(k) / frequency;
+        const double timeByBr = t + sensor.TO_SenToBr;
+        if (timeByBr + span >= et) {
+            break;
+        }
+        if (timeByBr >= st) {
+            stamps.push_back(t);
+        }
+    }
+    return stamps;
+}
+
+Sophus::SE3d SyntheticDataGenerator::SensorPose(const SimConfigor::SensorInfo &sensor,
+                                                double timeByBr) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    Sophus::SE3d SE3_BrToW(so3Spline.Evaluate(timeByBr), posSpline.Evaluate<0>(timeByBr));
+    return SE3_BrToW * sensor.SE3_SenToBr();
+}
+
+Eigen::Vector3d SyntheticDataGenerator::SensorVelocity(const SimConfigor::SensorInfo &sensor,
+                                                       double timeByBr) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    const auto SO3_BrToW = so3Spline.Evaluate(timeByBr);
+    const Eigen::Vector3d ANG_VEL_BrToWInBr = so3Spline.VelocityBody(timeByBr);
+    const Eigen::Vector3d LIN_VEL_BrInW = posSpline.Evaluate<1>(timeByBr);
+    return LIN_VEL_BrInW + SO3_BrToW * ANG_VEL_BrToWInBr.cross(sensor.POS_SenInBr);
+}
+
+bool SyntheticDataGenerator::RayCast(const Eigen::Vector3d &origin,
+                                     const Eigen::Vector3d &dir,
+                                     double rangeMax,
+                                     double *range,
+                                     double *intensity) const {
+    const Surfel *hit = nullptr;
+    double best = rangeMax, hitA = 0.0, hitB = 0.0;
+    for (const auto &surfel : _world) {
+        const double denom = surfel.normal.dot(dir);
+        if (std::abs(denom) < 1E-9) {
+            continue;
+        }
+        const double t = surfel.normal.dot(surfel.center - origin) / denom;
+        if (t <= 1E-6 || t >= best) {
+            continue;
+        }
+        const Eigen::Vector3d offset = origin + t * dir - surfel.center;
+        const double a = offset.dot(surfel.uDir), b = offset.dot(surfel.vDir);
+        if (std::abs(a) > surfel.halfU || std::abs(b) > surfel.halfV) {
+            continue;
+        }
+        hit = &surfel, best = t, hitA = a + surfel.halfU, hitB = b + surfel.halfV;
+    }
+    if (hit == nullptr) {
+        return false;
+    }
+    *range = best;
+    // cells of random gray levels, which provide corners for tracking and edges for events
+    const auto cu = static_cast<std::uint32_t>(std::floor(hitA / _configor->_textureCellSize));
+    const auto cv = static_cast<std::uint32_t>(std::floor(hitB / _configor->_textureCellSize));
+    std::uint32_t h = (hit->seed * 73856093u) ^ (cu * 19349663u) ^ (cv * 83492791u);
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    *intensity = 0.1 + 0.8 * static_cast<double>(h & 0xFFFFu) / 65535.0;
+    return true;
+}
+
+cv::Mat SyntheticDataGenerator::RenderImage(const SimConfigor::SensorInfo &sensor,
+                                            const SimConfigor::PinholeInfo &intri,
+                                            double timeByBr,
+                                            double readoutTime) const {
+    cv::Mat img(intri.height, intri.width, CV_64FC1, cv::Scalar(0.0));
+    const double rangeMax = _configor->_roomSize.norm() * 2.0;
+#pragma omp parallel for num_threads(omp_get_max_threads()) schedule(dynamic) default(none) \
+    shared(img, sensor, intri, timeByBr, readoutTime, rangeMax)
+    for (int r = 0; r < intri.height; ++r) {
+        const auto SE3_CToW =
+            SensorPose(sensor, timeByBr + static_cast<double>(r) / intri.height * readoutTime);
+        auto *row = img.ptr<double>(r);
+        for (int c = 0; c < intri.width; ++c) {
+            const Eigen::Vector3d dirInC((c - intri.cx) / intri.fx, (r - intri.cy) / intri.fy,
+                                         1.0);
+            double range, intensity;
+            if (RayCast(SE3_CToW.translation(), SE3_CToW.so3() * dirInC.normalized(), rangeMax,
+                        &range, &intensity)) {
+                row[c] = intensity;
+            }
+        }
+    }
+    // the blur of optics, which also reduces aliasing of texture edges
+    cv::GaussianBlur(img, img, cv::Size(3, 3), 0.8);
+    return img;
+}
+
+void SyntheticDataGenerator::WriteIMU(rosbag::Bag &bag,
+                                      const SimConfigor::IMUInfo &imu,
+                                      std::default_random_engine &engine) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    const auto SO3_BiToBr = imu.SO3_SenToBr();
+    const double st = so3Spline.MinTime(), et = so3Spline.MaxTime() - 1E-6;
+    constexpr double DIFF_DT = 1E-4;
+
+    const auto stamps = SensorStamps(imu, imu.frequency, 0.0);
+    for (double t : stamps) {
+        const double timeByBr = t + imu.TO_SenToBr;
+        const auto SO3_BrToW = so3Spline.Evaluate(timeByBr);
+        const Eigen::Vector3d ANG_VEL = so3Spline.VelocityBody(timeByBr);
+        // the angular acceleration (in the body frame) by central differences
+        const double tm = std::max(timeByBr - DIFF_DT, st), tp = std::min(timeByBr + DIFF_DT, et);
+        const Eigen::Vector3d ANG_ACCE =
+            (so3Spline.VelocityBody(tp) - so3Spline.VelocityBody(tm)) / (tp - tm);
+        const Eigen::Vector3d &p = imu.POS_SenInBr;
+        const Eigen::Vector3d LIN_ACCE_BiInW =
+            posSpline.Evaluate<2>(timeByBr) +
+            SO3_BrToW * (ANG_ACCE.cross(p) + ANG_VEL.cross(ANG_VEL.cross(p)));
+
+        const Eigen::Vector3d gyro = SO3_BiToBr.inverse() * ANG_VEL;
+        const Eigen::Vector3d acce =
+            SO3_BiToBr.inverse() * (SO3_BrToW.inverse() * (LIN_ACCE_BiInW - _gravity));
+
+        sensor_msgs::Imu msg;
+        msg.header.stamp = ros::Time(_configor->_startTime + t);
+        msg.header.frame_id = imu.topic;
+        msg.orientation_covariance.at(0) = -1.0;
+        msg.angular_velocity.x = gyro(0) + Gaussian(engine, imu.gyroNoise);
+        msg.angular_velocity.y = gyro(1) + Gaussian(engine, imu.gyroNoise);
+        msg.angular_velocity.z = gyro(2) + Gaussian(engine, imu.gyroNoise);
+        msg.linear_acceleration.x = acce(0) + Gaussian(engine, imu.acceNoise);
+        msg.linear_acceleration.y = acce(1) + Gaussian(engine, imu.acceNoise);
+        msg.linear_acceleration.z = acce(2) + Gaussian(engine, imu.acceNoise);
+        bag.write(imu.topic, msg.header.stamp, msg);
+    }
+    spdlog::info("imu '{}' simulated, frames: '{}'", imu.topic, stamps.size());
+}
+
+void SyntheticDataGenerator::WriteLiDAR(rosbag::Bag &bag,
+                                        const SimConfigor::LiDARInfo &lidar,
+                                        std::default_random_engine &engine) const {
+    const double span = 1.0 / lidar.frequency;
+    const int rings = lidar.rings, columns = lidar.columns;
+    const auto stamps = SensorStamps(lidar, lidar.frequency, span);
+    // the ray directions in the lidar frame, rings from the bottom to the top
+    std::vector<Eigen::Vector3d> dirs(static_cast<std::size_t>(rings) * columns);
+    for (int r = 0; r < rings; ++r) {
+        const double elevation =
+            rings > 1 ? (-0.5 + static_cast<double>(r) / (rings - 1)) * lidar.verticalFov : 0.0;
+        const double el = elevation * M_PI / 180.0;
+        for (int c = 0; c < columns; ++c) {
+            const double az = 2.0 * M_PI * c / columns;
+            dirs.at(r * columns + c) = {std::cos(el) * std::cos(az), std::cos(el) * std::sin(az),
+                                        std::sin(el)};
+        }
+    }
+
+    std::vector<double> ranges(dirs.size()), intensities(dirs.size());
+    for (double t : stamps) {
+        // a spinning lidar, columns are scanned one by one
+#pragma omp parallel for num_threads(omp_get_max_threads()) default(none) \
+    shared(lidar, rings, columns, span, t, dirs, ranges, intensities)
+        for (int c = 0; c < columns; ++c) {
+            const auto SE3_LToW = SensorPose(lidar, t + lidar.TO_SenToBr + span * c / columns);
+            for (int r = 0; r < rings; ++r) {
+                const int idx = r * columns + c;
+                if (!RayCast(SE3_LToW.translation(), SE3_LToW.so3() * dirs.at(idx),
+                             lidar.rangeMax, &ranges.at(idx), &intensities.at(idx))) {
+                    ranges.at(idx) = 0.0;
+                }
+            }
+        }
+
+        OusterPointCloud cloud;
+        cloud.width = columns;
+        cloud.height = rings;
+        cloud.is_dense = false;
+        cloud.resize(dirs.size());
+        for (int r = 0; r < rings; ++r) {
+            for (int c = 0; c < columns; ++c) {
+                const int idx = r * columns + c;
+                auto &p = cloud.at(c, r);
+                // missed rays are kept as zero points, which are removed by the depth range
+                const double range =
+                    ranges.at(idx) > 0.0 ? ranges.at(idx) + Gaussian(engine, lidar.rangeNoise)
+                                         : 0.0;
+                const Eigen::Vector3d pInL = range * dirs.at(idx);
+                p.x = static_cast<float>(pInL(0));
+                p.y = static_cast<float>(pInL(1));
+                p.z = static_cast<float>(pInL(2));
+                p.intensity = static_cast<float>(intensities.at(idx) * 255.0);
+                p.ring = static_cast<std::uint8_t>(r);
+                // relative time in nanoseconds
+                p.t = static_cast<std::uint32_t>(span * c / columns * 1E9);
+                p.range = static_cast<float>(range);
+            }
+        }
+        sensor_msgs::PointCloud2 msg;
+        pcl::toROSMsg(cloud, msg);
+        msg.header.stamp = ros::Time(_configor->_startTime + t);
+        msg.header.frame_id = lidar.topic;
+        bag.write(lidar.topic, msg.header.stamp, msg);
+    }
+    spdlog::info("lidar '{}' simulated, scans: '{}'", lidar.topic, stamps.size());
+}
+
+void SyntheticDataGenerator::WriteRadar(rosbag::Bag &bag,
+                                        const SimConfigor::RadarInfo &radar,
+                                        std::default_random_engine &engine) const {
+    std::uniform_real_distribution<double> azDist(-0.5 * radar.azimuthFov * M_PI / 180.0,
+                                                  0.5 * radar.azimuthFov * M_PI / 180.0);
+    std::uniform_real_distribution<double> elDist(-0.5 * radar.elevationFov * M_PI / 180.0,
+                                                  0.5 * radar.elevationFov * M_PI / 180.0);
+    const auto stamps = SensorStamps(radar, radar.frequency, 0.0);
+    for (double t : stamps) {
+        const double timeByBr = t + radar.TO_SenToBr;
+        const auto SE3_RToW = SensorPose(radar, timeByBr);
+        const Eigen::Vector3d LIN_VEL_RInR =
+            SE3_RToW.so3().inverse() * SensorVelocity(radar, timeByBr);
+
+        RadarPOSVCloud cloud;
+        for (int i = 0; i < 3 * radar.targetsPerScan &&
+                        static_cast<int>(cloud.size()) < radar.targetsPerScan;
+             ++i) {
+            const double az = azDist(engine), el = elDist(engine);
+            const Eigen::Vector3d dirInR(std::cos(el) * std::cos(az), std::cos(el) * std::sin(az),
+                                         std::sin(el));
+            double range, intensity;
+            if (!RayCast(SE3_RToW.translation(), SE3_RToW.so3() * dirInR, radar.rangeMax, &range,
+                         &intensity)) {
+                continue;
+            }
+            // targets are static, the radial velocity is that of the radar with respect to them
+            const Eigen::Vector3d tarInR = (range + Gaussian(engine, radar.rangeNoise)) * dirInR;
+            RadarTargetPOSV target;
+            target.x = static_cast<float>(tarInR(0));
+            target.y = static_cast<float>(tarInR(1));
+            target.z = static_cast<float>(tarInR(2));
+            target.velocity = static_cast<float>(-dirInR.dot(LIN_VEL_RInR) +
+                                                 Gaussian(engine, radar.velocityNoise));
+            cloud.push_back(target);
+        }
+        sensor_msgs::PointCloud2 msg;
+        pcl::toROSMsg(cloud, msg);
+        msg.header.stamp = ros::Time(_configor->_startTime + t);
+        msg.header.frame_id = radar.topic;
+        bag.write(radar.topic, msg.header.stamp, msg);
+    }
+    spdlog::info("radar '{}' simulated, scans: '{}'", radar.topic, stamps.size());
+}
+
+void SyntheticDataGenerator::WriteCamera(rosbag::Bag &bag,
+                                         const SimConfigor::CameraInfo &camera,
+                                         std::default_random_engine &engine) const {
+    const auto stamps = SensorStamps(camera, camera.frequency, camera.readoutTime);
+    for (double t : stamps) {
+        cv::Mat img = RenderImage(camera, camera.intri, t + camera.TO_SenToBr, camera.readoutTime);
+        cv::Mat gray(img.rows, img.cols, CV_8UC1);
+        for (int r = 0; r < img.rows; ++r) {
+            const auto *src = img.ptr<double>(r);
+            auto *dst = gray.ptr<std::uint8_t>(r);
+            for (int c = 0; c < img.cols; ++c) {
+                dst[c] = cv::saturate_cast<std::uint8_t>(src[c] * 255.0 +
+                                                         Gaussian(engine, camera.pixelNoise));
+            }
+        }
+        std_msgs::Header header;
+        header.stamp = ros::Time(_configor->_startTime + t);
+        header.frame_id = camera.topic;
+        bag.write(camera.topic, header.stamp,
+                  *cv_bridge::CvImage(header, sensor_msgs::image_encodings::MONO8, gray)
+                       .toImageMsg());
+    }
+    spdlog::info("camera '{}' simulated, images: '{}'", camera.topic, stamps.size());
+}
+
+void SyntheticDataGenerator::WriteEvent(rosbag::Bag &bag,
+                                        const SimConfigor::EventInfo &event) const {
+    const int width = event.intri.width, height = event.intri.height;
+    const double batchDt = 1.0 / event.frequency, threshold = event.contrastThreshold;
+    const auto stamps = SensorStamps(event, event.renderFrequency, 0.0);
+    if (stamps.empty()) {
+        return;
+    }
+
+    std::vector<ikalibr::DVSEvent> batch;
+    double batchEnd = stamps.front() + batchDt;
+    std::size_t batchCount = 0, eventCount = 0;
+    auto flush = [&]() {
+        if (batch.empty()) {
+            return;
+        }
+        ikalibr::DVSEventArray msg;
+        msg.header.stamp = batch.back().ts;
+        msg.header.frame_id = event.topic;
+        msg.height = height;
+        msg.width = width;
+        msg.events.swap(batch);
+        bag.write(event.topic, msg.header.stamp, msg);
+        ++batchCount, eventCount += msg.events.size();
+        batch.clear();
+    };
+
+    // log intensities at the last rendering, and the reference ones at the last events
+    cv::Mat lastLog, refLog;
+    std::vector<std::vector<ikalibr::DVSEvent>> rowEvents(height);
+    for (std::size_t i = 0; i < stamps.size(); ++i) {
+        const double t = stamps.at(i);
+        cv::Mat curLog = RenderImage(event, event.intri, t + event.TO_SenToBr, 0.0) + 1E-2;
+        cv::log(curLog, curLog);
+        if (i == 0) {
+            lastLog = curLog, refLog = curLog.clone();
+            continue;
+        }
+        const double lastTime = stamps.at(i - 1), startTime = _configor->_startTime;
+
+        // events between two renderings, the time of a crossing is interpolated linearly
+#pragma omp parallel for num_threads(omp_get_max_threads()) default(none) \
+    shared(height, width, threshold, curLog, lastLog, refLog, rowEvents, t, lastTime, startTime)
+        for (int r = 0; r < height; ++r) {
+            auto &events = rowEvents.at(r);
+            events.clear();
+            const auto *cur = curLog.ptr<double>(r), *last = lastLog.ptr<double>(r);
+            auto *ref = refLog.ptr<double>(r);
+            for (int c = 0; c < width; ++c) {
+                while (std::abs(cur[c] - ref[c]) >= threshold) {
+                    const bool polarity = cur[c] > ref[c];
+                    ref[c] += polarity ? threshold : -threshold;
+                    const double ratio =
+                        std::clamp((ref[c] - last[c]) / (cur[c] - last[c]), 0.0, 1.0);
+                    ikalibr::DVSEvent e;
+                    e.x = static_cast<std::uint16_t>(c);
+                    e.y = static_cast<std::uint16_t>(r);
+                    e.ts = ros::Time(startTime + lastTime + ratio * (t - lastTime));
+                    e.polarity = polarity;
+                    events.push_back(e);
+                }
+            }
+        }
+        std::vector<ikalibr::DVSEvent> events;
+        for (const auto &rowEvent : rowEvents) {
+            events.insert(events.end(), rowEvent.cbegin(), rowEvent.cend());
+        }
+        std::stable_sort(events.begin(), events.end(),
+                         [](const auto &e1, const auto &e2) { return e1.ts < e2.ts; });
+        for (const auto &e : events) {
+            if (e.ts.toSec() - _configor->_startTime >= batchEnd) {
+                flush();
+                while (e.ts.toSec() - _configor->_startTime >= batchEnd) {
+                    batchEnd += batchDt;
+                }
+            }
+            batch.push_back(e);
+        }
+        lastLog = curLog;
+    }
+    flush();
+    spdlog::info("event camera '{}' simulated, arrays: '{}', events: '{}'", event.topic,
+                 batchCount, eventCount);
+}
+
+CalibParamManager::Ptr SyntheticDataGenerator::GroundTruth() const {
+    std::vector<std::string> imuTopics, radarTopics, lidarTopics, cameraTopics, eventTopics;
+    auto topicOf = [](const auto &sensor) { return sensor.topic; };
+    std::transform(_configor->_imus.cbegin(), _configor->_imus.cend(),
+                   std::back_inserter(imuTopics), topicOf);
+    std::transform(_configor->_radars.cbegin(), _configor->_radars.cend(),
+                   std::back_inserter(radarTopics), topicOf);
+    std::transform(_configor->_lidars.cbegin(), _configor->_lidars.cend(),
+                   std::back_inserter(lidarTopics), topicOf);
+    std::transform(_configor->_cameras.cbegin(), _configor->_cameras.cend(),
+                   std::back_inserter(cameraTopics), topicOf);
+    std::transform(_configor->_events.cbegin(), _configor->_events.cend(),
+                   std::back_inserter(eventTopics), topicOf);
+    auto parMagr = CalibParamManager::Create(imuTopics, radarTopics, lidarTopics, cameraTopics,
+                                             {}, eventTopics);
+    for (const auto &s : _configor->_imus) {
+        parMagr->EXTRI.SO3_BiToBr.at(s.topic) = s.SO3_SenToBr();
+        parMagr->EXTRI.POS_BiInBr.at(s.topic) = s.POS_SenInBr;
+        parMagr->TEMPORAL.TO_BiToBr.at(s.topic) = s.TO_SenToBr;
+    }
+    for (const auto &s : _configor->_radars) {
+        parMagr->EXTRI.SO3_RjToBr.at(s.topic) = s.SO3_SenToBr();
+        parMagr->EXTRI.POS_RjInBr.at(s.topic) = s.POS_SenInBr;
+        parMagr->TEMPORAL.TO_RjToBr.at(s.topic) = s.TO_SenToBr;
+    }
+    for (const auto &s : _configor->_lidars) {
+        parMagr->EXTRI.SO3_LkToBr.at(s.topic) = s.SO3_SenToBr();
+        parMagr->EXTRI.POS_LkInBr.at(s.topic) = s.POS_SenInBr;
+        parMagr->TEMPORAL.TO_LkToBr.at(s.topic) = s.TO_SenToBr;
+    }
+    for (const auto &s : _configor->_cameras) {
+        parMagr->EXTRI.SO3_CmToBr.at(s.topic) = s.SO3_SenToBr();
+        parMagr->EXTRI.POS_CmInBr.at(s.topic) = s.POS_SenInBr;
+        parMagr->TEMPORAL.TO_CmToBr.at(s.topic) = s.TO_SenToBr;
+        parMagr->TEMPORAL.RS_READOUT.at(s.topic) = s.readoutTime;
+        parMagr->INTRI.Camera.at(s.topic) = s.intri.Intrinsics();
+    }
+    for (const auto &s : _configor->_events) {
+        parMagr->EXTRI.SO3_EsToBr.at(s.topic) = s.SO3_SenToBr();
+        parMagr->EXTRI.POS_EsInBr.at(s.topic) = s.POS_SenInBr;
+        parMagr->TEMPORAL.TO_EsToBr.at(s.topic) = s.TO_SenToBr;
+        parMagr->INTRI.Camera.at(s.topic) = s.intri.Intrinsics();
+    }
+    // expressed in the frame of the reference imu at the start of the simulation
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    parMagr->GRAVITY = so3Spline.Evaluate(so3Spline.MinTime()).inverse() * _gravity;
+    return parMagr;
+}
+
+void SyntheticDataGenerator::Process() {
+    const std::filesystem::path bagPath = _configor->_outputBagPath;
+    if (bagPath.has_parent_path() && !std::filesystem::exists(bagPath.parent_path()) &&
+        !std::filesystem::create_directories(bagPath.parent_path())) {
+        throw Status(Status::CRITICAL, "the folder to output rosbag can not be created: '{}'",
+                     bagPath.parent_path().string());
+    }
+    auto bag = std::make_unique<rosbag::Bag>();
+    bag->open(bagPath.string(), rosbag::BagMode::Write);
+
+    // one engine for noises of all streams, sensors are simulated in the configured order
+    std::default_random_engine engine(_configor->_seed + 2);
+    for (const auto &imu : _configor->_imus) {
+        WriteIMU(*bag, imu, engine);
+    }
+    for (const auto &lidar : _configor->_lidars) {
+        WriteLiDAR(*bag, lidar, engine);
+    }
+    for (const auto &radar : _configor->_radars) {
+        WriteRadar(*bag, radar, engine);
+    }
+    for (const auto &camera : _configor->_cameras) {
+        WriteCamera(*bag, camera, engine);
+    }
+    for (const auto &event : _configor->_events) {
+        WriteEvent(*bag, event);
+    }
+    bag->close();
+    spdlog::info("synthetic data have been written to '{}'", bagPath.string());
+
+    // the ground truth, and intrinsics of cameras to be used in the configure file of 'ikalibr'
+    auto prefix = bagPath.parent_path() / bagPath.stem();
+    auto truth = GroundTruth();
+    truth->Save(prefix.string() + "-truth.yaml", CerealArchiveType::Enum::YAML);
+    for (const auto &[topic, intri] : truth->INTRI.Camera) {
+        auto name = topic;
+        std::replace(name.begin(), name.end(), '/', '_');
+        const auto filename = prefix.string() + "-intri" + name + ".yaml";
+        CalibParamManager::ParIntri::SaveCameraIntri(intri, filename,
+                                                     CerealArchiveType::Enum::YAML);
+        spdlog::info("intrinsics of '{}' have been saved to '{}'", topic, filename);
+    }
+    spdlog::info("ground truth has been saved to '{}'", prefix.string() + "-truth.yaml");
+}
+}  // namespace ns_ikalibr
@@ -33,7 +33,11 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "sensor/camera.h"
+#include "config/configor.h"
 #include "spdlog/spdlog.h"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/imgcodecs.hpp"
+#include "util/memory_usage.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -41,11 +45,25 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+// the LRU cache of decoded lazy frames, the most recently used one is at the front
+static std::mutex DecodedFrameCacheMutex;
+static std::list<CameraFrame *> DecodedFrameCache;
+
+// the LRU cache of derived data of frames, the most recently used one is at the front
+static std::mutex DerivedDataCacheMutex;
+static std::list<CameraFrame::DerivedData *> DerivedDataCache;
+static std::size_t DerivedDataCacheBytes = 0;
+
 CameraFrame::CameraFrame(double timestamp, cv::Mat greyImg, cv::Mat colorImg, ns_veta::IndexT id)
     : _timestamp(timestamp),
       _greyImg(std::move(greyImg)),
       _colorImg(std::move(colorImg)),
-      _id(id) {
+      _id(id),
+      _decoder(nullptr),
+      _inDecodedCache(false),
+      _payloadBytes(0),
+      _greyOnly(false),
+      _colorDecoder(nullptr) {
     if (!greyImg.empty() && !colorImg.empty() && greyImg.size() != colorImg.size()) {
         spdlog::warn(
             "the size of grey image ({}x{}) is not the same as the one of color image ({}x{})!",
@@ -61,7 +79,117 @@ CameraFrame::Ptr CameraFrame::Create(double timestamp,
     return std::make_shared<CameraFrame>(timestamp, greyImg, colorImg, id);
 }
 
-cv::Mat &CameraFrame::GetImage() { return _greyImg; }
+CameraFrame::Ptr CameraFrame::CreateLazy(double timestamp,
+                                         Decoder decoder,
+                                         ns_veta::IndexT id,
+                                         std::size_t payloadBytes,
+                                         bool greyOnly) {
+    auto frame = std::make_shared<CameraFrame>(timestamp, cv::Mat(), cv::Mat(), id);
+    frame->_decoder = std::move(decoder);
+    frame->_payloadBytes = payloadBytes;
+    frame->_greyOnly = greyOnly;
+    return frame;
+}
+
+CameraFrame::Ptr CameraFrame::CreateGreyOnly(double timestamp,
+                                             const cv::Mat &greyImg,
+                                             Decoder decoder,
+                                             ns_veta::IndexT id,
+                                             std::size_t payloadBytes) {
+    auto frame = std::make_shared<CameraFrame>(timestamp, greyImg, cv::Mat(), id);
+    frame->_greyOnly = true;
+    if (decoder != nullptr) {
+        // the payload is kept only for the color image, which is not a lazy frame
+        frame->_colorDecoder = std::move(decoder);
+        frame->_payloadBytes = payloadBytes;
+    }
+    return frame;
+}
+
+CameraFrame::~CameraFrame() {
+    ReleaseDerivedData();
+    if (_decoder == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> cacheLock(DecodedFrameCacheMutex);
+    if (_inDecodedCache) {
+        DecodedFrameCache.erase(_decodedCacheIter);
+    }
+}
+
+bool CameraFrame::IsLazy() const { return _decoder != nullptr; }
+
+bool CameraFrame::IsGreyOnly() const { return _greyOnly; }
+
+std::size_t CameraFrame::GetMemoryBytes() const {
+    std::size_t bytes = MemoryUsage::MakeSharedBytes<CameraFrame>();
+    {
+        std::lock_guard<std::mutex> frameLock(_decodeMutex);
+        bytes += MemoryUsage::MatBytes(_greyImg) + MemoryUsage::MatBytes(_colorImg) +
+                 _payloadBytes;
+    }
+    std::lock_guard<std::mutex> frameLock(_derivedMutex);
+    std::lock_guard<std::mutex> cacheLock(DerivedDataCacheMutex);
+    for (const auto &[key, entry] : _derivedData) {
+        if (entry.inCache) {
+            bytes += entry.bytes;
+        }
+    }
+    return bytes;
+}
+
+cv::Mat CameraFrame::DecodeIfLazy() {
+    if (_decoder == nullptr) {
+        std::lock_guard<std::mutex> frameLock(_decodeMutex);
+        return _greyImg;
+    }
+    // the header taken under the lock shares the data, which outlives the eviction of this frame
+    cv::Mat greyImg;
+    // frames evicted from the cache, their images are released after unlocking this frame
+    std::vector<CameraFrame::Ptr> evicted;
+    {
+        std::lock_guard<std::mutex> frameLock(_decodeMutex);
+        if (_greyImg.empty()) {
+            cv::Mat colorImg = _decoder();
+            cv::cvtColor(colorImg, _greyImg, cv::COLOR_BGR2GRAY);
+            if (!_greyOnly) {
+                _colorImg = colorImg;
+            }
+        }
+        greyImg = _greyImg;
+        std::lock_guard<std::mutex> cacheLock(DecodedFrameCacheMutex);
+        if (_inDecodedCache) {
+            DecodedFrameCache.splice(DecodedFrameCache.begin(), DecodedFrameCache,
+                                     _decodedCacheIter);
+        } else {
+            DecodedFrameCache.push_front(this);
+            _decodedCacheIter = DecodedFrameCache.begin();
+            _inDecodedCache = true;
+        }
+        const std::size_t capacity = Configor::Preference::LazyImageCacheCapacity;
+        while (DecodedFrameCache.size() > std::max<std::size_t>(capacity, 1)) {
+            // the frame may be under destruction, where it can not be locked
+            auto frame = DecodedFrameCache.back();
+            frame->_inDecodedCache = false;
+            if (auto framePtr = frame->weak_from_this().lock(); framePtr != nullptr) {
+                evicted.push_back(framePtr);
+            }
+            DecodedFrameCache.pop_back();
+        }
+    }
+    for (const auto &frame : evicted) {
+        std::lock_guard<std::mutex> frameLock(frame->_decodeMutex);
+        std::lock_guard<std::mutex> cacheLock(DecodedFrameCacheMutex);
+        // this frame may be accessed and cached again in the meantime
+        if (!frame->_inDecodedCache) {
+            frame->_greyImg.release();
+            frame->_colorImg.release();
+        }
+    }
+    return greyImg;
+}
+
+cv::Mat CameraFrame::GetImage() { return DecodeIfLazy(); }
 
 double CameraFrame::GetTimestamp() const { return _timestamp; }
 
@@ -75,11 +203,130 @@ std::ostream &operator<<(std::ostream &os, const CameraFrame &frame) {
 void CameraFrame::ReleaseMat() {
     _greyImg.release();
     _colorImg.release();
+    ReleaseDerivedData();
+}
+
+bool CameraFrame::SpillToDisk(const std::string &filename) {
+    {
+        std::lock_guard<std::mutex> frameLock(_decodeMutex);
+        if (_decoder == nullptr) {
+            const cv::Mat &mat = _colorImg.empty() ? _greyImg : _colorImg;
+            if (mat.empty() || !cv::imwrite(filename, mat)) {
+                return false;
+            }
+            _decoder = [filename]() { return cv::imread(filename, cv::IMREAD_COLOR); };
+            _payloadBytes = filename.capacity();
+            _colorDecoder = nullptr;
+        }
+        _greyImg.release();
+        _colorImg.release();
+    }
+    ReleaseDerivedData();
+    return true;
+}
+
+std::shared_ptr<const void> CameraFrame::FindDerivedData(const std::string &key) {
+    std::lock_guard<std::mutex> frameLock(_derivedMutex);
+    auto iter = _derivedData.find(key);
+    if (iter == _derivedData.end()) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> cacheLock(DerivedDataCacheMutex);
+    auto &entry = iter->second;
+    // this product has been evicted, and would be released soon
+    if (!entry.inCache) {
+        return nullptr;
+    }
+    DerivedDataCache.splice(DerivedDataCache.begin(), DerivedDataCache, entry.cacheIter);
+    return entry.data;
+}
+
+std::shared_ptr<const void> CameraFrame::StoreDerivedData(const std::string &key,
+                                                          const std::shared_ptr<const void> &data,
+                                                          std::size_t bytes) {
+    // products of other frames evicted from the cache, released after unlocking this frame
+    std::vector<std::pair<CameraFrame::Ptr, std::string>> evicted;
+    {
+        std::lock_guard<std::mutex> frameLock(_derivedMutex);
+        std::lock_guard<std::mutex> cacheLock(DerivedDataCacheMutex);
+        auto &entry = _derivedData[key];
+        if (entry.inCache) {
+            return entry.data;
+        }
+        entry.owner = this;
+        entry.key = key;
+        entry.data = data;
+        entry.bytes = bytes;
+        entry.inCache = true;
+        DerivedDataCache.push_front(&entry);
+        entry.cacheIter = DerivedDataCache.begin();
+        DerivedDataCacheBytes += bytes;
+
+        const std::size_t budget = Configor::Preference::DerivedFrameDataBudget * 1024 * 1024;
+        // the product just stored is always kept
+        while (DerivedDataCacheBytes > budget && DerivedDataCache.size() > 1) {
+            auto evictedEntry = DerivedDataCache.back();
+            evictedEntry->inCache = false;
+            DerivedDataCacheBytes -= evictedEntry->bytes;
+            DerivedDataCache.pop_back();
+            if (evictedEntry->owner == this) {
+                const std::string evictedKey = evictedEntry->key;
+                _derivedData.erase(evictedKey);
+            } else if (auto frame = evictedEntry->owner->weak_from_this().lock();
+                       frame != nullptr) {
+                // the frame may be under destruction, where it can not be locked
+                evicted.emplace_back(frame, evictedEntry->key);
+            }
+        }
+    }
+    for (const auto &[frame, evictedKey] : evicted) {
+        std::lock_guard<std::mutex> frameLock(frame->_derivedMutex);
+        std::lock_guard<std::mutex> cacheLock(DerivedDataCacheMutex);
+        // this product may be computed and cached again in the meantime
+        if (auto iter = frame->_derivedData.find(evictedKey);
+            iter != frame->_derivedData.end() && !iter->second.inCache) {
+            frame->_derivedData.erase(iter);
+        }
+    }
+    return data;
+}
+
+void CameraFrame::ReleaseDerivedData() {
+    std::lock_guard<std::mutex> frameLock(_derivedMutex);
+    std::lock_guard<std::mutex> cacheLock(DerivedDataCacheMutex);
+    for (const auto &[key, entry] : _derivedData) {
+        if (entry.inCache) {
+            DerivedDataCache.erase(entry.cacheIter);
+            DerivedDataCacheBytes -= entry.bytes;
+        }
+    }
+    _derivedData.clear();
 }
 
 ns_veta::IndexT CameraFrame::GetId() const { return _id; }
 
 void CameraFrame::SetId(ns_veta::IndexT id) { _id = id; }
 
-cv::Mat &CameraFrame::GetColorImage() { return _colorImg; }
+cv::Mat CameraFrame::GetColorImage() { return DeriveColorIfGreyOnly(DecodeIfLazy()); }
+
+cv::Mat CameraFrame::DeriveColorIfGreyOnly(const cv::Mat &greyImg) {
+    std::lock_guard<std::mutex> frameLock(_decodeMutex);
+    if (!_colorImg.empty() || greyImg.empty()) {
+        return _colorImg;
+    }
+    cv::Mat colorImg;
+    if (_decoder != nullptr) {
+        colorImg = _decoder();
+    } else if (_colorDecoder != nullptr) {
+        colorImg = _colorDecoder();
+    } else {
+        cv::cvtColor(greyImg, colorImg, cv::COLOR_GRAY2BGR);
+    }
+    // the derived color image is kept until the frame is released (or evicted if lazy), unless
+    // this lazy frame has been evicted in the meantime
+    if (!_greyImg.empty()) {
+        _colorImg = colorImg;
+    }
+    return colorImg;
+}
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -38,6 +38,7 @@
 #include "cv_bridge/cv_bridge.h"
 #include "util/status.hpp"
 #include "spdlog/fmt/fmt.h"
+#include "config/configor.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -146,12 +147,30 @@ CameraFrame::Ptr SensorImageLoader::UnpackFrame(const rosbag::MessageInstance &m
     CheckMessage<sensor_msgs::Image>(msg);
     RefineImgMsgWrongEncoding(msg);
 
-    cv::Mat cImg, gImg;
-    cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::BGR8)->image.copyTo(cImg);
-    cv::cvtColor(cImg, gImg, cv::COLOR_BGR2GRAY);
     if (msg->header.stamp.isZero()) {
         Status(Status::WARNING, "camera image with zero timestamp exists!!!");
     }
+    const bool greyOnly = !Configor::IsColorImageRequired();
+    if (Configor::Preference::LazyImageDecoding) {
+        // the raw message is kept, and converted when the image is accessed
+        return CameraFrame::CreateLazy(
+            msg->header.stamp.toSec(),
+            [msg]() {
+                return cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::BGR8)->image;
+            },
+            ns_veta::UndefinedIndexT, sizeof(sensor_msgs::Image) + msg->data.capacity(),
+            greyOnly);
+    }
+    if (greyOnly) {
+        // the raw message is as large as the color image, thus colors are derived from the grey
+        return CameraFrame::CreateGreyOnly(
+            msg->header.stamp.toSec(),
+            cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::MONO8)->image);
+    }
+
+    cv::Mat cImg, gImg;
+    cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::BGR8)->image.copyTo(cImg);
+    cv::cvtColor(cImg, gImg, cv::COLOR_BGR2GRAY);
     return CameraFrame::Create(msg->header.stamp.toSec(), gImg, cImg);
 }
 
@@ -171,11 +190,27 @@ CameraFrame::Ptr SensorImageCompLoader::UnpackFrame(const rosbag::MessageInstanc
 
     CheckMessage<sensor_msgs::CompressedImage>(msg);
 
+    if (msg->header.stamp.isZero()) {
+        Status(Status::WARNING, "camera image with zero timestamp exists!!!");
+    }
+    const bool greyOnly = !Configor::IsColorImageRequired();
+    auto decoder = [msg]() {
+        return cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::BGR8)->image;
+    };
+    const std::size_t payloadBytes = sizeof(sensor_msgs::CompressedImage) + msg->data.capacity();
+    if (Configor::Preference::LazyImageDecoding) {
+        // the compressed message is kept, and decoded when the image is accessed
+        return CameraFrame::CreateLazy(msg->header.stamp.toSec(), decoder, ns_veta::UndefinedIndexT,
+                                       payloadBytes, greyOnly);
+    }
+
     cv::Mat cImg, gImg;
     cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::BGR8)->image.copyTo(cImg);
     cv::cvtColor(cImg, gImg, cv::COLOR_BGR2GRAY);
-    if (msg->header.stamp.isZero()) {
-        Status(Status::WARNING, "camera image with zero timestamp exists!!!");
+    if (greyOnly) {
+        // the compressed message is kept to decode the color image if it is required later
+        return CameraFrame::CreateGreyOnly(msg->header.stamp.toSec(), gImg, decoder,
+                                           ns_veta::UndefinedIndexT, payloadBytes);
     }
     return CameraFrame::Create(msg->header.stamp.toSec(), gImg, cImg);
 }
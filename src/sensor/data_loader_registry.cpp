@@ -0,0 +1,80 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "sensor/data_loader_registry.h"
+#include "util/status.hpp"
+#include "spdlog/spdlog.h"
+#include "dlfcn.h"
+#include "set"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+std::string DecodeCapabilityStr(DecodeCapability capability) {
+    std::string str;
+    for (const auto &item : {DecodeCapability::ZERO_COPY, DecodeCapability::BATCH_DECODE,
+                             DecodeCapability::SIMD_DECODE}) {
+        if ((capability & item) == item) {
+            str += (str.empty() ? "" : "|") + std::string(magic_enum::enum_name(item));
+        }
+    }
+    return str.empty() ? std::string(magic_enum::enum_name(DecodeCapability::NONE)) : str;
+}
+
+void LoadDataLoaderPlugins(const std::vector<std::string> &paths) {
+    static std::set<std::string> LOADED;
+    static std::mutex LOADED_MUTEX;
+    std::lock_guard<std::mutex> lock(LOADED_MUTEX);
+    for (const auto &path : paths) {
+        if (LOADED.count(path) != 0) {
+            continue;
+        }
+        /**
+         * the handle is never closed, as registered factories live in the plugin. Symbols are
+         * resolved globally, so that the plugin shares the registries of this library
+         */
+        if (dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL) == nullptr) {
+            const char *error = dlerror();
+            throw Status(Status::ERROR, "load the data loader plugin '{}' failed: {}", path,
+                         error != nullptr ? error : "unknown error");
+        }
+        LOADED.insert(path);
+        spdlog::info("data loader plugin '{}' is loaded", path);
+    }
+}
+
+}  // namespace ns_ikalibr
@@ -37,6 +37,9 @@
 #include "sensor_msgs/CompressedImage.h"
 #include "cv_bridge/cv_bridge.h"
 #include "util/status.hpp"
+#include "config/configor.h"
+#include "algorithm"
+#include "array"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -98,6 +101,92 @@ void DepthDataLoader::InverseMat(cv::Mat &floatMat) {
     }
 }
 
+void DepthDataLoader::OrganizeMat(cv::Mat &depthMat) const {
+    if (depthMat.type() == CV_16UC1 && !_isInverse) {
+        // raw 16-bit depths are kept, actual depths are recovered using the depth factor later
+    } else if (depthMat.type() != CV_32FC1) {
+        // todo: the alpha=1.0, beta=0.0, assume that the depth factor is not provided
+        depthMat.convertTo(depthMat, CV_32F, 1.0, 0.0);
+    }
+    if (_isInverse) {
+        InverseMat(depthMat);
+    }
+    if (!Configor::Preference::FilterDepthImages) {
+        return;
+    }
+    if (depthMat.type() == CV_16UC1) {
+        FilterMat<ushort>(depthMat);
+    } else {
+        FilterMat<float>(depthMat);
+    }
+}
+
+template <class Type>
+void DepthDataLoader::FilterMat(cv::Mat &depthMat) {
+    // the max relative difference of consistent neighboring depths
+    constexpr float CONSISTENCY_RATIO = 0.05f;
+    // depths with fewer consistent neighbors (in 8 ones) are speckles
+    constexpr int SPECKLE_NEIGHBORS = 2;
+    // holes with more consistent neighbors (in 8 ones) are filled
+    constexpr int HOLE_NEIGHBORS = 6;
+
+    const int rowCnt = depthMat.rows;
+    const int colCnt = depthMat.cols;
+
+    // invalid depths (non-finite or non-positive ones) are cleared as holes
+    for (int row = 0; row < rowCnt; ++row) {
+        auto dData = depthMat.ptr<Type>(row);
+        for (int col = 0; col < colCnt; ++col) {
+            if (!(dData[col] > Type(0)) || !std::isfinite(static_cast<float>(dData[col]))) {
+                dData[col] = Type(0);
+            }
+        }
+    }
+
+    // neighbors are queried from the cleared image, thus the result is independent of the order
+    const cv::Mat srcMat = depthMat.clone();
+    std::array<float, 8> neighbors{};
+    auto consistentCount = [&neighbors](int count, float depth) {
+        int consistent = 0;
+        for (int i = 0; i < count; ++i) {
+            consistent += std::abs(neighbors[i] - depth) <= CONSISTENCY_RATIO * depth;
+        }
+        return consistent;
+    };
+    for (int row = 1; row < rowCnt - 1; ++row) {
+        const auto upData = srcMat.ptr<Type>(row - 1);
+        const auto curData = srcMat.ptr<Type>(row);
+        const auto downData = srcMat.ptr<Type>(row + 1);
+        auto dData = depthMat.ptr<Type>(row);
+        for (int col = 1; col < colCnt - 1; ++col) {
+            int count = 0;
+            for (int c = col - 1; c <= col + 1; ++c) {
+                if (upData[c] > Type(0)) {
+                    neighbors[count++] = static_cast<float>(upData[c]);
+                }
+                if (downData[c] > Type(0)) {
+                    neighbors[count++] = static_cast<float>(downData[c]);
+                }
+                if (c != col && curData[c] > Type(0)) {
+                    neighbors[count++] = static_cast<float>(curData[c]);
+                }
+            }
+            if (const auto depth = static_cast<float>(curData[col]); depth > 0.0f) {
+                if (consistentCount(count, depth) < SPECKLE_NEIGHBORS) {
+                    dData[col] = Type(0);
+                }
+            } else if (count >= HOLE_NEIGHBORS) {
+                std::nth_element(neighbors.begin(), neighbors.begin() + count / 2,
+                                 neighbors.begin() + count);
+                const float median = neighbors[count / 2];
+                if (consistentCount(count, median) >= HOLE_NEIGHBORS) {
+                    dData[col] = static_cast<Type>(median);
+                }
+            }
+        }
+    }
+}
+
 // ----------------------
 // DepthSensorImageLoader
 // ----------------------
@@ -118,13 +207,7 @@ DepthFrame::Ptr DepthSensorImageLoader::UnpackFrame(const rosbag::MessageInstanc
     if (dImg.channels() != 1) {
         throw Status(Status::ERROR, "the channel of depth image dose not equal to 1!!!");
     }
-    if (dImg.type() != CV_32FC1) {
-        // todo: the alpha=1.0, beta=0.0, assume that the depth factor is not provided
-        dImg.convertTo(dImg, CV_32F, 1.0, 0.0);
-    }
-    if (_isInverse) {
-        InverseMat(dImg);
-    }
+    OrganizeMat(dImg);
     if (msg->header.stamp.isZero()) {
         Status(Status::WARNING, "depth image with zero timestamp exists!!!");
     }
@@ -154,13 +237,7 @@ DepthFrame::Ptr DepthSensorImageCompLoader::UnpackFrame(
     if (dImg.channels() != 1) {
         throw Status(Status::ERROR, "the channel of depth image dose not equal to 1!!!");
     }
-    if (dImg.type() != CV_32FC1) {
-        // todo: the alpha=1.0, beta=0.0, assume that the depth factor is not provided
-        dImg.convertTo(dImg, CV_32F, 1.0, 0.0);
-    }
-    if (_isInverse) {
-        InverseMat(dImg);
-    }
+    OrganizeMat(dImg);
     if (msg->header.stamp.isZero()) {
         Status(Status::WARNING, "depth image with zero timestamp exists!!!");
     }
@@ -34,6 +34,8 @@
 
 #include "sensor/event.h"
 #include "veta/camera/pinhole.h"
+#include "util/status.hpp"
+#include "util/memory_usage.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -59,34 +61,155 @@ bool Event::GetPolarity() const { return _polarity; }
 
 EventArray::EventArray(double timestamp, const std::vector<Event::Ptr>& events)
     : _timestamp(timestamp),
-      _events(events) {}
+      _timeBase(0.0) {
+    Reserve(events.size());
+    for (const auto& event : events) {
+        PushBack(event->GetTimestamp(), event->GetPos()(0), event->GetPos()(1),
+                 event->GetPolarity());
+    }
+}
+
+EventArray::EventArray(double timestamp,
+                       const std::vector<double>& eventTimes,
+                       const std::vector<PosScalar>& eventXs,
+                       const std::vector<PosScalar>& eventYs,
+                       const std::vector<std::uint8_t>& eventPolarities)
+    : _timestamp(timestamp),
+      _timeBase(0.0) {
+    if (eventTimes.size() != eventXs.size() || eventTimes.size() != eventYs.size() ||
+        eventTimes.size() != eventPolarities.size()) {
+        throw Status(Status::CRITICAL, "the sizes of packed event fields are not consistent!");
+    }
+    if (!eventTimes.empty()) {
+        _timeBase = *std::min_element(eventTimes.cbegin(), eventTimes.cend());
+    }
+    Reserve(eventTimes.size());
+    for (std::size_t i = 0; i < eventTimes.size(); ++i) {
+        PushBack(eventTimes[i], eventXs[i], eventYs[i], eventPolarities[i]);
+    }
+}
+
+EventArray::EventArray(double timestamp, double timeBase, std::vector<PackedEvent> events)
+    : _timestamp(timestamp),
+      _timeBase(timeBase),
+      _events(std::move(events)) {}
 
 EventArray::Ptr EventArray::Create(double timestamp, const std::vector<Event::Ptr>& events) {
     return std::make_shared<EventArray>(timestamp, events);
 }
 
-double EventArray::GetTimestamp() const { return _timestamp; }
+EventArray::Ptr EventArray::Create(double timestamp,
+                                   const std::vector<double>& eventTimes,
+                                   const std::vector<PosScalar>& eventXs,
+                                   const std::vector<PosScalar>& eventYs,
+                                   const std::vector<std::uint8_t>& eventPolarities) {
+    return std::make_shared<EventArray>(timestamp, eventTimes, eventXs, eventYs,
+                                        eventPolarities);
+}
+
+EventArray::Ptr EventArray::Create(double timestamp,
+                                   double timeBase,
+                                   std::vector<PackedEvent> events) {
+    return std::make_shared<EventArray>(timestamp, timeBase, std::move(events));
+}
 
-std::vector<Event::Ptr> EventArray::GetEvents() const { return _events; }
+double EventArray::GetTimestamp() const { return _timestamp; }
 
 void EventArray::SetTimestamp(double timestamp) { _timestamp = timestamp; }
 
-cv::Mat EventArray::DrawRawEventFrame(const ns_veta::PinholeIntrinsic::Ptr& intri) const {
-    cv::Mat eventFrame =
-        cv::Mat(static_cast<int>(intri->imgHeight), static_cast<int>(intri->imgWidth), CV_8UC3,
-                cv::Scalar(255, 255, 255));
+void EventArray::ShiftTimestamps(double dt) {
+    _timestamp += dt;
+    // offsets are relative, only the base time is shifted
+    _timeBase += dt;
+}
 
+void EventArray::Reserve(std::size_t size) { _events.reserve(size); }
+
+void EventArray::PushBack(double timestamp, PosScalar x, PosScalar y, bool polarity) {
+    if (_events.empty()) {
+        _timeBase = timestamp;
+    } else if (timestamp < _timeBase) {
+        Rebase(timestamp);
+    }
+    const auto offset = std::llround((timestamp - _timeBase) / TIME_RESOLUTION);
+    if (offset > MAX_OFFSET) {
+        throw Status(Status::CRITICAL,
+                     "the time span of events in an array is too long to be packed!!!");
+    }
+    _events.push_back({(static_cast<std::uint32_t>(offset) << 1) | (polarity ? 1u : 0u), x, y});
+}
+
+void EventArray::Rebase(double timeBase) {
+    const auto delta = std::llround((_timeBase - timeBase) / TIME_RESOLUTION);
+    for (auto& event : _events) {
+        if (event.Offset() + delta > MAX_OFFSET) {
+            throw Status(Status::CRITICAL,
+                         "the time span of events in an array is too long to be packed!!!");
+        }
+        event.offsetAndPolarity += static_cast<std::uint32_t>(delta) << 1;
+    }
+    _timeBase = timeBase;
+}
+
+std::size_t EventArray::GetEventCount() const { return _events.size(); }
+
+bool EventArray::IsEmpty() const { return _events.empty(); }
+
+const std::vector<EventArray::PackedEvent>& EventArray::GetPackedEvents() const {
+    return _events;
+}
+
+std::size_t EventArray::GetMemoryBytes() const {
+    return MemoryUsage::MakeSharedBytes<EventArray>() + MemoryUsage::VectorBytes(_events);
+}
+
+double EventArray::GetTimeBase() const { return _timeBase; }
+
+double EventArray::GetEventTime(std::size_t idx) const { return DecodeTime(_events[idx]); }
+
+EventArray::PosScalar EventArray::GetEventX(std::size_t idx) const { return _events[idx].x; }
+
+EventArray::PosScalar EventArray::GetEventY(std::size_t idx) const { return _events[idx].y; }
+
+Event::PosType EventArray::GetEventPos(std::size_t idx) const {
+    return {_events[idx].x, _events[idx].y};
+}
+
+bool EventArray::GetEventPolarity(std::size_t idx) const { return _events[idx].Polarity(); }
+
+std::size_t EventArray::LowerBound(double t) const {
+    auto iter = std::partition_point(_events.cbegin(), _events.cend(),
+                                     [this, t](const PackedEvent& e) { return DecodeTime(e) < t; });
+    return static_cast<std::size_t>(iter - _events.cbegin());
+}
+
+std::vector<Event::Ptr> EventArray::GetEvents() const {
+    std::vector<Event::Ptr> events(GetEventCount());
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        events[i] = Event::Create(GetEventTime(i), GetEventPos(i), GetEventPolarity(i));
+    }
+    return events;
+}
+
+void EventArray::DrawEventsOnFrame(cv::Mat& eventFrame) const {
     for (const auto& event : _events) {
         cv::Vec3b color;
-        if (event->GetPolarity()) {
+        if (event.Polarity()) {
             // red
             color = cv::Vec3b(0, 0, 255);
         } else {
             // blue
             color = cv::Vec3b(255, 0, 0);
         }
-        eventFrame.at<cv::Vec3b>(event->GetPos()(1), event->GetPos()(0)) = color;
+        eventFrame.at<cv::Vec3b>(event.y, event.x) = color;
     }
+}
+
+cv::Mat EventArray::DrawRawEventFrame(const ns_veta::PinholeIntrinsic::Ptr& intri) const {
+    cv::Mat eventFrame =
+        cv::Mat(static_cast<int>(intri->imgHeight), static_cast<int>(intri->imgWidth), CV_8UC3,
+                cv::Scalar(255, 255, 255));
+    DrawEventsOnFrame(eventFrame);
     return eventFrame;
 }
 
@@ -98,20 +221,70 @@ cv::Mat EventArray::DrawRawEventFrame(const std::vector<Ptr>::const_iterator& sI
                 cv::Scalar(255, 255, 255));
 
     for (auto iter = sIter; iter != eIter; ++iter) {
-        for (const auto& event : (*iter)->GetEvents()) {
-            cv::Vec3b color;
-            if (event->GetPolarity()) {
-                // red
-                color = cv::Vec3b(0, 0, 255);
-            } else {
-                // blue
-                color = cv::Vec3b(255, 0, 0);
-            }
-            eventFrame.at<cv::Vec3b>(event->GetPos()(1), event->GetPos()(0)) = color;
-        }
+        (*iter)->DrawEventsOnFrame(eventFrame);
     }
 
     return eventFrame;
 }
 
+/**
+ * EventArraySpan
+ */
+EventArraySpan::EventArraySpan(ArrayIter sIter, ArrayIter eIter, std::size_t sIdx, std::size_t eIdx)
+    : _sIter(std::move(sIter)),
+      _eIter(std::move(eIter)),
+      _sIdx(sIdx),
+      _eIdx(eIdx) {}
+
+EventArraySpan::EventArraySpan(const ArrayIter& sIter, const ArrayIter& eIter)
+    : _sIter(sIter),
+      _eIter(eIter),
+      _sIdx(0),
+      _eIdx(sIter == eIter ? 0 : (*std::prev(eIter))->GetEventCount()) {}
+
+EventArraySpan EventArraySpan::Extract(const std::vector<EventArray::Ptr>& data,
+                                       double st,
+                                       double et) {
+    // the min/max event timestamps of blocks, empty arrays are represented by their timestamps
+    auto MinTime = [](const EventArray::Ptr& ary) {
+        return ary->IsEmpty() ? ary->GetTimestamp() : ary->GetEventTime(0);
+    };
+    auto MaxTime = [](const EventArray::Ptr& ary) {
+        return ary->IsEmpty() ? ary->GetTimestamp() : ary->GetEventTime(ary->GetEventCount() - 1);
+    };
+    // the first block whose latest event is not before 'st'
+    auto sIter = std::partition_point(data.cbegin(), data.cend(), [&MaxTime, st](const auto& ary) {
+        return MaxTime(ary) < st;
+    });
+    // the first block whose earliest event is not before 'et'
+    auto eIter = std::partition_point(sIter, data.cend(), [&MinTime, et](const auto& ary) {
+        return MinTime(ary) < et;
+    });
+    if (sIter == eIter) {
+        return {sIter, eIter, 0, 0};
+    }
+    return {sIter, eIter, (*sIter)->LowerBound(st), (*std::prev(eIter))->LowerBound(et)};
+}
+
+const EventArraySpan::ArrayIter& EventArraySpan::ArraysBegin() const { return _sIter; }
+
+const EventArraySpan::ArrayIter& EventArraySpan::ArraysEnd() const { return _eIter; }
+
+std::pair<std::size_t, std::size_t> EventArraySpan::GetEventRange(const ArrayIter& iter) const {
+    std::size_t sIdx = iter == _sIter ? _sIdx : 0;
+    std::size_t eIdx = std::next(iter) == _eIter ? _eIdx : (*iter)->GetEventCount();
+    return {sIdx, std::max(sIdx, eIdx)};
+}
+
+std::size_t EventArraySpan::GetEventCount() const {
+    std::size_t count = 0;
+    for (auto iter = _sIter; iter != _eIter; ++iter) {
+        const auto [sIdx, eIdx] = GetEventRange(iter);
+        count += eIdx - sIdx;
+    }
+    return count;
+}
+
+bool EventArraySpan::IsEmpty() const { return GetEventCount() == 0; }
+
 }  // namespace ns_ikalibr
@@ -33,9 +33,74 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "sensor/imu.h"
+#include "util/memory_usage.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
-namespace ns_ikalibr {}
+namespace ns_ikalibr {
+
+IMUSampleStore::Ptr IMUSampleStore::Create() { return std::make_shared<IMUSampleStore>(); }
+
+IMUSampleStore::Ptr IMUSampleStore::Create(const std::vector<IMUFrame::Ptr> &frames) {
+    auto store = Create();
+    store->Reserve(frames.size());
+    for (const auto &frame : frames) {
+        store->Append(frame->GetTimestamp(), frame->GetGyro(), frame->GetAcce());
+    }
+    return store;
+}
+
+void IMUSampleStore::Reserve(std::size_t size) {
+    _timestamps.reserve(size);
+    _gyro.reserve(size);
+    _acce.reserve(size);
+}
+
+void IMUSampleStore::Append(double timestamp,
+                            const Eigen::Vector3d &gyro,
+                            const Eigen::Vector3d &acce) {
+    _timestamps.push_back(timestamp);
+    _gyro.push_back(gyro);
+    _acce.push_back(acce);
+}
+
+std::size_t IMUSampleStore::Size() const { return _timestamps.size(); }
+
+bool IMUSampleStore::Empty() const { return _timestamps.empty(); }
+
+const std::vector<double> &IMUSampleStore::GetTimestamps() const { return _timestamps; }
+
+double IMUSampleStore::GetTimestamp(std::size_t i) const { return _timestamps[i]; }
+
+const Eigen::Vector3d &IMUSampleStore::GetGyro(std::size_t i) const { return _gyro[i]; }
+
+const Eigen::Vector3d &IMUSampleStore::GetAcce(std::size_t i) const { return _acce[i]; }
+
+std::vector<IMUFrame::Ptr> IMUSampleStore::PackFrames() const {
+    auto packed = std::make_shared<std::vector<IMUFrame>>();
+    packed->reserve(Size());
+    for (std::size_t i = 0; i < Size(); ++i) {
+        packed->emplace_back(_timestamps[i], _gyro[i], _acce[i]);
+    }
+    std::vector<IMUFrame::Ptr> frames;
+    frames.reserve(packed->size());
+    for (auto &frame : *packed) {
+        // the aliasing constructor, no allocation is performed
+        frames.emplace_back(packed, &frame);
+    }
+    return frames;
+}
+
+std::size_t IMUSampleStore::GetMemoryBytes() const {
+    return MemoryUsage::VectorBytes(_timestamps) + MemoryUsage::VectorBytes(_gyro) +
+           MemoryUsage::VectorBytes(_acce);
+}
+
+std::size_t IMUSampleStore::PackedFramesBytes(const std::vector<IMUFrame::Ptr> &frames) {
+    return MemoryUsage::VectorBytes(frames) +
+           MemoryUsage::MakeSharedBytes<std::vector<IMUFrame>>() +
+           frames.size() * sizeof(IMUFrame);
+}
+}  // namespace ns_ikalibr
@@ -105,21 +105,46 @@ SensorIMULoader::Ptr SensorIMULoader::Create(IMUModelType imuModel,
 }
 
 IMUFrame::Ptr SensorIMULoader::UnpackFrame(const rosbag::MessageInstance &msgInstance) {
+    double timestamp;
+    Eigen::Vector3d gyro, acce;
+    UnpackSampleFrom(msgInstance, timestamp, gyro, acce);
+    return IMUFrame::Create(timestamp, gyro, acce);
+}
+
+IMUFrame::Ptr SensorIMULoader::UnpackFrame(const topic_tools::ShapeShifter &msg) {
+    double timestamp;
+    Eigen::Vector3d gyro, acce;
+    UnpackSampleFrom(msg, timestamp, gyro, acce);
+    return IMUFrame::Create(timestamp, gyro, acce);
+}
+
+void SensorIMULoader::UnpackFrame(const rosbag::MessageInstance &msgInstance,
+                                  IMUSampleStore &store) {
+    double timestamp;
+    Eigen::Vector3d gyro, acce;
+    UnpackSampleFrom(msgInstance, timestamp, gyro, acce);
+    store.Append(timestamp, gyro, acce);
+}
+
+template <class MsgSource>
+void SensorIMULoader::UnpackSampleFrom(const MsgSource &source,
+                                       double &timestamp,
+                                       Eigen::Vector3d &gyro,
+                                       Eigen::Vector3d &acce) {
     // imu data item
-    sensor_msgs::ImuConstPtr msg = msgInstance.instantiate<sensor_msgs::Imu>();
+    sensor_msgs::ImuConstPtr msg = source.template instantiate<sensor_msgs::Imu>();
 
     CheckMessage<sensor_msgs::Imu>(msg);
 
-    Eigen::Vector3d acce =
-        a2StdUnit * Eigen::Vector3d(msg->linear_acceleration.x, msg->linear_acceleration.y,
-                                    msg->linear_acceleration.z);
-    Eigen::Vector3d gyro =
+    acce = a2StdUnit * Eigen::Vector3d(msg->linear_acceleration.x, msg->linear_acceleration.y,
+                                       msg->linear_acceleration.z);
+    gyro =
         g2StdUnit *
         Eigen::Vector3d(msg->angular_velocity.x, msg->angular_velocity.y, msg->angular_velocity.z);
     if (msg->header.stamp.isZero()) {
         Status(Status::WARNING, "inertial measurement with zero timestamp exists!!!");
     }
-    return IMUFrame::Create(msg->header.stamp.toSec(), gyro, acce);
+    timestamp = msg->header.stamp.toSec();
 }
 
 // ------------
@@ -133,17 +158,42 @@ SbgIMULoader::Ptr SbgIMULoader::Create(IMUModelType imuModel) {
 }
 
 IMUFrame::Ptr SbgIMULoader::UnpackFrame(const rosbag::MessageInstance &msgInstance) {
+    double timestamp;
+    Eigen::Vector3d gyro, acce;
+    UnpackSampleFrom(msgInstance, timestamp, gyro, acce);
+    return IMUFrame::Create(timestamp, gyro, acce);
+}
+
+IMUFrame::Ptr SbgIMULoader::UnpackFrame(const topic_tools::ShapeShifter &msg) {
+    double timestamp;
+    Eigen::Vector3d gyro, acce;
+    UnpackSampleFrom(msg, timestamp, gyro, acce);
+    return IMUFrame::Create(timestamp, gyro, acce);
+}
+
+void SbgIMULoader::UnpackFrame(const rosbag::MessageInstance &msgInstance, IMUSampleStore &store) {
+    double timestamp;
+    Eigen::Vector3d gyro, acce;
+    UnpackSampleFrom(msgInstance, timestamp, gyro, acce);
+    store.Append(timestamp, gyro, acce);
+}
+
+template <class MsgSource>
+void SbgIMULoader::UnpackSampleFrom(const MsgSource &source,
+                                    double &timestamp,
+                                    Eigen::Vector3d &gyro,
+                                    Eigen::Vector3d &acce) {
     // imu data item
-    ikalibr::SbgImuData::ConstPtr msg = msgInstance.instantiate<ikalibr::SbgImuData>();
+    ikalibr::SbgImuData::ConstPtr msg = source.template instantiate<ikalibr::SbgImuData>();
 
     CheckMessage<ikalibr::SbgImuData>(msg);
 
-    Eigen::Vector3d acce = Eigen::Vector3d(msg->accel.x, msg->accel.y, msg->accel.z);
-    Eigen::Vector3d gyro = Eigen::Vector3d(msg->gyro.x, msg->gyro.y, msg->gyro.z);
+    acce = Eigen::Vector3d(msg->accel.x, msg->accel.y, msg->accel.z);
+    gyro = Eigen::Vector3d(msg->gyro.x, msg->gyro.y, msg->gyro.z);
     if (msg->header.stamp.isZero()) {
-        return IMUFrame::Create(msg->time_stamp * 1E-6, gyro, acce);
+        timestamp = msg->time_stamp * 1E-6;
     } else {
-        return IMUFrame::Create(msg->header.stamp.toSec(), gyro, acce);
+        timestamp = msg->header.stamp.toSec();
     }
 }
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -37,6 +37,7 @@
 //
 
 #include "sensor/lidar.h"
+#include "util/memory_usage.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -46,19 +47,62 @@ namespace ns_ikalibr {
 
 LiDARFrame::LiDARFrame(double timestamp, IKalibrPointCloud::Ptr scan)
     : _timestamp(timestamp),
-      _scan(std::move(scan)) {}
+      _width(0),
+      _height(0),
+      _isDense(true) {
+    if (scan == nullptr) {
+        return;
+    }
+    _width = scan->width, _height = scan->height, _isDense = scan->is_dense;
+    _header = scan->header;
+    _points.resize(scan->size());
+    for (std::size_t i = 0; i < scan->size(); ++i) {
+        const auto &p = scan->points[i];
+        auto &cp = _points[i];
+        cp.x = p.x, cp.y = p.y, cp.z = p.z;
+        cp.timeOffset = static_cast<float>(p.timestamp - _timestamp);
+    }
+}
 
 LiDARFrame::Ptr LiDARFrame::Create(double timestamp, const IKalibrPointCloud::Ptr &scan) {
     return std::make_shared<LiDARFrame>(timestamp, scan);
 }
 
-IKalibrPointCloud::Ptr LiDARFrame::GetScan() const { return this->_scan; }
+IKalibrPointCloud::Ptr LiDARFrame::GetScan() const {
+    IKalibrPointCloud::Ptr scan(new IKalibrPointCloud);
+    scan->header = _header;
+    scan->resize(_points.size());
+    scan->width = _width, scan->height = _height, scan->is_dense = _isDense;
+    for (std::size_t i = 0; i < _points.size(); ++i) {
+        const auto &cp = _points[i];
+        auto &p = scan->points[i];
+        p.x = cp.x, p.y = cp.y, p.z = cp.z;
+        p.timestamp = _timestamp + cp.timeOffset;
+    }
+    return scan;
+}
+
+const std::vector<CompactLiDARPoint> &LiDARFrame::GetCompactPoints() const { return _points; }
+
+std::uint32_t LiDARFrame::GetWidth() const { return _width; }
+
+std::uint32_t LiDARFrame::GetHeight() const { return _height; }
+
+std::size_t LiDARFrame::GetPointCount() const { return _points.size(); }
+
+double LiDARFrame::GetPointTimestamp(std::size_t i) const {
+    return _timestamp + _points[i].timeOffset;
+}
+
+std::size_t LiDARFrame::GetMemoryBytes() const {
+    return MemoryUsage::MakeSharedBytes<LiDARFrame>() + MemoryUsage::VectorBytes(_points);
+}
 
 double LiDARFrame::GetTimestamp() const { return _timestamp; }
 
 std::ostream &operator<<(std::ostream &os, const LiDARFrame &frame) {
-    os << "size: " << frame._scan->size() << ", width: " << frame._scan->width
-       << ", height: " << frame._scan->height << ", timestamp: " << frame._timestamp;
+    os << "size: " << frame._points.size() << ", width: " << frame._width
+       << ", height: " << frame._height << ", timestamp: " << frame._timestamp;
     return os;
 }
 
@@ -44,6 +44,7 @@
 #include "velodyne_msgs/VelodynePacket.h"
 #include "velodyne_pointcloud/pointcloudXYZIRT.h"
 #include "velodyne_pointcloud/rawdata.h"
+#include "cstring"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -51,35 +52,157 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+template class DataLoaderRegistry<LiDARDataLoader>;
+
+// built-in loaders, points of 'sensor_msgs::PointCloud2' are converted via field offsets
+IKALIBR_REGISTER_DATA_LOADER(LiDARDataLoader, "VLP_16_PACKET", "Velodyne16",
+                             DecodeCapability::BATCH_DECODE | DecodeCapability::SIMD_DECODE,
+                             [] { return Velodyne16::Create(LidarModelType::VLP_16_PACKET); })
+IKALIBR_REGISTER_DATA_LOADER(LiDARDataLoader, "VLP_POINTS", "VelodynePoints",
+                             DecodeCapability::ZERO_COPY,
+                             [] { return VelodynePoints::Create(LidarModelType::VLP_POINTS); })
+IKALIBR_REGISTER_DATA_LOADER(LiDARDataLoader, "OUSTER_POINTS", "OusterLiDAR",
+                             DecodeCapability::ZERO_COPY,
+                             [] { return OusterLiDAR::Create(LidarModelType::OUSTER_POINTS); })
+IKALIBR_REGISTER_DATA_LOADER(LiDARDataLoader, "PANDAR_XT_POINTS", "PandarXTLiDAR",
+                             DecodeCapability::ZERO_COPY,
+                             [] { return PandarXTLiDAR::Create(LidarModelType::PANDAR_XT_POINTS); })
+IKALIBR_REGISTER_DATA_LOADER(LiDARDataLoader, "LIVOX_CUSTOM", "LivoxLiDAR",
+                             DecodeCapability::NONE,
+                             [] { return LivoxLiDAR::Create(LidarModelType::LIVOX_CUSTOM); })
+
 LiDARDataLoader::Ptr LiDARDataLoader::GetLoader(const std::string &lidarModelStr) {
-    // try extract lidar model
-    LidarModelType lidarModel;
-    try {
-        lidarModel = EnumCast::stringToEnum<LidarModelType>(lidarModelStr);
-    } catch (...) {
+    // the fastest registered decoder (built-in or from plugins) of the lidar model
+    auto dataLoader = DataLoaderRegistry<LiDARDataLoader>::Create(lidarModelStr);
+    if (dataLoader == nullptr) {
         throw Status(Status::WARNING, LidarModel::UnsupportedLiDARModelMsg(lidarModelStr));
     }
-    LiDARDataLoader::Ptr dataLoader;
-    switch (lidarModel) {
-        case LidarModelType::VLP_16_PACKET:
-            dataLoader = Velodyne16::Create(lidarModel);
-            break;
-        case LidarModelType::VLP_POINTS:
-            dataLoader = VelodynePoints::Create(lidarModel);
-            break;
-        case LidarModelType::OUSTER_POINTS:
-            dataLoader = OusterLiDAR::Create(lidarModel);
+    return dataLoader;
+}
+
+LiDARDataLoader::PointCloud2Layout LiDARDataLoader::GetPointCloud2Layout(
+    const sensor_msgs::PointCloud2 &msg, const std::string &timeField) {
+    std::lock_guard<std::mutex> lock(_layoutMutex);
+
+    bool changed = _layout.fields.size() != msg.fields.size();
+    for (std::size_t i = 0; !changed && i < msg.fields.size(); ++i) {
+        const auto &[name, offset, datatype] = _layout.fields.at(i);
+        const auto &field = msg.fields.at(i);
+        changed = name != field.name || offset != field.offset || datatype != field.datatype;
+    }
+    if (!changed) {
+        return _layout;
+    }
+
+    // recognize the layout
+    PointCloud2Layout layout;
+    int foundCount = 0;
+    for (const auto &field : msg.fields) {
+        layout.fields.emplace_back(field.name, field.offset, field.datatype);
+        if (field.count != 1) {
+            continue;
+        }
+        if (field.datatype == sensor_msgs::PointField::FLOAT32) {
+            if (field.name == "x") {
+                layout.xOffset = field.offset, ++foundCount;
+            } else if (field.name == "y") {
+                layout.yOffset = field.offset, ++foundCount;
+            } else if (field.name == "z") {
+                layout.zOffset = field.offset, ++foundCount;
+            }
+        }
+        if (field.name == timeField && (field.datatype == sensor_msgs::PointField::FLOAT32 ||
+                                        field.datatype == sensor_msgs::PointField::FLOAT64 ||
+                                        field.datatype == sensor_msgs::PointField::UINT32)) {
+            layout.timeOffset = field.offset, layout.timeDatatype = field.datatype, ++foundCount;
+        }
+    }
+    layout.supported = foundCount == 4;
+    if (!layout.supported) {
+        spdlog::warn(
+            "field layout of point clouds for '{}' LiDAR is not recognized, use the slow "
+            "pcl-based conversion instead!",
+            EnumCast::enumToString(GetLiDARModel()));
+    }
+    _layout = layout;
+    return _layout;
+}
+
+IKalibrPointCloud::Ptr LiDARDataLoader::UnpackPointCloud2(const sensor_msgs::PointCloud2 &msg,
+                                                          const std::string &timeField,
+                                                          double timebase,
+                                                          double timeScale,
+                                                          double depthMin,
+                                                          double depthMax) {
+    const auto layout = GetPointCloud2Layout(msg, timeField);
+    if (!layout.supported || msg.is_bigendian ||
+        msg.data.size() < static_cast<std::size_t>(msg.row_step) * msg.height) {
+        return nullptr;
+    }
+    // the offsets of fields should be in a point
+    const std::uint32_t timeSize = layout.timeDatatype == sensor_msgs::PointField::FLOAT64 ? 8 : 4;
+    if (std::max({layout.xOffset, layout.yOffset, layout.zOffset}) + 4 > msg.point_step ||
+        layout.timeOffset + timeSize > msg.point_step ||
+        static_cast<std::size_t>(msg.point_step) * msg.width > msg.row_step) {
+        return nullptr;
+    }
+    // x, y, z are usually stored contiguously, they can be copied at once
+    const bool xyzContiguous =
+        layout.yOffset == layout.xOffset + 4 && layout.zOffset == layout.xOffset + 8;
+
+    IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud);
+    cloud->is_dense = false;
+    cloud->resize(static_cast<std::size_t>(msg.width) * msg.height);
+
+    auto convert = [&](auto timeTag) {
+        using TimeType = decltype(timeTag);
+        std::size_t j = 0;
+        for (std::uint32_t row = 0; row < msg.height; ++row) {
+            const std::uint8_t *ptr =
+                msg.data.data() + static_cast<std::size_t>(row) * msg.row_step;
+            for (std::uint32_t col = 0; col < msg.width; ++col, ptr += msg.point_step) {
+                float xyz[3];
+                if (xyzContiguous) {
+                    std::memcpy(xyz, ptr + layout.xOffset, sizeof(xyz));
+                } else {
+                    std::memcpy(xyz + 0, ptr + layout.xOffset, sizeof(float));
+                    std::memcpy(xyz + 1, ptr + layout.yOffset, sizeof(float));
+                    std::memcpy(xyz + 2, ptr + layout.zOffset, sizeof(float));
+                }
+                if (std::isnan(xyz[0]) || std::isnan(xyz[1]) || std::isnan(xyz[2])) {
+                    continue;
+                }
+                double depth = std::sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+                if (depth > depthMax || depth < depthMin) {
+                    continue;
+                }
+                TimeType time;
+                std::memcpy(&time, ptr + layout.timeOffset, sizeof(TimeType));
+
+                IKalibrPoint &dstPoint = cloud->points[j++];
+                dstPoint.x = xyz[0];
+                dstPoint.y = xyz[1];
+                dstPoint.z = xyz[2];
+                dstPoint.timestamp = timebase + static_cast<double>(time) * timeScale;
+            }
+        }
+        cloud->resize(j);
+    };
+
+    switch (layout.timeDatatype) {
+        case sensor_msgs::PointField::FLOAT32:
+            convert(float{});
             break;
-        case LidarModelType::PANDAR_XT_POINTS:
-            dataLoader = PandarXTLiDAR::Create(lidarModel);
+        case sensor_msgs::PointField::FLOAT64:
+            convert(double{});
             break;
-        case LidarModelType::LIVOX_CUSTOM:
-            dataLoader = LivoxLiDAR::Create(lidarModel);
+        case sensor_msgs::PointField::UINT32:
+            convert(std::uint32_t{});
             break;
         default:
-            throw Status(Status::WARNING, LidarModel::UnsupportedLiDARModelMsg(lidarModelStr));
+            return nullptr;
     }
-    return dataLoader;
+    return cloud;
 }
 
 LidarModelType LiDARDataLoader::GetLiDARModel() const { return _lidarModel; }
@@ -114,36 +237,38 @@ LiDARFrame::Ptr Velodyne16::UnpackScan(
     if (lidarMsg->header.stamp.isZero()) {
         Status(Status::WARNING, "lidar scan with zero timestamp exists!!!");
     }
-    LiDARFrame::Ptr output = LiDARFrame::Create(lidarMsg->header.stamp.toSec());
+    return UnpackPackets(lidarMsg->packets, lidarMsg->header.stamp.toSec());
+}
 
+LiDARFrame::Ptr Velodyne16::UnpackPackets(const std::vector<velodyne_msgs::VelodynePacket> &packets,
+                                          double scanTimestamp) const {
     // point cloud
-    auto scan = output->GetScan();
+    IKalibrPointCloud::Ptr scan(new IKalibrPointCloud);
     scan->height = 16;
-    scan->width = 24 * (int)lidarMsg->packets.size();
+    scan->width = 24 * (int)packets.size();
     scan->is_dense = false;
     scan->resize(scan->height * scan->width);
     for (auto &p : scan->points) {
         SET_POS_NAN(p)
     }
 
-    int blockCounter = 0;
-
-    double scanTimestamp = lidarMsg->header.stamp.toSec();
-
-    for (const auto &packet : lidarMsg->packets) {
-        float azimuth;
-        float azimuthDiff;
+    // firings (columns of the scan) of all packets, each has 'SCANS_PER_FIRING' lasers
+    const int firingCount = static_cast<int>(packets.size()) * BLOCKS_PER_PACKET * 2;
+    const int pointCount = firingCount * SCANS_PER_FIRING;
+
+    /**
+     * gather: ranges and corrected azimuth bins of all lasers are decoded from raw packets, stored
+     * firing by firing. The azimuth of a laser is interpolated by the azimuth difference between
+     * the current and next block
+     */
+    std::vector<float> distances(pointCount), xs(pointCount), ys(pointCount), zs(pointCount);
+    std::vector<int> azimuthBins(pointCount);
+    for (int i = 0; i < static_cast<int>(packets.size()); ++i) {
+        const auto *raw = (const RAW_PACKET_T *)&packets.at(i).data[0];
         float lastAzimuthDiff = 0;
-        float azimuthCorrectedF;
-        int azimuthCorrected;
-        float x, y, z;
-
-        const auto *raw = (const RAW_PACKET_T *)&packet.data[0];
-
-        for (int block = 0; block < BLOCKS_PER_PACKET; block++, blockCounter++) {
-            // Calculate difference between current and next block's azimuth angle.
-            azimuth = (float)(raw->blocks[block].rotation);
-
+        for (int block = 0; block < BLOCKS_PER_PACKET; block++) {
+            const auto azimuth = (float)(raw->blocks[block].rotation);
+            float azimuthDiff;
             if (block < (BLOCKS_PER_PACKET - 1)) {
                 azimuthDiff = (float)((ROTATION_MAX_UNITS + raw->blocks[block + 1].rotation -
                                        raw->blocks[block].rotation) %
@@ -152,78 +277,77 @@ LiDARFrame::Ptr Velodyne16::UnpackScan(
             } else {
                 azimuthDiff = lastAzimuthDiff;
             }
-
-            for (int firing = 0, k = 0; firing < FIRINGS_PER_BLOCK; firing++) {
-                for (int dsr = 0; dsr < SCANS_PER_FIRING; dsr++, k += RAW_SCAN_SIZE) {
-                    /** Position Calculation */
+            const uint8_t *data = raw->blocks[block].data;
+            for (int firing = 0; firing < FIRINGS_PER_BLOCK; firing++) {
+                const int base = ((i * BLOCKS_PER_PACKET + block) * 2 + firing) * SCANS_PER_FIRING;
+                const uint8_t *firingData = data + firing * SCANS_PER_FIRING * RAW_SCAN_SIZE;
+                for (int dsr = 0; dsr < SCANS_PER_FIRING; dsr++) {
+                    const uint8_t *laser = firingData + dsr * RAW_SCAN_SIZE;
                     union TwoBytes tmp{};
-                    tmp.bytes[0] = raw->blocks[block].data[k];
-                    tmp.bytes[1] = raw->blocks[block].data[k + 1];
-
-                    /** correct for the laser rotation as a function of timing during
-                     * the firings **/
-                    azimuthCorrectedF =
-                        azimuth + (azimuthDiff *
-                                   (((float)dsr * DSR_TOFFSET) + ((float)firing * FIRING_TOFFSET)) /
-                                   BLOCK_TDURATION);
-
-                    azimuthCorrected = ((int)round(azimuthCorrectedF)) % ROTATION_MAX_UNITS;
-
-                    /*condition added to avoid calculating points which are not
-                  in the interesting defined area (minAngle < area < maxAngle)*/
-                    if ((azimuthCorrected >= CONFIG.minAngle &&
-                         azimuthCorrected <= CONFIG.maxAngle &&
-                         CONFIG.minAngle < CONFIG.maxAngle) ||
-                        (CONFIG.minAngle > CONFIG.maxAngle &&
-                         (azimuthCorrected <= CONFIG.maxAngle ||
-                          azimuthCorrected >= CONFIG.minAngle))) {
-                        // convert polar coordinates to Euclidean XYZ
-                        float distance = (float)tmp.uint * DISTANCE_RESOLUTION;
-
-                        float cos_vert_angle = COS_VERT_ANGLE[dsr];
-                        float sin_vert_angle = SIN_VERT_ANGLE[dsr];
-
-                        float cos_rot_angle = COS_ROT_TABLE[azimuthCorrected];
-                        float sin_rot_angle = SIN_ROT_TABLE[azimuthCorrected];
-
-                        x = distance * cos_vert_angle * sin_rot_angle;
-                        y = distance * cos_vert_angle * cos_rot_angle;
-                        z = distance * sin_vert_angle;
-
-                        /** Use standard ROS coordinate system (right-hand rule) */
-                        float x_coord = y;
-                        float y_coord = -x;
-                        float z_coord = z;
-
-                        // attention: use 'PointXYZT' as 'IKalibrPoint' rather than 'PointXYZIT'
-                        // here float intensity = raw->blocks[block].data[k + 2];
-                        double point_timestamp =
-                            scanTimestamp + GetExactTime(dsr, 2 * blockCounter + firing);
-
-                        IKalibrPoint point_xyz;
-                        point_xyz.timestamp = point_timestamp;
-
-                        if (PointInRange(distance)) {
-                            point_xyz.x = x_coord;
-                            point_xyz.y = y_coord;
-                            point_xyz.z = z_coord;
-                            // attention: use 'PointXYZT' as 'IKalibrPoint' rather than 'PointXYZIT'
-                            // here point_xyz.intensity = intensity;
-                        } else {
-                            SET_POS_NAN(point_xyz)
-                        }
-
-                        scan->at(2 * blockCounter + firing, SCAN_MAPPING_16[dsr]) = point_xyz;
-                    }
+                    tmp.bytes[0] = laser[0];
+                    tmp.bytes[1] = laser[1];
+                    distances[base + dsr] = (float)tmp.uint * DISTANCE_RESOLUTION;
+                    azimuthBins[base + dsr] =
+                        ((int)round(azimuth + azimuthDiff * AZIMUTH_TOFFSET_FACTOR[firing][dsr])) %
+                        ROTATION_MAX_UNITS;
                 }
             }
         }
     }
 
-    return output;
+    /**
+     * compute: polar coordinates are converted to Euclidean ones (in ros coordinate system, i.e.,
+     * the right-hand rule) with table lookups only, which is vectorized laser-wise
+     */
+    for (int f = 0; f < firingCount; ++f) {
+        const float *dist = distances.data() + f * SCANS_PER_FIRING;
+        const int *bins = azimuthBins.data() + f * SCANS_PER_FIRING;
+        float *x = xs.data() + f * SCANS_PER_FIRING;
+        float *y = ys.data() + f * SCANS_PER_FIRING;
+        float *z = zs.data() + f * SCANS_PER_FIRING;
+#pragma omp simd
+        for (int dsr = 0; dsr < 16; ++dsr) {
+            const float xy = dist[dsr] * COS_VERT_ANGLE[dsr];
+            x[dsr] = xy * COS_ROT_TABLE[bins[dsr]];
+            y[dsr] = -xy * SIN_ROT_TABLE[bins[dsr]];
+            z[dsr] = dist[dsr] * SIN_VERT_ANGLE[dsr];
+        }
+    }
+
+    // organize: points in the interesting area are assigned to the scan
+    for (int f = 0; f < firingCount; ++f) {
+        for (int dsr = 0; dsr < SCANS_PER_FIRING; ++dsr) {
+            const int idx = f * SCANS_PER_FIRING + dsr;
+            const int azimuthCorrected = azimuthBins[idx];
+            /*condition added to avoid calculating points which are not
+            in the interesting defined area (minAngle < area < maxAngle)*/
+            if (!((azimuthCorrected >= CONFIG.minAngle && azimuthCorrected <= CONFIG.maxAngle &&
+                   CONFIG.minAngle < CONFIG.maxAngle) ||
+                  (CONFIG.minAngle > CONFIG.maxAngle && (azimuthCorrected <= CONFIG.maxAngle ||
+                                                         azimuthCorrected >= CONFIG.minAngle)))) {
+                continue;
+            }
+            // attention: use 'PointXYZT' as 'IKalibrPoint' rather than 'PointXYZIT' here
+            IKalibrPoint point_xyz;
+            point_xyz.timestamp = scanTimestamp + GetExactTime(dsr, f);
+            if (PointInRange(distances[idx])) {
+                point_xyz.x = xs[idx];
+                point_xyz.y = ys[idx];
+                point_xyz.z = zs[idx];
+            } else {
+                SET_POS_NAN(point_xyz)
+            }
+            scan->at(f, SCAN_MAPPING_16[dsr]) = point_xyz;
+        }
+    }
+
+    // the scan is stored compactly in the frame
+    return LiDARFrame::Create(scanTimestamp, scan);
 }
 
-double Velodyne16::GetExactTime(int dsr, int firing) const { return VLP16_TIME_BLOCK[firing][dsr]; }
+double Velodyne16::GetExactTime(int dsr, int firing) {
+    return dsr * 2.304 * 1e-6 + firing * 55.296 * 1e-6;
+}
 
 void Velodyne16::SetParameters() {
     CONFIG.maxRange = 150;
@@ -272,9 +396,10 @@ void Velodyne16::SetParameters() {
     SCAN_MAPPING_16[2] = 14;
     SCAN_MAPPING_16[0] = 15;
 
-    for (unsigned int w = 0; w < 1824; w++) {
-        for (unsigned int h = 0; h < 16; h++) {
-            VLP16_TIME_BLOCK[w][h] = h * 2.304 * 1e-6 + w * 55.296 * 1e-6;  //  16*1824
+    for (int firing = 0; firing < FIRINGS_PER_BLOCK; firing++) {
+        for (int dsr = 0; dsr < SCANS_PER_FIRING; dsr++) {
+            AZIMUTH_TOFFSET_FACTOR[firing][dsr] =
+                ((float)dsr * DSR_TOFFSET + (float)firing * FIRING_TOFFSET) / BLOCK_TDURATION;
         }
     }
 }
@@ -299,14 +424,20 @@ LiDARFrame::Ptr VelodynePoints::UnpackScan(const rosbag::MessageInstance &msgIns
 
     CheckMessage<sensor_msgs::PointCloud2>(lidarMsg);
 
-    PosIRTPointCloud pcIn;
-    pcl::fromROSMsg(*lidarMsg, pcIn);
-
     if (lidarMsg->header.stamp.isZero()) {
         Status(Status::WARNING, "lidar scan with zero timestamp exists!!!");
     }
     double timebase = lidarMsg->header.stamp.toSec();
 
+    // fast path: relative time in seconds
+    if (auto cloud = UnpackPointCloud2(*lidarMsg, "time", timebase, 1.0, 1.0, 200.0);
+        cloud != nullptr) {
+        return LiDARFrame::Create(timebase, cloud);
+    }
+
+    PosIRTPointCloud pcIn;
+    pcl::fromROSMsg(*lidarMsg, pcIn);
+
     IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud());
     cloud->is_dense = false;
     cloud->resize(pcIn.size());
@@ -353,14 +484,20 @@ LiDARFrame::Ptr OusterLiDAR::UnpackScan(const rosbag::MessageInstance &msgInstan
 
     CheckMessage<sensor_msgs::PointCloud2>(lidarMsg);
 
-    OusterPointCloud pcIn;
-    pcl::fromROSMsg(*lidarMsg, pcIn);
-
     if (lidarMsg->header.stamp.isZero()) {
         Status(Status::WARNING, "lidar scan with zero timestamp exists!!!");
     }
     double timebase = lidarMsg->header.stamp.toSec();
 
+    // fast path: relative time in nanoseconds
+    if (auto cloud = UnpackPointCloud2(*lidarMsg, "t", timebase, 1E-9, 1.0, 60.0);
+        cloud != nullptr) {
+        return LiDARFrame::Create(timebase, cloud);
+    }
+
+    OusterPointCloud pcIn;
+    pcl::fromROSMsg(*lidarMsg, pcIn);
+
     IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud());
     cloud->is_dense = false;
     cloud->resize(pcIn.size());
@@ -407,14 +544,20 @@ LiDARFrame::Ptr PandarXTLiDAR::UnpackScan(const rosbag::MessageInstance &msgInst
 
     CheckMessage<sensor_msgs::PointCloud2>(lidarMsg);
 
-    PandarPointCloud pcIn;
-    pcl::fromROSMsg(*lidarMsg, pcIn);
-
     if (lidarMsg->header.stamp.isZero()) {
         Status(Status::WARNING, "lidar scan with zero timestamp exists!!!");
     }
     double timebase = lidarMsg->header.stamp.toSec();
 
+    // fast path: absolute time in seconds
+    if (auto cloud = UnpackPointCloud2(*lidarMsg, "timestamp", 0.0, 1.0, 1.0, 100.0);
+        cloud != nullptr) {
+        return LiDARFrame::Create(timebase, cloud);
+    }
+
+    PandarPointCloud pcIn;
+    pcl::fromROSMsg(*lidarMsg, pcIn);
+
     /// point cloud
     IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud);
     cloud->is_dense = false;
@@ -34,6 +34,7 @@
 
 #include "sensor/radar.h"
 #include "ctraj/utils/utils.hpp"
+#include "util/memory_usage.hpp"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -79,19 +80,140 @@ double RadarTarget::GetRange() const { return _range; }
 
 double RadarTarget::GetInvRange() const { return _invRange; }
 
+// --------------
+// RadarTargetSoA
+// --------------
+
+RadarTargetSoA::RadarTargetSoA(Eigen::Index size)
+    : timestamps(size),
+      ranges(size),
+      azimuths(size),
+      elevations(size),
+      radialVels(size),
+      dirs(3, size) {}
+
+RadarTargetSoA RadarTargetSoA::FromTargets(const std::vector<RadarTarget::Ptr> &targets) {
+    RadarTargetSoA soa(static_cast<Eigen::Index>(targets.size()));
+    for (Eigen::Index i = 0; i < soa.Size(); ++i) {
+        const auto &tar = targets[i];
+        soa.Set(i, tar->GetTimestamp(), tar->GetTargetXYZ(), tar->GetRadialVelocity());
+    }
+    return soa;
+}
+
+Eigen::Index RadarTargetSoA::Size() const { return timestamps.size(); }
+
+void RadarTargetSoA::Resize(Eigen::Index size) {
+    timestamps.conservativeResize(size);
+    ranges.conservativeResize(size);
+    azimuths.conservativeResize(size);
+    elevations.conservativeResize(size);
+    radialVels.conservativeResize(size);
+    dirs.conservativeResize(Eigen::NoChange, size);
+}
+
+void RadarTargetSoA::Set(Eigen::Index i,
+                         double timestamp,
+                         const Eigen::Vector3d &xyz,
+                         double radialVel) {
+    const Eigen::Vector3d rtp = ns_ctraj::XYZtoRTP<double>(xyz);
+    timestamps(i) = timestamp;
+    ranges(i) = rtp(0);
+    azimuths(i) = rtp(1);
+    elevations(i) = rtp(2);
+    radialVels(i) = radialVel;
+    dirs.col(i) = xyz / rtp(0);
+}
+
+Eigen::Vector3d RadarTargetSoA::GetTargetXYZ(Eigen::Index i) const {
+    return dirs.col(i) * ranges(i);
+}
+
+RadarTargetSoAView RadarTargetSoA::View(Eigen::Index begin, Eigen::Index size) const {
+    return {timestamps.segment(begin, size), ranges.segment(begin, size),
+            radialVels.segment(begin, size), dirs.middleCols(begin, size)};
+}
+
+RadarTargetSoAView RadarTargetSoA::View() const { return View(0, Size()); }
+
+std::size_t RadarTargetSoA::GetMemoryBytes() const {
+    return sizeof(double) * (5 + 3) * static_cast<std::size_t>(Size());
+}
+
+// ----------------
+// RadarTargetArray
+// ----------------
+
 RadarTargetArray::RadarTargetArray(double timestamp, const std::vector<RadarTarget::Ptr> &targets)
     : _timestamp(timestamp),
-      _targets(targets) {}
+      _targets(targets),
+      _soa(RadarTargetSoA::FromTargets(targets)) {}
 
 RadarTargetArray::Ptr RadarTargetArray::Create(double timestamp,
                                                const std::vector<RadarTarget::Ptr> &targets) {
     return std::make_shared<RadarTargetArray>(timestamp, targets);
 }
 
+RadarTargetArray::Ptr RadarTargetArray::CreatePacked(double timestamp,
+                                                     std::vector<RadarTarget> targets) {
+    auto packed = std::make_shared<std::vector<RadarTarget>>(std::move(targets));
+    std::vector<RadarTarget::Ptr> ptrs;
+    ptrs.reserve(packed->size());
+    for (auto &target : *packed) {
+        // the aliasing constructor, no allocation is performed
+        ptrs.emplace_back(packed, &target);
+    }
+    auto array = Create(timestamp, ptrs);
+    array->_packed = std::move(packed);
+    return array;
+}
+
+RadarTargetArray::Ptr RadarTargetArray::CreatePacked(double timestamp, RadarTargetSoA soa) {
+    std::vector<RadarTarget> targets;
+    targets.reserve(soa.Size());
+    for (Eigen::Index i = 0; i < soa.Size(); ++i) {
+        targets.emplace_back(soa.timestamps(i), soa.GetTargetXYZ(i), soa.radialVels(i));
+    }
+    auto packed = std::make_shared<std::vector<RadarTarget>>(std::move(targets));
+    auto array = std::make_shared<RadarTargetArray>(timestamp);
+    array->_targets.reserve(packed->size());
+    for (auto &target : *packed) {
+        array->_targets.emplace_back(packed, &target);
+    }
+    array->_packed = std::move(packed);
+    array->_soa = std::move(soa);
+    return array;
+}
+
 double RadarTargetArray::GetTimestamp() const { return _timestamp; }
 
 const std::vector<RadarTarget::Ptr> &RadarTargetArray::GetTargets() const { return _targets; }
 
+const RadarTargetSoA &RadarTargetArray::GetTargetSoA() const { return _soa; }
+
+void RadarTargetArray::ShiftTimestamps(double dt) {
+    _timestamp += dt;
+    for (auto &tar : _targets) {
+        tar->SetTimestamp(tar->GetTimestamp() + dt);
+    }
+    _soa.timestamps.array() += dt;
+}
+
+std::size_t RadarTargetArray::GetMemoryBytes() const {
+    if (_packed != nullptr) {
+        return MemoryUsage::MakeSharedBytes<RadarTargetArray>() +
+               MemoryUsage::VectorBytes(_targets) +
+               MemoryUsage::MakeSharedBytes<std::vector<RadarTarget>>() +
+               MemoryUsage::VectorBytes(*_packed) + _soa.GetMemoryBytes();
+    }
+    return MemoryUsage::MakeSharedBytes<RadarTargetArray>() +
+           MemoryUsage::SharedSeqBytes(_targets,
+                                       [](const RadarTarget::Ptr &) {
+                                           return MemoryUsage::MakeSharedBytes<RadarTarget>();
+                                       }) +
+           _soa.GetMemoryBytes();
+}
+
 void RadarTargetArray::SetTimestamp(double timestamp) { _timestamp = timestamp; }
 
 bool RadarTargetArray::SaveTargetArraysToDisk(const std::string &filename,
@@ -40,6 +40,8 @@
 #include "sensor_msgs/PointCloud2.h"
 #include "pcl_conversions/pcl_conversions.h"
 #include "spdlog/fmt/fmt.h"
+#include "spdlog/spdlog.h"
+#include "cstring"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -50,40 +52,124 @@ namespace ns_ikalibr {
 RadarDataLoader::RadarDataLoader(RadarModelType radarModel)
     : _radarModel(radarModel) {}
 
+template class DataLoaderRegistry<RadarDataLoader>;
+
+// built-in loaders
+IKALIBR_REGISTER_DATA_LOADER(
+    RadarDataLoader, "AINSTEIN_RADAR", "AinsteinRadarLoader", DecodeCapability::NONE,
+    [] { return AinsteinRadarLoader::Create(RadarModelType::AINSTEIN_RADAR); })
+IKALIBR_REGISTER_DATA_LOADER(
+    RadarDataLoader, "AWR1843BOOST_RAW", "AWR1843BOOSTRawLoader", DecodeCapability::NONE,
+    [] { return AWR1843BOOSTRawLoader::Create(RadarModelType::AWR1843BOOST_RAW); })
+IKALIBR_REGISTER_DATA_LOADER(
+    RadarDataLoader, "AWR1843BOOST_CUSTOM", "AWR1843BOOSTCustomLoader", DecodeCapability::NONE,
+    [] { return AWR1843BOOSTCustomLoader::Create(RadarModelType::AWR1843BOOST_CUSTOM); })
+IKALIBR_REGISTER_DATA_LOADER(
+    RadarDataLoader, "POINTCLOUD2_POSV", "PointCloud2POSVLoader", DecodeCapability::ZERO_COPY,
+    [] { return PointCloud2POSVLoader::Create(RadarModelType::POINTCLOUD2_POSV); })
+IKALIBR_REGISTER_DATA_LOADER(
+    RadarDataLoader, "POINTCLOUD2_POSIV", "PointCloud2POSIVLoader", DecodeCapability::ZERO_COPY,
+    [] { return PointCloud2POSIVLoader::Create(RadarModelType::POINTCLOUD2_POSIV); })
+IKALIBR_REGISTER_DATA_LOADER(
+    RadarDataLoader, "POINTCLOUD2_XRIO", "PointCloud2XRIOLoader", DecodeCapability::ZERO_COPY,
+    [] { return PointCloud2XRIOLoader::Create(RadarModelType::POINTCLOUD2_XRIO); })
+
 RadarDataLoader::Ptr RadarDataLoader::GetLoader(const std::string &radarModelStr) {
-    // try extract radar model
-    RadarModelType radarModel;
-    try {
-        radarModel = EnumCast::stringToEnum<RadarModelType>(radarModelStr);
-    } catch (...) {
+    // the fastest registered decoder (built-in or from plugins) of the radar model
+    auto radarDataLoader = DataLoaderRegistry<RadarDataLoader>::Create(radarModelStr);
+    if (radarDataLoader == nullptr) {
         throw Status(Status::WARNING, RadarModel::UnsupportedRadarModelMsg(radarModelStr));
     }
-    RadarDataLoader::Ptr radarDataLoader;
-    switch (radarModel) {
-        case RadarModelType::AINSTEIN_RADAR:
-            radarDataLoader = AinsteinRadarLoader::Create(radarModel);
-            break;
-        case RadarModelType::AWR1843BOOST_RAW:
-            radarDataLoader = AWR1843BOOSTRawLoader::Create(radarModel);
-            break;
-        case RadarModelType::POINTCLOUD2_POSV:
-            radarDataLoader = PointCloud2POSVLoader::Create(radarModel);
-            break;
-        case RadarModelType::POINTCLOUD2_POSIV:
-            radarDataLoader = PointCloud2POSIVLoader::Create(radarModel);
-            break;
-        case RadarModelType::AWR1843BOOST_CUSTOM:
-            radarDataLoader = AWR1843BOOSTCustomLoader::Create(radarModel);
-            break;
-        case RadarModelType::POINTCLOUD2_XRIO:
-            radarDataLoader = PointCloud2XRIOLoader::Create(radarModel);
-            break;
-        default:
-            throw Status(Status::WARNING, RadarModel::UnsupportedRadarModelMsg(radarModelStr));
-    }
     return radarDataLoader;
 }
 
+RadarDataLoader::PointCloud2Layout RadarDataLoader::GetPointCloud2Layout(
+    const sensor_msgs::PointCloud2 &msg, const std::string &velField) {
+    std::lock_guard<std::mutex> lock(_layoutMutex);
+
+    bool changed = _layout.fields.size() != msg.fields.size();
+    for (std::size_t i = 0; !changed && i < msg.fields.size(); ++i) {
+        const auto &[name, offset, datatype] = _layout.fields.at(i);
+        const auto &field = msg.fields.at(i);
+        changed = name != field.name || offset != field.offset || datatype != field.datatype;
+    }
+    if (!changed) {
+        return _layout;
+    }
+
+    // recognize the layout
+    PointCloud2Layout layout;
+    int foundCount = 0;
+    for (const auto &field : msg.fields) {
+        layout.fields.emplace_back(field.name, field.offset, field.datatype);
+        if (field.count != 1 || field.datatype != sensor_msgs::PointField::FLOAT32) {
+            continue;
+        }
+        if (field.name == "x") {
+            layout.xOffset = field.offset, ++foundCount;
+        } else if (field.name == "y") {
+            layout.yOffset = field.offset, ++foundCount;
+        } else if (field.name == "z") {
+            layout.zOffset = field.offset, ++foundCount;
+        } else if (field.name == velField) {
+            layout.velOffset = field.offset, ++foundCount;
+        }
+    }
+    layout.supported = foundCount == 4;
+    if (!layout.supported) {
+        spdlog::warn(
+            "field layout of point clouds for '{}' radar is not recognized, use the slow "
+            "pcl-based conversion instead!",
+            EnumCast::enumToString(GetRadarModel()));
+    }
+    _layout = layout;
+    return _layout;
+}
+
+RadarTargetArray::Ptr RadarDataLoader::UnpackPointCloud2(const sensor_msgs::PointCloud2 &msg,
+                                                         const std::string &velField,
+                                                         double timestamp) {
+    const auto layout = GetPointCloud2Layout(msg, velField);
+    if (!layout.supported || msg.is_bigendian ||
+        msg.data.size() < static_cast<std::size_t>(msg.row_step) * msg.height) {
+        return nullptr;
+    }
+    // the offsets of fields should be in a target
+    if (std::max({layout.xOffset, layout.yOffset, layout.zOffset, layout.velOffset}) + 4 >
+            msg.point_step ||
+        static_cast<std::size_t>(msg.point_step) * msg.width > msg.row_step) {
+        return nullptr;
+    }
+
+    // targets are filled into the structure-of-arrays layout directly
+    RadarTargetSoA soa(static_cast<Eigen::Index>(msg.width) * msg.height);
+    Eigen::Index j = 0;
+    for (std::uint32_t row = 0; row < msg.height; ++row) {
+        const std::uint8_t *ptr = msg.data.data() + static_cast<std::size_t>(row) * msg.row_step;
+        for (std::uint32_t col = 0; col < msg.width; ++col, ptr += msg.point_step) {
+            float x, y, z, vel;
+            std::memcpy(&x, ptr + layout.xOffset, sizeof(float));
+            std::memcpy(&y, ptr + layout.yOffset, sizeof(float));
+            std::memcpy(&z, ptr + layout.zOffset, sizeof(float));
+            std::memcpy(&vel, ptr + layout.velOffset, sizeof(float));
+            if (std::isnan(x) || std::isnan(y) || std::isnan(z) || std::isnan(vel)) {
+                continue;
+            }
+            if (x * x + y * y + z * z < 0.25f) {
+                continue;
+            }
+            soa.Set(j++, timestamp, Eigen::Vector3d(x, y, z), vel);
+        }
+    }
+    soa.Resize(j);
+
+    if (msg.header.stamp.isZero()) {
+        return RadarTargetArray::CreatePacked(timestamp, std::move(soa));
+    } else {
+        return RadarTargetArray::CreatePacked(msg.header.stamp.toSec(), std::move(soa));
+    }
+}
+
 RadarModelType RadarDataLoader::GetRadarModel() const { return _radarModel; }
 
 // -------------------
@@ -173,6 +259,12 @@ RadarTargetArray::Ptr PointCloud2POSVLoader::UnpackScan(
 
     CheckMessage<sensor_msgs::PointCloud2>(msg);
 
+    // the timestamp should be obtained from header, rather than from instance
+    if (auto array = UnpackPointCloud2(*msg, "velocity", msgInstance.getTime().toSec());
+        array != nullptr) {
+        return array;
+    }
+
     RadarPOSVCloud radarTargets;
     pcl::fromROSMsg(*msg, radarTargets);
 
@@ -215,6 +307,12 @@ RadarTargetArray::Ptr PointCloud2POSIVLoader::UnpackScan(
 
     CheckMessage<sensor_msgs::PointCloud2>(msg);
 
+    // the timestamp should be obtained from header, rather than from instance
+    if (auto array = UnpackPointCloud2(*msg, "velocity", msgInstance.getTime().toSec());
+        array != nullptr) {
+        return array;
+    }
+
     RadarPOSIVCloud radarTargets;
     pcl::fromROSMsg(*msg, radarTargets);
 
@@ -284,7 +382,7 @@ PointCloud2XRIOLoader::PointCloud2XRIOLoader(RadarModelType radarModel)
     : RadarDataLoader(radarModel) {}
 
 PointCloud2XRIOLoader::Ptr PointCloud2XRIOLoader::Create(RadarModelType radarModel) {
-    return std::make_shared<PointCloud2POSIVLoader>(radarModel);
+    return std::make_shared<PointCloud2XRIOLoader>(radarModel);
 }
 
 RadarTargetArray::Ptr PointCloud2XRIOLoader::UnpackScan(
@@ -293,6 +391,12 @@ RadarTargetArray::Ptr PointCloud2XRIOLoader::UnpackScan(
 
     CheckMessage<sensor_msgs::PointCloud2>(msg);
 
+    // the timestamp should be obtained from header, rather than from instance
+    if (auto array = UnpackPointCloud2(*msg, "v_doppler_mps", msgInstance.getTime().toSec());
+        array != nullptr) {
+        return array;
+    }
+
     RadarXRIOCloud radarTargets;
     pcl::fromROSMsg(*msg, radarTargets);
 
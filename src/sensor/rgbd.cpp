@@ -36,6 +36,9 @@
 #include "spdlog/spdlog.h"
 #include "opencv2/imgproc.hpp"
 #include "sensor/rgbd_intrinsic.hpp"
+#include "util/memory_usage.hpp"
+#include "random"
+#include "limits"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -43,6 +46,28 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+// ----------
+// RGBDRayLUT
+// ----------
+
+RGBDRayLUT::RGBDRayLUT(const RGBDIntrinsicsPtr& intri, int width, int height)
+    : width(width),
+      height(height),
+      xs(width * height),
+      ys(width * height) {
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            Eigen::Vector2d lmInDnPlane = intri->intri->ImgToCam({col, row});
+            xs[row * width + col] = static_cast<float>(lmInDnPlane(0));
+            ys[row * width + col] = static_cast<float>(lmInDnPlane(1));
+        }
+    }
+}
+
+RGBDRayLUT::Ptr RGBDRayLUT::Create(const RGBDIntrinsicsPtr& intri, int width, int height) {
+    return std::make_shared<RGBDRayLUT>(intri, width, height);
+}
+
 // ---------
 // RGBDFrame
 // ---------
@@ -77,11 +102,24 @@ RGBDFrame::Ptr RGBDFrame::Create(double timestamp,
 
 cv::Mat& RGBDFrame::GetDepthImage() { return _depthImg; }
 
+float RGBDFrame::GetRawDepth(int row, int col) const {
+    if (_depthImg.depth() == CV_16U) {
+        return static_cast<float>(_depthImg.at<ushort>(row, col));
+    }
+    return _depthImg.at<float>(row, col);
+}
+
 void RGBDFrame::ReleaseMat() {
     CameraFrame::ReleaseMat();
     _depthImg.release();
 }
 
+std::size_t RGBDFrame::GetMemoryBytes() const {
+    // the frame is allocated as a 'RGBDFrame', rather than the base one
+    return CameraFrame::GetMemoryBytes() + sizeof(RGBDFrame) - sizeof(CameraFrame) +
+           MemoryUsage::MatBytes(_depthImg);
+}
+
 cv::Mat RGBDFrame::CreateColorDepthMap(const RGBDIntrinsics::Ptr& intri,
                                        bool withColorMat,
                                        float zMin,
@@ -92,9 +130,13 @@ cv::Mat RGBDFrame::CreateColorDepthMap(const RGBDIntrinsics::Ptr& intri,
     cv::Mat invDepthImg(rowCnt, colCnt, CV_32FC1, cv::Scalar(0.0f));
     float min = std::numeric_limits<float>::max(), max = std::numeric_limits<float>::min();
 
+    // raw depths may be 16-bit ones
+    cv::Mat rawDepthImg;
+    _depthImg.convertTo(rawDepthImg, CV_32F);
+
     for (int row = 0; row < rowCnt; ++row) {
         auto iData = invDepthImg.ptr<float>(row);
-        auto dData = _depthImg.ptr<float>(row);
+        auto dData = rawDepthImg.ptr<float>(row);
         for (int col = 0; col < colCnt; ++col) {
             auto depth = (float)intri->ActualDepth(dData[0]);
             if (depth > zMin && depth < zMax) {
@@ -137,81 +179,220 @@ cv::Mat RGBDFrame::CreateColorDepthMap(const RGBDIntrinsics::Ptr& intri,
     }
 }
 
+std::vector<int> RGBDFrame::ValidDepthPixels(const RGBDIntrinsicsPtr& intri,
+                                             float zMin,
+                                             float zMax,
+                                             int sampleCount,
+                                             std::vector<float>& depths) const {
+    const int rowCnt = _depthImg.rows;
+    const int colCnt = _depthImg.cols;
+    const auto alpha = static_cast<float>(intri->alpha), beta = static_cast<float>(intri->beta);
+
+    depths.resize(rowCnt * colCnt);
+    std::vector<int> indices(rowCnt * colCnt);
+    std::size_t count = 0;
+    // actual depths of a row are computed in a vectorizable loop, raw depths may be 16-bit ones
+    auto actualDepths = [alpha, beta, colCnt](const auto* dData, float* depth) {
+        for (int col = 0; col < colCnt; ++col) {
+            depth[col] = alpha * static_cast<float>(dData[col]) + beta;
+        }
+    };
+    const bool rawIn16U = _depthImg.depth() == CV_16U;
+    for (int row = 0; row < rowCnt; ++row) {
+        float* depth = depths.data() + row * colCnt;
+        if (rawIn16U) {
+            actualDepths(_depthImg.ptr<ushort>(row), depth);
+        } else {
+            actualDepths(_depthImg.ptr<float>(row), depth);
+        }
+        // branchless compaction of valid pixels
+        for (int col = 0; col < colCnt; ++col) {
+            indices[count] = row * colCnt + col;
+            count += (depth[col] > zMin && depth[col] < zMax);
+        }
+    }
+    indices.resize(count);
+
+    if (sampleCount > 0 && static_cast<int>(count) > sampleCount) {
+        std::vector<int> sampled;
+        sampled.reserve(sampleCount);
+        // the order of pixels is kept in sampling
+        std::sample(indices.cbegin(), indices.cend(), std::back_inserter(sampled), sampleCount,
+                    std::mt19937(std::mt19937::default_seed));
+        return sampled;
+    }
+    return indices;
+}
+
 ColorPointCloud::Ptr RGBDFrame::CreatePointCloud(const RGBDIntrinsicsPtr& intri,
                                                  float zMin,
-                                                 float zMax) {
-    auto cMat = _colorImg;
-    auto dMat = _depthImg;
-    int rowCnt = cMat.rows;
-    int colCnt = cMat.cols;
+                                                 float zMax,
+                                                 int sampleCount,
+                                                 const RGBDRayLUT::Ptr& lut) {
+    const auto& cMat = _colorImg;
+    const auto& dMat = _depthImg;
 
     if (cMat.empty() || dMat.empty() || cMat.size != dMat.size) {
         return nullptr;
     }
+    auto rays = lut;
+    if (rays == nullptr || rays->width != dMat.cols || rays->height != dMat.rows) {
+        rays = RGBDRayLUT::Create(intri, dMat.cols, dMat.rows);
+    }
+
+    std::vector<float> depths;
+    const auto indices = ValidDepthPixels(intri, zMin, zMax, sampleCount, depths);
 
     ColorPointCloud::Ptr cloud(new ColorPointCloud);
-    cloud->reserve(rowCnt * colCnt);
-    for (int row = 0; row < rowCnt; ++row) {
-        auto cData = cMat.ptr<uchar>(row);
-        auto dData = dMat.ptr<float>(row);
-        for (int col = 0; col < colCnt; ++col) {
-            auto depth = (float)intri->ActualDepth(dData[0]);
-            if (depth > zMin && depth < zMax) {
-                Eigen::Vector2d lmInDnPlane = intri->intri->ImgToCam({col, row});
-                Eigen::Vector3d lmInDn(lmInDnPlane(0) * depth, lmInDnPlane(1) * depth, depth);
-
-                ColorPoint p;
-                p.x = (float)lmInDn(0);
-                p.y = (float)lmInDn(1);
-                p.z = (float)lmInDn(2);
-                p.b = cData[0];
-                p.g = cData[1];
-                p.r = cData[2];
-                p.a = 255;
-                cloud->push_back(p);
-            }
-            // color mat ptr
-            cData += 3;
-            // depth mat ptr
-            dData += 1;
-        }
+    cloud->resize(indices.size());
+    const int colCnt = dMat.cols;
+    for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
+        const int idx = indices[i];
+        const float depth = depths[idx];
+        const auto cData = cMat.ptr<uchar>(idx / colCnt) + (idx % colCnt) * 3;
+        auto& p = cloud->at(i);
+        p.x = rays->xs[idx] * depth;
+        p.y = rays->ys[idx] * depth;
+        p.z = depth;
+        p.b = cData[0];
+        p.g = cData[1];
+        p.r = cData[2];
+        p.a = 255;
     }
     return cloud;
 }
 
-IKalibrPointCloud::Ptr RGBDFrame::CreatePointCloud(
-    double rsExpFactor, double readout, const RGBDIntrinsicsPtr& intri, float zMin, float zMax) {
-    auto cMat = _colorImg;
-    auto dMat = _depthImg;
-    int rowCnt = cMat.rows;
-    int colCnt = cMat.cols;
+IKalibrPointCloud::Ptr RGBDFrame::CreatePointCloud(double rsExpFactor,
+                                                   double readout,
+                                                   const RGBDIntrinsicsPtr& intri,
+                                                   float zMin,
+                                                   float zMax,
+                                                   int sampleCount,
+                                                   const RGBDRayLUT::Ptr& lut) {
+    if (_colorImg.empty() || _depthImg.empty() || _colorImg.size != _depthImg.size) {
+        return nullptr;
+    }
+    std::vector<float> depths;
+    const auto indices = ValidDepthPixels(intri, zMin, zMax, sampleCount, depths);
+    return BackProject(rsExpFactor, readout, intri, indices, depths, lut);
+}
 
-    if (cMat.empty() || dMat.empty() || cMat.size != dMat.size) {
+IKalibrPointCloud::Ptr RGBDFrame::CreateSparsePointCloud(double rsExpFactor,
+                                                         double readout,
+                                                         const RGBDIntrinsicsPtr& intri,
+                                                         int count,
+                                                         float zMin,
+                                                         float zMax,
+                                                         const RGBDRayLUT::Ptr& lut) {
+    if (_colorImg.empty() || _depthImg.empty() || _colorImg.size != _depthImg.size) {
         return nullptr;
     }
+    std::vector<float> depths;
+    const auto indices = SparseDepthPixels(intri, zMin, zMax, count, depths);
+    return BackProject(rsExpFactor, readout, intri, indices, depths, lut);
+}
+
+std::vector<int> RGBDFrame::SparseDepthPixels(const RGBDIntrinsicsPtr& intri,
+                                              float zMin,
+                                              float zMax,
+                                              int count,
+                                              std::vector<float>& depths) const {
+    // the max relative depth difference to neighbors, larger ones are discontinuities
+    constexpr float EDGE_RATIO = 0.05f;
+
+    const auto valid = ValidDepthPixels(intri, zMin, zMax, -1, depths);
+    if (count <= 0 || static_cast<int>(valid.size()) <= count) {
+        return valid;
+    }
+    const int rowCnt = _depthImg.rows;
+    const int colCnt = _depthImg.cols;
+
+    std::vector<uchar> mask(rowCnt * colCnt, 0);
+    for (int idx : valid) {
+        mask[idx] = 1;
+    }
+
+    // the image is bucketed so that valid pixels are roughly spread into 'count' cells
+    const int cellSize = std::max(1, static_cast<int>(std::sqrt(valid.size() / (double)count)));
+    const int cellCols = (colCnt + cellSize - 1) / cellSize;
+    const int cellRows = (rowCnt + cellSize - 1) / cellSize;
+    std::vector<float> bestScores(cellCols * cellRows, std::numeric_limits<float>::max());
+    std::vector<int> bestIndices(cellCols * cellRows, -1);
+
+    for (int idx : valid) {
+        const int row = idx / colCnt, col = idx % colCnt;
+        if (row == 0 || col == 0 || row == rowCnt - 1 || col == colCnt - 1) {
+            continue;
+        }
+        // pixels next to holes are mostly mixed ones (flying pixels)
+        if (!mask[idx - 1] || !mask[idx + 1] || !mask[idx - colCnt] || !mask[idx + colCnt]) {
+            continue;
+        }
+        const float d = depths[idx];
+        const float l = depths[idx - 1], r = depths[idx + 1];
+        const float u = depths[idx - colCnt], b = depths[idx + colCnt];
+
+        // depth discontinuities, i.e., object boundaries
+        const float maxDiff = std::max(std::max(std::abs(l - d), std::abs(r - d)),
+                                       std::max(std::abs(u - d), std::abs(b - d)));
+        if (maxDiff > EDGE_RATIO * d) {
+            continue;
+        }
+
+        // the relative second-order differences, which are small on planar areas
+        const float score = (std::abs(l + r - 2.0f * d) + std::abs(u + b - 2.0f * d)) / d;
+        const int cell = (row / cellSize) * cellCols + col / cellSize;
+        if (score < bestScores[cell]) {
+            bestScores[cell] = score;
+            bestIndices[cell] = idx;
+        }
+    }
+
+    std::vector<int> indices;
+    indices.reserve(bestIndices.size());
+    for (int idx : bestIndices) {
+        if (idx >= 0) {
+            indices.push_back(idx);
+        }
+    }
+    // pixels are organized in row-major order
+    std::sort(indices.begin(), indices.end());
+
+    if (static_cast<int>(indices.size()) > count) {
+        std::vector<int> sampled;
+        sampled.reserve(count);
+        std::sample(indices.cbegin(), indices.cend(), std::back_inserter(sampled), count,
+                    std::mt19937(std::mt19937::default_seed));
+        return sampled;
+    }
+    return indices;
+}
+
+IKalibrPointCloud::Ptr RGBDFrame::BackProject(double rsExpFactor,
+                                              double readout,
+                                              const RGBDIntrinsicsPtr& intri,
+                                              const std::vector<int>& indices,
+                                              const std::vector<float>& depths,
+                                              const RGBDRayLUT::Ptr& lut) const {
+    const auto& dMat = _depthImg;
+    auto rays = lut;
+    if (rays == nullptr || rays->width != dMat.cols || rays->height != dMat.rows) {
+        rays = RGBDRayLUT::Create(intri, dMat.cols, dMat.rows);
+    }
 
     IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud);
-    cloud->reserve(rowCnt * colCnt);
+    cloud->resize(indices.size());
+    const int colCnt = dMat.cols;
     const int imgHeight = _greyImg.rows;
-    for (int row = 0; row < rowCnt; ++row) {
-        auto dData = dMat.ptr<float>(row);
-        const double rdFactorAry = row / (double)imgHeight - rsExpFactor;
-        for (int col = 0; col < colCnt; ++col) {
-            auto depth = (float)intri->ActualDepth(dData[0]);
-            if (depth > zMin && depth < zMax) {
-                Eigen::Vector2d lmInDnPlane = intri->intri->ImgToCam({col, row});
-                Eigen::Vector3d lmInDn(lmInDnPlane(0) * depth, lmInDnPlane(1) * depth, depth);
-
-                IKalibrPoint p;
-                p.timestamp = _timestamp + rdFactorAry * readout;
-                p.x = (float)lmInDn(0);
-                p.y = (float)lmInDn(1);
-                p.z = (float)lmInDn(2);
-                cloud->push_back(p);
-            }
-            // depth mat ptr
-            dData += 1;
-        }
+    for (int i = 0; i < static_cast<int>(indices.size()); ++i) {
+        const int idx = indices[i];
+        const float depth = depths[idx];
+        const double rdFactorAry = (idx / colCnt) / (double)imgHeight - rsExpFactor;
+        auto& p = cloud->at(i);
+        p.timestamp = _timestamp + rdFactorAry * readout;
+        p.x = rays->xs[idx] * depth;
+        p.y = rays->ys[idx] * depth;
+        p.z = depth;
     }
     return cloud;
 }
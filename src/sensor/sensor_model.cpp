@@ -114,6 +114,7 @@ std::string LidarModel::UnsupportedLiDARModelMsg(const std::string &modelStr) {
         "4.           Livox LiDARs: LIVOX_CUSTOM (the official 'xfer_format'=1, "
         "mid-360 and avia is recommend)\n"
         "...\n"
+        "or models registered by data loader plugins (see 'DataStream::LoaderPlugins').\n"
         "If you need to use other IMU types, "
         "please 'Issues' us on the profile of the github repository.",
         modelStr);
@@ -133,6 +134,7 @@ std::string RadarModel::UnsupportedRadarModelMsg(const std::string &modelStr) {
         "6.    POINTCLOUD2_XRIO: 'sensor_msgs/PointCloud2' with x-RIO point format (see "
         "https://github.com/christopherdoer/rio.git)\n"
         "...\n"
+        "or models registered by data loader plugins (see 'DataStream::LoaderPlugins').\n"
         "If you need to use other radar types, "
         "please 'Issues' us on the profile of the github repository.",
         modelStr);
@@ -33,8 +33,10 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "solver/calib_solver_tpl.hpp"
+#include "calib/batch_opt_problem.h"
 #include "magic_enum_flags.hpp"
 #include "util/utils_tpl.hpp"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -42,14 +44,45 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+// residual groups of raw measurements (imus and radars) and correspondences (lidars and cameras)
+static const std::string RAW_MES_GROUP = "RAW_MES", CORR_GROUP = "CORR";
+// inverse depths (rather than depths) of optical flow correspondences are estimated
+static constexpr bool OPTICAL_FLOW_EST_INV_DEPTH = true;
+
+OptOption CalibSolver::RefineReadoutTimeOptForCameras(const std::string &topic, OptOption opt) {
+    OptOption visualOpt = opt;
+    /*
+     * if this camera is a rolling shutter camera and optimization option is with
+     * 'OPT_RS_CAM_READOUT_TIME' option, we optimize the rs readout time.
+     * if this camera is a global shutter camera and optimization option is with
+     * 'OPT_RS_CAM_READOUT_TIME' option, we remove this option and do not optimize the
+     * rs readout time.
+     */
+    if (IsOptionWith(OptOption::OPT_RS_CAM_READOUT_TIME, visualOpt)) {
+        if (IsRSCamera(topic)) {
+            spdlog::info(
+                "camera '{}' is a rolling shutter (RS) camera, use optimization option "
+                "'OPT_RS_CAM_READOUT_TIME'",
+                topic);
+        } else {
+            visualOpt ^= OptOption::OPT_RS_CAM_READOUT_TIME;
+            spdlog::info(
+                "camera '{}' is a global shutter (GS) camera, remove optimization option "
+                "'OPT_RS_CAM_READOUT_TIME'",
+                topic);
+        }
+    }
+    return visualOpt;
+}
+
 CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
     OptOption optOption,
-    const std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> &lidarPtsCorrs,
+    const std::map<std::string, PointToSurfelCorrBuffer::Ptr> &lidarPtsCorrs,
     const std::map<std::string, std::vector<VisualReProjCorrSeq::Ptr>> &visualReprojCorrs,
     const std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> &rgbdCorrs,
     const std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> &visualVelCorrs,
     const std::map<std::string, std::vector<OpticalFlowCurveCorr::Ptr>> &eventCorrs,
-    const std::optional<std::map<std::string, std::vector<PointToSurfelCorrPtr>>> &rgbdPtsCorrs)
+    const std::optional<std::map<std::string, PointToSurfelCorrBufferPtr>> &rgbdPtsCorrs)
     const {
     // a lambda function to obtain the string of current optimization option
     auto GetOptString = [](OptOption opt) -> std::string {
@@ -57,49 +90,144 @@ CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
         stringStream << magic_enum::enum_flags_name(opt);
         return stringStream.str();
     };
-    // a lambda function to refine optimization option for gs/rs cameras
-    auto RefineReadoutTimeOptForCameras = [](const std::string &topic,
-                                             const OptOption opt) -> OptOption {
-        OptOption visualOpt = opt;
-        /*
-         * if this camera is a rolling shutter camera and optimization option is with
-         * 'OPT_RS_CAM_READOUT_TIME' option, we optimize the rs readout time.
-         * if this camera is a global shutter camera and optimization option is with
-         * 'OPT_RS_CAM_READOUT_TIME' option, we remove this option and do not optimize the
-         * rs readout time.
-         */
-        if (IsOptionWith(OptOption::OPT_RS_CAM_READOUT_TIME, visualOpt)) {
-            if (IsRSCamera(topic)) {
-                spdlog::info(
-                    "camera '{}' is a rolling shutter (RS) camera, use optimization option "
-                    "'OPT_RS_CAM_READOUT_TIME'",
-                    topic);
-            } else {
-                visualOpt ^= OptOption::OPT_RS_CAM_READOUT_TIME;
-                spdlog::info(
-                    "camera '{}' is a global shutter (GS) camera, remove optimization option "
-                    "'OPT_RS_CAM_READOUT_TIME'",
-                    topic);
+    spdlog::info("Optimization option: {}", GetOptString(optOption));
+
+    // save the problem of this batch optimization, which could be replayed for solver benchmarks
+    if (IsOptionWith(OutputOption::BatchOptProblems, Configor::Preference::Outputs)) {
+        const std::string saveDir = Configor::DataStream::OutputPath + "/problems";
+        if (std::filesystem::exists(saveDir) || std::filesystem::create_directories(saveDir)) {
+            auto problem = BatchOptProblem::Create(optOption, GetScaleType(), _splines, _parMagr);
+            problem->imuMes = _dataMagr->GetIMUMeasurements();
+            problem->radarMes = _dataMagr->GetRadarMeasurements();
+            problem->lidarPtsCorrs = lidarPtsCorrs;
+            problem->visualReprojCorrs = visualReprojCorrs;
+            problem->rgbdCorrs = rgbdCorrs;
+            problem->visualVelCorrs = visualVelCorrs;
+            if (rgbdPtsCorrs != std::nullopt) {
+                problem->rgbdPtsCorrs = *rgbdPtsCorrs;
+            }
+            for (const auto &[topic, _] : visualReprojCorrs) {
+                problem->cameraOptOptions[topic] = RefineReadoutTimeOptForCameras(topic, optOption);
+            }
+            for (const auto &[topic, _] : rgbdCorrs) {
+                problem->cameraOptOptions[topic] = RefineReadoutTimeOptForCameras(topic, optOption);
+            }
+            for (const auto &[topic, _] : visualVelCorrs) {
+                problem->cameraOptOptions[topic] = RefineReadoutTimeOptForCameras(topic, optOption);
+            }
+            const auto filename = fmt::format("{}/batch_opt_problem_{}{}", saveDir,
+                                              _batchOptProblemIdx++,
+                                              Configor::GetFormatExtension());
+            spdlog::info("saving the batch optimization problem to '{}'...", filename);
+            problem->Save(filename, Configor::Preference::OutputDataFormat);
+        } else {
+            spdlog::warn("create directory failed: '{}'", saveDir);
+        }
+    }
+
+    /**
+     * residuals of raw measurements (imus and radars) are unchanged among batch optimizations,
+     * while the ones of correspondences (lidars and cameras) are re-associated. Thus, if time
+     * offset related options (which affect the knots involved in residuals) and imu intrinsic
+     * related ones (frozen intrinsics are removed from measurements in advance) stay the same, the
+     * estimator of the last batch optimization is reused, only correspondence residuals are rebuilt
+     */
+    auto IsRawMesOptSame = [](OptOption opt1, OptOption opt2) {
+        for (const auto &opt :
+             {OptOption::OPT_TO_BiToBr, OptOption::OPT_TO_RjToBr, OptOption::OPT_TO_LkToBr,
+              OptOption::OPT_TO_CmToBr, OptOption::OPT_TO_DnToBr, OptOption::OPT_TO_EsToBr,
+              OptOption::OPT_GYRO_BIAS, OptOption::OPT_GYRO_MAP_COEFF, OptOption::OPT_SO3_AtoG,
+              OptOption::OPT_ACCE_BIAS, OptOption::OPT_ACCE_MAP_COEFF}) {
+            if (IsOptionWith(opt, opt1) != IsOptionWith(opt, opt2)) {
+                return false;
             }
         }
-        return visualOpt;
+        return true;
     };
+    const bool reuseEstimator = Configor::Preference::ReuseBatchEstimator && _backup != nullptr &&
+                                _backup->estimator != nullptr &&
+                                _backup->estimator->HasResidualGroup(RAW_MES_GROUP) &&
+                                IsRawMesOptSame(_backup->optOption, optOption) &&
+                                _backup->estimator->GetTemporalPadding() == *_temporalPadding;
+    Estimator::Ptr estimator;
+    if (reuseEstimator) {
+        spdlog::info("reuse the estimator of last batch optimization, rebuild correspondences...");
+        estimator = _backup->estimator;
+        estimator->RemoveResidualGroup(CORR_GROUP);
+        estimator->ResetParameterBlockConstancy(optOption);
+    } else if (Configor::Preference::ReuseBatchEstimator) {
+        estimator = Estimator::Create(_splines, _parMagr, Estimator::PersistentProblemOptions());
+    } else {
+        estimator = Estimator::Create(_splines, _parMagr);
+    }
+    // knots involved in residuals of estimated temporal parameters depend on their paddings
+    estimator->SetTemporalPadding(*_temporalPadding);
+    if (IsOptionWith(OutputOption::FactorProfiles, Configor::Preference::Outputs)) {
+        // factors of a reused estimator have been profiled (if enabled) when they were added
+        estimator->EnableFactorProfiler();
+    }
+    auto visualGlobalScale = std::make_shared<double>(1.0);
+    // residuals of raw measurements are kept in the reused estimator
+    this->AddBatchOptFactors(estimator, optOption, lidarPtsCorrs, visualReprojCorrs, rgbdCorrs,
+                             visualVelCorrs, eventCorrs, rgbdPtsCorrs, visualGlobalScale.get(),
+                             !reuseEstimator);
 
-    spdlog::info("Optimization option: {}", GetOptString(optOption));
+    // make this problem full rank
+    estimator->SetRefIMUParamsConstant();
 
-    auto estimator = Estimator::Create(_splines, _parMagr);
-    auto visualGlobalScale = std::make_shared<double>(1.0);
-    constexpr bool OPTICAL_FLOW_EST_INV_DEPTH = true;
+    estimator->PrintParameterInfo();
+
+    auto sum = estimator->Solve(_ceresOption, this->_priori);
+    spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
+
+    // factor counts are accumulated over batch optimizations for telemetry comparisons
+    for (const auto &[factor, count] : estimator->FactorCounts()) {
+        StageProfiler::Count("Factors/" + factor, count);
+    }
+
+    if (const auto &profiler = estimator->GetFactorProfiler(); profiler != nullptr) {
+        const std::string saveDir = Configor::DataStream::OutputPath + "/profiles";
+        if (std::filesystem::exists(saveDir) || std::filesystem::create_directories(saveDir)) {
+            const auto filename =
+                fmt::format("{}/factor_profile_{}.csv", saveDir, _factorProfileIdx++);
+            spdlog::info("saving the factor evaluation profile to '{}'...", filename);
+            profiler->SaveToCSV(filename);
+        } else {
+            spdlog::warn("create directory failed: '{}'", saveDir);
+        }
+    }
+
+    // align states to the gravity after the batch optimization is finished
+    AlignStatesToGravity();
+
+    return this->UpdateByBatchOptimization(estimator, optOption, lidarPtsCorrs, visualReprojCorrs,
+                                           rgbdCorrs, visualVelCorrs, eventCorrs,
+                                           visualGlobalScale);
+}
 
+void CalibSolver::AddBatchOptFactors(
+    EstimatorPtr &estimator,
+    OptOption optOption,
+    const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs,
+    const std::map<std::string, std::vector<VisualReProjCorrSeqPtr>> &visualReprojCorrs,
+    const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &rgbdCorrs,
+    const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &visualVelCorrs,
+    const std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> &eventCorrs,
+    const std::optional<std::map<std::string, PointToSurfelCorrBufferPtr>> &rgbdPtsCorrs,
+    double *visualGlobalScale,
+    bool withRawMes) const {
     switch (GetScaleType()) {
         case TimeDeriv::LIN_ACCE_SPLINE: {
             /**
              * only when imu-only multi-imu calibration is required, the linear acceleration spline
              * would be maintained
              */
-            for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
-                this->AddAcceFactor<TimeDeriv::LIN_ACCE_SPLINE>(estimator, topic, optOption);
-                this->AddGyroFactor(estimator, topic, optOption);
+            if (withRawMes) {
+                estimator->SetResidualGroup(RAW_MES_GROUP);
+                for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+                    this->AddAcceFactor<TimeDeriv::LIN_ACCE_SPLINE>(estimator, topic, optOption);
+                    this->AddGyroFactor(estimator, topic, optOption);
+                }
             }
         } break;
         case TimeDeriv::LIN_VEL_SPLINE: {
@@ -107,42 +235,36 @@ CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
              * when rgbds or radars are involved in the calibration, a linear velocity spline would
              * be maintained in the estimator
              */
-            for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
-                this->AddRadarFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
-            }
-            for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
-                this->AddAcceFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
-                this->AddGyroFactor(estimator, topic, optOption);
+            if (withRawMes) {
+                estimator->SetResidualGroup(RAW_MES_GROUP);
+                for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
+                    this->AddRadarFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
+                }
+                for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+                    this->AddAcceFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
+                    this->AddGyroFactor(estimator, topic, optOption);
+                }
             }
+            estimator->SetResidualGroup(CORR_GROUP);
             for (const auto &[topic, corrs] : rgbdCorrs) {
-                this->AddRGBDOpticalFlowFactor<TimeDeriv::LIN_VEL_SPLINE,
-                                               OPTICAL_FLOW_EST_INV_DEPTH>(
-                    estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
                 /**
                  * when vel spline is maintained, we add additional reprojection constraints for
                  * optical flow tracking correspondence, under the assumption of uniform velocity
                  * variation
                  */
-                this->AddRGBDOpticalFlowReprojFactor<TimeDeriv::LIN_VEL_SPLINE,
-                                                     OPTICAL_FLOW_EST_INV_DEPTH>(
+                this->AddRGBDOpticalFlowFusedFactor<TimeDeriv::LIN_VEL_SPLINE,
+                                                    OPTICAL_FLOW_EST_INV_DEPTH>(
                     estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
             }
             for (const auto &[topic, corrs] : visualVelCorrs) {
-                this->AddVisualOpticalFlowFactor<TimeDeriv::LIN_VEL_SPLINE,
-                                                 OPTICAL_FLOW_EST_INV_DEPTH>(
-                    estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
-
                 /**
                  * when vel spline is maintained, we add additional reprojection constraints for
                  * optical flow tracking correspondence, under the assumption of uniform velocity
                  * variation
                  */
-                this->AddVisualOpticalFlowReprojFactor<TimeDeriv::LIN_VEL_SPLINE,
-                                                       OPTICAL_FLOW_EST_INV_DEPTH>(
+                this->AddVisualOpticalFlowFusedFactor<TimeDeriv::LIN_VEL_SPLINE,
+                                                      OPTICAL_FLOW_EST_INV_DEPTH>(
                     estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
-
-                // this->AddVisualPPPTrifocalTensorFactor<TimeDeriv::LIN_VEL_SPLINE>(
-                //     estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
             }
             for (const auto &[topic, corrs] : eventCorrs) {
                 this->AddEventOpticalFlowFactor<TimeDeriv::LIN_VEL_SPLINE,
@@ -164,47 +286,42 @@ CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
              * when lidars or optical cameras are involved in the calibration, a translation spline
              * would be maintained in the estimator
              */
+            if (withRawMes) {
+                estimator->SetResidualGroup(RAW_MES_GROUP);
+                for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
+                    this->AddRadarFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic, optOption);
+                }
+                for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+                    this->AddAcceFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic, optOption);
+                    this->AddGyroFactor(estimator, topic, optOption);
+                }
+            }
+            estimator->SetResidualGroup(CORR_GROUP);
             for (const auto &[topic, corrs] : lidarPtsCorrs) {
                 this->AddLiDARPointToSurfelFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic,
                                                                              corrs, optOption);
             }
             for (const auto &[topic, corrs] : visualReprojCorrs) {
                 this->AddVisualReprojectionFactor<TimeDeriv::LIN_POS_SPLINE>(
-                    estimator, topic, corrs, visualGlobalScale.get(),
+                    estimator, topic, corrs, visualGlobalScale,
                     RefineReadoutTimeOptForCameras(topic, optOption));
             }
-            for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
-                this->AddRadarFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic, optOption);
-            }
-            for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
-                this->AddAcceFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic, optOption);
-                this->AddGyroFactor(estimator, topic, optOption);
-            }
             for (const auto &[topic, corrs] : rgbdCorrs) {
-                this->AddRGBDOpticalFlowFactor<TimeDeriv::LIN_POS_SPLINE,
-                                               OPTICAL_FLOW_EST_INV_DEPTH>(
-                    estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
                 /**
                  * when pos spline is maintained, we add additional reprojection constraints for
                  * optical flow tracking correspondence
                  */
-                this->AddRGBDOpticalFlowReprojFactor<TimeDeriv::LIN_POS_SPLINE,
-                                                     OPTICAL_FLOW_EST_INV_DEPTH>(
+                this->AddRGBDOpticalFlowFusedFactor<TimeDeriv::LIN_POS_SPLINE,
+                                                    OPTICAL_FLOW_EST_INV_DEPTH>(
                     estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
-
-                // this->AddVisualPPPTrifocalTensorFactor<TimeDeriv::LIN_VEL_SPLINE>(
-                //     estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
             }
             for (const auto &[topic, corrs] : visualVelCorrs) {
-                this->AddVisualOpticalFlowFactor<TimeDeriv::LIN_POS_SPLINE,
-                                                 OPTICAL_FLOW_EST_INV_DEPTH>(
-                    estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
                 /**
                  * when pos spline is maintained, we add additional reprojection constraints for
                  * optical flow tracking correspondence
                  */
-                this->AddVisualOpticalFlowReprojFactor<TimeDeriv::LIN_POS_SPLINE,
-                                                       OPTICAL_FLOW_EST_INV_DEPTH>(
+                this->AddVisualOpticalFlowFusedFactor<TimeDeriv::LIN_POS_SPLINE,
+                                                      OPTICAL_FLOW_EST_INV_DEPTH>(
                     estimator, topic, corrs, RefineReadoutTimeOptForCameras(topic, optOption));
             }
             for (const auto &[topic, corrs] : eventCorrs) {
@@ -231,18 +348,18 @@ CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
             }
         } break;
     }
+    estimator->SetResidualGroup("");
+}
 
-    // make this problem full rank
-    estimator->SetRefIMUParamsConstant();
-
-    estimator->PrintParameterInfo();
-
-    auto sum = estimator->Solve(_ceresOption, this->_priori);
-    spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
-
-    // align states to the gravity after the batch optimization is finished
-    AlignStatesToGravity();
-
+CalibSolver::BackUp::Ptr CalibSolver::UpdateByBatchOptimization(
+    const EstimatorPtr &estimator,
+    OptOption optOption,
+    const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs,
+    const std::map<std::string, std::vector<VisualReProjCorrSeqPtr>> &visualReprojCorrs,
+    const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &rgbdCorrs,
+    const std::map<std::string, std::vector<OpticalFlowCorrPtr>> &visualVelCorrs,
+    const std::map<std::string, std::vector<OpticalFlowCurveCorrPtr>> &eventCorrs,
+    const std::shared_ptr<double> &visualGlobalScale) const {
     // for better map consistency in visualization, we update the veta every time
     for (const auto &[topic, reprojCorrVec] : visualReprojCorrs) {
         auto &veta = _dataMagr->GetSfMData(topic);
@@ -313,6 +430,7 @@ CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
     // these quantities need to be backup for Hessian matrix finding in ceres
     auto backUp = std::make_shared<BackUp>();
     backUp->estimator = estimator;
+    backUp->optOption = optOption;
     backUp->visualGlobalScale = visualGlobalScale;
     backUp->lidarCorrs = lidarPtsCorrs;
     backUp->visualCorrs = visualReprojCorrs;
@@ -320,9 +438,213 @@ CalibSolver::BackUp::Ptr CalibSolver::BatchOptimization(
     for (const auto &[topic, corrs] : visualVelCorrs) {
         backUp->ofCorrs.insert({topic, corrs});
     }
+    backUp->eventCorrs = eventCorrs;
     // do not back up the maps
     backUp->lidarMap = nullptr;
     backUp->radarMap = nullptr;
     return backUp;
 }
+
+Estimator::Ptr CalibSolver::JointBatchOptimization(const std::vector<Ptr> &sessions,
+                                                   OptOption optOption,
+                                                   const std::vector<BatchOptCorrs> &corrs) {
+    const auto &lead = sessions.front();
+    const int count = static_cast<int>(sessions.size());
+    auto estimator = Estimator::Create(lead->_splines, lead->_parMagr);
+    // paddings are shared by sessions, as time offsets are
+    estimator->SetTemporalPadding(*lead->_temporalPadding);
+
+    std::vector<std::shared_ptr<double>> visualGlobalScales(count);
+    for (int k = 0; k < count; ++k) {
+        const auto &session = sessions.at(k);
+        const auto &corr = corrs.at(k);
+        // factors of this session are added on its own splines, parameters are shared
+        estimator->SwitchSplines(session->_splines);
+        // sfm reconstructions of sessions are up to their own scales
+        visualGlobalScales.at(k) = std::make_shared<double>(1.0);
+        session->AddBatchOptFactors(estimator, optOption, corr.lidarPtsCorrs,
+                                    corr.visualReprojCorrs, corr.rgbdCorrs, corr.visualVelCorrs,
+                                    corr.eventCorrs, std::nullopt, visualGlobalScales.at(k).get(),
+                                    true);
+        spdlog::info("factors of '{}-th' session are added, time range: '{:.3f}' (s)", k,
+                     session->_dataMagr->GetCalibTimeRange());
+    }
+
+    // make this problem full rank
+    estimator->SetRefIMUParamsConstant();
+
+    estimator->PrintParameterInfo();
+
+    auto sum = estimator->Solve(lead->_ceresOption, lead->_priori);
+    spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
+
+    for (const auto &[factor, factorCount] : estimator->FactorCounts()) {
+        StageProfiler::Count("Factors/" + factor, factorCount);
+    }
+
+    /**
+     * the estimated gravity is expressed in the (shared) reference frame before any alignment,
+     * states of each session are aligned using it, i.e., rotated about their own headings
+     */
+    const Eigen::Vector3d gravity = lead->_parMagr->GRAVITY;
+    for (int k = 0; k < count; ++k) {
+        const auto &session = sessions.at(k);
+        const auto &corr = corrs.at(k);
+        session->AlignStatesToGravity(gravity);
+        session->_backup = session->UpdateByBatchOptimization(
+            estimator, optOption, corr.lidarPtsCorrs, corr.visualReprojCorrs, corr.rgbdCorrs,
+            corr.visualVelCorrs, corr.eventCorrs, visualGlobalScales.at(k));
+    }
+    return estimator;
+}
+
+void CalibSolver::NarrowTemporalPaddings(const Estimator::Ptr &estimator) const {
+    if (Configor::Preference::TemporalPaddingSigma <= 0.0) {
+        return;
+    }
+    // estimated temporal parameters: [topic, is time offset (or readout time), parameter block]
+    std::vector<std::tuple<std::string, bool, double *>> temporalPars;
+    auto InvolveTemporalPars = [&temporalPars, &estimator](auto &parMap, bool isTimeOffset) {
+        for (auto &[topic, par] : parMap) {
+            if (estimator->HasParameterBlock(&par) && !estimator->IsParameterBlockConstant(&par)) {
+                temporalPars.emplace_back(topic, isTimeOffset, &par);
+            }
+        }
+    };
+    InvolveTemporalPars(_parMagr->TEMPORAL.TO_BiToBr, true);
+    InvolveTemporalPars(_parMagr->TEMPORAL.TO_RjToBr, true);
+    InvolveTemporalPars(_parMagr->TEMPORAL.TO_LkToBr, true);
+    InvolveTemporalPars(_parMagr->TEMPORAL.TO_CmToBr, true);
+    InvolveTemporalPars(_parMagr->TEMPORAL.TO_DnToBr, true);
+    InvolveTemporalPars(_parMagr->TEMPORAL.TO_EsToBr, true);
+    InvolveTemporalPars(_parMagr->TEMPORAL.RS_READOUT, false);
+    if (temporalPars.empty()) {
+        return;
+    }
+
+    // temporal blocks are kept, all other free blocks (knots, extrinsics, ...) are marginalized
+    std::vector<double *> keptBlocks, allBlocks, margBlocks;
+    for (const auto &[topic, isTimeOffset, par] : temporalPars) {
+        keptBlocks.push_back(par);
+    }
+    estimator->GetParameterBlocks(&allBlocks);
+    for (double *block : allBlocks) {
+        if (!estimator->IsParameterBlockConstant(block) &&
+            std::find(keptBlocks.cbegin(), keptBlocks.cend(), block) == keptBlocks.cend()) {
+            margBlocks.push_back(block);
+        }
+    }
+    Eigen::MatrixXd info;
+    try {
+        info = estimator->GetMarginalHessianMatrix(keptBlocks, margBlocks,
+                                                   Configor::Preference::AvailableThreads());
+    } catch (const IKalibrStatus &status) {
+        spdlog::warn("paddings of temporal parameters are not narrowed: {}", status.what);
+        return;
+    }
+    Eigen::LLT<Eigen::MatrixXd> llt(info);
+    if (llt.info() != Eigen::Success) {
+        spdlog::warn("paddings of temporal parameters are not narrowed: singular information");
+        return;
+    }
+    // the marginal covariance of temporal parameters
+    const Eigen::MatrixXd cov = llt.solve(Eigen::MatrixXd::Identity(info.rows(), info.cols()));
+
+    for (int i = 0; i < static_cast<int>(temporalPars.size()); ++i) {
+        const auto &[topic, isTimeOffset, par] = temporalPars.at(i);
+        const double stdDev = std::sqrt(std::max(cov(i, i), 0.0));
+        if (isTimeOffset) {
+            _temporalPadding->NarrowTimeOffset(topic, *par, stdDev);
+        } else {
+            _temporalPadding->NarrowReadoutTime(topic, *par, stdDev);
+        }
+    }
+    _temporalPadding->ShowPaddings();
+}
+
+std::pair<double, double> CalibSolver::ScheduledKnotTimeDist(int boIdx, int boCount) {
+    /**
+     * batch optimizations are divided into 'CoarseToFineLevels + 1' groups evenly, the first group
+     * uses the coarsest knots, and the knot distances are halved in each following group, so that
+     * the last group (at least the last batch optimization) uses the ones from the configure
+     */
+    const int levels =
+        std::clamp(Configor::Prior::KnotTimeDist::CoarseToFineLevels, 0, std::max(boCount - 1, 0));
+    const int level = std::max(levels - boIdx * (levels + 1) / std::max(boCount, 1), 0);
+    const double factor = static_cast<double>(1 << level);
+    return {Configor::Prior::KnotTimeDist::SO3Spline * factor,
+            Configor::Prior::KnotTimeDist::ScaleSpline * factor};
+}
+
+CalibSolver::SplineBundleType::Ptr CalibSolver::FitSplineBundle(double st,
+                                                                double et,
+                                                                double so3Dt,
+                                                                double scaleDt,
+                                                                int threads) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+
+    auto splines = CreateSplineBundle(st, et, so3Dt, scaleDt);
+    auto &nSo3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    auto &nScaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+
+    const double minTime = std::max({so3Spline.MinTime(), scaleSpline.MinTime(), st});
+    const double maxTime = std::min({so3Spline.MaxTime(), scaleSpline.MaxTime(), et});
+    auto ClampTime = [minTime, maxTime](double t) {
+        return std::clamp(t, minTime, maxTime - 1E-6);
+    };
+
+    /**
+     * initialize each control point using the current splines evaluated at the time it mainly
+     * influences, which is close enough to the fitted one (especially for the rotation spline)
+     */
+    constexpr double KnotTimeShift = (Configor::Prior::SplineOrder - 2) * 0.5;
+    for (int i = 0; i < static_cast<int>(nSo3Spline.GetKnots().size()); ++i) {
+        const double t = nSo3Spline.MinTime() + (i - KnotTimeShift) * so3Dt;
+        nSo3Spline.GetKnot(i) = so3Spline.Evaluate(ClampTime(t));
+    }
+    for (int i = 0; i < static_cast<int>(nScaleSpline.GetKnots().size()); ++i) {
+        const double t = nScaleSpline.MinTime() + (i - KnotTimeShift) * scaleDt;
+        nScaleSpline.GetKnot(i) = scaleSpline.Evaluate(ClampTime(t));
+    }
+
+    // fit the new splines to the current ones, several samples are used for each segment
+    constexpr int ValueDeriv = 0;
+    const auto optOption = OptOption::OPT_SO3_SPLINE | OptOption::OPT_SCALE_SPLINE;
+    const double sampleDt = std::min(so3Dt, scaleDt) * 0.25;
+    auto estimator = Estimator::Create(splines, _parMagr);
+    for (double t = minTime; t < maxTime; t += sampleDt) {
+        estimator->AddSO3Constraint(t, so3Spline.Evaluate(t), optOption, 1.0);
+        estimator->AddLinearScaleConstraint<ValueDeriv>(t, scaleSpline.Evaluate(t), optOption,
+                                                        1.0);
+    }
+    // add tail factors (constraints) to maintain enough observability
+    estimator->AddLinScaleTailConstraint(optOption, 1.0);
+    estimator->AddSO3TailConstraint(optOption, 1.0);
+
+    // we don't want to output the solving information
+    auto solveOpt =
+        Estimator::DefaultSolverOptions(threads, false, Configor::Preference::UseCudaInSolving);
+    auto sum = estimator->Solve(solveOpt, _priori);
+    spdlog::info("fit splines with knot distances (so3: '{:.5f}', scale: '{:.5f}'): {}", so3Dt,
+                 scaleDt, sum.BriefReport());
+
+    return splines;
+}
+
+void CalibSolver::RefitSplineBundle(double so3Dt, double scaleDt) {
+    auto splines =
+        FitSplineBundle(_dataMagr->GetCalibStartTimestamp(), _dataMagr->GetCalibEndTimestamp(),
+                        so3Dt, scaleDt, Configor::Preference::AvailableThreads());
+    /**
+     * splines are replaced in place, as they are shared with the viewer. The estimator kept for
+     * reusing holds the addresses of the replaced control points, thus can not be reused anymore
+     */
+    *_splines = *splines;
+    if (_backup != nullptr) {
+        _backup->estimator = nullptr;
+    }
+    // cached metas are keyed by the bundle address, but bound to the replaced knot layout
+    SplineMetaCache::GetCache(_splines)->Clear();
+}
 }  // namespace ns_ikalibr
\ No newline at end of file
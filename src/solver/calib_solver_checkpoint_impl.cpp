@@ -0,0 +1,274 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/calib_data_cache.h"
+#include "calib/calib_data_manager.h"
+#include "calib/calib_param_manager.h"
+#include "calib/flat_param_io.h"
+#include "calib/spline_meta_cache.h"
+#include "cereal/types/map.hpp"
+#include "cereal/types/string.hpp"
+#include "core/optical_flow_trace.h"
+#include "factor/data_correspondence.h"
+#include "sensor/rgbd.h"
+#include "solver/calib_solver.h"
+#include "util/status.hpp"
+#include "viewer/viewer.h"
+#include "spdlog/spdlog.h"
+#include "algorithm"
+#include "filesystem"
+#include "fstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+// increase this version once the layout of the checkpoint changes
+constexpr static std::uint32_t CHECKPOINT_VERSION = 2;
+// the checkpoint saved after the initialization, and the prefix of ones after batch optimizations
+static const std::string INIT_STAGE = "stage_3_scale_fit", BO_STAGE_PREFIX = "stage_4_bo_";
+
+/**
+ * the optical flow triple trace is stored by ids, timestamps, and pixels of its frames, which are
+ * bound to the loaded camera (rgbd) frames again when the checkpoint is loaded
+ */
+struct OpticalFlowTraceRecord {
+    std::array<ns_veta::IndexT, 3> ids{};
+    std::array<double, 3> times{};
+    std::array<Eigen::Vector2d, 3> pixels;
+
+    template <class Archive>
+    void serialize(Archive &ar) {
+        ar(CEREAL_NVP(ids), CEREAL_NVP(times), CEREAL_NVP(pixels));
+    }
+};
+
+/**
+ * the checkpoint is bound to the data (the same as the data cache) and the knot distances of
+ * splines, which decide the layout of serialized splines
+ */
+static std::string CheckpointKey() {
+    return CalibDataCache::CreateFromConfigor()->GetKey() +
+           fmt::format("knots: {:.9f}, {:.9f}\n", Configor::Prior::KnotTimeDist::SO3Spline,
+                       Configor::Prior::KnotTimeDist::ScaleSpline);
+}
+
+static std::string CheckpointDir(const std::string &desc) {
+    return Configor::DataStream::OutputPath + "/checkpoint/" + desc;
+}
+
+void CalibSolver::SaveStageCheckpoint(const std::string &desc) const {
+    const std::string dir = CheckpointDir(desc);
+    if (!std::filesystem::exists(dir) && !std::filesystem::create_directories(dir)) {
+        spdlog::warn("create directory failed: '{}'", dir);
+        return;
+    }
+    spdlog::info("saving checkpoint of stage '{}' to dir: '{}'...", desc, dir);
+
+    // sfm data is stored by the veta library
+    std::vector<std::string> sfmTopics;
+    for (const auto &[topic, veta] : _dataMagr->GetSfMData()) {
+        if (veta == nullptr) {
+            continue;
+        }
+        const std::string subDir = dir + "/sfm/" + topic;
+        if (!std::filesystem::exists(subDir) && !std::filesystem::create_directories(subDir)) {
+            spdlog::warn("create directory failed: '{}'", subDir);
+            return;
+        }
+        if (!ns_veta::Save(*veta, subDir + "/veta.bin", ns_veta::Veta::ALL)) {
+            spdlog::warn("save veta for camera '{}' to checkpoint failed: '{}'", topic, subDir);
+            return;
+        }
+        sfmTopics.push_back(topic);
+    }
+
+    std::map<std::string, std::vector<OpticalFlowTraceRecord>> traces;
+    for (const auto &[topic, traceVec] : _dataMagr->GetVisualOpticalFlowTrace()) {
+        auto &records = traces[topic];
+        records.reserve(traceVec.size());
+        for (const auto &trace : traceVec) {
+            const auto movement = trace->GetTrace();
+            OpticalFlowTraceRecord record;
+            for (int i = 0; i < 3; ++i) {
+                record.ids.at(i) = movement.at(i).first->GetId();
+                record.times.at(i) = movement.at(i).first->GetTimestamp();
+                record.pixels.at(i) = movement.at(i).second;
+            }
+            records.push_back(record);
+        }
+    }
+
+    // splines and parameters are stored in the flat layout, which is fast to write and to load
+    if (!FlatParamIO::SaveSplines(_splines, dir + "/splines" + FlatParamIO::EXTENSION) ||
+        !FlatParamIO::SaveParams(_parMagr, dir + "/params" + FlatParamIO::EXTENSION)) {
+        spdlog::warn("save splines and parameters to checkpoint failed: '{}'", dir);
+        return;
+    }
+
+    // write a temporary file first, so that an interrupted saving would not leave a broken one
+    const std::string filename = dir + "/checkpoint.bin", tmpFilename = filename + ".tmp";
+    {
+        std::ofstream file(tmpFilename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            spdlog::warn("open checkpoint file failed: '{}'", tmpFilename);
+            return;
+        }
+        cereal::BinaryOutputArchive ar(file);
+        ar(CHECKPOINT_VERSION, CheckpointKey(), traces, _dataMagr->GetVisualFeatureTrackingCurve(),
+           sfmTopics);
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpFilename, filename, ec);
+    if (ec) {
+        spdlog::warn("save checkpoint file failed: '{}', {}", filename, ec.message());
+    } else {
+        spdlog::info("checkpoint of stage '{}' is saved as '{}'", desc, filename);
+    }
+}
+
+int CalibSolver::LoadStageCheckpoint(const std::string &desc) {
+    // the index of the batch optimization performed after this stage
+    int boIdx = -1;
+    if (desc == INIT_STAGE) {
+        boIdx = 0;
+    } else if (desc.rfind(BO_STAGE_PREFIX, 0) == 0) {
+        const std::string idxStr = desc.substr(BO_STAGE_PREFIX.size());
+        if (!idxStr.empty() && std::all_of(idxStr.cbegin(), idxStr.cend(), ::isdigit)) {
+            boIdx = std::stoi(idxStr) + 1;
+        }
+    }
+    if (boIdx < 0) {
+        throw Status(Status::ERROR,
+                     "unknown stage '{}' to resume from, which should be '{}' or '{}i' (i >= 0)",
+                     desc, INIT_STAGE, BO_STAGE_PREFIX);
+    }
+
+    const std::string dir = CheckpointDir(desc), filename = dir + "/checkpoint.bin";
+    if (!std::filesystem::exists(filename)) {
+        throw Status(Status::ERROR, "the checkpoint of stage '{}', i.e., '{}', dose not exist!!!",
+                     desc, filename);
+    }
+    spdlog::info("loading checkpoint of stage '{}' from '{}'...", desc, filename);
+
+    std::ifstream file(filename, std::ios::binary);
+    cereal::BinaryInputArchive ar(file);
+
+    std::uint32_t version = 0;
+    std::string key;
+    ar(version, key);
+    if (version != CHECKPOINT_VERSION || key != CheckpointKey()) {
+        throw Status(Status::ERROR,
+                     "the checkpoint '{}' is bound to other data or spline configurations, which "
+                     "can not be resumed from!!!",
+                     filename);
+    }
+
+    std::map<std::string, std::vector<OpticalFlowTraceRecord>> traces;
+    std::map<std::string, std::vector<FeatureTrackingCurve::Ptr>> curves;
+    std::vector<std::string> sfmTopics;
+    ar(traces, curves, sfmTopics);
+
+    // the parameter manager and splines are shared with the viewer, thus replaced in place
+    auto splines = FlatParamIO::LoadSplines(dir + "/splines" + FlatParamIO::EXTENSION);
+    FlatParamIO::LoadParams(dir + "/params" + FlatParamIO::EXTENSION, _parMagr);
+    *_splines = *splines;
+    // the knot layout of loaded splines may differ, metas cached for the bundle are stale
+    SplineMetaCache::GetCache(_splines)->Clear();
+
+    for (const auto &topic : sfmTopics) {
+        auto veta = ns_veta::Veta::Create();
+        const std::string vetaFilename = dir + "/sfm/" + topic + "/veta.bin";
+        if (!ns_veta::Load(*veta, vetaFilename, ns_veta::Veta::ALL)) {
+            throw Status(Status::ERROR, "load veta of camera '{}' from checkpoint failed: '{}'",
+                         topic, vetaFilename);
+        }
+        _dataMagr->SetSfMData(topic, veta);
+    }
+
+    for (const auto &[topic, records] : traces) {
+        // traces of event cameras are bound to image-less frames, which are created here
+        const bool isEvent = Configor::DataStream::EventTopics.count(topic) != 0;
+        std::map<ns_veta::IndexT, CameraFrame::Ptr> frames;
+        if (Configor::DataStream::RGBDTopics.count(topic) != 0) {
+            for (const auto &frame : _dataMagr->GetRGBDMeasurements(topic)) {
+                frames.insert({frame->GetId(), frame});
+            }
+        } else if (!isEvent) {
+            for (const auto &frame : _dataMagr->GetCameraMeasurements(topic)) {
+                frames.insert({frame->GetId(), frame});
+            }
+        }
+        std::map<std::pair<ns_veta::IndexT, double>, CameraFrame::Ptr> eventFrames;
+
+        std::vector<OpticalFlowTripleTrace::Ptr> traceVec;
+        traceVec.reserve(records.size());
+        for (const auto &record : records) {
+            std::array<std::pair<CameraFrame::Ptr, Eigen::Vector2d>, 3> movement;
+            for (int i = 0; i < 3; ++i) {
+                const auto id = record.ids.at(i);
+                const double time = record.times.at(i);
+                CameraFrame::Ptr frame;
+                if (isEvent) {
+                    auto &eventFrame = eventFrames[{id, time}];
+                    if (eventFrame == nullptr) {
+                        eventFrame = CameraFrame::Create(time, cv::Mat(), cv::Mat(), id);
+                    }
+                    frame = eventFrame;
+                } else if (auto iter = frames.find(id); iter != frames.cend()) {
+                    frame = iter->second;
+                } else {
+                    throw Status(Status::ERROR,
+                                 "frame '{}' of '{}' in the checkpoint is not found in data", id,
+                                 topic);
+                }
+                movement.at(i) = {frame, record.pixels.at(i)};
+            }
+            traceVec.push_back(OpticalFlowTripleTrace::Create(movement));
+        }
+        _dataMagr->SetVisualOpticalFlowTrace(topic, traceVec);
+    }
+
+    for (const auto &[topic, curveVec] : curves) {
+        _dataMagr->SetVisualFeatureTrackingCurve(topic, curveVec);
+    }
+
+    _viewer->UpdateSplineViewer();
+    spdlog::info("resume from stage '{}', the '{}-th' batch optimization would be performed next",
+                 desc, boIdx);
+    return boIdx;
+}
+}  // namespace ns_ikalibr
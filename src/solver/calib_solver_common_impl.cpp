@@ -36,6 +36,7 @@
 #include "calib/calib_param_manager.h"
 #include "calib/ceres_callback.h"
 #include "calib/estimator.h"
+#include "calib/pose_query_cursor.h"
 #include "calib/spat_temp_priori.h"
 #include "core/colmap_data_io.h"
 #include "core/optical_flow_trace.h"
@@ -48,11 +49,16 @@
 #include "sensor/camera_data_loader.h"
 #include "solver/calib_solver.h"
 #include "spdlog/sinks/basic_file_sink.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "util/utils_tpl.hpp"
 #include "viewer/viewer.h"
+#include "viewer/viewer_bridge.h"
 #include "core/haste_data_io.h"
 #include "core/event_preprocessing.h"
+#include "core/event_rasterizer.h"
+#include "omp.h"
+#include "atomic"
+#include "numeric"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -97,15 +103,25 @@ std::map<std::string, ns_veta::IndexT> ImagesInfo::GetImagesNameToIdx() const {
 // -----------
 
 CalibSolver::CalibSolver(CalibDataManager::Ptr calibDataManager,
-                         CalibParamManager::Ptr calibParamManager)
-    : _dataMagr(std::move(calibDataManager)),
+                         CalibParamManager::Ptr calibParamManager,
+                         CalibContextPtr context)
+    : _context(context != nullptr ? std::move(context) : calibDataManager->GetContext()),
+      _dataMagr(std::move(calibDataManager)),
       _parMagr(std::move(calibParamManager)),
       _priori(nullptr),
-      _ceresOption(Estimator::DefaultSolverOptions(
-          Configor::Preference::AvailableThreads(), true, Configor::Preference::UseCudaInSolving)),
       _viewer(nullptr),
+      _viewerBridge(nullptr),
       _initAsset(new InitAsset),
-      _solveFinished(false) {
+      _surfelAsset(new SurfelMapAsset),
+      _lifetimePlanner(nullptr),
+      _temporalPadding(TemporalPadding::Create()),
+      _solveFinished(false),
+      _batchOptProblemIdx(0),
+      _factorProfileIdx(0) {
+    auto scope = _context->Activate();
+    _ceresOption = Estimator::DefaultSolverOptions(Configor::Preference::AvailableThreads(), true,
+                                                   Configor::Preference::UseCudaInSolving);
+
     // create so3 and linear scale splines given start and end times, knot distances
     _splines = CreateSplineBundle(
         _dataMagr->GetCalibStartTimestamp(), _dataMagr->GetCalibEndTimestamp(),
@@ -116,11 +132,18 @@ CalibSolver::CalibSolver(CalibDataManager::Ptr calibDataManager,
     auto modelPath = ros::package::getPath("ikalibr") + "/model/ikalibr.obj";
     _viewer->FillEmptyViews(modelPath);
 
+    _viewerBridge = ViewerBridge::Create(_viewer);
+
     // pass the 'CeresViewerCallBack' to ceres option so that update the viewer after every
-    // iteration in ceres
-    _ceresOption.callbacks.push_back(new CeresViewerCallBack(_viewer));
+    // iteration in ceres (asynchronously, through the viewer bridge)
+    _ceresOption.callbacks.push_back(new CeresViewerCallBack(_viewerBridge));
     _ceresOption.update_state_every_iteration = true;
 
+    // trace ceres iterations if needed
+    if (IsOptionWith(OutputOption::TraceEvents, Configor::Preference::Outputs)) {
+        _ceresOption.callbacks.push_back(new CeresTraceCallBack());
+    }
+
     // output spatiotemporal parameters after each iteration if needed
     if (IsOptionWith(OutputOption::ParamInEachIter, Configor::Preference::Outputs)) {
         _ceresOption.callbacks.push_back(new CeresDebugCallBack(_parMagr));
@@ -136,11 +159,28 @@ CalibSolver::CalibSolver(CalibDataManager::Ptr calibDataManager,
 }
 
 CalibSolver::Ptr CalibSolver::Create(const CalibDataManager::Ptr &calibDataManager,
-                                     const CalibParamManager::Ptr &calibParamManager) {
-    return std::make_shared<CalibSolver>(calibDataManager, calibParamManager);
+                                     const CalibParamManager::Ptr &calibParamManager,
+                                     const CalibContextPtr &context) {
+    return std::make_shared<CalibSolver>(calibDataManager, calibParamManager, context);
+}
+
+const CalibContextPtr &CalibSolver::GetContext() const { return _context; }
+
+void CalibSolver::CloseViewer() const {
+    pangolin::QuitAll();
+    while (_viewer->IsActive()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
 }
 
 CalibSolver::~CalibSolver() {
+    // no snapshot would be rendered after solving
+    _viewerBridge->Stop();
+    // callbacks are created by the solver, e.g., pending parameter dumps are written on deleting
+    for (auto *callback : _ceresOption.callbacks) {
+        delete callback;
+    }
+    _ceresOption.callbacks.clear();
     // solving is not performed or not finished as an exception is thrown
     if (!_solveFinished) {
         pangolin::QuitAll();
@@ -152,102 +192,75 @@ CalibSolver::~CalibSolver() {
 }
 
 std::optional<Sophus::SE3d> CalibSolver::CurBrToW(double timeByBr) const {
+    return BrToWCursor().Query(timeByBr);
+}
+
+std::optional<Sophus::SE3d> CalibSolver::CurLkToW(double timeByLk, const std::string &topic) const {
+    return LkToWCursor(topic).Query(timeByLk);
+}
+
+std::optional<Sophus::SE3d> CalibSolver::CurCmToW(double timeByCm, const std::string &topic) const {
+    return CmToWCursor(topic).Query(timeByCm);
+}
+
+std::optional<Sophus::SE3d> CalibSolver::CurEsToW(double timeByEs, const std::string &topic) const {
+    return EsToWCursor(topic).Query(timeByEs);
+}
+
+std::optional<Sophus::SE3d> CalibSolver::CurDnToW(double timeByDn, const std::string &topic) const {
+    return DnToWCursor(topic).Query(timeByDn);
+}
+
+std::optional<Sophus::SE3d> CalibSolver::CurRjToW(double timeByRj, const std::string &topic) const {
+    return RjToWCursor(topic).Query(timeByRj);
+}
+
+PoseQueryCursor CalibSolver::BrToWCursor() const {
     if (GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         throw Status(Status::CRITICAL,
                      "'CurBrToW' error, scale spline is not translation spline!!!");
     }
-    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-    if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-        return {};
-    } else {
-        return Sophus::SE3d(so3Spline.Evaluate(timeByBr), posSpline.Evaluate(timeByBr));
-    }
+    return {_splines, 0.0};
 }
 
-std::optional<Sophus::SE3d> CalibSolver::CurLkToW(double timeByLk, const std::string &topic) const {
+PoseQueryCursor CalibSolver::LkToWCursor(const std::string &topic) const {
     if (GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         throw Status(Status::CRITICAL,
                      "'CurLkToW' error, scale spline is not translation spline!!!");
     }
-    double timeByBr = timeByLk + _parMagr->TEMPORAL.TO_LkToBr.at(topic);
-    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-
-    if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-        return {};
-    } else {
-        Sophus::SE3d curBrToW(so3Spline.Evaluate(timeByBr), posSpline.Evaluate(timeByBr));
-        return curBrToW * _parMagr->EXTRI.SE3_LkToBr(topic);
-    }
+    return {_splines, _parMagr->TEMPORAL.TO_LkToBr.at(topic), _parMagr->EXTRI.SE3_LkToBr(topic)};
 }
 
-std::optional<Sophus::SE3d> CalibSolver::CurCmToW(double timeByCm, const std::string &topic) const {
+PoseQueryCursor CalibSolver::CmToWCursor(const std::string &topic) const {
     if (GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         throw Status(Status::CRITICAL,
                      "'CurCmToW' error, scale spline is not translation spline!!!");
     }
-    double timeByBr = timeByCm + _parMagr->TEMPORAL.TO_CmToBr.at(topic);
-    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-
-    if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-        return {};
-    } else {
-        Sophus::SE3d curBrToW(so3Spline.Evaluate(timeByBr), posSpline.Evaluate(timeByBr));
-        return curBrToW * _parMagr->EXTRI.SE3_CmToBr(topic);
-    }
+    return {_splines, _parMagr->TEMPORAL.TO_CmToBr.at(topic), _parMagr->EXTRI.SE3_CmToBr(topic)};
 }
 
-std::optional<Sophus::SE3d> CalibSolver::CurEsToW(double timeByEs, const std::string &topic) const {
+PoseQueryCursor CalibSolver::EsToWCursor(const std::string &topic) const {
     if (GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         throw Status(Status::CRITICAL,
                      "'CurEsToW' error, scale spline is not translation spline!!!");
     }
-    double timeByBr = timeByEs + _parMagr->TEMPORAL.TO_EsToBr.at(topic);
-    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-
-    if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-        return {};
-    } else {
-        Sophus::SE3d curBrToW(so3Spline.Evaluate(timeByBr), posSpline.Evaluate(timeByBr));
-        return curBrToW * _parMagr->EXTRI.SE3_EsToBr(topic);
-    }
+    return {_splines, _parMagr->TEMPORAL.TO_EsToBr.at(topic), _parMagr->EXTRI.SE3_EsToBr(topic)};
 }
 
-std::optional<Sophus::SE3d> CalibSolver::CurDnToW(double timeByDn, const std::string &topic) const {
+PoseQueryCursor CalibSolver::DnToWCursor(const std::string &topic) const {
     if (GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         throw Status(Status::CRITICAL,
                      "'CurDnToW' error, scale spline is not translation spline!!!");
     }
-    double timeByBr = timeByDn + _parMagr->TEMPORAL.TO_DnToBr.at(topic);
-    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-
-    if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-        return {};
-    } else {
-        Sophus::SE3d curBrToW(so3Spline.Evaluate(timeByBr), posSpline.Evaluate(timeByBr));
-        return curBrToW * _parMagr->EXTRI.SE3_DnToBr(topic);
-    }
+    return {_splines, _parMagr->TEMPORAL.TO_DnToBr.at(topic), _parMagr->EXTRI.SE3_DnToBr(topic)};
 }
 
-std::optional<Sophus::SE3d> CalibSolver::CurRjToW(double timeByRj, const std::string &topic) const {
+PoseQueryCursor CalibSolver::RjToWCursor(const std::string &topic) const {
     if (GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         throw Status(Status::CRITICAL,
                      "'CurRjToW' error, scale spline is not translation spline!!!");
     }
-    double timeByBr = timeByRj + _parMagr->TEMPORAL.TO_RjToBr.at(topic);
-    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-
-    if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-        return {};
-    } else {
-        Sophus::SE3d curBrToW(so3Spline.Evaluate(timeByBr), posSpline.Evaluate(timeByBr));
-        return curBrToW * _parMagr->EXTRI.SE3_RjToBr(topic);
-    }
+    return {_splines, _parMagr->TEMPORAL.TO_RjToBr.at(topic), _parMagr->EXTRI.SE3_RjToBr(topic)};
 }
 
 TimeDeriv::ScaleSplineType CalibSolver::GetScaleType() {
@@ -277,14 +290,16 @@ CalibSolver::SplineBundleType::Ptr CalibSolver::CreateSplineBundle(double st,
     return SplineBundleType::Create({so3SplineInfo, scaleSplineInfo});
 }
 
-void CalibSolver::AlignStatesToGravity() const {
+void CalibSolver::AlignStatesToGravity() const { AlignStatesToGravity(_parMagr->GRAVITY); }
+
+void CalibSolver::AlignStatesToGravity(const Eigen::Vector3d &gravity) const {
     auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
     // current gravity, velocities, and rotations are expressed in the reference frame
     // align them to the world frame whose negative z axis is aligned with the gravity vector
     auto SO3_RefToW =
-        ObtainAlignedWtoRef(so3Spline.Evaluate(so3Spline.MinTime()), _parMagr->GRAVITY).inverse();
-    _parMagr->GRAVITY = SO3_RefToW * _parMagr->GRAVITY;
+        ObtainAlignedWtoRef(so3Spline.Evaluate(so3Spline.MinTime()), gravity).inverse();
+    _parMagr->GRAVITY = SO3_RefToW * gravity;
     for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
         so3Spline.GetKnot(i) = SO3_RefToW * so3Spline.GetKnot(i);
     }
@@ -294,6 +309,43 @@ void CalibSolver::AlignStatesToGravity() const {
     }
 }
 
+void CalibSolver::RunTrackingPipelines(
+    const std::vector<std::string> &topics,
+    const std::function<void(const std::string &, int, bool)> &pipeline) {
+    const int topicCount = static_cast<int>(topics.size());
+    // parallel regions in pipelines, e.g., feature tracking, share the budget of their worker
+    const Configor::Preference::ThreadSplit split(topicCount);
+    const int pipelineCount = split.Workers();
+    // the viewer, highgui windows and progress bars are not thread-safe, used in the serial case
+    const bool inSerial = pipelineCount == 1;
+    /**
+     * frames decoded by all pipelines share the lazy image cache, the prefetched frames of a
+     * pipeline should not be evicted by other pipelines before they are tracked
+     */
+    const int cacheCapacity = static_cast<int>(Configor::Preference::LazyImageCacheCapacity);
+    const int prefetchDepth = std::clamp(cacheCapacity / (2 * pipelineCount), 1, 16);
+    spdlog::info("track features of '{}' camera(s) using '{}' pipeline(s)", topicCount,
+                 pipelineCount);
+
+    std::vector<std::exception_ptr> exceptions(topicCount, nullptr);
+#pragma omp parallel for num_threads(pipelineCount) schedule(dynamic) default(none) \
+    shared(topicCount, topics, pipeline, prefetchDepth, inSerial, exceptions, split)
+    for (int i = 0; i < topicCount; ++i) {
+        const auto binding = split.EnterWorker();
+        try {
+            pipeline(topics.at(i), prefetchDepth, inSerial);
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
+        }
+    }
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+}
+
 void CalibSolver::StoreImagesForSfM(const std::string &topic,
                                     const std::set<IndexPair> &matchRes) const {
     // -------------
@@ -309,31 +361,101 @@ void CalibSolver::StoreImagesForSfM(const std::string &topic,
 
     int size = static_cast<int>(frames.size());
     const auto &intri = _parMagr->INTRI.Camera.at(topic);
-    auto undistoMapper = VisualUndistortionMap::Create(intri);
+    auto undistoMapper = VisualUndistortionMap::Obtain(intri);
+
+    auto ws = ns_ikalibr::Configor::DataStream::CreateSfMWorkspace(topic);
+    if (ws == std::nullopt) {
+        throw ns_ikalibr::Status(Status::CRITICAL,
+                                 "can not create workspace for SfM for topic: '{}'!!!", topic);
+    }
+
+    /**
+     * images stored in the last run are reused if they are undistorted using the same intrinsics,
+     * which is identified by the hash of the serialized intrinsics
+     */
+    std::string intriHash;
+    {
+        std::stringstream stream;
+        {
+            cereal::JSONOutputArchive ar(stream);
+            ar(cereal::make_nvp("Intrinsics", intri));
+        }
+        intriHash = fmt::format("{:016x}", std::hash<std::string>{}(stream.str()));
+    }
+    const std::string intriHashFile = *ws + "/stored-images-intri-hash.txt";
+    bool reuseStored = false;
+    if (std::filesystem::exists(intriHashFile)) {
+        std::ifstream hashFile(intriHashFile, std::ios::in);
+        std::string lastHash;
+        hashFile >> lastHash;
+        reuseStored = lastHash == intriHash;
+    }
+    // the hash is rewritten once all images are stored
+    std::filesystem::remove(intriHashFile);
 
-    auto bar = std::make_shared<tqdm>();
+    std::vector<std::string> filenames(size);
     for (int i = 0; i != size; ++i) {
-        bar->progress(i, size);
         const auto &frame = frames.at(i);
         // generate the image name
-        std::string filename = std::to_string(frame->GetId()) + ".jpg";
-        info.images[frame->GetId()] = filename;
+        filenames.at(i) = std::to_string(frame->GetId()) + ".jpg";
+        info.images[frame->GetId()] = filenames.at(i);
+    }
 
-        cv::Mat undistImg = undistoMapper->RemoveDistortion(frame->GetImage());
+    spdlog::info("store undistorted images of camera '{}' using '{}' thread(s)...", topic,
+                 Configor::Preference::AvailableThreads());
+    std::atomic<int> reusedCount(0);
+    std::vector<std::exception_ptr> exceptions(size, nullptr);
+    auto bar = ProgressStage::Create(fmt::format("store images of '{}'", topic), size);
+    // undistortion, jpeg encoding, and writing are performed in parallel for frames
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(size, frames, filenames, path, reuseStored, undistoMapper, exceptions, \
+                             reusedCount, bar)
+    for (int i = 0; i < size; ++i) {
+        try {
+            const std::string filename = *path + "/" + filenames.at(i);
+            if (reuseStored && std::filesystem::exists(filename)) {
+                ++reusedCount;
+            } else {
+                cv::Mat undistImg = undistoMapper->RemoveDistortion(frames.at(i)->GetImage());
+                std::vector<uchar> buffer;
+                if (!cv::imencode(".jpg", undistImg, buffer)) {
+                    throw Status(Status::ERROR, "encode image '{}' failed!!!", filename);
+                }
+                // write to a temporary file first, thus no broken image would be reused
+                const std::string tmpFilename = filename + ".tmp";
+                {
+                    std::ofstream file(tmpFilename, std::ios::out | std::ios::binary);
+                    file.write(reinterpret_cast<const char *>(buffer.data()),
+                               static_cast<std::streamsize>(buffer.size()));
+                    if (!file) {
+                        throw Status(Status::ERROR, "write image '{}' failed!!!", filename);
+                    }
+                }
+                std::filesystem::rename(tmpFilename, filename);
+            }
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
+        }
+        bar->Step();
+    }
+    bar->Finish();
 
-        // save image
-        cv::imwrite(*path + "/" + filename, undistImg);
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
     }
-    bar->finish();
+    {
+        std::ofstream hashFile(intriHashFile, std::ios::out);
+        hashFile << intriHash << std::endl;
+    }
+    spdlog::info("'{}' images stored for camera '{}', '{}' of them are reused from the last run",
+                 size, topic, reusedCount.load());
 
     // -------------------
     // colmap command line
     // -------------------
-    auto ws = ns_ikalibr::Configor::DataStream::CreateSfMWorkspace(topic);
-    if (ws == std::nullopt) {
-        throw ns_ikalibr::Status(Status::CRITICAL,
-                                 "can not create workspace for SfM for topic: '{}'!!!", topic);
-    }
     const std::string database_path = *ws + "/database.db";
     const std::string &image_path = *path;
     const std::string match_list_path = *ws + "/matches.txt";
@@ -445,28 +567,42 @@ ns_veta::Veta::Ptr CalibSolver::TryLoadSfMData(const std::string &topic,
         return nullptr;
     }
 
-    const auto camerasFilename = *sfmWsPath + "/cameras.txt";
+    /**
+     * the binary model (output by the colmap / glomap mapper in '/0' of the workspace, or converted
+     * to the workspace) is preferred, which is streamed into the veta, otherwise, the text one
+     */
+    std::optional<std::string> binaryModelPath;
+    for (const auto &dir : {*sfmWsPath, *sfmWsPath + "/0"}) {
+        if (std::filesystem::exists(dir + "/cameras.bin") &&
+            std::filesystem::exists(dir + "/images.bin") &&
+            std::filesystem::exists(dir + "/points3D.bin")) {
+            binaryModelPath = dir;
+            break;
+        }
+    }
+    const std::string modelPath = binaryModelPath ? *binaryModelPath : *sfmWsPath;
+    const std::string modelExt = binaryModelPath ? ".bin" : ".txt";
+
+    const auto camerasFilename = modelPath + "/cameras" + modelExt;
     if (!std::filesystem::exists(camerasFilename)) {
         spdlog::warn("the cameras file, i.e., '{}', dose not exists!!!", camerasFilename);
         return nullptr;
     }
 
     // images
-    const auto imagesFilename = *sfmWsPath + "/images.txt";
+    const auto imagesFilename = modelPath + "/images" + modelExt;
     if (!std::filesystem::exists(imagesFilename)) {
         spdlog::warn("the images file, i.e., '{}', dose not exists!!!", imagesFilename);
         return nullptr;
     }
 
     // points
-    const auto ptsFilename = *sfmWsPath + "/points3D.txt";
+    const auto ptsFilename = modelPath + "/points3D" + modelExt;
     if (!std::filesystem::exists(ptsFilename)) {
         spdlog::warn("the points 3D file, i.e., '{}', dose not exists!!!", ptsFilename);
         return nullptr;
     }
 
-    // cameras
-
     // load info file
     ImagesInfo info("", "", {});
     {
@@ -477,13 +613,8 @@ ns_veta::Veta::Ptr CalibSolver::TryLoadSfMData(const std::string &topic,
     }
 
     // load cameras
-    auto cameras = ColMapDataIO::ReadCamerasText(camerasFilename);
-
-    // load images
-    auto images = ColMapDataIO::ReadImagesText(imagesFilename);
-
-    // load landmarks
-    auto points3D = ColMapDataIO::ReadPoints3DText(ptsFilename);
+    auto cameras = binaryModelPath ? ColMapDataIO::ReadCamerasBinary(camerasFilename)
+                                   : ColMapDataIO::ReadCamerasText(camerasFilename);
 
     auto veta = ns_veta::Veta::Create();
 
@@ -502,14 +633,15 @@ ns_veta::Veta::Ptr CalibSolver::TryLoadSfMData(const std::string &topic,
     }
 
     const auto &nameToOurIdx = info.GetImagesNameToIdx();
-    for (const auto &[IdFromColmap, image] : images) {
+    // add the view and pose of the image, returns false if this frame is not involved in solving
+    auto AddView = [&](const ColMapDataIO::Image &image) {
         const auto &viewId = nameToOurIdx.at(image.name_);
         const auto &poseId = viewId;
 
         auto frameIter = ourIdxToCamFrame.find(viewId);
         // this frame is not involved in solving
         if (frameIter == ourIdxToCamFrame.cend()) {
-            continue;
+            return false;
         }
 
         // view
@@ -526,16 +658,86 @@ ns_veta::Veta::Ptr CalibSolver::TryLoadSfMData(const std::string &topic,
         auto T_WorldToImg = ns_veta::Posed(image.QuatWorldToImg().matrix(), image.tvec_);
         // we store pose from camera to world
         veta->poses.insert({poseId, T_WorldToImg.Inverse()});
+        return true;
+    };
+    auto CheckReconstructed = [&]() {
+        for (const auto &frame : _dataMagr->GetCameraMeasurements(topic)) {
+            if (veta->views.count(frame->GetId()) == 0) {
+                spdlog::warn(
+                    "frame indexed as '{}' of camera '{}' is involved in solving but not "
+                    "reconstructed in SfM!!!",
+                    frame->GetId(), topic);
+            }
+        }
+    };
+
+    if (binaryModelPath) {
+        /**
+         * images are streamed, and only 2D points that are connected to landmarks are kept for
+         * involved views, sorted by their indices: image id, [view id, 2D points]
+         */
+        using Point2DVec = std::vector<std::pair<ColMapDataIO::point2D_t, Eigen::Vector2d>>;
+        std::unordered_map<ColMapDataIO::image_t, std::pair<ns_veta::IndexT, Point2DVec>> imgObs;
+        ColMapDataIO::ForEachImageBinary(imagesFilename, [&](const ColMapDataIO::Image &image) {
+            if (!AddView(image)) {
+                return;
+            }
+            auto &[viewId, points2D] = imgObs[image.image_id_];
+            viewId = nameToOurIdx.at(image.name_);
+            for (std::size_t idx = 0; idx < image.points2D_.size(); ++idx) {
+                const auto &pt2d = image.points2D_.at(idx);
+                if (pt2d.point3D_id_ != ColMapDataIO::kInvalidPoint3DId) {
+                    points2D.emplace_back(static_cast<ColMapDataIO::point2D_t>(idx), pt2d.xy_);
+                }
+            }
+        });
+        CheckReconstructed();
+
+        // landmarks are streamed, and organized as our structure directly
+        ColMapDataIO::ForEachPoint3DBinary(
+            ptsFilename, [&](ColMapDataIO::point3D_t pt3dId, const ColMapDataIO::Point3D &pt3d) {
+                // filter bad landmarks
+                if (pt3d.error_ > errorThd || pt3d.track_.size() < trackLenThd) {
+                    return;
+                }
+                ns_veta::Landmark lm;
+                lm.X = pt3d.xyz_;
+                lm.color = pt3d.color_;
+                for (const auto &track : pt3d.track_) {
+                    auto imgIter = imgObs.find(track.image_id);
+                    // this frame is not involved in solving
+                    if (imgIter == imgObs.cend()) {
+                        continue;
+                    }
+                    const auto &[viewId, points2D] = imgIter->second;
+                    auto ptIter = std::lower_bound(
+                        points2D.cbegin(), points2D.cend(), track.point2D_idx,
+                        [](const auto &p, ColMapDataIO::point2D_t idx) { return p.first < idx; });
+                    if (ptIter == points2D.cend() || ptIter->first != track.point2D_idx) {
+                        spdlog::warn(
+                            "'point3D_id_' of point3D and 'point3D_id_' of feature connected are "
+                            "in conflict!!!");
+                        continue;
+                    }
+                    lm.obs.insert({viewId, ns_veta::Observation(ptIter->second, ptIter->first)});
+                }
+                if (lm.obs.size() >= trackLenThd) {
+                    veta->structure.insert({pt3dId, lm});
+                }
+            });
+        return veta;
     }
 
-    for (const auto &frame : _dataMagr->GetCameraMeasurements(topic)) {
-        if (veta->views.count(frame->GetId()) == 0) {
-            spdlog::warn(
-                "frame indexed as '{}' of camera '{}' is involved in solving but not reconstructed "
-                "in SfM!!!",
-                frame->GetId(), topic);
-        }
+    // load images
+    auto images = ColMapDataIO::ReadImagesText(imagesFilename);
+
+    // load landmarks
+    auto points3D = ColMapDataIO::ReadPoints3DText(ptsFilename);
+
+    for (const auto &[IdFromColmap, image] : images) {
+        AddView(image);
     }
+    CheckReconstructed();
 
     // from point3D to our structure
     for (const auto &[pt3dId, pt3d] : points3D) {
@@ -578,14 +780,32 @@ ns_veta::Veta::Ptr CalibSolver::TryLoadSfMData(const std::string &topic,
 void CalibSolver::PerformTransformForVeta(const ns_veta::Veta::Ptr &veta,
                                           const ns_veta::Posed &curToNew,
                                           double scale) {
-    // pose
+    // poses and landmarks are flattened, and transformed in parallel
+    std::vector<ns_veta::Posed *> poses;
+    poses.reserve(veta->poses.size());
     for (auto &[id, pose] : veta->poses) {
+        poses.push_back(&pose);
+    }
+    std::vector<ns_veta::Landmark *> landmarks;
+    landmarks.reserve(veta->structure.size());
+    for (auto &[id, lm] : veta->structure) {
+        landmarks.push_back(&lm);
+    }
+
+    // pose
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(poses, curToNew, scale)
+    for (int i = 0; i < static_cast<int>(poses.size()); ++i) {
+        auto &pose = *poses.at(i);
         pose.Translation() *= scale;
         pose = curToNew * pose;
     }
 
     // structure
-    for (auto &[id, lm] : veta->structure) {
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(landmarks, curToNew, scale)
+    for (int i = 0; i < static_cast<int>(landmarks.size()); ++i) {
+        auto &lm = *landmarks.at(i);
         lm.X *= scale;
         lm.X = curToNew(lm.X);
     }
@@ -609,35 +829,147 @@ bool CalibSolver::IsRSCamera(const std::string &topic) {
 void CalibSolver::DownsampleVeta(const ns_veta::Veta::Ptr &veta,
                                  std::size_t lmNumThd,
                                  std::size_t obvNumThd) {
-    std::default_random_engine engine(std::chrono::system_clock::now().time_since_epoch().count());
+    /**
+     * landmarks and observations are flattened to vectors of their iterators, sampled ones are
+     * erased by iterators (rather than by ids). Observations are sampled using counter-based
+     * streams keyed by landmark ids, thus landmarks are filtered in parallel reproducibly
+     */
     if (veta->structure.size() > lmNumThd) {
-        std::vector<ns_veta::IndexT> lmIdVec;
-        lmIdVec.reserve(veta->structure.size());
-        for (const auto &[lmId, lm] : veta->structure) {
-            lmIdVec.push_back(lmId);
+        std::vector<decltype(veta->structure.begin())> lmIters;
+        lmIters.reserve(veta->structure.size());
+        for (auto iter = veta->structure.begin(); iter != veta->structure.end(); ++iter) {
+            lmIters.push_back(iter);
         }
-        auto lmIdVecToMove =
-            SamplingWoutReplace2(engine, lmIdVec, veta->structure.size() - lmNumThd);
-        for (const auto &id : lmIdVecToMove) {
-            veta->structure.erase(id);
+        // the stream of landmarks, which is not the id of any landmark
+        constexpr auto LM_STREAM = std::numeric_limits<std::uint64_t>::max();
+        const auto lmIdxToMove = SamplingWoutReplace(Configor::Preference::SamplingSeed, LM_STREAM,
+                                                     lmIters.size(), lmIters.size() - lmNumThd);
+        for (const auto &idx : lmIdxToMove) {
+            veta->structure.erase(lmIters.at(idx));
         }
     }
+
+    std::vector<std::pair<ns_veta::IndexT, ns_veta::Landmark *>> landmarks;
     for (auto &[lmId, lm] : veta->structure) {
-        if (lm.obs.size() < obvNumThd) {
-            continue;
+        if (lm.obs.size() > obvNumThd) {
+            landmarks.emplace_back(lmId, &lm);
         }
-
-        std::vector<ns_veta::IndexT> obvIdVec;
-        obvIdVec.reserve(lm.obs.size());
-        for (const auto &[viewId, obv] : lm.obs) {
-            obvIdVec.push_back(viewId);
+    }
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(landmarks, obvNumThd)
+    for (int i = 0; i < static_cast<int>(landmarks.size()); ++i) {
+        auto &obs = landmarks.at(i).second->obs;
+        std::vector<decltype(obs.begin())> obvIters;
+        obvIters.reserve(obs.size());
+        for (auto iter = obs.begin(); iter != obs.end(); ++iter) {
+            obvIters.push_back(iter);
         }
+        const auto obvIdxToMove =
+            SamplingWoutReplace(Configor::Preference::SamplingSeed, landmarks.at(i).first,
+                                obvIters.size(), obvIters.size() - obvNumThd);
+        for (const auto &idx : obvIdxToMove) {
+            obs.erase(obvIters.at(idx));
+        }
+    }
+}
 
-        auto obvIdVecToMove = SamplingWoutReplace2(engine, obvIdVec, lm.obs.size() - obvNumThd);
-        for (const auto &id : obvIdVecToMove) {
-            lm.obs.erase(id);
+std::vector<VisualReProjCorrSeq::Ptr> CalibSolver::SelectVisualReProjCorrs(
+    const std::vector<VisualReProjCorrSeq::Ptr> &corrs, std::size_t budget) {
+    std::size_t totalCount = 0;
+    for (const auto &seq : corrs) {
+        totalCount += seq->corrs.size();
+    }
+    if (budget == 0 || totalCount <= budget) {
+        return corrs;
+    }
+    /**
+     * views are identified by their timestamps, and are traversed in time order. A view becomes a
+     * keyframe once the landmarks it shares with the last keyframe drop below a ratio
+     */
+    constexpr double KEYFRAME_COVISIBILITY = 0.7;
+    // timestamp of the view, indices of sequences observed in this view (in ascending order)
+    std::map<double, std::vector<int>> seqInView;
+    for (int i = 0; i < static_cast<int>(corrs.size()); ++i) {
+        for (const auto &c : corrs.at(i)->corrs) {
+            auto &seqs = seqInView[c->tj];
+            if (seqs.empty() || seqs.back() != i) {
+                seqs.push_back(i);
+            }
+        }
+    }
+    std::set<double> keyframes;
+    const std::vector<int> *seqInKeyframe = nullptr;
+    for (const auto &[time, seqs] : seqInView) {
+        if (seqInKeyframe != nullptr) {
+            std::vector<int> common;
+            std::set_intersection(seqs.cbegin(), seqs.cend(), seqInKeyframe->cbegin(),
+                                  seqInKeyframe->cend(), std::back_inserter(common));
+            if (static_cast<double>(common.size()) >=
+                KEYFRAME_COVISIBILITY * static_cast<double>(seqInKeyframe->size())) {
+                continue;
+            }
+        }
+        keyframes.insert(time);
+        seqInKeyframe = &seqs;
+    }
+    std::size_t keyframeCount = 0;
+    for (const auto &seq : corrs) {
+        for (const auto &c : seq->corrs) {
+            keyframeCount += keyframes.count(c->tj);
         }
     }
+    // the ratios of observations to keep in keyframes and in other views
+    const double keyframeRatio =
+        std::min(1.0, static_cast<double>(budget) / static_cast<double>(keyframeCount));
+    const double otherRatio =
+        keyframeCount >= budget ? 0.0
+                                : static_cast<double>(budget - keyframeCount) /
+                                      static_cast<double>(totalCount - keyframeCount);
+
+    // select indices evenly distributed in 'indices' with the ratio, the last one is preferred
+    auto EvenlySelect = [](const std::vector<int> &indices, double ratio, std::set<int> &selected) {
+        const int size = static_cast<int>(indices.size());
+        const int count = std::min(size, static_cast<int>(std::ceil(ratio * size)));
+        for (int j = 0; j < count; ++j) {
+            const int k = count == 1 ? size - 1 : j * (size - 1) / (count - 1);
+            selected.insert(indices.at(k));
+        }
+    };
+    std::vector<VisualReProjCorrSeq::Ptr> selectedCorrs;
+    selectedCorrs.reserve(corrs.size());
+    std::size_t selectedCount = 0;
+    for (const auto &seq : corrs) {
+        std::vector<int> inKeyframe, inOther;
+        for (int j = 0; j < static_cast<int>(seq->corrs.size()); ++j) {
+            (keyframes.count(seq->corrs.at(j)->tj) ? inKeyframe : inOther).push_back(j);
+        }
+        std::set<int> selected;
+        EvenlySelect(inKeyframe, keyframeRatio, selected);
+        EvenlySelect(inOther, otherRatio, selected);
+        if (selected.empty() && !seq->corrs.empty()) {
+            // the last observation has the longest baseline with the first one
+            selected.insert(static_cast<int>(seq->corrs.size()) - 1);
+        }
+        if (selected.empty()) {
+            continue;
+        }
+        auto selectedSeq = std::make_shared<VisualReProjCorrSeq>();
+        // the inverse depth is shared, thus the one in the input sequence is estimated
+        selectedSeq->invDepthFir = seq->invDepthFir;
+        selectedSeq->lmId = seq->lmId;
+        selectedSeq->firObvViewId = seq->firObvViewId;
+        selectedSeq->firObv = seq->firObv;
+        selectedSeq->corrs.reserve(selected.size());
+        for (int j : selected) {
+            selectedSeq->corrs.push_back(seq->corrs.at(j));
+        }
+        selectedCount += selected.size();
+        selectedCorrs.push_back(selectedSeq);
+    }
+    spdlog::info(
+        "visual reprojection factors are subsampled from '{}' to '{}' using '{}' keyframe(s)",
+        totalCount, selectedCount, keyframes.size());
+    return selectedCorrs;
 }
 
 void CalibSolver::SaveStageCalibParam(const CalibParamManager::Ptr &par, const std::string &desc) {
@@ -715,13 +1047,53 @@ ns_veta::Veta::Ptr CalibSolver::CreateVetaFromOpticalFlow(
 void CalibSolver::AddGyroFactor(Estimator::Ptr &estimator,
                                 const std::string &imuTopic,
                                 Estimator::Opt option) const {
+    AddGyroFactor(estimator, imuTopic, _dataMagr->GetIMUMeasurements(imuTopic), option);
+}
+
+void CalibSolver::AddGyroFactor(Estimator::Ptr &estimator,
+                                const std::string &imuTopic,
+                                const std::vector<IMUFrame::Ptr> &mes,
+                                Estimator::Opt option) {
     double weight = Configor::DataStream::IMUTopics.at(imuTopic).GyroWeight;
 
-    for (const auto &item : _dataMagr->GetIMUMeasurements(imuTopic)) {
+    if (Configor::Preference::BatchInertialFactors) {
+        estimator->AddIMUGyroMeasurements(mes, imuTopic, option, weight);
+        return;
+    }
+    for (const auto &item : mes) {
         estimator->AddIMUGyroMeasurement(item, imuTopic, option, weight);
     }
 }
 
+std::vector<IMUFrame::Ptr> CalibSolver::SelectInformativeGyroMes(
+    const std::vector<IMUFrame::Ptr> &mes, std::size_t budget) {
+    if (budget == 0 || mes.size() <= budget) {
+        return mes;
+    }
+    // the norms of angular accelerations, the first and last ones are not scored
+    std::vector<double> scores(mes.size(), -1.0);
+    for (std::size_t i = 1; i + 1 < mes.size(); ++i) {
+        const double dt = mes.at(i + 1)->GetTimestamp() - mes.at(i - 1)->GetTimestamp();
+        if (dt > 0.0) {
+            scores.at(i) = (mes.at(i + 1)->GetGyro() - mes.at(i - 1)->GetGyro()).norm() / dt;
+        }
+    }
+    std::vector<std::size_t> indices(mes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::nth_element(indices.begin(), indices.begin() + static_cast<long>(budget) - 1,
+                     indices.end(),
+                     [&scores](std::size_t i, std::size_t j) { return scores[i] > scores[j]; });
+    indices.resize(budget);
+    std::sort(indices.begin(), indices.end());
+
+    std::vector<IMUFrame::Ptr> selected;
+    selected.reserve(budget);
+    for (const auto &idx : indices) {
+        selected.push_back(mes.at(idx));
+    }
+    return selected;
+}
+
 std::vector<Eigen::Vector2d> CalibSolver::FindTexturePoints(const cv::Mat &eventFrame, int num) {
     cv::Mat imgFiltered;
     cv::medianBlur(eventFrame, imgFiltered, 5);
@@ -762,7 +1134,7 @@ std::vector<Eigen::Vector2d> CalibSolver::FindTexturePointsAt(
     while (true) {
         bool updated = false;
         if (std::distance(data.cbegin(), fIter) > 0) {
-            accumulatedEventNum += (*fIter)->GetEvents().size();
+            accumulatedEventNum += (*fIter)->GetEventCount();
             if (accumulatedEventNum > eventNumThd) {
                 break;
             } else {
@@ -772,7 +1144,7 @@ std::vector<Eigen::Vector2d> CalibSolver::FindTexturePointsAt(
         }
 
         if (std::distance(bIter, data.cend()) > 0) {
-            accumulatedEventNum += (*bIter)->GetEvents().size();
+            accumulatedEventNum += (*bIter)->GetEventCount();
             if (accumulatedEventNum > eventNumThd) {
                 break;
             } else {
@@ -784,8 +1156,9 @@ std::vector<Eigen::Vector2d> CalibSolver::FindTexturePointsAt(
             break;
         }
     }
-    auto mat = EventArray::DrawRawEventFrame(fIter, bIter, intri);
-    auto vertex = FindTexturePoints(EventArray::DrawRawEventFrame(fIter, bIter, intri), featNum);
+    // events are binned once (on OpenCL devices if enabled), the frame is drawn from the raster
+    auto mat = EventRasterizer::Create(intri)->Rasterize(EventArraySpan(fIter, bIter)).EventFrame();
+    auto vertex = FindTexturePoints(mat, featNum);
     for (const auto &v : vertex) {
         DrawKeypointOnCVMat(mat, v, true, cv::Scalar(0, 0, 0));
     }
@@ -815,115 +1188,146 @@ void CalibSolver::SaveEventDataForFeatureTracking(const std::string &topic,
                                                   std::size_t seedNum) const {
     const auto &intri = _parMagr->INTRI.Camera.at(topic);
     const auto &eventMes = _dataMagr->GetEventMeasurements(topic);
-    auto saeCreator = ActiveEventSurface::Create(intri, 0.01);
-
-    std::stringstream commands;
-    // the index of sub batch in event data
-    int subEventDataIdx = 0;
-    std::vector<EventsInfo::SubBatch> subBatches;
-
+    using EventIter = std::vector<EventArray::Ptr>::const_iterator;
+
+    /**
+     *                          |<- BATCH_TIME_WIN_THD ->|
+     * ------------------------------------------------------------------
+     * |<- BATCH_TIME_WIN_THD ->|                        |<- BATCH_TIME_WIN_THD ->|
+     *  data in windown would be output for event-based feature tracking
+     * windows are only determined by timestamps, thus they are split sequentially here, and then
+     * processed in parallel
+     */
+    // the head, the seed, and the tail iterators of batches
+    std::vector<std::tuple<EventIter, EventIter, EventIter>> batchIters;
     auto headIter = eventMes.cbegin();
     for (auto tailIter = eventMes.cbegin(); tailIter != eventMes.cend(); ++tailIter) {
-        /**
-         *                          |<- BATCH_TIME_WIN_THD ->|
-         * ------------------------------------------------------------------
-         * |<- BATCH_TIME_WIN_THD ->|                        |<- BATCH_TIME_WIN_THD ->|
-         *  data in windown would be output for event-based feature tracking
-         */
         if ((*tailIter)->GetTimestamp() - (*headIter)->GetTimestamp() < BATCH_TIME_WIN_THD) {
             continue;
         }
-
-        // information for seed
-        decltype(tailIter) seedIter;
-        cv::Mat tsMatSeedTime;
-        // treated as reset of 'accumEventMat'
-        cv::Mat accumEventMat = saeCreator->GetEventImgMat(true, false);
-        bool findSeed = false;
-        std::size_t accumulatedEventNum = 0;
-        for (auto iter = headIter; iter != tailIter; ++iter) {
-            saeCreator->GrabEvent(*iter, true);
-            accumulatedEventNum += (*iter)->GetEvents().size();
-            /**
-             *        |--> event data to be accumulated to locate seed positions
-             * ----|-------------------|----
-             *     |<--batch windown-->|
-             *        |--> the seed time
-             */
-            if (!findSeed && (*iter)->GetTimestamp() - (*headIter)->GetTimestamp() > 0.01) {
-                // assign
-                seedIter = iter;
-                findSeed = true;
-                // create time surface
-                tsMatSeedTime = saeCreator->TimeSurface(true,   // ignore polarity
-                                                        false,  // undisto event frame mat
-                                                        0,      // perform medianBlur
-                                                        0.02);  // the constant decay rate
-                accumEventMat = saeCreator->GetEventImgMat(true, false);
-            }
+        /**
+         *        |--> event data to be accumulated to locate seed positions
+         * ----|-------------------|----
+         *     |<--batch windown-->|
+         *        |--> the seed time
+         */
+        auto seedIter = std::find_if(headIter, tailIter, [&headIter](const EventArray::Ptr &ary) {
+            return ary->GetTimestamp() - (*headIter)->GetTimestamp() > 0.01;
+        });
+        if (seedIter != tailIter) {
+            batchIters.emplace_back(headIter, seedIter, tailIter);
         }
+        // update
+        headIter = tailIter;
+    }
 
-        if (!findSeed) {
-            // update
-            headIter = tailIter;
-            continue;
-        }
+    /**
+     * each batch owns its active event surface, which is warmed up on a short lead-in window
+     * before the batch, so that pixels activated just before the batch are kept in the time
+     * surface as in the sequential case (the time surface decays with a constant rate of 0.02 s)
+     */
+    constexpr double LEAD_IN_TIME = 0.1;
+    const int batchCount = static_cast<int>(batchIters.size());
+    std::vector<std::string> commands(batchCount);
+    std::vector<EventsInfo::SubBatch> subBatches(batchCount);
+    // the highgui windows are not thread-safe, mats are displayed after the parallel region
+    std::vector<cv::Mat> visMats(batchCount);
+    std::vector<std::exception_ptr> exceptions(batchCount, nullptr);
+
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(batchCount, batchIters, eventMes, intri, seedNum, ws, topic, commands, \
+                             subBatches, visMats, exceptions, LEAD_IN_TIME)
+    for (int subEventDataIdx = 0; subEventDataIdx < batchCount; ++subEventDataIdx) {
+        try {
+            const auto &[batchHeadIter, seedIter, tailIter] = batchIters.at(subEventDataIdx);
+            auto saeCreator = ActiveEventSurface::Create(intri, 0.01);
+
+            const auto &headAry = *batchHeadIter;
+            const double headTime =
+                headAry->IsEmpty() ? headAry->GetTimestamp() : headAry->GetEventTime(0);
+            saeCreator->GrabEvent(EventArraySpan::Extract(eventMes, headTime - LEAD_IN_TIME,
+                                                          headTime),
+                                  true);
+
+            // information for seed
+            cv::Mat tsMatSeedTime;
+            // treated as reset of 'accumEventMat'
+            cv::Mat accumEventMat = saeCreator->GetEventImgMat(true, false);
+            for (auto iter = batchHeadIter; iter != tailIter; ++iter) {
+                saeCreator->GrabEvent(*iter, true);
+                if (iter == seedIter) {
+                    // create time surface
+                    tsMatSeedTime = saeCreator->TimeSurface(true,   // ignore polarity
+                                                            false,  // undisto event frame mat
+                                                            0,      // perform medianBlur
+                                                            0.02);  // the constant decay rate
+                    accumEventMat = saeCreator->GetEventImgMat(true, false);
+                }
+            }
 
-        // find seeds (todo: refine)
-        std::vector<cv::Point2f> ptsCurVec;
-        cv::goodFeaturesToTrack(tsMatSeedTime, ptsCurVec, seedNum, 0.01, 10);
-
-        cv::cvtColor(tsMatSeedTime, tsMatSeedTime, cv::COLOR_GRAY2BGR);
-        std::vector<Eigen::Vector2d> seeds;
-        seeds.reserve(ptsCurVec.size());
-        for (const auto &pt : ptsCurVec) {
-            DrawKeypointOnCVMat(tsMatSeedTime, pt, true);
-            DrawKeypointOnCVMat(accumEventMat, pt, true);
-            seeds.push_back({pt.x, pt.y});
-        }
+            // find seeds (todo: refine)
+            std::vector<cv::Point2f> ptsCurVec;
+            cv::goodFeaturesToTrack(tsMatSeedTime, ptsCurVec, static_cast<int>(seedNum), 0.01,
+                                    10);
+
+            cv::cvtColor(tsMatSeedTime, tsMatSeedTime, cv::COLOR_GRAY2BGR);
+            std::vector<Eigen::Vector2d> seeds;
+            seeds.reserve(ptsCurVec.size());
+            for (const auto &pt : ptsCurVec) {
+                DrawKeypointOnCVMat(tsMatSeedTime, pt, true);
+                DrawKeypointOnCVMat(accumEventMat, pt, true);
+                seeds.push_back({pt.x, pt.y});
+            }
 
-        // the directory to save sub event data
-        const std::string subWS = ws + "/" + std::to_string(subEventDataIdx);
-        if (!std::filesystem::exists(subWS)) {
-            if (!std::filesystem::create_directories(subWS)) {
-                throw Status(Status::CRITICAL,
-                             "can not create sub output directory '{}' for event "
-                             "camera '{}' sub event data sequence '{}'!!!",
-                             subWS, topic, subEventDataIdx);
+            // the directory to save sub event data
+            const std::string subWS = ws + "/" + std::to_string(subEventDataIdx);
+            if (!std::filesystem::exists(subWS)) {
+                if (!std::filesystem::create_directories(subWS)) {
+                    throw Status(Status::CRITICAL,
+                                 "can not create sub output directory '{}' for event "
+                                 "camera '{}' sub event data sequence '{}'!!!",
+                                 subWS, topic, subEventDataIdx);
+                }
             }
+            double seedTime = (*seedIter)->GetEventTime((*seedIter)->GetEventCount() - 1);
+            auto [c, i] = HASTEDataIO::SaveRawEventDataAsBinary(batchHeadIter,  // from
+                                                                tailIter,       // to
+                                                                intri,          // intrinsics
+                                                                seeds,     // seed positions
+                                                                seedTime,  // seed timestamps
+                                                                subWS,     // directory
+                                                                subEventDataIdx);
+
+            // record information
+            commands.at(subEventDataIdx) = c;
+            subBatches.at(subEventDataIdx) = i;
+
+            cv::hconcat(tsMatSeedTime, accumEventMat, visMats.at(subEventDataIdx));
+        } catch (...) {
+            exceptions.at(subEventDataIdx) = std::current_exception();
+        }
+    }
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
         }
-        double seedTime = (*seedIter)->GetEvents().back()->GetTimestamp();
-        auto [c, i] = HASTEDataIO::SaveRawEventDataAsBinary(headIter,  // from
-                                                            tailIter,  // to
-                                                            intri,     // intrinsics
-                                                            seeds,     // seed positions
-                                                            seedTime,  // seed timestamps
-                                                            subWS,     // directory
-                                                            subEventDataIdx);
-
-        // record information
-        commands << '\"' << c << "\"\n";
-        subBatches.emplace_back(i);
-
-        // plus index of sub data batch
-        ++subEventDataIdx;
-
-        cv::Mat m;
-        cv::hconcat(tsMatSeedTime, accumEventMat, m);
+    }
+
+    for (const auto &m : visMats) {
         cv::imshow("Normalized Time Surface & Accumulated Event Mat", m);
         cv::waitKey(0);
-
-        // update
-        headIter = tailIter;
     }
 
     // the command shell file
     const std::string cmdOutputPath = ws + "/run_haste.sh";
     std::ofstream ofCmdShell(cmdOutputPath, std::ios::out);
     ofCmdShell << "#!/bin/bash\n"
-                  "commands=(\n"
-               << commands.str()
-               << ")\n"
+                  "commands=(\n";
+    for (const auto &c : commands) {
+        ofCmdShell << '\"' << c << "\"\n";
+    }
+    ofCmdShell << ")\n"
                   "max_parallel=8\n"
                   "echo \"Maximum Parallel Tasks Set To: $max_parallel\"\n"
                   "total_commands=${#commands[@]}\n"
@@ -983,13 +1387,13 @@ void CalibSolver::SaveEventDataForFeatureTracking(const std::string &topic,
         int subEventDataIdx = 0;
 
         // for visualization
-        std::shared_ptr<tqdm> bar = std::make_shared<tqdm>();
+        auto bar = ProgressStage::Create(fmt::format("event batches '{}'", topic));
         auto totalSubBatchCount =
             (eventMes.back()->GetTimestamp() - eventMes.front()->GetTimestamp()) /
             BATCH_TIME_WIN_THD * 2;
 
         for (auto curIter = matSIter; curIter != eventMes.cend(); ++curIter) {
-            accumulatedEventCount += (*curIter)->GetEvents().size();
+            accumulatedEventCount += (*curIter)->GetEventCount();
             if (accumulatedEventCount > EVENT_FRAME_NUM_THD) {
                 /**
                  * If the number of events accumulates to a certain number, we construct it into an
@@ -1010,7 +1414,7 @@ void CalibSolver::SaveEventDataForFeatureTracking(const std::string &topic,
             if ((*curIter)->GetTimestamp() - (*tailIter)->GetTimestamp() >
                 BATCH_TIME_WIN_THD_HALF) {
                 if ((*curIter)->GetTimestamp() - (*headIter)->GetTimestamp() > BATCH_TIME_WIN_THD) {
-                    bar->progress(subEventDataIdx, static_cast<int>(totalSubBatchCount));
+                    bar->Progress(subEventDataIdx, static_cast<int>(totalSubBatchCount));
 
                     // the directory to save sub event data
                     const std::string subWS = ws + "/" + std::to_string(subEventDataIdx);
@@ -1069,8 +1473,8 @@ void CalibSolver::SaveEventDataForFeatureTracking(const std::string &topic,
             }
         }
 
-        bar->progress(subEventDataIdx, subEventDataIdx);
-        bar->finish();
+        bar->Progress(subEventDataIdx, subEventDataIdx);
+        bar->Finish();
 
         // the command shell file
         const std::string cmdOutputPath = ws + "/run_haste.sh";
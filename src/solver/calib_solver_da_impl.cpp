@@ -34,19 +34,26 @@
 
 #include "calib/calib_data_manager.h"
 #include "calib/calib_param_manager.h"
+#include "calib/pose_query_cursor.h"
 #include "core/optical_flow_trace.h"
 #include "core/pts_association.h"
 #include "core/scan_undistortion.h"
 #include "core/visual_reproj_association.h"
+#include "core/veta_landmark_pruner.h"
+#include "core/voxel_map_accumulator.h"
 #include "factor/data_correspondence.h"
 #include "pcl/common/transforms.h"
-#include "pcl/filters/random_sample.h"
 #include "pcl/filters/voxel_grid.h"
+#include "sensor/rgbd.h"
 #include "solver/calib_solver.h"
 #include "spdlog/spdlog.h"
 #include "util/cloud_define.hpp"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "viewer/viewer.h"
+#include "unordered_map"
+#include "atomic"
+#include "omp.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -54,8 +61,34 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+/**
+ * sample at most 'numEachNode' correspondences of each surfel without replacement. Surfels are
+ * sampled in parallel, each from its own counter-based stream (the surfel index) under the key
+ * 'seed', thus the result is reproducible and independent of the thread count
+ */
+static std::vector<std::size_t> SampleEachSurfel(
+    const std::vector<std::pair<std::uint32_t, std::vector<std::size_t>>> &surfels,
+    std::size_t numEachNode,
+    std::uint64_t seed) {
+    const int surfelCount = static_cast<int>(surfels.size());
+    std::vector<std::vector<std::size_t>> sampled(surfelCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) \
+    schedule(dynamic, 64) default(none) shared(surfelCount, surfels, numEachNode, seed, sampled)
+    for (int i = 0; i < surfelCount; ++i) {
+        const auto &[surfelIdx, corrIndices] = surfels.at(i);
+        sampled.at(i) = SamplingWoutReplace2(seed, surfelIdx, corrIndices,
+                                             std::min(corrIndices.size(), numEachNode));
+    }
+    // merge in the order of surfels
+    std::vector<std::size_t> indices;
+    for (const auto &item : sampled) {
+        indices.insert(indices.end(), item.cbegin(), item.cend());
+    }
+    return indices;
+}
+
 std::tuple<IKalibrPointCloud::Ptr, std::map<std::string, std::vector<LiDARFrame::Ptr>>>
-CalibSolver::BuildGlobalMapOfLiDAR() const {
+CalibSolver::BuildGlobalMapOfLiDAR(bool keepDense) const {
     if (!Configor::IsLiDARIntegrated()) {
         return {};
     }
@@ -67,19 +100,39 @@ CalibSolver::BuildGlobalMapOfLiDAR() const {
 
     std::map<std::string, std::vector<LiDARFrame::Ptr>> undistFrames;
     IKalibrPointCloud::Ptr mapCloud(new IKalibrPointCloud);
+    /**
+     * if the dense map is not required, scans are streamed into a voxel map in parallel, rather
+     * than being concatenated into a huge cloud
+     */
+    auto voxelMap = VoxelMapAccumulator::Create(Configor::Prior::MapDownSample);
     for (const auto &[topic, data] : _dataMagr->GetLiDARMeasurements()) {
         spdlog::info("undistort scans for lidar '{}'...", topic);
         undistFrames[topic] =
             undistHelper->UndistortToRef(data, topic, ScanUndistortion::Option::ALL);
 
         spdlog::info("marge scans from lidar '{}' to map...", topic);
-        for (auto &frame : undistFrames.at(topic)) {
-            if (frame == nullptr) {
-                continue;
+        const auto &frames = undistFrames.at(topic);
+        if (keepDense) {
+            for (auto &frame : frames) {
+                if (frame == nullptr) {
+                    continue;
+                }
+                *mapCloud += *frame->GetScan();
+            }
+        } else {
+            const int frameCount = static_cast<int>(frames.size());
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(frameCount, frames, voxelMap)
+            for (int i = 0; i < frameCount; ++i) {
+                if (frames.at(i) != nullptr) {
+                    voxelMap->Insert(frames.at(i)->GetScan());
+                }
             }
-            *mapCloud += *frame->GetScan();
         }
     }
+    if (!keepDense) {
+        return {voxelMap->GetCloud(), undistFrames};
+    }
 
     IKalibrPointCloud::Ptr newMapCloud(new IKalibrPointCloud);
     std::vector<int> index;
@@ -98,16 +151,24 @@ IKalibrPointCloud::Ptr CalibSolver::BuildGlobalMapOfRadar() const {
     for (const auto &[topic, data] : _dataMagr->GetRadarMeasurements()) {
         const double TO_RjToBr = _parMagr->TEMPORAL.TO_RjToBr.at(topic);
         IKalibrPointCloud::Ptr curRadarCloud(new IKalibrPointCloud);
-        curRadarCloud->reserve(data.size() * data.front()->GetTargets().size());
+        // arrays are in time order, thus the cursor reuses the control points of queried segments
+        auto cursor = RjToWCursor(topic);
+        std::optional<Sophus::SE3d> SE3_CurRjToW;
+        curRadarCloud->reserve(data.size() * data.front()->GetTargetSoA().Size());
         for (const auto &ary : data) {
-            for (const auto &frame : ary->GetTargets()) {
-                auto SE3_CurRjToW = CurRjToW(frame->GetTimestamp(), topic);
+            const auto &soa = ary->GetTargetSoA();
+            for (Eigen::Index i = 0; i < soa.Size(); ++i) {
+                const double t = soa.timestamps(i);
+                // targets of an array usually share the same timestamp, so does the pose
+                if (i == 0 || t != soa.timestamps(i - 1)) {
+                    SE3_CurRjToW = cursor.Query(t);
+                }
                 if (SE3_CurRjToW == std::nullopt) {
                     continue;
                 }
-                Eigen::Vector3d p = *SE3_CurRjToW * frame->GetTargetXYZ();
+                Eigen::Vector3d p = *SE3_CurRjToW * soa.GetTargetXYZ(i);
                 IKalibrPoint p2;
-                p2.timestamp = frame->GetTimestamp() + TO_RjToBr;
+                p2.timestamp = t + TO_RjToBr;
                 p2.x = static_cast<float>(p(0));
                 p2.y = static_cast<float>(p(1));
                 p2.z = static_cast<float>(p(2));
@@ -126,7 +187,10 @@ IKalibrPointCloud::Ptr CalibSolver::BuildGlobalMapOfRadar() const {
     filter.setLeafSize(size, size, size);
 
     IKalibrPointCloud::Ptr radarCloudSampled(new IKalibrPointCloud);
-    filter.filter(*radarCloudSampled);
+    // the down-sampled cloud is only for the viewer
+    if (!_viewer->IsHeadless()) {
+        filter.filter(*radarCloudSampled);
+    }
     _viewer->AddStarMarkCloud(radarCloudSampled, Viewer::VIEW_MAP);
 
     return radarCloud;
@@ -141,43 +205,59 @@ ColorPointCloud::Ptr CalibSolver::BuildGlobalColorMapOfRGBD(const std::string &t
 
     auto intri = _parMagr->INTRI.RGBD.at(topic);
 
-    ColorPointCloud::Ptr map(new ColorPointCloud);
-
-    auto bar = std::make_shared<tqdm>();
     const auto &frames = _dataMagr->GetRGBDMeasurements(topic);
-    for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
-        bar->progress(i, static_cast<int>(frames.size()));
+    const int frameCount = static_cast<int>(frames.size());
+    // rays of pixels are shared by all frames of this rgbd camera
+    RGBDRayLUT::Ptr lut = nullptr;
+    for (const auto &frame : frames) {
+        const auto &depthImg = frame->GetDepthImage();
+        if (!depthImg.empty()) {
+            lut = RGBDRayLUT::Create(intri, depthImg.cols, depthImg.rows);
+            break;
+        }
+    }
+
+    // poses of frames (in time order) are queried in batch
+    std::vector<double> frameTimes(frameCount);
+    for (int i = 0; i < frameCount; ++i) {
+        frameTimes.at(i) = frames.at(i)->GetTimestamp();
+    }
+    const auto poses = DnToWCursor(topic).QueryBatch(frameTimes);
+
+    // frames are back-projected in parallel, and then merged in order
+    std::vector<ColorPointCloud::Ptr> clouds(frameCount);
+    auto bar = ProgressStage::Create(fmt::format("back-project '{}'", topic), frameCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(frameCount, frames, poses, intri, lut, clouds, bar)
+    for (int i = 0; i < frameCount; ++i) {
         const auto &frame = frames.at(i);
+        bar->Step();
 
         // transformation
-        auto SE3_CurDnToW = CurDnToW(frame->GetTimestamp(), topic);
+        const auto &SE3_CurDnToW = poses.at(i);
         if (SE3_CurDnToW == std::nullopt) {
             continue;
         }
 
-        // save points to 'cloud'
-        ColorPointCloud::Ptr cloud = frame->CreatePointCloud(intri, 0.1f, 8.0f);
+        // only sampled pixels are back-projected, the dense cloud is not created
+        ColorPointCloud::Ptr cloud = frame->CreatePointCloud(intri, 0.1f, 8.0f, 10000, lut);
         if (cloud == nullptr) {
             continue;
         }
 
-        // down sample the map cloud
-        ColorPointCloud::Ptr cloudDownSampled(new ColorPointCloud);
-
-        pcl::RandomSample<ColorPoint> filter;
-        filter.setInputCloud(cloud);
-        filter.setSample(1E4);
-        filter.filter(*cloudDownSampled);
-
         // transform cloud to map coordinate frame
         ColorPointCloud::Ptr cloudTransformed(new ColorPointCloud);
-        pcl::transformPointCloud(*cloudDownSampled, *cloudTransformed,
-                                 SE3_CurDnToW->matrix().cast<float>());
-
-        *map += *cloudTransformed;
+        pcl::transformPointCloud(*cloud, *cloudTransformed, SE3_CurDnToW->matrix().cast<float>());
+        clouds.at(i) = cloudTransformed;
     }
-    bar->finish();
+    bar->Finish();
 
+    ColorPointCloud::Ptr map(new ColorPointCloud);
+    for (const auto &cloud : clouds) {
+        if (cloud != nullptr) {
+            *map += *cloud;
+        }
+    }
     return map;
 }
 
@@ -186,13 +266,25 @@ std::tuple<IKalibrPointCloud::Ptr,
            std::map<std::string, std::vector<IKalibrPointCloud::Ptr>>,
            // scans in local frame
            std::map<std::string, std::vector<IKalibrPointCloud::Ptr>>>
-CalibSolver::BuildGlobalMapOfRGBD() const {
+CalibSolver::BuildGlobalMapOfRGBD(bool keepDense) const {
     if (!Configor::IsRGBDIntegrated() || GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         return {};
     }
     IKalibrPointCloud::Ptr globalMap(new IKalibrPointCloud);
     std::map<std::string, std::vector<IKalibrPointCloud::Ptr>> scanInGFrame;
     std::map<std::string, std::vector<IKalibrPointCloud::Ptr>> scanInLFrame;
+    /**
+     * if the dense map is not required, scans are streamed into a voxel map in parallel, rather
+     * than being concatenated into a huge cloud
+     */
+    auto voxelMap = VoxelMapAccumulator::Create(Configor::Prior::MapDownSample);
+    /**
+     * scans returned for data association are sparsified in the image before back-projection,
+     * only edge-free and planar pixels (oversampled) are kept, see 'CreateSparsePointCloud'
+     */
+    const int candidateCount =
+        static_cast<int>(std::ceil(Configor::Prior::LiDARDataAssociate::PointToSurfelCountInScan *
+                                   Configor::Prior::LiDARDataAssociate::CandidateOversampling));
 
     for (const auto &[topic, _] : Configor::DataStream::RGBDTopics) {
         spdlog::info("build global map for rgbd '{}'...", topic);
@@ -204,58 +296,98 @@ CalibSolver::BuildGlobalMapOfRGBD() const {
         const double readout = _parMagr->TEMPORAL.RS_READOUT.at(topic);
 
         const auto &frames = _dataMagr->GetRGBDMeasurements(topic);
-        IKalibrPointCloud::Ptr map(new IKalibrPointCloud);
-        auto &curScanInGFrame = scanInGFrame[topic];
-        curScanInGFrame.reserve(frames.size());
-        auto &curScanInLFrame = scanInLFrame[topic];
-        curScanInLFrame.reserve(frames.size());
+        const int frameCount = static_cast<int>(frames.size());
+        // rays of pixels are shared by all frames of this rgbd camera
+        RGBDRayLUT::Ptr lut = nullptr;
+        for (const auto &frame : frames) {
+            const auto &depthImg = frame->GetDepthImage();
+            if (!depthImg.empty()) {
+                lut = RGBDRayLUT::Create(intri, depthImg.cols, depthImg.rows);
+                break;
+            }
+        }
 
-        auto bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
-            bar->progress(i, static_cast<int>(frames.size()));
+        // poses of frames (in time order) are queried in batch
+        std::vector<double> frameTimes(frameCount);
+        for (int i = 0; i < frameCount; ++i) {
+            frameTimes.at(i) = frames.at(i)->GetTimestamp();
+        }
+        const auto poses = DnToWCursor(topic).QueryBatch(frameTimes);
+
+        // frames are back-projected in parallel, and then organized in order
+        std::vector<IKalibrPointCloud::Ptr> cloudsInL(frameCount), cloudsInG(frameCount);
+        std::vector<IKalibrPointCloud::Ptr> mapClouds(keepDense ? frameCount : 0);
+        auto bar = ProgressStage::Create(fmt::format("back-project '{}'", topic), frameCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(frameCount, frames, poses, intri, rsExpFactor, readout, lut, cloudsInL, \
+                             cloudsInG, mapClouds, bar, keepDense, voxelMap, candidateCount)
+        for (int i = 0; i < frameCount; ++i) {
             const auto &frame = frames.at(i);
+            bar->Step();
 
             // transformation
-            auto SE3_CurDnToW = CurDnToW(frame->GetTimestamp(), topic);
+            const auto &SE3_CurDnToW = poses.at(i);
             if (SE3_CurDnToW == std::nullopt) {
                 continue;
             }
 
-            // save points to 'cloud'
+            // only sampled pixels are back-projected, the dense cloud is not created
             IKalibrPointCloud::Ptr cloud =
-                frame->CreatePointCloud(rsExpFactor, readout, intri, 0.1f, 8.0f);
+                frame->CreatePointCloud(rsExpFactor, readout, intri, 0.1f, 8.0f, 10000, lut);
             if (cloud == nullptr) {
                 continue;
             }
 
-            // down sample the map cloud
-            IKalibrPointCloud::Ptr cloudDownSampled(new IKalibrPointCloud);
-
-            pcl::RandomSample<IKalibrPoint> filter;
-            filter.setInputCloud(cloud);
-            filter.setSample(1E4);
-            filter.filter(*cloudDownSampled);
-
             // transform cloud to map coordinate frame
+            const Eigen::Matrix4f SE3_CurDnToWMat = SE3_CurDnToW->matrix().cast<float>();
             IKalibrPointCloud::Ptr cloudTransformed(new IKalibrPointCloud);
-            pcl::transformPointCloud(*cloudDownSampled, *cloudTransformed,
-                                     SE3_CurDnToW->matrix().cast<float>());
+            pcl::transformPointCloud(*cloud, *cloudTransformed, SE3_CurDnToWMat);
+            if (keepDense) {
+                mapClouds.at(i) = cloudTransformed;
+            } else {
+                voxelMap->Insert(cloudTransformed);
+            }
+
+            // the sparse scan for data association
+            IKalibrPointCloud::Ptr scan =
+                frame->CreateSparsePointCloud(rsExpFactor, readout, intri, candidateCount, 0.1f,
+                                              8.0f, lut);
+            IKalibrPointCloud::Ptr scanTransformed(new IKalibrPointCloud);
+            pcl::transformPointCloud(*scan, *scanTransformed, SE3_CurDnToWMat);
 
-            curScanInLFrame.push_back(cloudDownSampled);
-            curScanInGFrame.push_back(cloudTransformed);
-            *map += *cloudTransformed;
+            cloudsInL.at(i) = scan;
+            cloudsInG.at(i) = scanTransformed;
+        }
+        bar->Finish();
+
+        auto &curScanInGFrame = scanInGFrame[topic];
+        curScanInGFrame.reserve(frames.size());
+        auto &curScanInLFrame = scanInLFrame[topic];
+        curScanInLFrame.reserve(frames.size());
+        for (int i = 0; i < frameCount; ++i) {
+            if (cloudsInG.at(i) == nullptr) {
+                continue;
+            }
+            curScanInLFrame.push_back(cloudsInL.at(i));
+            curScanInGFrame.push_back(cloudsInG.at(i));
+            if (keepDense) {
+                *globalMap += *mapClouds.at(i);
+            }
         }
-        bar->finish();
-        *globalMap += *map;
+    }
+    if (!keepDense) {
+        return {voxelMap->GetCloud(), scanInGFrame, scanInLFrame};
     }
 
     return {globalMap, scanInGFrame, scanInLFrame};
 }
 
-std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> CalibSolver::DataAssociationForLiDARs(
+std::map<std::string, PointToSurfelCorrBuffer::Ptr> CalibSolver::DataAssociationForLiDARs(
     const IKalibrPointCloud::Ptr &map,
     const std::map<std::string, std::vector<LiDARFrame::Ptr>> &undistFrames,
-    int ptsCountInEachScan) const {
+    int ptsCountInEachScan,
+    bool withMapPoints) const {
+    StageProfiler::Scope stageScope("DataAssociationForLiDARs");
     if (!Configor::IsLiDARIntegrated()) {
         return {};
     }
@@ -269,7 +401,10 @@ std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> CalibSolver::DataAsso
     filter.setLeafSize(size, size, size);
 
     IKalibrPointCloud::Ptr mapDownSampled(new IKalibrPointCloud);
-    filter.filter(*mapDownSampled);
+    // the down-sampled cloud is only for the viewer
+    if (!_viewer->IsHeadless()) {
+        filter.filter(*mapDownSampled);
+    }
 
     _viewer->AddAlignedCloud(mapDownSampled, Viewer::VIEW_MAP, -_parMagr->GRAVITY.cast<float>(),
                              2.0f);
@@ -277,10 +412,8 @@ std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> CalibSolver::DataAsso
     // ------------------------------------------------
     // Step 2: perform data association for each frames
     // ------------------------------------------------
-    auto associator = PointToSurfelAssociator::Create(
-        // we use the dense map to create data associator for high-perform point-to-surfel search
-        map, Configor::Prior::LiDARDataAssociate::MapResolution,
-        Configor::Prior::LiDARDataAssociate::MapDepthLevels);
+    // the surfel map is kept across batch optimizations, and updated incrementally
+    auto associator = UpdateSurfelMapOfLiDARs(undistFrames);
     auto condition = PointToSurfelCondition();
     _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION);
     _viewer->AddSurfelMap(associator->GetSurfelMap(), condition, Viewer::VIEW_ASSOCIATION);
@@ -290,52 +423,57 @@ std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> CalibSolver::DataAsso
     // deconstruction
     mapDownSampled.reset();
 
-    std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> pointToSurfel;
+    std::map<std::string, PointToSurfelCorrBuffer::Ptr> pointToSurfel;
+
+    /**
+     * most of the correspondences would be dropped by the downsampling after association, thus
+     * only a number of candidates (oversampled) of each scan are associated
+     */
+    const double oversampling = Configor::Prior::LiDARDataAssociate::CandidateOversampling;
+    const int candidateCount =
+        oversampling > 0.0 ? static_cast<int>(std::ceil(ptsCountInEachScan * oversampling)) : -1;
+    // points in the map frame are only kept for the viewer and the surfel map export
+    const bool withVisualization = withMapPoints || !_viewer->IsHeadless();
 
     std::size_t count = 0;
-    std::shared_ptr<tqdm> bar;
     for (const auto &[topic, framesInMap] : undistFrames) {
         const auto &rawFrames = _dataMagr->GetLiDARMeasurements(topic);
         spdlog::info("perform point to surfel association for lidar '{}'...", topic);
 
         // for each scan, we keep 'ptsCountInEachScan' point to surfel corrs
-        pointToSurfel[topic] = {};
+        pointToSurfel[topic] = PointToSurfelCorrBuffer::Create();
         auto &curPointToSurfel = pointToSurfel.at(topic);
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(framesInMap.size()); ++i) {
-            bar->progress(i, static_cast<int>(framesInMap.size()));
 
+        // scans are associated in parallel, frames failed to be undistorted are skipped
+        std::vector<IKalibrPointCloud::Ptr> mapScans(framesInMap.size(), nullptr);
+        std::vector<IKalibrPointCloud::Ptr> rawScans(framesInMap.size(), nullptr);
+        for (int i = 0; i < static_cast<int>(framesInMap.size()); ++i) {
             if (framesInMap.at(i) == nullptr || rawFrames.at(i) == nullptr) {
                 continue;
             }
-
-            auto ptsVec = associator->Association(framesInMap.at(i)->GetScan(),
-                                                  rawFrames.at(i)->GetScan(), condition);
-
-            curPointToSurfel.insert(curPointToSurfel.end(), ptsVec.cbegin(), ptsVec.cend());
+            mapScans.at(i) = framesInMap.at(i)->GetScan();
+            rawScans.at(i) = rawFrames.at(i)->GetScan();
+        }
+        // merge correspondences of scans in order
+        for (const auto &scanCorrs : associator->Association(mapScans, rawScans, condition,
+                                                             withVisualization, candidateCount)) {
+            curPointToSurfel->Append(*scanCorrs);
         }
-        bar->finish();
 
         // downsample
         int expectCount = ptsCountInEachScan * static_cast<int>(rawFrames.size());
-        if (static_cast<int>(curPointToSurfel.size()) > expectCount) {
-            std::map<ufo::map::Node, std::vector<PointToSurfelCorr::Ptr>> nodes;
-            for (const auto &corr : curPointToSurfel) {
-                nodes[corr->node].push_back(corr);
-            }
-            std::size_t numEachNode = expectCount / nodes.size() + 1;
-            curPointToSurfel.clear();
-
-            // uniform sampling
-            std::default_random_engine engine(
-                std::chrono::steady_clock::now().time_since_epoch().count());
-            for (const auto &[node, corrs] : nodes) {
-                auto newCorrs =
-                    SamplingWoutReplace2(engine, corrs, std::min(corrs.size(), numEachNode));
-                curPointToSurfel.insert(curPointToSurfel.end(), newCorrs.cbegin(), newCorrs.cend());
-            }
+        if (static_cast<int>(curPointToSurfel->Size()) > expectCount) {
+            // correspondences of the same surfel share an index in the surfel table
+            const auto surfels = curPointToSurfel->GroupBySurfel();
+            std::size_t numEachNode = expectCount / surfels.size() + 1;
+
+            // uniform sampling, each surfel is sampled from its own stream, thus in parallel
+            curPointToSurfel = curPointToSurfel->Select(
+                SampleEachSurfel(surfels, numEachNode,
+                                 Configor::Preference::SamplingSeed ^
+                                     std::hash<std::string>()(topic)));
         }
-        count += curPointToSurfel.size();
+        count += curPointToSurfel->Size();
     }
     spdlog::info("total point to surfel count for LiDARs: {}", count);
     _viewer->AddPointToSurfel(associator->GetSurfelMap(), pointToSurfel, Viewer::VIEW_ASSOCIATION);
@@ -343,11 +481,103 @@ std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> CalibSolver::DataAsso
     return pointToSurfel;
 }
 
-std::map<std::string, std::vector<PointToSurfelCorrPtr>> CalibSolver::DataAssociationForRGBDs(
+PointToSurfelAssociator::Ptr CalibSolver::UpdateSurfelMapOfLiDARs(
+    const std::map<std::string, std::vector<LiDARFrame::Ptr>> &undistFrames) const {
+    auto &keptFrames = _surfelAsset->framesInMap;
+    auto &associator = _surfelAsset->associator;
+
+    // whether the kept scans correspond to the given ones one by one
+    bool consistent = associator != nullptr && keptFrames.size() == undistFrames.size();
+    for (const auto &[topic, frames] : undistFrames) {
+        if (!consistent) {
+            break;
+        }
+        auto iter = keptFrames.find(topic);
+        consistent = iter != keptFrames.cend() && iter->second.size() == frames.size();
+    }
+
+    // find scans moved beyond the threshold, by the max displacement of their points
+    std::vector<std::pair<std::string, int>> movedScans;
+    std::size_t scanCount = 0;
+    const double threshold = Configor::Prior::LiDARDataAssociate::SurfelMapUpdateThreshold;
+    for (const auto &[topic, frames] : undistFrames) {
+        scanCount += frames.size();
+        if (!consistent) {
+            continue;
+        }
+        const auto &curKeptFrames = keptFrames.at(topic);
+        const int frameCount = static_cast<int>(frames.size());
+        std::vector<char> moved(frameCount, 0);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) default(none) \
+    shared(frameCount, frames, curKeptFrames, moved, threshold)
+        for (int i = 0; i < frameCount; ++i) {
+            const auto &kept = curKeptFrames.at(i), &cur = frames.at(i);
+            if (kept == nullptr || cur == nullptr) {
+                moved.at(i) = kept != cur;
+                continue;
+            }
+            const auto &keptScan = kept->GetScan(), &curScan = cur->GetScan();
+            if (keptScan->size() != curScan->size()) {
+                moved.at(i) = 1;
+                continue;
+            }
+            for (int j = 0; j < static_cast<int>(curScan->size()); ++j) {
+                const auto &kp = keptScan->at(j), &cp = curScan->at(j);
+                if (IS_POS_NAN(kp) != IS_POS_NAN(cp)) {
+                    moved.at(i) = 1;
+                    break;
+                }
+                if (!IS_POS_NAN(cp) &&
+                    (kp.getVector3fMap() - cp.getVector3fMap()).norm() > threshold) {
+                    moved.at(i) = 1;
+                    break;
+                }
+            }
+        }
+        for (int i = 0; i < frameCount; ++i) {
+            if (moved.at(i)) {
+                movedScans.emplace_back(topic, i);
+            }
+        }
+    }
+
+    const double rebuildRatio = Configor::Prior::LiDARDataAssociate::SurfelMapRebuildRatio;
+    if (!consistent || static_cast<double>(movedScans.size()) > rebuildRatio * scanCount) {
+        spdlog::info("build the lidar surfel map from '{}' scans...", scanCount);
+        // we use dense scans to create data associator for high-perform point-to-surfel search,
+        // they are inserted one by one, rather than being concatenated into a dense map
+        associator = PointToSurfelAssociator::Create(
+            Configor::Prior::LiDARDataAssociate::MapResolution,
+            Configor::Prior::LiDARDataAssociate::MapDepthLevels);
+        for (const auto &[topic, frames] : undistFrames) {
+            for (const auto &frame : frames) {
+                if (frame != nullptr) {
+                    associator->UpdateSurfelMap(nullptr, frame->GetScan());
+                }
+            }
+        }
+        keptFrames = undistFrames;
+    } else {
+        spdlog::info("update the lidar surfel map incrementally, '{}' of '{}' scans moved...",
+                     movedScans.size(), scanCount);
+        // the surfel map is not thread-safe for modification, scans are updated in order
+        for (const auto &[topic, idx] : movedScans) {
+            auto &kept = keptFrames.at(topic).at(idx);
+            const auto &cur = undistFrames.at(topic).at(idx);
+            associator->UpdateSurfelMap(kept == nullptr ? nullptr : kept->GetScan(),
+                                        cur == nullptr ? nullptr : cur->GetScan());
+            kept = cur;
+        }
+    }
+    return associator;
+}
+
+std::map<std::string, PointToSurfelCorrBufferPtr> CalibSolver::DataAssociationForRGBDs(
     const IKalibrPointCloud::Ptr &map,
     const std::map<std::string, std::vector<IKalibrPointCloud::Ptr>> &scanInGFrame,
     const std::map<std::string, std::vector<IKalibrPointCloud::Ptr>> &scanInLFrame,
     int ptsCountInEachScan) const {
+    StageProfiler::Scope stageScope("DataAssociationForRGBDs(PointToSurfel)");
     if (!Configor::IsRGBDIntegrated() || GetScaleType() != TimeDeriv::LIN_POS_SPLINE) {
         return {};
     }
@@ -361,7 +591,10 @@ std::map<std::string, std::vector<PointToSurfelCorrPtr>> CalibSolver::DataAssoci
     filter.setLeafSize(size, size, size);
 
     IKalibrPointCloud::Ptr mapDownSampled(new IKalibrPointCloud);
-    filter.filter(*mapDownSampled);
+    // the down-sampled cloud is only for the viewer
+    if (!_viewer->IsHeadless()) {
+        filter.filter(*mapDownSampled);
+    }
 
     _viewer->AddAlignedCloud(mapDownSampled, Viewer::VIEW_MAP, -_parMagr->GRAVITY.cast<float>(),
                              2.0f);
@@ -388,50 +621,39 @@ std::map<std::string, std::vector<PointToSurfelCorrPtr>> CalibSolver::DataAssoci
     // deconstruction
     mapDownSampled.reset();
 
-    std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> pointToSurfel;
+    std::map<std::string, PointToSurfelCorrBuffer::Ptr> pointToSurfel;
 
     std::size_t count = 0;
-    std::shared_ptr<tqdm> bar;
     for (const auto &[topic, framesInMap] : scanInGFrame) {
         spdlog::info("perform point to surfel association for rgbd '{}'...", topic);
 
         // for each scan, we keep 'ptsCountInEachScan' point to surfel corrs
         const auto &rawFrames = scanInLFrame.at(topic);
         auto &curPointToSurfel = pointToSurfel[topic];
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(framesInMap.size()); ++i) {
-            bar->progress(i, static_cast<int>(framesInMap.size()));
-
-            if (framesInMap.at(i) == nullptr || rawFrames.at(i) == nullptr) {
-                continue;
-            }
-
-            auto ptsVec = associator->Association(framesInMap.at(i), rawFrames.at(i), condition);
-
-            curPointToSurfel.insert(curPointToSurfel.end(), ptsVec.cbegin(), ptsVec.cend());
+        curPointToSurfel = PointToSurfelCorrBuffer::Create();
+        /**
+         * scans are associated in parallel, they have been sparsified in the image (see
+         * 'BuildGlobalMapOfRGBD'), thus no candidate would be sampled here
+         */
+        for (const auto &scanCorrs : associator->Association(framesInMap, rawFrames, condition,
+                                                             !_viewer->IsHeadless())) {
+            curPointToSurfel->Append(*scanCorrs);
         }
-        bar->finish();
 
         // downsample
         int expectCount = ptsCountInEachScan * static_cast<int>(rawFrames.size());
-        if (static_cast<int>(curPointToSurfel.size()) > expectCount) {
-            std::map<ufo::map::Node, std::vector<PointToSurfelCorr::Ptr>> nodes;
-            for (const auto &corr : curPointToSurfel) {
-                nodes[corr->node].push_back(corr);
-            }
-            std::size_t numEachNode = expectCount / nodes.size() + 1;
-            curPointToSurfel.clear();
-
-            // uniform sampling
-            std::default_random_engine engine(
-                std::chrono::steady_clock::now().time_since_epoch().count());
-            for (const auto &[node, corrs] : nodes) {
-                auto newCorrs =
-                    SamplingWoutReplace2(engine, corrs, std::min(corrs.size(), numEachNode));
-                curPointToSurfel.insert(curPointToSurfel.end(), newCorrs.cbegin(), newCorrs.cend());
-            }
+        if (static_cast<int>(curPointToSurfel->Size()) > expectCount) {
+            // correspondences of the same surfel share an index in the surfel table
+            const auto surfels = curPointToSurfel->GroupBySurfel();
+            std::size_t numEachNode = expectCount / surfels.size() + 1;
+
+            // uniform sampling, each surfel is sampled from its own stream, thus in parallel
+            curPointToSurfel = curPointToSurfel->Select(
+                SampleEachSurfel(surfels, numEachNode,
+                                 Configor::Preference::SamplingSeed ^
+                                     std::hash<std::string>()(topic)));
         }
-        count += curPointToSurfel.size();
+        count += curPointToSurfel->Size();
     }
     spdlog::info("total point to surfel count for RGBDs: {}", count);
     _viewer->AddPointToSurfel(associator->GetSurfelMap(), pointToSurfel, Viewer::VIEW_ASSOCIATION);
@@ -441,6 +663,7 @@ std::map<std::string, std::vector<PointToSurfelCorrPtr>> CalibSolver::DataAssoci
 
 std::map<std::string, std::vector<VisualReProjCorrSeq::Ptr>>
 CalibSolver::DataAssociationForPosCameras() const {
+    StageProfiler::Scope stageScope("DataAssociationForPosCameras");
     if (!Configor::IsPosCameraIntegrated()) {
         return {};
     }
@@ -448,10 +671,13 @@ CalibSolver::DataAssociationForPosCameras() const {
     std::map<std::string, std::vector<VisualReProjCorrSeq::Ptr>> corrs;
     for (const auto &[topic, sfmData] : _dataMagr->GetSfMData()) {
         spdlog::info("performing visual reprojection data association for camera '{}'...", topic);
+        const auto &intri = _parMagr->INTRI.Camera.at(topic);
+        // short, low-parallax, and inaccurate tracks are pruned, good ones are spread over images
+        auto prunedData = VetaLandmarkPruner::Create()->Prune(sfmData, intri);
         corrs[topic] =
             VisualReProjAssociator::Create(EnumCast::stringToEnum<CameraModelType>(
                                                Configor::DataStream::CameraTopics.at(topic).Type))
-                ->Association(*sfmData, _parMagr->INTRI.Camera.at(topic));
+                ->Association(*prunedData, intri);
         _viewer->AddVeta(sfmData, Viewer::VIEW_MAP);
         spdlog::info("visual reprojection sequences for '{}': {}", topic, corrs.at(topic).size());
     }
@@ -460,34 +686,53 @@ CalibSolver::DataAssociationForPosCameras() const {
 
 std::vector<OpticalFlowTripleTrace::Ptr> CalibSolver::CreateOpticalFlowTrace(
     const std::list<RotOnlyVisualOdometer::FeatTrackingInfo> &trackInfoList, int trackThd) {
-    std::vector<OpticalFlowTripleTrace::Ptr> dynamics;
+    using TrackList = RotOnlyVisualOdometer::FeatTrackingInfo::mapped_type;
+    const int minTrackLen = std::max(trackThd, 3);
+
+    /**
+     * tracked features are collected with offsets of their traces in the output, thus traces of
+     * features can be created in parallel and written to their own slots, the order is not changed
+     */
+    std::vector<const TrackList *> tracks;
+    std::vector<std::size_t> offsets;
+    std::size_t traceCount = 0;
     for (const auto &trackInfo : trackInfoList) {
         for (const auto &[id, info] : trackInfo) {
             // for each tracked feature
-            if (static_cast<int>(info.size()) < std::max(trackThd, 3)) {
+            if (static_cast<int>(info.size()) < minTrackLen) {
                 continue;
             }
+            tracks.push_back(&info);
+            offsets.push_back(traceCount);
             // store in groups of three
-            auto groupSize = info.size() - 2;
-            auto iter0 = info.cbegin();
-            for (int i = 0; i < static_cast<int>(groupSize); ++i, ++iter0) {
-                auto iter1 = iter0, iter2 = iter0;
-                std::advance(iter1, 1), std::advance(iter2, 2);
-                std::array<std::pair<CameraFramePtr, Eigen::Vector2d>, 3> movement;
-                movement.at(0) = {
-                    iter0->first,
-                    Eigen::Vector2d(iter0->second->undistorted.x, iter0->second->undistorted.y),
-                };
-                movement.at(1) = {
-                    iter1->first,
-                    Eigen::Vector2d(iter1->second->undistorted.x, iter1->second->undistorted.y),
-                };
-                movement.at(2) = {
-                    iter2->first,
-                    Eigen::Vector2d(iter2->second->undistorted.x, iter2->second->undistorted.y),
-                };
-                dynamics.push_back(OpticalFlowTripleTrace::Create(movement));
-            }
+            traceCount += info.size() - 2;
+        }
+    }
+
+    std::vector<OpticalFlowTripleTrace::Ptr> dynamics(traceCount);
+    const int trackCount = static_cast<int>(tracks.size());
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(trackCount, tracks, offsets, dynamics)
+    for (int j = 0; j < trackCount; ++j) {
+        const auto &info = *tracks.at(j);
+        const auto groupSize = info.size() - 2;
+        // frames are shared by traces, no image is copied here
+        auto iter0 = info.cbegin(), iter1 = std::next(iter0), iter2 = std::next(iter1);
+        for (std::size_t i = 0; i < groupSize; ++i, ++iter0, ++iter1, ++iter2) {
+            std::array<std::pair<CameraFramePtr, Eigen::Vector2d>, 3> movement;
+            movement.at(0) = {
+                iter0->first,
+                Eigen::Vector2d(iter0->second->undistorted.x, iter0->second->undistorted.y),
+            };
+            movement.at(1) = {
+                iter1->first,
+                Eigen::Vector2d(iter1->second->undistorted.x, iter1->second->undistorted.y),
+            };
+            movement.at(2) = {
+                iter2->first,
+                Eigen::Vector2d(iter2->second->undistorted.x, iter2->second->undistorted.y),
+            };
+            dynamics.at(offsets.at(j) + i) = OpticalFlowTripleTrace::Create(movement);
         }
     }
     return dynamics;
@@ -495,6 +740,7 @@ std::vector<OpticalFlowTripleTrace::Ptr> CalibSolver::CreateOpticalFlowTrace(
 
 std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> CalibSolver::DataAssociationForRGBDs(
     bool estDepth) {
+    StageProfiler::Scope stageScope("DataAssociationForRGBDs(OpticalFlow)");
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
 
@@ -608,15 +854,17 @@ std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> CalibSolver::DataAssoci
             "count: {}, with depth observability: {}",
             topic, curCorrs.size(), estDepthCount, dObvCount);
 
-        std::default_random_engine engine(
-            std::chrono::system_clock::now().time_since_epoch().count());
         constexpr int CorrCountPerFrame = 50;
         auto desiredCount = CorrCountPerFrame * _dataMagr->GetRGBDMeasurements(topic).size();
         if (desiredCount < curCorrs.size()) {
-            curCorrs = SamplingWoutReplace2(engine, curCorrs, desiredCount);
+            curCorrs = SamplingWoutReplace2(Configor::Preference::SamplingSeed,
+                                            std::hash<std::string>()(topic), curCorrs,
+                                            desiredCount);
             spdlog::info("total correspondences count for rgbd '{}' after down sampled: {}", topic,
                          curCorrs.size());
         }
+        // depth parameters of correspondences are organized contiguously, ordered by frame
+        curCorrs = OpticalFlowCorr::CreateArena(curCorrs);
     }
 
     // add veta for visualization
@@ -637,6 +885,7 @@ std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> CalibSolver::DataAssoci
 
 std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> CalibSolver::DataAssociationForVelCameras()
     const {
+    StageProfiler::Scope stageScope("DataAssociationForVelCameras");
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
 
@@ -730,15 +979,17 @@ std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> CalibSolver::DataAssoci
 
         spdlog::info("total correspondences count for camera '{}': {}", topic, curCorrs.size());
 
-        std::default_random_engine engine(
-            std::chrono::system_clock::now().time_since_epoch().count());
         constexpr int CorrCountPerFrame = 50;
         auto desiredCount = CorrCountPerFrame * _dataMagr->GetCameraMeasurements(topic).size();
         if (desiredCount < curCorrs.size()) {
-            curCorrs = SamplingWoutReplace2(engine, curCorrs, desiredCount);
+            curCorrs = SamplingWoutReplace2(Configor::Preference::SamplingSeed,
+                                            std::hash<std::string>()(topic), curCorrs,
+                                            desiredCount);
             spdlog::info("total correspondences count for camera '{}' after down sampled: {}",
                          topic, curCorrs.size());
         }
+        // depth parameters of correspondences are organized contiguously, ordered by frame
+        curCorrs = OpticalFlowCorr::CreateArena(curCorrs);
     }
 
     // add veta from pixel dynamics
@@ -759,6 +1010,7 @@ std::map<std::string, std::vector<OpticalFlowCorr::Ptr>> CalibSolver::DataAssoci
 
 std::map<std::string, std::vector<OpticalFlowCorrPtr>> CalibSolver::DataAssociationForEventCameras()
     const {
+    StageProfiler::Scope stageScope("DataAssociationForEventCameras");
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
 
@@ -847,6 +1099,8 @@ std::map<std::string, std::vector<OpticalFlowCorrPtr>> CalibSolver::DataAssociat
         }
 
         spdlog::info("total correspondences count for camera '{}': {}", topic, curCorrs.size());
+        // depth parameters of correspondences are organized contiguously, ordered by frame
+        curCorrs = OpticalFlowCorr::CreateArena(curCorrs);
     }
 
     // add veta from pixel dynamics
@@ -866,6 +1120,7 @@ std::map<std::string, std::vector<OpticalFlowCorrPtr>> CalibSolver::DataAssociat
 
 std::map<std::string, std::vector<OpticalFlowCurveCorr::Ptr>>
 CalibSolver::DataAssociationForEventCameras(bool) const {
+    StageProfiler::Scope stageScope("DataAssociationForEventCameras(Curve)");
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
 
@@ -885,18 +1140,34 @@ CalibSolver::DataAssociationForEventCameras(bool) const {
         Sophus::SO3d SO3_BrToEs = SO3_EsToBr.inverse();
         Eigen::Vector3d POS_EsInBr = _parMagr->EXTRI.POS_EsInBr.at(topic);
 
-        auto &curCorrs = corrs[topic];
-
-        for (const auto &trace : traceVec) {
-            for (double midTime = trace->sTime; midTime < trace->eTime;) {
-                const double firTime = midTime - TRACE_TRIPLE_POINTS_TIME_PADDING;
-                const double lastTime = midTime + TRACE_TRIPLE_POINTS_TIME_PADDING;
-                midTime += TRACE_TRIPLE_POINTS_TIME_PADDING;
-
-                if (!trace->IsTimeInRange(firTime) || !trace->IsTimeInRange(lastTime)) {
-                    continue;
-                }
+        /**
+         * traces are independent, thus their correspondences are created in parallel, and then
+         * merged in order. Mid times of each trace are sampled first, where the curve is evaluated
+         * in a batch (see 'FeatureTrackingCurve::EvaluateAt')
+         */
+        const auto scaleType = GetScaleType();
+        const int traceCount = static_cast<int>(traceVec.size());
+        std::vector<std::vector<OpticalFlowCurveCorr::Ptr>> traceCorrs(traceCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(traceCount, traceVec, traceCorrs, so3Spline, scaleSpline, fx, fy, cx, cy, \
+                             TO_EsToBr, SO3_BrToEs, POS_EsInBr, scaleType,              \
+                             TRACE_TRIPLE_POINTS_TIME_PADDING)
+        for (int i = 0; i < traceCount; ++i) {
+            const auto &trace = traceVec.at(i);
+            auto &curTraceCorrs = traceCorrs.at(i);
+
+            // mid times whose triple points are all covered by the trace
+            std::vector<double> midTimes;
+            for (double midTime = trace->sTime + TRACE_TRIPLE_POINTS_TIME_PADDING;
+                 midTime + TRACE_TRIPLE_POINTS_TIME_PADDING <= trace->eTime;
+                 midTime += TRACE_TRIPLE_POINTS_TIME_PADDING) {
+                midTimes.push_back(midTime);
+            }
+            std::vector<Eigen::Vector2d> midPoints, midVels;
+            const auto [begin, end] = trace->EvaluateAt(midTimes, &midPoints, &midVels);
 
+            for (std::size_t j = begin; j < end; ++j) {
+                const double midTime = midTimes.at(j);
                 double midTimeByBr = midTime + TO_EsToBr;
                 if (!so3Spline.TimeStampInRange(midTimeByBr) ||
                     !scaleSpline.TimeStampInRange(midTimeByBr)) {
@@ -904,7 +1175,7 @@ CalibSolver::DataAssociationForEventCameras(bool) const {
                 }
 
                 Eigen::Vector3d LIN_VEL_BrToBr0InBr0;
-                switch (GetScaleType()) {
+                switch (scaleType) {
                     case TimeDeriv::LIN_ACCE_SPLINE:
                         // this would not happen
                         continue;
@@ -925,8 +1196,8 @@ CalibSolver::DataAssociationForEventCameras(bool) const {
                     -Sophus::SO3d::hat(SO3_BrToBr0 * POS_EsInBr) * ANG_VEL_BrToBr0InBr0 +
                     LIN_VEL_BrToBr0InBr0;
 
-                Eigen::Vector2d midPoint = *trace->PositionAt(midTime);
-                Eigen::Vector2d midVel = *trace->VelocityAt(midTime);
+                const Eigen::Vector2d &midPoint = midPoints.at(j - begin);
+                const Eigen::Vector2d &midVel = midVels.at(j - begin);
                 const double midVelNorm = midVel.norm();
 
                 bool withDepthObservability =
@@ -961,11 +1232,16 @@ CalibSolver::DataAssociationForEventCameras(bool) const {
                     midTime, estDepth, TRACE_TRIPLE_POINTS_TIME_PADDING, trace, weight);
 
                 if (moment != nullptr) {
-                    curCorrs.push_back(moment);
+                    curTraceCorrs.push_back(moment);
                 }
             }
         }
 
+        auto &curCorrs = corrs[topic];
+        for (auto &curTraceCorrs : traceCorrs) {
+            curCorrs.insert(curCorrs.end(), curTraceCorrs.begin(), curTraceCorrs.end());
+        }
+
         spdlog::info("total correspondences count for camera '{}': {}", topic, curCorrs.size());
     }
 
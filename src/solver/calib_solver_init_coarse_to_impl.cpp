@@ -0,0 +1,218 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "calib/calib_data_manager.h"
+#include "calib/calib_param_manager.h"
+#include "calib/temporal_padding.h"
+#include "core/lidar_odometer.h"
+#include "solver/calib_solver.h"
+#include "spdlog/spdlog.h"
+#include "util/stage_profiler.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+void CalibSolver::InitCoarseTimeOffsets() const {
+    StageProfiler::Scope stageScope("InitCoarseTimeOffsets");
+    if (!Configor::Prior::OptTemporalParams ||
+        Configor::Preference::CoarseTimeOffsetMargin <= 0.0) {
+        return;
+    }
+    spdlog::info("estimating coarse time offsets by correlating angular rate magnitudes...");
+
+    // angular rate magnitudes of consecutive rotations, which are stamped at middle times
+    auto RatesOfRotations = [](const std::vector<ns_ctraj::Posed> &poseSeq) {
+        std::vector<std::pair<double, double>> rates;
+        rates.reserve(poseSeq.size());
+        for (int i = 0; i < static_cast<int>(poseSeq.size()) - 1; ++i) {
+            const auto &sPose = poseSeq.at(i), ePose = poseSeq.at(i + 1);
+            const double dt = ePose.timeStamp - sPose.timeStamp;
+            if (dt <= 0.0) {
+                continue;
+            }
+            rates.emplace_back(0.5 * (sPose.timeStamp + ePose.timeStamp),
+                               (sPose.so3.inverse() * ePose.so3).log().norm() / dt);
+        }
+        return rates;
+    };
+
+    auto NarrowPadding = [this](const std::string &topic,
+                                const std::vector<std::pair<double, double>> &rates,
+                                double curTimeOffset) {
+        const auto result = CorrelateAngularRates(rates, _temporalPadding->TimeOffset(topic));
+        if (result == std::nullopt) {
+            spdlog::warn("coarse time offset of '{}' is not found, its padding is kept", topic);
+            return;
+        }
+        const auto &[timeOffset, corr] = *result;
+        if (corr < Configor::Preference::CoarseTimeOffsetMinCorr) {
+            spdlog::warn("weakly correlated angular rates of '{}' ({:.3f}), its padding is kept",
+                         topic, corr);
+            return;
+        }
+        spdlog::info("coarse time offset of '{}': {:.6f} (s), correlation: {:.3f}", topic,
+                     timeOffset, corr);
+        // the padding is also the bound, which should cover the current estimate (initial value)
+        _temporalPadding->NarrowTimeOffsetTo(
+            topic, std::max(std::abs(timeOffset), std::abs(curTimeOffset)) +
+                       Configor::Preference::CoarseTimeOffsetMargin);
+    };
+
+    // imus (the reference one excluded)
+    for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+        if (topic == Configor::DataStream::ReferIMU) {
+            continue;
+        }
+        const auto &intri = _parMagr->INTRI.IMU.at(topic);
+        const auto &frames = _dataMagr->GetIMUMeasurements(topic);
+        std::vector<std::pair<double, double>> rates;
+        rates.reserve(frames.size());
+        for (const auto &frame : frames) {
+            rates.emplace_back(frame->GetTimestamp(),
+                               intri->RemoveGyroIntri(frame->GetGyro()).norm());
+        }
+        NarrowPadding(topic, rates, _parMagr->TEMPORAL.TO_BiToBr.at(topic));
+    }
+
+    // lidars, using rotations from lidar odometers
+    for (const auto &[topic, odometer] : _initAsset->lidarOdometers) {
+        if (odometer == nullptr) {
+            continue;
+        }
+        NarrowPadding(topic, RatesOfRotations(odometer->GetOdomPoseVec()),
+                      _parMagr->TEMPORAL.TO_LkToBr.at(topic));
+    }
+
+    // cameras, using rotations from the structure from motion
+    for (const auto &[topic, veta] : _dataMagr->GetSfMData()) {
+        const auto &frames = _dataMagr->GetCameraMeasurements(topic);
+        std::vector<ns_ctraj::Posed> poseSeq;
+        poseSeq.reserve(frames.size());
+        for (const auto &frame : frames) {
+            auto viewIter = veta->views.find(frame->GetId());
+            if (viewIter == veta->views.cend()) {
+                continue;
+            }
+            auto poseIter = veta->poses.find(viewIter->second->poseId);
+            if (poseIter == veta->poses.cend()) {
+                continue;
+            }
+            const auto &pose = poseIter->second;
+            poseSeq.emplace_back(pose.Rotation(), pose.Translation(), frame->GetTimestamp());
+        }
+        NarrowPadding(topic, RatesOfRotations(poseSeq), _parMagr->TEMPORAL.TO_CmToBr.at(topic));
+    }
+
+    _temporalPadding->ShowPaddings();
+}
+
+std::optional<std::pair<double, double>> CalibSolver::CorrelateAngularRates(
+    const std::vector<std::pair<double, double>> &rates, double maxLag) const {
+    // too short sequences are not reliable for correlation
+    static constexpr int MIN_SAMPLE_COUNT = 100;
+    static constexpr double EPS = 1E-9;
+    if (rates.size() < 2) {
+        return {};
+    }
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const double dt = 1.0 / Configor::Preference::CoarseTimeOffsetSampleRate;
+    const int maxLagIdx = std::max(1, static_cast<int>(std::ceil(maxLag / dt)));
+    const int lagCount = 2 * maxLagIdx + 1;
+
+    // the grid stamped by the sensor, which should be in the range of the spline once lagged
+    const double st = std::max(rates.front().first, so3Spline.MinTime() + maxLagIdx * dt);
+    const double et = std::min(rates.back().first, so3Spline.MaxTime() - (maxLagIdx + 1) * dt);
+    if (et <= st) {
+        return {};
+    }
+    const int count = static_cast<int>(std::floor((et - st) / dt)) + 1;
+    if (count < std::max(MIN_SAMPLE_COUNT, lagCount)) {
+        return {};
+    }
+
+    // angular rate magnitudes of the sensor on the grid (linearly interpolated)
+    Eigen::VectorXd senRates(count);
+    auto iter = rates.cbegin();
+    for (int i = 0; i < count; ++i) {
+        const double t = st + i * dt;
+        while (std::next(iter) != rates.cend() && std::next(iter)->first < t) {
+            ++iter;
+        }
+        const auto next = std::next(iter);
+        if (next == rates.cend() || next->first <= iter->first) {
+            senRates(i) = iter->second;
+        } else {
+            const double f = std::clamp((t - iter->first) / (next->first - iter->first), 0.0, 1.0);
+            senRates(i) = (1.0 - f) * iter->second + f * next->second;
+        }
+    }
+
+    // angular rate magnitudes of the spline on the grid extended by lags at both sides
+    Eigen::VectorXd splRates(count + lagCount - 1);
+    for (int j = 0; j < splRates.size(); ++j) {
+        splRates(j) = so3Spline.VelocityBody(st + (j - maxLagIdx) * dt).norm();
+    }
+
+    // the normalized cross-correlation for each lag
+    const Eigen::VectorXd senCentered = senRates.array() - senRates.mean();
+    const double senNorm = senCentered.norm();
+    if (senNorm < EPS) {
+        // the sensor is not rotationally excited
+        return {};
+    }
+    Eigen::VectorXd corr(lagCount);
+    for (int l = 0; l < lagCount; ++l) {
+        const auto seg = splRates.segment(l, count);
+        const Eigen::VectorXd splCentered = seg.array() - seg.mean();
+        const double splNorm = splCentered.norm();
+        corr(l) = splNorm < EPS ? 0.0 : senCentered.dot(splCentered) / (senNorm * splNorm);
+    }
+    Eigen::Index best;
+    const double maxCorr = corr.maxCoeff(&best);
+    if (best == 0 || best == lagCount - 1) {
+        // the peak is on the bound, the time offset may be out of it
+        return {};
+    }
+
+    // sub-sample refinement by fitting a parabola around the peak
+    const double cm = corr(best - 1), c0 = corr(best), cp = corr(best + 1);
+    const double denom = cm - 2.0 * c0 + cp;
+    const double shift = denom < 0.0 ? 0.5 * (cm - cp) / denom : 0.0;
+    return std::make_pair((static_cast<double>(best - maxLagIdx) + shift) * dt, maxCorr);
+}
+
+}  // namespace ns_ikalibr
@@ -34,8 +34,11 @@
 
 #include "solver/calib_solver.h"
 #include "core/lidar_odometer.h"
+#include "core/voxel_map_accumulator.h"
 #include "calib/calib_data_manager.h"
 #include "viewer/viewer.h"
+#include "util/point_buffer.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -44,6 +47,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitPrepBatchOpt() const {
+    StageProfiler::Scope stageScope("InitPrepBatchOpt");
     /**
      * align initialized states to gravity direction
      */
@@ -70,8 +74,8 @@ void CalibSolver::InitPrepBatchOpt() const {
      * build map and undisto frames if LiDARs are integrated
      */
     spdlog::info("build global map and undisto lidar frames in world...");
-    auto &globalMap = _initAsset->globalMap;
-    globalMap = IKalibrPointCloud::Ptr(new IKalibrPointCloud);
+    // scans are streamed into a voxel map, rather than being concatenated into a dense map
+    auto voxelMap = VoxelMapAccumulator::Create(Configor::Prior::MapDownSample);
     auto &undistFramesInMap = _initAsset->undistFramesInMap;
     for (const auto &[lidarTopic, odometer] : _initAsset->lidarOdometers) {
         auto SE3_Lk0ToBr0 = this->CurLkToW(odometer->GetMapTime(), lidarTopic);
@@ -95,15 +99,16 @@ void CalibSolver::InitPrepBatchOpt() const {
             } else {
                 const auto &SE3_ScanToLk0 = poseSeq.at(i);
                 Sophus::SE3d SE3_ScanToBr0 = *SE3_Lk0ToBr0 * SE3_ScanToLk0.se3();
-                IKalibrPointCloud::Ptr scanInBr0(new IKalibrPointCloud);
-                pcl::transformPointCloud(*undistoScan->GetScan(), *scanInBr0,
-                                         SE3_ScanToBr0.matrix().cast<float>());
+                auto scanInBr0 = PointBuffer(*undistoScan->GetScan())
+                                     .Transform(SE3_ScanToBr0.cast<float>())
+                                     .ToCloud();
                 curUndistFramesInMap.at(i) =
                     LiDARFrame::Create(undistoScan->GetTimestamp(), scanInBr0);
 
-                *globalMap += *scanInBr0;
+                voxelMap->Insert(scanInBr0);
             }
         }
     }
+    _initAsset->globalMap = voxelMap->GetCloud();
 }
 }  // namespace ns_ikalibr
\ No newline at end of file
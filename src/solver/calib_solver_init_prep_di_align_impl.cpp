@@ -36,6 +36,7 @@
 #include "calib/calib_param_manager.h"
 #include "calib/estimator.h"
 #include "core/optical_flow_trace.h"
+#include "core/frame_prefetcher.h"
 #include "core/rotation_estimator.h"
 #include "core/visual_velocity_sac.h"
 #include "factor/data_correspondence.h"
@@ -43,8 +44,9 @@
 #include "solver/calib_solver.h"
 #include "spdlog/spdlog.h"
 #include "tiny-viewer/object/camera.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "viewer/viewer.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -53,6 +55,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitPrepRGBDInertialAlign() const {
+    StageProfiler::Scope stageScope("InitPrepRGBDInertialAlign");
     if (!Configor::IsRGBDIntegrated()) {
         return;
     }
@@ -70,155 +73,23 @@ void CalibSolver::InitPrepRGBDInertialAlign() const {
     /**
      * the feature tracking is first performed for rotation-only visual odometry.
      * the rotation-only visual odometry means we only estimate the time-varying rotations of the
-     * camera, which would be utilized for extrinsic rotation recovery
+     * camera, which would be utilized for extrinsic rotation recovery. Pipelines of RGBD cameras
+     * are independent of each other, thus they run concurrently
      */
     // 'FeatTrackingInfo' is a list for each rgbd camera, as fail tracking leads to multiple pieces
     std::map<std::string, std::list<RotOnlyVisualOdometer::FeatTrackingInfo>> RGBDTrackingInfo;
-    // how many features to maintain in each image
-    constexpr int featNumPerImg = 300;
-    // the min distance between two features (to ensure features are distributed uniformly)
-    constexpr int minDist = 25;
-    for (const auto &[topic, frameVec] : _dataMagr->GetRGBDMeasurements()) {
-        spdlog::info(
-            "perform rotation-only visual odometer to recover extrinsic rotations for RGBD "
-            "camera '{}'...",
-            topic);
-
-        // estimates rotations
-        auto intri = _parMagr->INTRI.RGBD.at(topic);
-        auto tracker = LKFeatureTracking::Create(featNumPerImg, minDist, intri->intri);
-        auto odometer = RotOnlyVisualOdometer::Create(tracker, intri->intri);
-
-        // sensor-inertial rotation estimator (linear least-squares problem)
-        auto rotEstimator = RotationEstimator::Create();
-
-        auto bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(frameVec.size()); ++i) {
-            bar->progress(i, static_cast<int>(frameVec.size()));
-
-            if (i % 30 == 0) {
-                /**
-                 * we do not update the viewer too frequent, which would lead to heavy tasks
-                 */
-                _viewer->ClearViewer(Viewer::VIEW_MAP);
-                // rgbd camera
-                static auto rgbd = ns_viewer::CubeCamera::Create(
-                    ns_viewer::Posef(), 0.04, ns_viewer::Colour(1.0f, 0.5f, 0.0f, 1.0f));
-                _viewer->AddEntityLocal({rgbd}, Viewer::VIEW_MAP);
-                // depth point could
-                _viewer->AddRGBDFrame(frameVec.at(i), intri, Viewer::VIEW_MAP, true, 2.0f);
-                // auto img = frameVec.at(i)->CreateColorDepthMap(intri, true);
-                // cv::imshow("img", img);
-                // cv::waitKey();
-            }
-
-            /*
-             * we try to compute the prior rotation to accelerate the feature tracking.
-             * only the extrinsic rotation is recovered, we can compute such priori.
-             */
-            std::optional<Sophus::SO3d> SO3_LastToCur = std::nullopt;
-            if (rotEstimator->SolveStatus()) {
-                // such codes should be put out of the for loop, but fore better readability...
-                const auto SO3_DnToBr = _parMagr->EXTRI.SO3_DnToBr.at(topic);
-                const auto TO_DnToBr = _parMagr->TEMPORAL.TO_DnToBr.at(topic);
-                double lastTimeByBr = frameVec.at(i - 1)->GetTimestamp() + TO_DnToBr;
-                double curTimeByBr = frameVec.at(i)->GetTimestamp() + TO_DnToBr;
-                if (so3Spline.TimeStampInRange(lastTimeByBr) &&
-                    so3Spline.TimeStampInRange(curTimeByBr)) {
-                    // compute rotations at two timestamps
-                    auto SO3_LastBrToW = so3Spline.Evaluate(lastTimeByBr);
-                    auto SO3_CurBrToW = so3Spline.Evaluate(lastTimeByBr);
-                    // compute the relative rotation of the reference imu
-                    auto SO3_LastBrToCurBr = SO3_CurBrToW.inverse() * SO3_LastBrToW;
-                    // assignment
-                    SO3_LastToCur = SO3_DnToBr.inverse() * SO3_LastBrToCurBr * SO3_DnToBr;
-                }
-            }
-
-            // if tracking current frame failed, the rotation-only odometer would re-initialize
-            if (!odometer->GrabFrame(frameVec.at(i), SO3_LastToCur)) {
-                spdlog::warn(
-                    "tracking failed when grab the '{}' image frame!!! try to reinitialize", i);
-                // save the tracking information
-                RGBDTrackingInfo[topic].push_back(odometer->GetLmTrackInfo());
-                // clear workspace
-                odometer->ResetWorkspace();
-            }
-
-            // we do not want to try to recover the extrinsic rotation too frequent (or has been
-            // recovered)
-            if (rotEstimator->SolveStatus() || (odometer->GetRotations().size() < 50) ||
-                (odometer->GetRotations().size() % 5 != 0)) {
-                continue;
-            }
-
-            // estimate the extrinsic rotation
-            rotEstimator->Estimate(so3Spline, odometer->GetRotations());
-
-            // check solver status
-            if (rotEstimator->SolveStatus()) {
-                // assign the estimated extrinsic rotation
-                _parMagr->EXTRI.SO3_DnToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
-
-                /**
-                 * once the extrinsic rotation is recovered, if time offset is also required, we
-                 * continue to recover it and refine extrineic rotation using
-                 * continuous-time-based alignment
-                 */
-                if (Configor::Prior::OptTemporalParams) {
-                    auto estimator = Estimator::Create(_splines, _parMagr);
-
-                    auto optOption = OptOption::OPT_SO3_DnToBr | OptOption::OPT_TO_DnToBr;
-                    double TO_DnToBr = _parMagr->TEMPORAL.TO_DnToBr.at(topic);
-                    double weight = Configor::DataStream::RGBDTopics.at(topic).Weight;
-
-                    const auto &rotations = odometer->GetRotations();
-                    for (int j = 0; j < static_cast<int>(rotations.size()) - 1; ++j) {
-                        const auto &sRot = rotations.at(j), eRot = rotations.at(j + 1);
-                        // we throw the head and tail data as the rotations from the fitted SO3
-                        // Spline in that range are poor
-                        if (sRot.first + TO_DnToBr < st || eRot.first + TO_DnToBr > et) {
-                            continue;
-                        }
-
-                        estimator->AddHandEyeRotationAlignmentForRGBD(
-                            topic,        // the ros topic
-                            sRot.first,   // the time of start rotation stamped by the camera
-                            eRot.first,   // the time of end rotation stamped by the camera
-                            sRot.second,  // the start rotation
-                            eRot.second,  // the end rotation
-                            optOption,    // the optimization option
-                            weight        // the weight
-                        );
-                    }
-
-                    // we don't want to output the solving information
-                    auto optWithoutOutput = Estimator::DefaultSolverOptions(
-                        Configor::Preference::AvailableThreads(),
-                        false,  // do not output the solving information
-                        Configor::Preference::UseCudaInSolving);
-
-                    estimator->Solve(optWithoutOutput, _priori);
-                }
-
-                _viewer->UpdateSensorViewer();
-            }
-        }
-        bar->finish();
-
-        // add tracking info
-        RGBDTrackingInfo[topic].push_back(odometer->GetLmTrackInfo());
-
-        /**
-         * after all images are grabbed, if the extrinsic rotation is not recovered (use min
-         * eigen value to check solve results), stop this program
-         */
-        if (!rotEstimator->SolveStatus()) {
-            throw Status(Status::ERROR,
-                         "initialize rotation 'SO3_DnToBr' failed, this may be related to "
-                         "insufficiently excited motion or bad images.");
-        }
+    std::vector<std::string> topics;
+    for (const auto &[topic, _] : _dataMagr->GetRGBDMeasurements()) {
+        topics.push_back(topic);
+        // entries are created here, thus each pipeline only assigns its own one
+        RGBDTrackingInfo[topic] = {};
     }
+    RunTrackingPipelines(topics, [this, &RGBDTrackingInfo](const std::string &topic,
+                                                           int prefetchDepth, bool visualize) {
+        RGBDTrackingInfo.at(topic) = InitPrepRGBDPipeline(topic, prefetchDepth, visualize);
+    });
+    // the viewer is not updated in parallel pipelines
+    _viewer->UpdateSensorViewer();
     _viewer->ClearViewer(Viewer::VIEW_MAP);
     cv::destroyAllWindows();
 
@@ -292,28 +163,60 @@ void CalibSolver::InitPrepRGBDInertialAlign() const {
         const auto &rgbdIntri = _parMagr->INTRI.RGBD.at(topic);
         const double TO_DnToBr = _parMagr->TEMPORAL.TO_DnToBr.at(topic);
         const Sophus::SO3d &SO3_DnToBr = _parMagr->EXTRI.SO3_DnToBr.at(topic);
+
+        // frames are organized in time order, thus velocities of neighbors are available
+        std::vector<std::pair<CameraFrame::Ptr, const std::vector<OpticalFlowCorr::Ptr> *>> frames;
         for (const auto &[frame, ofVec] : opticalFlowInFrame.at(topic)) {
             const double timeByBr = frame->GetTimestamp() + TO_DnToBr;
             // at least two measurements are required, here we up the ante
             if (timeByBr < st || timeByBr > et || ofVec.size() < 5) {
                 continue;
             }
-            auto res = VisualVelocitySacProblem::VisualVelocityEstimationRANSAC(
-                ofVec,             // pixel velocity sequence in this image
-                readout,           // the readout time of the associated camera
-                rgbdIntri->intri,  // the visual intrinsics
-                timeByBr,          // the time stamped by the reference imu
-                so3Spline,         // the rotation spline
-                SO3_DnToBr         // the extrinsic rotation
-            );
-            if (res) {
+            frames.emplace_back(frame, &ofVec);
+        }
+        std::sort(frames.begin(), frames.end(), [](const auto &p1, const auto &p2) {
+            return p1.first->GetTimestamp() < p2.first->GetTimestamp();
+        });
+
+        /**
+         * frames are split into contiguous chunks, which are processed in parallel. In each chunk,
+         * frames are processed in order, and the velocity of the last frame warm starts the ransac
+         * of the current one, as velocities of neighboring frames are close
+         */
+        const int frameCount = static_cast<int>(frames.size());
+        const int chunkCount = std::min(frameCount, Configor::Preference::AvailableThreads());
+        std::vector<std::optional<Eigen::Vector3d>> vels(frameCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(static) \
+    default(none) shared(chunkCount, frameCount, frames, vels, readout, rgbdIntri, TO_DnToBr, \
+                             so3Spline, SO3_DnToBr)
+        for (int c = 0; c < chunkCount; ++c) {
+            std::optional<Eigen::Vector3d> lastVel = std::nullopt;
+            for (int i = c * frameCount / chunkCount; i < (c + 1) * frameCount / chunkCount; ++i) {
+                const auto &[frame, ofVec] = frames.at(i);
+                vels.at(i) = VisualVelocitySacProblem::VisualVelocityEstimationRANSAC(
+                    *ofVec,                             // pixel velocity sequence in this image
+                    readout,                            // the readout time of the camera
+                    rgbdIntri->intri,                   // the visual intrinsics
+                    frame->GetTimestamp() + TO_DnToBr,  // the time stamped by the reference imu
+                    so3Spline,                          // the rotation spline
+                    SO3_DnToBr,                         // the extrinsic rotation
+                    lastVel                             // the velocity of the last frame
+                );
+                lastVel = vels.at(i);
+            }
+        }
+
+        for (int i = 0; i < frameCount; ++i) {
+            const auto &[frame, ofVec] = frames.at(i);
+            if (const auto &res = vels.at(i); res) {
                 rgbdBodyFrameVels[topic].emplace_back(frame, *res);
 #define VISUALIZE_RGBD_ONLY_VEL_EST 0
 #if VISUALIZE_RGBD_ONLY_VEL_EST
+                const double timeByBr = frame->GetTimestamp() + TO_DnToBr;
                 // feature, velocity, depth
                 std::vector<std::tuple<Eigen::Vector2d, Eigen::Vector2d, double>> dynamics;
-                dynamics.reserve(ofVec.size());
-                for (const auto &ofCorr : ofVec) {
+                dynamics.reserve(ofVec->size());
+                for (const auto &ofCorr : *ofVec) {
                     if (ofCorr->depth < 1E-3 /* 1mm */) {
                         continue;
                     }
@@ -338,4 +241,248 @@ void CalibSolver::InitPrepRGBDInertialAlign() const {
         });
     }
 }
+std::list<RotOnlyVisualOdometer::FeatTrackingInfo> CalibSolver::InitPrepRGBDPipeline(
+    const std::string &topic, int prefetchDepth, bool visualize) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    /**
+     * we throw the head and tail data as the rotations from the fitted SO3 Spline in that range are
+     * poor
+     */
+    const double st = std::max(so3Spline.MinTime(), scaleSpline.MinTime()) +  // the max as start
+                      Configor::Prior::TimeOffsetPadding;
+    const double et = std::min(so3Spline.MaxTime(), scaleSpline.MaxTime()) -  // the min as end
+                      Configor::Prior::TimeOffsetPadding;
+
+    // 'FeatTrackingInfo' is a list, as fail tracking leads to multiple pieces
+    std::list<RotOnlyVisualOdometer::FeatTrackingInfo> trackingInfo;
+    // how many features to maintain in each image
+    constexpr int featNumPerImg = 300;
+    // the min distance between two features (to ensure features are distributed uniformly)
+    constexpr int minDist = 25;
+
+    const auto &frameVec = _dataMagr->GetRGBDMeasurements(topic);
+    spdlog::info(
+        "perform rotation-only visual odometer to recover extrinsic rotations for RGBD camera "
+        "'{}'...",
+        topic);
+
+    // estimates rotations
+    auto intri = _parMagr->INTRI.RGBD.at(topic);
+
+    // sensor-inertial rotation estimator (linear least-squares problem)
+    auto rotEstimator = RotationEstimator::Create();
+
+    // recover the time offset and refine the extrinsic rotation using continuous-time-based
+    // alignment of the given rotation sequences
+    auto refineHandEyeAlignment =
+        [this, &topic, st, et](const std::vector<RotationEstimator::RotationSequence> &rotSeqs) {
+            // the estimator touches the shared splines and parameters, solve them one by one
+#pragma omp critical(ikalibr_hand_eye_rotation_alignment)
+            {
+                auto estimator = Estimator::Create(_splines, _parMagr);
+
+                auto optOption = OptOption::OPT_SO3_DnToBr | OptOption::OPT_TO_DnToBr;
+                double TO_DnToBr = _parMagr->TEMPORAL.TO_DnToBr.at(topic);
+                double weight = Configor::DataStream::RGBDTopics.at(topic).Weight;
+
+                for (const auto &rotations : rotSeqs) {
+                    for (int j = 0; j < static_cast<int>(rotations.size()) - 1; ++j) {
+                        const auto &sRot = rotations.at(j), eRot = rotations.at(j + 1);
+                        // we throw the head and tail data as the rotations from the fitted SO3
+                        // Spline in that range are poor
+                        if (sRot.first + TO_DnToBr < st || eRot.first + TO_DnToBr > et) {
+                            continue;
+                        }
+
+                        estimator->AddHandEyeRotationAlignmentForRGBD(
+                            topic,        // the ros topic
+                            sRot.first,   // the time of start rotation stamped by the camera
+                            eRot.first,   // the time of end rotation stamped by the camera
+                            sRot.second,  // the start rotation
+                            eRot.second,  // the end rotation
+                            optOption,    // the optimization option
+                            weight        // the weight
+                        );
+                    }
+                }
+
+                // we don't want to output the solving information
+                auto optWithoutOutput =
+                    Estimator::DefaultSolverOptions(Configor::Preference::AvailableThreads(),
+                                                    false,  // do not output the solving information
+                                                    Configor::Preference::UseCudaInSolving);
+
+                estimator->Solve(optWithoutOutput, _priori);
+            }
+        };
+
+    // whether the extrinsic rotation is recovered
+    bool rotRecovered = false;
+    if (const int chunkSize = Configor::Preference::VOChunkFrameCount;
+        chunkSize > 0 && static_cast<int>(frameVec.size()) >= 2 * chunkSize &&
+        Configor::Preference::AvailableThreads() > 1) {
+        /**
+         * long sequences are tracked in overlapping chunks in parallel, see
+         * 'InitPrepVelCameraPipeline'
+         */
+        spdlog::info("track '{}' frames of '{}' in chunks of '{}' frames...", frameVec.size(),
+                     topic, chunkSize);
+        auto pieces = RotOnlyVisualOdometer::TrackInChunks(
+            std::vector<CameraFrame::Ptr>(frameVec.cbegin(), frameVec.cend()),
+            [&]() { return LKFeatureTracking::Create(featNumPerImg, minDist, intri->intri); },
+            intri->intri, chunkSize, Configor::Preference::VOChunkOverlapFrames);
+
+        std::vector<RotationEstimator::RotationSequence> rotSeqs;
+        RotationEstimator::RelRotationSequence relRotSeq;
+        for (auto &piece : pieces) {
+            const auto &rotations = piece.rotations;
+            for (int j = 0; j < static_cast<int>(rotations.size()) - 1; ++j) {
+                const auto &sRot = rotations.at(j), eRot = rotations.at(j + 1);
+                relRotSeq.emplace_back(sRot.first, eRot.first, sRot.second.inverse() * eRot.second);
+            }
+            rotSeqs.push_back(std::move(piece.rotations));
+            trackingInfo.push_back(std::move(piece.lmTrackInfo));
+        }
+
+        // estimate the extrinsic rotation, the normal matrix is accumulated in a single pass
+        rotEstimator->EstimateIncrementally(so3Spline, relRotSeq);
+
+        rotRecovered = rotEstimator->SolveStatus();
+        if (rotRecovered) {
+            // assign the estimated extrinsic rotation
+            _parMagr->EXTRI.SO3_DnToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
+
+            if (Configor::Prior::OptTemporalParams) {
+                refineHandEyeAlignment(rotSeqs);
+            }
+        }
+    } else {
+        auto tracker = LKFeatureTracking::Create(featNumPerImg, minDist, intri->intri);
+        auto odometer = RotOnlyVisualOdometer::Create(tracker, intri->intri, visualize);
+
+        // the decode stage, images are decoded ahead of the tracking stage
+        auto prefetcher = FramePrefetcher::Create(
+            std::vector<CameraFrame::Ptr>(frameVec.cbegin(), frameVec.cend()), prefetchDepth);
+
+        // whether the estimates of the extrinsic rotation are stable
+        bool rotConverged = false;
+        auto bar = ProgressStage::Create(fmt::format("depth odometry '{}'", topic));
+        for (int i = 0; i < static_cast<int>(frameVec.size()); ++i) {
+            prefetcher->Acquire(i);
+            const auto &frame = frameVec.at(i);
+
+            bar->Progress(i, static_cast<int>(frameVec.size()));
+            if (visualize && i % 30 == 0) {
+                /**
+                 * we do not update the viewer too frequent, which would lead to heavy tasks
+                 */
+                _viewer->ClearViewer(Viewer::VIEW_MAP);
+                // rgbd camera
+                static auto rgbd = ns_viewer::CubeCamera::Create(
+                    ns_viewer::Posef(), 0.04, ns_viewer::Colour(1.0f, 0.5f, 0.0f, 1.0f));
+                _viewer->AddEntityLocal({rgbd}, Viewer::VIEW_MAP);
+                // depth point could
+                _viewer->AddRGBDFrame(frame, intri, Viewer::VIEW_MAP, true, 2.0f);
+                // auto img = frame->CreateColorDepthMap(intri, true);
+                // cv::imshow("img", img);
+                // cv::waitKey();
+            }
+
+            /*
+             * we try to compute the prior rotation to accelerate the feature tracking.
+             * only the extrinsic rotation is recovered, we can compute such priori.
+             */
+            std::optional<Sophus::SO3d> SO3_LastToCur = std::nullopt;
+            if (rotRecovered) {
+                // such codes should be put out of the for loop, but fore better readability...
+                const auto SO3_DnToBr = _parMagr->EXTRI.SO3_DnToBr.at(topic);
+                const auto TO_DnToBr = _parMagr->TEMPORAL.TO_DnToBr.at(topic);
+                double lastTimeByBr = frameVec.at(i - 1)->GetTimestamp() + TO_DnToBr;
+                double curTimeByBr = frame->GetTimestamp() + TO_DnToBr;
+                if (so3Spline.TimeStampInRange(lastTimeByBr) &&
+                    so3Spline.TimeStampInRange(curTimeByBr)) {
+                    // compute rotations at two timestamps
+                    auto SO3_LastBrToW = so3Spline.Evaluate(lastTimeByBr);
+                    auto SO3_CurBrToW = so3Spline.Evaluate(curTimeByBr);
+                    // compute the relative rotation of the reference imu
+                    auto SO3_LastBrToCurBr = SO3_CurBrToW.inverse() * SO3_LastBrToW;
+                    // assignment
+                    SO3_LastToCur = SO3_DnToBr.inverse() * SO3_LastBrToCurBr * SO3_DnToBr;
+                }
+            }
+
+            // if tracking current frame failed, the rotation-only odometer would re-initialize
+            if (!odometer->GrabFrame(frame, SO3_LastToCur)) {
+                spdlog::warn(
+                    "tracking failed when grab the '{}' image frame of '{}'!!! try to reinitialize",
+                    i, topic);
+                // save the tracking information
+                trackingInfo.push_back(odometer->GetLmTrackInfo());
+                // clear workspace
+                odometer->ResetWorkspace();
+            }
+
+            // we do not want to try to recover the extrinsic rotation too frequent (or has
+            // converged)
+            if (rotConverged || (odometer->GetRotations().size() < 50) ||
+                (odometer->GetRotations().size() % 5 != 0)) {
+                continue;
+            }
+
+            // estimate the extrinsic rotation
+            rotEstimator->EstimateIncrementally(so3Spline, odometer->GetRotations());
+
+            // check solver status
+            if (!rotEstimator->SolveStatus()) {
+                continue;
+            }
+            // assign the latest estimated extrinsic rotation
+            _parMagr->EXTRI.SO3_DnToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
+            rotRecovered = true;
+
+            // the estimation stops once the recent estimates are stable
+            if (!rotEstimator->Stable(Configor::Preference::RotationStabilityCount,
+                                      Configor::Preference::RotationStabilityThd)) {
+                continue;
+            }
+            rotConverged = true;
+
+            /**
+             * once the extrinsic rotation is converged, if time offset is also required, we
+             * continue to recover it and refine extrineic rotation
+             */
+            if (Configor::Prior::OptTemporalParams) {
+                refineHandEyeAlignment({odometer->GetRotations()});
+            }
+            // rotations are not required anymore, while features are still tracked
+            odometer->KeepRotationSequence(false);
+
+            if (visualize) {
+                _viewer->UpdateSensorViewer();
+            }
+        }
+        bar->Finish();
+
+        // the sequence ends before the estimates are stable, the latest estimate is used
+        if (rotRecovered && !rotConverged && Configor::Prior::OptTemporalParams) {
+            refineHandEyeAlignment({odometer->GetRotations()});
+        }
+
+        // add tracking info
+        trackingInfo.push_back(odometer->GetLmTrackInfo());
+    }
+
+    /**
+     * after all images are grabbed, if the extrinsic rotation is not recovered (use min
+     * eigen value to check solve results), stop this program
+     */
+    if (!rotRecovered) {
+        throw Status(Status::ERROR,
+                     "initialize rotation 'SO3_DnToBr' of '{}' failed, this may be related to "
+                     "insufficiently excited motion or bad images.",
+                     topic);
+    }
+    return trackingInfo;
+}
 }  // namespace ns_ikalibr
\ No newline at end of file
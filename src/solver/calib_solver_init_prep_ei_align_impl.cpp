@@ -33,7 +33,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "solver/calib_solver.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "spdlog/spdlog.h"
 #include "calib/calib_data_manager.h"
 #include "calib/calib_param_manager.h"
@@ -42,6 +42,11 @@
 #include "core/feature_tracking.h"
 #include "core/event_trace_sac.h"
 #include "calib/estimator.h"
+#include "config/configor.h"
+#include "core/haste_data_io.h"
+#include "mutex"
+#include "atomic"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -49,6 +54,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 void CalibSolver::InitPrepEventInertialAlign() const {
+    StageProfiler::Scope stageScope("InitPrepEventInertialAlign");
     throw Status(
         Status::WARNING,
         "Although point-based optical flow event-inertial calibration has been developed "
@@ -104,14 +110,12 @@ void CalibSolver::InitPrepEventInertialAlign() const {
             auto tracking = HASTEDataIO::TryLoadHASTEResultsFromBinary(
                 *eventsInfo, intri, _dataMagr->GetRawStartTimestamp());
             if (tracking != std::nullopt) {
-                auto bar = std::make_shared<tqdm>();
-                int barIndex = 0;
                 spdlog::info("rep-process loaded event tracking by haste for '{}'...", topic);
-                for (auto iter = tracking->begin(); iter != tracking->end(); ++iter) {
-                    bar->progress(barIndex++, static_cast<int>(tracking->size()));
-                    auto &[index, batch] = *iter;
+                // batches out of the valid time range are dropped first
+                std::vector<std::pair<const int, FeatureVecMap> *> batches;
+                for (auto iter = tracking->begin(); iter != tracking->end();) {
                     // aligned time (start and end)
-                    const auto &batchInfo = eventsInfo->batches.at(index);
+                    const auto &batchInfo = eventsInfo->batches.at(iter->first);
                     const auto &batchSTime = batchInfo.start_time + eventsInfo->raw_start_time -
                                              _dataMagr->GetRawStartTimestamp();
                     const auto &batchETime = batchInfo.end_time + eventsInfo->raw_start_time -
@@ -120,28 +124,62 @@ void CalibSolver::InitPrepEventInertialAlign() const {
                     if ((batchSTime < st && batchETime < st) ||
                         (batchSTime > et && batchETime > et)) {
                         iter = tracking->erase(iter);
-                        continue;
+                    } else {
+                        batches.push_back(&*iter);
+                        ++iter;
                     }
+                }
 
+                /**
+                 * batches are filtered in parallel. The viewer is fed with the latest filtered
+                 * batch at a limited rate by whichever thread is free to draw, thus no thread
+                 * would sleep or wait for drawing
+                 */
+                constexpr auto VIEWER_FEED_INTERVAL = std::chrono::milliseconds(50);
+                const int batchCount = static_cast<int>(batches.size());
+                const double rawStartTime = _dataMagr->GetRawStartTimestamp();
+                std::mutex viewerMutex;
+                auto lastFeedTime = std::chrono::steady_clock::now() - VIEWER_FEED_INTERVAL;
+                auto bar = ProgressStage::Create(
+                    fmt::format("filter event batches '{}'", topic), batchCount);
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(batchCount, batches, eventsInfo, rawStartTime, intri, viewerMutex,     \
+                             lastFeedTime, bar, VIEWER_FEED_INTERVAL,                            \
+                             TRACKING_LEN_PERCENT_THD, TRACKING_FIT_SAC_THD,                     \
+                             TRACKING_AGE_PERCENT_THD, TRACKING_FREQ_PERCENT_THD)
+                for (int i = 0; i < batchCount; ++i) {
+                    auto &[index, batch] = *batches.at(i);
                     // const auto oldSize = batch.size();
-                    EventTrackingFilter::FilterByTrackingLength(batch, TRACKING_LEN_PERCENT_THD);
-                    EventTrackingFilter::FilterByTraceFittingSAC(batch, TRACKING_FIT_SAC_THD);
-                    EventTrackingFilter::FilterByTrackingAge(batch, TRACKING_AGE_PERCENT_THD);
-                    EventTrackingFilter::FilterByTrackingFreq(batch, TRACKING_FREQ_PERCENT_THD);
+                    EventTrackingFilter::FilterTracking(batch,                        // tracking
+                                                        TRACKING_LEN_PERCENT_THD,     // length
+                                                        TRACKING_FIT_SAC_THD,         // sac
+                                                        TRACKING_AGE_PERCENT_THD,     // age
+                                                        TRACKING_FREQ_PERCENT_THD);  // frequency
                     // spdlog::info(
                     //     "size before filtering: {}, size after filtering: {}, filtered: {}",
                     //     oldSize, batch.size(), oldSize - batch.size());
+                    bar->Step();
 
                     // draw
-                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    std::unique_lock<std::mutex> lock(viewerMutex, std::try_to_lock);
+                    if (!lock.owns_lock() ||
+                        std::chrono::steady_clock::now() - lastFeedTime < VIEWER_FEED_INTERVAL) {
+                        continue;
+                    }
+                    lastFeedTime = std::chrono::steady_clock::now();
+
+                    const auto &batchInfo = eventsInfo->batches.at(index);
+                    const auto batchSTime =
+                        batchInfo.start_time + eventsInfo->raw_start_time - rawStartTime;
+                    const auto batchETime =
+                        batchInfo.end_time + eventsInfo->raw_start_time - rawStartTime;
                     _viewer->ClearViewer(Viewer::VIEW_MAP);
                     _viewer->AddEventFeatTracking(batch, intri, static_cast<float>(batchSTime),
                                                   static_cast<float>(batchETime), Viewer::VIEW_MAP);
-                    // auto iters = _dataMagr->ExtractEventDataPiece(topic, batchSTime, batchETime);
-                    // _viewer->AddEventData(iters.first, iters.second, batchSTime,
-                    // Viewer::VIEW_MAP, 0.01, 20);
+                    // auto span = _dataMagr->ExtractEventDataSpan(topic, batchSTime, batchETime);
+                    // _viewer->AddEventData(span, batchSTime, Viewer::VIEW_MAP, {0.01, 20});
                 }
-                bar->finish();
+                bar->Finish();
                 // save tracking results
                 eventFeatTrackingRes[topic] = *tracking;
                 _viewer->ClearViewer(Viewer::VIEW_MAP);
@@ -204,11 +242,11 @@ void CalibSolver::InitPrepEventInertialAlign() const {
         RotationEstimator::RelRotationSequence relRotations;
         auto rotEstimator = RotationEstimator::Create();
         spdlog::info("perform rotation-only relative rotation estimation for '{}'...", topic);
-        auto bar = std::make_shared<tqdm>();
+        auto bar = ProgressStage::Create(fmt::format("rot-only odometry '{}'", topic));
         const int totalSize = static_cast<int>((et - st) / DISCRETE_TIME_INTERVAL) - 1;
         int barIndex = 0;
         for (double time = st; time < et - DISCRETE_TIME_INTERVAL;) {
-            bar->progress(barIndex++, totalSize);
+            bar->Progress(barIndex++, totalSize);
             const double t1 = time, t2 = time + DISCRETE_TIME_INTERVAL;
             time += DISCRETE_TIME_INTERVAL;
 
@@ -320,7 +358,7 @@ void CalibSolver::InitPrepEventInertialAlign() const {
                     (relRotations.size() % 5 != 0)) {
                     continue;
                 }
-                rotEstimator->Estimate(so3Spline, relRotations);
+                rotEstimator->EstimateIncrementally(so3Spline, relRotations);
                 if (!rotEstimator->SolveStatus()) {
                     continue;
                 }
@@ -400,7 +438,7 @@ void CalibSolver::InitPrepEventInertialAlign() const {
                 // cv::waitKey(0);
             }
         }
-        bar->finish();
+        bar->Finish();
         auto traceVecNewSize = traceVec.size();
         spdlog::info("event trace count before rejection: {}, count after rejection: {}",
                      traceVecOldSize, traceVecNewSize);
@@ -493,11 +531,21 @@ void CalibSolver::InitPrepEventInertialAlign() const {
         const auto &traceVec = _dataMagr->GetVisualOpticalFlowTrace(topic);
         auto &curOpticalFlowInFrame = opticalFlowInFrame[topic];
 
-        for (const auto &trace : traceVec) {
-            auto midCamFrame = trace->GetMidCameraFrame();
+        // traces are sorted by their middle frames, thus correspondences keep their order in the
+        // arena, where the depth parameters of correspondences are organized contiguously
+        auto sortedTraceVec = traceVec;
+        std::stable_sort(sortedTraceVec.begin(), sortedTraceVec.end(),
+                         [](const auto &t1, const auto &t2) {
+                             return t1->GetMidCameraFrame()->GetTimestamp() <
+                                    t2->GetMidCameraFrame()->GetTimestamp();
+                         });
+        std::vector<OpticalFlowCorr::Ptr> corrVec;
+        corrVec.reserve(sortedTraceVec.size());
+
+        for (const auto &trace : sortedTraceVec) {
             // the depth information stored in 'OpticalFlowCorr' is invalid currently
             const auto &corr = trace->CreateEventOpticalFlowCorr();
-            curOpticalFlowInFrame[midCamFrame].emplace_back(corr);
+            corrVec.push_back(corr);
 
     #define VISUALIZE_OPTICAL_FLOW_TRACE 0
     #if VISUALIZE_OPTICAL_FLOW_TRACE
@@ -531,6 +579,11 @@ void CalibSolver::InitPrepEventInertialAlign() const {
     #endif
     #undef VISUALIZE_OPTICAL_FLOW_TRACE
         }
+        corrVec = OpticalFlowCorr::CreateArena(corrVec);
+        for (int i = 0; i < static_cast<int>(corrVec.size()); ++i) {
+            curOpticalFlowInFrame[sortedTraceVec.at(i)->GetMidCameraFrame()].push_back(
+                corrVec.at(i));
+        }
     }
 
     /**
@@ -543,12 +596,12 @@ void CalibSolver::InitPrepEventInertialAlign() const {
         const auto &readout = _parMagr->TEMPORAL.RS_READOUT.at(topic);
         const double TO_EsToBr = _parMagr->TEMPORAL.TO_EsToBr.at(topic);
 
-        auto bar = std::make_shared<tqdm>();
+        auto bar = ProgressStage::Create(fmt::format("velocity directions '{}'", topic));
         const auto &curOpticalFlowInFrame = opticalFlowInFrame.at(topic);
         auto totalSize = static_cast<int>(curOpticalFlowInFrame.size());
         int curIdx = 0;
         for (const auto &[frame, ofVec] : curOpticalFlowInFrame) {
-            bar->progress(curIdx++, totalSize);
+            bar->Progress(curIdx++, totalSize);
             const double timeByBr = frame->GetTimestamp() + TO_EsToBr;
             // at least two measurements are required, here we up the ante
             if (timeByBr < st || timeByBr > et || ofVec.size() < 5) {
@@ -585,7 +638,7 @@ void CalibSolver::InitPrepEventInertialAlign() const {
 
             eventBodyFrameVelDirs[topic].emplace_back(frame->GetTimestamp(), velDir);
         }
-        bar->finish();
+        bar->Finish();
         /**
          * the obtained camera-frame velocities may not time-ordered, thus we sort these quantities
          * based on their timestamps
@@ -701,12 +754,12 @@ void CalibSolver::InitPrepEventInertialAlign() const {
         }
 
         spdlog::info("estimate event-derived linear velocities for '{}'...", topic);
-        auto bar = std::make_shared<tqdm>();
+        auto bar = ProgressStage::Create(fmt::format("event velocities '{}'", topic));
         auto totalSize = static_cast<int>(ofsPerStampList.size());
         int curIdx = 0;
         const double TO_EsToBr = _parMagr->TEMPORAL.TO_EsToBr.at(topic);
         for (auto &[timeByCam, dpvTupleVec] : ofsPerStampList) {
-            bar->progress(curIdx++, totalSize);
+            bar->Progress(curIdx++, totalSize);
             const double timeByBr = timeByCam + TO_EsToBr;
             // at least two measurements are required, here we up the ante
             if (timeByBr < st || timeByBr > et || dpvTupleVec.size() < 5) {
@@ -747,7 +800,7 @@ void CalibSolver::InitPrepEventInertialAlign() const {
 
             eventBodyFrameVelDirs[topic].emplace_back(timeByCam, velDir);
         }
-        bar->finish();
+        bar->Finish();
     }
 #endif
 }
@@ -33,13 +33,14 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "solver/calib_solver.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "spdlog/spdlog.h"
 #include "calib/calib_data_manager.h"
 #include "calib/calib_param_manager.h"
 #include "viewer/viewer.h"
 #include "util/status.hpp"
 #include "calib/estimator.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -47,6 +48,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 void CalibSolver::InitPrepEventInertialAlignLineBased() const {
+    StageProfiler::Scope stageScope("InitPrepEventInertialAlignLineBased");
     if (!Configor::IsEventIntegrated()) {
         return;
     }
@@ -63,9 +65,9 @@ void CalibSolver::InitPrepEventInertialAlignLineBased() const {
         auto saeCreator = ActiveEventSurface::Create(intri, 0.01);
         double lastNfEventTime = eventMes.front()->GetTimestamp();
         auto &nfsCurCam = nfsForEventCams[topic];
-        auto bar = std::make_shared<tqdm>();
+        auto bar = ProgressStage::Create(fmt::format("event normal flows '{}'", topic));
         for (int i = 0; i < static_cast<int>(eventMes.size()); i++) {
-            bar->progress(i, eventMes.size());
+            bar->Progress(i, eventMes.size());
 
             const auto &eventAry = eventMes.at(i);
             saeCreator->GrabEvent(eventAry);
@@ -99,7 +101,7 @@ void CalibSolver::InitPrepEventInertialAlignLineBased() const {
             // _viewer->ClearViewer(Viewer::VIEW_MAP);
             cv::waitKey(1);
         }
-        bar->finish();
+        bar->Finish();
     }
     cv::destroyAllWindows();
 
@@ -116,9 +118,33 @@ void CalibSolver::InitPrepEventInertialAlignLineBased() const {
         // if (Configor::Prior::OptTemporalParams) {
         //     opt |= OptOption::OPT_TO_EsToBr;
         // }
-        for (const auto &nfs : nfsList) {
-            for (const auto &nf : nfs) {
-                estimator->AddEventNormFlowRotConstraint(nf, topic, opt, 1.0);
+        const double binWidth = Configor::Preference::EventNormFlowBinWidth;
+        if (binWidth > 0.0) {
+            // normal flows are grouped into short time bins, each of which shares one factor
+            std::vector<NormFlow::Ptr> nfsInTime;
+            for (const auto &nfs : nfsList) {
+                nfsInTime.insert(nfsInTime.end(), nfs.cbegin(), nfs.cend());
+            }
+            std::sort(nfsInTime.begin(), nfsInTime.end(),
+                      [](const NormFlow::Ptr &a, const NormFlow::Ptr &b) {
+                          return a->timestamp < b->timestamp;
+                      });
+            std::size_t binCount = 0;
+            for (auto sIter = nfsInTime.cbegin(); sIter != nfsInTime.cend();) {
+                const double binEndTime = (*sIter)->timestamp + binWidth;
+                auto eIter = std::find_if(sIter, nfsInTime.cend(), [binEndTime](const auto &nf) {
+                    return nf->timestamp >= binEndTime;
+                });
+                estimator->AddEventNormFlowRotBinConstraint({sIter, eIter}, topic, opt, 1.0);
+                sIter = eIter, ++binCount;
+            }
+            spdlog::info("'{}' normal flows are grouped into '{}' time bins", nfsInTime.size(),
+                         binCount);
+        } else {
+            for (const auto &nfs : nfsList) {
+                for (const auto &nf : nfs) {
+                    estimator->AddEventNormFlowRotConstraint(nf, topic, opt, 1.0);
+                }
             }
         }
         auto sum = estimator->Solve(_ceresOption, this->_priori);
@@ -40,8 +40,10 @@
 #include "core/scan_undistortion.h"
 #include "solver/calib_solver.h"
 #include "spdlog/spdlog.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "viewer/viewer.h"
+#include "viewer/viewer_bridge.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -50,6 +52,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitPrepLiDARInertialAlign() const {
+    StageProfiler::Scope stageScope("InitPrepLiDARInertialAlign");
     if (!Configor::IsLiDARIntegrated()) {
         return;
     }
@@ -65,130 +68,76 @@ void CalibSolver::InitPrepLiDARInertialAlign() const {
                       Configor::Prior::TimeOffsetPadding;
 
     /**
-     * we use the ndt to recover rotations of lidar scans and use them to recovce the extrinsisc
-     * rotation of lidars
+     * the pipelines of LiDARs (rotation initialization, undistortion, and odometer rerun) are
+     * independent of each other, they are performed in parallel, and the threads are split across
+     * them for ndt solving. Entries of the initialization asset are created here, thus each
+     * pipeline only assigns its own ones
      */
-    spdlog::info("LiDARs are integrated, initializing extrinsic rotations of LiDARs...");
+    auto &lidarOdometers = _initAsset->lidarOdometers;
+    auto &undistFramesInScan = _initAsset->undistFramesInScan;
+    std::vector<std::string> topics;
     for (const auto &[topic, data] : _dataMagr->GetLiDARMeasurements()) {
-        spdlog::info("performing ndt odometer for '{}' for extrinsic rotation initialization...",
-                     topic);
-
-        auto lidarOdometer = LiDAROdometer::Create(
-            // the resolution of ndt
-            static_cast<float>(Configor::Prior::NDTLiDAROdometer::Resolution),
-            // the thread count to used
-            Configor::Preference::AvailableThreads());
-
-        auto rotEstimator = RotationEstimator::Create();
-        auto bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-            bar->progress(i, static_cast<int>(data.size()));
-            // just for visualization
-            _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION);
-            _viewer->AddAlignedCloud(data.at(i)->GetScan(), Viewer::VIEW_ASSOCIATION);
-
-            // run the lidar odometer(feed frame to ndt solver)
-            lidarOdometer->FeedFrame(data.at(i));
-
-            // we run rotation solver when frame size is 50, 55, 60, ...
-            if (lidarOdometer->FrameSize() < 50 || lidarOdometer->FrameSize() % 5 != 0) {
-                continue;
-            }
+        topics.push_back(topic);
+        lidarOdometers[topic] = nullptr;
+        undistFramesInScan[topic] = {};
+    }
+    const int topicCount = static_cast<int>(topics.size());
+    // the ndt solving runs in a nested parallel region
+    const Configor::Preference::ThreadSplit split(topicCount);
+    const int pipelineCount = split.Workers();
+    const int ndtThreads = split.ThreadsPerWorker();
+    // the viewer and progress bars are not thread-safe, they are only used in the serial case
+    const bool inSerial = pipelineCount == 1;
+    spdlog::info("initialize '{}' LiDAR(s) using '{}' pipeline(s), each with '{}' ndt thread(s)",
+                 topicCount, pipelineCount, ndtThreads);
 
-            // estimate the rotation
-            rotEstimator->Estimate(so3Spline, lidarOdometer->GetOdomPoseVec());
+    std::vector<std::exception_ptr> exceptions(topicCount, nullptr);
+#pragma omp parallel for num_threads(pipelineCount) schedule(dynamic) default(none) \
+    shared(topicCount, topics, split, ndtThreads, inSerial, exceptions)
+    for (int i = 0; i < topicCount; ++i) {
+        const auto binding = split.EnterWorker();
+        try {
+            InitPrepLiDARPipeline(topics.at(i), ndtThreads, inSerial);
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
+        }
+    }
 
-            // check solver status
-            if (rotEstimator->SolveStatus()) {
-                // update extrinsic rotation from lidar to the reference imu
-                _parMagr->EXTRI.SO3_LkToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
-                // once we solve the rotation successfully, just break
-                bar->finish();
-                break;
-            }
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (const auto &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
         }
-        if (!rotEstimator->SolveStatus()) {
-            throw Status(Status::ERROR,
-                         "initialize rotation 'SO3_LkToBr' failed, this may be related to the "
-                         "'NDTResolution' of lidar odometer.");
-        } else {
-            spdlog::info("extrinsic rotation of '{}' is recovered using '{:06}' frames", topic,
-                         lidarOdometer->GetOdomPoseVec().size());
+    }
+    if (!inSerial) {
+        // update the viewer, add global lidar maps, which are not added in parallel pipelines
+        for (const auto &topic : topics) {
+            _viewer->AddCloud(lidarOdometers.at(topic)->GetMap(), Viewer::VIEW_MAP,
+                              ns_viewer::Entity::GetUniqueColour(), 2.0f);
         }
-        // update viewer: add global map and update sensor spatiotemporal visualization
-        _viewer->AddCloud(lidarOdometer->GetMap(), Viewer::VIEW_MAP,
-                          ns_viewer::Entity::GetUniqueColour(), 2.0f);
         _viewer->UpdateSensorViewer();
     }
-    _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION);
-
-    /**
-     * once the extrinsic rotations are recovered, we use the prior rotations to undistort lidar
-     * scans (rotation-only), these undistorted scans would used again for accurate ndt mapping
-     */
-    auto &lidarOdometers = _initAsset->lidarOdometers;
-    auto &undistFramesInScan = _initAsset->undistFramesInScan;
-    auto undistHelper = ScanUndistortion::Create(_splines, _parMagr);
 
-    for (const auto &[topic, data] : _dataMagr->GetLiDARMeasurements()) {
-        spdlog::info("undistort scans for lidar '{}'...", topic);
-
-        // undistort rotation only using 'UNDIST_SO3' in initialization
-        undistFramesInScan[topic] = undistHelper->UndistortToScan(
-            // raw lidar scans
-            data,
-            // the ros topic
-            topic, ScanUndistortion::Option::UNDIST_SO3);
-
-        spdlog::info("rerun odometer for lidar '{}' using undistorted scans...", topic);
-
-        lidarOdometers[topic] = LiDAROdometer::Create(
-            // resolution of ndt
-            static_cast<float>(Configor::Prior::NDTLiDAROdometer::Resolution),
-            // the thread count for solving
-            Configor::Preference::AvailableThreads());
-
-        const auto &undistFrames = undistFramesInScan.at(topic);
-        auto bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(undistFrames.size()); ++i) {
-            bar->progress(i, static_cast<int>(undistFrames.size()));
-
-            // clear the viewer
-            _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION);
-            _viewer->AddAlignedCloud(data.at(i)->GetScan(), Viewer::VIEW_ASSOCIATION);
-
-            auto curUndistFrame = undistFrames.at(i);
-            // we compute the prior rotation from the estimated rotation spline and extrinsics
-            Eigen::Matrix4d predCurToLast = Eigen::Matrix4d::Identity();
-            if (i == 0) {
-                predCurToLast = Eigen::Matrix4d::Identity();
+    if (!Configor::Prior::OptTemporalParams && !Configor::Preference::RefineHandEyeRotation) {
+        /**
+         * time offsets are not required, extrinsic rotations are re-estimated in closed form using
+         * whole rotation sequences from rerun odometers, which takes milliseconds
+         */
+        spdlog::info("performing closed-form hand eye rotation alignment for LiDARs...");
+        for (const auto &[lidarTopic, odometer] : lidarOdometers) {
+            auto rotEstimator = RotationEstimator::Create();
+            rotEstimator->Estimate(
+                so3Spline, RotationEstimator::RelRotations(
+                               odometer->GetOdomPoseVec(),
+                               _parMagr->TEMPORAL.TO_LkToBr.at(lidarTopic), st, et));
+            if (rotEstimator->SolveStatus()) {
+                _parMagr->EXTRI.SO3_LkToBr.at(lidarTopic) = rotEstimator->GetSO3SensorToSpline();
             } else {
-                auto lastUndistFrame = undistFrames.at(i - 1);
-
-                if (curUndistFrame == nullptr || lastUndistFrame == nullptr) {
-                    continue;
-                }
-
-                auto curLtoRef = this->CurLkToW(curUndistFrame->GetTimestamp(), topic);
-                auto lastLtoRef = this->CurLkToW(lastUndistFrame->GetTimestamp(), topic);
-
-                // if query pose successfully
-                if (curLtoRef && lastLtoRef) {
-                    Sophus::SO3d SO3_CurToLast = lastLtoRef->so3().inverse() * curLtoRef->so3();
-                    // note that the translation has not been initialized
-                    predCurToLast = ns_ctraj::Posed(SO3_CurToLast, Eigen::Vector3d::Zero()).T();
-                } else {
-                    predCurToLast = Eigen::Matrix4d::Identity();
-                }
+                spdlog::warn("closed-form rotation alignment of '{}' failed, keep the initial one",
+                             lidarTopic);
             }
-            lidarOdometers.at(topic)->FeedFrame(curUndistFrame, predCurToLast, i < 100);
         }
-        bar->finish();
-
-        // update the viewer, add global lidar map
-        _viewer->ClearViewer(Viewer::VIEW_ASSOCIATION);
-        _viewer->AddCloud(lidarOdometers.at(topic)->GetMap(), Viewer::VIEW_MAP,
-                          ns_viewer::Entity::GetUniqueColour(), 2.0f);
+        return;
     }
 
     /**
@@ -230,4 +179,166 @@ void CalibSolver::InitPrepLiDARInertialAlign() const {
     auto sum = estimator->Solve(_ceresOption, this->_priori);
     spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
 }
+
+void CalibSolver::InitPrepLiDARPipeline(const std::string &topic,
+                                        int ndtThreads,
+                                        bool visualize) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &data = _dataMagr->GetLiDARMeasurements(topic);
+
+    /**
+     * we use the ndt to recover rotations of lidar scans and use them to recovce the extrinsisc
+     * rotation of lidars
+     */
+    spdlog::info("performing ndt odometer for '{}' for extrinsic rotation initialization...",
+                 topic);
+
+    auto lidarOdometer = LiDAROdometer::Create(
+        // the resolution of ndt
+        static_cast<float>(Configor::Prior::NDTLiDAROdometer::Resolution),
+        // the thread count to used
+        ndtThreads,
+        // the number of key frames in the local map
+        Configor::Prior::NDTLiDAROdometer::LocalMapKeyFrames);
+
+    auto rotEstimator = RotationEstimator::Create();
+    auto bar = ProgressStage::Create(fmt::format("lidar odometry '{}'", topic));
+    for (int i = 0; i < static_cast<int>(data.size()); ++i) {
+        bar->Progress(i, static_cast<int>(data.size()));
+        if (visualize) {
+            // just for visualization (asynchronous, only the latest scan is rendered)
+            _viewerBridge->PublishScan(Viewer::VIEW_ASSOCIATION, data.at(i)->GetScan());
+        }
+
+        // run the lidar odometer(feed frame to ndt solver)
+        lidarOdometer->FeedFrame(data.at(i));
+
+        // we run rotation solver when frame size is 50, 55, 60, ...
+        if (lidarOdometer->FrameSize() < 50 || lidarOdometer->FrameSize() % 5 != 0) {
+            continue;
+        }
+
+        // estimate the rotation
+        rotEstimator->EstimateIncrementally(so3Spline, lidarOdometer->GetOdomPoseVec());
+
+        // check solver status
+        if (rotEstimator->SolveStatus()) {
+            // update extrinsic rotation from lidar to the reference imu
+            _parMagr->EXTRI.SO3_LkToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
+            // once we solve the rotation successfully, just break
+            bar->Finish();
+            break;
+        }
+    }
+    if (!rotEstimator->SolveStatus()) {
+        throw Status(Status::ERROR,
+                     "initialize rotation 'SO3_LkToBr' failed, this may be related to the "
+                     "'NDTResolution' of lidar odometer.");
+    } else {
+        spdlog::info("extrinsic rotation of '{}' is recovered using '{:06}' frames", topic,
+                     lidarOdometer->GetOdomPoseVec().size());
+    }
+    if (visualize) {
+        // update viewer: add global map and update sensor spatiotemporal visualization
+        _viewer->AddCloud(lidarOdometer->GetMap(), Viewer::VIEW_MAP,
+                          ns_viewer::Entity::GetUniqueColour(), 2.0f);
+        _viewer->UpdateSensorViewer();
+        _viewerBridge->DropScans(Viewer::VIEW_ASSOCIATION);
+    }
+
+    /**
+     * once the extrinsic rotations are recovered, we use the prior rotations to undistort lidar
+     * scans (rotation-only), these undistorted scans would used again for accurate ndt mapping
+     */
+    auto undistHelper = ScanUndistortion::Create(_splines, _parMagr);
+
+    spdlog::info("undistort scans for lidar '{}'...", topic);
+
+    // undistort rotation only using 'UNDIST_SO3' in initialization
+    auto &undistFrames = _initAsset->undistFramesInScan.at(topic);
+    undistFrames = undistHelper->UndistortToScan(
+        // raw lidar scans
+        data,
+        // the ros topic
+        topic, ScanUndistortion::Option::UNDIST_SO3);
+
+    spdlog::info("rerun odometer for lidar '{}' using undistorted scans...", topic);
+
+    auto &odometer = _initAsset->lidarOdometers.at(topic);
+    odometer = LiDAROdometer::Create(
+        // resolution of ndt
+        static_cast<float>(Configor::Prior::NDTLiDAROdometer::Resolution),
+        // the thread count for solving
+        ndtThreads,
+        // the number of key frames in the local map
+        Configor::Prior::NDTLiDAROdometer::LocalMapKeyFrames,
+        // states cached for scans in the first run (if any) are reused
+        lidarOdometer->GetRegistration()->Renew());
+
+    /**
+     * the first run covers the head window of scans, its relative poses are reused as priors of the
+     * rerun in this window. Rotations are still predicted from the spline, which is more accurate,
+     * while the translations, which are not initialized yet, come from the first run
+     */
+    const auto &firstRunPoses = lidarOdometer->GetOdomPoseVec();
+    const int warmStartCount = Configor::Prior::NDTLiDAROdometer::WarmStartRerun
+                                   ? static_cast<int>(firstRunPoses.size())
+                                   : 0;
+
+    bar = ProgressStage::Create(fmt::format("undistorted odometry '{}'", topic));
+    for (int i = 0; i < static_cast<int>(undistFrames.size()); ++i) {
+        bar->Progress(i, static_cast<int>(undistFrames.size()));
+        if (visualize) {
+            // clear the viewer
+            // just for visualization (asynchronous, only the latest scan is rendered)
+            _viewerBridge->PublishScan(Viewer::VIEW_ASSOCIATION, data.at(i)->GetScan());
+        }
+
+        auto curUndistFrame = undistFrames.at(i);
+        // we compute the prior rotation from the estimated rotation spline and extrinsics
+        Eigen::Matrix4d predCurToLast = Eigen::Matrix4d::Identity();
+        if (i == 0) {
+            predCurToLast = Eigen::Matrix4d::Identity();
+        } else {
+            auto lastUndistFrame = undistFrames.at(i - 1);
+
+            if (curUndistFrame == nullptr || lastUndistFrame == nullptr) {
+                continue;
+            }
+
+            auto curLtoRef = this->CurLkToW(curUndistFrame->GetTimestamp(), topic);
+            auto lastLtoRef = this->CurLkToW(lastUndistFrame->GetTimestamp(), topic);
+
+            // the relative pose from the first run
+            std::optional<Sophus::SE3d> firstRunCurToLast;
+            if (i < warmStartCount) {
+                firstRunCurToLast =
+                    firstRunPoses.at(i - 1).se3().inverse() * firstRunPoses.at(i).se3();
+            }
+
+            // if query pose successfully
+            if (curLtoRef && lastLtoRef) {
+                Sophus::SO3d SO3_CurToLast = lastLtoRef->so3().inverse() * curLtoRef->so3();
+                // note that the translation has not been initialized
+                Eigen::Vector3d POS_CurInLast = firstRunCurToLast
+                                                    ? firstRunCurToLast->translation()
+                                                    : Eigen::Vector3d::Zero();
+                predCurToLast = ns_ctraj::Posed(SO3_CurToLast, POS_CurInLast).T();
+            } else if (firstRunCurToLast) {
+                predCurToLast = firstRunCurToLast->matrix();
+            } else {
+                predCurToLast = Eigen::Matrix4d::Identity();
+            }
+        }
+        odometer->FeedFrame(curUndistFrame, predCurToLast, i < 100);
+    }
+
+    bar->Finish();
+    if (visualize) {
+        // update the viewer, add global lidar map
+        _viewerBridge->DropScans(Viewer::VIEW_ASSOCIATION);
+        _viewer->AddCloud(odometer->GetMap(), Viewer::VIEW_MAP,
+                          ns_viewer::Entity::GetUniqueColour(), 2.0f);
+    }
+}
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -39,8 +39,9 @@
 #include "core/vision_only_sfm.h"
 #include "opencv2/highgui.hpp"
 #include "solver/calib_solver.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "viewer/viewer.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -48,6 +49,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 void CalibSolver::InitPrepPosCameraInertialAlign() const {
+    StageProfiler::Scope stageScope("InitPrepPosCameraInertialAlign");
     if (!Configor::IsPosCameraIntegrated()) {
         return;
     }
@@ -67,7 +69,7 @@ void CalibSolver::InitPrepPosCameraInertialAlign() const {
      * the rotation-only visual odometry means we only estimate the time-varying rotations of the
      * camera, which would be utilized for extrinsic rotation recovery
      */
-    std::shared_ptr<tqdm> bar;
+    ProgressStage::Ptr bar;
     std::map<std::string, RotOnlyVisualOdometer::Ptr> rotOnlyOdom;
     // how many features to maintain in each image
     constexpr int featNumPerImg = 300;
@@ -87,9 +89,9 @@ void CalibSolver::InitPrepPosCameraInertialAlign() const {
         // sensor-inertial rotation estimator (linear least-squares problem)
         const auto rotEstimator = RotationEstimator::Create();
 
-        bar = std::make_shared<tqdm>();
+        bar = ProgressStage::Create(fmt::format("rot-only odometry '{}'", topic));
         for (int i = 0; i < static_cast<int>(frameVec.size()); ++i) {
-            bar->progress(i, static_cast<int>(frameVec.size()));
+            bar->Progress(i, static_cast<int>(frameVec.size()));
 
             // if tracking current frame failed, the rotation-only odometer would re-initialize
             if (!odometer->GrabFrame(frameVec.at(i))) {
@@ -104,14 +106,14 @@ void CalibSolver::InitPrepPosCameraInertialAlign() const {
             }
 
             // estimate the extrinsic rotation
-            rotEstimator->Estimate(so3Spline, odometer->GetRotations());
+            rotEstimator->EstimateIncrementally(so3Spline, odometer->GetRotations());
 
             // check solver status
             if (rotEstimator->SolveStatus()) {
                 // assign the estimated extrinsic rotation
                 _parMagr->EXTRI.SO3_CmToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
                 // once we solve the rotation successfully, break this for loop
-                bar->finish();
+                bar->Finish();
                 break;
             }
         }
@@ -188,6 +190,22 @@ void CalibSolver::InitPrepPosCameraInertialAlign() const {
             IsRSCamera(topic) ? 2.0 : 1.0,
             // the track length threshold
             Configor::DataStream::CameraTopics.at(topic).TrackLengthMin);
+        if (veta == nullptr && Configor::Preference::InProcessSfM) {
+            /**
+             * perform SfM in process on decoded frames, the rotation priors of frames from the so3
+             * spline and extrinsic rotation are utilized in feature matching and pose solving
+             */
+            spdlog::info("perform in-process SfM for camera '{}'...", topic);
+            auto sfm = VisionOnlySfM::Create(topic, data, _parMagr, so3Spline, _viewer);
+            if (sfm->PreProcess() && sfm->StructureFromMotion()) {
+                veta = sfm->ExtractReconstruction(
+                    IsRSCamera(topic) ? 2.0 : 1.0,
+                    Configor::DataStream::CameraTopics.at(topic).TrackLengthMin);
+            }
+            if (veta == nullptr || veta->views.empty() || veta->structure.empty()) {
+                throw Status(Status::ERROR, "in-process SfM for camera '{}' failed!!!", topic);
+            }
+        }
         if (veta != nullptr) {
             /**
              * the SfM result data is valid fro this camera, we store it in the data manager
@@ -256,39 +274,61 @@ void CalibSolver::InitPrepPosCameraInertialAlign() const {
      * rotation-only hand-eye alignment is that we use the rotations recovered by colmap-derived
      * ones, rather than rotation-only odometer-derived ones.
      */
-    spdlog::info(
-        "perform rotation alignment to refine time offset for each camera using SfM "
-        "results...");
-    auto estimator = Estimator::Create(_splines, _parMagr);
-    auto optOption = OptOption::OPT_SO3_CmToBr;
-    if (Configor::Prior::OptTemporalParams) {
-        optOption |= OptOption::OPT_TO_CmToBr;
-    }
-
-    for (const auto& [camTopic, veta] : _dataMagr->GetSfMData()) {
-        double TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(camTopic);
-        double weight = Configor::DataStream::CameraTopics.at(camTopic).Weight;
-
+    // poses of frames constructed (grabbed) by SfM
+    auto ConstructedFrames = [this](const std::string& camTopic, const auto& veta) {
         const auto& frames = _dataMagr->GetCameraMeasurements(camTopic);
         std::vector<ns_ctraj::Posed> constructedFrames;
         constructedFrames.reserve(frames.size());
-
-        // find constructed frames by SfM
         for (const auto& frame : frames) {
             auto viewIter = veta->views.find(frame->GetId());
             if (viewIter == veta->views.cend()) {
-                // this frame is not constructed (grabbed)
                 continue;
             }
             auto poseIter = veta->poses.find(viewIter->second->poseId);
             if (poseIter == veta->poses.cend()) {
-                // this frame is not constructed (grabbed)
                 continue;
             }
             const auto& pose = poseIter->second;
             constructedFrames.emplace_back(pose.Rotation(), pose.Translation(),
                                            frame->GetTimestamp());
         }
+        return constructedFrames;
+    };
+
+    if (!Configor::Prior::OptTemporalParams && !Configor::Preference::RefineHandEyeRotation) {
+        // time offsets are not required, extrinsic rotations are re-estimated in closed form
+        spdlog::info("perform closed-form rotation alignment for each camera using SfM results...");
+        for (const auto& [camTopic, veta] : _dataMagr->GetSfMData()) {
+            auto rotEstimator = RotationEstimator::Create();
+            const double TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(camTopic);
+            rotEstimator->Estimate(so3Spline, RotationEstimator::RelRotations(
+                                                  ConstructedFrames(camTopic, veta), TO_CmToBr,
+                                                  st, et));
+            if (rotEstimator->SolveStatus()) {
+                _parMagr->EXTRI.SO3_CmToBr.at(camTopic) = rotEstimator->GetSO3SensorToSpline();
+            } else {
+                spdlog::warn("closed-form rotation alignment of '{}' failed, keep the initial one",
+                             camTopic);
+            }
+        }
+        return;
+    }
+
+    spdlog::info(
+        "perform rotation alignment to refine time offset for each camera using SfM "
+        "results...");
+    auto estimator = Estimator::Create(_splines, _parMagr);
+    auto optOption = OptOption::OPT_SO3_CmToBr;
+    if (Configor::Prior::OptTemporalParams) {
+        optOption |= OptOption::OPT_TO_CmToBr;
+    }
+
+    for (const auto& [camTopic, veta] : _dataMagr->GetSfMData()) {
+        double TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(camTopic);
+        double weight = Configor::DataStream::CameraTopics.at(camTopic).Weight;
+
+        // find constructed frames by SfM
+        const auto constructedFrames = ConstructedFrames(camTopic, veta);
 
         for (int i = 0; i < static_cast<int>(constructedFrames.size()) - 1; ++i) {
             const auto& sPose = constructedFrames.at(i);
@@ -32,7 +32,11 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "calib/calib_data_manager.h"
+#include "core/radar_velocity_sac.h"
 #include "solver/calib_solver.h"
+#include "spdlog/spdlog.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -41,10 +45,48 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitPrepRadarInertialAlign() {
+    StageProfiler::Scope stageScope("InitPrepRadarInertialAlign");
     if (!Configor::IsRadarIntegrated()) {
         return;
     }
-    // There is no need to prepare for radar-inertial alignment
+    // the ransac thresholds used in the rough and refined radar-inertial alignment
+    constexpr double ROUGH_RANSAC_THD = 0.05;
+    const double RANSAC_THD = Configor::Prior::LossForRadarDopplerFactor;
+
+    /**
+     * radar velocities are estimated from static targets of each array here in parallel, which
+     * are reused by factors of the rough and refined radar-inertial alignment, rather than
+     * re-estimated by each factor (each array is involved in multiple factors)
+     */
+    for (const auto &[radarTopic, radarMes] : _dataMagr->GetRadarMeasurements()) {
+        spdlog::info("estimate radar velocities from static targets for '{}'...", radarTopic);
+        auto &roughVels = _initAsset->radarRoughBodyFrameVels[radarTopic];
+        auto &vels = _initAsset->radarBodyFrameVels[radarTopic];
+        roughVels.assign(radarMes.size(), Eigen::Vector3d::Zero());
+        vels.assign(radarMes.size(), Eigen::Vector3d::Zero());
+
+#pragma omp parallel for num_threads(Configor::Preference::AvailableThreads()) schedule(dynamic) \
+    default(none) shared(radarMes, roughVels, vels, ROUGH_RANSAC_THD, RANSAC_THD)
+        for (int i = 0; i < static_cast<int>(radarMes.size()); ++i) {
+            const auto &ary = radarMes.at(i);
+            // to estimate the radar velocity, the minim targets number required is 3
+            if (ary->GetTargets().size() < 3) {
+                continue;
+            }
+            // the structure-of-arrays targets are shared by the two estimations
+            RadarVelocitySac sac(ary);
+            for (auto [thd, vel] : {std::pair{ROUGH_RANSAC_THD, &roughVels.at(i)},
+                                    std::pair{RANSAC_THD, &vels.at(i)}}) {
+                if (auto res = sac.Estimate(thd); res != std::nullopt) {
+                    *vel = *res;
+                } else {
+                    spdlog::warn(
+                        "compute velocity using RANSAC failed, try to use all targets to fit...");
+                    *vel = ary->RadarVelocityFromStaticTargetArray();
+                }
+            }
+        }
+    }
 }
 
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -33,7 +33,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "solver/calib_solver.h"
-#include "util/tqdm.h"
+#include "util/progress.h"
 #include "spdlog/spdlog.h"
 #include "calib/calib_data_manager.h"
 #include "calib/calib_param_manager.h"
@@ -45,6 +45,8 @@
 #include "sensor/sensor_model.h"
 #include "factor/data_correspondence.h"
 #include "core/optical_flow_trace.h"
+#include "core/frame_prefetcher.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -52,6 +54,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 void CalibSolver::InitPrepVelCameraInertialAlign() const {
+    StageProfiler::Scope stageScope("InitPrepVelCameraInertialAlign");
     if (!Configor::IsVelCameraIntegrated()) {
         return;
     }
@@ -69,141 +72,23 @@ void CalibSolver::InitPrepVelCameraInertialAlign() const {
     /**
      * the feature tracking is first performed for rotation-only visual odometry.
      * the rotation-only visual odometry means we only estimate the time-varying rotations of the
-     * camera, which would be utilized for extrinsic rotation recovery
+     * camera, which would be utilized for extrinsic rotation recovery. Pipelines of cameras are
+     * independent of each other, thus they run concurrently
      */
     // 'FeatTrackingInfo' is a list for each camera, as fail tracking leads to multiple pieces
     std::map<std::string, std::list<RotOnlyVisualOdometer::FeatTrackingInfo>> trackingInfo;
-    // how many features to maintain in each image
-    constexpr int featNumPerImg = 300;
-    // the min distance between two features (to ensure features are distributed uniformly)
-    constexpr int minDist = 25;
+    std::vector<std::string> topics;
     for (const auto &[topic, _] : Configor::DataStream::VelCameraTopics()) {
-        const auto &frameVec = _dataMagr->GetCameraMeasurements(topic);
-        spdlog::info(
-            "perform rotation-only visual odometer to recover extrinsic rotations for camera "
-            "'{}'...",
-            topic);
-
-        // estimates rotations
-        auto intri = _parMagr->INTRI.Camera.at(topic);
-        auto tracker = LKFeatureTracking::Create(featNumPerImg, minDist, intri);
-        auto odometer = RotOnlyVisualOdometer::Create(tracker, intri);
-
-        // sensor-inertial rotation estimator (linear least-squares problem)
-        auto rotEstimator = RotationEstimator::Create();
-
-        auto bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(frameVec.size()); ++i) {
-            bar->progress(i, static_cast<int>(frameVec.size()));
-
-            /*
-             * we try to compute the prior rotation to accelerate the feature tracking.
-             * only the extrinsic rotation is recovered, we can compute such priori.
-             */
-            std::optional<Sophus::SO3d> SO3_LastToCur = std::nullopt;
-            if (rotEstimator->SolveStatus()) {
-                // such codes should be put out of the for loop, but fore better readability...
-                const auto &SO3_CmToBr = _parMagr->EXTRI.SO3_CmToBr.at(topic);
-                const auto &TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(topic);
-
-                double lastTimeByBr = frameVec.at(i - 1)->GetTimestamp() + TO_CmToBr;
-                double curTimeByBr = frameVec.at(i)->GetTimestamp() + TO_CmToBr;
-                if (so3Spline.TimeStampInRange(lastTimeByBr) &&
-                    so3Spline.TimeStampInRange(curTimeByBr)) {
-                    // compute rotations at two timestamps
-                    auto SO3_LastBrToW = so3Spline.Evaluate(lastTimeByBr);
-                    auto SO3_CurBrToW = so3Spline.Evaluate(lastTimeByBr);
-                    // compute the relative rotation of the reference imu
-                    auto SO3_LastBrToCurBr = SO3_CurBrToW.inverse() * SO3_LastBrToW;
-                    // assignment
-                    SO3_LastToCur = SO3_CmToBr.inverse() * SO3_LastBrToCurBr * SO3_CmToBr;
-                }
-            }
-
-            // if tracking current frame failed, the rotation-only odometer would re-initialize
-            if (!odometer->GrabFrame(frameVec.at(i), SO3_LastToCur)) {
-                spdlog::warn(
-                    "tracking failed when grab the '{}' image frame!!! try to reinitialize", i);
-                // save the tracking information
-                trackingInfo[topic].push_back(odometer->GetLmTrackInfo());
-                // clear workspace
-                odometer->ResetWorkspace();
-            }
-
-            // we do not want to try to recover the extrinsic rotation too frequent (or has been
-            // recovered)
-            if (rotEstimator->SolveStatus() || (odometer->GetRotations().size() < 50) ||
-                (odometer->GetRotations().size() % 5 != 0)) {
-                continue;
-            }
-
-            // estimate the extrinsic rotation
-            rotEstimator->Estimate(so3Spline, odometer->GetRotations());
-
-            // check solver status
-            if (rotEstimator->SolveStatus()) {
-                // assign the estimated extrinsic rotation
-                _parMagr->EXTRI.SO3_CmToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
-
-                /**
-                 * once the extrinsic rotation is recovered, if time offset is also required, we
-                 * continue to recover it and refine extrineic rotation using
-                 * continuous-time-based alignment
-                 */
-                if (Configor::Prior::OptTemporalParams) {
-                    auto estimator = Estimator::Create(_splines, _parMagr);
-
-                    auto optOption = OptOption::OPT_SO3_CmToBr | OptOption::OPT_TO_CmToBr;
-                    double TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(topic);
-                    double weight = Configor::DataStream::CameraTopics.at(topic).Weight;
-
-                    const auto &rotations = odometer->GetRotations();
-                    for (int j = 0; j < static_cast<int>(rotations.size()) - 1; ++j) {
-                        const auto &sRot = rotations.at(j), eRot = rotations.at(j + 1);
-                        // we throw the head and tail data as the rotations from the fitted SO3
-                        // Spline in that range are poor
-                        if (sRot.first + TO_CmToBr < st || eRot.first + TO_CmToBr > et) {
-                            continue;
-                        }
-
-                        estimator->AddHandEyeRotationAlignmentForCamera(
-                            topic,        // the ros topic
-                            sRot.first,   // the time of start rotation stamped by the camera
-                            eRot.first,   // the time of end rotation stamped by the camera
-                            sRot.second,  // the start rotation
-                            eRot.second,  // the end rotation
-                            optOption,    // the optimization option
-                            weight        // the weight
-                        );
-                    }
-
-                    // we don't want to output the solving information
-                    auto optWithoutOutput = Estimator::DefaultSolverOptions(
-                        Configor::Preference::AvailableThreads(),
-                        false,  // do not output the solving information
-                        Configor::Preference::UseCudaInSolving);
-
-                    estimator->Solve(optWithoutOutput, _priori);
-                }
-
-                _viewer->UpdateSensorViewer();
-            }
-        }
-        bar->finish();
-
-        // add tracking info
-        trackingInfo[topic].push_back(odometer->GetLmTrackInfo());
-
-        /**
-         * after all images are grabbed, if the extrinsic rotation is not recovered (use min
-         * eigen value to check solve results), stop this program
-         */
-        if (!rotEstimator->SolveStatus()) {
-            throw Status(Status::ERROR,
-                         "initialize rotation 'SO3_CmToBr' failed, this may be related to "
-                         "insufficiently excited motion or bad images.");
-        }
+        topics.push_back(topic);
+        // entries are created here, thus each pipeline only assigns its own one
+        trackingInfo[topic] = {};
     }
+    RunTrackingPipelines(topics, [this, &trackingInfo](const std::string &topic,
+                                                       int prefetchDepth, bool visualize) {
+        trackingInfo.at(topic) = InitPrepVelCameraPipeline(topic, prefetchDepth, visualize);
+    });
+    // the viewer is not updated in parallel pipelines
+    _viewer->UpdateSensorViewer();
     _viewer->ClearViewer(Viewer::VIEW_MAP);
     cv::destroyAllWindows();
 
@@ -234,11 +119,21 @@ void CalibSolver::InitPrepVelCameraInertialAlign() const {
                 Configor::DataStream::CameraTopics.at(topic).Type));
         auto &curOpticalFlowInFrame = opticalFlowInFrame[topic];
 
-        for (const auto &trace : traceVec) {
-            auto midCamFrame = trace->GetMidCameraFrame();
+        // traces are sorted by their middle frames, thus correspondences keep their order in the
+        // arena, where the depth parameters of correspondences are organized contiguously
+        auto sortedTraceVec = traceVec;
+        std::stable_sort(sortedTraceVec.begin(), sortedTraceVec.end(),
+                         [](const auto &t1, const auto &t2) {
+                             return t1->GetMidCameraFrame()->GetTimestamp() <
+                                    t2->GetMidCameraFrame()->GetTimestamp();
+                         });
+        std::vector<OpticalFlowCorr::Ptr> corrVec;
+        corrVec.reserve(sortedTraceVec.size());
+
+        for (const auto &trace : sortedTraceVec) {
             // the depth information stored in 'OpticalFlowCorr' is invalid currently
             const auto &corr = trace->CreateOpticalFlowCorr(rsExpFactor);
-            curOpticalFlowInFrame[midCamFrame].emplace_back(corr);
+            corrVec.push_back(corr);
 
 #define VISUALIZE_OPTICAL_FLOW_TRACE 0
 #if VISUALIZE_OPTICAL_FLOW_TRACE
@@ -260,6 +155,11 @@ void CalibSolver::InitPrepVelCameraInertialAlign() const {
 #endif
 #undef VISUALIZE_OPTICAL_FLOW_TRACE
         }
+        corrVec = OpticalFlowCorr::CreateArena(corrVec);
+        for (int i = 0; i < static_cast<int>(corrVec.size()); ++i) {
+            curOpticalFlowInFrame[sortedTraceVec.at(i)->GetMidCameraFrame()].push_back(
+                corrVec.at(i));
+        }
     }
 
     /**
@@ -272,12 +172,12 @@ void CalibSolver::InitPrepVelCameraInertialAlign() const {
         const auto &readout = _parMagr->TEMPORAL.RS_READOUT.at(topic);
         const double TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(topic);
 
-        auto bar = std::make_shared<tqdm>();
+        auto bar = ProgressStage::Create(fmt::format("velocity directions '{}'", topic));
         const auto &curOpticalFlowInFrame = opticalFlowInFrame.at(topic);
         auto totalSize = static_cast<int>(curOpticalFlowInFrame.size());
         int curIdx = 0;
         for (const auto &[frame, ofVec] : curOpticalFlowInFrame) {
-            bar->progress(curIdx++, totalSize);
+            bar->Progress(curIdx++, totalSize);
             const double timeByBr = frame->GetTimestamp() + TO_CmToBr;
             // at least two measurements are required, here we up the ante
             if (timeByBr < st || timeByBr > et || ofVec.size() < 5) {
@@ -323,7 +223,7 @@ void CalibSolver::InitPrepVelCameraInertialAlign() const {
 
             velCamBodyFrameVelDirs[topic].emplace_back(frame, velDir);
         }
-        bar->finish();
+        bar->Finish();
         /**
          * the obtained camera-frame velocities may not time-ordered, thus we sort these quantities
          * based on their timestamps
@@ -334,4 +234,230 @@ void CalibSolver::InitPrepVelCameraInertialAlign() const {
         });
     }
 }
+std::list<RotOnlyVisualOdometer::FeatTrackingInfo> CalibSolver::InitPrepVelCameraPipeline(
+    const std::string &topic, int prefetchDepth, bool visualize) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    /**
+     * we throw the head and tail data as the rotations from the fitted SO3 Spline in that range are
+     * poor
+     */
+    const double st = std::max(so3Spline.MinTime(), scaleSpline.MinTime()) +  // the max as start
+                      Configor::Prior::TimeOffsetPadding;
+    const double et = std::min(so3Spline.MaxTime(), scaleSpline.MaxTime()) -  // the min as end
+                      Configor::Prior::TimeOffsetPadding;
+
+    // 'FeatTrackingInfo' is a list, as fail tracking leads to multiple pieces
+    std::list<RotOnlyVisualOdometer::FeatTrackingInfo> trackingInfo;
+    // how many features to maintain in each image
+    constexpr int featNumPerImg = 300;
+    // the min distance between two features (to ensure features are distributed uniformly)
+    constexpr int minDist = 25;
+
+    const auto &frameVec = _dataMagr->GetCameraMeasurements(topic);
+    spdlog::info(
+        "perform rotation-only visual odometer to recover extrinsic rotations for camera '{}'...",
+        topic);
+
+    // estimates rotations
+    auto intri = _parMagr->INTRI.Camera.at(topic);
+
+    // sensor-inertial rotation estimator (linear least-squares problem)
+    auto rotEstimator = RotationEstimator::Create();
+
+    // recover the time offset and refine the extrinsic rotation using continuous-time-based
+    // alignment of the given rotation sequences
+    auto refineHandEyeAlignment =
+        [this, &topic, st, et](const std::vector<RotationEstimator::RotationSequence> &rotSeqs) {
+            // the estimator touches the shared splines and parameters, solve them one by one
+#pragma omp critical(ikalibr_hand_eye_rotation_alignment)
+            {
+                auto estimator = Estimator::Create(_splines, _parMagr);
+
+                auto optOption = OptOption::OPT_SO3_CmToBr | OptOption::OPT_TO_CmToBr;
+                double TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(topic);
+                double weight = Configor::DataStream::CameraTopics.at(topic).Weight;
+
+                for (const auto &rotations : rotSeqs) {
+                    for (int j = 0; j < static_cast<int>(rotations.size()) - 1; ++j) {
+                        const auto &sRot = rotations.at(j), eRot = rotations.at(j + 1);
+                        // we throw the head and tail data as the rotations from the fitted SO3
+                        // Spline in that range are poor
+                        if (sRot.first + TO_CmToBr < st || eRot.first + TO_CmToBr > et) {
+                            continue;
+                        }
+
+                        estimator->AddHandEyeRotationAlignmentForCamera(
+                            topic,        // the ros topic
+                            sRot.first,   // the time of start rotation stamped by the camera
+                            eRot.first,   // the time of end rotation stamped by the camera
+                            sRot.second,  // the start rotation
+                            eRot.second,  // the end rotation
+                            optOption,    // the optimization option
+                            weight        // the weight
+                        );
+                    }
+                }
+
+                // we don't want to output the solving information
+                auto optWithoutOutput =
+                    Estimator::DefaultSolverOptions(Configor::Preference::AvailableThreads(),
+                                                    false,  // do not output the solving information
+                                                    Configor::Preference::UseCudaInSolving);
+
+                estimator->Solve(optWithoutOutput, _priori);
+            }
+        };
+
+    // whether the extrinsic rotation is recovered
+    bool rotRecovered = false;
+    if (const int chunkSize = Configor::Preference::VOChunkFrameCount;
+        chunkSize > 0 && static_cast<int>(frameVec.size()) >= 2 * chunkSize &&
+        Configor::Preference::AvailableThreads() > 1) {
+        /**
+         * long sequences are tracked in overlapping chunks in parallel, and the extrinsic rotation
+         * is recovered using all tracked pieces afterward. Features are tracked without rotation
+         * priors here, as such priors require the extrinsic rotation
+         */
+        spdlog::info("track '{}' frames of '{}' in chunks of '{}' frames...", frameVec.size(),
+                     topic, chunkSize);
+        auto pieces = RotOnlyVisualOdometer::TrackInChunks(
+            frameVec, [&]() { return LKFeatureTracking::Create(featNumPerImg, minDist, intri); },
+            intri, chunkSize, Configor::Preference::VOChunkOverlapFrames);
+
+        std::vector<RotationEstimator::RotationSequence> rotSeqs;
+        RotationEstimator::RelRotationSequence relRotSeq;
+        for (auto &piece : pieces) {
+            const auto &rotations = piece.rotations;
+            for (int j = 0; j < static_cast<int>(rotations.size()) - 1; ++j) {
+                const auto &sRot = rotations.at(j), eRot = rotations.at(j + 1);
+                relRotSeq.emplace_back(sRot.first, eRot.first, sRot.second.inverse() * eRot.second);
+            }
+            rotSeqs.push_back(std::move(piece.rotations));
+            trackingInfo.push_back(std::move(piece.lmTrackInfo));
+        }
+
+        // estimate the extrinsic rotation, the normal matrix is accumulated in a single pass
+        rotEstimator->EstimateIncrementally(so3Spline, relRotSeq);
+
+        rotRecovered = rotEstimator->SolveStatus();
+        if (rotRecovered) {
+            // assign the estimated extrinsic rotation
+            _parMagr->EXTRI.SO3_CmToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
+
+            if (Configor::Prior::OptTemporalParams) {
+                refineHandEyeAlignment(rotSeqs);
+            }
+        }
+    } else {
+        auto tracker = LKFeatureTracking::Create(featNumPerImg, minDist, intri);
+        auto odometer = RotOnlyVisualOdometer::Create(tracker, intri, visualize);
+
+        // the decode stage, images are decoded ahead of the tracking stage
+        auto prefetcher = FramePrefetcher::Create(frameVec, prefetchDepth);
+
+        // whether the estimates of the extrinsic rotation are stable
+        bool rotConverged = false;
+        auto bar = ProgressStage::Create(fmt::format("track features '{}'", topic));
+        for (int i = 0; i < static_cast<int>(frameVec.size()); ++i) {
+            bar->Progress(i, static_cast<int>(frameVec.size()));
+            const auto &frame = prefetcher->Acquire(i);
+
+            /*
+             * we try to compute the prior rotation to accelerate the feature tracking.
+             * only the extrinsic rotation is recovered, we can compute such priori.
+             */
+            std::optional<Sophus::SO3d> SO3_LastToCur = std::nullopt;
+            if (rotRecovered) {
+                // such codes should be put out of the for loop, but fore better readability...
+                const auto &SO3_CmToBr = _parMagr->EXTRI.SO3_CmToBr.at(topic);
+                const auto &TO_CmToBr = _parMagr->TEMPORAL.TO_CmToBr.at(topic);
+
+                double lastTimeByBr = frameVec.at(i - 1)->GetTimestamp() + TO_CmToBr;
+                double curTimeByBr = frame->GetTimestamp() + TO_CmToBr;
+                if (so3Spline.TimeStampInRange(lastTimeByBr) &&
+                    so3Spline.TimeStampInRange(curTimeByBr)) {
+                    // compute rotations at two timestamps
+                    auto SO3_LastBrToW = so3Spline.Evaluate(lastTimeByBr);
+                    auto SO3_CurBrToW = so3Spline.Evaluate(curTimeByBr);
+                    // compute the relative rotation of the reference imu
+                    auto SO3_LastBrToCurBr = SO3_CurBrToW.inverse() * SO3_LastBrToW;
+                    // assignment
+                    SO3_LastToCur = SO3_CmToBr.inverse() * SO3_LastBrToCurBr * SO3_CmToBr;
+                }
+            }
+
+            // if tracking current frame failed, the rotation-only odometer would re-initialize
+            if (!odometer->GrabFrame(frame, SO3_LastToCur)) {
+                spdlog::warn(
+                    "tracking failed when grab the '{}' image frame of '{}'!!! try to reinitialize",
+                    i, topic);
+                // save the tracking information
+                trackingInfo.push_back(odometer->GetLmTrackInfo());
+                // clear workspace
+                odometer->ResetWorkspace();
+            }
+
+            // we do not want to try to recover the extrinsic rotation too frequent (or has
+            // converged)
+            if (rotConverged || (odometer->GetRotations().size() < 50) ||
+                (odometer->GetRotations().size() % 5 != 0)) {
+                continue;
+            }
+
+            // estimate the extrinsic rotation
+            rotEstimator->EstimateIncrementally(so3Spline, odometer->GetRotations());
+
+            // check solver status
+            if (!rotEstimator->SolveStatus()) {
+                continue;
+            }
+            // assign the latest estimated extrinsic rotation
+            _parMagr->EXTRI.SO3_CmToBr.at(topic) = rotEstimator->GetSO3SensorToSpline();
+            rotRecovered = true;
+
+            // the estimation stops once the recent estimates are stable
+            if (!rotEstimator->Stable(Configor::Preference::RotationStabilityCount,
+                                      Configor::Preference::RotationStabilityThd)) {
+                continue;
+            }
+            rotConverged = true;
+
+            /**
+             * once the extrinsic rotation is converged, if time offset is also required, we
+             * continue to recover it and refine extrineic rotation
+             */
+            if (Configor::Prior::OptTemporalParams) {
+                refineHandEyeAlignment({odometer->GetRotations()});
+            }
+            // rotations are not required anymore, while features are still tracked
+            odometer->KeepRotationSequence(false);
+
+            if (visualize) {
+                _viewer->UpdateSensorViewer();
+            }
+        }
+        bar->Finish();
+
+        // the sequence ends before the estimates are stable, the latest estimate is used
+        if (rotRecovered && !rotConverged && Configor::Prior::OptTemporalParams) {
+            refineHandEyeAlignment({odometer->GetRotations()});
+        }
+
+        // add tracking info
+        trackingInfo.push_back(odometer->GetLmTrackInfo());
+    }
+
+    /**
+     * after all images are grabbed, if the extrinsic rotation is not recovered (use min
+     * eigen value to check solve results), stop this program
+     */
+    if (!rotRecovered) {
+        throw Status(Status::ERROR,
+                     "initialize rotation 'SO3_CmToBr' of '{}' failed, this may be related to "
+                     "insufficiently excited motion or bad images.",
+                     topic);
+    }
+    return trackingInfo;
+}
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -35,6 +35,8 @@
 #include "solver/calib_solver_tpl.hpp"
 #include "core/lidar_odometer.h"
 #include "util/utils_tpl.hpp"
+#include "util/stage_profiler.h"
+#include "calib/linear_scale_fitter.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -43,7 +45,9 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitScaleSpline() const {
+    StageProfiler::Scope stageScope("InitScaleSpline");
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
 
     spdlog::info("performing scale spline recovery...");
 
@@ -62,6 +66,27 @@ void CalibSolver::InitScaleSpline() const {
                 TimeDeriv::Deriv<TimeDeriv::LIN_VEL_SPLINE, TimeDeriv::LIN_VEL>();
             optOption |= OptOption::OPT_SO3_SPLINE;
 
+            /**
+             * knots enter velocity and acceleration constraints linearly if the so3 spline is
+             * kept, thus they are fitted in closed form, rather than using ceres jointly
+             */
+            LinearScaleFitter::Ptr fitter;
+            if (Configor::Preference::LinearScaleSplineInit) {
+                fitter = LinearScaleFitter::Create(scaleSpline.MinTime(), scaleSpline.MaxTime(),
+                                                   static_cast<int>(scaleSpline.GetKnots().size()));
+            }
+            auto AddVelocity = [&](double timeByBr, const Eigen::Vector3d &vel, double weight) {
+                if (fitter != nullptr) {
+                    fitter->AddConstraint(timeByBr, VelDeriv, vel, weight);
+                } else {
+                    estimator->AddLinearScaleConstraint<VelDeriv>(
+                        timeByBr,   // time stamped the reference imu
+                        vel,        // the linear velocity
+                        optOption,  // the optimization option
+                        weight);    // the weigh
+                }
+            };
+
             // radar-derived velocities
             for (const auto &[topic, data] : _dataMagr->GetRadarMeasurements()) {
                 const double TO_RjToBr = _parMagr->TEMPORAL.TO_RjToBr.at(topic);
@@ -82,11 +107,7 @@ void CalibSolver::InitScaleSpline() const {
                         SO3_BrToW * SO3_RjToBr * ary->RadarVelocityFromStaticTargetArray() -
                         Sophus::SO3d::hat(ANG_VEL_BrToWInW) * (SO3_BrToW * POS_RjInBr);
 
-                    estimator->AddLinearScaleConstraint<VelDeriv>(
-                        timeByBr,          // time stamped the reference imu
-                        LIN_VEL_BrToWInW,  // the linear velocity
-                        optOption,         // the optimization option
-                        weight);           // the weigh
+                    AddVelocity(timeByBr, LIN_VEL_BrToWInW, weight);
                 }
             }
 
@@ -110,11 +131,7 @@ void CalibSolver::InitScaleSpline() const {
                         SO3_BrToW * SO3_DnToBr * vel -
                         Sophus::SO3d::hat(ANG_VEL_BrToWInW) * (SO3_BrToW * POS_DnInBr);
 
-                    estimator->AddLinearScaleConstraint<VelDeriv>(
-                        timeByBr,          // time stamped the reference imu
-                        LIN_VEL_BrToWInW,  // the linear velocity
-                        optOption,         // the optimization option
-                        weight);           // the weigh
+                    AddVelocity(timeByBr, LIN_VEL_BrToWInW, weight);
                 }
             }
 
@@ -137,11 +154,7 @@ void CalibSolver::InitScaleSpline() const {
                         SO3_BrToW * SO3_CmToBr * vel -
                         Sophus::SO3d::hat(ANG_VEL_BrToWInW) * (SO3_BrToW * POS_CmInBr);
 
-                    estimator->AddLinearScaleConstraint<VelDeriv>(
-                        timeByBr,          // time stamped the reference imu
-                        LIN_VEL_BrToWInW,  // the linear velocity
-                        optOption,         // the optimization option
-                        weight);           // the weigh
+                    AddVelocity(timeByBr, LIN_VEL_BrToWInW, weight);
                 }
             }
 
@@ -164,31 +177,37 @@ void CalibSolver::InitScaleSpline() const {
                         SO3_BrToW * SO3_EsToBr * vel -
                         Sophus::SO3d::hat(ANG_VEL_BrToWInW) * (SO3_BrToW * POS_EsInBr);
 
-                    estimator->AddLinearScaleConstraint<VelDeriv>(
-                        timeByBr,          // time stamped the reference imu
-                        LIN_VEL_BrToWInW,  // the linear velocity
-                        optOption,         // the optimization option
-                        weight);           // the weigh
+                    AddVelocity(timeByBr, LIN_VEL_BrToWInW, weight);
                 }
             }
 
-            // add acceleration factor using inertial measurements only from reference IMU
-            this->AddAcceFactor<TimeDeriv::LIN_VEL_SPLINE>(
-                estimator, Configor::DataStream::ReferIMU, optOption);
-            this->AddGyroFactor(estimator, Configor::DataStream::ReferIMU, optOption);
+            if (fitter != nullptr) {
+                constexpr int AcceDeriv =
+                    TimeDeriv::Deriv<TimeDeriv::LIN_VEL_SPLINE, TimeDeriv::LIN_ACCE>();
+                // accelerations in the world frame, using measurements only from reference IMU
+                AddAcceConstraints(fitter, AcceDeriv);
+                ApplyLinearScaleFit(fitter);
+            } else {
+                // add acceleration factor using inertial measurements only from reference IMU
+                this->AddAcceFactor<TimeDeriv::LIN_VEL_SPLINE>(
+                    estimator, Configor::DataStream::ReferIMU, optOption);
+                this->AddGyroFactor(estimator, Configor::DataStream::ReferIMU, optOption);
+            }
 
             /**
              * if optimize time offsets, we first recover the scale spline, then construct a ls
              * problem to recover time offsets, only for radars
              */
             if (Configor::IsRadarIntegrated() && Configor::Prior::OptTemporalParams) {
-                // we don't want to output the solving information
-                auto solveOpt = Estimator::DefaultSolverOptions(
-                    // the thread count
-                    Configor::Preference::AvailableThreads(),
-                    // do not output information
-                    false, Configor::Preference::UseCudaInSolving);
-                estimator->Solve(solveOpt);
+                if (fitter == nullptr) {
+                    // we don't want to output the solving information
+                    auto solveOpt = Estimator::DefaultSolverOptions(
+                        // the thread count
+                        Configor::Preference::AvailableThreads(),
+                        // do not output information
+                        false, Configor::Preference::UseCudaInSolving);
+                    estimator->Solve(solveOpt);
+                }
 
                 /**
                  * in the new constructed ls problem, we estimate the time offsets of radars
@@ -198,6 +217,9 @@ void CalibSolver::InitScaleSpline() const {
                 for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
                     this->AddRadarFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
                 }
+            } else if (fitter != nullptr) {
+                // the scale spline has been fitted in closed form, nothing to solve
+                return;
             }
 
         } break;
@@ -336,20 +358,34 @@ void CalibSolver::InitScaleSpline() const {
             spdlog::info("fitting rough splines finished.");
 
             estimator = Estimator::Create(_splines, _parMagr);
+            // translations are fitted in closed form, while rotations are still fitted by ceres
+            LinearScaleFitter::Ptr fitter;
+            if (Configor::Preference::LinearScaleSplineInit) {
+                fitter = LinearScaleFitter::Create(scaleSpline.MinTime(), scaleSpline.MaxTime(),
+                                                   static_cast<int>(scaleSpline.GetKnots().size()));
+            }
             for (double t = minTime; t < maxTime;) {
                 estimator->AddSO3Constraint(t,  // the time stamped the reference imu
                                             rSo3Spline.Evaluate(t),  // the rotation
                                             optOption,               // the optimization option
                                             1.0);                    // the weight
-                estimator->AddLinearScaleConstraint<PosDeriv>(
-                    t,                         // the time stamped the reference imu
-                    rScaleSpline.Evaluate(t),  // the translation
-                    optOption,                 // the optimization option
-                    1.0);                      // the weight
+                if (fitter != nullptr) {
+                    fitter->AddConstraint(t, PosDeriv, rScaleSpline.Evaluate(t), 1.0);
+                } else {
+                    estimator->AddLinearScaleConstraint<PosDeriv>(
+                        t,                         // the time stamped the reference imu
+                        rScaleSpline.Evaluate(t),  // the translation
+                        optOption,                 // the optimization option
+                        1.0);                      // the weight
+                }
                 t += 0.01;
             }
-            // add tail factors (constraints) to maintain enough observability
-            estimator->AddLinScaleTailConstraint(optOption, 1.0);
+            if (fitter != nullptr) {
+                ApplyLinearScaleFit(fitter);
+            } else {
+                // add tail factors (constraints) to maintain enough observability
+                estimator->AddLinScaleTailConstraint(optOption, 1.0);
+            }
             estimator->AddSO3TailConstraint(optOption, 1.0);
             // estimator->PrintUninvolvedKnots();
         } break;
@@ -369,4 +405,44 @@ void CalibSolver::InitScaleSpline() const {
         spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
     }
 }
+
+void CalibSolver::AddAcceConstraints(const LinearScaleFitter::Ptr &fitter, int acceDeriv) const {
+    const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &topic = Configor::DataStream::ReferIMU;
+    const double weight = Configor::DataStream::IMUTopics.at(topic).AcceWeight;
+    const auto &intri = _parMagr->INTRI.IMU.at(topic);
+    const auto &SO3_BiToBr = _parMagr->EXTRI.SO3_BiToBr.at(topic);
+    const double TO_BiToBr = _parMagr->TEMPORAL.TO_BiToBr.at(topic);
+
+    for (const auto &frame : _dataMagr->GetIMUMeasurements(topic)) {
+        const double timeByBr = frame->GetTimestamp() + TO_BiToBr;
+        if (!so3Spline.TimeStampInRange(timeByBr)) {
+            continue;
+        }
+        // the lever arm of the reference imu is zero
+        const Eigen::Vector3d LIN_ACCE_BrToBr0InBr0 =
+            so3Spline.Evaluate(timeByBr) * SO3_BiToBr * intri->RemoveForceIntri(frame->GetAcce()) +
+            _parMagr->GRAVITY;
+        fitter->AddConstraint(timeByBr, acceDeriv, LIN_ACCE_BrToBr0InBr0, weight);
+    }
+}
+
+void CalibSolver::ApplyLinearScaleFit(const LinearScaleFitter::Ptr &fitter) const {
+    StageProfiler::Scope stageScope("LinearScaleFit");
+    auto knots = fitter->Solve();
+    if (knots == std::nullopt) {
+        throw Status(Status::CRITICAL,
+                     "closed-form fitting of the scale spline failed, the normal matrix is not "
+                     "positive definite!");
+    }
+    auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    for (int i = 0; i < static_cast<int>(knots->size()); ++i) {
+        scaleSpline.GetKnot(i) = knots->at(i);
+    }
+    StageProfiler::Count("InitScaleSpline/LinearConstraints",
+                         static_cast<double>(fitter->ConstraintCount()));
+    spdlog::info("scale spline with {} knots is fitted in closed form using {} constraints",
+                 knots->size(), fitter->ConstraintCount());
+}
+
 }  // namespace ns_ikalibr
\ No newline at end of file
@@ -39,6 +39,7 @@
 #include "solver/calib_solver.h"
 #include "util/utils_tpl.hpp"
 #include "viewer/viewer.h"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -47,6 +48,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitSensorInertialAlign() const {
+    StageProfiler::Scope stageScope("InitSensorInertialAlign");
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
     /**
@@ -265,6 +267,7 @@ void CalibSolver::InitSensorInertialAlign() const {
         double TO_RjToBr = _parMagr->TEMPORAL.TO_RjToBr.at(radarTopic);
 
         const auto &refIMUFrames = _dataMagr->GetIMUMeasurements(Configor::DataStream::ReferIMU);
+        const auto &roughVels = _initAsset->radarRoughBodyFrameVels.at(radarTopic);
 
         const int ALIGN_STEP =
             std::max(1, int(DESIRED_TIME_INTERVAL * _dataMagr->GetRadarAvgFrequency(radarTopic)));
@@ -308,6 +311,8 @@ void CalibSolver::InitSensorInertialAlign() const {
                 radarTopic,                      // the ros topic of this radar
                 sArray,                          // the start target array
                 eArray,                          // the end target array
+                roughVels.at(i),                 // the start radar velocity
+                roughVels.at(i + ALIGN_STEP),    // the end radar velocity
                 optOption,                       // the optimization option
                 weight);                         // the weight
             ++count;
@@ -462,17 +467,49 @@ void CalibSolver::InitSensorInertialAlign() const {
     // make this problem full rank
     estimator->SetRefIMUParamsConstant();
 
-    auto sum = estimator->Solve(_ceresOption, this->_priori);
+    ceres::Solver::Summary sum;
+    if (Configor::Preference::SchurSensorInertialAlign) {
+        /**
+         * velocities (and scales of velocity directions) are numerous but only coupled within
+         * alignment windows, they are eliminated, and a small system of gravity, extrinsic
+         * translations and visual scales is solved in each iteration
+         */
+        std::set<double *> perWindowPars;
+        for (auto *linVelSeqMap : {&linVelSeqLk, &linVelSeqCm}) {
+            for (auto &[topic, linVelSeq] : *linVelSeqMap) {
+                for (auto &linVel : linVelSeq) {
+                    perWindowPars.insert(linVel.data());
+                }
+            }
+        }
+        for (auto &linVel : linVelSeqBr) {
+            perWindowPars.insert(linVel.data());
+        }
+        for (auto *velScalesMap : {&velCamLinVelScales, &eventLinVelScales}) {
+            for (auto &[topic, velScales] : *velScalesMap) {
+                for (auto &velScale : velScales) {
+                    perWindowPars.insert(&velScale);
+                }
+            }
+        }
+        sum = estimator->SolveBySchurElimination(perWindowPars, _ceresOption, this->_priori);
+    } else {
+        sum = estimator->Solve(_ceresOption, this->_priori);
+    }
     spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
 
     if (Configor::IsRadarIntegrated()) {
+        // the so3 spline is not optimized above, preintegration tables are still valid
+        const auto preintegrations = estimator->GetInertialPreintegrations();
         estimator = Estimator::Create(_splines, _parMagr);
+        estimator->SetInertialPreintegrations(preintegrations);
         // radar-inertial alignment
         for (const auto &[radarTopic, radarMes] : _dataMagr->GetRadarMeasurements()) {
             double weight = Configor::DataStream::RadarTopics.at(radarTopic).Weight;
             double TO_RjToBr = _parMagr->TEMPORAL.TO_RjToBr.at(radarTopic);
 
             const auto &frames = _dataMagr->GetIMUMeasurements(Configor::DataStream::ReferIMU);
+            const auto &vels = _initAsset->radarBodyFrameVels.at(radarTopic);
             spdlog::info("add radar-inertial alignment factors for '{}' and '{}'...", radarTopic,
                          Configor::DataStream::ReferIMU);
 
@@ -498,6 +535,8 @@ void CalibSolver::InitSensorInertialAlign() const {
                     radarTopic,                      // the ros topic of this radar
                     sArray,                          // the start target array
                     eArray,                          // the end target array
+                    vels.at(i),                      // the start radar velocity
+                    vels.at(i + 1),                  // the end radar velocity
                     optOption,                       // the optimization option
                     weight);                         // the weight
             }
@@ -36,6 +36,8 @@
 #include "util/utils_tpl.hpp"
 #include "spdlog/spdlog.h"
 #include "calib/estimator.h"
+#include "util/stage_profiler.h"
+#include "Eigen/Sparse"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -44,6 +46,7 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 namespace ns_ikalibr {
 
 void CalibSolver::InitSO3Spline() const {
+    StageProfiler::Scope stageScope("InitSO3Spline");
     /**
      * this function would initialize the rotation spline, as well as the extrinsic rotations and
      * time offsets between multiple imus, if they are integrated
@@ -72,7 +75,13 @@ void CalibSolver::InitSO3Spline() const {
     auto estimator = Estimator::Create(_splines, _parMagr);
     // we initialize the rotation spline first use only the measurements from the reference imu
     this->AddGyroFactor(estimator, Configor::DataStream::ReferIMU, OptOption::OPT_SO3_SPLINE);
-    auto sum = estimator->Solve(_ceresOption, this->_priori);
+    auto option = _ceresOption;
+    if (Configor::Preference::LinearSO3SplineInit) {
+        // knots from the linear fit are close to the optimum, only a few iterations are required
+        this->FitSO3SplineLinearly();
+        option.max_num_iterations = Configor::Preference::SO3SplinePolishIterations;
+    }
+    auto sum = estimator->Solve(option, this->_priori);
     spdlog::info("here is the summary:\n{}\n", sum.BriefReport());
 
     if (Configor::DataStream::IMUTopics.size() > 1) {
@@ -82,8 +91,16 @@ void CalibSolver::InitSO3Spline() const {
         if (Configor::Prior::OptTemporalParams) {
             optOption |= OptOption::OPT_TO_BiToBr;
         }
+        /**
+         * these few parameters are well constrained by a small fraction of measurements, we use
+         * the most excited ones only, i.e., ones with large angular accelerations
+         */
         for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
-            this->AddGyroFactor(estimator, topic, optOption);
+            const auto mes = SelectInformativeGyroMes(_dataMagr->GetIMUMeasurements(topic),
+                                                      Configor::Preference::MultiIMUInitGyroBudget);
+            spdlog::info("gyroscope measurements of imu '{}' used for initialization: {}/{}",
+                         topic, mes.size(), _dataMagr->GetIMUMeasurements(topic).size());
+            AddGyroFactor(estimator, topic, mes, optOption);
         }
         // make this problem full rank
         estimator->SetRefIMUParamsConstant();
@@ -93,4 +110,70 @@ void CalibSolver::InitSO3Spline() const {
     }
 }
 
+void CalibSolver::FitSO3SplineLinearly() const {
+    constexpr int Order = Configor::Prior::SplineOrder;
+    static_assert(Order == 4, "the linear so3 spline fitting only supports 'Order == 4'");
+
+    auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &topic = Configor::DataStream::ReferIMU;
+    const auto &intri = _parMagr->INTRI.IMU.at(topic);
+    const Sophus::SO3d &SO3_BiToBr = _parMagr->EXTRI.SO3_BiToBr.at(topic);
+    const double TO_BiToBr = _parMagr->TEMPORAL.TO_BiToBr.at(topic);
+
+    const int knotCount = static_cast<int>(so3Spline.GetKnots().size());
+    const double dtInv = static_cast<double>(knotCount - Order + 1) /
+                         (so3Spline.MaxTime() - so3Spline.MinTime());
+
+    /**
+     * for the cumulative parameterization, the rotation in segment i is 'R_i * exp(B_1(u) * d_1) *
+     * exp(B_2(u) * d_2) * exp(B_3(u) * d_3)', where 'd_j = log(R_{i+j-1}^T * R_{i+j})'. Neglecting
+     * the adjoint terms, the angular velocity in body frame is 'sum(dB_j(u) / dt * d_j)', which is
+     * linear and isotropic in increments. Thus the three axes share one banded scalar system,
+     * whose unknowns are increments of the 1-st to the last knots (the first one is identity)
+     */
+    const int incCount = knotCount - 1;
+    std::vector<Eigen::Triplet<double>> triplets;
+    Eigen::MatrixX3d rhs = Eigen::MatrixX3d::Zero(incCount, 3);
+    for (const auto &frame : _dataMagr->GetIMUMeasurements(topic)) {
+        const double t = frame->GetTimestamp() + TO_BiToBr;
+        if (t < so3Spline.MinTime() || t >= so3Spline.MaxTime()) {
+            continue;
+        }
+        const auto [u, idx] = so3Spline.ComputeTIndex(t);
+        // derivatives of cumulative basis functions 'B_1(u)', 'B_2(u)', 'B_3(u)' w.r.t. time
+        const Eigen::Vector3d coeff = dtInv * Eigen::Vector3d((3.0 - 6.0 * u + 3.0 * u * u) / 6.0,
+                                                              (3.0 + 6.0 * u - 6.0 * u * u) / 6.0,
+                                                              0.5 * u * u);
+        const Eigen::Vector3d angVel = SO3_BiToBr * intri->RemoveGyroIntri(frame->GetGyro());
+        // the increment of the (idx + j + 1)-th knot is the (idx + j)-th unknown
+        for (int r = 0; r < Order - 1; ++r) {
+            for (int c = 0; c < Order - 1; ++c) {
+                triplets.emplace_back(idx + r, idx + c, coeff(r) * coeff(c));
+            }
+            rhs.row(idx + r) += coeff(r) * angVel.transpose();
+        }
+    }
+    // a slight damping for increments without measurements (they are solved as zero)
+    for (int i = 0; i < incCount; ++i) {
+        triplets.emplace_back(i, i, 1E-6);
+    }
+    // duplicated triplets are summed up
+    Eigen::SparseMatrix<double> HMat(incCount, incCount);
+    HMat.setFromTriplets(triplets.begin(), triplets.end());
+
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(HMat);
+    if (solver.info() != Eigen::Success) {
+        spdlog::warn("linear fitting of the so3 spline failed, knots are not initialized!");
+        return;
+    }
+    const Eigen::MatrixX3d increments = solver.solve(rhs);
+
+    so3Spline.GetKnot(0) = Sophus::SO3d();
+    for (int i = 1; i < knotCount; ++i) {
+        so3Spline.GetKnot(i) =
+            so3Spline.GetKnot(i - 1) * Sophus::SO3d::exp(increments.row(i - 1).transpose());
+    }
+    spdlog::info("so3 spline with {} knots is fitted linearly", knotCount);
+}
+
 }  // namespace ns_ikalibr
\ No newline at end of file
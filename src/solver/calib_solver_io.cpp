@@ -34,7 +34,11 @@
 
 #include "calib/calib_data_manager.h"
 #include "calib/calib_param_manager.h"
+#include "calib/data_lifetime_planner.h"
 #include "calib/estimator.h"
+#include "calib/flat_param_io.h"
+#include "calib/spline_sampler.h"
+#include "calib/residual_evaluator.h"
 #include "cereal/types/list.hpp"
 #include "cereal/types/utility.hpp"
 #include "factor/data_correspondence.h"
@@ -43,13 +47,18 @@
 #include "solver/calib_solver.h"
 #include "solver/calib_solver_io.h"
 #include "tiny-viewer/object/aligned_cloud.hpp"
-#include "util/tqdm.h"
+#include "util/columnar_writer.h"
+#include "util/streaming_pcd_writer.hpp"
+#include "util/progress.h"
 #include "viewer/visual_ang_vel_drawer.h"
 #include "viewer/visual_colorized_cloud_map.h"
 #include "viewer/visual_gravity.h"
 #include "viewer/visual_lidar_covisibility.h"
 #include "viewer/visual_lin_vel_drawer.h"
 #include "core/visual_distortion.h"
+#include "atomic"
+#include "chrono"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -57,6 +66,67 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
+/**
+ * the rendered images of a frame: images to write (as '{filename, image}'), and the one to display
+ * (empty if nothing to display)
+ */
+struct RenderedFrame {
+    std::vector<std::pair<std::string, cv::Mat>> images;
+    cv::Mat display;
+};
+
+/**
+ * render frames '[0, count)' with the stride 'Configor::Preference::DiagnosticFrameStride' and
+ * write their images. Frames are independent, thus are rendered and encoded in parallel chunks
+ * (bounded by the available threads), the last frame of each chunk is displayed in the calling
+ * thread, as the highgui is not thread-safe
+ */
+static void RenderFrames(int count,
+                         const std::string &label,
+                         const std::string &window,
+                         const std::function<RenderedFrame(int)> &render) {
+    std::vector<int> indices;
+    for (int i = 0; i < count; i += std::max(Configor::Preference::DiagnosticFrameStride, 1)) {
+        indices.push_back(i);
+    }
+    const int threads = Configor::Preference::AvailableThreads();
+    const int chunkSize = 4 * threads, total = static_cast<int>(indices.size());
+    auto bar = ProgressStage::Create(label, total);
+    for (int begin = 0; begin < total; begin += chunkSize) {
+        const int end = std::min(begin + chunkSize, total);
+        std::vector<cv::Mat> displays(end - begin);
+        std::vector<std::exception_ptr> exceptions(end - begin, nullptr);
+#pragma omp parallel for num_threads(threads) schedule(dynamic) default(none) \
+    shared(begin, end, indices, render, displays, exceptions, bar)
+        for (int i = begin; i < end; ++i) {
+            try {
+                auto rendered = render(indices.at(i));
+                for (const auto &[filename, image] : rendered.images) {
+                    cv::imwrite(filename, image);
+                }
+                displays.at(i - begin) = rendered.display;
+            } catch (...) {
+                exceptions.at(i - begin) = std::current_exception();
+            }
+            bar->Step();
+        }
+        // exceptions can not be thrown out of the parallel region, rethrow them here
+        for (const auto &exception : exceptions) {
+            if (exception != nullptr) {
+                std::rethrow_exception(exception);
+            }
+        }
+        for (auto iter = displays.crbegin(); iter != displays.crend(); ++iter) {
+            if (!iter->empty()) {
+                cv::imshow(window, *iter);
+                cv::waitKey(1);
+                break;
+            }
+        }
+    }
+    bar->Finish();
+}
+
 CalibSolverIO::CalibSolverIO(CalibSolver::Ptr solver)
     : _solver(std::move(solver)) {
     if (!_solver->_solveFinished) {
@@ -69,56 +139,100 @@ CalibSolverIO::Ptr CalibSolverIO::Create(const CalibSolver::Ptr &solver) {
 }
 
 void CalibSolverIO::SaveByProductsToDisk() const {
-    if (IsOptionWith(OutputOption::LiDARMaps, Configor::Preference::Outputs)) {
-        this->SaveLiDARMaps();
-    }
-
-    if (IsOptionWith(OutputOption::VisualMaps, Configor::Preference::Outputs)) {
-        this->SaveVisualMaps();
-    }
-
-    if (IsOptionWith(OutputOption::RadarMaps, Configor::Preference::Outputs)) {
-        this->SaveRadarMaps();
-    }
-
-    if (IsOptionWith(OutputOption::BSplines, Configor::Preference::Outputs)) {
-        this->SaveBSplines();
-    }
-
-    if (IsOptionWith(OutputOption::HessianMat, Configor::Preference::Outputs)) {
-        this->SaveHessianMatrix();
-    }
-
-    if (IsOptionWith(OutputOption::AlignedInertialMes, Configor::Preference::Outputs)) {
-        this->SaveAlignedInertialMes();
-    }
-
-    if (IsOptionWith(OutputOption::VisualReprojErrors, Configor::Preference::Outputs)) {
-        this->SaveVisualReprojectionError();
-    }
-
-    if (IsOptionWith(OutputOption::RadarDopplerErrors, Configor::Preference::Outputs)) {
-        this->SaveRadarDopplerError();
-    }
-
-    if (IsOptionWith(OutputOption::VisualOpticalFlowErrors, Configor::Preference::Outputs)) {
-        this->SaveVisualOpticalFlowError();
-    }
+    StageProfiler::Scope stageScope("SaveByProductsToDisk");
+    auto scope = _solver->GetContext()->Activate();
+    struct ByProduct {
+        std::string desc;
+        OutputOption option;
+        std::function<void()> save;
+        // by-products displayed by the highgui, which is not thread-safe
+        bool displayed;
+    };
+    const std::vector<ByProduct> byProducts = {
+        {"lidar maps", OutputOption::LiDARMaps, [this] { SaveLiDARMaps(); }, false},
+        {"visual maps", OutputOption::VisualMaps, [this] { SaveVisualMaps(); }, false},
+        {"radar maps", OutputOption::RadarMaps, [this] { SaveRadarMaps(); }, false},
+        {"splines", OutputOption::BSplines, [this] { SaveBSplines(); }, false},
+        {"hessian matrix", OutputOption::HessianMat, [this] { SaveHessianMatrix(); }, false},
+        {"aligned inertial measurements", OutputOption::AlignedInertialMes,
+         [this] { SaveAlignedInertialMes(); }, false},
+        {"visual reprojection errors", OutputOption::VisualReprojErrors,
+         [this] { SaveVisualReprojectionError(); }, false},
+        {"radar doppler errors", OutputOption::RadarDopplerErrors,
+         [this] { SaveRadarDopplerError(); }, false},
+        {"visual optical flow errors", OutputOption::VisualOpticalFlowErrors,
+         [this] { SaveVisualOpticalFlowError(); }, false},
+        {"lidar point-to-surfel errors", OutputOption::LiDARPointToSurfelErrors,
+         [this] { SaveLiDARPointToSurfelError(); }, false},
+        {"visual kinematics", OutputOption::VisualKinematics, [this] { SaveVisualKinematics(); },
+         true},
+        {"visual-lidar covisibility", OutputOption::VisualLiDARCovisibility,
+         [this] { VerifyVisualLiDARConsistency(); }, true},
+        {"colorized lidar map", OutputOption::ColorizedLiDARMap,
+         [this] { SaveVisualColorizedMap(); }, false},
+    };
 
-    if (IsOptionWith(OutputOption::LiDARPointToSurfelErrors, Configor::Preference::Outputs)) {
-        this->SaveLiDARPointToSurfelError();
+    /**
+     * by-products are independent, and are output concurrently (bounded by the io concurrency),
+     * the displayed ones are grouped into a single task, and output in order
+     */
+    std::vector<std::vector<const ByProduct *>> tasks;
+    std::vector<const ByProduct *> displayed;
+    int byProductCount = 0;
+    for (const auto &byProduct : byProducts) {
+        if (!IsOptionWith(byProduct.option, Configor::Preference::Outputs)) {
+            continue;
+        }
+        ++byProductCount;
+        if (byProduct.displayed) {
+            displayed.push_back(&byProduct);
+        } else {
+            tasks.push_back({&byProduct});
+        }
     }
-
-    if (IsOptionWith(OutputOption::VisualKinematics, Configor::Preference::Outputs)) {
-        this->SaveVisualKinematics();
+    if (!displayed.empty()) {
+        tasks.push_back(displayed);
+    }
+    const int taskCount = static_cast<int>(tasks.size());
+    const Configor::Preference::ThreadSplit split(
+        std::min(taskCount, Configor::Preference::ByProductOutputConcurrency));
+    const int workerCount = split.Workers();
+    if (workerCount > 1) {
+        spdlog::info("output '{}' by-product(s) using '{}' worker(s), each with '{}' thread(s)",
+                     byProductCount, workerCount, split.ThreadsPerWorker());
+    }
+
+    std::atomic<int> finishedCount = 0;
+    std::vector<std::exception_ptr> exceptions(taskCount, nullptr);
+#pragma omp parallel for num_threads(workerCount) schedule(dynamic) default(none) \
+    shared(taskCount, tasks, split, exceptions, finishedCount, byProductCount)
+    for (int i = 0; i < taskCount; ++i) {
+        const auto binding = split.EnterWorker();
+        for (const auto &byProduct : tasks.at(i)) {
+            try {
+                const auto start = std::chrono::steady_clock::now();
+                byProduct->save();
+                const std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+                // stream the completion status
+                spdlog::info("by-product '{}' is saved in '{:.3f}' (s), finished: '{}/{}'",
+                             byProduct->desc, cost.count(), ++finishedCount, byProductCount);
+            } catch (...) {
+                spdlog::warn("output by-product '{}' failed!", byProduct->desc);
+                exceptions.at(i) = std::current_exception();
+                break;
+            }
+        }
     }
 
-    if (IsOptionWith(OutputOption::VisualLiDARCovisibility, Configor::Preference::Outputs)) {
-        this->VerifyVisualLiDARConsistency();
+    if (_solver->_lifetimePlanner != nullptr) {
+        _solver->_lifetimePlanner->OnStageFinished(DataLifetimePlanner::Stage::OUTPUT);
     }
 
-    if (IsOptionWith(OutputOption::ColorizedLiDARMap, Configor::Preference::Outputs)) {
-        this->SaveVisualColorizedMap();
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (int i = 0; i < taskCount; ++i) {
+        if (exceptions.at(i) != nullptr) {
+            std::rethrow_exception(exceptions.at(i));
+        }
     }
 }
 
@@ -137,21 +251,24 @@ void CalibSolverIO::SaveBSplines(int hz) const {
         const double st = std::max(so3Spline.MinTime(), scaleSpline.MinTime());
         const double et = std::min(so3Spline.MaxTime(), scaleSpline.MaxTime());
         const double dt = 1.0 / hz;
+        // samples are evaluated in parallel chunks
+        const auto samples = SplineSampler::Evaluate(
+            _solver->_splines, SplineSampler::UniformTimes(st, et, dt), 0, false);
         // pose container
         Eigen::aligned_vector<ns_ctraj::Posed> poseSeq;
-        poseSeq.reserve(static_cast<std::size_t>((et - st) / dt));
-
-        for (double t = st; t < et;) {
-            if (_solver->_splines->TimeInRange(t, so3Spline) &&
-                _solver->_splines->TimeInRange(t, scaleSpline)) {
-                Sophus::SO3d curSO3_BrToBr0 = so3Spline.Evaluate(t);
-                Eigen::Vector3d linAcce_BrToBr0InBr0 = scaleSpline.Evaluate(t);
-                poseSeq.emplace_back(curSO3_BrToBr0, linAcce_BrToBr0InBr0, t);
+        poseSeq.reserve(samples.size());
+        for (const auto &sample : samples) {
+            if (sample.valid) {
+                poseSeq.emplace_back(sample.so3, sample.scale, sample.time);
             }
-            t += dt;
         }
-        auto filename = saveDir + "/samples" + Configor::GetFormatExtension();
-        SavePoseSequence(poseSeq, filename, Configor::Preference::OutputDataFormat);
+        if (Configor::IsColumnarOutput()) {
+            auto filename = saveDir + "/samples" + Configor::GetColumnarExtension();
+            SavePoseSequenceColumnar(poseSeq, filename);
+        } else {
+            auto filename = saveDir + "/samples" + Configor::GetFormatExtension();
+            SavePoseSequence(poseSeq, filename, Configor::Preference::OutputDataFormat);
+        }
     }
     {
         // control points
@@ -160,6 +277,8 @@ void CalibSolverIO::SaveBSplines(int hz) const {
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
         SerializeByOutputArchiveVariant(ar, Configor::Preference::OutputDataFormat,
                                         cereal::make_nvp("splines", *_solver->_splines));
+        // the flat copy of control points, which is fast to load when warm-starting
+        FlatParamIO::SaveSplines(_solver->_splines, saveDir + "/knots" + FlatParamIO::EXTENSION);
     }
     spdlog::info("saving splines finished!");
 }
@@ -267,6 +386,10 @@ void CalibSolverIO::SaveHessianMatrix() const {
     // gravity
     InvolveParameter(_solver->_parMagr->GRAVITY.data(), "GRAVITY");
 
+    // parameters (except knots) that are kept in the marginal hessian matrix
+    const auto keptParAddress = parAddress;
+    const auto keptParOrderSize = parOrderSize;
+
     // control points
     auto &so3Spline = _solver->_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     auto &scaleSpline = _solver->_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
@@ -286,6 +409,34 @@ void CalibSolverIO::SaveHessianMatrix() const {
         ar, Configor::Preference::OutputDataFormat, cereal::make_nvp("row", hessianMat.rows()),
         cereal::make_nvp("col", hessianMat.cols()), cereal::make_nvp("hessian", hessianMat),
         cereal::make_nvp("par_order_size", parOrderSize));
+
+    // the marginal hessian matrix of parameters, where all knots are marginalized
+    std::vector<double *> knotAddress;
+    for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+        if (auto address = so3Spline.GetKnot(i).data(); estimator->HasParameterBlock(address)) {
+            knotAddress.push_back(address);
+        }
+    }
+    for (int i = 0; i < static_cast<int>(scaleSpline.GetKnots().size()); ++i) {
+        if (auto address = scaleSpline.GetKnot(i).data(); estimator->HasParameterBlock(address)) {
+            knotAddress.push_back(address);
+        }
+    }
+    try {
+        auto marginalMat = estimator->GetMarginalHessianMatrix(
+            keptParAddress, knotAddress, Configor::Preference::AvailableThreads());
+        filename = saveDir + "/marginal_hessian" + Configor::GetFormatExtension();
+        std::ofstream marginalFile(filename);
+        auto marginalAr =
+            GetOutputArchiveVariant(marginalFile, Configor::Preference::OutputDataFormat);
+        SerializeByOutputArchiveVariant(
+            marginalAr, Configor::Preference::OutputDataFormat,
+            cereal::make_nvp("row", marginalMat.rows()),
+            cereal::make_nvp("col", marginalMat.cols()), cereal::make_nvp("hessian", marginalMat),
+            cereal::make_nvp("par_order_size", keptParOrderSize));
+    } catch (const IKalibrStatus &status) {
+        spdlog::warn("the marginal hessian matrix is not saved: {}", status.what);
+    }
     spdlog::info("saving hessian matrix finished!");
 }
 
@@ -307,7 +458,6 @@ void CalibSolverIO::VerifyVisualLiDARConsistency() const {
 
     auto covisibility = VisualLiDARCovisibility::Create(_solver->_backup->lidarMap);
     // for cameras
-    std::shared_ptr<tqdm> bar;
     for (const auto &[topic, _] : Configor::DataStream::CameraTopics) {
         const auto &data = _solver->_dataMagr->GetCameraMeasurements(topic);
         spdlog::info("verify consistency between LiDAR and camera '{}'...", topic);
@@ -319,41 +469,44 @@ void CalibSolverIO::VerifyVisualLiDARConsistency() const {
         }
 
         const auto &intri = _solver->_parMagr->INTRI.Camera.at(topic);
-        auto undistoMapper = VisualUndistortionMap::Create(intri);
-        std::vector<std::pair<ns_veta::IndexT, Sophus::SE3d>> poseVec;
-        poseVec.reserve(data.size());
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-            bar->progress(i, static_cast<int>(data.size()));
-
+        auto undistoMapper = VisualUndistortionMap::Obtain(intri);
+        // poses of frames, which are organized in order once all frames are rendered
+        std::vector<std::optional<Sophus::SE3d>> poses(data.size());
+        // structured bindings can not be captured by lambdas in c++17
+        const std::string &curTopic = topic;
+        auto render = [&](int i) {
             const auto &frame = data.at(i);
-            auto pose = _solver->CurCmToW(frame->GetTimestamp(), topic);
+            auto pose = _solver->CurCmToW(frame->GetTimestamp(), curTopic);
             if (pose == std::nullopt) {
-                continue;
+                return RenderedFrame();
             }
-
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            // 32-bit float images should be saved as tiff-format files
-            auto filenameDepth = subSaveDir + '/' + std::to_string(frame->GetId()) + "-d.tiff";
-            auto filenameColor = subSaveDir + '/' + std::to_string(frame->GetId()) + "-c.jpg";
+            poses.at(i) = pose;
+            const std::string prefix = subSaveDir + '/' + std::to_string(frame->GetId());
 
             // undistorted gray image
-            cv::Mat undistImgColor, res;
-            undistImgColor = undistoMapper->RemoveDistortion(frame->GetColorImage());
+            cv::Mat undistImgColor = undistoMapper->RemoveDistortion(frame->GetColorImage());
 
             // depth image
             auto [depthImg, colorImg] = covisibility->CreateCovisibility(*pose, intri);
-            cv::imwrite(filename, undistImgColor);
-            cv::imwrite(filenameDepth, depthImg);
-            cv::imwrite(filenameColor, colorImg);
-            poseVec.emplace_back(frame->GetId(), *pose);
 
             // connect
-            cv::hconcat(undistImgColor, colorImg, res);
-            cv::imshow("Covisibility Image", res);
-            cv::waitKey(1);
+            RenderedFrame rendered;
+            cv::hconcat(undistImgColor, colorImg, rendered.display);
+            // 32-bit float images should be saved as tiff-format files
+            rendered.images = {{prefix + ".jpg", undistImgColor},
+                               {prefix + "-d.tiff", depthImg},
+                               {prefix + "-c.jpg", colorImg}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(data.size()), fmt::format("covisibility '{}'", topic),
+                     "Covisibility Image", render);
+        std::vector<std::pair<ns_veta::IndexT, Sophus::SE3d>> poseVec;
+        poseVec.reserve(data.size());
+        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
+            if (poses.at(i) != std::nullopt) {
+                poseVec.emplace_back(data.at(i)->GetId(), *poses.at(i));
+            }
         }
-        bar->finish();
         // save pose vector
         auto filename = subSaveDir + "/pose" + ns_ikalibr::Configor::GetFormatExtension();
         std::ofstream file(filename, std::ios::out);
@@ -379,43 +532,46 @@ void CalibSolverIO::VerifyVisualLiDARConsistency() const {
         }
 
         const auto &intri = _solver->_parMagr->INTRI.RGBD.at(topic);
-        auto undistoMapper = VisualUndistortionMap::Create(intri->intri);
-        std::vector<std::pair<ns_veta::IndexT, Sophus::SE3d>> poseVec;
-        poseVec.reserve(data.size());
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-            bar->progress(i, static_cast<int>(data.size()));
-
-            const auto &frame = data.at(i);
-            auto pose = _solver->CurDnToW(frame->GetTimestamp(), topic);
+        auto undistoMapper = VisualUndistortionMap::Obtain(intri->intri);
+        // poses of frames, which are organized in order once all frames are rendered
+        std::vector<std::optional<Sophus::SE3d>> poses(data.size());
+        // structured bindings can not be captured by lambdas in c++17
+        const std::string &curTopic = topic;
+        const auto &frames = data;
+        auto render = [&](int i) {
+            const auto &frame = frames.at(i);
+            auto pose = _solver->CurDnToW(frame->GetTimestamp(), curTopic);
             if (pose == std::nullopt) {
-                continue;
+                return RenderedFrame();
             }
-
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            // 32-bit float images should be saved as tiff-format files
-            auto filenameDepth = subSaveDir + '/' + std::to_string(frame->GetId()) + "-d.tiff";
-            auto filenameColor = subSaveDir + '/' + std::to_string(frame->GetId()) + "-c.jpg";
-            auto filenameRaw = subSaveDir + '/' + std::to_string(frame->GetId()) + "-r.jpg";
+            poses.at(i) = pose;
+            const std::string prefix = subSaveDir + '/' + std::to_string(frame->GetId());
 
             // undistorted gray image
-            cv::Mat undistImgColor, res;
-            undistImgColor = undistoMapper->RemoveDistortion(frame->GetColorImage());
+            cv::Mat undistImgColor = undistoMapper->RemoveDistortion(frame->GetColorImage());
 
             // depth image
             auto [depthImg, colorImg] = covisibility->CreateCovisibility(*pose, intri->intri);
-            cv::imwrite(filename, undistImgColor);
-            cv::imwrite(filenameDepth, depthImg);
-            cv::imwrite(filenameColor, colorImg);
-            cv::imwrite(filenameRaw, frame->CreateColorDepthMap(intri, false));
-            poseVec.emplace_back(frame->GetId(), *pose);
 
             // connect
-            cv::hconcat(undistImgColor, colorImg, res);
-            cv::imshow("Covisibility Image", res);
-            cv::waitKey(1);
+            RenderedFrame rendered;
+            cv::hconcat(undistImgColor, colorImg, rendered.display);
+            // 32-bit float images should be saved as tiff-format files
+            rendered.images = {{prefix + ".jpg", undistImgColor},
+                               {prefix + "-d.tiff", depthImg},
+                               {prefix + "-c.jpg", colorImg},
+                               {prefix + "-r.jpg", frame->CreateColorDepthMap(intri, false)}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(data.size()), fmt::format("covisibility '{}'", topic),
+                     "Covisibility Image", render);
+        std::vector<std::pair<ns_veta::IndexT, Sophus::SE3d>> poseVec;
+        poseVec.reserve(data.size());
+        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
+            if (poses.at(i) != std::nullopt) {
+                poseVec.emplace_back(data.at(i)->GetId(), *poses.at(i));
+            }
         }
-        bar->finish();
         // save pose vector
         auto filename = subSaveDir + "/pose" + ns_ikalibr::Configor::GetFormatExtension();
         std::ofstream file(filename, std::ios::out);
@@ -446,7 +602,6 @@ void CalibSolverIO::SaveVisualKinematics() const {
         return;
     }
 
-    std::shared_ptr<tqdm> bar;
     // gravity
     for (const auto &[topic, _] : Configor::DataStream::PosCameraTopics()) {
         const auto &data = _solver->_dataMagr->GetCameraMeasurements(topic);
@@ -460,17 +615,16 @@ void CalibSolverIO::SaveVisualKinematics() const {
 
         auto gravityDrawer = VisualGravityDrawer::Create(
             topic, _solver->_dataMagr->GetSfMData(topic), _solver->_splines, _solver->_parMagr);
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-            bar->progress(i, static_cast<int>(data.size()));
+        auto render = [&](int i) {
             const auto &frame = data.at(i);
-            cv::Mat res = gravityDrawer->CreateGravityImg(frame);
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            cv::imwrite(filename, res);
-            cv::imshow("Visual Gravity", res);
-            cv::waitKey(1);
-        }
-        bar->finish();
+            RenderedFrame rendered;
+            rendered.display = gravityDrawer->CreateGravityImg(frame);
+            const auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
+            rendered.images = {{filename, rendered.display}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(data.size()), fmt::format("visual gravity '{}'", topic),
+                     "Visual Gravity", render);
     }
     cv::destroyAllWindows();
 
@@ -504,17 +658,16 @@ void CalibSolverIO::SaveVisualKinematics() const {
                          topic);
         }
 
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
-            bar->progress(i, static_cast<int>(frames.size()));
+        auto render = [&](int i) {
             const auto &frame = frames.at(i);
-            cv::Mat res = gravityDrawer->CreateGravityImg(frame);
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            cv::imwrite(filename, res);
-            cv::imshow("Visual Gravity", res);
-            cv::waitKey(1);
-        }
-        bar->finish();
+            RenderedFrame rendered;
+            rendered.display = gravityDrawer->CreateGravityImg(frame);
+            const auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
+            rendered.images = {{filename, rendered.display}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(frames.size()), fmt::format("visual gravity '{}'", topic),
+                     "Visual Gravity", render);
     }
     cv::destroyAllWindows();
 
@@ -532,17 +685,16 @@ void CalibSolverIO::SaveVisualKinematics() const {
         auto linVelDrawer = VisualLinVelDrawer::Create(topic, _solver->_dataMagr->GetSfMData(topic),
                                                        _solver->_splines, _solver->_parMagr);
 
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-            bar->progress(i, static_cast<int>(data.size()));
+        auto render = [&](int i) {
             const auto &frame = data.at(i);
-            cv::Mat res = linVelDrawer->CreateLinVelImg(frame);
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            cv::imwrite(filename, res);
-            cv::imshow("Visual Linear Velocity", res);
-            cv::waitKey(1);
-        }
-        bar->finish();
+            RenderedFrame rendered;
+            rendered.display = linVelDrawer->CreateLinVelImg(frame);
+            const auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
+            rendered.images = {{filename, rendered.display}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(data.size()), fmt::format("linear velocities '{}'", topic),
+                     "Visual Linear Velocity", render);
     }
     cv::destroyAllWindows();
 
@@ -578,17 +730,16 @@ void CalibSolverIO::SaveVisualKinematics() const {
         }
 
         const TimeDeriv::ScaleSplineType &scaleSplineType = ns_ikalibr::CalibSolver::GetScaleType();
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
-            bar->progress(i, static_cast<int>(frames.size()));
+        auto render = [&](int i) {
             const auto &frame = frames.at(i);
-            cv::Mat res = linVelDrawer->CreateLinVelImg(frame, scaleSplineType);
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            cv::imwrite(filename, res);
-            cv::imshow("Visual Linear Velocity", res);
-            cv::waitKey(1);
-        }
-        bar->finish();
+            RenderedFrame rendered;
+            rendered.display = linVelDrawer->CreateLinVelImg(frame, scaleSplineType);
+            const auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
+            rendered.images = {{filename, rendered.display}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(frames.size()), fmt::format("linear velocities '{}'", topic),
+                     "Visual Linear Velocity", render);
     }
     cv::destroyAllWindows();
 
@@ -606,17 +757,16 @@ void CalibSolverIO::SaveVisualKinematics() const {
         auto angVelDrawer = VisualAngVelDrawer::Create(topic, _solver->_dataMagr->GetSfMData(topic),
                                                        _solver->_splines, _solver->_parMagr);
 
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(data.size()); ++i) {
-            bar->progress(i, static_cast<int>(data.size()));
+        auto render = [&](int i) {
             const auto &frame = data.at(i);
-            cv::Mat res = angVelDrawer->CreateAngVelImg(frame);
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            cv::imwrite(filename, res);
-            cv::imshow("Visual Angular Velocity", res);
-            cv::waitKey(1);
-        }
-        bar->finish();
+            RenderedFrame rendered;
+            rendered.display = angVelDrawer->CreateAngVelImg(frame);
+            const auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
+            rendered.images = {{filename, rendered.display}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(data.size()), fmt::format("angular velocities '{}'", topic),
+                     "Visual Angular Velocity", render);
     }
 
     // angular velocities for rgbds and vel cameras
@@ -650,17 +800,16 @@ void CalibSolverIO::SaveVisualKinematics() const {
                 topic);
         }
 
-        bar = std::make_shared<tqdm>();
-        for (int i = 0; i < static_cast<int>(frames.size()); ++i) {
-            bar->progress(i, static_cast<int>(frames.size()));
+        auto render = [&](int i) {
             const auto &frame = frames.at(i);
-            cv::Mat res = angVelDrawer->CreateAngVelImg(frame);
-            auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
-            cv::imwrite(filename, res);
-            cv::imshow("Visual Angular Velocity", res);
-            cv::waitKey(1);
-        }
-        bar->finish();
+            RenderedFrame rendered;
+            rendered.display = angVelDrawer->CreateAngVelImg(frame);
+            const auto filename = subSaveDir + '/' + std::to_string(frame->GetId()) + ".jpg";
+            rendered.images = {{filename, rendered.display}};
+            return rendered;
+        };
+        RenderFrames(static_cast<int>(frames.size()), fmt::format("angular velocities '{}'", topic),
+                     "Visual Angular Velocity", render);
     }
 
     cv::destroyAllWindows();
@@ -697,11 +846,7 @@ void CalibSolverIO::SaveVisualColorizedMap() const {
         const auto shader = ColorizedCloudMap::CreateForCameras(
             topic, frames, _solver->_dataMagr->GetSfMData(topic), _solver->_splines,
             _solver->_parMagr);
-        auto colorizedMap = shader->Colorize(_solver->_backup->lidarMap);
-        auto filename = subSaveDir + "/colorized_map.pcd";
-        if (pcl::io::savePCDFile(filename, *colorizedMap, true) == -1) {
-            spdlog::warn("save colorized map as : '{}' failed!", filename);
-        }
+        SaveColorizedMap(shader, subSaveDir + "/colorized_map.pcd");
     }
 
     // rgbds and vel cameras
@@ -748,19 +893,34 @@ void CalibSolverIO::SaveVisualColorizedMap() const {
                 topic);
         }
 
-        auto colorizedMap = shader->Colorize(_solver->_backup->lidarMap);
-        auto filename = subSaveDir + "/colorized_map.pcd";
-        if (pcl::io::savePCDFile(filename, *colorizedMap, true) == -1) {
-            spdlog::warn("save colorized map as : '{}' failed!", filename);
-        }
+        SaveColorizedMap(shader, subSaveDir + "/colorized_map.pcd");
     }
 
     spdlog::info("saving visual colorized map finished!");
 }
 
 void CalibSolverIO::SaveAlignedInertialMes() const {
-    auto &scaleSpline = _solver->_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-    auto &so3Spline = _solver->_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    // the derivative order of the scale spline for linear accelerations
+    int acceDeriv = 0;
+    switch (ns_ikalibr::CalibSolver::GetScaleType()) {
+        case TimeDeriv::LIN_ACCE_SPLINE:
+            acceDeriv = TimeDeriv::Deriv<TimeDeriv::LIN_ACCE_SPLINE, TimeDeriv::LIN_ACCE>();
+            break;
+        case TimeDeriv::LIN_VEL_SPLINE:
+            acceDeriv = TimeDeriv::Deriv<TimeDeriv::LIN_VEL_SPLINE, TimeDeriv::LIN_ACCE>();
+            break;
+        case TimeDeriv::LIN_POS_SPLINE:
+            acceDeriv = TimeDeriv::Deriv<TimeDeriv::LIN_POS_SPLINE, TimeDeriv::LIN_ACCE>();
+            break;
+    }
+    // spline sampling times of measurements, i.e., their timestamps in the reference imu frame
+    auto MesTimes = [](const std::vector<IMUFrame::Ptr> &mes, double timeOffset) {
+        std::vector<double> times(mes.size());
+        for (int i = 0; i < static_cast<int>(mes.size()); ++i) {
+            times.at(i) = mes.at(i)->GetTimestamp() + timeOffset;
+        }
+        return times;
+    };
 
     // folder
     std::string saveDir = Configor::DataStream::OutputPath + "/residuals/inertial_error";
@@ -786,47 +946,29 @@ void CalibSolverIO::SaveAlignedInertialMes() const {
         // inertial measurements
         std::list<IMUFrame> rawMes, estMes, diff;
 
-        for (const auto &item : _solver->_dataMagr->GetIMUMeasurements(topic)) {
-            double t = item->GetTimestamp() + timeOffset;
-
-            if (!_solver->_splines->TimeInRange(t, scaleSpline)) {
-                continue;
-            }
-            if (!_solver->_splines->TimeInRange(t, so3Spline)) {
+        const auto &mes = _solver->_dataMagr->GetIMUMeasurements(topic);
+        const auto samples = SplineSampler::Evaluate(_solver->_splines,
+                                                     MesTimes(mes, timeOffset), acceDeriv, true);
+        for (int i = 0; i < static_cast<int>(mes.size()); ++i) {
+            const auto &item = mes.at(i);
+            const auto &sample = samples.at(i);
+            if (!sample.valid) {
                 continue;
             }
 
             rawMes.push_back(*item);
 
-            const auto &SO3_curBrToW = so3Spline.Evaluate(t);
-            const Eigen::Vector3d &angVelInW = SO3_curBrToW * so3Spline.VelocityBody(t);
-            const Eigen::Vector3d &angAcceInW = SO3_curBrToW * so3Spline.AccelerationBody(t);
+            const auto &SO3_curBrToW = sample.so3;
+            const Eigen::Vector3d &angVelInW = SO3_curBrToW * sample.angVelInBody;
+            const Eigen::Vector3d &angAcceInW = SO3_curBrToW * sample.angAcceInBody;
             const Eigen::Matrix3d &angVelMat = Sophus::SO3d::hat(angVelInW);
             const Eigen::Matrix3d &angAcceMat = Sophus::SO3d::hat(angAcceInW);
-            Eigen::Vector3d linAcce;
-            switch (ns_ikalibr::CalibSolver::GetScaleType()) {
-                case TimeDeriv::LIN_ACCE_SPLINE: {
-                    constexpr int derive =
-                        TimeDeriv::Deriv<TimeDeriv::LIN_ACCE_SPLINE, TimeDeriv::LIN_ACCE>();
-                    linAcce = scaleSpline.Evaluate<derive>(t);
-                } break;
-                case TimeDeriv::LIN_VEL_SPLINE: {
-                    constexpr int derive =
-                        TimeDeriv::Deriv<TimeDeriv::LIN_VEL_SPLINE, TimeDeriv::LIN_ACCE>();
-                    linAcce = scaleSpline.Evaluate<derive>(t);
-                } break;
-                case TimeDeriv::LIN_POS_SPLINE: {
-                    constexpr int derive =
-                        TimeDeriv::Deriv<TimeDeriv::LIN_POS_SPLINE, TimeDeriv::LIN_ACCE>();
-                    linAcce = scaleSpline.Evaluate<derive>(t);
-                } break;
-            }
+            const Eigen::Vector3d &linAcce = sample.scale;
 
             const auto &est = IMUIntrinsics::KinematicsToInertialMes(
                 item->GetTimestamp(),
                 linAcce + (angAcceMat + angVelMat * angVelMat) * SO3_curBrToW.matrix() * POS_BiInBr,
-                SO3_curBrToW * so3Spline.VelocityBody(t), SO3_curBrToW * SO3_BiToBr,
-                _solver->_parMagr->GRAVITY);
+                angVelInW, SO3_curBrToW * SO3_BiToBr, _solver->_parMagr->GRAVITY);
 
             estMes.push_back(*intri->InvolveIntri(est));
 
@@ -834,6 +976,12 @@ void CalibSolverIO::SaveAlignedInertialMes() const {
                               rawMes.back().GetGyro() - estMes.back().GetGyro(),
                               rawMes.back().GetAcce() - estMes.back().GetAcce());
         }
+        if (Configor::IsColumnarOutput()) {
+            SaveInertialMesColumnar(
+                {{"raw", &rawMes}, {"est", &estMes}, {"diff", &diff}},
+                subSaveDir + "/inertial_mes" + Configor::GetColumnarExtension());
+            continue;
+        }
         std::ofstream file(subSaveDir + "/inertial_mes" + Configor::GetFormatExtension(),
                            std::ios::out);
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
@@ -859,21 +1007,22 @@ void CalibSolverIO::SaveAlignedInertialMes() const {
 
         std::list<IMUFrame> estMes;
 
-        for (const auto &item : _solver->_dataMagr->GetIMUMeasurements(topic)) {
-            double t = item->GetTimestamp() + timeOffset;
-
-            if (!_solver->_splines->TimeInRange(t, scaleSpline)) {
-                continue;
-            }
-            if (!_solver->_splines->TimeInRange(t, so3Spline)) {
+        const auto &mes = _solver->_dataMagr->GetIMUMeasurements(topic);
+        const auto samples = SplineSampler::Evaluate(_solver->_splines,
+                                                     MesTimes(mes, timeOffset), acceDeriv, true);
+        for (int i = 0; i < static_cast<int>(mes.size()); ++i) {
+            const auto &item = mes.at(i);
+            const auto &sample = samples.at(i);
+            if (!sample.valid) {
                 continue;
             }
+            const double t = sample.time;
 
             auto mesInIdeal = intri->RemoveIntri(item);
 
-            const auto &SO3_curBrToW = so3Spline.Evaluate(t);
-            const Eigen::Vector3d &angVelInW = SO3_curBrToW * so3Spline.VelocityBody(t);
-            const Eigen::Vector3d &angAcceInW = SO3_curBrToW * so3Spline.AccelerationBody(t);
+            const auto &SO3_curBrToW = sample.so3;
+            const Eigen::Vector3d &angVelInW = SO3_curBrToW * sample.angVelInBody;
+            const Eigen::Vector3d &angAcceInW = SO3_curBrToW * sample.angAcceInBody;
             const Eigen::Matrix3d &angVelMat = Sophus::SO3d::hat(angVelInW);
             const Eigen::Matrix3d &angAcceMat = Sophus::SO3d::hat(angAcceInW);
 
@@ -888,6 +1037,12 @@ void CalibSolverIO::SaveAlignedInertialMes() const {
 
             estMes.push_back(*refIntri->InvolveIntri(alignedMes));
         }
+        if (Configor::IsColumnarOutput()) {
+            SaveInertialMesColumnar(
+                {{"aligned", &estMes}},
+                subSaveDir + "/aligned_mes_to_ref" + Configor::GetColumnarExtension());
+            continue;
+        }
         std::ofstream file(subSaveDir + "/aligned_mes_to_ref" + Configor::GetFormatExtension(),
                            std::ios::out);
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
@@ -910,63 +1065,30 @@ void CalibSolverIO::SaveVisualReprojectionError() const {
         return;
     }
 
-    for (const auto &[topic, corrsVec] : _solver->_backup->visualCorrs) {
-        const double TO_CmToBr = _solver->_parMagr->TEMPORAL.TO_CmToBr.at(topic);
-        const double READOUT_TIME = _solver->_parMagr->TEMPORAL.RS_READOUT.at(topic);
-
-        const auto &intri = _solver->_parMagr->INTRI.Camera.at(topic);
-        const double FX = intri->FocalX(), FX_INV = 1.0 / FX;
-        const double FY = intri->FocalY(), FY_INV = 1.0 / FY;
-        const double CX = intri->PrincipalPoint()(0);
-        const double CY = intri->PrincipalPoint()(1);
-        const double GLOBAL_SCALE = 1.0;
-
-        const auto SE3_CmToBr = _solver->_parMagr->EXTRI.SE3_CmToBr(topic);
+    const auto evaluator =
+        ResidualEvaluator::Create(_solver->_splines, CalibSolver::GetScaleType());
 
+    for (const auto &[topic, corrsVec] : _solver->_backup->visualCorrs) {
         auto subSaveDir = saveDir + "/" + topic;
         if (!TryCreatePath(subSaveDir)) {
             spdlog::warn("create sub directory for '{}' failed: '{}'", topic, subSaveDir);
             continue;
         }
-        std::list<Eigen::Vector2d> reprojErrors;
-
-        for (const auto &corrs : corrsVec) {
-            const double INV_DEPTH = *corrs->invDepthFir;
-            const double DEPTH = 1.0 / INV_DEPTH;
-
-            for (const auto &corr : corrs->corrs) {
-                // calculate the so3 and lin scale offset for i-feat
-                double timeIByBr = corr->ti + TO_CmToBr + corr->li * READOUT_TIME;
-                auto SE3_BrToBr0_I = _solver->CurBrToW(timeIByBr);
-                if (SE3_BrToBr0_I == std::nullopt) {
-                    continue;
-                }
-
-                // calculate the so3 and lin scale offset for j-feat
-                auto timeJByBr = corr->tj + TO_CmToBr + corr->lj * READOUT_TIME;
-                auto SE3_BrToBr0_J = _solver->CurBrToW(timeJByBr);
-                if (SE3_BrToBr0_J == std::nullopt) {
-                    continue;
-                }
-
-                Sophus::SE3d SE3_BrIToBrJ = SE3_BrToBr0_J->inverse() * *SE3_BrToBr0_I;
-                Sophus::SE3d SE3_CmIToCmJ = SE3_CmToBr.inverse() * SE3_BrIToBrJ * SE3_CmToBr;
-
-                Eigen::Vector3d PI;
-                VisualReProjCorr::TransformImgToCam<double>(&FX_INV, &FY_INV, &CX, &CY, corr->fi,
-                                                            &PI);
-                PI *= DEPTH * GLOBAL_SCALE;
-
-                Eigen::Vector3d PJ = SE3_CmIToCmJ * PI;
-                PJ /= PJ(2);
-                Eigen::Vector2d fjPred;
-                VisualReProjCorr::TransformCamToImg<double>(&FX, &FY, &CX, &CY, PJ, &fjPred);
-
-                Eigen::Vector2d residuals = fjPred - corr->fj;
-                reprojErrors.push_back(residuals);
-            }
+        ResidualStatistics stats;
+        const auto reprojErrors = evaluator->VisualReprojection(
+            ResidualEvaluator::ReprojPack::Pack(corrsVec),
+            _solver->_parMagr->TEMPORAL.TO_CmToBr.at(topic),
+            _solver->_parMagr->TEMPORAL.RS_READOUT.at(topic),
+            _solver->_parMagr->EXTRI.SE3_CmToBr(topic), _solver->_parMagr->INTRI.Camera.at(topic),
+            &stats);
+        spdlog::info("visual reprojection errors of '{}': {}", topic, stats.Summary());
+        SaveResidualStatistics(stats, subSaveDir + "/statistics" + Configor::GetFormatExtension());
+
+        if (Configor::IsColumnarOutput()) {
+            SaveResidualsColumnar(reprojErrors,
+                                  subSaveDir + "/residuals" + Configor::GetColumnarExtension());
+            continue;
         }
-
         std::ofstream file(subSaveDir + "/residuals" + Configor::GetFormatExtension(),
                            std::ios::out);
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
@@ -985,6 +1107,115 @@ bool CalibSolverIO::SavePoseSequence(const Eigen::aligned_vector<ns_ctraj::Posed
     return true;
 }
 
+bool CalibSolverIO::SavePoseSequenceColumnar(
+    const Eigen::aligned_vector<ns_ctraj::Posed> &poseSeq, const std::string &filename) {
+    auto writer =
+        ColumnarWriter::Create(filename, {"timestamp", "qx", "qy", "qz", "qw", "px", "py", "pz"});
+    if (!writer->IsOpen()) {
+        spdlog::warn("open columnar file failed: '{}'", filename);
+        return false;
+    }
+    for (const auto &pose : poseSeq) {
+        const Eigen::Quaterniond &q = pose.so3.unit_quaternion();
+        writer->AppendRow(
+            {pose.timeStamp, q.x(), q.y(), q.z(), q.w(), pose.t(0), pose.t(1), pose.t(2)});
+    }
+    return true;
+}
+
+bool CalibSolverIO::SaveInertialMesColumnar(
+    const std::vector<std::pair<std::string, const std::list<IMUFrame> *>> &mesLists,
+    const std::string &filename) {
+    std::vector<std::string> columns{"timestamp"};
+    for (const auto &[prefix, _] : mesLists) {
+        for (const std::string name : {"gyro", "acce"}) {
+            for (const std::string axis : {"x", "y", "z"}) {
+                columns.push_back(prefix + '_' + name + '_' + axis);
+            }
+        }
+    }
+    auto writer = ColumnarWriter::Create(filename, columns);
+    if (!writer->IsOpen()) {
+        spdlog::warn("open columnar file failed: '{}'", filename);
+        return false;
+    }
+    if (mesLists.empty()) {
+        return true;
+    }
+    std::vector<std::list<IMUFrame>::const_iterator> iters;
+    for (const auto &[_, mes] : mesLists) {
+        iters.push_back(mes->cbegin());
+    }
+    std::vector<double> row(columns.size());
+    while (iters.front() != mesLists.front().second->cend()) {
+        row.at(0) = iters.front()->GetTimestamp();
+        for (int i = 0; i < static_cast<int>(iters.size()); ++i) {
+            const IMUFrame &frame = *iters.at(i)++;
+            const Eigen::Vector3d &gyro = frame.GetGyro(), &acce = frame.GetAcce();
+            for (int j = 0; j < 3; ++j) {
+                row.at(1 + i * 6 + j) = gyro(j);
+                row.at(4 + i * 6 + j) = acce(j);
+            }
+        }
+        writer->AppendRow(row);
+    }
+    return true;
+}
+
+bool CalibSolverIO::SaveResidualsColumnar(const std::vector<double> &residuals,
+                                          const std::string &filename) {
+    auto writer = ColumnarWriter::Create(filename, {"residual"});
+    if (!writer->IsOpen()) {
+        spdlog::warn("open columnar file failed: '{}'", filename);
+        return false;
+    }
+    for (const double &r : residuals) {
+        writer->AppendRow({r});
+    }
+    return true;
+}
+
+bool CalibSolverIO::SaveResidualsColumnar(
+    const Eigen::aligned_vector<Eigen::Vector2d> &residuals, const std::string &filename) {
+    auto writer = ColumnarWriter::Create(filename, {"residual_x", "residual_y"});
+    if (!writer->IsOpen()) {
+        spdlog::warn("open columnar file failed: '{}'", filename);
+        return false;
+    }
+    for (const Eigen::Vector2d &r : residuals) {
+        writer->AppendRow({r(0), r(1)});
+    }
+    return true;
+}
+
+bool CalibSolverIO::SaveColorizedMap(const ColorizedCloudMapPtr &shader,
+                                     const std::string &filename) const {
+    // colorized chunks are streamed to the file, the whole colorized map is not created
+    auto writer =
+        StreamingPCDWriter<ColorPoint>::Create(filename, Configor::Preference::MapExportVoxelSize);
+    shader->Colorize(_solver->_backup->lidarMap,
+                     [&writer](const ColorPointCloud &chunk) { writer->Append(chunk); });
+    if (!writer->Close()) {
+        spdlog::warn("save colorized map as : '{}' failed!", filename);
+        return false;
+    }
+    spdlog::info("save colorized map ('{}' points) as '{}'", writer->Count(), filename);
+    return true;
+}
+
+bool CalibSolverIO::SaveResidualStatistics(const ResidualStatistics &stats,
+                                           const std::string &filename) {
+    std::ofstream file(filename, std::ios::out);
+    if (!file.is_open()) {
+        spdlog::warn("open file failed: '{}'", filename);
+        return false;
+    }
+    auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
+    SerializeByOutputArchiveVariant(ar, Configor::Preference::OutputDataFormat,
+                                    cereal::make_nvp("statistics", stats));
+    return true;
+}
+
 bool CalibSolverIO::TryCreatePath(const std::string &path) {
     if (!std::filesystem::exists(path) && !std::filesystem::create_directories(path)) {
         spdlog::warn("create directory failed: '{}'", path);
@@ -1013,41 +1244,48 @@ void CalibSolverIO::SaveLiDARMaps() const {
     if (!TryCreatePath(subSaveDir)) {
         spdlog::warn("create sub directory to save lidar map failed: '{}'", subSaveDir);
     } else {
-        std::map<ufo::map::Node, std::vector<PointToSurfelCorr::Ptr>> nodes;
+        // points in the map of each surfel node
+        std::map<ufo::map::Node, std::vector<Eigen::Vector3f>> nodes;
         std::size_t count = 0;
-        for (const auto &[topic, corrVec] : _solver->_backup->lidarCorrs) {
-            for (const auto &corr : corrVec) {
-                nodes[corr->node].push_back(corr), ++count;
+        for (const auto &[topic, buffer] : _solver->_backup->lidarCorrs) {
+            if (!buffer->WithVisualization()) {
+                spdlog::warn("points in the map of lidar '{}' are not kept, skip it", topic);
+                continue;
+            }
+            for (const auto &[surfelIdx, indices] : buffer->GroupBySurfel()) {
+                auto &points = nodes[buffer->surfels->nodes.at(surfelIdx)];
+                for (const auto &i : indices) {
+                    points.push_back(buffer->pInMap.at(i)), ++count;
+                }
             }
         }
 
-        ColorPointCloud::Ptr surfelCloud(new ColorPointCloud);
-        surfelCloud->reserve(count);
-        for (const auto &[node, corrVec] : nodes) {
+        // surfels are streamed to the file one by one, the whole surfel cloud is not created
+        auto filename = subSaveDir + "/surfel_map.pcd";
+        spdlog::info("save global lidar surfel map ('{}' points)...", count);
+        auto writer = StreamingPCDWriter<ColorPoint>::Create(
+            filename, Configor::Preference::MapExportVoxelSize);
+        ColorPointCloud surfelCloud;
+        for (const auto &[node, points] : nodes) {
             auto color = ns_viewer::Entity::GetUniqueColour();
-            for (const auto &corr : corrVec) {
-                ColorPoint p;
-                p.x = static_cast<float>(corr->pInMap(0));
-                p.y = static_cast<float>(corr->pInMap(1));
-                p.z = static_cast<float>(corr->pInMap(2));
+            surfelCloud.resize(points.size());
+            for (int i = 0; i < static_cast<int>(points.size()); ++i) {
+                const auto &pInMap = points.at(i);
+                ColorPoint &p = surfelCloud.points.at(i);
+                p.x = pInMap(0), p.y = pInMap(1), p.z = pInMap(2);
                 p.r = static_cast<std::uint8_t>(color.r * 255.0f);
                 p.g = static_cast<std::uint8_t>(color.g * 255.0f);
                 p.b = static_cast<std::uint8_t>(color.b * 255.0f);
                 p.a = static_cast<std::uint8_t>(color.a * 255.0f);
-                surfelCloud->push_back(p);
             }
+            writer->Append(surfelCloud);
         }
-        auto filename = subSaveDir + "/surfel_map.pcd";
-        spdlog::info("save global lidar surfel map...");
-        if (pcl::io::savePCDFile(filename, *surfelCloud, true) == -1) {
+        if (!writer->Close()) {
             spdlog::warn("save surfel lidar map as : '{}' failed!", filename);
         } else {
             spdlog::info("save global lidar surfel map as '{}'", filename);
         }
 
-        // deconstruct
-        surfelCloud.reset();
-
         filename = subSaveDir + "/gravity_aligned_map.pcd";
 
         // create colorized map by aligning to the gravity
@@ -1178,9 +1416,8 @@ void CalibSolverIO::SaveRadarDopplerError() const {
         return;
     }
 
-    const auto &so3Spline = _solver->_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &scaleSpline = _solver->_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-    auto scaleType = ns_ikalibr::CalibSolver::GetScaleType();
+    const auto evaluator =
+        ResidualEvaluator::Create(_solver->_splines, CalibSolver::GetScaleType());
 
     for (const auto &[topic, data] : _solver->_dataMagr->GetRadarMeasurements()) {
         auto subSaveDir = saveDir + "/" + topic;
@@ -1188,46 +1425,19 @@ void CalibSolverIO::SaveRadarDopplerError() const {
             spdlog::warn("create sub directory for '{}' failed: '{}'", topic, subSaveDir);
             continue;
         }
-        std::list<double> dopplerErrors;
-
-        const double TO_RjToBr = _solver->_parMagr->TEMPORAL.TO_RjToBr.at(topic);
-        const auto SE3_RjToBr = _solver->_parMagr->EXTRI.SE3_RjToBr(topic);
-
-        for (const auto &ary : data) {
-            for (const auto &tar : ary->GetTargets()) {
-                double timeByBr = tar->GetTimestamp() + TO_RjToBr;
-                if (!so3Spline.TimeStampInRange(timeByBr) ||
-                    !scaleSpline.TimeStampInRange(timeByBr)) {
-                    continue;
-                }
-                // query
-                Sophus::SO3d SO3_BrToBr0 = so3Spline.Evaluate(timeByBr);
-                Eigen::Vector3d ANG_VEL_BrToBr0InBr = so3Spline.VelocityBody(timeByBr);
-                Eigen::Vector3d ANG_VEL_BrToBr0InBr0 = SO3_BrToBr0 * ANG_VEL_BrToBr0InBr;
-
-                Eigen::Vector3d LIN_VEL_BrInBr0;
-                if (scaleType == TimeDeriv::LIN_VEL_SPLINE) {
-                    LIN_VEL_BrInBr0 = scaleSpline.Evaluate<0>(timeByBr);
-                } else if (scaleType == TimeDeriv::LIN_POS_SPLINE) {
-                    LIN_VEL_BrInBr0 = scaleSpline.Evaluate<1>(timeByBr);
-                } else {
-                    throw Status(Status::ERROR,
-                                 "unknown scale spline type when compute the radar residuals");
-                }
-
-                Eigen::Vector3d tarInRj = tar->GetTargetXYZ();
-                Eigen::Vector1d v1 = -tarInRj.transpose() * SE3_RjToBr.so3().matrix().transpose() *
-                                     SO3_BrToBr0.matrix().transpose() *
-                                     (-Sophus::SO3d::hat(SO3_BrToBr0 * SE3_RjToBr.translation()) *
-                                          ANG_VEL_BrToBr0InBr0 +
-                                      LIN_VEL_BrInBr0);
-
-                double v2 = tar->GetRadialVelocity();
-                double error = tar->GetInvRange() * v1(0) - v2;
-                dopplerErrors.push_back(error);
-            }
+        ResidualStatistics stats;
+        const auto dopplerErrors = evaluator->RadarDoppler(
+            ResidualEvaluator::RadarPack::Pack(data),
+            _solver->_parMagr->TEMPORAL.TO_RjToBr.at(topic),
+            _solver->_parMagr->EXTRI.SE3_RjToBr(topic), &stats);
+        spdlog::info("radar doppler errors of '{}': {}", topic, stats.Summary());
+        SaveResidualStatistics(stats, subSaveDir + "/statistics" + Configor::GetFormatExtension());
+
+        if (Configor::IsColumnarOutput()) {
+            SaveResidualsColumnar(dopplerErrors,
+                                  subSaveDir + "/residuals" + Configor::GetColumnarExtension());
+            continue;
         }
-
         std::ofstream file(subSaveDir + "/residuals" + Configor::GetFormatExtension(),
                            std::ios::out);
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
@@ -1250,9 +1460,8 @@ void CalibSolverIO::SaveVisualOpticalFlowError() const {
         return;
     }
 
-    const auto &so3Spline = _solver->_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &scaleSpline = _solver->_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
-    auto scaleType = CalibSolver::GetScaleType();
+    const auto evaluator =
+        ResidualEvaluator::Create(_solver->_splines, CalibSolver::GetScaleType());
     const auto &parMagr = _solver->_parMagr;
 
     for (const auto &[topic, corrVec] : _solver->_backup->ofCorrs) {
@@ -1279,58 +1488,18 @@ void CalibSolverIO::SaveVisualOpticalFlowError() const {
             throw Status(Status::ERROR, "can not create optical flow error for sensor '{}'", topic);
         }
 
-        std::list<Eigen::Vector2d> velErrors;
-
-        for (const auto &corr : corrVec) {
-            double timeByBr = corr->MidPointTime(readout) + TO_CamToBr;
-            if (!so3Spline.TimeStampInRange(timeByBr) || !scaleSpline.TimeStampInRange(timeByBr)) {
-                continue;
-            }
-
-            auto SO3_BrToBr0 = so3Spline.Evaluate(timeByBr);
-            Sophus::SO3d SO3_BrToCam = SE3_CamToBr.so3().inverse();
-
-            Eigen::Vector3d ANG_VEL_BrToBr0InBr = so3Spline.VelocityBody(timeByBr);
-            Eigen::Vector3d ANG_VEL_BrToBr0InBr0 = SO3_BrToBr0 * ANG_VEL_BrToBr0InBr;
-            Eigen::Vector3d ANG_VEL_CamToBr0InCam = SO3_BrToCam * ANG_VEL_BrToBr0InBr;
-
-            Eigen::Vector3d LIN_VEL_BrToBr0InBr0;
-            switch (scaleType) {
-                case TimeDeriv::LIN_ACCE_SPLINE:
-                    // this would not happen
-                    continue;
-                case TimeDeriv::LIN_VEL_SPLINE:
-                    LIN_VEL_BrToBr0InBr0 = scaleSpline.Evaluate<0>(timeByBr);
-                    break;
-                case TimeDeriv::LIN_POS_SPLINE:
-                    LIN_VEL_BrToBr0InBr0 = scaleSpline.Evaluate<1>(timeByBr);
-                    break;
-            }
-
-            Eigen::Vector3d LIN_VEL_CamToBr0InBr0 =
-                LIN_VEL_BrToBr0InBr0 -
-                Sophus::SO3d::hat(SO3_BrToBr0 * SE3_CamToBr.translation()) * ANG_VEL_BrToBr0InBr0;
-            Eigen::Vector3d LIN_VEL_CamToBr0InCam =
-                SO3_BrToCam * SO3_BrToBr0.inverse() * LIN_VEL_CamToBr0InBr0;
-
-            const double FX = intri->FocalX(), FY = intri->FocalY();
-            const double CX = intri->PrincipalPoint()(0), CY = intri->PrincipalPoint()(1);
-
-            // map depth using alpha and beta
-            const double depth = corr->depth;
+        ResidualStatistics stats;
+        const auto velErrors =
+            evaluator->VisualOpticalFlow(ResidualEvaluator::OpticalFlowPack::Pack(corrVec, readout),
+                                         TO_CamToBr, SE3_CamToBr, intri, &stats);
+        spdlog::info("optical flow errors of '{}': {}", topic, stats.Summary());
+        SaveResidualStatistics(stats, subSaveDir + "/statistics" + Configor::GetFormatExtension());
 
-            Eigen::Matrix<double, 2, 3> subAMat, subBMat;
-            OpticalFlowCorr::SubMats<double>(&FX, &FY, &CX, &CY, corr->MidPoint(), &subAMat,
-                                             &subBMat);
-            Eigen::Vector2d pred =
-                1.0 / depth * subAMat * LIN_VEL_CamToBr0InCam + subBMat * ANG_VEL_CamToBr0InCam;
-
-            Eigen::Vector2d mes = corr->MidPointVel(readout);
-
-            Eigen::Vector2d residuals = pred - mes;
-            velErrors.push_back(residuals);
+        if (Configor::IsColumnarOutput()) {
+            SaveResidualsColumnar(velErrors,
+                                  subSaveDir + "/residuals" + Configor::GetColumnarExtension());
+            continue;
         }
-
         std::ofstream file(subSaveDir + "/residuals" + Configor::GetFormatExtension(),
                            std::ios::out);
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
@@ -1354,8 +1523,8 @@ void CalibSolverIO::SaveLiDARPointToSurfelError() const {
         return;
     }
 
-    const auto &so3Spline = _solver->_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
-    const auto &posSpline = _solver->_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    const auto evaluator =
+        ResidualEvaluator::Create(_solver->_splines, CalibSolver::GetScaleType());
     const auto &parMagr = _solver->_parMagr;
 
     for (const auto &elem : _solver->_backup->lidarCorrs) {
@@ -1371,31 +1540,18 @@ void CalibSolverIO::SaveLiDARPointToSurfelError() const {
         const Eigen::Vector3d POS_LkInBr = parMagr->EXTRI.POS_LkInBr.at(topic);
         const double TO_LkToBr = parMagr->TEMPORAL.TO_LkToBr.at(topic);
 
-        std::list<double> ptsErrors;
-#pragma omp parallel for num_threads(omp_get_max_threads()) default(none) \
-    shared(corrVec, TO_LkToBr, so3Spline, posSpline, SO3_LkToBr, POS_LkInBr, ptsErrors)
-        for (int i = 0; i < static_cast<int>(corrVec.size()); ++i) {
-            const auto &corr = corrVec.at(i);
-
-            auto timeByBr = corr->timestamp + TO_LkToBr;
-            if (!so3Spline.TimeStampInRange(timeByBr) || !posSpline.TimeStampInRange(timeByBr)) {
-                continue;
-            }
-
-            auto SO3_BrToBr0 = so3Spline.Evaluate(timeByBr);
-
-            Eigen::Vector3d POS_BrInBr0 = posSpline.Evaluate(timeByBr);
+        ResidualStatistics stats;
+        const auto ptsErrors = evaluator->PointToSurfel(
+            ResidualEvaluator::PointToSurfelPack::Pack(*corrVec), TO_LkToBr, SO3_LkToBr, POS_LkInBr,
+            &stats);
+        spdlog::info("lidar point-to-surfel errors of '{}': {}", topic, stats.Summary());
+        SaveResidualStatistics(stats, subSaveDir + "/statistics" + Configor::GetFormatExtension());
 
-            // construct the residuals
-            Eigen::Vector3d pointInBr = SO3_LkToBr * corr->pInScan + POS_LkInBr;
-            Eigen::Vector3d pointInBr0 = SO3_BrToBr0 * pointInBr + POS_BrInBr0;
-
-            Eigen::Vector3d planeNorm = corr->surfelInW.head(3);
-            double distance = pointInBr0.dot(planeNorm) + corr->surfelInW(3);
-#pragma omp critical
-            { ptsErrors.push_back(distance); }
+        if (Configor::IsColumnarOutput()) {
+            SaveResidualsColumnar(ptsErrors,
+                                  subSaveDir + "/residuals" + Configor::GetColumnarExtension());
+            continue;
         }
-
         std::ofstream file(subSaveDir + "/residuals" + Configor::GetFormatExtension(),
                            std::ios::out);
         auto ar = GetOutputArchiveVariant(file, Configor::Preference::OutputDataFormat);
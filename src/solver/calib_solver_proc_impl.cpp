@@ -32,72 +32,158 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include "calib/data_lifetime_planner.h"
 #include "calib/estimator.h"
 #include "factor/point_to_surfel_factor.hpp"
 #include "solver/batch_opt_option.hpp"
 #include "solver/calib_solver.h"
+#include "util/status.hpp"
 #include "util/utils_tpl.hpp"
 #include "viewer/viewer.h"
+#include "functional"
+#include "algorithm"
+#include "util/stage_profiler.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 }
 
 namespace ns_ikalibr {
-void CalibSolver::Process() {
-    auto outputParams = IsOptionWith(OutputOption::ParamInEachIter, Configor::Preference::Outputs);
-    if (outputParams) {
-        SaveStageCalibParam(_parMagr, "stage_0_init");
-    }
-    /**
-     * perform the initialization procedure to recover spatiotemporal parameters and
-     * interested states in the estimator, such as the splines and the gravity vector
-     */
+/**
+ * the max changes of spatiotemporal parameters from the given last states, i.e., extrinsic
+ * rotations (deg), extrinsic translations (m), and time offsets and readout times (s)
+ */
+static std::tuple<double, double, double> SpatTempParamDeltas(
+    const CalibParamManager::ParExtri &lastExtri,
+    const CalibParamManager::ParTemporal &lastTemporal,
+    const CalibParamManager::Ptr &parMagr) {
+    double rotDelta = 0.0, posDelta = 0.0, timeDelta = 0.0;
+    auto SO3Delta = [&rotDelta](const auto &lastMap, const auto &curMap) {
+        for (const auto &[topic, SO3_Last] : lastMap) {
+            const double delta = (SO3_Last.inverse() * curMap.at(topic)).log().norm();
+            rotDelta = std::max(rotDelta, delta * CalibParamManager::RAD_TO_DEG);
+        }
+    };
+    auto POSDelta = [&posDelta](const auto &lastMap, const auto &curMap) {
+        for (const auto &[topic, POS_Last] : lastMap) {
+            posDelta = std::max(posDelta, (curMap.at(topic) - POS_Last).norm());
+        }
+    };
+    auto TimeDelta = [&timeDelta](const auto &lastMap, const auto &curMap) {
+        for (const auto &[topic, TO_Last] : lastMap) {
+            timeDelta = std::max(timeDelta, std::abs(curMap.at(topic) - TO_Last));
+        }
+    };
+    const auto &extri = parMagr->EXTRI;
+    SO3Delta(lastExtri.SO3_BiToBr, extri.SO3_BiToBr);
+    SO3Delta(lastExtri.SO3_RjToBr, extri.SO3_RjToBr);
+    SO3Delta(lastExtri.SO3_LkToBr, extri.SO3_LkToBr);
+    SO3Delta(lastExtri.SO3_CmToBr, extri.SO3_CmToBr);
+    SO3Delta(lastExtri.SO3_DnToBr, extri.SO3_DnToBr);
+    SO3Delta(lastExtri.SO3_EsToBr, extri.SO3_EsToBr);
+    POSDelta(lastExtri.POS_BiInBr, extri.POS_BiInBr);
+    POSDelta(lastExtri.POS_RjInBr, extri.POS_RjInBr);
+    POSDelta(lastExtri.POS_LkInBr, extri.POS_LkInBr);
+    POSDelta(lastExtri.POS_CmInBr, extri.POS_CmInBr);
+    POSDelta(lastExtri.POS_DnInBr, extri.POS_DnInBr);
+    POSDelta(lastExtri.POS_EsInBr, extri.POS_EsInBr);
+    const auto &temporal = parMagr->TEMPORAL;
+    TimeDelta(lastTemporal.TO_BiToBr, temporal.TO_BiToBr);
+    TimeDelta(lastTemporal.TO_RjToBr, temporal.TO_RjToBr);
+    TimeDelta(lastTemporal.TO_LkToBr, temporal.TO_LkToBr);
+    TimeDelta(lastTemporal.TO_CmToBr, temporal.TO_CmToBr);
+    TimeDelta(lastTemporal.TO_DnToBr, temporal.TO_DnToBr);
+    TimeDelta(lastTemporal.TO_EsToBr, temporal.TO_EsToBr);
+    TimeDelta(lastTemporal.RS_READOUT, temporal.RS_READOUT);
+    return {rotDelta, posDelta, timeDelta};
+}
 
-    /* initialize (recover) the rotation spline using raw angular velocity measurements from the
-     * gyroscope. If multiple gyroscopes (IMUs) are involved, the extrinsic rotations and time
-     * offsets would be also recovered
-     */
-    this->InitSO3Spline();
-    if (outputParams) {
-        SaveStageCalibParam(_parMagr, "stage_1_rot_fit");
+/**
+ * run independent tasks [description, task], concurrently if 'concurrent' is true. The thread
+ * budget is shared by tasks, each uses its share in its nested parallel regions. Exceptions are
+ * rethrown once all tasks are finished
+ */
+static void RunIndependentTasks(
+    const std::vector<std::pair<std::string, std::function<void()>>> &tasks,
+    bool concurrent,
+    const std::string &kind) {
+    const int taskCount = static_cast<int>(tasks.size());
+    if (!concurrent || taskCount < 2) {
+        for (const auto &[desc, task] : tasks) {
+            task();
+        }
+        return;
     }
 
-    /**
-     * perform sensor-inertial alignment to recover the gravity vector and extrinsic translations.
-     * for each type of sensor, the preparation is first performed to obtain necessary quantities
-     * for one-shot sensor-inertial alignment
-     */
-    this->InitPrepPosCameraInertialAlign();  // visual-inertial (pos scale spline based)
-    this->InitPrepVelCameraInertialAlign();  // visual-inertial (vel scale spline based)
-    this->InitPrepRGBDInertialAlign();       // rgbd-inertial
-    this->InitPrepLiDARInertialAlign();      // lidar-inertial
-    this->InitPrepRadarInertialAlign();      // radar-inertial
-    this->InitPrepInertialInertialAlign();   // inertial-inertial
-
-    // this->InitPrepEventInertialAlign();        // point-based optical flow event-inertial
-    this->InitPrepEventInertialAlignLineBased();  // line-based norm flow event-inertial
-
-    this->InitSensorInertialAlign();  // one-shot sensor-inertial alignment
+    // tasks contain nested parallel regions, e.g., pipelines and ndt solving of lidars
+    const Configor::Preference::ThreadSplit split(taskCount);
+    const int workerCount = split.Workers();
+    spdlog::info("run '{}' {}(s) using '{}' worker(s), each with '{}' thread(s)", taskCount, kind,
+                 workerCount, split.ThreadsPerWorker());
 
-    if (outputParams) {
-        SaveStageCalibParam(_parMagr, "stage_2_align");
+    std::vector<std::exception_ptr> exceptions(taskCount, nullptr);
+#pragma omp parallel for num_threads(workerCount) schedule(dynamic) default(none) \
+    shared(taskCount, tasks, split, exceptions)
+    for (int i = 0; i < taskCount; ++i) {
+        const auto binding = split.EnterWorker();
+        try {
+            tasks.at(i).second();
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
+        }
     }
 
-    /**
-     * recover the linear scale spline using quantities from the one-shot sensor-inertial alignment
-     */
-    this->InitScaleSpline();
-
-    if (outputParams) {
-        SaveStageCalibParam(_parMagr, "stage_3_scale_fit");
+    // exceptions can not be thrown out of the parallel region, rethrow them here
+    for (int i = 0; i < taskCount; ++i) {
+        if (exceptions.at(i) != nullptr) {
+            spdlog::warn("{} '{}' failed!", kind, tasks.at(i).first);
+            std::rethrow_exception(exceptions.at(i));
+        }
     }
+}
+
+void CalibSolver::Process() {
+    StageProfiler::Scope stageScope("Process");
+    auto scope = _context->Activate();
+    auto outputParams = IsOptionWith(OutputOption::ParamInEachIter, Configor::Preference::Outputs);
+    auto options = BatchOptOption::GetOptions();
 
     /**
-     * this is the end of the initialization procedure, also the start of the batch optimizaion.
-     * some preparation operatiors would be performed here
+     * if a stage to resume from is specified, states saved after this stage are loaded from its
+     * checkpoint, and stages before (including) it are skipped
      */
-    this->InitPrepBatchOpt();
+    int boBegin = 0;
+    if (Configor::Preference::ResumeFromStage.empty()) {
+        /**
+         * states from a previous calibration are used instead of the initialization if they fit
+         * the data, as a resumed checkpoint does, the lidar global map is rebuilt from splines
+         */
+        if (this->TryWarmStart()) {
+            _initAsset = nullptr;
+            if (Configor::Preference::SaveCheckpoints) {
+                SaveStageCheckpoint("stage_3_scale_fit");
+            }
+        } else {
+            this->Initialization();
+        }
+    } else {
+        boBegin = this->LoadStageCheckpoint(Configor::Preference::ResumeFromStage);
+        if (boBegin >= static_cast<int>(options.size())) {
+            throw Status(Status::ERROR,
+                         "all batch optimizations are finished in stage '{}', nothing to resume!",
+                         Configor::Preference::ResumeFromStage);
+        }
+        // raw events are only used in the initialization, which is skipped here
+        if (Configor::Preference::ReleaseConsumedData) {
+            _dataMagr->ReleaseEventMeasurements();
+        }
+        // the lidar global map would be rebuilt from the loaded splines
+        _initAsset = nullptr;
+    }
+    _lifetimePlanner = DataLifetimePlanner::Create(_dataMagr, GetScaleType(),
+                                                   static_cast<int>(options.size()) - boBegin);
+    _lifetimePlanner->PrintPlan();
+    _lifetimePlanner->OnStageFinished(DataLifetimePlanner::Stage::INITIALIZATION);
 
     /**
      * once the initialization procedure is finished, we print the recovered spatiotemporal
@@ -109,43 +195,46 @@ void CalibSolver::Process() {
      * perform multi-stage batch optimizations to refine all initialized states to global optimal
      * ones, which is descided by the optimization options from the 'BatchOptOption'
      */
-    const int ptsCountInEachScan = Configor::Prior::LiDARDataAssociate::PointToSurfelCountInScan;
-    auto options = BatchOptOption::GetOptions();
 
-    for (int i = 0; i < static_cast<int>(options.size()); ++i) {
+    /**
+     * correspondences of the last batch optimization, which are reused (data association is
+     * skipped) if spatiotemporal parameters converged in it
+     */
+    BatchOptCorrs corrs;
+    bool reassociate = true;
+
+    for (int i = boBegin; i < static_cast<int>(options.size()); ++i) {
+        StageProfiler::Scope stageScope(fmt::format("BatchOptimization{}", i));
         spdlog::info("perform '{}-th' batch optimization...", i);
         /**
-         * the preparation visualization tasks before the batch optimization.
+         * coarse-to-fine knot scheduling: early batch optimizations are performed on splines with
+         * coarse knots, which are refitted once the scheduled knot distances change. The current
+         * ones are obtained from the splines, as they may be loaded from a checkpoint
          */
-        _viewer->ClearViewer(Viewer::VIEW_MAP);
-        if (Configor::IsRadarIntegrated() && GetScaleType() == TimeDeriv::LIN_POS_SPLINE) {
-            // add radar cloud if radars and pose spline is maintained
-            auto color = ns_viewer::Colour::Black().WithAlpha(0.2f);
-            _viewer->AddCloud(BuildGlobalMapOfRadar(), Viewer::VIEW_MAP, color, 2.0f);
+        const auto [so3Dt, scaleDt] = ScheduledKnotTimeDist(i, static_cast<int>(options.size()));
+        if (this->RefitScheduledSplines(so3Dt, scaleDt)) {
+            // correspondences are bound to the states of the replaced splines
+            reassociate = true;
         }
-        std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> lidarPtsCorr;
 
-        /**
-         * for the first batch optimization, the lidar global map and frames in the global frames
-         * are from the odometry performed in the initialization procedure, to save the computation
-         * consumption
-         */
-        if (i == 0) {
-            lidarPtsCorr = DataAssociationForLiDARs(
-                // the global lidar map
-                _initAsset->globalMap,
-                // undistorted frame expressed in the global map
-                _initAsset->undistFramesInMap, ptsCountInEachScan);
-            _initAsset = nullptr;  // deconstruct data from initialization
+        if (reassociate) {
+            this->BatchOptDataAssociation(options.at(i), corrs);
         } else {
-            auto [curGlobalMap, curUndistFramesInMap] = BuildGlobalMapOfLiDAR();
-            lidarPtsCorr = DataAssociationForLiDARs(
-                // the global lidar map
-                curGlobalMap,
-                // undistorted frame expressed in the global map
-                curUndistFramesInMap, ptsCountInEachScan);
-            // 'curGlobalMap' and 'curUndistFramesInMap' would be deconstructed here
+            spdlog::info(
+                "spatiotemporal parameters converged in last batch optimization, reuse its "
+                "correspondences and skip data association");
         }
+
+        /**
+         * for long recordings, calibration parameters are first recovered in overlapping time
+         * windows solved in parallel, and reconciled by consensus, if the decomposition is enabled
+         */
+        this->WindowedConsensusOptimization(options.at(i), corrs.lidarPtsCorrs, so3Dt, scaleDt);
+
+        // spatiotemporal parameters before this batch optimization, for convergence monitoring
+        const auto lastExtri = _parMagr->EXTRI;
+        const auto lastTemporal = _parMagr->TEMPORAL;
+
         /**
          * perform batch optimization, association correspondences of cameras, rgbds, and lidars are
          * from addition constructed, while for imus and radars, raw measurements can be directly
@@ -156,15 +245,19 @@ void CalibSolver::Process() {
             // optimization option
             options.at(i),
             // point to surfel data association for LiDARs
-            lidarPtsCorr,
+            corrs.lidarPtsCorrs,
             // visual reprojection data association for cameras
-            DataAssociationForPosCameras(),
+            corrs.visualReprojCorrs,
             // visual velocity creation for rgbd cameras
-            DataAssociationForRGBDs(IsOptionWith(OptOption::OPT_VISUAL_DEPTH, options.at(i))),
+            corrs.rgbdCorrs,
             // visual velocity creation for optical cameras
-            DataAssociationForVelCameras(),
+            corrs.visualVelCorrs,
             // visual velocity creation for event cameras
-            DataAssociationForEventCameras(true));
+            corrs.eventCorrs);
+        if (i + 1 < static_cast<int>(options.size())) {
+            // residuals of the next batch optimization involve fewer knots if paddings narrowed
+            NarrowTemporalPaddings(_backup->estimator);
+        }
 
         /**
          * update the viewer and output the spatiotemporal parameters after this batch optimization
@@ -175,6 +268,47 @@ void CalibSolver::Process() {
         if (outputParams) {
             SaveStageCalibParam(_parMagr, "stage_4_bo_" + std::to_string(i));
         }
+        if (Configor::Preference::SaveCheckpoints) {
+            SaveStageCheckpoint("stage_4_bo_" + std::to_string(i));
+        }
+
+        /**
+         * convergence monitoring: if spatiotemporal parameters barely moved in this batch
+         * optimization, data association of the next one is skipped, and the remaining ones are
+         * terminated early if they would not optimize any other parameters
+         */
+        const auto [rotDelta, posDelta, timeDelta] =
+            SpatTempParamDeltas(lastExtri, lastTemporal, _parMagr);
+        const bool converged = rotDelta < Configor::Preference::StageConvergenceRotThd &&
+                               posDelta < Configor::Preference::StageConvergencePosThd &&
+                               timeDelta < Configor::Preference::StageConvergenceTimeThd;
+        spdlog::info(
+            "max spatiotemporal parameter changes in '{}-th' batch optimization: rotation: "
+            "'{:.6f}' (deg), translation: '{:.6f}' (m), time: '{:.6f}' (s), converged: '{}'",
+            i, rotDelta, posDelta, timeDelta, converged);
+        if (!converged || i + 1 == static_cast<int>(options.size())) {
+            reassociate = true;
+            continue;
+        }
+        const bool remainingSame = std::all_of(options.cbegin() + i + 1, options.cend(),
+                                               [opt = options.at(i)](OptOption o) {
+                                                   return o == opt;
+                                               });
+        // the splines should have been refined to the configured knot distances (the final level)
+        const bool finestKnots =
+            ScheduledKnotTimeDist(i, static_cast<int>(options.size())) ==
+            ScheduledKnotTimeDist(static_cast<int>(options.size()) - 1,
+                                  static_cast<int>(options.size()));
+        if (Configor::Preference::EarlyStopBatchOptimization && remainingSame && finestKnots) {
+            spdlog::info(
+                "remaining '{}' batch optimization(s) optimize the same parameters with converged "
+                "ones, terminate them early",
+                options.size() - i - 1);
+            break;
+        }
+        // rgbd correspondences depend on whether visual depths are optimized
+        reassociate = IsOptionWith(OptOption::OPT_VISUAL_DEPTH, options.at(i)) !=
+                      IsOptionWith(OptOption::OPT_VISUAL_DEPTH, options.at(i + 1));
     }
 
 /**
@@ -194,7 +328,7 @@ void CalibSolver::Process() {
             _viewer->AddCloud(BuildGlobalMapOfRadar(), Viewer::VIEW_MAP, color, 2.0f);
         }
 
-        std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> lidarPtsCorr;
+        std::map<std::string, PointToSurfelCorrBuffer::Ptr> lidarPtsCorr;
         {
             auto [curGlobalMap, curUndistFramesInMap] = BuildGlobalMapOfLiDAR();
             lidarPtsCorr = DataAssociationForLiDARs(curGlobalMap,
@@ -202,7 +336,7 @@ void CalibSolver::Process() {
                                                     curUndistFramesInMap, ptsCountInEachScan);
             // 'curGlobalMap' and 'curUndistFramesInMap' would be deconstructed here
         }
-        std::map<std::string, std::vector<PointToSurfelCorr::Ptr>> rgbdPtsCorr;
+        std::map<std::string, PointToSurfelCorrBuffer::Ptr> rgbdPtsCorr;
         {
             auto [rgbdGlobalMap, rgbdScansInGFrame, rgbdScansInLFrame] = BuildGlobalMapOfRGBD();
             rgbdPtsCorr = DataAssociationForRGBDs(rgbdGlobalMap,
@@ -236,21 +370,224 @@ void CalibSolver::Process() {
     }
 #endif
 #undef USE_CROSS_MODEL_REFINEMENT
+    _lifetimePlanner->OnStageFinished(DataLifetimePlanner::Stage::BATCH_OPTIMIZATION);
 
     /**
      * some tasks after batch optimization
      */
+    this->FinalizeBatchOptimizations(options.back());
+
+    _lifetimePlanner->OnStageFinished(DataLifetimePlanner::Stage::FINALIZATION);
+
+    _solveFinished = true;
+
+    spdlog::info(
+        "Solving is finished! Focus on the viewer and press [ctrl+'s'] to save the current scene!");
+    spdlog::info("Focus on the viewer and press ['w', 's', 'a', 'd'] to zoom spline viewer!");
+}
+
+void CalibSolver::ProcessSessions(const std::vector<Ptr> &sessions,
+                                  const CalibContextPtr &context) {
+    if (sessions.empty()) {
+        throw Status(Status::ERROR, "no session is given for the multi-session calibration!");
+    }
+    const auto &parMagr = sessions.front()->_parMagr;
+    for (const auto &session : sessions) {
+        if (session->_parMagr != parMagr) {
+            throw Status(Status::ERROR,
+                         "sessions of a multi-session calibration should share the same parameter "
+                         "manager!");
+        }
+    }
+    StageProfiler::Scope stageScope("ProcessSessions");
+    auto scope = context->Activate();
+    auto outputParams = IsOptionWith(OutputOption::ParamInEachIter, Configor::Preference::Outputs);
+    auto options = BatchOptOption::GetOptions();
+    const int boCount = static_cast<int>(options.size());
+    const int count = static_cast<int>(sessions.size());
+    if (!Configor::Preference::ResumeFromStage.empty() ||
+        !Configor::Preference::WarmStartParamPath.empty()) {
+        spdlog::warn(
+            "checkpoints and warm starts are not supported in multi-session calibrations, "
+            "sessions would be initialized!");
+    }
+
+    /**
+     * sessions are initialized one by one in their own contexts, as initializations write the
+     * shared parameters, and their outputs (e.g., images for SfM) go to the own output paths of
+     * sessions. The longest session is initialized last, thus its estimates are the start of the
+     * joint batch optimizations, and it leads them (i.e., its solver options and priori are used)
+     */
+    std::vector<Ptr> order = sessions;
+    std::stable_sort(order.begin(), order.end(), [](const Ptr &s1, const Ptr &s2) {
+        return s1->_dataMagr->GetCalibTimeRange() < s2->_dataMagr->GetCalibTimeRange();
+    });
+    for (int k = 0; k < count; ++k) {
+        const auto &session = order.at(k);
+        auto sessionScope = session->_context->Activate();
+        spdlog::info("initialize '{}-th' session of '{}' session(s), time range: '{:.3f}' (s)...",
+                     k, count, session->_dataMagr->GetCalibTimeRange());
+        session->Initialization();
+    }
+    std::reverse(order.begin(), order.end());
+    const auto &lead = order.front();
+    for (const auto &session : order) {
+        if (session != lead) {
+            // lidar maps of other sessions are bound to the estimates replaced by the lead one
+            session->_initAsset = nullptr;
+        }
+        session->_temporalPadding = lead->_temporalPadding;
+    }
+    parMagr->ShowParamStatus();
+
+    std::vector<BatchOptCorrs> corrs(count);
+    for (int i = 0; i < boCount; ++i) {
+        StageProfiler::Scope boScope(fmt::format("JointBatchOptimization{}", i));
+        spdlog::info("perform '{}-th' joint batch optimization of '{}' session(s)...", i, count);
+        const auto knotDist = ScheduledKnotTimeDist(i, boCount);
+
+        /**
+         * splines of sessions are refitted and their correspondences are associated independently
+         * given the shared parameters (read only), thus sessions are processed concurrently
+         */
+        std::vector<std::pair<std::string, std::function<void()>>> tasks;
+        for (int k = 0; k < count; ++k) {
+            tasks.emplace_back(fmt::format("session-{}", k), [&, k] {
+                order.at(k)->RefitScheduledSplines(knotDist.first, knotDist.second);
+                order.at(k)->BatchOptDataAssociation(options.at(i), corrs.at(k));
+            });
+        }
+        RunIndependentTasks(tasks, Configor::Preference::ConcurrentDataAssociation,
+                            "session data association");
+
+        const auto estimator = JointBatchOptimization(order, options.at(i), corrs);
+        if (i + 1 < boCount) {
+            // paddings are shared by sessions
+            lead->NarrowTemporalPaddings(estimator);
+        }
+
+        for (const auto &session : order) {
+            session->_viewer->UpdateSplineViewer();
+        }
+        parMagr->ShowParamStatus();
+        if (outputParams) {
+            SaveStageCalibParam(parMagr, "stage_4_bo_" + std::to_string(i));
+        }
+    }
+
+    // final maps and by-products of sessions go to their own output paths
+    for (const auto &session : order) {
+        auto sessionScope = session->_context->Activate();
+        session->FinalizeBatchOptimizations(options.back());
+        session->_solveFinished = true;
+    }
+
+    spdlog::info("Solving of '{}' session(s) is finished!", count);
+}
+
+bool CalibSolver::RefitScheduledSplines(double so3Dt, double scaleDt) {
+    // the knot distance of a spline, from its time range and the count of its control points
+    auto KnotTimeDistOf = [](const auto &spline) {
+        return (spline.MaxTime() - spline.MinTime()) /
+               static_cast<double>(spline.GetKnots().size() - Configor::Prior::SplineOrder + 1);
+    };
+    auto IsScheduled = [&KnotTimeDistOf](const auto &spline, double dt) {
+        return std::abs(KnotTimeDistOf(spline) - dt) < 0.1 * dt;
+    };
+    if (IsScheduled(_splines->GetSo3Spline(Configor::Preference::SO3_SPLINE), so3Dt) &&
+        IsScheduled(_splines->GetRdSpline(Configor::Preference::SCALE_SPLINE), scaleDt)) {
+        return false;
+    }
+    this->RefitSplineBundle(so3Dt, scaleDt);
+    return true;
+}
+
+void CalibSolver::BatchOptDataAssociation(OptOption optOption, BatchOptCorrs &corrs) {
+    const int ptsCountInEachScan = Configor::Prior::LiDARDataAssociate::PointToSurfelCountInScan;
+    /**
+     * the preparation visualization tasks before the batch optimization.
+     */
+    _viewer->ClearViewer(Viewer::VIEW_MAP);
+    if (Configor::IsRadarIntegrated() && GetScaleType() == TimeDeriv::LIN_POS_SPLINE) {
+        // add radar cloud if radars and pose spline is maintained
+        auto color = ns_viewer::Colour::Black().WithAlpha(0.2f);
+        _viewer->AddCloud(BuildGlobalMapOfRadar(), Viewer::VIEW_MAP, color, 2.0f);
+    }
+
+    /**
+     * for the first batch optimization, the lidar global map and frames in the global
+     * frames are from the odometry performed in the initialization procedure, to save the
+     * computation consumption (unless the initialization is skipped by resuming from a
+     * checkpoint)
+     */
+    auto LiDARAssociation = [this, &corrs, ptsCountInEachScan] {
+        if (_initAsset != nullptr) {
+            corrs.lidarPtsCorrs = DataAssociationForLiDARs(
+                // the global lidar map
+                _initAsset->globalMap,
+                // undistorted frame expressed in the global map
+                _initAsset->undistFramesInMap, ptsCountInEachScan);
+        } else {
+            auto [curGlobalMap, curUndistFramesInMap] = BuildGlobalMapOfLiDAR();
+            corrs.lidarPtsCorrs = DataAssociationForLiDARs(
+                // the global lidar map
+                curGlobalMap,
+                // undistorted frame expressed in the global map
+                curUndistFramesInMap, ptsCountInEachScan);
+            // 'curGlobalMap' and 'curUndistFramesInMap' would be deconstructed here
+        }
+    };
+    const bool estDepth = IsOptionWith(OptOption::OPT_VISUAL_DEPTH, optOption);
+    /**
+     * data associations of different sensor types are independent given the current
+     * splines and parameters (read only), thus can be performed concurrently, the viewer
+     * is updated by each of them in a thread-safe manner
+     */
+    std::vector<std::pair<std::string, std::function<void()>>> tasks;
+    if (Configor::IsLiDARIntegrated()) {
+        tasks.emplace_back("lidar", LiDARAssociation);
+    }
+    if (Configor::IsPosCameraIntegrated()) {
+        // visual reprojection data association for cameras
+        tasks.emplace_back("pos-camera",
+                           [&] { corrs.visualReprojCorrs = DataAssociationForPosCameras(); });
+    }
+    if (Configor::IsRGBDIntegrated()) {
+        // visual velocity creation for rgbd cameras
+        tasks.emplace_back("rgbd", [&] { corrs.rgbdCorrs = DataAssociationForRGBDs(estDepth); });
+    }
+    if (Configor::IsVelCameraIntegrated()) {
+        // visual velocity creation for optical cameras
+        tasks.emplace_back("vel-camera",
+                           [&] { corrs.visualVelCorrs = DataAssociationForVelCameras(); });
+    }
+    if (Configor::IsEventIntegrated()) {
+        // visual velocity creation for event cameras
+        tasks.emplace_back("event",
+                           [&] { corrs.eventCorrs = DataAssociationForEventCameras(true); });
+    }
+    RunIndependentTasks(tasks, Configor::Preference::ConcurrentDataAssociation,
+                        "data association");
+    // deconstruct data from initialization
+    _initAsset = nullptr;
+}
+
+void CalibSolver::FinalizeBatchOptimizations(OptOption lastOption) {
     _viewer->ClearViewer(Viewer::VIEW_MAP);
     if (Configor::IsLiDARIntegrated()) {
         spdlog::info("build final lidar map and point-to-surfel correspondences...");
         // aligned map
-        const auto final = BuildGlobalMapOfLiDAR();
+        // the dense map is kept for output
+        const auto final = BuildGlobalMapOfLiDAR(true);
         _backup->lidarMap = std::get<0>(final);
         // use large 'ptsCountInEachScan' to keep all point-to-surfel corrs
         // lidar map and corr map would be added to the viewer in this function
-        _backup->lidarCorrs =
-            DataAssociationForLiDARs(std::get<0>(final), std::get<1>(final), 100000);
+        _backup->lidarCorrs = DataAssociationForLiDARs(
+            std::get<0>(final), std::get<1>(final), 100000,
+            IsOptionWith(OutputOption::LiDARMaps, Configor::Preference::Outputs));
     }
+    // monitor spatiotemporal parameters in sliding windows, using the final correspondences
+    this->SlidingWindowRefinement(lastOption, _backup->lidarCorrs);
     if (Configor::IsRadarIntegrated() && GetScaleType() == TimeDeriv::LIN_POS_SPLINE) {
         spdlog::info("build final radar map...");
         // radar map would be added to the viewer in this function
@@ -292,10 +629,116 @@ void CalibSolver::Process() {
         }
     }
 
-    _solveFinished = true;
+}
 
-    spdlog::info(
-        "Solving is finished! Focus on the viewer and press [ctrl+'s'] to save the current scene!");
-    spdlog::info("Focus on the viewer and press ['w', 's', 'a', 'd'] to zoom spline viewer!");
+void CalibSolver::Initialization() {
+    StageProfiler::Scope stageScope("Initialization");
+    auto outputParams = IsOptionWith(OutputOption::ParamInEachIter, Configor::Preference::Outputs);
+    if (outputParams) {
+        SaveStageCalibParam(_parMagr, "stage_0_init");
+    }
+    /**
+     * perform the initialization procedure to recover spatiotemporal parameters and
+     * interested states in the estimator, such as the splines and the gravity vector
+     */
+
+    /* initialize (recover) the rotation spline using raw angular velocity measurements from the
+     * gyroscope. If multiple gyroscopes (IMUs) are involved, the extrinsic rotations and time
+     * offsets would be also recovered
+     */
+    this->InitSO3Spline();
+    if (outputParams) {
+        SaveStageCalibParam(_parMagr, "stage_1_rot_fit");
+    }
+
+    /**
+     * perform sensor-inertial alignment to recover the gravity vector and extrinsic translations.
+     * for each type of sensor, the preparation is first performed to obtain necessary quantities
+     * for one-shot sensor-inertial alignment
+     */
+    this->InitPrepSensorInertialAlign();
+
+    /**
+     * rotation sequences of sensors are available now, coarse time offsets are found by correlating
+     * angular rate magnitudes, which narrow the time offset paddings in batch optimizations
+     */
+    this->InitCoarseTimeOffsets();
+
+    /**
+     * raw events are only used to extract norm flows in the preparation above, the batch
+     * optimization uses the extracted norm flows instead. As event streams are the most memory-
+     * consuming measurements, release them here
+     */
+    if (Configor::Preference::ReleaseConsumedData) {
+        _dataMagr->ReleaseEventMeasurements();
+    }
+
+    this->InitSensorInertialAlign();  // one-shot sensor-inertial alignment
+
+    if (outputParams) {
+        SaveStageCalibParam(_parMagr, "stage_2_align");
+    }
+
+    /**
+     * recover the linear scale spline using quantities from the one-shot sensor-inertial alignment
+     */
+    this->InitScaleSpline();
+
+    if (outputParams) {
+        SaveStageCalibParam(_parMagr, "stage_3_scale_fit");
+    }
+
+    /**
+     * this is the end of the initialization procedure, also the start of the batch optimizaion.
+     * some preparation operatiors would be performed here
+     */
+    this->InitPrepBatchOpt();
+    if (Configor::Preference::SaveCheckpoints) {
+        SaveStageCheckpoint("stage_3_scale_fit");
+    }
+}
+
+void CalibSolver::InitPrepSensorInertialAlign() {
+    StageProfiler::Scope stageScope("InitPrepSensorInertialAlign");
+    /**
+     * the stage graph of preparations, each stage only depends on the SO3 spline initialized above
+     * (reading it), and writes its own entries of the initialization asset and the parameters.
+     * thus the graph has a single level, and stages of integrated sensors can run concurrently
+     */
+    struct PrepStage {
+        std::string desc;
+        bool integrated;
+        std::function<void()> run;
+    };
+    const std::vector<PrepStage> stages = {
+        // visual-inertial (pos scale spline based)
+        {"pos-camera-inertial", Configor::IsPosCameraIntegrated(),
+         [this] { InitPrepPosCameraInertialAlign(); }},
+        // visual-inertial (vel scale spline based)
+        {"vel-camera-inertial", Configor::IsVelCameraIntegrated(),
+         [this] { InitPrepVelCameraInertialAlign(); }},
+        // rgbd-inertial
+        {"rgbd-inertial", Configor::IsRGBDIntegrated(), [this] { InitPrepRGBDInertialAlign(); }},
+        // lidar-inertial
+        {"lidar-inertial", Configor::IsLiDARIntegrated(), [this] { InitPrepLiDARInertialAlign(); }},
+        // radar-inertial
+        {"radar-inertial", Configor::IsRadarIntegrated(), [this] { InitPrepRadarInertialAlign(); }},
+        // inertial-inertial
+        {"inertial-inertial", Configor::DataStream::IMUTopics.size() > 1,
+         [this] { InitPrepInertialInertialAlign(); }},
+        // point-based optical flow event-inertial, i.e., 'InitPrepEventInertialAlign', is suspended
+        // line-based norm flow event-inertial
+        {"event-inertial", Configor::IsEventIntegrated(),
+         [this] { InitPrepEventInertialAlignLineBased(); }},
+    };
+
+    std::vector<std::pair<std::string, std::function<void()>>> tasks;
+    for (const auto &stage : stages) {
+        if (stage.integrated) {
+            tasks.emplace_back(stage.desc, stage.run);
+        }
+    }
+    RunIndependentTasks(tasks, Configor::Preference::ConcurrentInitPreparation,
+                        "initialization preparation");
 }
-}  // namespace ns_ikalibr
\ No newline at end of file
+}  // namespace ns_ikalibr
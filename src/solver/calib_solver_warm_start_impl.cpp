@@ -0,0 +1,256 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#include "calib/calib_data_manager.h"
+#include "calib/calib_param_manager.h"
+#include "calib/flat_param_io.h"
+#include "calib/spline_meta_cache.h"
+#include "calib/spline_sampler.h"
+#include "cereal/archives/binary.hpp"
+#include "cereal/types/map.hpp"
+#include "cereal/types/string.hpp"
+#include "solver/calib_solver.h"
+#include "util/status.hpp"
+#include "viewer/viewer.h"
+#include "spdlog/spdlog.h"
+#include "algorithm"
+#include "filesystem"
+#include "fstream"
+#include "sstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+// the archive type of a file output by ikalibr, decided by its extension
+static CerealArchiveType::Enum ArchiveTypeOf(const std::string &filename) {
+    const auto ext = std::filesystem::path(filename).extension().string();
+    for (const auto &[type, typeExt] : Configor::Preference::FileExtension) {
+        if (typeExt == ext) {
+            return type;
+        }
+    }
+    throw Status(Status::ERROR, "unknown format of file '{}' to warm-start from!", filename);
+}
+
+// whether the file is in the flat layout, see 'FlatParamIO'
+static bool IsFlatPath(const std::string &filename) {
+    return std::filesystem::path(filename).extension().string() == FlatParamIO::EXTENSION;
+}
+
+/**
+ * flat parameters only involve estimates, thus they are loaded into a deep copy of the current
+ * manager (for camera models), which is of the same sensor suite, otherwise loading fails
+ */
+static CalibParamManager::Ptr LoadFlatParams(const std::string &filename,
+                                             const CalibParamManager::Ptr &layout) {
+    std::stringstream stream;
+    {
+        cereal::BinaryOutputArchive ar(stream);
+        ar(*layout);
+    }
+    auto parMagr = CalibParamManager::Create();
+    {
+        cereal::BinaryInputArchive ar(stream);
+        ar(*parMagr);
+    }
+    try {
+        FlatParamIO::LoadParams(filename, parMagr);
+    } catch (const IKalibrStatus &status) {
+        spdlog::warn("{}", status.what);
+        return nullptr;
+    }
+    return parMagr;
+}
+
+// whether two parameter managers are of the same sensor suite, i.e., the same topics
+static bool IsSameSensorSuite(const CalibParamManager &a, const CalibParamManager &b) {
+    auto SameKeys = [](const auto &ma, const auto &mb) {
+        return ma.size() == mb.size() &&
+               std::equal(ma.cbegin(), ma.cend(), mb.cbegin(),
+                          [](const auto &x, const auto &y) { return x.first == y.first; });
+    };
+    return SameKeys(a.EXTRI.SO3_BiToBr, b.EXTRI.SO3_BiToBr) &&
+           SameKeys(a.EXTRI.SO3_RjToBr, b.EXTRI.SO3_RjToBr) &&
+           SameKeys(a.EXTRI.SO3_LkToBr, b.EXTRI.SO3_LkToBr) &&
+           SameKeys(a.EXTRI.SO3_CmToBr, b.EXTRI.SO3_CmToBr) &&
+           SameKeys(a.EXTRI.SO3_DnToBr, b.EXTRI.SO3_DnToBr) &&
+           SameKeys(a.EXTRI.SO3_EsToBr, b.EXTRI.SO3_EsToBr) &&
+           SameKeys(a.TEMPORAL.RS_READOUT, b.TEMPORAL.RS_READOUT) &&
+           SameKeys(a.INTRI.IMU, b.INTRI.IMU);
+}
+
+bool CalibSolver::TryWarmStart() {
+    const auto &paramPath = Configor::Preference::WarmStartParamPath;
+    const auto &splinePath = Configor::Preference::WarmStartSplinePath;
+    if (paramPath.empty()) {
+        return false;
+    }
+    /**
+     * without splines, the gravity-aligned trajectory has to be recovered anyway, i.e., the whole
+     * initialization. Visual sensors further require the SfM and tracking results from it
+     */
+    if (splinePath.empty()) {
+        spdlog::warn("no splines to warm-start from, perform the regular initialization...");
+        return false;
+    }
+    if (Configor::IsPosCameraIntegrated() || Configor::IsVelCameraIntegrated() ||
+        Configor::IsRGBDIntegrated() || Configor::IsEventIntegrated()) {
+        spdlog::warn(
+            "warm start is not supported for visual sensors, whose SfM and tracking results are "
+            "obtained in the initialization, perform the regular initialization...");
+        return false;
+    }
+    spdlog::info("try to warm-start from parameters '{}' and splines '{}'...", paramPath,
+                 splinePath);
+
+    auto parMagr = IsFlatPath(paramPath)
+                       ? LoadFlatParams(paramPath, _parMagr)
+                       : CalibParamManager::Load(paramPath, ArchiveTypeOf(paramPath));
+    if (parMagr == nullptr || !IsSameSensorSuite(*parMagr, *_parMagr)) {
+        spdlog::warn("parameters to warm-start from are of other sensors, perform the regular "
+                     "initialization...");
+        return false;
+    }
+
+    // deserialized into a copy, as the splines are shared with the viewer
+    SplineBundleType::Ptr splines;
+    if (IsFlatPath(splinePath)) {
+        splines = FlatParamIO::LoadSplines(splinePath);
+    } else {
+        splines = std::make_shared<SplineBundleType>(*_splines);
+        const auto archiveType = ArchiveTypeOf(splinePath);
+        std::ifstream file(splinePath, std::ios::in);
+        auto ar = GetInputArchiveVariant(file, archiveType);
+        SerializeByInputArchiveVariant(ar, archiveType, cereal::make_nvp("splines", *splines));
+    }
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    const double st = _dataMagr->GetCalibStartTimestamp();
+    const double et = _dataMagr->GetCalibEndTimestamp();
+    if (so3Spline.MinTime() > st || so3Spline.MaxTime() < et || scaleSpline.MinTime() > st ||
+        scaleSpline.MaxTime() < et) {
+        spdlog::warn("splines to warm-start from do not cover the data '[{:.3f}, {:.3f})', "
+                     "perform the regular initialization...",
+                     st, et);
+        return false;
+    }
+
+    // the derivative order of the scale spline for linear accelerations
+    int acceDeriv = 0;
+    switch (GetScaleType()) {
+        case TimeDeriv::LIN_ACCE_SPLINE:
+            acceDeriv = TimeDeriv::Deriv<TimeDeriv::LIN_ACCE_SPLINE, TimeDeriv::LIN_ACCE>();
+            break;
+        case TimeDeriv::LIN_VEL_SPLINE:
+            acceDeriv = TimeDeriv::Deriv<TimeDeriv::LIN_VEL_SPLINE, TimeDeriv::LIN_ACCE>();
+            break;
+        case TimeDeriv::LIN_POS_SPLINE:
+            acceDeriv = TimeDeriv::Deriv<TimeDeriv::LIN_POS_SPLINE, TimeDeriv::LIN_ACCE>();
+            break;
+    }
+
+    /**
+     * the prior states are validated by inertial measurements (subsampled) of all IMUs, which are
+     * predicted from the splines, extrinsics, time offsets, intrinsics, and the gravity
+     */
+    for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+        const auto &intri = parMagr->INTRI.IMU.at(topic);
+        const auto &SO3_BiToBr = parMagr->EXTRI.SO3_BiToBr.at(topic);
+        const Eigen::Vector3d &POS_BiInBr = parMagr->EXTRI.POS_BiInBr.at(topic);
+        const double timeOffset = parMagr->TEMPORAL.TO_BiToBr.at(topic);
+
+        const auto &mes = _dataMagr->GetIMUMeasurements(topic);
+        std::vector<IMUFrame::Ptr> subMes;
+        std::vector<double> times;
+        for (int i = 0; i < static_cast<int>(mes.size());
+             i += Configor::Preference::WarmStartSampleStride) {
+            subMes.push_back(mes.at(i));
+            times.push_back(mes.at(i)->GetTimestamp() + timeOffset);
+        }
+        const auto samples = SplineSampler::Evaluate(splines, times, acceDeriv, true);
+
+        double gyroSqrSum = 0.0, acceSqrSum = 0.0;
+        int count = 0;
+        for (int i = 0; i < static_cast<int>(subMes.size()); ++i) {
+            const auto &sample = samples.at(i);
+            if (!sample.valid) {
+                continue;
+            }
+            const auto &SO3_curBrToW = sample.so3;
+            const Eigen::Vector3d &angVelInW = SO3_curBrToW * sample.angVelInBody;
+            const Eigen::Vector3d &angAcceInW = SO3_curBrToW * sample.angAcceInBody;
+            const Eigen::Matrix3d &angVelMat = Sophus::SO3d::hat(angVelInW);
+            const Eigen::Matrix3d &angAcceMat = Sophus::SO3d::hat(angAcceInW);
+
+            const auto &est = intri->InvolveIntri(IMUIntrinsics::KinematicsToInertialMes(
+                subMes.at(i)->GetTimestamp(),
+                sample.scale +
+                    (angAcceMat + angVelMat * angVelMat) * SO3_curBrToW.matrix() * POS_BiInBr,
+                angVelInW, SO3_curBrToW * SO3_BiToBr, parMagr->GRAVITY));
+
+            gyroSqrSum += (subMes.at(i)->GetGyro() - est->GetGyro()).squaredNorm();
+            acceSqrSum += (subMes.at(i)->GetAcce() - est->GetAcce()).squaredNorm();
+            ++count;
+        }
+        if (count == 0) {
+            spdlog::warn("no inertial measurements of '{}' to validate the warm start, perform "
+                         "the regular initialization...",
+                         topic);
+            return false;
+        }
+        const double gyroRMSE = std::sqrt(gyroSqrSum / count);
+        const double acceRMSE = std::sqrt(acceSqrSum / count);
+        spdlog::info("warm-start residuals of IMU '{}': gyro rmse '{:.5f}', acce rmse '{:.5f}'",
+                     topic, gyroRMSE, acceRMSE);
+        if (gyroRMSE > Configor::Preference::WarmStartMaxGyroRMSE ||
+            acceRMSE > Configor::Preference::WarmStartMaxAcceRMSE) {
+            spdlog::warn("states to warm-start from do not fit the data of IMU '{}', perform the "
+                         "regular initialization...",
+                         topic);
+            return false;
+        }
+    }
+
+    // the parameter manager and splines are shared with the viewer, thus replaced in place
+    *_parMagr = *parMagr;
+    *_splines = *splines;
+    // metas cached for the bundle refer to the knot layout before the warm start
+    SplineMetaCache::GetCache(_splines)->Clear();
+    _viewer->UpdateSplineViewer();
+    spdlog::info("warm start is accepted, the initialization procedure is skipped");
+    return true;
+}
+}  // namespace ns_ikalibr
@@ -0,0 +1,544 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "solver/calib_solver_tpl.hpp"
+#include "calib/calib_param_manager.h"
+#include "cereal/types/map.hpp"
+#include "cereal/types/string.hpp"
+#include "util/utils_tpl.hpp"
+#include "util/stage_profiler.h"
+#include "sstream"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+// a parameter block of the spatiotemporal parameters, which is reconciled among windows
+struct ConsensusBlock {
+    double *data;
+    int size;
+    bool isSO3;
+};
+
+/**
+ * the reconciled parameter blocks of the parameter manager, which are traversed in a deterministic
+ * order, so that the blocks of two copies of parameter managers correspond one by one. The gravity
+ * is not involved, as it is expressed in the world frame, which is not shared among windows
+ */
+static std::vector<ConsensusBlock> ConsensusBlocksOf(const CalibParamManager::Ptr &parMagr,
+                                                     bool withIntrinsics = true) {
+    std::vector<ConsensusBlock> blocks;
+    auto InsertSO3Map = [&blocks](auto &parMap) {
+        for (auto &[topic, par] : parMap) {
+            blocks.push_back({par.data(), 4, true});
+        }
+    };
+    auto InsertPOSMap = [&blocks](auto &parMap) {
+        for (auto &[topic, par] : parMap) {
+            blocks.push_back({par.data(), 3, false});
+        }
+    };
+    auto InsertTOMap = [&blocks](auto &parMap) {
+        for (auto &[topic, par] : parMap) {
+            blocks.push_back({&par, 1, false});
+        }
+    };
+
+    // extrinsics
+    InsertSO3Map(parMagr->EXTRI.SO3_BiToBr);
+    InsertPOSMap(parMagr->EXTRI.POS_BiInBr);
+    InsertSO3Map(parMagr->EXTRI.SO3_RjToBr);
+    InsertPOSMap(parMagr->EXTRI.POS_RjInBr);
+    InsertSO3Map(parMagr->EXTRI.SO3_LkToBr);
+    InsertPOSMap(parMagr->EXTRI.POS_LkInBr);
+    InsertSO3Map(parMagr->EXTRI.SO3_CmToBr);
+    InsertPOSMap(parMagr->EXTRI.POS_CmInBr);
+    InsertSO3Map(parMagr->EXTRI.SO3_DnToBr);
+    InsertPOSMap(parMagr->EXTRI.POS_DnInBr);
+    InsertSO3Map(parMagr->EXTRI.SO3_EsToBr);
+    InsertPOSMap(parMagr->EXTRI.POS_EsInBr);
+
+    // time offsets and readout times
+    InsertTOMap(parMagr->TEMPORAL.TO_BiToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_RjToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_LkToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_CmToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_DnToBr);
+    InsertTOMap(parMagr->TEMPORAL.TO_EsToBr);
+    InsertTOMap(parMagr->TEMPORAL.RS_READOUT);
+    if (!withIntrinsics) {
+        return blocks;
+    }
+
+    // intrinsics
+    for (auto &[topic, intri] : parMagr->INTRI.IMU) {
+        blocks.push_back({intri->GYRO.BIAS.data(), 3, false});
+        blocks.push_back({intri->GYRO.MAP_COEFF.data(), 6, false});
+        blocks.push_back({intri->ACCE.BIAS.data(), 3, false});
+        blocks.push_back({intri->ACCE.MAP_COEFF.data(), 6, false});
+        blocks.push_back({intri->SO3_AtoG.data(), 4, true});
+    }
+    auto InsertPinhole = [&blocks](const ns_veta::PinholeIntrinsic::Ptr &intri) {
+        blocks.push_back({intri->FXAddress(), 1, false});
+        blocks.push_back({intri->FYAddress(), 1, false});
+        blocks.push_back({intri->CXAddress(), 1, false});
+        blocks.push_back({intri->CYAddress(), 1, false});
+    };
+    for (auto &[topic, intri] : parMagr->INTRI.Camera) {
+        InsertPinhole(intri);
+    }
+    for (auto &[topic, intri] : parMagr->INTRI.RGBD) {
+        InsertPinhole(intri->intri);
+        blocks.push_back({&intri->alpha, 1, false});
+        blocks.push_back({&intri->beta, 1, false});
+    }
+    return blocks;
+}
+
+// a deep copy of the parameter manager, intrinsics are not shared with the given one
+static CalibParamManager::Ptr CloneParamManager(const CalibParamManager::Ptr &parMagr) {
+    std::stringstream buffer;
+    {
+        cereal::BinaryOutputArchive ar(buffer);
+        ar(*parMagr);
+    }
+    auto clone = CalibParamManager::Create();
+    {
+        cereal::BinaryInputArchive ar(buffer);
+        ar(*clone);
+    }
+    return clone;
+}
+
+void CalibSolver::AddWindowFactors(
+    EstimatorPtr &estimator,
+    OptOption optOption,
+    const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs) const {
+    switch (GetScaleType()) {
+        case TimeDeriv::LIN_ACCE_SPLINE: {
+            for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+                this->AddAcceFactor<TimeDeriv::LIN_ACCE_SPLINE>(estimator, topic, optOption);
+                this->AddGyroFactor(estimator, topic, optOption);
+            }
+        } break;
+        case TimeDeriv::LIN_VEL_SPLINE: {
+            for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
+                this->AddRadarFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
+            }
+            for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+                this->AddAcceFactor<TimeDeriv::LIN_VEL_SPLINE>(estimator, topic, optOption);
+                this->AddGyroFactor(estimator, topic, optOption);
+            }
+        } break;
+        case TimeDeriv::LIN_POS_SPLINE: {
+            for (const auto &[topic, _] : Configor::DataStream::RadarTopics) {
+                this->AddRadarFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic, optOption);
+            }
+            for (const auto &[topic, _] : Configor::DataStream::IMUTopics) {
+                this->AddAcceFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic, optOption);
+                this->AddGyroFactor(estimator, topic, optOption);
+            }
+            for (const auto &[topic, corrs] : lidarPtsCorrs) {
+                this->AddLiDARPointToSurfelFactor<TimeDeriv::LIN_POS_SPLINE>(estimator, topic,
+                                                                             corrs, optOption);
+            }
+        } break;
+    }
+}
+
+bool CalibSolver::WindowedConsensusOptimization(
+    OptOption optOption,
+    const std::map<std::string, PointToSurfelCorrBuffer::Ptr> &lidarPtsCorrs,
+    double so3Dt,
+    double scaleDt) {
+    const double windowLen = Configor::Preference::DecomposedWindowLength;
+    const double st = _dataMagr->GetCalibStartTimestamp();
+    const double et = _dataMagr->GetCalibEndTimestamp();
+    // a decomposition is only worthwhile if several windows can be created
+    if (windowLen <= 0.0 || et - st < 2.0 * windowLen) {
+        return false;
+    }
+
+    /**
+     * split the time range into overlapping windows, a short tail is merged into the last window
+     */
+    const double overlap =
+        std::clamp(Configor::Preference::DecomposedWindowOverlap, 0.0, 0.5 * windowLen);
+    std::vector<std::pair<double, double>> ranges;
+    for (double t = st;; t += windowLen - overlap) {
+        ranges.emplace_back(t, std::min(t + windowLen, et));
+        if (ranges.back().second >= et) {
+            break;
+        }
+    }
+    if (ranges.size() > 1 && ranges.back().second - ranges.back().first < 0.5 * windowLen) {
+        ranges.pop_back();
+        ranges.back().second = et;
+    }
+    const int windowCount = static_cast<int>(ranges.size());
+    const Configor::Preference::ThreadSplit split(windowCount);
+    const int workerCount = split.Workers();
+    const int solveThreads = split.ThreadsPerWorker();
+    spdlog::info(
+        "decompose the batch optimization into '{}' time window(s) ('{:.3f}' s, overlap '{:.3f}' "
+        "s), solved by '{}' worker(s), each with '{}' thread(s)",
+        windowCount, windowLen, overlap, workerCount, solveThreads);
+
+    struct Window {
+        SplineBundleType::Ptr splines;
+        CalibParamManager::Ptr parMagr;
+        Estimator::Ptr estimator;
+        std::vector<ConsensusBlock> blocks;
+        // whether the block is free in the problem of this window
+        std::vector<bool> involved;
+        // the (scaled) dual variables, for rotation blocks, they are in the tangent space
+        std::vector<Eigen::VectorXd> duals;
+    };
+    std::vector<Window> windows(windowCount);
+
+    /**
+     * the consensus values, initialized from current parameters. For rotation blocks, they are
+     * stored as quaternions of 'Sophus::SO3d'
+     */
+    const auto globalBlocks = ConsensusBlocksOf(_parMagr);
+    std::vector<Eigen::VectorXd> consensus(globalBlocks.size());
+    for (int k = 0; k < static_cast<int>(globalBlocks.size()); ++k) {
+        consensus.at(k) = Eigen::Map<const Eigen::VectorXd>(globalBlocks.at(k).data,
+                                                            globalBlocks.at(k).size);
+    }
+
+    // only raw measurements and lidar point-to-surfel correspondences are fused in windows
+    auto BuildWindow = [&](Window &window, double wst, double wet) {
+        window.splines = FitSplineBundle(wst, wet, so3Dt, scaleDt, solveThreads);
+        window.parMagr = CloneParamManager(_parMagr);
+        window.estimator = Estimator::Create(window.splines, window.parMagr);
+        auto &estimator = window.estimator;
+        estimator->SetTemporalPadding(*_temporalPadding);
+        AddWindowFactors(estimator, optOption, lidarPtsCorrs);
+        // make this problem full rank
+        estimator->SetRefIMUParamsConstant();
+
+        window.blocks = ConsensusBlocksOf(window.parMagr);
+        if (window.blocks.size() != globalBlocks.size()) {
+            throw Status(Status::CRITICAL, "parameter blocks of time windows are inconsistent!");
+        }
+        window.involved.resize(window.blocks.size());
+        window.duals.resize(window.blocks.size());
+        for (int k = 0; k < static_cast<int>(window.blocks.size()); ++k) {
+            const auto &block = window.blocks.at(k);
+            window.involved.at(k) = estimator->HasParameterBlock(block.data) &&
+                                    !estimator->IsParameterBlockConstant(block.data);
+            window.duals.at(k) = Eigen::VectorXd::Zero(block.isSO3 ? 3 : block.size);
+        }
+    };
+
+    // solve the problem of a window, with augmented terms pulling blocks to their targets
+    static const std::string CONSENSUS_GROUP = "CONSENSUS";
+    const double weight = Configor::Preference::ConsensusWeight;
+    auto SolveWindow = [&](Window &window) {
+        auto &estimator = window.estimator;
+        estimator->RemoveResidualGroup(CONSENSUS_GROUP);
+        estimator->SetResidualGroup(CONSENSUS_GROUP);
+        for (int k = 0; k < static_cast<int>(window.blocks.size()); ++k) {
+            if (!window.involved.at(k)) {
+                continue;
+            }
+            const auto &block = window.blocks.at(k);
+            Eigen::VectorXd target;
+            if (block.isSO3) {
+                const Sophus::SO3d SO3_Target =
+                    Eigen::Map<Sophus::SO3d const>(consensus.at(k).data()) *
+                    Sophus::SO3d::exp(-window.duals.at(k));
+                target = Eigen::Map<const Eigen::Vector4d>(SO3_Target.data());
+            } else {
+                target = consensus.at(k) - window.duals.at(k);
+            }
+            estimator->AddConsensusConstraint(block.data, block.size, block.isSO3, target, weight);
+        }
+        estimator->SetResidualGroup("");
+        // we don't want to output the solving information
+        auto solveOpt = Estimator::DefaultSolverOptions(solveThreads, false,
+                                                        Configor::Preference::UseCudaInSolving);
+        estimator->Solve(solveOpt, _priori);
+    };
+
+    /**
+     * windows are built and solved in parallel, exceptions can not be thrown out of the parallel
+     * region, they are rethrown after it
+     */
+    std::vector<std::exception_ptr> exceptions(windowCount, nullptr);
+    auto RethrowExceptions = [&exceptions]() {
+        for (const auto &exception : exceptions) {
+            if (exception != nullptr) {
+                std::rethrow_exception(exception);
+            }
+        }
+    };
+#pragma omp parallel for num_threads(workerCount) schedule(dynamic) default(none) \
+    shared(windowCount, windows, ranges, exceptions, BuildWindow, split)
+    for (int i = 0; i < windowCount; ++i) {
+        const auto binding = split.EnterWorker();
+        try {
+            BuildWindow(windows.at(i), ranges.at(i).first, ranges.at(i).second);
+        } catch (...) {
+            exceptions.at(i) = std::current_exception();
+        }
+    }
+    RethrowExceptions();
+
+    for (int iter = 0; iter < Configor::Preference::ConsensusIterations; ++iter) {
+#pragma omp parallel for num_threads(workerCount) schedule(dynamic) default(none) \
+    shared(windowCount, windows, exceptions, SolveWindow, split)
+        for (int i = 0; i < windowCount; ++i) {
+            const auto binding = split.EnterWorker();
+            try {
+                SolveWindow(windows.at(i));
+            } catch (...) {
+                exceptions.at(i) = std::current_exception();
+            }
+        }
+        RethrowExceptions();
+
+        // the consensus update (average of primal and dual variables) and the dual update
+        double primalResidual = 0.0;
+        for (int k = 0; k < static_cast<int>(globalBlocks.size()); ++k) {
+            const auto &block = globalBlocks.at(k);
+            const int dim = block.isSO3 ? 3 : block.size;
+            Eigen::VectorXd sum = Eigen::VectorXd::Zero(dim);
+            int count = 0;
+            for (const auto &window : windows) {
+                if (!window.involved.at(k)) {
+                    continue;
+                }
+                const double *x = window.blocks.at(k).data;
+                if (block.isSO3) {
+                    const Sophus::SO3d SO3_Z =
+                        Eigen::Map<Sophus::SO3d const>(consensus.at(k).data());
+                    const Sophus::SO3d SO3_X = Eigen::Map<Sophus::SO3d const>(x);
+                    sum += (SO3_Z.inverse() * SO3_X * Sophus::SO3d::exp(window.duals.at(k))).log();
+                } else {
+                    sum += Eigen::Map<const Eigen::VectorXd>(x, dim) + window.duals.at(k);
+                }
+                ++count;
+            }
+            if (count == 0) {
+                continue;
+            }
+            if (block.isSO3) {
+                const Sophus::SO3d SO3_Z = Eigen::Map<Sophus::SO3d const>(consensus.at(k).data()) *
+                                           Sophus::SO3d::exp(sum / count);
+                consensus.at(k) = Eigen::Map<const Eigen::Vector4d>(SO3_Z.data());
+            } else {
+                consensus.at(k) = sum / count;
+            }
+            for (auto &window : windows) {
+                if (!window.involved.at(k)) {
+                    continue;
+                }
+                const double *x = window.blocks.at(k).data;
+                Eigen::VectorXd residual;
+                if (block.isSO3) {
+                    const Sophus::SO3d SO3_Z =
+                        Eigen::Map<Sophus::SO3d const>(consensus.at(k).data());
+                    residual = (SO3_Z.inverse() * Eigen::Map<Sophus::SO3d const>(x)).log();
+                } else {
+                    residual = Eigen::Map<const Eigen::VectorXd>(x, dim) - consensus.at(k);
+                }
+                window.duals.at(k) += residual;
+                primalResidual = std::max(primalResidual, residual.norm());
+            }
+        }
+        spdlog::info("'{}-th' consensus iteration finished, max primal residual: '{:.6f}'", iter,
+                     primalResidual);
+    }
+
+    // write consensus values back, which are refined in the following global batch optimization
+    for (int k = 0; k < static_cast<int>(globalBlocks.size()); ++k) {
+        Eigen::Map<Eigen::VectorXd>(globalBlocks.at(k).data, globalBlocks.at(k).size) =
+            consensus.at(k);
+    }
+    return true;
+}
+
+void CalibSolver::SlidingWindowRefinement(
+    OptOption optOption,
+    const std::map<std::string, PointToSurfelCorrBufferPtr> &lidarPtsCorrs) const {
+    const double windowLen = Configor::Preference::IncrementalWindowLength;
+    const double st = _dataMagr->GetCalibStartTimestamp();
+    const double et = _dataMagr->GetCalibEndTimestamp();
+    if (windowLen <= 0.0 || et - st < windowLen) {
+        return;
+    }
+    StageProfiler::Scope stageScope("SlidingWindowRefinement");
+    spdlog::info("refine the calibration incrementally in sliding windows ('{:.3f}' s)...",
+                 windowLen);
+
+    // the working copy of parameters, the batch estimate ('_parMagr') is kept as the reference
+    const auto parMagr = CloneParamManager(_parMagr);
+    const auto blocks = ConsensusBlocksOf(parMagr, false);
+    const auto refBlocks = ConsensusBlocksOf(_parMagr, false);
+    const int threads = Configor::Preference::AvailableThreads();
+
+    // the prior on blocks 'priorIdx' marginalized from old windows, empty for the first window
+    std::vector<int> priorIdx;
+    Eigen::VectorXd priorLinPoint;
+    Eigen::MatrixXd priorInfo;
+
+    int windowIdx = 0;
+    for (double wst = st; et - wst >= 0.5 * windowLen; wst += windowLen, ++windowIdx) {
+        // a short tail is merged into the last window
+        const double wet = et - wst < 1.5 * windowLen ? et : wst + windowLen;
+        auto splines = FitSplineBundle(wst, wet, Configor::Prior::KnotTimeDist::SO3Spline,
+                                       Configor::Prior::KnotTimeDist::ScaleSpline, threads);
+        auto estimator = Estimator::Create(splines, parMagr);
+        estimator->SetTemporalPadding(*_temporalPadding);
+        AddWindowFactors(estimator, optOption, lidarPtsCorrs);
+        // make this problem full rank
+        estimator->SetRefIMUParamsConstant();
+
+        if (!priorIdx.empty()) {
+            std::vector<double *> parBlocks;
+            std::vector<int> sizes;
+            std::vector<bool> isSO3;
+            for (int k : priorIdx) {
+                parBlocks.push_back(blocks.at(k).data);
+                sizes.push_back(blocks.at(k).size);
+                isSO3.push_back(blocks.at(k).isSO3);
+            }
+            estimator->AddMarginalPriorConstraint(parBlocks, sizes, isSO3, priorLinPoint,
+                                                  Configor::Preference::IncrementalPriorForgetting *
+                                                      priorInfo);
+        }
+
+        // we don't want to output the solving information
+        auto solveOpt = Estimator::DefaultSolverOptions(threads, false,
+                                                        Configor::Preference::UseCudaInSolving);
+        auto sum = estimator->Solve(solveOpt, _priori);
+
+        // spatiotemporal blocks are kept, all other free blocks (knots, biases, ...) marginalized
+        std::vector<int> keptIdx;
+        std::vector<double *> keptBlocks;
+        for (int k = 0; k < static_cast<int>(blocks.size()); ++k) {
+            if (estimator->HasParameterBlock(blocks.at(k).data) &&
+                !estimator->IsParameterBlockConstant(blocks.at(k).data)) {
+                keptIdx.push_back(k);
+                keptBlocks.push_back(blocks.at(k).data);
+            }
+        }
+        std::vector<double *> allBlocks, margBlocks;
+        estimator->GetParameterBlocks(&allBlocks);
+        for (double *block : allBlocks) {
+            if (!estimator->IsParameterBlockConstant(block) &&
+                std::find(keptBlocks.cbegin(), keptBlocks.cend(), block) == keptBlocks.cend()) {
+                margBlocks.push_back(block);
+            }
+        }
+        Eigen::MatrixXd info;
+        try {
+            info = estimator->GetMarginalHessianMatrix(keptBlocks, margBlocks, threads);
+        } catch (const IKalibrStatus &status) {
+            // the prior of old windows is kept
+            spdlog::warn("the '{}-th' window is not marginalized: {}", windowIdx, status.what);
+            continue;
+        }
+        priorIdx = keptIdx;
+        priorLinPoint.resize(0);
+        for (int k : keptIdx) {
+            const auto &block = blocks.at(k);
+            priorLinPoint.conservativeResize(priorLinPoint.size() + block.size);
+            priorLinPoint.tail(block.size) = Eigen::Map<const Eigen::VectorXd>(block.data,
+                                                                                 block.size);
+        }
+        priorInfo = info;
+
+        /**
+         * drifts w.r.t. the batch estimate, normalized by standard deviations from the marginal
+         * covariance (the pseudo-inverse of the marginal hessian matrix)
+         */
+        Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> solver(info);
+        const Eigen::VectorXd eigenValues = solver.eigenvalues();
+        Eigen::VectorXd invEigenValues = Eigen::VectorXd::Zero(eigenValues.size());
+        for (int i = 0; i < static_cast<int>(eigenValues.size()); ++i) {
+            if (eigenValues(i) > 1E-9 * eigenValues.cwiseAbs().maxCoeff()) {
+                invEigenValues(i) = 1.0 / eigenValues(i);
+            }
+        }
+        const Eigen::MatrixXd &V = solver.eigenvectors();
+        const Eigen::VectorXd variances =
+            (V * invEigenValues.asDiagonal() * V.transpose()).diagonal();
+        // rotation (deg), translation (m), and time offset (s), as well as their sigma multiples
+        double maxRot = 0.0, maxPos = 0.0, maxTime = 0.0, maxSigma = 0.0;
+        for (int i = 0, l = 0; i < static_cast<int>(keptIdx.size()); ++i) {
+            const auto &block = blocks.at(keptIdx.at(i));
+            const auto &refBlock = refBlocks.at(keptIdx.at(i));
+            Eigen::VectorXd drift;
+            if (block.isSO3) {
+                drift = (Eigen::Map<Sophus::SO3d const>(block.data) *
+                         Eigen::Map<Sophus::SO3d const>(refBlock.data).inverse())
+                            .log();
+                maxRot = std::max(maxRot, drift.norm() * CalibParamManager::RAD_TO_DEG);
+            } else if (block.size == 1) {
+                drift = Eigen::Map<const Eigen::VectorXd>(block.data, 1) -
+                        Eigen::Map<const Eigen::VectorXd>(refBlock.data, 1);
+                maxTime = std::max(maxTime, drift.norm());
+            } else {
+                drift = Eigen::Map<const Eigen::VectorXd>(block.data, block.size) -
+                        Eigen::Map<const Eigen::VectorXd>(refBlock.data, block.size);
+                maxPos = std::max(maxPos, drift.norm());
+            }
+            for (int j = 0; j < static_cast<int>(drift.size()); ++j) {
+                if (variances(l + j) > 0.0) {
+                    maxSigma = std::max(maxSigma, std::abs(drift(j)) / std::sqrt(variances(l + j)));
+                }
+            }
+            l += static_cast<int>(drift.size());
+        }
+        spdlog::info(
+            "'{}-th' window [{:.3f}, {:.3f}]: {}, max drift: rotation '{:.3f}' (deg), translation "
+            "'{:.4f}' (m), time offset '{:.5f}' (s), '{:.2f}' sigma",
+            windowIdx, wst, wet, sum.BriefReport(), maxRot, maxPos, maxTime, maxSigma);
+        if (maxSigma > Configor::Preference::IncrementalDriftSigma) {
+            spdlog::warn(
+                "spatiotemporal parameters in the '{}-th' window drift from the batch estimate by "
+                "'{:.2f}' sigma, which may be caused by changes of sensor mountings!",
+                windowIdx, maxSigma);
+        }
+        if (wet >= et) {
+            break;
+        }
+    }
+}
+}  // namespace ns_ikalibr
@@ -0,0 +1,163 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/columnar_writer.h"
+#include "util/status.hpp"
+#include "cstring"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+ColumnarWriter::ColumnarWriter(const std::string &filename,
+                               const std::vector<std::string> &columns)
+    : _file(filename, std::ios::out | std::ios::binary),
+      _columns(columns),
+      _block(columns.size()),
+      _rowCount(0) {
+    if (!_file.is_open()) {
+        return;
+    }
+    _file.write(MagicHeader().data(), static_cast<std::streamsize>(MagicHeader().size()));
+    Write(VERSION);
+    Write(static_cast<std::uint32_t>(_columns.size()));
+    for (const auto &name : _columns) {
+        Write(static_cast<std::uint32_t>(name.size()));
+        _file.write(name.data(), static_cast<std::streamsize>(name.size()));
+    }
+    for (auto &column : _block) {
+        column.reserve(BLOCK_ROWS);
+    }
+}
+
+ColumnarWriter::Ptr ColumnarWriter::Create(const std::string &filename,
+                                           const std::vector<std::string> &columns) {
+    return std::make_shared<ColumnarWriter>(filename, columns);
+}
+
+ColumnarWriter::~ColumnarWriter() {
+    if (IsOpen()) {
+        Flush();
+    }
+}
+
+bool ColumnarWriter::IsOpen() const { return _file.is_open(); }
+
+std::size_t ColumnarWriter::RowCount() const { return _rowCount; }
+
+void ColumnarWriter::AppendRow(const std::vector<double> &row) {
+    if (row.size() != _columns.size()) {
+        throw Status(Status::ERROR,
+                     "the row has '{}' values, while the columnar file has '{}' columns!!!",
+                     row.size(), _columns.size());
+    }
+    for (std::size_t i = 0; i < row.size(); ++i) {
+        _block.at(i).push_back(row.at(i));
+    }
+    ++_rowCount;
+    if (_block.front().size() >= BLOCK_ROWS) {
+        Flush();
+    }
+}
+
+void ColumnarWriter::Flush() {
+    if (_block.empty() || _block.front().empty()) {
+        return;
+    }
+    Write(static_cast<std::uint64_t>(_block.front().size()));
+    for (auto &column : _block) {
+        const auto [codec, payload] = EncodeColumn(column);
+        Write(static_cast<std::uint8_t>(codec));
+        Write(static_cast<std::uint64_t>(payload.size()));
+        _file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        column.clear();
+    }
+    _file.flush();
+}
+
+std::string ColumnarWriter::MagicHeader() { return "IKCOLUMN"; }
+
+std::pair<ColumnarWriter::Codec, std::string> ColumnarWriter::EncodeColumn(
+    const std::vector<double> &values) {
+    const std::size_t size = values.size();
+    std::string raw(size * sizeof(double), '\0');
+    std::memcpy(raw.data(), values.data(), raw.size());
+
+    // xor with the previous value, close values share sign, exponent and leading mantissa bits
+    std::vector<std::uint64_t> bits(size);
+    std::memcpy(bits.data(), values.data(), raw.size());
+    for (std::size_t i = size; i > 1; --i) {
+        bits[i - 1] ^= bits[i - 2];
+    }
+
+    // byte planes (from the most significant one), so that the zero bytes are contiguous
+    std::string planes(raw.size(), '\0');
+    for (std::size_t p = 0; p < sizeof(double); ++p) {
+        const int shift = static_cast<int>(8 * (sizeof(double) - 1 - p));
+        for (std::size_t i = 0; i < size; ++i) {
+            planes[p * size + i] = static_cast<char>((bits[i] >> shift) & 0xFF);
+        }
+    }
+
+    // run-length encoding of zero bytes: a zero byte is followed by the varint of the run length
+    std::string encoded;
+    encoded.reserve(raw.size() / 2);
+    for (std::size_t i = 0; i < planes.size();) {
+        if (planes[i] != '\0') {
+            encoded.push_back(planes[i++]);
+            continue;
+        }
+        std::uint64_t run = 0;
+        while (i < planes.size() && planes[i] == '\0') {
+            ++run, ++i;
+        }
+        encoded.push_back('\0');
+        do {
+            auto byte = static_cast<std::uint8_t>(run & 0x7F);
+            run >>= 7;
+            encoded.push_back(static_cast<char>(run ? byte | 0x80 : byte));
+        } while (run);
+        if (encoded.size() >= raw.size()) {
+            // not compressible
+            return {Codec::RAW, raw};
+        }
+    }
+    if (encoded.size() >= raw.size()) {
+        return {Codec::RAW, raw};
+    }
+    return {Codec::XOR_PLANE_RLE, encoded};
+}
+}  // namespace ns_ikalibr
@@ -0,0 +1,154 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/frame_encoder.h"
+#include "opencv2/imgcodecs.hpp"
+#include "spdlog/spdlog.h"
+#include "filesystem"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+FrameEncoder::FrameEncoder(std::string outputDir, Format format, int workers, int depth, double fps)
+    : _outputDir(std::move(outputDir)),
+      _format(format),
+      _depth(std::max(depth, 1)),
+      _fps(fps),
+      _pushed(0),
+      _failed(0),
+      _stop(false),
+      _pipe(nullptr) {
+    std::filesystem::create_directories(_outputDir);
+    // frames of a video must be written in order
+    if (_format == Format::VIDEO || workers < 1) {
+        workers = 1;
+    }
+    for (int i = 0; i < workers; ++i) {
+        _workers.emplace_back(&FrameEncoder::Encode, this);
+    }
+}
+
+FrameEncoder::Ptr FrameEncoder::Create(
+    const std::string &outputDir, Format format, int workers, int depth, double fps) {
+    return std::make_shared<FrameEncoder>(outputDir, format, workers, depth, fps);
+}
+
+void FrameEncoder::Push(cv::Mat frame) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cond.wait(lock, [this] { return static_cast<int>(_queue.size()) < _depth; });
+    _queue.emplace_back(_pushed++, std::move(frame));
+    _cond.notify_all();
+}
+
+int FrameEncoder::Finish() {
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cond.notify_all();
+    for (auto &worker : _workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    _workers.clear();
+    if (_pipe != nullptr) {
+        if (pclose(_pipe) != 0) {
+            ++_failed;
+            spdlog::warn("the 'ffmpeg' process for '{}' failed!", VideoFilename(_outputDir));
+        }
+        _pipe = nullptr;
+    }
+    return _failed;
+}
+
+FrameEncoder::~FrameEncoder() { Finish(); }
+
+std::string FrameEncoder::VideoFilename(const std::string &outputDir) {
+    return outputDir + "/render.mp4";
+}
+
+void FrameEncoder::Encode() {
+    while (true) {
+        std::pair<int, cv::Mat> item;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_queue.empty()) {
+                // stopped and all frames are encoded
+                return;
+            }
+            item = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        // a slot is released for 'Push'
+        _cond.notify_all();
+
+        bool good;
+        if (_format == Format::VIDEO) {
+            good = WriteVideoFrame(item.second);
+        } else {
+            char name[32];
+            std::snprintf(name, sizeof(name), "/frame_%06d.png", item.first);
+            // the fastest level of zlib, the encoding time rather than the size matters here
+            good = cv::imwrite(_outputDir + name, item.second, {cv::IMWRITE_PNG_COMPRESSION, 1});
+        }
+        if (!good) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            ++_failed;
+            spdlog::warn("encode the '{}'-th frame failed!", item.first);
+        }
+    }
+}
+
+bool FrameEncoder::WriteVideoFrame(const cv::Mat &frame) {
+    if (_pipe == nullptr) {
+        const auto cmd = fmt::format(
+            "ffmpeg -loglevel error -y -f rawvideo -pix_fmt bgr24 -s {}x{} -r {} -i - "
+            "-c:v libx264 -preset fast -pix_fmt yuv420p '{}'",
+            frame.cols, frame.rows, _fps, VideoFilename(_outputDir));
+        _pipe = popen(cmd.c_str(), "w");
+        if (_pipe == nullptr) {
+            spdlog::warn("start 'ffmpeg' failed, is it installed?");
+            return false;
+        }
+    }
+    cv::Mat continuous = frame.isContinuous() ? frame : frame.clone();
+    const std::size_t bytes = continuous.total() * continuous.elemSize();
+    return std::fwrite(continuous.data, 1, bytes, _pipe) == bytes;
+}
+}  // namespace ns_ikalibr
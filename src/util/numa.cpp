@@ -0,0 +1,149 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/numa.h"
+#include "spdlog/spdlog.h"
+#include "fstream"
+#include "sstream"
+#include "linux/mempolicy.h"
+#include "sys/syscall.h"
+#include "unistd.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+namespace {
+// parse a cpu list like '0-15,32-47'
+std::vector<int> ParseCPUList(const std::string &str) {
+    std::vector<int> cpus;
+    std::stringstream stream(str);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        const auto dash = range.find('-');
+        try {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (...) {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+struct Topology {
+    // ids of all nodes, and cpus of nodes having cpus (memory-only nodes are not candidates of
+    // thread placement)
+    std::vector<int> ids;
+    std::vector<std::vector<int>> cpus;
+};
+
+const Topology &LoadTopology() {
+    static const Topology topology = []() {
+        Topology topology;
+        // node ids could be sparse, and the count of possible ones is small
+        for (int i = 0; i < static_cast<int>(sizeof(unsigned long) * 8); ++i) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(i) + "/cpulist");
+            if (!file.is_open()) {
+                continue;
+            }
+            topology.ids.push_back(i);
+            std::string str;
+            std::getline(file, str);
+            if (auto cpus = ParseCPUList(str); !cpus.empty()) {
+                topology.cpus.push_back(cpus);
+            }
+        }
+        return topology;
+    }();
+    return topology;
+}
+}  // namespace
+
+const std::vector<std::vector<int>> &NUMATopology::Nodes() { return LoadTopology().cpus; }
+
+int NUMATopology::NodeCount() { return static_cast<int>(Nodes().size()); }
+
+bool NUMATopology::InterleaveMemory() {
+    const auto &ids = LoadTopology().ids;
+    if (ids.size() < 2) {
+        return false;
+    }
+    unsigned long mask = 0ul;
+    for (int id : ids) {
+        mask |= 1ul << id;
+    }
+    if (syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, &mask, sizeof(mask) * 8) != 0) {
+        spdlog::warn("interleave memory over '{}' numa nodes failed!", ids.size());
+        return false;
+    }
+    return true;
+}
+
+NUMABinding::NUMABinding(int node)
+    : _origin(),
+      _bound(false) {
+    const auto &nodes = NUMATopology::Nodes();
+    if (node < 0 || nodes.size() < 2) {
+        return;
+    }
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &_origin) != 0) {
+        return;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : nodes.at(node % nodes.size())) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    _bound = sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0;
+}
+
+NUMABinding::~NUMABinding() {
+    if (_bound) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &_origin);
+    }
+}
+
+bool NUMABinding::IsBound() const { return _bound; }
+}  // namespace ns_ikalibr
@@ -0,0 +1,131 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/point_buffer.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+PointBuffer::PointBuffer()
+    : _width(0),
+      _height(0) {}
+
+PointBuffer::PointBuffer(const IKalibrPointCloud &cloud)
+    : _xyz(3, cloud.size()),
+      _timestamps(cloud.size()),
+      _width(cloud.width),
+      _height(cloud.height) {
+    for (int i = 0; i < static_cast<int>(cloud.size()); ++i) {
+        const auto &p = cloud.points[i];
+        _xyz(0, i) = p.x;
+        _xyz(1, i) = p.y;
+        _xyz(2, i) = p.z;
+        _timestamps(i) = p.timestamp;
+    }
+}
+
+IKalibrPointCloud::Ptr PointBuffer::ToCloud() const {
+    IKalibrPointCloud::Ptr cloud(new IKalibrPointCloud);
+    cloud->resize(Size());
+    if (static_cast<Eigen::Index>(_width) * _height == Size()) {
+        cloud->width = _width;
+        cloud->height = _height;
+    } else {
+        cloud->width = static_cast<std::uint32_t>(Size());
+        cloud->height = 1;
+    }
+    bool isDense = true;
+    for (int i = 0; i < static_cast<int>(Size()); ++i) {
+        auto &p = cloud->points[i];
+        p.x = _xyz(0, i);
+        p.y = _xyz(1, i);
+        p.z = _xyz(2, i);
+        p.timestamp = _timestamps(i);
+        isDense = isDense && !IS_POS_NAN(p);
+    }
+    cloud->is_dense = isDense;
+    return cloud;
+}
+
+Eigen::Index PointBuffer::Size() const { return _xyz.cols(); }
+
+const PointBuffer::Coords &PointBuffer::GetCoords() const { return _xyz; }
+
+const PointBuffer::Times &PointBuffer::GetTimestamps() const { return _timestamps; }
+
+PointBuffer &PointBuffer::Transform(const Sophus::SE3f &trans) {
+    const Eigen::Matrix3f rot = trans.so3().matrix();
+    const Eigen::Vector3f &t = trans.translation();
+    // rows are contiguous, each output row is a vectorized linear combination of input rows
+    auto x = _xyz.row(0).array(), y = _xyz.row(1).array(), z = _xyz.row(2).array();
+    using Row = Eigen::Array<float, 1, Eigen::Dynamic>;
+    Row nx = rot(0, 0) * x + rot(0, 1) * y + rot(0, 2) * z + t(0);
+    Row ny = rot(1, 0) * x + rot(1, 1) * y + rot(1, 2) * z + t(1);
+    _xyz.row(2).array() = rot(2, 0) * x + rot(2, 1) * y + rot(2, 2) * z + t(2);
+    _xyz.row(0).array() = nx;
+    _xyz.row(1).array() = ny;
+    return *this;
+}
+
+PointBuffer::Mask PointBuffer::ValidMask(float minRange, float maxRange) const {
+    // nan values do not equal themselves, and any comparison with nan is false
+    const Eigen::Array<float, 1, Eigen::Dynamic> sqRange = _xyz.colwise().squaredNorm().array();
+    return (sqRange == sqRange) && (sqRange >= minRange * minRange) &&
+           (sqRange <= maxRange * maxRange);
+}
+
+PointBuffer PointBuffer::Select(const Mask &mask) const {
+    PointBuffer buffer;
+    const auto count = static_cast<Eigen::Index>(mask.count());
+    buffer._xyz.resize(3, count);
+    buffer._timestamps.resize(count);
+    buffer._width = static_cast<std::uint32_t>(count);
+    buffer._height = 1;
+    for (Eigen::Index i = 0, j = 0; i < Size(); ++i) {
+        if (mask(i)) {
+            buffer._xyz.col(j) = _xyz.col(i);
+            buffer._timestamps(j) = _timestamps(i);
+            ++j;
+        }
+    }
+    return buffer;
+}
+
+PointBuffer::VoxelKeys PointBuffer::ComputeVoxelKeys(float voxelSize) const {
+    return (_xyz.array() * (1.0f / voxelSize)).floor().cast<int>();
+}
+}  // namespace ns_ikalibr
@@ -0,0 +1,235 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/progress.h"
+#include "spdlog/spdlog.h"
+#include "algorithm"
+#include "cstdio"
+#include "chrono"
+#include "condition_variable"
+#include "mutex"
+#include "thread"
+#include "vector"
+#include "sys/ioctl.h"
+#include "unistd.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+namespace {
+double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+int TerminalWidth() {
+    struct winsize win {};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &win) != 0 || win.ws_col == 0) {
+        return 120;
+    }
+    return win.ws_col;
+}
+
+std::string StageStatus(const ProgressStage::State &state, double now) {
+    const long current = state.current.load(std::memory_order_relaxed);
+    const long total = state.total.load(std::memory_order_relaxed);
+    const double elapsed = std::max(now - state.startTime, 1E-6);
+    const double rate = static_cast<double>(current) / elapsed;
+
+    std::string status = state.label + ": ";
+    if (total > 0) {
+        const double percent = std::min(100.0 * static_cast<double>(current) / total, 100.0);
+        status += fmt::format("{:.1f}% ({}/{})", percent, current, total);
+    } else {
+        status += fmt::format("{}", current);
+    }
+    if (state.finished.load()) {
+        status += fmt::format(", done in {:.2f}s", elapsed);
+    } else {
+        status += fmt::format(", {:.1f}/s", rate);
+        if (total > current && rate > 0.0) {
+            status += fmt::format(", eta {:.0f}s", static_cast<double>(total - current) / rate);
+        }
+    }
+    return status;
+}
+
+struct Monitor {
+    // guards all fields below except 'mode'
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<ProgressStage::State>> stages;
+    std::atomic<ProgressMonitor::Mode> mode{ProgressMonitor::Mode::AUTO};
+    double redrawPeriod = 0.1, logPeriod = 5.0;
+    double lastLogTime = 0.0;
+    // whether a bar line (without the trailing new line) is on the terminal
+    bool lineDrawn = false;
+    bool stop = false;
+    std::thread worker;
+
+    Monitor()
+        : worker([this] { Run(); }) {}
+
+    ~Monitor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    void Run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stop) {
+            if (stages.empty()) {
+                // sleep until a stage is registered
+                cv.wait(lock, [this] { return stop || !stages.empty(); });
+                lastLogTime = NowSeconds();
+                continue;
+            }
+            cv.wait_for(lock, std::chrono::duration<double>(redrawPeriod));
+            if (!stop) {
+                ReportLocked(false);
+            }
+        }
+    }
+
+    [[nodiscard]] ProgressMonitor::Mode ActualMode() const {
+        auto m = mode.load();
+        if (m == ProgressMonitor::Mode::AUTO) {
+            m = isatty(STDOUT_FILENO) ? ProgressMonitor::Mode::BAR : ProgressMonitor::Mode::LOG;
+        }
+        return m;
+    }
+
+    // 'force' is true when a stage finishes, whose final state should be reported immediately
+    void ReportLocked(bool force) {
+        const auto m = ActualMode();
+        const double now = NowSeconds();
+        if (m == ProgressMonitor::Mode::BAR) {
+            std::string line;
+            for (const auto &state : stages) {
+                line += (line.empty() ? "" : " | ") + StageStatus(*state, now);
+            }
+            const auto width = static_cast<std::size_t>(std::max(TerminalWidth() - 1, 10));
+            if (line.size() > width) {
+                line = line.substr(0, width - 3) + "...";
+            }
+            // clear the line, then redraw in place
+            std::printf("\r\033[K%s", line.c_str());
+            lineDrawn = true;
+        } else if (m == ProgressMonitor::Mode::LOG &&
+                   (force || now - lastLogTime >= logPeriod)) {
+            std::string line;
+            for (const auto &state : stages) {
+                line += (line.empty() ? "" : "; ") + StageStatus(*state, now);
+            }
+            spdlog::info("[progress] {}", line);
+            lastLogTime = now;
+        }
+        stages.erase(std::remove_if(stages.begin(), stages.end(),
+                                    [](const auto &state) { return state->finished.load(); }),
+                     stages.end());
+        if (lineDrawn && stages.empty()) {
+            // all stages finished, keep the last line and move to a new one
+            std::printf("\n");
+            lineDrawn = false;
+        }
+        std::fflush(stdout);
+    }
+};
+
+Monitor &GetMonitor() {
+    static Monitor monitor;
+    return monitor;
+}
+}  // namespace
+
+// -------------
+// ProgressStage
+// -------------
+ProgressStage::ProgressStage(const std::string &label, long total)
+    : _state(std::make_shared<State>()) {
+    _state->label = label;
+    _state->current = 0;
+    _state->total = total;
+    _state->finished = false;
+    _state->startTime = NowSeconds();
+    ProgressMonitor::Register(_state);
+}
+
+ProgressStage::Ptr ProgressStage::Create(const std::string &label, long total) {
+    return std::make_shared<ProgressStage>(label, total);
+}
+
+ProgressStage::~ProgressStage() { Finish(); }
+
+void ProgressStage::Finish() {
+    if (!_state->finished.exchange(true)) {
+        ProgressMonitor::Report();
+    }
+}
+
+// ---------------
+// ProgressMonitor
+// ---------------
+void ProgressMonitor::SetMode(Mode mode) { GetMonitor().mode = mode; }
+
+void ProgressMonitor::SetPeriods(double redrawPeriod, double logPeriod) {
+    auto &monitor = GetMonitor();
+    std::lock_guard<std::mutex> lock(monitor.mutex);
+    monitor.redrawPeriod = std::max(redrawPeriod, 0.01);
+    monitor.logPeriod = std::max(logPeriod, 0.01);
+}
+
+void ProgressMonitor::Register(const std::shared_ptr<ProgressStage::State> &state) {
+    auto &monitor = GetMonitor();
+    {
+        std::lock_guard<std::mutex> lock(monitor.mutex);
+        monitor.stages.push_back(state);
+    }
+    monitor.cv.notify_all();
+}
+
+void ProgressMonitor::Report() {
+    auto &monitor = GetMonitor();
+    std::lock_guard<std::mutex> lock(monitor.mutex);
+    monitor.ReportLocked(true);
+}
+
+}  // namespace ns_ikalibr
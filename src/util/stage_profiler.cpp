@@ -0,0 +1,237 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/stage_profiler.h"
+#include "cereal/archives/json.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+#include "spdlog/spdlog.h"
+#include "fstream"
+#include "map"
+#include "thread"
+#include "ctime"
+#include "sys/resource.h"
+#include "unistd.h"
+#include "algorithm"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+namespace {
+// the stack of stage paths of the current thread
+thread_local std::vector<std::string> StageStack;
+
+// the thread initializing statics is regarded as the main thread
+const std::thread::id MainThreadId = std::this_thread::get_id();
+
+struct StageRegistry {
+    std::mutex mutex;
+    std::vector<StageProfiler::Record> records;
+    std::map<std::string, std::size_t> indices;
+    std::vector<StageProfiler::Counter> counters;
+    std::map<std::string, std::size_t> counterIndices;
+    // the innermost stage of the main thread, which hosts stages of worker threads
+    std::string mainPath;
+};
+
+StageRegistry &Registry() {
+    static StageRegistry registry;
+    return registry;
+}
+}  // namespace
+
+StageProfiler::Scope::Scope(const std::string &stage)
+    : _wallStart(std::chrono::steady_clock::now()),
+      _cpuStart(ProcessCPUTime()),
+      _span("stage", stage) {
+    std::string parent;
+    if (!StageStack.empty()) {
+        parent = StageStack.back();
+    } else if (std::this_thread::get_id() != MainThreadId) {
+        auto &registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        parent = registry.mainPath;
+    }
+    _path = parent.empty() ? stage : parent + '/' + stage;
+    StageStack.push_back(_path);
+    if (std::this_thread::get_id() == MainThreadId) {
+        auto &registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.mainPath = _path;
+    }
+}
+
+StageProfiler::Scope::~Scope() {
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - _wallStart;
+    Accumulate(_path, wall.count(), ProcessCPUTime() - _cpuStart);
+    StageStack.pop_back();
+    if (std::this_thread::get_id() == MainThreadId) {
+        auto &registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.mainPath = StageStack.empty() ? std::string() : StageStack.back();
+    }
+}
+
+void StageProfiler::Reset() {
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.records.clear();
+    registry.indices.clear();
+    registry.counters.clear();
+    registry.counterIndices.clear();
+}
+
+std::vector<StageProfiler::Record> StageProfiler::Records() {
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.records;
+}
+
+std::string StageProfiler::CurrentStage() {
+    if (!StageStack.empty()) {
+        return StageStack.back();
+    }
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.mainPath;
+}
+
+void StageProfiler::Count(const std::string &name, double value) {
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto iter = registry.counterIndices.find(name);
+    if (iter == registry.counterIndices.cend()) {
+        iter = registry.counterIndices.insert({name, registry.counters.size()}).first;
+        registry.counters.push_back({name, 0.0});
+    }
+    registry.counters.at(iter->second).value += value;
+}
+
+std::vector<StageProfiler::Counter> StageProfiler::Counters() {
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.counters;
+}
+
+bool StageProfiler::SaveReport(const std::string &filename) {
+    std::ofstream file(filename, std::ios::out);
+    if (!file.is_open()) {
+        spdlog::warn("the stage report can not be saved to '{}'", filename);
+        return false;
+    }
+    const auto records = Records();
+    const auto counters = Counters();
+    const int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+    cereal::JSONOutputArchive ar(file);
+    ar(cereal::make_nvp("HardwareThreads", hardwareThreads), cereal::make_nvp("Stages", records),
+       cereal::make_nvp("Counters", counters));
+    return true;
+}
+
+std::optional<StageProfiler::Report> StageProfiler::LoadReport(const std::string &filename) {
+    std::ifstream file(filename, std::ios::in);
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+    Report report{};
+    try {
+        cereal::JSONInputArchive ar(file);
+        ar(cereal::make_nvp("HardwareThreads", report.hardwareThreads),
+           cereal::make_nvp("Stages", report.stages));
+        try {
+            ar(cereal::make_nvp("Counters", report.counters));
+        } catch (const cereal::Exception &) {
+            // reports saved before counters were introduced
+            report.counters.clear();
+        }
+    } catch (const cereal::Exception &exception) {
+        spdlog::warn("the stage report '{}' can not be loaded: '{}'", filename, exception.what());
+        return std::nullopt;
+    }
+    return report;
+}
+
+void StageProfiler::Accumulate(const std::string &path, double wallTime, double cpuTime) {
+    const auto [peakRSS, curRSS] = ResidentMemory();
+    const double threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto iter = registry.indices.find(path);
+    if (iter == registry.indices.cend()) {
+        Record record{};
+        record.stage = path;
+        record.depth = static_cast<int>(std::count(path.cbegin(), path.cend(), '/'));
+        iter = registry.indices.insert({path, registry.records.size()}).first;
+        registry.records.push_back(record);
+    }
+    auto &record = registry.records.at(iter->second);
+    ++record.count;
+    record.wallTime += wallTime;
+    record.cpuTime += cpuTime;
+    record.threadUtilization =
+        record.wallTime > 0.0 ? record.cpuTime / (record.wallTime * threads) : 0.0;
+    record.peakRSS = std::max(record.peakRSS, peakRSS);
+    record.curRSS = curRSS;
+}
+
+double StageProfiler::ProcessCPUTime() {
+    timespec ts{};
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+        return 0.0;
+    }
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) * 1E-9;
+}
+
+std::pair<double, double> StageProfiler::ResidentMemory() {
+    // the peak resident memory, in KB on linux
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const double peak = static_cast<double>(usage.ru_maxrss) / 1024.0;
+
+    // the current resident memory, the second field of 'statm' in pages
+    double cur = 0.0;
+    std::ifstream statm("/proc/self/statm");
+    std::size_t size, resident;
+    if (statm >> size >> resident) {
+        cur = static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) /
+              (1024.0 * 1024.0);
+    }
+    return {peak, cur};
+}
+
+}  // namespace ns_ikalibr
@@ -0,0 +1,209 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "util/trace_recorder.h"
+#include "spdlog/spdlog.h"
+#include "chrono"
+#include "fstream"
+#include "memory"
+#include "mutex"
+#include "vector"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+namespace {
+struct TraceEvent {
+    const char *category;
+    std::string name;
+    char phase;
+    std::int64_t ts, dur;
+    double value;
+};
+
+// events of a thread, the mutex is only contended when events are saved or cleared
+struct ThreadTraceBuffer {
+    int tid;
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+};
+
+TraceRegistry &Registry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+ThreadTraceBuffer &LocalBuffer() {
+    thread_local std::shared_ptr<ThreadTraceBuffer> buffer = [] {
+        auto &registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto newBuffer = std::make_shared<ThreadTraceBuffer>();
+        newBuffer->tid = static_cast<int>(registry.buffers.size());
+        registry.buffers.push_back(newBuffer);
+        return newBuffer;
+    }();
+    return *buffer;
+}
+
+void Append(TraceEvent event) {
+    auto &buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(std::move(event));
+}
+
+std::string EscapeJSON(const std::string &str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (char c : str) {
+        switch (c) {
+            case '"':
+                escaped += "\\\"";
+                break;
+            case '\\':
+                escaped += "\\\\";
+                break;
+            case '\n':
+                escaped += "\\n";
+                break;
+            default:
+                escaped += c;
+        }
+    }
+    return escaped;
+}
+}  // namespace
+
+std::atomic_bool TraceRecorder::_enabled(false);
+
+TraceRecorder::Span::Span(const char *category, const char *name)
+    : _active(IsEnabled()),
+      _category(category),
+      _start(0) {
+    if (_active) {
+        _name = name;
+        _start = NowMicros();
+    }
+}
+
+TraceRecorder::Span::Span(const char *category, const std::string &name)
+    : _active(IsEnabled()),
+      _category(category),
+      _start(0) {
+    if (_active) {
+        _name = name;
+        _start = NowMicros();
+    }
+}
+
+TraceRecorder::Span::~Span() {
+    if (_active) {
+        Complete(_category, _name, _start, NowMicros() - _start);
+    }
+}
+
+void TraceRecorder::Start() {
+    {
+        auto &registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &buffer : registry.buffers) {
+            std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+            buffer->events.clear();
+        }
+    }
+    _enabled = true;
+}
+
+void TraceRecorder::Stop() { _enabled = false; }
+
+bool TraceRecorder::Save(const std::string &filename) {
+    std::ofstream file(filename, std::ios::out);
+    if (!file.is_open()) {
+        spdlog::warn("the trace can not be saved to '{}'", filename);
+        return false;
+    }
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto &registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto &buffer : registry.buffers) {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const auto &event : buffer->events) {
+            file << (first ? "\n" : ",\n") << "{\"pid\":1,\"tid\":" << buffer->tid
+                 << ",\"ph\":\"" << event.phase << "\",\"cat\":\"" << event.category
+                 << "\",\"name\":\"" << EscapeJSON(event.name) << "\",\"ts\":" << event.ts;
+            if (event.phase == 'X') {
+                file << ",\"dur\":" << event.dur;
+            } else if (event.phase == 'C') {
+                file << ",\"args\":{\"value\":" << event.value << '}';
+            }
+            file << '}';
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return true;
+}
+
+void TraceRecorder::Complete(const char *category,
+                             const std::string &name,
+                             std::int64_t start,
+                             std::int64_t duration) {
+    if (!IsEnabled()) {
+        return;
+    }
+    Append({category, name, 'X', start, duration, 0.0});
+}
+
+void TraceRecorder::Counter(const char *category, const std::string &name, double value) {
+    if (!IsEnabled()) {
+        return;
+    }
+    Append({category, name, 'C', NowMicros(), 0, value});
+}
+
+std::int64_t TraceRecorder::NowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace ns_ikalibr
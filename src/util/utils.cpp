@@ -36,6 +36,7 @@
 #include "filesystem"
 #include "ctraj/core/pose.hpp"
 #include "spdlog/spdlog.h"
+#include "spdlog/async.h"
 #include "regex"
 #include "random"
 #include "opencv2/imgproc.hpp"
@@ -54,6 +55,27 @@ void ConfigSpdlog() {
     spdlog::set_level(spdlog::level::debug);
 }
 
+void ConfigAsyncSpdlog(std::size_t queueSize) {
+    auto syncLogger = spdlog::default_logger();
+    const auto level = syncLogger->level();
+    // a single background thread keeps the order of messages
+    spdlog::init_thread_pool(queueSize, 1);
+    auto asyncLogger = std::make_shared<spdlog::async_logger>(
+        syncLogger->name(), syncLogger->sinks().begin(), syncLogger->sinks().end(),
+        spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+    asyncLogger->set_pattern("%^[%L]%$-[%t]-[%H:%M:%S.%e] %v");
+    asyncLogger->set_level(level);
+    // warnings and errors are flushed immediately, they are what matters when a program dies
+    asyncLogger->flush_on(spdlog::level::warn);
+    spdlog::set_default_logger(asyncLogger);
+    // drain the queue before exit, otherwise the latest messages would be lost
+    static bool registered = false;
+    if (!registered) {
+        std::atexit([] { spdlog::shutdown(); });
+        registered = true;
+    }
+}
+
 void PrintIKalibrLibInfo() {
     std::cout << "+----------------------------------------------------------+\n"
                  "|     ██▓ ██ ▄█▀▄▄▄       ██▓     ██▓ ▄▄▄▄    ██▀███       |\n"
@@ -168,6 +190,41 @@ std::vector<std::size_t> SamplingWoutReplace(std::default_random_engine &engine,
     return res;
 }
 
+std::uint64_t CounterBasedRandom(std::uint64_t seed, std::uint64_t stream, std::uint64_t counter) {
+    // the multiplier and the key increment (golden ratio) of Philox-2x64
+    constexpr std::uint64_t PHILOX_M = 0xD2B74407B1CE6E93ULL, PHILOX_W = 0x9E3779B97F4A7C15ULL;
+    std::uint64_t ctr0 = counter, ctr1 = stream, key = seed;
+    for (int round = 0; round < 10; ++round) {
+        const auto prod = static_cast<unsigned __int128>(PHILOX_M) * ctr0;
+        const auto hi = static_cast<std::uint64_t>(prod >> 64);
+        const auto lo = static_cast<std::uint64_t>(prod);
+        ctr0 = hi ^ key ^ ctr1;
+        ctr1 = lo;
+        key += PHILOX_W;
+    }
+    return ctr0;
+}
+
+std::vector<std::size_t> SamplingWoutReplace(std::uint64_t seed,
+                                             std::uint64_t stream,
+                                             std::size_t size,
+                                             std::size_t num) {
+    // the partial Fisher-Yates shuffle, the i-th swap is decided by the i-th number of the stream
+    std::vector<std::size_t> idxPool(size);
+    for (std::size_t i = 0; i != size; ++i) {
+        idxPool.at(i) = i;
+    }
+    for (std::size_t i = 0; i != num; ++i) {
+        // map the random number to [0, size - i) by the multiply-shift
+        const auto r = CounterBasedRandom(seed, stream, i);
+        const auto j =
+            i + static_cast<std::size_t>((static_cast<unsigned __int128>(r) * (size - i)) >> 64);
+        std::swap(idxPool.at(i), idxPool.at(j));
+    }
+    idxPool.resize(num);
+    return idxPool;
+}
+
 std::vector<std::size_t> SamplingWithReplace(std::default_random_engine &engine,
                                              std::size_t num,
                                              std::size_t start,
@@ -0,0 +1,228 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "viewer/offscreen_renderer.h"
+#include "pangolin/gl/gl.h"
+#include "pangolin/display/opengl_render_state.h"
+#include "opencv2/core.hpp"
+#include "spdlog/spdlog.h"
+
+#ifdef IKALIBR_WITH_EGL
+#include "EGL/egl.h"
+#endif
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+OffscreenRenderer::OffscreenRenderer(
+    std::vector<std::string> views, int cols, int cellSize, float near, float far)
+    : _views(std::move(views)),
+      _cols(std::max(cols, 1)),
+      _rows(0),
+      _cellSize(cellSize),
+      _near(near),
+      _far(far),
+      _display(nullptr),
+      _surface(nullptr),
+      _context(nullptr),
+      _nextId(0) {
+    _rows = (static_cast<int>(_views.size()) + _cols - 1) / _cols;
+    for (const auto &view : _views) {
+        _entities[view];
+    }
+    if (!InitContext()) {
+        spdlog::warn("offscreen rendering (egl) is unavailable!");
+    }
+}
+
+OffscreenRenderer::Ptr OffscreenRenderer::Create(
+    const std::vector<std::string> &views, int cols, int cellSize, float near, float far) {
+    return std::make_shared<OffscreenRenderer>(views, cols, cellSize, near, far);
+}
+
+OffscreenRenderer::~OffscreenRenderer() {
+    // entities may release gpu resources in their destructors
+    _entities.clear();
+#ifdef IKALIBR_WITH_EGL
+    if (_display != nullptr) {
+        eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (_context != nullptr) {
+            eglDestroyContext(_display, _context);
+        }
+        if (_surface != nullptr) {
+            eglDestroySurface(_display, _surface);
+        }
+        eglTerminate(_display);
+    }
+#endif
+}
+
+bool OffscreenRenderer::IsValid() const { return _context != nullptr; }
+
+bool OffscreenRenderer::InitContext() {
+#ifdef IKALIBR_WITH_EGL
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || eglInitialize(display, nullptr, nullptr) != EGL_TRUE) {
+        return false;
+    }
+    _display = display;
+
+    // clang-format off
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE};
+    // clang-format on
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) != EGL_TRUE ||
+        numConfigs < 1) {
+        return false;
+    }
+    const EGLint surfaceAttribs[] = {EGL_WIDTH, _cols * _cellSize, EGL_HEIGHT, _rows * _cellSize,
+                                     EGL_NONE};
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    if (surface == EGL_NO_SURFACE) {
+        return false;
+    }
+    _surface = surface;
+
+    // desktop opengl (rather than opengl es), as entities draw by the legacy pipeline
+    if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE) {
+        return false;
+    }
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+    if (context == EGL_NO_CONTEXT) {
+        return false;
+    }
+    if (eglMakeCurrent(display, surface, surface, context) != EGL_TRUE) {
+        eglDestroyContext(display, context);
+        return false;
+    }
+    _context = context;
+#ifdef HAVE_GLEW
+    // gl functions beyond 1.1 (e.g., buffers of 'LODCloud') are loaded by glew
+    glewInit();
+#endif
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t OffscreenRenderer::AddEntity(const ns_viewer::Entity::Ptr &entity,
+                                         const std::string &view) {
+    const auto id = _nextId++;
+    _entities.at(view).insert({id, entity});
+    return id;
+}
+
+std::vector<std::size_t> OffscreenRenderer::AddEntity(
+    const std::vector<ns_viewer::Entity::Ptr> &entities, const std::string &view) {
+    std::vector<std::size_t> ids;
+    ids.reserve(entities.size());
+    for (const auto &entity : entities) {
+        ids.push_back(AddEntity(entity, view));
+    }
+    return ids;
+}
+
+void OffscreenRenderer::RemoveEntity(const std::vector<std::size_t> &ids,
+                                     const std::string &view) {
+    auto &entities = _entities.at(view);
+    for (const auto &id : ids) {
+        entities.erase(id);
+    }
+}
+
+cv::Mat OffscreenRenderer::Render(const std::map<std::string, ns_viewer::Posef> &camPoses) {
+    const int width = _cols * _cellSize, height = _rows * _cellSize;
+    cv::Mat image(height, width, CV_8UC3, cv::Scalar(255, 255, 255));
+    if (!IsValid()) {
+        return image;
+    }
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, width, height);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const float focal = FOCAL_SCALE * static_cast<float>(_cellSize);
+    const float center = 0.5f * static_cast<float>(_cellSize);
+    auto projection = pangolin::ProjectionMatrixRDF_TopLeft(
+        _cellSize, _cellSize, focal, focal, center, center, _near, _far);
+
+    for (int i = 0; i < static_cast<int>(_views.size()); ++i) {
+        const auto &view = _views.at(i);
+        auto iter = camPoses.find(view);
+        if (iter == camPoses.cend()) {
+            continue;
+        }
+        // the origin of gl viewports is at the bottom left
+        const int x = (i % _cols) * _cellSize, y = (_rows - 1 - i / _cols) * _cellSize;
+        glViewport(x, y, _cellSize, _cellSize);
+        glScissor(x, y, _cellSize, _cellSize);
+
+        glMatrixMode(GL_PROJECTION);
+        projection.Load();
+        // from the world to the camera
+        Eigen::Matrix4f viewMat = Eigen::Matrix4f::Identity();
+        viewMat.topLeftCorner<3, 3>() = iter->second.rotation.transpose();
+        viewMat.topRightCorner<3, 1>() =
+            -iter->second.rotation.transpose() * iter->second.translation;
+        glMatrixMode(GL_MODELVIEW);
+        glLoadMatrixf(viewMat.data());
+
+        for (const auto &[id, entity] : _entities.at(view)) {
+            entity->Draw();
+        }
+    }
+    glFinish();
+
+    // rows are read from the bottom, and packed without padding
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    cv::Mat bgr(height, width, CV_8UC3);
+    glReadPixels(0, 0, width, height, GL_BGR, GL_UNSIGNED_BYTE, bgr.data);
+    cv::flip(bgr, image, 0);
+    return image;
+}
+}  // namespace ns_ikalibr
@@ -33,9 +33,12 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "viewer/viewer.h"
+#include "viewer/visual_lod_cloud.h"
+#include "util/trace_recorder.h"
 #include "util/status.hpp"
 #include "core/pts_association.h"
 #include "calib/calib_param_manager.h"
+#include "calib/spline_sampler.h"
 #include "sensor/rgbd.h"
 #include "factor/data_correspondence.h"
 #include "tiny-viewer/object/landmark.h"
@@ -49,9 +52,36 @@
 #include "sensor/event.h"
 #include "core/feature_tracking.h"
 #include "core/event_trace_sac.h"
+#include "cereal/archives/binary.hpp"
+#include "cereal/types/memory.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+#include "fstream"
+#include "thread"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+
+// combine hashes of values, i.e., the content of entities to be cached
+template <typename Type>
+void HashCombine(std::size_t &seed, const Type &val) {
+    seed ^= std::hash<Type>()(val) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+template <typename PointType>
+std::size_t HashCloud(std::size_t seed, const pcl::PointCloud<PointType> &cloud) {
+    HashCombine(seed, cloud.size());
+    for (const auto &p : cloud.points) {
+        HashCombine(seed, p.x), HashCombine(seed, p.y), HashCombine(seed, p.z);
+    }
+    return seed;
+}
+
+std::size_t HashColour(std::size_t seed, const ns_viewer::Colour &color, float size) {
+    HashCombine(seed, color.r), HashCombine(seed, color.g), HashCombine(seed, color.b);
+    HashCombine(seed, color.a), HashCombine(seed, size);
+    return seed;
+}
 }
 
 namespace ns_ikalibr {
@@ -61,54 +91,222 @@ const std::string Viewer::VIEW_SPLINE = "VIEW_SPLINE";
 const std::string Viewer::VIEW_MAP = "VIEW_MAP";
 const std::string Viewer::VIEW_ASSOCIATION = "VIEW_ASSOCIATION";
 
-ns_ikalibr::Viewer::Viewer(CalibParamManager::Ptr parMagr, SplineBundleType::Ptr splines)
+ns_ikalibr::Viewer::Viewer(CalibParamManager::Ptr parMagr,
+                           SplineBundleType::Ptr splines,
+                           ViewerModeType mode)
     : Parent(GenViewerConfigor()),
       _parMagr(std::move(parMagr)),
-      _splines(std::move(splines)) {
+      _splines(std::move(splines)),
+      _revision(0),
+      _mode(mode),
+      _recorder(nullptr) {
     // create containers for entities
     _entities.insert({VIEW_SENSORS, {}});
     _entities.insert({VIEW_SPLINE, {}});
     _entities.insert({VIEW_MAP, {}});
     _entities.insert({VIEW_ASSOCIATION, {}});
 
-    // run
-    this->RunInMultiThread();
+    switch (_mode) {
+        case ViewerModeType::GUI:
+            // run
+            this->RunInMultiThread();
+            break;
+        case ViewerModeType::HEADLESS:
+            spdlog::info("viewer is disabled (headless mode)");
+            break;
+        case ViewerModeType::RECORD: {
+            const auto filename = Configor::DataStream::OutputPath + "/viewer_commands.bin";
+            _recorder = std::make_shared<std::ofstream>(filename, std::ios::out | std::ios::binary);
+            if (!_recorder->is_open()) {
+                throw Status(Status::CRITICAL, "can not open file '{}' to record viewer commands!",
+                             filename);
+            }
+            spdlog::info("viewer commands are recorded to '{}' (record mode)", filename);
+        } break;
+    }
 }
 
 std::shared_ptr<Viewer> ns_ikalibr::Viewer::Create(const CalibParamManager::Ptr &parMagr,
-                                                   const SplineBundleType::Ptr &splines) {
-    return std::make_shared<Viewer>(parMagr, splines);
+                                                   const SplineBundleType::Ptr &splines,
+                                                   ViewerModeType mode) {
+    return std::make_shared<Viewer>(parMagr, splines, mode);
+}
+
+bool Viewer::IsHeadless() const { return _mode == ViewerModeType::HEADLESS; }
+
+bool Viewer::IsActive() {
+    // the window only runs in the gui mode
+    return _mode == ViewerModeType::GUI && Parent::IsActive();
+}
+
+void Viewer::Record(Command command,
+                    const std::string &view,
+                    const std::vector<ns_viewer::Entity::Ptr> &entities) {
+    // commands are archived separately and size-prefixed, so that a failed one (e.g., an entity
+    // type not registered to cereal) does not break the whole record
+    std::stringstream stream;
+    try {
+        cereal::BinaryOutputArchive ar(stream);
+        ar(command, view, entities);
+    } catch (const std::exception &e) {
+        spdlog::warn("viewer command for view '{}' can not be recorded: {}", view, e.what());
+        return;
+    }
+    const std::string buffer = stream.str();
+    const auto size = static_cast<std::uint64_t>(buffer.size());
+    _recorder->write(reinterpret_cast<const char *>(&size), sizeof(size));
+    _recorder->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    _recorder->flush();
+}
+
+void Viewer::Replay(const std::string &filename, double interval) {
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        throw Status(Status::ERROR, "can not open recorded viewer commands '{}'!", filename);
+    }
+    auto viewer = Viewer::Create(nullptr, nullptr, ViewerModeType::GUI);
+    // the window is run in another thread, wait for it
+    for (int i = 0; i < 50 && !viewer->IsActive(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::uint64_t size = 0;
+    std::string buffer;
+    while (viewer->IsActive() && file.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+        buffer.resize(size);
+        if (!file.read(buffer.data(), static_cast<std::streamsize>(size))) {
+            spdlog::warn("the recorded viewer commands '{}' are truncated!", filename);
+            break;
+        }
+        std::stringstream stream(buffer);
+        cereal::BinaryInputArchive ar(stream);
+        Command command;
+        std::string view;
+        std::vector<ns_viewer::Entity::Ptr> entities;
+        ar(command, view, entities);
+        switch (command) {
+            case Command::ADD:
+                viewer->AddEntityLocal(entities, view);
+                break;
+            case Command::CLEAR:
+                viewer->ClearViewer(view);
+                break;
+            case Command::POP_BACK:
+                viewer->PopBackEntity(view);
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+    }
+    // wait until the window is closed
+    while (viewer->IsActive()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
 }
 
 Viewer &Viewer::UpdateSensorViewer() {
+    if (IsHeadless()) {
+        return *this;
+    }
+    TraceRecorder::Span span("viewer", "UpdateSensorViewer");
+    const auto entities = _parMagr->EntitiesForVisualization();
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    ++_revision;
     ClearViewer(VIEW_SENSORS);
-    _entities.at(VIEW_SENSORS) = _parMagr->VisualizationSensors(*this, VIEW_SENSORS);
+    AddEntityLocal(entities, VIEW_SENSORS);
     return *this;
 }
 
 Viewer &Viewer::UpdateSplineViewer(double dt) {
+    if (IsHeadless()) {
+        return *this;
+    }
+    TraceRecorder::Span span("viewer", "UpdateSplineViewer");
+    const auto entities = SplineEntities(_splines, _parMagr, dt);
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    ++_revision;
     ClearViewer(VIEW_SPLINE);
+    AddEntityLocal(entities, VIEW_SPLINE);
+    return *this;
+}
 
-    // spline poses
-    std::vector<ns_viewer::Entity::Ptr> entities;
+Viewer::Snapshot::Ptr Viewer::TakeSnapshot() {
+    auto snapshot = std::make_shared<Snapshot>();
+    {
+        std::lock_guard<std::mutex> lock(_updateMutex);
+        snapshot->revision = _revision;
+    }
+    // only extrinsics and the gravity are rendered, which are held by values
+    snapshot->parMagr = std::make_shared<CalibParamManager>(*_parMagr);
+
+    // splines are recreated and knots are copied, as is done in their serialization, the knot
+    // distance is recovered from the time range, as splines of initialization use other ones
     const auto &so3Spline = _splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
     const auto &scaleSpline = _splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    auto knotDist = [](double st, double et, std::size_t knotCount) {
+        return (et - st) / static_cast<double>(knotCount - Configor::Prior::SplineOrder + 1);
+    };
+    snapshot->splines = SplineBundleType::Create(
+        {ns_ctraj::SplineInfo(
+             Configor::Preference::SO3_SPLINE, ns_ctraj::SplineType::So3Spline, so3Spline.MinTime(),
+             so3Spline.MaxTime(),
+             knotDist(so3Spline.MinTime(), so3Spline.MaxTime(), so3Spline.GetKnots().size())),
+         ns_ctraj::SplineInfo(Configor::Preference::SCALE_SPLINE, ns_ctraj::SplineType::RdSpline,
+                              scaleSpline.MinTime(), scaleSpline.MaxTime(),
+                              knotDist(scaleSpline.MinTime(), scaleSpline.MaxTime(),
+                                       scaleSpline.GetKnots().size()))});
+    auto &so3Copy = snapshot->splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    auto &scaleCopy = snapshot->splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
+    if (so3Copy.GetKnots().size() != so3Spline.GetKnots().size() ||
+        scaleCopy.GetKnots().size() != scaleSpline.GetKnots().size()) {
+        // the knot layout can not be recovered, e.g., splines with other knot distances are bound
+        return nullptr;
+    }
+    for (int i = 0; i < static_cast<int>(so3Spline.GetKnots().size()); ++i) {
+        so3Copy.GetKnot(i) = so3Spline.GetKnot(i);
+    }
+    for (int i = 0; i < static_cast<int>(scaleSpline.GetKnots().size()); ++i) {
+        scaleCopy.GetKnot(i) = scaleSpline.GetKnot(i);
+    }
+    return snapshot;
+}
+
+bool Viewer::UpdateFromSnapshot(const Snapshot::Ptr &snapshot, double dt) {
+    if (IsHeadless() || snapshot == nullptr) {
+        return false;
+    }
+    const auto sensorEntities = snapshot->parMagr->EntitiesForVisualization();
+    const auto splineEntities = SplineEntities(snapshot->splines, snapshot->parMagr, dt);
+    std::lock_guard<std::mutex> lock(_updateMutex);
+    if (snapshot->revision != _revision) {
+        // views have been directly updated by newer states
+        return false;
+    }
+    ClearViewer(VIEW_SENSORS);
+    AddEntityLocal(sensorEntities, VIEW_SENSORS);
+    ClearViewer(VIEW_SPLINE);
+    AddEntityLocal(splineEntities, VIEW_SPLINE);
+    return true;
+}
+
+std::vector<ns_viewer::Entity::Ptr> Viewer::SplineEntities(const SplineBundleType::Ptr &splines,
+                                                           const CalibParamManagerPtr &parMagr,
+                                                           double dt) {
+    // spline poses
+    std::vector<ns_viewer::Entity::Ptr> entities;
+    const auto &so3Spline = splines->GetSo3Spline(Configor::Preference::SO3_SPLINE);
+    const auto &scaleSpline = splines->GetRdSpline(Configor::Preference::SCALE_SPLINE);
     double minTime = std::max(so3Spline.MinTime(), scaleSpline.MinTime());
     double maxTime = std::min(so3Spline.MaxTime(), scaleSpline.MaxTime());
-    for (double t = minTime; t < maxTime;) {
-        if (!_splines->TimeInRange(t, so3Spline) || !_splines->TimeInRange(t, scaleSpline)) {
-            t += dt;
+    const auto times = SplineSampler::UniformTimes(minTime, maxTime, dt);
+    const auto samples = SplineSampler::Evaluate(splines, times, 0, false);
+    for (const auto &sample : samples) {
+        if (!sample.valid) {
             continue;
         }
-
-        Sophus::SO3d so3 = so3Spline.Evaluate(t);
-        Eigen::Vector3d linScale =
-            scaleSpline.Evaluate(t) * Configor::Preference::SplineScaleInViewer;
+        Eigen::Vector3d linScale = sample.scale * Configor::Preference::SplineScaleInViewer;
         // coordinate
         entities.push_back(ns_viewer::Coordinate::Create(
-            ns_viewer::Posed(so3.matrix(), linScale).cast<float>(),
+            ns_viewer::Posed(sample.so3.matrix(), linScale).cast<float>(),
             static_cast<float>(Configor::Preference::CoordSScaleInViewer)));
-        t += dt;
     }
     const auto &knots = scaleSpline.GetKnots();
     for (const auto &k : knots) {
@@ -124,24 +322,39 @@ Viewer &Viewer::UpdateSplineViewer(double dt) {
                                                    ns_viewer::Colour::Black()));
     }
     // gravity
-    entities.push_back(Gravity());
-
-    _entities.at(VIEW_SPLINE) = this->AddEntity(entities, VIEW_SPLINE);
-
-    return *this;
+    entities.push_back(Gravity(parMagr));
+    return entities;
 }
 
 Viewer &Viewer::AddCloud(const IKalibrPointCloud::Ptr &cloud,
                          const std::string &view,
                          const ns_viewer::Colour &color,
                          float size) {
-    AddEntityLocal({ns_viewer::Cloud<IKalibrPoint>::Create(cloud, color, size), Gravity()}, view);
+    if (IsHeadless()) {
+        return *this;
+    }
+    const std::size_t hash = HashCloud(HashColour(std::hash<std::string>()("Cloud"), color, size),
+                                       *cloud);
+    auto entities = CachedEntities(hash, [&cloud, &color, size]() {
+        if (cloud->size() >= Configor::Preference::LODCloudMinPoints) {
+            // large maps are drawn by levels of detail
+            return std::vector<ns_viewer::Entity::Ptr>{
+                ns_viewer::LODCloud::Create(cloud, color, size)};
+        }
+        return std::vector<ns_viewer::Entity::Ptr>{
+            ns_viewer::Cloud<IKalibrPoint>::Create(cloud, color, size)};
+    });
+    entities.push_back(Gravity());
+    AddEntityLocal(entities, view);
     return *this;
 }
 
 Viewer &Viewer::AddStarMarkCloud(const IKalibrPointCloud::Ptr &cloud,
                                  const std::string &view,
                                  float size) {
+    if (IsHeadless()) {
+        return *this;
+    }
     PosPointCloud::Ptr posCloud(new PosPointCloud);
     pcl::copyPointCloud(*cloud, *posCloud);
     AddEntityLocal({ns_viewer::Cloud<ns_viewer::Landmark>::Create(posCloud, size), Gravity()},
@@ -150,7 +363,22 @@ Viewer &Viewer::AddStarMarkCloud(const IKalibrPointCloud::Ptr &cloud,
 }
 
 Viewer &Viewer::AddCloud(const IKalibrPointCloud::Ptr &cloud, const std::string &view, float size) {
-    AddEntityLocal({ns_viewer::Cloud<IKalibrPoint>::Create(cloud, size)}, view);
+    if (IsHeadless()) {
+        return *this;
+    }
+    const std::size_t hash = HashCloud(
+        HashColour(std::hash<std::string>()("PlainCloud"), ns_viewer::Colour::Black(), size),
+        *cloud);
+    auto entities = CachedEntities(hash, [&cloud, size]() {
+        if (cloud->size() >= Configor::Preference::LODCloudMinPoints) {
+            // points of the plain cloud are drawn in black as well
+            return std::vector<ns_viewer::Entity::Ptr>{
+                ns_viewer::LODCloud::Create(cloud, ns_viewer::Colour::Black(), size)};
+        }
+        return std::vector<ns_viewer::Entity::Ptr>{
+            ns_viewer::Cloud<IKalibrPoint>::Create(cloud, size)};
+    });
+    AddEntityLocal(entities, view);
     return *this;
 }
 
@@ -158,6 +386,9 @@ Viewer &Viewer::AddAlignedCloud(const IKalibrPointCloud::Ptr &cloud,
                                 const std::string &view,
                                 const Eigen::Vector3f &dir,
                                 float size) {
+    if (IsHeadless()) {
+        return *this;
+    }
     AddEntityLocal({ns_viewer::AlignedCloud<IKalibrPoint>::Create(cloud, dir, size), Gravity()},
                    view);
     return *this;
@@ -190,6 +421,14 @@ ns_viewer::MultiViewerConfigor Viewer::GenViewerConfigor() {
 }
 
 Viewer &Viewer::ClearViewer(const std::string &view) {
+    if (IsHeadless()) {
+        return *this;
+    }
+    std::lock_guard<std::mutex> lock(_entitiesMutex);
+    if (_mode == ViewerModeType::RECORD) {
+        Record(Command::CLEAR, view);
+        return *this;
+    }
     this->RemoveEntity(_entities.at(view), view);
     _entities.at(view).clear();
     return *this;
@@ -222,26 +461,40 @@ void Viewer::ZoomOutCoordCallBack() {
 Viewer &Viewer::AddSurfelMap(const ufo::map::SurfelMap &smp,
                              const PointToSurfelCondition &condition,
                              const std::string &view) {
+    if (IsHeadless()) {
+        return *this;
+    }
     namespace ufopred = ufo::map::predicate;
-    std::vector<ns_viewer::Entity::Ptr> entities;
 
     auto pred = ufopred::HasSurfel() && ufopred::DepthMin(condition.queryDepthMin) &&
                 ufopred::DepthMax(condition.queryDepthMax) &&
                 ufopred::NumSurfelPointsMin(condition.surfelPointMin) &&
                 ufopred::SurfelPlanarityMin(condition.planarityMin);
 
+    // the geometry of surfel cubes
+    std::vector<Eigen::AlignedBox3f> boxes;
+    std::size_t hash = std::hash<std::string>()("SurfelMap");
     for (const auto &node : smp.query(pred)) {
-        // create entities
-        auto cen = smp.getNodeCenter(node);
-        auto pose =
-            ns_viewer::Posef(Eigen::Matrix3f::Identity(), Eigen::Vector3f(cen.x, cen.y, cen.z));
         auto min = smp.getNodeMin(node), max = smp.getNodeMax(node);
-        auto cube = ns_viewer::Cube::Create(pose, true, max.x - min.x, max.y - min.y, max.z - min.z,
-                                            ns_viewer::Colour::Black().WithAlpha(0.4f));
-
-        entities.push_back(cube);
+        HashCombine(hash, min.x), HashCombine(hash, min.y), HashCombine(hash, min.z);
+        HashCombine(hash, max.x), HashCombine(hash, max.y), HashCombine(hash, max.z);
+        boxes.emplace_back(Eigen::Vector3f(min.x, min.y, min.z),
+                           Eigen::Vector3f(max.x, max.y, max.z));
     }
 
+    auto entities = CachedEntities(hash, [&boxes]() {
+        std::vector<ns_viewer::Entity::Ptr> cubes;
+        cubes.reserve(boxes.size());
+        for (const auto &box : boxes) {
+            // create entities
+            auto pose = ns_viewer::Posef(Eigen::Matrix3f::Identity(), box.center());
+            const Eigen::Vector3f sizes = box.sizes();
+            cubes.push_back(ns_viewer::Cube::Create(pose, true, sizes(0), sizes(1), sizes(2),
+                                                    ns_viewer::Colour::Black().WithAlpha(0.4f)));
+        }
+        return cubes;
+    });
+
     entities.push_back(Gravity());
 
     AddEntityLocal(entities, view);
@@ -250,42 +503,72 @@ Viewer &Viewer::AddSurfelMap(const ufo::map::SurfelMap &smp,
 
 Viewer &Viewer::AddPointToSurfel(
     const ufo::map::SurfelMap &smp,
-    const std::map<std::string, std::vector<PointToSurfelCorrPtr>> &corrs,
+    const std::map<std::string, PointToSurfelCorrBufferPtr> &corrs,
     const std::string &view) {
-    std::map<ufo::map::Node, std::vector<PointToSurfelCorr::Ptr>> nodes;
-    for (const auto &[topic, corrVec] : corrs) {
-        for (const auto &corr : corrVec) {
-            nodes[corr->node].push_back(corr);
+    if (IsHeadless()) {
+        return *this;
+    }
+    // the surfel and the points in the map of each node
+    std::map<ufo::map::Node, std::pair<Eigen::Vector4d, std::vector<Eigen::Vector3f>>> nodes;
+    for (const auto &[topic, buffer] : corrs) {
+        if (buffer == nullptr || !buffer->WithVisualization()) {
+            continue;
+        }
+        for (const auto &[surfelIdx, indices] : buffer->GroupBySurfel()) {
+            auto &[surfel, points] = nodes[buffer->surfels->nodes.at(surfelIdx)];
+            surfel = buffer->surfels->coeffs.at(surfelIdx);
+            for (const auto &i : indices) {
+                points.push_back(buffer->pInMap.at(i));
+            }
         }
     }
 
-    std::vector<ns_viewer::Entity::Ptr> entities;
+    // the content, i.e., surfels and points in the map (colors are not involved)
+    std::size_t hash = std::hash<std::string>()("PointToSurfel");
     for (const auto &[node, nodeCorrs] : nodes) {
-        auto color = ns_viewer::Entity::GetUniqueColour();
-
-        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
-        cloud->reserve(nodeCorrs.size());
-        for (const auto &corr : nodeCorrs) {
-            pcl::PointXYZ p;
-            p.x = static_cast<float>(corr->pInMap(0));
-            p.y = static_cast<float>(corr->pInMap(1));
-            p.z = static_cast<float>(corr->pInMap(2));
-            cloud->push_back(p);
-        }
-        entities.push_back(ns_viewer::Cloud<pcl::PointXYZ>::Create(cloud, DefaultPointSize, color));
-
-        // create surfels
-        auto cen = smp.getNodeCenter(node);
-        auto pose =
-            ns_viewer::Posef(Eigen::Matrix3f::Identity(), Eigen::Vector3f(cen.x, cen.y, cen.z));
         auto min = smp.getNodeMin(node), max = smp.getNodeMax(node);
-        auto cube = ns_viewer::Cube::Create(pose, true, max.x - min.x, max.y - min.y, max.z - min.z,
-                                            ns_viewer::Colour::Black().WithAlpha(0.2f));
-        auto s = ns_viewer::Surfel::Create(nodeCorrs.front()->surfelInW.cast<float>(), *cube, false,
-                                           true, color.WithAlpha(0.2f));
-        entities.push_back(s);
+        HashCombine(hash, min.x), HashCombine(hash, min.y), HashCombine(hash, min.z);
+        HashCombine(hash, max.x), HashCombine(hash, max.y), HashCombine(hash, max.z);
+        for (int i = 0; i < 4; ++i) {
+            HashCombine(hash, nodeCorrs.first(i));
+        }
+        for (const auto &p : nodeCorrs.second) {
+            for (int i = 0; i < 3; ++i) {
+                HashCombine(hash, p(i));
+            }
+        }
     }
 
+    auto entities = CachedEntities(hash, [&smp, &nodes]() {
+        std::vector<ns_viewer::Entity::Ptr> created;
+        for (const auto &[node, nodeCorrs] : nodes) {
+            auto color = ns_viewer::Entity::GetUniqueColour();
+
+            pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>);
+            cloud->reserve(nodeCorrs.second.size());
+            for (const auto &pInMap : nodeCorrs.second) {
+                pcl::PointXYZ p;
+                p.x = pInMap(0), p.y = pInMap(1), p.z = pInMap(2);
+                cloud->push_back(p);
+            }
+            created.push_back(
+                ns_viewer::Cloud<pcl::PointXYZ>::Create(cloud, DefaultPointSize, color));
+
+            // create surfels
+            auto cen = smp.getNodeCenter(node);
+            auto pose = ns_viewer::Posef(Eigen::Matrix3f::Identity(),
+                                         Eigen::Vector3f(cen.x, cen.y, cen.z));
+            auto min = smp.getNodeMin(node), max = smp.getNodeMax(node);
+            auto cube =
+                ns_viewer::Cube::Create(pose, true, max.x - min.x, max.y - min.y, max.z - min.z,
+                                        ns_viewer::Colour::Black().WithAlpha(0.2f));
+            auto s = ns_viewer::Surfel::Create(nodeCorrs.first.cast<float>(), *cube,
+                                               false, true, color.WithAlpha(0.2f));
+            created.push_back(s);
+        }
+        return created;
+    });
+
     entities.push_back(Gravity());
 
     AddEntityLocal(entities, view);
@@ -293,6 +576,14 @@ Viewer &Viewer::AddPointToSurfel(
 }
 
 Viewer &Viewer::PopBackEntity(const std::string &view) {
+    if (IsHeadless()) {
+        return *this;
+    }
+    std::lock_guard<std::mutex> lock(_entitiesMutex);
+    if (_mode == ViewerModeType::RECORD) {
+        Record(Command::POP_BACK, view);
+        return *this;
+    }
     auto &curEntities = _entities.at(view);
     if (!curEntities.empty()) {
         this->RemoveEntity(curEntities.back(), view);
@@ -301,9 +592,11 @@ Viewer &Viewer::PopBackEntity(const std::string &view) {
     return *this;
 }
 
-ns_viewer::Entity::Ptr Viewer::Gravity() const {
+ns_viewer::Entity::Ptr Viewer::Gravity() const { return Gravity(_parMagr); }
+
+ns_viewer::Entity::Ptr Viewer::Gravity(const CalibParamManagerPtr &parMagr) {
     return ns_viewer::Arrow::Create(
-        _parMagr->GRAVITY.normalized().cast<float>() * Configor::Preference::SplineScaleInViewer,
+        parMagr->GRAVITY.normalized().cast<float>() * Configor::Preference::SplineScaleInViewer,
         Eigen::Vector3f::Zero(), ns_viewer::Colour::Blue());
 }
 
@@ -311,6 +604,9 @@ Viewer &Viewer::AddVeta(const ns_veta::Veta::Ptr &veta,
                         const std::string &view,
                         const std::optional<ns_viewer::Colour> &camColor,
                         const std::optional<ns_viewer::Colour> &lmColor) {
+    if (IsHeadless()) {
+        return *this;
+    }
     std::vector<ns_viewer::Entity::Ptr> entities;
     if (camColor != std::nullopt) {
         for (const auto &[viewId, se3] : veta->poses) {
@@ -342,14 +638,52 @@ Viewer &Viewer::AddVeta(const ns_veta::Veta::Ptr &veta,
 
 Viewer &Viewer::AddEntityLocal(const std::vector<ns_viewer::Entity::Ptr> &entities,
                                const std::string &view) {
+    if (IsHeadless()) {
+        return *this;
+    }
+    if (_mode == ViewerModeType::RECORD) {
+        std::lock_guard<std::mutex> lock(_entitiesMutex);
+        Record(Command::ADD, view, entities);
+        return *this;
+    }
     auto ids = this->AddEntity(entities, view);
+    std::lock_guard<std::mutex> lock(_entitiesMutex);
     _entities.at(view).insert(_entities.at(view).end(), ids.cbegin(), ids.cend());
     return *this;
 }
 
 void Viewer::SetNewSpline(const SplineBundleType::Ptr &splines) { _splines = splines; }
 
+std::vector<ns_viewer::Entity::Ptr> Viewer::CachedEntities(
+    std::size_t hash, const std::function<std::vector<ns_viewer::Entity::Ptr>()> &creator) {
+    {
+        std::lock_guard<std::mutex> lock(_entityCacheMutex);
+        auto iter = std::find_if(_entityCache.begin(), _entityCache.end(),
+                                 [hash](const auto &item) { return item.first == hash; });
+        if (iter != _entityCache.end()) {
+            // the most recently used one is moved to the front
+            _entityCache.splice(_entityCache.begin(), _entityCache, iter);
+            return _entityCache.front().second;
+        }
+    }
+    // entities are created outside the lock, which may be time-consuming
+    auto entities = creator();
+    if (Configor::Preference::ViewerEntityCacheCapacity == 0) {
+        return entities;
+    }
+    std::lock_guard<std::mutex> lock(_entityCacheMutex);
+    _entityCache.emplace_front(hash, entities);
+    while (_entityCache.size() > Configor::Preference::ViewerEntityCacheCapacity) {
+        _entityCache.pop_back();
+    }
+    return entities;
+}
+
 Viewer &Viewer::FillEmptyViews(const std::string &objPath) {
+    // models are only for the window, and are not recorded
+    if (_mode != ViewerModeType::GUI) {
+        return *this;
+    }
     std::array<std::map<std::string, bool>, 7> occupy;
     std::array<bool, 7> senIntegrated{};
     // imus
@@ -420,6 +754,9 @@ Viewer &Viewer::AddRGBDFrame(const RGBDFrame::Ptr &frame,
                              const std::string &view,
                              bool trueColor,
                              float size) {
+    if (IsHeadless()) {
+        return *this;
+    }
     ColorPointCloud ::Ptr cloud(new ColorPointCloud);
     if (trueColor) {
         cloud = frame->CreatePointCloud(intri);
@@ -438,6 +775,9 @@ Viewer &Viewer::AddEventFeatTracking(const std::map<int, FeatureVec> &batchTrack
                                      float eTime,
                                      const std::string &view,
                                      const std::pair<float, float> &ptScales) {
+    if (IsHeadless()) {
+        return *this;
+    }
     // tracking
     for (const auto &[id, tracking] : batchTracking) {
         AddEventFeatTracking(tracking, sTime, view, ptScales);
@@ -466,6 +806,9 @@ Viewer &Viewer::AddEventFeatTracking(const FeatureVec &tracking,
                                      float sTime,
                                      const std::string &view,
                                      const std::pair<float, float> &ptScales) {
+    if (IsHeadless()) {
+        return *this;
+    }
     // samples (raw tracked features)
     std::vector<Eigen::Vector3d> rawTrace(tracking.size());
     for (int i = 0; i != static_cast<int>(tracking.size()); ++i) {
@@ -489,6 +832,9 @@ Viewer &Viewer::AddSpatioTemporalTrace(const std::vector<Eigen::Vector3d> &trace
                                        float size,
                                        const ns_viewer::Colour &color,
                                        const std::pair<float, float> &ptScales) {
+    if (IsHeadless()) {
+        return *this;
+    }
     std::vector<ns_viewer::Entity::Ptr> entities;
     for (int i = 0; i != static_cast<int>(trace.size()) - 1; ++i) {
         const Eigen::Vector3f &f1 = trace.at(i).cast<float>();
@@ -512,24 +858,36 @@ Viewer &Viewer::AddEventData(const std::vector<EventArray::Ptr>::const_iterator
                              float sTime,
                              const std::string &view,
                              const std::pair<float, float> &ptScales) {
+    if (IsHeadless()) {
+        return *this;
+    }
+    return AddEventData(EventArraySpan(sIter, eIter), sTime, view, ptScales);
+}
+
+Viewer &Viewer::AddEventData(const EventArraySpan &span,
+                             float sTime,
+                             const std::string &view,
+                             const std::pair<float, float> &ptScales) {
+    if (IsHeadless()) {
+        return *this;
+    }
     pcl::PointCloud<ColorPoint>::Ptr cloud(new ColorPointCloud);
-    for (auto iter = sIter; iter != eIter; ++iter) {
-        for (const auto &event : (*iter)->GetEvents()) {
-            Eigen::Vector2f p = event->GetPos().cast<float>() * ptScales.first;
-            float t = ((float)event->GetTimestamp() - sTime) * ptScales.second;
-            ColorPoint cp;
-            cp.x = p(0), cp.y = p(1), cp.z = t;
-            if (event->GetPolarity()) {
-                cp.b = 255;
-                cp.r = cp.g = 0;
-            } else {
-                cp.r = 255;
-                cp.b = cp.g = 0;
-            }
-            cp.a = 50;
-            cloud->push_back(cp);
+    cloud->reserve(span.GetEventCount());
+    span.ForEachEvent([&cloud, sTime, &ptScales](const EventArray::Ptr &ary, std::size_t i) {
+        Eigen::Vector2f p = ary->GetEventPos(i).cast<float>() * ptScales.first;
+        float t = ((float)ary->GetEventTime(i) - sTime) * ptScales.second;
+        ColorPoint cp;
+        cp.x = p(0), cp.y = p(1), cp.z = t;
+        if (ary->GetEventPolarity(i)) {
+            cp.b = 255;
+            cp.r = cp.g = 0;
+        } else {
+            cp.r = 255;
+            cp.b = cp.g = 0;
         }
-    }
+        cp.a = 50;
+        cloud->push_back(cp);
+    });
     AddEntityLocal({ns_viewer::Cloud<ColorPoint>::Create(cloud, 1.0f)}, view);
     return *this;
 }
@@ -539,18 +897,20 @@ Viewer &Viewer::AddEventData(const EventArray::Ptr &ary,
                              const std::string &view,
                              const std::pair<float, float> &ptScales,
                              const std::optional<ns_viewer::Colour> &color) {
+    if (IsHeadless()) {
+        return *this;
+    }
     if (ary == nullptr) {
         return *this;
     }
     pcl::PointCloud<ColorPoint>::Ptr cloud(new ColorPointCloud);
-    const auto &events = ary->GetEvents();
-    for (const auto &event : events) {
-        Eigen::Vector2f p = event->GetPos().cast<float>() * ptScales.first;
-        float t = ((float)event->GetTimestamp() - sTime) * ptScales.second;
+    for (std::size_t i = 0; i < ary->GetEventCount(); ++i) {
+        Eigen::Vector2f p = ary->GetEventPos(i).cast<float>() * ptScales.first;
+        float t = ((float)ary->GetEventTime(i) - sTime) * ptScales.second;
         ColorPoint cp;
         cp.x = p(0), cp.y = p(1), cp.z = t;
         if (color == std::nullopt) {
-            if (event->GetPolarity()) {
+            if (ary->GetEventPolarity(i)) {
                 cp.b = 255;
                 cp.r = cp.g = 0;
             } else {
@@ -0,0 +1,164 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "viewer/viewer_bridge.h"
+#include "spdlog/spdlog.h"
+#include "util/trace_recorder.h"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_ikalibr {
+
+ViewerBridge::ViewerBridge(Viewer::Ptr viewer, double maxFPS)
+    : _viewer(std::move(viewer)),
+      _snapshot(nullptr),
+      _lastPublish(),
+      _period(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1.0 / std::max(maxFPS, 1E-3)))),
+      _stop(false) {
+    // nothing would be rendered in the headless mode, thus no thread is required
+    if (!_viewer->IsHeadless()) {
+        _thread = std::thread(&ViewerBridge::Run, this);
+    }
+}
+
+ViewerBridge::Ptr ViewerBridge::Create(const Viewer::Ptr &viewer, double maxFPS) {
+    return std::make_shared<ViewerBridge>(viewer, maxFPS);
+}
+
+ViewerBridge::~ViewerBridge() { Stop(); }
+
+void ViewerBridge::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void ViewerBridge::Publish() {
+    if (_stop || _viewer->IsHeadless()) {
+        return;
+    }
+    // publishers are solver threads, the time check is cheap compared with a snapshot
+    const auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (now - _lastPublish < _period) {
+            return;
+        }
+        _lastPublish = now;
+    }
+    auto snapshot = _viewer->TakeSnapshot();
+    if (snapshot == nullptr) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        // the pending snapshot (if not consumed yet) is dropped
+        _snapshot = std::move(snapshot);
+    }
+    _cv.notify_one();
+}
+
+void ViewerBridge::PublishScan(const std::string &view, const IKalibrPointCloud::Ptr &scan) {
+    if (_stop || _viewer->IsHeadless()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _scans[view] = scan;
+    }
+    _cv.notify_one();
+}
+
+void ViewerBridge::DropScans(const std::string &view) {
+    if (_stop || _viewer->IsHeadless()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _scans.erase(view);
+    }
+    // wait for the current rendering, after which the view would not be touched by the bridge
+    std::lock_guard<std::mutex> lock(_renderMutex);
+    _viewer->ClearViewer(view);
+}
+
+void ViewerBridge::Run() {
+    while (true) {
+        Viewer::Snapshot::Ptr snapshot;
+        std::map<std::string, IKalibrPointCloud::Ptr> scans;
+        std::unique_lock<std::mutex> renderLock(_renderMutex, std::defer_lock);
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this] { return _stop || _snapshot != nullptr || !_scans.empty(); });
+            if (_stop) {
+                break;
+            }
+            // swap buffers, the render lock is acquired before the pending one is released, so
+            // that a dropped view would not be rendered again
+            renderLock.lock();
+            std::swap(snapshot, _snapshot);
+            std::swap(scans, _scans);
+        }
+
+        const auto start = Clock::now();
+        try {
+            TraceRecorder::Span span("viewer", "RenderSnapshot");
+            _viewer->UpdateFromSnapshot(snapshot);
+            for (const auto &[view, scan] : scans) {
+                _viewer->ClearViewer(view);
+                _viewer->AddAlignedCloud(scan, view);
+            }
+        } catch (const std::exception &e) {
+            spdlog::warn("rendering the solver snapshot failed: '{}'", e.what());
+        }
+        renderLock.unlock();
+
+        // cap the rate, pending buffers keep being replaced by newer ones in the meantime
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait_until(lock, start + _period, [this] { return _stop.load(); });
+        if (_stop) {
+            break;
+        }
+    }
+}
+
+}  // namespace ns_ikalibr
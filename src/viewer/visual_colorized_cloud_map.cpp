@@ -39,6 +39,7 @@
 #include "sensor/rgbd.h"
 #include "opencv2/imgproc.hpp"
 #include "spdlog/spdlog.h"
+#include "omp.h"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -95,6 +96,15 @@ ColorizedCloudMap::Ptr ColorizedCloudMap::CreateForRGBDs(const std::string &topi
 }
 
 ColorPointCloud::Ptr ColorizedCloudMap::Colorize(const IKalibrPointCloud::Ptr &cloudMap, int K) {
+    ColorPointCloud::Ptr colorMap(new ColorPointCloud);
+    colorMap->reserve(cloudMap->size());
+    Colorize(cloudMap, [&colorMap](const ColorPointCloud &chunk) { *colorMap += chunk; }, K);
+    return colorMap;
+}
+
+void ColorizedCloudMap::Colorize(const IKalibrPointCloud::Ptr &cloudMap,
+                                 const std::function<void(const ColorPointCloud &)> &handler,
+                                 int K) {
     PosPointCloud::Ptr lmCloud(new PosPointCloud);
     lmCloud->resize(_veta->structure.size());
     std::map<std::size_t, ns_veta::IndexT> cloudIdxToLMIdx;
@@ -118,41 +128,101 @@ ColorPointCloud::Ptr ColorizedCloudMap::Colorize(const IKalibrPointCloud::Ptr &c
 
     pcl::KdTreeFLANN<PosPoint> kdtree;
     kdtree.setInputCloud(lmCloud);
-    std::vector<int> pointIdxKNNSearch(K);
-    std::vector<float> pointKNNSquaredDistance(K);
 
-    ColorPointCloud::Ptr colorMap(new ColorPointCloud);
-    colorMap->reserve(cloudMap->size());
+    // views in a random-access container, so that they can be processed in parallel
+    std::vector<ns_veta::IndexT> viewIds;
+    std::map<ns_veta::IndexT, int> viewIdToIdx;
+    for (const auto &[viewId, _] : _viewIdToFrame) {
+        viewIdToIdx.insert({viewId, static_cast<int>(viewIds.size())});
+        viewIds.push_back(viewId);
+    }
+    const int viewCount = static_cast<int>(viewIds.size());
+    const int threadCount = Configor::Preference::AvailableThreads();
+
+    const int pointCount = static_cast<int>(cloudMap->points.size());
+    // candidate views (with multiplicity) of each point in a chunk
+    std::vector<std::vector<std::pair<int, int>>> candidates;
+    // indices (in the chunk) and multiplicities of points visible to each view
+    std::vector<std::vector<std::pair<int, int>>> visible(viewCount);
+    // thread-local color accumulators, reduced after the per-view pass
+    std::vector<Eigen::Matrix3Xd> bgrAcc(threadCount);
+    std::vector<Eigen::VectorXi> countAcc(threadCount);
+    ColorPointCloud chunk;
     spdlog::info("performing colorizing, this would cost some time...");
-#pragma omp parallel for num_threads(omp_get_max_threads()) default(none)                    \
-    shared(K, pointIdxKNNSearch, pointKNNSquaredDistance, cloudMap, cloudIdxToLMIdx, kdtree, \
-               colorMap, leftTop, rightBottom, width, height)
-    for (int i = 0; i < static_cast<int>(cloudMap->points.size()); ++i) {
-        // if (i % 100000 == 0) { std::cout << i << '/' << cloudMap->points.size() << std::endl; }
-        const auto &ip = cloudMap->points.at(i);
-
-        if (IS_POS_NAN(ip)) {
-            continue;
-        }
+    for (int chunkBeg = 0; chunkBeg < pointCount; chunkBeg += COLORIZE_CHUNK_SIZE) {
+        const int chunkEnd = std::min(chunkBeg + COLORIZE_CHUNK_SIZE, pointCount);
+        const int chunkSize = chunkEnd - chunkBeg;
 
-        if (kdtree.nearestKSearchT(ip, K, pointIdxKNNSearch, pointKNNSquaredDistance) == 0) {
-            continue;
+        /**
+         * visibility pass: views that observe the K nearest landmarks of a point are its
+         * candidates, a view observing several of the landmarks is counted several times
+         */
+        candidates.assign(chunkSize, {});
+#pragma omp parallel for num_threads(threadCount) default(none) \
+    shared(K, cloudMap, cloudIdxToLMIdx, kdtree, viewIdToIdx, candidates, chunkBeg, chunkEnd)
+        for (int i = chunkBeg; i < chunkEnd; ++i) {
+            const auto &ip = cloudMap->points.at(i);
+            if (IS_POS_NAN(ip)) {
+                continue;
+            }
+            std::vector<int> pointIdxKNNSearch(K);
+            std::vector<float> pointKNNSquaredDistance(K);
+            if (kdtree.nearestKSearchT(ip, K, pointIdxKNNSearch, pointKNNSquaredDistance) == 0) {
+                continue;
+            }
+            auto &cand = candidates.at(i - chunkBeg);
+            for (const auto &pId : pointIdxKNNSearch) {
+                const auto &lm = _veta->structure.at(cloudIdxToLMIdx.at(pId));
+                for (const auto &[viewId, feat] : lm.obs) {
+                    const int viewIdx = viewIdToIdx.at(viewId);
+                    auto iter = std::find_if(cand.begin(), cand.end(), [viewIdx](const auto &c) {
+                        return c.first == viewIdx;
+                    });
+                    if (iter == cand.end()) {
+                        cand.emplace_back(viewIdx, 1);
+                    } else {
+                        ++iter->second;
+                    }
+                }
+            }
+        }
+        for (auto &vec : visible) {
+            vec.clear();
+        }
+        for (int i = 0; i < chunkSize; ++i) {
+            for (const auto &[viewIdx, multiplicity] : candidates.at(i)) {
+                visible.at(viewIdx).emplace_back(i, multiplicity);
+            }
         }
 
-        Eigen::Vector3d totalBGR = Eigen::Vector3d::Zero();
-        int count = 0;
+        /**
+         * per-view pass: the pose of a view is evaluated once, and its visible points (in the
+         * frustum) are projected to the image, colors are accumulated thread-locally
+         */
+        for (int t = 0; t < threadCount; ++t) {
+            bgrAcc.at(t).setZero(3, chunkSize);
+            countAcc.at(t).setZero(chunkSize);
+        }
+#pragma omp parallel for num_threads(threadCount) schedule(dynamic) default(none)           \
+    shared(viewCount, viewIds, visible, cloudMap, chunkBeg, leftTop, rightBottom, width, height, \
+               bgrAcc, countAcc)
+        for (int v = 0; v < viewCount; ++v) {
+            if (visible.at(v).empty()) {
+                continue;
+            }
+            const auto &[SE3_CurCmToW, undistImg] = _viewIdToFrame.at(viewIds.at(v));
+            if (!SE3_CurCmToW) {
+                continue;
+            }
+            const Sophus::SE3d SE3_WToCurCm = SE3_CurCmToW->inverse();
+            auto &bgrSum = bgrAcc.at(omp_get_thread_num());
+            auto &countSum = countAcc.at(omp_get_thread_num());
 
-        for (const auto &pId : pointIdxKNNSearch) {
-            auto lmId = cloudIdxToLMIdx.at(pId);
-            for (const auto &[viewId, feat] : _veta->structure.at(lmId).obs) {
-                const auto &[SE3_CurCmToW, undistImg] = _viewIdToFrame.at(viewId);
-                if (!SE3_CurCmToW) {
-                    continue;
-                }
+            for (const auto &[idx, multiplicity] : visible.at(v)) {
+                const auto &ip = cloudMap->points.at(chunkBeg + idx);
 
                 // transform point to camera frame
-                Eigen::Vector3d pInCm =
-                    SE3_CurCmToW->inverse() * Eigen::Vector3d(ExpandPCLPointXYZ(ip));
+                Eigen::Vector3d pInCm = SE3_WToCurCm * Eigen::Vector3d(ExpandPCLPointXYZ(ip));
                 if (pInCm(2) < 0.1) {
                     continue;
                 }
@@ -176,30 +246,36 @@ ColorPointCloud::Ptr ColorizedCloudMap::Colorize(const IKalibrPointCloud::Ptr &c
 
                 // row: pixel(1), col: pixel(0)
                 auto bgr = undistImg.at<cv::Vec3b>(pixel(1), pixel(0));
-                totalBGR += Eigen::Vector3d(bgr(0), bgr(1), bgr(2));
-                ++count;
-
-                // cv::imshow(std::to_string(viewId), DrawPoint(undistImg, pixel));
+                bgrSum.col(idx) += multiplicity * Eigen::Vector3d(bgr(0), bgr(1), bgr(2));
+                countSum(idx) += multiplicity;
             }
         }
+        for (int t = 1; t < threadCount; ++t) {
+            bgrAcc.front() += bgrAcc.at(t);
+            countAcc.front() += countAcc.at(t);
+        }
 
-        if (count == 0) {
-            continue;
+        // points colorized by at least one view are handed over (in order)
+        chunk.clear();
+        for (int i = 0; i < chunkSize; ++i) {
+            const int count = countAcc.front()(i);
+            if (count == 0) {
+                continue;
+            }
+            const auto &ip = cloudMap->points.at(chunkBeg + i);
+            ColorPoint op;
+            op.x = ip.x, op.y = ip.y, op.z = ip.z;
+            // although we should perform color average in the hsv space, to reduce the
+            // computation, we directly perform it in BGR space
+            Eigen::Vector3d avgBGR = bgrAcc.front().col(i) / count;
+            op.r = static_cast<uchar>(avgBGR(2));
+            op.g = static_cast<uchar>(avgBGR(1));
+            op.b = static_cast<uchar>(avgBGR(0));
+            op.a = 255;
+            chunk.push_back(op);
         }
-        ColorPoint op;
-        op.x = ip.x, op.y = ip.y, op.z = ip.z;
-        // although we should perform color average in the hsv space, to reduce the computation, we
-        // directly perform it in BGR space
-        Eigen::Vector3d avgBGR = totalBGR / count;
-        op.r = static_cast<uchar>(avgBGR(2));
-        op.g = static_cast<uchar>(avgBGR(1));
-        op.b = static_cast<uchar>(avgBGR(0));
-        op.a = 255;
-#pragma omp critical
-        { colorMap->push_back(op); }
-        // cv::waitKey(0);
+        handler(chunk);
     }
-    return colorMap;
 }
 
 std::optional<Sophus::SE3d> ColorizedCloudMap::CurCmToW(double timeByCm) {
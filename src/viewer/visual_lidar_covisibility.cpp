@@ -33,8 +33,8 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include "viewer/visual_lidar_covisibility.h"
-#include "pcl/common/transforms.h"
 #include "opencv2/imgproc.hpp"
+#include "algorithm"
 
 namespace {
 bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
@@ -42,8 +42,57 @@ bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
 
 namespace ns_ikalibr {
 
-VisualLiDARCovisibility::VisualLiDARCovisibility(IKalibrPointCloud::Ptr cloudMap)
-    : _cloudMap(std::move(cloudMap)) {}
+VisualLiDARCovisibility::VisualLiDARCovisibility(IKalibrPointCloud::Ptr cloudMap) {
+    _points.reserve(cloudMap->size());
+    for (const auto &p : cloudMap->points) {
+        if (!IS_POS_NAN(p)) {
+            _points.emplace_back(p.x, p.y, p.z);
+        }
+    }
+    if (!_points.empty()) {
+        BuildNode(0, _points.size(), 0);
+    }
+}
+
+int VisualLiDARCovisibility::BuildNode(std::size_t begin, std::size_t end, int depth) {
+    const int idx = static_cast<int>(_nodes.size());
+    Node node{begin, end - begin, Eigen::AlignedBox3f(), {}};
+    node.children.fill(-1);
+    for (std::size_t i = begin; i < end; ++i) {
+        node.box.extend(_points[i]);
+    }
+    _nodes.push_back(node);
+    if (end - begin <= LEAF_CAPACITY || depth >= MAX_DEPTH) {
+        return idx;
+    }
+
+    // partition points into octants, whose index is 'z * 4 + y * 2 + x' (1: the upper half)
+    const Eigen::Vector3f center = node.box.center();
+    std::array<std::size_t, 9> bounds{};
+    bounds.front() = begin, bounds.back() = end;
+    auto split = [this, &center](std::size_t b, std::size_t e, int axis) {
+        auto iter = std::partition(
+            _points.begin() + b, _points.begin() + e,
+            [&center, axis](const Eigen::Vector3f &p) { return p(axis) < center(axis); });
+        return static_cast<std::size_t>(iter - _points.begin());
+    };
+    bounds[4] = split(bounds[0], bounds[8], 2);
+    bounds[2] = split(bounds[0], bounds[4], 1);
+    bounds[6] = split(bounds[4], bounds[8], 1);
+    for (int i = 0; i < 8; i += 2) {
+        bounds[i + 1] = split(bounds[i], bounds[i + 2], 0);
+    }
+
+    for (int c = 0; c < 8; ++c) {
+        if (bounds[c + 1] == bounds[c]) {
+            continue;
+        }
+        const int child = BuildNode(bounds[c], bounds[c + 1], depth + 1);
+        // '_nodes' may be reallocated in building children, thus it is accessed by index
+        _nodes.at(idx).children.at(c) = child;
+    }
+    return idx;
+}
 
 VisualLiDARCovisibility::Ptr VisualLiDARCovisibility::Create(
     const IKalibrPointCloud::Ptr &cloudMap) {
@@ -55,9 +104,7 @@ std::pair<cv::Mat, cv::Mat> VisualLiDARCovisibility::CreateCovisibility(
     const ns_veta::PinholeIntrinsic::Ptr &intri,
     float zMin,
     float zMax) {
-    IKalibrPointCloud::Ptr mapInCam(new IKalibrPointCloud);
-    pcl::transformPointCloud(*_cloudMap, *mapInCam, SE3_CurCmToW.inverse().matrix().cast<float>());
-
+    const Sophus::SE3f SE3_WToCurCm = SE3_CurCmToW.inverse().cast<float>();
     const int width = (int)intri->imgWidth, height = (int)intri->imgHeight, padding = 1;
     Eigen::Vector2d leftTop = intri->ImgToCam(Eigen::Vector2d(0.0 + padding, 0.0 + padding));
     Eigen::Vector2d rightBottom =
@@ -67,43 +114,84 @@ std::pair<cv::Mat, cv::Mat> VisualLiDARCovisibility::CreateCovisibility(
     cv::Mat invDepthImg(height, width, CV_32FC1, cv::Scalar(0.0f));
     const float zMaxInv = 1.0f / zMax;
 
-    for (const auto &p : mapInCam->points) {
-        if (IS_POS_NAN(p) || p.z < zMin || p.z > zMax) {
-            continue;
+    /**
+     * the frustum in the camera frame: 'zMin <= z <= zMax', and '(x, y) / z' in the normalized
+     * image plane, which are linear constraints on the point, thus a box is out of the frustum if
+     * all its corners violate one of them, and is in it if all its corners satisfy all of them
+     */
+    const auto l0 = static_cast<float>(leftTop(0)), l1 = static_cast<float>(leftTop(1));
+    const auto r0 = static_cast<float>(rightBottom(0)), r1 = static_cast<float>(rightBottom(1));
+    auto Violations = [zMin, zMax, l0, l1, r0, r1](const Eigen::Vector3f &p) {
+        return std::array<bool, 6>{p.z() < zMin,       p.z() > zMax,
+                                   p.x() < l0 * p.z(), p.x() > r0 * p.z(),
+                                   p.y() < l1 * p.z(), p.y() > r1 * p.z()};
+    };
+    // the point ranges of visible nodes
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    std::vector<int> stack;
+    if (!_nodes.empty()) {
+        stack.push_back(0);
+    }
+    while (!stack.empty()) {
+        const auto &node = _nodes.at(stack.back());
+        stack.pop_back();
+        std::array<bool, 6> allViolated{}, anyViolated{};
+        allViolated.fill(true);
+        for (int c = 0; c < 8; ++c) {
+            const auto corner = node.box.corner(static_cast<Eigen::AlignedBox3f::CornerType>(c));
+            const auto violations = Violations(SE3_WToCurCm * corner);
+            for (int i = 0; i < 6; ++i) {
+                allViolated[i] = allViolated[i] && violations[i];
+                anyViolated[i] = anyViolated[i] || violations[i];
+            }
         }
-
-        const float zInv = 1.0f / p.z;
-        Eigen::Vector2d pInCamPlane(p.x * zInv, p.y * zInv);
-
-        // invalid
-        if (pInCamPlane(0) < leftTop(0) || pInCamPlane(0) > rightBottom(0) ||
-            pInCamPlane(1) < leftTop(1) || pInCamPlane(1) > rightBottom(1)) {
+        if (std::any_of(allViolated.cbegin(), allViolated.cend(), [](bool b) { return b; })) {
+            // culled
             continue;
         }
-
-        Eigen::Vector2i pixel = intri->CamToImg(pInCamPlane).cast<int>();
-
-        // invalid
-        if (pixel(0) < 0 || pixel(1) < 0 || pixel(0) > width - 1 || pixel(1) > height - 1) {
+        const bool isLeaf = std::all_of(node.children.cbegin(), node.children.cend(),
+                                        [](int child) { return child < 0; });
+        if (isLeaf || std::none_of(anyViolated.cbegin(), anyViolated.cend(),
+                                   [](bool b) { return b; })) {
+            // leaves, or nodes totally in the frustum, whose points are all projected
+            ranges.emplace_back(node.offset, node.offset + node.count);
             continue;
         }
+        for (int child : node.children) {
+            if (child >= 0) {
+                stack.push_back(child);
+            }
+        }
+    }
+
+    for (const auto &[begin, end] : ranges) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const Eigen::Vector3f p = SE3_WToCurCm * _points[i];
+            if (p.z() < zMin || p.z() > zMax) {
+                continue;
+            }
 
-        // row: pixel(1), col: pixel(0)
-        auto &val = invDepthImg.at<float>(pixel(1), pixel(0));
+            const float zInv = 1.0f / p.z();
+            Eigen::Vector2d pInCamPlane(p.x() * zInv, p.y() * zInv);
 
-        if (val < zMaxInv) {
-            // this pos has no value
-            val = zInv;
-            if (val < min) {
-                min = val;
+            // invalid
+            if (pInCamPlane(0) < leftTop(0) || pInCamPlane(0) > rightBottom(0) ||
+                pInCamPlane(1) < leftTop(1) || pInCamPlane(1) > rightBottom(1)) {
+                continue;
             }
-            if (val > max) {
-                max = val;
+
+            Eigen::Vector2i pixel = intri->CamToImg(pInCamPlane).cast<int>();
+
+            // invalid
+            if (pixel(0) < 0 || pixel(1) < 0 || pixel(0) > width - 1 || pixel(1) > height - 1) {
+                continue;
             }
-        } else {
-            // this pos has value
-            if (val < zInv) {
-                // the new pose is closer
+
+            // row: pixel(1), col: pixel(0)
+            auto &val = invDepthImg.at<float>(pixel(1), pixel(0));
+
+            if (val < zMaxInv) {
+                // this pos has no value
                 val = zInv;
                 if (val < min) {
                     min = val;
@@ -111,6 +199,18 @@ std::pair<cv::Mat, cv::Mat> VisualLiDARCovisibility::CreateCovisibility(
                 if (val > max) {
                     max = val;
                 }
+            } else {
+                // this pos has value
+                if (val < zInv) {
+                    // the new pose is closer
+                    val = zInv;
+                    if (val < min) {
+                        min = val;
+                    }
+                    if (val > max) {
+                        max = val;
+                    }
+                }
             }
         }
     }
@@ -0,0 +1,311 @@
+// iKalibr: Unified Targetless Spatiotemporal Calibration Framework
+// Copyright 2024, the School of Geodesy and Geomatics (SGG), Wuhan University, China
+// https://github.com/Unsigned-Long/iKalibr.git
+//
+// Author: Shuolong Chen (shlchen@whu.edu.cn)
+// GitHub: https://github.com/Unsigned-Long
+//  ORCID: 0000-0002-5283-9057
+//
+// Purpose: See .h/.hpp file.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * The names of its contributors can not be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "viewer/visual_lod_cloud.h"
+#include "config/configor.h"
+#include "pangolin/gl/gl.h"
+#include "queue"
+#include "cstddef"
+
+namespace {
+bool IKALIBR_UNIQUE_NAME(_2_) = ns_ikalibr::_1_(__FILE__);
+}
+
+namespace ns_viewer {
+
+// nodes deeper than this are leaves, e.g., for points sharing the same position
+constexpr int LOD_MAX_DEPTH = 20;
+
+LODCloud::LODCloud(const IKalibrPointCloud::Ptr &inputCloud, const Colour &color, float size)
+    : Entity(),
+      size(size) {
+    const auto r = static_cast<std::uint8_t>(color.r * 255.0f);
+    const auto g = static_cast<std::uint8_t>(color.g * 255.0f);
+    const auto b = static_cast<std::uint8_t>(color.b * 255.0f);
+    const auto a = static_cast<std::uint8_t>(color.a * 255.0f);
+    points.reserve(inputCloud->size());
+    for (const auto &p : inputCloud->points) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) {
+            continue;
+        }
+        points.push_back({p.x, p.y, p.z, r, g, b, a});
+    }
+    Build();
+}
+
+LODCloud::Ptr LODCloud::Create(const IKalibrPointCloud::Ptr &cloud,
+                               const Colour &color,
+                               float size) {
+    return std::make_shared<LODCloud>(cloud, color, size);
+}
+
+LODCloud::~LODCloud() {
+    if (buffers.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(ReleasedBuffersMutex());
+    for (const auto &[idx, buffer] : buffers) {
+        ReleasedBuffers().push_back(buffer.first);
+    }
+}
+
+void LODCloud::Build() {
+    nodes.clear();
+    if (points.empty()) {
+        return;
+    }
+    Eigen::AlignedBox3f box;
+    for (const auto &p : points) {
+        box.extend(Eigen::Vector3f(p.x, p.y, p.z));
+    }
+    // a slightly larger cube, so that points on the boundary fall into cells
+    const float halfSize = std::max(box.sizes().maxCoeff() * 0.5f, 1E-3f) * 1.001f;
+    BuildNode(0, points.size(), box.center(), halfSize, 0);
+}
+
+int LODCloud::BuildNode(std::size_t begin,
+                        std::size_t end,
+                        const Eigen::Vector3f &center,
+                        float halfSize,
+                        int depth) {
+    const int idx = static_cast<int>(nodes.size());
+    Node node{begin, end - begin, center, halfSize, 2.0f * halfSize / NODE_GRID_RES, {}};
+    node.children.fill(-1);
+    nodes.push_back(node);
+    if (end - begin <= LEAF_CAPACITY || depth >= LOD_MAX_DEPTH) {
+        return idx;
+    }
+
+    // grid sampling, the first point of each cell is kept by this node and moved to the front
+    std::vector<bool> occupied(NODE_GRID_RES * NODE_GRID_RES * NODE_GRID_RES, false);
+    const Eigen::Vector3f minCorner = center - Eigen::Vector3f::Constant(halfSize);
+    const float cellInv = NODE_GRID_RES / (2.0f * halfSize);
+    auto cellIdx = [&minCorner, cellInv](float v, int axis) {
+        const int i = static_cast<int>((v - minCorner(axis)) * cellInv);
+        return std::clamp(i, 0, NODE_GRID_RES - 1);
+    };
+    std::size_t kept = begin;
+    for (std::size_t i = begin; i < end; ++i) {
+        const auto &p = points[i];
+        const int key = (cellIdx(p.z, 2) * NODE_GRID_RES + cellIdx(p.y, 1)) * NODE_GRID_RES +
+                        cellIdx(p.x, 0);
+        if (!occupied[key]) {
+            occupied[key] = true;
+            std::swap(points[kept++], points[i]);
+        }
+    }
+    nodes.at(idx).count = kept - begin;
+
+    // partition the rest into octants, whose index is 'z * 4 + y * 2 + x' (1: the upper half)
+    std::array<std::size_t, 9> bounds{};
+    bounds.front() = kept, bounds.back() = end;
+    auto split = [this, &center](std::size_t b, std::size_t e, int axis) {
+        auto iter = std::partition(points.begin() + b, points.begin() + e,
+                                   [&center, axis](const Point &p) {
+                                       const float v = axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+                                       return v < center(axis);
+                                   });
+        return static_cast<std::size_t>(iter - points.begin());
+    };
+    bounds[4] = split(bounds[0], bounds[8], 2);
+    bounds[2] = split(bounds[0], bounds[4], 1);
+    bounds[6] = split(bounds[4], bounds[8], 1);
+    for (int i = 0; i < 8; i += 2) {
+        bounds[i + 1] = split(bounds[i], bounds[i + 2], 0);
+    }
+
+    for (int c = 0; c < 8; ++c) {
+        if (bounds[c + 1] == bounds[c]) {
+            continue;
+        }
+        const Eigen::Vector3f dir((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f,
+                                  (c & 4) ? 1.0f : -1.0f);
+        const int child = BuildNode(bounds[c], bounds[c + 1], center + dir * halfSize * 0.5f,
+                                    halfSize * 0.5f, depth + 1);
+        // 'nodes' may be reallocated in building children, thus it is accessed by index
+        nodes.at(idx).children.at(c) = child;
+    }
+    return idx;
+}
+
+void LODCloud::Draw() const {
+    {
+        std::lock_guard<std::mutex> lock(ReleasedBuffersMutex());
+        auto &released = ReleasedBuffers();
+        if (!released.empty()) {
+            glDeleteBuffers(static_cast<GLsizei>(released.size()), released.data());
+            released.clear();
+        }
+    }
+    if (nodes.empty()) {
+        return;
+    }
+    ++frame;
+
+    GLfloat mv[16], pj[16];
+    GLint viewport[4];
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    glGetFloatv(GL_PROJECTION_MATRIX, pj);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    // column-major, as is in opengl
+    const Eigen::Map<const Eigen::Matrix4f> MV(mv), P(pj);
+    const Eigen::Matrix4f MVP = P * MV;
+
+    // frustum planes extracted from the projection, whose normals point inwards
+    std::array<Eigen::Vector4f, 6> planes;
+    for (int i = 0; i < 3; ++i) {
+        planes.at(2 * i) = (MVP.row(3) + MVP.row(i)).transpose();
+        planes.at(2 * i + 1) = (MVP.row(3) - MVP.row(i)).transpose();
+    }
+    const Eigen::Vector3f camPos =
+        -MV.topLeftCorner<3, 3>().transpose() * MV.topRightCorner<3, 1>();
+    const bool ortho = P(3, 3) == 1.0f;
+    const float pxScale = P(1, 1) * static_cast<float>(viewport[3]) * 0.5f;
+
+    auto visible = [&planes](const Node &node) {
+        const float radius = node.halfSize * std::sqrt(3.0f);
+        for (const auto &plane : planes) {
+            if (plane.head<3>().dot(node.center) + plane(3) < -radius * plane.head<3>().norm()) {
+                return false;
+            }
+        }
+        return true;
+    };
+    // the node spacing projected on the screen (px)
+    auto projSpacing = [&camPos, ortho, pxScale](const Node &node) {
+        if (ortho) {
+            return node.spacing * pxScale;
+        }
+        const float dist = (node.center - camPos).norm() - node.halfSize * std::sqrt(3.0f);
+        return node.spacing * pxScale / std::max(dist, 1E-3f);
+    };
+
+    // nodes with larger projected spacing are drawn in priority
+    std::priority_queue<std::pair<float, int>> queue;
+    if (visible(nodes.front())) {
+        queue.push({projSpacing(nodes.front()), 0});
+    }
+    const std::size_t budget = ns_ikalibr::Configor::Preference::LODPointBudget;
+    const float sse = ns_ikalibr::Configor::Preference::LODScreenSpaceError;
+    std::size_t drawn = 0;
+    int uploads = 0;
+
+    glPointSize(size);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    while (!queue.empty() && drawn < budget) {
+        const auto [spacing, idx] = queue.top();
+        queue.pop();
+        const Node &node = nodes.at(idx);
+
+        auto iter = buffers.find(idx);
+        if (iter == buffers.end()) {
+            if (uploads >= MAX_UPLOADS_PER_FRAME) {
+                // would be uploaded in next frames
+                continue;
+            }
+            GLuint buffer;
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(node.count * sizeof(Point)),
+                         points.data() + node.offset, GL_STATIC_DRAW);
+            iter = buffers.insert({idx, {buffer, frame}}).first;
+            bufferedPoints += node.count;
+            ++uploads;
+        } else {
+            glBindBuffer(GL_ARRAY_BUFFER, iter->second.first);
+        }
+        iter->second.second = frame;
+
+        glVertexPointer(3, GL_FLOAT, sizeof(Point), nullptr);
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Point),
+                       reinterpret_cast<const GLvoid *>(offsetof(Point, r)));
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(node.count));
+        drawn += node.count;
+
+        // children are required only if points of this node are sparse on the screen
+        if (spacing <= sse) {
+            continue;
+        }
+        for (int child : node.children) {
+            if (child >= 0 && visible(nodes.at(child))) {
+                queue.push({projSpacing(nodes.at(child)), child});
+            }
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    // evict buffers not drawn in this frame by the least recently used order
+    const std::size_t gpuBudget = GPU_BUDGET_SCALE * budget;
+    if (bufferedPoints <= gpuBudget) {
+        return;
+    }
+    std::vector<std::pair<std::size_t, int>> lru;
+    for (const auto &[idx, buffer] : buffers) {
+        if (buffer.second != frame) {
+            lru.emplace_back(buffer.second, idx);
+        }
+    }
+    std::sort(lru.begin(), lru.end());
+    for (const auto &[lastFrame, idx] : lru) {
+        if (bufferedPoints <= gpuBudget) {
+            break;
+        }
+        ReleaseBuffer(idx);
+    }
+}
+
+std::vector<unsigned int> &LODCloud::ReleasedBuffers() {
+    static std::vector<unsigned int> released;
+    return released;
+}
+
+std::mutex &LODCloud::ReleasedBuffersMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+void LODCloud::ReleaseBuffer(int nodeIdx) const {
+    auto iter = buffers.find(nodeIdx);
+    if (iter == buffers.end()) {
+        return;
+    }
+    glDeleteBuffers(1, &iter->second.first);
+    bufferedPoints -= nodes.at(nodeIdx).count;
+    buffers.erase(iter);
+}
+
+}  // namespace ns_viewer